@@ -0,0 +1,345 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+// Running time, throughput, memory use, and scaling with the number of
+// threads of the algorithms in pmp/algorithms on generated and real-world
+// meshes of increasing size. Run with --benchmark_out=<file>
+// --benchmark_out_format=json to store the results, e.g., for comparing
+// releases with compare.py from Google Benchmark. Set the environment
+// variable PMP_PERF_COUNTERS=1 to report hardware events as well, see
+// PerfCounters.
+
+#include <benchmark/benchmark.h>
+
+#include <pmp/MemoryUsage.h>
+#include <pmp/Parallel.h>
+#include <pmp/PerfCounters.h>
+#include <pmp/SurfaceMesh.h>
+#include <pmp/algorithms/DifferentialGeometry.h>
+#include <pmp/algorithms/SurfaceCurvature.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceFairing.h>
+#include <pmp/algorithms/SurfaceGeodesic.h>
+#include <pmp/algorithms/SurfaceHoleFilling.h>
+#include <pmp/algorithms/SurfaceParameterization.h>
+#include <pmp/algorithms/SurfaceRemeshing.h>
+#include <pmp/algorithms/SurfaceSimplification.h>
+#include <pmp/algorithms/SurfaceSmoothing.h>
+#include <pmp/algorithms/SurfaceSubdivision.h>
+#include <pmp/algorithms/TriangleKdTree.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+// the input an algorithm expects
+enum class Shape
+{
+    Closed, // the mesh as generated or read
+    Disk,   // the lower half of the mesh, e.g., a hemisphere
+    Holes   // the mesh with small holes cut around a few vertices
+};
+
+// the lower half of the mesh, cut below the center of its bounding box
+SurfaceMesh cut_disk(const SurfaceMesh& input)
+{
+    SurfaceMesh mesh = input;
+    const Scalar z = mesh.bounds().center()[2];
+    for (auto f : mesh.faces())
+        if (centroid(mesh, f)[2] > z)
+            mesh.delete_face(f);
+    mesh.garbage_collection();
+    return mesh;
+}
+
+// holes around 16 vertices spread over the mesh
+SurfaceMesh cut_holes(const SurfaceMesh& input)
+{
+    SurfaceMesh mesh = input;
+    const Scalar radius = 0.02 * mesh.bounds().size();
+    const size_t step = std::max<size_t>(mesh.n_vertices() / 16, 1);
+    std::vector<Point> seeds;
+    for (size_t i = 0; i < mesh.vertices_size(); i += step)
+        seeds.push_back(mesh.position(Vertex(IndexType(i))));
+    for (auto f : mesh.faces())
+    {
+        const Point c = centroid(mesh, f);
+        for (const auto& s : seeds)
+        {
+            if (distance(c, s) < radius)
+            {
+                mesh.delete_face(f);
+                break;
+            }
+        }
+    }
+    mesh.garbage_collection();
+    return mesh;
+}
+
+// input mesh of the benchmarks, generated or read on first use
+struct Source
+{
+    Source(std::string name, std::string filename, size_t n_subdivisions)
+        : name(std::move(name)),
+          filename(std::move(filename)),
+          n_subdivisions(n_subdivisions)
+    {
+    }
+
+    std::string name;
+    std::string filename; // empty for generated meshes
+    size_t n_subdivisions;
+
+    const SurfaceMesh& mesh(Shape shape)
+    {
+        auto& mesh = meshes_[shape];
+        if (!mesh)
+        {
+            mesh.reset(new SurfaceMesh);
+            if (shape == Shape::Closed)
+            {
+                if (filename.empty())
+                    *mesh = SurfaceFactory::icosphere(n_subdivisions);
+                else
+                    mesh->read(filename);
+            }
+            else if (shape == Shape::Disk)
+                *mesh = cut_disk(this->mesh(Shape::Closed));
+            else
+                *mesh = cut_holes(this->mesh(Shape::Closed));
+        }
+        return *mesh;
+    }
+
+private:
+    std::map<Shape, std::shared_ptr<SurfaceMesh>> meshes_;
+};
+
+struct Algorithm
+{
+    std::string name;
+    Shape shape;
+    std::function<void(SurfaceMesh&)> run;
+};
+
+Scalar mean_edge_length(const SurfaceMesh& mesh)
+{
+    Scalar length = 0;
+    for (auto e : mesh.edges())
+        length += mesh.edge_length(e);
+    return mesh.n_edges() ? length / mesh.n_edges() : 0;
+}
+
+const std::vector<Algorithm> algorithms = {
+    {"simplification", Shape::Closed,
+     [](SurfaceMesh& mesh) {
+         SurfaceSimplification ss(mesh);
+         ss.initialize(5.0);
+         ss.simplify(mesh.n_vertices() / 10);
+     }},
+    {"remeshing_uniform", Shape::Closed,
+     [](SurfaceMesh& mesh) {
+         SurfaceRemeshing(mesh).uniform_remeshing(mean_edge_length(mesh), 3);
+     }},
+    {"subdivision_loop", Shape::Closed,
+     [](SurfaceMesh& mesh) { SurfaceSubdivision(mesh).loop(); }},
+    {"subdivision_catmull_clark", Shape::Closed,
+     [](SurfaceMesh& mesh) { SurfaceSubdivision(mesh).catmull_clark(); }},
+    {"smoothing_explicit", Shape::Closed,
+     [](SurfaceMesh& mesh) { SurfaceSmoothing(mesh).explicit_smoothing(10); }},
+    {"smoothing_implicit", Shape::Closed,
+     [](SurfaceMesh& mesh) { SurfaceSmoothing(mesh).implicit_smoothing(); }},
+    {"fairing", Shape::Disk,
+     [](SurfaceMesh& mesh) { SurfaceFairing(mesh).minimize_curvature(); }},
+    {"geodesic", Shape::Closed,
+     [](SurfaceMesh& mesh) {
+         SurfaceGeodesic(mesh).compute({*mesh.vertices_begin()});
+     }},
+    {"curvature", Shape::Closed,
+     [](SurfaceMesh& mesh) { SurfaceCurvature(mesh).analyze_tensor(1); }},
+    {"parameterization_harmonic", Shape::Disk,
+     [](SurfaceMesh& mesh) { SurfaceParameterization(mesh).harmonic(); }},
+    {"parameterization_lscm", Shape::Disk,
+     [](SurfaceMesh& mesh) { SurfaceParameterization(mesh).lscm(); }},
+    {"hole_filling", Shape::Holes,
+     [](SurfaceMesh& mesh) { SurfaceHoleFilling(mesh).fill_all_holes(); }},
+    {"kdtree", Shape::Closed,
+     [](SurfaceMesh& mesh) {
+         // build the tree and find the nearest faces of the vertices
+         const TriangleKdTree tree(mesh);
+         const SurfaceMesh& input = mesh;
+         std::vector<Point> points;
+         points.reserve(input.n_vertices());
+         for (auto v : input.vertices())
+             points.push_back(input.position(v));
+         std::vector<TriangleKdTree::NearestNeighbor> neighbors;
+         tree.nearest(points, neighbors);
+         benchmark::DoNotOptimize(neighbors.data());
+     }},
+};
+
+// hardware events per iteration of all threads of the algorithm, if they
+// were counted
+void set_perf_counters(benchmark::State& state, const PerfCounts& events)
+{
+    if (!events.is_valid())
+        return;
+    const auto average = benchmark::Counter::kAvgIterations;
+    state.counters["cycles"] =
+        benchmark::Counter(double(events.cycles), average);
+    state.counters["instructions"] =
+        benchmark::Counter(double(events.instructions), average);
+    state.counters["llc_misses"] =
+        benchmark::Counter(double(events.cache_misses), average);
+    state.counters["branch_misses"] =
+        benchmark::Counter(double(events.branch_misses), average);
+    state.counters["ipc"] = events.ipc();
+}
+
+// seconds per iteration with one thread, for the speedup of more threads
+std::map<std::string, double> single_thread_seconds;
+
+// run algorithm on a copy of the input. The copy is not timed, but the
+// first modification of properties shared with the input copies them, see
+// SurfaceMesh::operator=(), which is timed. The peak RSS is that of the
+// whole process so far, run algorithms separately with --benchmark_filter
+// for independent peaks.
+void run_algorithm(benchmark::State& state, Source* source,
+                   const Algorithm& algorithm, const std::string& name)
+{
+    const int n_threads = int(state.range(0));
+    Parallel::set_n_threads(n_threads);
+
+    const SurfaceMesh& input = source->mesh(algorithm.shape);
+    double seconds = 0;
+    size_t rss_growth = 0;
+    PerfCounts events;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        SurfaceMesh mesh = input;
+        const size_t before = MemoryUsage::current_size();
+        const PerfCounterScope counters;
+        const auto start = std::chrono::steady_clock::now();
+        state.ResumeTiming();
+
+        try
+        {
+            algorithm.run(mesh);
+        }
+        catch (const std::exception& e)
+        {
+            state.SkipWithError(e.what());
+            break;
+        }
+
+        state.PauseTiming();
+        seconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+        events += counters.counts();
+        const size_t after = MemoryUsage::current_size();
+        if (after > before)
+            rss_growth = std::max(rss_growth, after - before);
+        state.ResumeTiming();
+    }
+    Parallel::set_n_threads(0);
+    if (!state.iterations())
+        return;
+
+    // throughput per input element
+    state.counters["threads"] = n_threads;
+    state.counters["vertices"] = double(input.n_vertices());
+    state.counters["faces"] = double(input.n_faces());
+    state.counters["vertices_per_second"] =
+        benchmark::Counter(double(input.n_vertices()),
+                           benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["faces_per_second"] =
+        benchmark::Counter(double(input.n_faces()),
+                           benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["rss_growth"] = double(rss_growth);
+    state.counters["peak_rss"] = double(MemoryUsage::max_size());
+    set_perf_counters(state, events);
+
+    // scaling with the number of threads
+    seconds /= double(state.iterations());
+    if (n_threads == 1)
+        single_thread_seconds[name] = seconds;
+    const auto single = single_thread_seconds.find(name);
+    if (single != single_thread_seconds.end() && seconds > 0)
+        state.counters["speedup"] = single->second / seconds;
+}
+
+bool file_exists(const std::string& filename)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+    fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // generated spheres from 1280 to 81920 faces
+    std::vector<Source> sources;
+    for (size_t n = 3; n <= 6; ++n)
+        sources.emplace_back("icosphere" + std::to_string(n), "", n);
+
+    // real-world meshes, if the data submodule is checked out
+    for (const std::string name :
+         {"off/bunny.off", "off/fandisk.off", "obj/suzanne.obj"})
+    {
+        const std::string filename = std::string(PMP_DATA_DIR) + "/" + name;
+        if (file_exists(filename))
+        {
+            const auto slash = name.find('/');
+            const auto dot = name.rfind('.');
+            sources.emplace_back(name.substr(slash + 1, dot - slash - 1),
+                                 filename, 0);
+        }
+    }
+
+    // one thread, then doubling up to all available threads
+    const int max_threads = Parallel::n_threads();
+    std::vector<int64_t> thread_counts;
+    for (int n = 1; n < max_threads; n *= 2)
+        thread_counts.push_back(n);
+    thread_counts.push_back(max_threads);
+
+    for (const auto& algorithm : algorithms)
+    {
+        for (auto& source : sources)
+        {
+            const std::string name = algorithm.name + "/" + source.name;
+            Source* s = &source;
+            auto* b = benchmark::RegisterBenchmark(
+                name.c_str(), [s, algorithm, name](benchmark::State& state) {
+                    run_algorithm(state, s, algorithm, name);
+                });
+            b->ArgName("threads")->Unit(benchmark::kMillisecond);
+            for (auto n : thread_counts)
+                b->Arg(n);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
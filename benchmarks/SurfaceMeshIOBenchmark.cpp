@@ -0,0 +1,251 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+// Read and write throughput of the SurfaceMeshIO formats. Run with
+// --benchmark_out=<file> --benchmark_out_format=json to store the results,
+// e.g., for comparing releases with compare.py from Google Benchmark. Set
+// the environment variable PMP_PERF_COUNTERS=1 to report hardware events as
+// well, see PerfCounters.
+
+#include <benchmark/benchmark.h>
+
+#include <pmp/MemoryUsage.h>
+#include <pmp/PerfCounters.h>
+#include <pmp/SurfaceMesh.h>
+#include <pmp/SurfaceMeshIO.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+struct Format
+{
+    std::string name;
+    std::string extension;
+    bool binary;
+    bool readable;
+};
+
+const std::vector<Format> formats = {
+    {"off", "off", false, true},         {"off_binary", "off", true, true},
+    {"obj", "obj", false, true},         {"stl", "stl", false, true},
+    {"stl_binary", "stl", true, true},   {"ply", "ply", false, true},
+    {"ply_binary", "ply", true, true},   {"pmp", "pmp", false, true},
+    {"pmc", "pmc", false, true},         {"xyz", "xyz", false, true},
+    {"sma", "sma", false, true},         {"smb", "smb", false, true},
+    {"glb", "glb", false, false},
+};
+
+// input mesh of the benchmarks, generated or read on first use
+struct Source
+{
+    Source(std::string name, std::string filename, size_t n_subdivisions)
+        : name(std::move(name)),
+          filename(std::move(filename)),
+          n_subdivisions(n_subdivisions)
+    {
+    }
+
+    std::string name;
+    std::string filename; // empty for generated meshes
+    size_t n_subdivisions;
+
+    const SurfaceMesh& mesh()
+    {
+        if (!mesh_)
+        {
+            mesh_.reset(new SurfaceMesh);
+            if (filename.empty())
+                *mesh_ = SurfaceFactory::icosphere(n_subdivisions);
+            else
+                mesh_->read(filename);
+        }
+        return *mesh_;
+    }
+
+private:
+    std::shared_ptr<SurfaceMesh> mesh_;
+};
+
+bool file_exists(const std::string& filename)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+    fclose(file);
+    return true;
+}
+
+size_t file_size(const std::string& filename)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return 0;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fclose(file);
+    return size > 0 ? size_t(size) : 0;
+}
+
+IOFlags io_flags(const Format& format)
+{
+    IOFlags flags;
+    flags.use_binary = format.binary;
+    return flags;
+}
+
+std::string output_name(const Source& source, const Format& format)
+{
+    return "pmp_benchmark_" + source.name + "_" + format.name + "." +
+           format.extension;
+}
+
+// throughput, memory, and hardware event counters shared by reading and
+// writing. The peak RSS is that of the whole process so far, run formats
+// separately with --benchmark_filter for independent peaks.
+void set_counters(benchmark::State& state, size_t bytes, size_t n_vertices,
+                  size_t n_faces, size_t rss_growth, const PerfCounts& events)
+{
+    state.SetBytesProcessed(int64_t(state.iterations() * bytes));
+    state.counters["file_bytes"] = double(bytes);
+    state.counters["vertices_per_second"] = benchmark::Counter(
+        double(n_vertices), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["faces_per_second"] = benchmark::Counter(
+        double(n_faces), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["rss_growth"] = double(rss_growth);
+    state.counters["peak_rss"] = double(MemoryUsage::max_size());
+
+    if (!events.is_valid())
+        return;
+    const auto average = benchmark::Counter::kAvgIterations;
+    state.counters["cycles"] =
+        benchmark::Counter(double(events.cycles), average);
+    state.counters["instructions"] =
+        benchmark::Counter(double(events.instructions), average);
+    state.counters["llc_misses"] =
+        benchmark::Counter(double(events.cache_misses), average);
+    state.counters["branch_misses"] =
+        benchmark::Counter(double(events.branch_misses), average);
+    state.counters["ipc"] = events.ipc();
+}
+
+void write_mesh(benchmark::State& state, Source* source, const Format& format)
+{
+    const SurfaceMesh& mesh = source->mesh();
+    const std::string filename = output_name(*source, format);
+    const IOFlags flags = io_flags(format);
+
+    size_t rss_growth = 0;
+    PerfCounts events;
+    for (auto _ : state)
+    {
+        const size_t before = MemoryUsage::current_size();
+        const PerfCounterScope counters;
+        SurfaceMeshIO(filename, flags).write(mesh);
+        events += counters.counts();
+        const size_t after = MemoryUsage::current_size();
+        if (after > before)
+            rss_growth = std::max(rss_growth, after - before);
+    }
+
+    set_counters(state, file_size(filename), mesh.n_vertices(), mesh.n_faces(),
+                 rss_growth, events);
+}
+
+void read_mesh(benchmark::State& state, Source* source, const Format& format)
+{
+    const std::string filename = output_name(*source, format);
+    const IOFlags flags = io_flags(format);
+    if (!file_exists(filename))
+        SurfaceMeshIO(filename, flags).write(source->mesh());
+
+    size_t n_vertices = 0;
+    size_t n_faces = 0;
+    size_t rss_growth = 0;
+    PerfCounts events;
+    for (auto _ : state)
+    {
+        const size_t before = MemoryUsage::current_size();
+        const PerfCounterScope counters;
+        SurfaceMesh mesh;
+        SurfaceMeshIO(filename, flags).read(mesh);
+        events += counters.counts();
+        const size_t after = MemoryUsage::current_size();
+        if (after > before)
+            rss_growth = std::max(rss_growth, after - before);
+        n_vertices = mesh.n_vertices();
+        n_faces = mesh.n_faces();
+        benchmark::DoNotOptimize(mesh);
+    }
+
+    set_counters(state, file_size(filename), n_vertices, n_faces, rss_growth,
+                 events);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // generated spheres from 1280 to 327680 faces
+    std::vector<Source> sources;
+    for (size_t n = 3; n <= 7; ++n)
+        sources.emplace_back("icosphere" + std::to_string(n), "", n);
+
+    // real-world meshes, if the data submodule is checked out
+    for (const std::string name : {"off/bunny.off", "off/fandisk.off",
+                                   "off/hemisphere.off", "obj/suzanne.obj"})
+    {
+        const std::string filename = std::string(PMP_DATA_DIR) + "/" + name;
+        if (file_exists(filename))
+        {
+            const auto slash = name.find('/');
+            const auto dot = name.rfind('.');
+            sources.emplace_back(name.substr(slash + 1, dot - slash - 1),
+                                 filename, 0);
+        }
+    }
+
+    for (auto& source : sources)
+    {
+        for (const auto& format : formats)
+        {
+            const std::string suffix = format.name + "/" + source.name;
+            Source* s = &source;
+            benchmark::RegisterBenchmark(
+                ("write/" + suffix).c_str(),
+                [s, format](benchmark::State& state) {
+                    write_mesh(state, s, format);
+                })
+                ->Unit(benchmark::kMillisecond);
+            if (format.readable)
+                benchmark::RegisterBenchmark(
+                    ("read/" + suffix).c_str(),
+                    [s, format](benchmark::State& state) {
+                        read_mesh(state, s, format);
+                    })
+                    ->Unit(benchmark::kMillisecond);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    // remove the files written by the benchmarks
+    for (const auto& source : sources)
+        for (const auto& format : formats)
+            std::remove(output_name(source, format).c_str());
+
+    return 0;
+}
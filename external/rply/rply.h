@@ -9,6 +9,8 @@
  * at the end of this file.
  * ---------------------------------------------------------------------- */
 
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,6 +73,19 @@ int ply_get_ply_user_data(p_ply ply, void **pdata, long *idata);
 p_ply ply_open(const char *name, p_ply_error_cb error_cb, long idata,
         void *pdata);
 
+/* ----------------------------------------------------------------------
+ * Opens a PLY file for reading from an open file stream. The stream is
+ * not closed by ply_close.
+ *
+ * file_pointer: FILE * to file open for reading
+ * error_cb: error callback function
+ * idata,pdata: contextual information available to users
+ *
+ * Returns handle to PLY file if successful, NULL otherwise
+ * ---------------------------------------------------------------------- */
+p_ply ply_open_from_file(FILE *file_pointer, p_ply_error_cb error_cb,
+        long idata, void *pdata);
+
 /* ----------------------------------------------------------------------
  * Reads and parses the header of a PLY file returned by ply_open
  *
@@ -247,6 +262,20 @@ int ply_get_property_info(p_ply_property property, const char** name,
 p_ply ply_create(const char *name, e_ply_storage_mode storage_mode,
         p_ply_error_cb error_cb, long idata, void *pdata);
 
+/* ----------------------------------------------------------------------
+ * Creates new PLY file writing to an open file stream. The stream is not
+ * closed by ply_close.
+ *
+ * file_pointer: FILE * to a file open for writing
+ * storage_mode: file format mode
+ * error_cb: error callback function
+ * idata,pdata: contextual information available to users
+ *
+ * Returns handle to PLY file if successfull, NULL otherwise
+ * ---------------------------------------------------------------------- */
+p_ply ply_create_to_file(FILE *file_pointer, e_ply_storage_mode storage_mode,
+        p_ply_error_cb error_cb, long idata, void *pdata);
+
 /* ----------------------------------------------------------------------
  * Adds a new element to the PLY file created by ply_create
  *
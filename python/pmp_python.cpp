@@ -0,0 +1,464 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+#include "pmp/SurfaceMeshIO.h"
+#include "pmp/algorithms/SurfaceNormals.h"
+#include "pmp/algorithms/SurfaceRemeshing.h"
+#include "pmp/algorithms/SurfaceSimplification.h"
+#include "pmp/algorithms/SurfaceSmoothing.h"
+#include "pmp/algorithms/SurfaceSubdivision.h"
+
+namespace py = pybind11;
+using namespace pmp;
+
+namespace {
+
+// the views rely on vectors and handles being plain arrays of numbers
+static_assert(sizeof(Vector<float, 3>) == 3 * sizeof(float),
+              "vectors must not be padded");
+static_assert(sizeof(Vector<double, 3>) == 3 * sizeof(double),
+              "vectors must not be padded");
+static_assert(sizeof(Vertex) == sizeof(IndexType),
+              "handles must only hold their index");
+
+typedef py::array_t<Scalar, py::array::c_style | py::array::forcecast>
+    ScalarArray;
+typedef py::array_t<IndexType, py::array::c_style | py::array::forcecast>
+    IndexArray;
+
+// access to the properties of one kind of element by name
+template <class H>
+struct Elements;
+
+template <>
+struct Elements<Vertex>
+{
+    template <class T>
+    static Property<T> get(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.get_vertex_property<T>(name);
+    }
+    template <class T>
+    static Property<T> add(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.add_vertex_property<T>(name);
+    }
+    static const std::type_info& type(SurfaceMesh& mesh,
+                                      const std::string& name)
+    {
+        return mesh.get_vertex_property_type(name);
+    }
+    static size_t size(const SurfaceMesh& mesh) { return mesh.vertices_size(); }
+};
+
+template <>
+struct Elements<Halfedge>
+{
+    template <class T>
+    static Property<T> get(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.get_halfedge_property<T>(name);
+    }
+    template <class T>
+    static Property<T> add(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.add_halfedge_property<T>(name);
+    }
+    static const std::type_info& type(SurfaceMesh& mesh,
+                                      const std::string& name)
+    {
+        return mesh.get_halfedge_property_type(name);
+    }
+    static size_t size(const SurfaceMesh& mesh)
+    {
+        return mesh.halfedges_size();
+    }
+};
+
+template <>
+struct Elements<Edge>
+{
+    template <class T>
+    static Property<T> get(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.get_edge_property<T>(name);
+    }
+    template <class T>
+    static Property<T> add(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.add_edge_property<T>(name);
+    }
+    static const std::type_info& type(SurfaceMesh& mesh,
+                                      const std::string& name)
+    {
+        return mesh.get_edge_property_type(name);
+    }
+    static size_t size(const SurfaceMesh& mesh) { return mesh.edges_size(); }
+};
+
+template <>
+struct Elements<Face>
+{
+    template <class T>
+    static Property<T> get(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.get_face_property<T>(name);
+    }
+    template <class T>
+    static Property<T> add(SurfaceMesh& mesh, const std::string& name)
+    {
+        return mesh.add_face_property<T>(name);
+    }
+    static const std::type_info& type(SurfaceMesh& mesh,
+                                      const std::string& name)
+    {
+        return mesh.get_face_property_type(name);
+    }
+    static size_t size(const SurfaceMesh& mesh) { return mesh.faces_size(); }
+};
+
+// A writable array over the storage of property \p prop whose elements
+// consist of \p n_components values of type C. The array keeps \p base,
+// the Python mesh, alive. Shared or sparse storage is made dense and unique
+// first, wrapped external memory is viewed with its stride. The property is
+// pinned such that copies of the mesh do not share the viewed elements, but
+// its elements are still accessed directly in C++, see
+// PropertyArray::mutable_data().
+template <class C, class T>
+py::array view(Property<T> prop, size_t n_components, py::handle base)
+{
+    const auto n = py::ssize_t(prop.size());
+    const auto stride = py::ssize_t(prop.stride());
+    auto* data = reinterpret_cast<C*>(prop.mutable_data());
+    if (n_components == 1)
+        return py::array_t<C>({n}, {stride}, data, base);
+    return py::array_t<C>({n, py::ssize_t(n_components)},
+                          {stride, py::ssize_t(sizeof(C))}, data, base);
+}
+
+// bool properties are bit-packed and can only be copied
+py::array copy_bools(Property<bool> prop)
+{
+    py::array_t<bool> array(prop.size());
+    auto out = array.mutable_unchecked<1>();
+    const Property<bool>& cprop = prop;
+    for (size_t i = 0; i < cprop.size(); ++i)
+        out(i) = cprop[i];
+    return std::move(array);
+}
+
+template <class H>
+py::object property(py::object self, const std::string& name)
+{
+    auto& mesh = self.cast<SurfaceMesh&>();
+    const std::type_info& type = Elements<H>::type(mesh, name);
+
+#define PMP_VIEW(T, C, N)                                                     \
+    if (type == typeid(T))                                                    \
+        return view<C>(Elements<H>::template get<T>(mesh, name), N, self);
+
+    PMP_VIEW(float, float, 1)
+    PMP_VIEW(double, double, 1)
+    PMP_VIEW(int, int, 1)
+    PMP_VIEW(unsigned int, unsigned int, 1)
+    PMP_VIEW(Vector<float, 2>, float, 2)
+    PMP_VIEW(Vector<double, 2>, double, 2)
+    PMP_VIEW(Vector<float, 3>, float, 3)
+    PMP_VIEW(Vector<double, 3>, double, 3)
+    PMP_VIEW(Vertex, IndexType, 1)
+    PMP_VIEW(Halfedge, IndexType, 1)
+    PMP_VIEW(Edge, IndexType, 1)
+    PMP_VIEW(Face, IndexType, 1)
+
+#undef PMP_VIEW
+
+    if (type == typeid(bool))
+        return copy_bools(Elements<H>::template get<bool>(mesh, name));
+
+    if (type == typeid(void))
+        throw py::key_error("no property named " + name);
+    throw py::type_error("property " + name +
+                         " has a type without NumPy equivalent");
+}
+
+// add a property initialized from \p values, one row per element
+template <class H, class C>
+py::object add_typed(py::object self, const std::string& name,
+                     const py::array& values)
+{
+    auto& mesh = self.cast<SurfaceMesh&>();
+    auto array =
+        py::array_t<C, py::array::c_style | py::array::forcecast>::ensure(
+            values);
+    if (!array)
+        throw py::type_error("values must be convertible to an array");
+    const size_t n = Elements<H>::size(mesh);
+    if (array.ndim() < 1 || array.ndim() > 2 || size_t(array.shape(0)) != n)
+        throw py::value_error("values must have one row per element");
+    const size_t n_components =
+        array.ndim() == 2 ? size_t(array.shape(1)) : size_t(1);
+    if (n_components != 1 && !std::is_same<C, Scalar>::value)
+        throw py::value_error("integer values must have one column");
+
+    if (n_components == 1)
+    {
+        auto prop = Elements<H>::template add<C>(mesh, name);
+        std::copy(array.data(), array.data() + n, prop.mutable_data());
+        return view<C>(prop, 1, self);
+    }
+    if (n_components == 2)
+    {
+        auto prop = Elements<H>::template add<Vector<C, 2>>(mesh, name);
+        std::copy(array.data(), array.data() + 2 * n,
+                  reinterpret_cast<C*>(prop.mutable_data()));
+        return view<C>(prop, 2, self);
+    }
+    if (n_components == 3)
+    {
+        auto prop = Elements<H>::template add<Vector<C, 3>>(mesh, name);
+        std::copy(array.data(), array.data() + 3 * n,
+                  reinterpret_cast<C*>(prop.mutable_data()));
+        return view<C>(prop, 3, self);
+    }
+    throw py::value_error("values must have one, two, or three columns");
+}
+
+template <class H>
+py::object add_property(py::object self, const std::string& name,
+                        const py::array& values)
+{
+    auto& mesh = self.cast<SurfaceMesh&>();
+    if (Elements<H>::type(mesh, name) != typeid(void))
+        throw py::key_error("property " + name + " already exists");
+
+    const auto kind = values.dtype().kind();
+    if (kind == 'f')
+        return add_typed<H, Scalar>(self, name, values);
+    if (kind == 'i')
+        return add_typed<H, int>(self, name, values);
+    if (kind == 'u')
+        return add_typed<H, unsigned int>(self, name, values);
+    throw py::type_error("values must be floating point or integers");
+}
+
+void from_arrays(SurfaceMesh& mesh, const ScalarArray& points,
+                 const IndexArray& faces, const IndexArray& face_sizes)
+{
+    if (points.ndim() != 2 || points.shape(1) != 3)
+        throw py::value_error("points must have shape (n, 3)");
+    if (faces.ndim() != 1 && faces.ndim() != 2)
+        throw py::value_error("faces must have shape (m, k) or (k,)");
+    if (faces.ndim() == 2 && face_sizes.size() > 0)
+        throw py::value_error("face_sizes requires flat faces");
+
+    // from_indexed_faces() takes vectors, which costs one plain copy
+    const auto* p = reinterpret_cast<const Point*>(points.data());
+    std::vector<Point> positions(p, p + points.shape(0));
+    std::vector<IndexType> indices(faces.data(), faces.data() + faces.size());
+    std::vector<IndexType> sizes(face_sizes.data(),
+                                 face_sizes.data() + face_sizes.size());
+    if (faces.ndim() == 2 && faces.shape(1) != 3)
+        sizes.assign(faces.shape(0), IndexType(faces.shape(1)));
+
+    py::gil_scoped_release release;
+    mesh.from_indexed_faces(positions, indices, sizes);
+}
+
+// the vertex indices of all faces, as rows of a 2D array if all faces have
+// the same valence and as a flat array with the face sizes otherwise
+py::object face_indices(const SurfaceMesh& mesh)
+{
+    // deleted vertices would leave gaps in the indices
+    if (mesh.n_vertices() != mesh.vertices_size())
+        throw py::value_error("call garbage_collection() first");
+
+    std::vector<IndexType> indices, sizes;
+    indices.reserve(3 * mesh.n_faces());
+    sizes.reserve(mesh.n_faces());
+    {
+        py::gil_scoped_release release;
+        for (auto f : mesh.faces())
+        {
+            IndexType n = 0;
+            for (auto v : mesh.vertices(f))
+            {
+                indices.push_back(v.idx());
+                ++n;
+            }
+            sizes.push_back(n);
+        }
+    }
+
+    const bool uniform =
+        std::all_of(sizes.begin(), sizes.end(),
+                    [&](IndexType n) { return n == sizes.front(); });
+    py::array_t<IndexType> flat(indices.size(), indices.data());
+    if (uniform && !sizes.empty())
+        return flat.attr("reshape")(sizes.size(), sizes.front());
+    return py::make_tuple(flat, py::array_t<IndexType>(sizes.size(),
+                                                       sizes.data()));
+}
+
+} // namespace
+
+PYBIND11_MODULE(pmp, m)
+{
+    m.doc() = "Polygon Mesh Processing Library";
+
+    py::class_<SurfaceMesh>(m, "SurfaceMesh")
+        .def(py::init<>())
+        .def(py::init<const SurfaceMesh&>())
+        .def("n_vertices", &SurfaceMesh::n_vertices)
+        .def("n_halfedges", &SurfaceMesh::n_halfedges)
+        .def("n_edges", &SurfaceMesh::n_edges)
+        .def("n_faces", &SurfaceMesh::n_faces)
+        .def("is_empty", &SurfaceMesh::is_empty)
+        .def("is_triangle_mesh", &SurfaceMesh::is_triangle_mesh)
+        .def("is_quad_mesh", &SurfaceMesh::is_quad_mesh)
+        .def(
+            "garbage_collection",
+            [](SurfaceMesh& mesh) { mesh.garbage_collection(); },
+            py::call_guard<py::gil_scoped_release>())
+        .def("clear", &SurfaceMesh::clear)
+        .def("from_arrays", &from_arrays, py::arg("points"), py::arg("faces"),
+             py::arg("face_sizes") = IndexArray(),
+             "Replace the mesh by the points of shape (n, 3) and the faces, "
+             "either of shape (m, k) or flat with their face_sizes.")
+        .def("face_indices", &face_indices,
+             "The vertex indices of the faces, of shape (m, k) if all faces "
+             "have k vertices and as a tuple of flat indices and face sizes "
+             "otherwise.")
+        .def_property_readonly(
+            "points",
+            [](py::object self) { return property<Vertex>(self, "v:point"); },
+            "Writable view of the vertex positions, of shape (n, 3).")
+        .def("vertex_property", &property<Vertex>, py::arg("name"))
+        .def("halfedge_property", &property<Halfedge>, py::arg("name"))
+        .def("edge_property", &property<Edge>, py::arg("name"))
+        .def("face_property", &property<Face>, py::arg("name"))
+        .def("add_vertex_property", &add_property<Vertex>, py::arg("name"),
+             py::arg("values"))
+        .def("add_halfedge_property", &add_property<Halfedge>,
+             py::arg("name"), py::arg("values"))
+        .def("add_edge_property", &add_property<Edge>, py::arg("name"),
+             py::arg("values"))
+        .def("add_face_property", &add_property<Face>, py::arg("name"),
+             py::arg("values"))
+        .def("vertex_properties", &SurfaceMesh::vertex_properties)
+        .def("halfedge_properties", &SurfaceMesh::halfedge_properties)
+        .def("edge_properties", &SurfaceMesh::edge_properties)
+        .def("face_properties", &SurfaceMesh::face_properties);
+
+    // file I/O
+
+    m.def(
+        "read",
+        [](const std::string& filename) {
+            SurfaceMesh mesh;
+            SurfaceMeshIO(filename, IOFlags()).read(mesh);
+            return mesh;
+        },
+        py::arg("filename"), py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "write",
+        [](const SurfaceMesh& mesh, const std::string& filename,
+           bool binary) {
+            IOFlags flags;
+            flags.use_binary = binary;
+            SurfaceMeshIO(filename, flags).write(mesh);
+        },
+        py::arg("mesh"), py::arg("filename"), py::arg("binary") = false,
+        py::call_guard<py::gil_scoped_release>());
+
+    // algorithms, which do not hold the GIL while they run
+
+    m.def(
+        "vertex_normals",
+        [](SurfaceMesh& mesh) { SurfaceNormals::compute_vertex_normals(mesh); },
+        py::arg("mesh"), py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "face_normals",
+        [](SurfaceMesh& mesh) { SurfaceNormals::compute_face_normals(mesh); },
+        py::arg("mesh"), py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "triangulate", [](SurfaceMesh& mesh) { mesh.triangulate(); },
+        py::arg("mesh"), py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "explicit_smoothing",
+        [](SurfaceMesh& mesh, unsigned int iterations, bool uniform) {
+            SurfaceSmoothing(mesh).explicit_smoothing(iterations, uniform);
+        },
+        py::arg("mesh"), py::arg("iterations") = 10,
+        py::arg("use_uniform_laplace") = false,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "implicit_smoothing",
+        [](SurfaceMesh& mesh, Scalar timestep, bool uniform, bool rescale) {
+            SurfaceSmoothing(mesh).implicit_smoothing(timestep, uniform,
+                                                      rescale);
+        },
+        py::arg("mesh"), py::arg("timestep") = 0.001,
+        py::arg("use_uniform_laplace") = false, py::arg("rescale") = true,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "uniform_remeshing",
+        [](SurfaceMesh& mesh, Scalar edge_length, unsigned int iterations,
+           bool use_projection) {
+            SurfaceRemeshing(mesh).uniform_remeshing(edge_length, iterations,
+                                                     use_projection);
+        },
+        py::arg("mesh"), py::arg("edge_length"), py::arg("iterations") = 10,
+        py::arg("use_projection") = true,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "adaptive_remeshing",
+        [](SurfaceMesh& mesh, Scalar min_edge_length, Scalar max_edge_length,
+           Scalar approx_error, unsigned int iterations, bool use_projection) {
+            SurfaceRemeshing(mesh).adaptive_remeshing(
+                min_edge_length, max_edge_length, approx_error, iterations,
+                use_projection);
+        },
+        py::arg("mesh"), py::arg("min_edge_length"),
+        py::arg("max_edge_length"), py::arg("approx_error"),
+        py::arg("iterations") = 10, py::arg("use_projection") = true,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "simplification",
+        [](SurfaceMesh& mesh, unsigned int n_vertices, Scalar aspect_ratio,
+           Scalar edge_length, unsigned int max_valence,
+           Scalar normal_deviation, Scalar hausdorff_error) {
+            SurfaceSimplification simplification(mesh);
+            simplification.initialize(aspect_ratio, edge_length, max_valence,
+                                      normal_deviation, hausdorff_error);
+            simplification.simplify(n_vertices);
+        },
+        py::arg("mesh"), py::arg("n_vertices"), py::arg("aspect_ratio") = 0.0,
+        py::arg("edge_length") = 0.0, py::arg("max_valence") = 0,
+        py::arg("normal_deviation") = 0.0, py::arg("hausdorff_error") = 0.0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "loop_subdivision",
+        [](SurfaceMesh& mesh, unsigned int steps) {
+            SurfaceSubdivision(mesh).loop(steps);
+        },
+        py::arg("mesh"), py::arg("steps") = 1,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "catmull_clark_subdivision",
+        [](SurfaceMesh& mesh, unsigned int steps) {
+            SurfaceSubdivision(mesh).catmull_clark(steps);
+        },
+        py::arg("mesh"), py::arg("steps") = 1,
+        py::call_guard<py::gil_scoped_release>());
+}
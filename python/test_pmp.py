@@ -0,0 +1,81 @@
+# Copyright 2021 the Polygon Mesh Processing Library developers.
+# Distributed under a MIT-style license, see LICENSE.txt for details.
+
+import threading
+
+import numpy as np
+
+import pmp
+
+
+def quad_grid(n):
+    """An n x n grid of quads in the xy-plane."""
+    i, j = np.meshgrid(np.arange(n + 1), np.arange(n + 1))
+    points = np.stack([i.ravel(), j.ravel(), np.zeros(i.size)], axis=1)
+    corners = (j[:-1, :-1] * (n + 1) + i[:-1, :-1]).ravel()
+    faces = np.stack(
+        [corners, corners + 1, corners + n + 2, corners + n + 1], axis=1
+    )
+    return points, faces
+
+
+def test_bulk_construction():
+    points, faces = quad_grid(4)
+    mesh = pmp.SurfaceMesh()
+    mesh.from_arrays(points, faces)
+    assert mesh.n_vertices() == 25
+    assert mesh.n_faces() == 16
+    assert mesh.is_quad_mesh()
+    np.testing.assert_array_equal(mesh.face_indices(), faces)
+
+    # flat faces with their sizes
+    mesh.from_arrays(points, faces.ravel(), np.full(16, 4))
+    np.testing.assert_array_equal(mesh.face_indices(), faces)
+
+
+def test_view_round_trip():
+    points, faces = quad_grid(2)
+    mesh = pmp.SurfaceMesh()
+    mesh.from_arrays(points, faces)
+
+    # writes through the view show in the mesh and in later views
+    view = mesh.points
+    view[:, 2] = 1.0
+    np.testing.assert_allclose(mesh.points[:, 2], 1.0)
+
+    # copies do not see writes through views of the original
+    copy = pmp.SurfaceMesh(mesh)
+    view[0] = (5, 6, 7)
+    np.testing.assert_allclose(copy.points[0], points[0] + (0, 0, 1))
+    np.testing.assert_allclose(mesh.points[0], (5, 6, 7))
+
+    # added properties are views as well
+    weight = mesh.add_vertex_property("v:weight", np.arange(9.0))
+    weight *= 2
+    np.testing.assert_allclose(mesh.vertex_property("v:weight"),
+                               2 * np.arange(9.0))
+    del mesh
+    assert weight.base is not None
+
+
+def test_gil_released():
+    points, faces = quad_grid(64)
+    meshes = []
+    for _ in range(4):
+        mesh = pmp.SurfaceMesh()
+        mesh.from_arrays(points, faces)
+        pmp.triangulate(mesh)
+        meshes.append(mesh)
+
+    # smoothing runs without the GIL, such that threads overlap
+    threads = [
+        threading.Thread(target=pmp.explicit_smoothing, args=(mesh, 5, True))
+        for mesh in meshes
+    ]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for mesh in meshes:
+        assert mesh.is_triangle_mesh()
+        np.testing.assert_allclose(mesh.points[:, 2], 0.0)
@@ -0,0 +1,113 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+// Input and output files of the batch modes of the command line tools.
+
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glob.h>
+#include <sys/stat.h>
+
+// input and output file of a batch job
+struct Job
+{
+    std::string input;
+    std::string output;
+};
+
+inline size_t file_size(const std::string& filename)
+{
+    struct stat st;
+    return stat(filename.c_str(), &st) == 0 ? size_t(st.st_size) : 0;
+}
+
+// output name of input in directory with extension format
+inline std::string output_name(const std::string& input,
+                               const std::string& format,
+                               const std::string& directory)
+{
+    auto slash = input.rfind('/');
+    std::string dir =
+        slash == std::string::npos ? "" : input.substr(0, slash + 1);
+    std::string stem =
+        slash == std::string::npos ? input : input.substr(slash + 1);
+
+    // strip compression and format extensions
+    for (const char* ext : {".gz", ".zst"})
+    {
+        const std::string e(ext);
+        if (stem.size() > e.size() &&
+            stem.compare(stem.size() - e.size(), e.size(), e) == 0)
+            stem.resize(stem.size() - e.size());
+    }
+    auto dot = stem.rfind('.');
+    if (dot != std::string::npos && dot > 0)
+        stem.resize(dot);
+
+    if (!directory.empty())
+        dir = directory.back() == '/' ? directory : directory + "/";
+    return dir + stem + "." + format;
+}
+
+// the jobs of a manifest with one '<input> [<output>]' per line
+inline std::vector<Job> read_manifest(const char* filename,
+                                      const std::string& format,
+                                      const std::string& directory)
+{
+    std::ifstream ifs(filename);
+    if (!ifs)
+    {
+        std::cerr << "Failed to read manifest: " << filename << std::endl;
+        exit(1);
+    }
+
+    std::vector<Job> jobs;
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        Job job;
+        if (!(iss >> job.input) || job.input[0] == '#')
+            continue;
+        if (!(iss >> job.output))
+        {
+            if (format.empty())
+            {
+                std::cerr << "No output for " << job.input
+                          << ", specify a format with -f" << std::endl;
+                exit(1);
+            }
+            job.output = output_name(job.input, format, directory);
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+// the jobs of the files matching pattern
+inline std::vector<Job> glob_files(const char* pattern,
+                                   const std::string& format,
+                                   const std::string& directory)
+{
+    std::vector<Job> jobs;
+    glob_t matches;
+    if (glob(pattern, 0, nullptr, &matches) == 0)
+    {
+        for (size_t i = 0; i < matches.gl_pathc; ++i)
+        {
+            Job job;
+            job.input = matches.gl_pathv[i];
+            job.output = output_name(job.input, format, directory);
+            jobs.push_back(job);
+        }
+    }
+    globfree(&matches);
+    return jobs;
+}
@@ -17,13 +17,193 @@
 
 MeshProcessingViewer::MeshProcessingViewer(const char* title, int width,
                                            int height)
-    : MeshViewer(title, width, height), smoother_(mesh_)
+    : MeshViewer(title, width, height),
+      history_(mesh_),
+      smoother_(worker_),
+      job_progress_(-1),
+      cancel_job_(false),
+      job_generation_(0),
+      job_mesh_generation_(0)
 {
     //crease_angle_ = 90.0;
     //set_draw_mode("Hidden Line");
 
     // add help items
     add_help_item("O", "Flip mesh orientation", 5);
+    add_help_item("Ctrl+Z", "Undo", 6);
+    add_help_item("Ctrl+Y", "Redo", 7);
+
+    // keep the undoable edits of large meshes bounded
+    history_.set_memory_limit(size_t(512) << 20);
+}
+
+MeshProcessingViewer::~MeshProcessingViewer()
+{
+    // the job uses our members
+    cancel_job_ = true;
+    if (job_.valid())
+        job_.wait();
+}
+
+void MeshProcessingViewer::run_job(const char* name, std::function<void()> job)
+{
+    // a mesh being loaded replaces the result, a streamed one has no
+    // connectivity yet
+    if (job_.valid() || is_loading())
+        return;
+
+    // remember the mesh, to discard the result if it is replaced meanwhile
+    if (!mesh_.change_tracking())
+        mesh_.set_change_tracking(true);
+    job_mesh_generation_ = mesh_.new_generation();
+    auto marker = mesh_.object_property<uint64_t>("viewer:job_generation");
+    marker[0] = job_mesh_generation_;
+
+    // work on a copy, such that the mesh can be drawn meanwhile
+    worker_ = mesh_;
+    worker_.set_change_tracking(true);
+    job_generation_ = worker_.new_generation();
+
+    job_name_ = name;
+    job_start_ = std::chrono::steady_clock::now();
+    job_progress_ = -1;
+    cancel_job_ = false;
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    job_ = std::async(std::launch::deferred, job);
+    finish_job();
+#else
+    job_ = std::async(std::launch::async, job);
+#endif
+}
+
+ProgressCallback MeshProcessingViewer::job_progress()
+{
+    return [this](float fraction) {
+        job_progress_ = fraction;
+        return !cancel_job_;
+    };
+}
+
+void MeshProcessingViewer::do_processing()
+{
+    MeshViewer::do_processing();
+
+    if (!job_.valid())
+        return;
+
+    // keep showing the progress until the job is done
+    request_redraw();
+    if (job_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        finish_job();
+}
+
+void MeshProcessingViewer::finish_job()
+{
+    try
+    {
+        job_.get();
+    }
+    catch (const CancelledException&)
+    {
+        return;
+    }
+    catch (const InvalidInputException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+    catch (const SolverException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+
+    // was the mesh replaced, e.g., by loading another one?
+    const ObjectProperty<uint64_t> marker =
+        mesh_.get_object_property<uint64_t>("viewer:job_generation");
+    if (!marker || !marker.generation() || marker[0] != job_mesh_generation_)
+        return;
+
+    // copy only moved vertices if the connectivity is unchanged, such that
+    // the buffers are updated incrementally
+    const VertexProperty<Point> points =
+        worker_.get_vertex_property<Point>("v:point");
+    if (worker_.topology_generation() <= job_generation_)
+    {
+        begin_edit();
+        for (auto i : points.changed_since(job_generation_))
+        {
+            const Vertex v(static_cast<IndexType>(i));
+            mesh_.position(v) = points[v];
+        }
+        commit_edit(job_name_);
+    }
+    else
+    {
+        // only the modified elements are stored for undo
+        assign_edit(worker_, job_name_);
+    }
+    update_mesh();
+}
+
+void MeshProcessingViewer::begin_edit()
+{
+    check_history();
+    history_.begin();
+}
+
+void MeshProcessingViewer::commit_edit(const std::string& name)
+{
+    history_.commit(name);
+    mark_history();
+}
+
+void MeshProcessingViewer::assign_edit(const SurfaceMesh& mesh,
+                                       const std::string& name)
+{
+    check_history();
+    history_.assign(mesh, name);
+    mark_history();
+}
+
+void MeshProcessingViewer::undo()
+{
+    check_history();
+    if (!history_.can_undo())
+        return;
+    std::cout << "Undo " << history_.undo_name() << std::endl;
+    history_.undo();
+    mark_history();
+    update_mesh();
+}
+
+void MeshProcessingViewer::redo()
+{
+    check_history();
+    if (!history_.can_redo())
+        return;
+    std::cout << "Redo " << history_.redo_name() << std::endl;
+    history_.redo();
+    mark_history();
+    update_mesh();
+}
+
+void MeshProcessingViewer::check_history()
+{
+    // loading or replacing the mesh removes the marker
+    const ObjectProperty<const SurfaceMeshHistory*> marker =
+        mesh_.get_object_property<const SurfaceMeshHistory*>(
+            "viewer:history");
+    if (!marker || marker[0] != &history_)
+        history_.clear();
+}
+
+void MeshProcessingViewer::mark_history()
+{
+    auto marker =
+        mesh_.object_property<const SurfaceMeshHistory*>("viewer:history");
+    marker[0] = &history_;
 }
 
 void MeshProcessingViewer::keyboard(int key, int scancode, int action, int mods)
@@ -31,8 +211,32 @@ void MeshProcessingViewer::keyboard(int key, int scancode, int action, int mods)
     if (action != GLFW_PRESS && action != GLFW_REPEAT)
         return;
 
+    // the result of a running job would replace the modified mesh
+    const bool modifies_mesh =
+        key == GLFW_KEY_O || key == GLFW_KEY_M ||
+        (key >= GLFW_KEY_1 && key <= GLFW_KEY_8) ||
+        (ctrl_pressed() && (key == GLFW_KEY_Z || key == GLFW_KEY_Y));
+    if (job_.valid() && modifies_mesh)
+        return;
+
     switch (key)
     {
+        case GLFW_KEY_Z: // undo, or redo with shift
+        case GLFW_KEY_Y: // redo
+        {
+            if (!ctrl_pressed())
+            {
+                MeshViewer::keyboard(key, scancode, action, mods);
+                break;
+            }
+            if (is_loading())
+                break;
+            if (key == GLFW_KEY_Z && !shift_pressed())
+                undo();
+            else
+                redo();
+            break;
+        }
         case GLFW_KEY_O: // change face orientation
         {
             SurfaceMeshGL new_mesh;
@@ -50,7 +254,7 @@ void MeshProcessingViewer::keyboard(int key, int scancode, int action, int mods)
                 std::reverse(vertices.begin(), vertices.end());
                 new_mesh.add_face(vertices);
             }
-            mesh_ = new_mesh;
+            assign_edit(new_mesh, "Flip Orientation");
             update_mesh();
             break;
         }
@@ -75,7 +279,9 @@ void MeshProcessingViewer::keyboard(int key, int scancode, int action, int mods)
             if (ee.is_valid())
             {
                 std::cout << "Merge faces incident to edge " << ee << std::endl;
+                begin_edit();
                 mesh_.remove_edge(ee);
+                commit_edit("Merge Faces");
                 update_mesh();
             }
             break;
@@ -89,6 +295,7 @@ void MeshProcessingViewer::keyboard(int key, int scancode, int action, int mods)
         case GLFW_KEY_7:
         case GLFW_KEY_8:
         {
+            history_.clear();
             switch (key)
             {
                 case GLFW_KEY_1:
@@ -138,6 +345,44 @@ void MeshProcessingViewer::process_imgui()
     ImGui::Spacing();
     ImGui::Spacing();
 
+    // show the progress of the running job instead of the algorithms
+    if (job_.valid())
+    {
+        ImGui::Text("%s", job_name_.c_str());
+        if (job_progress_ >= 0)
+        {
+            ImGui::ProgressBar(job_progress_, ImVec2(200, 0));
+        }
+        else
+        {
+            const std::chrono::duration<float> elapsed =
+                std::chrono::steady_clock::now() - job_start_;
+            ImGui::Text("%.1f s", elapsed.count());
+        }
+        if (cancel_job_)
+            ImGui::TextDisabled("Cancelling...");
+        else if (ImGui::Button("Cancel"))
+            cancel_job_ = true;
+        return;
+    }
+
+    if (history_.can_undo() || history_.can_redo())
+    {
+        if (history_.can_undo() && ImGui::Button("Undo"))
+            undo();
+        if (history_.can_redo())
+        {
+            if (history_.can_undo())
+                ImGui::SameLine();
+            if (ImGui::Button("Redo"))
+                redo();
+        }
+        if (history_.can_undo())
+            ImGui::TextDisabled("Undo: %s", history_.undo_name().c_str());
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+
     if (ImGui::CollapsingHeader("Curvature"))
     {
         if (ImGui::Button("Mean Curvature"))
@@ -181,8 +426,11 @@ void MeshProcessingViewer::process_imgui()
 
         if (ImGui::Button("Explicit Smoothing"))
         {
-            smoother_.explicit_smoothing(iterations);
-            update_mesh();
+            const int n = iterations;
+            run_job("Explicit Smoothing", [this, n]() {
+                smoother_.set_progress(job_progress());
+                smoother_.explicit_smoothing(n);
+            });
         }
 
         ImGui::Spacing();
@@ -197,16 +445,10 @@ void MeshProcessingViewer::process_imgui()
         if (ImGui::Button("Implicit Smoothing"))
         {
             Scalar dt = timestep * radius_ * radius_;
-            try
-            {
+            run_job("Implicit Smoothing", [this, dt]() {
+                smoother_.set_progress(job_progress());
                 smoother_.implicit_smoothing(dt);
-            }
-            catch (const SolverException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            });
         }
     }
 
@@ -232,18 +474,16 @@ void MeshProcessingViewer::process_imgui()
 
         if (ImGui::Button("Decimate it!"))
         {
-            try
-            {
-                SurfaceSimplification ss(mesh_);
-                ss.initialize(aspect_ratio, 0.0, 0.0, normal_deviation, 0.0);
-                ss.simplify(mesh_.n_vertices() * 0.01 * target_percentage);
-            }
-            catch (const InvalidInputException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            const Scalar ar = aspect_ratio;
+            const Scalar nd = normal_deviation;
+            const unsigned int n_vertices =
+                mesh_.n_vertices() * 0.01 * target_percentage;
+            run_job("Decimation", [this, ar, nd, n_vertices]() {
+                SurfaceSimplification ss(worker_);
+                ss.set_progress(job_progress());
+                ss.initialize(ar, 0.0, 0.0, nd, 0.0);
+                ss.simplify(n_vertices);
+            });
         }
     }
 
@@ -254,37 +494,42 @@ void MeshProcessingViewer::process_imgui()
     {
         if (ImGui::Button("Loop Subdivision"))
         {
-            try
-            {
-                SurfaceSubdivision(mesh_).loop();
-            }
-            catch (const InvalidInputException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            run_job("Loop Subdivision", [this]() {
+                SurfaceSubdivision subdivision(worker_);
+                subdivision.set_progress(job_progress());
+                subdivision.loop();
+            });
         }
 
         if (ImGui::Button("Sqrt(3) Subdivision"))
         {
-            try
-            {
-                SurfaceSubdivision(mesh_).sqrt3();
-            }
-            catch (const InvalidInputException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            run_job("Sqrt(3) Subdivision", [this]() {
+                SurfaceSubdivision subdivision(worker_);
+                subdivision.set_progress(job_progress());
+                subdivision.sqrt3();
+            });
         }
 
         if (ImGui::Button("Catmull-Clark Subdivision"))
         {
-            SurfaceSubdivision(mesh_).catmull_clark();
-            update_mesh();
+            run_job("Catmull-Clark Subdivision", [this]() {
+                SurfaceSubdivision subdivision(worker_);
+                subdivision.set_progress(job_progress());
+                subdivision.catmull_clark();
+            });
+        }
+
+#ifndef __EMSCRIPTEN__
+        // the draw mode "Subdivision Surface" refines on the GPU instead
+        static int display_levels = 3;
+        ImGui::PushItemWidth(100);
+        if (ImGui::SliderInt("Display Levels", &display_levels, 1, 5))
+        {
+            mesh_.set_subdivision_levels(display_levels);
+            set_draw_mode("Subdivision Surface");
         }
+        ImGui::PopItemWidth();
+#endif
     }
 
     ImGui::Spacing();
@@ -296,19 +541,14 @@ void MeshProcessingViewer::process_imgui()
         {
             auto bb = mesh_.bounds().size();
 
-            try
-            {
-                SurfaceRemeshing(mesh_).adaptive_remeshing(
+            run_job("Adaptive Remeshing", [this, bb]() {
+                SurfaceRemeshing remeshing(worker_);
+                remeshing.set_progress(job_progress());
+                remeshing.adaptive_remeshing(
                     0.001 * bb,  // min length
                     1.0 * bb,    // max length
                     0.001 * bb); // approx. error
-            }
-            catch (const InvalidInputException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            });
         }
 
         if (ImGui::Button("Uniform Remeshing"))
@@ -319,16 +559,11 @@ void MeshProcessingViewer::process_imgui()
                               mesh_.position(mesh_.vertex(eit, 1)));
             l /= (Scalar)mesh_.n_edges();
 
-            try
-            {
-                SurfaceRemeshing(mesh_).uniform_remeshing(l);
-            }
-            catch (const InvalidInputException& e)
-            {
-                std::cerr << e.what() << std::endl;
-                return;
-            }
-            update_mesh();
+            run_job("Uniform Remeshing", [this, l]() {
+                SurfaceRemeshing remeshing(worker_);
+                remeshing.set_progress(job_progress());
+                remeshing.uniform_remeshing(l);
+            });
         }
     }
 
@@ -370,6 +605,7 @@ void MeshProcessingViewer::process_imgui()
             // close smallest hole
             if (hmin.is_valid())
             {
+                begin_edit();
                 try
                 {
                     SurfaceHoleFilling hf(mesh_);
@@ -377,9 +613,17 @@ void MeshProcessingViewer::process_imgui()
                 }
                 catch (const InvalidInputException& e)
                 {
+                    history_.rollback();
+                    std::cerr << e.what() << std::endl;
+                    return;
+                }
+                catch (const SolverException& e)
+                {
+                    history_.rollback();
                     std::cerr << e.what() << std::endl;
                     return;
                 }
+                commit_edit("Close Hole");
                 update_mesh();
             }
             else
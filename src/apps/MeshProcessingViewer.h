@@ -5,6 +5,13 @@
 
 #include <pmp/visualization/MeshViewer.h>
 #include <pmp/algorithms/SurfaceSmoothing.h>
+#include <pmp/SurfaceMeshHistory.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
 
 using namespace pmp;
 
@@ -14,6 +21,9 @@ public:
     //! constructor
     MeshProcessingViewer(const char* title, int width, int height);
 
+    //! destructor
+    ~MeshProcessingViewer();
+
 protected:
     //! this function handles mouse button presses
     void mouse(int button, int action, int mods) override;
@@ -24,7 +34,55 @@ protected:
     //! draw the scene in different draw modes
     virtual void process_imgui() override;
 
+    //! finish a background job
+    void do_processing() override;
+
 private:
+    // run job on a copy of the mesh in a background thread, showing the
+    // progress. the result replaces the mesh when the job is done.
+    void run_job(const char* name, std::function<void()> job);
+
+    // callback showing the progress of the running job in the viewer and
+    // cancelling the algorithm if the job was cancelled
+    ProgressCallback job_progress();
+
+    // take over the result of the finished job
+    void finish_job();
+
+    // start recording an undoable edit of the mesh
+    void begin_edit();
+
+    // make the recorded edit undoable as name
+    void commit_edit(const std::string& name);
+
+    // replace the mesh by mesh as an undoable edit named name
+    void assign_edit(const SurfaceMesh& mesh, const std::string& name);
+
+    // undo or redo the latest edit
+    void undo();
+    void redo();
+
+    // forget the edits if the mesh was replaced, e.g., by loading another one
+    void check_history();
+
+    // mark the mesh whose edits are recorded
+    void mark_history();
+
+    // the copy of the mesh processed by background jobs
+    SurfaceMesh worker_;
+
+    // the undoable edits of the mesh
+    SurfaceMeshHistory history_;
+
     // smoother has to remember cotan weights, hence it global member
     SurfaceSmoothing smoother_;
+
+    // the running job
+    std::future<void> job_;
+    std::string job_name_;
+    std::chrono::steady_clock::time_point job_start_;
+    std::atomic<float> job_progress_; // negative if unknown
+    std::atomic<bool> cancel_job_;
+    uint64_t job_generation_;      // generation of worker_ at the start
+    uint64_t job_mesh_generation_; // generation of mesh_ at the start
 };
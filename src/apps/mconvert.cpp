@@ -2,27 +2,122 @@
 // Distributed under a MIT-style license, see LICENSE.txt for details.
 
 #include <pmp/SurfaceMesh.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <unistd.h>
 
+#include "BatchJobs.h"
+
 using namespace pmp;
 
 void usage_and_exit()
 {
-    std::cerr << "Usage:\nmconvert [-b] -i <input> -o <output>\n\nOptions\n"
+    std::cerr << "Usage:\nmconvert [-b] -i <input> -o <output>\n"
+              << "mconvert [-b] [-j <threads>] -m <manifest> | -g <pattern> "
+                 "-f <format> [-d <directory>]\n\nOptions\n"
               << " -b:  write binary format\n"
+              << " -m:  convert the files listed in <manifest>, one "
+                 "'<input> [<output>]' per line\n"
+              << " -g:  convert the files matching <pattern>, e.g. "
+                 "'meshes/*.obj'\n"
+              << " -f:  output format of files without output name, e.g. ply\n"
+              << " -d:  output directory of files without output name\n"
+              << " -j:  number of conversion threads, default: all cores\n"
               << "\n";
     exit(1);
 }
 
+// statistics of a batch conversion
+struct Statistics
+{
+    std::atomic<size_t> n_converted{0};
+    std::atomic<size_t> n_failed{0};
+    std::atomic<size_t> bytes_read{0};
+    std::atomic<size_t> bytes_written{0};
+    std::atomic<size_t> n_vertices{0};
+    std::atomic<size_t> n_faces{0};
+};
+
+// convert the jobs on a pool of threads, each reusing its mesh
+int convert_batch(const std::vector<Job>& jobs, const IOFlags& flags,
+                  unsigned int n_threads)
+{
+    Statistics stats;
+    std::atomic<size_t> next(0);
+    std::mutex output_mutex;
+
+    auto worker = [&]() {
+        SurfaceMesh mesh;
+        for (size_t i = next++; i < jobs.size(); i = next++)
+        {
+            const Job& job = jobs[i];
+            try
+            {
+                mesh.read(job.input);
+                mesh.write(job.output, flags);
+            }
+            catch (const std::exception& e)
+            {
+                ++stats.n_failed;
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cerr << "Failed to convert " << job.input << ": "
+                          << e.what() << std::endl;
+                continue;
+            }
+            ++stats.n_converted;
+            stats.n_vertices += mesh.n_vertices();
+            stats.n_faces += mesh.n_faces();
+            stats.bytes_read += file_size(job.input);
+            stats.bytes_written += file_size(job.output);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    n_threads = std::max(1u, std::min(n_threads, unsigned(jobs.size())));
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < n_threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const double seconds = std::max(elapsed.count(), 1e-9);
+    const double mb = 1024.0 * 1024.0;
+    std::cout << "Converted " << stats.n_converted << " of " << jobs.size()
+              << " files in " << seconds << " s (" << n_threads
+              << " threads)\n"
+              << "  " << stats.n_converted / seconds << " files/s, "
+              << stats.bytes_read / mb / seconds << " MB/s read, "
+              << stats.bytes_written / mb / seconds << " MB/s written\n"
+              << "  " << stats.n_vertices << " vertices, " << stats.n_faces
+              << " faces" << std::endl;
+
+    return stats.n_failed ? 1 : 0;
+}
+
 int main(int argc, char** argv)
 {
     bool binary = false;
     const char* input = nullptr;
     const char* output = nullptr;
+    const char* manifest = nullptr;
+    const char* pattern = nullptr;
+    std::string format;
+    std::string directory;
+    unsigned int n_threads = std::thread::hardware_concurrency();
 
     // parse command line parameters
     int c;
-    while ((c = getopt(argc, argv, "bi:o:")) != -1)
+    while ((c = getopt(argc, argv, "bi:o:m:g:f:d:j:")) != -1)
     {
         switch (c)
         {
@@ -38,11 +133,49 @@ int main(int argc, char** argv)
                 output = optarg;
                 break;
 
+            case 'm':
+                manifest = optarg;
+                break;
+
+            case 'g':
+                pattern = optarg;
+                break;
+
+            case 'f':
+                format = optarg;
+                break;
+
+            case 'd':
+                directory = optarg;
+                break;
+
+            case 'j':
+                n_threads = unsigned(std::max(1, atoi(optarg)));
+                break;
+
             default:
                 usage_and_exit();
         }
     }
 
+    IOFlags flags;
+    flags.use_binary = binary;
+
+    // batch conversion
+    if (manifest || pattern)
+    {
+        if ((manifest && pattern) || (pattern && format.empty()))
+            usage_and_exit();
+        auto jobs = manifest ? read_manifest(manifest, format, directory)
+                             : glob_files(pattern, format, directory);
+        if (jobs.empty())
+        {
+            std::cerr << "No files to convert" << std::endl;
+            exit(1);
+        }
+        exit(convert_batch(jobs, flags, n_threads));
+    }
+
     // we need input and output mesh
     if (!input || !output)
     {
@@ -62,8 +195,6 @@ int main(int argc, char** argv)
     }
 
     // write output mesh
-    IOFlags flags;
-    flags.use_binary = binary;
     try
     {
         mesh.write(output, flags);
@@ -0,0 +1,440 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include <pmp/MemoryScope.h>
+#include <pmp/Parallel.h>
+#include <pmp/SurfaceMesh.h>
+#include <pmp/algorithms/SurfaceFairing.h>
+#include <pmp/algorithms/SurfaceFeatures.h>
+#include <pmp/algorithms/SurfaceHoleFilling.h>
+#include <pmp/algorithms/SurfaceParameterization.h>
+#include <pmp/algorithms/SurfaceQuality.h>
+#include <pmp/algorithms/SurfaceRemeshing.h>
+#include <pmp/algorithms/SurfaceSimplification.h>
+#include <pmp/algorithms/SurfaceSmoothing.h>
+#include <pmp/algorithms/SurfaceSubdivision.h>
+#include <pmp/algorithms/SurfaceTriangulation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BatchJobs.h"
+
+using namespace pmp;
+
+// an operation of the pipeline, run with the argument after its name
+struct Operation
+{
+    const char* name;
+    const char* help;
+    std::function<void(SurfaceMesh&, const std::string&)> run;
+};
+
+// an operation and its argument
+struct Stage
+{
+    const Operation* operation;
+    std::string argument;
+};
+
+// the numeric argument of an operation, or value if there is none
+Scalar number(const std::string& argument, Scalar value)
+{
+    if (argument.empty())
+        return value;
+    char* end;
+    value = Scalar(strtod(argument.c_str(), &end));
+    if (*end)
+        throw InvalidInputException("Invalid number: " + argument);
+    return value;
+}
+
+Scalar mean_edge_length(const SurfaceMesh& mesh)
+{
+    Scalar length(0);
+    for (auto e : mesh.edges())
+        length += mesh.edge_length(e);
+    return mesh.n_edges() ? length / Scalar(mesh.n_edges()) : 0;
+}
+
+const std::vector<Operation> operations = {
+    {"holefill", "fill all holes",
+     [](SurfaceMesh& mesh, const std::string&) {
+         SurfaceHoleFilling(mesh).fill_all_holes();
+     }},
+    {"triangulate", "triangulate all polygons",
+     [](SurfaceMesh& mesh, const std::string&) {
+         SurfaceTriangulation(mesh).triangulate();
+     }},
+    {"features[:<angle>]", "mark feature edges, default: 60 degrees",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceFeatures sf(mesh);
+         sf.clear();
+         sf.detect_angle(number(argument, 60));
+     }},
+    {"remesh[:<factor>]",
+     "uniform remeshing to <factor> times the mean edge length, default: 1",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         const Scalar length = number(argument, 1) * mean_edge_length(mesh);
+         SurfaceRemeshing(mesh).uniform_remeshing(length);
+     }},
+    {"adaptive[:<error>]",
+     "adaptive remeshing to an error relative to the bounding box, "
+     "default: 0.0005",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         const Scalar size = mesh.bounds().size();
+         SurfaceRemeshing(mesh).adaptive_remeshing(
+             0.001 * size, 0.05 * size, number(argument, 0.0005) * size);
+     }},
+    {"decimate:<target>",
+     "simplify to <target> vertices, or to that fraction if below 1",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         const Scalar target = number(argument, 0);
+         if (target <= 0)
+             throw InvalidInputException("decimate: Missing target.");
+         const unsigned int n_vertices =
+             target < 1 ? unsigned(target * mesh.n_vertices())
+                        : unsigned(target);
+         SurfaceSimplification ss(mesh);
+         ss.initialize(5.0);
+         ss.simplify(n_vertices);
+     }},
+    {"smooth[:<iterations>]", "explicit smoothing, default: 10 iterations",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceSmoothing(mesh).explicit_smoothing(
+             unsigned(number(argument, 10)));
+     }},
+    {"implicit[:<timestep>]", "implicit smoothing, default: 0.001",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceSmoothing(mesh).implicit_smoothing(number(argument, 0.001));
+     }},
+    {"fair[:<k>]", "minimize the k-th order energy, default: 2 (curvature)",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceFairing(mesh).fair(unsigned(number(argument, 2)));
+     }},
+    {"subdiv[:loop|catmull|sqrt3]", "one subdivision step, default: loop",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceSubdivision subdivision(mesh);
+         if (argument.empty() || argument == "loop")
+             subdivision.loop();
+         else if (argument == "catmull")
+             subdivision.catmull_clark();
+         else if (argument == "sqrt3")
+             subdivision.sqrt3();
+         else
+             throw InvalidInputException("Unknown subdivision: " + argument);
+     }},
+    {"param[:harmonic|lscm]", "parameterization, default: harmonic",
+     [](SurfaceMesh& mesh, const std::string& argument) {
+         SurfaceParameterization param(mesh);
+         if (argument.empty() || argument == "harmonic")
+             param.harmonic();
+         else if (argument == "lscm")
+             param.lscm();
+         else
+             throw InvalidInputException("Unknown parameterization: " +
+                                         argument);
+     }},
+    {"quality", "print aspect ratios, angles, edge lengths, and valences",
+     [](SurfaceMesh& mesh, const std::string&) {
+         const auto r = SurfaceQuality::analyze(mesh);
+         std::string valences;
+         for (size_t i = 0; i < r.valences.size(); ++i)
+             if (r.valences[i])
+                 valences += " " + std::to_string(i) + ":" +
+                             std::to_string(r.valences[i]);
+
+         // one call, such that lines of concurrent jobs are not mixed
+         printf("quality: %zu faces, aspect ratio %.3g/%.3g/%.3g "
+                "(min/mean/max), angles %.3g..%.3g, edge length "
+                "%.3g/%.3g/%.3g, %zu slivers, %zu degenerate, valences%s\n",
+                r.n_faces, double(r.aspect_ratio.min),
+                double(r.aspect_ratio.mean), double(r.aspect_ratio.max),
+                double(r.angle.min), double(r.angle.max),
+                double(r.edge_length.min), double(r.edge_length.mean),
+                double(r.edge_length.max), r.n_slivers, r.n_degenerate,
+                valences.c_str());
+     }},
+};
+
+void usage_and_exit()
+{
+    std::cerr << "Usage:\nmpipeline [-b] [-q] -i <input> [-o <output>] "
+                 "<operation>...\n"
+              << "mpipeline [-b] [-q] [-j <threads>] -m <manifest> | "
+                 "-g <pattern> -f <format> [-d <directory>] <operation>...\n"
+              << "\nReads each input, applies the operations in the given "
+                 "order, and writes the result.\n\nOptions\n"
+              << " -b:  write binary format\n"
+              << " -q:  do not print the time and memory of each stage\n"
+              << " -m:  process the files listed in <manifest>, one "
+                 "'<input> [<output>]' per line\n"
+              << " -g:  process the files matching <pattern>, e.g. "
+                 "'meshes/*.obj'\n"
+              << " -f:  output format of files without output name, e.g. ply\n"
+              << " -d:  output directory of files without output name\n"
+              << " -j:  number of files processed in parallel, default: all "
+                 "cores\n\nOperations\n";
+    for (const auto& op : operations)
+        fprintf(stderr, " %-28s %s\n", op.name, op.help);
+    std::cerr << "\nExample:\nmpipeline -i in.obj -o out.ply holefill remesh "
+                 "decimate:0.1\n\n";
+    exit(1);
+}
+
+// the stage of "<name>[:<argument>]"
+Stage parse_stage(const std::string& text)
+{
+    const auto colon = text.find(':');
+    const std::string name = text.substr(0, colon);
+    for (const auto& op : operations)
+    {
+        const std::string op_name(op.name);
+        if (op_name.compare(0, op_name.find_first_of("[:"), name) == 0)
+            return Stage{&op, colon == std::string::npos
+                                  ? ""
+                                  : text.substr(colon + 1)};
+    }
+    std::cerr << "Unknown operation: " << text << "\n\n";
+    usage_and_exit();
+    return Stage();
+}
+
+// milliseconds since start
+double milliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// the label of the stages, and of reading and writing the mesh
+std::vector<std::string> stage_labels(const std::vector<Stage>& stages)
+{
+    std::vector<std::string> labels{"read"};
+    for (const auto& stage : stages)
+    {
+        std::string label(stage.operation->name);
+        label = label.substr(0, label.find_first_of("[:"));
+        if (!stage.argument.empty())
+            label += ":" + stage.argument;
+        labels.push_back(label);
+    }
+    labels.push_back("write");
+    return labels;
+}
+
+// read job.input, run the stages, and write job.output if not empty. Adds
+// the time of each stage, reading and writing included, to times. Returns
+// an empty string on success, otherwise the error.
+std::string process(const Job& job, const std::vector<Stage>& stages,
+                    const IOFlags& flags, SurfaceMesh& mesh,
+                    std::vector<double>& times, std::string& log)
+{
+    const auto labels = stage_labels(stages);
+    char line[256];
+    size_t i = 0;
+    try
+    {
+        for (; i < labels.size(); ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            MemoryScope memory;
+            if (i == 0)
+                mesh.read(job.input);
+            else if (i <= stages.size())
+                stages[i - 1].operation->run(mesh, stages[i - 1].argument);
+            else if (!job.output.empty())
+                mesh.write(job.output, flags);
+            else
+                continue;
+            times[i] = milliseconds(start);
+
+            snprintf(line, sizeof(line),
+                     "  %-24s %10.2f ms %8.1f MB %10lu vertices %10lu faces\n",
+                     labels[i].c_str(), times[i],
+                     memory.peak_extra() / 1048576.0,
+                     (unsigned long)mesh.n_vertices(),
+                     (unsigned long)mesh.n_faces());
+            log += line;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        return labels[i] + ": " + e.what();
+    }
+    return "";
+}
+
+// process the jobs on a pool of threads, each reusing its mesh
+int process_batch(const std::vector<Job>& jobs,
+                  const std::vector<Stage>& stages, const IOFlags& flags,
+                  unsigned int n_threads, bool verbose)
+{
+    const auto labels = stage_labels(stages);
+    std::vector<double> total(labels.size(), 0.0);
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> n_failed(0);
+    std::mutex output_mutex;
+
+    auto worker = [&]() {
+        SurfaceMesh mesh;
+        std::vector<double> times(labels.size());
+        for (size_t i = next++; i < jobs.size(); i = next++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            std::fill(times.begin(), times.end(), 0.0);
+            std::string log;
+            const auto error =
+                process(jobs[i], stages, flags, mesh, times, log);
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (!error.empty())
+            {
+                ++n_failed;
+                std::cerr << "Failed to process " << jobs[i].input << ": "
+                          << error << std::endl;
+                continue;
+            }
+            for (size_t j = 0; j < times.size(); ++j)
+                total[j] += times[j];
+            if (verbose)
+                std::cout << jobs[i].input << ": " << milliseconds(start)
+                          << " ms\n"
+                          << log << std::flush;
+        }
+    };
+
+    // the files are processed in parallel, the algorithms sequentially
+    const auto start = std::chrono::steady_clock::now();
+    n_threads = std::max(1u, std::min(n_threads, unsigned(jobs.size())));
+    if (n_threads > 1)
+        Parallel::set_n_threads(1);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < n_threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+    const double elapsed = milliseconds(start);
+
+    // the time of each stage summed over all files
+    const size_t n_processed = jobs.size() - n_failed;
+    if (jobs.size() > 1)
+    {
+        std::cout << "Processed " << n_processed << " of " << jobs.size()
+                  << " files in " << elapsed << " ms (" << n_threads
+                  << " threads)\n";
+        char line[256];
+        for (size_t i = 0; i < labels.size(); ++i)
+        {
+            snprintf(line, sizeof(line), "  %-24s %10.2f ms total\n",
+                     labels[i].c_str(), total[i]);
+            std::cout << line;
+        }
+        std::cout << std::flush;
+    }
+
+    return n_failed ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    bool binary = false;
+    bool verbose = true;
+    const char* input = nullptr;
+    const char* output = nullptr;
+    const char* manifest = nullptr;
+    const char* pattern = nullptr;
+    std::string format;
+    std::string directory;
+    unsigned int n_threads = std::thread::hardware_concurrency();
+
+    // parse command line parameters
+    int c;
+    while ((c = getopt(argc, argv, "bqi:o:m:g:f:d:j:")) != -1)
+    {
+        switch (c)
+        {
+            case 'b':
+                binary = true;
+                break;
+
+            case 'q':
+                verbose = false;
+                break;
+
+            case 'i':
+                input = optarg;
+                break;
+
+            case 'o':
+                output = optarg;
+                break;
+
+            case 'm':
+                manifest = optarg;
+                break;
+
+            case 'g':
+                pattern = optarg;
+                break;
+
+            case 'f':
+                format = optarg;
+                break;
+
+            case 'd':
+                directory = optarg;
+                break;
+
+            case 'j':
+                n_threads = unsigned(std::max(1, atoi(optarg)));
+                break;
+
+            default:
+                usage_and_exit();
+        }
+    }
+
+    // the remaining arguments are the operations
+    std::vector<Stage> stages;
+    for (int i = optind; i < argc; ++i)
+        stages.push_back(parse_stage(argv[i]));
+
+    IOFlags flags;
+    flags.use_binary = binary;
+
+    std::vector<Job> jobs;
+    if (manifest || pattern)
+    {
+        if ((manifest && pattern) || (pattern && format.empty()))
+            usage_and_exit();
+        jobs = manifest ? read_manifest(manifest, format, directory)
+                        : glob_files(pattern, format, directory);
+        if (jobs.empty())
+        {
+            std::cerr << "No files to process" << std::endl;
+            exit(1);
+        }
+    }
+    else if (input)
+    {
+        jobs.push_back(Job{input, output ? output : ""});
+    }
+    else
+    {
+        usage_and_exit();
+    }
+
+    exit(process_batch(jobs, stages, flags, n_threads, verbose));
+}
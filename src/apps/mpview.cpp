@@ -6,9 +6,10 @@
 int main(int argc, char **argv)
 {
     MeshProcessingViewer window("MeshProcessingViewer", 800, 600);
+    window.set_render_on_demand(true);
 
     if (argc == 2)
-        window.load_mesh(argv[1]);
+        window.load_mesh_async(argv[1]);
 #ifdef __EMSCRIPTEN__
     else
         window.load_mesh("input.off");
@@ -0,0 +1,111 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include <pmp/Timer.h>
+#include <pmp/visualization/OffscreenRenderer.h>
+
+#include <algorithm>
+#include <string>
+
+#include <unistd.h>
+
+using namespace pmp;
+
+void usage_and_exit()
+{
+    std::cerr << "Usage:\nmthumb [-s <size>] [-m <draw mode>] "
+                 "[-d <directory>] <input>...\n\nOptions\n"
+              << " -s:  width and height of the images, default: 256\n"
+              << " -m:  draw mode, e.g. 'Hidden Line', default: "
+                 "'Smooth Shading'\n"
+              << " -d:  output directory, default: the input directory\n"
+              << "\nWrites the images <name>-<view>.png of the front, back, "
+                 "left, right, top,\nand an oblique view of each input.\n"
+              << "\n";
+    exit(1);
+}
+
+// the input filename without extension, in directory if not empty
+std::string basename(const std::string& filename, const std::string& directory)
+{
+    std::string name = filename.substr(0, filename.find_last_of('.'));
+    if (directory.empty())
+        return name;
+    const auto slash = name.find_last_of('/');
+    if (slash != std::string::npos)
+        name = name.substr(slash + 1);
+    return directory + "/" + name;
+}
+
+int main(int argc, char** argv)
+{
+    int size = 256;
+    std::string draw_mode = "Smooth Shading";
+    std::string directory;
+
+    // parse command line parameters
+    int c;
+    while ((c = getopt(argc, argv, "s:m:d:")) != -1)
+    {
+        switch (c)
+        {
+            case 's':
+                size = std::max(1, atoi(optarg));
+                break;
+
+            case 'm':
+                draw_mode = optarg;
+                break;
+
+            case 'd':
+                directory = optarg;
+                break;
+
+            default:
+                usage_and_exit();
+        }
+    }
+    if (optind == argc)
+        usage_and_exit();
+
+    int n_failed = 0;
+    Timer timer;
+    timer.start();
+    try
+    {
+        OffscreenRenderer renderer(size, size);
+        const auto views = OffscreenRenderer::default_views();
+
+        // the buffers of the mesh are reused for each input
+        SurfaceMeshGL mesh;
+        for (int i = optind; i < argc; ++i)
+        {
+            try
+            {
+                mesh.read(argv[i]);
+            }
+            catch (const IOException& e)
+            {
+                std::cerr << "Failed to read " << argv[i] << ": " << e.what()
+                          << std::endl;
+                ++n_failed;
+                continue;
+            }
+            mesh.update_opengl_buffers();
+            renderer.render(mesh, views, basename(argv[i], directory),
+                            draw_mode);
+        }
+        renderer.finish();
+
+        timer.stop();
+        std::cout << "Wrote " << renderer.n_written() << " images in "
+                  << timer << std::endl;
+    }
+    catch (const IOException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return n_failed ? 1 : 0;
+}
@@ -63,7 +63,9 @@ int main(int argc, char** argv)
 
     // open window, start application
     MeshViewer viewer("MeshViewer", 800, 600, gui);
-    viewer.load_mesh(input);
+    viewer.set_view_only(true);
+    viewer.set_render_on_demand(true);
+    viewer.load_mesh_async(input);
     if (texture)
     {
         viewer.load_texture(texture, GL_SRGB8);
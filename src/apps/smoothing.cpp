@@ -4,8 +4,13 @@
 #include <pmp/visualization/MeshViewer.h>
 #include <pmp/algorithms/SurfaceCurvature.h>
 #include <pmp/algorithms/SurfaceSmoothing.h>
+#ifndef __EMSCRIPTEN__
+#include <pmp/visualization/SurfaceSmoothingGL.h>
+#endif
 #include <imgui.h>
 
+#include <memory>
+
 using namespace pmp;
 
 class Viewer : public MeshViewer
@@ -15,9 +20,17 @@ public:
 
 protected:
     virtual void process_imgui();
+#ifndef __EMSCRIPTEN__
+    virtual void update_mesh();
+#endif
 
 private:
     SurfaceSmoothing smoother_;
+#ifndef __EMSCRIPTEN__
+    // smoothing on the GPU, for the mesh and buffers it was created for
+    std::unique_ptr<SurfaceSmoothingGL> gpu_smoother_;
+    bool use_gpu_ = false;
+#endif
 };
 
 Viewer::Viewer(const char* title, int width, int height)
@@ -26,6 +39,15 @@ Viewer::Viewer(const char* title, int width, int height)
     crease_angle_ = 180.0;
 }
 
+#ifndef __EMSCRIPTEN__
+void Viewer::update_mesh()
+{
+    // the mesh may have changed on the CPU, e.g., a new one was loaded
+    gpu_smoother_.reset();
+    MeshViewer::update_mesh();
+}
+#endif
+
 void Viewer::process_imgui()
 {
     MeshViewer::process_imgui();
@@ -61,8 +83,31 @@ void Viewer::process_imgui()
         ImGui::SliderInt("Iterations", &iterations, 1, 100);
         ImGui::PopItemWidth();
 
+#ifndef __EMSCRIPTEN__
+        ImGui::Checkbox("On GPU", &use_gpu_);
+#endif
+
         if (ImGui::Button("Explicit Smoothing"))
         {
+#ifndef __EMSCRIPTEN__
+            if (use_gpu_)
+            {
+                // the vertex buffers are updated on the GPU
+                try
+                {
+                    if (!gpu_smoother_)
+                        gpu_smoother_.reset(new SurfaceSmoothingGL(mesh_));
+                    gpu_smoother_->explicit_smoothing(iterations,
+                                                      uniform_laplace);
+                    gpu_smoother_->download();
+                }
+                catch (const InvalidInputException& e)
+                {
+                    std::cerr << e.what() << std::endl;
+                }
+                return;
+            }
+#endif
             smoother_.explicit_smoothing(iterations, uniform_laplace);
             update_mesh();
         }
@@ -0,0 +1,11 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/BitVector.h"
+
+namespace pmp {
+
+const size_t BitVector::word_bits;
+const size_t BitVector::npos;
+
+} // namespace pmp
@@ -0,0 +1,362 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace pmp {
+
+//! \brief Packed array of bits with word-parallel bulk operations.
+//! \details Stores 64 bits per word and provides the part of the interface
+//! of std::vector<bool> used by PropertyArray, where it stores the elements
+//! of bool properties. Unlike std::vector<bool>, distinct bits can be written
+//! from multiple threads, since single bits are set by atomic operations on
+//! their word. The bulk operations such as count() or operator|=() process
+//! whole words and must not run concurrently with writes.
+//! \ingroup core
+class BitVector
+{
+public:
+    //! storage unit of the bits
+    typedef uint64_t Word;
+
+    //! number of bits per word
+    static const size_t word_bits = 64;
+
+    //! returned by find_first() and find_next() if there is no set bit
+    static const size_t npos = size_t(-1);
+
+    //! reference to a single bit
+    class reference
+    {
+    public:
+        reference(std::atomic<Word>* word, Word mask)
+            : word_(word), mask_(mask)
+        {
+        }
+
+        //! read the bit
+        operator bool() const
+        {
+            return (word_->load(std::memory_order_relaxed) & mask_) != 0;
+        }
+
+        //! set the bit to \p b
+        reference& operator=(bool b)
+        {
+            if (b)
+                word_->fetch_or(mask_, std::memory_order_relaxed);
+            else
+                word_->fetch_and(~mask_, std::memory_order_relaxed);
+            return *this;
+        }
+
+        //! set the bit to the value of \p rhs
+        reference& operator=(const reference& rhs)
+        {
+            return operator=(bool(rhs));
+        }
+
+        //! invert the bit
+        void flip() { word_->fetch_xor(mask_, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<Word>* word_;
+        Word mask_;
+    };
+
+    //! value of a single bit
+    typedef bool const_reference;
+
+    //! construct with \p n bits of value \p value
+    explicit BitVector(size_t n = 0, bool value = false)
+        : size_(0), capacity_(0)
+    {
+        resize(n, value);
+    }
+
+    //! copy constructor
+    BitVector(const BitVector& rhs) : size_(0), capacity_(0)
+    {
+        operator=(rhs);
+    }
+
+    //! assignment
+    BitVector& operator=(const BitVector& rhs)
+    {
+        if (this != &rhs)
+        {
+            const size_t n = n_words(rhs.size_);
+            if (n > capacity_)
+                allocate(n);
+            for (size_t i = 0; i < n; ++i)
+                store(i, rhs.word(i));
+            size_ = rhs.size_;
+        }
+        return *this;
+    }
+
+    //! move constructor
+    BitVector(BitVector&& rhs) noexcept : size_(0), capacity_(0)
+    {
+        swap(rhs);
+    }
+
+    //! move assignment
+    BitVector& operator=(BitVector&& rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    //! number of bits
+    size_t size() const { return size_; }
+
+    //! are there no bits?
+    bool empty() const { return size_ == 0; }
+
+    //! number of bits that fit into the allocated words
+    size_t capacity() const { return capacity_ * word_bits; }
+
+    //! allocate words for at least \p n bits
+    void reserve(size_t n)
+    {
+        if (n_words(n) > capacity_)
+            allocate(n_words(n));
+    }
+
+    //! \brief Change the number of bits to \p n.
+    //! \details Added bits get the value \p value.
+    void resize(size_t n, bool value = false)
+    {
+        if (n_words(n) > capacity_)
+            allocate(std::max(n_words(n), 2 * capacity_));
+
+        if (n > size_)
+        {
+            // the bits after the old size are zero
+            const size_t last = size_ / word_bits;
+            if (value && size_ % word_bits)
+                store(last, word(last) | (~Word(0) << (size_ % word_bits)));
+            for (size_t i = n_words(size_); i < n_words(n); ++i)
+                store(i, value ? ~Word(0) : 0);
+        }
+        size_ = n;
+        clear_tail();
+    }
+
+    //! remove all bits
+    void clear() { size_ = 0; }
+
+    //! append a bit of value \p value
+    void push_back(bool value) { resize(size_ + 1, value); }
+
+    //! exchange the bits with \p rhs
+    void swap(BitVector& rhs) noexcept
+    {
+        words_.swap(rhs.words_);
+        std::swap(size_, rhs.size_);
+        std::swap(capacity_, rhs.capacity_);
+    }
+
+    //! access bit \p i
+    reference operator[](size_t i)
+    {
+        assert(i < size_);
+        return reference(&words_[i / word_bits], Word(1) << (i % word_bits));
+    }
+
+    //! read bit \p i
+    bool operator[](size_t i) const
+    {
+        assert(i < size_);
+        return (word(i / word_bits) >> (i % word_bits)) & 1;
+    }
+
+    //! \name Word-parallel operations
+    //!@{
+
+    //! set all bits to \p value
+    void fill(bool value)
+    {
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, value ? ~Word(0) : 0);
+        clear_tail();
+    }
+
+    //! invert all bits
+    void flip()
+    {
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, ~word(i));
+        clear_tail();
+    }
+
+    //! number of set bits
+    size_t count() const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < n_words(size_); ++i)
+            n += popcount(word(i));
+        return n;
+    }
+
+    //! is any bit set?
+    bool any() const
+    {
+        for (size_t i = 0; i < n_words(size_); ++i)
+            if (word(i))
+                return true;
+        return false;
+    }
+
+    //! is no bit set?
+    bool none() const { return !any(); }
+
+    //! index of the first set bit, npos if there is none
+    size_t find_first() const { return find_from(0); }
+
+    //! index of the first set bit after bit \p i, npos if there is none
+    size_t find_next(size_t i) const { return find_from(i + 1); }
+
+    //! keep the bits that are also set in \p rhs, which has the same size
+    BitVector& operator&=(const BitVector& rhs)
+    {
+        assert(rhs.size_ == size_);
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, word(i) & rhs.word(i));
+        return *this;
+    }
+
+    //! set the bits that are set in \p rhs, which has the same size
+    BitVector& operator|=(const BitVector& rhs)
+    {
+        assert(rhs.size_ == size_);
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, word(i) | rhs.word(i));
+        return *this;
+    }
+
+    //! invert the bits that are set in \p rhs, which has the same size
+    BitVector& operator^=(const BitVector& rhs)
+    {
+        assert(rhs.size_ == size_);
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, word(i) ^ rhs.word(i));
+        return *this;
+    }
+
+    //! clear the bits that are set in \p rhs, which has the same size
+    BitVector& and_not(const BitVector& rhs)
+    {
+        assert(rhs.size_ == size_);
+        for (size_t i = 0; i < n_words(size_); ++i)
+            store(i, word(i) & ~rhs.word(i));
+        return *this;
+    }
+
+    //! do both vectors have the same bits?
+    bool operator==(const BitVector& rhs) const
+    {
+        if (size_ != rhs.size_)
+            return false;
+        for (size_t i = 0; i < n_words(size_); ++i)
+            if (word(i) != rhs.word(i))
+                return false;
+        return true;
+    }
+
+    //! do the vectors differ?
+    bool operator!=(const BitVector& rhs) const { return !operator==(rhs); }
+
+    //! \brief Word \p i holding the bits 64i to 64i+63.
+    //! \details The bits after size() are zero.
+    Word word(size_t i) const
+    {
+        return words_[i].load(std::memory_order_relaxed);
+    }
+
+    //! number of words holding the bits
+    size_t n_words() const { return n_words(size_); }
+
+    //!@}
+
+private:
+    static size_t n_words(size_t n) { return (n + word_bits - 1) / word_bits; }
+
+    static size_t popcount(Word w)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return size_t(__builtin_popcountll(w));
+#else
+        w = w - ((w >> 1) & 0x5555555555555555ULL);
+        w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+        w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return size_t((w * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    static size_t lowest_bit(Word w)
+    {
+        assert(w != 0);
+#if defined(__GNUC__) || defined(__clang__)
+        return size_t(__builtin_ctzll(w));
+#else
+        return popcount((w & (~w + 1)) - 1);
+#endif
+    }
+
+    void store(size_t i, Word w)
+    {
+        words_[i].store(w, std::memory_order_relaxed);
+    }
+
+    // zero the bits after the size in the last word
+    void clear_tail()
+    {
+        if (size_ % word_bits)
+        {
+            const size_t i = size_ / word_bits;
+            store(i, word(i) & ~(~Word(0) << (size_ % word_bits)));
+        }
+    }
+
+    // index of the first set bit not before bit i
+    size_t find_from(size_t i) const
+    {
+        if (i >= size_)
+            return npos;
+        size_t w = i / word_bits;
+        Word bits = word(w) & (~Word(0) << (i % word_bits));
+        while (!bits)
+        {
+            if (++w == n_words(size_))
+                return npos;
+            bits = word(w);
+        }
+        return w * word_bits + lowest_bit(bits);
+    }
+
+    // grow the storage to n words, keeping the current bits
+    void allocate(size_t n)
+    {
+        std::unique_ptr<std::atomic<Word>[]> words(new std::atomic<Word>[n]);
+        for (size_t i = 0; i < n_words(size_); ++i)
+            words[i].store(word(i), std::memory_order_relaxed);
+        words_.swap(words);
+        capacity_ = n;
+    }
+
+    std::unique_ptr<std::atomic<Word>[]> words_;
+    size_t size_;
+    size_t capacity_; // allocated words
+};
+
+} // namespace pmp
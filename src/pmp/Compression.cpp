@@ -0,0 +1,376 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/Compression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#if defined(PMP_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(PMP_HAS_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace pmp {
+
+namespace {
+
+// size of the chunks passed to the compression libraries
+const size_t chunk_size = size_t(1) << 20;
+
+#if defined(PMP_HAS_ZLIB) || defined(PMP_HAS_ZSTD)
+// make room for at least one more chunk of output
+void grow(std::vector<char>& buffer, size_t used)
+{
+    if (buffer.size() - used < chunk_size)
+        buffer.resize(std::max(used + chunk_size, buffer.size() * 2));
+}
+#endif
+
+// receives the compressed data chunk by chunk
+typedef std::function<void(const char*, size_t)> Sink;
+
+void write_chunk(const char* data, size_t size, FILE* out)
+{
+    if (size && fwrite(data, 1, size, out) != size)
+        throw IOException("Failed to write compressed data");
+}
+
+#if defined(PMP_HAS_ZLIB)
+
+// ends the stream when leaving the scope
+struct ZStream
+{
+    ZStream(bool inflating) : inflating(inflating), initialized(false)
+    {
+        memset(&stream, 0, sizeof(stream));
+    }
+
+    ~ZStream()
+    {
+        if (initialized)
+            inflating ? inflateEnd(&stream) : deflateEnd(&stream);
+    }
+
+    z_stream stream;
+    bool inflating;
+    bool initialized;
+};
+
+std::vector<char> gzip_decompress(const char* data, size_t size)
+{
+    const size_t max_input = size_t(1) << 30; // avail_in is 32 bit
+
+    std::vector<char> result;
+
+    // the last four bytes store the uncompressed size modulo 2^32
+    if (size >= 18)
+    {
+        auto b = reinterpret_cast<const unsigned char*>(data + size - 4);
+        result.reserve(size_t(b[0]) | size_t(b[1]) << 8 | size_t(b[2]) << 16 |
+                       size_t(b[3]) << 24);
+    }
+
+    ZStream z(true);
+    z_stream& zs = z.stream;
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) // 32: detect gzip header
+        throw IOException("Failed to initialize gzip decompression");
+    z.initialized = true;
+
+    size_t consumed = 0;
+    size_t n_out = 0;
+    while (true)
+    {
+        if (zs.avail_in == 0 && consumed < size)
+        {
+            auto n = std::min(size - consumed, max_input);
+            zs.next_in = (Bytef*)(data + consumed);
+            zs.avail_in = uInt(n);
+            consumed += n;
+        }
+
+        grow(result, n_out);
+        auto n_avail = uInt(std::min(result.size() - n_out, max_input));
+        zs.next_out = (Bytef*)(result.data() + n_out);
+        zs.avail_out = n_avail;
+
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        n_out += n_avail - zs.avail_out;
+
+        if (ret == Z_STREAM_END)
+        {
+            if (zs.avail_in == 0 && consumed == size)
+                break;
+
+            // continue with the next gzip member
+            if (inflateReset(&zs) != Z_OK)
+                throw IOException("Corrupt gzip data");
+        }
+        else if (ret == Z_BUF_ERROR && zs.avail_in == 0 && consumed == size)
+        {
+            throw IOException("Truncated gzip data");
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            throw IOException("Corrupt gzip data");
+        }
+    }
+
+    result.resize(n_out);
+    return result;
+}
+
+void gzip_compress(const char* data, size_t size, const Sink& out,
+                    int level)
+{
+    const size_t max_input = size_t(1) << 30;
+
+    ZStream z(false);
+    z_stream& zs = z.stream;
+    if (deflateInit2(&zs, level ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) // 16: gzip
+        throw IOException("Failed to initialize gzip compression");
+    z.initialized = true;
+
+    std::vector<char> buffer(chunk_size);
+    size_t consumed = 0;
+    int ret;
+    do
+    {
+        if (zs.avail_in == 0 && consumed < size)
+        {
+            auto n = std::min(size - consumed, max_input);
+            zs.next_in = (Bytef*)(data + consumed);
+            zs.avail_in = uInt(n);
+            consumed += n;
+        }
+        const int flush =
+            (zs.avail_in == 0 && consumed == size) ? Z_FINISH : Z_NO_FLUSH;
+
+        zs.next_out = (Bytef*)buffer.data();
+        zs.avail_out = uInt(buffer.size());
+        ret = deflate(&zs, flush);
+        if (ret == Z_STREAM_ERROR)
+            throw IOException("Failed to compress gzip data");
+        out(buffer.data(), buffer.size() - zs.avail_out);
+    } while (ret != Z_STREAM_END);
+}
+
+#endif
+
+#if defined(PMP_HAS_ZSTD)
+
+std::string zstd_error(const char* what, size_t code)
+{
+    return std::string(what) + ": " + ZSTD_getErrorName(code);
+}
+
+std::vector<char> zstd_decompress(const char* data, size_t size)
+{
+    std::vector<char> result;
+    auto content_size = ZSTD_getFrameContentSize(data, size);
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+        content_size != ZSTD_CONTENTSIZE_ERROR)
+        result.reserve(size_t(content_size));
+
+    std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(),
+                                                            ZSTD_freeDCtx);
+    if (!dctx)
+        throw IOException("Failed to initialize zstd decompression");
+
+    ZSTD_inBuffer in = {data, size, 0};
+    size_t n_out = 0;
+    size_t ret = 0;
+    while (in.pos < in.size)
+    {
+        grow(result, n_out);
+        ZSTD_outBuffer o = {result.data() + n_out, result.size() - n_out, 0};
+        ret = ZSTD_decompressStream(dctx.get(), &o, &in);
+        if (ZSTD_isError(ret))
+            throw IOException(zstd_error("Corrupt zstd data", ret));
+        n_out += o.pos;
+    }
+
+    // flush data buffered by the decoder
+    while (ret != 0)
+    {
+        grow(result, n_out);
+        ZSTD_outBuffer o = {result.data() + n_out, result.size() - n_out, 0};
+        ret = ZSTD_decompressStream(dctx.get(), &o, &in);
+        if (ZSTD_isError(ret))
+            throw IOException(zstd_error("Corrupt zstd data", ret));
+        if (ret != 0 && o.pos == 0)
+            throw IOException("Truncated zstd data");
+        n_out += o.pos;
+    }
+
+    result.resize(n_out);
+    return result;
+}
+
+void zstd_compress(const char* data, size_t size, const Sink& out,
+                    int level)
+{
+    std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(),
+                                                            ZSTD_freeCCtx);
+    if (!cctx)
+        throw IOException("Failed to initialize zstd compression");
+
+    ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel,
+                           level ? level : ZSTD_CLEVEL_DEFAULT);
+
+    // has no effect if libzstd is built without thread support
+    ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_nbWorkers,
+                           int(std::thread::hardware_concurrency()));
+    ZSTD_CCtx_setPledgedSrcSize(cctx.get(), size);
+
+    std::vector<char> buffer(chunk_size);
+    ZSTD_inBuffer in = {data, size, 0};
+    size_t remaining;
+    do
+    {
+        ZSTD_outBuffer o = {buffer.data(), buffer.size(), 0};
+        remaining = ZSTD_compressStream2(cctx.get(), &o, &in, ZSTD_e_end);
+        if (ZSTD_isError(remaining))
+            throw IOException(
+                zstd_error("Failed to compress zstd data", remaining));
+        out(buffer.data(), o.pos);
+    } while (remaining != 0);
+}
+
+#endif
+
+std::string unsupported(Compression compression)
+{
+    return std::string("Library built without ") +
+           (compression == Compression::Gzip ? "zlib" : "zstd") +
+           " support";
+}
+
+} // namespace
+
+Compression detect_compression(const char* data, size_t size)
+{
+    auto b = reinterpret_cast<const unsigned char*>(data);
+    if (size >= 2 && b[0] == 0x1f && b[1] == 0x8b)
+        return Compression::Gzip;
+    if (size >= 4 && b[0] == 0x28 && b[1] == 0xb5 && b[2] == 0x2f &&
+        b[3] == 0xfd)
+        return Compression::Zstd;
+    return Compression::None;
+}
+
+Compression compression_from_extension(const std::string& filename)
+{
+    auto dot = filename.rfind('.');
+    if (dot == std::string::npos)
+        return Compression::None;
+    std::string ext = filename.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+    if (ext == "gz")
+        return Compression::Gzip;
+    if (ext == "zst")
+        return Compression::Zstd;
+    return Compression::None;
+}
+
+bool is_compression_supported(Compression compression)
+{
+    switch (compression)
+    {
+        case Compression::Gzip:
+#if defined(PMP_HAS_ZLIB)
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#if defined(PMP_HAS_ZSTD)
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+std::vector<char> decompress(const char* data, size_t size,
+                             Compression compression)
+{
+    if (!is_compression_supported(compression))
+        throw IOException(unsupported(compression));
+
+    switch (compression)
+    {
+#if defined(PMP_HAS_ZLIB)
+        case Compression::Gzip:
+            return gzip_decompress(data, size);
+#endif
+#if defined(PMP_HAS_ZSTD)
+        case Compression::Zstd:
+            return zstd_decompress(data, size);
+#endif
+        default:
+            return std::vector<char>(data, data + size);
+    }
+}
+
+namespace {
+
+void compress(const char* data, size_t size, const Sink& out,
+              Compression compression, int level)
+{
+    if (!is_compression_supported(compression))
+        throw IOException(unsupported(compression));
+
+    switch (compression)
+    {
+#if defined(PMP_HAS_ZLIB)
+        case Compression::Gzip:
+            gzip_compress(data, size, out, level);
+            break;
+#endif
+#if defined(PMP_HAS_ZSTD)
+        case Compression::Zstd:
+            zstd_compress(data, size, out, level);
+            break;
+#endif
+        default:
+            out(data, size);
+    }
+}
+
+} // namespace
+
+void compress(const char* data, size_t size, FILE* out,
+              Compression compression, int level)
+{
+    compress(
+        data, size,
+        [out](const char* chunk, size_t n) { write_chunk(chunk, n, out); },
+        compression, level);
+}
+
+std::vector<char> compress(const char* data, size_t size,
+                           Compression compression, int level)
+{
+    std::vector<char> result;
+    compress(
+        data, size,
+        [&result](const char* chunk, size_t n) {
+            result.insert(result.end(), chunk, chunk + n);
+        },
+        compression, level);
+    return result;
+}
+
+} // namespace pmp
@@ -0,0 +1,54 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+//! \addtogroup core
+//!@{
+
+//! \brief Compression of \p data judging from its first bytes.
+//! \return Compression::None if \p data is not gzip or zstd compressed.
+Compression detect_compression(const char* data, size_t size);
+
+//! \brief Compression given by the extension of \p filename.
+//! \return Compression::Gzip for ".gz", Compression::Zstd for ".zst", and
+//! Compression::None otherwise.
+Compression compression_from_extension(const std::string& filename);
+
+//! whether the library was built with support for \p compression
+bool is_compression_supported(Compression compression);
+
+//! \brief Decompress \p size bytes of \p data.
+//! \details The data is decompressed in chunks into a growing buffer.
+//! Concatenated gzip members and zstd frames are decompressed one after the
+//! other.
+//! \throw IOException if the data is corrupt or \p compression is not
+//! supported.
+std::vector<char> decompress(const char* data, size_t size,
+                             Compression compression);
+
+//! \brief Compress \p size bytes of \p data and write the result to \p out.
+//! \details \p level 0 uses the default level of the compression library.
+//! Zstd compression uses all hardware threads if libzstd supports it.
+//! \throw IOException if writing fails or \p compression is not supported.
+void compress(const char* data, size_t size, FILE* out,
+              Compression compression, int level = 0);
+
+//! \brief Compress \p size bytes of \p data into memory.
+//! \details See compress(const char*, size_t, FILE*, Compression, int).
+//! \throw IOException if \p compression is not supported.
+std::vector<char> compress(const char* data, size_t size,
+                           Compression compression, int level = 0);
+
+//!@}
+
+} // namespace pmp
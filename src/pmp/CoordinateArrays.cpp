@@ -0,0 +1,107 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/CoordinateArrays.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+void CoordinateArrays::allocate(size_t n)
+{
+    const size_t lanes = alignment / sizeof(Scalar);
+    size_ = n;
+    padded_size_ = (n + lanes - 1) / lanes * lanes;
+
+    // over-allocate by one alignment unit to align the first array
+    data_.assign(3 * padded_size_ + lanes, Scalar(0));
+}
+
+CoordinateArrays& CoordinateArrays::operator=(const CoordinateArrays& rhs)
+{
+    if (this != &rhs)
+    {
+        allocate(rhs.size_);
+        std::copy(rhs.base(), rhs.base() + 3 * padded_size_, base());
+        deleted_ = rhs.deleted_;
+    }
+    return *this;
+}
+
+void CoordinateArrays::gather(const SurfaceMesh& mesh)
+{
+    allocate(mesh.vertices_size());
+    deleted_.assign(size_, 0);
+
+    Scalar* px = x();
+    Scalar* py = y();
+    Scalar* pz = z();
+
+    const int n = int(size_);
+    parallel_for(0, n, [&](int i) {
+        const Point& p = mesh.position(Vertex(i));
+        px[i] = p[0];
+        py[i] = p[1];
+        pz[i] = p[2];
+        deleted_[i] = mesh.is_deleted(Vertex(i));
+    });
+}
+
+void CoordinateArrays::scatter(SurfaceMesh& mesh) const
+{
+    if (mesh.vertices_size() != size_)
+    {
+        auto what = "CoordinateArrays::scatter: Number of vertices changed.";
+        throw InvalidInputException(what);
+    }
+
+    auto points = mesh.vertex_property<Point>("v:point");
+    const Scalar* px = x();
+    const Scalar* py = y();
+    const Scalar* pz = z();
+
+    const int n = int(size_);
+    parallel_for(0, n, [&](int i) {
+        points[Vertex(i)] = Point(px[i], py[i], pz[i]);
+    });
+}
+
+BoundingBox CoordinateArrays::bounds() const
+{
+    const Scalar* c[3] = {x(), y(), z()};
+    const int n = int(size_);
+    const Scalar inf = std::numeric_limits<Scalar>::max();
+
+    Point bmin, bmax;
+    bool empty = true;
+    for (int k = 0; k < 3; ++k)
+    {
+        // branch-free min/max over one array, deleted entries are skipped
+        // by mapping them to the neutral element
+        const Scalar* a = c[k];
+        Scalar lo = inf, hi = -inf;
+        for (int i = 0; i < n; ++i)
+        {
+            const Scalar v = a[i];
+            const bool skip = deleted_[i] != 0;
+            lo = std::min(lo, skip ? inf : v);
+            hi = std::max(hi, skip ? -inf : v);
+        }
+        bmin[k] = lo;
+        bmax[k] = hi;
+        empty = empty && lo > hi;
+    }
+
+    BoundingBox bb;
+    if (!empty)
+    {
+        bb += bmin;
+        bb += bmax;
+    }
+    return bb;
+}
+
+} // namespace pmp
@@ -0,0 +1,110 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+#include "pmp/BoundingBox.h"
+
+namespace pmp {
+
+//! \brief Struct-of-arrays copy of the vertex positions of a SurfaceMesh.
+//! \details Stores the x, y, and z coordinates in three separate arrays,
+//! each aligned to \c alignment bytes and zero-padded to a multiple of
+//! \c alignment bytes. This lets loops over coordinates use full SIMD
+//! registers without peeling or remainder handling. The arrays are indexed
+//! by vertex index and are not kept in sync with \c "v:point" automatically:
+//! call gather() to update them from the mesh and scatter() to write them
+//! back.
+//! \ingroup core
+class CoordinateArrays
+{
+public:
+    //! alignment of each coordinate array in bytes
+    static const size_t alignment = 64;
+
+    //! construct empty arrays
+    CoordinateArrays() : size_(0), padded_size_(0) {}
+
+    //! construct from the vertex positions of \p mesh
+    explicit CoordinateArrays(const SurfaceMesh& mesh) { gather(mesh); }
+
+    //! copy constructor
+    CoordinateArrays(const CoordinateArrays& rhs) : size_(0), padded_size_(0)
+    {
+        *this = rhs;
+    }
+
+    //! assignment operator, re-aligns the copied arrays
+    CoordinateArrays& operator=(const CoordinateArrays& rhs);
+
+    //! \brief Copy the vertex positions of \p mesh into the arrays.
+    //! \details Deleted vertices are copied as well but excluded from
+    //! bounds().
+    void gather(const SurfaceMesh& mesh);
+
+    //! \brief Copy the coordinates back to the positions of \p mesh.
+    //! \pre \p mesh has the same number of vertex slots as when gathered.
+    //! \throw InvalidInputException if the precondition is violated.
+    void scatter(SurfaceMesh& mesh) const;
+
+    //! number of vertex slots, same as SurfaceMesh::vertices_size()
+    size_t size() const { return size_; }
+
+    //! size of each array including padding
+    size_t padded_size() const { return padded_size_; }
+
+    //! x coordinates
+    Scalar* x() { return base() + 0 * padded_size_; }
+
+    //! y coordinates
+    Scalar* y() { return base() + 1 * padded_size_; }
+
+    //! z coordinates
+    Scalar* z() { return base() + 2 * padded_size_; }
+
+    //! x coordinates
+    const Scalar* x() const { return base() + 0 * padded_size_; }
+
+    //! y coordinates
+    const Scalar* y() const { return base() + 1 * padded_size_; }
+
+    //! z coordinates
+    const Scalar* z() const { return base() + 2 * padded_size_; }
+
+    //! position of vertex \p v
+    Point position(Vertex v) const
+    {
+        return Point(x()[v.idx()], y()[v.idx()], z()[v.idx()]);
+    }
+
+    //! bounding box of the coordinates of all non-deleted vertices
+    BoundingBox bounds() const;
+
+private:
+    // allocate aligned arrays of n elements each
+    void allocate(size_t n);
+
+    // first aligned element of data_
+    Scalar* base()
+    {
+        return const_cast<Scalar*>(
+            static_cast<const CoordinateArrays*>(this)->base());
+    }
+    const Scalar* base() const
+    {
+        auto p = reinterpret_cast<std::uintptr_t>(data_.data());
+        auto offset = (alignment - p % alignment) % alignment;
+        return data_.data() + offset / sizeof(Scalar);
+    }
+
+    std::vector<Scalar> data_;
+    std::vector<unsigned char> deleted_;
+    size_t size_;
+    size_t padded_size_;
+};
+
+} // namespace pmp
@@ -0,0 +1,142 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "pmp/Properties.h"
+#include "pmp/MatVec.h"
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+//! \addtogroup core
+//! @{
+
+//! \brief Row-major matrix type of the view of a property of type
+//! Matrix<S, M, 1>.
+template <typename S, int M>
+using PropertyMatrix = Eigen::Matrix<S, Eigen::Dynamic, M, Eigen::RowMajor>;
+
+//! \brief Zero-copy view of a property of type Matrix<S, M, 1>.
+//! \details Row i holds the value of element i, e.g., the position of
+//! vertex i for \c "v:point".
+template <typename S, int M>
+using PropertyMap =
+    Eigen::Map<PropertyMatrix<S, M>, Eigen::Unaligned, Eigen::OuterStride<>>;
+
+//! Zero-copy read-only view of a property of type Matrix<S, M, 1>.
+template <typename S, int M>
+using ConstPropertyMap = Eigen::Map<const PropertyMatrix<S, M>,
+                                    Eigen::Unaligned, Eigen::OuterStride<>>;
+
+//! Zero-copy view of a scalar property.
+template <typename S>
+using ScalarPropertyMap =
+    Eigen::Map<Eigen::Matrix<S, Eigen::Dynamic, 1>, Eigen::Unaligned,
+               Eigen::InnerStride<>>;
+
+//! Zero-copy read-only view of a scalar property.
+template <typename S>
+using ConstScalarPropertyMap =
+    Eigen::Map<const Eigen::Matrix<S, Eigen::Dynamic, 1>, Eigen::Unaligned,
+               Eigen::InnerStride<>>;
+
+//! \brief View a vector-valued property as an Eigen matrix without copying.
+//! \details The matrix has one row per element, including deleted ones, and
+//! also works for properties wrapping strided external memory. Shared
+//! elements are copied first and all elements are recorded as modified, see
+//! PropertyArray::mutable_data(). The view is invalidated when elements are
+//! added or the property is removed.
+//!
+//! Example:
+//! \code
+//! auto points = eigen_map(mesh.get_vertex_property<Point>("v:point"));
+//! points.rowwise() += Eigen::RowVector3f(0, 0, 1);
+//! \endcode
+template <typename S, int M>
+PropertyMap<S, M> eigen_map(Property<Matrix<S, M, 1>> p)
+{
+    return PropertyMap<S, M>(reinterpret_cast<S*>(p.mutable_data()),
+                             p.size(), M,
+                             Eigen::OuterStride<>(p.stride() / sizeof(S)));
+}
+
+//! \brief View a vector-valued property as a read-only Eigen matrix.
+//! \details Does not copy shared elements nor record modifications.
+//! \sa eigen_map()
+template <typename S, int M>
+ConstPropertyMap<S, M> const_eigen_map(const Property<Matrix<S, M, 1>>& p)
+{
+    const S* data = p.size() ? p[0].data() : nullptr;
+    return ConstPropertyMap<S, M>(data, p.size(), M,
+                                  Eigen::OuterStride<>(p.stride() / sizeof(S)));
+}
+
+//! \brief View a scalar property as an Eigen vector without copying.
+//! \sa eigen_map()
+template <typename S, typename = typename std::enable_if<
+                          std::is_arithmetic<S>::value &&
+                          !std::is_same<S, bool>::value>::type>
+ScalarPropertyMap<S> eigen_map(Property<S> p)
+{
+    return ScalarPropertyMap<S>(p.mutable_data(), p.size(),
+                                Eigen::InnerStride<>(p.stride() / sizeof(S)));
+}
+
+//! \brief View a scalar property as a read-only Eigen vector.
+//! \sa const_eigen_map()
+template <typename S, typename = typename std::enable_if<
+                          std::is_arithmetic<S>::value &&
+                          !std::is_same<S, bool>::value>::type>
+ConstScalarPropertyMap<S> const_eigen_map(const Property<S>& p)
+{
+    const S* data = p.size() ? &p[0] : nullptr;
+    return ConstScalarPropertyMap<S>(
+        data, p.size(), Eigen::InnerStride<>(p.stride() / sizeof(S)));
+}
+
+//! \brief Copy the values of a property at \p elements into the rows of a
+//! double precision matrix, e.g., to set up the unknowns of a linear system.
+//! \details Row i receives the value of \p elements[i]. The rows are copied
+//! in parallel.
+template <class Handle, typename S, int M>
+Eigen::MatrixXd gather_rows(const Property<Matrix<S, M, 1>>& p,
+                            const std::vector<Handle>& elements)
+{
+    const auto map = const_eigen_map(p);
+    const int n = int(elements.size());
+    Eigen::MatrixXd X(n, M);
+
+    parallel_for(0, n, [&](int i) {
+        X.row(i) = map.row(elements[i].idx()).template cast<double>();
+    });
+
+    return X;
+}
+
+//! \brief Copy the rows of \p X back to the values of a property at
+//! \p elements, e.g., the solution of a linear system.
+//! \details Row i is written to \p elements[i]. The rows are copied in
+//! parallel, and only the written elements are recorded as modified.
+//! \pre \p X has one row per element and M columns.
+template <class Handle, typename S, int M, typename Derived>
+void scatter_rows(const Eigen::MatrixBase<Derived>& X,
+                  const std::vector<Handle>& elements,
+                  Property<Matrix<S, M, 1>> p)
+{
+    assert(X.rows() == Eigen::Index(elements.size()) && X.cols() == M);
+    parallel_for(0, int(elements.size()), [&](int i) {
+        Matrix<S, M, 1>& value = p[elements[i].idx()];
+        for (int j = 0; j < M; ++j)
+            value[j] = static_cast<S>(X(i, j));
+    });
+}
+
+//! @}
+
+} // namespace pmp
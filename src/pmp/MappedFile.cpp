@@ -0,0 +1,142 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/MappedFile.h"
+
+#include <cstdio>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define PMP_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+MappedFile::MappedFile(const std::string& filename, bool copy_on_write)
+    : data_(nullptr), size_(0), file_(nullptr), mapping_(nullptr)
+{
+#if defined(_WIN32)
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw IOException("Failed to open file: " + filename);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw IOException("Failed to open file: " + filename);
+    }
+    size_ = size_t(size.QuadPart);
+    file_ = file;
+    if (size_ == 0)
+        return;
+
+    HANDLE mapping = CreateFileMappingA(
+        file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0,
+        nullptr);
+    const void* view =
+        mapping ? MapViewOfFile(mapping,
+                                copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ,
+                                0, 0, 0)
+                : nullptr;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        throw IOException("Failed to map file: " + filename);
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(view);
+
+#elif defined(PMP_HAS_MMAP)
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw IOException("Failed to open file: " + filename);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw IOException("Failed to open file: " + filename);
+    }
+    size_ = size_t(st.st_size);
+    if (size_ > 0)
+    {
+        const int protection =
+            copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* p = mmap(nullptr, size_, protection, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            throw IOException("Failed to map file: " + filename);
+        }
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+    }
+
+    // the mapping stays valid after closing the file
+    close(fd);
+
+#else
+
+    (void)copy_on_write;
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in)
+        throw IOException("Failed to open file: " + filename);
+
+    char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        buffer_.insert(buffer_.end(), chunk, chunk + n);
+    fclose(in);
+
+    size_ = buffer_.size();
+    data_ = size_ ? buffer_.data() : nullptr;
+
+#endif
+}
+
+MappedFile::MappedFile(std::vector<char> contents)
+    : data_(nullptr),
+      size_(contents.size()),
+      file_(nullptr),
+      mapping_(nullptr),
+      buffer_(std::move(contents))
+{
+    data_ = size_ ? buffer_.data() : nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+    if (!buffer_.empty())
+        return;
+
+#if defined(_WIN32)
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_)
+        CloseHandle(static_cast<HANDLE>(file_));
+#elif defined(PMP_HAS_MMAP)
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+} // namespace pmp
@@ -0,0 +1,65 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pmp {
+
+//! \brief Read-only view of the contents of a file.
+//! \details The file is memory-mapped where supported, such that readers can
+//! parse it in place, and from multiple threads, without copying it into
+//! buffers first. On other platforms, e.g., Emscripten, it is read into
+//! memory at once.
+//! \ingroup core
+class MappedFile
+{
+public:
+    //! \brief Open and map \p filename.
+    //! \details If \p copy_on_write is true, the mapped pages may be
+    //! modified. Modifications are private to the process and do not change
+    //! the file.
+    //! \throw IOException if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& filename,
+                        bool copy_on_write = false);
+
+    //! \brief Take over \p contents that are already in memory.
+    //! \details Used for data that is decompressed when reading files. The
+    //! contents are writable.
+    explicit MappedFile(std::vector<char> contents);
+
+    //! unmap and close the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //! first byte of the file contents, null for an empty file
+    const char* data() const { return data_; }
+
+    //! size of the file in bytes
+    size_t size() const { return size_; }
+
+    //! one past the last byte of the file contents
+    const char* end() const { return data_ + size_; }
+
+    //! \brief Writable pointer to the file contents.
+    //! \pre The file was mapped with \c copy_on_write.
+    char* writable_data() const { return const_cast<char*>(data_); }
+
+private:
+    const char* data_;
+    size_t size_;
+
+    // platform-specific handles of the mapping
+    void* file_;
+    void* mapping_;
+
+    // contents of the file if it is not mapped
+    std::vector<char> buffer_;
+};
+
+} // namespace pmp
@@ -417,6 +417,69 @@ Matrix<Scalar, M, N> operator*(const Matrix<Scalar, M, K>& m1,
     return m;
 }
 
+// The products of 3x3 and 4x4 matrices and vectors below are written out
+// explicitly, since the nested loops above are not always unrolled. They
+// compute the same sums in the same order.
+
+//! matrix-vector multiplication for 3x3 matrices
+template <typename Scalar>
+inline Matrix<Scalar, 3, 1> operator*(const Mat3<Scalar>& m,
+                                      const Matrix<Scalar, 3, 1>& v)
+{
+    return Matrix<Scalar, 3, 1>(
+        m(0, 0) * v[0] + m(0, 1) * v[1] + m(0, 2) * v[2],
+        m(1, 0) * v[0] + m(1, 1) * v[1] + m(1, 2) * v[2],
+        m(2, 0) * v[0] + m(2, 1) * v[1] + m(2, 2) * v[2]);
+}
+
+//! matrix-vector multiplication for 4x4 matrices
+template <typename Scalar>
+inline Matrix<Scalar, 4, 1> operator*(const Mat4<Scalar>& m,
+                                      const Matrix<Scalar, 4, 1>& v)
+{
+    return Matrix<Scalar, 4, 1>(
+        m(0, 0) * v[0] + m(0, 1) * v[1] + m(0, 2) * v[2] + m(0, 3) * v[3],
+        m(1, 0) * v[0] + m(1, 1) * v[1] + m(1, 2) * v[2] + m(1, 3) * v[3],
+        m(2, 0) * v[0] + m(2, 1) * v[1] + m(2, 2) * v[2] + m(2, 3) * v[3],
+        m(3, 0) * v[0] + m(3, 1) * v[1] + m(3, 2) * v[2] + m(3, 3) * v[3]);
+}
+
+//! matrix-matrix multiplication for 3x3 matrices
+template <typename Scalar>
+inline Mat3<Scalar> operator*(const Mat3<Scalar>& m1, const Mat3<Scalar>& m2)
+{
+    Mat3<Scalar> m;
+    for (int j = 0; j < 3; ++j)
+    {
+        m(0, j) = m1(0, 0) * m2(0, j) + m1(0, 1) * m2(1, j) +
+                  m1(0, 2) * m2(2, j);
+        m(1, j) = m1(1, 0) * m2(0, j) + m1(1, 1) * m2(1, j) +
+                  m1(1, 2) * m2(2, j);
+        m(2, j) = m1(2, 0) * m2(0, j) + m1(2, 1) * m2(1, j) +
+                  m1(2, 2) * m2(2, j);
+    }
+    return m;
+}
+
+//! matrix-matrix multiplication for 4x4 matrices
+template <typename Scalar>
+inline Mat4<Scalar> operator*(const Mat4<Scalar>& m1, const Mat4<Scalar>& m2)
+{
+    Mat4<Scalar> m;
+    for (int j = 0; j < 4; ++j)
+    {
+        m(0, j) = m1(0, 0) * m2(0, j) + m1(0, 1) * m2(1, j) +
+                  m1(0, 2) * m2(2, j) + m1(0, 3) * m2(3, j);
+        m(1, j) = m1(1, 0) * m2(0, j) + m1(1, 1) * m2(1, j) +
+                  m1(1, 2) * m2(2, j) + m1(1, 3) * m2(3, j);
+        m(2, j) = m1(2, 0) * m2(0, j) + m1(2, 1) * m2(1, j) +
+                  m1(2, 2) * m2(2, j) + m1(2, 3) * m2(3, j);
+        m(3, j) = m1(3, 0) * m2(0, j) + m1(3, 1) * m2(1, j) +
+                  m1(3, 2) * m2(2, j) + m1(3, 3) * m2(3, j);
+    }
+    return m;
+}
+
 //! component-wise multiplication
 template <typename Scalar, int M, int N>
 Matrix<Scalar, M, N> cmult(const Matrix<Scalar, M, N>& m1,
@@ -530,6 +593,27 @@ inline Scalar sqrnorm(const Matrix<Scalar, M, N>& m)
     return s;
 }
 
+//! compute the squared Euclidean norm of a 2D vector
+template <typename Scalar>
+inline Scalar sqrnorm(const Matrix<Scalar, 2, 1>& v)
+{
+    return v[0] * v[0] + v[1] * v[1];
+}
+
+//! compute the squared Euclidean norm of a 3D vector
+template <typename Scalar>
+inline Scalar sqrnorm(const Matrix<Scalar, 3, 1>& v)
+{
+    return v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+}
+
+//! compute the squared Euclidean norm of a 4D vector
+template <typename Scalar>
+inline Scalar sqrnorm(const Matrix<Scalar, 4, 1>& v)
+{
+    return v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
+}
+
 //! return a normalized copy of a matrix or a vector
 template <typename Scalar, int M, int N>
 inline Matrix<Scalar, M, N> normalize(const Matrix<Scalar, M, N>& m)
@@ -1133,6 +1217,27 @@ inline Scalar dot(const Vector<Scalar, N>& v0, const Vector<Scalar, N>& v1)
     return p;
 }
 
+//! compute the dot product of two 2D vectors
+template <typename Scalar>
+inline Scalar dot(const Vector<Scalar, 2>& v0, const Vector<Scalar, 2>& v1)
+{
+    return v0[0] * v1[0] + v0[1] * v1[1];
+}
+
+//! compute the dot product of two 3D vectors
+template <typename Scalar>
+inline Scalar dot(const Vector<Scalar, 3>& v0, const Vector<Scalar, 3>& v1)
+{
+    return v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2];
+}
+
+//! compute the dot product of two 4D vectors
+template <typename Scalar>
+inline Scalar dot(const Vector<Scalar, 4>& v0, const Vector<Scalar, 4>& v1)
+{
+    return v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2] + v0[3] * v1[3];
+}
+
 //! compute the Euclidean distance between two points
 template <typename Scalar, int N>
 inline Scalar distance(const Vector<Scalar, N>& v0, const Vector<Scalar, N>& v1)
@@ -1147,6 +1252,22 @@ inline Scalar distance(const Vector<Scalar, N>& v0, const Vector<Scalar, N>& v1)
     return (Scalar)sqrt(dist);
 }
 
+//! compute the Euclidean distance between two 2D points
+template <typename Scalar>
+inline Scalar distance(const Vector<Scalar, 2>& v0, const Vector<Scalar, 2>& v1)
+{
+    const Scalar dx = v0[0] - v1[0], dy = v0[1] - v1[1];
+    return (Scalar)sqrt(dx * dx + dy * dy);
+}
+
+//! compute the Euclidean distance between two 3D points
+template <typename Scalar>
+inline Scalar distance(const Vector<Scalar, 3>& v0, const Vector<Scalar, 3>& v1)
+{
+    const Scalar dx = v0[0] - v1[0], dy = v0[1] - v1[1], dz = v0[2] - v1[2];
+    return (Scalar)sqrt(dx * dx + dy * dy + dz * dz);
+}
+
 //! compute perpendicular vector (rotate vector counter-clockwise by 90 degrees)
 template <typename Scalar>
 inline Vector<Scalar, 2> perp(const Vector<Scalar, 2>& v)
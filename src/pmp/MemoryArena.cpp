@@ -0,0 +1,74 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/MemoryArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+MemoryArena::MemoryArena(size_t block_size)
+    : block_size_(block_size), current_(0), offset_(0), used_(0), reserved_(0)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+    release();
+}
+
+void* MemoryArena::allocate(size_t bytes, size_t alignment)
+{
+    if (bytes == 0)
+        bytes = 1;
+
+    // try the current block and the blocks kept by reset()
+    for (; current_ < blocks_.size(); ++current_, offset_ = 0)
+    {
+        const Block& b = blocks_[current_];
+        auto p = reinterpret_cast<std::uintptr_t>(b.data) + offset_;
+        auto padding = (alignment - p % alignment) % alignment;
+        if (offset_ + padding + bytes <= b.size)
+        {
+            offset_ += padding + bytes;
+            used_ += bytes;
+            return b.data + offset_ - bytes;
+        }
+    }
+
+    // add a new block
+    Block b;
+    b.size = std::max(block_size_, bytes + alignment);
+    b.data = static_cast<char*>(::operator new(b.size, std::nothrow));
+    if (!b.data)
+    {
+        auto what = "MemoryArena::allocate: Out of memory.";
+        throw AllocationException(what);
+    }
+    blocks_.push_back(b);
+    reserved_ += b.size;
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(bytes, alignment);
+}
+
+void MemoryArena::reset()
+{
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+void MemoryArena::release()
+{
+    for (auto& b : blocks_)
+        ::operator delete(b.data);
+    blocks_.clear();
+    reserved_ = 0;
+    reset();
+}
+
+} // namespace pmp
@@ -0,0 +1,168 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "pmp/Properties.h"
+
+namespace pmp {
+
+//! \addtogroup core
+//!@{
+
+//! \brief Monotonic memory arena for short-lived meshes and temporaries.
+//! \details Memory is handed out by bumping a pointer through large blocks
+//! and is never freed individually. reset() makes all memory available again
+//! at once while keeping the blocks for reuse, which avoids the cost of
+//! allocating and freeing many small arrays when creating and destroying
+//! many meshes. The arena does not run destructors and is not thread-safe.
+//!
+//! Use SurfaceMesh::reserve(size_t,size_t,size_t,MemoryArena&) to place the
+//! standard mesh properties in an arena, move_to_arena() for other
+//! properties, and ArenaAllocator for algorithm temporaries:
+//! \code
+//! MemoryArena arena;
+//! for (const auto& tile : tiles)
+//! {
+//!     SurfaceMesh mesh;
+//!     mesh.reserve(tile.n_vertices, tile.n_edges, tile.n_faces, arena);
+//!     // ... build and process mesh ...
+//!     arena.reset(); // after mesh is destroyed
+//! }
+//! \endcode
+class MemoryArena
+{
+public:
+    //! construct with blocks of at least \p block_size bytes
+    explicit MemoryArena(size_t block_size = size_t(1) << 20);
+
+    //! free all blocks
+    ~MemoryArena();
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    //! \brief Allocate \p bytes bytes aligned to \p alignment.
+    //! \details \p alignment has to be a power of two.
+    //! \throw AllocationException if a new block cannot be allocated.
+    void* allocate(size_t bytes,
+                   size_t alignment = alignof(std::max_align_t));
+
+    //! Allocate uninitialized memory for \p n objects of type \p T.
+    template <class T>
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    //! \brief Make all memory available again, keeping the blocks.
+    //! \details Invalidates all memory handed out so far. Objects that use
+    //! arena memory, e.g., meshes placed in the arena, have to be destroyed
+    //! before.
+    void reset();
+
+    //! Free all blocks. Same precondition as reset().
+    void release();
+
+    //! number of bytes handed out since the last reset() or release()
+    size_t bytes_used() const { return used_; }
+
+    //! number of bytes reserved in blocks
+    size_t bytes_reserved() const { return reserved_; }
+
+private:
+    struct Block
+    {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    size_t block_size_;
+    size_t current_; // index of the block allocations are taken from
+    size_t offset_;  // first free byte in the current block
+    size_t used_;
+    size_t reserved_;
+};
+
+//! \brief STL allocator taking its memory from a MemoryArena.
+//! \details Deallocation is a no-op, memory is recycled by
+//! MemoryArena::reset(). Use it for temporary containers of algorithms:
+//! \code
+//! std::vector<Vertex, ArenaAllocator<Vertex>> queue{ArenaAllocator<Vertex>(arena)};
+//! \endcode
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    //! construct allocator using \p arena
+    explicit ArenaAllocator(MemoryArena& arena) : arena_(&arena) {}
+
+    //! construct from an allocator of another type using the same arena
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs) : arena_(rhs.arena())
+    {
+    }
+
+    //! allocate memory for \p n objects
+    T* allocate(size_t n) { return arena_->allocate<T>(n); }
+
+    //! no-op, memory is recycled by MemoryArena::reset()
+    void deallocate(T*, size_t) {}
+
+    //! the arena memory is taken from
+    MemoryArena* arena() const { return arena_; }
+
+private:
+    MemoryArena* arena_;
+};
+
+//! allocators are equal if they use the same arena
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+//! allocators are equal if they use the same arena
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
+
+//! \brief Move the elements of \p prop to arena memory.
+//! \details Allocates room for \p capacity elements in \p arena, copies the
+//! current elements, and lets \p prop wrap the arena memory, see
+//! PropertyArray::wrap(). The property can grow up to \p capacity elements
+//! without allocating. Beyond that, it continues with internal storage.
+//! \p T has to be trivially destructible and must not be \c bool.
+template <class T>
+void move_to_arena(Property<T> prop, size_t capacity, MemoryArena& arena)
+{
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "move_to_arena: arena memory is not destructed");
+    static_assert(!std::is_same<T, bool>::value,
+                  "move_to_arena: bool properties are bit-packed");
+
+    const auto& elements = prop.vector();
+    if (capacity < elements.size())
+        capacity = elements.size();
+
+    T* data = arena.allocate<T>(capacity);
+    std::uninitialized_copy(elements.begin(), elements.end(), data);
+    std::uninitialized_fill(data + elements.size(), data + capacity, T());
+    prop.wrap(data, sizeof(T), capacity);
+}
+
+//!@}
+
+} // namespace pmp
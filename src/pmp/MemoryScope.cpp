@@ -0,0 +1,126 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/MemoryScope.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pmp/MemoryUsage.h"
+
+namespace pmp {
+
+// Keeps the open scopes and samples the RSS for them on a background thread,
+// which is started with the first scope and waits while none is open.
+class MemorySampler
+{
+public:
+    static MemorySampler& instance()
+    {
+        static MemorySampler sampler;
+        return sampler;
+    }
+
+    ~MemorySampler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeup_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void open(MemoryScope* scope)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scopes_.push_back(scope);
+        if (interval_ > 0 && !thread_.joinable())
+            thread_ = std::thread(&MemorySampler::run, this);
+        else if (scopes_.size() == 1)
+            wakeup_.notify_all();
+    }
+
+    void close(MemoryScope* scope)
+    {
+        const size_t size = MemoryUsage::current_size();
+        std::lock_guard<std::mutex> lock(mutex_);
+        scope->peak_ = std::max(scope->peak_, size);
+        scopes_.erase(std::find(scopes_.begin(), scopes_.end(), scope));
+    }
+
+    size_t peak(MemoryScope* scope)
+    {
+        const size_t size = MemoryUsage::current_size();
+        std::lock_guard<std::mutex> lock(mutex_);
+        scope->peak_ = std::max(scope->peak_, size);
+        return scope->peak_;
+    }
+
+    void set_interval(double milliseconds)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            interval_ = std::max(milliseconds, 0.0);
+            if (interval_ > 0 && !thread_.joinable() && !scopes_.empty())
+                thread_ = std::thread(&MemorySampler::run, this);
+        }
+        wakeup_.notify_all();
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            if (scopes_.empty() || interval_ <= 0)
+            {
+                wakeup_.wait(lock);
+                continue;
+            }
+
+            // sampling under the lock only affects scopes opened before
+            const size_t size = MemoryUsage::current_size();
+            for (auto scope : scopes_)
+                scope->peak_ = std::max(scope->peak_, size);
+
+            wakeup_.wait_for(
+                lock, std::chrono::duration<double, std::milli>(interval_));
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+    std::vector<MemoryScope*> scopes_;
+    double interval_ = 5.0;
+    bool stop_ = false;
+};
+
+MemoryScope::MemoryScope() : start_(MemoryUsage::current_size()), peak_(start_)
+{
+    MemorySampler::instance().open(this);
+}
+
+MemoryScope::~MemoryScope()
+{
+    MemorySampler::instance().close(this);
+}
+
+size_t MemoryScope::peak_extra()
+{
+    return MemorySampler::instance().peak(this) - start_;
+}
+
+void MemoryScope::set_sampling_interval(double milliseconds)
+{
+    MemorySampler::instance().set_interval(milliseconds);
+}
+
+} // namespace pmp
@@ -0,0 +1,61 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstddef>
+
+namespace pmp {
+
+//! \brief Measures the peak memory a scope needs in addition to the memory
+//! in use when it was opened.
+//! \details Unlike MemoryUsage::max_size(), which never decreases, this
+//! tells which phase of a computation caused a peak. The resident set size
+//! (RSS) of the process is sampled when a scope is opened and closed, and
+//! periodically by a background thread while any scope is open. Short
+//! peaks between two samples are missed, and memory the allocator keeps
+//! after freeing it still counts as in use. The RSS is shared by all
+//! threads, so concurrent scopes see each other's memory.
+//!
+//! Example:
+//! \code
+//! MemoryScope scope;
+//! SurfaceRemeshing(mesh).uniform_remeshing(0.01);
+//! std::cout << scope.peak_extra() / 1e6 << " MB\n";
+//! \endcode
+//! \ingroup core
+class MemoryScope
+{
+public:
+    //! open the scope and sample the current RSS
+    MemoryScope();
+
+    //! close the scope
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+    //! the RSS in bytes when the scope was opened
+    size_t start_size() const { return start_; }
+
+    //! \brief The peak RSS since the scope was opened minus start_size(), in
+    //! bytes.
+    //! \details Takes a sample of the current RSS as well.
+    size_t peak_extra();
+
+    //! \brief Set the interval of the background sampling in milliseconds.
+    //! \details Defaults to 5 ms. An interval of 0 disables the background
+    //! thread, such that only the samples at opening, closing, and
+    //! peak_extra() are taken.
+    static void set_sampling_interval(double milliseconds);
+
+private:
+    // the sampler updates the peaks of all open scopes
+    friend class MemorySampler;
+
+    size_t start_;
+    size_t peak_;
+};
+
+} // namespace pmp
@@ -0,0 +1,263 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/Parallel.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// browsers run threads as web workers, which OpenMP does not support
+#if !defined(_OPENMP) && defined(__EMSCRIPTEN_PTHREADS__)
+#define PMP_THREAD_POOL
+#include <condition_variable>
+#include <thread>
+#endif
+
+namespace pmp {
+
+namespace {
+
+#ifdef _OPENMP
+const int default_n_threads = omp_get_max_threads();
+#endif
+
+#ifdef PMP_THREAD_POOL
+
+const int default_n_threads =
+    std::max(1, int(std::thread::hardware_concurrency()));
+
+// Runs the tasks of parallel loops on worker threads instead of OpenMP. The
+// calling thread takes part in each loop, and loops started while another
+// one is running run sequentially.
+class ThreadPool
+{
+public:
+    static ThreadPool& instance()
+    {
+        static ThreadPool pool(default_n_threads - 1);
+        return pool;
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeup_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    // run the tasks on up to n_threads threads, false if the pool is busy
+    bool run(int n_threads, int n_tasks, const std::function<void(int)>& task)
+    {
+        std::unique_lock<std::mutex> running(run_mutex_, std::try_to_lock);
+        if (!running)
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            n_tasks_ = n_tasks;
+            next_task_ = 0;
+            n_joining_ = std::min({n_threads - 1, n_tasks - 1,
+                                   int(workers_.size())});
+            ++generation_;
+        }
+        wakeup_.notify_all();
+        work();
+
+        // the tasks are taken, wait for those still running
+        std::unique_lock<std::mutex> lock(mutex_);
+        n_joining_ = 0;
+        done_.wait(lock, [&] { return n_working_ == 0; });
+        task_ = nullptr;
+        return true;
+    }
+
+private:
+    explicit ThreadPool(int n_workers)
+    {
+        for (int i = 0; i < n_workers; ++i)
+            workers_.emplace_back(&ThreadPool::wait_for_work, this);
+    }
+
+    void wait_for_work()
+    {
+        unsigned int generation = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            wakeup_.wait(lock, [&] {
+                return stop_ || (generation != generation_ && n_joining_ > 0);
+            });
+            if (stop_)
+                return;
+
+            generation = generation_;
+            --n_joining_;
+            ++n_working_;
+            lock.unlock();
+            work();
+            lock.lock();
+            if (--n_working_ == 0)
+                done_.notify_all();
+        }
+    }
+
+    void work()
+    {
+        int i;
+        while ((i = next_task_++) < n_tasks_)
+            (*task_)(i);
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_; // held while a loop is running
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::condition_variable done_;
+    const std::function<void(int)>* task_ = nullptr;
+    int n_tasks_ = 0;
+    std::atomic<int> next_task_{0};
+    int n_joining_ = 0; // workers still to join the current loop
+    int n_working_ = 0;
+    unsigned int generation_ = 0;
+    bool stop_ = false;
+};
+
+#endif
+
+// deterministic mode requested by the environment
+bool deterministic_from_environment()
+{
+    const char* value = std::getenv("PMP_DETERMINISTIC");
+    return value && *value && std::strcmp(value, "0") != 0;
+}
+
+std::atomic<int> n_threads_(0);
+std::atomic<bool> deterministic_(deterministic_from_environment());
+
+std::mutex executor_mutex;
+std::shared_ptr<const Executor> executor_;
+
+// whether the calling thread runs a task of a parallel loop
+thread_local bool in_task = false;
+
+} // namespace
+
+void Parallel::set_n_threads(int n_threads)
+{
+    n_threads_ = std::max(n_threads, 0);
+}
+
+int Parallel::n_threads()
+{
+#if defined(_OPENMP) || defined(PMP_THREAD_POOL)
+    return n_threads_ ? n_threads_.load() : default_n_threads;
+#else
+    return 1;
+#endif
+}
+
+void Parallel::set_executor(Executor executor)
+{
+    std::lock_guard<std::mutex> lock(executor_mutex);
+    if (executor)
+        executor_ = std::make_shared<const Executor>(std::move(executor));
+    else
+        executor_.reset();
+}
+
+bool Parallel::has_executor()
+{
+    std::lock_guard<std::mutex> lock(executor_mutex);
+    return bool(executor_);
+}
+
+void Parallel::set_deterministic(bool deterministic)
+{
+    deterministic_ = deterministic;
+}
+
+bool Parallel::is_deterministic()
+{
+    return deterministic_;
+}
+
+bool Parallel::in_parallel()
+{
+#ifdef _OPENMP
+    if (omp_in_parallel())
+        return true;
+#endif
+    return in_task;
+}
+
+void Parallel::run(int n_tasks, const std::function<void(int)>& task)
+{
+    if (n_tasks < 1)
+        return;
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto guarded = [&](int i) {
+        const bool nested = in_task;
+        in_task = true;
+        try
+        {
+            task(i);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+        in_task = nested;
+    };
+
+    std::shared_ptr<const Executor> executor;
+    {
+        std::lock_guard<std::mutex> lock(executor_mutex);
+        executor = executor_;
+    }
+
+    const bool sequential = n_tasks == 1 || in_parallel();
+
+    if (sequential)
+    {
+        for (int i = 0; i < n_tasks; ++i)
+            guarded(i);
+    }
+    else if (executor)
+    {
+        (*executor)(n_tasks, guarded);
+    }
+    else
+    {
+#ifdef PMP_THREAD_POOL
+        if (!ThreadPool::instance().run(n_threads(), n_tasks, guarded))
+            for (int i = 0; i < n_tasks; ++i)
+                guarded(i);
+#else
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads())
+        for (int i = 0; i < n_tasks; ++i)
+            guarded(i);
+#endif
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace pmp
@@ -0,0 +1,236 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \addtogroup core
+//! @{
+
+//! \brief Runs `task(i)` for each `i` in `[0, n_tasks)` and returns after all
+//! of them finished.
+//! \details The tasks are independent and may run concurrently in any order,
+//! e.g., on the thread pool of an application embedding the library. Tasks
+//! do not throw, exceptions are caught and rethrown by Parallel::run().
+typedef std::function<void(int n_tasks, const std::function<void(int)>& task)>
+    Executor;
+
+//! \brief Library-wide configuration of parallel execution.
+//! \details All parallel loops of the library, see parallel_for() and
+//! parallel_reduce(), split their range into chunks that are run as tasks
+//! either on the OpenMP threads or on an external Executor. The settings are
+//! global and meant to be changed while no algorithm is running.
+//!
+//! Browsers do not support OpenMP. WebAssembly builds with threads, see the
+//! CMake option \c PMP_WASM_THREADS, run the tasks on a pool of web workers
+//! instead, with one thread per logical processor by default.
+class Parallel
+{
+public:
+    //! \brief Set the number of threads of parallel loops.
+    //! \details 0 restores the default, all threads OpenMP provides.
+    //! Without OpenMP or web workers all loops run sequentially.
+    static void set_n_threads(int n_threads);
+
+    //! the number of threads of parallel loops, 1 without OpenMP or web
+    //! workers
+    static int n_threads();
+
+    //! \brief Run the tasks of parallel loops on \p executor instead of the
+    //! OpenMP threads.
+    //! \details An empty executor restores OpenMP. Loops started from within
+    //! a task run sequentially, such that an executor waiting for its tasks
+    //! cannot deadlock.
+    static void set_executor(Executor executor);
+
+    //! whether an executor is set
+    static bool has_executor();
+
+    //! \brief Make the results of parallel loops independent of the number of
+    //! threads and of the executor.
+    //! \details Loops that only write the elements they are called for are
+    //! deterministic anyway. In deterministic mode parallel_reduce() splits
+    //! its range into chunks of fixed size, at the cost of more partial
+    //! results, otherwise into a few chunks per thread, which changes the
+    //! rounding of floating point sums with the number of threads.
+    //!
+    //! Together with the fixed-order sums of the algorithms, e.g.,
+    //! surface_area() or the gathered quadrics of SurfaceSimplification, and
+    //! the thread-independent batches of IndependentSetScheduler, the output
+    //! of the algorithms is then bit-identical for any number of threads on
+    //! the same platform and build. The mode is enabled at startup if the
+    //! environment variable \c PMP_DETERMINISTIC is set to a value other
+    //! than \c 0.
+    static void set_deterministic(bool deterministic);
+
+    //! whether deterministic mode is enabled
+    static bool is_deterministic();
+
+    //! \brief Whether the calling thread runs a task of a parallel loop or is
+    //! within an OpenMP parallel region.
+    //! \details Parallel loops started from there run sequentially.
+    static bool in_parallel();
+
+    //! \brief Run `task(i)` for each `i` in `[0, n_tasks)`, on the executor if
+    //! one is set, otherwise on the OpenMP threads.
+    //! \details If tasks throw, the first exception is rethrown after all
+    //! tasks finished.
+    static void run(int n_tasks, const std::function<void(int)>& task);
+};
+
+//! \brief Call `fn(first, last)` for chunks of \p chunk_size consecutive
+//! indices in `[begin, end)` in parallel.
+//! \details Chunks are distributed dynamically, see Parallel::run(). This
+//! allows to reuse scratch memory within a chunk.
+template <class Function>
+void parallel_for_chunks(int begin, int end, Function fn,
+                         int chunk_size = 1024)
+{
+    if (begin >= end)
+        return;
+    if (chunk_size < 1)
+        chunk_size = 1;
+
+    const int n_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    Parallel::run(n_chunks, [&](int c) {
+        const int first = begin + c * chunk_size;
+        fn(first, std::min(first + chunk_size, end));
+    });
+}
+
+//! \brief Call `fn(i)` for each index \p i in `[begin, end)` in parallel.
+//! \details The indices are processed in chunks of \p chunk_size, see
+//! parallel_for_chunks().
+template <class Function>
+void parallel_for(int begin, int end, Function fn, int chunk_size = 1024)
+{
+    parallel_for_chunks(
+        begin, end,
+        [&](int first, int last) {
+            for (int i = first; i < last; ++i)
+                fn(i);
+        },
+        chunk_size);
+}
+
+//! \brief Call \p fn for each element of \p range in parallel.
+//! \details The index range of \p range, e.g., `mesh.vertices()` or
+//! `mesh.faces()`, is split into chunks of \p chunk_size consecutive indices
+//! that are distributed dynamically over the threads, see Parallel::run().
+//! Deleted elements are skipped, so ranges with garbage are balanced as well.
+//! Without garbage, and for SurfaceMesh::DenseRange, each chunk is a plain
+//! counted loop.
+//! Without OpenMP and executor the loop runs sequentially. If \p fn throws,
+//! the first exception is rethrown after all threads finished.
+//!
+//! Calling \p fn concurrently is safe as long as it only
+//! - reads connectivity and geometry, including all const member functions,
+//!   iterators, and circulators of SurfaceMesh,
+//! - reads properties through handles obtained beforehand,
+//! - writes properties of the element it was called for, or of any other
+//!   element it exclusively owns.
+//!
+//! Writing different elements of a `bool` property is safe as well, their
+//! bits are set atomically, see BitVector.
+//!
+//! It is not safe to add or delete elements, to perform topological
+//! operations such as SurfaceMesh::split() or SurfaceMesh::collapse(), or to
+//! add or remove properties.
+//!
+//! Example:
+//! \code
+//! parallel_for(mesh.vertices(), [&](Vertex v) {
+//!     normals[v] = SurfaceNormals::compute_vertex_normal(mesh, v);
+//! });
+//! \endcode
+template <class Range, class Function>
+void parallel_for(const Range& range, Function fn, int chunk_size = 1024)
+{
+    typedef typename std::decay<decltype(*range.begin())>::type Handle;
+
+    const SurfaceMesh* mesh = range.begin().mesh();
+    if (!mesh)
+        return;
+
+    const bool garbage = mesh->has_garbage();
+    parallel_for_chunks(
+        int((*range.begin()).idx()), int((*range.end()).idx()),
+        [&](int first, int last) {
+            if (!garbage)
+            {
+                for (int i = first; i < last; ++i)
+                    fn(Handle(i));
+                return;
+            }
+            for (int i = first; i < last; ++i)
+            {
+                Handle h(i);
+                if (!mesh->is_deleted(h))
+                    fn(h);
+            }
+        },
+        chunk_size);
+}
+
+//! \brief Combine the values `map(i)` of all indices \p i in `[begin, end)`
+//! in parallel.
+//! \details Each chunk of indices is reduced separately, the partial results
+//! are then combined pairwise in a fixed order and finally combined with
+//! \p init. \p combine has to be associative. The chunks have at least
+//! \p chunk_size indices, and exactly that many in deterministic mode, see
+//! Parallel::set_deterministic(). The pairwise combination also keeps the
+//! rounding error of long floating point sums low.
+//!
+//! Example:
+//! \code
+//! double area = parallel_reduce(
+//!     0, int(mesh.faces_size()), 0.0,
+//!     [&](int i) { return triangle_area(mesh, Face(i)); },
+//!     [](double a, double b) { return a + b; });
+//! \endcode
+template <class T, class Map, class Combine>
+T parallel_reduce(int begin, int end, T init, Map map, Combine combine,
+                  int chunk_size = 1024)
+{
+    if (begin >= end)
+        return init;
+    if (chunk_size < 1)
+        chunk_size = 1;
+
+    // a few chunks per thread for load balancing
+    if (!Parallel::is_deterministic())
+    {
+        const int n_chunks = 4 * Parallel::n_threads();
+        chunk_size = std::max(chunk_size, (end - begin) / n_chunks + 1);
+    }
+
+    const int n_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    std::vector<T> partial(n_chunks);
+    Parallel::run(n_chunks, [&](int c) {
+        const int first = begin + c * chunk_size;
+        const int last = std::min(first + chunk_size, end);
+        T value = map(first);
+        for (int i = first + 1; i < last; ++i)
+            value = combine(value, map(i));
+        partial[c] = value;
+    });
+
+    // pairwise, independent of the order in which the chunks finished
+    for (size_t step = 1; step < partial.size(); step *= 2)
+        for (size_t c = 0; c + step < partial.size(); c += 2 * step)
+            partial[c] = combine(partial[c], partial[c + step]);
+
+    return combine(init, partial[0]);
+}
+
+//! @}
+
+} // namespace pmp
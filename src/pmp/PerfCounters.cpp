@@ -0,0 +1,233 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/PerfCounters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "pmp/Parallel.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pmp {
+
+namespace {
+
+// counting requested by the environment
+bool enabled_from_environment()
+{
+    const char* value = std::getenv("PMP_PERF_COUNTERS");
+    return value && *value && std::strcmp(value, "0") != 0;
+}
+
+std::atomic<bool> enabled_(enabled_from_environment());
+
+#ifdef __linux__
+
+// the counted events, in the order of the members of PerfCounts
+const uint64_t events[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                           PERF_COUNT_HW_CACHE_MISSES,
+                           PERF_COUNT_HW_BRANCH_MISSES};
+const int n_events = 4;
+
+class ThreadCounters;
+
+// the open counters of all threads, and the final counts of the threads
+// that exited
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<const ThreadCounters*> counters;
+    PerfCounts exited;
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+// The counters of a thread, opened as one group led by the first event
+// that can be opened, such that all events are counted at the same time.
+// Events the processor cannot count are left out of the group.
+class ThreadCounters
+{
+public:
+    ThreadCounters() : leader_(-1)
+    {
+        for (int i = 0; i < n_events; ++i)
+        {
+            fds_[i] = -1;
+            slots_[i] = -1;
+        }
+
+        int n_open = 0;
+        for (int i = 0; i < n_events; ++i)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = events[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // the calling thread on any CPU
+            const int fd =
+                int(syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+            if (fd < 0)
+                continue;
+            if (leader_ < 0)
+                leader_ = fd;
+            fds_[i] = fd;
+            slots_[i] = n_open++;
+        }
+
+        if (is_open())
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.counters.push_back(this);
+        }
+    }
+
+    ~ThreadCounters()
+    {
+        if (is_open())
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.exited += read();
+            r.counters.erase(
+                std::find(r.counters.begin(), r.counters.end(), this));
+        }
+        for (int i = 0; i < n_events; ++i)
+            if (fds_[i] >= 0)
+                close(fds_[i]);
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    bool is_open() const { return leader_ >= 0; }
+
+    PerfCounts read() const
+    {
+        PerfCounts counts;
+        if (!is_open())
+            return counts;
+
+        // number of events, times enabled and running, values
+        uint64_t buffer[3 + n_events];
+        const ssize_t size = ::read(leader_, buffer, sizeof(buffer));
+        if (size < ssize_t(3 * sizeof(uint64_t)))
+            return counts;
+
+        // the group shares the counters with other groups if the processor
+        // has too few, which is compensated by scaling
+        const uint64_t n = buffer[0];
+        const double scale =
+            buffer[2] > 0 ? double(buffer[1]) / double(buffer[2]) : 0.0;
+        uint64_t values[n_events] = {0, 0, 0, 0};
+        for (int i = 0; i < n_events; ++i)
+            if (slots_[i] >= 0 && uint64_t(slots_[i]) < n)
+                values[i] = uint64_t(double(buffer[3 + slots_[i]]) * scale);
+
+        counts.cycles = values[0];
+        counts.instructions = values[1];
+        counts.cache_misses = values[2];
+        counts.branch_misses = values[3];
+        return counts;
+    }
+
+private:
+    int leader_;
+    int fds_[n_events];
+    int slots_[n_events]; // position of each event in the group, -1 if none
+};
+
+// the counters of the calling thread, opened on first use
+const ThreadCounters& thread_counters()
+{
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+#endif
+
+} // namespace
+
+void PerfCounters::set_enabled(bool enabled)
+{
+    enabled_ = enabled;
+}
+
+bool PerfCounters::is_enabled()
+{
+    return enabled_;
+}
+
+bool PerfCounters::is_available()
+{
+#ifdef __linux__
+    return thread_counters().is_open();
+#else
+    return false;
+#endif
+}
+
+PerfCounts PerfCounters::thread_counts()
+{
+#ifdef __linux__
+    if (enabled_)
+        return thread_counters().read();
+#endif
+    return PerfCounts();
+}
+
+PerfCounts PerfCounters::team_counts()
+{
+    if (!enabled_)
+        return PerfCounts();
+
+#ifdef __linux__
+    if (Parallel::in_parallel())
+        return thread_counts();
+
+    // open the counters of the threads running the parallel loops, which
+    // are then counted until they exit
+    Parallel::run(Parallel::n_threads(), [](int) { thread_counters(); });
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    PerfCounts sum = r.exited;
+    for (auto counters : r.counters)
+        sum += counters->read();
+    return sum;
+#else
+    return PerfCounts();
+#endif
+}
+
+PerfCounterScope::PerfCounterScope() : start_(PerfCounters::team_counts())
+{
+}
+
+PerfCounts PerfCounterScope::counts() const
+{
+    return PerfCounters::team_counts() - start_;
+}
+
+} // namespace pmp
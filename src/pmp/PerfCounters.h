@@ -0,0 +1,126 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstdint>
+
+namespace pmp {
+
+//! \brief Counts of hardware events.
+//! \details Counts of events the processor cannot count are zero, and
+//! is_valid() is false if no event could be counted at all.
+//! \ingroup core
+struct PerfCounts
+{
+    uint64_t cycles = 0;        //!< CPU cycles in user space
+    uint64_t instructions = 0;  //!< retired instructions
+    uint64_t cache_misses = 0;  //!< last level cache misses
+    uint64_t branch_misses = 0; //!< mispredicted branches
+
+    //! whether the counts were measured
+    bool is_valid() const { return cycles > 0 || instructions > 0; }
+
+    //! instructions per cycle, 0 if no cycles were counted
+    double ipc() const
+    {
+        return cycles ? double(instructions) / double(cycles) : 0.0;
+    }
+
+    //! add the counts of \p rhs
+    PerfCounts& operator+=(const PerfCounts& rhs)
+    {
+        cycles += rhs.cycles;
+        instructions += rhs.instructions;
+        cache_misses += rhs.cache_misses;
+        branch_misses += rhs.branch_misses;
+        return *this;
+    }
+
+    //! the counts from \p rhs to these counts, clamped to zero
+    PerfCounts operator-(const PerfCounts& rhs) const
+    {
+        PerfCounts d;
+        d.cycles = cycles > rhs.cycles ? cycles - rhs.cycles : 0;
+        d.instructions =
+            instructions > rhs.instructions ? instructions - rhs.instructions
+                                            : 0;
+        d.cache_misses =
+            cache_misses > rhs.cache_misses ? cache_misses - rhs.cache_misses
+                                            : 0;
+        d.branch_misses = branch_misses > rhs.branch_misses
+                              ? branch_misses - rhs.branch_misses
+                              : 0;
+        return d;
+    }
+};
+
+//! \brief Hardware performance counters of the calling threads.
+//! \details Tells whether a computation is limited by memory accesses or by
+//! branches, which wall-clock time alone cannot. On Linux the counters are
+//! opened with \c perf_event_open the first time a thread reads them and
+//! count user-space events of that thread only, until it exits. They are
+//! unavailable on other platforms, in many virtual machines, and if
+//! \c /proc/sys/kernel/perf_event_paranoid is larger than 2, in which case
+//! all counts are zero.
+//!
+//! Counting is disabled by default, such that profiling zones do not pay for
+//! reading the counters. It is enabled at startup if the environment
+//! variable \c PMP_PERF_COUNTERS is set to a value other than \c 0.
+//!
+//! Example:
+//! \code
+//! PerfCounters::set_enabled(true);
+//! PerfCounterScope scope;
+//! TriangleKdTree(mesh).nearest(points, neighbors);
+//! std::cout << scope.counts().cache_misses << " LLC misses\n";
+//! \endcode
+//! \ingroup core
+class PerfCounters
+{
+public:
+    //! enable or disable counting
+    static void set_enabled(bool enabled);
+
+    //! whether counting is enabled
+    static bool is_enabled();
+
+    //! whether the counters can be read by the calling thread
+    static bool is_available();
+
+    //! \brief The counts of the calling thread since its counters were
+    //! opened.
+    //! \details Zero if counting is disabled or unavailable.
+    static PerfCounts thread_counts();
+
+    //! \brief The sum of the counts of all threads that opened their
+    //! counters, including the threads that exited meanwhile.
+    //! \details Opens the counters of the threads running the parallel loops
+    //! of the library, on OpenMP, the web worker pool, or the executor, see
+    //! Parallel::run(). Within a parallel loop this is the same as
+    //! thread_counts().
+    static PerfCounts team_counts();
+};
+
+//! \brief Counts the hardware events of a scope.
+//! \details Measures team_counts(), such that the parallel loops within the
+//! scope are counted. A scope opened within a parallel region only counts
+//! the events of its own thread.
+//! \ingroup core
+class PerfCounterScope
+{
+public:
+    //! open the scope, reading the counters if counting is enabled
+    PerfCounterScope();
+
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+
+    //! the counts since the scope was opened
+    PerfCounts counts() const;
+
+private:
+    PerfCounts start_;
+};
+
+} // namespace pmp
@@ -0,0 +1,221 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t no_parent = std::numeric_limits<size_t>::max();
+
+// a zone per thread and nesting path
+struct Node
+{
+    const char* name;
+    size_t parent;
+    int thread;
+    size_t calls;
+    double total_ms;
+    size_t peak_extra; // highest peak extra memory of the calls in bytes
+    PerfCounts counts; // summed hardware events of the calls
+};
+
+// a single call of a zone, in microseconds since the epoch
+struct Event
+{
+    size_t node;
+    double start;
+    double duration;
+    size_t peak_extra;
+    PerfCounts counts;
+};
+
+std::mutex mutex;
+std::vector<Node> nodes;
+std::vector<Event> events;
+std::map<std::thread::id, int> threads;
+const Clock::time_point epoch = Clock::now();
+
+// the open zones of the calling thread
+thread_local std::vector<size_t> stack;
+
+double microseconds(Clock::duration d)
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// number threads in the order of their first zone, requires the lock
+int thread_index()
+{
+    const auto id = std::this_thread::get_id();
+    auto it = threads.find(id);
+    if (it == threads.end())
+        it = threads.emplace(id, int(threads.size())).first;
+    return it->second;
+}
+
+void print(std::ostream& os, size_t node, int depth, double parent_ms,
+           bool counted)
+{
+    const Node& n = nodes[node];
+    char line[256];
+    snprintf(line, sizeof(line), "%*s%-*s %8lu calls %12.3f ms %10.1f MB",
+             2 * depth, "", 40 - 2 * depth, n.name, (unsigned long)n.calls,
+             n.total_ms, n.peak_extra / 1048576.0);
+    os << line;
+    if (parent_ms > 0)
+    {
+        snprintf(line, sizeof(line), " %6.1f%%", 100 * n.total_ms / parent_ms);
+        os << line;
+    }
+    else if (counted)
+        os << std::string(8, ' ');
+    if (counted)
+    {
+        const PerfCounts& c = n.counts;
+        snprintf(line, sizeof(line),
+                 " %10.3g cycles %5.2f IPC %10.3g LLC misses %10.3g branch "
+                 "misses",
+                 double(c.cycles), c.ipc(), double(c.cache_misses),
+                 double(c.branch_misses));
+        os << line;
+    }
+    os << "\n";
+
+    for (size_t i = node + 1; i < nodes.size(); ++i)
+        if (nodes[i].parent == node)
+            print(os, i, depth + 1, n.total_ms, counted);
+}
+
+void write_string(FILE* file, const char* s)
+{
+    fputc('"', file);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', file);
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+} // namespace
+
+bool Profiler::is_enabled()
+{
+#ifdef PMP_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    nodes.clear();
+    events.clear();
+    threads.clear();
+}
+
+void Profiler::report(std::ostream& os)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    bool counted = false;
+    for (const auto& n : nodes)
+        counted = counted || n.counts.is_valid();
+
+    for (int t = 0; t < int(threads.size()); ++t)
+    {
+        if (threads.size() > 1)
+            os << "thread " << t << ":\n";
+        for (size_t i = 0; i < nodes.size(); ++i)
+            if (nodes[i].parent == no_parent && nodes[i].thread == t)
+                print(os, i, 0, 0, counted);
+    }
+}
+
+void Profiler::write_chrome_trace(const std::string& filename)
+{
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file)
+        throw IOException("Failed to open file: " + filename);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fprintf(file, "{\"traceEvents\":[");
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event& e = events[i];
+        const Node& n = nodes[e.node];
+        fprintf(file, "%s\n{\"name\":", i ? "," : "");
+        write_string(file, n.name);
+        fprintf(file,
+                ",\"cat\":\"pmp\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                "\"pid\":0,\"tid\":%d,\"args\":{\"peak_extra_bytes\":%lu",
+                e.start, e.duration, n.thread, (unsigned long)e.peak_extra);
+        if (e.counts.is_valid())
+            fprintf(file,
+                    ",\"cycles\":%llu,\"instructions\":%llu,"
+                    "\"llc_misses\":%llu,\"branch_misses\":%llu",
+                    (unsigned long long)e.counts.cycles,
+                    (unsigned long long)e.counts.instructions,
+                    (unsigned long long)e.counts.cache_misses,
+                    (unsigned long long)e.counts.branch_misses);
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+}
+
+ProfileZone::ProfileZone(const char* name)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t parent = stack.empty() ? no_parent : stack.back();
+        const int thread = thread_index();
+
+        node_ = 0;
+        while (node_ < nodes.size() &&
+               (nodes[node_].parent != parent ||
+                nodes[node_].thread != thread ||
+                strcmp(nodes[node_].name, name) != 0))
+            ++node_;
+        if (node_ == nodes.size())
+            nodes.push_back(Node{name, parent, thread, 0, 0.0, 0, {}});
+    }
+    stack.push_back(node_);
+    start_ = Clock::now();
+}
+
+ProfileZone::~ProfileZone()
+{
+    const auto end = Clock::now();
+    const size_t peak_extra = memory_.peak_extra();
+    const PerfCounts counts = counters_.counts();
+    stack.pop_back();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Node& n = nodes[node_];
+    ++n.calls;
+    n.total_ms += 1e-3 * microseconds(end - start_);
+    n.peak_extra = std::max(n.peak_extra, peak_extra);
+    n.counts += counts;
+    events.push_back(Event{node_, microseconds(start_ - epoch),
+                           microseconds(end - start_), peak_extra, counts});
+}
+
+} // namespace pmp
@@ -0,0 +1,89 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "pmp/MemoryScope.h"
+#include "pmp/PerfCounters.h"
+
+namespace pmp {
+
+//! \brief Collects the times of nested, named zones of all threads.
+//! \details Zones are opened by constructing a ProfileZone, usually through
+//! the PMP_PROFILE_SCOPE() macro, and closed by its destructor. The
+//! profiler accumulates the calls and times of each zone per thread and
+//! nesting path, and records every call for export in the Chrome trace event
+//! format, to be viewed with chrome://tracing or https://ui.perfetto.dev.
+//! Each zone also keeps the highest peak memory of its calls in addition to
+//! the memory in use when they started, see MemoryScope, and, if enabled,
+//! the hardware events of its calls, see PerfCounters.
+//! Closing a zone takes a lock, so zones are meant for the phases of an
+//! algorithm, not for its inner loops.
+//! \ingroup core
+class Profiler
+{
+public:
+    //! whether the library instruments its algorithms, see PMP_PROFILING
+    static bool is_enabled();
+
+    //! discard all recorded zones, must not be called while zones are open
+    static void clear();
+
+    //! \brief Print the zones as a tree.
+    //! \details Each line shows the name of a zone, its calls, its total
+    //! time, its peak extra memory, and its share of the time of the
+    //! enclosing zone. If hardware events were counted, the line continues
+    //! with the cycles, the instructions per cycle, and the last level cache
+    //! and branch misses of the zone.
+    static void report(std::ostream& os = std::cout);
+
+    //! \brief Write all recorded calls to \p filename as Chrome trace JSON.
+    //! \throw IOException in case of failure to open the file.
+    static void write_chrome_trace(const std::string& filename);
+};
+
+//! \brief Times a named zone of code from construction to destruction.
+//! \details Tracks the memory of the zone with a MemoryScope and its
+//! hardware events with a PerfCounterScope. \p name has to outlive the
+//! profiler, e.g., a string literal.
+//! \ingroup core
+class ProfileZone
+{
+public:
+    //! open the zone \p name within the innermost open zone of this thread
+    explicit ProfileZone(const char* name);
+
+    //! close the zone
+    ~ProfileZone();
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    size_t node_;
+    std::chrono::steady_clock::time_point start_;
+    MemoryScope memory_;
+    PerfCounterScope counters_;
+};
+
+} // namespace pmp
+
+#define PMP_PROFILE_CONCAT_(a, b) a##b
+#define PMP_PROFILE_CONCAT(a, b) PMP_PROFILE_CONCAT_(a, b)
+
+//! \def PMP_PROFILE_SCOPE(name)
+//! \brief Profile the enclosing scope as zone \p name.
+//! \details Expands to nothing unless the library is built with the CMake
+//! option PMP_PROFILING, which defines the macro of the same name.
+//! \ingroup core
+#ifdef PMP_PROFILING
+#define PMP_PROFILE_SCOPE(name)                                                \
+    pmp::ProfileZone PMP_PROFILE_CONCAT(pmp_profile_zone_, __LINE__)(name)
+#else
+#define PMP_PROFILE_SCOPE(name)
+#endif
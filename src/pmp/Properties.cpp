@@ -0,0 +1,21 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/Properties.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace pmp {
+
+size_t PropertyKey::intern(const std::string& name)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, size_t> ids;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t id = ids.size();
+    return ids.emplace(name, id).first->second;
+}
+
+} // namespace pmp
@@ -11,14 +11,160 @@
 #include <algorithm>
 #include <typeinfo>
 #include <iostream>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <type_traits>
+
+#include "pmp/BitVector.h"
 
 namespace pmp {
 
+//! \brief Interned property name for fast property lookup.
+//! \details Each name is registered once in a process-wide table and mapped
+//! to a dense integer ID. Looking up a property by key is a binary search
+//! over the IDs of a container's properties instead of a search comparing
+//! names. Keys are cheap to copy and are meant to be created once, e.g., as
+//! function-local static variables:
+//! \code
+//! static const PropertyKey color_key("v:color");
+//! auto colors = mesh.get_vertex_property<Color>(color_key);
+//! \endcode
+class PropertyKey
+{
+public:
+    //! Register \p name, or look up its ID if already registered.
+    explicit PropertyKey(const std::string& name)
+        : id_(intern(name)), name_(name)
+    {
+    }
+
+    //! Return the unique ID of the name
+    size_t id() const { return id_; }
+
+    //! Return the name of the key
+    const std::string& name() const { return name_; }
+
+private:
+    // thread-safe registration of names
+    static size_t intern(const std::string& name);
+
+    size_t id_;
+    std::string name_;
+};
+
+//! Memory used by a single property array.
+struct PropertyMemory
+{
+    //! Kind of elements the property belongs to, e.g., "vertex"
+    std::string container;
+
+    //! Name of the property
+    std::string name;
+
+    //! Number of elements
+    size_t size;
+
+    //! Bytes used by the elements, i.e., size times element size
+    size_t bytes;
+
+    //! Bytes reserved for elements, including unused capacity
+    size_t capacity_bytes;
+
+    //! Bytes allocated on the heap by the elements themselves, e.g., by
+    //! properties of type std::vector
+    size_t heap_bytes;
+
+    //! Are the elements shared with a copy of the property?
+    bool shared;
+
+    //! Are the elements stored in caller-owned memory?
+    bool external;
+
+    //! Are only the pages of written elements stored?
+    bool sparse;
+
+    //! Bytes owned by the property, zero for external memory
+    size_t total_bytes() const
+    {
+        return external ? heap_bytes : capacity_bytes + heap_bytes;
+    }
+};
+
+//! Heap memory allocated by a property value, zero for plain types.
+template <class T>
+inline size_t heap_bytes(const T&)
+{
+    return 0;
+}
+
+//! Heap memory allocated by a string value.
+inline size_t heap_bytes(const std::string& s)
+{
+    return s.capacity();
+}
+
+//! Heap memory allocated by a vector-valued property, including nested
+//! allocations of its elements.
+template <class T, class A>
+inline size_t heap_bytes(const std::vector<T, A>& v)
+{
+    size_t bytes = v.capacity() * sizeof(T);
+    for (const auto& t : v)
+        bytes += heap_bytes(t);
+    return bytes;
+}
+
+//! \brief Old values of the elements of a property array modified while
+//! recording.
+//! \sa BasePropertyArray::begin_delta()
+class BasePropertyDelta
+{
+public:
+    //! Destructor.
+    virtual ~BasePropertyDelta() {}
+
+    //! Bytes used by the saved values.
+    virtual size_t memory_usage() const = 0;
+};
+
+//! Old values of the elements of a PropertyArray<T>.
+template <class T>
+struct PropertyDelta : public BasePropertyDelta
+{
+    //! number of elements before the modifications
+    size_t size = 0;
+
+    //! indices of the saved elements, empty if all elements are saved in
+    //! order
+    std::vector<size_t> indices;
+
+    //! the saved values, aligned with indices
+    std::vector<T> values;
+
+    virtual size_t memory_usage() const
+    {
+        return indices.capacity() * sizeof(size_t) + heap_bytes(values);
+    }
+};
+
 class BasePropertyArray
 {
 public:
     //! Default constructor
-    BasePropertyArray(const std::string& name) : name_(name) {}
+    BasePropertyArray(const std::string& name)
+        : name_(name), key_(PropertyKey(name).id())
+    {
+    }
+
+    //! Construct with the already interned \p key of \p name, e.g., when
+    //! copying an array. Does not access the table of names.
+    BasePropertyArray(const std::string& name, size_t key)
+        : name_(name), key_(key)
+    {
+    }
 
     //! Destructor.
     virtual ~BasePropertyArray() {}
@@ -38,84 +184,1056 @@ public:
     //! Let two elements swap their storage place.
     virtual void swap(size_t i0, size_t i1) = 0;
 
+    //! Reset element \p idx to the default value.
+    virtual void reset(size_t idx) = 0;
+
+    //! Copy element \p first to position \p second for each entry of
+    //! \p moves.
+    virtual void relocate(
+        const std::vector<std::pair<size_t, size_t>>& moves) = 0;
+
+    //! Permute elements such that new element i is old element order[i].
+    virtual void permute(const std::vector<size_t>& order) = 0;
+
+    //! Copy the \p n elements of \p src starting at \p src_begin to the
+    //! elements starting at \p dst_begin. \p src has to have the same type.
+    virtual void copy_range(const BasePropertyArray& src, size_t src_begin,
+                            size_t n, size_t dst_begin) = 0;
+
+    //! Write the elements of \p src, which has to have the same type, that
+    //! differ from ours, resizing to the size of \p src.
+    virtual void assign_changed(const BasePropertyArray& src) = 0;
+
+    //! \brief Start saving the old value of each element on its first
+    //! modification.
+    //! \details Every modification that can change a value saves it first:
+    //! writes through non-const access, bulk access, permutations, and
+    //! shrinking. Elements added while recording are not saved. Concurrent
+    //! writes are safe, but the first write of each element takes a lock.
+    //! Used by SurfaceMeshHistory.
+    virtual void begin_delta() = 0;
+
+    //! \brief Stop recording and return the saved values.
+    //! \details Values that were written back unchanged are dropped. Returns
+    //! null if nothing changed.
+    virtual std::unique_ptr<BasePropertyDelta> end_delta() = 0;
+
+    //! \brief Restore the values saved in \p delta, which has to come from
+    //! an array of the same type.
+    //! \details Modifications are recorded as usual, such that recording
+    //! while applying a delta returns the delta undoing it.
+    virtual void apply_delta(const BasePropertyDelta& delta) = 0;
+
+    //! Are old values being saved?
+    bool records_delta() const { return recording_; }
+
     //! Return a deep copy of self.
     virtual BasePropertyArray* clone() const = 0;
 
+    //! Report the memory used by the property.
+    virtual PropertyMemory memory_usage() const = 0;
+
     //! Return the type_info of the property
     virtual const std::type_info& type() = 0;
 
     //! Return the name of the property
     const std::string& name() const { return name_; }
 
+    //! Return the ID of the interned name of the property
+    size_t key() const { return key_; }
+
+    //! \brief Record modified elements using generations read from \p clock.
+    //! \details While tracking, each element written through non-const
+    //! access is stamped with the current value of \p clock. Bulk access
+    //! through vector(), permutations, and changes of the array size stamp
+    //! all elements. A null \p clock stops tracking. \p n is the current
+    //! number of elements.
+    void track_changes(std::shared_ptr<const std::atomic<uint64_t>> clock,
+                       size_t n)
+    {
+        clock_ = clock;
+        std::vector<uint64_t>(clock_ ? n : 0, 0).swap(stamps_);
+        generation_.store(0, std::memory_order_relaxed);
+        update_fast_path();
+    }
+
+    //! Are modifications recorded?
+    bool tracks_changes() const { return clock_ != nullptr; }
+
+    //! Generation of the latest recorded modification, zero if none.
+    uint64_t generation() const
+    {
+        return generation_.load(std::memory_order_relaxed);
+    }
+
+    //! Indices of the elements modified after generation \p g. Empty if
+    //! changes are not tracked.
+    std::vector<size_t> changed_since(uint64_t g) const
+    {
+        std::vector<size_t> changed;
+        if (generation() > g)
+            for (size_t i = 0; i < stamps_.size(); ++i)
+                if (stamps_[i] > g)
+                    changed.push_back(i);
+        return changed;
+    }
+
 protected:
+    // stamp element i with the current generation, saving its old value
+    // while recording
+    void touch(size_t i)
+    {
+        if (recording_)
+            save(i, i + 1);
+        if (clock_)
+        {
+            const uint64_t g = clock_->load(std::memory_order_relaxed);
+            assert(i < stamps_.size());
+            stamps_[i] = g;
+            if (generation_.load(std::memory_order_relaxed) != g)
+                generation_.store(g, std::memory_order_relaxed);
+        }
+    }
+
+    // resize to n elements, stamping added elements with the current
+    // generation
+    void resize_stamps(size_t n)
+    {
+        const uint64_t g = clock_->load(std::memory_order_relaxed);
+        stamps_.resize(n, g);
+        generation_.store(g, std::memory_order_relaxed);
+    }
+
+    // stamp all n elements with the current generation, saving the old
+    // values while recording
+    void touch_all(size_t n)
+    {
+        if (recording_)
+            save(0, size_t(-1));
+        if (clock_)
+        {
+            const uint64_t g = clock_->load(std::memory_order_relaxed);
+            stamps_.assign(n, g);
+            generation_.store(g, std::memory_order_relaxed);
+        }
+    }
+
+    // save the unsaved elements in [begin, end) that existed before
+    // recording started
+    virtual void save(size_t begin, size_t end) = 0;
+
+    // enable or disable direct non-const element access after the storage,
+    // sharing, tracking, or recording state changed
+    virtual void update_fast_path() = 0;
+
     std::string name_;
+    size_t key_;
+
+    // saving old values, see begin_delta()
+    bool recording_ = false;
+
+    // change tracking
+    std::shared_ptr<const std::atomic<uint64_t>> clock_;
+    std::vector<uint64_t> stamps_;
+    std::atomic<uint64_t> generation_{0};
 };
 
+//! Container storing the elements of a PropertyArray<T>.
+template <class T>
+struct PropertyStorage
+{
+    typedef std::vector<T> Type;
+};
+
+//! bool properties are stored as packed bits
+template <>
+struct PropertyStorage<bool>
+{
+    typedef BitVector Type;
+};
+
+namespace detail {
+
+// compare values of types having an equality operator, other values are
+// never considered equal
+template <class T>
+auto equal_values(const T& a, const T& b, int) -> decltype(bool(a == b))
+{
+    return a == b;
+}
+
+template <class T>
+bool equal_values(const T&, const T&, long)
+{
+    return false;
+}
+
+// copy n elements between vectors
+template <class V>
+void copy_elements(const V& src, size_t src_begin, size_t n, V& dst,
+                   size_t dst_begin)
+{
+    std::copy(src.begin() + src_begin, src.begin() + src_begin + n,
+              dst.begin() + dst_begin);
+}
+
+inline void copy_elements(const BitVector& src, size_t src_begin, size_t n,
+                          BitVector& dst, size_t dst_begin)
+{
+    for (size_t i = 0; i < n; ++i)
+        dst[dst_begin + i] = src[src_begin + i];
+}
+
+} // namespace detail
+
 template <class T>
 class PropertyArray : public BasePropertyArray
 {
 public:
     typedef T ValueType;
-    typedef std::vector<ValueType> VectorType;
+    typedef typename PropertyStorage<T>::Type VectorType;
     typedef typename VectorType::reference reference;
     typedef typename VectorType::const_reference const_reference;
 
     PropertyArray(const std::string& name, T t = T())
-        : BasePropertyArray(name), value_(t)
+        : BasePropertyArray(name),
+          data_(std::make_shared<VectorType>()),
+          shared_(false),
+          value_(t),
+          external_(nullptr),
+          stride_(sizeof(T)),
+          size_(0),
+          capacity_(0),
+          n_pages_(0),
+          sparse_(false)
     {
     }
 
+    //! \brief Copy constructor.
+    //! \details The copy shares the elements of \p rhs until one of both is
+    //! modified. Wrapped external memory and sparse pages are always copied,
+    //! as are the elements of arrays pinned by vector() or mutable_data().
+    //! \note Several copies of \p rhs can be made concurrently, and also
+    //! while other threads read \p rhs. Copying is not thread-safe while
+    //! \p rhs is modified, and the first modification of a shared array
+    //! replaces its storage, which is not synchronized with const element
+    //! access from other threads.
+    PropertyArray(const PropertyArray<T>& rhs)
+        : BasePropertyArray(rhs.name_, rhs.key_),
+          shared_(false),
+          value_(rhs.value_),
+          external_(nullptr),
+          stride_(sizeof(T)),
+          size_(0),
+          capacity_(0),
+          n_pages_(0),
+          sparse_(false)
+    {
+        copy_data(rhs);
+    }
+
+    //! Destructor.
+    ~PropertyArray() { free_pages(); }
+
+    //! Assignment. Shares the elements of \p rhs, same as the copy constructor.
+    PropertyArray<T>& operator=(const PropertyArray<T>& rhs)
+    {
+        if (this != &rhs)
+        {
+            name_ = rhs.name_;
+            key_ = rhs.key_;
+            value_ = rhs.value_;
+            if (recording_)
+                save(0, size_t(-1));
+            external_ = nullptr;
+            stride_ = sizeof(T);
+            size_ = capacity_ = 0;
+            free_pages();
+            copy_data(rhs);
+        }
+        return *this;
+    }
+
 public: // virtual interface of BasePropertyArray
-    virtual void reserve(size_t n) { data_.reserve(n); }
+    virtual void reserve(size_t n)
+    {
+        if (!external_ && !sparse_)
+        {
+            make_unique();
+            data_->reserve(n);
+            update_fast_path();
+        }
+    }
+
+    virtual void resize(size_t n)
+    {
+        if (recording_ && n < size())
+            save(n, size());
+        if (clock_ && n != size())
+            resize_stamps(n);
 
-    virtual void resize(size_t n) { data_.resize(n, value_); }
+        if (sparse_)
+        {
+            resize_pages(n);
+        }
+        else if (!external_)
+        {
+            make_unique();
+            data_->resize(n, value_);
+        }
+        else if (n > capacity_)
+        {
+            detach();
+            data_->resize(n, value_);
+        }
+        else
+        {
+            const size_t old_size = size_;
+            size_ = n;
+            for (size_t i = old_size; i < n; ++i)
+                (*this)[i] = value_;
+        }
+        update_fast_path();
+    }
 
-    virtual void push_back() { data_.push_back(value_); }
+    virtual void push_back() { resize(size() + 1); }
 
-    virtual void free_memory() { VectorType(data_).swap(data_); }
+    virtual void free_memory()
+    {
+        if (sparse_)
+            free_default_pages();
+        else if (!external_ && !is_shared())
+        {
+            VectorType(*data_).swap(*data_);
+            update_fast_path();
+        }
+    }
 
     virtual void swap(size_t i0, size_t i1)
     {
-        T d(data_[i0]);
-        data_[i0] = data_[i1];
-        data_[i1] = d;
+        T d((*this)[i0]);
+        (*this)[i0] = (*this)[i1];
+        (*this)[i1] = d;
     }
 
+    virtual void reset(size_t idx) { set(idx, value_); }
+
+    virtual void relocate(const std::vector<std::pair<size_t, size_t>>& moves)
+    {
+        if (sparse_)
+        {
+            const PropertyArray<T>& self = *this;
+            for (const auto& m : moves)
+                set(m.second, self[m.first]);
+            return;
+        }
+
+        for (const auto& m : moves)
+            (*this)[m.second] = (*this)[m.first];
+    }
+
+    virtual void permute(const std::vector<size_t>& order)
+    {
+        if (sparse_)
+        {
+            permute_pages(order);
+            return;
+        }
+
+        const PropertyArray<T>& self = *this;
+        auto permuted = std::make_shared<VectorType>(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            (*permuted)[i] = self[order[i]];
+
+        touch_all(order.size());
+
+        if (!external_)
+        {
+            data_ = permuted;
+            shared_ = false;
+            pinned_ = false;
+            vector_pinned_ = false;
+            update_fast_path();
+            return;
+        }
+
+        for (size_t i = 0; i < permuted->size(); ++i)
+            (*this)[i] = (*permuted)[i];
+        size_ = permuted->size();
+    }
+
+    virtual void copy_range(const BasePropertyArray& src, size_t src_begin,
+                            size_t n, size_t dst_begin)
+    {
+        assert(typeid(src) == typeid(*this));
+        const auto& rhs = static_cast<const PropertyArray<T>&>(src);
+
+        if (external_ || rhs.external_ || sparse_ || rhs.sparse_)
+        {
+            for (size_t i = 0; i < n; ++i)
+                set(dst_begin + i, rhs[src_begin + i]);
+            return;
+        }
+
+        make_unique();
+        if (clock_ || recording_)
+            for (size_t i = 0; i < n; ++i)
+                touch(dst_begin + i);
+        detail::copy_elements(*rhs.data_, src_begin, n, *data_, dst_begin);
+    }
+
+    virtual void assign_changed(const BasePropertyArray& src)
+    {
+        assert(typeid(src) == typeid(*this));
+        const auto& rhs = static_cast<const PropertyArray<T>&>(src);
+        const PropertyArray<T>& self = *this;
+
+        resize(rhs.size());
+        for (size_t i = 0; i < rhs.size(); ++i)
+            if (!detail::equal_values<T>(self[i], rhs[i], 0))
+                set(i, rhs[i]);
+    }
+
+    virtual void begin_delta()
+    {
+        delta_.reset(new PropertyDelta<T>);
+        delta_->size = size();
+        BitVector().swap(saved_);
+        saved_ready_ = false;
+        recording_ = true;
+        update_fast_path();
+    }
+
+    virtual std::unique_ptr<BasePropertyDelta> end_delta()
+    {
+        recording_ = false;
+        update_fast_path();
+        std::unique_ptr<PropertyDelta<T>> d(std::move(delta_));
+        BitVector().swap(saved_);
+        saved_ready_ = false;
+        if (!d)
+            return nullptr;
+
+        // drop the values that were written back unchanged
+        const PropertyArray<T>& self = *this;
+        size_t n = 0;
+        for (size_t k = 0; k < d->indices.size(); ++k)
+        {
+            const size_t i = d->indices[k];
+            const T value = d->values[k];
+            if (i < size() && detail::equal_values<T>(value, self[i], 0))
+                continue;
+            d->indices[n] = i;
+            d->values[n] = value;
+            ++n;
+        }
+        d->indices.resize(n);
+        d->values.resize(n);
+        if (n == 0 && d->size == size())
+            return nullptr;
+
+        // all elements were saved, store them in order without indices
+        if (n == d->size)
+        {
+            std::vector<T> values(n);
+            for (size_t k = 0; k < n; ++k)
+                values[d->indices[k]] = d->values[k];
+            d->values.swap(values);
+            std::vector<size_t>().swap(d->indices);
+        }
+        d->indices.shrink_to_fit();
+        d->values.shrink_to_fit();
+        return std::unique_ptr<BasePropertyDelta>(d.release());
+    }
+
+    virtual void apply_delta(const BasePropertyDelta& delta)
+    {
+        assert(dynamic_cast<const PropertyDelta<T>*>(&delta));
+        const auto& d = static_cast<const PropertyDelta<T>&>(delta);
+
+        if (size() != d.size)
+            resize(d.size);
+        if (d.indices.empty())
+            for (size_t i = 0; i < d.values.size(); ++i)
+                set(i, d.values[i]);
+        else
+            for (size_t k = 0; k < d.indices.size(); ++k)
+                set(d.indices[k], d.values[k]);
+    }
+
+    //! Return a copy of self sharing its elements until modified.
     virtual BasePropertyArray* clone() const
     {
-        PropertyArray<T>* p = new PropertyArray<T>(name_, value_);
-        p->data_ = data_;
-        return p;
+        return new PropertyArray<T>(*this);
+    }
+
+    virtual PropertyMemory memory_usage() const
+    {
+        PropertyMemory m;
+        m.name = name_;
+        m.size = size();
+        m.bytes = m.size * sizeof(T);
+        m.capacity_bytes = external_ ? m.bytes : data_->capacity() * sizeof(T);
+        m.heap_bytes = 0;
+        m.shared = is_shared();
+        m.external = is_external();
+        m.sparse = sparse_;
+        if (sparse_)
+        {
+            // the allocated pages and the page table
+            size_t n_allocated = 0;
+            for (size_t p = 0; p < n_pages_; ++p)
+                if (const T* page = pages_[p].load(std::memory_order_acquire))
+                {
+                    ++n_allocated;
+                    for (size_t i = 0; i < page_size; ++i)
+                        m.heap_bytes += heap_bytes(page[i]);
+                }
+            m.bytes = n_allocated * page_size * sizeof(T);
+            m.capacity_bytes = m.bytes + n_pages_ * sizeof(T*);
+            return m;
+        }
+        for (size_t i = 0; i < m.size; ++i)
+            m.heap_bytes += heap_bytes((*this)[i]);
+        return m;
     }
 
     virtual const std::type_info& type() { return typeid(T); }
 
 public:
-    //! Get pointer to array (does not work for T==bool)
-    const T* data() const { return &data_[0]; }
+    //! \brief Use caller-owned memory as storage.
+    //! \details The current elements are replaced by the \p size() elements
+    //! found at \p data with a distance of \p stride bytes between two
+    //! elements, which allows to wrap interleaved buffers. The memory has to
+    //! stay valid as long as it is wrapped. The array can grow within the
+    //! external memory up to \p capacity elements, which have to be
+    //! constructed already. When the array has to grow beyond, the elements
+    //! are copied to internal storage and the external memory is released.
+    //! Not available for T==bool.
+    void wrap(T* data, size_t stride = sizeof(T), size_t capacity = 0)
+    {
+        if (recording_)
+            save(0, size());
+        size_ = size();
+        capacity_ = std::max(size_, capacity);
+        external_ = reinterpret_cast<char*>(data);
+        stride_ = stride;
+        data_ = std::make_shared<VectorType>();
+        shared_ = false;
+        pinned_ = false;
+        vector_pinned_ = false;
+        free_pages();
+        touch_all(size_);
+        update_fast_path();
+    }
+
+    //! Copy the elements to internal storage and stop using external memory.
+    void detach()
+    {
+        if (!external_)
+            return;
+
+        auto data = std::make_shared<VectorType>(size_);
+        for (size_t i = 0; i < size_; ++i)
+            (*data)[i] = (*this)[i];
+
+        external_ = nullptr;
+        stride_ = sizeof(T);
+        size_ = capacity_ = 0;
+        data_ = data;
+        update_fast_path();
+    }
+
+    //! \brief Store only the pages of elements that have been written.
+    //! \details A sparse array allocates a page of 64 elements on the first
+    //! non-const access to one of them, elements of the other pages have the
+    //! default value. This saves memory for properties that keep the default
+    //! value for most elements, e.g., selections or per-vertex constraints.
+    //! Reading through const access does not allocate pages, and elements of
+    //! any pages can be written concurrently as for dense arrays. When
+    //! converting, only pages containing a value that differs from the
+    //! default are kept, if T has an equality operator. Wrapped external
+    //! memory is released. bool arrays are always stored as packed bits and
+    //! stay dense.
+    void make_sparse()
+    {
+        if (sparse_ || std::is_same<T, bool>::value)
+            return;
+
+        detach();
+        const VectorType& dense = *data_;
+        size_ = dense.size();
+        allocate_pages(size_);
+        for (size_t i = 0; i < size_; ++i)
+            if (!detail::equal_values<T>(dense[i], value_, 0))
+                page_element(i) = dense[i];
+
+        data_ = std::make_shared<VectorType>();
+        shared_ = false;
+        pinned_ = false;
+        vector_pinned_ = false;
+        update_fast_path();
+    }
+
+    //! Store all elements contiguously again.
+    void make_dense()
+    {
+        if (!sparse_)
+            return;
+
+        auto data = std::make_shared<VectorType>(size_, value_);
+        for (size_t p = 0; p < n_pages_; ++p)
+            if (const T* page = pages_[p].load(std::memory_order_acquire))
+            {
+                const size_t begin = p * page_size;
+                const size_t end = std::min(size_, begin + page_size);
+                for (size_t i = begin; i < end; ++i)
+                    (*data)[i] = page[i - begin];
+            }
+
+        free_pages();
+        size_ = 0;
+        data_ = data;
+        update_fast_path();
+    }
+
+    //! Does the array store only the pages of written elements?
+    bool is_sparse() const { return sparse_; }
+
+    //! Does the array use caller-owned memory?
+    bool is_external() const { return external_ != nullptr; }
+
+    //! Are the elements shared with a copy of this array?
+    bool is_shared() const
+    {
+        return shared_.load(std::memory_order_acquire) &&
+               data_.use_count() > 1;
+    }
+
+    //! Return the number of elements
+    size_t size() const
+    {
+        return external_ || sparse_ ? size_ : data_->size();
+    }
 
-    //! Get reference to the underlying vector
-    std::vector<T>& vector() { return data_; }
+    //! Get pointer to array (does not work for T==bool, strided external
+    //! memory, or sparse arrays)
+    const T* data() const
+    {
+        assert(!sparse_);
+        if (external_)
+        {
+            assert(stride_ == sizeof(T));
+            return reinterpret_cast<const T*>(external_);
+        }
+        return data_->data();
+    }
 
-    //! Access the i'th element. No range check is performed!
+    //! \brief Get reference to the underlying vector
+    //! \details Copies shared elements, wrapped external memory, or sparse
+    //! pages to internal storage first. The vector of a bool array is a
+    //! BitVector. The array is pinned: later copies do not share the
+    //! elements, such that writes through the reference never show in a
+    //! copy. Since the vector may be resized through the reference, non-const
+    //! element access also takes the slow path until the array is unpinned.
+    //! See is_pinned() and unpin().
+    VectorType& vector()
+    {
+        detach();
+        make_dense();
+        make_unique();
+        touch_all(data_->size());
+        pinned_ = true;
+        vector_pinned_ = true;
+        update_fast_path();
+        return *data_;
+    }
+
+    //! \brief Get the underlying vector for reading.
+    //! \details Not available for external memory or sparse arrays.
+    const VectorType& vector() const
+    {
+        assert(!external_ && !sparse_);
+        return *data_;
+    }
+
+    //! \brief Get pointer for modifying the elements in place.
+    //! \details Copies shared elements or sparse pages to internal storage
+    //! first and records all elements as modified. Unlike vector(), wrapped
+    //! external memory is kept, with elements stride() bytes apart. Pins the
+    //! array like vector(), but keeps direct non-const element access, as
+    //! the pointer cannot move the elements. Does not work for T==bool.
+    T* mutable_data()
+    {
+        if (external_)
+        {
+            touch_all(size_);
+            return reinterpret_cast<T*>(external_);
+        }
+        make_dense();
+        make_unique();
+        touch_all(data_->size());
+        pinned_ = true;
+        update_fast_path();
+        return data_->data();
+    }
+
+    //! \brief Have the elements been handed out by vector() or
+    //! mutable_data()?
+    //! \details The caller may still write through the returned reference
+    //! or pointer, so copies of a pinned array get their own elements
+    //! instead of sharing them. The array stays pinned until unpin() is
+    //! called or its storage is replaced, e.g., by permute(), wrap(), or
+    //! assignment.
+    bool is_pinned() const { return pinned_; }
+
+    //! \brief Declare that the elements handed out by vector() or
+    //! mutable_data() are no longer accessed through the returned reference
+    //! or pointer.
+    //! \details Later copies share the elements again, and non-const element
+    //! access is direct again. The reference or pointer must not be used
+    //! afterwards, call vector() or mutable_data() again instead.
+    void unpin()
+    {
+        pinned_ = false;
+        vector_pinned_ = false;
+        update_fast_path();
+    }
+
+    //! \brief Distance between two elements in bytes.
+    //! \details Differs from sizeof(T) only for wrapped external memory.
+    size_t stride() const { return stride_; }
+
+    //! \brief Access the i'th element. No range check is performed!
+    //! \details Copies shared elements to internal storage first, and
+    //! allocates the page of the element of sparse arrays. Elements of dense
+    //! arrays that are neither shared, pinned, tracked, nor recorded are
+    //! accessed directly.
     reference operator[](size_t idx)
     {
-        assert(idx < data_.size());
-        return data_[idx];
+        if (T* elements = fast_.load(std::memory_order_acquire))
+        {
+            assert(idx < data_->size());
+            return elements[idx];
+        }
+        return access(idx);
     }
 
     //! Const access to the i'th element. No range check is performed!
     const_reference operator[](size_t idx) const
     {
-        assert(idx < data_.size());
-        return data_[idx];
+        if (external_)
+        {
+            assert(idx < size_);
+            return *reinterpret_cast<const T*>(external_ + idx * stride_);
+        }
+        if (sparse_)
+        {
+            assert(idx < size_);
+            const T* page =
+                pages_[idx / page_size].load(std::memory_order_acquire);
+            return page ? page[idx % page_size] : value_;
+        }
+        assert(idx < data_->size());
+        return (*data_)[idx];
     }
 
 private:
-    VectorType data_;
+    // elements per page of sparse arrays
+    static const size_t page_size = 64;
+
+    // non-const access to element idx if there is no direct access
+    reference access(size_t idx);
+
+    // share or copy the elements of rhs
+    void copy_data(const PropertyArray<T>& rhs)
+    {
+        share_data(rhs);
+        update_fast_path();
+    }
+
+    // rhs is marked as shared, which is why its sharing flag and fast path
+    // pointer are mutable. the lock keeps rhs from replacing its storage in
+    // unshare() meanwhile, e.g., when several copies are made concurrently.
+    void share_data(const PropertyArray<T>& rhs)
+    {
+        std::lock_guard<std::mutex> lock(rhs.mutex_);
+        pinned_ = false;
+        vector_pinned_ = false;
+        if (rhs.sparse_)
+        {
+            data_ = std::make_shared<VectorType>();
+            shared_ = false;
+            size_ = rhs.size_;
+            allocate_pages(size_);
+            for (size_t p = 0; p < n_pages_; ++p)
+                if (const T* page =
+                        rhs.pages_[p].load(std::memory_order_acquire))
+                    pages_[p].store(new_page(page), std::memory_order_relaxed);
+            return;
+        }
+        if (rhs.pinned_)
+        {
+            // the elements may be written through a reference handed out
+            // by rhs, so do not share them
+            data_ = std::make_shared<VectorType>(*rhs.data_);
+            shared_ = false;
+            return;
+        }
+        if (!rhs.external_)
+        {
+            data_ = rhs.data_;
+            shared_ = true;
+            rhs.shared_ = true;
+            rhs.fast_.store(nullptr, std::memory_order_relaxed);
+            return;
+        }
+        data_ = std::make_shared<VectorType>(rhs.size_);
+        for (size_t i = 0; i < rhs.size_; ++i)
+            (*data_)[i] = rhs[i];
+        shared_ = false;
+    }
+
+    // make sure the elements are not shared before modifying them
+    void make_unique()
+    {
+        if (shared_.load(std::memory_order_acquire))
+            unshare();
+    }
+
+    // clone shared elements, safe to call from multiple threads
+    void unshare()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!shared_.load(std::memory_order_relaxed))
+            return;
+        if (data_.use_count() > 1)
+            data_ = std::make_shared<VectorType>(*data_);
+        shared_.store(false, std::memory_order_release);
+        update_fast_path();
+    }
+
+    virtual void update_fast_path()
+    {
+        T* elements = nullptr;
+        if (!external_ && !sparse_ && !vector_pinned_ && !recording_ &&
+            !clock_ && !shared_.load(std::memory_order_relaxed))
+            elements = data_->data();
+        fast_.store(elements, std::memory_order_release);
+    }
+
+    // write element idx, without allocating a page for the default value
+    void set(size_t idx, const T& value)
+    {
+        if (sparse_ &&
+            !pages_[idx / page_size].load(std::memory_order_acquire) &&
+            detail::equal_values<T>(value, value_, 0))
+            return;
+        (*this)[idx] = value;
+    }
+
+    // a new page with the elements of src, or the default value
+    T* new_page(const T* src = nullptr) const
+    {
+        T* page = new T[page_size];
+        for (size_t i = 0; i < page_size; ++i)
+            page[i] = src ? src[i] : value_;
+        return page;
+    }
+
+    // element idx of a sparse array, allocating its page if needed. safe
+    // to call from multiple threads.
+    T& page_element(size_t idx)
+    {
+        assert(idx < size_);
+        std::atomic<T*>& slot = pages_[idx / page_size];
+        T* page = slot.load(std::memory_order_acquire);
+        if (!page)
+        {
+            T* fresh = new_page();
+            if (slot.compare_exchange_strong(page, fresh,
+                                             std::memory_order_acq_rel))
+                page = fresh;
+            else
+                delete[] fresh;
+        }
+        return page[idx % page_size];
+    }
+
+    // switch to sparse storage with an empty page table for n elements
+    void allocate_pages(size_t n)
+    {
+        free_pages();
+        n_pages_ = (n + page_size - 1) / page_size;
+        pages_.reset(new std::atomic<T*>[n_pages_]);
+        for (size_t p = 0; p < n_pages_; ++p)
+            pages_[p].store(nullptr, std::memory_order_relaxed);
+        sparse_ = true;
+    }
+
+    // release all pages and switch to dense storage
+    void free_pages()
+    {
+        for (size_t p = 0; p < n_pages_; ++p)
+            delete[] pages_[p].load(std::memory_order_relaxed);
+        pages_.reset();
+        n_pages_ = 0;
+        sparse_ = false;
+    }
+
+    // change the number of elements of a sparse array. elements after the
+    // size always have the default value.
+    void resize_pages(size_t n)
+    {
+        const size_t n_pages = (n + page_size - 1) / page_size;
+        for (size_t p = n_pages; p < n_pages_; ++p)
+            delete[] pages_[p].load(std::memory_order_relaxed);
+        if (n < size_ && n % page_size)
+        {
+            T* page = pages_[n / page_size].load(std::memory_order_relaxed);
+            for (size_t i = n % page_size; page && i < page_size; ++i)
+                page[i] = value_;
+        }
+
+        std::unique_ptr<std::atomic<T*>[]> pages(new std::atomic<T*>[n_pages]);
+        for (size_t p = 0; p < n_pages; ++p)
+        {
+            T* page = nullptr;
+            if (p < n_pages_)
+                page = pages_[p].load(std::memory_order_relaxed);
+            pages[p].store(page, std::memory_order_relaxed);
+        }
+        pages_.swap(pages);
+        n_pages_ = n_pages;
+        size_ = n;
+    }
+
+    // release the pages of a sparse array that only have default values
+    void free_default_pages()
+    {
+        for (size_t p = 0; p < n_pages_; ++p)
+        {
+            T* page = pages_[p].load(std::memory_order_relaxed);
+            if (!page)
+                continue;
+            bool is_default = true;
+            for (size_t i = 0; i < page_size && is_default; ++i)
+                is_default = detail::equal_values<T>(page[i], value_, 0);
+            if (is_default)
+            {
+                delete[] page;
+                pages_[p].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // permute the elements of a sparse array
+    void permute_pages(const std::vector<size_t>& order)
+    {
+        if (recording_)
+            save(0, size_);
+        std::unique_ptr<std::atomic<T*>[]> old_pages(std::move(pages_));
+        const size_t n_old_pages = n_pages_;
+        n_pages_ = 0;
+        allocate_pages(order.size());
+        size_ = order.size();
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const size_t j = order[i];
+            if (const T* page = old_pages[j / page_size].load(
+                    std::memory_order_relaxed))
+                set(i, page[j % page_size]);
+        }
+
+        for (size_t p = 0; p < n_old_pages; ++p)
+            delete[] old_pages[p].load(std::memory_order_relaxed);
+        touch_all(order.size());
+    }
+
+    virtual void save(size_t begin, size_t end)
+    {
+        // written elements are marked in saved_, which is allocated on the
+        // first write
+        PropertyDelta<T>& d = *delta_;
+        end = std::min(end, std::min(d.size, size()));
+        if (begin >= end)
+            return;
+        if (end - begin == 1 && saved_ready_.load(std::memory_order_acquire) &&
+            saved_[begin])
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!saved_ready_.load(std::memory_order_relaxed))
+        {
+            saved_.resize(d.size, false);
+            saved_ready_.store(true, std::memory_order_release);
+        }
+        const PropertyArray<T>& self = *this;
+        for (size_t i = begin; i < end; ++i)
+            if (!saved_[i])
+            {
+                saved_[i] = true;
+                d.indices.push_back(i);
+                d.values.push_back(self[i]);
+            }
+    }
+
+    std::shared_ptr<VectorType> data_;
+    mutable std::atomic<bool> shared_;
+    mutable std::mutex mutex_;
+
+    // elements handed out by vector() or mutable_data(), never shared
+    bool pinned_ = false;
+
+    // elements handed out by vector(), which may reallocate them
+    bool vector_pinned_ = false;
+
+    // the elements for direct non-const access, see update_fast_path().
+    // null unless the array is dense, not shared, not pinned by vector(),
+    // and neither tracks changes nor records a delta. other threads may set
+    // it while unsharing, and a copy clears it in the copied array when it
+    // starts sharing, so it is atomic.
+    mutable std::atomic<T*> fast_{nullptr};
     ValueType value_;
+
+    // old values saved while recording, and the saved elements
+    std::unique_ptr<PropertyDelta<T>> delta_;
+    BitVector saved_;
+    std::atomic<bool> saved_ready_{false};
+
+    // caller-owned storage, used instead of data_ if not null
+    char* external_;
+    size_t stride_;
+    size_t size_;
+    size_t capacity_;
+
+    // pages of sparse arrays, used instead of data_ if sparse_ is set
+    std::unique_ptr<std::atomic<T*>[]> pages_;
+    size_t n_pages_;
+    bool sparse_;
 };
 
+template <class T>
+typename PropertyArray<T>::reference PropertyArray<T>::access(size_t idx)
+{
+    if (external_)
+    {
+        assert(idx < size_);
+        touch(idx);
+        return *reinterpret_cast<T*>(external_ + idx * stride_);
+    }
+    if (sparse_)
+    {
+        touch(idx);
+        return page_element(idx);
+    }
+    make_unique();
+    touch(idx);
+    assert(idx < data_->size());
+    return (*data_)[idx];
+}
+
 // specialization for bool properties
 template <>
 inline const bool* PropertyArray<bool>::data() const
@@ -124,12 +1242,67 @@ inline const bool* PropertyArray<bool>::data() const
     return nullptr;
 }
 
+template <>
+inline bool* PropertyArray<bool>::mutable_data()
+{
+    assert(false);
+    return nullptr;
+}
+
+// bool properties are stored as packed bits
+template <>
+inline PropertyMemory PropertyArray<bool>::memory_usage() const
+{
+    PropertyMemory m;
+    m.name = name_;
+    m.size = size();
+    m.bytes = (m.size + 7) / 8;
+    m.capacity_bytes = (data_->capacity() + 7) / 8;
+    m.heap_bytes = 0;
+    m.shared = is_shared();
+    m.external = false;
+    m.sparse = false;
+    return m;
+}
+
+// bool properties cannot wrap external memory
+template <>
+inline void PropertyArray<bool>::wrap(bool*, size_t, size_t)
+{
+    assert(false);
+}
+
+// bool properties are accessed through bit references only
+template <>
+inline void PropertyArray<bool>::update_fast_path()
+{
+}
+
+template <>
+inline PropertyArray<bool>::reference PropertyArray<bool>::operator[](
+    size_t idx)
+{
+    make_unique();
+    touch(idx);
+    assert(idx < data_->size());
+    return (*data_)[idx];
+}
+
+template <>
+inline PropertyArray<bool>::const_reference PropertyArray<bool>::operator[](
+    size_t idx) const
+{
+    assert(idx < data_->size());
+    return (*data_)[idx];
+}
+
 template <class T>
 class Property
 {
 public:
     typedef typename PropertyArray<T>::reference reference;
     typedef typename PropertyArray<T>::const_reference const_reference;
+    typedef typename PropertyArray<T>::VectorType VectorType;
 
     friend class PropertyContainer;
     friend class SurfaceMesh;
@@ -150,7 +1323,9 @@ public:
     const_reference operator[](size_t i) const
     {
         assert(parray_ != nullptr);
-        return (*parray_)[i];
+        // neither copies shared elements nor records a modification
+        const PropertyArray<T>& array = *parray_;
+        return array[i];
     }
 
     const T* data() const
@@ -159,12 +1334,128 @@ public:
         return parray_->data();
     }
 
-    std::vector<T>& vector()
+    VectorType& vector()
     {
         assert(parray_ != nullptr);
         return parray_->vector();
     }
 
+    //! \brief The elements for reading, e.g., the BitVector of a bool
+    //! property for word-parallel operations.
+    //! \sa PropertyArray::vector() const
+    const VectorType& vector() const
+    {
+        assert(parray_ != nullptr);
+        const PropertyArray<T>& array = *parray_;
+        return array.vector();
+    }
+
+    //! \brief Pointer for modifying the elements in place.
+    //! \sa PropertyArray::mutable_data()
+    T* mutable_data()
+    {
+        assert(parray_ != nullptr);
+        return parray_->mutable_data();
+    }
+
+    //! Distance between two elements in bytes.
+    size_t stride() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->stride();
+    }
+
+    //! Number of elements.
+    size_t size() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->size();
+    }
+
+    //! \brief Use caller-owned memory at \p data as storage.
+    //! \sa PropertyArray::wrap()
+    void wrap(T* data, size_t stride = sizeof(T), size_t capacity = 0)
+    {
+        assert(parray_ != nullptr);
+        parray_->wrap(data, stride, capacity);
+    }
+
+    //! Copy wrapped external memory to internal storage.
+    void detach()
+    {
+        assert(parray_ != nullptr);
+        parray_->detach();
+    }
+
+    //! \brief Store only the pages of elements that have been written.
+    //! \sa PropertyArray::make_sparse()
+    void make_sparse()
+    {
+        assert(parray_ != nullptr);
+        parray_->make_sparse();
+    }
+
+    //! Store all elements contiguously again.
+    void make_dense()
+    {
+        assert(parray_ != nullptr);
+        parray_->make_dense();
+    }
+
+    //! Does the property store only the pages of written elements?
+    bool is_sparse() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->is_sparse();
+    }
+
+    //! \brief Generation of the latest modification, zero if none.
+    //! \sa SurfaceMesh::set_change_tracking()
+    uint64_t generation() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->generation();
+    }
+
+    //! \brief Indices of the elements modified after generation \p g.
+    //! \sa SurfaceMesh::set_change_tracking()
+    std::vector<size_t> changed_since(uint64_t g) const
+    {
+        assert(parray_ != nullptr);
+        return parray_->changed_since(g);
+    }
+
+    //! Does the property use caller-owned memory?
+    bool is_external() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->is_external();
+    }
+
+    //! Are the elements shared with a copy of the property?
+    bool is_shared() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->is_shared();
+    }
+
+    //! \brief Are copies kept from sharing the elements?
+    //! \sa PropertyArray::is_pinned()
+    bool is_pinned() const
+    {
+        assert(parray_ != nullptr);
+        return parray_->is_pinned();
+    }
+
+    //! \brief Stop using the elements handed out by vector() or
+    //! mutable_data().
+    //! \sa PropertyArray::unpin()
+    void unpin()
+    {
+        assert(parray_ != nullptr);
+        parray_->unpin();
+    }
+
 private:
     PropertyArray<T>& array()
     {
@@ -182,6 +1473,35 @@ private:
     PropertyArray<T>* parray_;
 };
 
+//! \brief Old state of the arrays of a PropertyContainer.
+//! \sa PropertyContainer::begin_delta()
+struct PropertyContainerDelta
+{
+    //! number of elements before the modifications
+    size_t size = 0;
+
+    //! old values of the modified arrays that still exist, by name
+    std::vector<std::pair<std::string, std::unique_ptr<BasePropertyDelta>>>
+        arrays;
+
+    //! removed arrays with their old values, and their positions
+    std::vector<std::pair<size_t, std::unique_ptr<BasePropertyArray>>> removed;
+
+    //! names of the added arrays
+    std::vector<std::string> added;
+
+    //! Bytes used by the saved values and arrays.
+    size_t memory_usage() const
+    {
+        size_t bytes = 0;
+        for (const auto& a : arrays)
+            bytes += a.second->memory_usage();
+        for (const auto& r : removed)
+            bytes += r.second->memory_usage().total_bytes();
+        return bytes;
+    }
+};
+
 class PropertyContainer
 {
 public:
@@ -189,7 +1509,11 @@ public:
     PropertyContainer() : size_(0) {}
 
     // destructor (deletes all property arrays)
-    virtual ~PropertyContainer() { clear(); }
+    virtual ~PropertyContainer()
+    {
+        delta_.reset();
+        clear();
+    }
 
     // copy constructor: performs deep copy of property arrays
     PropertyContainer(const PropertyContainer& rhs) { operator=(rhs); }
@@ -203,7 +1527,44 @@ public:
             parrays_.resize(rhs.n_properties());
             size_ = rhs.size();
             for (size_t i = 0; i < parrays_.size(); ++i)
+            {
                 parrays_[i] = rhs.parrays_[i]->clone();
+                if (delta_)
+                    delta_->added.push_back(parrays_[i]->name());
+            }
+            keys_ = rhs.keys_;
+            clock_.reset();
+        }
+        return *this;
+    }
+
+    // move constructor: takes over the property arrays, rhs is left empty
+    PropertyContainer(PropertyContainer&& rhs) noexcept
+        : parrays_(std::move(rhs.parrays_)),
+          keys_(std::move(rhs.keys_)),
+          clock_(std::move(rhs.clock_)),
+          delta_(std::move(rhs.delta_)),
+          size_(rhs.size_)
+    {
+        rhs.parrays_.clear();
+        rhs.keys_.clear();
+        rhs.clock_.reset();
+        rhs.size_ = 0;
+    }
+
+    // move assignment: takes over the property arrays, rhs is left empty
+    PropertyContainer& operator=(PropertyContainer&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            delta_.reset();
+            clear();
+            parrays_.swap(rhs.parrays_);
+            keys_.swap(rhs.keys_);
+            clock_.swap(rhs.clock_);
+            delta_.swap(rhs.delta_);
+            size_ = rhs.size_;
+            rhs.size_ = 0;
         }
         return *this;
     }
@@ -214,6 +1575,27 @@ public:
     // returns the number of property arrays
     size_t n_properties() const { return parrays_.size(); }
 
+    // returns the property arrays of this container
+    const std::vector<BasePropertyArray*>& arrays() const { return parrays_; }
+
+    // track changes of all current and future arrays using \p clock, a null
+    // clock disables tracking
+    void track_changes(std::shared_ptr<const std::atomic<uint64_t>> clock)
+    {
+        clock_ = clock;
+        for (auto a : parrays_)
+            a->track_changes(clock_, size_);
+    }
+
+    // returns the memory used by each property array
+    std::vector<PropertyMemory> memory_usage() const
+    {
+        std::vector<PropertyMemory> usage;
+        for (size_t i = 0; i < parrays_.size(); ++i)
+            usage.push_back(parrays_[i]->memory_usage());
+        return usage;
+    }
+
     // returns a vector of all property names
     std::vector<std::string> properties() const
     {
@@ -242,10 +1624,24 @@ public:
         // otherwise add the property
         PropertyArray<T>* p = new PropertyArray<T>(name, t);
         p->resize(size_);
-        parrays_.push_back(p);
+        insert(std::unique_ptr<BasePropertyArray>(p), parrays_.size());
         return Property<T>(p);
     }
 
+    // insert array \p a at position \p i, e.g., a clone of another
+    // container's array. the array needs to have size() elements and a name
+    // that does not exist yet.
+    void insert(std::unique_ptr<BasePropertyArray> a, size_t i)
+    {
+        assert(!exists(a->name()));
+        BasePropertyArray* p = a.release();
+        p->track_changes(clock_, size_);
+        parrays_.insert(parrays_.begin() + std::min(i, parrays_.size()), p);
+        if (delta_)
+            delta_->added.push_back(p->name());
+        update_keys();
+    }
+
     // do we have a property with a given name?
     bool exists(const std::string& name) const
     {
@@ -255,6 +1651,13 @@ public:
         return false;
     }
 
+    // do we have a property with a given key? logarithmic in the number of
+    // properties.
+    bool exists(const PropertyKey& key) const
+    {
+        return find(key.id()) != 0;
+    }
+
     // get a property by its name. returns invalid property if it does not exist.
     template <class T>
     Property<T> get(const std::string& name) const
@@ -266,6 +1669,30 @@ public:
         return Property<T>();
     }
 
+    // get a property by its key without comparing names. returns invalid
+    // property if it does not exist or if the type does not match.
+    template <class T>
+    Property<T> get(const PropertyKey& key) const
+    {
+        const size_t i = find(key.id());
+        if (!i)
+            return Property<T>();
+        BasePropertyArray* p = parrays_[i - 1];
+        if (p->type() != typeid(T))
+            return Property<T>();
+        return Property<T>(static_cast<PropertyArray<T>*>(p));
+    }
+
+    // returns a property if it exists, otherwise it creates it first.
+    template <class T>
+    Property<T> get_or_add(const PropertyKey& key, const T t = T())
+    {
+        Property<T> p = get<T>(key);
+        if (!p && !exists(key))
+            p = add<T>(key.name(), t);
+        return p;
+    }
+
     // returns a property if it exists, otherwise it creates it first.
     template <class T>
     Property<T> get_or_add(const std::string& name, const T t = T())
@@ -295,23 +1722,83 @@ public:
         {
             if (*it == h.parray_)
             {
-                delete *it;
-                parrays_.erase(it);
+                erase(it - parrays_.begin());
                 h.reset();
+                update_keys();
                 break;
             }
         }
     }
 
+    // delete the property array named \p name, if it exists
+    void remove(const std::string& name)
+    {
+        for (size_t i = 0; i < parrays_.size(); ++i)
+            if (parrays_[i]->name() == name)
+            {
+                erase(i);
+                update_keys();
+                break;
+            }
+    }
+
     // delete all properties
     void clear()
     {
-        for (size_t i = 0; i < parrays_.size(); ++i)
-            delete parrays_[i];
-        parrays_.clear();
+        for (size_t i = parrays_.size(); i > 0; --i)
+            erase(i - 1);
+        keys_.clear();
         size_ = 0;
     }
 
+    // start saving the old values of all arrays and the removed arrays, see
+    // SurfaceMeshHistory
+    void begin_delta()
+    {
+        delta_.reset(new PropertyContainerDelta);
+        delta_->size = size_;
+        for (auto a : parrays_)
+            a->begin_delta();
+    }
+
+    // are old values being saved?
+    bool records_delta() const { return delta_ != nullptr; }
+
+    // stop saving and return the old state
+    std::unique_ptr<PropertyContainerDelta> end_delta()
+    {
+        assert(delta_);
+        for (auto a : parrays_)
+            if (a->records_delta())
+                if (auto d = a->end_delta())
+                    delta_->arrays.emplace_back(a->name(), std::move(d));
+        return std::move(delta_);
+    }
+
+    // restore the old state saved in \p delta, taking over its removed
+    // arrays. modifications are recorded as usual.
+    void apply_delta(PropertyContainerDelta& delta)
+    {
+        for (const auto& name : delta.added)
+            remove(name);
+        for (auto r = delta.removed.rbegin(); r != delta.removed.rend(); ++r)
+        {
+            // replace a property added again after the recording
+            remove(r->second->name());
+            insert(std::move(r->second), r->first);
+        }
+        delta.removed.clear();
+
+        resize(delta.size);
+        for (const auto& a : delta.arrays)
+            for (auto p : parrays_)
+                if (p->name() == a.first)
+                {
+                    p->apply_delta(*a.second);
+                    break;
+                }
+    }
+
     // reserve memory for n entries in all arrays
     void reserve(size_t n) const
     {
@@ -342,6 +1829,13 @@ public:
         ++size_;
     }
 
+    // reset element i to its default value in all arrays
+    void reset(size_t i) const
+    {
+        for (size_t j = 0; j < parrays_.size(); ++j)
+            parrays_[j]->reset(i);
+    }
+
     // swap elements i0 and i1 in all arrays
     void swap(size_t i0, size_t i1) const
     {
@@ -350,7 +1844,63 @@ public:
     }
 
 private:
+    // delete array i, or keep it with its old values while recording
+    void erase(size_t i)
+    {
+        BasePropertyArray* a = parrays_[i];
+        parrays_.erase(parrays_.begin() + i);
+        if (!delta_)
+        {
+            delete a;
+            return;
+        }
+
+        if (!a->records_delta())
+        {
+            // added while recording
+            auto& added = delta_->added;
+            auto it = std::find(added.begin(), added.end(), a->name());
+            if (it != added.end())
+                added.erase(it);
+            delete a;
+            return;
+        }
+
+        if (auto d = a->end_delta())
+            a->apply_delta(*d);
+        delta_->removed.emplace_back(i, std::unique_ptr<BasePropertyArray>(a));
+    }
+
+    // rebuild the key table after adding or removing a property
+    void update_keys()
+    {
+        keys_.resize(parrays_.size());
+        for (size_t i = 0; i < parrays_.size(); ++i)
+            keys_[i] = std::make_pair(parrays_[i]->key(), i + 1);
+        std::sort(keys_.begin(), keys_.end());
+    }
+
+    // array index plus one of the property with key ID \p id, or zero
+    size_t find(size_t id) const
+    {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(),
+                                   std::make_pair(id, size_t(0)));
+        return it != keys_.end() && it->first == id ? it->second : 0;
+    }
+
     std::vector<BasePropertyArray*> parrays_;
+
+    // (key ID, array index plus one) of each property, sorted by key ID.
+    // holds only this container's keys, independent of how many names are
+    // registered in total.
+    std::vector<std::pair<size_t, size_t>> keys_;
+
+    // generation counter for change tracking, null if disabled
+    std::shared_ptr<const std::atomic<uint64_t>> clock_;
+
+    // old state saved while recording, null if not recording
+    std::unique_ptr<PropertyContainerDelta> delta_;
+
     size_t size_;
 };
 
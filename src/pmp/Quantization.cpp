@@ -0,0 +1,151 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/Quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace pmp {
+
+uint16_t Half::from_float(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    const uint32_t sign = (x >> 16) & 0x8000;
+    const uint32_t abs = x & 0x7fffffff;
+
+    // NaN and infinity
+    if (abs >= 0x7f800000)
+        return uint16_t(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+
+    // overflow to infinity
+    if (abs >= 0x477ff000)
+        return uint16_t(sign | 0x7c00);
+
+    // subnormal or zero: shift the mantissa including the implicit bit
+    if (abs < 0x38800000)
+    {
+        if (abs < 0x33000000)
+            return uint16_t(sign);
+        const uint32_t exponent = abs >> 23;
+        const uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        uint32_t h = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t half = 1u << (shift - 1);
+        if (rest > half || (rest == half && (h & 1)))
+            ++h;
+        return uint16_t(sign | h);
+    }
+
+    // normal: rebias exponent and round the mantissa to nearest even
+    uint32_t h = ((abs - 0x38000000) >> 13);
+    const uint32_t rest = abs & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        ++h;
+    return uint16_t(sign | h);
+}
+
+float Half::to_float(uint16_t h)
+{
+    const uint32_t sign = uint32_t(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+
+    uint32_t x;
+    if (exponent == 0x1f)
+    {
+        // NaN and infinity
+        x = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            x = sign;
+        }
+        else
+        {
+            // subnormal: normalize the mantissa
+            int e = -1;
+            do
+            {
+                ++e;
+                mantissa <<= 1;
+            } while (!(mantissa & 0x400));
+            x = sign | uint32_t(112 - e) << 23 | (mantissa & 0x3ff) << 13;
+        }
+    }
+    else
+    {
+        x = sign | (exponent + 112) << 23 | mantissa << 13;
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+namespace {
+
+inline Scalar sign_not_zero(Scalar x) { return x < 0 ? Scalar(-1) : Scalar(1); }
+
+inline int16_t to_snorm16(Scalar x)
+{
+    x = std::min(std::max(x, Scalar(-1)), Scalar(1));
+    return int16_t(std::lround(x * Scalar(32767)));
+}
+
+} // namespace
+
+void OctNormal::encode(const Normal& n)
+{
+    const Scalar l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    Scalar x = l1 > 0 ? n[0] / l1 : 0;
+    Scalar y = l1 > 0 ? n[1] / l1 : 0;
+
+    // fold the lower hemisphere onto the upper one
+    if (l1 > 0 && n[2] < 0)
+    {
+        const Scalar fx = (1 - std::abs(y)) * sign_not_zero(x);
+        const Scalar fy = (1 - std::abs(x)) * sign_not_zero(y);
+        x = fx;
+        y = fy;
+    }
+
+    u = to_snorm16(x);
+    v = to_snorm16(y);
+}
+
+OctNormal::operator Normal() const
+{
+    Scalar x = u / Scalar(32767);
+    Scalar y = v / Scalar(32767);
+    const Scalar z = 1 - std::abs(x) - std::abs(y);
+
+    if (z < 0)
+    {
+        const Scalar fx = (1 - std::abs(y)) * sign_not_zero(x);
+        const Scalar fy = (1 - std::abs(x)) * sign_not_zero(y);
+        x = fx;
+        y = fy;
+    }
+
+    return normalize(Normal(x, y, z));
+}
+
+Color8::Color8(const Color& c)
+{
+    auto quantize = [](Scalar x) {
+        x = std::min(std::max(x, Scalar(0)), Scalar(1));
+        return uint8_t(std::lround(x * Scalar(255)));
+    };
+    r = quantize(c[0]);
+    g = quantize(c[1]);
+    b = quantize(c[2]);
+}
+
+} // namespace pmp
@@ -0,0 +1,182 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "pmp/Parallel.h"
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \addtogroup core
+//!@{
+
+//! \brief IEEE 754 half-precision floating point number for compact storage.
+//! \details Only provides conversion from and to \c float, arithmetic has to
+//! be done after conversion. Has 11 significant bits and a range of
+//! +-65504. Conversion rounds to nearest even.
+class Half
+{
+public:
+    //! construct zero
+    Half() : bits_(0) {}
+
+    //! convert from float
+    explicit Half(float f) : bits_(from_float(f)) {}
+
+    //! convert to float
+    operator float() const { return to_float(bits_); }
+
+    //! the binary16 representation
+    uint16_t bits() const { return bits_; }
+
+    //! convert \p f to its binary16 representation
+    static uint16_t from_float(float f);
+
+    //! convert the binary16 representation \p h to float
+    static float to_float(uint16_t h);
+
+private:
+    uint16_t bits_;
+};
+
+//! \brief Unit normal in 32 bit octahedral encoding.
+//! \details Projects the normal onto the octahedron and stores the two
+//! coordinates as 16 bit signed normalized integers. The angular error is
+//! below 0.01 degrees.
+struct OctNormal
+{
+    //! construct from +z
+    OctNormal() { encode(Normal(0, 0, 1)); }
+
+    //! encode normal \p n, which does not have to be unit length
+    explicit OctNormal(const Normal& n) { encode(n); }
+
+    //! decode to a unit normal
+    operator Normal() const;
+
+    //! encode normal \p n
+    void encode(const Normal& n);
+
+    int16_t u, v;
+};
+
+//! \brief RGB color with 8 bits per channel.
+//! \details Channels are clamped to [0,1] and rounded to the nearest of 256
+//! levels.
+struct Color8
+{
+    //! construct black
+    Color8() : r(0), g(0), b(0) {}
+
+    //! encode color \p c
+    explicit Color8(const Color& c);
+
+    //! decode to a color with channels in [0,1]
+    operator Color() const
+    {
+        return Color(r / Scalar(255), g / Scalar(255), b / Scalar(255));
+    }
+
+    uint8_t r, g, b;
+};
+
+//! Texture coordinate stored in half precision.
+struct HalfTexCoord
+{
+    //! construct (0,0)
+    HalfTexCoord() {}
+
+    //! encode texture coordinate \p t
+    explicit HalfTexCoord(const TexCoord& t) : u(float(t[0])), v(float(t[1]))
+    {
+    }
+
+    //! decode to a full precision texture coordinate
+    operator TexCoord() const { return TexCoord(float(u), float(v)); }
+
+    Half u, v;
+};
+
+//! \brief Copy property \p prop to a new property \p name of type \p To.
+//! \details Each value is converted by the explicit constructor of \p To.
+//! Use, e.g., OctNormal for normals, Color8 for colors, HalfTexCoord for
+//! texture coordinates, or \c vec3 to store double precision positions in
+//! single precision. Converting back, e.g., to Normal, restores a full
+//! precision property for algorithms.
+//! \throw InvalidInputException if a property named \p name exists.
+template <class To, class From>
+VertexProperty<To> convert_property(SurfaceMesh& mesh,
+                                    VertexProperty<From> prop,
+                                    const std::string& name);
+
+//! \copydoc convert_property(SurfaceMesh&,VertexProperty<From>,const std::string&)
+template <class To, class From>
+HalfedgeProperty<To> convert_property(SurfaceMesh& mesh,
+                                      HalfedgeProperty<From> prop,
+                                      const std::string& name);
+
+//! \copydoc convert_property(SurfaceMesh&,VertexProperty<From>,const std::string&)
+template <class To, class From>
+FaceProperty<To> convert_property(SurfaceMesh& mesh, FaceProperty<From> prop,
+                                  const std::string& name);
+
+//!@}
+
+namespace detail {
+
+// convert all values of src into dst, both have the same size. element
+// access does not pin the arrays, see PropertyArray::vector().
+template <class To, class From>
+void convert_values(const Property<From>& src, Property<To> dst)
+{
+    parallel_for(0, int(src.size()), [&](int i) { dst[i] = To(src[i]); });
+}
+
+inline void check_new_property(bool exists, const std::string& name)
+{
+    if (exists)
+    {
+        auto what = "convert_property: Property " + name + " exists.";
+        throw InvalidInputException(what);
+    }
+}
+
+} // namespace detail
+
+template <class To, class From>
+VertexProperty<To> convert_property(SurfaceMesh& mesh,
+                                    VertexProperty<From> prop,
+                                    const std::string& name)
+{
+    detail::check_new_property(mesh.has_vertex_property(name), name);
+    auto result = mesh.add_vertex_property<To>(name);
+    detail::convert_values<To, From>(prop, result);
+    return result;
+}
+
+template <class To, class From>
+HalfedgeProperty<To> convert_property(SurfaceMesh& mesh,
+                                      HalfedgeProperty<From> prop,
+                                      const std::string& name)
+{
+    detail::check_new_property(mesh.has_halfedge_property(name), name);
+    auto result = mesh.add_halfedge_property<To>(name);
+    detail::convert_values<To, From>(prop, result);
+    return result;
+}
+
+template <class To, class From>
+FaceProperty<To> convert_property(SurfaceMesh& mesh, FaceProperty<From> prop,
+                                  const std::string& name)
+{
+    detail::check_new_property(mesh.has_face_property(name), name);
+    auto result = mesh.add_face_property<To>(name);
+    detail::convert_values<To, From>(prop, result);
+    return result;
+}
+
+} // namespace pmp
@@ -0,0 +1,519 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/StreamingMesh.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace pmp {
+
+namespace {
+
+const char binary_magic[4] = {'S', 'M', 'B', '1'};
+
+template <typename T>
+void write_value(FILE* out, const T& t)
+{
+    fwrite(&t, sizeof(T), 1, out);
+}
+
+} // namespace
+
+StreamingMeshReader::StreamingMeshReader(const std::string& filename)
+    : StreamingMeshReader(fopen(filename.c_str(), "rb"))
+{
+    if (!in_)
+        throw IOException("Failed to open file: " + filename);
+    owns_file_ = true;
+}
+
+StreamingMeshReader::StreamingMeshReader(FILE* in)
+    : in_(in),
+      owns_file_(false),
+      binary_(false),
+      at_end_(false),
+      push_(false),
+      format_detected_(true),
+      input_closed_(false),
+      input_pos_(0),
+      queue_head_(0),
+      erase_vertex_(false),
+      vertex_(PMP_MAX_INDEX),
+      n_vertices_(0),
+      n_faces_(0),
+      max_active_(0),
+      line_(256)
+{
+    if (in_)
+        detect_format();
+}
+
+StreamingMeshReader::StreamingMeshReader()
+    : StreamingMeshReader(static_cast<FILE*>(nullptr))
+{
+    push_ = true;
+    format_detected_ = false;
+}
+
+StreamingMeshReader::~StreamingMeshReader()
+{
+    if (owns_file_ && in_)
+        fclose(in_);
+}
+
+void StreamingMeshReader::append(const void* data, size_t size)
+{
+    if (!push_ || input_closed_)
+        throw InvalidInputException("Cannot append to streaming mesh input");
+
+    // drop the records read so far
+    if (input_pos_ > input_.size() / 2)
+    {
+        input_.erase(input_.begin(), input_.begin() + input_pos_);
+        input_pos_ = 0;
+    }
+    const char* bytes = static_cast<const char*>(data);
+    input_.insert(input_.end(), bytes, bytes + size);
+}
+
+void StreamingMeshReader::detect_format()
+{
+    if (push_)
+    {
+        const size_t n = input_.size() - input_pos_;
+        if (n == 0 || input_[input_pos_] != binary_magic[0])
+            return;
+        if (n < 4 || memcmp(&input_[input_pos_], binary_magic, 4) != 0)
+            throw IOException("Unknown streaming mesh format");
+        input_pos_ += 4;
+        binary_ = true;
+        return;
+    }
+
+    // ASCII files start with a record tag, a comment, or white space
+    const int c = getc(in_);
+    if (c == EOF)
+        return;
+    if (c != binary_magic[0])
+    {
+        ungetc(c, in_);
+        return;
+    }
+
+    char magic[3];
+    if (fread(magic, 1, 3, in_) != 3 ||
+        memcmp(magic, binary_magic + 1, 3) != 0)
+        throw IOException("Unknown streaming mesh format");
+    binary_ = true;
+}
+
+StreamingMeshReader::Event StreamingMeshReader::next()
+{
+    if (erase_vertex_)
+    {
+        active_.erase(vertex_);
+        erase_vertex_ = false;
+    }
+
+    // report the vertices finalized by the last face first
+    if (queue_head_ < finalize_queue_.size())
+    {
+        vertex_ = finalize_queue_[queue_head_++];
+        erase_vertex_ = true;
+        return Event::Finalize;
+    }
+    finalize_queue_.clear();
+    queue_head_ = 0;
+
+    if (at_end_)
+        return Event::End;
+
+    const Event event = read_record();
+    if (event != Event::End)
+        return event;
+
+    // finalize the remaining vertices in the order they were read
+    at_end_ = true;
+    for (const auto& v : active_)
+        finalize_queue_.push_back(v.first);
+    std::sort(finalize_queue_.begin(), finalize_queue_.end());
+    return next();
+}
+
+const Point& StreamingMeshReader::position(IndexType v) const
+{
+    const auto it = active_.find(v);
+    if (it == active_.end())
+        throw InvalidInputException("Vertex is not active");
+    return it->second;
+}
+
+bool StreamingMeshReader::read_bytes(void* data, size_t size)
+{
+    if (!push_)
+        return fread(data, 1, size, in_) == size;
+    if (input_.size() - input_pos_ < size)
+        return false;
+    memcpy(data, input_.data() + input_pos_, size);
+    input_pos_ += size;
+    return true;
+}
+
+size_t StreamingMeshReader::read_line()
+{
+    size_t length = 0;
+    if (!push_)
+    {
+        // read a complete line, growing the buffer as needed
+        while (fgets(line_.data() + length, int(line_.size() - length), in_))
+        {
+            length += strlen(line_.data() + length);
+            if (length && line_[length - 1] == '\n')
+                break;
+            if (length + 1 < line_.size())
+                break; // last line without newline
+            line_.resize(2 * line_.size());
+        }
+        if (length == 0 && ferror(in_))
+            throw IOException("Failed to read streaming mesh");
+        return length;
+    }
+
+    // up to the next newline, or the rest of the closed input
+    const size_t n = input_.size() - input_pos_;
+    if (n == 0)
+        return 0;
+    const char* begin = input_.data() + input_pos_;
+    const void* newline = memchr(begin, '\n', n);
+    length = newline ? static_cast<const char*>(newline) - begin + 1 : n;
+    if (line_.size() <= length)
+        line_.resize(length + 1);
+    memcpy(line_.data(), begin, length);
+    line_[length] = '\0';
+    input_pos_ += length;
+    return length;
+}
+
+bool StreamingMeshReader::record_available()
+{
+    if (!format_detected_)
+    {
+        if (input_.size() - input_pos_ < 4 && !input_closed_)
+            return false;
+        detect_format();
+        format_detected_ = true;
+    }
+    if (input_closed_)
+        return true;
+
+    const size_t n = input_.size() - input_pos_;
+    const char* s = input_.data() + input_pos_;
+    if (!binary_)
+        return n && memchr(s, '\n', n);
+
+    // the size of the record follows from its tag and the valence of faces
+    if (n == 0)
+        return false;
+    size_t size = 1;
+    if (s[0] == 'v')
+        size += 3 * sizeof(float);
+    else if (s[0] == 'x')
+        size += sizeof(int32_t);
+    else if (s[0] == 'f')
+    {
+        size += sizeof(int32_t);
+        if (n < size)
+            return false;
+        int32_t valence;
+        memcpy(&valence, s + 1, sizeof(valence));
+        if (valence >= 3)
+            size += valence * sizeof(int32_t);
+    }
+    return n >= size;
+}
+
+StreamingMeshReader::Event StreamingMeshReader::read_record()
+{
+    if (push_ && !record_available())
+        return Event::Pending;
+
+    const Event event = binary_ ? read_binary_record() : read_ascii_record();
+    if (event == Event::Vertex)
+    {
+        vertex_ = IndexType(n_vertices_++);
+        max_active_ = std::max(max_active_, active_.size());
+    }
+    else if (event == Event::Face)
+        ++n_faces_;
+    return event;
+}
+
+StreamingMeshReader::Event StreamingMeshReader::read_ascii_record()
+{
+    if (!in_ && !push_)
+        return Event::End;
+
+    while (true)
+    {
+        // skipped comments may leave no complete line
+        if (push_ && !record_available())
+            return Event::Pending;
+        if (read_line() == 0)
+            return Event::End;
+
+        char* s = line_.data();
+        while (*s == ' ' || *s == '\t')
+            ++s;
+        const char tag = *s++;
+
+        if (tag == 'v')
+        {
+            Point p;
+            for (int i = 0; i < 3; ++i)
+            {
+                char* end;
+                p[i] = Scalar(strtod(s, &end));
+                if (end == s)
+                    throw IOException("Invalid vertex in streaming mesh");
+                s = end;
+            }
+            active_[IndexType(n_vertices_)] = p;
+            return Event::Vertex;
+        }
+        else if (tag == 'f')
+        {
+            face_.clear();
+            while (true)
+            {
+                char* end;
+                errno = 0;
+                const long index = strtol(s, &end, 10);
+                if (end == s)
+                    break;
+                if (errno == ERANGE)
+                    throw IOException("Invalid face in streaming mesh");
+                add_face_index(index);
+                s = end;
+            }
+            if (face_.size() < 3)
+                throw IOException("Invalid face in streaming mesh");
+            return Event::Face;
+        }
+        else if (tag == 'x')
+        {
+            char* end;
+            const long index = strtol(s, &end, 10);
+            if (end == s || index <= 0 || size_t(index) > n_vertices_ ||
+                !active_.count(IndexType(index - 1)))
+                throw IOException("Invalid finalization in streaming mesh");
+            finalize_queue_.push_back(IndexType(index - 1));
+            return next();
+        }
+        else if (tag != '#' && tag != '\n' && tag != '\r' && tag != '\0')
+            throw IOException("Invalid record in streaming mesh");
+    }
+}
+
+StreamingMeshReader::Event StreamingMeshReader::read_binary_record()
+{
+    char tag;
+    if (!read_value(tag))
+    {
+        if (!push_ && ferror(in_))
+            throw IOException("Failed to read streaming mesh");
+        return Event::End;
+    }
+
+    if (tag == 'v')
+    {
+        float x[3];
+        if (!read_bytes(x, sizeof(x)))
+            throw IOException("Truncated streaming mesh");
+        active_[IndexType(n_vertices_)] = Point(x[0], x[1], x[2]);
+        return Event::Vertex;
+    }
+    else if (tag == 'f')
+    {
+        int32_t valence;
+        if (!read_value(valence) || valence < 3)
+            throw IOException("Invalid face in streaming mesh");
+        face_.clear();
+        for (int32_t i = 0; i < valence; ++i)
+        {
+            int32_t index;
+            if (!read_value(index))
+                throw IOException("Truncated streaming mesh");
+            add_face_index(index);
+        }
+        return Event::Face;
+    }
+    else if (tag == 'x')
+    {
+        int32_t index;
+        if (!read_value(index) || index <= 0 ||
+            size_t(index) > n_vertices_ ||
+            !active_.count(IndexType(index - 1)))
+            throw IOException("Invalid finalization in streaming mesh");
+        finalize_queue_.push_back(IndexType(index - 1));
+        return next();
+    }
+    throw IOException("Invalid record in streaming mesh");
+}
+
+void StreamingMeshReader::add_face_index(long index)
+{
+    const bool finalize = index < 0;
+    const size_t i = size_t(finalize ? -index : index);
+    if (i == 0 || i > n_vertices_ || !active_.count(IndexType(i - 1)))
+        throw IOException("Face references inactive vertex " +
+                          std::to_string(i));
+    face_.push_back(IndexType(i - 1));
+    if (finalize)
+        finalize_queue_.push_back(IndexType(i - 1));
+}
+
+StreamingMeshWriter::StreamingMeshWriter(const std::string& filename,
+                                         bool binary)
+    : StreamingMeshWriter(fopen(filename.c_str(), binary ? "wb" : "w"),
+                          binary)
+{
+    if (!out_)
+        throw IOException("Failed to open file: " + filename);
+    owns_file_ = true;
+}
+
+StreamingMeshWriter::StreamingMeshWriter(FILE* out, bool binary)
+    : out_(out),
+      owns_file_(false),
+      binary_(binary),
+      failed_(false),
+      n_vertices_(0)
+{
+    if (!out_)
+        return;
+    if (binary_)
+        fwrite(binary_magic, 1, 4, out_);
+    else
+        fprintf(out_, "# streaming mesh\n");
+}
+
+StreamingMeshWriter::~StreamingMeshWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (const IOException&)
+    {
+    }
+}
+
+IndexType StreamingMeshWriter::add_vertex(const Point& p)
+{
+    write_face();
+    if (binary_)
+    {
+        write_value(out_, 'v');
+        const float x[3] = {float(p[0]), float(p[1]), float(p[2])};
+        fwrite(x, sizeof(float), 3, out_);
+    }
+    else
+        fprintf(out_, "v %.9g %.9g %.9g\n", double(p[0]), double(p[1]),
+                double(p[2]));
+    return n_vertices_++;
+}
+
+void StreamingMeshWriter::add_face(const std::vector<IndexType>& vertices)
+{
+    for (auto v : vertices)
+        if (v >= n_vertices_)
+            throw InvalidInputException("Face references unknown vertex");
+    if (vertices.size() < 3)
+        throw InvalidInputException("Face needs at least three vertices");
+
+    write_face();
+    face_ = vertices;
+    finalized_.assign(face_.size(), false);
+}
+
+void StreamingMeshWriter::finalize(IndexType v)
+{
+    if (v >= n_vertices_)
+        throw InvalidInputException("Finalizing unknown vertex");
+
+    // tag the vertex in the last face if possible
+    const auto it = std::find(face_.begin(), face_.end(), v);
+    if (it != face_.end())
+    {
+        finalized_[it - face_.begin()] = true;
+        return;
+    }
+    write_finalize(v);
+}
+
+void StreamingMeshWriter::close()
+{
+    if (!out_)
+        return;
+    write_face();
+    check_error();
+
+    FILE* out = out_;
+    out_ = nullptr;
+    if (owns_file_ ? fclose(out) != 0 : fflush(out) != 0)
+        failed_ = true;
+    if (failed_)
+        throw IOException("Failed to write streaming mesh");
+}
+
+void StreamingMeshWriter::write_face()
+{
+    if (face_.empty())
+        return;
+
+    if (binary_)
+    {
+        write_value(out_, 'f');
+        write_value(out_, int32_t(face_.size()));
+        for (size_t i = 0; i < face_.size(); ++i)
+        {
+            const auto index = int32_t(face_[i] + 1);
+            write_value(out_, finalized_[i] ? -index : index);
+        }
+    }
+    else
+    {
+        fputc('f', out_);
+        for (size_t i = 0; i < face_.size(); ++i)
+        {
+            const auto index = (long long)(face_[i] + 1);
+            fprintf(out_, " %lld", finalized_[i] ? -index : index);
+        }
+        fputc('\n', out_);
+    }
+    face_.clear();
+    check_error();
+}
+
+void StreamingMeshWriter::write_finalize(IndexType v)
+{
+    if (binary_)
+    {
+        write_value(out_, 'x');
+        write_value(out_, int32_t(v + 1));
+    }
+    else
+        fprintf(out_, "x %lld\n", (long long)(v + 1));
+}
+
+void StreamingMeshWriter::check_error()
+{
+    if (out_ && ferror(out_))
+        failed_ = true;
+}
+
+} // namespace pmp
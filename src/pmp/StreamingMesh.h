@@ -0,0 +1,216 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+//! \brief Sequential reader of streaming meshes.
+//! \details Streaming meshes interleave vertices and faces such that faces
+//! follow their vertices closely, and they tag the last reference to each
+//! vertex. Only the vertices between their first and last reference are
+//! kept in memory, which allows processing meshes larger than the main
+//! memory \cite isenburg_2005_streaming.
+//!
+//! The ASCII format (.sma) consists of the lines
+//!
+//! \li `v x y z`: a vertex, numbered consecutively from 1,
+//! \li `f i j k ...`: a face referencing earlier vertices, a negative index
+//! `-i` finalizes vertex `i`, i.e., no later face references it,
+//! \li `x i`: finalization of vertex `i` independent of a face,
+//!
+//! and comments starting with `#`. The binary format (.smb) starts with
+//! `SMB1` and stores the same records in native byte order: a tag byte
+//! `v`, `f`, or `x`, followed by three 32 bit floats, by a 32 bit valence
+//! and that many signed 32 bit indices, or by one signed 32 bit index,
+//! respectively.
+//!
+//! Vertices that are not finalized until the end of the stream are
+//! finalized there.
+//!
+//! Besides files, the reader parses data passed to append() piece by
+//! piece, e.g., while a file is downloaded, such that each prefix of the
+//! stream can be processed as soon as it arrives.
+//! \ingroup core
+class StreamingMeshReader
+{
+public:
+    //! elements of the stream returned by next()
+    enum class Event
+    {
+        Vertex,   //!< a new vertex, see vertex()
+        Face,     //!< a new face, see face()
+        Finalize, //!< the vertex() is referenced for the last time
+        End,      //!< end of the stream
+        Pending   //!< no complete record was appended yet, see append()
+    };
+
+    //! \brief Open \p filename.
+    //! \throw IOException if the file cannot be opened.
+    explicit StreamingMeshReader(const std::string& filename);
+
+    //! \brief Read from \p in, which stays open after reading.
+    explicit StreamingMeshReader(FILE* in);
+
+    //! \brief Read the data passed to append().
+    //! \details next() returns Event::Pending if the appended data holds no
+    //! complete record, until close_input() is called.
+    StreamingMeshReader();
+
+    ~StreamingMeshReader();
+
+    StreamingMeshReader(const StreamingMeshReader&) = delete;
+    StreamingMeshReader& operator=(const StreamingMeshReader&) = delete;
+
+    //! \brief Read the next element.
+    //! \details The position of a finalized vertex is available until the
+    //! next call.
+    //! \throw IOException if the stream is corrupt or references vertices
+    //! that are not active.
+    Event next();
+
+    //! \brief Append the next \p size bytes of the stream.
+    //! \details Records may be split arbitrarily between calls.
+    //! \throw InvalidInputException if the reader reads a file or the input
+    //! was closed.
+    void append(const void* data, size_t size);
+
+    //! \brief Declare the end of the appended data.
+    //! \details Remaining incomplete records are reported as truncated.
+    void close_input() { input_closed_ = true; }
+
+    //! index of the vertex of the last Vertex or Finalize event
+    IndexType vertex() const { return vertex_; }
+
+    //! zero-based vertex indices of the face of the last Face event
+    const std::vector<IndexType>& face() const { return face_; }
+
+    //! \brief Position of the active vertex \p v.
+    //! \throw InvalidInputException if \p v is not active.
+    const Point& position(IndexType v) const;
+
+    //! number of vertices read so far
+    size_t n_vertices() const { return n_vertices_; }
+
+    //! number of faces read so far
+    size_t n_faces() const { return n_faces_; }
+
+    //! number of vertices read but not finalized
+    size_t n_active_vertices() const { return active_.size(); }
+
+    //! maximum number of active vertices so far, the width of the stream
+    size_t max_active_vertices() const { return max_active_; }
+
+private:
+    // read the next vertex, face, or finalization record
+    Event read_record();
+    Event read_ascii_record();
+    Event read_binary_record();
+
+    // check and store a face index of the file
+    void add_face_index(long index);
+
+    void detect_format();
+
+    // read size bytes of the file or the appended data
+    bool read_bytes(void* data, size_t size);
+
+    template <typename T>
+    bool read_value(T& t)
+    {
+        return read_bytes(&t, sizeof(T));
+    }
+
+    // read the next line into line_ and return its length, 0 at the end
+    size_t read_line();
+
+    // does the appended data hold a complete record? detects the format
+    // once the first bytes are available.
+    bool record_available();
+
+    FILE* in_;
+    bool owns_file_;
+    bool binary_;
+    bool at_end_;
+
+    // data passed to append(), read from input_pos_
+    bool push_;
+    bool format_detected_;
+    bool input_closed_;
+    std::vector<char> input_;
+    size_t input_pos_;
+
+    std::unordered_map<IndexType, Point> active_;
+    std::vector<IndexType> finalize_queue_;
+    size_t queue_head_;
+    bool erase_vertex_; // erase vertex_ in the next call
+
+    IndexType vertex_;
+    std::vector<IndexType> face_;
+    size_t n_vertices_;
+    size_t n_faces_;
+    size_t max_active_;
+    std::vector<char> line_;
+};
+
+//! \brief Sequential writer of streaming meshes.
+//! \details See StreamingMeshReader for the file formats. Vertices get
+//! consecutive zero-based indices in the order they are added.
+//! \ingroup core
+class StreamingMeshWriter
+{
+public:
+    //! \brief Create \p filename, in binary format if \p binary is true.
+    //! \throw IOException if the file cannot be created.
+    explicit StreamingMeshWriter(const std::string& filename,
+                                 bool binary = false);
+
+    //! \brief Write to \p out, which stays open after close().
+    explicit StreamingMeshWriter(FILE* out, bool binary = false);
+
+    //! calls close(), ignoring errors
+    ~StreamingMeshWriter();
+
+    StreamingMeshWriter(const StreamingMeshWriter&) = delete;
+    StreamingMeshWriter& operator=(const StreamingMeshWriter&) = delete;
+
+    //! add a vertex at \p p and return its index
+    IndexType add_vertex(const Point& p);
+
+    //! \brief Add a face of earlier, not finalized vertices.
+    //! \throw InvalidInputException if a vertex was not added before.
+    void add_face(const std::vector<IndexType>& vertices);
+
+    //! \brief Declare that no later face references vertex \p v.
+    //! \details Tags \p v in the last face if it belongs to it.
+    void finalize(IndexType v);
+
+    //! \brief Flush and close the stream.
+    //! \throw IOException if writing fails.
+    void close();
+
+private:
+    void write_face();
+    void write_finalize(IndexType v);
+    void check_error();
+
+    FILE* out_;
+    bool owns_file_;
+    bool binary_;
+    bool failed_;
+    IndexType n_vertices_;
+
+    // the last face, written when the next element is added, and which of
+    // its corners are tagged as finalized
+    std::vector<IndexType> face_;
+    std::vector<bool> finalized_;
+};
+
+} // namespace pmp
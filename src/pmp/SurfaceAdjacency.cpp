@@ -0,0 +1,63 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/SurfaceAdjacency.h"
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+SurfaceAdjacency::SurfaceAdjacency(const SurfaceMesh& mesh)
+{
+    const int nV(mesh.vertices_size()), nF(mesh.faces_size());
+
+    // count valences
+    vertex_offsets_.assign(nV + 1, 0);
+    face_offsets_.assign(nF + 1, 0);
+
+    parallel_for(0, nV, [&](int i) {
+        Vertex v(i);
+        if (!mesh.is_deleted(v) && !mesh.is_isolated(v))
+            vertex_offsets_[i + 1] = mesh.valence(v);
+    });
+
+    parallel_for(0, nF, [&](int i) {
+        Face f(i);
+        if (!mesh.is_deleted(f))
+            face_offsets_[i + 1] = mesh.valence(f);
+    });
+
+    // prefix sums give the start of each row
+    for (int i = 0; i < nV; ++i)
+        vertex_offsets_[i + 1] += vertex_offsets_[i];
+    for (int i = 0; i < nF; ++i)
+        face_offsets_[i + 1] += face_offsets_[i];
+
+    // fill rows
+    vertex_halfedges_.resize(vertex_offsets_[nV]);
+    vertex_vertices_.resize(vertex_offsets_[nV]);
+    vertex_faces_.resize(vertex_offsets_[nV]);
+    face_vertices_.resize(face_offsets_[nF]);
+
+    parallel_for(0, nV, [&](int i) {
+        size_t j = vertex_offsets_[i];
+        if (j == vertex_offsets_[i + 1])
+            return;
+        for (auto h : mesh.halfedges(Vertex(i)))
+        {
+            vertex_halfedges_[j] = h;
+            vertex_vertices_[j] = mesh.to_vertex(h);
+            vertex_faces_[j] = mesh.face(h);
+            ++j;
+        }
+    });
+
+    parallel_for(0, nF, [&](int i) {
+        size_t j = face_offsets_[i];
+        if (j == face_offsets_[i + 1])
+            return;
+        for (auto v : mesh.vertices(Face(i)))
+            face_vertices_[j++] = v;
+    });
+}
+
+} // namespace pmp
@@ -0,0 +1,104 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Immutable compressed-row snapshot of the adjacency of a SurfaceMesh.
+//! \details Stores the one-ring of every vertex and the vertices of every
+//! face in contiguous arrays, which avoids chasing halfedge pointers in
+//! read-only traversals. The one-ring of a vertex v lists its outgoing
+//! halfedges in the same counter-clockwise order as
+//! SurfaceMesh::halfedges(v), together with the aligned target vertices and
+//! faces. The snapshot is not updated when the mesh changes.
+//! \ingroup core
+class SurfaceAdjacency
+{
+public:
+    //! A contiguous range of elements of type \p T.
+    template <class T>
+    class Range
+    {
+    public:
+        Range(const T* begin, const T* end) : begin_(begin), end_(end) {}
+
+        const T* begin() const { return begin_; }
+        const T* end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+        const T& operator[](size_t i) const { return begin_[i]; }
+
+    private:
+        const T *begin_, *end_;
+    };
+
+    //! Build the adjacency of \p mesh. Deleted elements have empty ranges.
+    explicit SurfaceAdjacency(const SurfaceMesh& mesh);
+
+    //! outgoing halfedges of vertex \p v in counter-clockwise order
+    Range<Halfedge> vertex_halfedges(Vertex v) const
+    {
+        return range(vertex_halfedges_, vertex_offsets_, v.idx());
+    }
+
+    //! neighbors of vertex \p v, aligned with vertex_halfedges()
+    Range<Vertex> vertex_vertices(Vertex v) const
+    {
+        return range(vertex_vertices_, vertex_offsets_, v.idx());
+    }
+
+    //! \brief faces incident to vertex \p v, aligned with vertex_halfedges()
+    //! \details The face of a boundary halfedge is invalid.
+    Range<Face> vertex_faces(Vertex v) const
+    {
+        return range(vertex_faces_, vertex_offsets_, v.idx());
+    }
+
+    //! vertices of face \p f in the order of SurfaceMesh::vertices(f)
+    Range<Vertex> face_vertices(Face f) const
+    {
+        return range(face_vertices_, face_offsets_, f.idx());
+    }
+
+    //! number of neighbors of vertex \p v
+    size_t valence(Vertex v) const
+    {
+        return vertex_offsets_[v.idx() + 1] - vertex_offsets_[v.idx()];
+    }
+
+    //! number of vertices of face \p f
+    size_t valence(Face f) const
+    {
+        return face_offsets_[f.idx() + 1] - face_offsets_[f.idx()];
+    }
+
+    //! number of vertex slots, same as SurfaceMesh::vertices_size()
+    size_t vertices_size() const { return vertex_offsets_.size() - 1; }
+
+    //! number of face slots, same as SurfaceMesh::faces_size()
+    size_t faces_size() const { return face_offsets_.size() - 1; }
+
+private:
+    template <class T>
+    static Range<T> range(const std::vector<T>& data,
+                          const std::vector<size_t>& offsets, IndexType i)
+    {
+        const T* base = data.data();
+        return Range<T>(base + offsets[i], base + offsets[i + 1]);
+    }
+
+    std::vector<size_t> vertex_offsets_;
+    std::vector<Halfedge> vertex_halfedges_;
+    std::vector<Vertex> vertex_vertices_;
+    std::vector<Face> vertex_faces_;
+
+    std::vector<size_t> face_offsets_;
+    std::vector<Vertex> face_vertices_;
+};
+
+} // namespace pmp
@@ -4,8 +4,14 @@
 
 #include "pmp/SurfaceMesh.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
 
+#include "pmp/MemoryArena.h"
+#include "pmp/Parallel.h"
 #include "pmp/SurfaceMeshIO.h"
 
 namespace pmp {
@@ -29,6 +35,8 @@ SurfaceMesh::SurfaceMesh()
     deleted_edges_ = 0;
     deleted_faces_ = 0;
     has_garbage_ = false;
+    reuse_deleted_ = false;
+    edge_index_enabled_ = false;
 }
 
 SurfaceMesh::~SurfaceMesh() = default;
@@ -60,11 +68,80 @@ SurfaceMesh& SurfaceMesh::operator=(const SurfaceMesh& rhs)
         deleted_faces_ = rhs.deleted_faces_;
 
         has_garbage_ = rhs.has_garbage_;
+
+        reuse_deleted_ = rhs.reuse_deleted_;
+        free_vertices_ = rhs.free_vertices_;
+        free_edges_ = rhs.free_edges_;
+        free_faces_ = rhs.free_faces_;
+
+        edge_index_enabled_ = rhs.edge_index_enabled_;
+        edge_index_ = rhs.edge_index_;
+
+        set_change_tracking(rhs.change_tracking());
     }
 
     return *this;
 }
 
+SurfaceMesh::SurfaceMesh(SurfaceMesh&& rhs) : SurfaceMesh()
+{
+    swap(rhs);
+}
+
+SurfaceMesh& SurfaceMesh::operator=(SurfaceMesh&& rhs)
+{
+    if (this != &rhs)
+    {
+        // keep recording into our arrays, copies share the elements anyway.
+        // see SurfaceMeshHistory.
+        if (vprops_.records_delta())
+        {
+            operator=(static_cast<const SurfaceMesh&>(rhs));
+            SurfaceMesh().swap(rhs);
+            return *this;
+        }
+
+        // release our own data along with tmp
+        SurfaceMesh tmp(std::move(rhs));
+        swap(tmp);
+    }
+
+    return *this;
+}
+
+void SurfaceMesh::swap(SurfaceMesh& rhs) noexcept
+{
+    // property arrays do not move, so the handles remain valid
+    std::swap(oprops_, rhs.oprops_);
+    std::swap(vprops_, rhs.vprops_);
+    std::swap(hprops_, rhs.hprops_);
+    std::swap(eprops_, rhs.eprops_);
+    std::swap(fprops_, rhs.fprops_);
+
+    std::swap(vpoint_, rhs.vpoint_);
+    std::swap(vconn_, rhs.vconn_);
+    std::swap(hconn_, rhs.hconn_);
+    std::swap(fconn_, rhs.fconn_);
+
+    std::swap(vdeleted_, rhs.vdeleted_);
+    std::swap(edeleted_, rhs.edeleted_);
+    std::swap(fdeleted_, rhs.fdeleted_);
+
+    std::swap(deleted_vertices_, rhs.deleted_vertices_);
+    std::swap(deleted_edges_, rhs.deleted_edges_);
+    std::swap(deleted_faces_, rhs.deleted_faces_);
+    std::swap(has_garbage_, rhs.has_garbage_);
+
+    std::swap(reuse_deleted_, rhs.reuse_deleted_);
+    free_vertices_.swap(rhs.free_vertices_);
+    free_edges_.swap(rhs.free_edges_);
+    free_faces_.swap(rhs.free_faces_);
+
+    std::swap(edge_index_enabled_, rhs.edge_index_enabled_);
+    edge_index_.swap(rhs.edge_index_);
+    clock_.swap(rhs.clock_);
+}
+
 SurfaceMesh& SurfaceMesh::assign(const SurfaceMesh& rhs)
 {
     if (this != &rhs)
@@ -108,6 +185,16 @@ SurfaceMesh& SurfaceMesh::assign(const SurfaceMesh& rhs)
         deleted_edges_ = rhs.deleted_edges_;
         deleted_faces_ = rhs.deleted_faces_;
         has_garbage_ = rhs.has_garbage_;
+
+        reuse_deleted_ = rhs.reuse_deleted_;
+        free_vertices_ = rhs.free_vertices_;
+        free_edges_ = rhs.free_edges_;
+        free_faces_ = rhs.free_faces_;
+
+        edge_index_enabled_ = rhs.edge_index_enabled_;
+        edge_index_ = rhs.edge_index_;
+
+        set_change_tracking(rhs.change_tracking());
     }
 
     return *this;
@@ -152,6 +239,8 @@ void SurfaceMesh::clear()
     deleted_edges_ = 0;
     deleted_faces_ = 0;
     has_garbage_ = false;
+    clear_free_lists();
+    EdgeIndex().swap(edge_index_);
 }
 
 void SurfaceMesh::free_memory()
@@ -172,35 +261,83 @@ void SurfaceMesh::reserve(size_t nvertices, size_t nedges, size_t nfaces)
     fprops_.reserve(nfaces);
 }
 
+void SurfaceMesh::reserve(size_t nvertices, size_t nedges, size_t nfaces,
+                          MemoryArena& arena)
+{
+    reserve(nvertices, nedges, nfaces);
+    move_to_arena(vpoint_, nvertices, arena);
+    move_to_arena(vconn_, nvertices, arena);
+    move_to_arena(hconn_, 2 * nedges, arena);
+    move_to_arena(fconn_, nfaces, arena);
+}
+
 void SurfaceMesh::property_stats() const
 {
-    std::vector<std::string> props;
+    const char* headers[] = {"object", "point", "halfedge", "edge", "face"};
+    const char* containers[] = {"object", "vertex", "halfedge", "edge",
+                                "face"};
+    auto usage = memory_usage();
 
-    std::cout << "point properties:\n";
-    props = vertex_properties();
-    for (const auto& prop : props)
-        std::cout << "\t" << prop << std::endl;
+    for (int i = 0; i < 5; ++i)
+    {
+        std::cout << headers[i] << " properties:\n";
+        for (const auto& m : usage)
+        {
+            if (m.container != containers[i])
+                continue;
+            std::cout << "\t" << m.name << ": " << m.size << " elements, "
+                      << m.capacity_bytes << " bytes";
+            if (m.heap_bytes)
+                std::cout << " + " << m.heap_bytes << " bytes on heap";
+            if (m.shared)
+                std::cout << " (shared)";
+            if (m.external)
+                std::cout << " (external)";
+            if (m.sparse)
+                std::cout << " (sparse)";
+            std::cout << std::endl;
+        }
+    }
 
-    std::cout << "halfedge properties:\n";
-    props = halfedge_properties();
-    for (const auto& prop : props)
-        std::cout << "\t" << prop << std::endl;
+    std::cout << "total: " << memory_bytes() << " bytes" << std::endl;
+}
 
-    std::cout << "edge properties:\n";
-    props = edge_properties();
-    for (const auto& prop : props)
-        std::cout << "\t" << prop << std::endl;
+std::vector<PropertyMemory> SurfaceMesh::memory_usage() const
+{
+    std::vector<PropertyMemory> usage;
+    auto append = [&](const PropertyContainer& props, const char* container) {
+        for (auto m : props.memory_usage())
+        {
+            m.container = container;
+            usage.push_back(m);
+        }
+    };
+    append(oprops_, "object");
+    append(vprops_, "vertex");
+    append(hprops_, "halfedge");
+    append(eprops_, "edge");
+    append(fprops_, "face");
+    return usage;
+}
 
-    std::cout << "face properties:\n";
-    props = face_properties();
-    for (const auto& prop : props)
-        std::cout << "\t" << prop << std::endl;
+size_t SurfaceMesh::memory_bytes() const
+{
+    size_t bytes = 0;
+    for (const auto& m : memory_usage())
+        bytes += m.total_bytes();
+    return bytes;
 }
 
 Halfedge SurfaceMesh::find_halfedge(Vertex start, Vertex end) const
 {
     assert(is_valid(start) && is_valid(end));
 
+    if (edge_index_enabled_)
+    {
+        auto it = edge_index_.find(std::make_pair(start.idx(), end.idx()));
+        return it != edge_index_.end() ? it->second : Halfedge();
+    }
+
     Halfedge h = halfedge(start);
     const Halfedge hh = h;
 
@@ -450,6 +587,639 @@ Face SurfaceMesh::add_face(const std::vector<Vertex>& vertices)
     return f;
 }
 
+namespace {
+
+// The links add_face() maintains between the halfedges around one vertex:
+// the next and previous halfedges of the incoming and outgoing ones, and
+// which of them have a face. Vertices have few neighbors, so the tables are
+// searched linearly.
+class VertexLinks
+{
+public:
+    void clear()
+    {
+        next_.clear();
+        prev_.clear();
+        with_face_.clear();
+    }
+
+    IndexType next(IndexType h) const { return find(next_, h); }
+    IndexType prev(IndexType h) const { return find(prev_, h); }
+
+    bool has_face(IndexType h) const
+    {
+        return std::find(with_face_.begin(), with_face_.end(), h) !=
+               with_face_.end();
+    }
+
+    void set_face(IndexType h) { with_face_.push_back(h); }
+
+    // like SurfaceMesh::set_next_halfedge()
+    void link(IndexType h, IndexType nh)
+    {
+        set(next_, h, nh);
+        set(prev_, nh, h);
+    }
+
+private:
+    typedef std::vector<std::pair<IndexType, IndexType>> Table;
+
+    static IndexType find(const Table& table, IndexType h)
+    {
+        for (const auto& entry : table)
+            if (entry.first == h)
+                return entry.second;
+        return PMP_MAX_INDEX;
+    }
+
+    static void set(Table& table, IndexType h, IndexType value)
+    {
+        for (auto& entry : table)
+            if (entry.first == h)
+            {
+                entry.second = value;
+                return;
+            }
+        table.emplace_back(h, value);
+    }
+
+    Table next_, prev_;
+    std::vector<IndexType> with_face_;
+};
+
+// Replay the steps of add_face() that concern a single vertex for the faces
+// around it, given by its corners in face order, and return the outgoing
+// halfedge add_face() would have assigned to the vertex. Corner c stands
+// for the halfedge chalfedge[c] that leaves the vertex of c, an even index
+// means that the edge was created with this halfedge. Each step only reads
+// and writes the links around the vertex, so vertices are independent.
+// Returns PMP_MAX_INDEX if add_face() would have failed.
+IndexType replay_outgoing_halfedge(const IndexType* corners, size_t n,
+                                   const std::vector<IndexType>& chalfedge,
+                                   const std::vector<IndexType>& cprev,
+                                   const std::vector<IndexType>& cface,
+                                   VertexLinks& links)
+{
+    const IndexType none = PMP_MAX_INDEX;
+    links.clear();
+    IndexType hv = none;
+    std::vector<std::pair<IndexType, IndexType>> cache;
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        const IndexType c = corners[k];
+        if (k > 0 && cface[corners[k - 1]] == cface[c])
+            return none;
+
+        const IndexType inner_prev = chalfedge[cprev[c]];
+        const IndexType inner_next = chalfedge[c];
+        const bool prev_is_new = !(inner_prev & 1);
+        const bool next_is_new = !(inner_next & 1);
+
+        // complex vertex or edge
+        if (hv != none && links.has_face(hv))
+            return none;
+        if ((!prev_is_new && links.has_face(inner_prev)) ||
+            (!next_is_new && links.has_face(inner_next)))
+            return none;
+
+        // re-link patches
+        cache.clear();
+        if (!prev_is_new && !next_is_new &&
+            links.next(inner_prev) != inner_next)
+        {
+            IndexType boundary_prev = inner_next ^ 1;
+            size_t steps = 0;
+            do
+            {
+                const IndexType h = links.next(boundary_prev);
+                if (h == none || ++steps > 2 * n + 2)
+                    return none;
+                boundary_prev = h ^ 1;
+            } while (links.has_face(boundary_prev) ||
+                     boundary_prev == inner_prev);
+            const IndexType boundary_next = links.next(boundary_prev);
+            if (boundary_next == inner_next)
+                return none;
+
+            const IndexType patch_start = links.next(inner_prev);
+            const IndexType patch_end = links.prev(inner_next);
+            if (patch_start == none || patch_end == none)
+                return none;
+            cache.emplace_back(boundary_prev, patch_start);
+            cache.emplace_back(patch_end, boundary_next);
+            cache.emplace_back(inner_prev, inner_next);
+        }
+
+        // set up the halfedges
+        bool needs_adjust = false;
+        const IndexType outer_prev = inner_next ^ 1;
+        const IndexType outer_next = inner_prev ^ 1;
+        if (prev_is_new && !next_is_new)
+        {
+            const IndexType boundary_prev = links.prev(inner_next);
+            if (boundary_prev == none)
+                return none;
+            cache.emplace_back(boundary_prev, outer_next);
+            hv = outer_next;
+        }
+        else if (!prev_is_new && next_is_new)
+        {
+            const IndexType boundary_next = links.next(inner_prev);
+            if (boundary_next == none)
+                return none;
+            cache.emplace_back(outer_prev, boundary_next);
+            hv = boundary_next;
+        }
+        else if (prev_is_new && next_is_new)
+        {
+            if (hv == none)
+            {
+                hv = outer_next;
+                cache.emplace_back(outer_prev, outer_next);
+            }
+            else
+            {
+                const IndexType boundary_next = hv;
+                const IndexType boundary_prev = links.prev(boundary_next);
+                if (boundary_prev == none)
+                    return none;
+                cache.emplace_back(boundary_prev, outer_next);
+                cache.emplace_back(outer_prev, boundary_next);
+            }
+        }
+        else
+        {
+            needs_adjust = (hv == inner_next);
+        }
+        if (prev_is_new || next_is_new)
+            cache.emplace_back(inner_prev, inner_next);
+
+        links.set_face(inner_prev);
+        links.set_face(inner_next);
+        for (const auto& entry : cache)
+            links.link(entry.first, entry.second);
+
+        // like SurfaceMesh::adjust_outgoing_halfedge()
+        if (needs_adjust)
+        {
+            IndexType h = hv;
+            size_t steps = 0;
+            do
+            {
+                if (!links.has_face(h))
+                {
+                    hv = h;
+                    break;
+                }
+                h = links.next(h ^ 1);
+                if (h == none || ++steps > 2 * n + 2)
+                    return none;
+            } while (h != hv);
+        }
+    }
+
+    return hv;
+}
+
+} // namespace
+
+void SurfaceMesh::from_indexed_faces(const std::vector<Point>& points,
+                                     const std::vector<IndexType>& indices,
+                                     const std::vector<IndexType>& face_sizes)
+{
+    clear();
+
+    const size_t nv = points.size();
+    const size_t nc = indices.size();
+
+    if (nv >= PMP_MAX_INDEX - 1 || 2 * nc >= PMP_MAX_INDEX - 1)
+    {
+        auto what = "SurfaceMesh::from_indexed_faces: max. index reached";
+        throw AllocationException(what);
+    }
+
+    // offsets of the faces in the index buffer
+    std::vector<IndexType> offsets;
+    if (face_sizes.empty())
+    {
+        if (nc % 3 != 0)
+        {
+            auto what = "SurfaceMesh::from_indexed_faces: Number of indices "
+                        "is not a multiple of three.";
+            throw InvalidInputException(what);
+        }
+        offsets.resize(nc / 3 + 1);
+        for (size_t i = 0; i < offsets.size(); ++i)
+            offsets[i] = 3 * i;
+    }
+    else
+    {
+        offsets.resize(face_sizes.size() + 1);
+        offsets[0] = 0;
+        for (size_t i = 0; i < face_sizes.size(); ++i)
+        {
+            if (face_sizes[i] < 3)
+            {
+                auto what = "SurfaceMesh::from_indexed_faces: Face with less "
+                            "than three vertices.";
+                throw InvalidInputException(what);
+            }
+            offsets[i + 1] = offsets[i] + face_sizes[i];
+        }
+        if (offsets.back() != nc)
+        {
+            auto what = "SurfaceMesh::from_indexed_faces: Face sizes do not "
+                        "match the number of indices.";
+            throw InvalidInputException(what);
+        }
+    }
+    const size_t nf = offsets.size() - 1;
+
+    for (auto idx : indices)
+    {
+        if (idx >= nv)
+        {
+            auto what =
+                "SurfaceMesh::from_indexed_faces: Vertex index out of range.";
+            throw InvalidInputException(what);
+        }
+    }
+
+    // corner c of face f represents the halfedge from indices[c] to
+    // indices[cnext[c]]
+    std::vector<IndexType> cnext(nc), cface(nc);
+    for (size_t f = 0; f < nf; ++f)
+    {
+        for (IndexType c = offsets[f]; c < offsets[f + 1]; ++c)
+        {
+            cnext[c] = (c + 1 < offsets[f + 1]) ? c + 1 : offsets[f];
+            cface[c] = f;
+        }
+    }
+
+    // bucket corners by the smaller vertex of their edge (counting sort)
+    std::vector<IndexType> bucket(nv + 1, 0);
+    for (size_t c = 0; c < nc; ++c)
+    {
+        IndexType a = indices[c], b = indices[cnext[c]];
+        if (a == b)
+        {
+            clear();
+            auto what = "SurfaceMesh::from_indexed_faces: Degenerate face.";
+            throw TopologyException(what);
+        }
+        ++bucket[std::min(a, b) + 1];
+    }
+    for (size_t i = 0; i < nv; ++i)
+        bucket[i + 1] += bucket[i];
+
+    std::vector<IndexType> sorted(nc);
+    {
+        std::vector<IndexType> pos(bucket.begin(), bucket.end() - 1);
+        for (size_t c = 0; c < nc; ++c)
+        {
+            IndexType lo = std::min(indices[c], indices[cnext[c]]);
+            sorted[pos[lo]++] = c;
+        }
+    }
+
+    // match opposite corners within each bucket
+    auto other = [&](IndexType c) {
+        return std::max(indices[c], indices[cnext[c]]);
+    };
+    std::vector<IndexType> cmate(nc, PMP_MAX_INDEX);
+    for (size_t lo = 0; lo < nv; ++lo)
+    {
+        const auto begin = sorted.begin() + bucket[lo];
+        const auto end = sorted.begin() + bucket[lo + 1];
+        std::sort(begin, end, [&](IndexType c0, IndexType c1) {
+            return other(c0) < other(c1);
+        });
+
+        for (auto it = begin; it != end;)
+        {
+            auto jt = it + 1;
+            while (jt != end && other(*jt) == other(*it))
+                ++jt;
+
+            if (jt - it == 2 && indices[*it] != indices[*(it + 1)])
+            {
+                cmate[*it] = *(it + 1);
+                cmate[*(it + 1)] = *it;
+            }
+            else if (jt - it != 1)
+            {
+                clear();
+                auto what = "SurfaceMesh::from_indexed_faces: Complex edge.";
+                throw TopologyException(what);
+            }
+            it = jt;
+        }
+    }
+
+    // number the edges in the order add_face() creates them, by their first
+    // corner, whose halfedge comes first
+    std::vector<IndexType> chalfedge(nc);
+    IndexType ne = 0;
+    for (IndexType c = 0; c < nc; ++c)
+    {
+        if (cmate[c] != PMP_MAX_INDEX && cmate[c] < c)
+            continue;
+        chalfedge[c] = 2 * ne;
+        if (cmate[c] != PMP_MAX_INDEX)
+            chalfedge[cmate[c]] = 2 * ne + 1;
+        ++ne;
+    }
+
+    // allocate all elements at once
+    vprops_.resize(nv);
+    hprops_.resize(2 * ne);
+    eprops_.resize(ne);
+    fprops_.resize(nf);
+    for (size_t i = 0; i < nv; ++i)
+        vpoint_[Vertex(i)] = points[i];
+
+    // interior halfedges
+    for (size_t c = 0; c < nc; ++c)
+    {
+        Halfedge h(chalfedge[c]);
+        set_vertex(h, Vertex(indices[cnext[c]]));
+        set_face(h, Face(cface[c]));
+        set_next_halfedge(h, Halfedge(chalfedge[cnext[c]]));
+        set_halfedge(Vertex(indices[c]), h);
+    }
+    for (size_t f = 0; f < nf; ++f)
+        set_halfedge(Face(f), Halfedge(chalfedge[offsets[f + 1] - 1]));
+
+    // boundary halfedges: the second halfedge of an edge is boundary if it
+    // has not been assigned to a corner
+    std::vector<IndexType> vboundary(nv, PMP_MAX_INDEX);
+    for (IndexType e = 0; e < ne; ++e)
+    {
+        Halfedge h0(2 * e), h1(2 * e + 1);
+        if (face(h1).is_valid())
+            continue;
+
+        Vertex v = to_vertex(h0);
+        set_vertex(h1, to_vertex(prev_halfedge(h0)));
+
+        if (vboundary[v.idx()] != PMP_MAX_INDEX)
+        {
+            clear();
+            auto what = "SurfaceMesh::from_indexed_faces: Complex vertex.";
+            throw TopologyException(what);
+        }
+        vboundary[v.idx()] = h1.idx();
+        set_halfedge(v, h1);
+    }
+    for (IndexType e = 0; e < ne; ++e)
+    {
+        Halfedge h1(2 * e + 1);
+        if (face(h1).is_valid())
+            continue;
+        Halfedge next(vboundary[to_vertex(h1).idx()]);
+        assert(next.is_valid());
+        set_next_halfedge(h1, next);
+    }
+
+    // a vertex is non-manifold if its outgoing halfedges form more than
+    // one fan
+    std::vector<IndexType> degree(nv, 0);
+    for (size_t h = 0; h < 2 * ne; ++h)
+        ++degree[to_vertex(opposite_halfedge(Halfedge(h))).idx()];
+    for (size_t i = 0; i < nv; ++i)
+    {
+        Vertex v(i);
+        Halfedge h = halfedge(v);
+        if (!h.is_valid())
+            continue;
+
+        const Halfedge hh = h;
+        IndexType n = 0;
+        do
+        {
+            ++n;
+            h = cw_rotated_halfedge(h);
+        } while (h != hh && n <= degree[i]);
+
+        if (n != degree[i])
+        {
+            clear();
+            auto what = "SurfaceMesh::from_indexed_faces: Complex vertex.";
+            throw TopologyException(what);
+        }
+    }
+
+    // the outgoing halfedge of each vertex as chosen by add_face(), which
+    // depends on the order of the faces around the vertex
+    std::vector<IndexType> cprev(nc), vcorner_offsets(nv + 1, 0);
+    for (size_t c = 0; c < nc; ++c)
+    {
+        cprev[cnext[c]] = IndexType(c);
+        ++vcorner_offsets[indices[c] + 1];
+    }
+    for (size_t i = 0; i < nv; ++i)
+        vcorner_offsets[i + 1] += vcorner_offsets[i];
+    std::vector<IndexType> vcorners(nc);
+    {
+        std::vector<IndexType> pos(vcorner_offsets.begin(),
+                                   vcorner_offsets.end() - 1);
+        for (size_t c = 0; c < nc; ++c)
+            vcorners[pos[indices[c]]++] = IndexType(c);
+    }
+    parallel_for_chunks(0, int(nv), [&](int first, int last) {
+        VertexLinks links;
+        for (int i = first; i < last; ++i)
+        {
+            const IndexType begin = vcorner_offsets[i];
+            const IndexType end = vcorner_offsets[i + 1];
+            if (begin == end)
+                continue;
+            const IndexType h = replay_outgoing_halfedge(
+                &vcorners[begin], end - begin, chalfedge, cprev, cface, links);
+            if (h != PMP_MAX_INDEX)
+                set_halfedge(Vertex(i), Halfedge(h));
+        }
+    });
+}
+
+void SurfaceMesh::append(const SurfaceMesh& other)
+{
+    append_meshes(std::vector<const SurfaceMesh*>(1, &other));
+}
+
+void SurfaceMesh::append(const std::vector<SurfaceMesh>& meshes)
+{
+    std::vector<const SurfaceMesh*> pointers;
+    pointers.reserve(meshes.size());
+    for (const auto& m : meshes)
+        pointers.push_back(&m);
+    append_meshes(pointers);
+}
+
+void SurfaceMesh::append_meshes(
+    const std::vector<const SurfaceMesh*>& meshes)
+{
+    // appending to itself reads from a copy sharing the elements
+    std::vector<const SurfaceMesh*> sources(meshes);
+    SurfaceMesh self;
+    bool has_self = false;
+    for (auto& m : sources)
+        if (m == this)
+        {
+            if (!has_self)
+                self = *this;
+            has_self = true;
+            m = &self;
+        }
+
+    // the new elements of each mesh start at these offsets
+    const size_t n = sources.size();
+    std::vector<size_t> voffset(n + 1), eoffset(n + 1), foffset(n + 1);
+    voffset[0] = vertices_size();
+    eoffset[0] = edges_size();
+    foffset[0] = faces_size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        voffset[i + 1] = voffset[i] + sources[i]->vertices_size();
+        eoffset[i + 1] = eoffset[i] + sources[i]->edges_size();
+        foffset[i + 1] = foffset[i] + sources[i]->faces_size();
+    }
+
+    if (voffset[n] >= PMP_MAX_INDEX - 1 ||
+        2 * eoffset[n] >= PMP_MAX_INDEX - 1 ||
+        foffset[n] >= PMP_MAX_INDEX - 1)
+    {
+        auto what = "SurfaceMesh::append: max. index reached";
+        throw AllocationException(what);
+    }
+
+    vprops_.resize(voffset[n]);
+    hprops_.resize(2 * eoffset[n]);
+    eprops_.resize(eoffset[n]);
+    fprops_.resize(foffset[n]);
+
+    // copy blocks of matching properties in parallel. each job is a range
+    // of tasks, bool arrays are packed bits and are thus copied by one job.
+    struct Task
+    {
+        BasePropertyArray* dst;
+        const BasePropertyArray* src;
+        size_t src_begin, count, dst_begin, mesh;
+    };
+    const size_t block_size = 1 << 16;
+    std::vector<Task> tasks;
+    std::vector<size_t> jobs;
+    auto add_tasks = [&](PropertyContainer SurfaceMesh::*props,
+                         const std::vector<size_t>& offset, size_t factor) {
+        for (auto dst : (this->*props).arrays())
+        {
+            const bool is_bool = dst->type() == typeid(bool);
+            if (is_bool)
+                jobs.push_back(tasks.size());
+            for (size_t i = 0; i < n; ++i)
+            {
+                const BasePropertyArray* src = nullptr;
+                for (auto a : (sources[i]->*props).arrays())
+                    if (a->key() == dst->key() && a->type() == dst->type())
+                        src = a;
+                if (!src)
+                    continue;
+
+                const size_t size = factor * (offset[i + 1] - offset[i]);
+                for (size_t b = 0; b < size; b += block_size)
+                {
+                    if (!is_bool)
+                        jobs.push_back(tasks.size());
+                    tasks.push_back(Task{dst, src, b,
+                                         std::min(block_size, size - b),
+                                         factor * offset[i] + b, i});
+                }
+            }
+        }
+    };
+    add_tasks(&SurfaceMesh::vprops_, voffset, 1);
+    add_tasks(&SurfaceMesh::hprops_, eoffset, 2);
+    add_tasks(&SurfaceMesh::eprops_, eoffset, 1);
+    add_tasks(&SurfaceMesh::fprops_, foffset, 1);
+    jobs.push_back(tasks.size());
+
+    auto shift = [&](Halfedge h, size_t m) {
+        return h.is_valid() ? Halfedge(IndexType(h.idx() + 2 * eoffset[m]))
+                            : h;
+    };
+
+    parallel_for(
+        0, int(jobs.size()) - 1,
+        [&](int j) {
+            for (size_t k = jobs[j]; k < jobs[j + 1]; ++k)
+            {
+                const Task& t = tasks[k];
+                t.dst->copy_range(*t.src, t.src_begin, t.count, t.dst_begin);
+
+                // the connectivity refers to the elements of the source mesh
+                const size_t m = t.mesh, end = t.dst_begin + t.count;
+                if (t.dst == &vconn_.array())
+                    for (size_t i = t.dst_begin; i < end; ++i)
+                    {
+                        auto& vc = vconn_[Vertex(IndexType(i))];
+                        vc.halfedge_ = shift(vc.halfedge_, m);
+                    }
+                else if (t.dst == &hconn_.array())
+                    for (size_t i = t.dst_begin; i < end; ++i)
+                    {
+                        auto& hc = hconn_[Halfedge(IndexType(i))];
+                        if (hc.vertex_.is_valid())
+                            hc.vertex_ = Vertex(IndexType(hc.vertex_.idx() +
+                                                          voffset[m]));
+                        hc.next_halfedge_ = shift(hc.next_halfedge_, m);
+                        hc.prev_halfedge_ = shift(hc.prev_halfedge_, m);
+                        if (hc.face_.is_valid())
+                            hc.face_ =
+                                Face(IndexType(hc.face_.idx() + foffset[m]));
+                    }
+                else if (t.dst == &fconn_.array())
+                    for (size_t i = t.dst_begin; i < end; ++i)
+                    {
+                        auto& fc = fconn_[Face(IndexType(i))];
+                        fc.halfedge_ = shift(fc.halfedge_, m);
+                    }
+            }
+        },
+        1);
+
+    // deleted elements stay deleted and can be reused if enabled
+    for (size_t i = 0; i < n; ++i)
+    {
+        const SurfaceMesh& source = *sources[i];
+        deleted_vertices_ += source.deleted_vertices_;
+        deleted_edges_ += source.deleted_edges_;
+        deleted_faces_ += source.deleted_faces_;
+        if (!reuse_deleted_ || !source.has_garbage_)
+            continue;
+
+        for (size_t v = 0; v < source.vertices_size(); ++v)
+            if (source.vdeleted_[Vertex(IndexType(v))])
+                free_vertices_.push_back(IndexType(voffset[i] + v));
+        for (size_t e = 0; e < source.edges_size(); ++e)
+            if (source.edeleted_[Edge(IndexType(e))])
+                free_edges_.push_back(IndexType(eoffset[i] + e));
+        for (size_t f = 0; f < source.faces_size(); ++f)
+            if (source.fdeleted_[Face(IndexType(f))])
+                free_faces_.push_back(IndexType(foffset[i] + f));
+    }
+    update_garbage_status();
+
+    if (edge_index_enabled_)
+        for (size_t e = eoffset[0]; e < eoffset[n]; ++e)
+            if (!edeleted_[Edge(IndexType(e))])
+            {
+                index_halfedge(Halfedge(IndexType(2 * e)));
+                index_halfedge(Halfedge(IndexType(2 * e + 1)));
+            }
+}
+
 size_t SurfaceMesh::valence(Vertex v) const
 {
     size_t count(0);
@@ -494,13 +1264,310 @@ bool SurfaceMesh::is_quad_mesh() const
     return true;
 }
 
+namespace {
+
+// Run check(i, defects) for all n elements in parallel and append the
+// defects found ordered by element index.
+template <class Check>
+void check_elements(size_t n, Check check, std::vector<MeshDefect>& defects)
+{
+    // one list per chunk, concatenated in the order of the chunks
+    const int chunk_size = 1024;
+    std::vector<std::vector<MeshDefect>> found((n + chunk_size - 1) /
+                                               chunk_size);
+    parallel_for_chunks(
+        0, int(n),
+        [&](int first, int last) {
+            std::vector<MeshDefect>& local = found[first / chunk_size];
+            for (int i = first; i < last; ++i)
+                check(IndexType(i), local);
+        },
+        chunk_size);
+
+    for (const auto& local : found)
+        defects.insert(defects.end(), local.begin(), local.end());
+}
+
+inline MeshDefect make_defect(MeshDefect::Type type, const char* element,
+                              IndexType idx, const char* what)
+{
+    return MeshDefect{type, idx,
+                      std::string(element) + " " + std::to_string(idx) +
+                          ": " + what};
+}
+
+} // namespace
+
+std::vector<MeshDefect> SurfaceMesh::validate() const
+{
+    std::vector<MeshDefect> defects;
+
+    const size_t nv = vertices_size();
+    const size_t nh = halfedges_size();
+    const size_t nf = faces_size();
+
+    // vertices: outgoing halfedge, one-ring closure, boundary convention
+    check_elements(
+        nv,
+        [&](IndexType i, std::vector<MeshDefect>& d) {
+            Vertex v(i);
+            if (vdeleted_[v])
+                return;
+
+            Halfedge h = halfedge(v);
+            if (!h.is_valid())
+                return;
+            if (h.idx() >= nh)
+            {
+                d.push_back(make_defect(MeshDefect::InvalidReference,
+                                        "vertex", i,
+                                        "halfedge out of range."));
+                return;
+            }
+            if (edeleted_[edge(h)])
+            {
+                d.push_back(make_defect(MeshDefect::DeletedReference,
+                                        "vertex", i, "halfedge is deleted."));
+                return;
+            }
+            if (from_vertex(h) != v)
+            {
+                d.push_back(make_defect(MeshDefect::VertexHalfedge, "vertex",
+                                        i, "halfedge does not start here."));
+                return;
+            }
+
+            // rotate around v, bounded by the number of halfedges
+            bool boundary = false;
+            bool closed = false;
+            Halfedge hh = h;
+            for (size_t n = 0; n < nh; ++n)
+            {
+                if (!face(hh).is_valid())
+                    boundary = true;
+                Halfedge p = prev_halfedge(hh);
+                if (!p.is_valid() || p.idx() >= nh)
+                    break;
+                hh = opposite_halfedge(p);
+                if (from_vertex(hh) != v)
+                    break;
+                if (hh == h)
+                {
+                    closed = true;
+                    break;
+                }
+            }
+            if (!closed)
+                d.push_back(make_defect(MeshDefect::VertexLoop, "vertex", i,
+                                        "one-ring does not close."));
+            else if (boundary && face(h).is_valid())
+                d.push_back(make_defect(MeshDefect::OutgoingBoundary, "vertex",
+                                        i,
+                                        "halfedge is not a boundary halfedge "
+                                        "of a boundary vertex."));
+        },
+        defects);
+
+    // halfedges: opposite, next/prev links, incident vertex and face
+    check_elements(
+        nh,
+        [&](IndexType i, std::vector<MeshDefect>& d) {
+            Halfedge h(i);
+            if (edeleted_[edge(h)])
+                return;
+
+            Vertex v = to_vertex(h);
+            if (!v.is_valid() || v.idx() >= nv)
+                d.push_back(make_defect(MeshDefect::InvalidReference,
+                                        "halfedge", i,
+                                        "vertex out of range."));
+            else if (vdeleted_[v])
+                d.push_back(make_defect(MeshDefect::DeletedReference,
+                                        "halfedge", i, "vertex is deleted."));
+            else if ((i & 1) == 0 && to_vertex(opposite_halfedge(h)) == v)
+                d.push_back(make_defect(MeshDefect::DegenerateEdge,
+                                        "halfedge", i,
+                                        "opposite points to same vertex."));
+
+            Halfedge n = next_halfedge(h);
+            Halfedge p = prev_halfedge(h);
+            if (!n.is_valid() || n.idx() >= nh || !p.is_valid() ||
+                p.idx() >= nh)
+            {
+                d.push_back(make_defect(MeshDefect::InvalidReference,
+                                        "halfedge", i,
+                                        "next or prev out of range."));
+                return;
+            }
+            if (edeleted_[edge(n)] || edeleted_[edge(p)])
+                d.push_back(make_defect(MeshDefect::DeletedReference,
+                                        "halfedge", i,
+                                        "next or prev is deleted."));
+            if (prev_halfedge(n) != h || next_halfedge(p) != h)
+                d.push_back(make_defect(MeshDefect::NextPrev, "halfedge", i,
+                                        "next and prev are not inverse."));
+            else if (from_vertex(n) != v)
+                d.push_back(make_defect(MeshDefect::NextPrev, "halfedge", i,
+                                        "next does not start at target."));
+
+            Face f = face(h);
+            if (!f.is_valid())
+                return;
+            if (f.idx() >= nf)
+                d.push_back(make_defect(MeshDefect::InvalidReference,
+                                        "halfedge", i, "face out of range."));
+            else if (fdeleted_[f])
+                d.push_back(make_defect(MeshDefect::DeletedReference,
+                                        "halfedge", i, "face is deleted."));
+            else if (face(n) != f)
+                d.push_back(make_defect(MeshDefect::FaceLoop, "halfedge", i,
+                                        "next belongs to another face."));
+        },
+        defects);
+
+    // faces: halfedge loop closes and only contains halfedges of the face
+    check_elements(
+        nf,
+        [&](IndexType i, std::vector<MeshDefect>& d) {
+            Face f(i);
+            if (fdeleted_[f])
+                return;
+
+            Halfedge h = halfedge(f);
+            if (!h.is_valid() || h.idx() >= nh)
+            {
+                d.push_back(make_defect(MeshDefect::InvalidReference, "face",
+                                        i, "halfedge out of range."));
+                return;
+            }
+            if (edeleted_[edge(h)])
+            {
+                d.push_back(make_defect(MeshDefect::DeletedReference, "face",
+                                        i, "halfedge is deleted."));
+                return;
+            }
+
+            size_t count = 0;
+            bool closed = false;
+            Halfedge hh = h;
+            for (size_t n = 0; n < nh; ++n)
+            {
+                if (face(hh) != f)
+                    break;
+                ++count;
+                hh = next_halfedge(hh);
+                if (!hh.is_valid() || hh.idx() >= nh)
+                    break;
+                if (hh == h)
+                {
+                    closed = true;
+                    break;
+                }
+            }
+            if (!closed)
+                d.push_back(make_defect(MeshDefect::FaceLoop, "face", i,
+                                        "halfedge loop does not close."));
+            else if (count < 3)
+                d.push_back(make_defect(MeshDefect::FaceLoop, "face", i,
+                                        "less than three halfedges."));
+        },
+        defects);
+
+    // deletion counters
+    auto sum = [](size_t a, size_t b) { return a + b; };
+    const size_t n_deleted_vertices = parallel_reduce(
+        0, int(nv), size_t(0),
+        [&](int i) { return size_t(vdeleted_[Vertex(i)]); }, sum);
+    const size_t n_deleted_edges = parallel_reduce(
+        0, int(edges_size()), size_t(0),
+        [&](int i) { return size_t(edeleted_[Edge(i)]); }, sum);
+    const size_t n_deleted_faces = parallel_reduce(
+        0, int(nf), size_t(0),
+        [&](int i) { return size_t(fdeleted_[Face(i)]); }, sum);
+
+    if (n_deleted_vertices != deleted_vertices_ ||
+        n_deleted_edges != deleted_edges_ || n_deleted_faces != deleted_faces_)
+        defects.push_back(MeshDefect{
+            MeshDefect::DeletedCount, PMP_MAX_INDEX,
+            "mesh: deletion counters do not match deletion flags."});
+
+    return defects;
+}
+
 void SurfaceMesh::triangulate()
 {
-    // The iterators will stay valid, even though new faces are added, because
-    // they are now implemented index-based instead of pointer-based.
-    auto fend = faces_end();
-    for (auto fit = faces_begin(); fit != fend; ++fit)
-        triangulate(*fit);
+    // Each face of valence n is split into the same fan as by
+    // triangulate(Face), which needs n-3 new edges and faces. All of them
+    // are allocated at once, and each face then connects its own range of
+    // new elements independently of the others.
+    const int nf(faces_size());
+    std::vector<size_t> offsets(nf + 1, 0);
+    parallel_for_chunks(0, nf, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+            if (!fdeleted_[Face(i)])
+                offsets[i + 1] = valence(Face(i)) - 3;
+    });
+    for (int i = 0; i < nf; ++i)
+        offsets[i + 1] += offsets[i];
+
+    const size_t n = offsets[nf];
+    if (n == 0)
+        return;
+    const IndexType e0 = new_edges(n).idx() / 2;
+    const IndexType f0 = new_faces(n).idx();
+
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            for (int i = first; i < last; ++i)
+            {
+                const size_t k = offsets[i + 1] - offsets[i];
+                if (k == 0)
+                    continue;
+
+                const Face f(i);
+                const Vertex start = from_vertex(halfedge(f));
+                Halfedge base = halfedge(f);
+                Halfedge next = next_halfedge(base);
+                for (size_t j = 0; j < k; ++j)
+                {
+                    const IndexType e = IndexType(e0 + offsets[i] + j);
+                    const Face t(IndexType(f0 + offsets[i] + j));
+                    const Halfedge h(2 * e), o(2 * e + 1);
+                    const Halfedge next_next = next_halfedge(next);
+
+                    // h closes the triangle (base, next) at the start
+                    // vertex. the edge index is updated afterwards, it is
+                    // not thread-safe.
+                    hconn_[h].vertex_ = start;
+                    hconn_[o].vertex_ = to_vertex(next);
+                    set_next_halfedge(base, next);
+                    set_next_halfedge(next, h);
+                    set_next_halfedge(h, base);
+                    set_face(base, t);
+                    set_face(next, t);
+                    set_face(h, t);
+                    set_halfedge(t, base);
+
+                    base = o;
+                    next = next_next;
+                }
+
+                // the last triangle keeps the face
+                set_next_halfedge(base, next);
+                set_next_halfedge(next_halfedge(next), base);
+                set_face(base, f);
+                set_halfedge(f, base);
+            }
+        },
+        256);
+
+    if (edge_index_enabled_)
+        for (size_t e = e0; e < e0 + n; ++e)
+        {
+            index_halfedge(Halfedge(IndexType(2 * e)));
+            index_halfedge(Halfedge(IndexType(2 * e + 1)));
+        }
 }
 
 void SurfaceMesh::triangulate(Face f)
@@ -961,10 +2028,8 @@ bool SurfaceMesh::remove_edge(Edge e)
         set_halfedge(f1, h1_next);
 
     // delete face f0 and edge e
-    fdeleted_[f0] = true;
-    ++deleted_faces_;
-    edeleted_[e] = true;
-    ++deleted_edges_;
+    mark_deleted(f0);
+    mark_deleted(e);
     has_garbage_ = true;
 
     return true;
@@ -1027,10 +2092,8 @@ void SurfaceMesh::remove_edge_helper(Halfedge h)
     set_halfedge(vo, Halfedge());
 
     // delete stuff
-    vdeleted_[vo] = true;
-    ++deleted_vertices_;
-    edeleted_[edge(h)] = true;
-    ++deleted_edges_;
+    mark_deleted(vo);
+    mark_deleted(edge(h));
     has_garbage_ = true;
 }
 
@@ -1071,11 +2134,9 @@ void SurfaceMesh::remove_loop_helper(Halfedge h)
     // delete stuff
     if (fh.is_valid())
     {
-        fdeleted_[fh] = true;
-        ++deleted_faces_;
+        mark_deleted(fh);
     }
-    edeleted_[edge(h)] = true;
-    ++deleted_edges_;
+    mark_deleted(edge(h));
     has_garbage_ = true;
 }
 
@@ -1098,8 +2159,7 @@ void SurfaceMesh::delete_vertex(Vertex v)
     // mark v as deleted if not yet done by delete_face()
     if (!vdeleted_[v])
     {
-        vdeleted_[v] = true;
-        deleted_vertices_++;
+        mark_deleted(v);
         has_garbage_ = true;
     }
 }
@@ -1126,8 +2186,7 @@ void SurfaceMesh::delete_face(Face f)
     // mark face deleted
     if (!fdeleted_[f])
     {
-        fdeleted_[f] = true;
-        deleted_faces_++;
+        mark_deleted(f);
     }
 
     // boundary edges of face f to be deleted
@@ -1184,8 +2243,7 @@ void SurfaceMesh::delete_face(Face f)
             // mark edge deleted
             if (!edeleted_[*delit])
             {
-                edeleted_[*delit] = true;
-                deleted_edges_++;
+                mark_deleted(*delit);
             }
 
             // update v0
@@ -1195,8 +2253,7 @@ void SurfaceMesh::delete_face(Face f)
                 {
                     if (!vdeleted_[v0])
                     {
-                        vdeleted_[v0] = true;
-                        deleted_vertices_++;
+                        mark_deleted(v0);
                     }
                 }
                 else
@@ -1210,8 +2267,7 @@ void SurfaceMesh::delete_face(Face f)
                 {
                     if (!vdeleted_[v1])
                     {
-                        vdeleted_[v1] = true;
-                        deleted_vertices_++;
+                        mark_deleted(v1);
                     }
                 }
                 else
@@ -1228,145 +2284,439 @@ void SurfaceMesh::delete_face(Face f)
     has_garbage_ = true;
 }
 
-void SurfaceMesh::garbage_collection()
+namespace {
+
+typedef std::vector<std::pair<size_t, size_t>> Moves;
+
+// Compute the moves that compact an array of n elements by moving the last
+// non-deleted elements into the first deleted slots. Stores the new index of
+// each element (or PMP_MAX_INDEX if deleted) in map.
+template <class IsDeleted>
+void compaction_moves(size_t n, IsDeleted is_deleted, Moves& moves,
+                      std::vector<IndexType>& map)
 {
-    int i, i0, i1, nV(vertices_size()), nE(edges_size()), nH(halfedges_size()),
-        nF(faces_size());
+    map.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        map[i] = is_deleted(i) ? PMP_MAX_INDEX : i;
 
-    Vertex v;
-    Halfedge h;
-    Face f;
-
-    // setup handle mapping
-    VertexProperty<Vertex> vmap =
-        add_vertex_property<Vertex>("v:garbage-collection");
-    HalfedgeProperty<Halfedge> hmap =
-        add_halfedge_property<Halfedge>("h:garbage-collection");
-    FaceProperty<Face> fmap = add_face_property<Face>("f:garbage-collection");
-    for (i = 0; i < nV; ++i)
-        vmap[Vertex(i)] = Vertex(i);
-    for (i = 0; i < nH; ++i)
-        hmap[Halfedge(i)] = Halfedge(i);
-    for (i = 0; i < nF; ++i)
-        fmap[Face(i)] = Face(i);
-
-    // remove deleted vertices
-    if (nV > 0)
-    {
-        i0 = 0;
-        i1 = nV - 1;
-
-        while (1)
-        {
-            // find first deleted and last un-deleted
-            while (!vdeleted_[Vertex(i0)] && i0 < i1)
-                ++i0;
-            while (vdeleted_[Vertex(i1)] && i0 < i1)
-                --i1;
-            if (i0 >= i1)
-                break;
-
-            // swap
-            vprops_.swap(i0, i1);
-        };
-
-        // remember new size
-        nV = vdeleted_[Vertex(i0)] ? i0 : i0 + 1;
-    }
+    if (n == 0)
+        return;
 
-    // remove deleted edges
-    if (nE > 0)
+    size_t i0 = 0, i1 = n - 1;
+    while (true)
     {
-        i0 = 0;
-        i1 = nE - 1;
-
-        while (1)
-        {
-            // find first deleted and last un-deleted
-            while (!edeleted_[Edge(i0)] && i0 < i1)
-                ++i0;
-            while (edeleted_[Edge(i1)] && i0 < i1)
-                --i1;
-            if (i0 >= i1)
-                break;
-
-            // swap
-            eprops_.swap(i0, i1);
-            hprops_.swap(2 * i0, 2 * i1);
-            hprops_.swap(2 * i0 + 1, 2 * i1 + 1);
-        };
-
-        // remember new size
-        nE = edeleted_[Edge(i0)] ? i0 : i0 + 1;
-        nH = 2 * nE;
+        // find first deleted and last un-deleted
+        while (!is_deleted(i0) && i0 < i1)
+            ++i0;
+        while (is_deleted(i1) && i0 < i1)
+            --i1;
+        if (i0 >= i1)
+            break;
+
+        moves.emplace_back(i1, i0);
+        map[i1] = i0;
+        ++i0;
+        --i1;
     }
+}
 
-    // remove deleted faces
-    if (nF > 0)
-    {
-        i0 = 0;
-        i1 = nF - 1;
+// Spread the lower 21 bits of x such that two zero bits separate each bit.
+inline uint64_t spread_bits(uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
 
-        while (1)
-        {
-            // find 1st deleted and last un-deleted
-            while (!fdeleted_[Face(i0)] && i0 < i1)
-                ++i0;
-            while (fdeleted_[Face(i1)] && i0 < i1)
-                --i1;
-            if (i0 >= i1)
-                break;
-
-            // swap
-            fprops_.swap(i0, i1);
-        };
-
-        // remember new size
-        nF = fdeleted_[Face(i0)] ? i0 : i0 + 1;
-    }
+} // namespace
 
-    // update vertex connectivity
-    for (i = 0; i < nV; ++i)
-    {
-        v = Vertex(i);
-        if (!is_isolated(v))
-            set_halfedge(v, hmap[halfedge(v)]);
-    }
+void SurfaceMesh::garbage_collection()
+{
+    std::vector<IndexType> vmap, emap, fmap;
+    compact(vmap, emap, fmap);
+}
+
+void SurfaceMesh::garbage_collection(std::vector<Vertex>& vmap,
+                                     std::vector<Halfedge>& hmap,
+                                     std::vector<Edge>& emap,
+                                     std::vector<Face>& fmap)
+{
+    std::vector<IndexType> vidx, eidx, fidx;
+    compact(vidx, eidx, fidx);
+
+    vmap.resize(vidx.size());
+    for (size_t i = 0; i < vidx.size(); ++i)
+        vmap[i] = Vertex(vidx[i]);
 
-    // update halfedge connectivity
-    for (i = 0; i < nH; ++i)
+    emap.resize(eidx.size());
+    hmap.resize(2 * eidx.size());
+    for (size_t i = 0; i < eidx.size(); ++i)
     {
-        h = Halfedge(i);
-        set_vertex(h, vmap[to_vertex(h)]);
-        set_next_halfedge(h, hmap[next_halfedge(h)]);
-        if (!is_boundary(h))
-            set_face(h, fmap[face(h)]);
+        emap[i] = Edge(eidx[i]);
+        if (eidx[i] != PMP_MAX_INDEX)
+        {
+            hmap[2 * i] = Halfedge(2 * eidx[i]);
+            hmap[2 * i + 1] = Halfedge(2 * eidx[i] + 1);
+        }
+        else
+        {
+            hmap[2 * i] = hmap[2 * i + 1] = Halfedge();
+        }
     }
 
-    // update handles of faces
-    for (i = 0; i < nF; ++i)
+    fmap.resize(fidx.size());
+    for (size_t i = 0; i < fidx.size(); ++i)
+        fmap[i] = Face(fidx[i]);
+}
+
+void SurfaceMesh::compact(std::vector<IndexType>& vmap,
+                          std::vector<IndexType>& emap,
+                          std::vector<IndexType>& fmap)
+{
+    const int nV(vertices_size()), nE(edges_size()), nF(faces_size());
+
+    // compute element moves and handle mappings once
+    Moves vmoves, emoves, hmoves, fmoves;
+    compaction_moves(
+        nV, [&](size_t i) { return vdeleted_[Vertex(i)]; }, vmoves, vmap);
+    compaction_moves(
+        nE, [&](size_t i) { return edeleted_[Edge(i)]; }, emoves, emap);
+    compaction_moves(
+        nF, [&](size_t i) { return fdeleted_[Face(i)]; }, fmoves, fmap);
+
+    hmoves.reserve(2 * emoves.size());
+    for (const auto& m : emoves)
     {
-        f = Face(i);
-        set_halfedge(f, hmap[halfedge(f)]);
+        hmoves.emplace_back(2 * m.first, 2 * m.second);
+        hmoves.emplace_back(2 * m.first + 1, 2 * m.second + 1);
     }
 
-    // remove handle maps
-    remove_vertex_property(vmap);
-    remove_halfedge_property(hmap);
-    remove_face_property(fmap);
+    auto new_halfedge = [&](Halfedge h) {
+        if (!h.is_valid())
+            return h;
+        IndexType e = emap[h.idx() >> 1];
+        return e == PMP_MAX_INDEX ? Halfedge()
+                                  : Halfedge((e << 1) + (h.idx() & 1));
+    };
+
+    // update connectivity of the remaining elements in place
+    parallel_for(0, nV, [&](int i) {
+        if (vmap[i] == PMP_MAX_INDEX)
+            return;
+        auto& vc = vconn_[Vertex(i)];
+        vc.halfedge_ = new_halfedge(vc.halfedge_);
+    });
+
+    parallel_for(0, 2 * nE, [&](int i) {
+        if (emap[i >> 1] == PMP_MAX_INDEX)
+            return;
+        auto& hc = hconn_[Halfedge(i)];
+        hc.vertex_ = Vertex(vmap[hc.vertex_.idx()]);
+        hc.next_halfedge_ = new_halfedge(hc.next_halfedge_);
+        hc.prev_halfedge_ = new_halfedge(hc.prev_halfedge_);
+        if (hc.face_.is_valid())
+            hc.face_ = Face(fmap[hc.face_.idx()]);
+    });
+
+    parallel_for(0, nF, [&](int i) {
+        if (fmap[i] == PMP_MAX_INDEX)
+            return;
+        auto& fc = fconn_[Face(i)];
+        fc.halfedge_ = new_halfedge(fc.halfedge_);
+    });
+
+    // relocate all property arrays, one task per array
+    std::vector<std::pair<BasePropertyArray*, const Moves*>> tasks;
+    for (auto a : vprops_.arrays())
+        tasks.emplace_back(a, &vmoves);
+    for (auto a : hprops_.arrays())
+        tasks.emplace_back(a, &hmoves);
+    for (auto a : eprops_.arrays())
+        tasks.emplace_back(a, &emoves);
+    for (auto a : fprops_.arrays())
+        tasks.emplace_back(a, &fmoves);
+
+    parallel_for(
+        0, int(tasks.size()),
+        [&](int i) { tasks[i].first->relocate(*tasks[i].second); },
+        1);
 
     // finally resize arrays
-    vprops_.resize(nV);
+    vprops_.resize(nV - deleted_vertices_);
     vprops_.free_memory();
-    hprops_.resize(nH);
+    hprops_.resize(2 * (nE - deleted_edges_));
     hprops_.free_memory();
-    eprops_.resize(nE);
+    eprops_.resize(nE - deleted_edges_);
     eprops_.free_memory();
-    fprops_.resize(nF);
+    fprops_.resize(nF - deleted_faces_);
     fprops_.free_memory();
 
     deleted_vertices_ = deleted_edges_ = deleted_faces_ = 0;
     has_garbage_ = false;
+    clear_free_lists();
+    rebuild_edge_index();
+}
+
+void SurfaceMesh::set_reuse_deleted(bool b)
+{
+    reuse_deleted_ = b;
+    if (!reuse_deleted_)
+        clear_free_lists();
+}
+
+void SurfaceMesh::clear_free_lists()
+{
+    std::vector<IndexType>().swap(free_vertices_);
+    std::vector<IndexType>().swap(free_edges_);
+    std::vector<IndexType>().swap(free_faces_);
+}
+
+void SurfaceMesh::set_edge_index(bool b)
+{
+    edge_index_enabled_ = b;
+    if (b)
+        rebuild_edge_index();
+    else
+        EdgeIndex().swap(edge_index_);
+}
+
+void SurfaceMesh::set_change_tracking(bool b)
+{
+    if (b)
+        clock_ = std::make_shared<std::atomic<uint64_t>>(1);
+    else
+        clock_.reset();
+
+    oprops_.track_changes(clock_);
+    vprops_.track_changes(clock_);
+    hprops_.track_changes(clock_);
+    eprops_.track_changes(clock_);
+    fprops_.track_changes(clock_);
+}
+
+uint64_t SurfaceMesh::topology_generation() const
+{
+    return std::max({vconn_.generation(), hconn_.generation(),
+                     fconn_.generation(), vdeleted_.generation(),
+                     edeleted_.generation(), fdeleted_.generation()});
+}
+
+std::vector<Vertex> SurfaceMesh::topology_changed_vertices(uint64_t g) const
+{
+    std::vector<Vertex> changed;
+    auto add = [&](Vertex v) {
+        if (!is_deleted(v))
+            changed.push_back(v);
+    };
+
+    for (auto i : vconn_.changed_since(g))
+        add(Vertex(IndexType(i)));
+    for (auto i : hconn_.changed_since(g))
+    {
+        const auto h = Halfedge(IndexType(i));
+        if (!is_deleted(edge(h)))
+        {
+            add(to_vertex(h));
+            add(from_vertex(h));
+        }
+    }
+    for (auto i : fconn_.changed_since(g))
+    {
+        const auto f = Face(IndexType(i));
+        if (!is_deleted(f))
+            for (auto v : vertices(f))
+                add(v);
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+void SurfaceMesh::set_indexed_vertex(Halfedge h, Vertex v)
+{
+    const Halfedge o = opposite_halfedge(h);
+    unindex_halfedge(h);
+    unindex_halfedge(o);
+    hconn_[h].vertex_ = v;
+    if (!edeleted_[edge(h)])
+    {
+        index_halfedge(h);
+        index_halfedge(o);
+    }
+}
+
+void SurfaceMesh::index_halfedge(Halfedge h)
+{
+    const Vertex from = to_vertex(opposite_halfedge(h));
+    const Vertex to = to_vertex(h);
+    if (from.is_valid() && to.is_valid())
+        edge_index_.emplace(std::make_pair(from.idx(), to.idx()), h);
+}
+
+void SurfaceMesh::unindex_halfedge(Halfedge h)
+{
+    const Vertex from = to_vertex(opposite_halfedge(h));
+    const Vertex to = to_vertex(h);
+    if (!from.is_valid() || !to.is_valid())
+        return;
+
+    auto range = edge_index_.equal_range(std::make_pair(from.idx(), to.idx()));
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second == h)
+        {
+            edge_index_.erase(it);
+            return;
+        }
+}
+
+void SurfaceMesh::rebuild_edge_index()
+{
+    if (!edge_index_enabled_)
+        return;
+
+    edge_index_.clear();
+    edge_index_.reserve(n_halfedges());
+    for (auto h : halfedges())
+        index_halfedge(h);
+}
+
+void SurfaceMesh::reorder()
+{
+    if (has_garbage())
+        garbage_collection();
+
+    const int nV(vertices_size()), nE(edges_size()), nF(faces_size());
+
+    // Morton code of quantized vertex positions
+    BoundingBox bb = bounds();
+    Point extent = bb.max() - bb.min();
+    Scalar scale = std::max(extent[0], std::max(extent[1], extent[2]));
+    scale = scale > 0 ? Scalar(0x1fffff) / scale : 0;
+
+    std::vector<uint64_t> codes(nV);
+    parallel_for(0, nV, [&](int i) {
+        Point q = (vpoint_[Vertex(i)] - bb.min()) * scale;
+        codes[i] = spread_bits(uint64_t(q[0])) |
+                   spread_bits(uint64_t(q[1])) << 1 |
+                   spread_bits(uint64_t(q[2])) << 2;
+    });
+
+    std::vector<size_t> vorder(nV);
+    std::iota(vorder.begin(), vorder.end(), 0);
+    std::stable_sort(vorder.begin(), vorder.end(),
+                     [&](size_t a, size_t b) { return codes[a] < codes[b]; });
+
+    // faces in the order they are first touched by the sorted vertices
+    std::vector<size_t> forder;
+    forder.reserve(nF);
+    std::vector<bool> visited(nF, false);
+    for (auto i : vorder)
+    {
+        if (is_isolated(Vertex(i)))
+            continue;
+        for (auto f : faces(Vertex(i)))
+        {
+            if (!visited[f.idx()])
+            {
+                visited[f.idx()] = true;
+                forder.push_back(f.idx());
+            }
+        }
+    }
+
+    // edges in the order of their first incident face, then the rest
+    std::vector<size_t> eorder;
+    eorder.reserve(nE);
+    visited.assign(nE, false);
+    for (auto i : forder)
+    {
+        for (auto h : halfedges(Face(i)))
+        {
+            IndexType e = edge(h).idx();
+            if (!visited[e])
+            {
+                visited[e] = true;
+                eorder.push_back(e);
+            }
+        }
+    }
+    for (int i = 0; i < nE; ++i)
+        if (!visited[i])
+            eorder.push_back(i);
+
+    permute(vorder, eorder, forder);
+}
+
+void SurfaceMesh::permute(const std::vector<size_t>& vorder,
+                          const std::vector<size_t>& eorder,
+                          const std::vector<size_t>& forder)
+{
+    const int nV(vertices_size()), nE(edges_size()), nF(faces_size());
+
+    // invert permutations to map old to new indices
+    std::vector<IndexType> vmap(nV), emap(nE), fmap(nF);
+    for (int i = 0; i < nV; ++i)
+        vmap[vorder[i]] = i;
+    for (int i = 0; i < nE; ++i)
+        emap[eorder[i]] = i;
+    for (int i = 0; i < nF; ++i)
+        fmap[forder[i]] = i;
+
+    std::vector<size_t> horder(2 * nE);
+    for (int i = 0; i < nE; ++i)
+    {
+        horder[2 * i] = 2 * eorder[i];
+        horder[2 * i + 1] = 2 * eorder[i] + 1;
+    }
+
+    auto new_halfedge = [&](Halfedge h) {
+        if (!h.is_valid())
+            return h;
+        return Halfedge((emap[h.idx() >> 1] << 1) + (h.idx() & 1));
+    };
+
+    // update connectivity in place, then permute all arrays
+    parallel_for(0, nV, [&](int i) {
+        auto& vc = vconn_[Vertex(i)];
+        vc.halfedge_ = new_halfedge(vc.halfedge_);
+    });
+
+    parallel_for(0, 2 * nE, [&](int i) {
+        auto& hc = hconn_[Halfedge(i)];
+        hc.vertex_ = Vertex(vmap[hc.vertex_.idx()]);
+        hc.next_halfedge_ = new_halfedge(hc.next_halfedge_);
+        hc.prev_halfedge_ = new_halfedge(hc.prev_halfedge_);
+        if (hc.face_.is_valid())
+            hc.face_ = Face(fmap[hc.face_.idx()]);
+    });
+
+    parallel_for(0, nF, [&](int i) {
+        auto& fc = fconn_[Face(i)];
+        fc.halfedge_ = new_halfedge(fc.halfedge_);
+    });
+
+    std::vector<std::pair<BasePropertyArray*, const std::vector<size_t>*>>
+        tasks;
+    for (auto a : vprops_.arrays())
+        tasks.emplace_back(a, &vorder);
+    for (auto a : hprops_.arrays())
+        tasks.emplace_back(a, &horder);
+    for (auto a : eprops_.arrays())
+        tasks.emplace_back(a, &eorder);
+    for (auto a : fprops_.arrays())
+        tasks.emplace_back(a, &forder);
+
+    parallel_for(
+        0, int(tasks.size()),
+        [&](int i) { tasks[i].first->permute(*tasks[i].second); },
+        1);
+
+    rebuild_edge_index();
 }
 
 } // namespace pmp
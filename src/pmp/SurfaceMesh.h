@@ -8,6 +8,8 @@
 #include <vector>
 #include <limits>
 #include <numeric>
+#include <unordered_map>
+#include <utility>
 
 #include "pmp/Types.h"
 #include "pmp/Properties.h"
@@ -15,7 +17,10 @@
 
 namespace pmp {
 
+class SurfaceComponents;
+class SurfaceMeshHistory;
 class SurfaceMeshIO;
+class MemoryArena;
 
 //! \addtogroup core
 //!@{
@@ -215,6 +220,33 @@ public:
     }
 };
 
+//! A violated connectivity invariant as reported by SurfaceMesh::validate().
+struct MeshDefect
+{
+    //! The invariants checked by SurfaceMesh::validate()
+    enum Type
+    {
+        InvalidReference, //!< a stored handle is out of range
+        DeletedReference, //!< a live element refers to a deleted element
+        DegenerateEdge,   //!< both halfedges of an edge point to one vertex
+        NextPrev,         //!< next and previous halfedges are inconsistent
+        FaceLoop,         //!< a face's halfedges do not form a closed loop
+        VertexHalfedge,   //!< a vertex's halfedge does not start at it
+        VertexLoop,       //!< the halfedges around a vertex do not close
+        OutgoingBoundary, //!< a boundary vertex's halfedge is not on the boundary
+        DeletedCount      //!< deletion flags disagree with deletion counters
+    };
+
+    //! the violated invariant
+    Type type;
+
+    //! index of the offending element, its kind is given in \p message
+    IndexType idx;
+
+    //! human-readable description of the defect
+    std::string message;
+};
+
 //! A halfedge data structure for polygonal meshes.
 class SurfaceMesh
 {
@@ -238,6 +270,9 @@ public:
         //! get the vertex the iterator refers to
         Vertex operator*() const { return handle_; }
 
+        //! get the mesh the iterator refers to
+        const SurfaceMesh* mesh() const { return mesh_; }
+
         //! are two iterators equal?
         bool operator==(const VertexIterator& rhs) const
         {
@@ -304,6 +339,9 @@ public:
         //! get the halfedge the iterator refers to
         Halfedge operator*() const { return handle_; }
 
+        //! get the mesh the iterator refers to
+        const SurfaceMesh* mesh() const { return mesh_; }
+
         //! are two iterators equal?
         bool operator==(const HalfedgeIterator& rhs) const
         {
@@ -369,6 +407,9 @@ public:
         //! get the edge the iterator refers to
         Edge operator*() const { return handle_; }
 
+        //! get the mesh the iterator refers to
+        const SurfaceMesh* mesh() const { return mesh_; }
+
         //! are two iterators equal?
         bool operator==(const EdgeIterator& rhs) const
         {
@@ -434,6 +475,9 @@ public:
         //! get the face the iterator refers to
         Face operator*() const { return handle_; }
 
+        //! get the mesh the iterator refers to
+        const SurfaceMesh* mesh() const { return mesh_; }
+
         //! are two iterators equal?
         bool operator==(const FaceIterator& rhs) const
         {
@@ -549,6 +593,70 @@ public:
         FaceIterator begin_, end_;
     };
 
+    //! \brief Helper class for iterating through all elements of a mesh
+    //! without garbage by a plain counted loop over their indices.
+    //! \details In contrast to the containers above, the iterator neither
+    //! checks for garbage nor skips deleted elements, such that compilers
+    //! can vectorize the loop. \sa dense_vertices(), dense_faces()
+    template <class HandleT>
+    class DenseRange
+    {
+    public:
+        //! iterator incrementing the index only
+        class Iterator
+        {
+        public:
+            //! default constructor
+            Iterator(IndexType idx = 0, const SurfaceMesh* mesh = nullptr)
+                : idx_(idx), mesh_(mesh)
+            {
+            }
+
+            //! get the element the iterator refers to
+            HandleT operator*() const { return HandleT(idx_); }
+
+            //! get the mesh the iterator refers to
+            const SurfaceMesh* mesh() const { return mesh_; }
+
+            //! are two iterators equal?
+            bool operator==(const Iterator& rhs) const
+            {
+                return idx_ == rhs.idx_;
+            }
+
+            //! are two iterators different?
+            bool operator!=(const Iterator& rhs) const
+            {
+                return idx_ != rhs.idx_;
+            }
+
+            //! pre-increment iterator
+            Iterator& operator++()
+            {
+                ++idx_;
+                return *this;
+            }
+
+        private:
+            IndexType idx_;
+            const SurfaceMesh* mesh_;
+        };
+
+        DenseRange(IndexType size, const SurfaceMesh* mesh)
+            : size_(size), mesh_(mesh)
+        {
+        }
+        Iterator begin() const { return Iterator(0, mesh_); }
+        Iterator end() const { return Iterator(size_, mesh_); }
+
+        //! number of elements in the range
+        IndexType size() const { return size_; }
+
+    private:
+        IndexType size_;
+        const SurfaceMesh* mesh_;
+    };
+
     //!@}
     //! \name Circulator Types
     //!@{
@@ -941,8 +1049,24 @@ public:
     SurfaceMesh(const SurfaceMesh& rhs) { operator=(rhs); }
 
     //! assign \p rhs to \p *this. performs a deep copy of all properties.
+    //! \note The property arrays share their elements until modified. Do not
+    //! copy a mesh while other threads modify it. The first modification of
+    //! a shared property replaces its storage and must not run concurrently
+    //! with reads of the same property, see PropertyArray::PropertyArray().
     SurfaceMesh& operator=(const SurfaceMesh& rhs);
 
+    //! move constructor: takes over all properties of \p rhs without copying
+    //! them. property handles of \p rhs stay valid and refer to \p *this.
+    //! \p rhs is left as a valid empty mesh with the standard properties,
+    //! which are allocated anew. Hence the move may throw std::bad_alloc.
+    SurfaceMesh(SurfaceMesh&& rhs);
+
+    //! move \p rhs to \p *this without copying properties. \p rhs is left
+    //! as a valid empty mesh, see SurfaceMesh(SurfaceMesh&&). While a
+    //! SurfaceMeshHistory records an edit, the properties are copied sharing
+    //! their elements instead.
+    SurfaceMesh& operator=(SurfaceMesh&& rhs);
+
     //! assign \p rhs to \p *this. does not copy custom properties.
     SurfaceMesh& assign(const SurfaceMesh& rhs);
 
@@ -963,7 +1087,15 @@ public:
     //! PMP    | no    | yes    | no      | no     | no
     //! XYZ    | yes   | no     | a       | no     | no
     //! AGI    | yes   | no     | a       | a      | no
+    //! PTS    | yes   | no     | no      | a      | no
+    //! PMC    | no    | yes    | b       | no     | b
+    //! SMA    | yes   | no     | no      | no     | no
+    //! SMB    | no    | yes    | no      | no     | no
     //!
+    //! SMA and SMB are the ASCII and binary streaming mesh formats, see
+    //! StreamingMeshReader.
+    //! Point clouds (XYZ, AGI, PTS) are parsed in parallel. Binary point
+    //! clouds with normals and colors are best stored as binary PLY.
     //! In addition, the OBJ and PMP formats support reading per-halfedge
     //! texture coordinates.
     void read(const std::string& filename, const IOFlags& flags = IOFlags());
@@ -976,11 +1108,21 @@ public:
     //! -------|-------|--------|---------|--------|----------
     //! OFF    | yes   | yes    | a       | a      | a
     //! OBJ    | yes   | no     | a       | no     | no
-    //! STL    | yes   | no     | no      | no     | no
+    //! STL    | yes   | yes    | no      | no     | no
     //! PLY    | yes   | yes    | no      | no     | no
     //! PMP    | no    | yes    | no      | no     | no
     //! XYZ    | yes   | no     | a       | no     | no
+    //! PMC    | no    | yes    | b       | no     | b
+    //! GLB    | no    | yes    | b       | b      | b
+    //! SMA    | yes   | no     | no      | no     | no
+    //! SMB    | no    | yes    | no      | no     | no
     //!
+    //! GLB files contain a glTF 2.0 scene with indexed triangles and
+    //! interleaved vertex attributes, polygons are triangulated. PMC files
+    //! are compressed for transport, see SurfaceMeshIO::encode(). Streaming
+    //! meshes are written in a spatially coherent order, see
+    //! StreamingMeshWriter. STL files store the face normals, which are
+    //! computed if the mesh has none.
     //! In addition, the OBJ and PMP formats support writing per-halfedge
     //! texture coordinates.
     void write(const std::string& filename,
@@ -1006,6 +1148,43 @@ public:
     //! \sa add_triangle, add_face
     Face add_quad(Vertex v0, Vertex v1, Vertex v2, Vertex v3);
 
+    //! \brief Build the mesh from an indexed face set in a single pass.
+    //! \details Replaces the current contents of the mesh. \p indices holds
+    //! the vertex indices of all faces one after another, \p face_sizes the
+    //! number of vertices of each face. If \p face_sizes is empty, all faces
+    //! are assumed to be triangles. Opposite halfedges are matched by
+    //! bucketing the edges by their smaller vertex index instead of searching
+    //! vertex rings, which makes this considerably faster than calling
+    //! add_face() for each face. The resulting mesh is identical to the one
+    //! built by add_face(), including the numbering of edges and the
+    //! halfedges of vertices and faces, so that later operations such as
+    //! triangulate() give the same results.
+    //! \throw InvalidInputException if an index is out of range or a face has
+    //! less than three vertices.
+    //! \throw TopologyException if the input is not a manifold polygon mesh.
+    //! The mesh is empty in this case.
+    //! \sa add_face()
+    void from_indexed_faces(const std::vector<Point>& points,
+                            const std::vector<IndexType>& indices,
+                            const std::vector<IndexType>& face_sizes =
+                                std::vector<IndexType>());
+
+    //! \brief Append a copy of the elements of \p other.
+    //! \details The elements are added after the existing ones and their
+    //! connectivity is shifted by the numbers of existing elements, without
+    //! searching for halfedges, so the parts stay disconnected even where
+    //! they touch. Vertex, halfedge, edge, and face properties of \p other
+    //! that exist in \p *this with the same type are copied block-wise, the
+    //! other properties of \p *this get their default values for the new
+    //! elements. Deleted elements stay deleted.
+    void append(const SurfaceMesh& other);
+
+    //! \brief Append copies of the elements of all \p meshes.
+    //! \details Same as calling append(const SurfaceMesh&) for each mesh in
+    //! turn, but the space for all meshes is allocated at once and the
+    //! meshes are copied into their ranges in parallel.
+    void append(const std::vector<SurfaceMesh>& meshes);
+
     //!@}
     //! \name Memory Management
     //!@{
@@ -1046,9 +1225,109 @@ public:
     //! reserve memory (mainly used in file readers)
     void reserve(size_t nvertices, size_t nedges, size_t nfaces);
 
-    //! remove deleted elements
+    //! \brief Reserve memory for the standard properties in \p arena.
+    //! \details Positions and connectivity are moved to arena memory with
+    //! room for the given numbers of elements, see move_to_arena(). The mesh
+    //! keeps using the arena until it grows beyond these numbers, so \p arena
+    //! must not be reset while the mesh is alive. Copies of the mesh use
+    //! internal storage.
+    void reserve(size_t nvertices, size_t nedges, size_t nfaces,
+                 MemoryArena& arena);
+
+    //! \brief Remove deleted elements.
+    //! \details The remaining elements are compacted by moving the last
+    //! non-deleted elements into the slots of deleted ones. The element
+    //! mappings are computed once, afterwards all property arrays are
+    //! relocated in parallel.
     void garbage_collection();
 
+    //! \brief are there any deleted elements?
+    //! \details If not, loops can iterate densely over all indices, see
+    //! dense_vertices().
+    bool has_garbage() const { return has_garbage_; }
+
+    //! \brief Remove deleted elements and report the old-to-new handle mapping.
+    //! \details After the call, \p vmap[i] is the new handle of the vertex
+    //! that had index \p i before, or an invalid handle if it has been
+    //! removed. The same holds for \p hmap, \p emap, and \p fmap.
+    //! \sa garbage_collection()
+    void garbage_collection(std::vector<Vertex>& vmap,
+                            std::vector<Halfedge>& hmap,
+                            std::vector<Edge>& emap, std::vector<Face>& fmap);
+
+    //! \brief Enable or disable reuse of deleted elements.
+    //! \details If enabled, elements deleted from now on are kept in free
+    //! lists and new_vertex(), new_edge(), and new_face() take their slots
+    //! instead of growing the property arrays. All properties of a reused
+    //! element are reset to their default values. Keeps memory usage flat
+    //! during long editing sessions without calling garbage_collection().
+    //! \note Reused elements may have smaller indices than existing ones,
+    //! so loops adding elements while iterating might skip them.
+    void set_reuse_deleted(bool b);
+
+    //! returns whether deleted elements are reused
+    //! \sa set_reuse_deleted()
+    bool reuse_deleted() const { return reuse_deleted_; }
+
+    //! \brief Enable or disable the edge index.
+    //! \details If enabled, the mesh maintains a hash map from vertex pairs
+    //! to halfedges that is kept up to date by all operations modifying the
+    //! connectivity, e.g., add_face(), flip(), collapse(), and split(). This
+    //! makes find_halfedge() and find_edge() take constant instead of
+    //! O(valence) time, which pays off for high-valence vertices, at the cost
+    //! of additional memory and slower connectivity updates.
+    void set_edge_index(bool b);
+
+    //! returns whether the edge index is enabled
+    //! \sa set_edge_index()
+    bool has_edge_index() const { return edge_index_enabled_; }
+
+    //! \brief Enable or disable change tracking of all properties.
+    //! \details If enabled, every element written through non-const property
+    //! access is stamped with the current generation, see new_generation().
+    //! Consumers remember a generation and later ask a property which
+    //! elements changed since then using Property::changed_since(), or
+    //! whether anything changed using Property::generation(). Topological
+    //! operations like flip(), collapse(), split(), and insert_vertex()
+    //! write the connectivity properties and are thus tracked as well, see
+    //! topology_generation(). Copies of the mesh start with fresh stamps.
+    //! \note Access through Property::vector() stamps all elements.
+    void set_change_tracking(bool b);
+
+    //! returns whether change tracking is enabled
+    //! \sa set_change_tracking()
+    bool change_tracking() const { return clock_ != nullptr; }
+
+    //! \brief Start a new generation and return the previous one.
+    //! \details Modifications from now on are stamped with a later
+    //! generation than the returned one. Returns zero if change tracking is
+    //! disabled.
+    //! \sa set_change_tracking()
+    uint64_t new_generation() { return clock_ ? clock_->fetch_add(1) : 0; }
+
+    //! \brief Generation of the latest change of the connectivity.
+    //! \details Covers added, deleted, and re-linked elements.
+    //! \sa set_change_tracking()
+    uint64_t topology_generation() const;
+
+    //! \brief Vertices whose one-ring changed after generation \p g.
+    //! \details Collects the vertices with modified connectivity, the end
+    //! points of modified halfedges, and the vertices of modified faces.
+    //! Deleted elements are skipped. The result is sorted. Empty if change
+    //! tracking is disabled.
+    //! \sa set_change_tracking()
+    std::vector<Vertex> topology_changed_vertices(uint64_t g) const;
+
+    //! \brief Reorder all elements to improve memory locality.
+    //! \details Vertices are sorted along a Morton (Z-order) curve of their
+    //! positions. Faces are emitted in the order in which they are first
+    //! touched by the sorted vertices, which keeps the vertices of subsequent
+    //! faces close together and suits GPU vertex caches. Edges follow the
+    //! order of their first incident face. All property arrays are permuted
+    //! accordingly, deleted elements are removed before.
+    //! \note Invalidates all handles to mesh elements.
+    void reorder();
+
     //! returns whether vertex \p v is deleted
     //! \sa garbage_collection()
     bool is_deleted(Vertex v) const { return vdeleted_[v]; }
@@ -1126,7 +1405,13 @@ public:
     }
 
     //! sets the vertex the halfedge \p h points to to \p v
-    inline void set_vertex(Halfedge h, Vertex v) { hconn_[h].vertex_ = v; }
+    inline void set_vertex(Halfedge h, Vertex v)
+    {
+        if (edge_index_enabled_)
+            set_indexed_vertex(h, v);
+        else
+            hconn_[h].vertex_ = v;
+    }
 
     //! returns the face incident to halfedge \p h
     Face face(Halfedge h) const { return hconn_[h].face_; }
@@ -1510,9 +1795,113 @@ public:
         return fprops_.properties();
     }
 
-    //! prints the names of all properties
+    //! prints the names and memory usage of all properties
     void property_stats() const;
 
+    //! \brief Report the memory used by each property of the mesh.
+    //! \details Lists object, vertex, halfedge, edge, and face properties in
+    //! this order, PropertyMemory::container tells them apart.
+    std::vector<PropertyMemory> memory_usage() const;
+
+    //! total number of bytes owned by all properties of the mesh
+    size_t memory_bytes() const;
+
+    //! get the vertex property with key \p key of type \p T in constant
+    //! time. returns an invalid VertexProperty if the property does not exist or
+    //! if the type does not match.
+    template <class T>
+    VertexProperty<T> get_vertex_property(const PropertyKey& key) const
+    {
+        return VertexProperty<T>(vprops_.get<T>(key));
+    }
+
+    //! if a vertex property of type \p T with key \p key exists, it is
+    //! returned. otherwise this property is added (with default value \c
+    //! t)
+    template <class T>
+    VertexProperty<T> vertex_property(const PropertyKey& key, const T t = T())
+    {
+        return VertexProperty<T>(vprops_.get_or_add<T>(key, t));
+    }
+
+    //! does the mesh have a vertex property with key \p key?
+    bool has_vertex_property(const PropertyKey& key) const
+    {
+        return vprops_.exists(key);
+    }
+
+    //! get the halfedge property with key \p key of type \p T in constant
+    //! time. returns an invalid HalfedgeProperty if the property does not exist or
+    //! if the type does not match.
+    template <class T>
+    HalfedgeProperty<T> get_halfedge_property(const PropertyKey& key) const
+    {
+        return HalfedgeProperty<T>(hprops_.get<T>(key));
+    }
+
+    //! if a halfedge property of type \p T with key \p key exists, it is
+    //! returned. otherwise this property is added (with default value \c
+    //! t)
+    template <class T>
+    HalfedgeProperty<T> halfedge_property(const PropertyKey& key, const T t = T())
+    {
+        return HalfedgeProperty<T>(hprops_.get_or_add<T>(key, t));
+    }
+
+    //! does the mesh have a halfedge property with key \p key?
+    bool has_halfedge_property(const PropertyKey& key) const
+    {
+        return hprops_.exists(key);
+    }
+
+    //! get the edge property with key \p key of type \p T in constant
+    //! time. returns an invalid EdgeProperty if the property does not exist or
+    //! if the type does not match.
+    template <class T>
+    EdgeProperty<T> get_edge_property(const PropertyKey& key) const
+    {
+        return EdgeProperty<T>(eprops_.get<T>(key));
+    }
+
+    //! if an edge property of type \p T with key \p key exists, it is
+    //! returned. otherwise this property is added (with default value \c
+    //! t)
+    template <class T>
+    EdgeProperty<T> edge_property(const PropertyKey& key, const T t = T())
+    {
+        return EdgeProperty<T>(eprops_.get_or_add<T>(key, t));
+    }
+
+    //! does the mesh have an edge property with key \p key?
+    bool has_edge_property(const PropertyKey& key) const
+    {
+        return eprops_.exists(key);
+    }
+
+    //! get the face property with key \p key of type \p T in constant
+    //! time. returns an invalid FaceProperty if the property does not exist or
+    //! if the type does not match.
+    template <class T>
+    FaceProperty<T> get_face_property(const PropertyKey& key) const
+    {
+        return FaceProperty<T>(fprops_.get<T>(key));
+    }
+
+    //! if a face property of type \p T with key \p key exists, it is
+    //! returned. otherwise this property is added (with default value \c
+    //! t)
+    template <class T>
+    FaceProperty<T> face_property(const PropertyKey& key, const T t = T())
+    {
+        return FaceProperty<T>(fprops_.get_or_add<T>(key, t));
+    }
+
+    //! does the mesh have a face property with key \p key?
+    bool has_face_property(const PropertyKey& key) const
+    {
+        return fprops_.exists(key);
+    }
+
     //!@}
     //! \name Iterators and circulators
     //!@{
@@ -1595,6 +1984,42 @@ public:
         return FaceContainer(faces_begin(), faces_end());
     }
 
+    //! \brief returns all vertices for counted loops without deletion
+    //! checks, see DenseRange.
+    //! \pre The mesh has no garbage, see garbage_collection().
+    DenseRange<Vertex> dense_vertices() const
+    {
+        assert(!has_garbage());
+        return DenseRange<Vertex>(IndexType(vertices_size()), this);
+    }
+
+    //! \brief returns all halfedges for counted loops without deletion
+    //! checks, see DenseRange.
+    //! \pre The mesh has no garbage, see garbage_collection().
+    DenseRange<Halfedge> dense_halfedges() const
+    {
+        assert(!has_garbage());
+        return DenseRange<Halfedge>(IndexType(halfedges_size()), this);
+    }
+
+    //! \brief returns all edges for counted loops without deletion checks,
+    //! see DenseRange.
+    //! \pre The mesh has no garbage, see garbage_collection().
+    DenseRange<Edge> dense_edges() const
+    {
+        assert(!has_garbage());
+        return DenseRange<Edge>(IndexType(edges_size()), this);
+    }
+
+    //! \brief returns all faces for counted loops without deletion checks,
+    //! see DenseRange.
+    //! \pre The mesh has no garbage, see garbage_collection().
+    DenseRange<Face> dense_faces() const
+    {
+        assert(!has_garbage());
+        return DenseRange<Face>(IndexType(faces_size()), this);
+    }
+
     //! returns circulator for faces around vertex \p v
     FaceAroundVertexCirculator faces(Vertex v) const
     {
@@ -1660,7 +2085,20 @@ public:
     //! each face, and therefore is not very efficient.
     bool is_quad_mesh() const;
 
-    //! triangulate the entire mesh, by calling triangulate(Face) for each face.
+    //! \brief Check all connectivity invariants of the mesh in parallel.
+    //! \details Checks opposite halfedges, next/previous links, face loops,
+    //! vertex halfedges and their boundary convention, references to deleted
+    //! elements, and the deletion counters. Deleted elements themselves are
+    //! not checked. Defects are ordered by vertices, halfedges, faces, and
+    //! counters, then by element index.
+    //! \return the defects found, empty for a valid mesh
+    std::vector<MeshDefect> validate() const;
+
+    //! \brief Triangulate the entire mesh.
+    //! \details Gives the same result as calling triangulate(Face) for each
+    //! face in order, including the numbering of the new elements and the
+    //! halfedges of the faces, but allocates all new edges and faces at once
+    //! and splits the faces in parallel. Deleted elements are not reused.
     //! \sa triangulate(Face)
     void triangulate();
 
@@ -1769,15 +2207,21 @@ public:
     //! position of a vertex
     Point& position(Vertex v) { return vpoint_[v]; }
 
-    //! vector of point positions, re-implemented from \p GeometryObject
+    //! \brief vector of point positions, re-implemented from
+    //! \p GeometryObject
+    //! \details Copies of the mesh do not share the positions afterwards,
+    //! and writing single positions takes a slower path, until the positions
+    //! are unpinned, see PropertyArray::vector() and PropertyArray::unpin().
     std::vector<Point>& positions() { return vpoint_.vector(); }
 
     //! compute the bounding box of the object
     BoundingBox bounds()
     {
+        // read without pinning the positions
+        const Property<Point>& points = vpoint_;
         BoundingBox bb;
-        for (auto p : positions())
-            bb += p;
+        for (size_t i = 0; i < points.size(); ++i)
+            bb += points[i];
         return bb;
     }
 
@@ -1799,6 +2243,12 @@ private:
         //! an outgoing halfedge per vertex (it will be a boundary halfedge
         //! for boundary vertices)
         Halfedge halfedge_;
+
+        //! are the connectivities equal?
+        bool operator==(const VertexConnectivity& rhs) const
+        {
+            return halfedge_ == rhs.halfedge_;
+        }
     };
 
     //! This type stores the halfedge connectivity
@@ -1808,6 +2258,14 @@ private:
         Vertex vertex_;          //!< vertex the halfedge points to
         Halfedge next_halfedge_; //!< next halfedge
         Halfedge prev_halfedge_; //!< previous halfedge
+
+        //! are the connectivities equal?
+        bool operator==(const HalfedgeConnectivity& rhs) const
+        {
+            return face_ == rhs.face_ && vertex_ == rhs.vertex_ &&
+                   next_halfedge_ == rhs.next_halfedge_ &&
+                   prev_halfedge_ == rhs.prev_halfedge_;
+        }
     };
 
     //! This type stores the face connectivity
@@ -1815,6 +2273,12 @@ private:
     struct FaceConnectivity
     {
         Halfedge halfedge_; //!< a halfedge that is part of the face
+
+        //! are the connectivities equal?
+        bool operator==(const FaceConnectivity& rhs) const
+        {
+            return halfedge_ == rhs.halfedge_;
+        }
     };
 
     //!@}
@@ -1833,10 +2297,36 @@ public:
                 "SurfaceMesh: cannot allocate vertex, max. index reached";
             throw AllocationException(what);
         }
+        if (!free_vertices_.empty())
+        {
+            Vertex v(free_vertices_.back());
+            free_vertices_.pop_back();
+            vprops_.reset(v.idx());
+            --deleted_vertices_;
+            update_garbage_status();
+            return v;
+        }
         vprops_.push_back();
         return Vertex(vertices_size() - 1);
     }
 
+    //! \brief Allocate \p n new vertices at once, resize vertex properties
+    //! accordingly.
+    //! \details Unlike new_vertex(), deleted vertices are not reused.
+    //! \return The first new vertex, the others follow consecutively.
+    //! \throw AllocationException if the max. index would be exceeded.
+    Vertex new_vertices(size_t n)
+    {
+        if (n >= PMP_MAX_INDEX - 1 - vertices_size())
+        {
+            auto what =
+                "SurfaceMesh: cannot allocate vertices, max. index reached";
+            throw AllocationException(what);
+        }
+        vprops_.resize(vertices_size() + n);
+        return Vertex(IndexType(vertices_size() - n));
+    }
+
     //! \brief Allocate a new edge, resize edge and halfedge properties accordingly.
     //! \throw AllocationException in case of failure to allocate a new edge.
     Halfedge new_edge()
@@ -1847,6 +2337,9 @@ public:
             throw AllocationException(what);
         }
 
+        if (!free_edges_.empty())
+            return reuse_edge();
+
         eprops_.push_back();
         hprops_.push_back();
         hprops_.push_back();
@@ -1871,12 +2364,21 @@ public:
             throw AllocationException(what);
         }
 
-        eprops_.push_back();
-        hprops_.push_back();
-        hprops_.push_back();
+        Halfedge h0, h1;
+        if (!free_edges_.empty())
+        {
+            h0 = reuse_edge();
+            h1 = opposite_halfedge(h0);
+        }
+        else
+        {
+            eprops_.push_back();
+            hprops_.push_back();
+            hprops_.push_back();
 
-        Halfedge h0(halfedges_size() - 2);
-        Halfedge h1(halfedges_size() - 1);
+            h0 = Halfedge(halfedges_size() - 2);
+            h1 = Halfedge(halfedges_size() - 1);
+        }
 
         set_vertex(h0, end);
         set_vertex(h1, start);
@@ -1884,6 +2386,26 @@ public:
         return h0;
     }
 
+    //! \brief Allocate \p n new edges at once, resize edge and halfedge
+    //! properties accordingly.
+    //! \details Unlike new_edge(), deleted edges are not reused. The
+    //! halfedges of the new edges are not connected yet.
+    //! \return The first halfedge of the first new edge, the others follow
+    //! consecutively.
+    //! \throw AllocationException if the max. index would be exceeded.
+    Halfedge new_edges(size_t n)
+    {
+        if (2 * n >= PMP_MAX_INDEX - 1 - halfedges_size())
+        {
+            auto what =
+                "SurfaceMesh: cannot allocate edges, max. index reached";
+            throw AllocationException(what);
+        }
+        eprops_.resize(edges_size() + n);
+        hprops_.resize(halfedges_size() + 2 * n);
+        return Halfedge(IndexType(halfedges_size() - 2 * n));
+    }
+
     //! \brief Allocate a new face, resize face properties accordingly.
     //! \throw AllocationException in case of failure to allocate a new face.
     Face new_face()
@@ -1894,10 +2416,36 @@ public:
             throw AllocationException(what);
         }
 
+        if (!free_faces_.empty())
+        {
+            Face f(free_faces_.back());
+            free_faces_.pop_back();
+            fprops_.reset(f.idx());
+            --deleted_faces_;
+            update_garbage_status();
+            return f;
+        }
         fprops_.push_back();
         return Face(faces_size() - 1);
     }
 
+    //! \brief Allocate \p n new faces at once, resize face properties
+    //! accordingly.
+    //! \details Unlike new_face(), deleted faces are not reused.
+    //! \return The first new face, the others follow consecutively.
+    //! \throw AllocationException if the max. index would be exceeded.
+    Face new_faces(size_t n)
+    {
+        if (n >= PMP_MAX_INDEX - 1 - faces_size())
+        {
+            auto what =
+                "SurfaceMesh: cannot allocate faces, max. index reached";
+            throw AllocationException(what);
+        }
+        fprops_.resize(faces_size() + n);
+        return Face(IndexType(faces_size() - n));
+    }
+
     //!@}
 
 private:
@@ -1911,17 +2459,100 @@ private:
     //! Helper for halfedge collapse
     void remove_edge_helper(Halfedge h);
 
+    //! mark vertex \p v as deleted, remember it for reuse if enabled
+    void mark_deleted(Vertex v)
+    {
+        vdeleted_[v] = true;
+        ++deleted_vertices_;
+        if (reuse_deleted_)
+            free_vertices_.push_back(v.idx());
+    }
+
+    //! mark edge \p e as deleted, remember it for reuse if enabled
+    void mark_deleted(Edge e)
+    {
+        if (edge_index_enabled_)
+        {
+            unindex_halfedge(halfedge(e, 0));
+            unindex_halfedge(halfedge(e, 1));
+        }
+        edeleted_[e] = true;
+        ++deleted_edges_;
+        if (reuse_deleted_)
+            free_edges_.push_back(e.idx());
+    }
+
+    //! mark face \p f as deleted, remember it for reuse if enabled
+    void mark_deleted(Face f)
+    {
+        fdeleted_[f] = true;
+        ++deleted_faces_;
+        if (reuse_deleted_)
+            free_faces_.push_back(f.idx());
+    }
+
+    //! take a deleted edge from the free list and reset its properties
+    Halfedge reuse_edge()
+    {
+        Edge e(free_edges_.back());
+        free_edges_.pop_back();
+        eprops_.reset(e.idx());
+        hprops_.reset(2 * e.idx());
+        hprops_.reset(2 * e.idx() + 1);
+        --deleted_edges_;
+        update_garbage_status();
+        return halfedge(e, 0);
+    }
+
+    //! forget all deleted elements available for reuse
+    void clear_free_lists();
+
+    //! set_vertex() keeping the edge index up to date
+    void set_indexed_vertex(Halfedge h, Vertex v);
+
+    //! add \p h to the edge index if both its vertices are valid
+    void index_halfedge(Halfedge h);
+
+    //! remove \p h from the edge index
+    void unindex_halfedge(Halfedge h);
+
+    //! rebuild the edge index from scratch if it is enabled
+    void rebuild_edge_index();
+
+    //! reset the garbage flag once all deleted elements have been reused
+    void update_garbage_status()
+    {
+        has_garbage_ =
+            deleted_vertices_ > 0 || deleted_edges_ > 0 || deleted_faces_ > 0;
+    }
+
     //! Helper for halfedge collapse
     void remove_loop_helper(Halfedge h);
 
-    //! are there any deleted entities?
-    inline bool has_garbage() const { return has_garbage_; }
+    //! Helper for garbage collection: compacts all elements and stores the
+    //! new index of every element (PMP_MAX_INDEX if deleted) in the maps.
+    void compact(std::vector<IndexType>& vmap, std::vector<IndexType>& emap,
+                 std::vector<IndexType>& fmap);
+
+    //! Helper for append: copies all \p meshes behind the existing elements.
+    void append_meshes(const std::vector<const SurfaceMesh*>& meshes);
+
+    //! Helper for reorder: permutes all elements such that new element i is
+    //! old element order[i].
+    void permute(const std::vector<size_t>& vorder,
+                 const std::vector<size_t>& eorder,
+                 const std::vector<size_t>& forder);
+
+    //! exchange all properties and status of \p *this and \p rhs
+    void swap(SurfaceMesh& rhs) noexcept;
 
     //!@}
     //! \name Private members
     //!@{
 
     friend SurfaceMeshIO;
+    friend SurfaceComponents;
+    friend SurfaceMeshHistory;
 
     // property containers for each entity type and object
     PropertyContainer oprops_;
@@ -1951,6 +2582,38 @@ private:
     // indicate garbage present
     bool has_garbage_;
 
+    // reuse deleted elements when allocating new ones?
+    bool reuse_deleted_;
+
+    // deleted elements available for reuse
+    std::vector<IndexType> free_vertices_;
+    std::vector<IndexType> free_edges_;
+    std::vector<IndexType> free_faces_;
+
+    // hash of a (from, to) vertex index pair
+    struct VertexPairHash
+    {
+        size_t operator()(const std::pair<IndexType, IndexType>& p) const
+        {
+            uint64_t k = (uint64_t(p.first) << 32) ^ uint64_t(p.second);
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            return size_t(k);
+        }
+    };
+
+    // optional index from (from, to) vertices to halfedges. a multimap
+    // since operators may temporarily create duplicate edges.
+    typedef std::unordered_multimap<std::pair<IndexType, IndexType>,
+                                    Halfedge, VertexPairHash>
+        EdgeIndex;
+    bool edge_index_enabled_;
+    EdgeIndex edge_index_;
+
+    // generation counter for change tracking, null if disabled
+    std::shared_ptr<std::atomic<uint64_t>> clock_;
+
     // helper data for add_face()
     typedef std::pair<Halfedge, Halfedge> NextCacheEntry;
     typedef std::vector<NextCacheEntry> NextCache;
@@ -0,0 +1,301 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/SurfaceMeshHistory.h"
+
+#include <limits>
+
+namespace pmp {
+
+namespace {
+
+// the array of container c named name, null if there is none
+BasePropertyArray* find_array(const PropertyContainer& c,
+                              const std::string& name)
+{
+    for (auto a : c.arrays())
+        if (a->name() == name)
+            return a;
+    return nullptr;
+}
+
+} // namespace
+
+SurfaceMeshHistory::SurfaceMeshHistory(SurfaceMesh& mesh)
+    : mesh_(mesh),
+      recording_(false),
+      memory_limit_(std::numeric_limits<size_t>::max())
+{
+}
+
+SurfaceMeshHistory::~SurfaceMeshHistory()
+{
+    clear();
+}
+
+std::vector<PropertyContainer*> SurfaceMeshHistory::containers() const
+{
+    return {&mesh_.oprops_, &mesh_.vprops_, &mesh_.hprops_, &mesh_.eprops_,
+            &mesh_.fprops_};
+}
+
+void SurfaceMeshHistory::begin()
+{
+    if (recording_)
+        throw InvalidInputException(
+            "SurfaceMeshHistory: Already recording an edit.");
+
+    start();
+    recording_ = true;
+}
+
+void SurfaceMeshHistory::commit(const std::string& name)
+{
+    if (!recording_)
+        throw InvalidInputException("SurfaceMeshHistory: Not recording.");
+
+    for (auto c : containers())
+        if (!c->records_delta())
+        {
+            recording_ = false;
+            clear();
+            throw InvalidInputException(
+                "SurfaceMeshHistory: Mesh replaced while recording.");
+        }
+
+    Edit edit = finish();
+    recording_ = false;
+
+    // did the edit modify anything?
+    bool modified = edit.deleted_vertices != mesh_.deleted_vertices_ ||
+                    edit.deleted_edges != mesh_.deleted_edges_ ||
+                    edit.deleted_faces != mesh_.deleted_faces_ ||
+                    edit.has_garbage != mesh_.has_garbage_ ||
+                    edit.free_vertices != mesh_.free_vertices_ ||
+                    edit.free_edges != mesh_.free_edges_ ||
+                    edit.free_faces != mesh_.free_faces_;
+    for (const auto& p : edit.props)
+        modified = modified || !p->arrays.empty() || !p->removed.empty() ||
+                   !p->added.empty();
+    if (!modified)
+        return;
+
+    edit.name = name;
+    redo_.clear();
+    undo_.push_back(std::move(edit));
+    enforce_memory_limit();
+}
+
+void SurfaceMeshHistory::rollback()
+{
+    if (!recording_)
+        throw InvalidInputException("SurfaceMeshHistory: Not recording.");
+
+    Edit edit = finish();
+    recording_ = false;
+    restore(edit);
+}
+
+void SurfaceMeshHistory::assign(const SurfaceMesh& mesh,
+                                const std::string& name)
+{
+    if (recording_)
+        throw InvalidInputException(
+            "SurfaceMeshHistory: Already recording an edit.");
+    if (&mesh == &mesh_)
+        return;
+
+    begin();
+
+    const std::vector<const PropertyContainer*> sources = {
+        &mesh.oprops_, &mesh.vprops_, &mesh.hprops_, &mesh.eprops_,
+        &mesh.fprops_};
+    const auto targets = containers();
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        PropertyContainer& dst = *targets[i];
+        const PropertyContainer& src = *sources[i];
+
+        // remove the properties missing in mesh or having another type
+        for (const auto& p : dst.properties())
+        {
+            BasePropertyArray* a = find_array(src, p);
+            if (!a || a->type() != find_array(dst, p)->type())
+                dst.remove(p);
+        }
+
+        // write the elements that differ, or clone added properties
+        dst.resize(src.size());
+        for (size_t j = 0; j < src.arrays().size(); ++j)
+        {
+            const BasePropertyArray* a = src.arrays()[j];
+            if (BasePropertyArray* b = find_array(dst, a->name()))
+                b->assign_changed(*a);
+            else
+                dst.insert(std::unique_ptr<BasePropertyArray>(a->clone()), j);
+        }
+    }
+
+    mesh_.deleted_vertices_ = mesh.deleted_vertices_;
+    mesh_.deleted_edges_ = mesh.deleted_edges_;
+    mesh_.deleted_faces_ = mesh.deleted_faces_;
+    mesh_.has_garbage_ = mesh.has_garbage_;
+    mesh_.free_vertices_ = mesh.free_vertices_;
+    mesh_.free_edges_ = mesh.free_edges_;
+    mesh_.free_faces_ = mesh.free_faces_;
+    update_mesh();
+
+    commit(name);
+}
+
+std::string SurfaceMeshHistory::undo_name() const
+{
+    return undo_.empty() ? std::string() : undo_.back().name;
+}
+
+std::string SurfaceMeshHistory::redo_name() const
+{
+    return redo_.empty() ? std::string() : redo_.back().name;
+}
+
+void SurfaceMeshHistory::undo()
+{
+    if (recording_)
+        throw InvalidInputException(
+            "SurfaceMeshHistory: Cannot undo while recording.");
+    if (undo_.empty())
+        throw InvalidInputException("SurfaceMeshHistory: Nothing to undo.");
+
+    Edit edit = std::move(undo_.back());
+    undo_.pop_back();
+    redo_.push_back(apply(edit));
+}
+
+void SurfaceMeshHistory::redo()
+{
+    if (recording_)
+        throw InvalidInputException(
+            "SurfaceMeshHistory: Cannot redo while recording.");
+    if (redo_.empty())
+        throw InvalidInputException("SurfaceMeshHistory: Nothing to redo.");
+
+    Edit edit = std::move(redo_.back());
+    redo_.pop_back();
+    undo_.push_back(apply(edit));
+    enforce_memory_limit();
+}
+
+void SurfaceMeshHistory::clear()
+{
+    if (recording_)
+    {
+        finish();
+        recording_ = false;
+    }
+    undo_.clear();
+    redo_.clear();
+}
+
+size_t SurfaceMeshHistory::memory_usage() const
+{
+    size_t bytes = 0;
+    for (const auto& e : undo_)
+        bytes += e.bytes;
+    for (const auto& e : redo_)
+        bytes += e.bytes;
+    return bytes;
+}
+
+void SurfaceMeshHistory::set_memory_limit(size_t bytes)
+{
+    memory_limit_ = bytes;
+    enforce_memory_limit();
+}
+
+void SurfaceMeshHistory::start()
+{
+    edit_ = Edit();
+    for (auto c : containers())
+        c->begin_delta();
+
+    edit_.deleted_vertices = mesh_.deleted_vertices_;
+    edit_.deleted_edges = mesh_.deleted_edges_;
+    edit_.deleted_faces = mesh_.deleted_faces_;
+    edit_.has_garbage = mesh_.has_garbage_;
+    edit_.free_vertices = mesh_.free_vertices_;
+    edit_.free_edges = mesh_.free_edges_;
+    edit_.free_faces = mesh_.free_faces_;
+}
+
+SurfaceMeshHistory::Edit SurfaceMeshHistory::finish()
+{
+    Edit edit = std::move(edit_);
+    const auto cs = containers();
+    edit.bytes = sizeof(Edit) + sizeof(IndexType) * (edit.free_vertices.size() +
+                                                     edit.free_edges.size() +
+                                                     edit.free_faces.size());
+    for (size_t i = 0; i < cs.size(); ++i)
+    {
+        if (cs[i]->records_delta())
+            edit.props[i] = cs[i]->end_delta();
+        else
+            edit.props[i].reset(new PropertyContainerDelta);
+        edit.bytes += edit.props[i]->memory_usage();
+    }
+    return edit;
+}
+
+void SurfaceMeshHistory::restore(Edit& edit)
+{
+    const auto cs = containers();
+    for (size_t i = 0; i < cs.size(); ++i)
+        cs[i]->apply_delta(*edit.props[i]);
+
+    mesh_.deleted_vertices_ = edit.deleted_vertices;
+    mesh_.deleted_edges_ = edit.deleted_edges;
+    mesh_.deleted_faces_ = edit.deleted_faces;
+    mesh_.has_garbage_ = edit.has_garbage;
+    mesh_.free_vertices_.swap(edit.free_vertices);
+    mesh_.free_edges_.swap(edit.free_edges);
+    mesh_.free_faces_.swap(edit.free_faces);
+    update_mesh();
+}
+
+SurfaceMeshHistory::Edit SurfaceMeshHistory::apply(Edit& edit)
+{
+    start();
+    restore(edit);
+    Edit inverse = finish();
+    inverse.name = edit.name;
+    return inverse;
+}
+
+void SurfaceMeshHistory::update_mesh()
+{
+    // the standard properties may have been removed and inserted again
+    mesh_.vpoint_ = mesh_.get_vertex_property<Point>("v:point");
+    mesh_.vconn_ = mesh_.get_vertex_property<SurfaceMesh::VertexConnectivity>(
+        "v:connectivity");
+    mesh_.hconn_ =
+        mesh_.get_halfedge_property<SurfaceMesh::HalfedgeConnectivity>(
+            "h:connectivity");
+    mesh_.fconn_ = mesh_.get_face_property<SurfaceMesh::FaceConnectivity>(
+        "f:connectivity");
+    mesh_.vdeleted_ = mesh_.get_vertex_property<bool>("v:deleted");
+    mesh_.edeleted_ = mesh_.get_edge_property<bool>("e:deleted");
+    mesh_.fdeleted_ = mesh_.get_face_property<bool>("f:deleted");
+
+    mesh_.rebuild_edge_index();
+}
+
+void SurfaceMeshHistory::enforce_memory_limit()
+{
+    size_t bytes = memory_usage();
+    while (bytes > memory_limit_ && undo_.size() > 1)
+    {
+        bytes -= undo_.front().bytes;
+        undo_.pop_front();
+    }
+}
+
+} // namespace pmp
@@ -0,0 +1,158 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Undo and redo of the edits of a SurfaceMesh.
+//! \details An edit is any sequence of modifications between begin() and
+//! commit(). While recording, every property array saves the old value of
+//! an element before its first modification, and the properties added or
+//! removed by the edit are remembered. Topological operations like flip(),
+//! collapse(), and split() write the connectivity properties and are thus
+//! recorded like positions or any other property. Memory and time scale
+//! with the number of modified elements instead of the size of the mesh.
+//! Undoing an edit records the values it overwrites in the same way, which
+//! are used to redo it.
+//!
+//! Bulk access through Property::vector() saves all elements of the
+//! property, and garbage_collection() saves the relocated elements.
+//! Assigning another mesh and clear() save all properties, assign() only
+//! the elements that differ. The mesh must not be swapped while recording.
+//! Handles of properties added or removed by an edit become invalid when
+//! undoing or redoing it. The edge index, if enabled, is rebuilt.
+//! \ingroup core
+class SurfaceMeshHistory
+{
+public:
+    //! record the edits of \p mesh, which has to outlive the history
+    explicit SurfaceMeshHistory(SurfaceMesh& mesh);
+
+    //! stop recording, keeping the modifications of an uncommitted edit
+    ~SurfaceMeshHistory();
+
+    SurfaceMeshHistory(const SurfaceMeshHistory&) = delete;
+    SurfaceMeshHistory& operator=(const SurfaceMeshHistory&) = delete;
+
+    //! \brief Start recording an edit.
+    //! \throw InvalidInputException if an edit is being recorded already.
+    void begin();
+
+    //! \brief Stop recording and make the edit undoable as \p name.
+    //! \details Discards the edits that could be redone. An edit that
+    //! modified nothing is dropped. The oldest edits are dropped while the
+    //! history exceeds memory_limit().
+    //! \throw InvalidInputException if no edit is being recorded, or if the
+    //! mesh was swapped meanwhile. The history is cleared in the latter
+    //! case.
+    void commit(const std::string& name);
+
+    //! \brief Undo the modifications of the edit being recorded and stop
+    //! recording.
+    //! \throw InvalidInputException if no edit is being recorded.
+    void rollback();
+
+    //! is an edit being recorded?
+    bool is_recording() const { return recording_; }
+
+    //! \brief Replace the mesh by \p mesh as an edit named \p name.
+    //! \details Like SurfaceMesh::operator=(), but writes only the elements
+    //! and properties that differ, such that just these are stored.
+    //! Properties of both meshes with the same name but different types are
+    //! replaced. Settings like the edge index are kept.
+    //! \throw InvalidInputException if an edit is being recorded.
+    void assign(const SurfaceMesh& mesh, const std::string& name);
+
+    //! is there an edit to undo?
+    bool can_undo() const { return !undo_.empty(); }
+
+    //! is there an edit to redo?
+    bool can_redo() const { return !redo_.empty(); }
+
+    //! name of the edit undone by undo(), empty if there is none
+    std::string undo_name() const;
+
+    //! name of the edit redone by redo(), empty if there is none
+    std::string redo_name() const;
+
+    //! \brief Undo the latest edit.
+    //! \throw InvalidInputException if an edit is being recorded or if there
+    //! is nothing to undo.
+    void undo();
+
+    //! \brief Redo the latest undone edit.
+    //! \throw InvalidInputException if an edit is being recorded or if there
+    //! is nothing to redo.
+    void redo();
+
+    //! \brief Forget all edits, e.g., after loading another mesh.
+    //! \details An edit being recorded is stopped and kept.
+    void clear();
+
+    //! number of edits that can be undone
+    size_t n_undo() const { return undo_.size(); }
+
+    //! number of edits that can be redone
+    size_t n_redo() const { return redo_.size(); }
+
+    //! bytes used by the recorded edits
+    size_t memory_usage() const;
+
+    //! \brief Keep the recorded edits within \p bytes.
+    //! \details The oldest edits are dropped first. The latest edit is
+    //! always kept. Unlimited by default.
+    void set_memory_limit(size_t bytes);
+
+    //! the memory limit of the recorded edits in bytes
+    size_t memory_limit() const { return memory_limit_; }
+
+private:
+    // the old state of the mesh before an edit
+    struct Edit
+    {
+        std::string name;
+        std::unique_ptr<PropertyContainerDelta> props[5];
+        IndexType deleted_vertices, deleted_edges, deleted_faces;
+        bool has_garbage;
+        std::vector<IndexType> free_vertices, free_edges, free_faces;
+        size_t bytes;
+    };
+
+    // the property containers of the mesh
+    std::vector<PropertyContainer*> containers() const;
+
+    // start recording into edit_
+    void start();
+
+    // stop recording and return the old state
+    Edit finish();
+
+    // restore the old state of edit, taking over its removed arrays
+    void restore(Edit& edit);
+
+    // restore the old state of edit and return the edit undoing this
+    Edit apply(Edit& edit);
+
+    // update the handles of the standard properties and the edge index
+    void update_mesh();
+
+    // drop the oldest edits beyond the memory limit
+    void enforce_memory_limit();
+
+    SurfaceMesh& mesh_;
+    bool recording_;
+    Edit edit_; // the mesh state at begin()
+    std::deque<Edit> undo_;
+    std::vector<Edit> redo_;
+    size_t memory_limit_;
+};
+
+} // namespace pmp
@@ -4,15 +4,33 @@
 
 #include "pmp/SurfaceMeshIO.h"
 
+#include <algorithm>
+#include <atomic>
 #include <clocale>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <cctype>
 
-#include <fstream>
+#include <cmath>
+#include <functional>
+#include <istream>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
+#include <ostream>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
 
 #include <rply.h>
 
+#include "pmp/Compression.h"
+#include "pmp/MappedFile.h"
+#include "pmp/Parallel.h"
+#include "pmp/StreamingMesh.h"
+
 // helper function
 template <typename T>
 void tfread(FILE* in, const T& t)
@@ -31,1187 +49,5893 @@ void tfwrite(FILE* out, const T& t)
 
 namespace pmp {
 
-void SurfaceMeshIO::read(SurfaceMesh& mesh)
+namespace {
+
+// vertices, texture coordinates, and faces found in a chunk of an OBJ file
+struct ObjChunk
 {
-    std::setlocale(LC_NUMERIC, "C");
+    static const int64_t no_index = std::numeric_limits<int64_t>::min();
 
-    // clear mesh before reading from file
-    mesh.clear();
+    void swap(ObjChunk& rhs)
+    {
+        points.swap(rhs.points);
+        tex_coords.swap(rhs.tex_coords);
+        face_sizes.swap(rhs.face_sizes);
+        vertices.swap(rhs.vertices);
+        tex_coord_indices.swap(rhs.tex_coord_indices);
+        relative_vertices.swap(rhs.relative_vertices);
+        relative_tex_coords.swap(rhs.relative_tex_coords);
+        error.swap(rhs.error);
+    }
 
-    // extract file extension
-    std::string::size_type dot(filename_.rfind("."));
-    if (dot == std::string::npos)
-        throw IOException("Could not determine file extension!");
-    std::string ext = filename_.substr(dot + 1, filename_.length() - dot - 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+    std::vector<Point> points;
+    std::vector<TexCoord> tex_coords;
+    std::vector<IndexType> face_sizes;
 
-    // extension determines reader
-    if (ext == "off")
-        read_off(mesh);
-    else if (ext == "obj")
-        read_obj(mesh);
-    else if (ext == "stl")
-        read_stl(mesh);
-    else if (ext == "ply")
-        read_ply(mesh);
-    else if (ext == "pmp")
-        read_pmp(mesh);
-    else if (ext == "xyz")
-        read_xyz(mesh);
-    else if (ext == "agi")
-        read_agi(mesh);
-    else
-        throw IOException("Could not find reader for " + filename_);
+    // zero-based indices per face corner. negative OBJ indices refer to
+    // the elements read so far and are stored relative to the chunk start,
+    // marked by the relative_* flags.
+    std::vector<int64_t> vertices;
+    std::vector<int64_t> tex_coord_indices;
+    std::vector<unsigned char> relative_vertices;
+    std::vector<unsigned char> relative_tex_coords;
 
-    add_failed_faces(mesh);
-}
+    std::string error;
+};
 
-void SurfaceMeshIO::write(const SurfaceMesh& mesh)
-{
-    // extract file extension
-    std::string::size_type dot(filename_.rfind("."));
-    if (dot == std::string::npos)
-        throw IOException("Could not determine file extension!");
-    std::string ext = filename_.substr(dot + 1, filename_.length() - dot - 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+const int64_t ObjChunk::no_index;
 
-    // extension determines reader
-    if (ext == "off")
-        write_off(mesh);
-    else if (ext == "obj")
-        write_obj(mesh);
-    else if (ext == "stl")
-        write_stl(mesh);
-    else if (ext == "ply")
-        write_ply(mesh);
-    else if (ext == "pmp")
-        write_pmp(mesh);
-    else if (ext == "xyz")
-        write_xyz(mesh);
-    else
-        throw IOException("Could not find writer for " + filename_);
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
 }
 
-void SurfaceMeshIO::read_obj(SurfaceMesh& mesh)
+inline bool is_blank(char c)
 {
-    char s[200];
-    float x, y, z;
-    std::vector<Vertex> vertices;
-    std::vector<TexCoord> all_tex_coords; //individual texture coordinates
-    std::vector<int>
-        halfedge_tex_idx; //texture coordinates sorted for halfedges
-    HalfedgeProperty<TexCoord> tex_coords =
-        mesh.halfedge_property<TexCoord>("h:tex");
-    bool with_tex_coord = false;
-
-    // open file (in ASCII mode)
-    FILE* in = fopen(filename_.c_str(), "r");
-    if (!in)
-        throw IOException("Failed to open file: " + filename_);
+    return c == ' ' || c == '\t' || c == '\r';
+}
 
-    // clear line once
-    memset(&s, 0, 200);
+inline void skip_blanks(const char*& p, const char* end)
+{
+    while (p < end && is_blank(*p))
+        ++p;
+}
 
-    // parse line by line (currently only supports vertex positions & faces
-    while (in && !feof(in) && fgets(s, 200, in))
+// parse a floating point number at p using strtod
+bool parse_double_slow(const char*& p, const char* end, double& value)
+{
+    char buffer[128];
+    size_t n = 0;
+    while (p + n < end && n + 1 < sizeof(buffer) && !is_blank(p[n]))
     {
-        // comment
-        if (s[0] == '#' || isspace(s[0]))
-            continue;
+        buffer[n] = p[n];
+        ++n;
+    }
+    buffer[n] = '\0';
+
+    char* stop;
+    value = strtod(buffer, &stop);
+    if (stop == buffer)
+        return false;
+    p += stop - buffer;
+    return true;
+}
 
-        // vertex
-        else if (strncmp(s, "v ", 2) == 0)
+// parse a floating point number at p. decimal numbers of up to 15
+// significant digits and small exponents are converted exactly, i.e.,
+// without calling the locale dependent and slow strtod.
+bool parse_double(const char*& p, const char* end, double& value)
+{
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char* q = p;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+'))
+        negative = (*q++ == '-');
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any_digit = false;
+    while (q < end && is_digit(*q))
+    {
+        if (digits < 15)
         {
-            if (sscanf(s, "v %f %f %f", &x, &y, &z))
-            {
-                mesh.add_vertex(Point(x, y, z));
-            }
+            mantissa = 10 * mantissa + uint64_t(*q - '0');
+            if (mantissa)
+                ++digits;
         }
-
-        // normal
-        else if (strncmp(s, "vn ", 3) == 0)
+        else
+            digits = 16; // too many digits
+        any_digit = true;
+        ++q;
+    }
+    if (q < end && *q == '.')
+    {
+        ++q;
+        while (q < end && is_digit(*q))
         {
-            if (sscanf(s, "vn %f %f %f", &x, &y, &z))
+            if (digits < 15)
             {
-                // problematic as it can be either a vertex property when interpolated
-                // or a halfedge property for hard edges
+                mantissa = 10 * mantissa + uint64_t(*q - '0');
+                if (mantissa)
+                    ++digits;
+                --exponent;
             }
+            else
+                digits = 16;
+            any_digit = true;
+            ++q;
         }
+    }
+    if (!any_digit || digits > 15)
+        return parse_double_slow(p, end, value);
 
-        // texture coordinate
-        else if (strncmp(s, "vt ", 3) == 0)
+    if (q < end && (*q == 'e' || *q == 'E'))
+    {
+        const char* e = q + 1;
+        bool negative_exponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+            negative_exponent = (*e++ == '-');
+        if (e < end && is_digit(*e))
         {
-            if (sscanf(s, "vt %f %f", &x, &y))
-            {
-                all_tex_coords.emplace_back(x, y);
-            }
+            int n = 0;
+            while (e < end && is_digit(*e) && n < 10000)
+                n = 10 * n + (*e++ - '0');
+            exponent += negative_exponent ? -n : n;
+            q = e;
         }
+    }
+    if (exponent < -22 || exponent > 22)
+        return parse_double_slow(p, end, value);
+
+    value = double(mantissa);
+    value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    if (negative)
+        value = -value;
+    p = q;
+    return true;
+}
 
-        // face
-        else if (strncmp(s, "f ", 2) == 0)
-        {
-            int component(0), nv(0);
-            bool end_of_vertex(false);
-            char *p0, *p1(s + 1);
-
-            vertices.clear();
-            halfedge_tex_idx.clear();
-
-            // skip white-spaces
-            while (*p1 == ' ')
-                ++p1;
-
-            while (p1)
-            {
-                p0 = p1;
-
-                // overwrite next separator
-
-                // skip '/', '\n', ' ', '\0', '\r' <-- don't forget Windows
-                while (*p1 != '/' && *p1 != '\r' && *p1 != '\n' && *p1 != ' ' &&
-                       *p1 != '\0')
-                    ++p1;
-
-                // detect end of vertex
-                if (*p1 != '/')
-                {
-                    end_of_vertex = true;
-                }
-
-                // replace separator by '\0'
-                if (*p1 != '\0')
-                {
-                    *p1 = '\0';
-                    p1++; // point to next token
-                }
-
-                // detect end of line and break
-                if (*p1 == '\0' || *p1 == '\n')
-                {
-                    p1 = nullptr;
-                }
-
-                // read next vertex component
-                if (*p0 != '\0')
-                {
-                    switch (component)
-                    {
-                        case 0: // vertex
-                        {
-                            vertices.emplace_back(atoi(p0) - 1);
-                            break;
-                        }
-                        case 1: // texture coord
-                        {
-                            int idx = atoi(p0) - 1;
-                            halfedge_tex_idx.push_back(idx);
-                            with_tex_coord = true;
-                            break;
-                        }
-                        case 2: // normal
-                            break;
-                    }
-                }
-
-                ++component;
-
-                if (end_of_vertex)
-                {
-                    component = 0;
-                    nv++;
-                    end_of_vertex = false;
-                }
-            }
-
-            Face f = add_face(mesh, vertices);
+bool parse_index(const char*& p, const char* end, int64_t& value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+    if (p == end || !is_digit(*p))
+        return false;
+    value = 0;
+    while (p < end && is_digit(*p))
+        value = 10 * value + (*p++ - '0');
+    if (negative)
+        value = -value;
+    return true;
+}
 
-            // add texture coordinates
-            if (with_tex_coord)
-            {
-                SurfaceMesh::HalfedgeAroundFaceCirculator h_fit =
-                    mesh.halfedges(f);
-                SurfaceMesh::HalfedgeAroundFaceCirculator h_end = h_fit;
-                unsigned v_idx = 0;
-                do
-                {
-                    tex_coords[*h_fit] =
-                        all_tex_coords.at(halfedge_tex_idx.at(v_idx));
-                    ++v_idx;
-                    ++h_fit;
-                } while (h_fit != h_end);
-            }
-        }
-        // clear line
-        memset(&s, 0, 200);
+// convert the OBJ index idx to a zero-based index, n is the number of
+// elements read so far in the chunk
+void add_index(int64_t idx, size_t n, std::vector<int64_t>& indices,
+               std::vector<unsigned char>& relative)
+{
+    if (idx < 0)
+    {
+        indices.push_back(int64_t(n) + idx);
+        relative.push_back(1);
     }
-
-    // if there are no textures, delete texture property!
-    if (!with_tex_coord)
+    else
     {
-        mesh.remove_halfedge_property(tex_coords);
+        indices.push_back(idx - 1);
+        relative.push_back(0);
     }
-
-    fclose(in);
 }
 
-void SurfaceMeshIO::write_obj(const SurfaceMesh& mesh)
+void parse_obj_face(const char* p, const char* end, ObjChunk& chunk)
 {
-    FILE* out = fopen(filename_.c_str(), "w");
-    if (!out)
-        throw IOException("Failed to open file: " + filename_);
-
-    // comment
-    fprintf(out, "# OBJ export from PMP\n");
-
-    // write vertices
-    auto points = mesh.get_vertex_property<Point>("v:point");
-    for (auto v : mesh.vertices())
+    size_t n = 0;
+    for (;;)
     {
-        const Point& p = points[v];
-        fprintf(out, "v %.10f %.10f %.10f\n", p[0], p[1], p[2]);
-    }
+        skip_blanks(p, end);
+        if (p == end)
+            break;
 
-    // write normals
-    auto normals = mesh.get_vertex_property<Normal>("v:normal");
-    if (normals)
-    {
-        for (auto v : mesh.vertices())
+        int64_t v, t = 0;
+        if (!parse_index(p, end, v) || v == 0)
         {
-            const Normal& n = normals[v];
-            fprintf(out, "vn %.10f %.10f %.10f\n", n[0], n[1], n[2]);
+            chunk.error = "Invalid face";
+            break;
         }
-    }
+        add_index(v, chunk.points.size(), chunk.vertices,
+                  chunk.relative_vertices);
 
-    // write texture coordinates
-    auto tex_coords = mesh.get_halfedge_property<TexCoord>("h:tex");
-    if (tex_coords)
-    {
-        for (auto h : mesh.halfedges())
+        // optional texture coordinate and normal, normals are ignored
+        bool has_tex_coord = false;
+        if (p < end && *p == '/')
+        {
+            ++p;
+            has_tex_coord = parse_index(p, end, t) && t != 0;
+            if (p < end && *p == '/')
+            {
+                ++p;
+                int64_t normal;
+                parse_index(p, end, normal);
+            }
+        }
+        if (has_tex_coord)
+            add_index(t, chunk.tex_coords.size(), chunk.tex_coord_indices,
+                      chunk.relative_tex_coords);
+        else
         {
-            const TexCoord& pt = tex_coords[h];
-            fprintf(out, "vt %.10f %.10f\n", pt[0], pt[1]);
+            chunk.tex_coord_indices.push_back(ObjChunk::no_index);
+            chunk.relative_tex_coords.push_back(0);
         }
+
+        while (p < end && !is_blank(*p))
+            ++p;
+        ++n;
     }
 
-    // write faces
-    for (auto f : mesh.faces())
+    // skip faces with less than three vertices
+    if (n < 3)
+    {
+        chunk.vertices.resize(chunk.vertices.size() - n);
+        chunk.tex_coord_indices.resize(chunk.tex_coord_indices.size() - n);
+        chunk.relative_vertices.resize(chunk.relative_vertices.size() - n);
+        chunk.relative_tex_coords.resize(chunk.relative_tex_coords.size() - n);
+    }
+    else
+        chunk.face_sizes.push_back(IndexType(n));
+}
+
+// parse the lines in [begin,end)
+// split [begin, end) into chunks of about chunk_size bytes starting at line
+// beginnings, return the bounds of the chunks
+std::vector<const char*> split_lines(const char* begin, const char* end,
+                                     size_t chunk_size)
+{
+    const size_t n_chunks = size_t(end - begin) / chunk_size + 1;
+    std::vector<const char*> bounds(n_chunks + 1, end);
+    bounds[0] = begin;
+    for (size_t i = 1; i < n_chunks; ++i)
     {
-        fprintf(out, "f");
+        const char* p = std::max(begin + i * chunk_size, bounds[i - 1]);
+        const char* eol =
+            static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        bounds[i] = eol ? eol + 1 : end;
+    }
+    return bounds;
+}
 
-        auto h = mesh.halfedges(f);
-        for (auto v : mesh.vertices(f))
+// count the lines in [begin, end) whose first token is one of n keywords
+void count_keywords(const char* begin, const char* end,
+                    const char* const* keywords, size_t n, size_t* counts)
+{
+    std::fill(counts, counts + n, 0);
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* eol =
+            static_cast<const char*>(memchr(line, '\n', size_t(end - line)));
+        if (!eol)
+            eol = end;
+
+        const char* p = line;
+        line = eol + 1;
+        skip_blanks(p, eol);
+        const char* q = p;
+        while (q < eol && !is_blank(*q))
+            ++q;
+        const size_t length = size_t(q - p);
+        for (size_t i = 0; i < n; ++i)
         {
-            auto idx = v.idx() + 1;
-            if (tex_coords)
-            {
-                // write vertex index, texCoord index and normal index
-                fprintf(out, " %d/%d/%d", idx, (*h).idx() + 1, idx);
-                ++h;
-            }
-            else
+            if (strlen(keywords[i]) == length &&
+                strncmp(p, keywords[i], length) == 0)
             {
-                // write vertex index and normal index
-                fprintf(out, " %d//%d", idx, idx);
+                ++counts[i];
+                break;
             }
         }
-        fprintf(out, "\n");
     }
-
-    fclose(out);
 }
 
-void SurfaceMeshIO::read_off_ascii(SurfaceMesh& mesh, FILE* in,
-                                   const bool has_normals,
-                                   const bool has_texcoords,
-                                   const bool has_colors)
+// count_keywords() for whole files, counting chunks in parallel
+void count_keywords_parallel(const char* begin, const char* end,
+                             const char* const* keywords, size_t n,
+                             size_t* counts)
 {
-    char line[1000], *lp;
-    int nc;
-    unsigned int i, j, items, idx;
-    unsigned int nv, nf, ne;
-    float x, y, z, r, g, b;
-    Vertex v;
-
-    // properties
-    VertexProperty<Normal> normals;
-    VertexProperty<TexCoord> texcoords;
-    VertexProperty<Color> colors;
-    if (has_normals)
-        normals = mesh.vertex_property<Normal>("v:normal");
-    if (has_texcoords)
-        texcoords = mesh.vertex_property<TexCoord>("v:tex");
-    if (has_colors)
-        colors = mesh.vertex_property<Color>("v:color");
-
-    // #Vertice, #Faces, #Edges
-    items = fscanf(in, "%d %d %d\n", (int*)&nv, (int*)&nf, (int*)&ne);
-    PMP_ASSERT(items);
+    const auto bounds = split_lines(begin, end, size_t(1) << 22);
+    const size_t n_chunks = bounds.size() - 1;
+    std::vector<size_t> chunk_counts(n_chunks * n);
+    parallel_for(
+        0, int(n_chunks),
+        [&](int i) {
+            count_keywords(bounds[i], bounds[i + 1], keywords, n,
+                           chunk_counts.data() + size_t(i) * n);
+        },
+        1);
+
+    std::fill(counts, counts + n, 0);
+    for (size_t i = 0; i < n_chunks; ++i)
+        for (size_t j = 0; j < n; ++j)
+            counts[j] += chunk_counts[i * n + j];
+}
 
-    mesh.reserve(nv, std::max(3 * nv, ne), nf);
+// whether the line [p, eol) starts with a number
+inline bool is_data_line(const char* p, const char* eol)
+{
+    skip_blanks(p, eol);
+    return p < eol && (is_digit(*p) || *p == '-' || *p == '+' || *p == '.');
+}
 
-    // read vertices: pos [normal] [color] [texcoord]
-    for (i = 0; i < nv && !feof(in); ++i)
+// number of lines starting with a number, e.g., points of XYZ files
+size_t count_data_lines(const char* begin, const char* end)
+{
+    size_t n = 0;
+    const char* line = begin;
+    while (line < end)
     {
-        // read line
-        lp = fgets(line, 1000, in);
-        lp = line;
+        const char* eol =
+            static_cast<const char*>(memchr(line, '\n', size_t(end - line)));
+        if (!eol)
+            eol = end;
+        if (is_data_line(line, eol))
+            ++n;
+        line = eol + 1;
+    }
+    return n;
+}
 
-        // position
-        items = sscanf(lp, "%f %f %f%n", &x, &y, &z, &nc);
-        assert(items == 3);
-        v = mesh.add_vertex(Point(x, y, z));
-        lp += nc;
+void parse_obj_chunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    // reserve memory, assuming mostly triangles
+    static const char* const keywords[] = {"v", "vt", "f"};
+    size_t counts[3];
+    count_keywords(begin, end, keywords, 3, counts);
+    chunk.points.reserve(counts[0]);
+    chunk.tex_coords.reserve(counts[1]);
+    chunk.face_sizes.reserve(counts[2]);
+    chunk.vertices.reserve(3 * counts[2]);
+    chunk.relative_vertices.reserve(3 * counts[2]);
+    chunk.tex_coord_indices.reserve(3 * counts[2]);
+    chunk.relative_tex_coords.reserve(3 * counts[2]);
+
+    const char* line = begin;
+    while (line < end && chunk.error.empty())
+    {
+        const char* eol =
+            static_cast<const char*>(memchr(line, '\n', size_t(end - line)));
+        if (!eol)
+            eol = end;
+
+        const char* p = line;
+        line = eol + 1;
+        skip_blanks(p, eol);
+        if (eol - p < 2)
+            continue;
 
-        // normal
-        if (has_normals)
+        if (p[0] == 'v' && is_blank(p[1]))
         {
-            if (sscanf(lp, "%f %f %f%n", &x, &y, &z, &nc) == 3)
+            // vertex, a missing coordinate is zero
+            Point point(0, 0, 0);
+            p += 2;
+            for (int i = 0; i < 3; ++i)
             {
-                normals[v] = Normal(x, y, z);
+                skip_blanks(p, eol);
+                double x;
+                if (p == eol || !parse_double(p, eol, x))
+                    break;
+                point[i] = Scalar(x);
             }
-            lp += nc;
+            chunk.points.push_back(point);
         }
-
-        // color
-        if (has_colors)
+        else if (p[0] == 'v' && p[1] == 't' && eol - p > 2 && is_blank(p[2]))
         {
-            if (sscanf(lp, "%f %f %f%n", &r, &g, &b, &nc) == 3)
+            TexCoord t(0, 0);
+            p += 3;
+            for (int i = 0; i < 2; ++i)
             {
-                if (r > 1.0f || g > 1.0f || b > 1.0f)
-                {
-                    r /= 255.0f;
-                    g /= 255.0f;
-                    b /= 255.0f;
-                }
-                colors[v] = Color(r, g, b);
+                skip_blanks(p, eol);
+                double x;
+                if (p == eol || !parse_double(p, eol, x))
+                    break;
+                t[i] = TexCoord::value_type(x);
             }
-            lp += nc;
+            chunk.tex_coords.push_back(t);
         }
-
-        // tex coord
-        if (has_texcoords)
+        else if (p[0] == 'f' && is_blank(p[1]))
         {
-            items = sscanf(lp, "%f %f%n", &x, &y, &nc);
-            assert(items == 2);
-            texcoords[v][0] = x;
-            texcoords[v][1] = y;
-            lp += nc;
+            parse_obj_face(p + 2, eol, chunk);
         }
     }
+}
 
-    // read faces: #N v[1] v[2] ... v[n-1]
-    std::vector<Vertex> vertices;
-    for (i = 0; i < nf; ++i)
-    {
-        // read line
-        lp = fgets(line, 1000, in);
-        lp = line;
+// size of the file in bytes, zero if it cannot be opened
+size_t file_size(const std::string& filename)
+{
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in)
+        return 0;
+#if defined(_WIN32)
+    _fseeki64(in, 0, SEEK_END);
+    const auto size = _ftelli64(in);
+#else
+    fseeko(in, 0, SEEK_END);
+    const auto size = ftello(in);
+#endif
+    fclose(in);
+    return size > 0 ? size_t(size) : 0;
+}
 
-        // #vertices
-        items = sscanf(lp, "%d%n", (int*)&nv, &nc);
-        assert(items == 1);
-        vertices.resize(nv);
-        lp += nc;
+} // namespace
 
-        // indices
-        for (j = 0; j < nv; ++j)
-        {
-            items = sscanf(lp, "%d%n", (int*)&idx, &nc);
-            assert(items == 1);
-            vertices[j] = Vertex(idx);
-            lp += nc;
-        }
-        add_face(mesh, vertices);
-    }
+SurfaceMeshIO::~SurfaceMeshIO()
+{
+    free(output_buffer_);
 }
 
-void SurfaceMeshIO::read_off_binary(SurfaceMesh& mesh, FILE* in,
-                                    const bool has_normals,
-                                    const bool has_texcoords,
-                                    const bool has_colors)
+std::string SurfaceMeshIO::format_extension() const
 {
-    IndexType i, j, idx(0);
-    IndexType nv(0), nf(0), ne(0);
-    Point p, n, c;
-    vec2 t;
-    Vertex v;
+    // ignore the extension of compressed files
+    std::string name = filename_;
+    if (compression_from_extension(name) != Compression::None)
+        name.erase(name.rfind('.'));
 
-    // binary cannot (yet) read colors
-    if (has_colors)
-        throw IOException("Colors not supported for binary OFF file.");
-
-    // properties
-    VertexProperty<Normal> normals;
-    VertexProperty<TexCoord> texcoords;
-    if (has_normals)
-        normals = mesh.vertex_property<Normal>("v:normal");
-    if (has_texcoords)
-        texcoords = mesh.vertex_property<TexCoord>("v:tex");
-
-    // #Vertice, #Faces, #Edges
-    tfread(in, nv);
-    tfread(in, nf);
-    tfread(in, ne);
-    mesh.reserve(nv, std::max(3 * nv, ne), nf);
-
-    // read vertices: pos [normal] [color] [texcoord]
-    for (i = 0; i < nv && !feof(in); ++i)
-    {
-        // position
-        tfread(in, p);
-        v = mesh.add_vertex((Point)p);
-
-        // normal
-        if (has_normals)
-        {
-            tfread(in, n);
-            normals[v] = (Normal)n;
-        }
-
-        // tex coord
-        if (has_texcoords)
-        {
-            tfread(in, t);
-            texcoords[v][0] = t[0];
-            texcoords[v][1] = t[1];
-        }
-    }
+    std::string::size_type dot(name.rfind("."));
+    if (dot == std::string::npos)
+        throw IOException("Could not determine file extension!");
+    std::string ext = name.substr(dot + 1, name.length() - dot - 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+    return ext;
+}
 
-    // read faces: #N v[1] v[2] ... v[n-1]
-    std::vector<Vertex> vertices;
-    for (i = 0; i < nf; ++i)
+FILE* SurfaceMeshIO::open_input(const char* mode)
+{
+    if (!input_)
+        return fopen(filename_.c_str(), mode);
+    if (!input_->size())
+        return nullptr;
+
+#if !defined(_WIN32)
+    return fmemopen(input_->writable_data(), input_->size(), "rb");
+#else
+    // no memory streams, use an anonymous temporary file
+    FILE* in = tmpfile();
+    if (in)
     {
-        tfread(in, nv);
-        vertices.resize(nv);
-        for (j = 0; j < nv; ++j)
-        {
-            tfread(in, idx);
-            vertices[j] = Vertex(idx);
-        }
-        add_face(mesh, vertices);
+        fwrite(input_->data(), 1, input_->size(), in);
+        rewind(in);
     }
+    return in;
+#endif
 }
 
-void SurfaceMeshIO::write_off_binary(const SurfaceMesh& mesh)
+std::shared_ptr<MappedFile> SurfaceMeshIO::map_input(bool copy_on_write)
 {
-    FILE* out = fopen(filename_.c_str(), "w");
-    if (!out)
-        throw IOException("Failed to open file: " + filename_);
-
-    fprintf(out, "OFF BINARY\n");
-    fclose(out);
-    IndexType nv = (IndexType)mesh.n_vertices();
-    IndexType nf = (IndexType)mesh.n_faces();
-    IndexType ne = 0;
+    if (input_)
+        return input_;
+    return std::make_shared<MappedFile>(filename_, copy_on_write);
+}
 
-    out = fopen(filename_.c_str(), "ab");
-    tfwrite(out, nv);
-    tfwrite(out, nf);
-    tfwrite(out, ne);
-    auto points = mesh.get_vertex_property<Point>("v:point");
-    for (auto v : mesh.vertices())
-    {
-        const Point& p = points[v];
-        tfwrite(out, p);
-    }
+FILE* SurfaceMeshIO::open_output(const char* mode)
+{
+    if (output_compression_ == Compression::None && !memory_output_)
+        return fopen(filename_.c_str(), mode);
+
+#if !defined(_WIN32)
+    free(output_buffer_);
+    output_buffer_ = nullptr;
+    output_size_ = 0;
+    return open_memstream(&output_buffer_, &output_size_);
+#else
+    // no memory streams, compress the file in place in close_output()
+    if (memory_output_)
+        return tmpfile();
+    return fopen(filename_.c_str(), "wb");
+#endif
+}
 
-    for (auto f : mesh.faces())
+void SurfaceMeshIO::close_output(FILE* out)
+{
+#if defined(_WIN32)
+    if (memory_output_)
     {
-        IndexType nv = mesh.valence(f);
-        tfwrite(out, nv);
-        for (auto fv : mesh.vertices(f))
-            tfwrite(out, (IndexType)fv.idx());
+        // read back the temporary file, which is deleted when closing it
+        std::vector<char> buffer;
+        char chunk[1 << 16];
+        size_t n;
+        rewind(out);
+        while ((n = fread(chunk, 1, sizeof(chunk), out)) > 0)
+            buffer.insert(buffer.end(), chunk, chunk + n);
+        const bool failed = ferror(out) != 0;
+        if (fclose(out) != 0 || failed)
+            throw IOException("Failed to write file: " + filename_);
+        *memory_output_ = compress(buffer.data(), buffer.size(),
+                                   output_compression_,
+                                   flags_.compression_level);
+        return;
     }
-    fclose(out);
-}
+#endif
 
-void SurfaceMeshIO::read_off(SurfaceMesh& mesh)
-{
-    char line[200];
-    bool has_texcoords = false;
-    bool has_normals = false;
-    bool has_colors = false;
-    bool has_hcoords = false;
-    bool has_dim = false;
-    bool is_binary = false;
+    if (fclose(out) != 0)
+        throw IOException("Failed to write file: " + filename_);
+    if (output_compression_ == Compression::None && !memory_output_)
+        return;
 
-    // open file (in ASCII mode)
-    FILE* in = fopen(filename_.c_str(), "r");
-    if (!in)
-        throw IOException("Failed to open file: " + filename_);
+#if !defined(_WIN32)
+    std::unique_ptr<char, void (*)(void*)> buffer(output_buffer_, free);
+    output_buffer_ = nullptr;
+    const char* data = buffer.get();
+    const size_t size = output_size_;
 
-    // read header: [ST][C][N][4][n]OFF BINARY
-    char* c = fgets(line, 200, in);
-    assert(c != nullptr);
-    c = line;
-    if (c[0] == 'S' && c[1] == 'T')
+    if (memory_output_)
     {
-        has_texcoords = true;
-        c += 2;
+        if (output_compression_ == Compression::None)
+            memory_output_->assign(data, data + size);
+        else
+            *memory_output_ = compress(data, size, output_compression_,
+                                       flags_.compression_level);
+        return;
     }
-    if (c[0] == 'C')
+#else
+    std::vector<char> buffer;
     {
-        has_colors = true;
-        ++c;
+        MappedFile file(filename_);
+        buffer.assign(file.data(), file.end());
     }
-    if (c[0] == 'N')
+    const char* data = buffer.data();
+    const size_t size = buffer.size();
+#endif
+
+    out = fopen(filename_.c_str(), "wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+    try
     {
-        has_normals = true;
-        ++c;
+        compress(data, size, out, output_compression_,
+                 flags_.compression_level);
     }
-    if (c[0] == '4')
+    catch (...)
     {
-        has_hcoords = true;
-        ++c;
+        fclose(out);
+        throw;
     }
-    if (c[0] == 'n')
+    if (fclose(out) != 0)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+void SurfaceMeshIO::decompress_input()
+{
+    input_.reset();
+    if (memory_input_)
     {
-        has_dim = true;
-        ++c;
+        input_ = memory_input_;
+        auto compression =
+            detect_compression(memory_input_->data(), memory_input_->size());
+        if (compression != Compression::None)
+            input_ = std::make_shared<MappedFile>(decompress(
+                memory_input_->data(), memory_input_->size(), compression));
     }
-    if (strncmp(c, "OFF", 3) != 0)
+    else if (FILE* in = fopen(filename_.c_str(), "rb"))
     {
+        char magic[4];
+        size_t n = fread(magic, 1, sizeof(magic), in);
         fclose(in);
-        throw IOException("Failed to parse OFF header");
+        auto compression = detect_compression(magic, n);
+        if (compression != Compression::None)
+        {
+            MappedFile file(filename_);
+            input_ = std::make_shared<MappedFile>(
+                decompress(file.data(), file.size(), compression));
+        }
     }
-    if (strncmp(c + 4, "BINARY", 6) == 0)
-        is_binary = true;
+}
 
-    if (has_hcoords)
+void SurfaceMeshIO::read(SurfaceMesh& mesh)
+{
+    std::setlocale(LC_NUMERIC, "C");
+
+    // clear mesh before reading from file
+    mesh.clear();
+
+    std::string ext = format_extension();
+    decompress_input();
+
+    input_size_ = input_ ? input_->size() : file_size(filename_);
+    reader_thread_ = std::this_thread::get_id();
+    cancelled_ = false;
+
+    try
     {
-        fclose(in);
-        throw IOException("Error: Homogeneous coordinates not supported.");
+        report_progress(0);
+        check_cancelled();
+
+        // extension determines reader
+        if (ext == "off")
+            read_off(mesh);
+        else if (ext == "obj")
+            read_obj(mesh);
+        else if (ext == "stl")
+            read_stl(mesh);
+        else if (ext == "ply")
+            read_ply(mesh);
+        else if (ext == "pmp")
+            read_pmp(mesh);
+        else if (ext == "xyz" || ext == "agi" || ext == "pts")
+            read_points(mesh);
+        else if (ext == "pmc")
+            read_pmc(mesh);
+        else if (ext == "sma" || ext == "smb")
+            read_streaming(mesh);
+        else
+            throw IOException("Could not find reader for " + filename_);
+
+        add_failed_faces(mesh);
+
+        report_progress(input_size_);
+        check_cancelled();
     }
-    if (has_dim)
+    catch (const CancelledException&)
     {
-        fclose(in);
-        throw IOException("Error: vertex dimension != 3 not supported");
+        mesh.clear();
+        throw;
     }
+}
 
-    // if binary: reopen file in binary mode
-    if (is_binary)
+void SurfaceMeshIO::read(SurfaceMesh& mesh, IndexedFaces& faces)
+{
+    faces = IndexedFaces();
+    deferred_faces_ = &faces;
+    try
     {
-        fclose(in);
-        in = fopen(filename_.c_str(), "rb");
-        c = fgets(line, 200, in);
-        assert(c != nullptr);
+        read(mesh);
+    }
+    catch (...)
+    {
+        deferred_faces_ = nullptr;
+        faces = IndexedFaces();
+        throw;
     }
+    deferred_faces_ = nullptr;
+}
 
-    // read as ASCII or binary
-    if (is_binary)
-        read_off_binary(mesh, in, has_normals, has_texcoords, has_colors);
-    else
-        read_off_ascii(mesh, in, has_normals, has_texcoords, has_colors);
+std::future<SurfaceMesh> SurfaceMeshIO::read_async(const std::string& filename,
+                                                   const IOFlags& flags)
+{
+    return std::async(std::launch::async, [filename, flags]() {
+        SurfaceMesh mesh;
+        SurfaceMeshIO(filename, flags).read(mesh);
+        return mesh;
+    });
+}
 
-    fclose(in);
+void SurfaceMeshIO::read(const char* data, size_t size,
+                         const std::string& format, SurfaceMesh& mesh,
+                         const IOFlags& flags)
+{
+    read_memory(std::vector<char>(data, data + size), format, mesh, flags);
 }
 
-void SurfaceMeshIO::write_off(const SurfaceMesh& mesh)
+void SurfaceMeshIO::read(std::istream& in, const std::string& format,
+                         SurfaceMesh& mesh, const IOFlags& flags)
 {
-    if (flags_.use_binary)
-    {
-        write_off_binary(mesh);
-        return;
-    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    if (in.bad())
+        throw IOException("Failed to read stream");
+    read_memory(std::move(data), format, mesh, flags);
+}
+
+void SurfaceMeshIO::read_memory(std::vector<char> data,
+                                const std::string& format, SurfaceMesh& mesh,
+                                const IOFlags& flags)
+{
+    // the readers parse the data in place like a memory-mapped file, the
+    // name only determines the format and appears in error messages
+    SurfaceMeshIO reader("<memory>." + format, flags);
+    reader.memory_input_ = std::make_shared<MappedFile>(std::move(data));
+    reader.read(mesh);
+}
+
+std::vector<char> SurfaceMeshIO::write(const SurfaceMesh& mesh,
+                                       const std::string& format,
+                                       const IOFlags& flags)
+{
+    std::vector<char> data;
+    SurfaceMeshIO writer("<memory>." + format, flags);
+    writer.memory_output_ = &data;
+    writer.write(mesh);
+    return data;
+}
 
-    FILE* out = fopen(filename_.c_str(), "w");
+void SurfaceMeshIO::write(const SurfaceMesh& mesh, std::ostream& out,
+                          const std::string& format, const IOFlags& flags)
+{
+    const auto data = write(mesh, format, flags);
+    out.write(data.data(), std::streamsize(data.size()));
     if (!out)
-        throw IOException("Failed to open file: " + filename_);
+        throw IOException("Failed to write stream");
+}
 
-    bool has_normals = false;
-    bool has_texcoords = false;
-    bool has_colors = false;
+bool SurfaceMeshIO::report_progress(size_t bytes)
+{
+    if (cancelled_)
+        return false;
+    if (flags_.progress && std::this_thread::get_id() == reader_thread_ &&
+        !flags_.progress(std::min(bytes, input_size_), input_size_))
+        cancelled_ = true;
+    return !cancelled_;
+}
 
-    auto normals = mesh.get_vertex_property<Normal>("v:normal");
-    auto texcoords = mesh.get_vertex_property<TexCoord>("v:tex");
-    auto colors = mesh.get_vertex_property<Color>("v:color");
+void SurfaceMeshIO::check_cancelled() const
+{
+    if (cancelled_)
+        throw CancelledException("Reading cancelled: " + filename_);
+}
 
-    if (normals && flags_.use_vertex_normals)
-        has_normals = true;
-    if (texcoords && flags_.use_vertex_texcoords)
-        has_texcoords = true;
-    if (colors && flags_.use_vertex_colors)
-        has_colors = true;
+void SurfaceMeshIO::write(const SurfaceMesh& mesh)
+{
+    std::string ext = format_extension();
 
-    // header
-    if (has_texcoords)
-        fprintf(out, "ST");
-    if (has_colors)
-        fprintf(out, "C");
-    if (has_normals)
-        fprintf(out, "N");
-    fprintf(out, "OFF\n%zu %zu 0\n", mesh.n_vertices(), mesh.n_faces());
+    output_compression_ = flags_.compression;
+    if (output_compression_ == Compression::Automatic)
+        output_compression_ = compression_from_extension(filename_);
+    if (!is_compression_supported(output_compression_))
+        throw IOException("Compression not supported for " + filename_);
 
-    // vertices, and optionally normals and texture coordinates
-    VertexProperty<Point> points = mesh.get_vertex_property<Point>("v:point");
-    for (SurfaceMesh::VertexIterator vit = mesh.vertices_begin();
-         vit != mesh.vertices_end(); ++vit)
+    // extension determines reader
+    if (ext == "off")
+        write_off(mesh);
+    else if (ext == "obj")
+        write_obj(mesh);
+    else if (ext == "stl")
+        write_stl(mesh);
+    else if (ext == "ply")
+        write_ply(mesh);
+    else if (ext == "pmp")
+        write_pmp(mesh);
+    else if (ext == "xyz")
+        write_xyz(mesh);
+    else if (ext == "pmc")
+        write_pmc(mesh);
+    else if (ext == "glb")
+        write_glb(mesh);
+    else if (ext == "sma" || ext == "smb")
+        write_streaming(mesh, ext == "smb");
+    else
+        throw IOException("Could not find writer for " + filename_);
+}
+
+void SurfaceMeshIO::read_obj(SurfaceMesh& mesh)
+{
+    auto mapped = map_input();
+    const MappedFile& file = *mapped;
+
+    // split the file into chunks starting at line beginnings
+    const auto bounds =
+        split_lines(file.data(), file.end(), size_t(1) << 22);
+    const size_t n_chunks = bounds.size() - 1;
+
+    // parse chunks in parallel
+    std::vector<ObjChunk> chunks(n_chunks);
+    std::atomic<size_t> n_parsed(0);
+    parallel_for(
+        0, int(n_chunks),
+        [&](int i) {
+            if (cancelled_)
+                return;
+            parse_obj_chunk(bounds[i], bounds[i + 1], chunks[i]);
+            report_progress(n_parsed += size_t(bounds[i + 1] - bounds[i]));
+        },
+        1);
+    check_cancelled();
+
+    for (const auto& c : chunks)
+        if (!c.error.empty())
+            throw IOException(c.error + " in file " + filename_);
+
+    // merge chunks, resolving relative indices
+    std::vector<size_t> point_offset(n_chunks + 1, 0),
+        tex_offset(n_chunks + 1, 0), corner_offset(n_chunks + 1, 0),
+        face_offset(n_chunks + 1, 0);
+    for (size_t i = 0; i < n_chunks; ++i)
     {
-        const Point& p = points[*vit];
-        fprintf(out, "%.10f %.10f %.10f", p[0], p[1], p[2]);
+        point_offset[i + 1] = point_offset[i] + chunks[i].points.size();
+        tex_offset[i + 1] = tex_offset[i] + chunks[i].tex_coords.size();
+        corner_offset[i + 1] = corner_offset[i] + chunks[i].vertices.size();
+        face_offset[i + 1] = face_offset[i] + chunks[i].face_sizes.size();
+    }
+    const auto n_points = int64_t(point_offset.back());
+    const auto n_tex_coords = int64_t(tex_offset.back());
+
+    std::vector<Point> points(point_offset.back());
+    std::vector<TexCoord> tex_coords(tex_offset.back());
+    std::vector<IndexType> indices(corner_offset.back());
+    std::vector<IndexType> tex_indices(corner_offset.back());
+    std::vector<IndexType> face_sizes(face_offset.back());
+    std::atomic<int> n_invalid(0), n_with_tex(0);
+
+    parallel_for(
+        0, int(n_chunks),
+        [&](int i) {
+            auto& c = chunks[i];
+            int invalid = 0, with_tex = 0;
+            std::copy(c.points.begin(), c.points.end(),
+                      points.begin() + point_offset[i]);
+            std::copy(c.tex_coords.begin(), c.tex_coords.end(),
+                      tex_coords.begin() + tex_offset[i]);
+            std::copy(c.face_sizes.begin(), c.face_sizes.end(),
+                      face_sizes.begin() + face_offset[i]);
+
+            for (size_t j = 0; j < c.vertices.size(); ++j)
+            {
+                auto v = c.vertices[j];
+                if (c.relative_vertices[j])
+                    v += int64_t(point_offset[i]);
+                if (v < 0 || v >= n_points)
+                    ++invalid;
+                indices[corner_offset[i] + j] = IndexType(v);
+
+                auto t = c.tex_coord_indices[j];
+                IndexType tidx = PMP_MAX_INDEX;
+                if (t != ObjChunk::no_index)
+                {
+                    if (c.relative_tex_coords[j])
+                        t += int64_t(tex_offset[i]);
+                    if (t < 0 || t >= n_tex_coords)
+                        ++invalid;
+                    tidx = IndexType(t);
+                    ++with_tex;
+                }
+                tex_indices[corner_offset[i] + j] = tidx;
+            }
 
-        if (has_normals)
-        {
-            const Normal& n = normals[*vit];
-            fprintf(out, " %.10f %.10f %.10f", n[0], n[1], n[2]);
-        }
+            n_invalid += invalid;
+            n_with_tex += with_tex;
+            ObjChunk().swap(c);
+        },
+        1);
 
-        if (has_colors)
-        {
-            const Color& c = colors[*vit];
-            fprintf(out, " %.10f %.10f %.10f", c[0], c[1], c[2]);
-        }
+    if (n_invalid)
+        throw IOException("Invalid vertex index in file " + filename_);
 
-        if (has_texcoords)
+    // texture coordinates are stored at the halfedges pointing to the
+    // corners, which requires the connectivity
+    if (n_with_tex)
+        deferred_faces_ = nullptr;
+    auto faces = add_indexed_faces(mesh, points, indices, face_sizes);
+
+    if (n_with_tex)
+    {
+        auto htex = mesh.halfedge_property<TexCoord>("h:tex");
+        size_t corner = 0;
+        for (size_t i = 0; i < face_sizes.size(); ++i)
         {
-            const TexCoord& t = texcoords[*vit];
-            fprintf(out, " %.10f %.10f", t[0], t[1]);
+            const size_t n = face_sizes[i];
+            Face f = faces[i];
+            if (f.is_valid())
+            {
+                auto h = mesh.halfedge(f);
+                size_t k = 0;
+                while (k < n &&
+                       indices[corner + k] != input_vertex(mesh.to_vertex(h)))
+                    ++k;
+                for (size_t j = 0; j < n; ++j, h = mesh.next_halfedge(h))
+                {
+                    auto t = tex_indices[corner + (k + j) % n];
+                    if (t != PMP_MAX_INDEX)
+                        htex[h] = tex_coords[t];
+                }
+            }
+            corner += n;
         }
+    }
+}
+
+namespace {
+
+// append the decimal representation of value to text
+void append_int(std::string& text, long long value)
+{
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    unsigned long long u = value < 0 ? 0ull - (unsigned long long)value
+                                     : (unsigned long long)value;
+    do
+    {
+        *--p = char('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (value < 0)
+        *--p = '-';
+    text.append(p, end);
+}
+
+// slow path of append_fixed()
+void append_fixed_slow(std::string& text, double value)
+{
+    char buffer[512];
+    int n = snprintf(buffer, sizeof(buffer), "%.10f", value);
+    if (n < 0)
+        return;
+    n = std::min(n, int(sizeof(buffer)) - 1);
 
-        fprintf(out, "\n");
+    // don't depend on the current locale
+    std::replace(buffer, buffer + n, ',', '.');
+    text.append(buffer, n);
+}
+
+// \brief Append value with ten decimals.
+// \details The result is the same as for printf("%.10f") in the C locale,
+// but is computed with integer arithmetic. Falls back to snprintf for large
+// values and when value is too close to a rounding tie.
+void append_fixed(std::string& text, double value)
+{
+    const double a = std::fabs(value);
+    if (!(a < 1e8)) // includes nan and inf
+    {
+        append_fixed_slow(text, value);
+        return;
     }
 
-    // faces
-    for (SurfaceMesh::FaceIterator fit = mesh.faces_begin();
-         fit != mesh.faces_end(); ++fit)
+    // the subtraction is exact, the product has an error below 1e-5
+    const double integer_part = std::floor(a);
+    const double scaled = (a - integer_part) * 1e10;
+    const double digits = std::floor(scaled);
+    const double rest = scaled - digits;
+    if (std::fabs(rest - 0.5) < 1e-4)
     {
-        int nv = mesh.valence(*fit);
-        fprintf(out, "%d", nv);
-        SurfaceMesh::VertexAroundFaceCirculator fvit = mesh.vertices(*fit),
-                                                fvend = fvit;
-        do
-        {
-            fprintf(out, " %d", (*fvit).idx());
-        } while (++fvit != fvend);
-        fprintf(out, "\n");
+        append_fixed_slow(text, value);
+        return;
     }
 
-    fclose(out);
+    auto integer = (unsigned long long)integer_part;
+    auto fraction = (unsigned long long)digits + (rest > 0.5 ? 1 : 0);
+    if (fraction == 10000000000ull)
+    {
+        fraction = 0;
+        ++integer;
+    }
+
+    if (std::signbit(value))
+        text += '-';
+    append_int(text, (long long)integer);
+    char buffer[11];
+    buffer[0] = '.';
+    for (int i = 10; i > 0; --i)
+    {
+        buffer[i] = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    text.append(buffer, 11);
 }
 
-void SurfaceMeshIO::read_pmp(SurfaceMesh& mesh)
+// append the coordinates of v, separated by spaces, to text
+template <int N>
+void append_vector(std::string& text, const Vector<Scalar, N>& v)
 {
-    // open file (in binary mode)
-    FILE* in = fopen(filename_.c_str(), "rb");
-    if (!in)
+    for (int i = 0; i < N; ++i)
+    {
+        if (i)
+            text += ' ';
+        append_fixed(text, v[i]);
+    }
+}
+
+// \brief Write the text for the elements 0..n-1 to out.
+// \details format(i, text) appends the text of element i, or its binary
+// record. Blocks of elements are formatted in parallel and written in order,
+// such that the output does not depend on the number of threads.
+// \return false if not all blocks were written
+template <class Format>
+bool write_text_blocks(FILE* out, size_t n, Format format)
+{
+    bool ok = true;
+    const size_t block_size = 8192;
+    const size_t n_blocks = (n + block_size - 1) / block_size;
+    std::vector<std::string> texts(std::min(n_blocks, size_t(64)));
+
+    for (size_t first_block = 0; first_block < n_blocks;
+         first_block += texts.size())
+    {
+        const int n_batch =
+            int(std::min(texts.size(), n_blocks - first_block));
+
+        parallel_for(
+            0, n_batch,
+            [&](int b) {
+                std::string& text = texts[b];
+                text.clear();
+                const size_t begin = (first_block + b) * block_size;
+                const size_t end = std::min(begin + block_size, n);
+                for (size_t i = begin; i < end; ++i)
+                    format(i, text);
+            },
+            1);
+
+        for (int b = 0; b < n_batch; ++b)
+            if (fwrite(texts[b].data(), 1, texts[b].size(), out) !=
+                texts[b].size())
+                ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+void SurfaceMeshIO::write_obj(const SurfaceMesh& mesh)
+{
+    FILE* out = open_output("w");
+    if (!out)
         throw IOException("Failed to open file: " + filename_);
 
-    // how many elements?
-    unsigned int nv(0), ne(0), nh(0), nf(0);
+    // comment
+    fprintf(out, "# OBJ export from PMP\n");
+
+    // write vertices
+    const auto points = mesh.get_vertex_property<Point>("v:point");
+    bool ok = write_text_blocks(out, mesh.vertices_size(),
+                                [&](size_t i, std::string& text) {
+                                    Vertex v(static_cast<IndexType>(i));
+                                    if (mesh.is_deleted(v))
+                                        return;
+                                    text += "v ";
+                                    append_vector(text, points[v]);
+                                    text += '\n';
+                                });
+
+    // write normals
+    const auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    if (normals)
+    {
+        if (!write_text_blocks(out, mesh.vertices_size(),
+                               [&](size_t i, std::string& text) {
+                                   Vertex v(static_cast<IndexType>(i));
+                                   if (mesh.is_deleted(v))
+                                       return;
+                                   text += "vn ";
+                                   append_vector(text, normals[v]);
+                                   text += '\n';
+                               }))
+            ok = false;
+    }
+
+    // write texture coordinates
+    const auto tex_coords = mesh.get_halfedge_property<TexCoord>("h:tex");
+    if (tex_coords)
+    {
+        if (!write_text_blocks(out, mesh.halfedges_size(),
+                               [&](size_t i, std::string& text) {
+                                   Halfedge h(static_cast<IndexType>(i));
+                                   if (mesh.is_deleted(h))
+                                       return;
+                                   text += "vt ";
+                                   append_vector(text, tex_coords[h]);
+                                   text += '\n';
+                               }))
+            ok = false;
+    }
+
+    // write faces
+    auto format_face = [&](size_t i, std::string& text) {
+        Face f(static_cast<IndexType>(i));
+        if (mesh.is_deleted(f))
+            return;
+
+        text += 'f';
+        auto h = mesh.halfedges(f);
+        for (auto v : mesh.vertices(f))
+        {
+            auto idx = v.idx() + 1;
+            text += ' ';
+            append_int(text, idx);
+            if (tex_coords)
+            {
+                // write vertex index, texCoord index and normal index
+                text += '/';
+                append_int(text, (*h).idx() + 1);
+                text += '/';
+                ++h;
+            }
+            else
+            {
+                // write vertex index and normal index
+                text += "//";
+            }
+            append_int(text, idx);
+        }
+        text += '\n';
+    };
+    if (!write_text_blocks(out, mesh.faces_size(), format_face))
+        ok = false;
+
+    const bool header_ok = !ferror(out);
+    close_output(out);
+    if (!ok || !header_ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+void SurfaceMeshIO::read_off_ascii(SurfaceMesh& mesh, FILE* in,
+                                   const bool has_normals,
+                                   const bool has_texcoords,
+                                   const bool has_colors)
+{
+    char line[1000], *lp;
+    int nc;
+    unsigned int i, j, items, idx;
+    unsigned int nv, nf, ne;
+    float x, y, z, r, g, b;
+
+    // #Vertice, #Faces, #Edges
+    items = fscanf(in, "%d %d %d\n", (int*)&nv, (int*)&nf, (int*)&ne);
+    PMP_ASSERT(items);
+
+    // vertex data, added as properties after building the mesh
+    std::vector<Point> points;
+    std::vector<Normal> normals;
+    std::vector<TexCoord> texcoords;
+    std::vector<Color> colors;
+    points.reserve(nv);
+    if (has_normals)
+        normals.resize(nv, Normal(0, 0, 0));
+    if (has_texcoords)
+        texcoords.resize(nv, TexCoord(0, 0));
+    if (has_colors)
+        colors.resize(nv, Color(0, 0, 0));
+
+    // read vertices: pos [normal] [color] [texcoord]
+    for (i = 0; i < nv && !feof(in); ++i)
+    {
+        if (i % 4096 == 0 && !report_progress(size_t(ftell(in))))
+            return;
+
+        // read line
+        lp = fgets(line, 1000, in);
+        lp = line;
+
+        // position
+        items = sscanf(lp, "%f %f %f%n", &x, &y, &z, &nc);
+        assert(items == 3);
+        const size_t v = points.size();
+        points.emplace_back(x, y, z);
+        lp += nc;
+
+        // normal
+        if (has_normals)
+        {
+            if (sscanf(lp, "%f %f %f%n", &x, &y, &z, &nc) == 3)
+            {
+                normals[v] = Normal(x, y, z);
+            }
+            lp += nc;
+        }
+
+        // color
+        if (has_colors)
+        {
+            if (sscanf(lp, "%f %f %f%n", &r, &g, &b, &nc) == 3)
+            {
+                if (r > 1.0f || g > 1.0f || b > 1.0f)
+                {
+                    r /= 255.0f;
+                    g /= 255.0f;
+                    b /= 255.0f;
+                }
+                colors[v] = Color(r, g, b);
+            }
+            lp += nc;
+        }
+
+        // tex coord
+        if (has_texcoords)
+        {
+            items = sscanf(lp, "%f %f%n", &x, &y, &nc);
+            assert(items == 2);
+            texcoords[v][0] = x;
+            texcoords[v][1] = y;
+            lp += nc;
+        }
+    }
+
+    // read faces: #N v[1] v[2] ... v[n-1]
+    std::vector<IndexType> indices;
+    std::vector<IndexType> face_sizes;
+    indices.reserve(3 * size_t(nf));
+    face_sizes.reserve(nf);
+    for (i = 0; i < nf; ++i)
+    {
+        if (i % 4096 == 0 && !report_progress(size_t(ftell(in))))
+            return;
+
+        // read line
+        lp = fgets(line, 1000, in);
+        lp = line;
+
+        // #vertices
+        unsigned int n;
+        items = sscanf(lp, "%d%n", (int*)&n, &nc);
+        assert(items == 1);
+        lp += nc;
+
+        // indices
+        for (j = 0; j < n; ++j)
+        {
+            items = sscanf(lp, "%d%n", (int*)&idx, &nc);
+            assert(items == 1);
+            if (idx >= points.size())
+                throw IOException("Invalid vertex index in file " +
+                                  filename_);
+            indices.push_back(idx);
+            lp += nc;
+        }
+        face_sizes.push_back(n);
+    }
+
+    add_indexed_faces(mesh, points, indices, face_sizes);
+    if (has_normals)
+        set_vertex_values(mesh, "v:normal", normals);
+    if (has_texcoords)
+        set_vertex_values(mesh, "v:tex", texcoords);
+    if (has_colors)
+        set_vertex_values(mesh, "v:color", colors);
+}
+
+void SurfaceMeshIO::read_off_binary(SurfaceMesh& mesh, FILE* in,
+                                    const bool has_normals,
+                                    const bool has_texcoords,
+                                    const bool has_colors)
+{
+    IndexType nv(0), nf(0), ne(0);
+
+    // binary cannot (yet) read colors
+    if (has_colors)
+        throw IOException("Colors not supported for binary OFF file.");
+
+    // #Vertice, #Faces, #Edges
     tfread(in, nv);
-    tfread(in, ne);
     tfread(in, nf);
-    nh = 2 * ne;
+    tfread(in, ne);
 
-    // texture coordinates?
-    bool has_htex(false);
-    tfread(in, has_htex);
+    // read the vertex block at once: pos [normal] [texcoord]
+    const size_t stride = (sizeof(Point) + (has_normals ? sizeof(Normal) : 0) +
+                           (has_texcoords ? sizeof(vec2) : 0)) /
+                          sizeof(Scalar);
+    std::vector<Scalar> vertex_data(size_t(nv) * stride);
+    if (fread(vertex_data.data(), sizeof(Scalar), vertex_data.size(), in) !=
+        vertex_data.size())
+        throw IOException("Failed to read vertices of " + filename_);
+    if (!report_progress(size_t(ftell(in))))
+        return;
 
-    // resize containers
-    mesh.vprops_.resize(nv);
-    mesh.hprops_.resize(nh);
-    mesh.eprops_.resize(ne);
-    mesh.fprops_.resize(nf);
+    std::vector<Point> points(nv);
+    for (size_t i = 0; i < nv; ++i)
+    {
+        const Scalar* x = &vertex_data[i * stride];
+        points[i] = Point(x[0], x[1], x[2]);
+    }
 
-    // get properties
-    auto vconn =
-        mesh.vertex_property<SurfaceMesh::VertexConnectivity>("v:connectivity");
-    auto hconn = mesh.halfedge_property<SurfaceMesh::HalfedgeConnectivity>(
-        "h:connectivity");
-    auto fconn =
-        mesh.face_property<SurfaceMesh::FaceConnectivity>("f:connectivity");
-    auto point = mesh.vertex_property<Point>("v:point");
+    // read the face block in chunks: #N v[1] v[2] ... v[n-1]
+    std::vector<IndexType> face_data;
+    const size_t chunk_size = size_t(1) << 20;
+    while (!feof(in))
+    {
+        const size_t n = face_data.size();
+        face_data.resize(n + chunk_size);
+        face_data.resize(
+            n + fread(face_data.data() + n, sizeof(IndexType), chunk_size, in));
+        if (!report_progress(size_t(ftell(in))))
+            return;
+    }
 
-    // read properties from file
-    size_t nvc = fread((char*)vconn.data(),
-                       sizeof(SurfaceMesh::VertexConnectivity), nv, in);
-    size_t nhc = fread((char*)hconn.data(),
-                       sizeof(SurfaceMesh::HalfedgeConnectivity), nh, in);
-    size_t nfc = fread((char*)fconn.data(),
-                       sizeof(SurfaceMesh::FaceConnectivity), nf, in);
-    size_t np = fread((char*)point.data(), sizeof(Point), nv, in);
-    PMP_ASSERT(nvc == nv);
-    PMP_ASSERT(nhc == nh);
-    PMP_ASSERT(nfc == nf);
-    PMP_ASSERT(np == nv);
+    std::vector<IndexType> indices;
+    std::vector<IndexType> face_sizes(nf);
+    indices.reserve(face_data.size() - std::min(face_data.size(), size_t(nf)));
+    size_t pos = 0;
+    for (size_t i = 0; i < nf; ++i)
+    {
+        if (pos == face_data.size() || face_data[pos] < 3 ||
+            face_data[pos] > face_data.size() - pos - 1)
+            throw IOException("Failed to read faces of " + filename_);
+        face_sizes[i] = face_data[pos];
+        for (size_t j = pos + 1; j <= pos + face_sizes[i]; ++j)
+        {
+            if (face_data[j] >= nv)
+                throw IOException("Invalid vertex index in file " +
+                                  filename_);
+            indices.push_back(face_data[j]);
+        }
+        pos += face_sizes[i] + 1;
+    }
+    std::vector<IndexType>().swap(face_data);
+
+    add_indexed_faces(mesh, points, indices, face_sizes);
+
+    // properties, after building the mesh which clears it
+    if (has_normals)
+    {
+        auto normals = mesh.vertex_property<Normal>("v:normal");
+        for (auto v : mesh.vertices())
+        {
+            const Scalar* x = &vertex_data[input_vertex(v) * stride + 3];
+            normals[v] = Normal(x[0], x[1], x[2]);
+        }
+    }
+    if (has_texcoords)
+    {
+        auto texcoords = mesh.vertex_property<TexCoord>("v:tex");
+        const size_t offset = has_normals ? 6 : 3;
+        for (auto v : mesh.vertices())
+        {
+            const Scalar* x = &vertex_data[input_vertex(v) * stride + offset];
+            texcoords[v] = TexCoord(x[0], x[1]);
+        }
+    }
+}
+
+void SurfaceMeshIO::write_off_binary(const SurfaceMesh& mesh)
+{
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    fprintf(out, "OFF BINARY\n");
+    IndexType nv = (IndexType)mesh.n_vertices();
+    IndexType nf = (IndexType)mesh.n_faces();
+    IndexType ne = 0;
+
+    tfwrite(out, nv);
+    tfwrite(out, nf);
+    tfwrite(out, ne);
+
+    // gather the vertex and face blocks and write each at once. indices
+    // skip deleted vertices.
+    auto points = mesh.get_vertex_property<Point>("v:point");
+    std::vector<Point> vertex_data;
+    vertex_data.reserve(nv);
+    std::vector<IndexType> index_map(mesh.vertices_size(), 0);
+    for (auto v : mesh.vertices())
+    {
+        index_map[v.idx()] = IndexType(vertex_data.size());
+        vertex_data.push_back(points[v]);
+    }
+
+    std::vector<IndexType> face_data;
+    face_data.reserve(size_t(nf) + mesh.n_halfedges());
+    for (auto f : mesh.faces())
+    {
+        face_data.push_back(IndexType(mesh.valence(f)));
+        for (auto fv : mesh.vertices(f))
+            face_data.push_back(index_map[fv.idx()]);
+    }
+
+    const bool ok = fwrite(vertex_data.data(), sizeof(Point),
+                           vertex_data.size(), out) == vertex_data.size() &&
+                    fwrite(face_data.data(), sizeof(IndexType),
+                           face_data.size(), out) == face_data.size();
+    close_output(out);
+    if (!ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+void SurfaceMeshIO::read_off(SurfaceMesh& mesh)
+{
+    char line[200];
+    bool has_texcoords = false;
+    bool has_normals = false;
+    bool has_colors = false;
+    bool has_hcoords = false;
+    bool has_dim = false;
+    bool is_binary = false;
+
+    // open file (in ASCII mode)
+    FILE* in = open_input("r");
+    if (!in)
+        throw IOException("Failed to open file: " + filename_);
+
+    // read header: [ST][C][N][4][n]OFF BINARY
+    char* c = fgets(line, 200, in);
+    assert(c != nullptr);
+    c = line;
+    if (c[0] == 'S' && c[1] == 'T')
+    {
+        has_texcoords = true;
+        c += 2;
+    }
+    if (c[0] == 'C')
+    {
+        has_colors = true;
+        ++c;
+    }
+    if (c[0] == 'N')
+    {
+        has_normals = true;
+        ++c;
+    }
+    if (c[0] == '4')
+    {
+        has_hcoords = true;
+        ++c;
+    }
+    if (c[0] == 'n')
+    {
+        has_dim = true;
+        ++c;
+    }
+    if (strncmp(c, "OFF", 3) != 0)
+    {
+        fclose(in);
+        throw IOException("Failed to parse OFF header");
+    }
+    if (strncmp(c + 4, "BINARY", 6) == 0)
+        is_binary = true;
+
+    if (has_hcoords)
+    {
+        fclose(in);
+        throw IOException("Error: Homogeneous coordinates not supported.");
+    }
+    if (has_dim)
+    {
+        fclose(in);
+        throw IOException("Error: vertex dimension != 3 not supported");
+    }
+
+    // if binary: reopen file in binary mode
+    if (is_binary)
+    {
+        fclose(in);
+        in = open_input("rb");
+        c = fgets(line, 200, in);
+        assert(c != nullptr);
+    }
+
+    // read as ASCII or binary
+    if (is_binary)
+        read_off_binary(mesh, in, has_normals, has_texcoords, has_colors);
+    else
+        read_off_ascii(mesh, in, has_normals, has_texcoords, has_colors);
+
+    fclose(in);
+    check_cancelled();
+}
+
+void SurfaceMeshIO::write_off(const SurfaceMesh& mesh)
+{
+    if (flags_.use_binary)
+    {
+        write_off_binary(mesh);
+        return;
+    }
+
+    FILE* out = open_output("w");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    bool has_normals = false;
+    bool has_texcoords = false;
+    bool has_colors = false;
+
+    const auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    const auto texcoords = mesh.get_vertex_property<TexCoord>("v:tex");
+    const auto colors = mesh.get_vertex_property<Color>("v:color");
+
+    if (normals && flags_.use_vertex_normals)
+        has_normals = true;
+    if (texcoords && flags_.use_vertex_texcoords)
+        has_texcoords = true;
+    if (colors && flags_.use_vertex_colors)
+        has_colors = true;
+
+    // header
+    if (has_texcoords)
+        fprintf(out, "ST");
+    if (has_colors)
+        fprintf(out, "C");
+    if (has_normals)
+        fprintf(out, "N");
+    fprintf(out, "OFF\n%zu %zu 0\n", mesh.n_vertices(), mesh.n_faces());
+
+    // vertices, and optionally normals and texture coordinates
+    const auto points = mesh.get_vertex_property<Point>("v:point");
+    const bool vertices_ok = write_text_blocks(
+        out, mesh.vertices_size(), [&](size_t i, std::string& text) {
+            Vertex v(static_cast<IndexType>(i));
+            if (mesh.is_deleted(v))
+                return;
+
+            append_vector(text, points[v]);
+            if (has_normals)
+            {
+                text += ' ';
+                append_vector(text, normals[v]);
+            }
+            if (has_colors)
+            {
+                text += ' ';
+                append_vector(text, colors[v]);
+            }
+            if (has_texcoords)
+            {
+                text += ' ';
+                append_vector(text, texcoords[v]);
+            }
+            text += '\n';
+        });
+
+    // faces
+    const bool faces_ok = write_text_blocks(
+        out, mesh.faces_size(), [&](size_t i, std::string& text) {
+            Face f(static_cast<IndexType>(i));
+            if (mesh.is_deleted(f))
+                return;
+
+            append_int(text, mesh.valence(f));
+            for (auto v : mesh.vertices(f))
+            {
+                text += ' ';
+                append_int(text, v.idx());
+            }
+            text += '\n';
+        });
+
+    const bool header_ok = !ferror(out);
+    close_output(out);
+    if (!vertices_ok || !faces_ok || !header_ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+namespace {
+
+// binary PMP format, version 2. All data is stored in native byte order,
+// which is checked when reading:
+//  - PmpHeader
+//  - n_sections PmpSection entries, one per property
+//  - property names
+//  - property data, each section aligned to pmp_alignment bytes
+const char pmp_magic[8] = {'P', 'M', 'P', 'M', 'E', 'S', 'H', '\0'};
+const uint32_t pmp_version = 2;
+const uint32_t pmp_byte_order = 0x01020304;
+const uint64_t pmp_alignment = 64;
+
+struct PmpHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t index_size;
+    uint32_t n_sections;
+    uint64_t n_elements[5]; // object, vertex, halfedge, edge, face
+};
+
+struct PmpSection
+{
+    uint64_t offset;       // of the data in the file
+    uint64_t count;        // number of elements
+    uint64_t name_offset;  // of the name in the file
+    uint32_t name_length;  // number of characters
+    uint32_t element_size; // bytes per element
+    uint8_t container;     // index into PmpHeader::n_elements
+    uint8_t type;          // PmpType
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(PmpHeader) == 64, "unexpected PMP header size");
+static_assert(sizeof(PmpSection) == 40, "unexpected PMP section size");
+
+// type tags of the property types supported by the PMP format
+#define PMP_FORMAT_TYPES(X)                                                    \
+    X(bool, 1)                                                                 \
+    X(int8_t, 2)                                                               \
+    X(uint8_t, 3)                                                              \
+    X(int16_t, 4)                                                              \
+    X(uint16_t, 5)                                                             \
+    X(int32_t, 6)                                                              \
+    X(uint32_t, 7)                                                             \
+    X(int64_t, 8)                                                              \
+    X(uint64_t, 9)                                                             \
+    X(float, 10)                                                               \
+    X(double, 11)                                                              \
+    X(vec2, 12)                                                                \
+    X(vec3, 13)                                                                \
+    X(vec4, 14)                                                                \
+    X(dvec2, 15)                                                               \
+    X(dvec3, 16)                                                               \
+    X(dvec4, 17)                                                               \
+    X(ivec2, 18)                                                               \
+    X(ivec3, 19)                                                               \
+    X(ivec4, 20)                                                               \
+    X(uvec2, 21)                                                               \
+    X(uvec3, 22)                                                               \
+    X(uvec4, 23)                                                               \
+    X(Vertex, 24)                                                              \
+    X(Halfedge, 25)                                                            \
+    X(Edge, 26)                                                                \
+    X(Face, 27)
+
+// the connectivity types are private to SurfaceMesh and handled separately
+const uint8_t pmp_connectivity_type = 100;
+
+// type tag of array, zero if the type is not supported
+uint8_t pmp_type(BasePropertyArray* array)
+{
+#define PMP_TYPE_TAG(T, tag)                                                   \
+    if (array->type() == typeid(T))                                            \
+        return tag;
+    PMP_FORMAT_TYPES(PMP_TYPE_TAG)
+#undef PMP_TYPE_TAG
+    return 0;
+}
+
+// call visitor.apply<T>() for the type T of tag, return false if unknown
+template <class Visitor>
+bool visit_pmp_type(uint8_t tag, Visitor& visitor)
+{
+    switch (tag)
+    {
+#define PMP_TYPE_CASE(T, tag)                                                  \
+    case tag:                                                                  \
+        visitor.template apply<T>();                                           \
+        return true;
+        PMP_FORMAT_TYPES(PMP_TYPE_CASE)
+#undef PMP_TYPE_CASE
+        default:
+            return false;
+    }
+}
+
+size_t pmp_element_size(uint8_t tag)
+{
+    size_t size = 0;
+    switch (tag)
+    {
+#define PMP_TYPE_SIZE(T, tag)                                                  \
+    case tag:                                                                  \
+        size = std::is_same<T, bool>::value ? 1 : sizeof(T);                   \
+        break;
+        PMP_FORMAT_TYPES(PMP_TYPE_SIZE)
+#undef PMP_TYPE_SIZE
+        default:
+            break;
+    }
+    return size;
+}
+
+uint64_t pmp_align(uint64_t offset)
+{
+    return (offset + pmp_alignment - 1) / pmp_alignment * pmp_alignment;
+}
+
+// write the elements of a property array, bools are written as bytes
+struct PmpSectionWriter
+{
+    template <class T>
+    void apply()
+    {
+        const auto& a = static_cast<const PropertyArray<T>&>(*array);
+        write(a);
+    }
+
+    template <class T>
+    void write(const PropertyArray<T>& a)
+    {
+        if (!a.is_external() && !a.is_sparse())
+        {
+            n_written += fwrite(a.data(), sizeof(T), a.size(), out) * sizeof(T);
+            return;
+        }
+        std::vector<T> buffer(a.size());
+        for (size_t i = 0; i < a.size(); ++i)
+            buffer[i] = a[i];
+        n_written +=
+            fwrite(buffer.data(), sizeof(T), buffer.size(), out) * sizeof(T);
+    }
+
+    void write(const PropertyArray<bool>& a)
+    {
+        std::vector<uint8_t> buffer(a.size());
+        for (size_t i = 0; i < a.size(); ++i)
+            buffer[i] = a[i] ? 1 : 0;
+        n_written += fwrite(buffer.data(), 1, buffer.size(), out);
+    }
+
+    BasePropertyArray* array;
+    FILE* out;
+    size_t n_written;
+};
+
+// read a section into a new or existing property of a container
+struct PmpSectionReader
+{
+    template <class T>
+    void apply()
+    {
+        auto p = container->get<T>(name);
+        if (!p)
+        {
+            if (container->exists(name))
+            {
+                error = "Type mismatch of property " + name;
+                return;
+            }
+            p = container->add<T>(name);
+        }
+        read(p);
+    }
+
+    template <class T>
+    void read(Property<T>& p)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(data);
+        if (zero_copy && address % alignof(T) == 0)
+        {
+            p.wrap(reinterpret_cast<T*>(data));
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+            memcpy(&p[i], data + i * sizeof(T), sizeof(T));
+    }
+
+    void read(Property<bool>& p)
+    {
+        for (size_t i = 0; i < count; ++i)
+            p[i] = data[i] != 0;
+    }
+
+    PropertyContainer* container;
+    std::string name;
+    char* data;
+    size_t count;
+    bool zero_copy;
+    std::string error;
+};
+
+} // namespace
+
+void SurfaceMeshIO::read_pmp(SurfaceMesh& mesh)
+{
+    // files of version 1 do not have a header
+    {
+        char magic[sizeof(pmp_magic)] = {0};
+        FILE* in = open_input("rb");
+        if (!in)
+            throw IOException("Failed to open file: " + filename_);
+        size_t n = fread(magic, 1, sizeof(magic), in);
+        fclose(in);
+        if (n != sizeof(magic) || memcmp(magic, pmp_magic, sizeof(magic)))
+        {
+            read_pmp_v1(mesh);
+            return;
+        }
+    }
+
+    const bool zero_copy = flags_.use_memory_mapping;
+    auto file = map_input(zero_copy);
+    auto truncated = [&]() {
+        return IOException("Truncated PMP file " + filename_);
+    };
+
+    PmpHeader header;
+    if (file->size() < sizeof(header))
+        throw truncated();
+    memcpy(&header, file->data(), sizeof(header));
+    if (header.version > pmp_version)
+        throw IOException("Unsupported PMP version in file " + filename_);
+    if (header.byte_order != pmp_byte_order)
+        throw IOException("Unsupported byte order in file " + filename_);
+    if (header.index_size != sizeof(IndexType))
+        throw IOException("Unsupported index type in file " + filename_);
+
+    const uint64_t table_end =
+        sizeof(header) + uint64_t(header.n_sections) * sizeof(PmpSection);
+    if (file->size() < table_end)
+        throw truncated();
+    std::vector<PmpSection> sections(header.n_sections);
+    if (!sections.empty())
+        memcpy(&sections[0], file->data() + sizeof(header),
+               sections.size() * sizeof(PmpSection));
+
+    PropertyContainer* containers[5] = {&mesh.oprops_, &mesh.vprops_,
+                                        &mesh.hprops_, &mesh.eprops_,
+                                        &mesh.fprops_};
+    for (int i = 1; i < 5; ++i)
+        containers[i]->resize(header.n_elements[i]);
+
+    for (const auto& s : sections)
+    {
+        report_progress(size_t(s.offset));
+        check_cancelled();
+
+        if (s.container > 4 || s.count != containers[s.container]->size() ||
+            s.name_offset + s.name_length > file->size() ||
+            s.offset + s.count * s.element_size > file->size())
+            throw truncated();
+
+        PmpSectionReader reader;
+        reader.container = containers[s.container];
+        reader.name.assign(file->data() + s.name_offset, s.name_length);
+        reader.data = file->writable_data() + s.offset;
+        reader.count = s.count;
+        reader.zero_copy = zero_copy;
+
+        if (s.type == pmp_connectivity_type)
+        {
+            if (reader.name == "v:connectivity")
+                reader.read(mesh.vconn_);
+            else if (reader.name == "h:connectivity")
+                reader.read(mesh.hconn_);
+            else if (reader.name == "f:connectivity")
+                reader.read(mesh.fconn_);
+            else
+                reader.error = "Unknown connectivity " + reader.name;
+        }
+        else if (pmp_element_size(s.type) != s.element_size)
+        {
+            // skip properties of unknown types written by later versions
+            continue;
+        }
+        else
+        {
+            visit_pmp_type(s.type, reader);
+        }
+
+        if (!reader.error.empty())
+            throw IOException(reader.error + " in file " + filename_);
+    }
+
+    // keep the file mapped as long as properties use it
+    if (zero_copy)
+    {
+        auto mapping =
+            mesh.add_object_property<std::shared_ptr<MappedFile>>(
+                "g:mapped_file");
+        mapping[0] = file;
+    }
+
+    if (mesh.has_edge_index())
+        mesh.rebuild_edge_index();
+}
+
+void SurfaceMeshIO::read_pmp_v1(SurfaceMesh& mesh)
+{
+    // open file (in binary mode)
+    FILE* in = open_input("rb");
+    if (!in)
+        throw IOException("Failed to open file: " + filename_);
+
+    // how many elements?
+    unsigned int nv(0), ne(0), nh(0), nf(0);
+    tfread(in, nv);
+    tfread(in, ne);
+    tfread(in, nf);
+    nh = 2 * ne;
+
+    // texture coordinates?
+    bool has_htex(false);
+    tfread(in, has_htex);
+
+    // resize containers
+    mesh.vprops_.resize(nv);
+    mesh.hprops_.resize(nh);
+    mesh.eprops_.resize(ne);
+    mesh.fprops_.resize(nf);
+
+    // get properties
+    auto vconn =
+        mesh.vertex_property<SurfaceMesh::VertexConnectivity>("v:connectivity");
+    auto hconn = mesh.halfedge_property<SurfaceMesh::HalfedgeConnectivity>(
+        "h:connectivity");
+    auto fconn =
+        mesh.face_property<SurfaceMesh::FaceConnectivity>("f:connectivity");
+    auto point = mesh.vertex_property<Point>("v:point");
+
+    // read properties from file
+    size_t nvc = fread((char*)vconn.data(),
+                       sizeof(SurfaceMesh::VertexConnectivity), nv, in);
+    size_t nhc = fread((char*)hconn.data(),
+                       sizeof(SurfaceMesh::HalfedgeConnectivity), nh, in);
+    size_t nfc = fread((char*)fconn.data(),
+                       sizeof(SurfaceMesh::FaceConnectivity), nf, in);
+    size_t np = fread((char*)point.data(), sizeof(Point), nv, in);
+    PMP_ASSERT(nvc == nv);
+    PMP_ASSERT(nhc == nh);
+    PMP_ASSERT(nfc == nf);
+    PMP_ASSERT(np == nv);
+
+    // read texture coordiantes
+    if (has_htex)
+    {
+        auto htex = mesh.halfedge_property<TexCoord>("h:tex");
+        size_t nhtc = fread((char*)htex.data(), sizeof(TexCoord), nh, in);
+        PMP_ASSERT(nhtc == nh);
+    }
+
+    fclose(in);
+}
+
+namespace {
+
+// values per line of ASCII point clouds. lines with less than min_values
+// values are skipped.
+struct PointLayout
+{
+    static const size_t none = size_t(-1);
+
+    size_t min_values = 3;
+    size_t normal_offset = none; // values of lines with at least offset + 3
+    size_t color_offset = none;  // values in [0, 255]
+};
+
+const size_t PointLayout::none;
+
+// parse up to n numbers of the line [p, eol), return the number parsed
+size_t parse_values(const char* p, const char* eol, double* values, size_t n)
+{
+    size_t k = 0;
+    for (; k < n; ++k)
+    {
+        skip_blanks(p, eol);
+        if (p == eol || !parse_double(p, eol, values[k]))
+            break;
+    }
+    return k;
+}
+
+// end of the line starting at p
+const char* end_of_line(const char* p, const char* end)
+{
+    const char* eol =
+        static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+    return eol ? eol : end;
+}
+
+// the values of the first data line, sets values to zero if there is none
+size_t parse_first_values(const char* p, const char* end, double* values,
+                          size_t n)
+{
+    while (p < end)
+    {
+        const char* eol = end_of_line(p, end);
+        if (is_data_line(p, eol))
+            return parse_values(p, eol, values, n);
+        p = eol + 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+void SurfaceMeshIO::read_points(SurfaceMesh& mesh)
+{
+    const std::string ext = format_extension();
+    auto mapped = map_input();
+    const char* begin = mapped->data();
+    const char* end = mapped->end();
+
+    // determine the layout from the first data line
+    double values[9];
+    size_t n_first = parse_first_values(begin, end, values, 9);
+    PointLayout layout;
+    if (ext == "agi")
+    {
+        // x y z r g b nx ny nz
+        layout.min_values = 9;
+        layout.color_offset = 3;
+        layout.normal_offset = 6;
+    }
+    else if (ext == "pts")
+    {
+        // an optional line with the number of points, followed by
+        // x y z [intensity] [r g b]
+        if (n_first == 1)
+        {
+            begin = std::min(end_of_line(begin, end) + 1, end);
+            n_first = parse_first_values(begin, end, values, 9);
+        }
+        if (n_first == 6 || n_first == 7)
+        {
+            layout.color_offset = n_first - 3;
+            layout.min_values = n_first;
+        }
+    }
+    else if (n_first >= 6)
+    {
+        // x y z [nx ny nz]
+        layout.normal_offset = 3;
+    }
+
+    // count the data lines of chunks in parallel to place their points
+    const auto bounds = split_lines(begin, end, size_t(1) << 22);
+    const size_t n_chunks = bounds.size() - 1;
+    std::vector<size_t> offsets(n_chunks + 1, 0);
+    parallel_for(
+        0, int(n_chunks),
+        [&](int i) {
+            offsets[i + 1] = count_data_lines(bounds[i], bounds[i + 1]);
+        },
+        1);
+    for (size_t i = 0; i < n_chunks; ++i)
+        offsets[i + 1] += offsets[i];
+
+    // allocate all vertices and properties at once
+    const Vertex first = mesh.new_vertices(offsets.back());
+    auto points = mesh.vertex_property<Point>("v:point");
+    VertexProperty<Normal> normals;
+    VertexProperty<Color> colors;
+    if (layout.normal_offset != PointLayout::none)
+        normals = mesh.vertex_property<Normal>("v:normal");
+    if (layout.color_offset != PointLayout::none)
+        colors = mesh.vertex_property<Color>("v:color");
+
+    // parse chunks in parallel, writing their points to their offsets
+    std::vector<size_t> n_points(n_chunks, 0);
+    std::atomic<size_t> n_parsed(0);
+    parallel_for(
+        0, int(n_chunks),
+        [&](int i) {
+            if (cancelled_)
+                return;
+
+            double x[9];
+            size_t idx = first.idx() + offsets[i];
+            for (const char* p = bounds[i]; p < bounds[i + 1];)
+            {
+                const char* eol = end_of_line(p, bounds[i + 1]);
+                const char* line = p;
+                p = eol + 1;
+                if (!is_data_line(line, eol))
+                    continue;
+                const size_t n_values = parse_values(line, eol, x, 9);
+                if (n_values < layout.min_values)
+                    continue;
+
+                const Vertex v(IndexType(idx++));
+                points[v] = Point(x[0], x[1], x[2]);
+                if (normals && n_values >= layout.normal_offset + 3)
+                {
+                    const double* n = x + layout.normal_offset;
+                    normals[v] = Normal(n[0], n[1], n[2]);
+                }
+                if (colors)
+                {
+                    const double* c = x + layout.color_offset;
+                    colors[v] = Color(c[0], c[1], c[2]) / Scalar(255);
+                }
+            }
+            n_points[i] = idx - first.idx() - offsets[i];
+            report_progress(n_parsed += size_t(bounds[i + 1] - bounds[i]));
+        },
+        1);
+    check_cancelled();
+
+    // close the gaps left by data lines that turned out to be invalid
+    size_t n_valid = 0;
+    for (size_t i = 0; i < n_chunks; ++i)
+    {
+        if (n_valid != offsets[i])
+        {
+            for (size_t j = 0; j < n_points[i]; ++j)
+            {
+                const Vertex from(IndexType(first.idx() + offsets[i] + j));
+                const Vertex to(IndexType(first.idx() + n_valid + j));
+                points[to] = points[from];
+                if (normals)
+                    normals[to] = normals[from];
+                if (colors)
+                    colors[to] = colors[from];
+            }
+        }
+        n_valid += n_points[i];
+    }
+    if (n_valid < offsets.back())
+    {
+        for (size_t i = n_valid; i < offsets.back(); ++i)
+            mesh.delete_vertex(Vertex(IndexType(first.idx() + i)));
+        mesh.garbage_collection();
+    }
+}
+
+void SurfaceMeshIO::write_pmp(const SurfaceMesh& mesh)
+{
+    // only store non-deleted elements
+    if (mesh.has_garbage())
+    {
+        SurfaceMesh copy(mesh);
+        copy.garbage_collection();
+        write_pmp(copy);
+        return;
+    }
+
+    const PropertyContainer* containers[5] = {&mesh.oprops_, &mesh.vprops_,
+                                              &mesh.hprops_, &mesh.eprops_,
+                                              &mesh.fprops_};
+
+    // collect the properties of supported types
+    std::vector<PmpSection> sections;
+    std::vector<BasePropertyArray*> arrays;
+    std::string names;
+    for (uint8_t c = 0; c < 5; ++c)
+    {
+        for (auto a : containers[c]->arrays())
+        {
+            PmpSection s;
+            memset(&s, 0, sizeof(s));
+            s.container = c;
+            s.count = containers[c]->size();
+            s.name_length = uint32_t(a->name().size());
+
+            if (c == 1 && a->name() == "v:connectivity")
+            {
+                s.type = pmp_connectivity_type;
+                s.element_size = sizeof(SurfaceMesh::VertexConnectivity);
+            }
+            else if (c == 2 && a->name() == "h:connectivity")
+            {
+                s.type = pmp_connectivity_type;
+                s.element_size = sizeof(SurfaceMesh::HalfedgeConnectivity);
+            }
+            else if (c == 4 && a->name() == "f:connectivity")
+            {
+                s.type = pmp_connectivity_type;
+                s.element_size = sizeof(SurfaceMesh::FaceConnectivity);
+            }
+            else if ((s.type = pmp_type(a)) != 0)
+            {
+                s.element_size = uint32_t(pmp_element_size(s.type));
+            }
+            else
+            {
+                continue; // not supported, e.g., std::vector values
+            }
+
+            s.name_offset = names.size();
+            names += a->name();
+            sections.push_back(s);
+            arrays.push_back(a);
+        }
+    }
+
+    // layout
+    PmpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, pmp_magic, sizeof(pmp_magic));
+    header.version = pmp_version;
+    header.byte_order = pmp_byte_order;
+    header.index_size = sizeof(IndexType);
+    header.n_sections = uint32_t(sections.size());
+    for (int c = 0; c < 5; ++c)
+        header.n_elements[c] = containers[c]->size();
+
+    const uint64_t names_offset =
+        sizeof(header) + sections.size() * sizeof(PmpSection);
+    uint64_t offset = names_offset + names.size();
+    for (auto& s : sections)
+    {
+        s.name_offset += names_offset;
+        s.offset = offset = pmp_align(offset);
+        offset += s.count * s.element_size;
+    }
+
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    size_t n_written = fwrite(&header, sizeof(header), 1, out) * sizeof(header);
+    if (!sections.empty())
+        n_written += fwrite(sections.data(), sizeof(PmpSection),
+                            sections.size(), out) *
+                     sizeof(PmpSection);
+    n_written += fwrite(names.data(), 1, names.size(), out);
+
+    bool ok = n_written == names_offset + names.size();
+    uint64_t position = n_written;
+    const char zeros[pmp_alignment] = {0};
+    for (size_t i = 0; ok && i < sections.size(); ++i)
+    {
+        const PmpSection& s = sections[i];
+        const size_t padding = size_t(s.offset - position);
+        ok = fwrite(zeros, 1, padding, out) == padding;
+
+        PmpSectionWriter writer;
+        writer.array = arrays[i];
+        writer.out = out;
+        writer.n_written = 0;
+        if (s.type != pmp_connectivity_type)
+            visit_pmp_type(s.type, writer);
+        else if (s.container == 1)
+            writer.apply<SurfaceMesh::VertexConnectivity>();
+        else if (s.container == 2)
+            writer.apply<SurfaceMesh::HalfedgeConnectivity>();
+        else
+            writer.apply<SurfaceMesh::FaceConnectivity>();
+
+        ok = ok && writer.n_written == s.count * s.element_size;
+        position = s.offset + writer.n_written;
+    }
+
+    close_output(out);
+    if (!ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+// helper to assemble vertex data
+static int vertexCallback(p_ply_argument argument)
+{
+    long idx;
+    void* pdata;
+    ply_get_argument_user_data(argument, &pdata, &idx);
+
+    auto* mesh = (pmp::SurfaceMesh*)pdata;
+    auto point = mesh->get_object_property<pmp::Point>("g:point");
+    point[0][idx] = ply_get_argument_value(argument);
+
+    if (idx == 2)
+        mesh->add_vertex(point[0]);
+
+    return 1;
+}
+
+// helper to assemble face data
+static int faceCallback(p_ply_argument argument)
+{
+    long length, value_index;
+    void* pdata;
+    long idata;
+    ply_get_argument_user_data(argument, &pdata, &idata);
+    ply_get_argument_property(argument, nullptr, &length, &value_index);
+
+    auto* mesh = (pmp::SurfaceMesh*)pdata;
+    auto vertices =
+        mesh->get_object_property<std::vector<pmp::Vertex>>("g:vertices");
+
+    if (value_index == 0)
+        vertices[0].clear();
+
+    pmp::IndexType idx = (pmp::IndexType)ply_get_argument_value(argument);
+    vertices[0].push_back(pmp::Vertex(idx));
+
+    if (value_index == length - 1)
+        mesh->add_face(vertices[0]);
+
+    return 1;
+}
+
+namespace {
+
+bool is_little_endian()
+{
+    const uint16_t one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+// append the bytes of value to a binary record
+template <class T>
+void append_binary(std::string& record, const T& value)
+{
+    record.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// scalar types of the PLY format
+enum PlyType
+{
+    PLY_TYPE_INVALID,
+    PLY_TYPE_INT8,
+    PLY_TYPE_UINT8,
+    PLY_TYPE_INT16,
+    PLY_TYPE_UINT16,
+    PLY_TYPE_INT32,
+    PLY_TYPE_UINT32,
+    PLY_TYPE_FLOAT32,
+    PLY_TYPE_FLOAT64
+};
+
+PlyType ply_type(const std::string& name)
+{
+    if (name == "char" || name == "int8")
+        return PLY_TYPE_INT8;
+    if (name == "uchar" || name == "uint8")
+        return PLY_TYPE_UINT8;
+    if (name == "short" || name == "int16")
+        return PLY_TYPE_INT16;
+    if (name == "ushort" || name == "uint16")
+        return PLY_TYPE_UINT16;
+    if (name == "int" || name == "int32")
+        return PLY_TYPE_INT32;
+    if (name == "uint" || name == "uint32")
+        return PLY_TYPE_UINT32;
+    if (name == "float" || name == "float32")
+        return PLY_TYPE_FLOAT32;
+    if (name == "double" || name == "float64")
+        return PLY_TYPE_FLOAT64;
+    return PLY_TYPE_INVALID;
+}
+
+size_t ply_size(PlyType type)
+{
+    static const size_t sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+    return sizes[type];
+}
+
+// read a little-endian scalar of the given type at p
+template <class T>
+T ply_value(const char* p, PlyType type)
+{
+    switch (type)
+    {
+        case PLY_TYPE_INT8:
+            return T(*reinterpret_cast<const signed char*>(p));
+        case PLY_TYPE_UINT8:
+            return T(*reinterpret_cast<const unsigned char*>(p));
+        case PLY_TYPE_INT16:
+        {
+            int16_t v;
+            memcpy(&v, p, 2);
+            return T(v);
+        }
+        case PLY_TYPE_UINT16:
+        {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            return T(v);
+        }
+        case PLY_TYPE_INT32:
+        {
+            int32_t v;
+            memcpy(&v, p, 4);
+            return T(v);
+        }
+        case PLY_TYPE_UINT32:
+        {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            return T(v);
+        }
+        case PLY_TYPE_FLOAT32:
+        {
+            float v;
+            memcpy(&v, p, 4);
+            return T(v);
+        }
+        case PLY_TYPE_FLOAT64:
+        {
+            double v;
+            memcpy(&v, p, 8);
+            return T(v);
+        }
+        default:
+            return T(0);
+    }
+}
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type = PLY_TYPE_INVALID;
+    PlyType count_type = PLY_TYPE_INVALID; // valid for lists only
+    size_t offset = 0;                     // within fixed-size records
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    // size of a record if there are no list properties, zero otherwise
+    size_t stride() const
+    {
+        size_t s = 0;
+        for (const auto& p : properties)
+        {
+            if (p.count_type != PLY_TYPE_INVALID)
+                return 0;
+            s += ply_size(p.type);
+        }
+        return s;
+    }
+
+    const PlyProperty* find(const char* name) const
+    {
+        for (const auto& p : properties)
+            if (p.name == name)
+                return &p;
+        return nullptr;
+    }
+};
+
+// parse the header of a PLY file, return the first byte after the header or
+// null if the header is invalid. binary_le tells whether the data is binary
+// little-endian.
+const char* parse_ply_header(const char* begin, const char* end,
+                             std::vector<PlyElement>& elements,
+                             bool& binary_le)
+{
+    const char* p = begin;
+    binary_le = false;
+    size_t n_lines = 0;
+    while (p < end)
+    {
+        const char* eol =
+            static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        if (!eol)
+            return nullptr;
+
+        std::vector<std::string> tokens;
+        while (p < eol)
+        {
+            while (p < eol && (is_blank(*p)))
+                ++p;
+            const char* q = p;
+            while (q < eol && !is_blank(*q))
+                ++q;
+            if (q > p)
+                tokens.emplace_back(p, q);
+            p = q;
+        }
+        p = eol + 1;
+
+        if (n_lines++ == 0)
+        {
+            if (tokens.size() != 1 || tokens[0] != "ply")
+                return nullptr;
+        }
+        else if (tokens.empty() || tokens[0] == "comment" ||
+                 tokens[0] == "obj_info")
+        {
+            continue;
+        }
+        else if (tokens[0] == "format")
+        {
+            binary_le = tokens.size() > 1 &&
+                        tokens[1] == "binary_little_endian";
+        }
+        else if (tokens[0] == "element" && tokens.size() == 3)
+        {
+            PlyElement e;
+            e.name = tokens[1];
+            e.count = size_t(std::strtoull(tokens[2].c_str(), nullptr, 10));
+            elements.push_back(e);
+        }
+        else if (tokens[0] == "property" && !elements.empty())
+        {
+            PlyProperty prop;
+            if (tokens.size() == 3)
+            {
+                prop.type = ply_type(tokens[1]);
+                prop.name = tokens[2];
+            }
+            else if (tokens.size() == 5 && tokens[1] == "list")
+            {
+                prop.count_type = ply_type(tokens[2]);
+                prop.type = ply_type(tokens[3]);
+                prop.name = tokens[4];
+                if (prop.count_type == PLY_TYPE_INVALID)
+                    return nullptr;
+            }
+            if (prop.type == PLY_TYPE_INVALID)
+                return nullptr;
+
+            auto& e = elements.back();
+            if (!e.properties.empty())
+            {
+                const auto& last = e.properties.back();
+                prop.offset = last.offset + ply_size(last.type);
+            }
+            e.properties.push_back(prop);
+        }
+        else if (tokens[0] == "end_header")
+        {
+            return p;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool SurfaceMeshIO::read_ply_binary(SurfaceMesh& mesh)
+{
+    if (!is_little_endian())
+        return false;
+
+    auto mapped = map_input();
+    const MappedFile& file = *mapped;
+    std::vector<PlyElement> elements;
+    bool binary_le;
+    const char* p =
+        parse_ply_header(file.data(), file.end(), elements, binary_le);
+    if (!p || !binary_le)
+        return false;
+
+    // supported layout: scalar vertex properties followed by faces with a
+    // single list of vertex indices
+    if (elements.empty() || elements[0].name != "vertex" ||
+        !elements[0].stride() || elements.size() > 2)
+        return false;
+    const PlyElement& velem = elements[0];
+    const PlyProperty* x = velem.find("x");
+    const PlyProperty* y = velem.find("y");
+    const PlyProperty* z = velem.find("z");
+    if (!x || !y || !z)
+        return false;
+
+    const PlyProperty* flist = nullptr;
+    if (elements.size() == 2)
+    {
+        const PlyElement& felem = elements[1];
+        if (felem.name != "face" || felem.properties.size() != 1)
+            return false;
+        flist = &felem.properties[0];
+        if (flist->count_type == PLY_TYPE_INVALID ||
+            (flist->name != "vertex_indices" && flist->name != "vertex_index"))
+            return false;
+    }
+
+    // vertex block
+    const size_t stride = velem.stride();
+    const size_t nv = velem.count;
+    if (size_t(file.end() - p) < nv * stride)
+        throw IOException("Truncated PLY file " + filename_);
+
+    const PlyProperty* nx = velem.find("nx");
+    const PlyProperty* ny = velem.find("ny");
+    const PlyProperty* nz = velem.find("nz");
+    const bool has_normals = nx && ny && nz;
+
+    const PlyProperty* red = velem.find("red");
+    const PlyProperty* green = velem.find("green");
+    const PlyProperty* blue = velem.find("blue");
+    const bool has_colors = red && green && blue;
+
+    // colors are stored as bytes or in [0,1]
+    auto color = [](const char* record, const PlyProperty* c) {
+        Scalar v = ply_value<Scalar>(record + c->offset, c->type);
+        if (c->type != PLY_TYPE_FLOAT32 && c->type != PLY_TYPE_FLOAT64)
+            v /= Scalar(255);
+        return v;
+    };
+
+    std::vector<Point> points(nv);
+    std::vector<Normal> normals(has_normals ? nv : 0);
+    std::vector<Color> colors(has_colors ? nv : 0);
+
+    parallel_for(0, int(nv), [&](int i) {
+        const char* record = p + size_t(i) * stride;
+        points[i] = Point(ply_value<Scalar>(record + x->offset, x->type),
+                          ply_value<Scalar>(record + y->offset, y->type),
+                          ply_value<Scalar>(record + z->offset, z->type));
+        if (has_normals)
+            normals[i] =
+                Normal(ply_value<Scalar>(record + nx->offset, nx->type),
+                       ply_value<Scalar>(record + ny->offset, ny->type),
+                       ply_value<Scalar>(record + nz->offset, nz->type));
+        if (has_colors)
+            colors[i] = Color(color(record, red), color(record, green),
+                              color(record, blue));
+    });
+    p += nv * stride;
+    report_progress(size_t(p - file.data()));
+    check_cancelled();
+
+    // face block, records have variable size
+    std::vector<IndexType> indices, face_sizes;
+    if (flist)
+    {
+        const size_t nf = elements[1].count;
+        const size_t count_size = ply_size(flist->count_type);
+        const size_t index_size = ply_size(flist->type);
+        indices.reserve(3 * nf);
+        face_sizes.reserve(nf);
+
+        for (size_t f = 0; f < nf; ++f)
+        {
+            if (f % 65536 == 0)
+            {
+                report_progress(size_t(p - file.data()));
+                check_cancelled();
+            }
+            if (size_t(file.end() - p) < count_size)
+                throw IOException("Truncated PLY file " + filename_);
+            const auto n = ply_value<size_t>(p, flist->count_type);
+            p += count_size;
+            if (size_t(file.end() - p) < n * index_size)
+                throw IOException("Truncated PLY file " + filename_);
+
+            for (size_t j = 0; j < n; ++j, p += index_size)
+            {
+                const auto idx = ply_value<int64_t>(p, flist->type);
+                if (idx < 0 || idx >= int64_t(nv))
+                    throw IOException("Invalid vertex index in file " +
+                                      filename_);
+                indices.push_back(IndexType(idx));
+            }
+
+            // skip faces with less than three vertices
+            if (n < 3)
+                indices.resize(indices.size() - n);
+            else
+                face_sizes.push_back(IndexType(n));
+        }
+    }
+
+    add_indexed_faces(mesh, points, indices, face_sizes);
+    if (has_normals)
+        set_vertex_values(mesh, "v:normal", normals);
+    if (has_colors)
+        set_vertex_values(mesh, "v:color", colors);
+
+    return true;
+}
+
+void SurfaceMeshIO::read_ply(SurfaceMesh& mesh)
+{
+    if (read_ply_binary(mesh))
+        return;
+    // add object properties to hold temporary data
+    auto point = mesh.add_object_property<Point>("g:point");
+    auto vertices = mesh.add_object_property<std::vector<Vertex>>("g:vertices");
+
+    // open file, read header
+    FILE* in = open_input("rb");
+    p_ply ply = in ? ply_open_from_file(in, nullptr, 0, nullptr) : nullptr;
+
+    if (!ply)
+    {
+        if (in)
+            fclose(in);
+        throw IOException("Failed to open file: " + filename_);
+    }
+
+    if (!ply_read_header(ply))
+        throw IOException("Failed to read PLY header!");
+
+    // reserve memory for the elements announced in the header
+    long n_vertices = 0, n_faces = 0;
+    p_ply_element element = nullptr;
+    while ((element = ply_get_next_element(ply, element)))
+    {
+        const char* name;
+        long n;
+        ply_get_element_info(element, &name, &n);
+        if (strcmp(name, "vertex") == 0)
+            n_vertices = n;
+        else if (strcmp(name, "face") == 0)
+            n_faces = n;
+    }
+    mesh.reserve(size_t(n_vertices), size_t(n_vertices + n_faces),
+                 size_t(n_faces));
+
+    // setup callbacks for basic properties
+    ply_set_read_cb(ply, "vertex", "x", vertexCallback, &mesh, 0);
+    ply_set_read_cb(ply, "vertex", "y", vertexCallback, &mesh, 1);
+    ply_set_read_cb(ply, "vertex", "z", vertexCallback, &mesh, 2);
+
+    ply_set_read_cb(ply, "face", "vertex_indices", faceCallback, &mesh, 0);
+
+    // read the data
+    if (!ply_read(ply))
+        throw IOException("Failed to read PLY data!");
+
+    ply_close(ply);
+    fclose(in);
+
+    // clean-up properties
+    mesh.remove_object_property(point);
+    mesh.remove_object_property(vertices);
+}
+
+void SurfaceMeshIO::write_ply_binary(const SurfaceMesh& mesh)
+{
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    auto points = mesh.get_vertex_property<Point>("v:point");
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto colors = mesh.get_vertex_property<Color>("v:color");
+    const bool has_normals = normals && flags_.use_vertex_normals;
+    const bool has_colors = colors && flags_.use_vertex_colors;
+
+    // header
+    fprintf(out, "ply\nformat binary_little_endian 1.0\n");
+    fprintf(out, "comment File written with pmp-library\n");
+    fprintf(out, "element vertex %zu\n", mesh.n_vertices());
+    fprintf(out, "property float x\nproperty float y\nproperty float z\n");
+    if (has_normals)
+        fprintf(out,
+                "property float nx\nproperty float ny\nproperty float nz\n");
+    if (has_colors)
+        fprintf(out, "property uchar red\nproperty uchar green\n"
+                     "property uchar blue\n");
+    fprintf(out, "element face %zu\n", mesh.n_faces());
+    fprintf(out, "property list uchar int vertex_indices\nend_header\n");
+
+    // vertex indices without deleted vertices
+    std::vector<int> index(mesh.vertices_size(), -1);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        index[v.idx()] = int(vertices.size());
+        vertices.push_back(v);
+    }
+
+    // the list size of a face is a single byte
+    const int n_large = parallel_reduce(
+        0, int(mesh.faces_size()), 0,
+        [&](int i) {
+            const Face f(static_cast<IndexType>(i));
+            return int(!mesh.is_deleted(f) && mesh.valence(f) > 255);
+        },
+        [](int a, int b) { return a + b; });
+    if (n_large)
+    {
+        fclose(out);
+        auto what = "SurfaceMeshIO::write_ply: Face with more than 255 "
+                    "vertices.";
+        throw InvalidInputException(what);
+    }
+
+    // vertex block
+    const bool vertices_ok = write_text_blocks(
+        out, vertices.size(), [&](size_t i, std::string& record) {
+            const Vertex v = vertices[i];
+            for (int j = 0; j < 3; ++j)
+                append_binary(record, float(points[v][j]));
+            if (has_normals)
+                for (int j = 0; j < 3; ++j)
+                    append_binary(record, float(normals[v][j]));
+            if (has_colors)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    Scalar c = std::min(std::max(colors[v][j], Scalar(0)),
+                                        Scalar(1));
+                    record += char((unsigned char)(c * Scalar(255) + 0.5));
+                }
+            }
+        });
+
+    // face block
+    const bool faces_ok = write_text_blocks(
+        out, mesh.faces_size(), [&](size_t i, std::string& record) {
+            const Face f(static_cast<IndexType>(i));
+            if (mesh.is_deleted(f))
+                return;
+            record += char((unsigned char)mesh.valence(f));
+            for (auto v : mesh.vertices(f))
+                append_binary(record, int32_t(index[v.idx()]));
+        });
+
+    close_output(out);
+    if (!vertices_ok || !faces_ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+void SurfaceMeshIO::write_ply(const SurfaceMesh& mesh)
+{
+    if (flags_.use_binary && is_little_endian())
+    {
+        write_ply_binary(mesh);
+        return;
+    }
+
+    e_ply_storage_mode mode = flags_.use_binary ? PLY_LITTLE_ENDIAN : PLY_ASCII;
+    FILE* out = open_output("wb");
+    p_ply ply = out ? ply_create_to_file(out, mode, nullptr, 0, nullptr)
+                    : nullptr;
+    if (!ply)
+    {
+        if (out)
+            fclose(out);
+        throw IOException("Failed to open file: " + filename_);
+    }
+
+    ply_add_comment(ply, "File written with pmp-library");
+    ply_add_element(ply, "vertex", mesh.n_vertices());
+    ply_add_scalar_property(ply, "x", PLY_FLOAT);
+    ply_add_scalar_property(ply, "y", PLY_FLOAT);
+    ply_add_scalar_property(ply, "z", PLY_FLOAT);
+    ply_add_element(ply, "face", mesh.n_faces());
+    ply_add_property(ply, "vertex_indices", PLY_LIST, PLY_UCHAR, PLY_INT);
+    ply_write_header(ply);
+
+    // write vertices
+    auto points = mesh.get_vertex_property<Point>("v:point");
+    for (auto v : mesh.vertices())
+    {
+        ply_write(ply, points[v][0]);
+        ply_write(ply, points[v][1]);
+        ply_write(ply, points[v][2]);
+    }
+
+    // write faces
+    for (auto f : mesh.faces())
+    {
+        ply_write(ply, mesh.valence(f));
+        for (auto fv : mesh.vertices(f))
+            ply_write(ply, fv.idx());
+    }
+
+    ply_close(ply);
+    close_output(out);
+}
+
+namespace {
+
+// the integer grid cell of a point, or its exact bit pattern for welding
+// without tolerance
+struct WeldKey
+{
+    bool operator==(const WeldKey& rhs) const
+    {
+        return c[0] == rhs.c[0] && c[1] == rhs.c[1] && c[2] == rhs.c[2];
+    }
+
+    int64_t c[3];
+};
+
+struct WeldKeyHash
+{
+    size_t operator()(const WeldKey& k) const
+    {
+        uint64_t h = uint64_t(k.c[0]) * 0x9E3779B97F4A7C15ull;
+        h ^= uint64_t(k.c[1]) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= uint64_t(k.c[2]) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        return size_t(h ^ (h >> 32));
+    }
+};
+
+WeldKey exact_key(const vec3& p)
+{
+    WeldKey k;
+    for (int i = 0; i < 3; ++i)
+    {
+        // map -0 to +0
+        float f = p[i] + 0.0f;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        k.c[i] = bits;
+    }
+    return k;
+}
+
+WeldKey cell_key(const vec3& p, double cell_size)
+{
+    WeldKey k;
+    for (int i = 0; i < 3; ++i)
+        k.c[i] = int64_t(std::floor(double(p[i]) / cell_size));
+    return k;
+}
+
+// Merge corners into vertices and return the vertex index of each corner.
+// Vertices are numbered by their first corner. With zero tolerance, only
+// identical corners are merged. Otherwise a corner is merged into the first
+// vertex that differs by at most tolerance in each coordinate, found in the
+// neighboring cells of a grid with cells of size tolerance.
+std::vector<IndexType> weld_corners(const std::vector<vec3>& corners,
+                                    Scalar tolerance,
+                                    std::vector<Point>& points)
+{
+    std::vector<IndexType> vertex(corners.size());
+    points.clear();
+
+    if (tolerance <= 0)
+    {
+        std::unordered_map<WeldKey, IndexType, WeldKeyHash> map;
+        map.reserve(corners.size() / 4);
+        for (size_t i = 0; i < corners.size(); ++i)
+        {
+            auto it = map.emplace(exact_key(corners[i]),
+                                  IndexType(points.size()));
+            if (it.second)
+                points.push_back(Point(corners[i]));
+            vertex[i] = it.first->second;
+        }
+        return vertex;
+    }
+
+    std::unordered_map<WeldKey, std::vector<IndexType>, WeldKeyHash> grid;
+    grid.reserve(corners.size() / 4);
+    for (size_t i = 0; i < corners.size(); ++i)
+    {
+        const vec3& p = corners[i];
+        const WeldKey cell = cell_key(p, tolerance);
+
+        IndexType found = PMP_MAX_INDEX;
+        WeldKey k;
+        for (int dx = -1; dx <= 1; ++dx)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dz = -1; dz <= 1; ++dz)
+                {
+                    k.c[0] = cell.c[0] + dx;
+                    k.c[1] = cell.c[1] + dy;
+                    k.c[2] = cell.c[2] + dz;
+                    auto it = grid.find(k);
+                    if (it == grid.end())
+                        continue;
+                    for (auto v : it->second)
+                    {
+                        const Point& q = points[v];
+                        if (v < found &&
+                            std::fabs(Scalar(p[0]) - q[0]) <= tolerance &&
+                            std::fabs(Scalar(p[1]) - q[1]) <= tolerance &&
+                            std::fabs(Scalar(p[2]) - q[2]) <= tolerance)
+                            found = v;
+                    }
+                }
+
+        if (found == PMP_MAX_INDEX)
+        {
+            found = IndexType(points.size());
+            points.push_back(Point(p));
+            grid[cell].push_back(found);
+        }
+        vertex[i] = found;
+    }
+    return vertex;
+}
+
+// Whether file is a binary STL file. Binary files may start with "solid"
+// as well, so check whether the size matches the triangle count of the
+// binary header.
+bool is_binary_stl(const MappedFile& file, uint32_t& n_triangles)
+{
+    bool binary = file.size() < 5 || (strncmp(file.data(), "SOLID", 5) != 0 &&
+                                      strncmp(file.data(), "solid", 5) != 0);
+    n_triangles = 0;
+    if (file.size() >= 84)
+    {
+        memcpy(&n_triangles, file.data() + 80, sizeof(n_triangles));
+        if (file.size() == 84 + 50 * size_t(n_triangles))
+            binary = true;
+    }
+    return binary;
+}
+
+// keywords of the corners of ASCII STL files
+const char* const stl_vertex_keywords[] = {"vertex", "VERTEX"};
+
+// read the corners of an ASCII STL file
+void read_stl_ascii(const char* p, const char* end, std::vector<vec3>& corners)
+{
+    while (p < end)
+    {
+        const char* eol =
+            static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        if (!eol)
+            eol = end;
+
+        skip_blanks(p, eol);
+        if (eol - p > 6 && (strncmp(p, "vertex", 6) == 0 ||
+                            strncmp(p, "VERTEX", 6) == 0))
+        {
+            p += 6;
+            vec3 c(0, 0, 0);
+            for (int i = 0; i < 3; ++i)
+            {
+                skip_blanks(p, eol);
+                double x;
+                if (p == eol || !parse_double(p, eol, x))
+                    break;
+                c[i] = float(x);
+            }
+            corners.push_back(c);
+        }
+        p = eol + 1;
+    }
+}
+
+} // namespace
+
+void SurfaceMeshIO::read_stl(SurfaceMesh& mesh)
+{
+    auto mapped = map_input();
+    const MappedFile& file = *mapped;
+
+    uint32_t n_triangles;
+    const bool binary = is_binary_stl(file, n_triangles);
+
+    std::vector<vec3> corners;
+    if (binary)
+    {
+        if (file.size() < 84 || file.size() < 84 + 50 * size_t(n_triangles))
+            throw IOException("Truncated binary STL file " + filename_);
+
+        // each triangle has a normal, three corners, and two attribute bytes
+        corners.resize(3 * size_t(n_triangles));
+        const char* data = file.data() + 84;
+        parallel_for(0, int(n_triangles), [&](int t) {
+            memcpy(&corners[3 * size_t(t)], data + 50 * size_t(t) + 12,
+                   3 * sizeof(vec3));
+        });
+    }
+    else
+    {
+        size_t counts[2];
+        count_keywords_parallel(file.data(), file.end(), stl_vertex_keywords,
+                                2, counts);
+        corners.reserve(counts[0] + counts[1]);
+        const auto bounds =
+            split_lines(file.data(), file.end(), size_t(1) << 22);
+        for (size_t i = 0; i + 1 < bounds.size(); ++i)
+        {
+            read_stl_ascii(bounds[i], bounds[i + 1], corners);
+            report_progress(size_t(bounds[i + 1] - file.data()));
+            check_cancelled();
+        }
+        corners.resize(corners.size() / 3 * 3);
+    }
+
+    std::vector<Point> points;
+    auto vertex = weld_corners(corners, flags_.weld_tolerance, points);
+    std::vector<vec3>().swap(corners);
+
+    // skip degenerate triangles
+    std::vector<IndexType> indices;
+    indices.reserve(vertex.size());
+    for (size_t i = 0; i + 2 < vertex.size(); i += 3)
+    {
+        const IndexType a = vertex[i], b = vertex[i + 1], c = vertex[i + 2];
+        if (a != b && a != c && b != c)
+        {
+            indices.push_back(a);
+            indices.push_back(b);
+            indices.push_back(c);
+        }
+    }
+
+    add_indexed_faces(mesh, points, indices, std::vector<IndexType>());
+}
+
+void SurfaceMeshIO::write_stl(const SurfaceMesh& mesh)
+{
+    if (!mesh.is_triangle_mesh())
+    {
+        auto what = "SurfaceMeshIO::write_stl: Not a triangle mesh.";
+        throw InvalidInputException(what);
+    }
+
+    // binary STL is little endian
+    const bool binary = flags_.use_binary && is_little_endian();
+    if (binary && mesh.n_faces() > std::numeric_limits<uint32_t>::max())
+    {
+        auto what = "SurfaceMeshIO::write_stl: Too many faces for binary STL.";
+        throw InvalidInputException(what);
+    }
+
+    FILE* out = open_output(binary ? "wb" : "w");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    // face normals are computed on the fly if the mesh has none
+    auto points = mesh.get_vertex_property<Point>("v:point");
+    auto fnormals = mesh.get_face_property<Normal>("f:normal");
+    auto corners = [&](Face f, Point* p) {
+        auto h = mesh.halfedge(f);
+        for (int j = 0; j < 3; ++j, h = mesh.next_halfedge(h))
+            p[j] = points[mesh.to_vertex(h)];
+        if (fnormals)
+            return fnormals[f];
+        const Normal n = cross(p[1] - p[0], p[2] - p[0]);
+        const Scalar l = norm(n);
+        return l > std::numeric_limits<Scalar>::min() ? Normal(n / l) : n;
+    };
+
+    bool ok;
+    if (binary)
+    {
+        // 80 byte header, not starting with "solid", and the face count
+        char header[80] = "binary STL written by pmp-library";
+        const uint32_t n_faces = uint32_t(mesh.n_faces());
+        fwrite(header, 1, sizeof(header), out);
+        fwrite(&n_faces, sizeof(n_faces), 1, out);
+
+        // 50 byte records of normal, corners, and attribute byte count
+        ok = write_text_blocks(
+            out, mesh.faces_size(), [&](size_t i, std::string& record) {
+                const Face f(static_cast<IndexType>(i));
+                if (mesh.is_deleted(f))
+                    return;
+                Point p[3];
+                const Normal n = corners(f, p);
+                for (int j = 0; j < 3; ++j)
+                    append_binary(record, float(n[j]));
+                for (int k = 0; k < 3; ++k)
+                    for (int j = 0; j < 3; ++j)
+                        append_binary(record, float(p[k][j]));
+                append_binary(record, uint16_t(0));
+            });
+    }
+    else
+    {
+        fprintf(out, "solid stl\n");
+        ok = write_text_blocks(
+            out, mesh.faces_size(), [&](size_t i, std::string& text) {
+                const Face f(static_cast<IndexType>(i));
+                if (mesh.is_deleted(f))
+                    return;
+                Point p[3];
+                const Normal n = corners(f, p);
+                text += "  facet normal ";
+                append_vector(text, n);
+                text += "\n    outer loop\n";
+                for (int k = 0; k < 3; ++k)
+                {
+                    text += "      vertex ";
+                    append_vector(text, p[k]);
+                    text += '\n';
+                }
+                text += "    endloop\n  endfacet\n";
+            });
+        fprintf(out, "endsolid\n");
+    }
+
+    const bool header_ok = !ferror(out);
+    close_output(out);
+    if (!ok || !header_ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+void SurfaceMeshIO::write_xyz(const SurfaceMesh& mesh)
+{
+    FILE* out = open_output("w");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+
+    const auto points = mesh.get_vertex_property<Point>("v:point");
+    const auto vnormal = mesh.get_vertex_property<Normal>("v:normal");
+    const bool ok = write_text_blocks(
+        out, mesh.vertices_size(), [&](size_t i, std::string& text) {
+            Vertex v(static_cast<IndexType>(i));
+            if (mesh.is_deleted(v))
+                return;
+            append_vector(text, points[v]);
+            if (vnormal)
+            {
+                text += ' ';
+                append_vector(text, vnormal[v]);
+            }
+            text += '\n';
+        });
+
+    close_output(out);
+    if (!ok)
+        throw IOException("Failed to write file: " + filename_);
+}
+
+Face SurfaceMeshIO::add_face(SurfaceMesh& mesh,
+                             const std::vector<Vertex>& vertices)
+{
+    Face f;
+    try
+    {
+        f = mesh.add_face(vertices);
+    }
+    catch (const TopologyException&)
+    {
+        failed_faces_.push_back(vertices);
+    }
+    return f;
+}
+
+namespace {
+
+// union-find root of corner c with path halving
+IndexType find_root(std::vector<IndexType>& parent, IndexType c)
+{
+    while (parent[c] != c)
+        c = parent[c] = parent[parent[c]];
+    return c;
+}
+
+// corners of the indexed faces sorted by the vertices of their edges,
+// corner c representing the halfedge from indices[c] to indices[cnext[c]]
+std::vector<IndexType> sort_edges(const std::vector<IndexType>& indices,
+                                  const std::vector<IndexType>& cnext,
+                                  const std::vector<char>& detached,
+                                  const std::vector<IndexType>& cface)
+{
+    auto key = [&](IndexType c) {
+        const IndexType a = indices[c], b = indices[cnext[c]];
+        return std::make_pair(std::min(a, b), std::max(a, b));
+    };
+    std::vector<IndexType> sorted;
+    sorted.reserve(indices.size());
+    for (IndexType c = 0; c < indices.size(); ++c)
+        if (!detached[cface[c]])
+            sorted.push_back(c);
+    std::sort(sorted.begin(), sorted.end(), [&](IndexType c0, IndexType c1) {
+        const auto k0 = key(c0), k1 = key(c1);
+        return k0 < k1 || (k0 == k1 && c0 < c1);
+    });
+    return sorted;
+}
+
+// \brief Make an indexed face set acceptable for from_indexed_faces().
+// \details Non-manifold configurations are resolved in one sweep instead of
+// adding and retrying faces one by one:
+// 1. Faces visiting a vertex twice are detached, i.e., get own vertices.
+// 2. Corners are sorted by edge. The halfedges of each edge are matched
+//    into pairs of opposite orientation, in the order of the faces.
+// 3. The corners of a vertex joined by matched edges form fans. Vertices
+//    with more than one fan are split into one vertex per fan.
+// 4. Faces on edges that still have more than two halfedges are detached
+//    and step 3 is repeated once.
+// Appends the duplicated points and stores the input vertex of each point
+// in origin.
+void resolve_non_manifold(std::vector<Point>& points,
+                          std::vector<IndexType>& indices,
+                          const std::vector<IndexType>& offsets,
+                          std::vector<IndexType>& origin)
+{
+    const size_t nv = points.size();
+    const size_t nc = indices.size();
+    const size_t nf = offsets.size() - 1;
+    const std::vector<IndexType> input(indices);
+
+    std::vector<IndexType> cnext(nc), cface(nc);
+    std::vector<char> detached(nf, 0);
+    std::vector<IndexType> face;
+    for (size_t f = 0; f < nf; ++f)
+    {
+        for (IndexType c = offsets[f]; c < offsets[f + 1]; ++c)
+        {
+            cnext[c] = (c + 1 < offsets[f + 1]) ? c + 1 : offsets[f];
+            cface[c] = IndexType(f);
+        }
+        face.assign(input.begin() + offsets[f], input.begin() + offsets[f + 1]);
+        std::sort(face.begin(), face.end());
+        detached[f] = std::adjacent_find(face.begin(), face.end()) != face.end();
+    }
+
+    // match opposite halfedges of each edge
+    std::vector<IndexType> partner(nc, PMP_MAX_INDEX);
+    {
+        const auto sorted = sort_edges(input, cnext, detached, cface);
+        for (size_t i = 0; i < sorted.size();)
+        {
+            const IndexType c = sorted[i];
+            const auto lo = std::min(input[c], input[cnext[c]]);
+            const auto hi = std::max(input[c], input[cnext[c]]);
+            size_t j = i + 1;
+            while (j < sorted.size() &&
+                   std::min(input[sorted[j]], input[cnext[sorted[j]]]) == lo &&
+                   std::max(input[sorted[j]], input[cnext[sorted[j]]]) == hi)
+                ++j;
+            for (size_t k = i; k < j; ++k)
+            {
+                const IndexType c0 = sorted[k];
+                if (partner[c0] != PMP_MAX_INDEX)
+                    continue;
+                for (size_t l = k + 1; l < j; ++l)
+                {
+                    const IndexType c1 = sorted[l];
+                    if (partner[c1] == PMP_MAX_INDEX &&
+                        input[c1] == input[cnext[c0]])
+                    {
+                        partner[c0] = c1;
+                        partner[c1] = c0;
+                        break;
+                    }
+                }
+            }
+            i = j;
+        }
+    }
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        // join the corners of each fan
+        std::vector<IndexType> parent(nc);
+        for (IndexType c = 0; c < nc; ++c)
+            parent[c] = c;
+        for (IndexType c = 0; c < nc; ++c)
+        {
+            const IndexType d = partner[c];
+            if (d == PMP_MAX_INDEX || d < c || detached[cface[c]] ||
+                detached[cface[d]])
+                continue;
+            parent[find_root(parent, c)] = find_root(parent, cnext[d]);
+            parent[find_root(parent, d)] = find_root(parent, cnext[c]);
+        }
+
+        // one vertex per fan, the first fan of a vertex keeps its index
+        points.resize(nv);
+        origin.resize(nv);
+        for (size_t v = 0; v < nv; ++v)
+            origin[v] = IndexType(v);
+        std::vector<IndexType> fan_vertex(nc, PMP_MAX_INDEX);
+        std::vector<char> used(nv, 0);
+        for (IndexType c = 0; c < nc; ++c)
+        {
+            const IndexType v = input[c];
+            if (detached[cface[c]])
+            {
+                indices[c] = IndexType(points.size());
+                points.push_back(points[v]);
+                origin.push_back(v);
+                continue;
+            }
+
+            IndexType& fv = fan_vertex[find_root(parent, c)];
+            if (fv == PMP_MAX_INDEX)
+            {
+                if (!used[v])
+                {
+                    used[v] = 1;
+                    fv = v;
+                }
+                else
+                {
+                    fv = IndexType(points.size());
+                    points.push_back(points[v]);
+                    origin.push_back(v);
+                }
+            }
+            indices[c] = fv;
+        }
+        if (pass == 1)
+            break;
+
+        // detach the faces of edges that are still shared by more than two
+        // halfedges, keeping the first matched pair
+        bool changed = false;
+        const auto sorted = sort_edges(indices, cnext, detached, cface);
+        for (size_t i = 0; i < sorted.size();)
+        {
+            const IndexType c = sorted[i];
+            const auto lo = std::min(indices[c], indices[cnext[c]]);
+            const auto hi = std::max(indices[c], indices[cnext[c]]);
+            size_t j = i + 1;
+            while (j < sorted.size() &&
+                   std::min(indices[sorted[j]], indices[cnext[sorted[j]]]) ==
+                       lo &&
+                   std::max(indices[sorted[j]], indices[cnext[sorted[j]]]) ==
+                       hi)
+                ++j;
+            if (j - i > 2 || (j - i == 2 && partner[c] != sorted[i + 1]))
+            {
+                const IndexType keep = partner[c];
+                for (size_t k = i + 1; k < j; ++k)
+                {
+                    if (sorted[k] != keep || j - i == 2)
+                    {
+                        detached[cface[sorted[k]]] = 1;
+                        changed = true;
+                    }
+                }
+            }
+            i = j;
+        }
+        if (!changed)
+            break;
+    }
+}
+
+} // namespace
+
+std::vector<Face> SurfaceMeshIO::add_indexed_faces(
+    SurfaceMesh& mesh, const std::vector<Point>& points,
+    const std::vector<IndexType>& indices,
+    const std::vector<IndexType>& face_sizes)
+{
+    const size_t n_faces =
+        face_sizes.empty() ? indices.size() / 3 : face_sizes.size();
+    vertex_origin_.clear();
+
+    // add only the vertices and keep the faces for later
+    if (deferred_faces_)
+    {
+        mesh.clear();
+        mesh.new_vertices(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            mesh.position(Vertex(i)) = points[i];
+        deferred_faces_->indices = indices;
+        deferred_faces_->face_sizes = face_sizes;
+        return std::vector<Face>(n_faces);
+    }
+
+    std::vector<Face> faces;
+    faces.reserve(n_faces);
+
+    // build the mesh in one pass, after splitting non-manifold vertices and
+    // edges if needed
+    try
+    {
+        mesh.from_indexed_faces(points, indices, face_sizes);
+        for (size_t i = 0; i < n_faces; ++i)
+            faces.emplace_back(IndexType(i));
+        return faces;
+    }
+    catch (const TopologyException&)
+    {
+    }
+
+    std::vector<IndexType> offsets(n_faces + 1, 0);
+    for (size_t i = 0; i < n_faces; ++i)
+        offsets[i + 1] = offsets[i] + (face_sizes.empty() ? 3 : face_sizes[i]);
+
+    std::vector<Point> resolved_points(points);
+    std::vector<IndexType> resolved_indices(indices);
+    resolve_non_manifold(resolved_points, resolved_indices, offsets,
+                         vertex_origin_);
+    try
+    {
+        mesh.from_indexed_faces(resolved_points, resolved_indices, face_sizes);
+        for (size_t i = 0; i < n_faces; ++i)
+            faces.emplace_back(IndexType(i));
+        return faces;
+    }
+    catch (const TopologyException&)
+    {
+    }
+
+    // add the faces one by one as a last resort
+    vertex_origin_.clear();
+    mesh.clear();
+    mesh.reserve(points.size(), indices.size() / 2, n_faces);
+    for (const auto& p : points)
+        mesh.add_vertex(p);
+
+    std::vector<Vertex> vertices;
+    for (size_t i = 0; i < n_faces; ++i)
+    {
+        vertices.clear();
+        for (IndexType c = offsets[i]; c < offsets[i + 1]; ++c)
+            vertices.emplace_back(indices[c]);
+        faces.push_back(add_face(mesh, vertices));
+    }
+    return faces;
+}
+
+namespace {
+
+// the values of a vertex property, empty if there is none
+template <class T>
+std::vector<T> vertex_values(const SurfaceMesh& mesh, const std::string& name)
+{
+    // element access works for any storage and does not pin the array
+    const auto prop = mesh.get_vertex_property<T>(name);
+    std::vector<T> values(prop ? prop.size() : 0);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = prop[Vertex(i)];
+    return values;
+}
+
+} // namespace
+
+void SurfaceMeshIO::add_faces(SurfaceMesh& mesh, const IndexedFaces& faces,
+                              std::vector<IndexType>* vertex_origin)
+{
+    if (faces.empty())
+    {
+        if (vertex_origin)
+        {
+            vertex_origin->resize(mesh.vertices_size());
+            std::iota(vertex_origin->begin(), vertex_origin->end(), 0);
+        }
+        return;
+    }
+
+    // clearing the mesh removes its properties
+    const auto points = vertex_values<Point>(mesh, "v:point");
+    const auto normals = vertex_values<Normal>(mesh, "v:normal");
+    const auto colors = vertex_values<Color>(mesh, "v:color");
+    const auto texcoords = vertex_values<TexCoord>(mesh, "v:tex");
+
+    SurfaceMeshIO io("", IOFlags());
+    io.add_indexed_faces(mesh, points, faces.indices, faces.face_sizes);
+    io.add_failed_faces(mesh);
+    if (!normals.empty())
+        io.set_vertex_values(mesh, "v:normal", normals);
+    if (!colors.empty())
+        io.set_vertex_values(mesh, "v:color", colors);
+    if (!texcoords.empty())
+        io.set_vertex_values(mesh, "v:tex", texcoords);
+
+    if (vertex_origin)
+    {
+        vertex_origin->resize(mesh.vertices_size());
+        for (size_t i = 0; i < vertex_origin->size(); ++i)
+            (*vertex_origin)[i] = io.input_vertex(Vertex(i));
+    }
+}
+
+IndexType SurfaceMeshIO::input_vertex(Vertex v) const
+{
+    return v.idx() < vertex_origin_.size() ? vertex_origin_[v.idx()]
+                                           : v.idx();
+}
+
+template <class T>
+void SurfaceMeshIO::set_vertex_values(SurfaceMesh& mesh,
+                                      const std::string& name,
+                                      const std::vector<T>& values) const
+{
+    auto prop = mesh.vertex_property<T>(name);
+    for (auto v : mesh.vertices())
+    {
+        const IndexType i = input_vertex(v);
+        if (i < values.size())
+            prop[v] = values[i];
+    }
+}
+
+namespace {
+
+// whether vertex keys a and b are ordered, and the indices if they are equal
+bool weld_key_less(const std::pair<WeldKey, IndexType>& a,
+                   const std::pair<WeldKey, IndexType>& b)
+{
+    for (int i = 0; i < 3; ++i)
+        if (a.first.c[i] != b.first.c[i])
+            return a.first.c[i] < b.first.c[i];
+    return a.second < b.second;
+}
+
+// Cluster the points such that points differing by at most tolerance in
+// each coordinate are in the same cluster, and return the smallest point
+// index of the cluster of each point.
+std::vector<IndexType> weld_clusters(const std::vector<Point>& points,
+                                     Scalar tolerance)
+{
+    const int n = int(points.size());
+
+    // sort the points by their grid cells
+    std::vector<std::pair<WeldKey, IndexType>> sorted(n);
+    parallel_for(0, n, [&](int i) {
+        const vec3 p(points[i]);
+        sorted[i].first =
+            tolerance > 0 ? cell_key(p, tolerance) : exact_key(p);
+        sorted[i].second = IndexType(i);
+    });
+    std::sort(sorted.begin(), sorted.end(), weld_key_less);
+
+    // cells as ranges of the sorted points
+    std::unordered_map<WeldKey, std::pair<IndexType, IndexType>, WeldKeyHash>
+        cells;
+    cells.reserve(points.size());
+    for (size_t begin = 0, end; begin < sorted.size(); begin = end)
+    {
+        end = begin + 1;
+        while (end < sorted.size() && sorted[end].first == sorted[begin].first)
+            ++end;
+        cells[sorted[begin].first] =
+            std::make_pair(IndexType(begin), IndexType(end));
+    }
+
+    // identical points form the clusters, the first index of each cell is
+    // the smallest one
+    std::vector<IndexType> label(n);
+    if (tolerance <= 0)
+    {
+        parallel_for(0, n, [&](int i) {
+            label[sorted[i].second] =
+                sorted[cells.find(sorted[i].first)->second.first].second;
+        });
+        return label;
+    }
+
+    // propagate the smallest index of the close points until it is stable
+    std::iota(label.begin(), label.end(), 0);
+    std::vector<IndexType> next(n);
+    for (bool changed = true; changed;)
+    {
+        parallel_for(0, n, [&](int i) {
+            const Point& p = points[i];
+            const WeldKey cell = cell_key(vec3(p), tolerance);
+            IndexType smallest = label[i];
+            WeldKey k;
+            for (int dx = -1; dx <= 1; ++dx)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dz = -1; dz <= 1; ++dz)
+                    {
+                        k.c[0] = cell.c[0] + dx;
+                        k.c[1] = cell.c[1] + dy;
+                        k.c[2] = cell.c[2] + dz;
+                        auto it = cells.find(k);
+                        if (it == cells.end())
+                            continue;
+                        for (IndexType j = it->second.first;
+                             j < it->second.second; ++j)
+                        {
+                            const IndexType v = sorted[j].second;
+                            const Point& q = points[v];
+                            if (label[v] < smallest &&
+                                std::fabs(p[0] - q[0]) <= tolerance &&
+                                std::fabs(p[1] - q[1]) <= tolerance &&
+                                std::fabs(p[2] - q[2]) <= tolerance)
+                                smallest = label[v];
+                        }
+                    }
+            next[i] = smallest;
+        });
+        changed = next != label;
+        label.swap(next);
+    }
+    return label;
+}
+
+// stores averaged values into the vertices given their merged vertices
+typedef std::function<void(SurfaceMesh&, const std::vector<IndexType>&)>
+    StoreAverages;
+
+// averages of the values of a vertex property over the welded vertices
+template <class T>
+bool average_values(SurfaceMesh& mesh, const std::string& name,
+                    const std::vector<IndexType>& merged, size_t n_merged,
+                    std::vector<StoreAverages>& store)
+{
+    if (mesh.get_vertex_property_type(name) != typeid(T))
+        return false;
+
+    auto prop = mesh.get_vertex_property<T>(name);
+    auto sums = std::make_shared<std::vector<T>>(n_merged, T(0));
+    std::vector<unsigned int> counts(n_merged, 0);
+    for (size_t i = 0; i < merged.size(); ++i)
+    {
+        (*sums)[merged[i]] += prop[Vertex(i)];
+        ++counts[merged[i]];
+    }
+    for (size_t i = 0; i < n_merged; ++i)
+        (*sums)[i] /= counts[i];
+
+    // store the averages once the vertices are rebuilt
+    store.push_back([name, sums](SurfaceMesh& m,
+                                 const std::vector<IndexType>& origin) {
+        auto p = m.get_vertex_property<T>(name);
+        for (size_t i = 0; i < origin.size(); ++i)
+            p[Vertex(i)] = (*sums)[origin[i]];
+    });
+    return true;
+}
+
+} // namespace
+
+size_t SurfaceMeshIO::weld_vertices(SurfaceMesh& mesh, Scalar tolerance,
+                                    WeldPolicy policy)
+{
+    if (mesh.has_garbage())
+        mesh.garbage_collection();
+
+    // merged vertex of each vertex, numbered by their first vertices
+    const size_t n_vertices = mesh.vertices_size();
+    const auto label =
+        weld_clusters(vertex_values<Point>(mesh, "v:point"), tolerance);
+    std::vector<IndexType> merged(n_vertices);
+    std::vector<size_t> first;
+    for (size_t i = 0; i < n_vertices; ++i)
+    {
+        if (label[i] == i)
+        {
+            merged[i] = IndexType(first.size());
+            first.push_back(i);
+        }
+        else
+            merged[i] = merged[label[i]];
+    }
+    if (first.size() == n_vertices)
+        return 0;
+
+    // averaged vertex properties, computed before the mesh changes
+    std::vector<StoreAverages> averages;
+    if (policy == WeldPolicy::Average)
+    {
+        const size_t n = first.size();
+        for (const auto& name : mesh.vertex_properties())
+        {
+            auto& a = averages;
+            if (!average_values<float>(mesh, name, merged, n, a) &&
+                !average_values<double>(mesh, name, merged, n, a) &&
+                !average_values<vec2>(mesh, name, merged, n, a) &&
+                !average_values<vec3>(mesh, name, merged, n, a) &&
+                !average_values<vec4>(mesh, name, merged, n, a) &&
+                !average_values<dvec2>(mesh, name, merged, n, a) &&
+                !average_values<dvec3>(mesh, name, merged, n, a))
+                average_values<dvec4>(mesh, name, merged, n, a);
+        }
+    }
+
+    // faces with merged vertex indices, starting at the target of the
+    // first halfedge, and the halfedges of their corners
+    IndexedFaces faces;
+    std::vector<Face> input_faces;
+    std::vector<Halfedge> corners;
+    std::vector<IndexType> face;
+    for (auto f : mesh.faces())
+    {
+        face.clear();
+        for (auto h : mesh.halfedges(f))
+            face.push_back(merged[mesh.to_vertex(h).idx()]);
+        auto sorted = face;
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+            continue;
+
+        faces.indices.insert(faces.indices.end(), face.begin(), face.end());
+        faces.face_sizes.push_back(IndexType(face.size()));
+        input_faces.push_back(f);
+        for (auto h : mesh.halfedges(f))
+            corners.push_back(h);
+    }
+
+    // build the connectivity of the merged vertices
+    std::vector<Point> points(first.size());
+    for (size_t i = 0; i < first.size(); ++i)
+        points[i] = mesh.position(Vertex(IndexType(first[i])));
+    SurfaceMesh welded;
+    SurfaceMeshIO io("", IOFlags());
+    auto built = io.add_indexed_faces(welded, points, faces.indices,
+                                      faces.face_sizes);
+    auto added = io.add_failed_faces(welded);
+    for (size_t i = 0, j = 0; i < built.size(); ++i)
+        if (!built[i].is_valid())
+            built[i] = added[j++];
+
+    // old element of each new element
+    std::vector<IndexType> origin(welded.vertices_size());
+    std::vector<size_t> vorder(welded.vertices_size());
+    for (size_t i = 0; i < vorder.size(); ++i)
+    {
+        origin[i] = io.input_vertex(Vertex(IndexType(i)));
+        vorder[i] = first[origin[i]];
+    }
+
+    std::vector<size_t> horder(welded.halfedges_size(), PMP_MAX_INDEX);
+    std::vector<size_t> forder(welded.faces_size());
+    for (size_t i = 0, c = 0; i < built.size(); ++i)
+    {
+        const Face f = built[i];
+        forder[f.idx()] = input_faces[i].idx();
+
+        // the halfedge of the first corner, then follow the face
+        const IndexType size = faces.face_sizes[i];
+        Halfedge h = welded.halfedge(f);
+        while (origin[welded.to_vertex(h).idx()] != faces.indices[c])
+            h = welded.next_halfedge(h);
+        for (IndexType k = 0; k < size; ++k, ++c)
+        {
+            horder[h.idx()] = corners[c].idx();
+            h = welded.next_halfedge(h);
+        }
+    }
+
+    // boundary halfedges correspond to the opposites of their opposites
+    for (size_t i = 0; i < horder.size(); ++i)
+        if (horder[i] == PMP_MAX_INDEX)
+        {
+            const Halfedge h(IndexType(horder[i ^ 1]));
+            horder[i] = mesh.opposite_halfedge(h).idx();
+        }
+
+    std::vector<size_t> eorder(welded.edges_size());
+    for (size_t i = 0; i < eorder.size(); ++i)
+        eorder[i] = horder[2 * i] / 2;
+
+    // move the properties to the new elements, then take over the new
+    // connectivity
+    std::vector<std::pair<BasePropertyArray*, const std::vector<size_t>*>>
+        tasks;
+    for (auto a : mesh.vprops_.arrays())
+        tasks.emplace_back(a, &vorder);
+    for (auto a : mesh.hprops_.arrays())
+        tasks.emplace_back(a, &horder);
+    for (auto a : mesh.eprops_.arrays())
+        tasks.emplace_back(a, &eorder);
+    for (auto a : mesh.fprops_.arrays())
+        tasks.emplace_back(a, &forder);
+    parallel_for(
+        0, int(tasks.size()),
+        [&](int i) { tasks[i].first->permute(*tasks[i].second); }, 1);
+    mesh.vprops_.resize(vorder.size());
+    mesh.hprops_.resize(horder.size());
+    mesh.eprops_.resize(eorder.size());
+    mesh.fprops_.resize(forder.size());
+
+    parallel_for(0, int(vorder.size()), [&](int i) {
+        const Vertex v(i);
+        mesh.vconn_[v] = welded.vconn_[v];
+        mesh.vdeleted_[v] = false;
+    });
+    parallel_for(0, int(horder.size()), [&](int i) {
+        mesh.hconn_[Halfedge(i)] = welded.hconn_[Halfedge(i)];
+    });
+    parallel_for(0, int(eorder.size()),
+                 [&](int i) { mesh.edeleted_[Edge(i)] = false; });
+    parallel_for(0, int(forder.size()), [&](int i) {
+        const Face f(i);
+        mesh.fconn_[f] = welded.fconn_[f];
+        mesh.fdeleted_[f] = false;
+    });
+    mesh.rebuild_edge_index();
+
+    for (const auto& store : averages)
+        store(mesh, origin);
+
+    return n_vertices - vorder.size();
+}
+
+namespace {
+
+// LZMA-style binary range coder with adaptive probabilities
+const int rc_prob_bits = 11;
+const uint16_t rc_prob_one = 1 << rc_prob_bits;
+const uint16_t rc_prob_init = rc_prob_one / 2;
+const int rc_move_bits = 5;
+const uint32_t rc_top = 1u << 24;
+
+class RangeEncoder
+{
+public:
+    explicit RangeEncoder(std::vector<char>& out)
+        : low_(0), range_(0xFFFFFFFF), cache_(0), cache_size_(1), out_(out)
+    {
+    }
+
+    void encode_bit(uint16_t& prob, unsigned int bit)
+    {
+        const uint32_t bound = (range_ >> rc_prob_bits) * prob;
+        if (!bit)
+        {
+            range_ = bound;
+            prob += (rc_prob_one - prob) >> rc_move_bits;
+        }
+        else
+        {
+            low_ += bound;
+            range_ -= bound;
+            prob -= prob >> rc_move_bits;
+        }
+        normalize();
+    }
+
+    // encode the lowest n_bits bits of value with probability 1/2 each
+    void encode_direct(uint32_t value, int n_bits)
+    {
+        for (int i = n_bits - 1; i >= 0; --i)
+        {
+            range_ >>= 1;
+            if ((value >> i) & 1)
+                low_ += range_;
+            normalize();
+        }
+    }
+
+    void flush()
+    {
+        for (int i = 0; i < 5; ++i)
+            shift_low();
+    }
+
+private:
+    void normalize()
+    {
+        while (range_ < rc_top)
+        {
+            range_ <<= 8;
+            shift_low();
+        }
+    }
+
+    void shift_low()
+    {
+        if (uint32_t(low_) < 0xFF000000u || (low_ >> 32) != 0)
+        {
+            const uint8_t carry = uint8_t(low_ >> 32);
+            uint8_t temp = cache_;
+            do
+            {
+                out_.push_back(char(uint8_t(temp + carry)));
+                temp = 0xFF;
+            } while (--cache_size_ != 0);
+            cache_ = uint8_t(low_ >> 24);
+        }
+        ++cache_size_;
+        low_ = (low_ & 0x00FFFFFF) << 8;
+    }
+
+    uint64_t low_;
+    uint32_t range_;
+    uint8_t cache_;
+    uint64_t cache_size_;
+    std::vector<char>& out_;
+};
+
+class RangeDecoder
+{
+public:
+    RangeDecoder(const char* begin, const char* end)
+        : p_(begin), end_(end), range_(0xFFFFFFFF), code_(0), overrun_(false)
+    {
+        for (int i = 0; i < 5; ++i)
+            code_ = (code_ << 8) | next_byte();
+    }
+
+    unsigned int decode_bit(uint16_t& prob)
+    {
+        const uint32_t bound = (range_ >> rc_prob_bits) * prob;
+        unsigned int bit;
+        if (code_ < bound)
+        {
+            range_ = bound;
+            prob += (rc_prob_one - prob) >> rc_move_bits;
+            bit = 0;
+        }
+        else
+        {
+            code_ -= bound;
+            range_ -= bound;
+            prob -= prob >> rc_move_bits;
+            bit = 1;
+        }
+        normalize();
+        return bit;
+    }
+
+    uint32_t decode_direct(int n_bits)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < n_bits; ++i)
+        {
+            range_ >>= 1;
+            unsigned int bit = code_ >= range_ ? 1 : 0;
+            if (bit)
+                code_ -= range_;
+            value = (value << 1) | bit;
+            normalize();
+        }
+        return value;
+    }
+
+    // whether more bytes were read than available
+    bool overrun() const { return overrun_; }
+
+private:
+    void normalize()
+    {
+        while (range_ < rc_top)
+        {
+            range_ <<= 8;
+            code_ = (code_ << 8) | next_byte();
+        }
+    }
+
+    uint32_t next_byte()
+    {
+        if (p_ == end_)
+        {
+            overrun_ = true;
+            return 0;
+        }
+        return uint8_t(*p_++);
+    }
+
+    const char* p_;
+    const char* end_;
+    uint32_t range_;
+    uint32_t code_;
+    bool overrun_;
+};
+
+// \brief Adaptive model for unsigned integers.
+// \details Codes the bit length of value + 1 in unary and the two leading
+// bits below the highest one with adaptive probabilities, the remaining bits
+// directly.
+struct UIntModel
+{
+    UIntModel()
+    {
+        std::fill(&exponent[0], &exponent[0] + 33, rc_prob_init);
+        std::fill(&mantissa[0][0], &mantissa[0][0] + 33 * 4, rc_prob_init);
+    }
+
+    void encode(RangeEncoder& rc, uint32_t value)
+    {
+        const uint64_t v = uint64_t(value) + 1;
+        int e = 0;
+        while (v >> (e + 1))
+            ++e;
+        for (int i = 0; i < e; ++i)
+            rc.encode_bit(exponent[i], 1);
+        if (e < 32)
+            rc.encode_bit(exponent[e], 0);
+
+        const int n_modeled = std::min(e, 2);
+        int node = 1;
+        for (int i = e - 1; i >= e - n_modeled; --i)
+        {
+            unsigned int bit = (v >> i) & 1;
+            rc.encode_bit(mantissa[e][node], bit);
+            node = 2 * node + int(bit);
+        }
+        if (e > n_modeled)
+            rc.encode_direct(uint32_t(v), e - n_modeled);
+    }
+
+    uint32_t decode(RangeDecoder& rc)
+    {
+        int e = 0;
+        while (e < 32 && rc.decode_bit(exponent[e]))
+            ++e;
+
+        const int n_modeled = std::min(e, 2);
+        uint64_t v = 1;
+        int node = 1;
+        for (int i = 0; i < n_modeled; ++i)
+        {
+            unsigned int bit = rc.decode_bit(mantissa[e][node]);
+            node = 2 * node + int(bit);
+            v = (v << 1) | bit;
+        }
+        if (e > n_modeled)
+            v = (v << (e - n_modeled)) | rc.decode_direct(e - n_modeled);
+        return uint32_t(v - 1);
+    }
+
+    uint16_t exponent[33];
+    uint16_t mantissa[33][4];
+};
+
+// adaptive model for signed integers, e.g., prediction residuals
+struct IntModel
+{
+    IntModel() : zero(rc_prob_init), sign(rc_prob_init) {}
+
+    void encode(RangeEncoder& rc, int64_t value)
+    {
+        rc.encode_bit(zero, value != 0);
+        if (value == 0)
+            return;
+        rc.encode_bit(sign, value < 0);
+        magnitude.encode(rc, uint32_t((value < 0 ? -value : value) - 1));
+    }
+
+    int64_t decode(RangeDecoder& rc)
+    {
+        if (!rc.decode_bit(zero))
+            return 0;
+        const bool negative = rc.decode_bit(sign);
+        const int64_t value = int64_t(magnitude.decode(rc)) + 1;
+        return negative ? -value : value;
+    }
+
+    uint16_t zero;
+    uint16_t sign;
+    UIntModel magnitude;
+};
+
+// \brief Operations of the triangle traversal, named as in Edgebreaker.
+// \details For a triangle (a, b, w) entered through the border edge (a, b):
+// C: w is a new vertex, R: (b, w) is the next border edge, L: (w, a) is the
+// previous border edge, E: both, S: w is elsewhere on the border. B marks a
+// border edge without a triangle, i.e., a mesh boundary edge.
+enum PmcSymbol
+{
+    pmc_c,
+    pmc_r,
+    pmc_l,
+    pmc_e,
+    pmc_s,
+    pmc_b
+};
+
+// adaptive model for the operations, conditioned on the previous one
+struct SymbolModel
+{
+    SymbolModel() : previous(pmc_c)
+    {
+        std::fill(&bits[0][0], &bits[0][0] + 6 * 5, rc_prob_init);
+    }
+
+    void encode(RangeEncoder& rc, int symbol)
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            const unsigned int bit = symbol == i;
+            rc.encode_bit(bits[previous][i], bit);
+            if (bit)
+                break;
+        }
+        previous = symbol;
+    }
+
+    int decode(RangeDecoder& rc)
+    {
+        int symbol = 0;
+        while (symbol < 5 && !rc.decode_bit(bits[previous][symbol]))
+            ++symbol;
+        previous = symbol;
+        return symbol;
+    }
+
+    int previous;
+    uint16_t bits[6][5];
+};
+
+// \brief Border between the triangles traversed so far and the others.
+// \details Consists of loops of directed edges facing the untraversed side.
+// The encoder and the decoder perform the same updates, such that the
+// decoder can infer the vertices of R, L, and E triangles from the loops.
+class PmcBorder
+{
+public:
+    enum State
+    {
+        live,
+        hole,
+        removed
+    };
+
+    struct Node
+    {
+        IndexType from, to;
+        IndexType apex; // opposite vertex of the traversed triangle
+        int prev, next;
+        State state;
+    };
+
+    int add(IndexType from, IndexType to, IndexType apex)
+    {
+        Node n = {from, to, apex, -1, -1, live};
+        nodes.push_back(n);
+        return int(nodes.size()) - 1;
+    }
+
+    void link(int a, int b)
+    {
+        nodes[a].next = b;
+        nodes[b].prev = a;
+    }
+
+    // first live node of the loop starting at n, -1 if there is none
+    int find_live(int n) const
+    {
+        const int start = n;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (nodes[n].state == live)
+                return n;
+            n = nodes[n].next;
+            if (n == start || n < 0)
+                break;
+        }
+        return -1;
+    }
+
+    // the next live gate from the stack, -1 if there is none
+    int pop()
+    {
+        while (!stack.empty())
+        {
+            int n = stack.back();
+            stack.pop_back();
+            if (nodes[n].state != removed && (n = find_live(n)) >= 0)
+                return n;
+        }
+        return -1;
+    }
 
-    // read texture coordiantes
-    if (has_htex)
+    // \brief Update the border for the triangle (a, b, w) entered through
+    // gate g = (a, b).
+    // \details s is the border node leaving w for pmc_s. y1 and y2 receive
+    // the new nodes (w, b) and (a, w), or -1. Returns the next gate.
+    int advance(int g, int symbol, IndexType w, int s, int& y1, int& y2)
     {
-        auto htex = mesh.halfedge_property<TexCoord>("h:tex");
-        size_t nhtc = fread((char*)htex.data(), sizeof(TexCoord), nh, in);
-        PMP_ASSERT(nhtc == nh);
+        const IndexType a = nodes[g].from, b = nodes[g].to;
+        const int p = nodes[g].prev, q = nodes[g].next;
+        y1 = y2 = -1;
+        switch (symbol)
+        {
+            case pmc_c:
+                y2 = add(a, w, b);
+                y1 = add(w, b, a);
+                link(p, y2);
+                link(y2, y1);
+                link(y1, q);
+                nodes[g].state = removed;
+                return y1;
+
+            case pmc_r:
+                y2 = add(a, w, b);
+                link(p, y2);
+                link(y2, nodes[q].next);
+                nodes[g].state = nodes[q].state = removed;
+                return y2;
+
+            case pmc_l:
+                y1 = add(w, b, a);
+                link(nodes[p].prev, y1);
+                link(y1, q);
+                nodes[p].state = nodes[g].state = removed;
+                return y1;
+
+            case pmc_e:
+            {
+                nodes[p].state = nodes[g].state = nodes[q].state = removed;
+                const int r = nodes[q].next;
+                if (r == p)
+                    return pop();
+
+                // the loop touches w, continue with the rest of it
+                link(nodes[p].prev, r);
+                const int n = find_live(r);
+                return n >= 0 ? n : pop();
+            }
+
+            case pmc_s:
+            {
+                const int ps = nodes[s].prev;
+                y2 = add(a, w, b);
+                y1 = add(w, b, a);
+                link(p, y2);
+                link(y2, s);
+                link(ps, y1);
+                link(y1, q);
+                nodes[g].state = removed;
+                stack.push_back(y2);
+                return y1;
+            }
+
+            default:
+            {
+                nodes[g].state = hole;
+                const int n = find_live(q);
+                return n >= 0 ? n : pop();
+            }
+        }
     }
 
-    fclose(in);
-}
+    std::vector<Node> nodes;
+    std::vector<int> stack;
+};
+
+const char pmc_magic[4] = {'P', 'M', 'P', 'C'};
+const uint8_t pmc_version = 1;
+const int pmc_normal_bits = 12;
 
-void SurfaceMeshIO::read_xyz(SurfaceMesh& mesh)
+// connectivity coding of PMC files
+enum PmcConnectivity
 {
-    // open file (in ASCII mode)
-    FILE* in = fopen(filename_.c_str(), "r");
-    if (!in)
-        throw IOException("Failed to open file: " + filename_);
+    pmc_triangles = 0, // traversal of the triangles
+    pmc_polygons = 1,  // vertex indices of each face
+};
 
-    // add normal property
-    // \todo this adds property even if no normals present. change it.
-    auto vnormal = mesh.vertex_property<Normal>("v:normal");
+// attributes stored in PMC files
+enum PmcAttribute
+{
+    pmc_normals = 1,
+    pmc_texcoords = 2
+};
 
-    char line[200];
-    float x, y, z;
-    float nx, ny, nz;
-    int n;
-    Vertex v;
+// little-endian serialization of header fields
+template <typename T>
+void pmc_put(std::vector<char>& out, T value)
+{
+    typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type bits =
+        0;
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "unsupported size");
+    memcpy(&bits, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out.push_back(char(uint8_t(bits >> (8 * i))));
+}
+
+template <typename T>
+T pmc_get(const char*& p)
+{
+    typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type bits =
+        0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        bits |= decltype(bits)(uint8_t(p[i])) << (8 * i);
+    p += sizeof(T);
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+// uniform quantization of coordinates to integers
+template <int N>
+struct PmcQuantizer
+{
+    PmcQuantizer() : extent(1), bits(0) {}
 
-    // read data
-    while (in && !feof(in) && fgets(line, 200, in))
+    void setup(const std::vector<Vector<Scalar, N>>& values, int n_bits)
     {
-        n = sscanf(line, "%f %f %f %f %f %f", &x, &y, &z, &nx, &ny, &nz);
-        if (n >= 3)
-        {
-            v = mesh.add_vertex(Point(x, y, z));
-            if (n >= 6)
+        bits = n_bits;
+        for (int k = 0; k < N; ++k)
+            min[k] = values.empty() ? 0 : values[0][k];
+        double max[N];
+        std::copy(min, min + N, max);
+        for (const auto& x : values)
+            for (int k = 0; k < N; ++k)
             {
-                vnormal[v] = Normal(nx, ny, nz);
+                min[k] = std::min(min[k], double(x[k]));
+                max[k] = std::max(max[k], double(x[k]));
             }
+        extent = 0;
+        for (int k = 0; k < N; ++k)
+            extent = std::max(extent, max[k] - min[k]);
+        if (!(extent > 0))
+            extent = 1;
+    }
+
+    int32_t max_value() const { return int32_t((1u << bits) - 1); }
+
+    void quantize(const Vector<Scalar, N>& x, int32_t* q) const
+    {
+        const double scale = max_value() / extent;
+        for (int k = 0; k < N; ++k)
+        {
+            const double v = std::floor((x[k] - min[k]) * scale + 0.5);
+            q[k] = int32_t(std::min(std::max(v, 0.0), double(max_value())));
         }
     }
 
-    fclose(in);
+    Vector<Scalar, N> dequantize(const int32_t* q) const
+    {
+        const double scale = extent / max_value();
+        Vector<Scalar, N> x;
+        for (int k = 0; k < N; ++k)
+            x[k] = Scalar(min[k] + q[k] * scale);
+        return x;
+    }
+
+    double min[N];
+    double extent;
+    int bits;
+};
+
+// octahedral mapping of unit normals to [0, 2^pmc_normal_bits - 1]^2
+void pmc_encode_normal(const Normal& n, int32_t* q)
+{
+    double x = n[0], y = n[1], z = n[2];
+    const double l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    if (!(l1 > 0))
+    {
+        x = y = 0;
+        z = 1;
+    }
+    else
+    {
+        x /= l1;
+        y /= l1;
+        z /= l1;
+    }
+    if (z < 0)
+    {
+        const double ox = (1 - std::fabs(y)) * (x < 0 ? -1 : 1);
+        const double oy = (1 - std::fabs(x)) * (y < 0 ? -1 : 1);
+        x = ox;
+        y = oy;
+    }
+    const double max_value = (1 << pmc_normal_bits) - 1;
+    q[0] = int32_t(std::floor((x * 0.5 + 0.5) * max_value + 0.5));
+    q[1] = int32_t(std::floor((y * 0.5 + 0.5) * max_value + 0.5));
 }
 
-// \todo remove duplication with read_xyz
-void SurfaceMeshIO::read_agi(SurfaceMesh& mesh)
+Normal pmc_decode_normal(const int32_t* q)
 {
-    // open file (in ASCII mode)
-    FILE* in = fopen(filename_.c_str(), "r");
-    if (!in)
-        throw IOException("Failed to open file: " + filename_);
+    const double max_value = (1 << pmc_normal_bits) - 1;
+    double x = q[0] / max_value * 2 - 1;
+    double y = q[1] / max_value * 2 - 1;
+    const double z = 1 - std::fabs(x) - std::fabs(y);
+    if (z < 0)
+    {
+        const double t = x;
+        x = (1 - std::fabs(y)) * (t < 0 ? -1 : 1);
+        y = (1 - std::fabs(t)) * (y < 0 ? -1 : 1);
+    }
+    const double l = std::sqrt(x * x + y * y + z * z);
+    return Normal(Scalar(x / l), Scalar(y / l), Scalar(z / l));
+}
+
+// \brief Quantized vertex attributes in traversal order.
+// \details New vertices are predicted by the parallelogram rule across the
+// gate, vertices without neighbors from the previous vertex. The residuals
+// are entropy coded.
+class PmcAttributes
+{
+public:
+    PmcAttributes() : n_channels_(0), n_vertices_(0) {}
 
-    // add normal property
-    auto normal = mesh.vertex_property<Normal>("v:normal");
-    auto color = mesh.vertex_property<Color>("v:color");
+    // add an attribute with n channels in [0, max_value]
+    void add_channels(int n, int32_t max_value)
+    {
+        for (int i = 0; i < n; ++i)
+            max_.push_back(max_value);
+        n_channels_ += n;
+        models_.resize(n_channels_);
+    }
 
-    char line[200];
-    float x, y, z;
-    float nx, ny, nz;
-    float r, g, b;
-    int n;
-    Vertex v;
+    size_t n_vertices() const { return n_vertices_; }
 
-    // read data
-    while (in && !feof(in) && fgets(line, 200, in))
+    // quantized attributes of vertex v
+    const int32_t* operator[](size_t v) const
     {
-        n = sscanf(line, "%f %f %f %f %f %f %f %f %f", &x, &y, &z, &r, &g, &b,
-                   &nx, &ny, &nz);
-        if (n == 9)
+        return &values_[v * n_channels_];
+    }
+
+    // code the attributes of a new vertex, predicted from a + b - c
+    void encode(RangeEncoder& rc, const int32_t* q, IndexType a, IndexType b,
+                IndexType c)
+    {
+        int32_t* v = add();
+        for (int k = 0; k < n_channels_; ++k)
         {
-            v = mesh.add_vertex(Point(x, y, z));
-            normal[v] = Normal(nx, ny, nz);
-            color[v] = Color(r / 255.0, g / 255.0, b / 255.0);
+            v[k] = q[k];
+            models_[k].encode(rc, int64_t(q[k]) - predict(k, a, b, c));
         }
     }
 
-    fclose(in);
-}
-
-void SurfaceMeshIO::write_pmp(const SurfaceMesh& mesh)
-{
-    // open file (in binary mode)
-    FILE* out = fopen(filename_.c_str(), "wb");
-    if (!out)
-        throw IOException("Failed to open file: " + filename_);
-
-    // get properties
-    auto vconn = mesh.get_vertex_property<SurfaceMesh::VertexConnectivity>(
-        "v:connectivity");
-    auto hconn = mesh.get_halfedge_property<SurfaceMesh::HalfedgeConnectivity>(
-        "h:connectivity");
-    auto fconn =
-        mesh.get_face_property<SurfaceMesh::FaceConnectivity>("f:connectivity");
-    auto point = mesh.get_vertex_property<Point>("v:point");
-    auto htex = mesh.get_halfedge_property<TexCoord>("h:tex");
+    // decode the attributes of a new vertex, predicted from a + b - c
+    bool decode(RangeDecoder& rc, IndexType a, IndexType b, IndexType c)
+    {
+        int32_t* v = add();
+        bool ok = true;
+        for (int k = 0; k < n_channels_; ++k)
+        {
+            const int64_t x = predict(k, a, b, c) + models_[k].decode(rc);
+            ok = ok && x >= 0 && x <= max_[k];
+            v[k] = int32_t(x);
+        }
+        return ok;
+    }
 
-    // how many elements?
-    unsigned int nv, ne, nh, nf;
-    nv = mesh.n_vertices();
-    ne = mesh.n_edges();
-    nh = mesh.n_halfedges();
-    nf = mesh.n_faces();
+    // predict from the previous vertex
+    void encode(RangeEncoder& rc, const int32_t* q)
+    {
+        const IndexType last = IndexType(n_vertices_ ? n_vertices_ - 1 : 0);
+        encode(rc, q, last, last, last);
+    }
 
-    // write header
-    tfwrite(out, nv);
-    tfwrite(out, ne);
-    tfwrite(out, nf);
-    tfwrite(out, (bool)htex);
+    bool decode(RangeDecoder& rc)
+    {
+        const IndexType last = IndexType(n_vertices_ ? n_vertices_ - 1 : 0);
+        return decode(rc, last, last, last);
+    }
 
-    // write properties to file
-    fwrite((char*)vconn.data(), sizeof(SurfaceMesh::VertexConnectivity), nv,
-           out);
-    fwrite((char*)hconn.data(), sizeof(SurfaceMesh::HalfedgeConnectivity), nh,
-           out);
-    fwrite((char*)fconn.data(), sizeof(SurfaceMesh::FaceConnectivity), nf, out);
-    fwrite((char*)point.data(), sizeof(Point), nv, out);
+private:
+    int32_t* add()
+    {
+        values_.resize(values_.size() + n_channels_);
+        return &values_[n_vertices_++ * n_channels_];
+    }
 
-    // texture coordinates
-    if (htex)
-        fwrite((char*)htex.data(), sizeof(TexCoord), nh, out);
+    int64_t predict(int k, IndexType a, IndexType b, IndexType c) const
+    {
+        if (n_vertices_ == 1) // the vertex itself was just added
+            return 0;
+        const int64_t p = int64_t(values_[a * n_channels_ + k]) +
+                          values_[b * n_channels_ + k] -
+                          values_[c * n_channels_ + k];
+        return std::min(std::max(p, int64_t(0)), int64_t(max_[k]));
+    }
 
-    fclose(out);
-}
+    int n_channels_;
+    size_t n_vertices_;
+    std::vector<int32_t> max_;
+    std::vector<IntModel> models_;
+    std::vector<int32_t> values_;
+};
 
-// helper to assemble vertex data
-static int vertexCallback(p_ply_argument argument)
+// \brief Models shared by encoder and decoder.
+struct PmcModels
 {
-    long idx;
-    void* pdata;
-    ply_get_argument_user_data(argument, &pdata, &idx);
-
-    auto* mesh = (pmp::SurfaceMesh*)pdata;
-    auto point = mesh->get_object_property<pmp::Point>("g:point");
-    point[0][idx] = ply_get_argument_value(argument);
+    PmcModels() : new_vertex(rc_prob_init) {}
 
-    if (idx == 2)
-        mesh->add_vertex(point[0]);
+    SymbolModel symbols;
+    UIntModel node_offsets;
+    UIntModel vertex_offsets;
+    UIntModel valences;
+    uint16_t new_vertex;
+};
 
-    return 1;
-}
+} // namespace
 
-// helper to assemble face data
-static int faceCallback(p_ply_argument argument)
+std::vector<char> SurfaceMeshIO::encode(const SurfaceMesh& mesh,
+                                        const IOFlags& flags)
 {
-    long length, value_index;
-    void* pdata;
-    long idata;
-    ply_get_argument_user_data(argument, &pdata, &idata);
-    ply_get_argument_property(argument, nullptr, &length, &value_index);
+    if (flags.quantization_bits < 1 || flags.quantization_bits > 24)
+    {
+        auto what = "SurfaceMeshIO::encode: Quantization bits not in [1,24].";
+        throw InvalidInputException(what);
+    }
+    if (mesh.n_vertices() > uint32_t(-1) || mesh.n_faces() > uint32_t(-1))
+    {
+        auto what = "SurfaceMeshIO::encode: Mesh too large.";
+        throw InvalidInputException(what);
+    }
 
-    auto* mesh = (pmp::SurfaceMesh*)pdata;
-    auto vertices =
-        mesh->get_object_property<std::vector<pmp::Vertex>>("g:vertices");
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto texcoords = mesh.get_vertex_property<TexCoord>("v:tex");
+    if (!flags.use_vertex_normals)
+        normals = VertexProperty<Normal>();
+    if (!flags.use_vertex_texcoords)
+        texcoords = VertexProperty<TexCoord>();
+
+    // quantization ranges
+    std::vector<Point> points;
+    std::vector<TexCoord> coords;
+    points.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        points.push_back(mesh.position(v));
+        if (texcoords)
+            coords.push_back(texcoords[v]);
+    }
+    PmcQuantizer<3> position_quantizer;
+    position_quantizer.setup(points, flags.quantization_bits);
+    PmcQuantizer<2> texcoord_quantizer;
+    if (texcoords)
+        texcoord_quantizer.setup(coords, flags.quantization_bits);
 
-    if (value_index == 0)
-        vertices[0].clear();
+    // header
+    const bool triangles = mesh.is_triangle_mesh();
+    std::vector<char> out(pmc_magic, pmc_magic + sizeof(pmc_magic));
+    out.push_back(char(pmc_version));
+    out.push_back(char(triangles ? pmc_triangles : pmc_polygons));
+    out.push_back(char((normals ? pmc_normals : 0) |
+                       (texcoords ? pmc_texcoords : 0)));
+    out.push_back(char(flags.quantization_bits));
+    out.push_back(char(pmc_normal_bits));
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(0);
+    pmc_put(out, uint32_t(mesh.n_vertices()));
+    pmc_put(out, uint32_t(mesh.n_faces()));
+    for (int k = 0; k < 3; ++k)
+        pmc_put(out, position_quantizer.min[k]);
+    pmc_put(out, position_quantizer.extent);
+    if (texcoords)
+    {
+        for (int k = 0; k < 2; ++k)
+            pmc_put(out, texcoord_quantizer.min[k]);
+        pmc_put(out, texcoord_quantizer.extent);
+    }
 
-    pmp::IndexType idx = (pmp::IndexType)ply_get_argument_value(argument);
-    vertices[0].push_back(pmp::Vertex(idx));
+    RangeEncoder rc(out);
+    PmcModels models;
+    PmcAttributes attributes;
+    attributes.add_channels(3, position_quantizer.max_value());
+    if (normals)
+        attributes.add_channels(2, (1 << pmc_normal_bits) - 1);
+    if (texcoords)
+        attributes.add_channels(2, texcoord_quantizer.max_value());
+
+    // new vertex ids in traversal order
+    std::vector<IndexType> ids(mesh.vertices_size(), PMP_MAX_INDEX);
+    int32_t q[7];
+    auto add_vertex = [&](Vertex v) {
+        ids[v.idx()] = IndexType(attributes.n_vertices());
+        position_quantizer.quantize(mesh.position(v), q);
+        int k = 3;
+        if (normals)
+        {
+            pmc_encode_normal(normals[v], q + k);
+            k += 2;
+        }
+        if (texcoords)
+            texcoord_quantizer.quantize(texcoords[v], q + k);
+    };
+
+    // code a vertex of a seed triangle or a polygon as new or as offset
+    auto code_vertex = [&](Vertex v) {
+        const bool is_new = ids[v.idx()] == PMP_MAX_INDEX;
+        rc.encode_bit(models.new_vertex, is_new);
+        if (!is_new)
+            models.vertex_offsets.encode(
+                rc, uint32_t(attributes.n_vertices() - 1 - ids[v.idx()]));
+        return is_new;
+    };
+
+    if (triangles)
+    {
+        std::vector<bool> visited(mesh.faces_size(), false);
+        std::vector<int> halfedge_node(mesh.halfedges_size(), -1);
+        std::vector<Halfedge> node_halfedge;
+        PmcBorder border;
+
+        auto add_node = [&](int n, Halfedge h) {
+            node_halfedge.resize(border.nodes.size());
+            node_halfedge[n] = h;
+            halfedge_node[h.idx()] = n;
+        };
+
+        for (auto f : mesh.faces())
+        {
+            if (visited[f.idx()])
+                continue;
+
+            // seed triangle
+            visited[f.idx()] = true;
+            Halfedge h[3];
+            h[0] = mesh.halfedge(f);
+            h[1] = mesh.next_halfedge(h[0]);
+            h[2] = mesh.next_halfedge(h[1]);
+            const Vertex v[3] = {mesh.from_vertex(h[0]), mesh.to_vertex(h[0]),
+                                 mesh.to_vertex(h[1])};
+            for (auto vi : v)
+            {
+                if (code_vertex(vi))
+                {
+                    add_vertex(vi);
+                    attributes.encode(rc, q);
+                }
+            }
+            int n[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                n[i] = border.add(ids[mesh.to_vertex(h[i]).idx()],
+                                  ids[mesh.from_vertex(h[i]).idx()],
+                                  ids[v[(i + 2) % 3].idx()]);
+                add_node(n[i], mesh.opposite_halfedge(h[i]));
+            }
+            border.link(n[0], n[2]);
+            border.link(n[2], n[1]);
+            border.link(n[1], n[0]);
 
-    if (value_index == length - 1)
-        mesh->add_face(vertices[0]);
+            // traverse the connected triangles
+            int g = n[0];
+            while (g >= 0)
+            {
+                const Halfedge hg = node_halfedge[g];
+                const Face fg = mesh.face(hg);
+                int symbol = pmc_b;
+                IndexType w = 0;
+                int s = -1;
+                Halfedge x1, x2;
+                if (fg.is_valid() && !visited[fg.idx()])
+                {
+                    visited[fg.idx()] = true;
+                    x1 = mesh.next_halfedge(hg);
+                    x2 = mesh.next_halfedge(x1);
+                    const Vertex vw = mesh.to_vertex(x1);
+                    const auto& node = border.nodes[g];
+                    const bool r = halfedge_node[x1.idx()] >= 0 &&
+                                   halfedge_node[x1.idx()] == node.next;
+                    const bool l = halfedge_node[x2.idx()] >= 0 &&
+                                   halfedge_node[x2.idx()] == node.prev;
+                    if (r && l)
+                        symbol = pmc_e;
+                    else if (r)
+                        symbol = pmc_r;
+                    else if (l)
+                        symbol = pmc_l;
+                    else if (ids[vw.idx()] == PMP_MAX_INDEX)
+                        symbol = pmc_c;
+                    else
+                    {
+                        // find the border node leaving vw next to the
+                        // triangle by rotating around vw
+                        symbol = pmc_s;
+                        s = halfedge_node[x2.idx()];
+                        Halfedge hr = mesh.opposite_halfedge(x2);
+                        while (s < 0)
+                        {
+                            const Halfedge hn = mesh.next_halfedge(hr);
+                            if (hn == x2)
+                            {
+                                auto what = "SurfaceMeshIO::encode: "
+                                            "Inconsistent border.";
+                                throw TopologyException(what);
+                            }
+                            s = halfedge_node[hn.idx()];
+                            hr = mesh.opposite_halfedge(hn);
+                        }
+                    }
 
-    return 1;
-}
+                    if (symbol == pmc_c)
+                        add_vertex(vw);
+                    w = ids[vw.idx()];
+                }
 
-void SurfaceMeshIO::read_ply(SurfaceMesh& mesh)
-{
-    // add object properties to hold temporary data
-    auto point = mesh.add_object_property<Point>("g:point");
-    auto vertices = mesh.add_object_property<std::vector<Vertex>>("g:vertices");
+                models.symbols.encode(rc, symbol);
+                if (symbol == pmc_s)
+                    models.node_offsets.encode(
+                        rc, uint32_t(border.nodes.size() - 1 - s));
+                if (symbol == pmc_c)
+                {
+                    const auto& node = border.nodes[g];
+                    attributes.encode(rc, q, node.from, node.to, node.apex);
+                }
 
-    // open file, read header
-    p_ply ply = ply_open(filename_.c_str(), nullptr, 0, nullptr);
+                // update the border and the halfedges of its nodes
+                if (symbol != pmc_b)
+                {
+                    halfedge_node[hg.idx()] = -1;
+                    if (symbol == pmc_r || symbol == pmc_e)
+                        halfedge_node[x1.idx()] = -1;
+                    if (symbol == pmc_l || symbol == pmc_e)
+                        halfedge_node[x2.idx()] = -1;
+                }
+                int y1, y2;
+                g = border.advance(g, symbol, w, s, y1, y2);
+                if (y1 >= 0)
+                    add_node(y1, mesh.opposite_halfedge(x1));
+                if (y2 >= 0)
+                    add_node(y2, mesh.opposite_halfedge(x2));
+            }
+        }
+    }
+    else
+    {
+        for (auto f : mesh.faces())
+        {
+            models.valences.encode(rc, uint32_t(mesh.valence(f) - 3));
+            std::vector<IndexType> corners;
+            for (auto v : mesh.vertices(f))
+            {
+                if (code_vertex(v))
+                {
+                    add_vertex(v);
+                    // parallelogram of the three preceding corners
+                    const size_t n = corners.size();
+                    if (n >= 3)
+                        attributes.encode(rc, q, corners[n - 1],
+                                          corners[n - 3], corners[n - 2]);
+                    else if (n >= 1)
+                        attributes.encode(rc, q, corners[n - 1],
+                                          corners[n - 1], corners[n - 1]);
+                    else
+                        attributes.encode(rc, q);
+                }
+                corners.push_back(ids[v.idx()]);
+            }
+        }
+    }
 
-    if (!ply)
-        throw IOException("Failed to open file: " + filename_);
+    // isolated vertices
+    for (auto v : mesh.vertices())
+    {
+        if (ids[v.idx()] == PMP_MAX_INDEX)
+        {
+            add_vertex(v);
+            attributes.encode(rc, q);
+        }
+    }
 
-    if (!ply_read_header(ply))
-        throw IOException("Failed to read PLY header!");
+    rc.flush();
+    return out;
+}
 
-    // setup callbacks for basic properties
-    ply_set_read_cb(ply, "vertex", "x", vertexCallback, &mesh, 0);
-    ply_set_read_cb(ply, "vertex", "y", vertexCallback, &mesh, 1);
-    ply_set_read_cb(ply, "vertex", "z", vertexCallback, &mesh, 2);
+void SurfaceMeshIO::decode(const char* data, size_t size, SurfaceMesh& mesh)
+{
+    mesh.clear();
+    auto corrupt = []() { return IOException("Corrupt PMC data"); };
 
-    ply_set_read_cb(ply, "face", "vertex_indices", faceCallback, &mesh, 0);
+    // header
+    const size_t header_size = 20 + 4 * 8;
+    if (size < header_size || memcmp(data, pmc_magic, sizeof(pmc_magic)))
+        throw corrupt();
+    const uint8_t version = uint8_t(data[4]);
+    const uint8_t connectivity = uint8_t(data[5]);
+    const uint8_t attribute_mask = uint8_t(data[6]);
+    const int position_bits = uint8_t(data[7]);
+    const int normal_bits = uint8_t(data[8]);
+    if (version != pmc_version)
+        throw IOException("Unsupported PMC version");
+    if (connectivity > pmc_polygons || position_bits < 1 ||
+        position_bits > 24 || normal_bits != pmc_normal_bits)
+        throw corrupt();
+
+    const char* p = data + 12;
+    const size_t n_vertices = pmc_get<uint32_t>(p);
+    const size_t n_faces = pmc_get<uint32_t>(p);
+    PmcQuantizer<3> position_quantizer;
+    position_quantizer.bits = position_bits;
+    for (int k = 0; k < 3; ++k)
+        position_quantizer.min[k] = pmc_get<double>(p);
+    position_quantizer.extent = pmc_get<double>(p);
+
+    const bool has_normals = attribute_mask & pmc_normals;
+    const bool has_texcoords = attribute_mask & pmc_texcoords;
+    PmcQuantizer<2> texcoord_quantizer;
+    if (has_texcoords)
+    {
+        if (size < header_size + 3 * 8)
+            throw corrupt();
+        texcoord_quantizer.bits = position_bits;
+        for (int k = 0; k < 2; ++k)
+            texcoord_quantizer.min[k] = pmc_get<double>(p);
+        texcoord_quantizer.extent = pmc_get<double>(p);
+    }
 
-    // read the data
-    if (!ply_read(ply))
-        throw IOException("Failed to read PLY data!");
+    RangeDecoder rc(p, data + size);
+    PmcModels models;
+    PmcAttributes attributes;
+    attributes.add_channels(3, position_quantizer.max_value());
+    if (has_normals)
+        attributes.add_channels(2, (1 << pmc_normal_bits) - 1);
+    if (has_texcoords)
+        attributes.add_channels(2, texcoord_quantizer.max_value());
 
-    ply_close(ply);
+    std::vector<IndexType> indices;
+    std::vector<IndexType> face_sizes;
+    indices.reserve(3 * n_faces);
 
-    // clean-up properties
-    mesh.remove_object_property(point);
-    mesh.remove_object_property(vertices);
-}
+    // decode a vertex of a seed triangle or a polygon
+    auto decode_vertex = [&](IndexType& v) {
+        if (rc.decode_bit(models.new_vertex))
+        {
+            if (attributes.n_vertices() >= n_vertices)
+                throw corrupt();
+            v = IndexType(attributes.n_vertices());
+            return true;
+        }
+        const size_t offset = models.vertex_offsets.decode(rc);
+        if (offset >= attributes.n_vertices())
+            throw corrupt();
+        v = IndexType(attributes.n_vertices() - 1 - offset);
+        return false;
+    };
+
+    if (connectivity == pmc_triangles)
+    {
+        PmcBorder border;
+        size_t n_decoded = 0;
+        while (n_decoded < n_faces)
+        {
+            // seed triangle
+            IndexType v[3];
+            for (auto& vi : v)
+                if (decode_vertex(vi) && !attributes.decode(rc))
+                    throw corrupt();
+            if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0] || rc.overrun())
+                throw corrupt();
+            indices.insert(indices.end(), v, v + 3);
+            ++n_decoded;
+
+            int n[3];
+            for (int i = 0; i < 3; ++i)
+                n[i] = border.add(v[(i + 1) % 3], v[i], v[(i + 2) % 3]);
+            border.link(n[0], n[2]);
+            border.link(n[2], n[1]);
+            border.link(n[1], n[0]);
+
+            int g = n[0];
+            while (g >= 0)
+            {
+                const int symbol = models.symbols.decode(rc);
+                const auto node = border.nodes[g];
+                IndexType w = 0;
+                int s = -1;
+                switch (symbol)
+                {
+                    case pmc_c:
+                        if (attributes.n_vertices() >= n_vertices ||
+                            !attributes.decode(rc, node.from, node.to,
+                                               node.apex))
+                            throw corrupt();
+                        w = IndexType(attributes.n_vertices() - 1);
+                        break;
+                    case pmc_r:
+                        if (border.nodes[node.next].state != PmcBorder::live)
+                            throw corrupt();
+                        w = border.nodes[node.next].to;
+                        break;
+                    case pmc_l:
+                    case pmc_e:
+                        if (border.nodes[node.prev].state != PmcBorder::live ||
+                            (symbol == pmc_e &&
+                             border.nodes[node.next].state != PmcBorder::live))
+                            throw corrupt();
+                        w = border.nodes[node.prev].from;
+                        break;
+                    case pmc_s:
+                    {
+                        const size_t offset = models.node_offsets.decode(rc);
+                        if (offset >= border.nodes.size())
+                            throw corrupt();
+                        s = int(border.nodes.size() - 1 - offset);
+                        if (border.nodes[s].state == PmcBorder::removed)
+                            throw corrupt();
+                        w = border.nodes[s].from;
+                        break;
+                    }
+                    default:
+                        break;
+                }
 
-void SurfaceMeshIO::write_ply(const SurfaceMesh& mesh)
-{
-    e_ply_storage_mode mode = flags_.use_binary ? PLY_LITTLE_ENDIAN : PLY_ASCII;
-    p_ply ply = ply_create(filename_.c_str(), mode, nullptr, 0, nullptr);
+                if (symbol != pmc_b)
+                {
+                    if (w == node.from || w == node.to ||
+                        n_decoded == n_faces || rc.overrun())
+                        throw corrupt();
+                    indices.push_back(node.from);
+                    indices.push_back(node.to);
+                    indices.push_back(w);
+                    ++n_decoded;
+                }
 
-    ply_add_comment(ply, "File written with pmp-library");
-    ply_add_element(ply, "vertex", mesh.n_vertices());
-    ply_add_scalar_property(ply, "x", PLY_FLOAT);
-    ply_add_scalar_property(ply, "y", PLY_FLOAT);
-    ply_add_scalar_property(ply, "z", PLY_FLOAT);
-    ply_add_element(ply, "face", mesh.n_faces());
-    ply_add_property(ply, "vertex_indices", PLY_LIST, PLY_UCHAR, PLY_INT);
-    ply_write_header(ply);
+                int y1, y2;
+                g = border.advance(g, symbol, w, s, y1, y2);
+            }
+        }
+    }
+    else
+    {
+        face_sizes.reserve(n_faces);
+        for (size_t i = 0; i < n_faces; ++i)
+        {
+            const size_t valence = size_t(models.valences.decode(rc)) + 3;
+            if (valence > n_vertices || rc.overrun())
+                throw corrupt();
+            const size_t first = indices.size();
+            for (size_t j = 0; j < valence; ++j)
+            {
+                IndexType v;
+                if (decode_vertex(v))
+                {
+                    const IndexType* c = indices.data() + first;
+                    bool ok;
+                    if (j >= 3)
+                        ok = attributes.decode(rc, c[j - 1], c[j - 3],
+                                               c[j - 2]);
+                    else if (j >= 1)
+                        ok = attributes.decode(rc, c[j - 1], c[j - 1],
+                                               c[j - 1]);
+                    else
+                        ok = attributes.decode(rc);
+                    if (!ok)
+                        throw corrupt();
+                }
+                indices.push_back(v);
+            }
+            face_sizes.push_back(IndexType(valence));
+        }
+    }
 
-    // write vertices
-    auto points = mesh.get_vertex_property<Point>("v:point");
-    for (auto v : mesh.vertices())
+    // isolated vertices
+    while (attributes.n_vertices() < n_vertices)
+        if (!attributes.decode(rc))
+            throw corrupt();
+    if (rc.overrun())
+        throw corrupt();
+
+    std::vector<Point> points(n_vertices);
+    for (size_t i = 0; i < n_vertices; ++i)
+        points[i] = position_quantizer.dequantize(attributes[i]);
+    try
     {
-        ply_write(ply, points[v][0]);
-        ply_write(ply, points[v][1]);
-        ply_write(ply, points[v][2]);
+        mesh.from_indexed_faces(points, indices, face_sizes);
+    }
+    catch (const std::exception&)
+    {
+        mesh.clear();
+        throw corrupt();
     }
 
-    // write faces
-    for (auto f : mesh.faces())
+    int k = 3;
+    if (has_normals)
     {
-        ply_write(ply, mesh.valence(f));
-        for (auto fv : mesh.vertices(f))
-            ply_write(ply, fv.idx());
+        auto normals = mesh.vertex_property<Normal>("v:normal");
+        for (size_t i = 0; i < n_vertices; ++i)
+            normals[Vertex(IndexType(i))] =
+                pmc_decode_normal(attributes[i] + k);
+        k += 2;
+    }
+    if (has_texcoords)
+    {
+        auto texcoords = mesh.vertex_property<TexCoord>("v:tex");
+        for (size_t i = 0; i < n_vertices; ++i)
+            texcoords[Vertex(IndexType(i))] =
+                texcoord_quantizer.dequantize(attributes[i] + k);
     }
+}
 
-    ply_close(ply);
+void SurfaceMeshIO::read_pmc(SurfaceMesh& mesh)
+{
+    auto file = map_input();
+    decode(file->data(), file->size(), mesh);
 }
 
-// helper class for STL reader
-class CmpVec
+void SurfaceMeshIO::write_pmc(const SurfaceMesh& mesh)
 {
-public:
-    CmpVec(Scalar eps = std::numeric_limits<Scalar>::min()) : eps_(eps) {}
+    auto data = encode(mesh, flags_);
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+    const size_t n_written = fwrite(data.data(), 1, data.size(), out);
+    close_output(out);
+    if (n_written != data.size())
+        throw IOException("Failed to write file: " + filename_);
+}
+
+namespace {
+
+// \brief Reorder triangles for the post-transform vertex cache of GPUs.
+// \details Implements Tipsify [Sander et al. 2007], which emits the
+// triangles around a fanning vertex and selects the next one among the
+// vertices likely still in a cache of cache_size vertices.
+std::vector<IndexType> tipsify(const std::vector<IndexType>& indices,
+                               size_t n_vertices, int cache_size)
+{
+    const size_t n_triangles = indices.size() / 3;
+
+    // triangles incident to each vertex
+    std::vector<size_t> offsets(n_vertices + 1, 0);
+    for (auto v : indices)
+        ++offsets[v + 1];
+    for (size_t v = 0; v < n_vertices; ++v)
+        offsets[v + 1] += offsets[v];
+    std::vector<size_t> triangles(indices.size());
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            triangles[fill[indices[i]]++] = i / 3;
+    }
 
-    bool operator()(const vec3& v0, const vec3& v1) const
+    std::vector<int> live(n_vertices);
+    for (size_t v = 0; v < n_vertices; ++v)
+        live[v] = int(offsets[v + 1] - offsets[v]);
+    std::vector<int> cache_time(n_vertices, 0);
+    std::vector<bool> emitted(n_triangles, false);
+    std::vector<IndexType> dead_ends, candidates, result;
+    result.reserve(indices.size());
+
+    int time = cache_size + 1;
+    size_t cursor = 0;
+    size_t fanning = indices.empty() ? PMP_MAX_INDEX : indices[0];
+    while (fanning != PMP_MAX_INDEX)
     {
-        if (fabs(v0[0] - v1[0]) <= eps_)
+        // emit the triangles around the fanning vertex
+        candidates.clear();
+        for (size_t i = offsets[fanning]; i < offsets[fanning + 1]; ++i)
         {
-            if (fabs(v0[1] - v1[1]) <= eps_)
+            const size_t t = triangles[i];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+            for (int j = 0; j < 3; ++j)
             {
-                return (v0[2] < v1[2] - eps_);
+                const IndexType v = indices[3 * t + j];
+                result.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > cache_size)
+                    cache_time[v] = time++;
             }
-            else
-                return (v0[1] < v1[1] - eps_);
         }
-        else
-            return (v0[0] < v1[0] - eps_);
-    }
 
-private:
-    Scalar eps_;
-};
+        // prefer candidates that stay in the cache while emitting their
+        // remaining triangles
+        fanning = PMP_MAX_INDEX;
+        int best = -1;
+        for (auto v : candidates)
+        {
+            if (live[v] <= 0)
+                continue;
+            int priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size)
+                priority = time - cache_time[v];
+            if (priority > best)
+            {
+                best = priority;
+                fanning = v;
+            }
+        }
 
-void SurfaceMeshIO::read_stl(SurfaceMesh& mesh)
+        // otherwise continue with a recently used or the next vertex
+        while (fanning == PMP_MAX_INDEX && !dead_ends.empty())
+        {
+            const IndexType v = dead_ends.back();
+            dead_ends.pop_back();
+            if (live[v] > 0)
+                fanning = v;
+        }
+        for (; fanning == PMP_MAX_INDEX && cursor < n_vertices; ++cursor)
+            if (live[cursor] > 0)
+                fanning = cursor;
+    }
+    return result;
+}
+
+// JSON representation of a number, exact for floats
+std::string json_number(double x)
 {
-    char line[100], *c;
-    unsigned int i, nT(0);
-    vec3 p;
-    Vertex v;
-    std::vector<Vertex> vertices(3);
-    size_t n_items(0);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", x);
+    for (char* c = buffer; *c; ++c)
+        if (*c == ',')
+            *c = '.';
+    return buffer;
+}
 
-    CmpVec comp(std::numeric_limits<Scalar>::min());
-    std::map<vec3, Vertex, CmpVec> vMap(comp);
-    std::map<vec3, Vertex, CmpVec>::iterator vMapIt;
+std::string json_array(const double* x, int n)
+{
+    std::string result = "[";
+    for (int i = 0; i < n; ++i)
+        result += (i ? "," : "") + json_number(x[i]);
+    return result + "]";
+}
 
-    // open file (in ASCII mode)
-    FILE* in = fopen(filename_.c_str(), "r");
-    if (!in)
-        throw IOException("Failed to open file: " + filename_);
+// glTF component types
+const int gltf_byte = 5120;
+const int gltf_unsigned_byte = 5121;
+const int gltf_unsigned_short = 5123;
+const int gltf_unsigned_int = 5125;
+const int gltf_float = 5126;
 
-    // ASCII or binary STL?
-    c = fgets(line, 6, in);
-    PMP_ASSERT(c != nullptr);
-    const bool binary =
-        ((strncmp(line, "SOLID", 5) != 0) && (strncmp(line, "solid", 5) != 0));
+// vertex attribute within interleaved vertex records
+struct GlbAttribute
+{
+    std::string name;
+    int component_type;
+    int n_components;
+    bool normalized;
+    size_t offset; // within the record
+};
 
-    // parse binary STL
-    if (binary)
+// size of the components of a glTF component type
+size_t gltf_component_size(int type)
+{
+    switch (type)
     {
-        // re-open file in binary mode
-        fclose(in);
-        in = fopen(filename_.c_str(), "rb");
-        if (!in)
-            throw IOException("Failed to open file: " + filename_);
+        case gltf_byte:
+        case gltf_unsigned_byte:
+            return 1;
+        case gltf_unsigned_short:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+inline int16_t to_snorm8(Scalar x)
+{
+    return int16_t(std::floor(std::min(std::max(x, Scalar(-1)), Scalar(1)) *
+                                  127 +
+                              Scalar(0.5)));
+}
+
+inline uint32_t to_unorm(Scalar x, uint32_t max_value)
+{
+    x = std::min(std::max(x, Scalar(0)), Scalar(1));
+    return uint32_t(std::floor(x * max_value + Scalar(0.5)));
+}
 
-        // skip dummy header
-        n_items = fread(line, 1, 80, in);
-        PMP_ASSERT(n_items > 0);
+} // namespace
 
-        // read number of triangles
-        tfread(in, nT);
+void SurfaceMeshIO::write_glb(const SurfaceMesh& mesh)
+{
+    if (mesh.n_faces() == 0)
+        throw IOException("GLB files require faces: " + filename_);
+
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto colors = mesh.get_vertex_property<Color>("v:color");
+    auto vtex = mesh.get_vertex_property<TexCoord>("v:tex");
+    auto htex = mesh.get_halfedge_property<TexCoord>("h:tex");
+    const bool has_normals = normals && flags_.use_vertex_normals;
+    const bool has_colors = colors && flags_.use_vertex_colors;
+    const bool has_htex = htex && flags_.use_halfedge_texcoords;
+    const bool has_vtex = vtex && flags_.use_vertex_texcoords && !has_htex;
+    const bool quantize = flags_.use_quantization;
 
-        // read triangles
-        while (nT)
+    // glTF vertices: the mesh vertices, split at halfedge texture seams
+    std::vector<Vertex> vertices;
+    std::vector<TexCoord> texcoords;
+    std::vector<IndexType> corner(mesh.halfedges_size(), PMP_MAX_INDEX);
+    for (auto v : mesh.vertices())
+    {
+        const size_t first = vertices.size();
+        if (!has_htex)
         {
-            // skip triangle normal
-            n_items = fread(line, 1, 12, in);
-            PMP_ASSERT(n_items > 0);
-            // triangle's vertices
-            for (i = 0; i < 3; ++i)
+            vertices.push_back(v);
+            if (has_vtex)
+                texcoords.push_back(vtex[v]);
+        }
+        for (auto h : mesh.halfedges(v))
+        {
+            // the halfedge pointing to the corner at v
+            const Halfedge c = mesh.opposite_halfedge(h);
+            if (mesh.is_boundary(c))
+                continue;
+            size_t i = first;
+            if (has_htex)
             {
-                tfread(in, p);
-
-                // has vector been referenced before?
-                if ((vMapIt = vMap.find(p)) == vMap.end())
-                {
-                    // No : add vertex and remember idx/vector mapping
-                    v = mesh.add_vertex((Point)p);
-                    vertices[i] = v;
-                    vMap[p] = v;
-                }
-                else
+                while (i < vertices.size() && texcoords[i] != htex[c])
+                    ++i;
+                if (i == vertices.size())
                 {
-                    // Yes : get index from map
-                    vertices[i] = vMapIt->second;
+                    vertices.push_back(v);
+                    texcoords.push_back(htex[c]);
                 }
             }
+            corner[c.idx()] = IndexType(i);
+        }
+        if (vertices.size() == first)
+        {
+            // isolated vertex
+            vertices.push_back(v);
+            if (has_htex)
+                texcoords.push_back(TexCoord(0, 0));
+        }
+    }
+    const bool has_texcoords = has_htex || has_vtex;
 
-            // Add face only if it is not degenerated
-            if ((vertices[0] != vertices[1]) && (vertices[0] != vertices[2]) &&
-                (vertices[1] != vertices[2]))
-                add_face(mesh, vertices);
-
-            n_items = fread(line, 1, 2, in);
-            PMP_ASSERT(n_items > 0);
-            --nT;
+    // triangle fans of the faces
+    std::vector<IndexType> indices;
+    indices.reserve(3 * mesh.n_faces());
+    for (auto f : mesh.faces())
+    {
+        auto h0 = mesh.halfedge(f);
+        auto h1 = mesh.next_halfedge(h0);
+        for (auto h2 = mesh.next_halfedge(h1); h2 != h0;
+             h1 = h2, h2 = mesh.next_halfedge(h2))
+        {
+            indices.push_back(corner[h0.idx()]);
+            indices.push_back(corner[h1.idx()]);
+            indices.push_back(corner[h2.idx()]);
         }
     }
 
-    // parse ASCII STL
-    else
+    // order triangles for the vertex cache and vertices by first use
+    if (flags_.optimize_vertex_cache)
+    {
+        indices = tipsify(indices, vertices.size(), 16);
+        std::vector<IndexType> new_index(vertices.size(), PMP_MAX_INDEX);
+        std::vector<Vertex> new_vertices;
+        std::vector<TexCoord> new_texcoords;
+        new_vertices.reserve(vertices.size());
+        new_texcoords.reserve(texcoords.size());
+        auto use = [&](IndexType i) {
+            if (new_index[i] == PMP_MAX_INDEX)
+            {
+                new_index[i] = IndexType(new_vertices.size());
+                new_vertices.push_back(vertices[i]);
+                if (has_texcoords)
+                    new_texcoords.push_back(texcoords[i]);
+            }
+            return new_index[i];
+        };
+        for (auto& i : indices)
+            i = use(i);
+        for (size_t i = 0; i < vertices.size(); ++i)
+            use(IndexType(i));
+        vertices.swap(new_vertices);
+        texcoords.swap(new_texcoords);
+    }
+    const size_t n_vertices = vertices.size();
+
+    // bounds of positions and texture coordinates
+    double pmin[3] = {0, 0, 0}, pmax[3] = {0, 0, 0};
+    bool unit_texcoords = true;
+    for (size_t i = 0; i < n_vertices; ++i)
     {
-        // parse line by line
-        while (in && !feof(in) && fgets(line, 100, in))
+        const Point& p = mesh.position(vertices[i]);
+        for (int k = 0; k < 3; ++k)
         {
-            // skip white-space
-            for (c = line; isspace(*c) && *c != '\0'; ++c)
+            pmin[k] = i ? std::min(pmin[k], double(p[k])) : p[k];
+            pmax[k] = i ? std::max(pmax[k], double(p[k])) : p[k];
+        }
+        if (has_texcoords)
+            for (int k = 0; k < 2; ++k)
+                unit_texcoords = unit_texcoords && texcoords[i][k] >= 0 &&
+                                 texcoords[i][k] <= 1;
+    }
+    double extent = 0;
+    for (int k = 0; k < 3; ++k)
+        extent = std::max(extent, pmax[k] - pmin[k]);
+    if (!(extent > 0))
+        extent = 1;
+
+    // interleaved vertex layout, attributes are aligned to four bytes
+    std::vector<GlbAttribute> attributes;
+    size_t stride = 0;
+    auto add_attribute = [&](const char* name, int type, int n,
+                             bool normalized) {
+        GlbAttribute a = {name, type, n, normalized, stride};
+        attributes.push_back(a);
+        stride += (gltf_component_size(type) * n + 3) / 4 * 4;
+    };
+    add_attribute("POSITION", quantize ? gltf_unsigned_short : gltf_float, 3,
+                  false);
+    if (has_normals)
+        add_attribute("NORMAL", quantize ? gltf_byte : gltf_float, 3,
+                      quantize);
+    if (has_texcoords)
+        add_attribute("TEXCOORD_0",
+                      quantize && unit_texcoords ? gltf_unsigned_short
+                                                 : gltf_float,
+                      2, quantize && unit_texcoords);
+    if (has_colors)
+        add_attribute("COLOR_0", quantize ? gltf_unsigned_byte : gltf_float,
+                      3, quantize);
+
+    // binary buffer: vertex records followed by the indices
+    const bool short_indices = n_vertices < 0xFFFF;
+    const size_t vertex_bytes = n_vertices * stride;
+    const size_t index_bytes = indices.size() * (short_indices ? 2 : 4);
+    std::vector<char> buffer(vertex_bytes + (index_bytes + 3) / 4 * 4, 0);
+
+    const double scale = extent / 65535;
+    uint32_t qmin[3] = {0xFFFF, 0xFFFF, 0xFFFF}, qmax[3] = {0, 0, 0};
+    for (size_t i = 0; i < n_vertices; ++i)
+    {
+        char* record = buffer.data() + i * stride;
+        const Vertex v = vertices[i];
+        for (const auto& a : attributes)
+        {
+            char* p = record + a.offset;
+            double values[3];
+            if (a.name == "POSITION")
             {
-            };
+                const Point& x = mesh.position(v);
+                for (int k = 0; k < 3; ++k)
+                    values[k] = x[k];
+            }
+            else if (a.name == "NORMAL")
+            {
+                for (int k = 0; k < 3; ++k)
+                    values[k] = normals[v][k];
+            }
+            else if (a.name == "TEXCOORD_0")
+            {
+                // glTF texture coordinates start at the top left
+                values[0] = texcoords[i][0];
+                values[1] = 1 - texcoords[i][1];
+            }
+            else
+            {
+                for (int k = 0; k < 3; ++k)
+                    values[k] = colors[v][k];
+            }
 
-            // face begins
-            if ((strncmp(c, "outer", 5) == 0) || (strncmp(c, "OUTER", 5) == 0))
+            for (int k = 0; k < a.n_components; ++k)
             {
-                // read three vertices
-                for (i = 0; i < 3; ++i)
+                switch (a.component_type)
                 {
-                    // read line
-                    c = fgets(line, 100, in);
-                    PMP_ASSERT(c != nullptr);
-
-                    // skip white-space
-                    for (c = line; isspace(*c) && *c != '\0'; ++c)
-                    {
-                    };
-
-                    // read x, y, z
-                    sscanf(c + 6, "%f %f %f", &p[0], &p[1], &p[2]);
-
-                    // has vector been referenced before?
-                    if ((vMapIt = vMap.find(p)) == vMap.end())
+                    case gltf_float:
                     {
-                        // No : add vertex and remember idx/vector mapping
-                        v = mesh.add_vertex((Point)p);
-                        vertices[i] = v;
-                        vMap[p] = v;
+                        const float x = float(values[k]);
+                        memcpy(p + 4 * k, &x, 4);
+                        break;
                     }
-                    else
+                    case gltf_byte:
+                        p[k] = char(to_snorm8(Scalar(values[k])));
+                        break;
+                    case gltf_unsigned_byte:
+                        p[k] = char(to_unorm(Scalar(values[k]), 255));
+                        break;
+                    default:
                     {
-                        // Yes : get index from map
-                        vertices[i] = vMapIt->second;
+                        uint16_t x;
+                        if (a.name == "POSITION")
+                        {
+                            const double q =
+                                std::floor((values[k] - pmin[k]) / scale + 0.5);
+                            x = uint16_t(std::min(std::max(q, 0.0), 65535.0));
+                            qmin[k] = std::min(qmin[k], uint32_t(x));
+                            qmax[k] = std::max(qmax[k], uint32_t(x));
+                        }
+                        else
+                        {
+                            x = uint16_t(to_unorm(Scalar(values[k]), 65535));
+                        }
+                        memcpy(p + 2 * k, &x, 2);
                     }
                 }
-
-                // Add face only if it is not degenerated
-                if ((vertices[0] != vertices[1]) &&
-                    (vertices[0] != vertices[2]) &&
-                    (vertices[1] != vertices[2]))
-                    add_face(mesh, vertices);
             }
         }
     }
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        char* p = buffer.data() + vertex_bytes;
+        if (short_indices)
+        {
+            const uint16_t idx = uint16_t(indices[i]);
+            memcpy(p + 2 * i, &idx, 2);
+        }
+        else
+        {
+            const uint32_t idx = indices[i];
+            memcpy(p + 4 * i, &idx, 4);
+        }
+    }
 
-    fclose(in);
+    // JSON scene description
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":"
+                       "\"pmp-library\"}";
+    if (quantize)
+        json += ",\"extensionsUsed\":[\"KHR_mesh_quantization\"],"
+                "\"extensionsRequired\":[\"KHR_mesh_quantization\"]";
+    json += ",\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0";
+    if (quantize)
+    {
+        // dequantize positions by the node transformation
+        const double s[3] = {scale, scale, scale};
+        json += ",\"translation\":" + json_array(pmin, 3) +
+                ",\"scale\":" + json_array(s, 3);
+    }
+    json += "}],\"meshes\":[{\"primitives\":[{\"attributes\":{";
+    for (size_t i = 0; i < attributes.size(); ++i)
+        json += (i ? ",\"" : "\"") + attributes[i].name +
+                "\":" + std::to_string(i);
+    json += "},\"indices\":" + std::to_string(attributes.size()) +
+            ",\"mode\":4}]}]";
+
+    json += ",\"accessors\":[";
+    const char* types[] = {"", "SCALAR", "VEC2", "VEC3", "VEC4"};
+    for (const auto& a : attributes)
+    {
+        json += "{\"bufferView\":0,\"byteOffset\":" + std::to_string(a.offset) +
+                ",\"componentType\":" + std::to_string(a.component_type) +
+                (a.normalized ? ",\"normalized\":true" : "") +
+                ",\"count\":" + std::to_string(n_vertices) + ",\"type\":\"" +
+                types[a.n_components] + "\"";
+        if (a.name == "POSITION")
+        {
+            double lo[3], hi[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                lo[k] = quantize ? double(qmin[k]) : double(float(pmin[k]));
+                hi[k] = quantize ? double(qmax[k]) : double(float(pmax[k]));
+            }
+            json += ",\"min\":" + json_array(lo, 3) +
+                    ",\"max\":" + json_array(hi, 3);
+        }
+        json += "},";
+    }
+    json += "{\"bufferView\":1,\"componentType\":" +
+            std::to_string(short_indices ? gltf_unsigned_short
+                                         : gltf_unsigned_int) +
+            ",\"count\":" + std::to_string(indices.size()) +
+            ",\"type\":\"SCALAR\"}]";
+
+    json += ",\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" +
+            std::to_string(vertex_bytes) +
+            ",\"byteStride\":" + std::to_string(stride) +
+            ",\"target\":34962},{\"buffer\":0,\"byteOffset\":" +
+            std::to_string(vertex_bytes) +
+            ",\"byteLength\":" + std::to_string(index_bytes) +
+            ",\"target\":34963}]";
+    json += ",\"buffers\":[{\"byteLength\":" + std::to_string(buffer.size()) +
+            "}]}";
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+
+    // GLB container: header, JSON chunk, binary chunk
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+    const uint32_t header[3] = {
+        0x46546C67, 2, uint32_t(12 + 8 + json.size() + 8 + buffer.size())};
+    const uint32_t json_chunk[2] = {uint32_t(json.size()), 0x4E4F534A};
+    const uint32_t bin_chunk[2] = {uint32_t(buffer.size()), 0x004E4942};
+    bool ok = fwrite(header, sizeof(header), 1, out) == 1 &&
+              fwrite(json_chunk, sizeof(json_chunk), 1, out) == 1 &&
+              fwrite(json.data(), 1, json.size(), out) == json.size() &&
+              fwrite(bin_chunk, sizeof(bin_chunk), 1, out) == 1 &&
+              fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    close_output(out);
+    if (!ok)
+        throw IOException("Failed to write file: " + filename_);
 }
 
-void SurfaceMeshIO::write_stl(const SurfaceMesh& mesh)
+void SurfaceMeshIO::read_streaming(SurfaceMesh& mesh)
 {
-    if (!mesh.is_triangle_mesh())
+    FILE* in = open_input("rb");
+    if (!in)
+        throw IOException("Failed to open file: " + filename_);
+
+    std::vector<Point> points;
+    std::vector<IndexType> indices;
+    std::vector<IndexType> face_sizes;
+    try
     {
-        auto what = "SurfaceMeshIO::write_stl: Not a triangle mesh.";
-        throw InvalidInputException(what);
+        StreamingMeshReader reader(in);
+        size_t i = 0;
+        for (auto event = reader.next();
+             event != StreamingMeshReader::Event::End; event = reader.next())
+        {
+            if (event == StreamingMeshReader::Event::Vertex)
+                points.push_back(reader.position(reader.vertex()));
+            else if (event == StreamingMeshReader::Event::Face)
+            {
+                indices.insert(indices.end(), reader.face().begin(),
+                               reader.face().end());
+                face_sizes.push_back(IndexType(reader.face().size()));
+            }
+            if (++i % 4096 == 0 && !report_progress(size_t(ftell(in))))
+                break;
+        }
     }
-
-    auto fnormals = mesh.get_face_property<Normal>("f:normal");
-    if (!fnormals)
+    catch (...)
     {
-        auto what = "SurfaceMeshIO::write_stl: No face normals present.";
-        throw InvalidInputException(what);
+        fclose(in);
+        throw;
     }
+    fclose(in);
+    check_cancelled();
 
-    std::ofstream ofs(filename_.c_str());
-    auto points = mesh.get_vertex_property<Point>("v:point");
+    add_indexed_faces(mesh, points, indices, face_sizes);
+}
 
-    ofs << "solid stl" << std::endl;
-    Normal n;
-    Point p;
+void SurfaceMeshIO::write_streaming(const SurfaceMesh& mesh, bool binary)
+{
+    auto points = mesh.get_vertex_property<Point>("v:point");
 
+    // sort the faces along the longest extent of the mesh. the vertices are
+    // written before their first face and finalized after their last one,
+    // which keeps the stream narrow for elongated meshes like terrains.
+    BoundingBox bb;
+    for (auto v : mesh.vertices())
+        bb += points[v];
+    const Point extent = bb.max() - bb.min();
+    int axis = 0;
+    for (int i = 1; i < 3; ++i)
+        if (extent[i] > extent[axis])
+            axis = i;
+
+    std::vector<std::pair<Scalar, Face>> faces;
+    faces.reserve(mesh.n_faces());
     for (auto f : mesh.faces())
     {
-        n = fnormals[f];
-        ofs << "  facet normal ";
-        ofs << n[0] << " " << n[1] << " " << n[2] << std::endl;
-        ofs << "    outer loop" << std::endl;
+        Scalar c = 0;
         for (auto v : mesh.vertices(f))
+            c += points[v][axis];
+        faces.emplace_back(c / Scalar(mesh.valence(f)), f);
+    }
+    std::stable_sort(faces.begin(), faces.end(),
+                     [](const std::pair<Scalar, Face>& a,
+                        const std::pair<Scalar, Face>& b) {
+                         return a.first < b.first;
+                     });
+
+    // position of the last face of each vertex
+    std::vector<size_t> last_face(mesh.vertices_size(), 0);
+    for (size_t i = 0; i < faces.size(); ++i)
+        for (auto v : mesh.vertices(faces[i].second))
+            last_face[v.idx()] = i;
+
+    FILE* out = open_output("wb");
+    if (!out)
+        throw IOException("Failed to open file: " + filename_);
+    try
+    {
+        StreamingMeshWriter writer(out, binary);
+        std::vector<IndexType> output(mesh.vertices_size(), PMP_MAX_INDEX);
+        std::vector<IndexType> face;
+        for (size_t i = 0; i < faces.size(); ++i)
         {
-            p = points[v];
-            ofs << "      vertex ";
-            ofs << p[0] << " " << p[1] << " " << p[2] << std::endl;
+            face.clear();
+            for (auto v : mesh.vertices(faces[i].second))
+            {
+                if (output[v.idx()] == PMP_MAX_INDEX)
+                    output[v.idx()] = writer.add_vertex(points[v]);
+                face.push_back(output[v.idx()]);
+            }
+            writer.add_face(face);
+            for (auto v : mesh.vertices(faces[i].second))
+                if (last_face[v.idx()] == i)
+                    writer.finalize(output[v.idx()]);
         }
-        ofs << "    endloop" << std::endl;
-        ofs << "  endfacet" << std::endl;
+
+        // isolated vertices
+        for (auto v : mesh.vertices())
+            if (output[v.idx()] == PMP_MAX_INDEX)
+                writer.finalize(writer.add_vertex(points[v]));
+        writer.close();
+    }
+    catch (...)
+    {
+        fclose(out);
+        throw;
     }
-    ofs << "endsolid" << std::endl;
-    ofs.close();
+    close_output(out);
 }
 
-void SurfaceMeshIO::write_xyz(const SurfaceMesh& mesh)
+namespace {
+
+void probe_off(const MappedFile& file, MeshFileInfo& info)
 {
-    std::ofstream ofs(filename_);
-    if (!ofs)
-        throw IOException("Failed to open file: " + filename_);
+    const char* p = file.data();
+    const char* end = file.end();
+    const char* eol = p ? static_cast<const char*>(
+                              memchr(p, '\n', size_t(end - p)))
+                        : nullptr;
+    if (!eol)
+        throw IOException("Failed to parse OFF header");
 
-    auto vnormal = mesh.get_vertex_property<Normal>("v:normal");
-    for (auto v : mesh.vertices())
+    // header: [ST][C][N][4][n]OFF BINARY
+    if (eol - p >= 2 && p[0] == 'S' && p[1] == 'T')
+    {
+        info.has_vertex_texcoords = true;
+        p += 2;
+    }
+    if (p < eol && *p == 'C')
+    {
+        info.has_vertex_colors = true;
+        ++p;
+    }
+    if (p < eol && *p == 'N')
+    {
+        info.has_vertex_normals = true;
+        ++p;
+    }
+    if (eol - p < 3 || strncmp(p, "OFF", 3) != 0)
+        throw IOException("Failed to parse OFF header");
+    info.is_binary = eol - p >= 10 && strncmp(p + 4, "BINARY", 6) == 0;
+
+    // #vertices, #faces
+    p = eol + 1;
+    if (info.is_binary)
+    {
+        if (end - p < 2 * ptrdiff_t(sizeof(IndexType)))
+            throw IOException("Failed to parse OFF header");
+        IndexType n[2];
+        memcpy(n, p, sizeof(n));
+        info.n_vertices = n[0];
+        info.n_faces = n[1];
+        return;
+    }
+    std::string counts;
+    while (p < end && counts.empty())
+    {
+        eol = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        if (!eol)
+            eol = end;
+        skip_blanks(p, eol);
+        if (p < eol && *p != '#')
+            counts.assign(p, eol);
+        p = eol + 1;
+    }
+    unsigned long nv, nf;
+    if (sscanf(counts.c_str(), "%lu %lu", &nv, &nf) != 2)
+        throw IOException("Failed to parse OFF header");
+    info.n_vertices = nv;
+    info.n_faces = nf;
+}
+
+void probe_obj(const MappedFile& file, MeshFileInfo& info)
+{
+    static const char* const keywords[] = {"v", "vn", "vt", "f"};
+    size_t counts[4];
+    count_keywords_parallel(file.data(), file.end(), keywords, 4, counts);
+    info.n_vertices = counts[0];
+    info.has_vertex_normals = counts[1] > 0;
+    info.has_halfedge_texcoords = counts[2] > 0;
+    info.n_faces = counts[3];
+}
+
+void probe_stl(const MappedFile& file, MeshFileInfo& info)
+{
+    uint32_t n_triangles;
+    info.is_binary = is_binary_stl(file, n_triangles);
+    if (info.is_binary)
+    {
+        info.n_faces = n_triangles;
+    }
+    else
+    {
+        size_t counts[2];
+        count_keywords_parallel(file.data(), file.end(), stl_vertex_keywords,
+                                2, counts);
+        info.n_faces = (counts[0] + counts[1]) / 3;
+    }
+
+    // corners are welded when reading
+    info.n_vertices = 3 * info.n_faces;
+    info.exact_vertex_count = false;
+    info.has_face_normals = true;
+}
+
+void probe_ply(const MappedFile& file, MeshFileInfo& info)
+{
+    std::vector<PlyElement> elements;
+    bool binary_le;
+    const char* header_end =
+        parse_ply_header(file.data(), file.end(), elements, binary_le);
+    if (!header_end)
+        throw IOException("Failed to read PLY header");
+
+    // binary little- or big-endian
+    const std::string binary = "format binary";
+    info.is_binary = std::search(file.data(), header_end, binary.begin(),
+                                 binary.end()) != header_end;
+
+    for (const auto& e : elements)
     {
-        ofs << mesh.position(v);
-        ofs << " ";
-        if (vnormal)
+        if (e.name == "vertex")
+        {
+            info.n_vertices = e.count;
+            info.has_vertex_normals = e.find("nx") != nullptr;
+            info.has_vertex_colors =
+                e.find("red") != nullptr || e.find("r") != nullptr;
+            info.has_vertex_texcoords = e.find("u") != nullptr ||
+                                        e.find("s") != nullptr ||
+                                        e.find("texture_u") != nullptr;
+        }
+        else if (e.name == "face")
         {
-            ofs << vnormal[v];
+            info.n_faces = e.count;
+            info.has_face_normals = e.find("nx") != nullptr;
+            info.has_face_colors =
+                e.find("red") != nullptr || e.find("r") != nullptr;
         }
-        ofs << std::endl;
+    }
+}
+
+void probe_pmp(const MappedFile& file, MeshFileInfo& info)
+{
+    info.is_binary = true;
+
+    // files of version 1 start with the element counts
+    if (file.size() < sizeof(pmp_magic) ||
+        memcmp(file.data(), pmp_magic, sizeof(pmp_magic)) != 0)
+    {
+        uint32_t n[3]; // vertices, edges, faces
+        if (file.size() < sizeof(n) + 1)
+            throw IOException("Truncated PMP file");
+        memcpy(n, file.data(), sizeof(n));
+        info.n_vertices = n[0];
+        info.n_faces = n[2];
+        info.has_halfedge_texcoords = file.data()[sizeof(n)] != 0;
+        return;
     }
 
-    ofs.close();
+    PmpHeader header;
+    if (file.size() < sizeof(header))
+        throw IOException("Truncated PMP file");
+    memcpy(&header, file.data(), sizeof(header));
+    info.n_vertices = size_t(header.n_elements[1]);
+    info.n_faces = size_t(header.n_elements[4]);
+
+    const char* table = file.data() + sizeof(header);
+    for (uint32_t i = 0; i < header.n_sections; ++i)
+    {
+        PmpSection s;
+        if (size_t(table - file.data()) + (i + 1) * sizeof(s) > file.size())
+            throw IOException("Truncated PMP file");
+        memcpy(&s, table + i * sizeof(s), sizeof(s));
+        if (s.name_offset + s.name_length > file.size())
+            throw IOException("Truncated PMP file");
+
+        const std::string name(file.data() + s.name_offset, s.name_length);
+        if (name == "v:normal")
+            info.has_vertex_normals = true;
+        else if (name == "v:color")
+            info.has_vertex_colors = true;
+        else if (name == "v:tex")
+            info.has_vertex_texcoords = true;
+        else if (name == "f:normal")
+            info.has_face_normals = true;
+        else if (name == "f:color")
+            info.has_face_colors = true;
+        else if (name == "h:tex")
+            info.has_halfedge_texcoords = true;
+    }
 }
 
-Face SurfaceMeshIO::add_face(SurfaceMesh& mesh,
-                             const std::vector<Vertex>& vertices)
+void probe_pmc(const MappedFile& file, MeshFileInfo& info)
 {
-    Face f;
-    try
+    if (file.size() < 20 ||
+        memcmp(file.data(), pmc_magic, sizeof(pmc_magic)) != 0)
+        throw IOException("Corrupt PMC data");
+    const char* p = file.data() + 12;
+    info.n_vertices = pmc_get<uint32_t>(p);
+    info.n_faces = pmc_get<uint32_t>(p);
+    info.has_vertex_normals = file.data()[6] & pmc_normals;
+    info.has_vertex_texcoords = file.data()[6] & pmc_texcoords;
+    info.is_binary = true;
+}
+
+void probe_points(const MappedFile& file, MeshFileInfo& info)
+{
+    auto bounds = split_lines(file.data(), file.end(), size_t(1) << 22);
+    const int n_chunks = int(bounds.size()) - 1;
+    info.n_vertices = parallel_reduce(
+        0, n_chunks, size_t(0),
+        [&](int i) { return count_data_lines(bounds[i], bounds[i + 1]); },
+        [](size_t a, size_t b) { return a + b; }, 1);
+}
+
+} // namespace
+
+MeshFileInfo SurfaceMeshIO::probe(const std::string& filename)
+{
+    SurfaceMeshIO io(filename, IOFlags());
+    const std::string ext = io.format_extension();
+    io.decompress_input();
+    const auto file = io.map_input();
+
+    MeshFileInfo info;
+    if (ext == "off")
+        probe_off(*file, info);
+    else if (ext == "obj")
+        probe_obj(*file, info);
+    else if (ext == "stl")
+        probe_stl(*file, info);
+    else if (ext == "ply")
+        probe_ply(*file, info);
+    else if (ext == "pmp")
+        probe_pmp(*file, info);
+    else if (ext == "pmc")
+        probe_pmc(*file, info);
+    else if (ext == "sma" || ext == "smb")
     {
-        f = mesh.add_face(vertices);
+        // the counts are known only after reading the whole stream
+        FILE* in = io.open_input("rb");
+        if (!in)
+            throw IOException("Failed to open file: " + filename);
+        try
+        {
+            StreamingMeshReader reader(in);
+            while (reader.next() != StreamingMeshReader::Event::End)
+                ;
+            info.n_vertices = reader.n_vertices();
+            info.n_faces = reader.n_faces();
+        }
+        catch (...)
+        {
+            fclose(in);
+            throw;
+        }
+        fclose(in);
+        info.is_binary = ext == "smb";
     }
-    catch (const TopologyException&)
+    else if (ext == "xyz")
     {
-        failed_faces_.push_back(vertices);
+        probe_points(*file, info);
+        // normals are stored after the position of each point
+        const char* eol = file->size() ? static_cast<const char*>(memchr(
+                                             file->data(), '\n', file->size()))
+                                       : nullptr;
+        std::string first(file->data(), eol ? eol : file->end());
+        float x[6];
+        info.has_vertex_normals =
+            sscanf(first.c_str(), "%f %f %f %f %f %f", &x[0], &x[1], &x[2],
+                   &x[3], &x[4], &x[5]) == 6;
     }
-    return f;
+    else if (ext == "agi")
+    {
+        probe_points(*file, info);
+        info.has_vertex_normals = true;
+        info.has_vertex_colors = true;
+    }
+    else if (ext == "pts")
+    {
+        // an optional first line holds the number of points
+        probe_points(*file, info);
+        double values[9];
+        const char* p = file->data();
+        size_t n = parse_first_values(p, file->end(), values, 9);
+        if (n == 1)
+        {
+            --info.n_vertices;
+            p = std::min(end_of_line(p, file->end()) + 1, file->end());
+            n = parse_first_values(p, file->end(), values, 9);
+        }
+        info.has_vertex_colors = n == 6 || n == 7;
+    }
+    else
+        throw IOException("Could not find reader for " + filename);
+    return info;
 }
 
-void SurfaceMeshIO::add_failed_faces(SurfaceMesh& mesh)
+std::vector<Face> SurfaceMeshIO::add_failed_faces(SurfaceMesh& mesh)
 {
+    std::vector<Face> faces;
+    faces.reserve(failed_faces_.size());
     for (auto vertices : failed_faces_)
     {
+        // the duplicates are appended, make their input points explicit
+        for (size_t i = vertex_origin_.size(); i < mesh.vertices_size(); ++i)
+            vertex_origin_.push_back(IndexType(i));
+        for (auto v : vertices)
+            vertex_origin_.push_back(input_vertex(v));
+
         auto duplicates = duplicate_vertices(mesh, vertices);
-        mesh.add_face(duplicates);
+        faces.push_back(mesh.add_face(duplicates));
     }
     failed_faces_.clear();
+    return faces;
 }
 
 std::vector<Vertex> SurfaceMeshIO::duplicate_vertices(
@@ -4,51 +4,326 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdio>
+#include <future>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "pmp/Types.h"
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
 
+class MappedFile;
+
+//! \brief Element counts and attributes of a mesh file.
+//! \sa SurfaceMeshIO::probe()
+struct MeshFileInfo
+{
+    MeshFileInfo() {}
+    size_t n_vertices = 0; //!< number of vertices
+    size_t n_faces = 0;    //!< number of faces
+
+    //! \brief Whether n_vertices is exact.
+    //! \details STL files store the corners of each triangle, which are
+    //! welded into vertices when reading. n_vertices is an upper bound then.
+    bool exact_vertex_count = true;
+
+    bool is_binary = false;              //!< binary file format
+    bool has_vertex_normals = false;     //!< file stores vertex normals
+    bool has_vertex_colors = false;      //!< file stores vertex colors
+    bool has_vertex_texcoords = false;   //!< file stores vertex texcoords
+    bool has_face_normals = false;       //!< file stores face normals
+    bool has_face_colors = false;        //!< file stores face colors
+    bool has_halfedge_texcoords = false; //!< file stores halfedge texcoords
+};
+
+//! \brief Faces of a mesh as indices into its vertices.
+//! \sa SurfaceMeshIO::read(SurfaceMesh&, IndexedFaces&)
+struct IndexedFaces
+{
+    //! vertex indices of all faces one after another
+    std::vector<IndexType> indices;
+
+    //! number of vertices of each face, empty if all faces are triangles
+    std::vector<IndexType> face_sizes;
+
+    //! number of faces
+    size_t size() const
+    {
+        return face_sizes.empty() ? indices.size() / 3 : face_sizes.size();
+    }
+
+    //! whether there are no faces
+    bool empty() const { return indices.empty(); }
+};
+
+//! \brief How the properties of welded vertices are combined.
+//! \sa SurfaceMeshIO::weld_vertices()
+enum class WeldPolicy
+{
+    //! keep the values of the vertex with the smallest index
+    First,
+
+    //! \brief Average the values of all welded vertices.
+    //! \details Applies to properties of type float, double, and their
+    //! 2D, 3D, and 4D vectors, e.g., positions, normals, and colors. Other
+    //! properties keep the values of the first vertex.
+    Average
+};
+
 class SurfaceMeshIO
 {
 public:
     SurfaceMeshIO(const std::string& filename, const IOFlags& flags)
-        : filename_(filename), flags_(flags)
+        : filename_(filename),
+          flags_(flags),
+          input_size_(0),
+          cancelled_(false),
+          output_compression_(Compression::None),
+          output_buffer_(nullptr),
+          output_size_(0),
+          memory_output_(nullptr),
+          deferred_faces_(nullptr)
     {
     }
 
+    ~SurfaceMeshIO();
+
+    SurfaceMeshIO(const SurfaceMeshIO&) = delete;
+    SurfaceMeshIO& operator=(const SurfaceMeshIO&) = delete;
+
+    //! \brief Read the file into \p mesh.
+    //! \throw IOException if reading fails.
+    //! \throw CancelledException if IOFlags::progress cancels reading.
     void read(SurfaceMesh& mesh);
 
+    //! \brief Read the vertices of the file into \p mesh and its faces into
+    //! \p faces without building the halfedge connectivity.
+    //! \details Meant for viewing large files. The readers building indexed
+    //! face sets, i.e., OFF, OBJ, STL, binary PLY, SMA, and SMB, leave the
+    //! vertices of \p mesh isolated. Other formats and OBJ files with texture
+    //! coordinates are read completely, \p faces is empty then.
+    //! \throw IOException if reading fails.
+    //! \throw CancelledException if IOFlags::progress cancels reading.
+    //! \sa add_faces()
+    void read(SurfaceMesh& mesh, IndexedFaces& faces);
+
     void write(const SurfaceMesh& mesh);
 
+    //! \brief Build the connectivity of the vertices in \p mesh from \p faces
+    //! read by read(SurfaceMesh&, IndexedFaces&).
+    //! \details Non-manifold vertices and edges are split as when reading.
+    //! The vertex normals, colors, and texture coordinates are kept.
+    //! \pre \p mesh has no deleted vertices and no faces.
+    //! If \p vertex_origin is given, it receives for each vertex the index
+    //! of the vertex of \p mesh it was split from, or its own index.
+    static void add_faces(SurfaceMesh& mesh, const IndexedFaces& faces,
+                          std::vector<IndexType>* vertex_origin = nullptr);
+
+    //! \brief Merge coincident vertices of \p mesh and rebuild its
+    //! connectivity.
+    //! \details Merges vertices whose coordinates differ by at most
+    //! \p tolerance, or identical ones if \p tolerance is zero. Vertices are
+    //! merged transitively, such that chains of close vertices become one
+    //! vertex. They are found by hashing the vertices into a grid with
+    //! cells of size \p tolerance in parallel. The faces are rebuilt at
+    //! once as by add_faces(), splitting vertices and edges that become
+    //! non-manifold. Faces with repeated vertices after merging are
+    //! removed. The vertex properties are combined according to \p policy,
+    //! the halfedge and face properties of the remaining faces are kept,
+    //! and merged edges keep the properties of one of them. Deleted
+    //! elements are removed before.
+    //! \return The number of removed vertices.
+    //! \note Invalidates all handles to mesh elements if vertices are
+    //! merged.
+    static size_t weld_vertices(SurfaceMesh& mesh, Scalar tolerance = 0,
+                                WeldPolicy policy = WeldPolicy::First);
+
+    //! \brief Read \p filename in a background thread.
+    //! \details IOFlags::progress is called from the background thread and
+    //! can cancel reading.
+    //! \return The mesh being read. Its get() rethrows the exceptions of
+    //! read().
+    static std::future<SurfaceMesh> read_async(
+        const std::string& filename, const IOFlags& flags = IOFlags());
+
+    //! \brief Read \p mesh from \p size bytes of \p data in memory.
+    //! \details \p format is the file extension of the data, e.g., "obj"
+    //! or "ply". Gzip and zstd compressed data is detected from its first
+    //! bytes. All formats supported by SurfaceMesh::read() can be read.
+    //! \throw IOException if reading fails.
+    //! \throw CancelledException if IOFlags::progress cancels reading.
+    static void read(const char* data, size_t size, const std::string& format,
+                     SurfaceMesh& mesh, const IOFlags& flags = IOFlags());
+
+    //! \brief Read \p mesh from the remaining data of the stream \p in.
+    //! \details The stream is read to its end first and parsed like data in
+    //! memory.
+    //! \throw IOException if reading the stream or the mesh fails.
+    static void read(std::istream& in, const std::string& format,
+                     SurfaceMesh& mesh, const IOFlags& flags = IOFlags());
+
+    //! \brief Write \p mesh into memory.
+    //! \details \p format is the file extension of the data, e.g., "obj" or
+    //! "ply.gz". IOFlags::compression applies as when writing files. All
+    //! formats supported by SurfaceMesh::write() can be written.
+    //! \return The contents of the file.
+    //! \throw IOException if writing fails.
+    static std::vector<char> write(const SurfaceMesh& mesh,
+                                   const std::string& format,
+                                   const IOFlags& flags = IOFlags());
+
+    //! \brief Write \p mesh to the stream \p out.
+    //! \details The data is written into memory first, \p format and
+    //! \p flags are used as when writing into memory.
+    //! \throw IOException if writing the mesh or the stream fails.
+    static void write(const SurfaceMesh& mesh, std::ostream& out,
+                      const std::string& format,
+                      const IOFlags& flags = IOFlags());
+
+    //! \brief Element counts and attributes of the mesh in \p filename.
+    //! \details Reads only the header of formats storing the counts, i.e.,
+    //! OFF, PLY, PMP, PMC, and binary STL. The others are scanned without
+    //! parsing the data, except for streaming meshes, which are read
+    //! completely. Compressed files are decompressed in memory.
+    //! \throw IOException if the file cannot be opened or has an unknown
+    //! format.
+    static MeshFileInfo probe(const std::string& filename);
+
+    //! \brief Compress \p mesh into the PMC transport format.
+    //! \details Codes the connectivity of triangle meshes by a traversal
+    //! similar to Edgebreaker, using about two bits per triangle. General
+    //! polygon meshes store the vertex indices of each face. Positions and,
+    //! if enabled in \p flags, vertex normals and texture coordinates are
+    //! quantized, predicted from their neighbors, and entropy coded.
+    //! Vertices and faces are reordered.
+    //! \throw InvalidInputException if IOFlags::quantization_bits is not in
+    //! [1, 24].
+    static std::vector<char> encode(const SurfaceMesh& mesh,
+                                    const IOFlags& flags = IOFlags());
+
+    //! \brief Decompress \p mesh from \p size bytes of PMC data.
+    //! \throw IOException if the data is corrupt.
+    static void decode(const char* data, size_t size, SurfaceMesh& mesh);
+
 private:
+    //! \brief File extension determining the format.
+    //! \details Ignores the extension of compressed files, e.g., ".gz".
+    std::string format_extension() const;
+
+    //! Read \p mesh from \p data, taking over the buffer.
+    static void read_memory(std::vector<char> data, const std::string& format,
+                            SurfaceMesh& mesh, const IOFlags& flags);
+
+    //! \brief Decompress compressed input files into memory.
+    //! \details Uses the data given to read() in memory instead of the file
+    //! if there is any.
+    void decompress_input();
+
+    //! \brief Open the file for reading.
+    //! \details Reads decompressed data from memory for compressed files.
+    //! \throw IOException if the file cannot be opened.
+    FILE* open_input(const char* mode);
+
+    //! \brief Map the contents of the file for reading.
+    //! \details Returns the decompressed data for compressed files.
+    std::shared_ptr<MappedFile> map_input(bool copy_on_write = false);
+
+    //! \brief Report \p bytes of the input consumed to IOFlags::progress.
+    //! \details May be called from any thread, the callback is invoked only
+    //! in the thread calling read().
+    //! \return false if reading is cancelled.
+    bool report_progress(size_t bytes);
+
+    //! \throw CancelledException if reading is cancelled.
+    void check_cancelled() const;
+
+    //! \brief Open the file for writing.
+    //! \details Writes to memory if the output is compressed.
+    //! \throw IOException if the file cannot be opened.
+    FILE* open_output(const char* mode);
+
+    //! \brief Close \p out and compress the data written to it if needed.
+    void close_output(FILE* out);
+
     void read_off(SurfaceMesh& mesh);
     void read_obj(SurfaceMesh& mesh);
     void read_stl(SurfaceMesh& mesh);
     void read_ply(SurfaceMesh& mesh);
+
+    //! \brief Read binary little-endian PLY files with the standard vertex
+    //! and face layout directly from memory.
+    //! \return false if the file has a different format or layout.
+    bool read_ply_binary(SurfaceMesh& mesh);
+
     void read_pmp(SurfaceMesh& mesh);
-    void read_xyz(SurfaceMesh& mesh);
-    void read_agi(SurfaceMesh& mesh);
+    void read_pmp_v1(SurfaceMesh& mesh);
+
+    //! \brief Read the ASCII point clouds XYZ, AGI, and PTS.
+    //! \details Parses the memory-mapped file in parallel chunks, writing
+    //! directly into the vertex properties allocated at once.
+    void read_points(SurfaceMesh& mesh);
+
+    void read_pmc(SurfaceMesh& mesh);
+    void read_streaming(SurfaceMesh& mesh);
 
     void write_off(const SurfaceMesh& mesh);
     void write_off_binary(const SurfaceMesh& mesh);
     void write_obj(const SurfaceMesh& mesh);
     void write_stl(const SurfaceMesh& mesh);
     void write_ply(const SurfaceMesh& mesh);
+    void write_ply_binary(const SurfaceMesh& mesh);
     void write_pmp(const SurfaceMesh& mesh);
     void write_xyz(const SurfaceMesh& mesh);
+    void write_pmc(const SurfaceMesh& mesh);
+    void write_glb(const SurfaceMesh& mesh);
+
+    //! \brief Write a streaming mesh, see StreamingMeshWriter.
+    //! \details Faces are sorted along the longest axis of the bounding box,
+    //! vertices are written before their first and finalized after their
+    //! last face.
+    void write_streaming(const SurfaceMesh& mesh, bool binary);
 
     //! \brief Wrapper around add_face() to catch any topology errors.
     //! \details Failed faces are stored so they can be added later.
     //! \return A valid Face *if* it could be added, invalid Face otherwise.
     Face add_face(SurfaceMesh& mesh, const std::vector<Vertex>& vertices);
 
+    //! \brief Build the mesh from an indexed face set.
+    //! \details Uses SurfaceMesh::from_indexed_faces(). If the faces do not
+    //! form a manifold mesh, non-manifold vertices and edges are split in a
+    //! single pass first, duplicating vertices. Only if that fails, faces
+    //! are added one by one using add_face(). When reading deferred faces,
+    //! only the vertices are added and the faces are stored.
+    //! \return The face created for each input face, invalid for failed or
+    //! deferred faces.
+    std::vector<Face> add_indexed_faces(
+        SurfaceMesh& mesh, const std::vector<Point>& points,
+        const std::vector<IndexType>& indices,
+        const std::vector<IndexType>& face_sizes);
+
+    //! \brief Index of the input point of vertex \p v after
+    //! add_indexed_faces(), which differs for duplicated vertices.
+    IndexType input_vertex(Vertex v) const;
+
+    //! \brief Add the vertex property \p name holding the \p values of the
+    //! input points, including duplicated vertices.
+    template <class T>
+    void set_vertex_values(SurfaceMesh& mesh, const std::string& name,
+                           const std::vector<T>& values) const;
+
     //! \brief Add failed faces after duplicating their vertices.
+    //! \details The duplicates have the same input point as the vertices
+    //! they are copied from, see input_vertex().
     //! \pre failed_faces_ contains only valid vertex indices.
     //! \post failed faces are added to the mesh and the vector is cleared.
-    void add_failed_faces(SurfaceMesh& mesh);
+    //! \return The added faces in the order of failed_faces_.
+    std::vector<Face> add_failed_faces(SurfaceMesh& mesh);
 
     //! \brief Duplicate the given set of vertices by adding their points to the mesh again.
     //! \pre All input vertices are valid and already added to the mesh.
@@ -66,6 +341,30 @@ private:
     std::string filename_;
     IOFlags flags_;
     std::vector<std::vector<Vertex>> failed_faces_;
+
+    // input point of each vertex if add_indexed_faces() duplicated vertices
+    std::vector<IndexType> vertex_origin_;
+
+    // decompressed contents of compressed input files
+    std::shared_ptr<MappedFile> input_;
+
+    // progress of reading
+    size_t input_size_;
+    std::thread::id reader_thread_;
+    std::atomic<bool> cancelled_;
+
+    // compression of the output and the uncompressed data written so far
+    Compression output_compression_;
+    char* output_buffer_;
+    size_t output_size_;
+
+    // input and output data when reading or writing memory instead of files
+    std::shared_ptr<MappedFile> memory_input_;
+    std::vector<char>* memory_output_;
+
+    // destination of the faces if add_indexed_faces() is to skip building
+    // the connectivity
+    IndexedFaces* deferred_faces_;
 };
 
 } // namespace pmp
@@ -0,0 +1,156 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/TriangleMesh.h"
+
+namespace pmp {
+
+TriangleMesh::TriangleMesh() : n_boundary_(0)
+{
+    init_properties();
+}
+
+TriangleMesh::TriangleMesh(const SurfaceMesh& mesh) : TriangleMesh()
+{
+    if (!mesh.is_triangle_mesh())
+    {
+        auto what = "TriangleMesh: Input is not a pure triangle mesh.";
+        throw InvalidInputException(what);
+    }
+
+    // compact vertex indices
+    std::vector<IndexType> vmap(mesh.vertices_size(), PMP_MAX_INDEX);
+    IndexType nv = 0;
+    for (auto v : mesh.vertices())
+        vmap[v.idx()] = nv++;
+
+    // halfedge 3f+i is the i-th halfedge of face f
+    std::vector<IndexType> hmap(mesh.halfedges_size(), PMP_MAX_INDEX);
+    IndexType nf = 0;
+    for (auto f : mesh.faces())
+    {
+        IndexType c = 3 * nf++;
+        for (auto h : mesh.halfedges(f))
+            hmap[h.idx()] = c++;
+    }
+
+    vprops_.resize(nv);
+    hprops_.resize(3 * nf);
+    fprops_.resize(nf);
+
+    for (auto v : mesh.vertices())
+        vpoint_[Vertex(vmap[v.idx()])] = mesh.position(v);
+
+    for (auto f : mesh.faces())
+    {
+        for (auto h : mesh.halfedges(f))
+        {
+            Halfedge c(hmap[h.idx()]);
+            hvertex_[c] = Vertex(vmap[mesh.from_vertex(h).idx()]);
+
+            Halfedge o = mesh.opposite_halfedge(h);
+            if (mesh.is_boundary(o))
+                ++n_boundary_;
+            else
+                hopposite_[c] = Halfedge(hmap[o.idx()]);
+        }
+    }
+
+    for (auto v : mesh.vertices())
+    {
+        Halfedge h = mesh.halfedge(v);
+        if (!h.is_valid())
+            continue;
+
+        // boundary vertices start at the outgoing halfedge whose opposite is
+        // the incoming boundary halfedge
+        if (mesh.is_boundary(h))
+            h = mesh.opposite_halfedge(mesh.prev_halfedge(h));
+
+        vhalfedge_[Vertex(vmap[v.idx()])] = Halfedge(hmap[h.idx()]);
+    }
+}
+
+TriangleMesh::TriangleMesh(const TriangleMesh& rhs)
+    : vprops_(rhs.vprops_),
+      hprops_(rhs.hprops_),
+      fprops_(rhs.fprops_),
+      n_boundary_(rhs.n_boundary_)
+{
+    get_properties();
+}
+
+TriangleMesh& TriangleMesh::operator=(const TriangleMesh& rhs)
+{
+    if (this != &rhs)
+    {
+        vprops_ = rhs.vprops_;
+        hprops_ = rhs.hprops_;
+        fprops_ = rhs.fprops_;
+        n_boundary_ = rhs.n_boundary_;
+        get_properties();
+    }
+    return *this;
+}
+
+SurfaceMesh TriangleMesh::to_surface_mesh() const
+{
+    std::vector<Point> points(n_vertices());
+    for (auto v : vertices())
+        points[v.idx()] = position(v);
+
+    std::vector<IndexType> indices(n_halfedges());
+    for (auto h : halfedges())
+        indices[h.idx()] = from_vertex(h).idx();
+
+    SurfaceMesh mesh;
+    mesh.from_indexed_faces(points, indices);
+    return mesh;
+}
+
+void TriangleMesh::clear()
+{
+    vprops_.clear();
+    hprops_.clear();
+    fprops_.clear();
+    n_boundary_ = 0;
+    init_properties();
+}
+
+size_t TriangleMesh::valence(Vertex v) const
+{
+    size_t count = 0;
+    for (auto vv : vertices(v))
+    {
+        (void)vv;
+        ++count;
+    }
+    return count;
+}
+
+size_t TriangleMesh::memory_bytes() const
+{
+    size_t bytes = 0;
+    for (const auto* props : {&vprops_, &hprops_, &fprops_})
+        for (const auto& m : props->memory_usage())
+            bytes += m.total_bytes();
+    return bytes;
+}
+
+void TriangleMesh::init_properties()
+{
+    vpoint_ = add_vertex_property<Point>("v:point");
+    vhalfedge_ = add_vertex_property<Halfedge>("v:halfedge");
+    hvertex_ = add_halfedge_property<Vertex>("h:vertex");
+    hopposite_ = add_halfedge_property<Halfedge>("h:opposite");
+}
+
+void TriangleMesh::get_properties()
+{
+    vpoint_ = get_vertex_property<Point>("v:point");
+    vhalfedge_ = get_vertex_property<Halfedge>("v:halfedge");
+    hvertex_ = get_halfedge_property<Vertex>("h:vertex");
+    hopposite_ = get_halfedge_property<Halfedge>("h:opposite");
+}
+
+} // namespace pmp
@@ -0,0 +1,513 @@
+// Copyright 2011-2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/Types.h"
+#include "pmp/Properties.h"
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A compact triangle mesh based on a corner table.
+//! \details Halfedges are not stored explicitly but indexed implicitly:
+//! halfedge 3f+i is the i-th halfedge of face f, it starts at the vertex of
+//! corner i and points to the vertex of corner (i+1)%3. Only the start
+//! vertex and the opposite halfedge are stored per halfedge, plus one
+//! outgoing halfedge per vertex, which needs about half the connectivity
+//! memory of SurfaceMesh. Boundary halfedges do not exist, a halfedge on
+//! the boundary has an invalid opposite halfedge.
+//!
+//! The mesh offers the same handles, property types, and circulators as
+//! SurfaceMesh for read-only traversals. Its connectivity is fixed after
+//! construction, use SurfaceMesh for topological modifications.
+//! \ingroup core
+class TriangleMesh
+{
+public:
+    //! \name Iterator and circulator types
+    //!@{
+
+    //! An iterator over the consecutive indices of vertices, halfedges, or
+    //! faces.
+    template <class HandleT>
+    class Iterator
+    {
+    public:
+        explicit Iterator(HandleT h = HandleT()) : handle_(h) {}
+        HandleT operator*() const { return handle_; }
+        bool operator==(const Iterator& rhs) const
+        {
+            return handle_ == rhs.handle_;
+        }
+        bool operator!=(const Iterator& rhs) const { return !operator==(rhs); }
+        Iterator& operator++()
+        {
+            handle_ = HandleT(handle_.idx() + 1);
+            return *this;
+        }
+
+    private:
+        HandleT handle_;
+    };
+
+    //! helper class for range-based for-loops over all elements
+    template <class HandleT>
+    class Container
+    {
+    public:
+        Container(Iterator<HandleT> begin, Iterator<HandleT> end)
+            : begin_(begin), end_(end)
+        {
+        }
+        Iterator<HandleT> begin() const { return begin_; }
+        Iterator<HandleT> end() const { return end_; }
+
+    private:
+        Iterator<HandleT> begin_, end_;
+    };
+
+    typedef Container<Vertex> VertexContainer;
+    typedef Container<Halfedge> HalfedgeContainer;
+    typedef Container<Face> FaceContainer;
+
+    //! \brief Circulates counter-clockwise over the elements around a vertex.
+    //! \details Visits all outgoing halfedges, their target vertices, or their
+    //! faces. For boundary vertices the vertex circulator additionally visits
+    //! the neighbor across the last boundary edge.
+    template <class HandleT>
+    class VertexCirculator
+    {
+    public:
+        VertexCirculator(const TriangleMesh* mesh = nullptr,
+                         Halfedge start = Halfedge())
+            : mesh_(mesh), start_(start), halfedge_(start), extra_(false)
+        {
+        }
+
+        HandleT operator*() const { return get(HandleT()); }
+
+        bool operator==(const VertexCirculator& rhs) const
+        {
+            return halfedge_ == rhs.halfedge_ && extra_ == rhs.extra_;
+        }
+        bool operator!=(const VertexCirculator& rhs) const
+        {
+            return !operator==(rhs);
+        }
+
+        VertexCirculator& operator++()
+        {
+            assert(mesh_);
+            if (extra_)
+            {
+                halfedge_ = Halfedge();
+                extra_ = false;
+                return *this;
+            }
+            Halfedge h = mesh_->ccw_rotated_halfedge(halfedge_);
+            if (!h.is_valid())
+            {
+                // reached the boundary, visit the last neighbor if needed
+                if (visits_extra(HandleT()))
+                    extra_ = true;
+                else
+                    halfedge_ = Halfedge();
+            }
+            else
+            {
+                halfedge_ = (h == start_) ? Halfedge() : h;
+            }
+            return *this;
+        }
+
+        VertexCirculator begin() const { return *this; }
+        VertexCirculator end() const { return VertexCirculator(mesh_); }
+
+    private:
+        Halfedge get(Halfedge) const { return halfedge_; }
+        Face get(Face) const { return mesh_->face(halfedge_); }
+        Vertex get(Vertex) const
+        {
+            return extra_ ? mesh_->from_vertex(mesh_->prev_halfedge(halfedge_))
+                          : mesh_->to_vertex(halfedge_);
+        }
+
+        static bool visits_extra(Halfedge) { return false; }
+        static bool visits_extra(Face) { return false; }
+        static bool visits_extra(Vertex) { return true; }
+
+        const TriangleMesh* mesh_;
+        Halfedge start_;
+        Halfedge halfedge_;
+        bool extra_;
+    };
+
+    typedef VertexCirculator<Vertex> VertexAroundVertexCirculator;
+    typedef VertexCirculator<Halfedge> HalfedgeAroundVertexCirculator;
+    typedef VertexCirculator<Face> FaceAroundVertexCirculator;
+
+    //! Iterates over the three vertices or halfedges of a face.
+    template <class HandleT>
+    class FaceCirculator
+    {
+    public:
+        FaceCirculator(const TriangleMesh* mesh = nullptr,
+                       IndexType corner = PMP_MAX_INDEX)
+            : mesh_(mesh), corner_(corner)
+        {
+        }
+
+        HandleT operator*() const { return get(HandleT()); }
+
+        bool operator==(const FaceCirculator& rhs) const
+        {
+            return corner_ == rhs.corner_;
+        }
+        bool operator!=(const FaceCirculator& rhs) const
+        {
+            return !operator==(rhs);
+        }
+
+        FaceCirculator& operator++()
+        {
+            ++corner_;
+            return *this;
+        }
+
+        FaceCirculator begin() const { return *this; }
+        FaceCirculator end() const
+        {
+            return FaceCirculator(mesh_, corner_ - corner_ % 3 + 3);
+        }
+
+    private:
+        Halfedge get(Halfedge) const { return Halfedge(corner_); }
+        Vertex get(Vertex) const
+        {
+            return mesh_->from_vertex(Halfedge(corner_));
+        }
+
+        const TriangleMesh* mesh_;
+        IndexType corner_;
+    };
+
+    typedef FaceCirculator<Vertex> VertexAroundFaceCirculator;
+    typedef FaceCirculator<Halfedge> HalfedgeAroundFaceCirculator;
+
+    //!@}
+    //! \name Construction
+    //!@{
+
+    //! default constructor, creates an empty mesh
+    TriangleMesh();
+
+    //! \brief Build the corner table of \p mesh, which has to be a triangle
+    //! mesh.
+    //! \details Copies the vertex positions, deleted elements are skipped.
+    //! \throw InvalidInputException if \p mesh has non-triangular faces.
+    explicit TriangleMesh(const SurfaceMesh& mesh);
+
+    //! copy constructor, performs a deep copy of all properties
+    TriangleMesh(const TriangleMesh& rhs);
+
+    //! assignment, performs a deep copy of all properties
+    TriangleMesh& operator=(const TriangleMesh& rhs);
+
+    //! convert back to a SurfaceMesh, copying vertex positions
+    SurfaceMesh to_surface_mesh() const;
+
+    //! remove all elements and properties
+    void clear();
+
+    //!@}
+    //! \name Sizes and iteration
+    //!@{
+
+    //! returns number of vertices in the mesh
+    size_t n_vertices() const { return vprops_.size(); }
+
+    //! returns number of halfedges in the mesh, three per face
+    size_t n_halfedges() const { return hprops_.size(); }
+
+    //! returns number of edges in the mesh
+    size_t n_edges() const { return (n_halfedges() + n_boundary_) / 2; }
+
+    //! returns number of faces in the mesh
+    size_t n_faces() const { return fprops_.size(); }
+
+    //! returns true iff the mesh is empty, i.e., has no vertices
+    bool is_empty() const { return n_vertices() == 0; }
+
+    //! range of all vertices
+    VertexContainer vertices() const
+    {
+        return VertexContainer(Iterator<Vertex>(Vertex(0)),
+                               Iterator<Vertex>(Vertex(n_vertices())));
+    }
+
+    //! range of all halfedges
+    HalfedgeContainer halfedges() const
+    {
+        return HalfedgeContainer(
+            Iterator<Halfedge>(Halfedge(0)),
+            Iterator<Halfedge>(Halfedge(n_halfedges())));
+    }
+
+    //! range of all faces
+    FaceContainer faces() const
+    {
+        return FaceContainer(Iterator<Face>(Face(0)),
+                             Iterator<Face>(Face(n_faces())));
+    }
+
+    //! circulate counter-clockwise over the neighbors of vertex \p v
+    VertexAroundVertexCirculator vertices(Vertex v) const
+    {
+        return VertexAroundVertexCirculator(this, halfedge(v));
+    }
+
+    //! circulate counter-clockwise over the outgoing halfedges of vertex \p v
+    HalfedgeAroundVertexCirculator halfedges(Vertex v) const
+    {
+        return HalfedgeAroundVertexCirculator(this, halfedge(v));
+    }
+
+    //! circulate counter-clockwise over the faces incident to vertex \p v
+    FaceAroundVertexCirculator faces(Vertex v) const
+    {
+        return FaceAroundVertexCirculator(this, halfedge(v));
+    }
+
+    //! iterate over the three vertices of face \p f
+    VertexAroundFaceCirculator vertices(Face f) const
+    {
+        return VertexAroundFaceCirculator(this, 3 * f.idx());
+    }
+
+    //! iterate over the three halfedges of face \p f
+    HalfedgeAroundFaceCirculator halfedges(Face f) const
+    {
+        return HalfedgeAroundFaceCirculator(this, 3 * f.idx());
+    }
+
+    //!@}
+    //! \name Connectivity
+    //!@{
+
+    //! \brief returns an outgoing halfedge of vertex \p v.
+    //! \details For boundary vertices this is the outgoing boundary halfedge,
+    //! invalid for isolated vertices.
+    Halfedge halfedge(Vertex v) const { return vhalfedge_[v]; }
+
+    //! returns the first halfedge of face \p f
+    Halfedge halfedge(Face f) const { return Halfedge(3 * f.idx()); }
+
+    //! returns the face of halfedge \p h
+    Face face(Halfedge h) const { return Face(h.idx() / 3); }
+
+    //! returns the vertex the halfedge \p h emanates from
+    Vertex from_vertex(Halfedge h) const { return hvertex_[h]; }
+
+    //! returns the vertex the halfedge \p h points to
+    Vertex to_vertex(Halfedge h) const { return hvertex_[next_halfedge(h)]; }
+
+    //! returns the next halfedge within the face of \p h
+    Halfedge next_halfedge(Halfedge h) const
+    {
+        return Halfedge(h.idx() % 3 == 2 ? h.idx() - 2 : h.idx() + 1);
+    }
+
+    //! returns the previous halfedge within the face of \p h
+    Halfedge prev_halfedge(Halfedge h) const
+    {
+        return Halfedge(h.idx() % 3 == 0 ? h.idx() + 2 : h.idx() - 1);
+    }
+
+    //! returns the opposite halfedge of \p h, invalid on the boundary
+    Halfedge opposite_halfedge(Halfedge h) const { return hopposite_[h]; }
+
+    //! \brief returns the halfedge rotated counter-clockwise around the start
+    //! vertex of \p h, invalid if the boundary is crossed.
+    Halfedge ccw_rotated_halfedge(Halfedge h) const
+    {
+        return opposite_halfedge(prev_halfedge(h));
+    }
+
+    //! \brief returns the halfedge rotated clockwise around the start vertex
+    //! of \p h, invalid if the boundary is crossed.
+    Halfedge cw_rotated_halfedge(Halfedge h) const
+    {
+        Halfedge o = opposite_halfedge(h);
+        return o.is_valid() ? next_halfedge(o) : o;
+    }
+
+    //! returns whether halfedge \p h lies on the boundary
+    bool is_boundary(Halfedge h) const
+    {
+        return !opposite_halfedge(h).is_valid();
+    }
+
+    //! returns whether \p v is a boundary vertex
+    bool is_boundary(Vertex v) const
+    {
+        Halfedge h = halfedge(v);
+        return h.is_valid() && is_boundary(h);
+    }
+
+    //! returns whether \p v is isolated, i.e., not incident to any face
+    bool is_isolated(Vertex v) const { return !halfedge(v).is_valid(); }
+
+    //! returns the valence (number of incident edges) of vertex \p v
+    size_t valence(Vertex v) const;
+
+    //!@}
+    //! \name Properties
+    //!@{
+
+    //! position of vertex \p v
+    const Point& position(Vertex v) const { return vpoint_[v]; }
+
+    //! position of vertex \p v
+    Point& position(Vertex v) { return vpoint_[v]; }
+
+    //! vector of vertex positions
+    std::vector<Point>& positions() { return vpoint_.vector(); }
+
+    //! add a vertex property of type \p T with name \p name and default
+    //! value \p t. returns an invalid property if the name exists already.
+    template <class T>
+    VertexProperty<T> add_vertex_property(const std::string& name,
+                                          const T t = T())
+    {
+        return VertexProperty<T>(vprops_.add<T>(name, t));
+    }
+
+    //! get the vertex property named \p name of type \p T. returns an
+    //! invalid property if it does not exist or if the type does not match.
+    template <class T>
+    VertexProperty<T> get_vertex_property(const std::string& name) const
+    {
+        return VertexProperty<T>(vprops_.get<T>(name));
+    }
+
+    //! get or add the vertex property named \p name of type \p T
+    template <class T>
+    VertexProperty<T> vertex_property(const std::string& name, const T t = T())
+    {
+        return VertexProperty<T>(vprops_.get_or_add<T>(name, t));
+    }
+
+    //! remove the vertex property \p p
+    template <class T>
+    void remove_vertex_property(VertexProperty<T>& p)
+    {
+        vprops_.remove(p);
+    }
+
+    //! does the mesh have a vertex property with name \p name?
+    bool has_vertex_property(const std::string& name) const
+    {
+        return vprops_.exists(name);
+    }
+
+    //! add a halfedge (corner) property of type \p T with name \p name
+    //! and default value \p t.
+    template <class T>
+    HalfedgeProperty<T> add_halfedge_property(const std::string& name,
+                                              const T t = T())
+    {
+        return HalfedgeProperty<T>(hprops_.add<T>(name, t));
+    }
+
+    //! get the halfedge property named \p name of type \p T
+    template <class T>
+    HalfedgeProperty<T> get_halfedge_property(const std::string& name) const
+    {
+        return HalfedgeProperty<T>(hprops_.get<T>(name));
+    }
+
+    //! get or add the halfedge property named \p name of type \p T
+    template <class T>
+    HalfedgeProperty<T> halfedge_property(const std::string& name,
+                                          const T t = T())
+    {
+        return HalfedgeProperty<T>(hprops_.get_or_add<T>(name, t));
+    }
+
+    //! remove the halfedge property \p p
+    template <class T>
+    void remove_halfedge_property(HalfedgeProperty<T>& p)
+    {
+        hprops_.remove(p);
+    }
+
+    //! does the mesh have a halfedge property with name \p name?
+    bool has_halfedge_property(const std::string& name) const
+    {
+        return hprops_.exists(name);
+    }
+
+    //! add a face property of type \p T with name \p name and default
+    //! value \p t.
+    template <class T>
+    FaceProperty<T> add_face_property(const std::string& name, const T t = T())
+    {
+        return FaceProperty<T>(fprops_.add<T>(name, t));
+    }
+
+    //! get the face property named \p name of type \p T
+    template <class T>
+    FaceProperty<T> get_face_property(const std::string& name) const
+    {
+        return FaceProperty<T>(fprops_.get<T>(name));
+    }
+
+    //! get or add the face property named \p name of type \p T
+    template <class T>
+    FaceProperty<T> face_property(const std::string& name, const T t = T())
+    {
+        return FaceProperty<T>(fprops_.get_or_add<T>(name, t));
+    }
+
+    //! remove the face property \p p
+    template <class T>
+    void remove_face_property(FaceProperty<T>& p)
+    {
+        fprops_.remove(p);
+    }
+
+    //! does the mesh have a face property with name \p name?
+    bool has_face_property(const std::string& name) const
+    {
+        return fprops_.exists(name);
+    }
+
+    //! total number of bytes owned by all properties of the mesh
+    size_t memory_bytes() const;
+
+    //!@}
+
+private:
+    // add the standard properties
+    void init_properties();
+
+    // re-acquire the handles of the standard properties after copying
+    void get_properties();
+
+    PropertyContainer vprops_;
+    PropertyContainer hprops_;
+    PropertyContainer fprops_;
+
+    VertexProperty<Point> vpoint_;
+    VertexProperty<Halfedge> vhalfedge_;
+    HalfedgeProperty<Vertex> hvertex_;
+    HalfedgeProperty<Halfedge> hopposite_;
+
+    // number of halfedges without opposite
+    size_t n_boundary_;
+};
+
+} // namespace pmp
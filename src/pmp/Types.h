@@ -5,6 +5,7 @@
 
 #include <cstdint>
 
+#include <functional>
 #include <stdexcept>
 
 #include "pmp/MatVec.h"
@@ -62,6 +63,22 @@ typedef std::uint_least32_t IndexType;
 #define PMP_MAX_INDEX UINT_LEAST32_MAX
 #endif
 
+//! Compression of mesh files
+enum class Compression
+{
+    Automatic, //!< choose by file extension, .gz or .zst
+    None,      //!< no compression
+    Gzip,      //!< gzip, requires zlib
+    Zstd       //!< Zstandard, requires libzstd
+};
+
+//! \brief Progress callback of long-running algorithms.
+//! \details Called at safe points with the completed fraction in [0,1].
+//! Return false to cancel, the algorithm then stops at the next safe point,
+//! leaves the mesh in a valid, partially processed state, and throws a
+//! CancelledException. Called from the thread running the algorithm.
+typedef std::function<bool(float fraction)> ProgressCallback;
+
 //! Common IO flags for reading and writing
 struct IOFlags
 {
@@ -73,6 +90,40 @@ struct IOFlags
     bool use_face_normals = false;       //!< read / write face normals
     bool use_face_colors = false;        //!< read / write face colors
     bool use_halfedge_texcoords = false; //!< read / write halfedge texcoords
+
+    //! max. coordinate difference of STL corners welded into one vertex
+    Scalar weld_tolerance = 0;
+
+    //! \brief Let properties read from PMP files use the mapped file.
+    //! \details Avoids copying the data. The file must not be modified as
+    //! long as the mesh uses it.
+    bool use_memory_mapping = false;
+
+    //! \brief Compression of written files.
+    //! \details Compressed files are always detected when reading.
+    Compression compression = Compression::Automatic;
+
+    //! compression level, 0 for the default of the compression library
+    int compression_level = 0;
+
+    //! bits per coordinate of quantized positions and texcoords in PMC files
+    int quantization_bits = 14;
+
+    //! \brief Store quantized vertex attributes in glTF files.
+    //! \details Uses 16 bit positions and texcoords and 8 bit normals and
+    //! colors as defined by the KHR_mesh_quantization extension.
+    bool use_quantization = false;
+
+    //! \brief Reorder triangles and vertices of glTF files for the vertex
+    //! cache and vertex fetch of GPUs.
+    bool optimize_vertex_cache = false;
+
+    //! \brief Called while reading with the bytes consumed and the size of
+    //! the (decompressed) file.
+    //! \details Return false to cancel reading, which throws a
+    //! CancelledException and leaves the mesh empty. Called from the thread
+    //! reading the file.
+    std::function<bool(size_t bytes, size_t total)> progress;
 };
 
 //! \brief Exception indicating invalid input passed to a function.
@@ -117,6 +168,13 @@ public:
     IOException(const std::string& what) : std::runtime_error(what) {}
 };
 
+//! \brief Exception indicating that an operation was cancelled by the caller.
+class CancelledException : public std::runtime_error
+{
+public:
+    CancelledException(const std::string& what) : std::runtime_error(what) {}
+};
+
 //! @}
 
 //! \defgroup core core
@@ -3,9 +3,14 @@
 
 #include "pmp/algorithms/DifferentialGeometry.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <limits>
+#include <string>
+#include <vector>
+
+#include "pmp/Parallel.h"
 
 namespace pmp {
 
@@ -26,87 +31,361 @@ Scalar triangle_area(const SurfaceMesh& mesh, Face f)
     return triangle_area(p0, p1, p2);
 }
 
-Scalar surface_area(const SurfaceMesh& mesh)
+Point centroid(const SurfaceMesh& mesh, Face f)
 {
-    Scalar area(0);
-    for (auto f : mesh.faces())
+    Point c(0, 0, 0);
+    Scalar n(0);
+    for (auto v : mesh.vertices(f))
     {
-        area += triangle_area(mesh, f);
+        c += mesh.position(v);
+        ++n;
     }
-    return area;
+    c /= n;
+    return c;
 }
 
-Scalar volume(const SurfaceMesh& mesh)
+namespace {
+
+// Sums of the area, six times the signed volume, and the area-weighted
+// centroid of triangles
+struct TriangleSums
 {
-    if (!mesh.is_triangle_mesh())
+    double area = 0, volume = 0, cx = 0, cy = 0, cz = 0;
+
+    // number of faces that are not triangles
+    size_t n_polygons = 0;
+
+    TriangleSums& operator+=(const TriangleSums& s)
     {
-        throw InvalidInputException("Input is not a pure triangle mesh!");
+        area += s.area;
+        volume += s.volume;
+        cx += s.cx;
+        cy += s.cy;
+        cz += s.cz;
+        n_polygons += s.n_polygons;
+        return *this;
     }
+};
+
+// number of triangles summed per block
+const size_t block_size = 256;
+
+// The accessors below store the vertex indices of triangle t in tri and
+// return whether it is a polygon with more than three vertices, of which the
+// first three are used. Deleted faces become degenerate triangles that add
+// nothing.
+
+// triangles of an index buffer
+struct BufferTriangles
+{
+    const IndexType* indices;
 
-    Scalar volume(0);
-    for (const auto f : mesh.faces())
+    bool operator()(size_t t, IndexType* tri) const
     {
-        auto fv = mesh.vertices(f);
-        const auto& p0 = mesh.position(*fv);
-        const auto& p1 = mesh.position(*(++fv));
-        const auto& p2 = mesh.position(*(++fv));
+        tri[0] = indices[3 * t];
+        tri[1] = indices[3 * t + 1];
+        tri[2] = indices[3 * t + 2];
+        return false;
+    }
+};
+
+// faces of a mesh, checked for deletion only if it has garbage
+struct MeshTriangles
+{
+    const SurfaceMesh& mesh;
+    bool garbage;
 
-        volume += Scalar(1.0) / Scalar(6.0) * dot(cross(p0, p1), p2);
+    bool operator()(size_t t, IndexType* tri) const
+    {
+        const Face f(static_cast<IndexType>(t));
+        if (garbage && mesh.is_deleted(f))
+        {
+            tri[0] = tri[1] = tri[2] = 0;
+            return false;
+        }
+        Halfedge h = mesh.halfedge(f);
+        tri[0] = mesh.to_vertex(h).idx();
+        h = mesh.next_halfedge(h);
+        tri[1] = mesh.to_vertex(h).idx();
+        h = mesh.next_halfedge(h);
+        tri[2] = mesh.to_vertex(h).idx();
+        return mesh.next_halfedge(h) != mesh.halfedge(f);
     }
+};
 
-    return std::abs(volume);
+// faces of an adjacency
+struct AdjacencyTriangles
+{
+    const SurfaceAdjacency& adjacency;
+
+    bool operator()(size_t t, IndexType* tri) const
+    {
+        auto fv = adjacency.face_vertices(Face(static_cast<IndexType>(t)));
+        if (fv.empty())
+        {
+            tri[0] = tri[1] = tri[2] = 0;
+            return false;
+        }
+        tri[0] = fv[0].idx();
+        tri[1] = fv[1].idx();
+        tri[2] = fv[2].idx();
+        return fv.size() != 3;
+    }
+};
+
+// Sum the triangles [begin, end), reading the coordinates of vertex i from
+// x[i * stride], y[i * stride], and z[i * stride]. The triangles are
+// evaluated into arrays without dependencies between iterations and summed
+// pairwise by element-wise halving, so the arithmetic is vectorized by the
+// compiler and the result does not depend on the order in which blocks are
+// processed.
+template <class Triangles>
+TriangleSums block_sums(const Triangles& triangles, size_t begin, size_t end,
+                        const Scalar* x, const Scalar* y, const Scalar* z,
+                        size_t stride)
+{
+    IndexType idx[3 * block_size];
+    double a[block_size], vol[block_size];
+    double cx[block_size], cy[block_size], cz[block_size];
+
+    TriangleSums sums;
+    const size_t n = end - begin;
+    for (size_t t = 0; t < n; ++t)
+        if (triangles(begin + t, idx + 3 * t))
+            ++sums.n_polygons;
+
+    for (size_t t = 0; t < n; ++t)
+    {
+        const size_t i0 = idx[3 * t] * stride;
+        const size_t i1 = idx[3 * t + 1] * stride;
+        const size_t i2 = idx[3 * t + 2] * stride;
+
+        const double x0 = x[i0], y0 = y[i0], z0 = z[i0];
+        const double x1 = x[i1], y1 = y[i1], z1 = z[i1];
+        const double x2 = x[i2], y2 = y[i2], z2 = z[i2];
+
+        // edge vectors and their cross product
+        const double ux = x1 - x0, uy = y1 - y0, uz = z1 - z0;
+        const double vx = x2 - x0, vy = y2 - y0, vz = z2 - z0;
+        const double nx = uy * vz - uz * vy;
+        const double ny = uz * vx - ux * vz;
+        const double nz = ux * vy - uy * vx;
+        const double fa = 0.5 * std::sqrt(nx * nx + ny * ny + nz * nz);
+
+        a[t] = fa;
+        vol[t] = (y0 * z1 - z0 * y1) * x2 + (z0 * x1 - x0 * z1) * y2 +
+                 (x0 * y1 - y0 * x1) * z2;
+        cx[t] = fa * (x0 + x1 + x2) / 3.0;
+        cy[t] = fa * (y0 + y1 + y2) / 3.0;
+        cz[t] = fa * (z0 + z1 + z2) / 3.0;
+    }
+    for (size_t t = n; t < block_size; ++t)
+        a[t] = vol[t] = cx[t] = cy[t] = cz[t] = 0;
+
+    for (size_t half = block_size / 2; half > 0; half /= 2)
+        for (size_t t = 0; t < half; ++t)
+        {
+            a[t] += a[t + half];
+            vol[t] += vol[t + half];
+            cx[t] += cx[t + half];
+            cy[t] += cy[t + half];
+            cz[t] += cz[t + half];
+        }
+
+    sums.area = a[0];
+    sums.volume = vol[0];
+    sums.cx = cx[0];
+    sums.cy = cy[0];
+    sums.cz = cz[0];
+    return sums;
 }
 
-Point centroid(const SurfaceMesh& mesh, Face f)
+// Sum \p n_triangles triangles, see block_sums(). The blocks are evaluated
+// in parallel and their sums are added pairwise in a fixed order, so the
+// result is independent of the number of threads.
+template <class Triangles>
+TriangleSums triangle_sums(const Triangles& triangles, size_t n_triangles,
+                           const Scalar* x, const Scalar* y, const Scalar* z,
+                           size_t stride)
 {
-    Point c(0, 0, 0);
-    Scalar n(0);
-    for (auto v : mesh.vertices(f))
+    const int n_blocks = int((n_triangles + block_size - 1) / block_size);
+    std::vector<TriangleSums> sums(n_blocks);
+
+    parallel_for(
+        0, n_blocks,
+        [&](int b) {
+            const size_t begin = b * block_size;
+            const size_t end = std::min(begin + block_size, n_triangles);
+            sums[b] = block_sums(triangles, begin, end, x, y, z, stride);
+        },
+        1);
+
+    for (size_t step = 1; step < sums.size(); step *= 2)
+        for (size_t b = 0; b + step < sums.size(); b += 2 * step)
+            sums[b] += sums[b + step];
+
+    return sums.empty() ? TriangleSums() : sums[0];
+}
+
+TriangleSums triangle_sums(const std::vector<IndexType>& triangles,
+                           const CoordinateArrays& coords)
+{
+    return triangle_sums(BufferTriangles{triangles.data()},
+                         triangles.size() / 3, coords.x(), coords.y(),
+                         coords.z(), 1);
+}
+
+TriangleSums triangle_sums(const SurfaceMesh& mesh)
+{
+    if (mesh.vertices_size() == 0)
+        return TriangleSums();
+    const Scalar* p = mesh.position(Vertex(0)).data();
+    return triangle_sums(MeshTriangles{mesh, mesh.has_garbage()},
+                         mesh.faces_size(), p, p + 1, p + 2, 3);
+}
+
+TriangleSums triangle_sums(const SurfaceAdjacency& adjacency,
+                           const CoordinateArrays& coords)
+{
+    return triangle_sums(AdjacencyTriangles{adjacency},
+                         adjacency.faces_size(), coords.x(), coords.y(),
+                         coords.z(), 1);
+}
+
+// throw if the sums include polygons
+void check_triangles(const TriangleSums& sums, const char* caller)
+{
+    if (sums.n_polygons > 0)
     {
-        c += mesh.position(v);
-        ++n;
+        auto what = std::string(caller) + ": Input is not a pure triangle mesh!";
+        throw InvalidInputException(what);
     }
-    c /= n;
-    return c;
 }
 
-Point centroid(const SurfaceMesh& mesh)
+} // namespace
+
+Scalar surface_area(const SurfaceMesh& mesh)
 {
-    Point center(0, 0, 0), c;
-    Scalar area(0), a;
-    for (auto f : mesh.faces())
+    return Scalar(triangle_sums(mesh).area);
+}
+
+Scalar volume(const SurfaceMesh& mesh)
+{
+    const auto sums = triangle_sums(mesh);
+    if (sums.n_polygons > 0)
     {
-        a = triangle_area(mesh, f);
-        c = centroid(mesh, f);
-        area += a;
-        center += a * c;
+        throw InvalidInputException("Input is not a pure triangle mesh!");
     }
-    center /= area;
-    return center;
+
+    return Scalar(std::abs(sums.volume / 6.0));
 }
 
-void dual(SurfaceMesh& mesh)
+Point centroid(const SurfaceMesh& mesh)
 {
-    // the new dualized mesh
-    SurfaceMesh tmp;
+    const auto sums = triangle_sums(mesh);
+    return Point(sums.cx, sums.cy, sums.cz) / Scalar(sums.area);
+}
+
+Scalar surface_area(const SurfaceAdjacency& adjacency,
+                    const CoordinateArrays& coords)
+{
+    const auto sums = triangle_sums(adjacency, coords);
+    check_triangles(sums, "surface_area");
+    return Scalar(sums.area);
+}
 
-    // remember new vertices per face
-    auto fvertex = mesh.add_face_property<Vertex>("f:vertex");
+Scalar volume(const SurfaceAdjacency& adjacency,
+              const CoordinateArrays& coords)
+{
+    const auto sums = triangle_sums(adjacency, coords);
+    check_triangles(sums, "volume");
+    return Scalar(std::abs(sums.volume / 6.0));
+}
 
-    // add centroid for each face
-    for (auto f : mesh.faces())
-        fvertex[f] = tmp.add_vertex(centroid(mesh, f));
+Point centroid(const SurfaceAdjacency& adjacency,
+               const CoordinateArrays& coords)
+{
+    const auto sums = triangle_sums(adjacency, coords);
+    check_triangles(sums, "centroid");
+    return Point(sums.cx, sums.cy, sums.cz) / Scalar(sums.area);
+}
 
-    // add new face for each vertex
-    for (auto v : mesh.vertices())
-    {
-        std::vector<Vertex> vertices;
-        for (auto f : mesh.faces(v))
-            vertices.push_back(fvertex[f]);
+Scalar surface_area(const std::vector<IndexType>& triangles,
+                    const CoordinateArrays& coords)
+{
+    return Scalar(triangle_sums(triangles, coords).area);
+}
+
+Scalar volume(const std::vector<IndexType>& triangles,
+              const CoordinateArrays& coords)
+{
+    return Scalar(std::abs(triangle_sums(triangles, coords).volume / 6.0));
+}
 
-        tmp.add_face(vertices);
+Point centroid(const std::vector<IndexType>& triangles,
+               const CoordinateArrays& coords)
+{
+    const auto sums = triangle_sums(triangles, coords);
+    return Point(sums.cx, sums.cy, sums.cz) / Scalar(sums.area);
+}
+
+void dual(SurfaceMesh& mesh)
+{
+    // the new vertex of each face, numbering the faces that are not deleted
+    const int nf(mesh.faces_size());
+    const bool garbage = mesh.has_garbage();
+    std::vector<IndexType> fvertex(nf, PMP_MAX_INDEX);
+    IndexType n_points = 0;
+    if (garbage)
+        for (auto f : mesh.faces())
+            fvertex[f.idx()] = n_points++;
+    else
+        for (auto f : mesh.dense_faces())
+            fvertex[f.idx()] = n_points++;
+
+    // add centroid for each face
+    std::vector<Point> points(n_points);
+    parallel_for_chunks(0, nf, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+            if (fvertex[i] != PMP_MAX_INDEX)
+                points[fvertex[i]] = centroid(mesh, Face(i));
+    });
+
+    // new face for each vertex, written to the index buffer at offsets
+    // given by the numbers of incident faces
+    const int nv(mesh.vertices_size());
+    std::vector<IndexType> offsets(nv + 1, 0);
+    parallel_for_chunks(0, nv, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+            if (!garbage || !mesh.is_deleted(Vertex(i)))
+                for (auto h : mesh.halfedges(Vertex(i)))
+                    if (!mesh.is_boundary(h))
+                        ++offsets[i + 1];
+    });
+
+    std::vector<IndexType> face_sizes;
+    for (int i = 0; i < nv; ++i)
+    {
+        if (!garbage || !mesh.is_deleted(Vertex(i)))
+            face_sizes.push_back(offsets[i + 1]);
+        offsets[i + 1] += offsets[i];
     }
 
+    std::vector<IndexType> indices(offsets[nv]);
+    parallel_for_chunks(0, nv, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+        {
+            IndexType c = offsets[i];
+            if (!garbage || !mesh.is_deleted(Vertex(i)))
+                for (auto f : mesh.faces(Vertex(i)))
+                    indices[c++] = fvertex[f.idx()];
+        }
+    });
+
+    // build the dual mesh in one pass
+    SurfaceMesh tmp;
+    tmp.from_indexed_faces(points, indices, face_sizes);
+
     // swap old and new meshes, don't copy properties
     mesh.assign(tmp);
 }
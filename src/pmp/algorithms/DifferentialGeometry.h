@@ -5,6 +5,8 @@
 
 #include "pmp/Types.h"
 #include "pmp/SurfaceMesh.h"
+#include "pmp/SurfaceAdjacency.h"
+#include "pmp/CoordinateArrays.h"
 
 namespace pmp {
 
@@ -55,11 +57,14 @@ Scalar triangle_area(const Point& p0, const Point& p1, const Point& p2);
 //! compute area of triangle f
 Scalar triangle_area(const SurfaceMesh& mesh, Face f);
 
-//! surface area of the mesh (assumes triangular faces)
+//! \brief Surface area of the mesh (assumes triangular faces)
+//! \details Computed in parallel and summed pairwise, which gives the same
+//! result for any number of threads.
 Scalar surface_area(const SurfaceMesh& mesh);
 
 //! \brief Compute the volume of a mesh
-//! \details See \cite zhang_2002_efficient for details.
+//! \details See \cite zhang_2002_efficient for details. Computed like
+//! surface_area().
 //! \pre Input mesh needs to be a pure triangle mesh.
 //! \throw InvalidInputException if the input precondition is violated.
 Scalar volume(const SurfaceMesh& mesh);
@@ -68,11 +73,55 @@ Scalar volume(const SurfaceMesh& mesh);
 Point centroid(const SurfaceMesh& mesh, Face f);
 
 //! barycenter/centroid of mesh, computed as area-weighted mean of vertices.
-//! assumes triangular faces.
+//! assumes triangular faces. Computed like surface_area().
 Point centroid(const SurfaceMesh& mesh);
 
+//! \brief Surface area of a triangle mesh from struct-of-arrays coordinates.
+//! \details Reads the faces from \p adjacency and the vertex positions from
+//! \p coords, which avoids halfedge traversals and uses all cores.
+//! \throw InvalidInputException if a face is not a triangle.
+Scalar surface_area(const SurfaceAdjacency& adjacency,
+                    const CoordinateArrays& coords);
+
+//! \brief Volume of a triangle mesh from struct-of-arrays coordinates.
+//! \sa surface_area(const SurfaceAdjacency&, const CoordinateArrays&)
+//! \throw InvalidInputException if a face is not a triangle.
+Scalar volume(const SurfaceAdjacency& adjacency,
+              const CoordinateArrays& coords);
+
+//! \brief Area-weighted centroid of a triangle mesh from struct-of-arrays
+//! coordinates.
+//! \sa surface_area(const SurfaceAdjacency&, const CoordinateArrays&)
+//! \throw InvalidInputException if a face is not a triangle.
+Point centroid(const SurfaceAdjacency& adjacency,
+               const CoordinateArrays& coords);
+
+//! \brief Surface area of the triangles of an index buffer.
+//! \details \p triangles holds three vertex indices into \p coords per
+//! triangle. The triangles are evaluated in blocks that are vectorized by
+//! the compiler and processed in parallel. Their sums are added pairwise in
+//! a fixed order, so the result does not depend on the number of threads.
+Scalar surface_area(const std::vector<IndexType>& triangles,
+                    const CoordinateArrays& coords);
+
+//! \brief Volume enclosed by the triangles of an index buffer.
+//! \sa surface_area(const std::vector<IndexType>&, const CoordinateArrays&)
+Scalar volume(const std::vector<IndexType>& triangles,
+              const CoordinateArrays& coords);
+
+//! \brief Area-weighted centroid of the triangles of an index buffer.
+//! \sa surface_area(const std::vector<IndexType>&, const CoordinateArrays&)
+Point centroid(const std::vector<IndexType>& triangles,
+               const CoordinateArrays& coords);
+
 //! \brief Compute dual of a mesh.
+//! \details The centroids of the faces and the faces around the vertices are
+//! gathered in parallel, and the dual is built with
+//! SurfaceMesh::from_indexed_faces(), which gives the same mesh as adding
+//! the faces one by one.
 //! \warning Changes the mesh in place. All properties are cleared.
+//! \throw InvalidInputException if a vertex has less than three incident
+//! faces. The mesh is unchanged in this case.
 void dual(SurfaceMesh& mesh);
 
 //! compute the cotangent weight for edge e
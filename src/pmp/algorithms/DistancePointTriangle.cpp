@@ -3,8 +3,8 @@
 
 #include "pmp/algorithms/DistancePointTriangle.h"
 
+#include <algorithm>
 #include <cmath>
-
 #include <limits>
 
 namespace pmp {
@@ -212,4 +212,109 @@ Scalar dist_point_triangle(const Point& p, const Point& v0, const Point& v1,
     return norm(v0p);
 }
 
+void dist_point_triangles(const Point& p, const Scalar* const corners[9],
+                          size_t n, Scalar* dist, Scalar* b1, Scalar* b2)
+{
+    const Scalar *x0 = corners[0], *y0 = corners[1], *z0 = corners[2];
+    const Scalar *x1 = corners[3], *y1 = corners[4], *z1 = corners[5];
+    const Scalar *x2 = corners[6], *y2 = corners[7], *z2 = corners[8];
+    const Scalar px = p[0], py = p[1], pz = p[2];
+    const Scalar tiny = std::numeric_limits<Scalar>::min();
+
+    // closest point parameter on a segment, zero for degenerate segments.
+    // All operations are evaluated unconditionally and only their results
+    // are selected, which lets the compiler convert the loop to SIMD code.
+    auto clamp = [tiny](Scalar a, Scalar b) {
+        const Scalar u = a / (b + tiny);
+        const Scalar v = u > 1 ? Scalar(1) : u;
+        return u < 0 ? Scalar(0) : v;
+    };
+
+    // Compute all candidates, the projection into the triangle plane and the
+    // nearest points on the three edges, and select the nearest valid one.
+    // Blocks of triangles are written to local arrays first, which cannot
+    // alias the input.
+    const size_t block_size = 16;
+    Scalar sqr_dist[block_size], s1[block_size], s2[block_size];
+    for (size_t begin = 0; begin < n; begin += block_size)
+    {
+        const size_t m = std::min(block_size, n - begin);
+        for (size_t i = 0; i < m; ++i)
+        {
+            const size_t j = begin + i;
+            const Scalar e1x = x1[j] - x0[j], e1y = y1[j] - y0[j],
+                         e1z = z1[j] - z0[j];
+            const Scalar e2x = x2[j] - x0[j], e2y = y2[j] - y0[j],
+                         e2z = z2[j] - z0[j];
+            const Scalar wx = px - x0[j], wy = py - y0[j], wz = pz - z0[j];
+
+            // projection into the plane in barycentric coordinates
+            const Scalar nx = e1y * e2z - e1z * e2y;
+            const Scalar ny = e1z * e2x - e1x * e2z;
+            const Scalar nz = e1x * e2y - e1y * e2x;
+            const Scalar nn = nx * nx + ny * ny + nz * nz;
+            const Scalar inv_nn = Scalar(1) / (nn + tiny);
+            const Scalar s = ((wy * e2z - wz * e2y) * nx +
+                              (wz * e2x - wx * e2z) * ny +
+                              (wx * e2y - wy * e2x) * nz) *
+                             inv_nn;
+            const Scalar t = ((e1y * wz - e1z * wy) * nx +
+                              (e1z * wx - e1x * wz) * ny +
+                              (e1x * wy - e1y * wx) * nz) *
+                             inv_nn;
+            const Scalar wn = wx * nx + wy * ny + wz * nz;
+
+            // edge v0v1
+            const Scalar u01 = clamp(wx * e1x + wy * e1y + wz * e1z,
+                                     e1x * e1x + e1y * e1y + e1z * e1z);
+            const Scalar d01x = wx - u01 * e1x, d01y = wy - u01 * e1y,
+                         d01z = wz - u01 * e1z;
+            Scalar d = d01x * d01x + d01y * d01y + d01z * d01z;
+            Scalar bs = u01, bt = 0;
+
+            // edge v0v2
+            const Scalar u02 = clamp(wx * e2x + wy * e2y + wz * e2z,
+                                     e2x * e2x + e2y * e2y + e2z * e2z);
+            const Scalar d02x = wx - u02 * e2x, d02y = wy - u02 * e2y,
+                         d02z = wz - u02 * e2z;
+            const Scalar d02 = d02x * d02x + d02y * d02y + d02z * d02z;
+            bs = d02 < d ? 0 : bs;
+            bt = d02 < d ? u02 : bt;
+            d = d02 < d ? d02 : d;
+
+            // edge v1v2
+            const Scalar fx = e2x - e1x, fy = e2y - e1y, fz = e2z - e1z;
+            const Scalar gx = wx - e1x, gy = wy - e1y, gz = wz - e1z;
+            const Scalar gf = gx * fx + gy * fy + gz * fz;
+            const Scalar ff = fx * fx + fy * fy + fz * fz;
+            const Scalar u12 = clamp(gf, ff);
+            const Scalar v12 = clamp(ff - gf, ff); // 1 - u12
+            const Scalar d12x = gx - u12 * fx, d12y = gy - u12 * fy,
+                         d12z = gz - u12 * fz;
+            const Scalar d12 = d12x * d12x + d12y * d12y + d12z * d12z;
+            bs = d12 < d ? v12 : bs;
+            bt = d12 < d ? u12 : bt;
+            d = d12 < d ? d12 : d;
+
+            // the projection is taken if the triangle is not degenerate and
+            // its barycentric coordinates are non-negative. Then it is never
+            // farther than the edges, but testing this keeps its computation
+            // unconditional.
+            const Scalar dn = wn * wn * inv_nn;
+            const bool inside = (nn > tiny) & (s >= 0) & (t >= 0) &
+                                (s + t <= Scalar(1)) & (dn <= d);
+            sqr_dist[i] = inside ? dn : d;
+            s1[i] = inside ? s : bs;
+            s2[i] = inside ? t : bt;
+        }
+
+        for (size_t i = 0; i < m; ++i)
+        {
+            dist[begin + i] = std::sqrt(sqr_dist[i]);
+            b1[begin + i] = s1[i];
+            b2[begin + i] = s2[i];
+        }
+    }
+}
+
 } // namespace pmp
@@ -18,6 +18,20 @@ Scalar dist_point_line_segment(const Point& p, const Point& v0, const Point& v1,
 Scalar dist_point_triangle(const Point& p, const Point& v0, const Point& v1,
                            const Point& v2, Point& nearest_point);
 
+//! \brief Compute the distances of a point p to n triangles at once.
+//! \details The triangles are given in structure-of-arrays layout: \p corners
+//! holds nine arrays of n coordinates, the x, y, and z coordinates of the
+//! first corners v0, then those of the second corners v1, and of the third
+//! corners v2. For the i-th triangle, dist[i] receives the distance and
+//! b1[i], b2[i] the coordinates of the nearest point
+//! v0 + b1[i] * (v1 - v0) + b2[i] * (v2 - v0).
+//!
+//! The computation is free of branches, so that the compiler can process
+//! several triangles per SIMD instruction. Degenerate triangles are handled
+//! as in dist_point_triangle().
+void dist_point_triangles(const Point& p, const Scalar* const corners[9],
+                          size_t n, Scalar* dist, Scalar* b1, Scalar* b2);
+
 //! @}
 
 } // namespace pmp
@@ -0,0 +1,130 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/DistributedProcessing.h"
+
+#include <utility>
+
+#include "pmp/Parallel.h"
+#include "pmp/SurfaceMeshIO.h"
+#include "pmp/algorithms/SurfacePartition.h"
+#include "pmp/algorithms/SurfaceRemeshing.h"
+#include "pmp/algorithms/SurfaceSimplification.h"
+#include "pmp/algorithms/SurfaceSmoothing.h"
+
+namespace pmp {
+
+DistributedProcessing::DistributedProcessing(SurfaceMesh& mesh)
+    : mesh_(mesh), halo_rings_(1)
+{
+}
+
+void DistributedProcessing::set_transport(Transport transport)
+{
+    transport_ = std::move(transport);
+}
+
+void DistributedProcessing::run(const PatchFunction& process,
+                                size_t n_patches, unsigned int n_rounds)
+{
+    if (n_patches == 0)
+    {
+        auto what = "DistributedProcessing: Number of patches is zero.";
+        throw InvalidInputException(what);
+    }
+
+    SurfacePartition partition(mesh_);
+    for (unsigned int round = 0; round < n_rounds; ++round)
+    {
+        partition.partition(n_patches + round % 2);
+
+        // the patches are extracted and processed one per task, each task
+        // runs the parallel loops of its algorithm sequentially
+        const int n = int(partition.n_patches());
+        std::vector<SurfacePatch> patches(n);
+        parallel_for(
+            0, n,
+            [&](int i) { patches[i] = partition.extract(i, halo_rings_); },
+            1);
+
+        if (transport_)
+        {
+            std::vector<std::vector<char>> data(n);
+            parallel_for(
+                0, n, [&](int i) { data[i] = encode_patch(patches[i].mesh); },
+                1);
+            transport_(data);
+            if (data.size() != size_t(n))
+            {
+                auto what = "DistributedProcessing: Transport returned a "
+                            "different number of patches.";
+                throw InvalidInputException(what);
+            }
+            for (int i = 0; i < n; ++i)
+                decode_patch(data[i], patches[i].mesh);
+        }
+        else
+        {
+            parallel_for(
+                0, n, [&](int i) { process(patches[i].mesh); }, 1);
+        }
+
+        partition.stitch(patches);
+    }
+}
+
+std::vector<char> DistributedProcessing::encode_patch(const SurfaceMesh& mesh)
+{
+    return SurfaceMeshIO::write(mesh, "pmp");
+}
+
+void DistributedProcessing::decode_patch(const std::vector<char>& data,
+                                         SurfaceMesh& mesh)
+{
+    SurfaceMeshIO::read(data.data(), data.size(), "pmp", mesh);
+}
+
+std::vector<char> DistributedProcessing::process_patch(
+    const std::vector<char>& data, const PatchFunction& process)
+{
+    SurfaceMesh mesh;
+    decode_patch(data, mesh);
+    process(mesh);
+    return encode_patch(mesh);
+}
+
+DistributedProcessing::PatchFunction DistributedProcessing::smoothing(
+    unsigned int iterations)
+{
+    return [iterations](SurfaceMesh& mesh) {
+        SurfaceSmoothing(mesh).explicit_smoothing(iterations, true);
+    };
+}
+
+DistributedProcessing::PatchFunction DistributedProcessing::remeshing(
+    Scalar edge_length, unsigned int iterations)
+{
+    return [edge_length, iterations](SurfaceMesh& mesh) {
+        SurfaceRemeshing(mesh).uniform_remeshing(edge_length, iterations);
+    };
+}
+
+DistributedProcessing::PatchFunction DistributedProcessing::simplification(
+    Scalar ratio)
+{
+    return [ratio](SurfaceMesh& mesh) {
+        auto vselected = mesh.get_vertex_property<bool>("v:selected");
+        size_t n_selected = 0;
+        for (auto v : mesh.vertices())
+            if (!vselected || vselected[v])
+                ++n_selected;
+        const size_t n_frozen = mesh.n_vertices() - n_selected;
+        const auto target = n_frozen + size_t(ratio * Scalar(n_selected));
+
+        SurfaceSimplification simplification(mesh);
+        simplification.initialize(5.0);
+        simplification.simplify(static_cast<unsigned int>(target));
+    };
+}
+
+} // namespace pmp
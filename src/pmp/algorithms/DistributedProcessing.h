@@ -0,0 +1,124 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Processing of a mesh as patches on several processes or nodes.
+//! \details Splits the mesh with SurfacePartition into patches with a halo
+//! of frozen context faces, processes the patches independently, and
+//! stitches them back. Each round repartitions the current mesh, which
+//! rebalances the patches after their sizes changed and moves the patch
+//! boundaries, such that the vertices frozen at the interfaces of one round
+//! are processed in the next.
+//!
+//! By default the patches are processed in parallel on this process. A
+//! Transport distributes them to other processes instead, e.g., to the
+//! ranks of an MPI job, which run process_patch() with the same function.
+//! The library itself does not depend on MPI. A transport that sends the
+//! i-th patch to rank i + 1 could look like this:
+//! \code
+//! processing.set_transport([](std::vector<std::vector<char>>& patches) {
+//!     for (size_t i = 0; i < patches.size(); ++i)
+//!         MPI_Send(patches[i].data(), int(patches[i].size()), MPI_CHAR,
+//!                  int(i) + 1, 0, MPI_COMM_WORLD);
+//!     for (size_t i = 0; i < patches.size(); ++i)
+//!     {
+//!         MPI_Status status;
+//!         MPI_Probe(int(i) + 1, 0, MPI_COMM_WORLD, &status);
+//!         int size;
+//!         MPI_Get_count(&status, MPI_CHAR, &size);
+//!         patches[i].resize(size);
+//!         MPI_Recv(patches[i].data(), size, MPI_CHAR, int(i) + 1, 0,
+//!                  MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+//!     }
+//! });
+//! \endcode
+//! where each worker rank receives a patch, replaces it by the result of
+//! process_patch(), and sends it back. Only the patches travel, the mesh
+//! stays on the process calling run().
+//! \ingroup algorithms
+class DistributedProcessing
+{
+public:
+    //! \brief Processes the mesh of a patch in place.
+    //! \details Vertices that are not selected by the \c "v:selected"
+    //! property are shared with the halo and must neither be moved nor
+    //! deleted, which SurfaceSmoothing, SurfaceRemeshing, and
+    //! SurfaceSimplification respect.
+    typedef std::function<void(SurfaceMesh&)> PatchFunction;
+
+    //! \brief Replaces each encoded patch by its processed version.
+    //! \details The patches are encoded by encode_patch(). Each has to be
+    //! replaced by the result of process_patch() for the function given to
+    //! run(), computed anywhere.
+    typedef std::function<void(std::vector<std::vector<char>>& patches)>
+        Transport;
+
+    //! construct with the mesh to be processed
+    DistributedProcessing(SurfaceMesh& mesh);
+
+    //! \brief Process the patches with \p transport.
+    //! \details An empty transport processes the patches on this process.
+    void set_transport(Transport transport);
+
+    //! \brief Set the number of rings of halo faces around each patch.
+    //! \details Defaults to 1. Algorithms whose result at a vertex depends
+    //! on a larger neighborhood, e.g., several smoothing iterations, give
+    //! smoother interfaces with more rings.
+    void set_halo_rings(unsigned int rings) { halo_rings_ = rings; }
+
+    //! \brief Process the mesh by \p process in \p n_rounds rounds of
+    //! \p n_patches patches.
+    //! \details Odd rounds use one patch more, which shifts the patch
+    //! boundaries. If the connectivity changes, the mesh is rebuilt and only
+    //! keeps its vertex positions, see SurfacePartition::stitch().
+    //! \throw InvalidInputException if \p n_patches is zero or the
+    //! transport returns a different number of patches.
+    void run(const PatchFunction& process, size_t n_patches,
+             unsigned int n_rounds = 2);
+
+    //! \brief Encode \p mesh for the transport.
+    //! \details Uses the PMP format, which keeps the patch properties.
+    static std::vector<char> encode_patch(const SurfaceMesh& mesh);
+
+    //! \brief Decode an encoded patch into \p mesh.
+    //! \throw IOException if the data is not in the PMP format.
+    static void decode_patch(const std::vector<char>& data, SurfaceMesh& mesh);
+
+    //! \brief Decode the patch \p data, process it by \p process, and
+    //! encode the result, as the worker side of a transport.
+    //! \throw IOException if the data is not in the PMP format.
+    static std::vector<char> process_patch(const std::vector<char>& data,
+                                           const PatchFunction& process);
+
+    //! \name Patch functions
+    //!@{
+
+    //! \p iterations iterations of explicit uniform Laplacian smoothing
+    static PatchFunction smoothing(unsigned int iterations);
+
+    //! uniform remeshing to \p edge_length, see SurfaceRemeshing
+    static PatchFunction remeshing(Scalar edge_length,
+                                   unsigned int iterations = 10);
+
+    //! \brief Simplification of the patch interiors to \p ratio of their
+    //! vertices.
+    //! \details Faces are kept at an aspect ratio of at most 5.
+    static PatchFunction simplification(Scalar ratio);
+
+    //!@}
+
+private:
+    SurfaceMesh& mesh_;
+    Transport transport_;
+    unsigned int halo_rings_;
+};
+
+} // namespace pmp
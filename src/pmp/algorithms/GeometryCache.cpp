@@ -0,0 +1,63 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/GeometryCache.h"
+
+#include <algorithm>
+
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/DifferentialGeometry.h"
+
+namespace pmp {
+
+GeometryCache::GeometryCache(SurfaceMesh& mesh) : mesh_(mesh)
+{
+    owner_ = !mesh_.has_edge_property("geometry:cotan");
+    cotan_ = mesh_.edge_property<double>("geometry:cotan");
+    area_ = mesh_.vertex_property<double>("geometry:area");
+    generation_ = mesh_.object_property<uint64_t>("geometry:generation", 0);
+}
+
+GeometryCache::~GeometryCache()
+{
+    if (owner_)
+    {
+        mesh_.remove_edge_property(cotan_);
+        mesh_.remove_vertex_property(area_);
+        mesh_.remove_object_property(generation_);
+    }
+}
+
+bool GeometryCache::is_valid() const
+{
+    const uint64_t g = generation_[0];
+    if (g == 0)
+        return false;
+
+    const auto points = mesh_.get_vertex_property<Point>("v:point");
+    return std::max(points.generation(), mesh_.topology_generation()) <= g;
+}
+
+bool GeometryCache::update()
+{
+    if (is_valid())
+        return false;
+
+    const int nE = int(mesh_.edges_size());
+    parallel_for(0, nE, [&](int i) {
+        if (!mesh_.is_deleted(Edge(i)))
+            cotan_[Edge(i)] = pmp::cotan_weight(mesh_, Edge(i));
+    });
+
+    const int nV = int(mesh_.vertices_size());
+    parallel_for(0, nV, [&](int i) {
+        if (!mesh_.is_deleted(Vertex(i)))
+            area_[Vertex(i)] = pmp::voronoi_area(mesh_, Vertex(i));
+    });
+
+    // later changes are stamped with a later generation
+    generation_[0] = mesh_.new_generation();
+    return true;
+}
+
+} // namespace pmp
@@ -0,0 +1,60 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A cache of cotan weights and Voronoi areas shared by algorithms.
+//! \details Computes cotan_weight() of all edges and voronoi_area() of all
+//! vertices in one parallel pass and stores them in the edge property
+//! "geometry:cotan" and the vertex property "geometry:area". The algorithms
+//! using these values, e.g., SurfaceSmoothing, SurfaceFairing,
+//! SurfaceParameterization, SurfaceCurvature, and SurfaceRemeshing, create a
+//! cache for their mesh. While a cache for the mesh exists outside of them,
+//! they share its values instead of computing their own. The properties are
+//! removed with the cache that added them.
+//!
+//! update() recomputes the values if the vertex positions or the
+//! connectivity changed since they were computed, which is detected by
+//! change tracking, see SurfaceMesh::set_change_tracking(). Without change
+//! tracking, every update() recomputes the values.
+//! \ingroup algorithms
+class GeometryCache
+{
+public:
+    //! Construct for \p mesh, sharing the values of an existing cache.
+    explicit GeometryCache(SurfaceMesh& mesh);
+
+    //! Remove the properties if they were added by this cache.
+    ~GeometryCache();
+
+    GeometryCache(const GeometryCache&) = delete;
+    GeometryCache& operator=(const GeometryCache&) = delete;
+
+    //! \brief Recompute the values unless they are up to date.
+    //! \return whether the values were recomputed
+    bool update();
+
+    //! Are the values up to date with the mesh?
+    bool is_valid() const;
+
+    //! cotangent weight of edge \p e, see cotan_weight()
+    double cotan_weight(Edge e) const { return cotan_[e]; }
+
+    //! mixed Voronoi area of vertex \p v, see voronoi_area()
+    double voronoi_area(Vertex v) const { return area_[v]; }
+
+private:
+    SurfaceMesh& mesh_;
+    bool owner_;
+    EdgeProperty<double> cotan_;
+    VertexProperty<double> area_;
+
+    // generation of the last computation, zero if none
+    ObjectProperty<uint64_t> generation_;
+};
+
+} // namespace pmp
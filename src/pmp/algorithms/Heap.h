@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <utility>
 #include <vector>
 
 namespace pmp {
@@ -55,6 +58,18 @@ public:
         upheap(size() - 1);
     }
 
+    //! \brief Replace the content of the heap by \p entries.
+    //! \details Establishes the heap property bottom-up in linear time
+    //! instead of inserting the entries one by one.
+    void build(const std::vector<HeapEntry>& entries)
+    {
+        HeapVector::assign(entries.begin(), entries.end());
+        for (unsigned int i = 0; i < size(); ++i)
+            interface_.set_heap_position(entry(i), i);
+        for (unsigned int i = size() / 2; i-- > 0;)
+            downheap(i);
+    }
+
     //! get the first entry
     HeapEntry front()
     {
@@ -206,4 +221,263 @@ private:
     HeapInterface interface_;
 };
 
+//! \brief An indexed d-ary min-heap storing the priorities inline.
+//! \details Unlike Heap, the priorities are stored next to the entries in
+//! the heap array, so comparisons do not look up properties, and the wider
+//! nodes of a 4-ary or 8-ary heap keep the tree shallow. The heap positions
+//! are kept in an array indexed by HeapEntry::idx(), so entries have to be
+//! handles such as Vertex. Ties are broken by the handle index, making the
+//! order of equal priorities deterministic.
+//!
+//! lazy_remove() only marks an entry as removed in constant time, the marked
+//! nodes are dropped once they reach the front.
+//! \ingroup algorithms
+template <class HeapEntry, class Priority = float, unsigned int Arity = 4>
+class DAryHeap
+{
+    static_assert(Arity >= 2, "A heap needs at least two children per node");
+
+public:
+    //! Construct for entries with indices below \p n, grows as needed.
+    explicit DAryHeap(size_t n = 0) : positions_(n, npos), n_removed_(0) {}
+
+    //! clear the heap
+    void clear()
+    {
+        for (size_t i = 0; i < nodes_.size(); ++i)
+            if (is_live(i))
+                positions_[nodes_[i].entry.idx()] = npos;
+        nodes_.clear();
+        n_removed_ = 0;
+    }
+
+    //! is heap empty?
+    bool empty() const { return size() == 0; }
+
+    //! returns the number of entries in the heap
+    size_t size() const { return nodes_.size() - n_removed_; }
+
+    //! reserve space for \p n entries
+    void reserve(size_t n) { nodes_.reserve(n); }
+
+    //! is an entry in the heap?
+    bool is_stored(HeapEntry h) const
+    {
+        return h.idx() < positions_.size() && positions_[h.idx()] != npos;
+    }
+
+    //! priority of the stored entry \p h
+    Priority priority(HeapEntry h) const
+    {
+        assert(is_stored(h));
+        return nodes_[positions_[h.idx()]].priority;
+    }
+
+    //! insert the entry \p h with priority \p p
+    void insert(HeapEntry h, Priority p)
+    {
+        assert(!is_stored(h));
+        if (h.idx() >= positions_.size())
+            positions_.resize(h.idx() + 1, npos);
+        positions_[h.idx()] = nodes_.size();
+        nodes_.push_back(Node{p, h});
+        upheap(nodes_.size() - 1);
+    }
+
+    //! change the priority of the stored entry \p h to \p p
+    void update(HeapEntry h, Priority p)
+    {
+        assert(is_stored(h));
+        const size_t pos = positions_[h.idx()];
+        nodes_[pos].priority = p;
+        downheap(pos);
+        upheap(positions_[h.idx()]);
+        purge();
+    }
+
+    //! remove the entry \p h
+    void remove(HeapEntry h)
+    {
+        assert(is_stored(h));
+        const size_t pos = positions_[h.idx()];
+        positions_[h.idx()] = npos;
+        erase(pos);
+        purge();
+    }
+
+    //! \brief Mark the entry \p h as removed in constant time.
+    //! \details The node stays in the heap until it reaches the front.
+    void lazy_remove(HeapEntry h)
+    {
+        assert(is_stored(h));
+        positions_[h.idx()] = npos;
+        ++n_removed_;
+        purge();
+    }
+
+    //! get the first entry
+    HeapEntry front() const
+    {
+        assert(!empty());
+        return nodes_[0].entry;
+    }
+
+    //! get the priority of the first entry
+    Priority front_priority() const
+    {
+        assert(!empty());
+        return nodes_[0].priority;
+    }
+
+    //! delete the first entry
+    void pop_front()
+    {
+        assert(!empty());
+        positions_[nodes_[0].entry.idx()] = npos;
+        erase(0);
+        purge();
+    }
+
+    //! \brief Replace the content of the heap by \p entries and their
+    //! priorities.
+    //! \details Establishes the heap property bottom-up in linear time.
+    void build(const std::vector<std::pair<HeapEntry, Priority>>& entries)
+    {
+        clear();
+        nodes_.reserve(entries.size());
+        for (const auto& e : entries)
+        {
+            assert(!is_stored(e.first));
+            if (e.first.idx() >= positions_.size())
+                positions_.resize(e.first.idx() + 1, npos);
+            positions_[e.first.idx()] = nodes_.size();
+            nodes_.push_back(Node{e.second, e.first});
+        }
+        for (size_t i = nodes_.size() / Arity + 1; i-- > 0;)
+            if (i < nodes_.size())
+                downheap(i);
+    }
+
+    //! \brief Check heap condition and heap positions.
+    //! \return \c true if the heap is consistent, \c false if not.
+    bool check() const
+    {
+        size_t n_removed = 0;
+        for (size_t i = 0; i < nodes_.size(); ++i)
+        {
+            if (i > 0 && less(nodes_[i], nodes_[parent(i)]))
+                return false;
+            if (!is_live(i))
+                ++n_removed;
+        }
+        return n_removed == n_removed_ && (nodes_.empty() || is_live(0));
+    }
+
+private:
+    struct Node
+    {
+        Priority priority;
+        HeapEntry entry;
+    };
+
+    static const size_t npos = size_t(-1);
+
+    static size_t parent(size_t i) { return (i - 1) / Arity; }
+    static size_t first_child(size_t i) { return Arity * i + 1; }
+
+    static bool less(const Node& a, const Node& b)
+    {
+        return a.priority < b.priority ||
+               (a.priority == b.priority && a.entry.idx() < b.entry.idx());
+    }
+
+    // is the node at index i not lazily removed? Removed nodes keep their
+    // entry for the tie-breaking, but its position points elsewhere.
+    bool is_live(size_t i) const
+    {
+        return positions_[nodes_[i].entry.idx()] == i;
+    }
+
+    // put node n at index i and update its heap position if it is live
+    void place(size_t i, const Node& n, bool live)
+    {
+        nodes_[i] = n;
+        if (live)
+            positions_[n.entry.idx()] = i;
+    }
+
+    void upheap(size_t i)
+    {
+        const Node n = nodes_[i];
+        const bool live = is_live(i);
+        while (i > 0 && less(n, nodes_[parent(i)]))
+        {
+            place(i, nodes_[parent(i)], is_live(parent(i)));
+            i = parent(i);
+        }
+        place(i, n, live);
+    }
+
+    void downheap(size_t i)
+    {
+        const Node n = nodes_[i];
+        const bool live = is_live(i);
+        const size_t s = nodes_.size();
+        while (true)
+        {
+            const size_t first = first_child(i);
+            if (first >= s)
+                break;
+
+            // smallest child
+            size_t c = first;
+            const size_t last = std::min(first + Arity, s);
+            for (size_t j = first + 1; j < last; ++j)
+                if (less(nodes_[j], nodes_[c]))
+                    c = j;
+
+            if (!less(nodes_[c], n))
+                break;
+
+            place(i, nodes_[c], is_live(c));
+            i = c;
+        }
+        place(i, n, live);
+    }
+
+    // remove the node at index i, whose position is already reset
+    void erase(size_t i)
+    {
+        const size_t last = nodes_.size() - 1;
+        if (i != last)
+        {
+            place(i, nodes_[last], is_live(last));
+            nodes_.pop_back();
+            if (i > 0 && less(nodes_[i], nodes_[parent(i)]))
+                upheap(i);
+            else
+                downheap(i);
+        }
+        else
+            nodes_.pop_back();
+    }
+
+    // pop lazily removed nodes from the front
+    void purge()
+    {
+        while (!nodes_.empty() && !is_live(0))
+        {
+            --n_removed_;
+            erase(0);
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<size_t> positions_;
+    size_t n_removed_;
+};
+
+template <class HeapEntry, class Priority, unsigned int Arity>
+const size_t DAryHeap<HeapEntry, Priority, Arity>::npos;
+
 } // namespace pmp
@@ -0,0 +1,171 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "pmp/Parallel.h"
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Apply local topological operations in parallel batches.
+//! \details Candidate operations are processed in rounds. In each round the
+//! candidates are visited in their given order and greedily added to a batch
+//! if none of the vertices of their region is locked by an operation already
+//! in the batch, otherwise they are deferred to the next round. The
+//! operations of a batch thus form an independent set of the conflict graph
+//! and are applied concurrently. Batches only depend on the candidate order,
+//! such that the result is the same for any number of threads.
+//!
+//! The region of an operation has to contain all vertices whose incident
+//! elements the operation reads or modifies. For an edge flip these are the
+//! vertices of the two incident faces, see edge_region().
+//!
+//! Concurrent application is only safe for operations that modify existing
+//! elements within their region, such as SurfaceMesh::flip() or moving
+//! vertices. Operations that add or delete elements, such as
+//! SurfaceMesh::split() or SurfaceMesh::collapse(), have to be applied with
+//! \c parallel set to \c false. They still benefit from the scheduling, since
+//! each batch is free of conflicts. Operations are applied sequentially if the
+//! mesh has an edge index, see SurfaceMesh::set_edge_index().
+//! \ingroup algorithms
+class IndependentSetScheduler
+{
+public:
+    //! construct with the mesh the operations work on
+    explicit IndependentSetScheduler(const SurfaceMesh& mesh)
+        : mesh_(mesh), n_rounds_(0)
+    {
+    }
+
+    //! \brief Apply \p apply to all \p candidates in conflict-free batches.
+    //! \param candidates the operations, e.g., edges to be flipped
+    //! \param region called as `region(c, vertices)` to append the vertices
+    //! locked by candidate \p c to \p vertices
+    //! \param apply called as `apply(c)` to perform the operation, returns
+    //! whether it was performed. Has to re-check its preconditions, since
+    //! operations of earlier batches may have changed the mesh.
+    //! \param parallel whether to apply each batch concurrently
+    //! \return the number of performed operations
+    //! \note If \p apply throws, the first exception is rethrown after the
+    //! current batch finished.
+    template <class T, class Region, class Apply>
+    size_t run(const std::vector<T>& candidates, Region region, Apply apply,
+               bool parallel = true)
+    {
+        const bool concurrent = parallel && !mesh_.has_edge_index();
+        std::vector<unsigned int> lock(mesh_.vertices_size(), 0);
+        std::vector<Vertex> vertices;
+        std::vector<T> pending(candidates), deferred, batch;
+        size_t n_applied = 0;
+        n_rounds_ = 0;
+
+        while (!pending.empty())
+        {
+            const unsigned int round = ++n_rounds_;
+            if (lock.size() < mesh_.vertices_size())
+                lock.resize(mesh_.vertices_size(), 0);
+
+            batch.clear();
+            deferred.clear();
+            for (const auto& c : pending)
+            {
+                vertices.clear();
+                region(c, vertices);
+
+                bool free = true;
+                for (auto v : vertices)
+                    if (v.idx() < lock.size() && lock[v.idx()] == round)
+                    {
+                        free = false;
+                        break;
+                    }
+
+                if (free)
+                {
+                    for (auto v : vertices)
+                        if (v.idx() < lock.size())
+                            lock[v.idx()] = round;
+                    batch.push_back(c);
+                }
+                else
+                    deferred.push_back(c);
+            }
+
+            n_applied += apply_batch(batch, apply, concurrent);
+            pending.swap(deferred);
+        }
+
+        return n_applied;
+    }
+
+    //! \brief Return the number of batches of the last call to run().
+    unsigned int n_rounds() const { return n_rounds_; }
+
+    //! \brief Append the vertices of edge \p e and of its incident faces to
+    //! \p vertices.
+    //! \details This is the region of SurfaceMesh::flip(), and also covers a
+    //! split of \p e.
+    static void edge_region(const SurfaceMesh& mesh, Edge e,
+                            std::vector<Vertex>& vertices)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            auto h = mesh.halfedge(e, i);
+            vertices.push_back(mesh.to_vertex(h));
+            if (!mesh.is_boundary(h))
+                vertices.push_back(mesh.to_vertex(mesh.next_halfedge(h)));
+        }
+    }
+
+    //! \brief Append vertex \p v and its one-ring neighbors to \p vertices.
+    //! \details This is the region of moving \p v and of collapsing an edge
+    //! into \p v, if the region of the other endpoint is added as well.
+    static void vertex_region(const SurfaceMesh& mesh, Vertex v,
+                              std::vector<Vertex>& vertices)
+    {
+        vertices.push_back(v);
+        for (auto vv : mesh.vertices(v))
+            vertices.push_back(vv);
+    }
+
+private:
+    template <class T, class Apply>
+    size_t apply_batch(const std::vector<T>& batch, Apply& apply,
+                       bool concurrent)
+    {
+        const int n = int(batch.size());
+
+        if (!concurrent)
+        {
+            int n_applied = 0;
+            for (int i = 0; i < n; ++i)
+                if (apply(batch[i]))
+                    ++n_applied;
+            return n_applied;
+        }
+
+        // Parallel::run() rethrows the first exception of apply
+        const int chunk_size = 64;
+        std::atomic<int> n_applied(0);
+        Parallel::run((n + chunk_size - 1) / chunk_size, [&](int c) {
+            const int first = c * chunk_size;
+            const int last = std::min(first + chunk_size, n);
+            int n_chunk = 0;
+            for (int i = first; i < last; ++i)
+                if (apply(batch[i]))
+                    ++n_chunk;
+            n_applied += n_chunk;
+        });
+        return n_applied;
+    }
+
+    const SurfaceMesh& mesh_;
+    unsigned int n_rounds_;
+};
+
+} // namespace pmp
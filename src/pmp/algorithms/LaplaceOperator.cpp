@@ -0,0 +1,398 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/LaplaceOperator.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/GeometryCache.h"
+
+namespace pmp {
+
+namespace {
+
+const IndexType none = std::numeric_limits<IndexType>::max();
+
+// turn the row sizes stored at offsets[i + 1] into row offsets
+void accumulate(std::vector<IndexType>& offsets)
+{
+    for (size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+}
+
+// rows per task of loops whose scratch memory grows with the number of
+// vertices, a few tasks per thread such that the scratch is set up rarely
+int scratch_chunk_size(int n_rows)
+{
+    return std::max(256, n_rows / (4 * Parallel::n_threads()) + 1);
+}
+
+} // namespace
+
+LaplaceOperator::LaplaceOperator(SurfaceMesh& mesh,
+                                 const std::vector<Vertex>& free_vertices,
+                                 unsigned int k, bool use_uniform_weights)
+    : mesh_(mesh), free_(free_vertices), uniform_(use_uniform_weights)
+{
+    if (k == 0)
+    {
+        auto what = "LaplaceOperator: Degree has to be positive.";
+        throw InvalidInputException(what);
+    }
+
+    // the products need the rows of the Laplacian within the (k-1)-ring of
+    // the free vertices
+    std::vector<bool> rows(mesh_.vertices_size(), false);
+    std::vector<Vertex> front = free_, next;
+    for (auto v : front)
+        rows[v.idx()] = true;
+    for (unsigned int i = 1; i < k; ++i)
+    {
+        next.clear();
+        for (auto v : front)
+        {
+            for (auto vv : mesh_.vertices(v))
+            {
+                if (!rows[vv.idx()])
+                {
+                    rows[vv.idx()] = true;
+                    next.push_back(vv);
+                }
+            }
+        }
+        front.swap(next);
+    }
+
+    powers_.resize(k);
+    setup_laplace(rows);
+    for (unsigned int i = 1; i < k; ++i)
+        setup_product(powers_[i - 1], powers_[i]);
+    setup_restriction();
+
+    vertex_mass_.resize(mesh_.vertices_size(), 0.0);
+    mass_.resize(free_.size());
+    update();
+}
+
+void LaplaceOperator::update()
+{
+    if (uniform_)
+    {
+        fill_laplace(nullptr);
+    }
+    else
+    {
+        GeometryCache cache(mesh_);
+        cache.update();
+        fill_laplace(&cache);
+    }
+
+    for (size_t i = 1; i < powers_.size(); ++i)
+        fill_product(powers_[i - 1], powers_[i]);
+
+    // copy the entries of the free vertices
+    const Rows& top = powers_.back();
+
+    double* values = matrix_.valuePtr();
+    const int nm = int(matrix_entries_.size());
+    parallel_for(0, nm, [&](int j) {
+        values[j] = top.values[matrix_entries_[j]];
+    });
+
+    values = constraint_matrix_.valuePtr();
+    const int nc = int(constraint_entries_.size());
+    parallel_for(0, nc, [&](int j) {
+        values[j] = top.values[constraint_entries_[j]];
+    });
+
+    for (size_t i = 0; i < free_.size(); ++i)
+        mass_[i] = vertex_mass_[free_[i].idx()];
+}
+
+void LaplaceOperator::setup_laplace(const std::vector<bool>& rows)
+{
+    Rows& laplace = powers_[0];
+    const int n = int(mesh_.vertices_size());
+
+    // one entry per neighbor and the diagonal
+    laplace.offsets.assign(n + 1, 0);
+    for (int i = 0; i < n; ++i)
+    {
+        if (rows[i])
+            laplace.offsets[i + 1] = mesh_.valence(Vertex(i)) + 1;
+    }
+    accumulate(laplace.offsets);
+    laplace.columns.resize(laplace.offsets[n]);
+    laplace.values.resize(laplace.offsets[n]);
+    entry_edges_.resize(laplace.offsets[n]);
+
+    parallel_for_chunks(
+        0, n,
+        [&](int first, int last) {
+            std::vector<std::pair<IndexType, Edge>> row;
+            for (int i = first; i < last; ++i)
+            {
+                if (laplace.offsets[i] == laplace.offsets[i + 1])
+                    continue;
+
+                // the diagonal has no edge
+                row.clear();
+                row.emplace_back(IndexType(i), Edge());
+                for (auto h : mesh_.halfedges(Vertex(i)))
+                    row.emplace_back(mesh_.to_vertex(h).idx(), mesh_.edge(h));
+                std::sort(row.begin(), row.end(),
+                          [](const std::pair<IndexType, Edge>& a,
+                             const std::pair<IndexType, Edge>& b) {
+                              return a.first < b.first;
+                          });
+
+                IndexType j = laplace.offsets[i];
+                for (const auto& entry : row)
+                {
+                    laplace.columns[j] = entry.first;
+                    entry_edges_[j] = entry.second;
+                    ++j;
+                }
+            }
+        },
+        256);
+}
+
+void LaplaceOperator::setup_product(const Rows& a, Rows& product) const
+{
+    const Rows& laplace = powers_[0];
+    const size_t n = mesh_.vertices_size();
+    const int nf = int(free_.size());
+
+    // sorted columns of row i, marker remembers the last row of a column
+    auto row_pattern = [&](IndexType i, std::vector<IndexType>& marker,
+                           std::vector<IndexType>& columns) {
+        columns.clear();
+        for (IndexType s = a.offsets[i]; s < a.offsets[i + 1]; ++s)
+        {
+            const IndexType m = a.columns[s];
+            for (IndexType t = laplace.offsets[m]; t < laplace.offsets[m + 1];
+                 ++t)
+            {
+                const IndexType j = laplace.columns[t];
+                if (marker[j] != i)
+                {
+                    marker[j] = i;
+                    columns.push_back(j);
+                }
+            }
+        }
+        std::sort(columns.begin(), columns.end());
+    };
+
+    // count the entries of the rows, then fill them in
+    product.offsets.assign(n + 1, 0);
+
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            std::vector<IndexType> marker(n, none), columns;
+            for (int r = first; r < last; ++r)
+            {
+                const IndexType i = free_[r].idx();
+                row_pattern(i, marker, columns);
+                product.offsets[i + 1] = IndexType(columns.size());
+            }
+        },
+        scratch_chunk_size(nf));
+
+    accumulate(product.offsets);
+    product.columns.resize(product.offsets[n]);
+    product.values.resize(product.offsets[n]);
+
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            std::vector<IndexType> marker(n, none), columns;
+            for (int r = first; r < last; ++r)
+            {
+                const IndexType i = free_[r].idx();
+                row_pattern(i, marker, columns);
+                std::copy(columns.begin(), columns.end(),
+                          product.columns.begin() + product.offsets[i]);
+            }
+        },
+        scratch_chunk_size(nf));
+}
+
+void LaplaceOperator::setup_restriction()
+{
+    const Rows& top = powers_.back();
+    const size_t n = mesh_.vertices_size();
+    const int nf = int(free_.size());
+
+    // index of each free and constraint vertex in its matrix
+    std::vector<IndexType> free_index(n, none), constraint_index(n, none);
+    for (int r = 0; r < nf; ++r)
+        free_index[free_[r].idx()] = r;
+    for (auto v : free_)
+    {
+        for (IndexType s = top.offsets[v.idx()]; s < top.offsets[v.idx() + 1];
+             ++s)
+        {
+            const IndexType j = top.columns[s];
+            if (free_index[j] == none)
+                constraint_index[j] = 0;
+        }
+    }
+    constraints_.clear();
+    for (size_t j = 0; j < n; ++j)
+    {
+        if (constraint_index[j] != none)
+        {
+            constraint_index[j] = IndexType(constraints_.size());
+            constraints_.emplace_back(IndexType(j));
+        }
+    }
+
+    // count the entries of the rows
+    std::vector<IndexType> matrix_offsets(nf + 1, 0);
+    std::vector<IndexType> constraint_offsets(nf + 1, 0);
+    parallel_for(0, nf, [&](int r) {
+        const IndexType i = free_[r].idx();
+        for (IndexType s = top.offsets[i]; s < top.offsets[i + 1]; ++s)
+        {
+            if (free_index[top.columns[s]] != none)
+                ++matrix_offsets[r + 1];
+            else
+                ++constraint_offsets[r + 1];
+        }
+    });
+    accumulate(matrix_offsets);
+    accumulate(constraint_offsets);
+
+    matrix_.resize(nf, nf);
+    matrix_.resizeNonZeros(matrix_offsets[nf]);
+    std::copy(matrix_offsets.begin(), matrix_offsets.end(),
+              matrix_.outerIndexPtr());
+    matrix_entries_.resize(matrix_offsets[nf]);
+
+    constraint_matrix_.resize(nf, constraints_.size());
+    constraint_matrix_.resizeNonZeros(constraint_offsets[nf]);
+    std::copy(constraint_offsets.begin(), constraint_offsets.end(),
+              constraint_matrix_.outerIndexPtr());
+    constraint_entries_.resize(constraint_offsets[nf]);
+
+    // fill in the columns, which are sorted by vertex index for the
+    // constraints but not necessarily for the free vertices
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            std::vector<std::pair<IndexType, IndexType>> row;
+            for (int r = first; r < last; ++r)
+            {
+                const IndexType i = free_[r].idx();
+                IndexType c = constraint_offsets[r];
+                row.clear();
+                for (IndexType s = top.offsets[i]; s < top.offsets[i + 1]; ++s)
+                {
+                    const IndexType j = top.columns[s];
+                    if (free_index[j] != none)
+                    {
+                        row.emplace_back(free_index[j], s);
+                    }
+                    else
+                    {
+                        constraint_matrix_.innerIndexPtr()[c] =
+                            constraint_index[j];
+                        constraint_entries_[c] = s;
+                        ++c;
+                    }
+                }
+                std::sort(row.begin(), row.end());
+
+                IndexType m = matrix_offsets[r];
+                for (const auto& entry : row)
+                {
+                    matrix_.innerIndexPtr()[m] = entry.first;
+                    matrix_entries_[m] = entry.second;
+                    ++m;
+                }
+            }
+        },
+        256);
+}
+
+void LaplaceOperator::fill_laplace(const GeometryCache* cache)
+{
+    Rows& laplace = powers_[0];
+    const int n = int(mesh_.vertices_size());
+
+    parallel_for(
+        0, n,
+        [&](int i) {
+            const IndexType begin = laplace.offsets[i];
+            const IndexType end = laplace.offsets[i + 1];
+            if (begin == end)
+                return;
+
+            vertex_mass_[i] = cache ? cache->voronoi_area(Vertex(i)) : 1.0;
+
+            double sum = 0.0;
+            IndexType diagonal = begin;
+            for (IndexType j = begin; j < end; ++j)
+            {
+                const Edge e = entry_edges_[j];
+                if (e.is_valid())
+                {
+                    const double w =
+                        cache ? std::max(0.0, cache->cotan_weight(e)) : 1.0;
+                    laplace.values[j] = w;
+                    sum += w;
+                }
+                else
+                {
+                    diagonal = j;
+                }
+            }
+            laplace.values[diagonal] = -sum;
+        },
+        256);
+}
+
+void LaplaceOperator::fill_product(const Rows& a, Rows& product) const
+{
+    const Rows& laplace = powers_[0];
+    const int nf = int(free_.size());
+
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            // accumulate a row densely, then gather its entries
+            std::vector<double> sums(mesh_.vertices_size(), 0.0);
+            for (int r = first; r < last; ++r)
+            {
+                const IndexType i = free_[r].idx();
+                for (IndexType s = a.offsets[i]; s < a.offsets[i + 1]; ++s)
+                {
+                    // skip vertices without area, e.g., isolated ones
+                    const IndexType m = a.columns[s];
+                    if (vertex_mass_[m] <= 0.0)
+                        continue;
+
+                    const double f = a.values[s] / vertex_mass_[m];
+                    for (IndexType t = laplace.offsets[m];
+                         t < laplace.offsets[m + 1]; ++t)
+                        sums[laplace.columns[t]] += f * laplace.values[t];
+                }
+
+                for (IndexType s = product.offsets[i];
+                     s < product.offsets[i + 1]; ++s)
+                {
+                    product.values[s] = sums[product.columns[s]];
+                    sums[product.columns[s]] = 0.0;
+                }
+            }
+        },
+        scratch_chunk_size(nf));
+}
+
+} // namespace pmp
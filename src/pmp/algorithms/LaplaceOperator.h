@@ -0,0 +1,113 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Sparse>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+class GeometryCache;
+
+//! \brief Sparse Laplace, mass, and bi-Laplace matrices of a surface mesh.
+//! \details Sets up the Laplacian L with the weights max(0, cotan_weight())
+//! or uniform weights, the diagonal mass matrix M of the Voronoi areas or
+//! ones, and the powers L (M^-1 L)^(k-1), e.g., the bi-Laplacian L M^-1 L
+//! for k = 2. Rows and columns are restricted to a set of free vertices.
+//! The other vertices within reach of their rows are constraints, whose
+//! coupling to the free vertices is a separate matrix for the right hand
+//! side of linear systems.
+//!
+//! The sparsity patterns are computed once on construction, and the values
+//! are filled in directly, row by row in parallel, without triplet lists.
+//! As the matrices are symmetric, their compressed column storage equals
+//! compressed row storage. update() refills the values after the vertex
+//! positions changed without reallocating.
+//! \ingroup algorithms
+class LaplaceOperator
+{
+public:
+    //! symmetric sparse matrix
+    using SparseMatrix = Eigen::SparseMatrix<double>;
+
+    //! sparse matrix in compressed row storage
+    using RowMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+    //! \brief Set up the operator of degree \p k for \p free_vertices.
+    //! \details Row and column i of matrix() belong to the i-th free vertex.
+    //! \throw InvalidInputException if \p k is zero.
+    LaplaceOperator(SurfaceMesh& mesh, const std::vector<Vertex>& free_vertices,
+                    unsigned int k = 1, bool use_uniform_weights = false);
+
+    //! \brief Recompute the values for the current vertex positions.
+    //! \details The connectivity of the mesh must not have changed.
+    void update();
+
+    //! The operator L (M^-1 L)^(k-1) restricted to the free vertices.
+    const SparseMatrix& matrix() const { return matrix_; }
+
+    //! \brief Coupling of the free vertices to the constraints.
+    //! \details Column j belongs to the j-th constraint vertex. Given values
+    //! X_c at the constraints, solving matrix() X = -constraint_matrix() X_c
+    //! yields the values X at the free vertices.
+    const RowMatrix& constraint_matrix() const { return constraint_matrix_; }
+
+    //! The vertices coupled to the free vertices, sorted by index.
+    const std::vector<Vertex>& constraint_vertices() const
+    {
+        return constraints_;
+    }
+
+    //! The diagonal of the mass matrix M at the free vertices.
+    const Eigen::VectorXd& mass() const { return mass_; }
+
+private:
+    // a matrix indexed by vertices in compressed row storage, rows that
+    // are not needed are empty
+    struct Rows
+    {
+        std::vector<IndexType> offsets;
+        std::vector<IndexType> columns;
+        std::vector<double> values;
+    };
+
+    // set up the pattern of the rows of the Laplacian flagged in rows
+    void setup_laplace(const std::vector<bool>& rows);
+
+    // set up the pattern of the product of a, M^-1, and the Laplacian for
+    // the rows of the free vertices
+    void setup_product(const Rows& a, Rows& product) const;
+
+    // set up the patterns of matrix() and constraint_matrix()
+    void setup_restriction();
+
+    // fill in the values of the Laplacian, with uniform weights if cache
+    // is null
+    void fill_laplace(const GeometryCache* cache);
+
+    // fill in the values of the product of a, M^-1, and the Laplacian
+    void fill_product(const Rows& a, Rows& product) const;
+
+    SurfaceMesh& mesh_;
+    std::vector<Vertex> free_;
+    bool uniform_;
+
+    std::vector<Rows> powers_;        // L, L M^-1 L, ...
+    std::vector<Edge> entry_edges_;   // edge of each entry of L
+    std::vector<double> vertex_mass_; // mass per vertex
+
+    // entries of the highest power copied to the restrictions
+    std::vector<Vertex> constraints_;
+    std::vector<IndexType> matrix_entries_;
+    std::vector<IndexType> constraint_entries_;
+
+    SparseMatrix matrix_;
+    RowMatrix constraint_matrix_;
+    Eigen::VectorXd mass_;
+};
+
+} // namespace pmp
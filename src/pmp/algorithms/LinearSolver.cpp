@@ -0,0 +1,398 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/LinearSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef PMP_HAS_CHOLMOD
+#include <Eigen/CholmodSupport>
+#endif
+#ifdef PMP_HAS_PARDISO
+#include <Eigen/PardisoSupport>
+#endif
+
+#include "pmp/Types.h"
+
+namespace pmp {
+
+namespace {
+
+using SparseMatrix = LinearSolver::SparseMatrix;
+using RowMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+LinearSolver::Type default_solver_type = LinearSolver::Type::LDLT;
+
+// \brief Algebraic multigrid preconditioner for Eigen's iterative solvers.
+// \details Builds a hierarchy of coarser matrices by smoothed aggregation
+// and applies one symmetric V-cycle with damped Jacobi smoothing, solving
+// the coarsest level directly.
+class MultigridPreconditioner
+{
+public:
+    MultigridPreconditioner() : info_(Eigen::Success) {}
+
+    template <class MatrixType>
+    MultigridPreconditioner& analyzePattern(const MatrixType&)
+    {
+        return *this;
+    }
+
+    template <class MatrixType>
+    MultigridPreconditioner& factorize(const MatrixType& A)
+    {
+        levels_.clear();
+
+        RowMatrix a = A;
+        while (a.rows() > coarse_size && levels_.size() < max_levels)
+        {
+            Level level;
+            level.A = a;
+            level.inverse_diagonal = a.diagonal().cwiseInverse();
+            level.omega = 4.0 / (3.0 * spectral_radius(level));
+
+            // stop if aggregation does not reduce the size enough
+            std::vector<int> aggregates;
+            const int n_aggregates = aggregate(a, aggregates);
+            if (n_aggregates == 0 || n_aggregates > 0.9 * a.rows())
+                break;
+
+            // tentative prolongation of constants, smoothed by one Jacobi
+            // step
+            std::vector<Eigen::Triplet<double>> triplets;
+            for (int i = 0; i < int(a.rows()); ++i)
+                triplets.emplace_back(i, aggregates[i], 1.0);
+            RowMatrix tentative(a.rows(), n_aggregates);
+            tentative.setFromTriplets(triplets.begin(), triplets.end());
+            RowMatrix smoothing = level.inverse_diagonal.asDiagonal() * a;
+            smoothing *= level.omega;
+            const RowMatrix smoothed = smoothing * tentative;
+            level.P = tentative - smoothed;
+            level.R = level.P.transpose();
+
+            // Galerkin product for the next level
+            a = level.R * (a * level.P);
+            levels_.push_back(level);
+        }
+
+        coarse_.compute(SparseMatrix(a));
+        info_ = coarse_.info();
+        return *this;
+    }
+
+    template <class MatrixType>
+    MultigridPreconditioner& compute(const MatrixType& A)
+    {
+        analyzePattern(A);
+        return factorize(A);
+    }
+
+    template <class Rhs>
+    Eigen::VectorXd solve(const Rhs& b) const
+    {
+        Eigen::VectorXd x;
+        v_cycle(0, b, x);
+        return x;
+    }
+
+    Eigen::ComputationInfo info() const { return info_; }
+
+private:
+    struct Level
+    {
+        RowMatrix A, P, R;
+        Eigen::VectorXd inverse_diagonal;
+        double omega; // Jacobi damping
+    };
+
+    static const int coarse_size = 500;
+    static const size_t max_levels = 20;
+
+    // estimate the largest eigenvalue of D^-1 A by power iteration
+    static double spectral_radius(const Level& level)
+    {
+        Eigen::VectorXd x = Eigen::VectorXd::Ones(level.A.rows());
+        double lambda = 1.0;
+        for (int i = 0; i < 15; ++i)
+        {
+            x = level.inverse_diagonal.asDiagonal() * (level.A * x);
+            lambda = x.norm() / std::sqrt(double(x.size()));
+            if (lambda == 0.0)
+                return 1.0;
+            x /= x.norm() / std::sqrt(double(x.size()));
+        }
+        return lambda;
+    }
+
+    // group strongly connected unknowns, return the number of groups
+    static int aggregate(const RowMatrix& A, std::vector<int>& aggregates)
+    {
+        const int n = int(A.rows());
+        const double theta = 0.08;
+        const Eigen::VectorXd diagonal = A.diagonal().cwiseAbs();
+        auto is_strong = [&](int i, int j, double a) {
+            return i != j && a * a > theta * theta * diagonal[i] * diagonal[j];
+        };
+
+        aggregates.assign(n, -1);
+        int n_aggregates = 0;
+
+        // seeds whose strong neighbors are all free
+        for (int i = 0; i < n; ++i)
+        {
+            if (aggregates[i] != -1)
+                continue;
+            bool free = true;
+            for (RowMatrix::InnerIterator it(A, i); it && free; ++it)
+                if (is_strong(i, int(it.col()), it.value()) &&
+                    aggregates[it.col()] != -1)
+                    free = false;
+            if (!free)
+                continue;
+            aggregates[i] = n_aggregates;
+            for (RowMatrix::InnerIterator it(A, i); it; ++it)
+                if (is_strong(i, int(it.col()), it.value()))
+                    aggregates[it.col()] = n_aggregates;
+            ++n_aggregates;
+        }
+
+        // attach the rest to a strongly connected aggregate, or make them
+        // their own
+        std::vector<int> seeded = aggregates;
+        for (int i = 0; i < n; ++i)
+        {
+            if (aggregates[i] != -1)
+                continue;
+            for (RowMatrix::InnerIterator it(A, i); it; ++it)
+            {
+                if (is_strong(i, int(it.col()), it.value()) &&
+                    seeded[it.col()] != -1)
+                {
+                    aggregates[i] = seeded[it.col()];
+                    break;
+                }
+            }
+            if (aggregates[i] == -1)
+                aggregates[i] = n_aggregates++;
+        }
+
+        return n_aggregates;
+    }
+
+    // approximately solve A x = b on level l
+    template <class Rhs>
+    void v_cycle(size_t l, const Rhs& b, Eigen::VectorXd& x) const
+    {
+        if (l == levels_.size())
+        {
+            x = coarse_.solve(b);
+            return;
+        }
+
+        const Level& level = levels_[l];
+        const auto& D = level.inverse_diagonal;
+
+        // pre-smoothing from zero
+        x = level.omega * D.cwiseProduct(b);
+        x += level.omega * D.cwiseProduct(b - level.A * x);
+
+        // coarse grid correction
+        const Eigen::VectorXd coarse_b = level.R * (b - level.A * x);
+        Eigen::VectorXd coarse_x;
+        v_cycle(l + 1, coarse_b, coarse_x);
+        x += level.P * coarse_x;
+
+        // post-smoothing
+        for (int i = 0; i < 2; ++i)
+            x += level.omega * D.cwiseProduct(b - level.A * x);
+    }
+
+    std::vector<Level> levels_;
+    Eigen::SimplicialLDLT<SparseMatrix> coarse_;
+    Eigen::ComputationInfo info_;
+};
+
+} // namespace
+
+// interface of the backends
+class LinearSolver::Backend
+{
+public:
+    virtual ~Backend() = default;
+    virtual void analyze_pattern(const SparseMatrix& A) = 0;
+    virtual void factorize(const SparseMatrix& A) = 0;
+    virtual bool solve(const Eigen::MatrixXd& B, Eigen::MatrixXd& X) = 0;
+
+    double tolerance = 1e-10;
+    unsigned int max_iterations = 0;
+};
+
+// factorization by an Eigen solver or one of its wrappers
+template <class Solver>
+class LinearSolver::DirectBackend : public LinearSolver::Backend
+{
+public:
+    void analyze_pattern(const SparseMatrix& A) override
+    {
+        solver_.analyzePattern(A);
+    }
+
+    void factorize(const SparseMatrix& A) override { solver_.factorize(A); }
+
+    bool solve(const Eigen::MatrixXd& B, Eigen::MatrixXd& X) override
+    {
+        if (solver_.info() != Eigen::Success)
+            return false;
+        X = solver_.solve(B);
+        return solver_.info() == Eigen::Success;
+    }
+
+private:
+    Solver solver_;
+};
+
+// conjugate gradients, multi-threaded for row-major matrices and both
+// triangles
+template <class Preconditioner>
+class LinearSolver::IterativeBackend : public LinearSolver::Backend
+{
+public:
+    void analyze_pattern(const SparseMatrix& A) override
+    {
+        matrix_ = A;
+        solver_.analyzePattern(matrix_);
+    }
+
+    void factorize(const SparseMatrix& A) override
+    {
+        matrix_ = A;
+        solver_.factorize(matrix_);
+    }
+
+    bool solve(const Eigen::MatrixXd& B, Eigen::MatrixXd& X) override
+    {
+        if (solver_.info() != Eigen::Success)
+            return false;
+
+        solver_.setTolerance(tolerance);
+        if (max_iterations)
+            solver_.setMaxIterations(max_iterations);
+
+        // warm start from X if possible
+        const bool guess = X.rows() == B.rows() && X.cols() == B.cols();
+        if (!guess)
+            X.setZero(B.rows(), B.cols());
+        for (Eigen::Index j = 0; j < B.cols(); ++j)
+        {
+            X.col(j) = solver_.solveWithGuess(B.col(j), X.col(j));
+            if (solver_.info() != Eigen::Success)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    RowMatrix matrix_; // referenced by the solver
+    Eigen::ConjugateGradient<RowMatrix, Eigen::Lower | Eigen::Upper,
+                             Preconditioner>
+        solver_;
+};
+
+LinearSolver::LinearSolver(Type type) : type_(type)
+{
+    if (!is_available(type))
+        throw InvalidInputException("LinearSolver: Type is not available.");
+
+    switch (type)
+    {
+        case Type::LDLT:
+            backend_.reset(
+                new DirectBackend<Eigen::SimplicialLDLT<SparseMatrix>>());
+            break;
+#ifdef PMP_HAS_CHOLMOD
+        case Type::CholmodLLT:
+            backend_.reset(
+                new DirectBackend<Eigen::CholmodSupernodalLLT<SparseMatrix>>());
+            break;
+#endif
+#ifdef PMP_HAS_PARDISO
+        case Type::PardisoLDLT:
+            backend_.reset(
+                new DirectBackend<Eigen::PardisoLDLT<SparseMatrix>>());
+            break;
+#endif
+        case Type::ConjugateGradient:
+            backend_.reset(new IterativeBackend<
+                           Eigen::DiagonalPreconditioner<double>>());
+            break;
+        case Type::Multigrid:
+            backend_.reset(new IterativeBackend<MultigridPreconditioner>());
+            break;
+        default:
+            break;
+    }
+}
+
+LinearSolver::~LinearSolver() = default;
+
+bool LinearSolver::is_available(Type type)
+{
+    switch (type)
+    {
+        case Type::CholmodLLT:
+#ifdef PMP_HAS_CHOLMOD
+            return true;
+#else
+            return false;
+#endif
+        case Type::PardisoLDLT:
+#ifdef PMP_HAS_PARDISO
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+LinearSolver::Type LinearSolver::default_type()
+{
+    return default_solver_type;
+}
+
+void LinearSolver::set_default_type(Type type)
+{
+    if (!is_available(type))
+        throw InvalidInputException("LinearSolver: Type is not available.");
+    default_solver_type = type;
+}
+
+void LinearSolver::set_tolerance(double tolerance)
+{
+    backend_->tolerance = tolerance;
+}
+
+void LinearSolver::set_max_iterations(unsigned int iterations)
+{
+    backend_->max_iterations = iterations;
+}
+
+void LinearSolver::analyze_pattern(const SparseMatrix& A)
+{
+    backend_->analyze_pattern(A);
+}
+
+void LinearSolver::factorize(const SparseMatrix& A)
+{
+    backend_->factorize(A);
+}
+
+bool LinearSolver::solve(const Eigen::MatrixXd& B, Eigen::MatrixXd& X) const
+{
+    return backend_->solve(B, X);
+}
+
+} // namespace pmp
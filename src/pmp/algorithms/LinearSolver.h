@@ -0,0 +1,110 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <memory>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+namespace pmp {
+
+//! \brief Solver for sparse symmetric positive definite linear systems.
+//! \details Wraps several backends behind one interface. SurfaceSmoothing,
+//! SurfaceFairing, SurfaceParameterization, and SurfaceHoleFilling solve
+//! their systems with a solver of the default type, see set_default_type().
+//!
+//! The direct backends factorize the matrix, the symbolic analysis can be
+//! reused for matrices with the same sparsity pattern. The iterative
+//! backends run conjugate gradients with multi-threaded matrix products and
+//! start from the given solution, which is a good initial guess if the
+//! system describes a small change of the mesh.
+//! \ingroup algorithms
+class LinearSolver
+{
+public:
+    //! symmetric sparse matrix
+    using SparseMatrix = Eigen::SparseMatrix<double>;
+
+    //! solver backends
+    enum class Type
+    {
+        //! simplicial LDLT factorization of Eigen, always available
+        LDLT,
+
+        //! supernodal Cholesky factorization of CHOLMOD, if found on build
+        CholmodLLT,
+
+        //! LDLT factorization of Intel MKL Pardiso, if found on build
+        PardisoLDLT,
+
+        //! conjugate gradients with Jacobi preconditioner
+        ConjugateGradient,
+
+        //! conjugate gradients with algebraic multigrid preconditioner
+        Multigrid
+    };
+
+    //! Construct a solver of type \p type.
+    //! \throw InvalidInputException if the type is not available.
+    explicit LinearSolver(Type type = default_type());
+
+    //! destructor
+    ~LinearSolver();
+
+    //! Return whether the backend \p type is available in this build.
+    static bool is_available(Type type);
+
+    //! The type of solvers constructed without a type, LDLT by default.
+    static Type default_type();
+
+    //! \brief Set the type of solvers constructed without a type.
+    //! \throw InvalidInputException if the type is not available.
+    static void set_default_type(Type type);
+
+    //! the type of this solver
+    Type type() const { return type_; }
+
+    //! \brief Set the relative residual of the iterative backends.
+    //! \details Ignored by the direct backends. Default: 1e-10.
+    void set_tolerance(double tolerance);
+
+    //! \brief Set the maximum number of iterations of the iterative backends.
+    //! \details Ignored by the direct backends. Zero, the default, allows
+    //! twice the number of unknowns.
+    void set_max_iterations(unsigned int iterations);
+
+    //! Analyze the sparsity pattern of \p A.
+    void analyze_pattern(const SparseMatrix& A);
+
+    //! \brief Factorize \p A, or set up the preconditioner of the iterative
+    //! backends.
+    //! \details \p A must have the pattern last passed to analyze_pattern().
+    void factorize(const SparseMatrix& A);
+
+    //! Analyze the pattern of \p A and factorize it.
+    void compute(const SparseMatrix& A)
+    {
+        analyze_pattern(A);
+        factorize(A);
+    }
+
+    //! \brief Solve A X = B for the last factorized matrix A.
+    //! \details The iterative backends start from \p X if it has the size of
+    //! \p B, and from zero otherwise.
+    //! \return whether the factorization and the solve succeeded
+    bool solve(const Eigen::MatrixXd& B, Eigen::MatrixXd& X) const;
+
+private:
+    class Backend;
+    template <class Solver>
+    class DirectBackend;
+    template <class Preconditioner>
+    class IterativeBackend;
+
+    Type type_;
+    std::unique_ptr<Backend> backend_;
+};
+
+} // namespace pmp
@@ -0,0 +1,255 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/PointKdTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pmp/BoundingBox.h"
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+namespace {
+
+// limit of the tree depth, which bounds the traversal stack
+const unsigned int depth_limit = 60;
+
+// consecutive points of batched queries handled by one thread
+const int query_chunk_size = 256;
+
+} // namespace
+
+PointKdTree::PointKdTree(const SurfaceMesh& mesh, unsigned int max_points)
+{
+    points_.reserve(mesh.n_vertices());
+    vertices_.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        points_.push_back(mesh.position(v));
+        vertices_.push_back(v);
+    }
+    build(max_points);
+}
+
+PointKdTree::PointKdTree(const std::vector<Point>& points,
+                         unsigned int max_points)
+    : points_(points)
+{
+    vertices_.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        vertices_.push_back(Vertex(IndexType(i)));
+    build(max_points);
+}
+
+void PointKdTree::build(unsigned int max_points)
+{
+    if (points_.empty())
+        return;
+
+    // sort an index array and reorder the points once at the end
+    std::vector<IndexType> order(points_.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = IndexType(i);
+
+    // a balanced tree has fewer than 2n / max_points nodes
+    max_points = std::max(max_points, 1u);
+    nodes_.reserve(2 * points_.size() / max_points + 1);
+    build_recurse(order, 0, IndexType(order.size()), max_points, 0);
+
+    std::vector<Point> points(order.size());
+    std::vector<Vertex> vertices(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        points[i] = points_[order[i]];
+        vertices[i] = vertices_[order[i]];
+    }
+    points_.swap(points);
+    vertices_.swap(vertices);
+}
+
+void PointKdTree::build_recurse(std::vector<IndexType>& order,
+                                IndexType begin, IndexType end,
+                                unsigned int max_points, unsigned int depth)
+{
+    const IndexType node_index = IndexType(nodes_.size());
+    nodes_.push_back(Node{0, begin, end - begin, 3});
+    if (end - begin <= max_points || depth >= depth_limit)
+        return;
+
+    // split at the median of the longest side of the bounding box
+    BoundingBox bb;
+    for (IndexType i = begin; i < end; ++i)
+        bb += points_[order[i]];
+    const Point size = bb.max() - bb.min();
+    int axis = 0;
+    if (size[1] > size[axis])
+        axis = 1;
+    if (size[2] > size[axis])
+        axis = 2;
+    if (size[axis] <= 0)
+        return; // all points coincide
+
+    // the left points are not greater than the split, the right ones not
+    // smaller
+    const IndexType mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid,
+                     order.begin() + end, [&](IndexType a, IndexType b) {
+                         return points_[a][axis] < points_[b][axis];
+                     });
+    const Scalar split = points_[order[mid]][axis];
+
+    build_recurse(order, begin, mid, max_points, depth + 1);
+    const IndexType right = IndexType(nodes_.size());
+    build_recurse(order, mid, end, max_points, depth + 1);
+
+    Node& node = nodes_[node_index];
+    node.split = split;
+    node.index = right;
+    node.n_points = 0;
+    node.axis = (unsigned char)axis;
+}
+
+template <class Visit>
+void PointKdTree::traverse(const Point& p, Scalar& bound, Visit visit) const
+{
+    if (nodes_.empty())
+        return;
+
+    // nodes to visit and the squared distance to their splitting plane, the
+    // far children are only visited if they are closer than the bound
+    struct Entry
+    {
+        IndexType node;
+        Scalar sqrdist;
+    };
+    Entry stack[depth_limit + 2];
+    int top = 0;
+    stack[top++] = Entry{0, 0};
+
+    while (top > 0)
+    {
+        const Entry entry = stack[--top];
+        if (entry.sqrdist > bound)
+            continue;
+
+        const Node& node = nodes_[entry.node];
+
+        // terminal node? test its points
+        if (node.axis == 3)
+        {
+            const IndexType end = node.index + node.n_points;
+            for (IndexType i = node.index; i < end; ++i)
+                visit(i, sqrnorm(points_[i] - p));
+        }
+
+        // non-terminal node
+        else
+        {
+            const Scalar dist = p[node.axis] - node.split;
+            const IndexType left = entry.node + 1, right = node.index;
+            if (dist <= 0.0)
+            {
+                stack[top++] = Entry{right, dist * dist};
+                stack[top++] = Entry{left, 0};
+            }
+            else
+            {
+                stack[top++] = Entry{left, dist * dist};
+                stack[top++] = Entry{right, 0};
+            }
+        }
+    }
+}
+
+PointKdTree::Neighbor PointKdTree::nearest(const Point& p) const
+{
+    Scalar bound = std::numeric_limits<Scalar>::max();
+    IndexType best = PMP_MAX_INDEX;
+    traverse(p, bound, [&](IndexType i, Scalar d) {
+        if (d < bound)
+        {
+            bound = d;
+            best = i;
+        }
+    });
+
+    if (best == PMP_MAX_INDEX)
+        return Neighbor{Vertex(), std::numeric_limits<Scalar>::max()};
+    return Neighbor{vertices_[best], std::sqrt(bound)};
+}
+
+std::vector<PointKdTree::Neighbor> PointKdTree::k_nearest(const Point& p,
+                                                          unsigned int k) const
+{
+    // max-heap of the squared distances of the k nearest points so far
+    std::vector<std::pair<Scalar, IndexType>> heap;
+    Scalar bound = std::numeric_limits<Scalar>::max();
+    if (k > 0)
+    {
+        heap.reserve(k);
+        traverse(p, bound, [&](IndexType i, Scalar d) {
+            if (d >= bound)
+                return;
+            if (heap.size() == k)
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+            heap.emplace_back(d, i);
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() == k)
+                bound = heap.front().first;
+        });
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<Neighbor> result;
+    result.reserve(heap.size());
+    for (const auto& h : heap)
+        result.push_back(Neighbor{vertices_[h.second], std::sqrt(h.first)});
+    return result;
+}
+
+std::vector<PointKdTree::Neighbor> PointKdTree::within_radius(
+    const Point& p, Scalar radius) const
+{
+    std::vector<std::pair<Scalar, IndexType>> found;
+    Scalar bound = radius * radius;
+    traverse(p, bound, [&](IndexType i, Scalar d) {
+        if (d <= bound)
+            found.emplace_back(d, i);
+    });
+
+    std::sort(found.begin(), found.end());
+    std::vector<Neighbor> result;
+    result.reserve(found.size());
+    for (const auto& f : found)
+        result.push_back(Neighbor{vertices_[f.second], std::sqrt(f.first)});
+    return result;
+}
+
+void PointKdTree::k_nearest(const std::vector<Point>& points, unsigned int k,
+                            std::vector<std::vector<Neighbor>>& result) const
+{
+    result.resize(points.size());
+    parallel_for(
+        0, int(points.size()),
+        [&](int i) { result[i] = k_nearest(points[i], k); },
+        query_chunk_size);
+}
+
+void PointKdTree::within_radius(
+    const std::vector<Point>& points, Scalar radius,
+    std::vector<std::vector<Neighbor>>& result) const
+{
+    result.resize(points.size());
+    parallel_for(
+        0, int(points.size()),
+        [&](int i) { result[i] = within_radius(points[i], radius); },
+        query_chunk_size);
+}
+
+} // namespace pmp
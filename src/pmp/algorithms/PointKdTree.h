@@ -0,0 +1,96 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A k-d tree for points, e.g., the vertices of a point cloud.
+//! \details The points are split at the median of the longest side of their
+//! bounding box, such that the tree is balanced. The nodes are stored in one
+//! array in depth-first order, and the points of each leaf are stored
+//! contiguously. The batched queries handle the points in parallel.
+//! \ingroup algorithms
+class PointKdTree
+{
+public:
+    //! \brief Construct with the vertices of \p mesh.
+    //! \details Nodes with at most \p max_points points become leaves.
+    explicit PointKdTree(const SurfaceMesh& mesh,
+                         unsigned int max_points = 16);
+
+    //! \brief Construct with \p points.
+    //! \details The vertex handles of the neighbors are the indices of the
+    //! points. Nodes with at most \p max_points points become leaves.
+    explicit PointKdTree(const std::vector<Point>& points,
+                         unsigned int max_points = 16);
+
+    //! neighbor found by a query
+    struct Neighbor
+    {
+        Vertex vertex; //!< vertex of the point
+        Scalar dist;   //!< distance to the query point
+    };
+
+    //! \brief Return the point nearest to \p p.
+    //! \details The vertex is invalid if the tree is empty.
+    Neighbor nearest(const Point& p) const;
+
+    //! \brief Return the \p k points nearest to \p p.
+    //! \details The points are sorted by increasing distance. Fewer are
+    //! returned if the tree has less than \p k points.
+    std::vector<Neighbor> k_nearest(const Point& p, unsigned int k) const;
+
+    //! \brief Return all points within distance \p radius of \p p.
+    //! \details The points are sorted by increasing distance.
+    std::vector<Neighbor> within_radius(const Point& p, Scalar radius) const;
+
+    //! \brief Find the \p k nearest points of all \p points in parallel.
+    //! \details The i-th entry of \p result are the neighbors of the i-th
+    //! point, as returned by k_nearest(const Point&, unsigned int).
+    void k_nearest(const std::vector<Point>& points, unsigned int k,
+                   std::vector<std::vector<Neighbor>>& result) const;
+
+    //! \brief Find the points within \p radius of all \p points in parallel.
+    //! \details The i-th entry of \p result are the neighbors of the i-th
+    //! point, as returned by within_radius(const Point&, Scalar).
+    void within_radius(const std::vector<Point>& points, Scalar radius,
+                       std::vector<std::vector<Neighbor>>& result) const;
+
+    //! number of nodes of the tree
+    size_t n_nodes() const { return nodes_.size(); }
+
+private:
+    // node of the tree, its left child directly follows it
+    struct Node
+    {
+        Scalar split;       // splitting plane of inner nodes
+        IndexType index;    // right child, or first point of a leaf
+        IndexType n_points; // number of points of a leaf
+        unsigned char axis; // splitting axis, or 3 for leaves
+    };
+
+    // sort the points into the tree
+    void build(unsigned int max_points);
+
+    // build the subtree of the points order[begin, end) at the given depth,
+    // reordering them such that the points of each leaf are contiguous
+    void build_recurse(std::vector<IndexType>& order, IndexType begin,
+                       IndexType end, unsigned int max_points,
+                       unsigned int depth);
+
+    // call visit(i, sqrdist) for the leaf points i that may be closer to p
+    // than the squared distance bound, which visit may decrease
+    template <class Visit>
+    void traverse(const Point& p, Scalar& bound, Visit visit) const;
+
+    std::vector<Node> nodes_;
+    std::vector<Point> points_;    // points in leaf order
+    std::vector<Vertex> vertices_; // vertex per leaf point
+};
+
+} // namespace pmp
@@ -0,0 +1,196 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/PointNormals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/PointKdTree.h"
+
+namespace pmp {
+
+namespace {
+
+typedef std::vector<std::vector<PointKdTree::Neighbor>> Neighborhoods;
+
+// the k nearest neighbors of each vertex, not including itself
+void nearest_neighbors(const SurfaceMesh& cloud, unsigned int k,
+                       std::vector<Vertex>& vertices,
+                       Neighborhoods& neighbors)
+{
+    vertices.clear();
+    std::vector<Point> points;
+    vertices.reserve(cloud.n_vertices());
+    points.reserve(cloud.n_vertices());
+    for (auto v : cloud.vertices())
+    {
+        vertices.push_back(v);
+        points.push_back(cloud.position(v));
+    }
+
+    PointKdTree tree(cloud);
+    tree.k_nearest(points, k + 1, neighbors);
+
+    parallel_for(0, int(vertices.size()), [&](int i) {
+        auto& n = neighbors[i];
+        n.erase(std::remove_if(n.begin(), n.end(),
+                               [&](const PointKdTree::Neighbor& nb) {
+                                   return nb.vertex == vertices[i];
+                               }),
+                n.end());
+        if (n.size() > k)
+            n.resize(k);
+    });
+}
+
+// orient along a minimum spanning tree of the symmetric neighbor graph
+void orient_along_tree(SurfaceMesh& cloud,
+                       const std::vector<Vertex>& vertices,
+                       const Neighborhoods& neighbors)
+{
+    auto normals = cloud.vertex_property<Normal>("v:normal");
+    const size_t n = vertices.size();
+
+    // the graph in compressed rows, with the edges of both directions
+    std::vector<IndexType> index(cloud.vertices_size(), PMP_MAX_INDEX);
+    for (size_t i = 0; i < n; ++i)
+        index[vertices[i].idx()] = IndexType(i);
+    std::vector<IndexType> offsets(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+        for (const auto& nb : neighbors[i])
+        {
+            ++offsets[i + 1];
+            ++offsets[index[nb.vertex.idx()] + 1];
+        }
+    for (size_t i = 0; i < n; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<IndexType> edges(offsets[n]);
+    std::vector<IndexType> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+        for (const auto& nb : neighbors[i])
+        {
+            const IndexType j = index[nb.vertex.idx()];
+            edges[fill[i]++] = j;
+            edges[fill[j]++] = IndexType(i);
+        }
+
+    // the first unvisited vertex by decreasing height is the highest one of
+    // its component
+    std::vector<IndexType> by_height(n);
+    for (size_t i = 0; i < n; ++i)
+        by_height[i] = IndexType(i);
+    std::sort(by_height.begin(), by_height.end(),
+              [&](IndexType a, IndexType b) {
+                  const Scalar za = cloud.position(vertices[a])[2];
+                  const Scalar zb = cloud.position(vertices[b])[2];
+                  return za > zb || (za == zb && a < b);
+              });
+
+    // Prim's algorithm, costs are low for parallel normals
+    typedef std::tuple<Scalar, IndexType, IndexType> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    std::vector<char> visited(n, 0);
+    auto visit = [&](IndexType i) {
+        visited[i] = 1;
+        const Normal& ni = normals[vertices[i]];
+        for (IndexType e = offsets[i]; e < offsets[i + 1]; ++e)
+        {
+            const IndexType j = edges[e];
+            if (!visited[j])
+                queue.emplace(1 - std::fabs(dot(ni, normals[vertices[j]])),
+                              j, i);
+        }
+    };
+
+    for (auto seed : by_height)
+    {
+        if (visited[seed])
+            continue;
+
+        Normal& ns = normals[vertices[seed]];
+        if (ns[2] < 0)
+            ns = -ns;
+        visit(seed);
+
+        while (!queue.empty())
+        {
+            const IndexType j = std::get<1>(queue.top());
+            const IndexType i = std::get<2>(queue.top());
+            queue.pop();
+            if (visited[j])
+                continue;
+
+            Normal& nj = normals[vertices[j]];
+            if (dot(normals[vertices[i]], nj) < 0)
+                nj = -nj;
+            visit(j);
+        }
+    }
+}
+
+} // namespace
+
+void PointNormals::compute_normals(SurfaceMesh& cloud, unsigned int k,
+                                   bool orient)
+{
+    std::vector<Vertex> vertices;
+    Neighborhoods neighbors;
+    nearest_neighbors(cloud, k, vertices, neighbors);
+
+    auto normals = cloud.vertex_property<Normal>("v:normal");
+    parallel_for(
+        0, int(vertices.size()),
+        [&](int i) {
+            const Vertex v = vertices[i];
+            const auto& nbs = neighbors[i];
+
+            // the normal of the plane through the neighborhood is the
+            // eigenvector of the smallest eigenvalue of the covariance
+            dvec3 center = (dvec3)cloud.position(v);
+            for (const auto& nb : nbs)
+                center += (dvec3)cloud.position(nb.vertex);
+            center /= double(nbs.size() + 1);
+
+            dmat3 covariance(0.0);
+            auto add = [&](Vertex w) {
+                const dvec3 d = (dvec3)cloud.position(w) - center;
+                for (int r = 0; r < 3; ++r)
+                    for (int c = 0; c < 3; ++c)
+                        covariance(r, c) += d[r] * d[c];
+            };
+            add(v);
+            for (const auto& nb : nbs)
+                add(nb.vertex);
+
+            double eval1, eval2, eval3;
+            dvec3 evec1, evec2, evec3;
+            if (nbs.size() >= 2 &&
+                symmetric_eigendecomposition(covariance, eval1, eval2, eval3,
+                                             evec1, evec2, evec3))
+                normals[v] = (Normal)normalize(evec3);
+            else
+                normals[v] = Normal(0, 0, 0);
+        },
+        256);
+
+    if (orient)
+        orient_along_tree(cloud, vertices, neighbors);
+}
+
+void PointNormals::orient_normals(SurfaceMesh& cloud, unsigned int k)
+{
+    if (!cloud.has_vertex_property("v:normal"))
+        throw InvalidInputException("PointNormals: Missing vertex normals.");
+
+    std::vector<Vertex> vertices;
+    Neighborhoods neighbors;
+    nearest_neighbors(cloud, k, vertices, neighbors);
+    orient_along_tree(cloud, vertices, neighbors);
+}
+
+} // namespace pmp
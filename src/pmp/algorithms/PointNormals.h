@@ -0,0 +1,42 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Normal estimation for point clouds.
+//! \details Works on the vertices of a mesh, e.g., a point cloud read from
+//! an XYZ or AGI file, and ignores its faces. The neighborhoods are the k
+//! nearest vertices found with a PointKdTree. See \cite hoppe_1992_surface
+//! for a description of the method.
+//! \ingroup algorithms
+class PointNormals
+{
+public:
+    // delete default and copy constructor
+    PointNormals() = delete;
+    PointNormals(const PointNormals&) = delete;
+
+    //! \brief Estimate the normals of all vertices of \p cloud.
+    //! \details Fits a plane to each vertex and its \p k nearest neighbors
+    //! by principal component analysis, in parallel, and stores the plane
+    //! normals in the vertex property "v:normal". If \p orient is true, the
+    //! normals are oriented consistently by orient_normals(), otherwise
+    //! their signs are arbitrary.
+    static void compute_normals(SurfaceMesh& cloud, unsigned int k = 10,
+                                bool orient = true);
+
+    //! \brief Orient the normals "v:normal" of \p cloud consistently.
+    //! \details Propagates the orientation along a minimum spanning tree of
+    //! the graph connecting each vertex to its \p k nearest neighbors, whose
+    //! edges are cheaper the more parallel the normals of their vertices
+    //! are. In each connected component, the normal of the vertex with the
+    //! largest z-coordinate points upwards.
+    //! \throw InvalidInputException if \p cloud has no vertex normals.
+    static void orient_normals(SurfaceMesh& cloud, unsigned int k = 10);
+};
+
+} // namespace pmp
@@ -0,0 +1,146 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/ProgressiveMesh.h"
+
+namespace pmp {
+
+void ProgressiveMesh::reset(const SurfaceMesh& mesh)
+{
+    if (!mesh.is_triangle_mesh())
+        throw InvalidInputException("Input is not a pure triangle mesh!");
+
+    n_vertices_ = mesh.n_vertices();
+    positions_.resize(mesh.vertices_size());
+    deleted_.resize(mesh.vertices_size());
+    for (size_t i = 0; i < mesh.vertices_size(); ++i)
+    {
+        positions_[i] = mesh.position(Vertex(i));
+        deleted_[i] = mesh.is_deleted(Vertex(i));
+    }
+
+    indices_.clear();
+    indices_.reserve(3 * mesh.n_faces());
+    for (auto f : mesh.faces())
+        for (auto v : mesh.vertices(f))
+            indices_.push_back(v.idx());
+
+    splits_.clear();
+}
+
+void ProgressiveMesh::add_collapse(Vertex v0, Vertex v1, Vertex vl, Vertex vr)
+{
+    splits_.push_back(VertexSplit{v0.idx(), v1.idx(), vl.idx(), vr.idx()});
+}
+
+SurfaceMesh ProgressiveMesh::lod(size_t n_collapses) const
+{
+    std::vector<Point> positions;
+    std::vector<std::vector<IndexType>> indices;
+    lod_buffers(std::vector<size_t>(1, n_collapses), positions, indices);
+
+    // drop the vertices removed by the collapses
+    positions.resize(n_vertices_ - n_collapses);
+
+    SurfaceMesh mesh;
+    mesh.from_indexed_faces(positions, indices[0]);
+
+    // drop isolated vertices
+    for (auto v : mesh.vertices())
+        if (mesh.is_isolated(v))
+            mesh.delete_vertex(v);
+    mesh.garbage_collection();
+
+    return mesh;
+}
+
+void ProgressiveMesh::lod_buffers(
+    const std::vector<size_t>& levels, std::vector<Point>& positions,
+    std::vector<std::vector<IndexType>>& indices) const
+{
+    for (auto level : levels)
+        if (level > splits_.size())
+            throw InvalidInputException("Level of detail out of range");
+
+    // vertices still present at the coarsest level first, in input order,
+    // followed by the removed ones from the last collapse to the first
+    std::vector<IndexType> order(positions_.size(), PMP_MAX_INDEX);
+    std::vector<bool> removed(positions_.size(), false);
+    for (const auto& s : splits_)
+        removed[s.vertex] = true;
+
+    positions.clear();
+    positions.reserve(n_vertices_);
+    for (size_t i = 0; i < positions_.size(); ++i)
+    {
+        if (!deleted_[i] && !removed[i])
+        {
+            order[i] = positions.size();
+            positions.push_back(positions_[i]);
+        }
+    }
+    for (size_t i = splits_.size(); i-- > 0;)
+    {
+        const IndexType v = splits_[i].vertex;
+        order[v] = positions.size();
+        positions.push_back(positions_[v]);
+    }
+
+    indices.clear();
+    indices.reserve(levels.size());
+    for (auto level : levels)
+    {
+        auto map = representatives(level);
+        for (auto& i : map)
+            if (i != PMP_MAX_INDEX)
+                i = order[i];
+        indices.push_back(triangles(level, map));
+    }
+}
+
+std::vector<IndexType> ProgressiveMesh::representatives(
+    size_t n_collapses) const
+{
+    std::vector<IndexType> map(positions_.size());
+    for (size_t i = 0; i < map.size(); ++i)
+        map[i] = deleted_[i] ? PMP_MAX_INDEX : IndexType(i);
+
+    // a parent is only collapsed later than its children, so walking
+    // backwards resolves chains of collapses
+    for (size_t i = n_collapses; i-- > 0;)
+        map[splits_[i].vertex] = map[splits_[i].parent];
+
+    return map;
+}
+
+std::vector<IndexType> ProgressiveMesh::triangles(
+    size_t n_collapses, const std::vector<IndexType>& map) const
+{
+    // every collapse removes one triangle per valid opposite vertex
+    size_t n_triangles = indices_.size() / 3;
+    for (size_t i = 0; i < n_collapses; ++i)
+    {
+        if (splits_[i].left != PMP_MAX_INDEX)
+            --n_triangles;
+        if (splits_[i].right != PMP_MAX_INDEX)
+            --n_triangles;
+    }
+
+    std::vector<IndexType> result;
+    result.reserve(3 * n_triangles);
+    for (size_t i = 0; i < indices_.size(); i += 3)
+    {
+        const IndexType a = map[indices_[i]];
+        const IndexType b = map[indices_[i + 1]];
+        const IndexType c = map[indices_[i + 2]];
+        if (a != b && b != c && c != a)
+        {
+            result.push_back(a);
+            result.push_back(b);
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+} // namespace pmp
@@ -0,0 +1,83 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A triangle mesh together with a sequence of halfedge collapses.
+//! \details Recorded by SurfaceSimplification::simplify(). Vertices are
+//! referenced by their indices in the full-resolution mesh, i.e., before the
+//! garbage collection at the end of the simplification. Any intermediate
+//! level of detail can be extracted without repeating the simplification.
+//! \ingroup algorithms
+class ProgressiveMesh
+{
+public:
+    //! \brief The record of a halfedge collapse, undone by a vertex split.
+    //! \details \c vertex was collapsed into \c parent. \c left and \c right
+    //! are the opposite vertices of the two removed triangles, or
+    //! PMP_MAX_INDEX at the boundary.
+    struct VertexSplit
+    {
+        IndexType vertex;
+        IndexType parent;
+        IndexType left;
+        IndexType right;
+    };
+
+    //! \brief Reset to the triangle mesh \p mesh without collapses.
+    //! \throw InvalidInputException if \p mesh is not a triangle mesh.
+    void reset(const SurfaceMesh& mesh);
+
+    //! Append the collapse of \p v0 into \p v1 with the opposite vertices
+    //! \p vl and \p vr, which may be invalid at the boundary.
+    void add_collapse(Vertex v0, Vertex v1, Vertex vl, Vertex vr);
+
+    //! number of vertices of the full-resolution mesh
+    size_t n_vertices() const { return n_vertices_; }
+
+    //! number of recorded collapses, i.e., of levels of detail minus one
+    size_t n_collapses() const { return splits_.size(); }
+
+    //! the recorded collapses in the order they were performed
+    const std::vector<VertexSplit>& vertex_splits() const { return splits_; }
+
+    //! \brief Extract the level of detail after the first \p n_collapses
+    //! collapses.
+    //! \details Level 0 is the full-resolution mesh, n_collapses() the fully
+    //! simplified one. Unreferenced vertices are omitted.
+    //! \throw InvalidInputException if \p n_collapses exceeds n_collapses().
+    SurfaceMesh lod(size_t n_collapses) const;
+
+    //! \brief Index buffers of several levels of detail sharing one vertex
+    //! buffer.
+    //! \details Vertices are ordered by the level they are removed at, the
+    //! vertices still present after the last collapse come first, so each
+    //! level uses a prefix of \p positions. \p indices receives a triangle
+    //! index buffer for each entry of \p levels, given as number of collapses.
+    //! \throw InvalidInputException if a level exceeds n_collapses().
+    void lod_buffers(const std::vector<size_t>& levels,
+                     std::vector<Point>& positions,
+                     std::vector<std::vector<IndexType>>& indices) const;
+
+private:
+    // map each vertex to its representative after n_collapses collapses
+    std::vector<IndexType> representatives(size_t n_collapses) const;
+
+    // triangles after n_collapses collapses, with vertices mapped by map
+    std::vector<IndexType> triangles(size_t n_collapses,
+                                     const std::vector<IndexType>& map) const;
+
+    size_t n_vertices_ = 0;
+    std::vector<Point> positions_;   // indexed like the input mesh
+    std::vector<bool> deleted_;      // deleted vertices of the input mesh
+    std::vector<IndexType> indices_; // triangles of the input mesh
+    std::vector<VertexSplit> splits_;
+};
+
+} // namespace pmp
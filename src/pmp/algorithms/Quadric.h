@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cmath>
+
 #include "pmp/Types.h"
 
 namespace pmp {
@@ -19,18 +21,18 @@ public: // clang-format off
             double e, double f, double g,
             double h, double i,
             double j)
-        : a_(a), b_(b), c_(c), d_(d),
-          e_(e), f_(f), g_(g),
-          h_(h), i_(i),
-          j_(j)
+        : m_{a, b, c, d,
+             e, f, g,
+             h, i,
+             j}
     {}
 
     //! constructor quadric from given plane equation: ax+by+cz+d=0
     Quadric(double a=0.0, double b=0.0, double c=0.0, double d=0.0)
-        :  a_(a*a), b_(a*b), c_(a*c),  d_(a*d),
-           e_(b*b), f_(b*c), g_(b*d),
-           h_(c*c), i_(c*d),
-           j_(d*d)
+        : m_{a*a, a*b, a*c, a*d,
+             b*b, b*c, b*d,
+             c*c, c*d,
+             d*d}
     {}
 
     //! construct from point and normal specifying a plane
@@ -40,25 +42,25 @@ public: // clang-format off
     }
 
     //! set all matrix entries to zero
-    void clear() { a_ = b_ = c_ = d_ = e_ = f_ = g_ = h_ = i_ = j_ = 0.0; }
+    void clear()
+    {
+        for (int k = 0; k < 10; ++k)
+            m_[k] = 0.0;
+    }
 
     //! add given quadric to this quadric
     Quadric& operator+=(const Quadric& q)
     {
-        a_ += q.a_; b_ += q.b_; c_ += q.c_; d_ += q.d_;
-        e_ += q.e_; f_ += q.f_; g_ += q.g_;
-        h_ += q.h_; i_ += q.i_;
-        j_ += q.j_;
+        for (int k = 0; k < 10; ++k)
+            m_[k] += q.m_[k];
         return *this;
     }
 
     //! multiply quadric by a scalar
     Quadric& operator*=(double s)
     {
-        a_ *= s; b_ *= s; c_ *= s;  d_ *= s;
-        e_ *= s; f_ *= s; g_ *= s;
-        h_ *= s; i_ *= s;
-        j_ *= s;
+        for (int k = 0; k < 10; ++k)
+            m_[k] *= s;
         return *this;
     }
 
@@ -66,18 +68,78 @@ public: // clang-format off
     double operator()(const Point& p) const
     {
         const double x(p[0]), y(p[1]), z(p[2]);
-        return a_*x*x + 2.0*b_*x*y + 2.0*c_*x*z + 2.0*d_*x
-            +  e_*y*y + 2.0*f_*y*z + 2.0*g_*y
-            +  h_*z*z + 2.0*i_*z
-            +  j_;
+        return x*(a()*x + 2.0*(b()*y + c()*z + d()))
+            +  y*(e()*y + 2.0*(f()*z + g()))
+            +  z*(h()*z + 2.0*i())
+            +  j();
+    }
+
+    //! \brief Evaluate the quadric at the \p n positions \p points, storing
+    //! the results in \p errors.
+    //! \details Faster than evaluating the points one by one, since the
+    //! independent evaluations are vectorized by the compiler. Used to compare
+    //! several candidate positions of a collapse.
+    void evaluate(const Point* points, size_t n, double* errors) const
+    {
+        const double a2 = 2.0*b(), a3 = 2.0*c(), a4 = 2.0*d();
+        const double b3 = 2.0*f(), b4 = 2.0*g(), c4 = 2.0*i();
+        for (size_t k = 0; k < n; ++k)
+        {
+            const double x(points[k][0]), y(points[k][1]), z(points[k][2]);
+            errors[k] = x*(a()*x + a2*y + a3*z + a4)
+                      + y*(e()*y + b3*z + b4)
+                      + z*(h()*z + c4)
+                      + j();
+        }
+    }
+
+    //! \brief Find the point minimizing the quadric that is closest to
+    //! \p center.
+    //! \details Directions in which the quadric is nearly constant, i.e.,
+    //! whose eigenvalue is below \p tolerance times the largest one, are
+    //! left unchanged. This keeps the result near \p center for flat or
+    //! degenerate quadrics, see \cite lindstrom_2000_oocs.
+    Point minimizer(const Point& center, double tolerance = 1e-3) const
+    {
+        Eigen::Matrix3d A;
+        A << a(), b(), c(),
+             b(), e(), f(),
+             c(), f(), h();
+        const Eigen::Vector3d u(d(), g(), i());
+        const Eigen::Vector3d x(center[0], center[1], center[2]);
+
+        // pseudo-inverse of A applied to the gradient at center
+        const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(A);
+        const Eigen::Vector3d& lambda = solver.eigenvalues();
+        const Eigen::Matrix3d& V = solver.eigenvectors();
+        const double threshold = tolerance * lambda.cwiseAbs().maxCoeff();
+        const Eigen::Vector3d r = V.transpose() * -(A * x + u);
+        Eigen::Vector3d y = Eigen::Vector3d::Zero();
+        for (int k = 0; k < 3; ++k)
+            if (std::abs(lambda[k]) > threshold && lambda[k] != 0.0)
+                y[k] = r[k] / lambda[k];
+
+        const Eigen::Vector3d p = x + V * y;
+        return Point(p[0], p[1], p[2]);
     }
 
 private:
 
-    double a_, b_, c_, d_,
-        e_, f_, g_,
-        h_, i_,
-        j_;
+    // matrix entries, named as in the constructor
+    double a() const { return m_[0]; }
+    double b() const { return m_[1]; }
+    double c() const { return m_[2]; }
+    double d() const { return m_[3]; }
+    double e() const { return m_[4]; }
+    double f() const { return m_[5]; }
+    double g() const { return m_[6]; }
+    double h() const { return m_[7]; }
+    double i() const { return m_[8]; }
+    double j() const { return m_[9]; }
+
+    // upper triangle of the matrix, stored contiguously such that adding
+    // and scaling quadrics is vectorized
+    double m_[10];
 }; // clang-format on
 
 } // namespace pmp
@@ -0,0 +1,134 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/QuadricClustering.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "pmp/SurfaceMeshIO.h"
+
+namespace pmp {
+
+size_t QuadricClustering::CellKeyHash::operator()(const CellKey& k) const
+{
+    return std::hash<int64_t>()(k.x * 73856093 ^ k.y * 19349663 ^
+                                k.z * 83492791);
+}
+
+size_t QuadricClustering::TriangleHash::operator()(const Triangle& t) const
+{
+    return std::hash<size_t>()(t[0] * 73856093 ^ t[1] * 19349663 ^
+                               t[2] * 83492791);
+}
+
+QuadricClustering::QuadricClustering(Scalar cell_size) : cell_size_(cell_size)
+{
+    if (!(cell_size > 0))
+        throw InvalidInputException("Cell size must be positive");
+}
+
+IndexType QuadricClustering::cell(const Point& p)
+{
+    const CellKey key{int64_t(std::floor(p[0] / cell_size_)),
+                      int64_t(std::floor(p[1] / cell_size_)),
+                      int64_t(std::floor(p[2] / cell_size_))};
+    auto it = cell_index_.find(key);
+    if (it == cell_index_.end())
+    {
+        it = cell_index_.emplace(key, IndexType(cells_.size())).first;
+        cells_.emplace_back();
+    }
+    return it->second;
+}
+
+void QuadricClustering::add_triangle(const Point& p0, const Point& p1,
+                                     const Point& p2)
+{
+    Triangle t{cell(p0), cell(p1), cell(p2)};
+
+    // plane quadric weighted by the triangle area
+    const Normal n = cross(p1 - p0, p2 - p0);
+    const Scalar l = norm(n);
+    Quadric q;
+    if (l > 0)
+    {
+        q = Quadric(n / l, p0);
+        q *= 0.5 * l;
+    }
+
+    const Point* p[3] = {&p0, &p1, &p2};
+    for (int i = 0; i < 3; ++i)
+    {
+        Cell& c = cells_[t[i]];
+        c.quadric += q;
+        c.sum += *p[i];
+        ++c.n_points;
+    }
+
+    if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+        return;
+
+    // rotate the smallest index to the front to keep the orientation
+    while (t[0] > t[1] || t[0] > t[2])
+        t = Triangle{t[1], t[2], t[0]};
+    triangles_.insert(t);
+}
+
+void QuadricClustering::add_faces(StreamingMeshReader& in)
+{
+    for (auto event = in.next(); event != StreamingMeshReader::Event::End;
+         event = in.next())
+    {
+        if (event != StreamingMeshReader::Event::Face)
+            continue;
+
+        const auto& face = in.face();
+        for (size_t i = 2; i < face.size(); ++i)
+            add_triangle(in.position(face[0]), in.position(face[i - 1]),
+                         in.position(face[i]));
+    }
+}
+
+void QuadricClustering::add_faces(const SurfaceMesh& mesh)
+{
+    std::vector<Vertex> vertices;
+    for (auto f : mesh.faces())
+    {
+        vertices.clear();
+        for (auto v : mesh.vertices(f))
+            vertices.push_back(v);
+
+        for (size_t i = 2; i < vertices.size(); ++i)
+            add_triangle(mesh.position(vertices[0]),
+                         mesh.position(vertices[i - 1]),
+                         mesh.position(vertices[i]));
+    }
+}
+
+SurfaceMesh QuadricClustering::mesh() const
+{
+    SurfaceMesh mesh;
+    for (const auto& c : cells_)
+        mesh.add_vertex(c.quadric.minimizer(c.sum / Scalar(c.n_points)));
+
+    // sort the triangles for a deterministic result
+    std::vector<Triangle> triangles(triangles_.begin(), triangles_.end());
+    std::sort(triangles.begin(), triangles.end());
+
+    IndexedFaces faces;
+    faces.indices.reserve(3 * triangles.size());
+    for (const auto& t : triangles)
+        faces.indices.insert(faces.indices.end(), t.begin(), t.end());
+    SurfaceMeshIO::add_faces(mesh, faces);
+
+    // drop cells without triangles
+    for (auto v : mesh.vertices())
+        if (mesh.is_isolated(v))
+            mesh.delete_vertex(v);
+    mesh.garbage_collection();
+
+    return mesh;
+}
+
+} // namespace pmp
@@ -0,0 +1,105 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "pmp/StreamingMesh.h"
+#include "pmp/SurfaceMesh.h"
+#include "pmp/algorithms/Quadric.h"
+
+namespace pmp {
+
+//! \brief Out-of-core simplification by clustering vertices in a uniform
+//! grid.
+//! \details Consumes a triangle soup in a single pass. Each triangle adds its
+//! area-weighted plane quadric to the grid cells of its corners and is kept
+//! if the corners fall into three different cells. Each cell becomes one
+//! output vertex at the minimizer of its quadric. Memory use is proportional
+//! to the output, not to the input. See \cite lindstrom_2000_oocs.
+//!
+//! The result is a good starting point for a final SurfaceSimplification
+//! pass in memory.
+//!
+//! Example:
+//! \code
+//! QuadricClustering clustering(0.01);
+//! StreamingMeshReader reader("huge.smb");
+//! clustering.add_faces(reader);
+//! SurfaceMesh mesh = clustering.mesh();
+//! \endcode
+//! \ingroup algorithms
+class QuadricClustering
+{
+public:
+    //! \brief Construct with the edge length \p cell_size of the grid cells.
+    //! \throw InvalidInputException if \p cell_size is not positive.
+    explicit QuadricClustering(Scalar cell_size);
+
+    //! Add the triangle \p p0, \p p1, \p p2 of the soup.
+    void add_triangle(const Point& p0, const Point& p1, const Point& p2);
+
+    //! Add all faces of the streaming mesh \p in, triangulated as fans.
+    void add_faces(StreamingMeshReader& in);
+
+    //! Add all faces of \p mesh, triangulated as fans.
+    void add_faces(const SurfaceMesh& mesh);
+
+    //! number of occupied grid cells, i.e., of output vertices
+    size_t n_cells() const { return cells_.size(); }
+
+    //! number of output triangles
+    size_t n_triangles() const { return triangles_.size(); }
+
+    //! \brief Build the simplified mesh.
+    //! \details Non-manifold configurations are split as when reading a mesh,
+    //! see SurfaceMeshIO::add_faces().
+    SurfaceMesh mesh() const;
+
+private:
+    // grid coordinates of a cell
+    struct CellKey
+    {
+        bool operator==(const CellKey& rhs) const
+        {
+            return x == rhs.x && y == rhs.y && z == rhs.z;
+        }
+        int64_t x, y, z;
+    };
+
+    struct CellKeyHash
+    {
+        size_t operator()(const CellKey& k) const;
+    };
+
+    // accumulated data of a cell
+    struct Cell
+    {
+        Quadric quadric;
+        Point sum = Point(0, 0, 0);
+        size_t n_points = 0;
+    };
+
+    // cell indices of an output triangle
+    using Triangle = std::array<IndexType, 3>;
+
+    struct TriangleHash
+    {
+        size_t operator()(const Triangle& t) const;
+    };
+
+    // index of the cell containing p, adding it if needed
+    IndexType cell(const Point& p);
+
+    Scalar cell_size_;
+    std::unordered_map<CellKey, IndexType, CellKeyHash> cell_index_;
+    std::vector<Cell> cells_;
+    std::unordered_set<Triangle, TriangleHash> triangles_;
+};
+
+} // namespace pmp
@@ -0,0 +1,293 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/StreamingProcessing.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pmp {
+
+namespace {
+
+// grid coordinates of a cell
+struct CellKey
+{
+    bool operator==(const CellKey& rhs) const
+    {
+        return x == rhs.x && y == rhs.y && z == rhs.z;
+    }
+    int64_t x, y, z;
+};
+
+struct CellKeyHash
+{
+    size_t operator()(const CellKey& k) const
+    {
+        return std::hash<int64_t>()(k.x * 73856093 ^ k.y * 19349663 ^
+                                    k.z * 83492791);
+    }
+};
+
+// cluster ids of an output triangle
+using Triangle = std::array<size_t, 3>;
+
+struct TriangleHash
+{
+    size_t operator()(const Triangle& t) const
+    {
+        return std::hash<size_t>()(t[0] * 73856093 ^ t[1] * 19349663 ^
+                                   t[2] * 83492791);
+    }
+};
+
+// streaming vertex clustering. A cluster is open while it has active
+// vertices, closed and written once all of them are finalized, and dropped
+// once all its triangles are written.
+class VertexClustering
+{
+public:
+    VertexClustering(StreamingMeshWriter& out, Scalar cell_size)
+        : out_(out), cell_size_(cell_size), n_clusters_(0), n_triangles_(0)
+    {
+    }
+
+    void add_vertex(IndexType v, const Point& p)
+    {
+        const CellKey key{int64_t(std::floor(p[0] / cell_size_)),
+                          int64_t(std::floor(p[1] / cell_size_)),
+                          int64_t(std::floor(p[2] / cell_size_))};
+        auto it = open_.find(key);
+        if (it == open_.end())
+        {
+            it = open_.emplace(key, n_clusters_).first;
+            clusters_[n_clusters_++].key = key;
+        }
+
+        Cluster& c = clusters_[it->second];
+        c.sum += p;
+        ++c.n_vertices;
+        ++c.n_active;
+        vertex_cluster_[v] = it->second;
+    }
+
+    void add_face(const std::vector<IndexType>& vertices)
+    {
+        // clusters of the face, without repetitions of adjacent ones
+        ids_.clear();
+        for (auto v : vertices)
+        {
+            const size_t id = vertex_cluster_[v];
+            if (ids_.empty() || ids_.back() != id)
+                ids_.push_back(id);
+        }
+        while (ids_.size() > 1 && ids_.back() == ids_.front())
+            ids_.pop_back();
+
+        for (size_t i = 2; i < ids_.size(); ++i)
+            add_triangle(ids_[0], ids_[i - 1], ids_[i]);
+    }
+
+    void finalize_vertex(IndexType v)
+    {
+        const auto it = vertex_cluster_.find(v);
+        const size_t id = it->second;
+        vertex_cluster_.erase(it);
+        if (--clusters_[id].n_active == 0)
+            close(id);
+    }
+
+private:
+    struct Cluster
+    {
+        CellKey key;
+        Point sum = Point(0, 0, 0);
+        size_t n_vertices = 0;
+        size_t n_active = 0;
+        bool closed = false;
+        IndexType output = 0;
+
+        // pending triangles referencing the cluster, may contain triangles
+        // written since
+        std::vector<size_t> triangles;
+        size_t n_pending = 0;
+
+        // triangles starting with this cluster, to detect duplicates
+        std::vector<Triangle> keys;
+    };
+
+    void add_triangle(size_t a, size_t b, size_t c)
+    {
+        if (a == b || b == c || c == a)
+            return;
+
+        // rotate the smallest id to the front to keep the orientation
+        Triangle t{a, b, c};
+        while (t[0] > t[1] || t[0] > t[2])
+            t = Triangle{t[1], t[2], t[0]};
+        if (!written_.insert(t).second)
+            return;
+        clusters_[t[0]].keys.push_back(t);
+
+        pending_[n_triangles_] = t;
+        for (auto id : t)
+        {
+            clusters_[id].triangles.push_back(n_triangles_);
+            ++clusters_[id].n_pending;
+        }
+        ++n_triangles_;
+    }
+
+    void close(size_t id)
+    {
+        Cluster& c = clusters_[id];
+        c.closed = true;
+        c.output = out_.add_vertex(c.sum / Scalar(c.n_vertices));
+        open_.erase(c.key);
+
+        // write the triangles whose clusters are all closed now
+        std::vector<size_t> triangles;
+        triangles.swap(c.triangles);
+        for (auto t : triangles)
+        {
+            const auto it = pending_.find(t);
+            if (it == pending_.end())
+                continue;
+            const Triangle tri = it->second;
+            if (!clusters_[tri[0]].closed || !clusters_[tri[1]].closed ||
+                !clusters_[tri[2]].closed)
+            {
+                clusters_[id].triangles.push_back(t);
+                continue;
+            }
+
+            out_.add_face({clusters_[tri[0]].output, clusters_[tri[1]].output,
+                           clusters_[tri[2]].output});
+            pending_.erase(it);
+            for (auto other : tri)
+            {
+                --clusters_[other].n_pending;
+                if (other != id)
+                    drop(other);
+            }
+        }
+        drop(id);
+    }
+
+    // finalize and forget a closed cluster without pending triangles
+    void drop(size_t id)
+    {
+        const auto it = clusters_.find(id);
+        if (!it->second.closed || it->second.n_pending)
+            return;
+        out_.finalize(it->second.output);
+        for (const auto& t : it->second.keys)
+            written_.erase(t);
+        clusters_.erase(it);
+    }
+
+    StreamingMeshWriter& out_;
+    Scalar cell_size_;
+
+    std::unordered_map<size_t, Cluster> clusters_;
+    std::unordered_map<CellKey, size_t, CellKeyHash> open_;
+    std::unordered_map<IndexType, size_t> vertex_cluster_;
+    std::unordered_map<size_t, Triangle> pending_;
+    std::unordered_set<Triangle, TriangleHash> written_;
+    size_t n_clusters_;
+    size_t n_triangles_;
+
+    std::vector<size_t> ids_;
+};
+
+} // namespace
+
+void StreamingProcessing::compute_vertex_normals(StreamingMeshReader& in,
+                                                 const VertexCallback& callback)
+{
+    std::unordered_map<IndexType, Normal> normals;
+
+    for (auto event = in.next(); event != StreamingMeshReader::Event::End;
+         event = in.next())
+    {
+        switch (event)
+        {
+            case StreamingMeshReader::Event::Vertex:
+                normals[in.vertex()] = Normal(0, 0, 0);
+                break;
+
+            case StreamingMeshReader::Event::Face:
+            {
+                // sum the corner normals weighted by their angles
+                const auto& face = in.face();
+                const size_t n = face.size();
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const Point& p = in.position(face[i]);
+                    const Point d0 = in.position(face[(i + 1) % n]) - p;
+                    const Point d1 = in.position(face[(i + n - 1) % n]) - p;
+                    const Normal c = cross(d0, d1);
+                    const Scalar l = norm(c);
+                    if (l > std::numeric_limits<Scalar>::min())
+                        normals[face[i]] += c / l * std::atan2(l, dot(d0, d1));
+                }
+                break;
+            }
+
+            case StreamingMeshReader::Event::Finalize:
+            {
+                const auto it = normals.find(in.vertex());
+                const Scalar l = norm(it->second);
+                callback(in.vertex(), in.position(in.vertex()),
+                         l > 0 ? Normal(it->second / l) : it->second);
+                normals.erase(it);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+void StreamingProcessing::cluster_vertices(StreamingMeshReader& in,
+                                           StreamingMeshWriter& out,
+                                           Scalar cell_size)
+{
+    if (!(cell_size > 0))
+        throw InvalidInputException("Cell size must be positive");
+
+    VertexClustering clustering(out, cell_size);
+    for (auto event = in.next(); event != StreamingMeshReader::Event::End;
+         event = in.next())
+    {
+        if (event == StreamingMeshReader::Event::Vertex)
+            clustering.add_vertex(in.vertex(), in.position(in.vertex()));
+        else if (event == StreamingMeshReader::Event::Face)
+            clustering.add_face(in.face());
+        else if (event == StreamingMeshReader::Event::Finalize)
+            clustering.finalize_vertex(in.vertex());
+    }
+}
+
+void StreamingProcessing::copy(StreamingMeshReader& in,
+                               StreamingMeshWriter& out)
+{
+    // the writer numbers vertices in the same order as the reader
+    for (auto event = in.next(); event != StreamingMeshReader::Event::End;
+         event = in.next())
+    {
+        if (event == StreamingMeshReader::Event::Vertex)
+            out.add_vertex(in.position(in.vertex()));
+        else if (event == StreamingMeshReader::Event::Face)
+            out.add_face(in.face());
+        else if (event == StreamingMeshReader::Event::Finalize)
+            out.finalize(in.vertex());
+    }
+}
+
+} // namespace pmp
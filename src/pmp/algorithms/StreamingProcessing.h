@@ -0,0 +1,52 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <functional>
+
+#include "pmp/StreamingMesh.h"
+
+namespace pmp {
+
+//! \brief Processing of streaming meshes in bounded memory.
+//! \details The functions read a StreamingMeshReader once from front to
+//! back and keep only data of the active vertices, so their memory use
+//! depends on the width of the stream instead of the size of the mesh.
+//! \ingroup algorithms
+class StreamingProcessing
+{
+public:
+    // delete default and copy constructor
+    StreamingProcessing() = delete;
+    StreamingProcessing(const StreamingProcessing&) = delete;
+
+    //! \brief Receives a finalized vertex with its index, position, and
+    //! normal.
+    using VertexCallback =
+        std::function<void(IndexType, const Point&, const Normal&)>;
+
+    //! \brief Compute angle-weighted vertex normals.
+    //! \details Calls \p callback for each vertex when it is finalized,
+    //! i.e., once all its incident faces are read. Normals of isolated
+    //! vertices are zero.
+    static void compute_vertex_normals(StreamingMeshReader& in,
+                                       const VertexCallback& callback);
+
+    //! \brief Simplify by clustering the vertices in a uniform grid.
+    //! \details Vertices in the same cell of size \p cell_size are merged
+    //! into their mean position, faces are triangulated and kept if their
+    //! vertices fall into three different cells. A cell is written once all
+    //! its vertices are finalized, later vertices in the same cell start a
+    //! new cluster. See \cite lindstrom_2000_oocs for the out-of-core
+    //! variant of the algorithm.
+    //! \throw InvalidInputException if \p cell_size is not positive.
+    static void cluster_vertices(StreamingMeshReader& in,
+                                 StreamingMeshWriter& out, Scalar cell_size);
+
+    //! \brief Copy \p in to \p out, e.g., to convert between the ASCII and
+    //! the binary format.
+    static void copy(StreamingMeshReader& in, StreamingMeshWriter& out);
+};
+
+} // namespace pmp
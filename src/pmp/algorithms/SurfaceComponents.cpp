@@ -0,0 +1,334 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfaceComponents.h"
+
+#include <atomic>
+
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/DifferentialGeometry.h"
+
+namespace pmp {
+
+namespace {
+
+// the component of each vertex, edge, and face, -1 if deleted
+struct Labels
+{
+    std::vector<int> vertex, edge, face;
+    size_t n_components = 0;
+};
+
+// root of the set of i, halving the path on the way. the parent of an
+// element is never larger than the element, such that the root of each set
+// is its smallest element.
+IndexType find_root(std::vector<std::atomic<IndexType>>& parent, IndexType i)
+{
+    while (true)
+    {
+        IndexType p = parent[i].load(std::memory_order_relaxed);
+        if (p == i)
+            return i;
+        const IndexType gp = parent[p].load(std::memory_order_relaxed);
+        if (gp != p)
+            parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+        i = gp;
+    }
+}
+
+// merge the sets of a and b by linking the larger root to the smaller one
+void unite(std::vector<std::atomic<IndexType>>& parent, IndexType a,
+           IndexType b)
+{
+    while (true)
+    {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+        if (a == b)
+            return;
+        if (a < b)
+            std::swap(a, b);
+
+        // fails if another thread has linked a in the meantime
+        IndexType expected = a;
+        if (parent[a].compare_exchange_strong(expected, b,
+                                              std::memory_order_relaxed))
+            return;
+    }
+}
+
+Labels compute_labels(const SurfaceMesh& mesh)
+{
+    const int nv(mesh.vertices_size()), ne(mesh.edges_size()),
+        nf(mesh.faces_size());
+
+    std::vector<std::atomic<IndexType>> parent(nv);
+    parallel_for(0, nv, [&](int i) {
+        parent[i].store(IndexType(i), std::memory_order_relaxed);
+    });
+    parallel_for(mesh.edges(), [&](Edge e) {
+        unite(parent, mesh.vertex(e, 0).idx(), mesh.vertex(e, 1).idx());
+    });
+
+    // once all sets are merged the roots no longer change
+    Labels labels;
+    labels.vertex.resize(nv);
+    parallel_for(0, nv, [&](int i) {
+        labels.vertex[i] = int(find_root(parent, IndexType(i)));
+    });
+
+    // number the roots in the order of the vertices, each root is the first
+    // vertex of its component
+    std::vector<int> number(nv, -1);
+    for (int i = 0; i < nv; ++i)
+        if (!mesh.is_deleted(Vertex(i)) && labels.vertex[i] == i)
+            number[i] = int(labels.n_components++);
+
+    parallel_for(0, nv, [&](int i) {
+        labels.vertex[i] =
+            mesh.is_deleted(Vertex(i)) ? -1 : number[labels.vertex[i]];
+    });
+
+    labels.edge.resize(ne);
+    parallel_for(0, ne, [&](int i) {
+        const Edge e(i);
+        labels.edge[i] = mesh.is_deleted(e)
+                             ? -1
+                             : labels.vertex[mesh.vertex(e, 0).idx()];
+    });
+
+    labels.face.resize(nf);
+    parallel_for(0, nf, [&](int i) {
+        const Face f(i);
+        labels.face[i] =
+            mesh.is_deleted(f)
+                ? -1
+                : labels.vertex[mesh.to_vertex(mesh.halfedge(f)).idx()];
+    });
+
+    return labels;
+}
+
+// statistics of the labeled components
+std::vector<SurfaceComponents::Component> statistics(const SurfaceMesh& mesh,
+                                                     const Labels& labels)
+{
+    // the areas of the faces in parallel, summed in a fixed order below
+    const int nf(mesh.faces_size());
+    std::vector<Scalar> areas(nf, 0);
+    parallel_for(mesh.faces(), [&](Face f) {
+        const Halfedge h0 = mesh.halfedge(f);
+        const Point& p0 = mesh.position(mesh.from_vertex(h0));
+        Scalar area = 0;
+        for (Halfedge h = mesh.next_halfedge(h0);
+             mesh.to_vertex(h) != mesh.from_vertex(h0);
+             h = mesh.next_halfedge(h))
+            area += triangle_area(p0, mesh.position(mesh.from_vertex(h)),
+                                  mesh.position(mesh.to_vertex(h)));
+        areas[f.idx()] = area;
+    });
+
+    std::vector<SurfaceComponents::Component> components(labels.n_components);
+    std::vector<double> sums(labels.n_components, 0.0);
+    for (int c : labels.vertex)
+        if (c >= 0)
+            ++components[c].n_vertices;
+    for (int i = 0; i < nf; ++i)
+    {
+        const int c = labels.face[i];
+        if (c < 0)
+            continue;
+        ++components[c].n_faces;
+        sums[c] += areas[i];
+    }
+    for (size_t c = 0; c < components.size(); ++c)
+        components[c].area = Scalar(sums[c]);
+
+    return components;
+}
+
+// the elements of each component in increasing order, and the index of each
+// element within its component
+struct Partition
+{
+    std::vector<size_t> offsets, elements;
+    std::vector<IndexType> local;
+
+    Partition(const std::vector<int>& labels, size_t n_components)
+        : offsets(n_components + 1, 0), local(labels.size(), PMP_MAX_INDEX)
+    {
+        for (int c : labels)
+            if (c >= 0)
+                ++offsets[c + 1];
+        for (size_t c = 0; c < n_components; ++c)
+            offsets[c + 1] += offsets[c];
+
+        elements.resize(offsets[n_components]);
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < labels.size(); ++i)
+        {
+            const int c = labels[i];
+            if (c < 0)
+                continue;
+            local[i] = IndexType(fill[c] - offsets[c]);
+            elements[fill[c]++] = i;
+        }
+    }
+
+    std::vector<size_t> order(size_t c) const
+    {
+        return std::vector<size_t>(elements.begin() + offsets[c],
+                                   elements.begin() + offsets[c + 1]);
+    }
+};
+
+} // namespace
+
+std::vector<SurfaceComponents::Component> SurfaceComponents::label(
+    SurfaceMesh& mesh)
+{
+    const auto labels = compute_labels(mesh);
+
+    auto vcomponent = mesh.vertex_property<int>("v:component", -1);
+    auto fcomponent = mesh.face_property<int>("f:component", -1);
+    parallel_for(0, int(mesh.vertices_size()), [&](int i) {
+        vcomponent[Vertex(i)] = labels.vertex[i];
+    });
+    parallel_for(0, int(mesh.faces_size()),
+                 [&](int i) { fcomponent[Face(i)] = labels.face[i]; });
+
+    return statistics(mesh, labels);
+}
+
+std::vector<SurfaceMesh> SurfaceComponents::split(const SurfaceMesh& mesh)
+{
+    const auto labels = compute_labels(mesh);
+    const Partition vertices(labels.vertex, labels.n_components);
+    const Partition edges(labels.edge, labels.n_components);
+    const Partition faces(labels.face, labels.n_components);
+
+    // the parts start as copies sharing the properties of the source, which
+    // therefore has neither an edge index nor free lists to copy
+    SurfaceMesh source = mesh;
+    source.set_edge_index(false);
+    source.clear_free_lists();
+
+    auto local_halfedge = [&](Halfedge h) {
+        if (!h.is_valid())
+            return h;
+        return Halfedge((edges.local[h.idx() >> 1] << 1) + (h.idx() & 1));
+    };
+
+    std::vector<SurfaceMesh> parts(labels.n_components);
+    parallel_for(
+        0, int(parts.size()),
+        [&](int c) {
+            SurfaceMesh& part = parts[c];
+            part = source;
+
+            // select the elements of the component
+            const auto vorder = vertices.order(c);
+            const auto eorder = edges.order(c);
+            const auto forder = faces.order(c);
+            std::vector<size_t> horder(2 * eorder.size());
+            for (size_t i = 0; i < eorder.size(); ++i)
+            {
+                horder[2 * i] = 2 * eorder[i];
+                horder[2 * i + 1] = 2 * eorder[i] + 1;
+            }
+
+            for (auto a : part.vprops_.arrays())
+                a->permute(vorder);
+            for (auto a : part.hprops_.arrays())
+                a->permute(horder);
+            for (auto a : part.eprops_.arrays())
+                a->permute(eorder);
+            for (auto a : part.fprops_.arrays())
+                a->permute(forder);
+            part.vprops_.resize(vorder.size());
+            part.hprops_.resize(horder.size());
+            part.eprops_.resize(eorder.size());
+            part.fprops_.resize(forder.size());
+
+            // the connectivity still refers to the elements of the source
+            for (size_t i = 0; i < vorder.size(); ++i)
+            {
+                auto& vc = part.vconn_[Vertex(IndexType(i))];
+                vc.halfedge_ = local_halfedge(vc.halfedge_);
+            }
+            for (size_t i = 0; i < horder.size(); ++i)
+            {
+                auto& hc = part.hconn_[Halfedge(IndexType(i))];
+                hc.vertex_ = Vertex(vertices.local[hc.vertex_.idx()]);
+                hc.next_halfedge_ = local_halfedge(hc.next_halfedge_);
+                hc.prev_halfedge_ = local_halfedge(hc.prev_halfedge_);
+                if (hc.face_.is_valid())
+                    hc.face_ = Face(faces.local[hc.face_.idx()]);
+            }
+            for (size_t i = 0; i < forder.size(); ++i)
+            {
+                auto& fc = part.fconn_[Face(IndexType(i))];
+                fc.halfedge_ = local_halfedge(fc.halfedge_);
+            }
+
+            part.deleted_vertices_ = 0;
+            part.deleted_edges_ = 0;
+            part.deleted_faces_ = 0;
+            part.has_garbage_ = false;
+            part.set_edge_index(mesh.has_edge_index());
+        },
+        1);
+
+    return parts;
+}
+
+size_t SurfaceComponents::remove_small(SurfaceMesh& mesh, size_t min_faces,
+                                       Scalar min_area)
+{
+    const auto labels = compute_labels(mesh);
+    const auto components = statistics(mesh, labels);
+
+    std::vector<char> small(components.size(), 0);
+    size_t n_small = 0;
+    for (size_t c = 0; c < components.size(); ++c)
+        if (components[c].n_faces < min_faces || components[c].area < min_area)
+        {
+            small[c] = 1;
+            ++n_small;
+        }
+    if (n_small == 0)
+        return 0;
+
+    // deleting whole components leaves the connectivity of the remaining
+    // elements intact, so the flags are set directly
+    auto is_small = [&](int c) { return c >= 0 && small[c]; };
+    auto count = [&](const std::vector<int>& l) {
+        return parallel_reduce(
+            0, int(l.size()), size_t(0),
+            [&](int i) { return size_t(is_small(l[i])); },
+            [](size_t a, size_t b) { return a + b; });
+    };
+
+    parallel_for(0, int(mesh.vertices_size()), [&](int i) {
+        if (is_small(labels.vertex[i]))
+            mesh.vdeleted_[Vertex(i)] = true;
+    });
+    parallel_for(0, int(mesh.edges_size()), [&](int i) {
+        if (is_small(labels.edge[i]))
+            mesh.edeleted_[Edge(i)] = true;
+    });
+    parallel_for(0, int(mesh.faces_size()), [&](int i) {
+        if (is_small(labels.face[i]))
+            mesh.fdeleted_[Face(i)] = true;
+    });
+
+    mesh.deleted_vertices_ += IndexType(count(labels.vertex));
+    mesh.deleted_edges_ += IndexType(count(labels.edge));
+    mesh.deleted_faces_ += IndexType(count(labels.face));
+    mesh.has_garbage_ = true;
+    mesh.garbage_collection();
+
+    return n_small;
+}
+
+} // namespace pmp
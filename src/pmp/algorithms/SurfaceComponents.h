@@ -0,0 +1,58 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Connected components of a surface mesh.
+//! \details Two vertices are in the same component if they are connected by
+//! a path of edges. The components are found in parallel by a lock-free
+//! union-find over the edges, such that meshes with many small fragments,
+//! e.g., from 3D scans, are handled in a single pass.
+//! \ingroup algorithms
+class SurfaceComponents
+{
+public:
+    // delete default and copy constructor
+    SurfaceComponents() = delete;
+    SurfaceComponents(const SurfaceComponents&) = delete;
+
+    //! statistics of a connected component
+    struct Component
+    {
+        size_t n_vertices = 0; //!< number of vertices
+        size_t n_faces = 0;    //!< number of faces
+        Scalar area = 0;       //!< surface area, polygons are fanned
+    };
+
+    //! \brief Label the connected components of \p mesh.
+    //! \details Stores the index of the component of each vertex and face in
+    //! the int properties "v:component" and "f:component", deleted elements
+    //! get -1. The components are numbered in the order of their first
+    //! vertex, isolated vertices are components without faces.
+    //! \return The statistics of each component.
+    static std::vector<Component> label(SurfaceMesh& mesh);
+
+    //! \brief Split \p mesh into one mesh per connected component.
+    //! \details The i-th mesh is the i-th component as numbered by label().
+    //! The meshes are built in parallel and keep all properties of their
+    //! elements, which are in the same order as in \p mesh. Deleted elements
+    //! are dropped.
+    static std::vector<SurfaceMesh> split(const SurfaceMesh& mesh);
+
+    //! \brief Delete the components with fewer than \p min_faces faces or
+    //! with an area smaller than \p min_area.
+    //! \details All small components are deleted in one parallel pass,
+    //! followed by a single garbage collection. Isolated vertices are
+    //! removed for any \p min_faces greater than zero.
+    //! \return The number of deleted components.
+    static size_t remove_small(SurfaceMesh& mesh, size_t min_faces,
+                               Scalar min_area = 0);
+};
+
+} // namespace pmp
@@ -2,8 +2,15 @@
 // Distributed under a MIT-style license, see LICENSE.txt for details.
 
 #include "pmp/algorithms/SurfaceCurvature.h"
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
 #include "pmp/algorithms/SurfaceNormals.h"
 #include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/GeometryCache.h"
+#include "pmp/algorithms/TextureMapping.h"
+
+#include <cmath>
+#include <vector>
 
 namespace pmp {
 
@@ -21,42 +28,46 @@ SurfaceCurvature::~SurfaceCurvature()
 
 void SurfaceCurvature::analyze(unsigned int post_smoothing_steps)
 {
-    Scalar kmin, kmax, mean, gauss;
-    Scalar area, sum_angles;
-    Scalar weight, sum_weights;
-    Point p0, p1, p2, laplace;
+    analyze(SurfaceAdjacency(mesh_), post_smoothing_steps);
+}
+
+void SurfaceCurvature::analyze(const SurfaceAdjacency& adjacency,
+                               unsigned int post_smoothing_steps)
+{
+    PMP_PROFILE_SCOPE("SurfaceCurvature::analyze");
+
+    assert(adjacency.vertices_size() == mesh_.vertices_size());
 
-    // cotan weight per edge
-    auto cotan = mesh_.add_edge_property<double>("curv:cotan");
-    for (auto e : mesh_.edges())
-        cotan[e] = cotan_weight(mesh_, e);
+    GeometryCache cache(mesh_);
+    cache.update();
 
     // Voronoi area per vertex
     // Laplace per vertex
     // angle sum per vertex
     // -> mean, Gauss -> min, max curvature
-    for (auto v : mesh_.vertices())
-    {
-        kmin = kmax = 0.0;
+    parallel_for(mesh_.vertices(), [&](Vertex v) {
+        Scalar kmin = 0.0, kmax = 0.0;
 
         if (!mesh_.is_isolated(v) && !mesh_.is_boundary(v))
         {
-            laplace = Point(0.0);
-            sum_weights = 0.0;
-            sum_angles = 0.0;
-            p0 = mesh_.position(v);
+            Point laplace(0.0);
+            Scalar sum_weights = 0.0;
+            Scalar sum_angles = 0.0;
+            const Point p0 = mesh_.position(v);
 
             // Voronoi area
-            area = voronoi_area(mesh_, v);
+            const Scalar area = cache.voronoi_area(v);
 
             // Laplace & angle sum
-            for (auto vh : mesh_.halfedges(v))
+            const auto ring = adjacency.vertex_vertices(v);
+            const auto hring = adjacency.vertex_halfedges(v);
+            const size_t k = ring.size();
+            for (size_t i = 0; i < k; ++i)
             {
-                p1 = mesh_.position(mesh_.to_vertex(vh));
-                p2 = mesh_.position(
-                    mesh_.to_vertex(mesh_.ccw_rotated_halfedge(vh)));
+                Point p1 = mesh_.position(ring[i]);
+                Point p2 = mesh_.position(ring[i + 1 < k ? i + 1 : 0]);
 
-                weight = cotan[mesh_.edge(vh)];
+                const Scalar weight = cache.cotan_weight(mesh_.edge(hring[i]));
                 sum_weights += weight;
                 laplace += weight * p1;
 
@@ -69,8 +80,8 @@ void SurfaceCurvature::analyze(unsigned int post_smoothing_steps)
             laplace -= sum_weights * mesh_.position(v);
             laplace /= Scalar(2.0) * area;
 
-            mean = Scalar(0.5) * norm(laplace);
-            gauss = (2.0 * M_PI - sum_angles) / area;
+            const Scalar mean = Scalar(0.5) * norm(laplace);
+            const Scalar gauss = (2.0 * M_PI - sum_angles) / area;
 
             const Scalar s = sqrt(std::max(Scalar(0.0), mean * mean - gauss));
             kmin = mean - s;
@@ -79,221 +90,221 @@ void SurfaceCurvature::analyze(unsigned int post_smoothing_steps)
 
         min_curvature_[v] = kmin;
         max_curvature_[v] = kmax;
-    }
+    });
 
-    // boundary vertices: interpolate from interior neighbors
-    for (auto v : mesh_.vertices())
-    {
-        if (mesh_.is_boundary(v))
-        {
-            kmin = kmax = sum_weights = 0.0;
+    // boundary vertices: interpolate from interior neighbors, which are not
+    // written by this loop
+    parallel_for(mesh_.vertices(), [&](Vertex v) {
+        if (!mesh_.is_boundary(v))
+            return;
 
-            for (auto vh : mesh_.halfedges(v))
-            {
-                v = mesh_.to_vertex(vh);
-                if (!mesh_.is_boundary(v))
-                {
-                    weight = cotan[mesh_.edge(vh)];
-                    sum_weights += weight;
-                    kmin += weight * min_curvature_[v];
-                    kmax += weight * max_curvature_[v];
-                }
-            }
+        Scalar kmin = 0.0, kmax = 0.0, sum_weights = 0.0;
 
-            if (sum_weights)
+        const auto ring = adjacency.vertex_vertices(v);
+        const auto hring = adjacency.vertex_halfedges(v);
+        for (size_t i = 0; i < ring.size(); ++i)
+        {
+            const Vertex vv = ring[i];
+            if (!mesh_.is_boundary(vv))
             {
-                kmin /= sum_weights;
-                kmax /= sum_weights;
+                const Scalar weight = cache.cotan_weight(mesh_.edge(hring[i]));
+                sum_weights += weight;
+                kmin += weight * min_curvature_[vv];
+                kmax += weight * max_curvature_[vv];
             }
+        }
 
-            min_curvature_[v] = kmin;
-            max_curvature_[v] = kmax;
+        if (sum_weights)
+        {
+            kmin /= sum_weights;
+            kmax /= sum_weights;
         }
-    }
 
-    // clean-up properties
-    mesh_.remove_edge_property(cotan);
+        min_curvature_[v] = kmin;
+        max_curvature_[v] = kmax;
+    });
 
     // smooth curvature values
-    smooth_curvatures(post_smoothing_steps);
+    smooth_curvatures(post_smoothing_steps, cache);
 }
 
 void SurfaceCurvature::analyze_tensor(unsigned int post_smoothing_steps,
                                       bool two_ring_neighborhood)
 {
-    auto area = mesh_.add_vertex_property<double>("curv:area", 0.0);
-    auto normal = mesh_.add_face_property<dvec3>("curv:normal");
-    auto evec = mesh_.add_edge_property<dvec3>("curv:evec", dvec3(0, 0, 0));
-    auto angle = mesh_.add_edge_property<double>("curv:angle", 0.0);
+    PMP_PROFILE_SCOPE("SurfaceCurvature::analyze_tensor");
 
-    dvec3 p0, p1, n0, n1, ev;
-    double l, A, beta, a1, a2, a3;
-    dmat3 tensor;
+    const int nV = int(mesh_.vertices_size());
+    const int nE = int(mesh_.edges_size());
+    const int nF = int(mesh_.faces_size());
 
-    double eval1, eval2, eval3, kmin, kmax;
-    dvec3 evec1, evec2, evec3;
-
-    std::vector<Vertex> neighborhood;
-    neighborhood.reserve(15);
+    std::vector<dvec3> normal(nF);
+    std::vector<dvec3> evec(nE, dvec3(0, 0, 0));
+    std::vector<double> angle(nE, 0.0);
 
     // precompute Voronoi area per vertex
-    for (auto v : mesh_.vertices())
-    {
-        area[v] = voronoi_area(mesh_, v);
-    }
+    GeometryCache cache(mesh_);
+    cache.update();
 
     // precompute face normals
-    for (auto f : mesh_.faces())
-    {
-        normal[f] = (dvec3)SurfaceNormals::compute_face_normal(mesh_, f);
-    }
+    parallel_for(mesh_.faces(), [&](Face f) {
+        normal[f.idx()] = (dvec3)SurfaceNormals::compute_face_normal(mesh_, f);
+    });
 
     // precompute dihedralAngle*edge_length*edge per edge
-    for (auto e : mesh_.edges())
-    {
+    parallel_for(mesh_.edges(), [&](Edge e) {
+        const IndexType i = e.idx();
         auto h0 = mesh_.halfedge(e, 0);
         auto h1 = mesh_.halfedge(e, 1);
         auto f0 = mesh_.face(h0);
         auto f1 = mesh_.face(h1);
         if (f0.is_valid() && f1.is_valid())
         {
-            n0 = normal[f0];
-            n1 = normal[f1];
-            ev = (dvec3)mesh_.position(mesh_.to_vertex(h0));
+            const dvec3 n0 = normal[f0.idx()];
+            const dvec3 n1 = normal[f1.idx()];
+            dvec3 ev = (dvec3)mesh_.position(mesh_.to_vertex(h0));
             ev -= (dvec3)mesh_.position(mesh_.to_vertex(h1));
-            l = norm(ev);
+            double l = norm(ev);
             ev /= l;
             l *= 0.5; // only consider half of the edge (matching Voronoi area)
-            angle[e] = atan2(dot(cross(n0, n1), ev), dot(n0, n1));
-            evec[e] = sqrt(l) * ev;
+            angle[i] = atan2(dot(cross(n0, n1), ev), dot(n0, n1));
+            evec[i] = sqrt(l) * ev;
         }
-    }
+    });
 
     // compute curvature tensor for each vertex
-    for (auto v : mesh_.vertices())
-    {
-        kmin = 0.0;
-        kmax = 0.0;
+    parallel_for_chunks(
+        0, nV,
+        [&](int first, int last) {
+            std::vector<Vertex> neighborhood;
+            neighborhood.reserve(15);
 
-        if (!mesh_.is_isolated(v))
-        {
-            // one-ring or two-ring neighborhood?
-            neighborhood.clear();
-            neighborhood.push_back(v);
-            if (two_ring_neighborhood)
+            for (int j = first; j < last; ++j)
             {
-                for (auto vv : mesh_.vertices(v))
-                    neighborhood.push_back(vv);
-            }
-
-            A = 0.0;
-            tensor = dmat3(0.0);
-
-            // compute tensor over vertex neighborhood stored in vertices
-            for (auto nit : neighborhood)
-            {
-                // accumulate tensor from dihedral angles around vertices
-                for (auto hv : mesh_.halfedges(nit))
-                {
-                    auto ee = mesh_.edge(hv);
-                    ev = evec[ee];
-                    beta = angle[ee];
-                    for (int i = 0; i < 3; ++i)
-                        for (int j = 0; j < 3; ++j)
-                            tensor(i, j) += beta * ev[i] * ev[j];
-                }
-
-                // accumulate area
-                A += area[nit];
-            }
+                const Vertex v(j);
+                if (mesh_.is_deleted(v))
+                    continue;
 
-            // normalize tensor by accumulated
-            tensor /= A;
+                double kmin = 0.0;
+                double kmax = 0.0;
 
-            // Eigen-decomposition
-            bool ok = symmetric_eigendecomposition(tensor, eval1, eval2, eval3,
-                                                   evec1, evec2, evec3);
-            if (ok)
-            {
-                // curvature values:
-                //   normal vector -> eval with smallest absolute value
-                //   evals are sorted in decreasing order
-                a1 = fabs(eval1);
-                a2 = fabs(eval2);
-                a3 = fabs(eval3);
-                if (a1 < a2)
+                if (!mesh_.is_isolated(v))
                 {
-                    if (a1 < a3)
-                    {
-                        // e1 is normal
-                        kmax = eval2;
-                        kmin = eval3;
-                    }
-                    else
+                    // one-ring or two-ring neighborhood?
+                    neighborhood.clear();
+                    neighborhood.push_back(v);
+                    if (two_ring_neighborhood)
                     {
-                        // e3 is normal
-                        kmax = eval1;
-                        kmin = eval2;
+                        for (auto vv : mesh_.vertices(v))
+                            neighborhood.push_back(vv);
                     }
-                }
-                else
-                {
-                    if (a2 < a3)
+
+                    double A = 0.0;
+                    dmat3 tensor(0.0);
+
+                    // compute tensor over the vertex neighborhood
+                    for (auto nit : neighborhood)
                     {
-                        // e2 is normal
-                        kmax = eval1;
-                        kmin = eval3;
+                        // accumulate tensor from dihedral angles around
+                        // vertices
+                        for (auto hv : mesh_.halfedges(nit))
+                        {
+                            const IndexType ee = mesh_.edge(hv).idx();
+                            const dvec3& ev = evec[ee];
+                            const double beta = angle[ee];
+                            for (int i = 0; i < 3; ++i)
+                                for (int k = 0; k < 3; ++k)
+                                    tensor(i, k) += beta * ev[i] * ev[k];
+                        }
+
+                        // accumulate area
+                        A += cache.voronoi_area(nit);
                     }
-                    else
+
+                    // normalize tensor by accumulated
+                    tensor /= A;
+
+                    // Eigen-decomposition
+                    double eval1, eval2, eval3;
+                    dvec3 evec1, evec2, evec3;
+                    bool ok = symmetric_eigendecomposition(
+                        tensor, eval1, eval2, eval3, evec1, evec2, evec3);
+                    if (ok)
                     {
-                        // e3 is normal
-                        kmax = eval1;
-                        kmin = eval2;
+                        // curvature values:
+                        //   normal vector -> eval with smallest absolute value
+                        //   evals are sorted in decreasing order
+                        const double a1 = fabs(eval1);
+                        const double a2 = fabs(eval2);
+                        const double a3 = fabs(eval3);
+                        if (a1 < a2)
+                        {
+                            if (a1 < a3)
+                            {
+                                // e1 is normal
+                                kmax = eval2;
+                                kmin = eval3;
+                            }
+                            else
+                            {
+                                // e3 is normal
+                                kmax = eval1;
+                                kmin = eval2;
+                            }
+                        }
+                        else
+                        {
+                            if (a2 < a3)
+                            {
+                                // e2 is normal
+                                kmax = eval1;
+                                kmin = eval3;
+                            }
+                            else
+                            {
+                                // e3 is normal
+                                kmax = eval1;
+                                kmin = eval2;
+                            }
+                        }
                     }
                 }
-            }
-        }
 
-        assert(kmin <= kmax);
+                assert(kmin <= kmax);
 
-        min_curvature_[v] = kmin;
-        max_curvature_[v] = kmax;
-    }
-
-    // clean-up properties
-    mesh_.remove_vertex_property(area);
-    mesh_.remove_edge_property(evec);
-    mesh_.remove_edge_property(angle);
-    mesh_.remove_face_property(normal);
+                min_curvature_[v] = kmin;
+                max_curvature_[v] = kmax;
+            }
+        },
+        256);
 
     // smooth curvature values
-    smooth_curvatures(post_smoothing_steps);
+    if (post_smoothing_steps)
+        smooth_curvatures(post_smoothing_steps, cache);
 }
 
-void SurfaceCurvature::smooth_curvatures(unsigned int iterations)
+void SurfaceCurvature::smooth_curvatures(unsigned int iterations,
+                                         const GeometryCache& cache)
 {
-    Scalar kmin, kmax;
-    Scalar weight, sum_weights;
-
     // properties
     auto vfeature = mesh_.get_vertex_property<bool>("v:feature");
-    auto cotan = mesh_.add_edge_property<double>("curv:cotan");
 
-    // cotan weight per edge
-    for (auto e : mesh_.edges())
-    {
-        cotan[e] = cotan_weight(mesh_, e);
-    }
+    // smooth into a second buffer, so that all vertices of an iteration
+    // read the values of the previous one
+    const int nV = int(mesh_.vertices_size());
+    std::vector<Scalar> new_min(nV), new_max(nV);
 
-    for (unsigned int i = 0; i < iterations; ++i)
+    for (unsigned int iter = 0; iter < iterations; ++iter)
     {
-        for (auto v : mesh_.vertices())
-        {
+        parallel_for(0, nV, [&](int j) {
+            const Vertex v(j);
+            new_min[j] = min_curvature_[v];
+            new_max[j] = max_curvature_[v];
+
             // don't smooth feature vertices
-            if (vfeature && vfeature[v])
-                continue;
+            if (mesh_.is_deleted(v) || (vfeature && vfeature[v]))
+                return;
 
-            kmin = kmax = sum_weights = 0.0;
+            Scalar kmin = 0.0, kmax = 0.0, sum_weights = 0.0;
 
             for (auto vh : mesh_.halfedges(v))
             {
@@ -303,7 +314,8 @@ void SurfaceCurvature::smooth_curvatures(unsigned int iterations)
                 if (vfeature && vfeature[tv])
                     continue;
 
-                weight = std::max(0.0, cotan_weight(mesh_, mesh_.edge(vh)));
+                const Scalar weight =
+                    std::max(0.0, cache.cotan_weight(mesh_.edge(vh)));
                 sum_weights += weight;
                 kmin += weight * min_curvature_[tv];
                 kmax += weight * max_curvature_[tv];
@@ -311,86 +323,44 @@ void SurfaceCurvature::smooth_curvatures(unsigned int iterations)
 
             if (sum_weights)
             {
-                min_curvature_[v] = kmin / sum_weights;
-                max_curvature_[v] = kmax / sum_weights;
+                new_min[j] = kmin / sum_weights;
+                new_max[j] = kmax / sum_weights;
             }
-        }
-    }
+        });
 
-    // remove property
-    mesh_.remove_edge_property(cotan);
+        parallel_for(0, nV, [&](int j) {
+            min_curvature_[Vertex(j)] = new_min[j];
+            max_curvature_[Vertex(j)] = new_max[j];
+        });
+    }
 }
 
 void SurfaceCurvature::mean_curvature_to_texture_coordinates() const
 {
-    auto curvatures = mesh_.add_vertex_property<Scalar>("v:curv");
-    for (auto v : mesh_.vertices())
-    {
-        curvatures[v] = fabs(mean_curvature(v));
-    }
-    curvature_to_texture_coordinates();
-    mesh_.remove_vertex_property<Scalar>(curvatures);
+    curvature_to_texture_coordinates(
+        [&](Vertex v) { return std::fabs(mean_curvature(v)); });
 }
 
 void SurfaceCurvature::gauss_curvature_to_texture_coordinates() const
 {
-    auto curvatures = mesh_.add_vertex_property<Scalar>("v:curv");
-    for (auto v : mesh_.vertices())
-    {
-        curvatures[v] = gauss_curvature(v);
-    }
-    curvature_to_texture_coordinates();
-    mesh_.remove_vertex_property<Scalar>(curvatures);
+    curvature_to_texture_coordinates(
+        [&](Vertex v) { return gauss_curvature(v); });
 }
 
 void SurfaceCurvature::max_curvature_to_texture_coordinates() const
 {
-    auto curvatures = mesh_.add_vertex_property<Scalar>("v:curv");
-    for (auto v : mesh_.vertices())
-    {
-        curvatures[v] = max_abs_curvature(v);
-    }
-    curvature_to_texture_coordinates();
-    mesh_.remove_vertex_property<Scalar>(curvatures);
+    curvature_to_texture_coordinates(
+        [&](Vertex v) { return max_abs_curvature(v); });
 }
 
-void SurfaceCurvature::curvature_to_texture_coordinates() const
+void SurfaceCurvature::curvature_to_texture_coordinates(
+    const std::function<Scalar(Vertex)>& curvature) const
 {
-    auto curvatures = mesh_.get_vertex_property<Scalar>("v:curv");
-    assert(curvatures);
-
-    // sort curvature values
-    std::vector<Scalar> values;
-    values.reserve(mesh_.n_vertices());
-    for (auto v : mesh_.vertices())
-    {
-        values.push_back(curvatures[v]);
-    }
-    std::sort(values.begin(), values.end());
-    unsigned int n = values.size() - 1;
-
-    // clamp upper/lower 5%
-    unsigned int i = n / 20;
-    Scalar kmin = values[i];
-    Scalar kmax = values[n - 1 - i];
-
-    // generate 1D texture coordinates
-    auto tex = mesh_.vertex_property<TexCoord>("v:tex");
-    if (kmin < 0.0) // signed
-    {
-        kmax = std::max(fabs(kmin), fabs(kmax));
-        for (auto v : mesh_.vertices())
-        {
-            tex[v] = TexCoord((0.5f * curvatures[v] / kmax) + 0.5f, 0.0);
-        }
-    }
-    else // unsigned
-    {
-        for (auto v : mesh_.vertices())
-        {
-            tex[v] = TexCoord((curvatures[v] - kmin) / (kmax - kmin), 0.0);
-        }
-    }
+    auto curvatures = mesh_.add_vertex_property<Scalar>("v:curv");
+    parallel_for(mesh_.vertices(),
+                 [&](Vertex v) { curvatures[v] = curvature(v); });
+    values_to_texture_coordinates(mesh_, curvatures);
+    mesh_.remove_vertex_property<Scalar>(curvatures);
 }
 
 } // namespace pmp
@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <functional>
+
 #include "pmp/SurfaceMesh.h"
+#include "pmp/SurfaceAdjacency.h"
+#include "pmp/algorithms/GeometryCache.h"
 
 namespace pmp {
 
@@ -11,7 +15,7 @@ namespace pmp {
 //! \details Curvature values for boundary vertices are interpolated from their
 //! interior neighbors. Curvature values can be smoothed. See
 //! \cite meyer_2003_discrete and \cite cohen-steiner_2003_restricted for
-//! details.
+//! details. The per-vertex computations and the smoothing run in parallel.
 //! \ingroup algorithms
 class SurfaceCurvature
 {
@@ -26,6 +30,12 @@ public:
     //! by some smoothing iterations of the curvature values
     void analyze(unsigned int post_smoothing_steps = 0);
 
+    //! compute curvature information for each vertex using a precomputed
+    //! \p adjacency snapshot of the mesh, optionally followed by some
+    //! smoothing iterations of the curvature values
+    void analyze(const SurfaceAdjacency& adjacency,
+                 unsigned int post_smoothing_steps = 0);
+
     //! compute curvature information for each vertex, optionally followed
     //! by some smoothing iterations of the curvature values
     void analyze_tensor(unsigned int post_smoothing_steps = 0,
@@ -65,11 +75,17 @@ public:
     void max_curvature_to_texture_coordinates() const;
 
 private:
-    //! smooth curvature values
-    void smooth_curvatures(unsigned int iterations);
-
-    //! convert curvature values ("v:curv") to 1D texture coordinates
-    void curvature_to_texture_coordinates() const;
+    //! smooth curvature values using the cotan weight of each edge. Each
+    //! iteration reads the values of the previous one (Jacobi), which gives
+    //! different values, and hence different adaptive remeshing results,
+    //! than the former in-place sweep.
+    void smooth_curvatures(unsigned int iterations,
+                           const GeometryCache& cache);
+
+    //! convert the curvature of each vertex to 1D texture coordinates, see
+    //! values_to_texture_coordinates()
+    void curvature_to_texture_coordinates(
+        const std::function<Scalar(Vertex)>& curvature) const;
 
 private:
     SurfaceMesh& mesh_;
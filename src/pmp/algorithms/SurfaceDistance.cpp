@@ -0,0 +1,208 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfaceDistance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "pmp/algorithms/TriangleKdTree.h"
+
+namespace pmp {
+
+namespace {
+
+// sums of the distances of a set of points
+struct Sums
+{
+    double max = 0;
+    double sum = 0;
+    double sqrsum = 0;
+    size_t n = 0;
+};
+
+void check_target(const SurfaceMesh& target)
+{
+    if (!target.is_triangle_mesh() || target.n_faces() == 0)
+        throw InvalidInputException("Input is not a pure triangle mesh!");
+}
+
+// distances of points to the tree, optionally stored per point
+Sums measure(const TriangleKdTree& tree, const std::vector<Point>& points,
+             std::vector<Scalar>* distances = nullptr)
+{
+    std::vector<TriangleKdTree::NearestNeighbor> nearest;
+    tree.nearest(points, nearest);
+
+    Sums sums;
+    sums.n = points.size();
+    for (const auto& nn : nearest)
+    {
+        sums.max = std::max(sums.max, double(nn.dist));
+        sums.sum += nn.dist;
+        sums.sqrsum += double(nn.dist) * nn.dist;
+    }
+    if (distances)
+    {
+        distances->resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            (*distances)[i] = nearest[i].dist;
+    }
+    return sums;
+}
+
+// n points distributed uniformly by area on the faces of mesh, in the order
+// of the faces such that consecutive points are close to each other
+std::vector<Point> sample_faces(const SurfaceMesh& mesh, unsigned int n,
+                                unsigned int seed)
+{
+    // fan triangles of all faces and their accumulated areas
+    std::vector<Point> corners;
+    std::vector<double> accumulated;
+    double total = 0;
+    for (auto f : mesh.faces())
+    {
+        auto h = mesh.halfedge(f);
+        const Point& p0 = mesh.position(mesh.from_vertex(h));
+        for (h = mesh.next_halfedge(h);
+             mesh.to_vertex(h) != mesh.from_vertex(mesh.halfedge(f));
+             h = mesh.next_halfedge(h))
+        {
+            const Point& p1 = mesh.position(mesh.from_vertex(h));
+            const Point& p2 = mesh.position(mesh.to_vertex(h));
+            total += 0.5 * norm(cross(p1 - p0, p2 - p0));
+            accumulated.push_back(total);
+            corners.push_back(p0);
+            corners.push_back(p1);
+            corners.push_back(p2);
+        }
+    }
+
+    std::vector<Point> samples;
+    if (n == 0 || total <= 0)
+        return samples;
+    samples.reserve(n);
+
+    // one sample per stratum of the accumulated area, the strata are
+    // increasing such that the triangles are visited in order
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    size_t t = 0;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const double a = (i + uniform(rng)) / n * total;
+        while (t + 1 < accumulated.size() && accumulated[t] < a)
+            ++t;
+
+        double b1 = uniform(rng), b2 = uniform(rng);
+        if (b1 + b2 > 1)
+        {
+            b1 = 1 - b1;
+            b2 = 1 - b2;
+        }
+        const Point& p0 = corners[3 * t];
+        const Point& p1 = corners[3 * t + 1];
+        const Point& p2 = corners[3 * t + 2];
+        samples.push_back(p0 + Scalar(b1) * (p1 - p0) +
+                          Scalar(b2) * (p2 - p0));
+    }
+    return samples;
+}
+
+// distances of the vertices and samples of source to tree
+void measure(const SurfaceMesh& source, const TriangleKdTree& tree,
+             unsigned int n_samples, unsigned int seed, Sums& vertices,
+             Sums& samples)
+{
+    std::vector<Point> points;
+    points.reserve(source.n_vertices());
+    for (auto v : source.vertices())
+        points.push_back(source.position(v));
+    vertices = measure(tree, points);
+    samples = measure(tree, sample_faces(source, n_samples, seed));
+}
+
+SurfaceDistance::Statistics statistics(const Sums& vertices,
+                                       const Sums& samples)
+{
+    // the mean is taken over the samples if there are any
+    const Sums& mean = samples.n ? samples : vertices;
+
+    SurfaceDistance::Statistics result;
+    result.max_distance = Scalar(std::max(vertices.max, samples.max));
+    result.n_samples = samples.n;
+    if (mean.n)
+    {
+        result.mean_distance = Scalar(mean.sum / mean.n);
+        result.rms_distance = Scalar(std::sqrt(mean.sqrsum / mean.n));
+    }
+    return result;
+}
+
+} // namespace
+
+SurfaceDistance::Statistics SurfaceDistance::one_sided(
+    const SurfaceMesh& source, const SurfaceMesh& target,
+    unsigned int n_samples, unsigned int seed)
+{
+    check_target(target);
+    TriangleKdTree tree(target);
+
+    Sums vertices, samples;
+    measure(source, tree, n_samples, seed, vertices, samples);
+    return statistics(vertices, samples);
+}
+
+SurfaceDistance::Statistics SurfaceDistance::symmetric(const SurfaceMesh& a,
+                                                       const SurfaceMesh& b,
+                                                       unsigned int n_samples,
+                                                       unsigned int seed)
+{
+    check_target(a);
+    check_target(b);
+
+    Sums vertices_ab, samples_ab, vertices_ba, samples_ba;
+    measure(a, TriangleKdTree(b), n_samples, seed, vertices_ab, samples_ab);
+    measure(b, TriangleKdTree(a), n_samples, seed, vertices_ba, samples_ba);
+
+    // pool both directions
+    auto pool = [](const Sums& s0, const Sums& s1) {
+        Sums s;
+        s.max = std::max(s0.max, s1.max);
+        s.sum = s0.sum + s1.sum;
+        s.sqrsum = s0.sqrsum + s1.sqrsum;
+        s.n = s0.n + s1.n;
+        return s;
+    };
+    return statistics(pool(vertices_ab, vertices_ba),
+                      pool(samples_ab, samples_ba));
+}
+
+SurfaceDistance::Statistics SurfaceDistance::vertex_distances(
+    SurfaceMesh& mesh, const SurfaceMesh& target)
+{
+    check_target(target);
+    TriangleKdTree tree(target);
+
+    std::vector<Vertex> vertices;
+    std::vector<Point> points;
+    vertices.reserve(mesh.n_vertices());
+    points.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        vertices.push_back(v);
+        points.push_back(mesh.position(v));
+    }
+
+    std::vector<Scalar> distances;
+    const Sums sums = measure(tree, points, &distances);
+
+    auto distance = mesh.vertex_property<Scalar>("v:distance");
+    for (size_t i = 0; i < vertices.size(); ++i)
+        distance[vertices[i]] = distances[i];
+
+    return statistics(sums, Sums());
+}
+
+} // namespace pmp
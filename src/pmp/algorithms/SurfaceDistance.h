@@ -0,0 +1,67 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Distances between two surfaces, e.g., to validate the result of
+//! SurfaceSimplification or SurfaceRemeshing against its input.
+//! \details Points are sampled on one surface and their nearest points on
+//! the other one are found by batched queries of a TriangleKdTree in
+//! parallel. The maximum distance of the vertices and samples approximates
+//! the Hausdorff distance, see \cite cignoni_1998_metro.
+//! \ingroup algorithms
+class SurfaceDistance
+{
+public:
+    // delete default and copy constructor
+    SurfaceDistance() = delete;
+    SurfaceDistance(const SurfaceDistance&) = delete;
+
+    //! statistics of the measured distances
+    struct Statistics
+    {
+        Scalar max_distance = 0;  //!< maximum distance
+        Scalar mean_distance = 0; //!< mean distance over the surface
+        Scalar rms_distance = 0;  //!< root mean square distance
+        size_t n_samples = 0;     //!< number of sampled points
+    };
+
+    //! \brief Distance from \p source to \p target.
+    //! \details Measures the distances of the vertices of \p source and of
+    //! \p n_samples points distributed uniformly by area on its faces, using
+    //! stratified random sampling seeded by \p seed. The maximum is taken
+    //! over vertices and samples, the mean and RMS distances over the
+    //! samples only, or over the vertices if \p n_samples is zero. The
+    //! faces of \p source may be polygons.
+    //! \throw InvalidInputException if \p target is not a triangle mesh or
+    //! has no faces.
+    static Statistics one_sided(const SurfaceMesh& source,
+                                const SurfaceMesh& target,
+                                unsigned int n_samples = 100000,
+                                unsigned int seed = 0);
+
+    //! \brief Distance between \p a and \p b in both directions.
+    //! \details The maximum is the approximate Hausdorff distance, the mean
+    //! and RMS distances are taken over the samples of both directions, see
+    //! one_sided().
+    //! \throw InvalidInputException if \p a or \p b is not a triangle mesh or
+    //! has no faces.
+    static Statistics symmetric(const SurfaceMesh& a, const SurfaceMesh& b,
+                                unsigned int n_samples = 100000,
+                                unsigned int seed = 0);
+
+    //! \brief Distance of each vertex of \p mesh to \p target.
+    //! \details Stores the distances in the vertex property "v:distance",
+    //! e.g., for visualizing the error as a texture. Returns the statistics
+    //! of the vertex distances.
+    //! \throw InvalidInputException if \p target is not a triangle mesh or
+    //! has no faces.
+    static Statistics vertex_distances(SurfaceMesh& mesh,
+                                       const SurfaceMesh& target);
+};
+
+} // namespace pmp
@@ -5,6 +5,13 @@
 #include "SurfaceSubdivision.h"
 #include "DifferentialGeometry.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "pmp/Parallel.h"
+
 namespace pmp {
 
 void project_to_unit_sphere(SurfaceMesh& mesh)
@@ -17,6 +24,136 @@ void project_to_unit_sphere(SurfaceMesh& mesh)
     }
 }
 
+namespace {
+
+// throw if a mesh with these numbers of vertices and face corners exceeds
+// the index range, see SurfaceMesh::from_indexed_faces()
+void check_size(double n_vertices, double n_corners)
+{
+    if (n_vertices >= double(PMP_MAX_INDEX - 1) ||
+        2 * n_corners >= double(PMP_MAX_INDEX - 1))
+    {
+        auto what = "SurfaceFactory: Mesh exceeds the index range.";
+        throw AllocationException(what);
+    }
+}
+
+// index of the vertex (i, j) of a grid with n_columns cells per row
+inline IndexType grid_vertex(size_t i, size_t j, size_t n_columns)
+{
+    return IndexType(j * (n_columns + 1) + i);
+}
+
+// vertices of a grid of square cells in the xy-plane, longer side 1
+void grid_points(size_t n_columns, size_t n_rows, std::vector<Point>& points)
+{
+    const Scalar h = Scalar(1) / Scalar(std::max(n_columns, n_rows));
+    points.resize((n_columns + 1) * (n_rows + 1));
+    parallel_for(
+        0, int(n_rows + 1),
+        [&](int j) {
+            for (size_t i = 0; i <= n_columns; ++i)
+                points[grid_vertex(i, j, n_columns)] =
+                    Point(Scalar(i) * h, Scalar(j) * h, 0);
+        },
+        16);
+}
+
+// faces of a grid, quads or two triangles per cell
+void grid_faces(size_t n_columns, size_t n_rows, bool triangles,
+                std::vector<IndexType>& indices)
+{
+    const size_t n = triangles ? 6 : 4;
+    indices.resize(n_columns * n_rows * n);
+    parallel_for(
+        0, int(n_rows),
+        [&](int j) {
+            IndexType* c = &indices[size_t(j) * n_columns * n];
+            for (size_t i = 0; i < n_columns; ++i)
+            {
+                const IndexType v00 = grid_vertex(i, j, n_columns);
+                const IndexType v10 = v00 + 1;
+                const IndexType v01 = v00 + IndexType(n_columns + 1);
+                const IndexType v11 = v01 + 1;
+                if (triangles)
+                {
+                    for (auto v : {v00, v10, v11, v00, v11, v01})
+                        *c++ = v;
+                }
+                else
+                {
+                    for (auto v : {v00, v10, v11, v01})
+                        *c++ = v;
+                }
+            }
+        },
+        16);
+}
+
+// drop the points that no face uses and renumber the indices of the faces
+// and of the faces added later
+void remove_unused_points(std::vector<Point>& points,
+                          std::vector<IndexType>& indices,
+                          std::vector<IndexType>& later)
+{
+    std::vector<IndexType> map(points.size(), PMP_MAX_INDEX);
+    for (auto idx : indices)
+        map[idx] = 0;
+    for (auto idx : later)
+        map[idx] = 0;
+
+    IndexType n = 0;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (map[i] == PMP_MAX_INDEX)
+            continue;
+        points[n] = points[i];
+        map[i] = n++;
+    }
+    points.resize(n);
+
+    parallel_for(
+        0, int(indices.size() / 1024 + 1),
+        [&](int b) {
+            const size_t end = std::min(size_t(b + 1) * 1024, indices.size());
+            for (size_t i = size_t(b) * 1024; i < end; ++i)
+                indices[i] = map[indices[i]];
+        },
+        16);
+    for (auto& idx : later)
+        idx = map[idx];
+}
+
+// value of lattice point (i, j) in [-1, 1]
+Scalar lattice_value(uint32_t i, uint32_t j, uint32_t seed)
+{
+    uint32_t h = (i * 0x8da6b343u) ^ (j * 0xd8163841u) ^ (seed * 0xcb1ab31fu);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return Scalar(2.0 * h / double(UINT32_MAX) - 1.0);
+}
+
+// value noise at (x, y), smoothly interpolated between lattice points
+Scalar value_noise(Scalar x, Scalar y, uint32_t seed)
+{
+    const Scalar fx = std::floor(x), fy = std::floor(y);
+    const auto i = uint32_t(int64_t(fx)), j = uint32_t(int64_t(fy));
+    Scalar tx = x - fx, ty = y - fy;
+    tx = tx * tx * (3 - 2 * tx);
+    ty = ty * ty * (3 - 2 * ty);
+
+    const Scalar a = lattice_value(i, j, seed);
+    const Scalar b = lattice_value(i + 1, j, seed);
+    const Scalar c = lattice_value(i, j + 1, seed);
+    const Scalar d = lattice_value(i + 1, j + 1, seed);
+    return (1 - ty) * ((1 - tx) * a + tx * b) + ty * ((1 - tx) * c + tx * d);
+}
+
+} // namespace
+
 SurfaceMesh SurfaceFactory::tetrahedron()
 {
     SurfaceMesh mesh;
@@ -206,4 +343,287 @@ SurfaceMesh SurfaceFactory::uv_sphere(const Point& center, Scalar radius,
     return mesh;
 }
 
-} // namespace pmp
\ No newline at end of file
+SurfaceMesh SurfaceFactory::grid(size_t n_columns, size_t n_rows,
+                                 bool triangles)
+{
+    check_size(double(n_columns + 1) * double(n_rows + 1),
+               double(n_columns) * double(n_rows) * (triangles ? 6 : 4));
+
+    std::vector<Point> points;
+    std::vector<IndexType> indices;
+    grid_points(n_columns, n_rows, points);
+    grid_faces(n_columns, n_rows, triangles, indices);
+
+    SurfaceMesh mesh;
+    if (triangles)
+        mesh.from_indexed_faces(points, indices);
+    else
+        mesh.from_indexed_faces(
+            points, indices, std::vector<IndexType>(n_columns * n_rows, 4));
+    return mesh;
+}
+
+SurfaceMesh SurfaceFactory::terrain(size_t n_columns, size_t n_rows,
+                                    Scalar roughness, unsigned int seed)
+{
+    check_size(double(n_columns + 1) * double(n_rows + 1),
+               double(n_columns) * double(n_rows) * 6);
+
+    std::vector<Point> points;
+    std::vector<IndexType> indices;
+    grid_points(n_columns, n_rows, points);
+    grid_faces(n_columns, n_rows, true, indices);
+
+    // octaves up to the frequency of the cells
+    const Scalar max_frequency = Scalar(std::max(n_columns, n_rows));
+    parallel_for(
+        0, int(points.size() / 1024 + 1),
+        [&](int b) {
+            const size_t end = std::min(size_t(b + 1) * 1024, points.size());
+            for (size_t i = size_t(b) * 1024; i < end; ++i)
+            {
+                Point& p = points[i];
+                Scalar amplitude = 0.25, frequency = 4;
+                for (uint32_t o = 0; o < 16 && frequency <= max_frequency;
+                     ++o)
+                {
+                    p[2] += amplitude *
+                            value_noise(p[0] * frequency, p[1] * frequency,
+                                        uint32_t(seed) + o);
+                    amplitude *= roughness;
+                    frequency *= 2;
+                }
+            }
+        },
+        16);
+
+    SurfaceMesh mesh;
+    mesh.from_indexed_faces(points, indices);
+    return mesh;
+}
+
+SurfaceMesh SurfaceFactory::perforated_plate(size_t genus, size_t resolution)
+{
+    // blocks of r x r cells, the first genus of them with a hole
+    const size_t r = std::max<size_t>(resolution, 3);
+    const auto b = std::max<size_t>(
+        size_t(std::ceil(std::sqrt(double(genus)) - 1e-9)), 1);
+    const size_t n = b * r;
+    auto solid = [&](size_t i, size_t j) {
+        if (i >= n || j >= n)
+            return false;
+        const size_t block = (j / r) * b + i / r;
+        const size_t ii = i % r, jj = j % r;
+        return block >= genus || ii < r / 3 || ii >= r - r / 3 ||
+               jj < r / 3 || jj >= r - r / 3;
+    };
+
+    // top and bottom at the height of the walls, subdivided into layers
+    const size_t layers = r / 3;
+    const Scalar h = Scalar(1) / Scalar(n);
+    const Scalar d = Scalar(0.5) * Scalar(layers) * h;
+    const size_t nl = (n + 1) * (n + 1);
+
+    check_size(2.0 * double(nl) + 4.0 * double(n) * double(layers),
+               8.0 * double(n) * double(n) * double(layers + 1));
+
+    // the wall halfedges a -> b of the cells, counter-clockwise in the top
+    std::vector<std::pair<IndexType, IndexType>> walls;
+    for (size_t j = 0; j < n; ++j)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!solid(i, j))
+                continue;
+            const IndexType v00 = grid_vertex(i, j, n);
+            const IndexType v10 = v00 + 1;
+            const IndexType v01 = v00 + IndexType(n + 1);
+            const IndexType v11 = v01 + 1;
+            if (!solid(i, j - 1))
+                walls.emplace_back(v00, v10);
+            if (!solid(i + 1, j))
+                walls.emplace_back(v10, v11);
+            if (!solid(i, j + 1))
+                walls.emplace_back(v11, v01);
+            if (!solid(i - 1, j))
+                walls.emplace_back(v01, v00);
+        }
+    }
+
+    // top vertices, then bottom vertices, then the inner vertices of the
+    // walls of each top vertex on a wall
+    std::vector<Point> points;
+    grid_points(n, n, points);
+    points.resize(2 * nl);
+    for (size_t i = 0; i < nl; ++i)
+    {
+        points[nl + i] = points[i] - Point(0, 0, d);
+        points[i][2] = d;
+    }
+    std::vector<IndexType> wall_vertex(nl, PMP_MAX_INDEX);
+    for (const auto& w : walls)
+    {
+        for (auto v : {w.first, w.second})
+        {
+            if (wall_vertex[v] != PMP_MAX_INDEX)
+                continue;
+            wall_vertex[v] = IndexType(points.size());
+            for (size_t k = 1; k < layers; ++k)
+                points.push_back(points[v] -
+                                 Point(0, 0, 2 * d * Scalar(k) / layers));
+        }
+    }
+    auto vertex = [&](IndexType v, size_t k) {
+        if (k == 0)
+            return v;
+        if (k == layers)
+            return IndexType(nl + v);
+        return IndexType(wall_vertex[v] + k - 1);
+    };
+
+    // quads of the top, the bottom, and the walls
+    std::vector<IndexType> indices;
+    for (size_t j = 0; j < n; ++j)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!solid(i, j))
+                continue;
+            const IndexType v00 = grid_vertex(i, j, n);
+            const IndexType v10 = v00 + 1;
+            const IndexType v01 = v00 + IndexType(n + 1);
+            const IndexType v11 = v01 + 1;
+            for (auto v : {v00, v10, v11, v01})
+                indices.push_back(v);
+            for (auto v : {v00, v01, v11, v10})
+                indices.push_back(IndexType(nl + v));
+        }
+    }
+    for (const auto& w : walls)
+    {
+        for (size_t k = 0; k < layers; ++k)
+        {
+            indices.push_back(vertex(w.second, k));
+            indices.push_back(vertex(w.first, k));
+            indices.push_back(vertex(w.first, k + 1));
+            indices.push_back(vertex(w.second, k + 1));
+        }
+    }
+
+    // the vertices inside the holes are unused
+    std::vector<IndexType> none;
+    remove_unused_points(points, indices, none);
+
+    SurfaceMesh mesh;
+    mesh.from_indexed_faces(points, indices,
+                            std::vector<IndexType>(indices.size() / 4, 4));
+    return mesh;
+}
+
+SurfaceMesh SurfaceFactory::defective_grid(size_t n_columns, size_t n_rows,
+                                           const Defects& defects)
+{
+    check_size(double(n_columns + 1) * double(n_rows + 1),
+               double(n_columns) * double(n_rows) * 6);
+
+    // the defects are centered at the vertices of a lattice of spacing s
+    const size_t hole_size = std::max<size_t>(defects.hole_size, 1);
+    const size_t s = hole_size + 6;
+    const size_t nx = n_columns / s, ny = n_rows / s;
+    const size_t n_defects = defects.n_holes +
+                             defects.n_non_manifold_vertices +
+                             defects.n_slivers;
+    if (n_defects > nx * ny)
+    {
+        auto what = "SurfaceFactory::defective_grid: Too many defects for "
+                    "the grid size.";
+        throw InvalidInputException(what);
+    }
+
+    // random slots, shuffled with a generator that is the same on all
+    // platforms
+    std::vector<size_t> slots(nx * ny);
+    for (size_t i = 0; i < slots.size(); ++i)
+        slots[i] = i;
+    std::mt19937 random(defects.seed);
+    for (size_t i = slots.size(); i > 1; --i)
+        std::swap(slots[i - 1], slots[random() % i]);
+    slots.resize(n_defects);
+
+    std::vector<Point> points;
+    std::vector<IndexType> indices;
+    grid_points(n_columns, n_rows, points);
+    grid_faces(n_columns, n_rows, true, indices);
+
+    // triangles 2c and 2c+1 of cell c, either removed or added later
+    std::vector<size_t> removed;
+    std::vector<IndexType> later;
+    auto cell = [&](size_t i, size_t j) { return j * n_columns + i; };
+    auto add_later = [&](size_t t) {
+        removed.push_back(t);
+        later.insert(later.end(), indices.begin() + 3 * t,
+                     indices.begin() + 3 * t + 3);
+    };
+
+    const Scalar h = Scalar(1) / Scalar(std::max(n_columns, n_rows));
+    for (size_t k = 0; k < slots.size(); ++k)
+    {
+        const size_t ci = s / 2 + (slots[k] % nx) * s;
+        const size_t cj = s / 2 + (slots[k] / nx) * s;
+
+        if (k < defects.n_holes)
+        {
+            const size_t i0 = ci - hole_size / 2, j0 = cj - hole_size / 2;
+            for (size_t j = j0; j < j0 + hole_size; ++j)
+            {
+                for (size_t i = i0; i < i0 + hole_size; ++i)
+                {
+                    removed.push_back(2 * cell(i, j));
+                    removed.push_back(2 * cell(i, j) + 1);
+                }
+            }
+        }
+        else if (k < defects.n_holes + defects.n_non_manifold_vertices)
+        {
+            // of the six triangles around the vertex remove two opposite
+            // ones, the remaining two fans are added one after the other
+            removed.push_back(2 * cell(ci, cj) + 1);
+            removed.push_back(2 * cell(ci - 1, cj - 1));
+            add_later(2 * cell(ci - 1, cj));
+            add_later(2 * cell(ci - 1, cj - 1) + 1);
+        }
+        else
+        {
+            // move the vertex next to the diagonal of the cell to its left
+            const Point p = points[grid_vertex(ci, cj, n_columns)];
+            points[grid_vertex(ci, cj, n_columns)] =
+                p + h * Point(-0.5 + 1e-3, 0.5 - 1e-3, 0);
+        }
+    }
+
+    std::sort(removed.begin(), removed.end());
+    size_t n = 0;
+    for (size_t t = 0, r = 0; t < indices.size() / 3; ++t)
+    {
+        if (r < removed.size() && removed[r] == t)
+        {
+            ++r;
+            continue;
+        }
+        for (size_t i = 0; i < 3; ++i)
+            indices[n++] = indices[3 * t + i];
+    }
+    indices.resize(n);
+
+    // the vertices inside the holes are unused
+    remove_unused_points(points, indices, later);
+
+    SurfaceMesh mesh;
+    mesh.from_indexed_faces(points, indices);
+    for (size_t i = 0; i < later.size(); i += 3)
+        mesh.add_triangle(Vertex(later[i]), Vertex(later[i + 1]),
+                          Vertex(later[i + 2]));
+    return mesh;
+}
+
+} // namespace pmp
@@ -43,6 +43,74 @@ public:
     static SurfaceMesh uv_sphere(const Point& center = Point(0, 0, 0),
                                  Scalar radius = 1.0, size_t n_slices = 15,
                                  size_t n_stacks = 15);
+
+    //! \name Large synthetic meshes
+    //! \details These generators fill index buffers, those of the grids in
+    //! parallel, and build the mesh with SurfaceMesh::from_indexed_faces()
+    //! instead of adding elements one by one. They scale to hundreds of millions of faces,
+    //! limited by the index type, see PMP_INDEX_TYPE_64, and by memory.
+    //! The meshes are the same for any number of threads.
+    //!@{
+
+    //! \brief Generate a planar grid of \p n_columns x \p n_rows square cells.
+    //! \details The grid lies in the xy-plane with its lower left corner at
+    //! the origin, its longer side has unit length. Each cell is a quad, or
+    //! two triangles split along the diagonal if \p triangles is true.
+    //! \throw AllocationException if the mesh exceeds the index range.
+    static SurfaceMesh grid(size_t n_columns, size_t n_rows,
+                            bool triangles = false);
+
+    //! \brief Generate a triangulated terrain of \p n_columns x \p n_rows
+    //! cells.
+    //! \details The heights of grid() are fractal value noise, the sum of
+    //! octaves of doubling frequency whose amplitudes fall off by the
+    //! factor \p roughness in (0,1). Different \p seed values give
+    //! different terrains.
+    //! \throw AllocationException if the mesh exceeds the index range.
+    static SurfaceMesh terrain(size_t n_columns, size_t n_rows,
+                               Scalar roughness = 0.5,
+                               unsigned int seed = 0);
+
+    //! \brief Generate a closed quad mesh of genus \p genus.
+    //! \details The mesh is the surface of a square plate perforated by
+    //! \p genus square holes, laid out in blocks of \p resolution x
+    //! \p resolution cells, at least 3, with a hole in the middle third of
+    //! each block. The walls of the plate and of the holes are subdivided
+    //! to keep the quads square.
+    //! \throw AllocationException if the mesh exceeds the index range.
+    static SurfaceMesh perforated_plate(size_t genus, size_t resolution = 12);
+
+    //! defects of defective_grid()
+    struct Defects
+    {
+        //! number of square holes
+        size_t n_holes = 0;
+
+        //! number of cells along the side of a hole
+        size_t hole_size = 3;
+
+        //! number of vertices whose faces form two separate fans
+        size_t n_non_manifold_vertices = 0;
+
+        //! number of triangles with about 1e-3 times the area of the others
+        size_t n_slivers = 0;
+
+        //! seed of the random placement of the defects
+        unsigned int seed = 0;
+    };
+
+    //! \brief Generate a triangulated grid() with \p defects.
+    //! \details The defects are placed at random cells of a coarse lattice
+    //! such that they do not touch each other or the boundary of the grid.
+    //! SurfaceMesh cannot represent non-manifold edges, so non-manifold
+    //! vertices are the only non-manifold defect.
+    //! \throw InvalidInputException if the grid is too small for the
+    //! defects.
+    //! \throw AllocationException if the mesh exceeds the index range.
+    static SurfaceMesh defective_grid(size_t n_columns, size_t n_rows,
+                                      const Defects& defects);
+
+    //!@}
 };
 
 //! @}
@@ -3,47 +3,30 @@
 
 #include "pmp/algorithms/SurfaceFairing.h"
 
-#include <Eigen/Dense>
-#include <Eigen/Sparse>
-
-#include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/EigenMaps.h"
+#include "pmp/Profiler.h"
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/LinearSolver.h"
 
 namespace pmp {
 
-using SparseMatrix = Eigen::SparseMatrix<double>;
-using Triplet = Eigen::Triplet<double>;
-
 SurfaceFairing::SurfaceFairing(SurfaceMesh& mesh) : mesh_(mesh)
 {
     // get & add properties
     points_ = mesh_.vertex_property<Point>("v:point");
     vselected_ = mesh_.get_vertex_property<bool>("v:selected");
     vlocked_ = mesh_.add_vertex_property<bool>("fairing:locked");
-    vweight_ = mesh_.add_vertex_property<double>("fairing:vweight");
-    eweight_ = mesh_.add_edge_property<double>("fairing:eweight");
-    idx_ = mesh_.add_vertex_property<int>("fairing:idx", -1);
 }
 
 SurfaceFairing::~SurfaceFairing()
 {
     // remove properties
     mesh_.remove_vertex_property(vlocked_);
-    mesh_.remove_vertex_property(vweight_);
-    mesh_.remove_edge_property(eweight_);
-    mesh_.remove_vertex_property(idx_);
 }
 
 void SurfaceFairing::fair(unsigned int k)
 {
-    // compute cotan weights
-    for (auto v : mesh_.vertices())
-    {
-        vweight_[v] = 0.5 / voronoi_area(mesh_, v);
-    }
-    for (auto e : mesh_.edges())
-    {
-        eweight_[e] = std::max(0.0, cotan_weight(mesh_, e));
-    }
+    PMP_PROFILE_SCOPE("SurfaceFairing::fair");
 
     // check whether some vertices are selected
     bool no_selection = true;
@@ -108,7 +91,6 @@ void SurfaceFairing::fair(unsigned int k)
     {
         if (!vlocked_[v])
         {
-            idx_[v] = vertices.size();
             vertices.push_back(v);
         }
     }
@@ -120,122 +102,30 @@ void SurfaceFairing::fair(unsigned int k)
         throw InvalidInputException(what);
     }
 
-    // construct matrix & rhs
-    const unsigned int n = vertices.size();
-    SparseMatrix A(n, n);
-    Eigen::MatrixXd B(n, 3);
-    dvec3 b;
-
-    std::map<Vertex, double> row;
-    std::vector<Triplet> triplets;
-
-    for (unsigned int i = 0; i < n; ++i)
-    {
-        b = dvec3(0.0);
-
-        setup_matrix_row(vertices[i], vweight_, eweight_, k, row);
-
-        for (auto r : row)
-        {
-            auto v = r.first;
-            auto w = r.second;
-
-            if (idx_[v] != -1)
-            {
-                triplets.emplace_back(i, idx_[v], w);
-            }
-            else
-            {
-                b -= w * static_cast<dvec3>(points_[v]);
-            }
-        }
-
-        B.row(i) = (Eigen::Vector3d)b;
-    }
-
-    A.setFromTriplets(triplets.begin(), triplets.end());
-
-    // solve A*X = B
-    Eigen::SimplicialLDLT<SparseMatrix> solver(A);
-    Eigen::MatrixXd X = solver.solve(B);
-
-    if (solver.info() != Eigen::Success)
+    // the k-th power of the cotan Laplacian, L (M^-1 L)^(k-1), and its
+    // coupling to the locked vertices as right hand side, negated for odd
+    // k to make the system positive definite
+    LaplaceOperator laplace(mesh_, vertices, k);
+    const double sign = k % 2 ? -1.0 : 1.0;
+    const Eigen::MatrixXd C =
+        gather_rows(points_, laplace.constraint_vertices());
+    const Eigen::MatrixXd B = -sign * (laplace.constraint_matrix() * C);
+    if (progress_ && !progress_(0.2f))
+        throw CancelledException("SurfaceFairing: Cancelled.");
+
+    // solve A*X = B, starting from the current positions
+    Eigen::MatrixXd X = gather_rows(points_, vertices);
+    LinearSolver solver;
+    solver.compute(sign * laplace.matrix());
+    if (progress_ && !progress_(0.8f))
+        throw CancelledException("SurfaceFairing: Cancelled.");
+    if (!solver.solve(B, X))
     {
         throw SolverException("SurfaceFairing: Failed to solve linear system.");
     }
     else
     {
-        for (unsigned int i = 0; i < n; ++i)
-            points_[vertices[i]] = X.row(i);
-    }
-}
-
-struct Triple
-{
-    Triple() = default;
-
-    Triple(Vertex v, double weight, unsigned int degree)
-        : vertex_(v), weight_(weight), degree_(degree)
-    {
-    }
-
-    Vertex vertex_;
-    double weight_;
-    unsigned int degree_;
-};
-
-void SurfaceFairing::setup_matrix_row(const Vertex v,
-                                      VertexProperty<double> vweight,
-                                      EdgeProperty<double> eweight,
-                                      unsigned int laplace_degree,
-                                      std::map<Vertex, double>& row)
-{
-    Triple t(v, 1.0, laplace_degree);
-
-    // init
-    static std::vector<Triple> todo;
-    todo.reserve(50);
-    todo.push_back(t);
-    row.clear();
-
-    while (!todo.empty())
-    {
-        t = todo.back();
-        todo.pop_back();
-        auto v = t.vertex_;
-        auto d = t.degree_;
-
-        if (d == 0)
-        {
-            row[v] += t.weight_;
-        }
-
-        // else if (d == 1 && mesh_.is_boundary(v))
-        // {
-        //     // ignore?
-        // }
-
-        else
-        {
-            auto ww = 0.0;
-
-            for (auto h : mesh_.halfedges(v))
-            {
-                auto e = mesh_.edge(h);
-                auto vv = mesh_.to_vertex(h);
-                auto w = eweight[e];
-
-                if (d < laplace_degree)
-                    w *= vweight[v];
-
-                w *= t.weight_;
-                ww -= w;
-
-                todo.emplace_back(vv, w, d - 1);
-            }
-
-            todo.emplace_back(v, ww, d - 1);
-        }
+        scatter_rows(X, vertices, points_);
     }
 }
 
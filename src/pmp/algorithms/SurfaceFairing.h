@@ -3,8 +3,6 @@
 
 #pragma once
 
-#include <map>
-
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
@@ -30,13 +28,17 @@ public:
     //! compute surface by solving k-harmonic equation
     //! \throw SolverException in case of failure to solve the linear system
     //! \throw InvalidInputException in case of missing boundary constraints
+    //! \throw CancelledException if cancelled, see set_progress()
     void fair(unsigned int k = 2);
 
-private:
-    void setup_matrix_row(const Vertex v, VertexProperty<double> vweight,
-                          EdgeProperty<double> eweight,
-                          unsigned int laplace_degree,
-                          std::map<Vertex, double>& row);
+    //! \brief Report the progress of subsequent fairing.
+    //! \details Polled after setting up and after factorizing the linear
+    //! system. A cancelled fairing leaves the mesh unchanged. See
+    //! ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
 
 private:
     SurfaceMesh& mesh_; //!< the mesh
@@ -45,9 +47,8 @@ private:
     VertexProperty<Point> points_;
     VertexProperty<bool> vselected_;
     VertexProperty<bool> vlocked_;
-    VertexProperty<double> vweight_;
-    EdgeProperty<double> eweight_;
-    VertexProperty<int> idx_;
+
+    ProgressCallback progress_;
 };
 
 } // namespace pmp
@@ -3,6 +3,7 @@
 
 #include "pmp/algorithms/SurfaceFeatures.h"
 #include "pmp/algorithms/SurfaceNormals.h"
+#include "pmp/Parallel.h"
 
 namespace pmp {
 
@@ -23,41 +24,85 @@ void SurfaceFeatures::clear()
 
 size_t SurfaceFeatures::detect_boundary()
 {
+    return detect_boundary(nullptr);
+}
+
+size_t SurfaceFeatures::detect_boundary(std::vector<Edge>& edges)
+{
+    return detect_boundary(&edges);
+}
+
+size_t SurfaceFeatures::detect_angle(Scalar angle)
+{
+    return detect_angle(angle, nullptr);
+}
+
+size_t SurfaceFeatures::detect_angle(Scalar angle, std::vector<Edge>& edges)
+{
+    return detect_angle(angle, &edges);
+}
+
+size_t SurfaceFeatures::detect_boundary(std::vector<Edge>* edges)
+{
+    // classify in parallel, the packed bool properties are written serially
+    std::vector<char> vboundary(mesh_.vertices_size(), false);
+    parallel_for(mesh_.vertices(), [&](Vertex v) {
+        vboundary[v.idx()] = mesh_.is_boundary(v);
+    });
+    std::vector<char> eboundary(mesh_.edges_size(), false);
+    parallel_for(mesh_.edges(), [&](Edge e) {
+        eboundary[e.idx()] = mesh_.is_boundary(e);
+    });
+
+    // isolated vertices are boundary vertices as well
     for (auto v : mesh_.vertices())
-        if (mesh_.is_boundary(v))
+        if (vboundary[v.idx()])
             vfeature_[v] = true;
 
-    size_t n_edges = 0;
-    for (auto e : mesh_.edges())
-        if (mesh_.is_boundary(e))
-        {
-            efeature_[e] = true;
-            n_edges++;
-        }
-    return n_edges;
+    return mark_edges(eboundary, edges);
 }
 
-size_t SurfaceFeatures::detect_angle(Scalar angle)
+size_t SurfaceFeatures::detect_angle(Scalar angle, std::vector<Edge>* edges)
 {
     const Scalar feature_cosine = cos(angle / 180.0 * M_PI);
-    size_t n_edges = 0;
-    for (auto e : mesh_.edges())
-    {
+
+    // compute each face normal once
+    std::vector<Normal> normals(mesh_.faces_size());
+    parallel_for(mesh_.faces(), [&](Face f) {
+        normals[f.idx()] = SurfaceNormals::compute_face_normal(mesh_, f);
+    });
+
+    std::vector<char> features(mesh_.edges_size(), false);
+    parallel_for(mesh_.edges(), [&](Edge e) {
         if (!mesh_.is_boundary(e))
         {
             const auto f0 = mesh_.face(mesh_.halfedge(e, 0));
             const auto f1 = mesh_.face(mesh_.halfedge(e, 1));
 
-            const Normal n0 = SurfaceNormals::compute_face_normal(mesh_, f0);
-            const Normal n1 = SurfaceNormals::compute_face_normal(mesh_, f1);
+            const Normal& n0 = normals[f0.idx()];
+            const Normal& n1 = normals[f1.idx()];
+
+            features[e.idx()] = dot(n0, n1) < feature_cosine;
+        }
+    });
 
-            if (dot(n0, n1) < feature_cosine)
-            {
-                efeature_[e] = true;
-                vfeature_[mesh_.vertex(e, 0)] = true;
-                vfeature_[mesh_.vertex(e, 1)] = true;
-                n_edges++;
-            }
+    return mark_edges(features, edges);
+}
+
+size_t SurfaceFeatures::mark_edges(const std::vector<char>& features,
+                                   std::vector<Edge>* edges)
+{
+    size_t n_edges = 0;
+    for (auto e : mesh_.edges())
+    {
+        if (features[e.idx()])
+        {
+            efeature_[e] = true;
+            vfeature_[mesh_.vertex(e, 0)] = true;
+            vfeature_[mesh_.vertex(e, 1)] = true;
+            if (edges)
+                edges->push_back(e);
+            n_edges++;
         }
     }
     return n_edges;
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
@@ -29,14 +31,39 @@ public:
     void clear();
 
     //! \brief Mark all boundary edges as features.
+    //! \details Classifies edges and vertices in parallel.
     //! \return The number of boudary edges detected.
     size_t detect_boundary();
 
+    //! \brief Mark all boundary edges as features.
+    //! \details Also appends the boundary edges to \p edges in the order of
+    //! their indices, such that they can be processed without scanning all
+    //! edges again.
+    //! \return The number of boudary edges detected.
+    size_t detect_boundary(std::vector<Edge>& edges);
+
     //! \brief Mark edges with dihedral angle larger than \p angle as feature.
+    //! \details Computes the face normals once and classifies the edges in
+    //! parallel.
     //! \return The number of feature edges detected.
     size_t detect_angle(Scalar angle);
 
+    //! \brief Mark edges with dihedral angle larger than \p angle as feature.
+    //! \details Also appends the detected edges to \p edges in the order of
+    //! their indices, such that they can be processed without scanning all
+    //! edges again.
+    //! \return The number of feature edges detected.
+    size_t detect_angle(Scalar angle, std::vector<Edge>& edges);
+
 private:
+    // mark the edges flagged in \p features and their vertices, optionally
+    // collect them in \p edges
+    size_t mark_edges(const std::vector<char>& features,
+                      std::vector<Edge>* edges);
+
+    size_t detect_boundary(std::vector<Edge>* edges);
+    size_t detect_angle(Scalar angle, std::vector<Edge>* edges);
+
     SurfaceMesh& mesh_;
 
     VertexProperty<bool> vfeature_;
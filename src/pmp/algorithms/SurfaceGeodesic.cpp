@@ -3,13 +3,20 @@
 
 #include "pmp/algorithms/SurfaceGeodesic.h"
 
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
+#include "pmp/algorithms/TextureMapping.h"
+
 namespace pmp {
 
 SurfaceGeodesic::SurfaceGeodesic(SurfaceMesh& mesh, bool use_virtual_edges)
-    : mesh_(mesh), use_virtual_edges_(use_virtual_edges)
+    : mesh_(mesh),
+      use_virtual_edges_(use_virtual_edges),
+      front_(mesh.vertices_size()),
+      local_distances_(true)
 {
-    distance_ = mesh_.add_vertex_property<Scalar>("geodesic:distance");
-    processed_ = mesh_.add_vertex_property<bool>("geodesic:processed");
+    distance_ = mesh_.add_vertex_property<Scalar>(
+        "geodesic:distance", std::numeric_limits<Scalar>::max());
 
     if (use_virtual_edges_)
         find_virtual_edges();
@@ -18,133 +25,162 @@ SurfaceGeodesic::SurfaceGeodesic(SurfaceMesh& mesh, bool use_virtual_edges)
 SurfaceGeodesic::~SurfaceGeodesic()
 {
     mesh_.remove_vertex_property(distance_);
-    mesh_.remove_vertex_property(processed_);
 }
 
 void SurfaceGeodesic::find_virtual_edges()
 {
-    Halfedge hh, hhh;
-    Vertex vh0, vh1, vhn, start_vh0, start_vh1;
-    Point pp, p0, p1, pn, p, d0, d1;
-    Point X, Y;
-    vec2 v0, v1, vn, v, d;
-    Scalar f, alpha, beta, tan_beta;
-
-    const Scalar one(1.0), minus_one(-1.0);
     const Scalar max_angle = 90.0 / 180.0 * M_PI;
     const Scalar max_angle_cos = cos(max_angle);
 
-    virtual_edges_.clear();
+    virtual_edges_.assign(mesh_.halfedges_size(), VirtualEdge());
 
-    for (auto vv : mesh_.vertices())
-    {
-        pp = mesh_.position(vv);
+    // each vertex stores the virtual edges of its outgoing halfedges
+    const int n = int(mesh_.vertices_size());
+    parallel_for(
+        0, n,
+        [&](int i) {
+            const Vertex vv(i);
+            if (mesh_.is_deleted(vv))
+                return;
 
-        for (auto h : mesh_.halfedges(vv))
-        {
-            if (!mesh_.is_boundary(h))
-            {
-                vh0 = mesh_.to_vertex(h);
-                hh = mesh_.next_halfedge(h);
-                vh1 = mesh_.to_vertex(hh);
+            Halfedge hh, hhh;
+            Vertex vh0, vh1, vhn, start_vh0, start_vh1;
+            Point pp, p0, p1, pn, p, d0, d1;
+            Point X, Y;
+            vec2 v0, v1, vn, v, d;
+            Scalar f, alpha, beta, tan_beta;
+
+            const Scalar one(1.0), minus_one(-1.0);
 
-                p0 = mesh_.position(vh0);
-                p1 = mesh_.position(vh1);
-                d0 = normalize(p0 - pp);
-                d1 = normalize(p1 - pp);
+            pp = mesh_.position(vv);
 
-                // obtuse angle ?
-                if (dot(d0, d1) < max_angle_cos)
+            for (auto h : mesh_.halfedges(vv))
+            {
+                if (!mesh_.is_boundary(h))
                 {
-                    // compute angles
-                    alpha = 0.5 * acos(std::min(
-                                      one, std::max(minus_one, dot(d0, d1))));
-                    beta = max_angle - alpha;
-                    tan_beta = tan(beta);
-
-                    // coord system
-                    X = normalize(d0 + d1);
-                    Y = normalize(cross(cross(d0, d1), X));
-
-                    // 2D coords
-                    d0 = p0 - pp;
-                    d1 = p1 - pp;
-                    v0[0] = dot(d0, X);
-                    v0[1] = dot(d0, Y);
-                    v1[0] = dot(d1, X);
-                    v1[1] = dot(d1, Y);
-
-                    start_vh0 = vh0;
-                    start_vh1 = vh1;
-                    hhh = mesh_.opposite_halfedge(hh);
-
-                    // unfold ...
-                    while (((vh0 == start_vh0) || (vh1 == start_vh1)) &&
-                           (!mesh_.is_boundary(hhh)))
+                    vh0 = mesh_.to_vertex(h);
+                    hh = mesh_.next_halfedge(h);
+                    vh1 = mesh_.to_vertex(hh);
+
+                    p0 = mesh_.position(vh0);
+                    p1 = mesh_.position(vh1);
+                    d0 = normalize(p0 - pp);
+                    d1 = normalize(p1 - pp);
+
+                    // obtuse angle ?
+                    if (dot(d0, d1) < max_angle_cos)
                     {
-                        // get next point
-                        vhn = mesh_.to_vertex(mesh_.next_halfedge(hhh));
-                        pn = mesh_.position(vhn);
-                        d0 = (p1 - p0);
-                        d1 = (pn - p0);
-                        d = (v1 - v0);
-                        f = dot(d0, d1) / sqrnorm(d0);
-                        p = p0 + f * d0;
-                        v = v0 + f * d;
-                        d = normalize(vec2(d[1], -d[0]));
-                        vn = v + d * norm(p - pn);
-
-                        // point in tolerance?
-                        if ((fabs(vn[1]) / fabs(vn[0])) < tan_beta)
-                        {
-                            virtual_edges_.insert(
-                                std::pair<Halfedge, VirtualEdge>(
-                                    h, VirtualEdge(vhn, norm(vn))));
-                            break;
-                        }
+                        // compute angles
+                        alpha = 0.5 * acos(std::min(
+                                          one,
+                                          std::max(minus_one, dot(d0, d1))));
+                        beta = max_angle - alpha;
+                        tan_beta = tan(beta);
+
+                        // coord system
+                        X = normalize(d0 + d1);
+                        Y = normalize(cross(cross(d0, d1), X));
+
+                        // 2D coords
+                        d0 = p0 - pp;
+                        d1 = p1 - pp;
+                        v0[0] = dot(d0, X);
+                        v0[1] = dot(d0, Y);
+                        v1[0] = dot(d1, X);
+                        v1[1] = dot(d1, Y);
+
+                        start_vh0 = vh0;
+                        start_vh1 = vh1;
+                        hhh = mesh_.opposite_halfedge(hh);
 
-                        // prepare next edge
-                        if (vn[1] > 0.0)
-                        {
-                            hh = mesh_.opposite_halfedge(hh);
-                            hh = mesh_.next_halfedge(hh);
-                            vh1 = vhn;
-                            p1 = pn;
-                            v1 = vn;
-                        }
-                        else
+                        // unfold ...
+                        while (((vh0 == start_vh0) || (vh1 == start_vh1)) &&
+                               (!mesh_.is_boundary(hhh)))
                         {
-                            hh = mesh_.opposite_halfedge(hh);
-                            hh = mesh_.next_halfedge(hh);
-                            hh = mesh_.next_halfedge(hh);
-                            vh0 = vhn;
-                            p0 = pn;
-                            v0 = vn;
+                            // get next point
+                            vhn = mesh_.to_vertex(mesh_.next_halfedge(hhh));
+                            pn = mesh_.position(vhn);
+                            d0 = (p1 - p0);
+                            d1 = (pn - p0);
+                            d = (v1 - v0);
+                            f = dot(d0, d1) / sqrnorm(d0);
+                            p = p0 + f * d0;
+                            v = v0 + f * d;
+                            d = normalize(vec2(d[1], -d[0]));
+                            vn = v + d * norm(p - pn);
+
+                            // point in tolerance?
+                            if ((fabs(vn[1]) / fabs(vn[0])) < tan_beta)
+                            {
+                                virtual_edges_[h.idx()] =
+                                    VirtualEdge(vhn, norm(vn));
+                                break;
+                            }
+
+                            // prepare next edge
+                            if (vn[1] > 0.0)
+                            {
+                                hh = mesh_.opposite_halfedge(hh);
+                                hh = mesh_.next_halfedge(hh);
+                                vh1 = vhn;
+                                p1 = pn;
+                                v1 = vn;
+                            }
+                            else
+                            {
+                                hh = mesh_.opposite_halfedge(hh);
+                                hh = mesh_.next_halfedge(hh);
+                                hh = mesh_.next_halfedge(hh);
+                                vh0 = vhn;
+                                p0 = pn;
+                                v0 = vn;
+                            }
+                            hhh = mesh_.opposite_halfedge(hh);
                         }
-                        hhh = mesh_.opposite_halfedge(hh);
                     }
                 }
             }
-        }
-    }
+        },
+        256);
 }
 
 unsigned int SurfaceGeodesic::compute(const std::vector<Vertex>& seed,
                                       Scalar maxdist, unsigned int maxnum,
                                       std::vector<Vertex>* neighbors)
 {
+    PMP_PROFILE_SCOPE("SurfaceGeodesic::compute");
+
     unsigned int num(0);
 
-    // generate front
-    front_ = new PriorityQueue(VertexCmp(distance_));
+    // reset the distances of the previous call
+    const Scalar max = std::numeric_limits<Scalar>::max();
+    if (front_.distance.size() != mesh_.vertices_size())
+    {
+        front_ = Front(mesh_.vertices_size());
+        local_distances_ = false;
+    }
+    if (local_distances_)
+    {
+        for (auto v : front_.touched)
+            distance_[v] = max;
+    }
+    else
+    {
+        for (auto v : mesh_.vertices())
+            distance_[v] = max;
+        local_distances_ = true;
+    }
+    front_.reset();
+    Front& front = front_;
 
     // initialize front with given seed
-    num = init_front(seed, neighbors);
+    num = init_front(front, seed, neighbors);
 
     // sort one-ring neighbors of seed vertices
     if (neighbors)
     {
-        std::sort(neighbors->begin(), neighbors->end(), VertexCmp(distance_));
+        std::sort(neighbors->begin(), neighbors->end(),
+                  VertexCmp(front.distance));
     }
 
     // correct if seed vertices have more than maxnum neighbors
@@ -157,29 +193,98 @@ unsigned int SurfaceGeodesic::compute(const std::vector<Vertex>& seed,
 
     // propagate up to max distance or max number of neighbors
     if (num < maxnum)
-        num += propagate_front(maxdist, maxnum - num, neighbors);
+        num += propagate_front(front, maxdist, maxnum - num, neighbors);
 
-    // clean up
-    delete front_;
+    // store distances
+    for (auto v : front.touched)
+        distance_[v] = front.distance[v.idx()];
 
     return num;
 }
 
-unsigned int SurfaceGeodesic::init_front(const std::vector<Vertex>& seed,
-                                         std::vector<Vertex>* neighbors)
+Eigen::MatrixXd SurfaceGeodesic::distances(
+    const std::vector<std::vector<Vertex>>& seeds, Scalar maxdist) const
 {
-    unsigned int num(0);
+    const int m = int(seeds.size());
+    Eigen::MatrixXd D(mesh_.vertices_size(), m);
+
+    parallel_for_chunks(
+        0, m,
+        [&](int first, int last) {
+            // one front per chunk, reset between its seed sets
+            Front front(mesh_.vertices_size());
+            for (int j = first; j < last; ++j)
+            {
+                front.reset();
+                init_front(front, seeds[j], nullptr);
+                propagate_front(front, maxdist, INT_MAX, nullptr);
+                for (size_t i = 0; i < front.distance.size(); ++i)
+                    D(i, j) = front.distance[i];
+            }
+        },
+        1);
 
-    if (seed.empty())
-        return num;
+    return D;
+}
 
-    // reset all vertices
+std::vector<Vertex> SurfaceGeodesic::farthest_point_sampling(
+    unsigned int n, Vertex start, std::vector<unsigned int>* regions)
+{
+    std::vector<Vertex> samples;
+    const size_t nv = mesh_.vertices_size();
+    std::vector<Scalar> nearest(nv, std::numeric_limits<Scalar>::max());
+    if (regions)
+        regions->assign(nv, 0);
+
+    // vertices by decreasing distance to the closest sample
+    PriorityQueue farthest(nv);
     for (auto v : mesh_.vertices())
+        farthest.insert(v, -nearest[v.idx()]);
+
+    Front front(nv);
+    while (samples.size() < n && !farthest.empty())
     {
-        processed_[v] = false;
-        distance_[v] = std::numeric_limits<Scalar>::max();
+        Vertex s = farthest.front();
+        if (samples.empty() && farthest.is_stored(start))
+            s = start;
+        farthest.remove(s);
+        samples.push_back(s);
+
+        // propagate over the vertices closer to the new sample
+        front.reset();
+        init_front(front, std::vector<Vertex>{s}, nullptr);
+        propagate_front(front, std::numeric_limits<Scalar>::max(), INT_MAX,
+                        nullptr, &nearest);
+
+        for (auto v : front.touched)
+        {
+            const Scalar d = front.distance[v.idx()];
+            if (d >= nearest[v.idx()])
+                continue;
+            nearest[v.idx()] = d;
+            if (regions)
+                (*regions)[v.idx()] = (unsigned int)(samples.size() - 1);
+            if (farthest.is_stored(v))
+                farthest.update(v, -d);
+        }
     }
 
+    for (auto v : mesh_.vertices())
+        distance_[v] = nearest[v.idx()];
+    local_distances_ = false;
+
+    return samples;
+}
+
+unsigned int SurfaceGeodesic::init_front(Front& front,
+                                         const std::vector<Vertex>& seed,
+                                         std::vector<Vertex>* neighbors) const
+{
+    unsigned int num(0);
+
+    if (seed.empty())
+        return num;
+
     // initialize neighbor array
     if (neighbors)
         neighbors->clear();
@@ -187,8 +292,8 @@ unsigned int SurfaceGeodesic::init_front(const std::vector<Vertex>& seed,
     // initialize seed vertices
     for (auto v : seed)
     {
-        processed_[v] = true;
-        distance_[v] = 0.0;
+        front.processed[v.idx()] = true;
+        front.set_distance(v, 0.0);
     }
 
     // initialize seed's one-ring
@@ -198,10 +303,10 @@ unsigned int SurfaceGeodesic::init_front(const std::vector<Vertex>& seed,
         {
             const Scalar dist =
                 pmp::distance(mesh_.position(v), mesh_.position(vv));
-            if (dist < distance_[vv])
+            if (dist < front.distance[vv.idx()])
             {
-                distance_[vv] = dist;
-                processed_[vv] = true;
+                front.set_distance(vv, dist);
+                front.processed[vv.idx()] = true;
                 ++num;
                 if (neighbors)
                     neighbors->push_back(vv);
@@ -210,16 +315,16 @@ unsigned int SurfaceGeodesic::init_front(const std::vector<Vertex>& seed,
     }
 
     // init marching front
-    front_->clear();
+    front.queue.clear();
     for (auto v : seed)
     {
         for (auto vv : mesh_.vertices(v))
         {
             for (auto vvv : mesh_.vertices(vv))
             {
-                if (!processed_[vvv])
+                if (!front.processed[vvv.idx()])
                 {
-                    heap_vertex(vvv);
+                    heap_vertex(front, vvv);
                 }
             }
         }
@@ -228,37 +333,41 @@ unsigned int SurfaceGeodesic::init_front(const std::vector<Vertex>& seed,
     return num;
 }
 
-unsigned int SurfaceGeodesic::propagate_front(Scalar maxdist,
-                                              unsigned int maxnum,
-                                              std::vector<Vertex>* neighbors)
+unsigned int SurfaceGeodesic::propagate_front(
+    Front& front, Scalar maxdist, unsigned int maxnum,
+    std::vector<Vertex>* neighbors, const std::vector<Scalar>* bound) const
 {
     unsigned int num(0);
 
-    while (!front_->empty())
+    while (!front.queue.empty())
     {
         // find minimum vertex, remove it from queue
-        auto v = *front_->begin();
-        front_->erase(front_->begin());
-        assert(!processed_[v]);
-        processed_[v] = true;
+        auto v = front.queue.front();
+        front.queue.pop_front();
+        assert(!front.processed[v.idx()]);
+        front.processed[v.idx()] = true;
         ++num;
         if (neighbors)
             neighbors->push_back(v);
 
         // did we reach maximum distance?
-        if (distance_[v] > maxdist)
+        if (front.distance[v.idx()] > maxdist)
             break;
 
         // did we reach maximum number of neighbors
         if (num >= maxnum)
             break;
 
+        // is the vertex closer to another front?
+        if (bound && front.distance[v.idx()] >= (*bound)[v.idx()])
+            continue;
+
         // update front
         for (auto vv : mesh_.vertices(v))
         {
-            if (!processed_[vv])
+            if (!front.processed[vv.idx()])
             {
-                heap_vertex(vv);
+                heap_vertex(front, vv);
             }
         }
     }
@@ -266,30 +375,31 @@ unsigned int SurfaceGeodesic::propagate_front(Scalar maxdist,
     return num;
 }
 
-void SurfaceGeodesic::heap_vertex(Vertex v)
+void SurfaceGeodesic::heap_vertex(Front& front, Vertex v) const
 {
-    assert(!processed_[v]);
+    assert(!front.processed[v.idx()]);
 
     Vertex v0, v1, vv, v0_min, v1_min;
     Scalar dist, dist_min(std::numeric_limits<Scalar>::max()), d;
-    typename VirtualEdges::const_iterator ve_it, ve_end(virtual_edges_.end());
     bool found(false);
+    const std::vector<bool>& processed = front.processed;
 
     for (auto h : mesh_.halfedges(v))
     {
         if (!mesh_.is_boundary(h))
         {
-            ve_it = virtual_edges_.find(h);
+            const VirtualEdge* ve =
+                virtual_edges_.empty() ? nullptr : &virtual_edges_[h.idx()];
 
             // no virtual edge
-            if (ve_it == ve_end)
+            if (!ve || !ve->vertex.is_valid())
             {
                 v0 = mesh_.to_vertex(h);
                 v1 = mesh_.to_vertex(mesh_.next_halfedge(h));
 
-                if (processed_[v0] && processed_[v1])
+                if (processed[v0.idx()] && processed[v1.idx()])
                 {
-                    dist = distance(v0, v1, v);
+                    dist = distance(front, v0, v1, v);
                     if (dist < dist_min)
                     {
                         dist_min = dist;
@@ -303,12 +413,12 @@ void SurfaceGeodesic::heap_vertex(Vertex v)
             {
                 v0 = mesh_.to_vertex(h);
                 v1 = mesh_.to_vertex(mesh_.next_halfedge(h));
-                vv = ve_it->second.vertex;
-                d = ve_it->second.length;
+                vv = ve->vertex;
+                d = ve->length;
 
-                if (processed_[v0] && processed_[vv])
+                if (processed[v0.idx()] && processed[vv.idx()])
                 {
-                    dist = distance(v0, vv, v,
+                    dist = distance(front, v0, vv, v,
                                     std::numeric_limits<Scalar>::max(), d);
                     if (dist < dist_min)
                     {
@@ -317,9 +427,9 @@ void SurfaceGeodesic::heap_vertex(Vertex v)
                     }
                 }
 
-                if (processed_[v1] && processed_[vv])
+                if (processed[v1.idx()] && processed[vv.idx()])
                 {
-                    dist = distance(vv, v1, v, d,
+                    dist = distance(front, vv, v1, v, d,
                                     std::numeric_limits<Scalar>::max());
                     if (dist < dist_min)
                     {
@@ -334,23 +444,17 @@ void SurfaceGeodesic::heap_vertex(Vertex v)
     // update priority queue
     if (found)
     {
-        if (distance_[v] != std::numeric_limits<Scalar>::max())
-        {
-            auto it = front_->find(v);
-            assert(it != front_->end());
-            front_->erase(it);
-        }
-
-        distance_[v] = dist_min;
-        front_->insert(v);
+        front.set_distance(v, dist_min);
+        if (front.queue.is_stored(v))
+            front.queue.update(v, dist_min);
+        else
+            front.queue.insert(v, dist_min);
     }
     else
     {
-        if (distance_[v] != std::numeric_limits<Scalar>::max())
-        {
-            front_->erase(v);
-            distance_[v] = std::numeric_limits<Scalar>::max();
-        }
+        if (front.queue.is_stored(v))
+            front.queue.lazy_remove(v);
+        front.distance[v.idx()] = std::numeric_limits<Scalar>::max();
     }
 }
 
@@ -359,21 +463,23 @@ bool valid_triangle(double a, double b, double c)
     return (a + b > c && a + c > b && b + c > a);
 }
 
-Scalar SurfaceGeodesic::distance(Vertex v0, Vertex v1, Vertex v2, Scalar r0,
-                                 Scalar r1)
+Scalar SurfaceGeodesic::distance(const Front& front, Vertex v0, Vertex v1,
+                                 Vertex v2, Scalar r0, Scalar r1) const
 {
+    const std::vector<Scalar>& field = front.distance;
+
     Point A, B, C;
     double TA, TB;
     double a, b;
 
     // choose points such that TB>TA and hence u>0
-    if (distance_[v0] < distance_[v1])
+    if (field[v0.idx()] < field[v1.idx()])
     {
         A = mesh_.position(v0);
         B = mesh_.position(v1);
         C = mesh_.position(v2);
-        TA = distance_[v0];
-        TB = distance_[v1];
+        TA = field[v0.idx()];
+        TB = field[v1.idx()];
         a = r1 == std::numeric_limits<Scalar>::max() ? pmp::distance(B, C) : r1;
         b = r0 == std::numeric_limits<Scalar>::max() ? pmp::distance(A, C) : r0;
     }
@@ -382,8 +488,8 @@ Scalar SurfaceGeodesic::distance(Vertex v0, Vertex v1, Vertex v2, Scalar r0,
         A = mesh_.position(v1);
         B = mesh_.position(v0);
         C = mesh_.position(v2);
-        TA = distance_[v1];
-        TB = distance_[v0];
+        TA = field[v1.idx()];
+        TB = field[v0.idx()];
         a = r0 == std::numeric_limits<Scalar>::max() ? pmp::distance(B, C) : r0;
         b = r1 == std::numeric_limits<Scalar>::max() ? pmp::distance(A, C) : r1;
     }
@@ -420,28 +526,7 @@ Scalar SurfaceGeodesic::distance(Vertex v0, Vertex v1, Vertex v2, Scalar r0,
 
 void SurfaceGeodesic::distance_to_texture_coordinates()
 {
-    // find maximum distance
-    Scalar maxdist(0);
-    for (auto v : mesh_.vertices())
-    {
-        if (distance_[v] < std::numeric_limits<Scalar>::max())
-        {
-            maxdist = std::max(maxdist, distance_[v]);
-        }
-    }
-
-    auto tex = mesh_.vertex_property<TexCoord>("v:tex");
-    for (auto v : mesh_.vertices())
-    {
-        if (distance_[v] < std::numeric_limits<Scalar>::max())
-        {
-            tex[v] = TexCoord(distance_[v] / maxdist, 0.0);
-        }
-        else
-        {
-            tex[v] = TexCoord(1.0, 0.0);
-        }
-    }
+    distances_to_texture_coordinates(mesh_, distance_);
 }
 
 } // namespace pmp
@@ -4,10 +4,12 @@
 #pragma once
 
 #include <limits>
-#include <set>
 #include <vector>
 
+#include <Eigen/Dense>
+
 #include "pmp/SurfaceMesh.h"
+#include "pmp/algorithms/Heap.h"
 
 namespace pmp {
 
@@ -22,7 +24,8 @@ public:
     //! \brief Construct from mesh.
     //! \param mesh The mesh on which to compute the geodesic distances.
     //! \param use_virtual_edges A flag to control the use of virtual edges.
-    //! Default: true.
+    //! Default: true. The virtual edges are found once in parallel and
+    //! reused by all calls to compute().
     //! \sa compute() to actually compute the geodesic distances.
     SurfaceGeodesic(SurfaceMesh& mesh, bool use_virtual_edges = true);
 
@@ -37,11 +40,42 @@ public:
     //! compute the geodesic distances.
     //! \param[out] neighbors The vector of neighbor vertices.
     //! \return The number of neighbors that have been found.
+    //! \note Only the vertices reached by the previous call are reset, so
+    //! local queries with small \p maxdist or \p maxnum cost time in the
+    //! size of the neighborhood, not of the mesh. See visited().
     unsigned int compute(const std::vector<Vertex>& seed,
                          Scalar maxdist = std::numeric_limits<Scalar>::max(),
                          unsigned int maxnum = INT_MAX,
                          std::vector<Vertex>* neighbors = nullptr);
 
+    //! \brief Compute distance fields from several seed sets concurrently.
+    //! \details Each thread propagates its own front, the virtual edges are
+    //! shared. Does not change the distances accessed by operator().
+    //! \param[in] seeds The seed vertices of each distance field.
+    //! \param[in] maxdist The maximum distance up to which to compute the
+    //! geodesic distances.
+    //! \return A matrix whose column j contains the distances from the
+    //! vertices in \p seeds[j], indexed by vertex index. Vertices that have
+    //! not been reached get the maximum Scalar.
+    Eigen::MatrixXd distances(
+        const std::vector<std::vector<Vertex>>& seeds,
+        Scalar maxdist = std::numeric_limits<Scalar>::max()) const;
+
+    //! \brief Sample vertices by farthest point sampling.
+    //! \details Starts at \p start and repeatedly adds the vertex farthest
+    //! from all samples so far. The front of a new sample only propagates
+    //! as long as it is closer than the previous samples, i.e., over the
+    //! geodesic Voronoi cell of the sample, instead of over the whole mesh.
+    //! Afterwards, operator() returns the distance to the closest sample.
+    //! \param[in] n The number of samples.
+    //! \param[in] start The first sample.
+    //! \param[out] regions The index of the closest sample of each vertex,
+    //! indexed by vertex index.
+    //! \return The samples, fewer than \p n if the mesh has fewer vertices.
+    std::vector<Vertex> farthest_point_sampling(
+        unsigned int n, Vertex start = Vertex(0),
+        std::vector<unsigned int>* regions = nullptr);
+
     //! \brief Access the computed geodesic distance.
     //! \param[in] v The vertex for which to return the geodesic distance.
     //! \return The geodesic distance of vertex \p v.
@@ -50,6 +84,13 @@ public:
     //! used during construction.
     Scalar operator()(Vertex v) const { return distance_[v]; }
 
+    //! \brief The vertices reached by the last call to compute().
+    //! \details These are the vertices whose distance is below the maximum
+    //! Scalar, including the seeds and the vertices on the front beyond
+    //! \p maxdist or \p maxnum, in the order they were first reached. All
+    //! other vertices have the maximum Scalar as distance.
+    const std::vector<Vertex>& visited() const { return front_.touched; }
+
     //! \brief Use the normalized distances as texture coordinates
     //! \details Stores the normalized distances in a vertex property of type
     //! TexCoord named "v:tex". Re-uses any existing vertex property of the
@@ -61,51 +102,100 @@ private:
     class VertexCmp
     {
     public:
-        VertexCmp(const VertexProperty<Scalar>& dist) : dist_(dist) {}
+        VertexCmp(const std::vector<Scalar>& dist) : dist_(dist) {}
 
         bool operator()(Vertex v0, Vertex v1) const
         {
-            return ((dist_[v0] == dist_[v1]) ? (v0 < v1)
-                                             : (dist_[v0] < dist_[v1]));
+            const Scalar d0 = dist_[v0.idx()], d1 = dist_[v1.idx()];
+            return ((d0 == d1) ? (v0 < v1) : (d0 < d1));
         }
 
     private:
-        const VertexProperty<Scalar>& dist_;
+        const std::vector<Scalar>& dist_;
     };
 
-    // priority queue using geodesic distance as sorting criterion
-    typedef std::set<Vertex, VertexCmp> PriorityQueue;
+    // priority queue using geodesic distance as sorting criterion, ties are
+    // broken by the vertex index as by VertexCmp
+    typedef DAryHeap<Vertex, Scalar> PriorityQueue;
+
+    // state of a marching front, one per concurrently computed distance
+    // field
+    struct Front
+    {
+        explicit Front(size_t n)
+            : distance(n, std::numeric_limits<Scalar>::max()),
+              processed(n, false),
+              queue(n)
+        {
+        }
+
+        // set the distance of v, remembering which vertices to reset
+        void set_distance(Vertex v, Scalar d)
+        {
+            if (distance[v.idx()] == std::numeric_limits<Scalar>::max())
+                touched.push_back(v);
+            distance[v.idx()] = d;
+        }
+
+        // reset the touched vertices to the initial state
+        void reset()
+        {
+            for (auto v : touched)
+            {
+                distance[v.idx()] = std::numeric_limits<Scalar>::max();
+                processed[v.idx()] = false;
+            }
+            touched.clear();
+            queue.clear();
+        }
 
-    // virtual edges for walking through obtuse triangles
+        std::vector<Scalar> distance;
+        std::vector<bool> processed;
+        std::vector<Vertex> touched;
+        PriorityQueue queue;
+    };
+
+    // virtual edges for walking through obtuse triangles, the vertex is
+    // invalid if there is none
     struct VirtualEdge
     {
+        VirtualEdge() : length(0) {}
         VirtualEdge(Vertex v, Scalar l) : vertex(v), length(l) {}
         Vertex vertex;
         Scalar length;
     };
 
-    // set for storing virtual edges
-    typedef std::map<Halfedge, VirtualEdge> VirtualEdges;
+    // virtual edges indexed by the halfedge spanning the obtuse angle
+    typedef std::vector<VirtualEdge> VirtualEdges;
 
     void find_virtual_edges();
-    unsigned int init_front(const std::vector<Vertex>& seed,
-                            std::vector<Vertex>* neighbors);
-    unsigned int propagate_front(Scalar maxdist, unsigned int maxnum,
-                                 std::vector<Vertex>* neighbors);
-    void heap_vertex(Vertex v);
-    Scalar distance(Vertex v0, Vertex v1, Vertex v2,
+    unsigned int init_front(Front& front, const std::vector<Vertex>& seed,
+                            std::vector<Vertex>* neighbors) const;
+
+    // propagate the front, vertices at least as far as their bound are not
+    // expanded
+    unsigned int propagate_front(
+        Front& front, Scalar maxdist, unsigned int maxnum,
+        std::vector<Vertex>* neighbors,
+        const std::vector<Scalar>* bound = nullptr) const;
+    void heap_vertex(Front& front, Vertex v) const;
+    Scalar distance(const Front& front, Vertex v0, Vertex v1, Vertex v2,
                     Scalar r0 = std::numeric_limits<Scalar>::max(),
-                    Scalar r1 = std::numeric_limits<Scalar>::max());
+                    Scalar r1 = std::numeric_limits<Scalar>::max()) const;
 
     SurfaceMesh& mesh_;
 
     bool use_virtual_edges_;
     VirtualEdges virtual_edges_;
 
-    PriorityQueue* front_;
-
     VertexProperty<Scalar> distance_;
-    VertexProperty<bool> processed_;
+
+    // front of compute(), kept between calls to reset only its vertices
+    Front front_;
+
+    // whether distance_ is the maximum Scalar outside of front_.touched,
+    // which farthest_point_sampling() does not maintain
+    bool local_distances_;
 };
 
 } // namespace pmp
@@ -0,0 +1,271 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfaceHeatGeodesic.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/TextureMapping.h"
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+SurfaceHeatGeodesic::SurfaceHeatGeodesic(SurfaceMesh& mesh, Scalar time_factor)
+    : mesh_(mesh), n_components_(0)
+{
+    if (!mesh_.is_triangle_mesh())
+    {
+        auto what = "SurfaceHeatGeodesic: Not a triangle mesh.";
+        throw InvalidInputException(what);
+    }
+
+    const size_t n = mesh_.vertices_size();
+
+    // label the connected components, the first vertex of each component
+    // fixes the constant of the Poisson equation
+    component_.assign(n, -1);
+    std::vector<Vertex> heat_vertices, poisson_vertices, stack;
+    for (auto v : mesh_.vertices())
+    {
+        if (component_[v.idx()] != -1)
+            continue;
+
+        component_[v.idx()] = n_components_;
+        stack.push_back(v);
+        while (!stack.empty())
+        {
+            const Vertex w = stack.back();
+            stack.pop_back();
+            if (!mesh_.is_isolated(w))
+            {
+                heat_vertices.push_back(w);
+                if (w != v)
+                    poisson_vertices.push_back(w);
+            }
+            for (auto vv : mesh_.vertices(w))
+            {
+                if (component_[vv.idx()] == -1)
+                {
+                    component_[vv.idx()] = n_components_;
+                    stack.push_back(vv);
+                }
+            }
+        }
+        ++n_components_;
+    }
+
+    heat_index_.assign(n, -1);
+    for (size_t i = 0; i < heat_vertices.size(); ++i)
+        heat_index_[heat_vertices[i].idx()] = int(i);
+    poisson_index_.assign(n, -1);
+    for (size_t i = 0; i < poisson_vertices.size(); ++i)
+        poisson_index_[poisson_vertices[i].idx()] = int(i);
+
+    // per halfedge of a face: the gradient of the hat function of the
+    // opposite vertex and the cotangent-weighted halfedge vector
+    gradient_.assign(mesh_.halfedges_size(), dvec3(0, 0, 0));
+    divergence_.assign(mesh_.halfedges_size(), dvec3(0, 0, 0));
+    const int nf = int(mesh_.faces_size());
+    parallel_for(0, nf, [&](int i) {
+        const Face f(i);
+        if (mesh_.is_deleted(f))
+            return;
+
+        for (auto h : mesh_.halfedges(f))
+        {
+            const dvec3 a(mesh_.position(mesh_.from_vertex(h)));
+            const dvec3 b(mesh_.position(mesh_.to_vertex(h)));
+            const dvec3 c(
+                mesh_.position(mesh_.to_vertex(mesh_.next_halfedge(h))));
+            const dvec3 e = b - a;
+            const dvec3 normal = cross(e, c - a);
+            const double area2 = sqrnorm(normal);
+            if (area2 <= std::numeric_limits<double>::min())
+                continue;
+
+            gradient_[h.idx()] = cross(normal, e) / area2;
+            const double cot = dot(a - c, b - c) / std::sqrt(area2);
+            divergence_[h.idx()] = clamp_cot(cot) * e;
+        }
+    });
+
+    // mean edge length for the time step
+    double length = 0.0;
+    for (auto e : mesh_.edges())
+        length += mesh_.edge_length(e);
+    if (mesh_.n_edges())
+        length /= mesh_.n_edges();
+    const double t = time_factor * length * length;
+
+    // the Laplacian uses the cotangents of both angles without the factor
+    // 1/2, hence the heat operator is M - t/2 L and the Poisson equation
+    // L phi = div X uses the same scaling for the divergence
+    LaplaceOperator heat(mesh_, heat_vertices);
+    LinearSolver::SparseMatrix A = -0.5 * t * heat.matrix();
+    A.diagonal() += heat.mass();
+    heat_solver_.compute(A);
+
+    // the Laplacian is negative semi-definite, the fixed vertices make it
+    // definite
+    if (!poisson_vertices.empty())
+    {
+        LaplaceOperator poisson(mesh_, poisson_vertices);
+        poisson_solver_.compute(-poisson.matrix());
+    }
+
+    distance_ = mesh_.add_vertex_property<Scalar>("heat:distance");
+}
+
+SurfaceHeatGeodesic::~SurfaceHeatGeodesic()
+{
+    mesh_.remove_vertex_property(distance_);
+}
+
+void SurfaceHeatGeodesic::compute(const std::vector<Vertex>& seed)
+{
+    const Eigen::MatrixXd D = distances({seed});
+    for (auto v : mesh_.vertices())
+        distance_[v] = Scalar(D(v.idx(), 0));
+}
+
+Eigen::MatrixXd SurfaceHeatGeodesic::distances(
+    const std::vector<std::vector<Vertex>>& seeds) const
+{
+    const int n = int(mesh_.vertices_size());
+    const int nf = int(mesh_.faces_size());
+    const int m = int(seeds.size());
+    const double infinity = std::numeric_limits<Scalar>::max();
+
+    Eigen::MatrixXd D = Eigen::MatrixXd::Constant(n, m, infinity);
+    if (m == 0)
+        return D;
+
+    // deleted vertices have no component, they are rejected like invalid
+    // handles before any table is indexed
+    for (const auto& seed : seeds)
+        for (auto v : seed)
+            if (v.idx() >= IndexType(n) || component_[v.idx()] == -1)
+            {
+                auto what = "SurfaceHeatGeodesic: Seed is not a vertex of "
+                            "the mesh.";
+                throw InvalidInputException(what);
+            }
+
+    // diffuse heat from the seeds
+    const auto n_heat = std::count_if(heat_index_.begin(), heat_index_.end(),
+                                      [](int i) { return i != -1; });
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(n_heat, m);
+    for (int j = 0; j < m; ++j)
+        for (auto v : seeds[j])
+            if (heat_index_[v.idx()] != -1)
+                B(heat_index_[v.idx()], j) = 1.0;
+    Eigen::MatrixXd U;
+    if (n_heat && !heat_solver_.solve(B, U))
+    {
+        auto what = "SurfaceHeatGeodesic: Failed to solve heat equation.";
+        throw SolverException(what);
+    }
+
+    // normalized negative gradients per face and seed set
+    std::vector<dvec3> field(size_t(nf) * m, dvec3(0, 0, 0));
+    parallel_for(0, nf, [&](int i) {
+        const Face f(i);
+        if (mesh_.is_deleted(f))
+            return;
+
+        for (int j = 0; j < m; ++j)
+        {
+            dvec3 gradient(0, 0, 0);
+            for (auto h : mesh_.halfedges(f))
+            {
+                const Vertex v = mesh_.to_vertex(mesh_.next_halfedge(h));
+                gradient += U(heat_index_[v.idx()], j) * gradient_[h.idx()];
+            }
+            const double length = norm(gradient);
+            if (length > std::numeric_limits<double>::min())
+                field[size_t(i) * m + j] = -gradient / length;
+        }
+    });
+
+    // divergence at the vertices of the Poisson system
+    const auto n_poisson =
+        std::count_if(poisson_index_.begin(), poisson_index_.end(),
+                      [](int i) { return i != -1; });
+    B.setZero(n_poisson, m);
+    parallel_for(
+        0, n,
+        [&](int i) {
+            const int row = poisson_index_[i];
+            if (row == -1)
+                return;
+
+            for (auto h : mesh_.halfedges(Vertex(i)))
+            {
+                const Face f = mesh_.face(h);
+                const Halfedge o = mesh_.opposite_halfedge(h);
+                const Face g = mesh_.face(o);
+                for (int j = 0; j < m; ++j)
+                {
+                    double div = 0.0;
+                    if (f.is_valid())
+                        div += dot(divergence_[h.idx()],
+                                   field[size_t(f.idx()) * m + j]);
+                    if (g.is_valid())
+                        div -= dot(divergence_[o.idx()],
+                                   field[size_t(g.idx()) * m + j]);
+
+                    // the system is negated to be positive definite
+                    B(row, j) -= div;
+                }
+            }
+        },
+        256);
+    Eigen::MatrixXd Phi;
+    if (n_poisson && !poisson_solver_.solve(B, Phi))
+    {
+        auto what = "SurfaceHeatGeodesic: Failed to solve Poisson equation.";
+        throw SolverException(what);
+    }
+
+    // shift the distances per component such that the closest seed is at
+    // zero, leave components without seeds at infinity
+    parallel_for(
+        0, m,
+        [&](int j) {
+            auto phi = [&](IndexType v) {
+                const int row = poisson_index_[v];
+                return row == -1 ? 0.0 : Phi(row, j);
+            };
+
+            std::vector<double> offset(n_components_, infinity);
+            for (auto v : seeds[j])
+            {
+                double& o = offset[component_[v.idx()]];
+                o = std::min(o, phi(v.idx()));
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                const int c = component_[i];
+                if (c == -1 || offset[c] == infinity)
+                    continue;
+                if (heat_index_[i] == -1)
+                    D(i, j) = 0.0; // isolated seed
+                else
+                    D(i, j) = std::max(0.0, phi(i) - offset[c]);
+            }
+        },
+        1);
+
+    return D;
+}
+
+void SurfaceHeatGeodesic::distance_to_texture_coordinates()
+{
+    distances_to_texture_coordinates(mesh_, distance_);
+}
+
+} // namespace pmp
@@ -0,0 +1,94 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "pmp/SurfaceMesh.h"
+#include "pmp/algorithms/LinearSolver.h"
+
+namespace pmp {
+
+//! \brief Compute geodesic distances by the heat method.
+//! \details Diffuses heat from the seed vertices for a short time, normalizes
+//! the negative gradient of the heat per face, and recovers the distance by
+//! solving a Poisson equation for the divergence of this field. See
+//! \cite crane_2013_geodesics for details.
+//!
+//! Both the heat and the Poisson operator are set up and factorized once on
+//! construction, such that each query costs two back-substitutions. Several
+//! seed sets can be solved at once as multiple right hand sides. The
+//! distances are approximate, for exact distances along edges and virtual
+//! edges see SurfaceGeodesic.
+//! \ingroup algorithms
+class SurfaceHeatGeodesic
+{
+public:
+    //! \brief Construct from mesh and factorize the operators.
+    //! \param mesh The triangle mesh on which to compute distances. Its
+    //! geometry and connectivity must not change while this object is used.
+    //! \param time_factor The time step of the heat flow relative to the
+    //! squared mean edge length. Default: 1.0.
+    //! \throw InvalidInputException if the input is not a triangle mesh.
+    explicit SurfaceHeatGeodesic(SurfaceMesh& mesh, Scalar time_factor = 1.0);
+
+    // destructor
+    ~SurfaceHeatGeodesic();
+
+    //! \brief Compute geodesic distances from the vertices in \p seed.
+    //! \details Stores the distances in a vertex property accessed by
+    //! operator(). Vertices of components without seeds, as well as
+    //! isolated vertices that are not seeds, get the maximum Scalar.
+    //! \throw InvalidInputException if a seed is invalid or deleted.
+    //! \throw SolverException if a linear system cannot be solved.
+    void compute(const std::vector<Vertex>& seed);
+
+    //! \brief Compute geodesic distances for several seed sets at once.
+    //! \return A matrix whose column j contains the distances from the
+    //! vertices in \p seeds[j], indexed by vertex index. Deleted vertices
+    //! and unreachable vertices get the maximum Scalar.
+    //! \throw InvalidInputException if a seed is invalid or deleted.
+    //! \throw SolverException if a linear system cannot be solved.
+    Eigen::MatrixXd distances(
+        const std::vector<std::vector<Vertex>>& seeds) const;
+
+    //! \brief Access the computed geodesic distance.
+    //! \pre The function compute() has been called before.
+    Scalar operator()(Vertex v) const { return distance_[v]; }
+
+    //! \brief Use the normalized distances as texture coordinates
+    //! \details Stores the normalized distances in a vertex property of type
+    //! TexCoord named "v:tex". Re-uses any existing vertex property of the
+    //! same type and name.
+    void distance_to_texture_coordinates();
+
+private:
+    SurfaceMesh& mesh_;
+
+    // row of each vertex in the heat system, -1 for isolated vertices
+    std::vector<int> heat_index_;
+
+    // row of each vertex in the Poisson system, -1 for isolated vertices
+    // and for the vertex fixed per component
+    std::vector<int> poisson_index_;
+
+    // connected component of each vertex, -1 for deleted vertices
+    std::vector<int> component_;
+    int n_components_;
+
+    // gradient of the hat function of the vertex opposite to each halfedge
+    std::vector<dvec3> gradient_;
+
+    // cotangent of the angle opposite to each halfedge times its vector
+    std::vector<dvec3> divergence_;
+
+    LinearSolver heat_solver_;
+    LinearSolver poisson_solver_;
+
+    VertexProperty<Scalar> distance_;
+};
+
+} // namespace pmp
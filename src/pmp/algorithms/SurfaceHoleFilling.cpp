@@ -3,9 +3,17 @@
 
 #include "pmp/algorithms/SurfaceHoleFilling.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
+#include "pmp/algorithms/LinearSolver.h"
 #include "pmp/algorithms/SurfaceFairing.h"
 
 using SparseMatrix = Eigen::SparseMatrix<double>;
@@ -44,8 +52,10 @@ Scalar SurfaceHoleFilling::compute_angle(const Point& _n1,
     return (1.0 - dot(_n1, _n2));
 }
 
-void SurfaceHoleFilling::fill_hole(Halfedge h)
+void SurfaceHoleFilling::fill_hole(Halfedge h, unsigned int optimal_size)
 {
+    PMP_PROFILE_SCOPE("SurfaceHoleFilling::fill_hole");
+
     if (!h.is_valid())
     {
         throw InvalidInputException("SurfaceHoleFilling: Invalid halfedge.");
@@ -69,10 +79,12 @@ void SurfaceHoleFilling::fill_hole(Halfedge h)
     for (auto e : mesh_.edges())
         elocked_[e] = true;
 
+    bool completed = true;
     try
     {
-        triangulate_hole(h); // do minimal triangulation
-        refine();            // refine filled-in edges
+        triangulate_hole(h, optimal_size); // do minimal triangulation
+        completed = !(progress_ && !progress_(0.3f)) &&
+                    refine(); // refine filled-in edges
     }
     catch (InvalidInputException& e)
     {
@@ -88,10 +100,167 @@ void SurfaceHoleFilling::fill_hole(Halfedge h)
     hole_.clear();
     mesh_.remove_vertex_property(vlocked_);
     mesh_.remove_edge_property(elocked_);
+
+    if (!completed)
+        throw CancelledException("SurfaceHoleFilling: Cancelled.");
+}
+
+size_t SurfaceHoleFilling::fill_all_holes(unsigned int max_size,
+                                          unsigned int optimal_size)
+{
+    // find the boundary loops of manifold vertices
+    std::vector<Halfedge> holes;
+    std::vector<bool> visited(mesh_.halfedges_size(), false);
+    for (auto h : mesh_.halfedges())
+    {
+        if (visited[h.idx()] || !mesh_.is_boundary(h))
+            continue;
+
+        bool manifold = true;
+        size_t size = 0;
+        Halfedge hh = h;
+        do
+        {
+            visited[hh.idx()] = true;
+            manifold = manifold && mesh_.is_manifold(mesh_.to_vertex(hh));
+            ++size;
+        } while ((hh = mesh_.next_halfedge(hh)) != h);
+
+        if (manifold && size <= max_size)
+            holes.push_back(h);
+    }
+
+    // the patch filling a hole, indexing the vertices of the copy
+    struct Patch
+    {
+        bool filled = false;
+        std::vector<Vertex> vertices; // mesh vertex of each copied vertex
+        std::vector<Point> points;    // positions of the new vertices
+        std::vector<std::vector<IndexType>> faces;
+    };
+    std::vector<Patch> patches(holes.size());
+
+    // fill each hole in a copy of the faces around it. the calling thread
+    // reports the progress, the others skip the remaining holes if cancelled
+    const int n = holes.size();
+    std::atomic<int> n_done(0);
+    std::atomic<bool> cancelled(false);
+    const auto caller = std::this_thread::get_id();
+    parallel_for(
+        0, n,
+        [&](int i) {
+            if (cancelled)
+                return;
+
+            // the hole vertices and their neighbors
+            std::vector<Vertex> ring;
+            std::unordered_map<IndexType, Vertex> local;
+            Halfedge h = holes[i];
+            do
+            {
+                const Vertex v = mesh_.to_vertex(h);
+                for (auto vv : mesh_.vertices(v))
+                    ring.push_back(vv);
+                ring.push_back(v);
+            } while ((h = mesh_.next_halfedge(h)) != holes[i]);
+
+            std::vector<Face> faces;
+            for (auto v : ring)
+                for (auto f : mesh_.faces(v))
+                    faces.push_back(f);
+            std::sort(faces.begin(), faces.end());
+            faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+
+            Patch& patch = patches[i];
+            try
+            {
+                SurfaceMesh copy;
+                std::vector<Vertex> vertices;
+                for (auto f : faces)
+                {
+                    vertices.clear();
+                    for (auto v : mesh_.vertices(f))
+                    {
+                        auto it = local.find(v.idx());
+                        if (it == local.end())
+                        {
+                            it = local.emplace(v.idx(),
+                                               copy.add_vertex(points_[v]))
+                                     .first;
+                            patch.vertices.push_back(v);
+                        }
+                        vertices.push_back(it->second);
+                    }
+                    copy.add_face(vertices);
+                }
+
+                const Vertex v0 = local[mesh_.from_vertex(holes[i]).idx()];
+                const Vertex v1 = local[mesh_.to_vertex(holes[i]).idx()];
+                const Halfedge hole = copy.find_halfedge(v0, v1);
+                if (!hole.is_valid() || !copy.is_boundary(hole))
+                    return;
+
+                // the copied faces and vertices come first and are kept
+                const size_t nv = copy.n_vertices();
+                const size_t nf = copy.n_faces();
+                SurfaceHoleFilling(copy).fill_hole(hole, optimal_size);
+
+                for (size_t j = nv; j < copy.vertices_size(); ++j)
+                    patch.points.push_back(copy.position(Vertex(IndexType(j))));
+                for (size_t j = nf; j < copy.faces_size(); ++j)
+                {
+                    std::vector<IndexType> face;
+                    for (auto v : copy.vertices(Face(IndexType(j))))
+                        face.push_back(v.idx());
+                    patch.faces.push_back(face);
+                }
+                patch.filled = true;
+            }
+            catch (const std::exception&)
+            {
+                // leave the hole open
+            }
+
+            const int done = ++n_done;
+            if (std::this_thread::get_id() != caller)
+                return;
+            if (progress_ && !progress_(float(done) / float(n)))
+                cancelled = true;
+        },
+        1);
+
+    // merge the patches
+    size_t n_filled = 0;
+    std::vector<Vertex> vertices;
+    for (const auto& patch : patches)
+    {
+        if (!patch.filled)
+            continue;
+
+        std::vector<Vertex> map = patch.vertices;
+        for (const auto& p : patch.points)
+            map.push_back(mesh_.add_vertex(p));
+        for (const auto& face : patch.faces)
+        {
+            vertices.clear();
+            for (auto idx : face)
+                vertices.push_back(map[idx]);
+            mesh_.add_face(vertices);
+        }
+        ++n_filled;
+    }
+
+    if (cancelled)
+        throw CancelledException("SurfaceHoleFilling: Cancelled.");
+
+    return n_filled;
 }
 
-void SurfaceHoleFilling::triangulate_hole(Halfedge _h)
+void SurfaceHoleFilling::triangulate_hole(Halfedge _h,
+                                          unsigned int optimal_size)
 {
+    PMP_PROFILE_SCOPE("triangulate");
+
     // trace hole
     hole_.clear();
     Halfedge h = _h;
@@ -108,6 +277,97 @@ void SurfaceHoleFilling::triangulate_hole(Halfedge _h)
     } while ((h = mesh_.next_halfedge(h)) != _h);
     const int n = hole_.size();
 
+    // split large holes into polygons to be triangulated optimally
+    std::vector<std::vector<int>> polygons(1, std::vector<int>(n));
+    for (int i = 0; i < n; ++i)
+        polygons[0][i] = i;
+    std::vector<int> first, second;
+    while (!polygons.empty())
+    {
+        polygon_.swap(polygons.back());
+        polygons.pop_back();
+
+        if (polygon_.size() > std::max(optimal_size, 3u))
+        {
+            split_polygon(first, second);
+            if (!first.empty())
+            {
+                polygons.push_back(second);
+                polygons.push_back(first);
+                continue;
+            }
+        }
+
+        triangulate_polygon();
+    }
+    polygon_.clear();
+}
+
+void SurfaceHoleFilling::split_polygon(std::vector<int>& first,
+                                       std::vector<int>& second) const
+{
+    first.clear();
+    second.clear();
+
+    // arc length along the polygon
+    const int n = polygon_.size();
+    std::vector<Scalar> arc(n + 1, 0);
+    for (int i = 0; i < n; ++i)
+        arc[i + 1] = arc[i] + distance(points_[polygon_vertex(i)],
+                                       points_[polygon_vertex((i + 1) % n)]);
+
+    // find the chord that is shortest relative to the shorter arc between
+    // its vertices, keeping at least a quarter of the vertices on each side
+    const int min_size = n / 4;
+    Scalar min_ratio = std::numeric_limits<Scalar>::max();
+    int imin = -1, jmin = -1;
+    for (int i = 0; i < n; ++i)
+    {
+        const Point& p = points_[polygon_vertex(i)];
+        for (int j = i + min_size; j <= i + n - min_size && j < n; ++j)
+        {
+            const Scalar length = std::min(arc[j] - arc[i],
+                                           arc[n] - arc[j] + arc[i]);
+            const Scalar ratio =
+                distance(p, points_[polygon_vertex(j)]) / length;
+            if (ratio < min_ratio &&
+                !mesh_.find_halfedge(polygon_vertex(i), polygon_vertex(j))
+                     .is_valid())
+            {
+                min_ratio = ratio;
+                imin = i;
+                jmin = j;
+            }
+        }
+    }
+    if (imin == -1)
+        return;
+
+    // Start both polygons after an edge of the hole, such that their
+    // triangles are added next to existing edges.
+    auto add = [&](std::vector<int>& polygon, int begin, int end) {
+        for (int i = begin; i != end; i = (i + 1) % n)
+            polygon.push_back(polygon_[i]);
+        polygon.push_back(polygon_[end]);
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            const size_t j = (i + 1) % polygon.size();
+            if ((polygon[i] + 1) % hole_.size() == size_t(polygon[j]))
+            {
+                std::rotate(polygon.begin(), polygon.begin() + j,
+                            polygon.end());
+                break;
+            }
+        }
+    };
+    add(first, imin, jmin);
+    add(second, jmin, imin);
+}
+
+void SurfaceHoleFilling::triangulate_polygon()
+{
+    const int n = polygon_.size();
+
     // compute minimal triangulation by dynamic programming
     weight_.clear();
     weight_.resize(n, std::vector<Weight>(n, Weight()));
@@ -164,8 +424,8 @@ void SurfaceHoleFilling::triangulate_hole(Halfedge _h)
             continue;
         int split = index_[start][end];
 
-        mesh_.add_triangle(hole_vertex(start), hole_vertex(split),
-                           hole_vertex(end));
+        mesh_.add_triangle(polygon_vertex(start), polygon_vertex(split),
+                           polygon_vertex(end));
 
         todo.push_back(ivec2(start, split));
         todo.push_back(ivec2(split, end));
@@ -179,9 +439,9 @@ void SurfaceHoleFilling::triangulate_hole(Halfedge _h)
 SurfaceHoleFilling::Weight SurfaceHoleFilling::compute_weight(int _i, int _j,
                                                               int _k) const
 {
-    const Vertex a = hole_vertex(_i);
-    const Vertex b = hole_vertex(_j);
-    const Vertex c = hole_vertex(_k);
+    const Vertex a = polygon_vertex(_i);
+    const Vertex b = polygon_vertex(_j);
+    const Vertex c = polygon_vertex(_k);
     Vertex d;
 
     // if one of the potential edges already exists, this would result
@@ -199,26 +459,40 @@ SurfaceHoleFilling::Weight SurfaceHoleFilling::compute_weight(int _i, int _j,
     Scalar angle(0);
     const Point n = compute_normal(a, b, c);
 
-    // ...neighbor to (i,j)
-    d = (_i + 1 == _j) ? opposite_vertex(_j) : hole_vertex(index_[_i][_j]);
-    angle = std::max(angle, compute_angle(n, compute_normal(a, d, b)));
+    // ...neighbor to (i,j), unknown across chords between polygons
+    if (_i + 1 != _j)
+        d = polygon_vertex(index_[_i][_j]);
+    else if (is_hole_edge(_i, _j))
+        d = opposite_vertex(polygon_[_j]);
+    else
+        d = Vertex();
+    if (d.is_valid())
+        angle = std::max(angle, compute_angle(n, compute_normal(a, d, b)));
 
     // ...neighbor to (j,k)
-    d = (_j + 1 == _k) ? opposite_vertex(_k) : hole_vertex(index_[_j][_k]);
-    angle = std::max(angle, compute_angle(n, compute_normal(b, d, c)));
+    if (_j + 1 != _k)
+        d = polygon_vertex(index_[_j][_k]);
+    else if (is_hole_edge(_j, _k))
+        d = opposite_vertex(polygon_[_k]);
+    else
+        d = Vertex();
+    if (d.is_valid())
+        angle = std::max(angle, compute_angle(n, compute_normal(b, d, c)));
 
     // ...neighbor to (k,i) if (k,i)==(n-1, 0)
-    if (_i == 0 && _k + 1 == (int)hole_.size())
+    if (_i == 0 && _k + 1 == (int)polygon_.size() && is_hole_edge(_k, 0))
     {
-        d = opposite_vertex(0);
+        d = opposite_vertex(polygon_[0]);
         angle = std::max(angle, compute_angle(n, compute_normal(c, d, a)));
     }
 
     return Weight(angle, area);
 }
 
-void SurfaceHoleFilling::refine()
+bool SurfaceHoleFilling::refine()
 {
+    PMP_PROFILE_SCOPE("refine");
+
     const int n = hole_.size();
     Scalar l, lmin, lmax;
 
@@ -240,8 +514,13 @@ void SurfaceHoleFilling::refine()
         collapse_short_edges(lmin);
         flip_edges();
         relaxation();
+
+        if (progress_ && !progress_(0.3f + 0.06f * float(iter + 1)))
+            return false;
     }
     fairing();
+
+    return true;
 }
 
 void SurfaceHoleFilling::split_long_edges(const Scalar _lmax)
@@ -411,42 +690,53 @@ void SurfaceHoleFilling::relaxation()
     {
         constraints.push_back(mesh_.to_vertex(h));
     }
-    const int m = constraints.size();
 
-    // setup matrix & rhs
-    Eigen::MatrixXd B(m, 3);
+    // setup the normal equations of the least squares system directly,
+    // without the rectangular matrix: the Laplacian of each constrained
+    // vertex adds the outer product of its coefficients of free vertices,
+    // the locked vertices move to the right hand side
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(n, 3);
     std::vector<Triplet> triplets;
-    for (int i = 0; i < m; ++i)
+    std::vector<std::pair<int, double>> row;
+    for (auto v : constraints)
     {
-        Vertex v = constraints[i];
         Point b(0, 0, 0);
         Scalar c(0);
+        row.clear();
 
         for (auto vv : mesh_.vertices(v))
         {
             if (vlocked_[vv])
                 b += points_[vv];
             else
-                triplets.emplace_back(i, idx[vv], -1.0);
+                row.emplace_back(idx[vv], -1.0);
             ++c;
         }
 
         if (vlocked_[v])
             b -= c * points_[v];
         else
-            triplets.emplace_back(i, idx[v], c);
+            row.emplace_back(idx[v], c);
 
-        B.row(i) = (Eigen::Vector3d)b;
+        const Eigen::Vector3d bd = (Eigen::Vector3d)b;
+        for (const auto& i : row)
+        {
+            B.row(i.first) += i.second * bd.transpose();
+            for (const auto& j : row)
+                triplets.emplace_back(i.first, j.first, i.second * j.second);
+        }
     }
 
-    // solve least squares system
-    SparseMatrix A(m, n);
-    A.setFromTriplets(triplets.begin(), triplets.end());
-    SparseMatrix AtA = A.transpose() * A;
-    Eigen::MatrixXd AtB = A.transpose() * B;
-    Eigen::SimplicialLDLT<SparseMatrix> solver(AtA);
-    Eigen::MatrixXd X = solver.solve(AtB);
-    if (solver.info() != Eigen::Success)
+    // solve the square system over the free vertices, starting from the
+    // current positions
+    SparseMatrix M(n, n);
+    M.setFromTriplets(triplets.begin(), triplets.end());
+    Eigen::MatrixXd X(n, 3);
+    for (int i = 0; i < n; ++i)
+        X.row(i) = (Eigen::Vector3d) static_cast<dvec3>(points_[vertices[i]]);
+    LinearSolver solver;
+    solver.compute(M);
+    if (!solver.solve(B, X))
     {
         // clean up
         mesh_.remove_vertex_property(idx);
@@ -466,6 +756,8 @@ void SurfaceHoleFilling::relaxation()
 
 void SurfaceHoleFilling::fairing()
 {
+    PMP_PROFILE_SCOPE("fairing");
+
     // did the refinement insert new vertices?
     // if yes, then trigger fairing; otherwise don't.
     bool new_vertices = false;
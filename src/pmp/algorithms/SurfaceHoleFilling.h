@@ -24,11 +24,42 @@ public:
     SurfaceHoleFilling(SurfaceMesh& mesh);
 
     //! \brief Fill the hole specified by halfedge \a h
+    //! \param h A boundary halfedge of the hole.
+    //! \param optimal_size Holes with at most this many boundary vertices
+    //! are triangulated optimally in O(n^3) time. Larger holes are split
+    //! recursively along short chords into parts of this size, which takes
+    //! about O(n^2) time for the chords and linear time for the parts.
     //! \pre The specified halfedge is valid.
     //! \pre The specified halfedge is a boundary halfedge.
     //! \pre The specified halfedge is not adjacent to a non-manifold hole.
     //! \throw InvalidInputException in case on of the input preconditions is violated
-    void fill_hole(Halfedge h);
+    //! \throw CancelledException if cancelled, see set_progress()
+    void fill_hole(Halfedge h, unsigned int optimal_size = 300);
+
+    //! \brief Fill all holes with at most \p max_size boundary vertices.
+    //! \details Detects the boundary loops of manifold vertices and fills
+    //! them as fill_hole() does. The holes are filled in parallel, each in a
+    //! copy of the two rings of faces around it, and the filled-in patches
+    //! are merged back into the mesh. Holes that cannot be filled, e.g.,
+    //! since the linear systems cannot be solved, are left open.
+    //! \note With the default \p max_size, the outer boundaries of open
+    //! surfaces are filled as well.
+    //! \return The number of filled holes.
+    //! \throw CancelledException if cancelled, see set_progress()
+    size_t fill_all_holes(
+        unsigned int max_size = std::numeric_limits<unsigned int>::max(),
+        unsigned int optimal_size = 300);
+
+    //! \brief Report the progress of subsequent hole filling.
+    //! \details fill_hole() polls after the triangulation and after each
+    //! refinement iteration, a cancelled hole is triangulated but may lack
+    //! the refinement or fairing. fill_all_holes() polls whenever the calling
+    //! thread has filled a hole, and keeps the holes filled so far. See
+    //! ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
 
 private:
     struct Weight
@@ -54,15 +85,22 @@ private:
         Scalar area;
     };
 
-    // compute optimal triangulation of hole
+    // compute triangulation of hole, optimal for small holes
     //! \throw InvalidInputException in case of a non-manifold hole.
-    void triangulate_hole(Halfedge h);
+    void triangulate_hole(Halfedge h, unsigned int optimal_size);
+
+    // split polygon_ along a short chord into two polygons
+    void split_polygon(std::vector<int>& first,
+                       std::vector<int>& second) const;
 
-    // compute the weight of the triangle (i,j,k).
+    // compute optimal triangulation of polygon_
+    void triangulate_polygon();
+
+    // compute the weight of the triangle (i,j,k) of polygon_.
     Weight compute_weight(int i, int j, int k) const;
 
-    // refine triangulation (isotropic remeshing)
-    void refine();
+    // refine triangulation (isotropic remeshing), returns false if cancelled
+    bool refine();
     void split_long_edges(const Scalar lmax);
     void collapse_short_edges(const Scalar lmin);
     void flip_edges();
@@ -84,6 +122,19 @@ private:
             mesh_.next_halfedge(mesh_.opposite_halfedge(hole_[i])));
     }
 
+    // return i'th vertex of the polygon being triangulated
+    Vertex polygon_vertex(unsigned int i) const
+    {
+        assert(i < polygon_.size());
+        return hole_vertex(polygon_[i]);
+    }
+
+    // is polygon edge (i,j) an edge of the hole, not a chord?
+    bool is_hole_edge(unsigned int i, unsigned int j) const
+    {
+        return (polygon_[i] + 1) % hole_.size() == size_t(polygon_[j]);
+    }
+
     // does interior edge (_a,_b) exist already?
     bool is_interior_edge(Vertex _a, Vertex _b) const;
 
@@ -104,9 +155,14 @@ private:
 
     std::vector<Halfedge> hole_;
 
+    // indices of the hole vertices of the polygon being triangulated
+    std::vector<int> polygon_;
+
     // data for computing optimal triangulation
     std::vector<std::vector<Weight>> weight_;
     std::vector<std::vector<int>> index_;
+
+    ProgressCallback progress_;
 };
 
 } // namespace pmp
@@ -2,16 +2,21 @@
 // Distributed under a MIT-style license, see LICENSE.txt for details.
 
 #include "pmp/algorithms/SurfaceNormals.h"
+#include "pmp/Parallel.h"
+
+#include <algorithm>
 
 namespace pmp {
 
-Normal SurfaceNormals::compute_face_normal(const SurfaceMesh& mesh, Face f)
+namespace {
+
+// compute_face_normal() for known vertex positions
+Normal face_normal(const SurfaceMesh& mesh,
+                   const VertexProperty<Point>& vpoint, Face f)
 {
     Halfedge h = mesh.halfedge(f);
     Halfedge hend = h;
 
-    auto vpoint = mesh.get_vertex_property<Point>("v:point");
-
     Point p0 = vpoint[mesh.to_vertex(h)];
     h = mesh.next_halfedge(h);
     Point p1 = vpoint[mesh.to_vertex(h)];
@@ -41,6 +46,13 @@ Normal SurfaceNormals::compute_face_normal(const SurfaceMesh& mesh, Face f)
     }
 }
 
+} // namespace
+
+Normal SurfaceNormals::compute_face_normal(const SurfaceMesh& mesh, Face f)
+{
+    return face_normal(mesh, mesh.get_vertex_property<Point>("v:point"), f);
+}
+
 Normal SurfaceNormals::compute_vertex_normal(const SurfaceMesh& mesh, Vertex v)
 {
     Point nn(0, 0, 0);
@@ -53,7 +65,6 @@ Normal SurfaceNormals::compute_vertex_normal(const SurfaceMesh& mesh, Vertex v)
         Normal n;
         Point p1, p2;
         Scalar cosine, angle, denom;
-        bool is_triangle;
 
         for (auto h : mesh.halfedges(v))
         {
@@ -75,12 +86,9 @@ Normal SurfaceNormals::compute_vertex_normal(const SurfaceMesh& mesh, Vertex v)
                         cosine = 1.0;
                     angle = acos(cosine);
 
-                    // compute triangle or polygon normal
-                    is_triangle = (mesh.next_halfedge(mesh.next_halfedge(
-                                       mesh.next_halfedge(h))) == h);
-                    n = is_triangle ? normalize(cross(p1, p2))
-                                    : compute_face_normal(mesh, mesh.face(h));
-
+                    // weight the face normal, computed as in
+                    // compute_vertex_normals() to get the same result
+                    n = face_normal(mesh, vpoint, mesh.face(h));
                     n *= angle;
                     nn += n;
                 }
@@ -171,16 +179,128 @@ Normal SurfaceNormals::compute_corner_normal(const SurfaceMesh& mesh,
 
 void SurfaceNormals::compute_vertex_normals(SurfaceMesh& mesh)
 {
+    compute_vertex_normals(mesh, SurfaceAdjacency(mesh));
+}
+
+void SurfaceNormals::compute_vertex_normals(SurfaceMesh& mesh,
+                                            const SurfaceAdjacency& adjacency)
+{
+    assert(adjacency.vertices_size() == mesh.vertices_size());
+
+    auto vpoint = mesh.get_vertex_property<Point>("v:point");
     auto vnormal = mesh.vertex_property<Normal>("v:normal");
-    for (auto v : mesh.vertices())
-        vnormal[v] = compute_vertex_normal(mesh, v);
+
+    // face normals are computed once instead of for each of their corners
+    const int nF = int(adjacency.faces_size());
+    std::vector<Normal> fnormal(nF);
+    parallel_for(0, nF, [&](int i) {
+        const auto vertices = adjacency.face_vertices(Face(i));
+        if (vertices.size() == 3)
+        {
+            // same computation as face_normal()
+            Point p0 = vpoint[vertices[0]];
+            const Point& p1 = vpoint[vertices[1]];
+            Point p2 = vpoint[vertices[2]];
+            fnormal[i] = normalize(cross(p2 -= p1, p0 -= p1));
+        }
+        else if (vertices.size() > 3)
+            fnormal[i] = face_normal(mesh, vpoint, Face(i));
+    });
+
+    // same computation as compute_vertex_normal(), the corners are spanned
+    // by two subsequent neighbors of the one-ring
+    parallel_for(mesh.vertices(), [&](Vertex v) {
+        Point nn(0, 0, 0);
+        const auto ring = adjacency.vertex_vertices(v);
+        const auto faces = adjacency.vertex_faces(v);
+        const size_t k = ring.size();
+
+        if (k)
+        {
+            const Point p0 = vpoint[v];
+
+            for (size_t i = 0; i < k; ++i)
+            {
+                if (!faces[i].is_valid())
+                    continue;
+
+                const Point p1 = vpoint[ring[i]] - p0;
+                const Point p2 = vpoint[ring[i + 1 < k ? i + 1 : 0]] - p0;
+
+                // check whether we can robustly compute angle
+                const Scalar denom = sqrt(dot(p1, p1) * dot(p2, p2));
+                if (denom > std::numeric_limits<Scalar>::min())
+                {
+                    Scalar cosine = dot(p1, p2) / denom;
+                    if (cosine < -1.0)
+                        cosine = -1.0;
+                    else if (cosine > 1.0)
+                        cosine = 1.0;
+                    nn += acos(cosine) * fnormal[faces[i].idx()];
+                }
+            }
+
+            nn = normalize(nn);
+        }
+
+        vnormal[v] = nn;
+    });
 }
 
 void SurfaceNormals::compute_face_normals(SurfaceMesh& mesh)
 {
+    auto vpoint = mesh.get_vertex_property<Point>("v:point");
     auto fnormal = mesh.face_property<Normal>("f:normal");
-    for (auto f : mesh.faces())
-        fnormal[f] = compute_face_normal(mesh, f);
+    parallel_for(mesh.faces(),
+                 [&](Face f) { fnormal[f] = face_normal(mesh, vpoint, f); });
+}
+
+void SurfaceNormals::update_normals(SurfaceMesh& mesh,
+                                    const std::vector<Vertex>& vertices)
+{
+    const bool has_vnormal = mesh.has_vertex_property("v:normal");
+    if (!has_vnormal)
+        compute_vertex_normals(mesh);
+
+    auto vpoint = mesh.get_vertex_property<Point>("v:point");
+    auto vnormal = mesh.vertex_property<Normal>("v:normal");
+    auto fnormal = mesh.get_face_property<Normal>("f:normal");
+
+    // faces incident to the modified vertices, and the vertices of these
+    std::vector<Face> faces;
+    std::vector<Vertex> ring;
+    for (auto v : vertices)
+    {
+        if (mesh.is_deleted(v))
+            continue;
+        ring.push_back(v);
+        for (auto f : mesh.faces(v))
+            faces.push_back(f);
+    }
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+    for (auto f : faces)
+        for (auto v : mesh.vertices(f))
+            ring.push_back(v);
+    std::sort(ring.begin(), ring.end());
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+
+    if (fnormal)
+        for (auto f : faces)
+            fnormal[f] = face_normal(mesh, vpoint, f);
+    if (has_vnormal)
+        for (auto v : ring)
+            vnormal[v] = compute_vertex_normal(mesh, v);
+}
+
+void SurfaceNormals::update_normals(SurfaceMesh& mesh, uint64_t g)
+{
+    auto vpoint = mesh.get_vertex_property<Point>("v:point");
+    std::vector<Vertex> vertices = mesh.topology_changed_vertices(g);
+    for (auto i : vpoint.changed_since(g))
+        if (!mesh.is_deleted(Vertex(IndexType(i))))
+            vertices.emplace_back(IndexType(i));
+    update_normals(mesh, vertices);
 }
 
 } // namespace pmp
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "pmp/SurfaceMesh.h"
+#include "pmp/SurfaceAdjacency.h"
 
 namespace pmp {
 
@@ -27,15 +28,42 @@ public:
     SurfaceNormals(const SurfaceNormals&) = delete;
 
     //! \brief Compute vertex normals for the whole \p mesh.
-    //! \details Calls compute_vertex_normal() for each vertex and adds a new
-    //! vertex property of type Normal named "v:normal".
+    //! \details Computes the normals of compute_vertex_normal() for all
+    //! vertices in parallel and adds a new vertex property of type Normal
+    //! named "v:normal".
     static void compute_vertex_normals(SurfaceMesh& mesh);
 
+    //! \brief Compute vertex normals for the whole \p mesh using a
+    //! precomputed \p adjacency snapshot of it.
+    //! \details Same result as compute_vertex_normals(SurfaceMesh&), but
+    //! one-rings are read from contiguous arrays instead of circulating
+    //! halfedges. The face normals are computed once in a first pass, then
+    //! the angle-weighted normals of the incident faces are gathered per
+    //! vertex. Both passes run in parallel.
+    static void compute_vertex_normals(SurfaceMesh& mesh,
+                                       const SurfaceAdjacency& adjacency);
+
     //! \brief Compute face normals for the whole \p mesh.
-    //! \details Calls compute_face_normal() for each face and adds a new face
-    //! property of type Normal named "f:normal".
+    //! \details Calls compute_face_normal() for each face in parallel and
+    //! adds a new face property of type Normal named "f:normal".
     static void compute_face_normals(SurfaceMesh& mesh);
 
+    //! \brief Update the normals around \p vertices after local edits.
+    //! \details Call this after moving \p vertices or changing their
+    //! one-rings, e.g., by flip(), collapse(), or split(). Recomputes the
+    //! normals of the faces incident to \p vertices in "f:normal", if that
+    //! property exists, and of all vertices of these faces in "v:normal".
+    //! Computes all vertex normals if "v:normal" does not exist yet.
+    static void update_normals(SurfaceMesh& mesh,
+                               const std::vector<Vertex>& vertices);
+
+    //! \brief Update the normals after the changes since generation \p g.
+    //! \details Uses change tracking to find the vertices that were moved
+    //! or whose one-ring changed after generation \p g and calls
+    //! update_normals() for them.
+    //! \sa SurfaceMesh::set_change_tracking(), SurfaceMesh::new_generation()
+    static void update_normals(SurfaceMesh& mesh, uint64_t g);
+
     //! \brief Compute the normal vector of vertex \p v.
     static Normal compute_vertex_normal(const SurfaceMesh& mesh, Vertex v);
 
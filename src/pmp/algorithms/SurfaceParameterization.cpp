@@ -3,17 +3,30 @@
 
 #include "pmp/algorithms/SurfaceParameterization.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <unordered_map>
 
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 
 #include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/LinearSolver.h"
+#include "pmp/algorithms/SurfacePartition.h"
+#include "pmp/EigenMaps.h"
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
 
 namespace pmp {
 
 SurfaceParameterization::SurfaceParameterization(SurfaceMesh& mesh)
     : mesh_(mesh)
+{
+}
+
+void SurfaceParameterization::check_boundary() const
 {
     bool has_boundary = false;
     for (auto v : mesh_.vertices())
@@ -89,99 +102,45 @@ void SurfaceParameterization::setup_boundary_constraints()
 
 void SurfaceParameterization::harmonic(bool use_uniform_weights)
 {
+    PMP_PROFILE_SCOPE("SurfaceParameterization::harmonic");
+
+    check_boundary();
+
     // map boundary to circle
     setup_boundary_constraints();
 
     // get properties
     auto tex = mesh_.vertex_property<TexCoord>("v:tex");
-    auto eweight = mesh_.add_edge_property<Scalar>("e:param");
-    auto idx = mesh_.add_vertex_property<int>("v:idx", -1);
-
-    // compute Laplace weight per edge: cotan or uniform
-    for (auto e : mesh_.edges())
-    {
-        eweight[e] =
-            use_uniform_weights ? 1.0 : std::max(0.0, cotan_weight(mesh_, e));
-    }
 
     // collect free (non-boundary) vertices in array free_vertices[]
-    // assign indices such that idx[ free_vertices[i] ] == i
-    unsigned i = 0;
     std::vector<Vertex> free_vertices;
     free_vertices.reserve(mesh_.n_vertices());
     for (auto v : mesh_.vertices())
     {
         if (!mesh_.is_boundary(v))
-        {
-            idx[v] = i++;
             free_vertices.push_back(v);
-        }
-    }
-
-    // setup matrix A and rhs B
-    const unsigned int n = free_vertices.size();
-    Eigen::SparseMatrix<double> A(n, n);
-    Eigen::MatrixXd B(n, 2);
-    std::vector<Eigen::Triplet<double>> triplets;
-    dvec2 b;
-    double w, ww;
-    Vertex v, vv;
-    Edge e;
-    for (i = 0; i < n; ++i)
-    {
-        v = free_vertices[i];
-
-        // rhs row
-        b = dvec2(0.0);
-
-        // lhs row
-        ww = 0.0;
-        for (auto h : mesh_.halfedges(v))
-        {
-            vv = mesh_.to_vertex(h);
-            e = mesh_.edge(h);
-            w = eweight[e];
-            ww += w;
-
-            if (mesh_.is_boundary(vv))
-            {
-                b -= -w * static_cast<dvec2>(tex[vv]);
-            }
-            else
-            {
-                triplets.emplace_back(i, idx[vv], -w);
-            }
-        }
-        triplets.emplace_back(i, i, ww);
-        B.row(i) = (Eigen::Vector2d)b;
     }
 
-    // build sparse matrix from triplets
-    A.setFromTriplets(triplets.begin(), triplets.end());
-
-    // solve A*X = B
-    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(A);
-    Eigen::MatrixXd X = solver.solve(B);
-    if (solver.info() != Eigen::Success)
+    // Laplacian with cotan or uniform weights: -L X = L_c X_c for the
+    // boundary constraints X_c
+    LaplaceOperator laplace(mesh_, free_vertices, 1, use_uniform_weights);
+    const Eigen::MatrixXd C = gather_rows(tex, laplace.constraint_vertices());
+    const Eigen::MatrixXd B = laplace.constraint_matrix() * C;
+
+    // solve A*X = B, starting from the current texture coordinates
+    Eigen::MatrixXd X = gather_rows(tex, free_vertices);
+    LinearSolver solver;
+    solver.compute(-laplace.matrix());
+    if (!solver.solve(B, X))
     {
-        // clean-up
-        mesh_.remove_vertex_property(idx);
-        mesh_.remove_edge_property(eweight);
         auto what = "SurfaceParameterization: Failed to solve linear system.";
         throw SolverException(what);
     }
     else
     {
         // copy solution
-        for (i = 0; i < n; ++i)
-        {
-            tex[free_vertices[i]] = X.row(i);
-        }
+        scatter_rows(X, free_vertices, tex);
     }
-
-    // clean-up
-    mesh_.remove_vertex_property(idx);
-    mesh_.remove_edge_property(eweight);
 }
 
 void SurfaceParameterization::setup_lscm_boundary()
@@ -231,6 +190,10 @@ void SurfaceParameterization::setup_lscm_boundary()
 
 void SurfaceParameterization::lscm()
 {
+    PMP_PROFILE_SCOPE("SurfaceParameterization::lscm");
+
+    check_boundary();
+
     // boundary constraints
     setup_lscm_boundary();
 
@@ -243,8 +206,7 @@ void SurfaceParameterization::lscm()
     assert(locked);
 
     // compute weights/gradients per face/halfedge
-    for (auto f : mesh_.faces())
-    {
+    parallel_for(mesh_.faces(), [&](Face f) {
         // collect face halfedge
         auto fh_it = mesh_.halfedges(f);
         auto ha = *fh_it;
@@ -289,107 +251,114 @@ void SurfaceParameterization::lscm()
         weight[ha] = dvec2(w_ar * area, w_ai * area);
         weight[hb] = dvec2(w_br * area, w_bi * area);
         weight[hc] = dvec2(w_cr * area, w_ci * area);
-    }
+    });
 
     // collect free (non-boundary) vertices in array free_vertices[]
     // assign indices such that idx[ free_vertices[i] ] == i
-    unsigned i = 0;
     std::vector<Vertex> free_vertices;
     free_vertices.reserve(mesh_.n_vertices());
     for (auto v : mesh_.vertices())
     {
         if (!locked[v])
         {
-            idx[v] = i++;
+            idx[v] = free_vertices.size();
             free_vertices.push_back(v);
         }
     }
 
-    // build matrix and rhs
-    const unsigned int nv2 = 2 * mesh_.n_vertices();
-    const unsigned int nv = mesh_.n_vertices();
-    const unsigned int n = free_vertices.size();
-    Vertex vi, vj;
-    Halfedge hh;
-    double si, sj0, sj1, sign;
-    int row(0), c0, c1;
-
+    // the rows of the u coordinates of the free vertices come first, then
+    // the ones of the v coordinates, with two entries per free neighbor and
+    // the diagonal entry
+    const int n = free_vertices.size();
+    std::vector<size_t> offsets(n + 1, 0);
+    parallel_for(0, n, [&](int k) {
+        size_t n_entries = 1;
+        for (auto vj : mesh_.vertices(free_vertices[k]))
+            if (!locked[vj])
+                n_entries += 2;
+        offsets[k + 1] = n_entries;
+    });
+    for (int k = 0; k < n; ++k)
+        offsets[k + 1] += offsets[k];
+
+    // build matrix and rhs, each row independently
     Eigen::SparseMatrix<double> A(2 * n, 2 * n);
     Eigen::VectorXd b = Eigen::VectorXd::Zero(2 * n);
-    std::vector<Eigen::Triplet<double>> triplets;
-
-    for (unsigned int i = 0; i < nv2; ++i)
-    {
-        vi = Vertex(i % nv);
+    std::vector<Eigen::Triplet<double>> triplets(2 * offsets[n]);
 
-        if (i < nv)
-        {
-            sign = 1.0;
-            c0 = 0;
-            c1 = 1;
-        }
-        else
-        {
-            sign = -1.0;
-            c0 = 1;
-            c1 = 0;
-        }
+    parallel_for(
+        0, n,
+        [&](int k) {
+            const Vertex vi = free_vertices[k];
 
-        if (!locked[vi])
-        {
-            si = 0;
-
-            for (auto h : mesh_.halfedges(vi))
+            for (int c = 0; c < 2; ++c)
             {
-                vj = mesh_.to_vertex(h);
-                sj0 = sj1 = 0;
-
-                if (!mesh_.is_boundary(h))
-                {
-                    const dvec2& wj = weight[h];
-                    const dvec2& wi = weight[mesh_.prev_halfedge(h)];
-
-                    sj0 += sign * wi[c0] * wj[0] + wi[c1] * wj[1];
-                    sj1 += -sign * wi[c0] * wj[1] + wi[c1] * wj[0];
-                    si += wi[0] * wi[0] + wi[1] * wi[1];
-                }
-
-                h = mesh_.opposite_halfedge(h);
-                if (!mesh_.is_boundary(h))
+                const double sign = c == 0 ? 1.0 : -1.0;
+                const int c0 = c;
+                const int c1 = 1 - c;
+                const int row = k + c * n;
+                size_t entry = c * offsets[n] + offsets[k];
+                double si = 0;
+
+                for (auto h : mesh_.halfedges(vi))
                 {
-                    const dvec2& wi = weight[h];
-                    const dvec2& wj = weight[mesh_.prev_halfedge(h)];
-
-                    sj0 += sign * wi[c0] * wj[0] + wi[c1] * wj[1];
-                    sj1 += -sign * wi[c0] * wj[1] + wi[c1] * wj[0];
-                    si += wi[0] * wi[0] + wi[1] * wi[1];
+                    const Vertex vj = mesh_.to_vertex(h);
+                    double sj0 = 0, sj1 = 0;
+
+                    if (!mesh_.is_boundary(h))
+                    {
+                        const dvec2& wj = weight[h];
+                        const dvec2& wi = weight[mesh_.prev_halfedge(h)];
+
+                        sj0 += sign * wi[c0] * wj[0] + wi[c1] * wj[1];
+                        sj1 += -sign * wi[c0] * wj[1] + wi[c1] * wj[0];
+                        si += wi[0] * wi[0] + wi[1] * wi[1];
+                    }
+
+                    h = mesh_.opposite_halfedge(h);
+                    if (!mesh_.is_boundary(h))
+                    {
+                        const dvec2& wi = weight[h];
+                        const dvec2& wj = weight[mesh_.prev_halfedge(h)];
+
+                        sj0 += sign * wi[c0] * wj[0] + wi[c1] * wj[1];
+                        sj1 += -sign * wi[c0] * wj[1] + wi[c1] * wj[0];
+                        si += wi[0] * wi[0] + wi[1] * wi[1];
+                    }
+
+                    if (!locked[vj])
+                    {
+                        triplets[entry++] =
+                            Eigen::Triplet<double>(row, idx[vj], sj0);
+                        triplets[entry++] =
+                            Eigen::Triplet<double>(row, idx[vj] + n, sj1);
+                    }
+                    else
+                    {
+                        b[row] -= sj0 * tex[vj][0];
+                        b[row] -= sj1 * tex[vj][1];
+                    }
                 }
 
-                if (!locked[vj])
-                {
-                    triplets.emplace_back(row, idx[vj], sj0);
-                    triplets.emplace_back(row, idx[vj] + n, sj1);
-                }
-                else
-                {
-                    b[row] -= sj0 * tex[vj][0];
-                    b[row] -= sj1 * tex[vj][1];
-                }
+                triplets[entry] =
+                    Eigen::Triplet<double>(row, idx[vi] + c * n, 0.5 * si);
             }
-
-            triplets.emplace_back(row, idx[vi] + (i < nv ? 0 : n), 0.5 * si);
-
-            ++row;
-        }
-    }
+        },
+        256);
 
     // build sparse matrix from triplets
     A.setFromTriplets(triplets.begin(), triplets.end());
 
-    // solve A*X = B
-    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(A);
-    Eigen::VectorXd x = solver.solve(b);
-    if (solver.info() != Eigen::Success)
+    // solve A*X = B, starting from the current texture coordinates
+    Eigen::MatrixXd x(2 * n, 1);
+    for (int i = 0; i < n; ++i)
+    {
+        x(i, 0) = tex[free_vertices[i]][0];
+        x(i + n, 0) = tex[free_vertices[i]][1];
+    }
+    LinearSolver solver;
+    solver.compute(A);
+    if (!solver.solve(b, x))
     {
         // clean-up
         mesh_.remove_vertex_property(idx);
@@ -401,9 +370,9 @@ void SurfaceParameterization::lscm()
     else
     {
         // copy solution
-        for (i = 0; i < n; ++i)
+        for (int i = 0; i < n; ++i)
         {
-            tex[free_vertices[i]] = TexCoord(x[i], x[i + n]);
+            tex[free_vertices[i]] = TexCoord(x(i, 0), x(i + n, 0));
         }
     }
 
@@ -428,4 +397,260 @@ void SurfaceParameterization::lscm()
     mesh_.remove_halfedge_property(weight);
 }
 
+size_t SurfaceParameterization::lscm_charts(size_t n_charts)
+{
+    if (n_charts == 0)
+    {
+        auto what = "SurfaceParameterization: Zero charts requested.";
+        throw InvalidInputException(what);
+    }
+
+    // split the faces into patches, keeping an existing partition
+    auto fpatch = mesh_.get_face_property<int>("f:patch");
+    std::vector<int> patches;
+    if (fpatch)
+    {
+        // element access does not pin the property, see
+        // PropertyArray::vector()
+        const auto& patch = fpatch;
+        patches.resize(mesh_.faces_size());
+        for (size_t i = 0; i < patches.size(); ++i)
+            patches[i] = patch[Face(IndexType(i))];
+    }
+    SurfacePartition(mesh_).partition(n_charts);
+    fpatch = mesh_.get_face_property<int>("f:patch");
+
+    // the connected components of the patches are the charts
+    auto fchart = mesh_.face_property<int>("f:chart");
+    for (auto f : mesh_.faces())
+        fchart[f] = -1;
+    std::vector<std::vector<Face>> charts;
+    std::vector<Face> stack;
+    for (auto f : mesh_.faces())
+    {
+        if (fchart[f] != -1)
+            continue;
+
+        const int chart = charts.size();
+        charts.emplace_back();
+        fchart[f] = chart;
+        stack.push_back(f);
+        while (!stack.empty())
+        {
+            const Face g = stack.back();
+            stack.pop_back();
+            charts.back().push_back(g);
+            for (auto h : mesh_.halfedges(g))
+            {
+                const Face ff = mesh_.face(mesh_.opposite_halfedge(h));
+                if (ff.is_valid() && fchart[ff] == -1 &&
+                    fpatch[ff] == fpatch[g])
+                {
+                    fchart[ff] = chart;
+                    stack.push_back(ff);
+                }
+            }
+        }
+    }
+
+    if (patches.empty())
+        mesh_.remove_face_property(fpatch);
+    else
+        for (size_t i = 0; i < patches.size(); ++i)
+            fpatch[Face(IndexType(i))] = patches[i];
+
+    // parameterize a copy of each chart and place it in its grid cell
+    auto htex = mesh_.halfedge_property<TexCoord>("h:tex");
+    const int n = charts.size();
+    const int columns = int(std::ceil(std::sqrt(double(n))));
+    parallel_for(
+        0, n,
+        [&](int c) {
+            // faces are sorted to make the copy independent of the flood fill
+            std::sort(charts[c].begin(), charts[c].end());
+
+            SurfaceMesh chart;
+            std::unordered_map<IndexType, Vertex> local;
+            std::vector<Vertex> vertices;
+            for (auto f : charts[c])
+            {
+                vertices.clear();
+                for (auto v : mesh_.vertices(f))
+                {
+                    auto it = local.find(v.idx());
+                    if (it == local.end())
+                        it = local.emplace(v.idx(),
+                                           chart.add_vertex(mesh_.position(v)))
+                                 .first;
+                    vertices.push_back(it->second);
+                }
+                chart.add_face(vertices);
+            }
+
+            SurfaceParameterization(chart).lscm();
+
+            const auto tex = chart.get_vertex_property<TexCoord>("v:tex");
+            const TexCoord offset(c % columns, c / columns);
+            for (auto f : charts[c])
+                for (auto h : mesh_.halfedges(f))
+                    htex[h] = (tex[local[mesh_.to_vertex(h).idx()]] + offset) /
+                              Scalar(columns);
+        },
+        1);
+
+    return n;
+}
+
+SurfaceParameterization::DistortionStatistics
+SurfaceParameterization::distortion()
+{
+    auto htex = mesh_.get_halfedge_property<TexCoord>("h:tex");
+    auto vtex = mesh_.get_vertex_property<TexCoord>("v:tex");
+    if (!htex && !vtex)
+    {
+        auto what = "SurfaceParameterization: No texture coordinates.";
+        throw InvalidInputException(what);
+    }
+    if (!mesh_.is_triangle_mesh())
+    {
+        auto what = "SurfaceParameterization: Not a triangle mesh.";
+        throw InvalidInputException(what);
+    }
+
+    auto pos = mesh_.vertex_property<Point>("v:point");
+    auto conformal = mesh_.face_property<Scalar>("f:conformal_distortion");
+    auto area = mesh_.face_property<Scalar>("f:area_distortion");
+    const Scalar degenerate = std::numeric_limits<Scalar>::max();
+
+    // surface area, signed texture area, and conformal distortion per face
+    const int nf = mesh_.faces_size();
+    std::vector<double> surface_area(nf, 0.0), tex_area(nf, 0.0);
+    parallel_for(mesh_.faces(), [&](Face f) {
+        Halfedge h[3];
+        int i = 0;
+        for (auto hh : mesh_.halfedges(f))
+            h[i++] = hh;
+
+        TexCoord t[3];
+        dvec3 p[3];
+        for (i = 0; i < 3; ++i)
+        {
+            const Vertex v = mesh_.to_vertex(h[i]);
+            t[i] = htex ? htex[h[i]] : vtex[v];
+            p[i] = (dvec3)pos[v];
+        }
+
+        // the triangle in a local frame: q1 = (l1, 0), q2 = (x2, y2)
+        const dvec3 e1 = p[1] - p[0];
+        const dvec3 e2 = p[2] - p[0];
+        const double l1 = norm(e1);
+        const double a3 = norm(cross(e1, e2));
+        const dvec2 t1 = (dvec2)(t[1] - t[0]);
+        const dvec2 t2 = (dvec2)(t[2] - t[0]);
+        const double a2 = t1[0] * t2[1] - t1[1] * t2[0];
+        surface_area[f.idx()] = 0.5 * a3;
+        tex_area[f.idx()] = 0.5 * a2;
+        if (l1 == 0 || a3 == 0 || a2 == 0)
+        {
+            conformal[f] = degenerate;
+            return;
+        }
+        const double x2 = dot(e1, e2) / l1;
+        const double y2 = a3 / l1;
+
+        // Jacobian J = T Q^-1 of the map from the local frame to texture
+        // space, with T = [t1 t2] and Q = [q1 q2]
+        const double j00 = t1[0] / l1;
+        const double j10 = t1[1] / l1;
+        const double j01 = (t2[0] - j00 * x2) / y2;
+        const double j11 = (t2[1] - j10 * x2) / y2;
+
+        // singular values of J in closed form
+        const double sa = 0.5 * (j00 + j11), sb = 0.5 * (j00 - j11);
+        const double sc = 0.5 * (j10 + j01), sd = 0.5 * (j10 - j01);
+        const double q = std::sqrt(sa * sa + sd * sd);
+        const double r = std::sqrt(sb * sb + sc * sc);
+        conformal[f] = Scalar((q + r) / std::fabs(q - r));
+    });
+
+    const dvec2 areas = parallel_reduce(
+        0, nf, dvec2(0, 0),
+        [&](int i) { return dvec2(surface_area[i], std::fabs(tex_area[i])); },
+        [](const dvec2& a, const dvec2& b) { return a + b; });
+    const double scale = areas[1] > 0 ? areas[0] / areas[1] : 0;
+
+    // area distortion and statistics, accumulated per chunk of faces and
+    // combined in order to be independent of the number of threads
+    struct Sums
+    {
+        double weight = 0, conformal = 0, area = 0;
+        Scalar max_conformal = 0, max_area = 0;
+        unsigned int n_flipped = 0, n_degenerate = 0;
+    };
+    const int chunk_size = 1024;
+    const int n_chunks = (nf + chunk_size - 1) / chunk_size;
+    std::vector<Sums> sums(n_chunks);
+
+    parallel_for(
+        0, n_chunks,
+        [&](int c) {
+            Sums& s = sums[c];
+            const int last = std::min(nf, (c + 1) * chunk_size);
+            for (int i = c * chunk_size; i < last; ++i)
+            {
+                const Face f(i);
+                if (mesh_.is_deleted(f))
+                    continue;
+                if (tex_area[i] < 0)
+                    ++s.n_flipped;
+                if (conformal[f] == degenerate)
+                {
+                    area[f] = degenerate;
+                    ++s.n_degenerate;
+                    continue;
+                }
+
+                const double ratio = scale * std::fabs(tex_area[i]) /
+                                     surface_area[i];
+                area[f] = Scalar(std::max(ratio, 1.0 / ratio));
+
+                s.weight += surface_area[i];
+                s.conformal += surface_area[i] * conformal[f];
+                s.area += surface_area[i] * area[f];
+                s.max_conformal = std::max(s.max_conformal, conformal[f]);
+                s.max_area = std::max(s.max_area, area[f]);
+            }
+        },
+        1);
+
+    Sums total;
+    for (const auto& s : sums)
+    {
+        total.weight += s.weight;
+        total.conformal += s.conformal;
+        total.area += s.area;
+        total.max_conformal = std::max(total.max_conformal, s.max_conformal);
+        total.max_area = std::max(total.max_area, s.max_area);
+        total.n_flipped += s.n_flipped;
+        total.n_degenerate += s.n_degenerate;
+    }
+
+    // bool properties are packed, so they are written sequentially
+    auto flipped = mesh_.face_property<bool>("f:flipped");
+    for (auto f : mesh_.faces())
+        flipped[f] = tex_area[f.idx()] < 0;
+
+    DistortionStatistics stats;
+    if (total.weight > 0)
+    {
+        stats.mean_conformal = Scalar(total.conformal / total.weight);
+        stats.mean_area = Scalar(total.area / total.weight);
+    }
+    stats.max_conformal = total.max_conformal;
+    stats.max_area = total.max_area;
+    stats.n_flipped = total.n_flipped;
+    stats.n_degenerate = total.n_degenerate;
+    return stats;
+}
+
 } // namespace pmp
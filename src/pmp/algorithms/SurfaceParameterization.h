@@ -15,19 +15,77 @@ class SurfaceParameterization
 {
 public:
     //! \brief Construct with mesh to be parameterized.
-    //! \pre The mesh has a boundary.
-    //! \throw InvalidInputException if the input precondition is violated.
     SurfaceParameterization(SurfaceMesh& mesh);
 
     //! \brief Compute discrete harmonic parameterization.
+    //! \pre The mesh has a boundary.
+    //! \throw InvalidInputException if the input precondition is violated.
     //! \throw SolverException in case of failure to solve the linear system.
     void harmonic(bool use_uniform_weights = false);
 
     //! \brief Compute parameterization based on least squares conformal mapping.
+    //! \details The linear system is assembled in parallel and solved by a
+    //! LinearSolver of the default type.
+    //! \pre The mesh has a boundary.
+    //! \throw InvalidInputException if the input precondition is violated.
     //! \throw SolverException in case of failure to solve the linear system.
     void lscm();
 
+    //! \brief Parameterize the mesh as an atlas of independent charts.
+    //! \details Splits the faces into \p n_charts spatially coherent patches
+    //! using SurfacePartition. Each connected component of a patch becomes a
+    //! chart, which is parameterized by lscm() in parallel with the other
+    //! charts. The charts are placed in the cells of a square grid in the
+    //! unit square. The texture coordinates are stored per halfedge in the
+    //! property \c "h:tex", the chart of each face in \c "f:chart". An
+    //! existing \c "f:patch" property is restored afterwards. Meshes
+    //! without boundary are supported as long as \p n_charts cuts each
+    //! closed component.
+    //! \return The number of charts.
+    //! \throw InvalidInputException if \p n_charts is zero or a chart has no
+    //! boundary.
+    //! \throw SolverException in case of failure to solve a linear system.
+    size_t lscm_charts(size_t n_charts);
+
+    //! distortion of a parameterization, see distortion()
+    struct DistortionStatistics
+    {
+        //! mean conformal distortion, weighted by surface area
+        Scalar mean_conformal = 0;
+
+        //! maximum conformal distortion
+        Scalar max_conformal = 0;
+
+        //! mean area distortion, weighted by surface area
+        Scalar mean_area = 0;
+
+        //! maximum area distortion
+        Scalar max_area = 0;
+
+        unsigned int n_flipped = 0;    //!< number of flipped faces
+        unsigned int n_degenerate = 0; //!< number of degenerate faces
+    };
+
+    //! \brief Measure the distortion of the current parameterization.
+    //! \details Uses the texture coordinates in \c "h:tex" if present,
+    //! otherwise the ones in \c "v:tex". The faces are analyzed in parallel.
+    //! The conformal distortion of a face is the ratio of the singular values
+    //! of the Jacobian of its map to the texture domain, the area distortion
+    //! is the ratio of its texture area to its surface area, relative to the
+    //! ratio of the total areas, or the inverse of that if it is smaller than
+    //! one. Both are 1 for an undistorted face. They are stored in the face
+    //! properties \c "f:conformal_distortion" and \c "f:area_distortion".
+    //! Faces with negative texture area are marked in \c "f:flipped".
+    //! Degenerate faces, having zero surface or texture area, get the maximum
+    //! Scalar as distortion and are excluded from the means and maxima.
+    //! \throw InvalidInputException if the mesh has no texture coordinates or
+    //! is not a triangle mesh.
+    DistortionStatistics distortion();
+
 private:
+    //! throw if the mesh has no boundary
+    void check_boundary() const;
+
     //! setup boundary constraints: map surface boundary to unit circle
     void setup_boundary_constraints();
 
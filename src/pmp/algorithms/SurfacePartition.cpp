@@ -0,0 +1,418 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfacePartition.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace pmp {
+
+namespace {
+
+typedef std::vector<std::pair<Point, Face>> Centroids;
+
+// Assign patch indices first, ..., first + n_parts - 1 to the faces in
+// [begin, end) by recursively splitting at the median along the longest
+// bounding box axis. Parts are sized proportionally to their patch counts.
+void bisect(Centroids::iterator begin, Centroids::iterator end, size_t n_parts,
+            int first, FaceProperty<int>& fpatch)
+{
+    if (n_parts == 1 || end - begin < 2)
+    {
+        for (auto it = begin; it != end; ++it)
+            fpatch[it->second] = first;
+        return;
+    }
+
+    BoundingBox bb;
+    for (auto it = begin; it != end; ++it)
+        bb += it->first;
+    const Point extent = bb.max() - bb.min();
+    int axis = 0;
+    if (extent[1] > extent[axis])
+        axis = 1;
+    if (extent[2] > extent[axis])
+        axis = 2;
+
+    const size_t n_left = n_parts / 2;
+    auto mid = begin + (end - begin) * n_left / n_parts;
+    std::nth_element(begin, mid, end,
+                     [axis](const Centroids::value_type& a,
+                            const Centroids::value_type& b) {
+                         return a.first[axis] < b.first[axis];
+                     });
+
+    bisect(begin, mid, n_left, first, fpatch);
+    bisect(mid, end, n_parts - n_left, first + int(n_left), fpatch);
+}
+
+// Count the fans of selected faces around v. More than one fan makes v a
+// complex vertex of the selection.
+size_t n_fans(const SurfaceMesh& mesh, Vertex v,
+              const std::vector<char>& fselected)
+{
+    auto selected = [&](Halfedge h) {
+        Face f = mesh.face(h);
+        return f.is_valid() && fselected[f.idx()];
+    };
+
+    size_t n = 0;
+    for (auto h : mesh.halfedges(v))
+        if (selected(h) && !selected(mesh.ccw_rotated_halfedge(h)))
+            ++n;
+    return n;
+}
+
+} // namespace
+
+SurfacePartition::SurfacePartition(SurfaceMesh& mesh) : mesh_(mesh)
+{
+    fpatch_ = mesh_.face_property<int>("f:patch", -1);
+
+    int n = 0;
+    for (auto f : mesh_.faces())
+        n = std::max(n, fpatch_[f] + 1);
+    n_patches_ = n;
+}
+
+void SurfacePartition::partition(size_t n_patches)
+{
+    if (n_patches == 0)
+    {
+        auto what = "SurfacePartition::partition: Number of patches is zero.";
+        throw InvalidInputException(what);
+    }
+
+    Centroids centroids;
+    centroids.reserve(mesh_.n_faces());
+    for (auto f : mesh_.faces())
+    {
+        Point c(0, 0, 0);
+        Scalar n(0);
+        for (auto v : mesh_.vertices(f))
+        {
+            c += mesh_.position(v);
+            ++n;
+        }
+        centroids.emplace_back(c / n, f);
+    }
+
+    bisect(centroids.begin(), centroids.end(), n_patches, 0, fpatch_);
+    n_patches_ = n_patches;
+}
+
+SurfacePatch SurfacePartition::extract(size_t index,
+                                       unsigned int halo_rings) const
+{
+    if (index >= n_patches_)
+    {
+        auto what = "SurfacePartition::extract: Patch index out of range.";
+        throw InvalidInputException(what);
+    }
+
+    // select patch faces (1) and halo faces (2)
+    std::vector<char> fselected(mesh_.faces_size(), 0);
+    std::vector<char> vselected(mesh_.vertices_size(), 0);
+    std::vector<Vertex> front;
+    for (auto f : mesh_.faces())
+        if (fpatch_[f] == int(index))
+        {
+            fselected[f.idx()] = 1;
+            for (auto v : mesh_.vertices(f))
+                if (!vselected[v.idx()])
+                {
+                    vselected[v.idx()] = 1;
+                    front.push_back(v);
+                }
+        }
+
+    // grow the halo ring by ring
+    for (unsigned int i = 0; i < halo_rings; ++i)
+    {
+        std::vector<Vertex> next;
+        for (auto v : front)
+            for (auto f : mesh_.faces(v))
+                if (!fselected[f.idx()])
+                {
+                    fselected[f.idx()] = 2;
+                    for (auto fv : mesh_.vertices(f))
+                        if (!vselected[fv.idx()])
+                        {
+                            vselected[fv.idx()] = 1;
+                            next.push_back(fv);
+                        }
+                }
+        front.swap(next);
+    }
+
+    // close the face fans of complex vertices
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto v : mesh_.vertices())
+            if (vselected[v.idx()] && n_fans(mesh_, v, fselected) > 1)
+            {
+                for (auto f : mesh_.faces(v))
+                    if (!fselected[f.idx()])
+                    {
+                        fselected[f.idx()] = 2;
+                        for (auto fv : mesh_.vertices(f))
+                            vselected[fv.idx()] = 1;
+                    }
+                changed = true;
+            }
+    }
+
+    // collect vertices and faces in mesh order
+    std::vector<IndexType> vmap(mesh_.vertices_size(), PMP_MAX_INDEX);
+    std::vector<Point> points;
+    std::vector<Vertex> vorigin;
+    for (auto v : mesh_.vertices())
+        if (vselected[v.idx()])
+        {
+            vmap[v.idx()] = points.size();
+            points.push_back(mesh_.position(v));
+            vorigin.push_back(v);
+        }
+
+    std::vector<IndexType> indices, face_sizes;
+    std::vector<Face> forigin;
+    std::vector<bool> fhalo;
+    for (auto f : mesh_.faces())
+        if (fselected[f.idx()])
+        {
+            IndexType n = 0;
+            for (auto v : mesh_.vertices(f))
+            {
+                indices.push_back(vmap[v.idx()]);
+                ++n;
+            }
+            face_sizes.push_back(n);
+            forigin.push_back(f);
+            fhalo.push_back(fselected[f.idx()] == 2);
+        }
+
+    SurfacePatch patch;
+    patch.index = index;
+    SurfaceMesh& pmesh = patch.mesh;
+    pmesh.from_indexed_faces(points, indices, face_sizes);
+
+    auto pvorigin = pmesh.add_vertex_property<Vertex>("v:origin");
+    auto pforigin = pmesh.add_face_property<Face>("f:origin");
+    auto pvhalo = pmesh.add_vertex_property<bool>("v:halo", false);
+    auto pfhalo = pmesh.add_face_property<bool>("f:halo", false);
+    auto pvselected = pmesh.add_vertex_property<bool>("v:selected", false);
+
+    for (auto v : pmesh.vertices())
+        pvorigin[v] = vorigin[v.idx()];
+
+    for (auto f : pmesh.faces())
+    {
+        pforigin[f] = forigin[f.idx()];
+        if (fhalo[f.idx()])
+        {
+            pfhalo[f] = true;
+            for (auto v : pmesh.vertices(f))
+                pvhalo[v] = true;
+        }
+    }
+
+    for (auto v : pmesh.vertices())
+        pvselected[v] = !pvhalo[v];
+
+    return patch;
+}
+
+bool SurfacePartition::same_connectivity(
+    const SurfacePatch& patch, const std::vector<size_t>& n_faces) const
+{
+    const SurfaceMesh& pmesh = patch.mesh;
+    if (pmesh.n_vertices() != pmesh.vertices_size() ||
+        pmesh.n_faces() != pmesh.faces_size())
+        return false;
+
+    auto vorigin = pmesh.get_vertex_property<Vertex>("v:origin");
+    auto forigin = pmesh.get_face_property<Face>("f:origin");
+    auto fhalo = pmesh.get_face_property<bool>("f:halo");
+
+    for (auto v : pmesh.vertices())
+        if (!vorigin[v].is_valid())
+            return false;
+
+    size_t n = 0;
+    std::vector<Vertex> a, b;
+    for (auto f : pmesh.faces())
+    {
+        if (fhalo[f])
+            continue;
+        ++n;
+
+        Face g = forigin[f];
+        if (!g.is_valid() || fpatch_[g] != int(patch.index))
+            return false;
+
+        // compare the vertex cycles up to rotation
+        a.clear();
+        b.clear();
+        for (auto v : mesh_.vertices(g))
+            a.push_back(v);
+        for (auto v : pmesh.vertices(f))
+            b.push_back(vorigin[v]);
+        if (a.size() != b.size())
+            return false;
+        auto it = std::find(a.begin(), a.end(), b[0]);
+        if (it == a.end())
+            return false;
+        std::rotate(a.begin(), it, a.end());
+        if (a != b)
+            return false;
+    }
+
+    return n == n_faces[patch.index];
+}
+
+void SurfacePartition::stitch(const std::vector<SurfacePatch>& patches)
+{
+    std::vector<char> replaced(n_patches_, 0);
+    for (const auto& patch : patches)
+    {
+        if (patch.index >= n_patches_)
+        {
+            auto what = "SurfacePartition::stitch: Patch index out of range.";
+            throw InvalidInputException(what);
+        }
+        if (replaced[patch.index])
+        {
+            auto what = "SurfacePartition::stitch: Patch passed twice.";
+            throw InvalidInputException(what);
+        }
+        if (!patch.mesh.has_vertex_property("v:origin") ||
+            !patch.mesh.has_vertex_property("v:halo") ||
+            !patch.mesh.has_face_property("f:halo"))
+        {
+            auto what = "SurfacePartition::stitch: Missing patch properties.";
+            throw InvalidInputException(what);
+        }
+        replaced[patch.index] = 1;
+    }
+
+    std::vector<size_t> n_faces(n_patches_, 0);
+    for (auto f : mesh_.faces())
+        if (fpatch_[f] >= 0)
+            ++n_faces[fpatch_[f]];
+
+    bool same = true;
+    for (const auto& patch : patches)
+        if (!same_connectivity(patch, n_faces))
+        {
+            same = false;
+            break;
+        }
+
+    // connectivity unchanged: copy positions of the patch interiors
+    if (same)
+    {
+        for (const auto& patch : patches)
+        {
+            const SurfaceMesh& pmesh = patch.mesh;
+            auto vorigin = pmesh.get_vertex_property<Vertex>("v:origin");
+            auto vhalo = pmesh.get_vertex_property<bool>("v:halo");
+            for (auto v : pmesh.vertices())
+                if (!vhalo[v])
+                    mesh_.position(vorigin[v]) = pmesh.position(v);
+        }
+        return;
+    }
+
+    // rebuild from untouched faces and the patch interiors
+    std::vector<IndexType> vmap(mesh_.vertices_size(), PMP_MAX_INDEX);
+    std::vector<Point> points;
+    for (auto v : mesh_.vertices())
+    {
+        vmap[v.idx()] = points.size();
+        points.push_back(mesh_.position(v));
+    }
+
+    std::vector<IndexType> indices, face_sizes;
+    std::vector<int> patch_ids;
+    for (auto f : mesh_.faces())
+    {
+        if (fpatch_[f] >= 0 && replaced[fpatch_[f]])
+            continue;
+        IndexType n = 0;
+        for (auto v : mesh_.vertices(f))
+        {
+            indices.push_back(vmap[v.idx()]);
+            ++n;
+        }
+        face_sizes.push_back(n);
+        patch_ids.push_back(fpatch_[f]);
+    }
+
+    for (const auto& patch : patches)
+    {
+        const SurfaceMesh& pmesh = patch.mesh;
+        auto vorigin = pmesh.get_vertex_property<Vertex>("v:origin");
+        auto vhalo = pmesh.get_vertex_property<bool>("v:halo");
+        auto fhalo = pmesh.get_face_property<bool>("f:halo");
+
+        std::vector<IndexType> pmap(pmesh.vertices_size(), PMP_MAX_INDEX);
+        for (auto v : pmesh.vertices())
+        {
+            Vertex o = vorigin[v];
+            if (o.is_valid() && o.idx() < vmap.size() &&
+                vmap[o.idx()] != PMP_MAX_INDEX)
+            {
+                pmap[v.idx()] = vmap[o.idx()];
+                if (!vhalo[v])
+                    points[pmap[v.idx()]] = pmesh.position(v);
+            }
+            else
+            {
+                pmap[v.idx()] = points.size();
+                points.push_back(pmesh.position(v));
+            }
+        }
+
+        for (auto f : pmesh.faces())
+        {
+            if (fhalo[f])
+                continue;
+            IndexType n = 0;
+            for (auto v : pmesh.vertices(f))
+            {
+                indices.push_back(pmap[v.idx()]);
+                ++n;
+            }
+            face_sizes.push_back(n);
+            patch_ids.push_back(int(patch.index));
+        }
+    }
+
+    // drop vertices no longer referenced by any face
+    std::vector<IndexType> used(points.size(), PMP_MAX_INDEX);
+    for (auto i : indices)
+        used[i] = 0;
+    size_t n_used = 0;
+    for (size_t i = 0; i < points.size(); ++i)
+        if (used[i] != PMP_MAX_INDEX)
+        {
+            used[i] = n_used;
+            points[n_used++] = points[i];
+        }
+    points.resize(n_used);
+    for (auto& i : indices)
+        i = used[i];
+
+    SurfaceMesh result;
+    result.from_indexed_faces(points, indices, face_sizes);
+    mesh_ = std::move(result);
+
+    fpatch_ = mesh_.add_face_property<int>("f:patch", -1);
+    for (auto f : mesh_.faces())
+        fpatch_[f] = patch_ids[f.idx()];
+}
+
+} // namespace pmp
@@ -0,0 +1,87 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A patch of a mesh as extracted by SurfacePartition::extract().
+//! \details The patch mesh contains the faces of the patch plus a halo of
+//! surrounding faces and carries the following properties:
+//!  - \c "v:origin" (Vertex) and \c "f:origin" (Face) map patch elements to
+//!    the elements of the partitioned mesh they were copied from. Elements
+//!    created while processing the patch have invalid origins.
+//!  - \c "v:halo" (bool) marks vertices that are shared with the halo, i.e.,
+//!    all vertices incident to a halo face. These must not be moved or
+//!    deleted when processing the patch.
+//!  - \c "f:halo" (bool) marks the halo faces.
+//!  - \c "v:selected" (bool) is the negation of \c "v:halo", such that
+//!    SurfaceRemeshing only modifies the patch interior.
+//!
+//! The origins are stored as properties so that they stay valid across
+//! garbage collection.
+//! \ingroup algorithms
+struct SurfacePatch
+{
+    //! index of the patch within its partition
+    size_t index;
+
+    //! the faces of the patch plus its halo
+    SurfaceMesh mesh;
+};
+
+//! \brief Split a mesh into spatially coherent patches for chunked processing.
+//! \details Patches are extracted as standalone meshes with a halo ring of
+//! context faces, processed independently, e.g., in parallel or on different
+//! machines, and stitched back into the mesh.
+//! \ingroup algorithms
+class SurfacePartition
+{
+public:
+    //! \brief Construct with mesh to be partitioned.
+    //! \details Adds the face property \c "f:patch" storing the patch index
+    //! of each face if it does not already exist. An existing partition is
+    //! re-used.
+    SurfacePartition(SurfaceMesh& mesh);
+
+    //! \brief Split the faces into \p n_patches patches of about equal size.
+    //! \details Performs recursive coordinate bisection of the face
+    //! centroids along the longest bounding box axis.
+    //! \throw InvalidInputException if \p n_patches is zero.
+    void partition(size_t n_patches);
+
+    //! \brief Return the number of patches.
+    size_t n_patches() const { return n_patches_; }
+
+    //! \brief Extract patch \p index with \p halo_rings rings of halo faces.
+    //! \details Halo faces are added where needed to keep the patch mesh
+    //! manifold. This function does not modify the partitioned mesh and may
+    //! be called concurrently for different patches.
+    //! \throw InvalidInputException if \p index is out of range.
+    SurfacePatch extract(size_t index, unsigned int halo_rings = 1) const;
+
+    //! \brief Write processed \p patches back into the mesh.
+    //! \details If no patch changed its connectivity, only the positions of
+    //! the non-halo vertices are copied back and all mesh properties are
+    //! kept. Otherwise the mesh is rebuilt from the faces of the untouched
+    //! patches and the non-halo faces of \p patches, which keeps vertex
+    //! positions and \c "f:patch" only.
+    //! \pre The halo of each patch is unchanged.
+    //! \throw InvalidInputException if a patch index is out of range, a
+    //! patch is passed twice, or a patch lacks its origin properties.
+    void stitch(const std::vector<SurfacePatch>& patches);
+
+private:
+    bool same_connectivity(const SurfacePatch& patch,
+                           const std::vector<size_t>& n_faces) const;
+
+    SurfaceMesh& mesh_;
+    FaceProperty<int> fpatch_;
+    size_t n_patches_;
+};
+
+} // namespace pmp
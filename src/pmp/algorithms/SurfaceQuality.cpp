@@ -0,0 +1,277 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfaceQuality.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+namespace {
+
+// elements per chunk. fixed, such that the sums are rounded the same for
+// any number of threads.
+const int chunk_size = 8192;
+
+// the log2 of edge lengths is clamped to [-max_octave, max_octave)
+const int max_octave = 64;
+
+// minimum, maximum, and sum of a quantity
+struct Accumulator
+{
+    Scalar min = std::numeric_limits<Scalar>::max();
+    Scalar max = std::numeric_limits<Scalar>::lowest();
+    double sum = 0;
+    size_t n = 0;
+
+    void add(Scalar x)
+    {
+        min = std::min(min, x);
+        max = std::max(max, x);
+        sum += x;
+        ++n;
+    }
+
+    void add(const Accumulator& a)
+    {
+        min = std::min(min, a.min);
+        max = std::max(max, a.max);
+        sum += a.sum;
+        n += a.n;
+    }
+
+    SurfaceQuality::Range range() const
+    {
+        SurfaceQuality::Range r;
+        if (n)
+        {
+            r.min = min;
+            r.max = max;
+            r.mean = Scalar(sum / n);
+        }
+        return r;
+    }
+};
+
+// add the counts of b to a, growing a as needed
+void add_counts(std::vector<size_t>& a, const std::vector<size_t>& b)
+{
+    if (a.size() < b.size())
+        a.resize(b.size(), 0);
+    for (size_t i = 0; i < b.size(); ++i)
+        a[i] += b[i];
+}
+
+// the bin of x in n_bins equal bins of [lo, hi], clamped
+size_t bin(Scalar x, Scalar lo, Scalar hi, size_t n_bins)
+{
+    const Scalar t = (x - lo) / (hi - lo) * n_bins;
+    if (!(t > 0))
+        return 0;
+    return std::min(size_t(t), n_bins - 1);
+}
+
+// equal bins of [lo, hi]
+SurfaceQuality::Histogram histogram(Scalar lo, Scalar hi,
+                                    std::vector<size_t> counts)
+{
+    SurfaceQuality::Histogram h;
+    const size_t n = counts.size();
+    for (size_t i = 0; i <= n; ++i)
+        h.bounds.push_back(lo + (hi - lo) * i / n);
+    h.counts = std::move(counts);
+    return h;
+}
+
+// statistics of a chunk of faces and vertices
+struct Statistics
+{
+    SurfaceQuality::Report report;
+    Accumulator aspect_ratio, angle, edge_length;
+    std::vector<size_t> aspect_ratios, angles, edge_lengths;
+
+    void add(const Statistics& s)
+    {
+        SurfaceQuality::Report& r = report;
+        const SurfaceQuality::Report& q = s.report;
+        r.n_vertices += q.n_vertices;
+        r.n_edges += q.n_edges;
+        r.n_boundary_edges += q.n_boundary_edges;
+        r.n_faces += q.n_faces;
+        r.n_triangles += q.n_triangles;
+        r.n_slivers += q.n_slivers;
+        r.n_degenerate += q.n_degenerate;
+        add_counts(r.valences, q.valences);
+        aspect_ratio.add(s.aspect_ratio);
+        angle.add(s.angle);
+        edge_length.add(s.edge_length);
+        add_counts(aspect_ratios, s.aspect_ratios);
+        add_counts(angles, s.angles);
+        add_counts(edge_lengths, s.edge_lengths);
+    }
+};
+
+} // namespace
+
+Scalar SurfaceQuality::aspect_ratio(const Point& p0, const Point& p1,
+                                    const Point& p2)
+{
+    const Scalar l = std::max(sqrnorm(p1 - p0),
+                              std::max(sqrnorm(p2 - p1), sqrnorm(p0 - p2)));
+
+    // twice the area
+    const Scalar a = norm(cross(p1 - p0, p2 - p0));
+    if (!(a > 0))
+        return std::numeric_limits<Scalar>::infinity();
+
+    return l * std::sqrt(Scalar(3)) / (2 * a);
+}
+
+SurfaceQuality::Report SurfaceQuality::analyze(const SurfaceMesh& mesh,
+                                               const Settings& settings)
+{
+    const size_t n_bins = std::max(settings.n_bins, 1u);
+    const Scalar max_aspect_ratio = std::max(settings.max_aspect_ratio,
+                                             Scalar(1) + Scalar(1e-6));
+    const int per_octave = int(std::max(settings.edge_bins_per_octave, 1u));
+    const int n_length_bins = 2 * max_octave * per_octave;
+
+    // faces and vertices are fused into one range of indices
+    const int n = int(std::max(mesh.faces_size(), mesh.vertices_size()));
+    const int n_chunks = (n + chunk_size - 1) / chunk_size;
+    std::vector<Statistics> partial(n_chunks);
+
+    Parallel::run(n_chunks, [&](int c) {
+        Statistics& s = partial[c];
+        SurfaceQuality::Report& r = s.report;
+        s.aspect_ratios.assign(n_bins, 0);
+        s.angles.assign(n_bins, 0);
+        s.edge_lengths.assign(n_length_bins, 0);
+
+        std::vector<Point> points;
+        const int first = c * chunk_size;
+        const int last = std::min(first + chunk_size, n);
+        for (int i = first; i < last; ++i)
+        {
+            const Face f(i);
+            if (size_t(i) < mesh.faces_size() && !mesh.is_deleted(f))
+            {
+                ++r.n_faces;
+
+                // edges are counted by their smaller halfedge, boundary edges
+                // by their interior one
+                points.clear();
+                for (auto h : mesh.halfedges(f))
+                {
+                    points.push_back(mesh.position(mesh.to_vertex(h)));
+
+                    const Halfedge o = mesh.opposite_halfedge(h);
+                    const bool boundary = mesh.is_boundary(o);
+                    if (!boundary && o.idx() < h.idx())
+                        continue;
+                    ++r.n_edges;
+                    if (boundary)
+                        ++r.n_boundary_edges;
+
+                    const Scalar l = distance(points.back(),
+                                              mesh.position(mesh.to_vertex(o)));
+                    s.edge_length.add(l);
+                    if (l > 0)
+                    {
+                        int b = int(std::floor(per_octave * std::log2(l)));
+                        b = std::min(std::max(b + max_octave * per_octave, 0),
+                                     n_length_bins - 1);
+                        ++s.edge_lengths[b];
+                    }
+                }
+
+                // interior angles
+                const size_t valence = points.size();
+                Scalar min_angle = 180;
+                for (size_t j = 0; j < valence; ++j)
+                {
+                    const Point& p = points[j];
+                    const Point d0 = points[(j + 1) % valence] - p;
+                    const Point d1 = points[(j + valence - 1) % valence] - p;
+                    const Scalar a =
+                        std::atan2(norm(cross(d0, d1)), dot(d0, d1)) * 180 /
+                        Scalar(M_PI);
+                    s.angle.add(a);
+                    ++s.angles[bin(a, 0, 180, n_bins)];
+                    min_angle = std::min(min_angle, a);
+                }
+
+                if (valence == 3)
+                {
+                    ++r.n_triangles;
+                    const Scalar ar =
+                        aspect_ratio(points[0], points[1], points[2]);
+                    if (std::isinf(ar))
+                    {
+                        ++r.n_degenerate;
+                        ++r.n_slivers;
+                    }
+                    else
+                    {
+                        s.aspect_ratio.add(ar);
+                        ++s.aspect_ratios[bin(ar, 1, max_aspect_ratio,
+                                              n_bins)];
+                        if (min_angle < settings.sliver_angle)
+                            ++r.n_slivers;
+                    }
+                }
+            }
+
+            const Vertex v(i);
+            if (size_t(i) < mesh.vertices_size() && !mesh.is_deleted(v))
+            {
+                ++r.n_vertices;
+                const size_t valence = mesh.valence(v);
+                if (r.valences.size() <= valence)
+                    r.valences.resize(valence + 1, 0);
+                ++r.valences[valence];
+            }
+        }
+    });
+
+    // combine in a fixed order
+    Statistics total;
+    for (const auto& s : partial)
+        total.add(s);
+
+    Report report = std::move(total.report);
+    report.aspect_ratio = total.aspect_ratio.range();
+    report.angle = total.angle.range();
+    report.edge_length = total.edge_length.range();
+    report.aspect_ratios =
+        histogram(1, max_aspect_ratio,
+                  total.aspect_ratios.empty() ? std::vector<size_t>(n_bins, 0)
+                                              : total.aspect_ratios);
+    report.angles = histogram(
+        0, 180,
+        total.angles.empty() ? std::vector<size_t>(n_bins, 0) : total.angles);
+
+    // the logarithmic bins from the shortest to the longest edge
+    const auto& lengths = total.edge_lengths;
+    const auto nonzero = [](size_t count) { return count != 0; };
+    const auto begin = std::find_if(lengths.begin(), lengths.end(), nonzero);
+    if (begin != lengths.end())
+    {
+        const auto end =
+            std::find_if(lengths.rbegin(), lengths.rend(), nonzero).base();
+        const int offset =
+            int(begin - lengths.begin()) - max_octave * per_octave;
+        auto& h = report.edge_lengths;
+        h.counts.assign(begin, end);
+        for (size_t i = 0; i <= h.counts.size(); ++i)
+            h.bounds.push_back(
+                std::exp2(Scalar(offset + int(i)) / per_octave));
+    }
+    return report;
+}
+
+} // namespace pmp
@@ -0,0 +1,121 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Quality statistics of the elements of a surface mesh.
+//! \details Computes the aspect ratios and angles of the faces, the edge
+//! lengths, and the vertex valences in a single parallel pass over the
+//! faces and vertices, cheap enough to check the output of every step of a
+//! processing pipeline. The statistics are gathered per chunk of elements
+//! and combined in a fixed order, such that the report is the same for any
+//! number of threads.
+//! \ingroup algorithms
+class SurfaceQuality
+{
+public:
+    // delete default and copy constructor
+    SurfaceQuality() = delete;
+    SurfaceQuality(const SurfaceQuality&) = delete;
+
+    //! minimum, maximum, and mean of a quantity, zero if there are no values
+    struct Range
+    {
+        Scalar min = 0;
+        Scalar max = 0;
+        Scalar mean = 0;
+    };
+
+    //! \brief Number of values in consecutive bins.
+    //! \details Bin i counts the values in [bounds[i], bounds[i+1]). Values
+    //! beyond the bounds are counted in the first or last bin.
+    struct Histogram
+    {
+        std::vector<Scalar> bounds; //!< ascending, one more than counts
+        std::vector<size_t> counts; //!< number of values of each bin
+    };
+
+    //! parameters of analyze()
+    struct Settings
+    {
+        //! number of bins of the angle and aspect ratio histograms
+        unsigned int n_bins = 18;
+
+        //! upper bound of the aspect ratio histogram
+        Scalar max_aspect_ratio = 10;
+
+        //! triangles with a smaller angle, in degrees, are slivers
+        Scalar sliver_angle = 10;
+
+        //! \brief Bins of the edge length histogram per doubling of the
+        //! length.
+        //! \details The bins are spaced logarithmically, such that lengths
+        //! of any scale are resolved without a second pass. The histogram
+        //! spans the bins from the shortest to the longest edge.
+        unsigned int edge_bins_per_octave = 4;
+    };
+
+    //! statistics gathered by analyze()
+    struct Report
+    {
+        size_t n_vertices = 0;       //!< number of vertices
+        size_t n_edges = 0;          //!< number of edges
+        size_t n_boundary_edges = 0; //!< number of boundary edges
+        size_t n_faces = 0;          //!< number of faces
+        size_t n_triangles = 0;      //!< number of triangles
+
+        //! aspect ratios of the non-degenerate triangles, see aspect_ratio()
+        Range aspect_ratio;
+
+        //! interior angles of all faces in degrees
+        Range angle;
+
+        //! lengths of all edges
+        Range edge_length;
+
+        //! triangles with an angle below Settings::sliver_angle, including
+        //! the degenerate ones
+        size_t n_slivers = 0;
+
+        //! triangles of zero area
+        size_t n_degenerate = 0;
+
+        //! aspect ratios in [1, Settings::max_aspect_ratio]
+        Histogram aspect_ratios;
+
+        //! angles in [0, 180] degrees
+        Histogram angles;
+
+        //! edge lengths in logarithmically spaced bins, without zero lengths
+        Histogram edge_lengths;
+
+        //! number of vertices of each valence, indexed by the valence
+        std::vector<size_t> valences;
+    };
+
+    //! \brief Compute the quality statistics of \p mesh.
+    //! \details Aspect ratios, slivers, and degenerate faces are counted
+    //! for triangles only, angles for the corners of all faces.
+    static Report analyze(const SurfaceMesh& mesh, const Settings& settings);
+
+    //! compute the quality statistics of \p mesh with the default settings
+    static Report analyze(const SurfaceMesh& mesh)
+    {
+        return analyze(mesh, Settings());
+    }
+
+    //! \brief Aspect ratio of the triangle (p0, p1, p2).
+    //! \details The squared longest edge over the area, scaled such that
+    //! equilateral triangles have aspect ratio one. Returns infinity for
+    //! degenerate triangles.
+    static Scalar aspect_ratio(const Point& p0, const Point& p1,
+                               const Point& p2);
+};
+
+} // namespace pmp
@@ -6,18 +6,31 @@
 #include <cmath>
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
 #include <stdexcept>
 
-#include "pmp/algorithms/TriangleKdTree.h"
+#include "pmp/MemoryScope.h"
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
+#include "pmp/SurfaceMeshIO.h"
 #include "pmp/algorithms/SurfaceCurvature.h"
 #include "pmp/algorithms/SurfaceNormals.h"
 #include "pmp/algorithms/BarycentricCoordinates.h"
-#include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/GeometryCache.h"
+#include "pmp/algorithms/IndependentSetScheduler.h"
 
 namespace pmp {
 
 SurfaceRemeshing::SurfaceRemeshing(SurfaceMesh& mesh)
-    : mesh_(mesh), refmesh_(nullptr), kd_tree_(nullptr)
+    : mesh_(mesh),
+      refmesh_(nullptr),
+      bvh_(nullptr),
+      localized_(false),
+      halo_(4),
+      use_worklist_(false)
 {
     if (!mesh_.is_triangle_mesh())
         throw InvalidInputException("Input is not a pure triangle mesh!");
@@ -34,28 +47,23 @@ void SurfaceRemeshing::uniform_remeshing(Scalar edge_length,
                                          unsigned int iterations,
                                          bool use_projection)
 {
+    PMP_PROFILE_SCOPE("SurfaceRemeshing::uniform_remeshing");
+
     uniform_ = true;
     use_projection_ = use_projection;
     target_edge_length_ = edge_length;
 
     preprocessing();
 
-    for (unsigned int i = 0; i < iterations; ++i)
-    {
-        split_long_edges();
-
-        SurfaceNormals::compute_vertex_normals(mesh_);
-
-        collapse_short_edges();
+    const bool completed = remesh(iterations);
 
-        flip_edges();
-
-        tangential_smoothing(5);
-    }
-
-    remove_caps();
+    if (completed)
+        remove_caps();
 
     postprocessing();
+
+    if (!completed)
+        throw CancelledException("SurfaceRemeshing: Cancelled.");
 }
 
 void SurfaceRemeshing::adaptive_remeshing(Scalar min_edge_length,
@@ -64,6 +72,8 @@ void SurfaceRemeshing::adaptive_remeshing(Scalar min_edge_length,
                                           unsigned int iterations,
                                           bool use_projection)
 {
+    PMP_PROFILE_SCOPE("SurfaceRemeshing::adaptive_remeshing");
+
     uniform_ = false;
     min_edge_length_ = min_edge_length;
     max_edge_length_ = max_edge_length;
@@ -72,38 +82,158 @@ void SurfaceRemeshing::adaptive_remeshing(Scalar min_edge_length,
 
     preprocessing();
 
+    const bool completed = remesh(iterations);
+
+    if (completed)
+        remove_caps();
+
+    postprocessing();
+
+    if (!completed)
+        throw CancelledException("SurfaceRemeshing: Cancelled.");
+}
+
+void SurfaceRemeshing::adaptive_remeshing(VertexProperty<Scalar> sizing,
+                                          unsigned int iterations,
+                                          bool use_projection)
+{
+    PMP_PROFILE_SCOPE("SurfaceRemeshing::adaptive_remeshing");
+
+    uniform_ = false;
+    sizing_ = sizing;
+    use_projection_ = use_projection;
+
+    preprocessing();
+
+    const bool completed = remesh(iterations);
+
+    if (completed)
+        remove_caps();
+
+    postprocessing();
+
+    if (!completed)
+        throw CancelledException("SurfaceRemeshing: Cancelled.");
+}
+
+bool SurfaceRemeshing::remesh(unsigned int iterations)
+{
+    typedef std::chrono::steady_clock clock;
+    const auto start = clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double, std::milli>(clock::now() - start)
+            .count();
+    };
+
+    statistics_.clear();
+
     for (unsigned int i = 0; i < iterations; ++i)
     {
-        split_long_edges();
+        IterationStatistics stats;
+        MemoryScope memory;
+
+        double phase = elapsed();
+        auto phase_time = [&]() {
+            const double begin = phase;
+            phase = elapsed();
+            return phase - begin;
+        };
+
+        // the progress is polled after each of the four phases
+        auto cancelled = [&](unsigned int phase) {
+            return progress_ &&
+                   !progress_(float(4 * i + phase) / float(4 * iterations));
+        };
+
+        split_long_edges(stats);
 
         SurfaceNormals::compute_vertex_normals(mesh_);
+        stats.split_time = phase_time();
+        bool completed = !cancelled(1);
 
-        collapse_short_edges();
+        if (completed)
+        {
+            collapse_short_edges(stats);
+            stats.collapse_time = phase_time();
+            completed = !cancelled(2);
+        }
 
-        flip_edges();
+        if (completed)
+        {
+            flip_edges(stats);
+            stats.flip_time = phase_time();
+            completed = !cancelled(3);
+        }
 
-        tangential_smoothing(5);
+        if (completed)
+        {
+            tangential_smoothing(5);
+            stats.smooth_time = phase_time();
+            completed = !cancelled(4);
+        }
+
+        stats.outside_band = outside_band();
+        stats.elapsed = elapsed();
+        stats.peak_memory = memory.peak_extra();
+        statistics_.push_back(stats);
+        if (!completed)
+            return false;
+
+        // check stop criteria
+        const StopCriteria& stop = stop_criteria_;
+        if (stop.max_outside_band > 0 &&
+            stats.outside_band <= stop.max_outside_band)
+            break;
+
+        if (stats.n_splits + stats.n_collapses + stats.n_flips <
+            stop.min_operations)
+            break;
+
+        const double duration =
+            stats.elapsed - (i > 0 ? statistics_[i - 1].elapsed : 0.0);
+        if (stop.time_budget > 0 &&
+            stats.elapsed + duration > stop.time_budget)
+            break;
     }
 
-    remove_caps();
+    return true;
+}
+
+Scalar SurfaceRemeshing::outside_band() const
+{
+    if (!mesh_.n_edges())
+        return 0;
 
-    postprocessing();
+    size_t n = 0;
+    for (auto e : mesh_.edges())
+    {
+        const Vertex v0 = mesh_.vertex(e, 0);
+        const Vertex v1 = mesh_.vertex(e, 1);
+        if (is_too_long(v0, v1) || is_too_short(v0, v1))
+            ++n;
+    }
+    return Scalar(n) / mesh_.n_edges();
 }
 
 void SurfaceRemeshing::preprocessing()
 {
+    PMP_PROFILE_SCOPE("preprocessing");
+
     // properties
     vfeature_ = mesh_.vertex_property<bool>("v:feature", false);
     efeature_ = mesh_.edge_property<bool>("e:feature", false);
     vlocked_ = mesh_.add_vertex_property<bool>("v:locked", false);
     elocked_ = mesh_.add_edge_property<bool>("e:locked", false);
     vsizing_ = mesh_.add_vertex_property<Scalar>("v:sizing");
+    vvalence_ = mesh_.add_vertex_property<int>("v:valence");
+    for (auto v : mesh_.vertices())
+        vvalence_[v] = mesh_.valence(v);
 
     // lock unselected vertices if some vertices are selected
     auto vselected = mesh_.get_vertex_property<bool>("v:selected");
+    bool has_selection = false;
     if (vselected)
     {
-        bool has_selection = false;
         for (auto v : mesh_.vertices())
         {
             if (vselected[v])
@@ -144,6 +274,12 @@ void SurfaceRemeshing::preprocessing()
         }
     }
 
+    // restrict the reference to the selection and a halo around it
+    const bool localized = localized_ && has_selection;
+    std::vector<Vertex> ref_vertices;
+    if (localized && (use_projection_ || (!uniform_ && !sizing_)))
+        refmesh_ = region_mesh(ref_vertices);
+
     // compute sizing field
     if (uniform_)
     {
@@ -152,123 +288,268 @@ void SurfaceRemeshing::preprocessing()
             vsizing_[v] = target_edge_length_;
         }
     }
+    else if (sizing_)
+    {
+        for (auto v : mesh_.vertices())
+        {
+            vsizing_[v] = sizing_[v];
+        }
+    }
+    else if (localized)
+    {
+        auto sizing = refmesh_->vertex_property<Scalar>("v:sizing");
+        curvature_sizing(*refmesh_, sizing);
+
+        // vertices outside the region are never split or collapsed
+        for (auto v : mesh_.vertices())
+        {
+            vsizing_[v] = max_edge_length_;
+        }
+        for (auto v : refmesh_->vertices())
+        {
+            vsizing_[ref_vertices[v.idx()]] = sizing[v];
+        }
+    }
     else
     {
-        // compute curvature for all mesh vertices, using cotan or Cohen-Steiner
-        // don't use two-ring neighborhood, since we otherwise compute
-        // curvature over sharp features edges, leading to high curvatures.
-        // prefer tensor analysis over cotan-Laplace, since the former is more
-        // robust and gives better results on the boundary.
-        SurfaceCurvature curv(mesh_);
-        curv.analyze_tensor(1);
+        curvature_sizing(mesh_, vsizing_);
+    }
 
-        // use vsizing_ to store/smooth curvatures to avoid another vertex property
+    if (use_projection_)
+    {
+        // build reference mesh
+        if (!localized)
+        {
+            refmesh_ = new SurfaceMesh();
+            refmesh_->assign(mesh_);
+        }
+        SurfaceNormals::compute_vertex_normals(*refmesh_);
+        refpoints_ = refmesh_->vertex_property<Point>("v:point");
+        refnormals_ = refmesh_->vertex_property<Point>("v:normal");
 
-        // curvature values for feature vertices and boundary vertices
-        // are not meaningful. mark them as negative values.
-        for (auto v : mesh_.vertices())
+        // copy sizing field from mesh_
+        refsizing_ = refmesh_->vertex_property<Scalar>("v:sizing");
+        for (auto v : refmesh_->vertices())
         {
-            if (mesh_.is_boundary(v) || (vfeature_ && vfeature_[v]))
-                vsizing_[v] = -1.0;
-            else
-                vsizing_[v] = curv.max_abs_curvature(v);
+            refsizing_[v] = vsizing_[localized ? ref_vertices[v.idx()] : v];
         }
 
-        // curvature values might be noisy. smooth them.
-        // don't consider feature vertices' curvatures.
-        // don't consider boundary vertices' curvatures.
-        // do this for two iterations, to propagate curvatures
-        // from non-feature regions to feature vertices.
-        for (int iters = 0; iters < 2; ++iters)
+        // build bounding volume hierarchy
+        bvh_ = new TriangleBVH(*refmesh_);
+    }
+}
+
+void SurfaceRemeshing::compute_sizing_curvature(SurfaceMesh& mesh)
+{
+    PMP_PROFILE_SCOPE("SurfaceRemeshing::compute_sizing_curvature");
+
+    auto curvature = mesh.vertex_property<Scalar>("v:sizing_curvature");
+    smoothed_curvature(mesh, curvature);
+}
+
+void SurfaceRemeshing::smoothed_curvature(SurfaceMesh& mesh,
+                                          VertexProperty<Scalar> curvature)
+{
+    auto vfeature = mesh.get_vertex_property<bool>("v:feature");
+
+    // compute curvature for all mesh vertices, using cotan or Cohen-Steiner
+    // don't use two-ring neighborhood, since we otherwise compute
+    // curvature over sharp features edges, leading to high curvatures.
+    // prefer tensor analysis over cotan-Laplace, since the former is more
+    // robust and gives better results on the boundary. the curvature
+    // analysis shares the cotan weights of the cache.
+    GeometryCache cache(mesh);
+    cache.update();
+    SurfaceCurvature curv(mesh);
+    curv.analyze_tensor(1);
+
+    // curvature values for feature vertices and boundary vertices
+    // are not meaningful. mark them as negative values.
+    parallel_for(mesh.vertices(), [&](Vertex v) {
+        if (mesh.is_boundary(v) || (vfeature && vfeature[v]))
+            curvature[v] = -1.0;
+        else
+            curvature[v] = curv.max_abs_curvature(v);
+    });
+
+    // curvature values might be noisy. smooth them.
+    // don't consider feature vertices' curvatures.
+    // don't consider boundary vertices' curvatures.
+    // do this for two iterations, to propagate curvatures
+    // from non-feature regions to feature vertices.
+    // the smoothing is in place and thus stays sequential.
+    for (int iters = 0; iters < 2; ++iters)
+    {
+        for (auto v : mesh.vertices())
         {
-            for (auto v : mesh_.vertices())
-            {
-                Scalar w, ww = 0.0;
-                Scalar c, cc = 0.0;
+            Scalar w, ww = 0.0;
+            Scalar c, cc = 0.0;
 
-                for (auto h : mesh_.halfedges(v))
+            for (auto h : mesh.halfedges(v))
+            {
+                c = curvature[mesh.to_vertex(h)];
+                if (c > 0.0)
                 {
-                    c = vsizing_[mesh_.to_vertex(h)];
-                    if (c > 0.0)
-                    {
-                        w = std::max(0.0, cotan_weight(mesh_, mesh_.edge(h)));
-                        ww += w;
-                        cc += w * c;
-                    }
+                    w = std::max(0.0, cache.cotan_weight(mesh.edge(h)));
+                    ww += w;
+                    cc += w * c;
                 }
-
-                if (ww)
-                    cc /= ww;
-                vsizing_[v] = cc;
             }
+
+            if (ww)
+                cc /= ww;
+            curvature[v] = cc;
         }
+    }
+}
 
-        // now convert per-vertex curvature into target edge length
-        for (auto v : mesh_.vertices())
+void SurfaceRemeshing::curvature_sizing(SurfaceMesh& mesh,
+                                        VertexProperty<Scalar> sizing) const
+{
+    // use sizing to store the curvatures to avoid another vertex property
+    auto cached = mesh.get_vertex_property<Scalar>("v:sizing_curvature");
+    if (cached)
+        parallel_for(mesh.vertices(),
+                     [&](Vertex v) { sizing[v] = cached[v]; });
+    else
+        smoothed_curvature(mesh, sizing);
+
+    // now convert per-vertex curvature into target edge length
+    parallel_for(mesh.vertices(), [&](Vertex v) {
+        Scalar c = sizing[v];
+
+        // get edge length from curvature
+        const Scalar r = 1.0 / c;
+        const Scalar e = approx_error_;
+        Scalar h;
+        if (e < r)
         {
-            Scalar c = vsizing_[v];
+            // see mathworld: "circle segment" and "equilateral triangle"
+            //h = sqrt(2.0*r*e-e*e) * 3.0 / sqrt(3.0);
+            h = sqrt(6.0 * e * r - 3.0 * e * e); // simplified...
+        }
+        else
+        {
+            // this does not really make sense
+            h = e * 3.0 / sqrt(3.0);
+        }
 
-            // get edge length from curvature
-            const Scalar r = 1.0 / c;
-            const Scalar e = approx_error_;
-            Scalar h;
-            if (e < r)
-            {
-                // see mathworld: "circle segment" and "equilateral triangle"
-                //h = sqrt(2.0*r*e-e*e) * 3.0 / sqrt(3.0);
-                h = sqrt(6.0 * e * r - 3.0 * e * e); // simplified...
-            }
-            else
-            {
-                // this does not really make sense
-                h = e * 3.0 / sqrt(3.0);
-            }
+        // clamp to min. and max. edge length
+        if (h < min_edge_length_)
+            h = min_edge_length_;
+        else if (h > max_edge_length_)
+            h = max_edge_length_;
 
-            // clamp to min. and max. edge length
-            if (h < min_edge_length_)
-                h = min_edge_length_;
-            else if (h > max_edge_length_)
-                h = max_edge_length_;
+        // store target edge length
+        sizing[v] = h;
+    });
+}
+
+SurfaceMesh* SurfaceRemeshing::region_mesh(std::vector<Vertex>& vertices) const
+{
+    auto vselected = mesh_.get_vertex_property<bool>("v:selected");
 
-            // store target edge length
-            vsizing_[v] = h;
+    // breadth-first search from the selected vertices up to the halo
+    std::vector<unsigned int> dist(mesh_.vertices_size(),
+                                   std::numeric_limits<unsigned int>::max());
+    std::vector<Vertex> region;
+    for (auto v : mesh_.vertices())
+    {
+        if (vselected[v])
+        {
+            dist[v.idx()] = 0;
+            region.push_back(v);
         }
     }
-
-    if (use_projection_)
+    for (size_t i = 0; i < region.size(); ++i)
     {
-        // build reference mesh
-        refmesh_ = new SurfaceMesh();
-        refmesh_->assign(mesh_);
-        SurfaceNormals::compute_vertex_normals(*refmesh_);
-        refpoints_ = refmesh_->vertex_property<Point>("v:point");
-        refnormals_ = refmesh_->vertex_property<Point>("v:normal");
+        const Vertex v = region[i];
+        if (dist[v.idx()] == halo_)
+            continue;
 
-        // copy sizing field from mesh_
-        refsizing_ = refmesh_->add_vertex_property<Scalar>("v:sizing");
-        for (auto v : refmesh_->vertices())
+        for (auto vv : mesh_.vertices(v))
         {
-            refsizing_[v] = vsizing_[v];
+            if (dist[vv.idx()] > dist[v.idx()] + 1)
+            {
+                dist[vv.idx()] = dist[v.idx()] + 1;
+                region.push_back(vv);
+            }
+        }
+    }
+
+    // copy all faces incident to the region
+    auto* mesh = new SurfaceMesh();
+    IndexedFaces faces;
+    std::vector<bool> copied(mesh_.faces_size(), false);
+    std::vector<IndexType> index(mesh_.vertices_size(), PMP_MAX_INDEX);
+    vertices.clear();
+    for (auto v : region)
+    {
+        for (auto f : mesh_.faces(v))
+        {
+            if (copied[f.idx()])
+                continue;
+            copied[f.idx()] = true;
+
+            for (auto fv : mesh_.vertices(f))
+            {
+                if (index[fv.idx()] == PMP_MAX_INDEX)
+                {
+                    index[fv.idx()] = IndexType(vertices.size());
+                    vertices.push_back(fv);
+                    mesh->add_vertex(points_[fv]);
+                }
+                faces.indices.push_back(index[fv.idx()]);
+            }
         }
+    }
 
-        // build kd-tree
-        kd_tree_ = new TriangleKdTree(*refmesh_, 0);
+    // the faces of the region are not necessarily manifold at its border
+    std::vector<IndexType> origin;
+    SurfaceMeshIO::add_faces(*mesh, faces, &origin);
+    std::vector<Vertex> mapped(origin.size());
+    for (size_t i = 0; i < origin.size(); ++i)
+        mapped[i] = vertices[origin[i]];
+    vertices.swap(mapped);
+
+    // copy feature vertices for the curvature analysis
+    auto vfeature = mesh->vertex_property<bool>("v:feature", false);
+    for (auto v : mesh->vertices())
+        vfeature[v] = vfeature_[vertices[v.idx()]];
+
+    // and the curvature if it was computed in advance
+    auto cached = mesh_.get_vertex_property<Scalar>("v:sizing_curvature");
+    if (cached)
+    {
+        auto curvature = mesh->vertex_property<Scalar>("v:sizing_curvature");
+        for (auto v : mesh->vertices())
+            curvature[v] = cached[vertices[v.idx()]];
     }
+
+    return mesh;
 }
 
 void SurfaceRemeshing::postprocessing()
 {
-    // delete kd-tree and reference mesh
-    if (use_projection_)
-    {
-        delete kd_tree_;
-        delete refmesh_;
-    }
+    PMP_PROFILE_SCOPE("postprocessing");
+
+    // delete bounding volume hierarchy and reference mesh
+    delete bvh_;
+    delete refmesh_;
+    bvh_ = nullptr;
+    refmesh_ = nullptr;
 
     // remove properties
     mesh_.remove_vertex_property(vlocked_);
     mesh_.remove_edge_property(elocked_);
     mesh_.remove_vertex_property(vsizing_);
+    mesh_.remove_vertex_property(vvalence_);
+
+    // the sizing field and the curvature belong to the input
+    sizing_ = VertexProperty<Scalar>();
+    auto cached = mesh_.get_vertex_property<Scalar>("v:sizing_curvature");
+    if (cached)
+        mesh_.remove_vertex_property(cached);
 }
 
 void SurfaceRemeshing::project_to_reference(Vertex v)
@@ -279,7 +560,12 @@ void SurfaceRemeshing::project_to_reference(Vertex v)
     }
 
     // find closest triangle of reference mesh
-    TriangleKdTree::NearestNeighbor nn = kd_tree_->nearest(points_[v]);
+    project_to_reference(v, bvh_->nearest(points_[v]));
+}
+
+void SurfaceRemeshing::project_to_reference(
+    Vertex v, const TriangleBVH::NearestNeighbor& nn)
+{
     const Point p = nn.nearest;
     const Face f = nn.face;
 
@@ -320,64 +606,168 @@ void SurfaceRemeshing::project_to_reference(Vertex v)
     vsizing_[v] = s;
 }
 
-void SurfaceRemeshing::split_long_edges()
+void SurfaceRemeshing::project_to_reference()
 {
-    Vertex vnew, v0, v1;
-    Edge enew, e0, e1;
-    Face f0, f1, f2, f3;
-    bool ok, is_feature, is_boundary;
-    int i;
+    PMP_PROFILE_SCOPE("project");
 
-    for (ok = false, i = 0; !ok && i < 10; ++i)
+    if (!use_projection_)
     {
-        ok = true;
+        return;
+    }
 
-        for (auto e : mesh_.edges())
+    std::vector<Vertex> vertices;
+    std::vector<Point> points;
+    for (auto v : mesh_.vertices())
+    {
+        if (!mesh_.is_boundary(v) && !vlocked_[v])
         {
-            v0 = mesh_.vertex(e, 0);
-            v1 = mesh_.vertex(e, 1);
+            vertices.push_back(v);
+            points.push_back(points_[v]);
+        }
+    }
+
+    // find closest triangles of reference mesh
+    std::vector<TriangleBVH::NearestNeighbor> nn;
+    bvh_->nearest(points, nn);
+
+    parallel_for(
+        0, int(vertices.size()),
+        [&](int i) { project_to_reference(vertices[i], nn[i]); }, 256);
+}
 
+void SurfaceRemeshing::split_long_edges(IterationStatistics& stats)
+{
+    PMP_PROFILE_SCOPE("split");
+
+    if (use_worklist_)
+    {
+        // the longest edges relative to their sizing first
+        std::priority_queue<std::pair<Scalar, IndexType>> queue;
+        auto enqueue = [&](Edge e) {
+            const Vertex v0 = mesh_.vertex(e, 0);
+            const Vertex v1 = mesh_.vertex(e, 1);
             if (!elocked_[e] && is_too_long(v0, v1))
-            {
-                const Point& p0 = points_[v0];
-                const Point& p1 = points_[v1];
+                queue.emplace(relative_length(v0, v1), e.idx());
+        };
 
-                is_feature = efeature_[e];
-                is_boundary = mesh_.is_boundary(e);
+        for (auto e : mesh_.edges())
+            enqueue(e);
 
-                vnew = mesh_.add_vertex((p0 + p1) * 0.5f);
-                mesh_.split(e, vnew);
+        while (!queue.empty())
+        {
+            const Edge e(queue.top().second);
+            queue.pop();
+
+            // only the edges around the new vertex changed, and each of
+            // them is new or was just taken from the queue
+            const Vertex vnew = split_edge(e, stats);
+            for (auto h : mesh_.halfedges(vnew))
+                enqueue(mesh_.edge(h));
+        }
+        return;
+    }
 
-                // need normal or sizing for adaptive refinement
-                vnormal_[vnew] =
-                    SurfaceNormals::compute_vertex_normal(mesh_, vnew);
-                vsizing_[vnew] = 0.5f * (vsizing_[v0] + vsizing_[v1]);
+    bool ok;
+    int i;
 
-                if (is_feature)
-                {
-                    enew = is_boundary ? Edge(mesh_.n_edges() - 2)
-                                       : Edge(mesh_.n_edges() - 3);
-                    efeature_[enew] = true;
-                    vfeature_[vnew] = true;
-                }
-                else
-                {
-                    project_to_reference(vnew);
-                }
+    for (ok = false, i = 0; !ok && i < 10; ++i)
+    {
+        ok = true;
 
+        for (auto e : mesh_.edges())
+        {
+            if (!elocked_[e] &&
+                is_too_long(mesh_.vertex(e, 0), mesh_.vertex(e, 1)))
+            {
+                split_edge(e, stats);
                 ok = false;
             }
         }
     }
 }
 
-void SurfaceRemeshing::collapse_short_edges()
+Vertex SurfaceRemeshing::split_edge(Edge e, IterationStatistics& stats)
 {
-    Vertex v0, v1;
-    Halfedge h0, h1, h01, h10;
-    bool ok, b0, b1, l0, l1, f0, f1;
+    const Vertex v0 = mesh_.vertex(e, 0);
+    const Vertex v1 = mesh_.vertex(e, 1);
+    const Point& p0 = points_[v0];
+    const Point& p1 = points_[v1];
+
+    const bool is_feature = efeature_[e];
+    const bool is_boundary = mesh_.is_boundary(e);
+
+    const Vertex vnew = mesh_.add_vertex((p0 + p1) * 0.5f);
+    mesh_.split(e, vnew);
+
+    // need normal or sizing for adaptive refinement
+    vnormal_[vnew] = SurfaceNormals::compute_vertex_normal(mesh_, vnew);
+    vsizing_[vnew] = 0.5f * (vsizing_[v0] + vsizing_[v1]);
+
+    // the opposite vertices gain the new vertex as neighbor
+    vvalence_[vnew] = mesh_.valence(vnew);
+    for (auto vv : mesh_.vertices(vnew))
+        if (vv != v0 && vv != v1)
+            ++vvalence_[vv];
+
+    if (is_feature)
+    {
+        const Edge enew = is_boundary ? Edge(mesh_.n_edges() - 2)
+                                      : Edge(mesh_.n_edges() - 3);
+        efeature_[enew] = true;
+        vfeature_[vnew] = true;
+    }
+    else
+    {
+        project_to_reference(vnew);
+    }
+
+    ++stats.n_splits;
+    return vnew;
+}
+
+void SurfaceRemeshing::collapse_short_edges(IterationStatistics& stats)
+{
+    PMP_PROFILE_SCOPE("collapse");
+
+    if (use_worklist_)
+    {
+        // the shortest edges relative to their sizing first
+        typedef std::pair<Scalar, IndexType> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+            queue;
+        auto enqueue = [&](Edge e) {
+            const Vertex v0 = mesh_.vertex(e, 0);
+            const Vertex v1 = mesh_.vertex(e, 1);
+            if (!elocked_[e] && is_too_short(v0, v1))
+                queue.emplace(relative_length(v0, v1), e.idx());
+        };
+
+        for (auto e : mesh_.edges())
+            enqueue(e);
+
+        while (!queue.empty())
+        {
+            const Edge e(queue.top().second);
+            queue.pop();
+
+            // the edge may have been removed or changed since it was queued
+            if (mesh_.is_deleted(e) || elocked_[e] ||
+                !is_too_short(mesh_.vertex(e, 0), mesh_.vertex(e, 1)))
+                continue;
+
+            // only the edges around the remaining vertex changed
+            const Vertex v = collapse_edge(e, stats);
+            if (v.is_valid())
+                for (auto h : mesh_.halfedges(v))
+                    enqueue(mesh_.edge(h));
+        }
+
+        mesh_.garbage_collection();
+        return;
+    }
+
+    bool ok;
     int i;
-    bool hcol01, hcol10;
 
     for (ok = false, i = 0; !ok && i < 10; ++i)
     {
@@ -385,333 +775,416 @@ void SurfaceRemeshing::collapse_short_edges()
 
         for (auto e : mesh_.edges())
         {
-            if (!mesh_.is_deleted(e) && !elocked_[e])
-            {
-                h10 = mesh_.halfedge(e, 0);
-                h01 = mesh_.halfedge(e, 1);
-                v0 = mesh_.to_vertex(h10);
-                v1 = mesh_.to_vertex(h01);
+            if (!mesh_.is_deleted(e) && !elocked_[e] &&
+                is_too_short(mesh_.vertex(e, 0), mesh_.vertex(e, 1)) &&
+                collapse_edge(e, stats).is_valid())
+                ok = false;
+        }
+    }
 
-                if (is_too_short(v0, v1))
-                {
-                    // get status
-                    b0 = mesh_.is_boundary(v0);
-                    b1 = mesh_.is_boundary(v1);
-                    l0 = vlocked_[v0];
-                    l1 = vlocked_[v1];
-                    f0 = vfeature_[v0];
-                    f1 = vfeature_[v1];
-                    hcol01 = hcol10 = true;
-
-                    // boundary rules
-                    if (b0 && b1)
-                    {
-                        if (!mesh_.is_boundary(e))
-                            continue;
-                    }
-                    else if (b0)
-                        hcol01 = false;
-                    else if (b1)
-                        hcol10 = false;
-
-                    // locked rules
-                    if (l0 && l1)
-                        continue;
-                    else if (l0)
-                        hcol01 = false;
-                    else if (l1)
-                        hcol10 = false;
-
-                    // feature rules
-                    if (f0 && f1)
-                    {
-                        // edge must be feature
-                        if (!efeature_[e])
-                            continue;
-
-                        // the other two edges removed by collapse must not be features
-                        h0 = mesh_.prev_halfedge(h01);
-                        h1 = mesh_.next_halfedge(h10);
-                        if (efeature_[mesh_.edge(h0)] ||
-                            efeature_[mesh_.edge(h1)])
-                            hcol01 = false;
-                        // the other two edges removed by collapse must not be features
-                        h0 = mesh_.prev_halfedge(h10);
-                        h1 = mesh_.next_halfedge(h01);
-                        if (efeature_[mesh_.edge(h0)] ||
-                            efeature_[mesh_.edge(h1)])
-                            hcol10 = false;
-                    }
-                    else if (f0)
-                        hcol01 = false;
-                    else if (f1)
-                        hcol10 = false;
+    mesh_.garbage_collection();
+}
+
+Vertex SurfaceRemeshing::collapse_edge(Edge e, IterationStatistics& stats)
+{
+    const Halfedge h10 = mesh_.halfedge(e, 0);
+    const Halfedge h01 = mesh_.halfedge(e, 1);
+    const Vertex v0 = mesh_.to_vertex(h10);
+    const Vertex v1 = mesh_.to_vertex(h01);
+    Halfedge h0, h1;
+    bool b0, b1, l0, l1, f0, f1;
+    bool hcol01, hcol10;
 
-                    // topological rules
-                    bool collapse_ok = mesh_.is_collapse_ok(h01);
+    // get status
+    b0 = mesh_.is_boundary(v0);
+    b1 = mesh_.is_boundary(v1);
+    l0 = vlocked_[v0];
+    l1 = vlocked_[v1];
+    f0 = vfeature_[v0];
+    f1 = vfeature_[v1];
+    hcol01 = hcol10 = true;
+
+    // boundary rules
+    if (b0 && b1)
+    {
+        if (!mesh_.is_boundary(e))
+        {
+            ++stats.n_rejected_collapses;
+            return Vertex();
+        }
+    }
+    else if (b0)
+        hcol01 = false;
+    else if (b1)
+        hcol10 = false;
 
-                    if (hcol01)
-                        hcol01 = collapse_ok;
-                    if (hcol10)
-                        hcol10 = collapse_ok;
+    // locked rules
+    if (l0 && l1)
+    {
+        ++stats.n_rejected_collapses;
+        return Vertex();
+    }
+    else if (l0)
+        hcol01 = false;
+    else if (l1)
+        hcol10 = false;
 
-                    // both collapses possible: collapse into vertex w/ higher valence
-                    if (hcol01 && hcol10)
-                    {
-                        if (mesh_.valence(v0) < mesh_.valence(v1))
-                            hcol10 = false;
-                        else
-                            hcol01 = false;
-                    }
+    // feature rules
+    if (f0 && f1)
+    {
+        // edge must be feature
+        if (!efeature_[e])
+        {
+            ++stats.n_rejected_collapses;
+            return Vertex();
+        }
 
-                    // try v1 -> v0
-                    if (hcol10)
-                    {
-                        // don't create too long edges
-                        for (auto vv : mesh_.vertices(v1))
-                        {
-                            if (is_too_long(v0, vv))
-                            {
-                                hcol10 = false;
-                                break;
-                            }
-                        }
+        // the other two edges removed by collapse must not be features
+        h0 = mesh_.prev_halfedge(h01);
+        h1 = mesh_.next_halfedge(h10);
+        if (efeature_[mesh_.edge(h0)] || efeature_[mesh_.edge(h1)])
+            hcol01 = false;
+        // the other two edges removed by collapse must not be features
+        h0 = mesh_.prev_halfedge(h10);
+        h1 = mesh_.next_halfedge(h01);
+        if (efeature_[mesh_.edge(h0)] || efeature_[mesh_.edge(h1)])
+            hcol10 = false;
+    }
+    else if (f0)
+        hcol01 = false;
+    else if (f1)
+        hcol10 = false;
 
-                        if (hcol10)
-                        {
-                            mesh_.collapse(h10);
-                            ok = false;
-                        }
-                    }
+    // topological rules
+    bool collapse_ok = mesh_.is_collapse_ok(h01);
 
-                    // try v0 -> v1
-                    else if (hcol01)
-                    {
-                        // don't create too long edges
-                        for (auto vv : mesh_.vertices(v0))
-                        {
-                            if (is_too_long(v1, vv))
-                            {
-                                hcol01 = false;
-                                break;
-                            }
-                        }
+    if (hcol01)
+        hcol01 = collapse_ok;
+    if (hcol10)
+        hcol10 = collapse_ok;
 
-                        if (hcol01)
-                        {
-                            mesh_.collapse(h01);
-                            ok = false;
-                        }
-                    }
-                }
+    // both collapses possible: collapse into vertex w/ higher valence
+    if (hcol01 && hcol10)
+    {
+        if (mesh_.valence(v0) < mesh_.valence(v1))
+            hcol10 = false;
+        else
+            hcol01 = false;
+    }
+
+    // try v1 -> v0
+    if (hcol10)
+    {
+        // don't create too long edges
+        for (auto vv : mesh_.vertices(v1))
+        {
+            if (is_too_long(v0, vv))
+            {
+                hcol10 = false;
+                break;
             }
         }
+
+        if (hcol10)
+        {
+            mesh_.collapse(h10);
+            update_valences(v0);
+            ++stats.n_collapses;
+            return v0;
+        }
     }
 
-    mesh_.garbage_collection();
+    // try v0 -> v1
+    else if (hcol01)
+    {
+        // don't create too long edges
+        for (auto vv : mesh_.vertices(v0))
+        {
+            if (is_too_long(v1, vv))
+            {
+                hcol01 = false;
+                break;
+            }
+        }
+
+        if (hcol01)
+        {
+            mesh_.collapse(h01);
+            update_valences(v1);
+            ++stats.n_collapses;
+            return v1;
+        }
+    }
+
+
+    ++stats.n_rejected_collapses;
+    return Vertex();
 }
 
-void SurfaceRemeshing::flip_edges()
+void SurfaceRemeshing::flip_edges(IterationStatistics& stats)
 {
-    Vertex v0, v1, v2, v3;
-    Halfedge h;
-    int val0, val1, val2, val3;
-    int val_opt0, val_opt1, val_opt2, val_opt3;
-    int ve0, ve1, ve2, ve3, ve_before, ve_after;
-    bool ok;
-    int i;
+    PMP_PROFILE_SCOPE("flip");
 
-    // precompute valences
-    VertexProperty<int> valence = mesh_.add_vertex_property<int>("valence");
-    for (auto v : mesh_.vertices())
+    if (!use_worklist_)
     {
-        valence[v] = mesh_.valence(v);
-    }
+        // an edge is only evaluated again if the valence of one of its
+        // vertices changed since, which keeps the result of full sweeps
+        std::vector<unsigned int> vchanged(mesh_.vertices_size(), 0);
+        std::vector<unsigned int> echecked(mesh_.edges_size(), 0);
+        unsigned int n_changes = 0;
+        bool ok;
+        int i;
+
+        for (ok = false, i = 0; !ok && i < 10; ++i)
+        {
+            ok = true;
 
-    for (ok = false, i = 0; !ok && i < 10; ++i)
-    {
-        ok = true;
+            for (auto e : mesh_.edges())
+            {
+                const Halfedge h0 = mesh_.halfedge(e, 0);
+                const Halfedge h1 = mesh_.halfedge(e, 1);
+                const Vertex v0 = mesh_.to_vertex(h0);
+                const Vertex v1 = mesh_.to_vertex(h1);
+                const Vertex v2 = mesh_.to_vertex(mesh_.next_halfedge(h0));
+                const Vertex v3 = mesh_.to_vertex(mesh_.next_halfedge(h1));
+
+                const unsigned int checked = echecked[e.idx()];
+                if (i > 0 && vchanged[v0.idx()] <= checked &&
+                    vchanged[v1.idx()] <= checked &&
+                    vchanged[v2.idx()] <= checked &&
+                    vchanged[v3.idx()] <= checked)
+                    continue;
+                echecked[e.idx()] = n_changes;
 
-        for (auto e : mesh_.edges())
+                if (flip_gain(e) <= 0)
+                    continue;
+                if (!mesh_.is_flip_ok(e))
+                {
+                    ++stats.n_rejected_flips;
+                    continue;
+                }
+
+                mesh_.flip(e);
+                --vvalence_[v0];
+                --vvalence_[v1];
+                ++vvalence_[v2];
+                ++vvalence_[v3];
+                ++n_changes;
+                vchanged[v0.idx()] = vchanged[v1.idx()] = n_changes;
+                vchanged[v2.idx()] = vchanged[v3.idx()] = n_changes;
+                ++stats.n_flips;
+                ok = false;
+            }
+        }
+        return;
+    }
+
+    IndependentSetScheduler scheduler(mesh_);
+    auto region = [&](Edge e, std::vector<Vertex>& vertices) {
+        IndependentSetScheduler::edge_region(mesh_, e, vertices);
+    };
+
+    // flips in the same batch touch different vertices and edges
+    std::vector<char> dirty(mesh_.vertices_size(), 0);
+    std::vector<char> rejected(mesh_.edges_size(), 0);
+    auto apply = [&](Edge e) {
+        // an earlier batch may have changed the valences
+        if (flip_gain(e) <= 0)
+            return false;
+        if (!mesh_.is_flip_ok(e))
         {
-            if (!elocked_[e] && !efeature_[e])
-            {
-                h = mesh_.halfedge(e, 0);
-                v0 = mesh_.to_vertex(h);
-                v2 = mesh_.to_vertex(mesh_.next_halfedge(h));
-                h = mesh_.halfedge(e, 1);
-                v1 = mesh_.to_vertex(h);
-                v3 = mesh_.to_vertex(mesh_.next_halfedge(h));
-
-                if (!vlocked_[v0] && !vlocked_[v1] && !vlocked_[v2] &&
-                    !vlocked_[v3])
+            rejected[e.idx()] = 1;
+            return false;
+        }
+
+        const Halfedge h0 = mesh_.halfedge(e, 0);
+        const Halfedge h1 = mesh_.halfedge(e, 1);
+        const Vertex v0 = mesh_.to_vertex(h0);
+        const Vertex v1 = mesh_.to_vertex(h1);
+        const Vertex v2 = mesh_.to_vertex(mesh_.next_halfedge(h0));
+        const Vertex v3 = mesh_.to_vertex(mesh_.next_halfedge(h1));
+        mesh_.flip(e);
+        --vvalence_[v0];
+        --vvalence_[v1];
+        ++vvalence_[v2];
+        ++vvalence_[v3];
+        dirty[v0.idx()] = dirty[v1.idx()] = 1;
+        dirty[v2.idx()] = dirty[v3.idx()] = 1;
+        return true;
+    };
+
+    // all edges are evaluated first, then only the ones around vertices
+    // whose valence changed
+    std::vector<Edge> edges, candidates;
+    edges.reserve(mesh_.n_edges());
+    for (auto e : mesh_.edges())
+        edges.push_back(e);
+    std::vector<int> gain;
+    std::vector<char> queued(mesh_.edges_size(), 0);
+    for (int i = 0; i < 10 && !edges.empty(); ++i)
+    {
+        gain.resize(edges.size());
+        parallel_for(
+            0, int(edges.size()), [&](int j) { gain[j] = flip_gain(edges[j]); },
+            256);
+
+        candidates.clear();
+        for (size_t j = 0; j < edges.size(); ++j)
+            if (gain[j] > 0)
+                candidates.push_back(edges[j]);
+
+        std::fill(dirty.begin(), dirty.end(), 0);
+        const size_t n_flips = scheduler.run(candidates, region, apply);
+        stats.n_flips += (unsigned int)n_flips;
+        if (n_flips == 0)
+            break;
+
+        edges.clear();
+        std::fill(queued.begin(), queued.end(), 0);
+        for (auto v : mesh_.vertices())
+            if (dirty[v.idx()])
+                for (auto h : mesh_.halfedges(v))
                 {
-                    val0 = valence[v0];
-                    val1 = valence[v1];
-                    val2 = valence[v2];
-                    val3 = valence[v3];
-
-                    val_opt0 = (mesh_.is_boundary(v0) ? 4 : 6);
-                    val_opt1 = (mesh_.is_boundary(v1) ? 4 : 6);
-                    val_opt2 = (mesh_.is_boundary(v2) ? 4 : 6);
-                    val_opt3 = (mesh_.is_boundary(v3) ? 4 : 6);
-
-                    ve0 = (val0 - val_opt0);
-                    ve1 = (val1 - val_opt1);
-                    ve2 = (val2 - val_opt2);
-                    ve3 = (val3 - val_opt3);
-
-                    ve0 *= ve0;
-                    ve1 *= ve1;
-                    ve2 *= ve2;
-                    ve3 *= ve3;
-
-                    ve_before = ve0 + ve1 + ve2 + ve3;
-
-                    --val0;
-                    --val1;
-                    ++val2;
-                    ++val3;
-
-                    ve0 = (val0 - val_opt0);
-                    ve1 = (val1 - val_opt1);
-                    ve2 = (val2 - val_opt2);
-                    ve3 = (val3 - val_opt3);
-
-                    ve0 *= ve0;
-                    ve1 *= ve1;
-                    ve2 *= ve2;
-                    ve3 *= ve3;
-
-                    ve_after = ve0 + ve1 + ve2 + ve3;
-
-                    if (ve_before > ve_after && mesh_.is_flip_ok(e))
+                    const Edge e = mesh_.edge(h);
+                    if (!queued[e.idx()])
                     {
-                        mesh_.flip(e);
-                        --valence[v0];
-                        --valence[v1];
-                        ++valence[v2];
-                        ++valence[v3];
-                        ok = false;
+                        queued[e.idx()] = 1;
+                        edges.push_back(e);
                     }
                 }
-            }
-        }
     }
 
-    mesh_.remove_vertex_property(valence);
+    for (auto r : rejected)
+        stats.n_rejected_flips += r;
+}
+
+int SurfaceRemeshing::flip_gain(Edge e) const
+{
+    if (elocked_[e] || efeature_[e])
+        return 0;
+
+    Halfedge h = mesh_.halfedge(e, 0);
+    const Vertex v0 = mesh_.to_vertex(h);
+    const Vertex v2 = mesh_.to_vertex(mesh_.next_halfedge(h));
+    h = mesh_.halfedge(e, 1);
+    const Vertex v1 = mesh_.to_vertex(h);
+    const Vertex v3 = mesh_.to_vertex(mesh_.next_halfedge(h));
+
+    if (vlocked_[v0] || vlocked_[v1] || vlocked_[v2] || vlocked_[v3])
+        return 0;
+
+    // squared deviation from the optimal valence before and after the flip
+    auto deviation = [&](Vertex v, int change) {
+        const int d =
+            vvalence_[v] + change - (mesh_.is_boundary(v) ? 4 : 6);
+        return d * d;
+    };
+    const int before = deviation(v0, 0) + deviation(v1, 0) +
+                       deviation(v2, 0) + deviation(v3, 0);
+    const int after = deviation(v0, -1) + deviation(v1, -1) +
+                      deviation(v2, 1) + deviation(v3, 1);
+    return before - after;
+}
+
+void SurfaceRemeshing::update_valences(Vertex v)
+{
+    vvalence_[v] = mesh_.valence(v);
+    for (auto vv : mesh_.vertices(v))
+        vvalence_[vv] = mesh_.valence(vv);
 }
 
 void SurfaceRemeshing::tangential_smoothing(unsigned int iterations)
 {
-    Vertex v1, v2, v3, vv;
-    Edge e;
-    Scalar w, ww;
-    Point u, n, t, b;
+    PMP_PROFILE_SCOPE("smooth");
 
     // add property
     VertexProperty<Point> update = mesh_.add_vertex_property<Point>("v:update");
 
     // project at the beginning to get valid sizing values and normal vectors
     // for vertices introduced by splitting
-    if (use_projection_)
-    {
-        for (auto v : mesh_.vertices())
-        {
-            if (!mesh_.is_boundary(v) && !vlocked_[v])
-            {
-                project_to_reference(v);
-            }
-        }
-    }
+    project_to_reference();
+
+    // the connectivity does not change while smoothing
+    const SurfaceAdjacency adjacency(mesh_);
 
     for (unsigned int iters = 0; iters < iterations; ++iters)
     {
-        for (auto v : mesh_.vertices())
-        {
-            if (!mesh_.is_boundary(v) && !vlocked_[v])
+        // compute all updates from the previous positions in parallel, such
+        // that the result does not depend on the number of threads
+        parallel_for(mesh_.vertices(), [&](Vertex v) {
+            if (mesh_.is_boundary(v) || vlocked_[v])
+                return;
+
+            if (vfeature_[v])
             {
-                if (vfeature_[v])
-                {
-                    u = Point(0.0);
-                    t = Point(0.0);
-                    ww = 0;
-                    int c = 0;
+                Point u(0.0), t(0.0);
+                Scalar ww = 0;
+                int c = 0;
 
-                    for (auto h : mesh_.halfedges(v))
+                for (auto h : mesh_.halfedges(v))
+                {
+                    if (efeature_[mesh_.edge(h)])
                     {
-                        if (efeature_[mesh_.edge(h)])
+                        const Vertex vv = mesh_.to_vertex(h);
+
+                        Point b = points_[v];
+                        b += points_[vv];
+                        b *= 0.5;
+
+                        const Scalar w =
+                            distance(points_[v], points_[vv]) /
+                            (0.5 * (vsizing_[v] + vsizing_[vv]));
+                        ww += w;
+                        u += w * b;
+
+                        if (c == 0)
+                        {
+                            t += normalize(points_[vv] - points_[v]);
+                            ++c;
+                        }
+                        else
                         {
-                            vv = mesh_.to_vertex(h);
-
-                            b = points_[v];
-                            b += points_[vv];
-                            b *= 0.5;
-
-                            w = distance(points_[v], points_[vv]) /
-                                (0.5 * (vsizing_[v] + vsizing_[vv]));
-                            ww += w;
-                            u += w * b;
-
-                            if (c == 0)
-                            {
-                                t += normalize(points_[vv] - points_[v]);
-                                ++c;
-                            }
-                            else
-                            {
-                                ++c;
-                                t -= normalize(points_[vv] - points_[v]);
-                            }
+                            ++c;
+                            t -= normalize(points_[vv] - points_[v]);
                         }
                     }
+                }
 
-                    assert(c == 2);
+                assert(c == 2);
 
-                    u *= (1.0 / ww);
-                    u -= points_[v];
-                    t = normalize(t);
-                    u = t * dot(u, t);
+                u *= (1.0 / ww);
+                u -= points_[v];
+                t = normalize(t);
+                u = t * dot(u, t);
 
-                    update[v] = u;
-                }
-                else
-                {
-                    Point p = minimize_squared_areas(v);
-                    u = p - mesh_.position(v);
+                update[v] = u;
+            }
+            else
+            {
+                Point p = minimize_squared_areas(v);
+                Point u = p - mesh_.position(v);
 
-                    n = vnormal_[v];
-                    u -= n * dot(u, n);
+                const Point n = vnormal_[v];
+                u -= n * dot(u, n);
 
-                    update[v] = u;
-                }
+                update[v] = u;
             }
-        }
+        });
 
         // update vertex positions
-        for (auto v : mesh_.vertices())
-        {
+        parallel_for(mesh_.vertices(), [&](Vertex v) {
             if (!mesh_.is_boundary(v) && !vlocked_[v])
             {
                 points_[v] += update[v];
             }
-        }
+        });
 
         // update normal vectors (if not done so through projection)
-        SurfaceNormals::compute_vertex_normals(mesh_);
+        SurfaceNormals::compute_vertex_normals(mesh_, adjacency);
     }
 
     // project at the end
-    if (use_projection_)
-    {
-        for (auto v : mesh_.vertices())
-        {
-            if (!mesh_.is_boundary(v) && !vlocked_[v])
-            {
-                project_to_reference(v);
-            }
-        }
-    }
+    project_to_reference();
 
     // remove property
     mesh_.remove_vertex_property(update);
@@ -719,6 +1192,8 @@ void SurfaceRemeshing::tangential_smoothing(unsigned int iterations)
 
 void SurfaceRemeshing::remove_caps()
 {
+    PMP_PROFILE_SCOPE("remove_caps");
+
     Halfedge h;
     Vertex v, vb, vd;
     Face fb, fd;
@@ -3,12 +3,13 @@
 
 #pragma once
 
+#include <vector>
+
 #include "pmp/SurfaceMesh.h"
+#include "pmp/algorithms/TriangleBVH.h"
 
 namespace pmp {
 
-class TriangleKdTree;
-
 //! \brief A class for uniform and adaptive surface remeshing.
 //! \details The algorithm implemented here performs incremental remeshing based
 //! on edge collapse, split, flip, and tangential relaxation.
@@ -26,10 +27,113 @@ public:
     // destructor
     ~SurfaceRemeshing();
 
+    //! \brief Conditions to stop remeshing before the given number of
+    //! iterations.
+    //! \details Checked after each iteration. A zero disables a condition.
+    struct StopCriteria
+    {
+        //! \brief Stop once at most this fraction of the edges is outside the
+        //! band [4/5, 4/3] of the target edge length.
+        Scalar max_outside_band = 0;
+
+        //! \brief Stop once an iteration performs fewer than this number of
+        //! splits, collapses, and flips in total.
+        unsigned int min_operations = 0;
+
+        //! \brief Wall-clock budget in milliseconds for the iterations.
+        //! \details Stop if the next iteration would exceed the budget,
+        //! assuming it takes as long as the last one. Building the reference
+        //! for the projection before the first iteration is not included.
+        double time_budget = 0;
+    };
+
+    //! statistics of one remeshing iteration
+    struct IterationStatistics
+    {
+        unsigned int n_splits = 0;    //!< number of edge splits
+        unsigned int n_collapses = 0; //!< number of edge collapses
+        unsigned int n_flips = 0;     //!< number of edge flips
+
+        //! too short edges not collapsed, e.g., due to features, locked
+        //! vertices, topology, or too long resulting edges
+        unsigned int n_rejected_collapses = 0;
+
+        //! flips improving the valences rejected by the topology check
+        unsigned int n_rejected_flips = 0;
+
+        double split_time = 0;    //!< time of the splits in milliseconds
+        double collapse_time = 0; //!< time of the collapses in milliseconds
+        double flip_time = 0;     //!< time of the flips in milliseconds
+        double smooth_time = 0;   //!< time of the smoothing in milliseconds
+
+        //! fraction of edges outside the target band after the iteration
+        Scalar outside_band = 0;
+
+        //! wall-clock time in milliseconds since the first iteration started
+        double elapsed = 0;
+
+        //! peak memory of the iteration in addition to the memory in use
+        //! when it started, in bytes, see MemoryScope
+        size_t peak_memory = 0;
+    };
+
+    //! Set the conditions for stopping early, used by subsequent calls.
+    void set_stop_criteria(const StopCriteria& criteria)
+    {
+        stop_criteria_ = criteria;
+    }
+
+    //! \brief Restrict the reference surface to the selected region.
+    //! \details If vertices are selected by the `v:selected` property, only
+    //! they are remeshed. In localized mode, the curvature analysis of
+    //! adaptive remeshing and the reference surface used for the projection
+    //! are also restricted to the selection and \p halo rings of vertices
+    //! around it, so their cost scales with the region instead of the whole
+    //! mesh. Uniform remeshing gives the same result as without localized
+    //! mode. The curvature-based sizing of adaptive remeshing is smoothed
+    //! within the region only, so it differs slightly. Used by subsequent
+    //! calls.
+    void set_localized(bool localized, unsigned int halo = 4)
+    {
+        localized_ = localized;
+        halo_ = halo;
+    }
+
+    //! \brief Split, collapse, and flip edges from worklists instead of
+    //! sweeps.
+    //! \details By default, the splits and collapses sweep over all edges
+    //! until no operation happens, up to ten times. With worklists, only
+    //! the edges that are too long or too short are queued, the ones
+    //! deviating most from their target length first, and an operation
+    //! queues only the edges around the vertex it changes. The cost is then
+    //! proportional to the number of operations instead of the number of
+    //! sweeps times the size of the mesh. The flips are evaluated in
+    //! parallel and applied in conflict-free batches, see
+    //! IndependentSetScheduler, again only near the previous flips. The
+    //! order of the operations and thus the result differ from the sweeps.
+    //! Used by subsequent calls.
+    void set_use_worklist(bool use_worklist) { use_worklist_ = use_worklist; }
+
+    //! \brief Report the progress of subsequent remeshing calls.
+    //! \details Polled after the splits, collapses, flips, and smoothing of
+    //! each iteration. A cancelled remeshing keeps the phases performed so
+    //! far. See ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
+
+    //! Statistics of each iteration performed by the last remeshing call.
+    const std::vector<IterationStatistics>& statistics() const
+    {
+        return statistics_;
+    }
+
     //! \brief Perform uniform remeshing.
     //! \param edge_length the target edge length.
     //! \param iterations the number of iterations
     //! \param use_projection use back-projection to the input surface
+    //! \throw CancelledException if cancelled, see set_progress()
     void uniform_remeshing(Scalar edge_length, unsigned int iterations = 10,
                            bool use_projection = true);
 
@@ -39,23 +143,87 @@ public:
     //! \param approx_error the maximum approximation error
     //! \param iterations the number of iterations
     //! \param use_projection use back-projection to the input surface
+    //! \throw CancelledException if cancelled, see set_progress()
     void adaptive_remeshing(Scalar min_edge_length, Scalar max_edge_length,
                             Scalar approx_error, unsigned int iterations = 10,
                             bool use_projection = true);
 
+    //! \brief Perform adaptive remeshing with a given sizing field.
+    //! \param sizing the target edge length of each vertex of the mesh,
+    //! read once before the first iteration
+    //! \param iterations the number of iterations
+    //! \param use_projection use back-projection to the input surface
+    //! \throw CancelledException if cancelled, see set_progress()
+    void adaptive_remeshing(VertexProperty<Scalar> sizing,
+                            unsigned int iterations = 10,
+                            bool use_projection = true);
+
+    //! \brief Compute the curvature from which adaptive remeshing derives
+    //! its sizing field.
+    //! \details Stores the smoothed maximum absolute curvature in the vertex
+    //! property `v:sizing_curvature`, taking the `v:feature` vertices into
+    //! account. Adaptive remeshing uses this property instead of analyzing
+    //! the curvature again, and removes it, since it no longer matches the
+    //! remeshed surface. Computing it once for an input and remeshing copies
+    //! of it, e.g., with different tolerances, skips the curvature analysis
+    //! of each remeshing.
+    static void compute_sizing_curvature(SurfaceMesh& mesh);
+
 private:
     void preprocessing();
     void postprocessing();
 
-    void split_long_edges();
-    void collapse_short_edges();
-    void flip_edges();
+    // run up to the given number of iterations, checking the stop criteria.
+    // returns false if cancelled.
+    bool remesh(unsigned int iterations);
+
+    // the operations add their performed and rejected operations to stats
+    void split_long_edges(IterationStatistics& stats);
+    void collapse_short_edges(IterationStatistics& stats);
+    void flip_edges(IterationStatistics& stats);
+
+    // split e at its midpoint and return the new vertex
+    Vertex split_edge(Edge e, IterationStatistics& stats);
+
+    // collapse e if the boundary, lock, feature, and topology rules allow
+    // it, and return the remaining vertex, or an invalid one if rejected
+    Vertex collapse_edge(Edge e, IterationStatistics& stats);
+
+    // decrease of the squared valence deviation of the vertices of e by
+    // flipping it, zero if e or its vertices are locked or e is a feature
+    int flip_gain(Edge e) const;
+
+    // recompute the valences of v and its neighbors after a collapse
+    void update_valences(Vertex v);
     void tangential_smoothing(unsigned int iterations);
     void remove_caps();
 
     Point minimize_squared_areas(Vertex v);
 
+    // fraction of edges that are too long or too short
+    Scalar outside_band() const;
+
+    // store the curvature-based target edge lengths of mesh in sizing,
+    // using the v:sizing_curvature property if the mesh has one
+    void curvature_sizing(SurfaceMesh& mesh,
+                          VertexProperty<Scalar> sizing) const;
+
+    // store the smoothed maximum absolute curvature of mesh in curvature
+    static void smoothed_curvature(SurfaceMesh& mesh,
+                                   VertexProperty<Scalar> curvature);
+
+    // copy of the faces around the selected vertices and the halo, vertices
+    // receives the vertex of mesh_ of each vertex of the copy
+    SurfaceMesh* region_mesh(std::vector<Vertex>& vertices) const;
+
+    // project v to the closest point of the reference mesh and interpolate
+    // its normal and sizing
     void project_to_reference(Vertex v);
+    void project_to_reference(Vertex v,
+                              const TriangleBVH::NearestNeighbor& nn);
+
+    // project all interior unlocked vertices, querying them in parallel
+    void project_to_reference();
 
     bool is_too_long(Vertex v0, Vertex v1) const
     {
@@ -68,12 +236,19 @@ private:
                4.0 / 5.0 * std::min(vsizing_[v0], vsizing_[v1]);
     }
 
+    // edge length relative to the target length, the worklist priority
+    Scalar relative_length(Vertex v0, Vertex v1) const
+    {
+        return distance(points_[v0], points_[v1]) /
+               std::min(vsizing_[v0], vsizing_[v1]);
+    }
+
 private:
     SurfaceMesh& mesh_;
     SurfaceMesh* refmesh_;
 
     bool use_projection_;
-    TriangleKdTree* kd_tree_;
+    TriangleBVH* bvh_;
 
     bool uniform_;
     Scalar target_edge_length_;
@@ -81,6 +256,9 @@ private:
     Scalar max_edge_length_;
     Scalar approx_error_;
 
+    // sizing field given by the caller, if any
+    VertexProperty<Scalar> sizing_;
+
     VertexProperty<Point> points_;
     VertexProperty<Point> vnormal_;
     VertexProperty<bool> vfeature_;
@@ -89,9 +267,20 @@ private:
     EdgeProperty<bool> elocked_;
     VertexProperty<Scalar> vsizing_;
 
+    // valences kept up to date by the splits, collapses, and flips
+    VertexProperty<int> vvalence_;
+
     VertexProperty<Point> refpoints_;
     VertexProperty<Point> refnormals_;
     VertexProperty<Scalar> refsizing_;
+
+    bool localized_;
+    unsigned int halo_;
+    bool use_worklist_;
+
+    StopCriteria stop_criteria_;
+    ProgressCallback progress_;
+    std::vector<IterationStatistics> statistics_;
 };
 
 } // namespace pmp
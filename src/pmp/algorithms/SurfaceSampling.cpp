@@ -0,0 +1,270 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/SurfaceSampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+#include "pmp/BoundingBox.h"
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+namespace {
+
+// faces per chunk of the parallel prefix sum
+const int cdf_chunk_size = 4096;
+
+// samples drawn with one random number generator
+const size_t sample_block_size = 4096;
+
+// candidates of poisson_disk() per area of a square of the radius
+const double candidate_density = 10;
+
+// random number generator of a block of samples
+std::mt19937 block_generator(unsigned int seed, size_t block)
+{
+    std::seed_seq seq{seed, unsigned(block), unsigned(uint64_t(block) >> 32)};
+    return std::mt19937(seq);
+}
+
+// mixes the bits of x, used for random priorities of poisson_disk()
+uint64_t hash(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+void check_triangles(const SurfaceMesh& mesh)
+{
+    if (!mesh.is_triangle_mesh())
+        throw InvalidInputException("Input is not a pure triangle mesh!");
+}
+
+} // namespace
+
+std::vector<SurfaceSampling::Sample> SurfaceSampling::uniform(
+    const SurfaceMesh& mesh, size_t n_samples, unsigned int seed)
+{
+    check_triangles(mesh);
+
+    // accumulated areas indexed by face, deleted faces have zero area
+    const int n_faces = int(mesh.faces_size());
+    std::vector<double> cdf(n_faces);
+    const int n_chunks = (n_faces + cdf_chunk_size - 1) / cdf_chunk_size;
+    std::vector<double> chunk_sums(n_chunks);
+    parallel_for_chunks(
+        0, n_faces,
+        [&](int first, int last) {
+            double sum = 0;
+            for (int i = first; i < last; ++i)
+            {
+                const Face f(i);
+                if (!mesh.is_deleted(f))
+                {
+                    auto h = mesh.halfedge(f);
+                    const Point& p0 = mesh.position(mesh.to_vertex(h));
+                    h = mesh.next_halfedge(h);
+                    const Point& p1 = mesh.position(mesh.to_vertex(h));
+                    h = mesh.next_halfedge(h);
+                    const Point& p2 = mesh.position(mesh.to_vertex(h));
+                    sum += 0.5 * norm(cross(p1 - p0, p2 - p0));
+                }
+                cdf[i] = sum;
+            }
+            chunk_sums[first / cdf_chunk_size] = sum;
+        },
+        cdf_chunk_size);
+
+    // offsets of the chunks
+    double total = 0;
+    for (auto& sum : chunk_sums)
+    {
+        const double offset = total;
+        total += sum;
+        sum = offset;
+    }
+    parallel_for_chunks(
+        0, n_faces,
+        [&](int first, int last) {
+            const double offset = chunk_sums[first / cdf_chunk_size];
+            for (int i = first; i < last; ++i)
+                cdf[i] += offset;
+        },
+        cdf_chunk_size);
+
+    std::vector<Sample> samples;
+    if (n_samples == 0 || !(total > 0))
+        return samples;
+    samples.resize(n_samples);
+
+    const size_t n_blocks =
+        (n_samples + sample_block_size - 1) / sample_block_size;
+    parallel_for(
+        0, int(n_blocks),
+        [&](int b) {
+            auto rng = block_generator(seed, b);
+            std::uniform_real_distribution<double> uniform(0, 1);
+            const size_t first = b * sample_block_size;
+            const size_t last = std::min(first + sample_block_size, n_samples);
+            for (size_t i = first; i < last; ++i)
+            {
+                // the first face whose accumulated area exceeds the one of
+                // the sample, which skips faces of zero area
+                const double a = (i + uniform(rng)) / n_samples * total;
+                auto it = std::upper_bound(cdf.begin(), cdf.end(), a);
+                if (it == cdf.end())
+                    it = std::lower_bound(cdf.begin(), cdf.end(), total);
+                const Face f(IndexType(it - cdf.begin()));
+
+                double b1 = uniform(rng), b2 = uniform(rng);
+                if (b1 + b2 > 1)
+                {
+                    b1 = 1 - b1;
+                    b2 = 1 - b2;
+                }
+
+                auto h = mesh.halfedge(f);
+                const Point& p0 = mesh.position(mesh.to_vertex(h));
+                h = mesh.next_halfedge(h);
+                const Point& p1 = mesh.position(mesh.to_vertex(h));
+                h = mesh.next_halfedge(h);
+                const Point& p2 = mesh.position(mesh.to_vertex(h));
+
+                Sample& s = samples[i];
+                s.face = f;
+                s.barycentric = Vector<Scalar, 3>(Scalar(1 - b1 - b2),
+                                                  Scalar(b1), Scalar(b2));
+                s.point = s.barycentric[0] * p0 + s.barycentric[1] * p1 +
+                          s.barycentric[2] * p2;
+            }
+        },
+        1);
+
+    return samples;
+}
+
+std::vector<SurfaceSampling::Sample> SurfaceSampling::poisson_disk(
+    const SurfaceMesh& mesh, Scalar radius, unsigned int seed)
+{
+    check_triangles(mesh);
+    if (!(radius > 0))
+        throw InvalidInputException("SurfaceSampling: Invalid radius.");
+
+    // candidates, their number is proportional to the area
+    double area = 0;
+    for (auto f : mesh.faces())
+    {
+        auto h = mesh.halfedge(f);
+        const Point& p0 = mesh.position(mesh.to_vertex(h));
+        h = mesh.next_halfedge(h);
+        const Point& p1 = mesh.position(mesh.to_vertex(h));
+        h = mesh.next_halfedge(h);
+        const Point& p2 = mesh.position(mesh.to_vertex(h));
+        area += 0.5 * norm(cross(p1 - p0, p2 - p0));
+    }
+    const auto n_candidates =
+        size_t(std::ceil(candidate_density * area / (radius * radius)));
+    const auto candidates = uniform(mesh, n_candidates, seed);
+    if (candidates.empty())
+        return candidates;
+
+    // grid cell of each candidate, 21 bits per coordinate
+    BoundingBox bb;
+    for (auto v : mesh.vertices())
+        bb += mesh.position(v);
+    const int max_cell = (1 << 21) - 1;
+    for (int i = 0; i < 3; ++i)
+        if ((bb.max()[i] - bb.min()[i]) / radius >= max_cell)
+            throw InvalidInputException("SurfaceSampling: Radius too small.");
+
+    auto cell = [&](const Point& p, int i) {
+        return std::min(int((p[i] - bb.min()[i]) / radius), max_cell);
+    };
+    auto key = [](int x, int y, int z) {
+        return (uint64_t(x) << 42) | (uint64_t(y) << 21) | uint64_t(z);
+    };
+
+    // sort the candidates by cell and, within each cell, by random priority
+    std::vector<std::pair<uint64_t, uint64_t>> order(candidates.size());
+    parallel_for(0, int(candidates.size()), [&](int i) {
+        const Point& p = candidates[i].point;
+        order[i].first = key(cell(p, 0), cell(p, 1), cell(p, 2));
+        order[i].second = (hash(uint64_t(i) ^ (uint64_t(seed) << 32)) &
+                           ~uint64_t(0xffffffff)) |
+                          uint64_t(i);
+    });
+    std::sort(order.begin(), order.end());
+
+    // ranges of the cells in order, sorted into the 27 phases
+    std::unordered_map<uint64_t, std::pair<IndexType, IndexType>> cells;
+    std::vector<std::vector<uint64_t>> phases(27);
+    for (size_t begin = 0, end; begin < order.size(); begin = end)
+    {
+        end = begin + 1;
+        while (end < order.size() && order[end].first == order[begin].first)
+            ++end;
+        const uint64_t k = order[begin].first;
+        cells[k] = std::make_pair(IndexType(begin), IndexType(end));
+        const int x = int(k >> 42), y = int((k >> 21) & max_cell),
+                  z = int(k & max_cell);
+        phases[(x % 3) * 9 + (y % 3) * 3 + z % 3].push_back(k);
+    }
+
+    // cells of one phase do not have common neighbors, so each cell can
+    // test its candidates against the accepted ones of its neighbors
+    const Scalar sqr_radius = radius * radius;
+    std::vector<char> accepted(order.size(), 0);
+    auto candidate = [&](IndexType j) -> const Point& {
+        return candidates[order[j].second & 0xffffffff].point;
+    };
+    for (const auto& phase : phases)
+    {
+        parallel_for(
+            0, int(phase.size()),
+            [&](int c) {
+                const uint64_t k = phase[c];
+                const int x = int(k >> 42), y = int((k >> 21) & max_cell),
+                          z = int(k & max_cell);
+                const auto range = cells.find(k)->second;
+                for (IndexType i = range.first; i < range.second; ++i)
+                {
+                    const Point& p = candidate(i);
+                    bool free = true;
+                    for (int dx = -1; dx <= 1 && free; ++dx)
+                        for (int dy = -1; dy <= 1 && free; ++dy)
+                            for (int dz = -1; dz <= 1 && free; ++dz)
+                            {
+                                if (x + dx < 0 || y + dy < 0 || z + dz < 0)
+                                    continue;
+                                auto it = cells.find(
+                                    key(x + dx, y + dy, z + dz));
+                                if (it == cells.end())
+                                    continue;
+                                for (IndexType j = it->second.first;
+                                     j < it->second.second && free; ++j)
+                                    if (accepted[j] &&
+                                        sqrnorm(candidate(j) - p) <
+                                            sqr_radius)
+                                        free = false;
+                            }
+                    accepted[i] = free;
+                }
+            },
+            16);
+    }
+
+    std::vector<Sample> samples;
+    for (size_t i = 0; i < order.size(); ++i)
+        if (accepted[i])
+            samples.push_back(candidates[order[i].second & 0xffffffff]);
+    return samples;
+}
+
+} // namespace pmp
@@ -0,0 +1,76 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief Random point samples on the surface of a triangle mesh.
+//! \details The samples are drawn in parallel. Each block of consecutive
+//! samples uses its own random number generator seeded by the block index,
+//! such that the results do not depend on the number of threads.
+//! \ingroup algorithms
+class SurfaceSampling
+{
+public:
+    // delete default and copy constructor
+    SurfaceSampling() = delete;
+    SurfaceSampling(const SurfaceSampling&) = delete;
+
+    //! point sampled on a triangle
+    struct Sample
+    {
+        Face face;   //!< triangle containing the sample
+        Point point; //!< position of the sample
+
+        //! \brief Barycentric coordinates of the sample.
+        //! \details Refer to the vertices of the face in the order of
+        //! SurfaceMesh::vertices(Face), see interpolate().
+        Vector<Scalar, 3> barycentric;
+    };
+
+    //! \brief Draw \p n_samples points uniformly distributed by area.
+    //! \details Builds the cumulative distribution of the triangle areas
+    //! with a parallel prefix sum. The samples are stratified: the i-th
+    //! sample lies in the i-th of \p n_samples intervals of equal area of
+    //! the distribution, so they are ordered like the faces and cover the
+    //! surface more evenly than independent samples.
+    //! \throw InvalidInputException if \p mesh is not a triangle mesh.
+    static std::vector<Sample> uniform(const SurfaceMesh& mesh,
+                                       size_t n_samples,
+                                       unsigned int seed = 0);
+
+    //! \brief Draw blue noise samples that are at least \p radius apart.
+    //! \details Thins out uniform() candidates with a spatial grid of cells
+    //! of size \p radius. The cells are processed in 27 phases, the cells of
+    //! each phase are three cells apart and are processed in parallel. The
+    //! distance is Euclidean, not geodesic.
+    //! \throw InvalidInputException if \p mesh is not a triangle mesh or
+    //! \p radius is not positive.
+    static std::vector<Sample> poisson_disk(const SurfaceMesh& mesh,
+                                            Scalar radius,
+                                            unsigned int seed = 0);
+
+    //! \brief Interpolate the vertex property \p values at \p sample.
+    //! \details \p T must support addition and multiplication by Scalar.
+    template <class T>
+    static T interpolate(const SurfaceMesh& mesh,
+                         const VertexProperty<T>& values,
+                         const Sample& sample)
+    {
+        auto h = mesh.halfedge(sample.face);
+        const T& v0 = values[mesh.to_vertex(h)];
+        h = mesh.next_halfedge(h);
+        const T& v1 = values[mesh.to_vertex(h)];
+        h = mesh.next_halfedge(h);
+        const T& v2 = values[mesh.to_vertex(h)];
+        return sample.barycentric[0] * v0 + sample.barycentric[1] * v1 +
+               sample.barycentric[2] * v2;
+    }
+};
+
+} // namespace pmp
@@ -3,16 +3,75 @@
 
 #include "pmp/algorithms/SurfaceSimplification.h"
 
-#include <iterator>
+#include <algorithm>
+#include <chrono>
 #include <limits>
+#include <string>
 
+#include "pmp/MemoryScope.h"
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
 #include "pmp/algorithms/DistancePointTriangle.h"
+#include "pmp/algorithms/IndependentSetScheduler.h"
 #include "pmp/algorithms/SurfaceNormals.h"
 
 namespace pmp {
 
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// milliseconds since time, which is reset to now
+double lap(Clock::time_point& time)
+{
+    const auto now = Clock::now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(now - time).count();
+    time = now;
+    return ms;
+}
+
+// fraction of the collapses towards the vertex and face targets
+float fraction(unsigned int nv0, unsigned int nv, unsigned int n_vertices,
+               unsigned int nf0, unsigned int nf, unsigned int n_faces)
+{
+    float f = 0;
+    if (nv0 > n_vertices)
+        f = std::max(f, float(nv0 - nv) / float(nv0 - n_vertices));
+    if (nf0 > n_faces)
+        f = std::max(f, float(nf0 - nf) / float(nf0 - n_faces));
+    return std::min(f, 1.0f);
+}
+
+} // namespace
+
+// The per-element data is kept in containers of its own instead of the mesh,
+// resizing them for the next mesh keeps their capacity. The point lists and
+// the queue are swapped in and out by the simplifications.
+class SurfaceSimplification::Workspace
+{
+public:
+    PropertyContainer vprops;
+    PropertyContainer fprops;
+    PriorityQueue queue;
+    std::vector<Point> points;
+    std::vector<IndexType> next_point;
+};
+
 SurfaceSimplification::SurfaceSimplification(SurfaceMesh& mesh)
-    : mesh_(mesh), initialized_(false), queue_(nullptr)
+    : SurfaceSimplification(mesh, nullptr)
+{
+}
+
+SurfaceSimplification::SurfaceSimplification(SurfaceMesh& mesh,
+                                             Workspace* workspace)
+    : mesh_(mesh),
+      initialized_(false),
+      queue_(nullptr),
+      workspace_(workspace),
+      n_legality_tests_(0),
+      n_rejected_(0),
+      lazy_updates_(false)
 
 {
     if (!mesh_.is_triangle_mesh())
@@ -23,9 +82,18 @@ SurfaceSimplification::SurfaceSimplification(SurfaceMesh& mesh)
     max_valence_ = 0;
     normal_deviation_ = 0;
     hausdorff_error_ = 0;
+    optimal_placement_ = false;
+
+    if (workspace_)
+    {
+        workspace_->vprops.resize(mesh_.vertices_size());
+        workspace_->fprops.resize(mesh_.faces_size());
+        std::swap(points_, workspace_->points);
+        std::swap(next_point_, workspace_->next_point);
+    }
 
     // add properties
-    vquadric_ = mesh_.add_vertex_property<Quadric>("v:quadric");
+    vquadric_ = add_vertex_scratch<Quadric>("v:quadric");
 
     // get properties
     vpoint_ = mesh_.vertex_property<Point>("v:point");
@@ -38,32 +106,78 @@ SurfaceSimplification::SurfaceSimplification(SurfaceMesh& mesh)
 SurfaceSimplification::~SurfaceSimplification()
 {
     // remove added properties
-    mesh_.remove_vertex_property(vquadric_);
-    mesh_.remove_face_property(normal_cone_);
-    mesh_.remove_face_property(face_points_);
+    remove_scratch(vquadric_);
+    remove_scratch(normal_cone_);
+    remove_scratch(face_points_);
+
+    if (workspace_)
+    {
+        std::swap(points_, workspace_->points);
+        std::swap(next_point_, workspace_->next_point);
+    }
+}
+
+template <class T>
+VertexProperty<T> SurfaceSimplification::add_vertex_scratch(
+    const std::string& name)
+{
+    if (workspace_)
+        return VertexProperty<T>(workspace_->vprops.get_or_add<T>(name));
+    return mesh_.add_vertex_property<T>(name);
+}
+
+template <class T>
+FaceProperty<T> SurfaceSimplification::face_scratch(const std::string& name)
+{
+    if (workspace_)
+        return FaceProperty<T>(workspace_->fprops.get_or_add<T>(name));
+    return mesh_.face_property<T>(name);
+}
+
+template <class T>
+void SurfaceSimplification::remove_scratch(VertexProperty<T>& prop)
+{
+    if (workspace_)
+        prop.reset();
+    else
+        mesh_.remove_vertex_property(prop);
+}
+
+template <class T>
+void SurfaceSimplification::remove_scratch(FaceProperty<T>& prop)
+{
+    if (workspace_)
+        prop.reset();
+    else
+        mesh_.remove_face_property(prop);
 }
 
 void SurfaceSimplification::initialize(Scalar aspect_ratio, Scalar edge_length,
                                        unsigned int max_valence,
                                        Scalar normal_deviation,
-                                       Scalar hausdorff_error)
+                                       Scalar hausdorff_error,
+                                       bool optimal_placement)
 {
+    PMP_PROFILE_SCOPE("SurfaceSimplification::initialize");
+    auto time = Clock::now();
+
     // store parameters
     aspect_ratio_ = aspect_ratio;
     max_valence_ = max_valence;
     edge_length_ = edge_length;
     normal_deviation_ = normal_deviation / 180.0 * M_PI;
     hausdorff_error_ = hausdorff_error;
+    optimal_placement_ = optimal_placement;
 
     // properties
     if (normal_deviation_ > 0.0)
-        normal_cone_ = mesh_.face_property<NormalCone>("f:normalCone");
+        normal_cone_ = face_scratch<NormalCone>("f:normalCone");
     else
-        mesh_.remove_face_property(normal_cone_);
+        remove_scratch(normal_cone_);
     if (hausdorff_error > 0.0)
-        face_points_ = mesh_.face_property<Points>("f:points");
+        face_points_ = face_scratch<IndexType>("f:points");
     else
-        mesh_.remove_face_property(face_points_);
+        remove_scratch(face_points_);
 
     // vertex selection
     has_selection_ = false;
@@ -96,9 +210,8 @@ void SurfaceSimplification::initialize(Scalar aspect_ratio, Scalar edge_length,
         }
     }
 
-    // initialize quadrics
-    for (auto v : mesh_.vertices())
-    {
+    // initialize quadrics, each vertex gathers from its incident faces
+    parallel_for(mesh_.vertices(), [&](Vertex v) {
         vquadric_[v].clear();
 
         if (!mesh_.is_isolated(v))
@@ -108,68 +221,147 @@ void SurfaceSimplification::initialize(Scalar aspect_ratio, Scalar edge_length,
                 vquadric_[v] += Quadric(fnormal_[f], vpoint_[v]);
             }
         }
-    }
+    });
 
     // initialize normal cones
     if (normal_deviation_)
     {
-        for (auto f : mesh_.faces())
-        {
+        parallel_for(mesh_.faces(), [&](Face f) {
             normal_cone_[f] = NormalCone(fnormal_[f]);
-        }
+        });
     }
 
     // initialize faces' point list
     if (hausdorff_error_)
     {
-        for (auto f : mesh_.faces())
-        {
-            Points().swap(face_points_[f]); // free mem
-        }
+        parallel_for(mesh_.faces(),
+                     [&](Face f) { face_points_[f] = PMP_MAX_INDEX; });
+    }
+    if (workspace_)
+    {
+        points_.clear();
+        next_point_.clear();
+    }
+    else
+    {
+        std::vector<Point>().swap(points_); // free mem
+        std::vector<IndexType>().swap(next_point_);
     }
 
     initialized_ = true;
+    statistics_.initialize_time = lap(time);
+}
+
+void SurfaceSimplification::reset_statistics()
+{
+    const double initialize_time = statistics_.initialize_time;
+    statistics_ = Statistics();
+    statistics_.initialize_time = initialize_time;
+    n_legality_tests_ = 0;
+    n_rejected_ = 0;
 }
 
 void SurfaceSimplification::simplify(unsigned int n_vertices)
 {
+    simplify(n_vertices, 0, 0);
+}
+
+void SurfaceSimplification::simplify(unsigned int n_vertices,
+                                     unsigned int n_faces, Scalar max_error,
+                                     ProgressiveMesh* progressive_mesh)
+{
+    PMP_PROFILE_SCOPE("SurfaceSimplification::simplify");
+    MemoryScope memory;
+
     // make sure the decimater is initialized
     if (!initialized_)
         initialize();
+    reset_statistics();
+    auto time = Clock::now();
+
+    if (progressive_mesh)
+        progressive_mesh->reset(mesh_);
 
     unsigned int nv(mesh_.n_vertices());
+    unsigned int nf(mesh_.n_faces());
+    const unsigned int nv0(nv), nf0(nf);
+    unsigned int n_candidates(0);
+    bool cancelled(false);
 
     std::vector<Vertex> one_ring;
     std::vector<Vertex>::iterator or_it, or_end;
     Halfedge h;
     Vertex v;
 
+    // vertices in the queue whose target is outdated, in lazy mode
+    std::vector<char> stale;
+    if (lazy_updates_)
+        stale.assign(mesh_.vertices_size(), 0);
+
     // add properties for priority queue
-    vpriority_ = mesh_.add_vertex_property<float>("v:prio");
-    heap_pos_ = mesh_.add_vertex_property<int>("v:heap");
-    vtarget_ = mesh_.add_vertex_property<Halfedge>("v:target");
-
-    // build priority queue
-    HeapInterface hi(vpriority_, heap_pos_);
-    queue_ = new PriorityQueue(hi);
-    queue_->reserve(mesh_.n_vertices());
-    for (auto v : mesh_.vertices())
+    vpriority_ = add_vertex_scratch<float>("v:prio");
+    vtarget_ = add_vertex_scratch<Halfedge>("v:target");
+
     {
-        queue_->reset_heap_position(v);
-        enqueue_vertex(v);
+        PMP_PROFILE_SCOPE("queue");
+
+        // find the initial targets in parallel
+        parallel_for(mesh_.vertices(), [&](Vertex v) {
+            vtarget_[v] = find_target(v, vpriority_[v]);
+        });
+
+        // build priority queue in one pass
+        queue_ = workspace_ ? &workspace_->queue
+                            : new PriorityQueue(mesh_.vertices_size());
+        std::vector<std::pair<Vertex, float>> entries;
+        entries.reserve(mesh_.n_vertices());
+        for (auto v : mesh_.vertices())
+            if (vtarget_[v].is_valid())
+                entries.emplace_back(v, vpriority_[v]);
+        queue_->build(entries);
+        statistics_.n_queue_updates += entries.size();
+        statistics_.queue_time += lap(time);
     }
 
-    while (nv > n_vertices && !queue_->empty())
+    PMP_PROFILE_SCOPE("collapse");
+
+    while (nv > n_vertices && nf > n_faces && !queue_->empty())
     {
-        // get 1st element
+        if (progress_ && ++n_candidates % 256 == 0 &&
+            !progress_(fraction(nv0, nv, n_vertices, nf0, nf, n_faces)))
+        {
+            cancelled = true;
+            break;
+        }
+
+        // re-evaluate a stale vertex once it is the cheapest
         v = queue_->front();
+        if (lazy_updates_ && stale[v.idx()])
+        {
+            stale[v.idx()] = 0;
+            enqueue_vertex(v);
+            ++statistics_.n_stale;
+            continue;
+        }
+
+        // the cheapest collapse exceeds the error budget
+        if (max_error > 0 && vpriority_[v] > max_error)
+            break;
+
+        // get 1st element
         queue_->pop_front();
         h = vtarget_[v];
         CollapseData cd(mesh_, h);
 
         // check this (again)
         if (!mesh_.is_collapse_ok(h))
+        {
+            ++statistics_.n_invalid;
             continue;
+        }
+        cd.target = placement(cd);
+        const bool moved = cd.target != vpoint_[cd.v1];
+        const IndexType points = store_points(cd);
 
         // store one-ring
         one_ring.clear();
@@ -180,44 +372,294 @@ void SurfaceSimplification::simplify(unsigned int n_vertices)
 
         // perform collapse
         mesh_.collapse(h);
+        ++statistics_.n_collapses;
         --nv;
+        if (progressive_mesh)
+            progressive_mesh->add_collapse(cd.v0, cd.v1, cd.vl, cd.vr);
+        if (cd.fl.is_valid())
+            --nf;
+        if (cd.fr.is_valid())
+            --nf;
 
         // postprocessing, e.g., update quadrics
-        postprocess_collapse(cd);
+        postprocess_collapse(cd, points);
+
+        // moving v1 changes the targets around it
+        if (moved)
+        {
+            one_ring.clear();
+            moved_region(cd.v1, one_ring);
+        }
 
         // update queue
         for (or_it = one_ring.begin(), or_end = one_ring.end(); or_it != or_end;
              ++or_it)
-            enqueue_vertex(*or_it);
+        {
+            if (lazy_updates_ && queue_->is_stored(*or_it))
+                stale[or_it->idx()] = 1;
+            else
+                enqueue_vertex(*or_it);
+        }
     }
 
     // clean up
-    delete queue_;
+    if (!workspace_)
+        delete queue_;
     mesh_.garbage_collection();
-    mesh_.remove_vertex_property(vpriority_);
-    mesh_.remove_vertex_property(heap_pos_);
-    mesh_.remove_vertex_property(vtarget_);
+    remove_scratch(vpriority_);
+    remove_scratch(vtarget_);
+
+    statistics_.collapse_time += lap(time);
+    statistics_.n_legality_tests = n_legality_tests_;
+    statistics_.n_rejected = n_rejected_;
+    statistics_.peak_memory = memory.peak_extra();
+
+    if (cancelled)
+        throw CancelledException("SurfaceSimplification: Cancelled.");
 }
 
-void SurfaceSimplification::enqueue_vertex(Vertex v)
+void SurfaceSimplification::simplify_parallel(
+    unsigned int n_vertices, unsigned int n_faces, Scalar max_error,
+    ProgressiveMesh* progressive_mesh)
+{
+    PMP_PROFILE_SCOPE("SurfaceSimplification::simplify_parallel");
+    MemoryScope memory;
+
+    // make sure the decimater is initialized
+    if (!initialized_)
+        initialize();
+    reset_statistics();
+    auto time = Clock::now();
+
+    if (progressive_mesh)
+        progressive_mesh->reset(mesh_);
+
+    unsigned int nv(mesh_.n_vertices());
+    unsigned int nf(mesh_.n_faces());
+    const unsigned int nv0(nv), nf0(nf);
+    bool cancelled(false);
+
+    // add properties for collapse targets
+    vpriority_ = add_vertex_scratch<float>("v:prio");
+    vtarget_ = add_vertex_scratch<Halfedge>("v:target");
+
+    // vertices whose target has to be (re-)computed
+    std::vector<char> dirty(mesh_.vertices_size(), 1);
+
+    // round stamps of the vertices locked by the current batch
+    std::vector<unsigned int> lock(mesh_.vertices_size(), 0);
+    unsigned int round = 0;
+
+    std::vector<Vertex> candidates, region, moved;
+    std::vector<CollapseData> batch;
+    std::vector<IndexType> batch_points;
+
+    while (nv > n_vertices && nf > n_faces)
+    {
+        if (progress_ &&
+            !progress_(fraction(nv0, nv, n_vertices, nf0, nf, n_faces)))
+        {
+            cancelled = true;
+            break;
+        }
+
+        ++statistics_.n_rounds;
+
+        // evaluate the changed targets in parallel
+        parallel_for(mesh_.vertices(), [&](Vertex v) {
+            if (dirty[v.idx()])
+            {
+                vtarget_[v] = find_target(v, vpriority_[v]);
+                dirty[v.idx()] = 0;
+            }
+        });
+
+        // collapses within the error budget
+        candidates.clear();
+        for (auto v : mesh_.vertices())
+            if (vtarget_[v].is_valid() &&
+                !(max_error > 0 && vpriority_[v] > max_error))
+                candidates.push_back(v);
+        if (candidates.empty())
+            break;
+
+        // the cheapest quarter of them, in order of priority. Ties are
+        // broken by index, so the batches do not depend on the standard
+        // library's sorting algorithm.
+        auto by_priority = [&](Vertex a, Vertex b) {
+            return vpriority_[a] < vpriority_[b] ||
+                   (vpriority_[a] == vpriority_[b] && a < b);
+        };
+        const size_t n_cheap = candidates.size() / 4 + 1;
+        std::nth_element(candidates.begin(), candidates.begin() + n_cheap - 1,
+                         candidates.end(), by_priority);
+        candidates.resize(n_cheap);
+        std::sort(candidates.begin(), candidates.end(), by_priority);
+
+        // greedily select collapses whose one-rings do not overlap. Their
+        // targets cannot invalidate each other, and each one only updates
+        // data inside its region.
+        ++round;
+        batch.clear();
+        for (auto v : candidates)
+        {
+            if (nv <= n_vertices || nf <= n_faces)
+                break;
+
+            const Halfedge h = vtarget_[v];
+            region.clear();
+            IndependentSetScheduler::vertex_region(mesh_, v, region);
+            IndependentSetScheduler::vertex_region(mesh_, mesh_.to_vertex(h),
+                                                   region);
+
+            bool free = true;
+            for (auto vv : region)
+                if (lock[vv.idx()] == round)
+                {
+                    free = false;
+                    break;
+                }
+            if (!free)
+            {
+                ++statistics_.n_conflicts;
+                continue;
+            }
+            if (!mesh_.is_collapse_ok(h))
+            {
+                ++statistics_.n_invalid;
+                continue;
+            }
+
+            for (auto vv : region)
+                lock[vv.idx()] = round;
+            batch.emplace_back(mesh_, h);
+            batch.back().target = placement(batch.back());
+            --nv;
+            if (batch.back().fl.is_valid())
+                --nf;
+            if (batch.back().fr.is_valid())
+                --nf;
+        }
+        statistics_.queue_time += lap(time);
+        statistics_.n_collapses += (unsigned int)batch.size();
+
+        // perform the collapses, the one-rings of the removed vertices and
+        // of the moved ones have to be re-evaluated
+        batch_points.clear();
+        for (const auto& cd : batch)
+        {
+            for (auto vv : mesh_.vertices(cd.v0))
+                dirty[vv.idx()] = 1;
+            const bool is_moved = cd.target != vpoint_[cd.v1];
+            batch_points.push_back(store_points(cd));
+            mesh_.collapse(cd.v0v1);
+            if (is_moved)
+            {
+                moved.clear();
+                moved_region(cd.v1, moved);
+                for (auto vv : moved)
+                    dirty[vv.idx()] = 1;
+            }
+            if (progressive_mesh)
+                progressive_mesh->add_collapse(cd.v0, cd.v1, cd.vl, cd.vr);
+        }
+
+        // postprocessing, e.g., update quadrics
+        const int n = int(batch.size());
+        parallel_for(
+            0, n,
+            [&](int i) { postprocess_collapse(batch[i], batch_points[i]); },
+            64);
+        statistics_.collapse_time += lap(time);
+    }
+
+    // clean up
+    mesh_.garbage_collection();
+    remove_scratch(vpriority_);
+    remove_scratch(vtarget_);
+
+    statistics_.collapse_time += lap(time);
+    statistics_.n_legality_tests = n_legality_tests_;
+    statistics_.n_rejected = n_rejected_;
+    statistics_.peak_memory = memory.peak_extra();
+
+    if (cancelled)
+        throw CancelledException("SurfaceSimplification: Cancelled.");
+}
+
+void SurfaceSimplification::simplify_batch(std::vector<SurfaceMesh>& meshes,
+                                           const BatchSettings& settings)
 {
-    float prio, min_prio(std::numeric_limits<float>::max());
+    PMP_PROFILE_SCOPE("SurfaceSimplification::simplify_batch");
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+        if (!meshes[i].is_triangle_mesh())
+        {
+            auto what = "SurfaceSimplification: Mesh " + std::to_string(i) +
+                        " is not a pure triangle mesh!";
+            throw InvalidInputException(what);
+        }
+
+    // a few chunks per thread balance the load, each chunk reuses its
+    // workspace for all of its meshes
+    const int n = int(meshes.size());
+    const int chunk_size = std::max(1, n / (4 * Parallel::n_threads()));
+    parallel_for_chunks(
+        0, n,
+        [&](int first, int last) {
+            Workspace workspace;
+            for (int i = first; i < last; ++i)
+            {
+                SurfaceMesh& mesh = meshes[i];
+                const auto n_vertices = static_cast<unsigned int>(
+                    settings.ratio * Scalar(mesh.n_vertices()));
+
+                SurfaceSimplification simplification(mesh, &workspace);
+                simplification.initialize(
+                    settings.aspect_ratio, settings.edge_length,
+                    settings.max_valence, settings.normal_deviation,
+                    settings.hausdorff_error, settings.optimal_placement);
+                simplification.simplify(n_vertices, 0, settings.max_error);
+            }
+        },
+        chunk_size);
+}
+
+Halfedge SurfaceSimplification::find_target(Vertex v, float& prio) const
+{
+    float min_prio(std::numeric_limits<float>::max());
     Halfedge min_h;
+    size_t n_tests = 0, n_rejected = 0;
 
     // find best out-going halfedge
     for (auto h : mesh_.halfedges(v))
     {
         CollapseData cd(mesh_, h);
+        cd.target = placement(cd);
+        ++n_tests;
         if (is_collapse_legal(cd))
         {
-            prio = priority(cd);
-            if (prio != -1.0 && prio < min_prio)
+            float p = priority(cd);
+            if (p != -1.0 && p < min_prio)
             {
-                min_prio = prio;
+                min_prio = p;
                 min_h = h;
             }
         }
+        else
+            ++n_rejected;
     }
+    n_legality_tests_ += n_tests;
+    n_rejected_ += n_rejected;
+
+    prio = min_h.is_valid() ? min_prio : -1;
+    return min_h;
+}
+
+void SurfaceSimplification::enqueue_vertex(Vertex v)
+{
+    float min_prio;
+    Halfedge min_h = find_target(v, min_prio);
 
     // target found -> put vertex on heap
     if (min_h.is_valid())
@@ -226,23 +668,73 @@ void SurfaceSimplification::enqueue_vertex(Vertex v)
         vtarget_[v] = min_h;
 
         if (queue_->is_stored(v))
-            queue_->update(v);
+            queue_->update(v, min_prio);
         else
-            queue_->insert(v);
+            queue_->insert(v, min_prio);
+        ++statistics_.n_queue_updates;
     }
 
     // not valid -> remove from heap
     else
     {
         if (queue_->is_stored(v))
-            queue_->remove(v);
+        {
+            queue_->lazy_remove(v);
+            ++statistics_.n_queue_updates;
+        }
 
         vpriority_[v] = -1;
         vtarget_[v] = min_h;
     }
 }
 
-bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
+Point SurfaceSimplification::placement(const CollapseData& cd) const
+{
+    const Point& p1 = vpoint_[cd.v1];
+
+    // keep the position of vertices that must not move
+    if (!optimal_placement_ || mesh_.is_boundary(cd.v1) ||
+        (has_features_ && vfeature_[cd.v1]) ||
+        (has_selection_ && !vselected_[cd.v1]))
+        return p1;
+
+    Quadric Q = vquadric_[cd.v0];
+    Q += vquadric_[cd.v1];
+
+    // the minimizer of the combined quadric, unless the endpoint or the
+    // midpoint is as good, e.g., for a nearly degenerate quadric
+    const Point mid = Scalar(0.5) * (vpoint_[cd.v0] + p1);
+    const Point candidates[3] = {p1, mid, Q.minimizer(mid)};
+    double errors[3];
+    Q.evaluate(candidates, 3, errors);
+    return candidates[std::min_element(errors, errors + 3) - errors];
+}
+
+void SurfaceSimplification::moved_region(Vertex v,
+                                         std::vector<Vertex>& vertices) const
+{
+    const size_t begin = vertices.size();
+    vertices.push_back(v);
+    for (auto vv : mesh_.vertices(v))
+        vertices.push_back(vv);
+    const size_t end = vertices.size();
+
+    // the faces of the target vertex are checked as well when it can move
+    for (size_t i = begin + 1; i < end; ++i)
+    {
+        for (auto h : mesh_.halfedges(vertices[i]))
+        {
+            const Halfedge o = mesh_.opposite_halfedge(h);
+            const Vertex w = mesh_.to_vertex(h);
+            if (vtarget_[w] == o &&
+                std::find(vertices.begin() + begin, vertices.begin() + end,
+                          w) == vertices.begin() + end)
+                vertices.push_back(w);
+        }
+    }
+}
+
+bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd) const
 {
     // test selected vertices
     if (has_selection_)
@@ -291,19 +783,28 @@ bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
             return false;
     }
 
-    // remember the positions of the endpoints
+    // remember the positions of the endpoints and of the merged vertex
     const Point p0 = vpoint_[cd.v0];
     const Point p1 = vpoint_[cd.v1];
+    const Point& p = cd.target;
+
+    // the faces of the endpoints that are moved to p, only those of v0
+    // unless v1 is moved as well
+    const Vertex moved[2] = {cd.v0, cd.v1};
+    const int n_moved = (p != p1) ? 2 : 1;
 
     // check for maximum edge length
     if (edge_length_)
     {
-        for (auto v : mesh_.vertices(cd.v0))
+        for (int k = 0; k < n_moved; ++k)
         {
-            if (v != cd.v1 && v != cd.vl && v != cd.vr)
+            for (auto v : mesh_.vertices(moved[k]))
             {
-                if (norm(vpoint_[v] - p1) > edge_length_)
-                    return false;
+                if (v != cd.v0 && v != cd.v1 && v != cd.vl && v != cd.vr)
+                {
+                    if (norm(vpoint_[v] - p) > edge_length_)
+                        return false;
+                }
             }
         }
     }
@@ -311,28 +812,24 @@ bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
     // check for flipping normals
     if (normal_deviation_ == 0.0)
     {
-        vpoint_[cd.v0] = p1;
-        for (auto f : mesh_.faces(cd.v0))
+        for (int k = 0; k < n_moved; ++k)
         {
-            if (f != cd.fl && f != cd.fr)
+            for (auto f : mesh_.faces(moved[k]))
             {
-                Normal n0 = fnormal_[f];
-                Normal n1 = SurfaceNormals::compute_face_normal(mesh_, f);
-                if (dot(n0, n1) < 0.0)
+                if (f != cd.fl && f != cd.fr)
                 {
-                    vpoint_[cd.v0] = p0;
-                    return false;
+                    Normal n0 = fnormal_[f];
+                    Normal n1 = face_normal(f, moved[k], p);
+                    if (dot(n0, n1) < 0.0)
+                        return false;
                 }
             }
         }
-        vpoint_[cd.v0] = p0;
     }
 
     // check normal cone
     else
     {
-        vpoint_[cd.v0] = p1;
-
         Face fll, frr;
         if (cd.vl.is_valid())
             fll = mesh_.face(
@@ -341,27 +838,25 @@ bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
             frr = mesh_.face(
                 mesh_.opposite_halfedge(mesh_.next_halfedge(cd.v1v0)));
 
-        for (auto f : mesh_.faces(cd.v0))
+        for (int k = 0; k < n_moved; ++k)
         {
-            if (f != cd.fl && f != cd.fr)
+            for (auto f : mesh_.faces(moved[k]))
             {
-                NormalCone nc = normal_cone_[f];
-                nc.merge(SurfaceNormals::compute_face_normal(mesh_, f));
+                if (f != cd.fl && f != cd.fr)
+                {
+                    NormalCone nc = normal_cone_[f];
+                    nc.merge(face_normal(f, moved[k], p));
 
-                if (f == fll)
-                    nc.merge(normal_cone_[cd.fl]);
-                if (f == frr)
-                    nc.merge(normal_cone_[cd.fr]);
+                    if (f == fll)
+                        nc.merge(normal_cone_[cd.fl]);
+                    if (f == frr)
+                        nc.merge(normal_cone_[cd.fr]);
 
-                if (nc.angle() > 0.5 * normal_deviation_)
-                {
-                    vpoint_[cd.v0] = p0;
-                    return false;
+                    if (nc.angle() > 0.5 * normal_deviation_)
+                        return false;
                 }
             }
         }
-
-        vpoint_[cd.v0] = p0;
     }
 
     // check aspect ratio
@@ -369,16 +864,18 @@ bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
     {
         Scalar ar0(0), ar1(0);
 
-        for (auto f : mesh_.faces(cd.v0))
+        for (int k = 0; k < n_moved; ++k)
         {
-            if (f != cd.fl && f != cd.fr)
+            for (auto f : mesh_.faces(moved[k]))
             {
-                // worst aspect ratio after collapse
-                vpoint_[cd.v0] = p1;
-                ar1 = std::max(ar1, aspect_ratio(f));
-                // worst aspect ratio before collapse
-                vpoint_[cd.v0] = p0;
-                ar0 = std::max(ar0, aspect_ratio(f));
+                if (f != cd.fl && f != cd.fr)
+                {
+                    // worst aspect ratio after collapse
+                    ar1 = std::max(ar1, aspect_ratio(f, moved[k], p));
+                    // worst aspect ratio before collapse
+                    ar0 = std::max(ar0, aspect_ratio(f, moved[k],
+                                                     vpoint_[moved[k]]));
+                }
             }
         }
 
@@ -390,58 +887,78 @@ bool SurfaceSimplification::is_collapse_legal(const CollapseData& cd)
     // check Hausdorff error
     if (hausdorff_error_)
     {
-        Points points;
-        bool ok;
-
-        // collect points to be tested
-        for (auto f : mesh_.faces(cd.v0))
-        {
-            std::copy(face_points_[f].begin(), face_points_[f].end(),
-                      std::back_inserter(points));
-        }
-        points.push_back(vpoint_[cd.v0]);
-
-        // test points against all faces
-        vpoint_[cd.v0] = p1;
-        for (auto point : points)
-        {
-            ok = false;
-
-            for (auto f : mesh_.faces(cd.v0))
+        // test a point against all faces
+        auto is_close = [&](const Point& point) {
+            for (int k = 0; k < n_moved; ++k)
             {
-                if (f != cd.fl && f != cd.fr)
+                for (auto f : mesh_.faces(moved[k]))
                 {
-                    if (distance(f, point) < hausdorff_error_)
+                    if (f != cd.fl && f != cd.fr)
                     {
-                        ok = true;
-                        break;
+                        if (distance(f, point, moved[k], &p) < hausdorff_error_)
+                            return true;
                     }
                 }
             }
+            return false;
+        };
 
-            if (!ok)
+        // test the points of all incident faces and the moved vertices
+        for (int k = 0; k < n_moved; ++k)
+        {
+            for (auto f : mesh_.faces(moved[k]))
             {
-                vpoint_[cd.v0] = p0;
-                return false;
+                if (k == 1 && (f == cd.fl || f == cd.fr))
+                    continue;
+
+                for (IndexType i = face_points_[f]; i != PMP_MAX_INDEX;
+                     i = next_point_[i])
+                {
+                    if (!is_close(points_[i]))
+                        return false;
+                }
             }
         }
-        vpoint_[cd.v0] = p0;
+        if (!is_close(p0) || (n_moved == 2 && !is_close(p1)))
+            return false;
     }
 
     // collapse passed all tests -> ok
     return true;
 }
 
-float SurfaceSimplification::priority(const CollapseData& cd)
+float SurfaceSimplification::priority(const CollapseData& cd) const
 {
     // computer quadric error metric
     Quadric Q = vquadric_[cd.v0];
     Q += vquadric_[cd.v1];
-    return Q(vpoint_[cd.v1]);
+    return Q(cd.target);
+}
+
+IndexType SurfaceSimplification::store_points(const CollapseData& cd)
+{
+    if (!hausdorff_error_)
+        return PMP_MAX_INDEX;
+
+    points_.push_back(vpoint_[cd.v0]);
+    next_point_.push_back(PMP_MAX_INDEX);
+
+    // the original position of a moved vertex
+    if (cd.target != vpoint_[cd.v1])
+    {
+        points_.push_back(vpoint_[cd.v1]);
+        next_point_.push_back(IndexType(points_.size() - 2));
+    }
+
+    return IndexType(points_.size() - 1);
 }
 
-void SurfaceSimplification::postprocess_collapse(const CollapseData& cd)
+void SurfaceSimplification::postprocess_collapse(const CollapseData& cd,
+                                                 IndexType points)
 {
+    // move the remaining vertex
+    vpoint_[cd.v1] = cd.target;
+
     // update error quadrics
     vquadric_[cd.v1] += vquadric_[cd.v0];
 
@@ -472,46 +989,43 @@ void SurfaceSimplification::postprocess_collapse(const CollapseData& cd)
     // update Hausdorff error
     if (hausdorff_error_)
     {
-        Points points;
-
-        // collect points to be distributed
+        // collect points to be distributed in one list, starting with the
+        // removed vertices
+        auto collect = [&](Face f) {
+            IndexType i = face_points_[f];
+            while (i != PMP_MAX_INDEX)
+            {
+                const IndexType next = next_point_[i];
+                next_point_[i] = points;
+                points = i;
+                i = next;
+            }
+            face_points_[f] = PMP_MAX_INDEX;
+        };
 
         // points of v1's one-ring
         for (auto f : mesh_.faces(cd.v1))
-        {
-            std::copy(face_points_[f].begin(), face_points_[f].end(),
-                      std::back_inserter(points));
-            face_points_[f].clear();
-        }
+            collect(f);
 
         // points of the 2 removed triangles
         if (cd.fl.is_valid())
-        {
-            std::copy(face_points_[cd.fl].begin(), face_points_[cd.fl].end(),
-                      std::back_inserter(points));
-            Points().swap(face_points_[cd.fl]); // free mem
-        }
+            collect(cd.fl);
         if (cd.fr.is_valid())
-        {
-            std::copy(face_points_[cd.fr].begin(), face_points_[cd.fr].end(),
-                      std::back_inserter(points));
-            Points().swap(face_points_[cd.fr]); // free mem
-        }
-
-        // the removed vertex
-        points.push_back(vpoint_[cd.v0]);
+            collect(cd.fr);
 
-        // test points against all faces
+        // move each point to the closest face
         Scalar d, dd;
         Face ff;
 
-        for (auto point : points)
+        while (points != PMP_MAX_INDEX)
         {
+            const IndexType i = points;
+            points = next_point_[i];
             dd = std::numeric_limits<Scalar>::max();
 
             for (auto f : mesh_.faces(cd.v1))
             {
-                d = distance(f, point);
+                d = distance(f, points_[i]);
                 if (d < dd)
                 {
                     ff = f;
@@ -519,22 +1033,44 @@ void SurfaceSimplification::postprocess_collapse(const CollapseData& cd)
                 }
             }
 
-            face_points_[ff].push_back(point);
+            next_point_[i] = face_points_[ff];
+            face_points_[ff] = i;
         }
     }
 }
 
-Scalar SurfaceSimplification::aspect_ratio(Face f) const
+void SurfaceSimplification::triangle(Face f, Vertex v, const Point* p,
+                                     Point& p0, Point& p1, Point& p2) const
+{
+    SurfaceMesh::VertexAroundFaceCirculator fvit = mesh_.vertices(f);
+
+    const Vertex v0 = *fvit;
+    const Vertex v1 = *(++fvit);
+    const Vertex v2 = *(++fvit);
+
+    p0 = (p && v0 == v) ? *p : vpoint_[v0];
+    p1 = (p && v1 == v) ? *p : vpoint_[v1];
+    p2 = (p && v2 == v) ? *p : vpoint_[v2];
+}
+
+Normal SurfaceSimplification::face_normal(Face f, Vertex v,
+                                          const Point& p) const
+{
+    // same as SurfaceNormals::compute_face_normal() for triangles
+    Point p0, p1, p2;
+    triangle(f, v, &p, p0, p1, p2);
+    return normalize(cross(p2 - p1, p0 - p1));
+}
+
+Scalar SurfaceSimplification::aspect_ratio(Face f, Vertex v,
+                                           const Point& p) const
 {
     // min height is area/maxLength
     // aspect ratio = length / height
     //              = length * length / area
 
-    SurfaceMesh::VertexAroundFaceCirculator fvit = mesh_.vertices(f);
-
-    const Point p0 = vpoint_[*fvit];
-    const Point p1 = vpoint_[*(++fvit)];
-    const Point p2 = vpoint_[*(++fvit)];
+    Point p0, p1, p2;
+    triangle(f, v, &p, p0, p1, p2);
 
     const Point d0 = p0 - p1;
     const Point d1 = p1 - p2;
@@ -553,13 +1089,11 @@ Scalar SurfaceSimplification::aspect_ratio(Face f) const
     return l / a;
 }
 
-Scalar SurfaceSimplification::distance(Face f, const Point& p) const
+Scalar SurfaceSimplification::distance(Face f, const Point& p, Vertex v,
+                                       const Point* q) const
 {
-    SurfaceMesh::VertexAroundFaceCirculator fvit = mesh_.vertices(f);
-
-    const Point p0 = vpoint_[*fvit];
-    const Point p1 = vpoint_[*(++fvit)];
-    const Point p2 = vpoint_[*(++fvit)];
+    Point p0, p1, p2;
+    triangle(f, v, q, p0, p1, p2);
 
     Point n;
 
@@ -573,6 +1107,7 @@ SurfaceSimplification::CollapseData::CollapseData(SurfaceMesh& sm, Halfedge h)
     v1v0 = mesh.opposite_halfedge(v0v1);
     v0 = mesh.to_vertex(v1v0);
     v1 = mesh.to_vertex(v0v1);
+    target = mesh.position(v1);
     fl = mesh.face(v0v1);
     fr = mesh.face(v1v0);
 
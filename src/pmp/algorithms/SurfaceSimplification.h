@@ -3,12 +3,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <set>
 #include <vector>
 
 #include "pmp/SurfaceMesh.h"
 #include "pmp/algorithms/Heap.h"
 #include "pmp/algorithms/NormalCone.h"
+#include "pmp/algorithms/ProgressiveMesh.h"
 #include "pmp/algorithms/Quadric.h"
 
 namespace pmp {
@@ -30,15 +32,159 @@ public:
     //! Destructor.
     ~SurfaceSimplification();
 
-    //! Initialize with given parameters.
+    //! \brief Initialize with given parameters.
+    //! \details By default, a halfedge collapse keeps the position of the
+    //! remaining vertex. With \p optimal_placement, the remaining vertex is
+    //! moved to the position minimizing the combined error quadric, which
+    //! yields a lower approximation error at a higher cost per collapse.
+    //! Boundary, feature, and unselected vertices are never moved. A
+    //! ProgressiveMesh recorded with optimal placement keeps the original
+    //! vertex positions.
     void initialize(Scalar aspect_ratio = 0.0, Scalar edge_length = 0.0,
                     unsigned int max_valence = 0, Scalar normal_deviation = 0.0,
-                    Scalar hausdorff_error = 0.0);
+                    Scalar hausdorff_error = 0.0,
+                    bool optimal_placement = false);
 
     //! Simplify mesh to \p n_vertices.
     void simplify(unsigned int n_vertices);
 
+    //! \brief Simplify mesh until the first of the given targets is reached.
+    //! \details Stops when the mesh has \p n_vertices vertices or \p n_faces
+    //! faces, or before the first collapse whose quadric error, i.e., the sum
+    //! of squared distances to the planes of the merged original faces,
+    //! exceeds \p max_error. A zero disables a target. A Hausdorff error
+    //! budget is set by initialize(), simplifying with all targets disabled
+    //! then collapses until the budget is exhausted. If \p progressive_mesh
+    //! is given, it is reset to the input mesh and records the collapses,
+    //! such that every intermediate level of detail can be extracted later.
+    //! \throw CancelledException if cancelled, see set_progress()
+    void simplify(unsigned int n_vertices, unsigned int n_faces,
+                  Scalar max_error,
+                  ProgressiveMesh* progressive_mesh = nullptr);
+
+    //! \brief Simplify mesh in parallel batches of independent collapses.
+    //! \details Takes the same targets as simplify(). Each round evaluates
+    //! the changed collapse targets in parallel, selects the cheapest quarter
+    //! of all legal collapses, and performs those of them whose one-rings do
+    //! not overlap. This uses the same legality checks and error quadrics as
+    //! simplify(), but does not strictly follow the greedy order, so the
+    //! result differs slightly. Considerably faster on large meshes.
+    //! \sa IndependentSetScheduler
+    //! \throw CancelledException if cancelled, see set_progress()
+    void simplify_parallel(unsigned int n_vertices, unsigned int n_faces = 0,
+                           Scalar max_error = 0,
+                           ProgressiveMesh* progressive_mesh = nullptr);
+
+    //! settings of simplify_batch(), see initialize() and simplify()
+    struct BatchSettings
+    {
+        //! \brief Target number of vertices relative to the vertices of each
+        //! mesh.
+        //! \details Zero disables the target, such that only \p max_error
+        //! stops the simplification.
+        Scalar ratio = 0.5;
+
+        Scalar max_error = 0;           //!< quadric error budget
+        Scalar aspect_ratio = 0;        //!< maximum aspect ratio
+        Scalar edge_length = 0;         //!< maximum edge length
+        unsigned int max_valence = 0;   //!< maximum vertex valence
+        Scalar normal_deviation = 0;    //!< maximum normal deviation in degrees
+        Scalar hausdorff_error = 0;     //!< maximum Hausdorff error
+        bool optimal_placement = false; //!< move the remaining vertices
+    };
+
+    //! \brief Simplify many small meshes concurrently.
+    //! \details Each mesh is simplified by simplify() as by its own
+    //! SurfaceSimplification and yields the same result, but the meshes are
+    //! distributed over the threads of the parallel loops, see Parallel, in
+    //! chunks of consecutive meshes. The meshes of a chunk share the error
+    //! quadrics, collapse targets, point lists, and priority queue, which
+    //! only grow to the largest mesh instead of being allocated and freed for
+    //! each mesh. Worthwhile for thousands of meshes of up to a few thousand
+    //! vertices, large meshes are better simplified one by one.
+    //! \throw InvalidInputException if a mesh is not a pure triangle mesh.
+    //! The meshes are unchanged in this case.
+    static void simplify_batch(std::vector<SurfaceMesh>& meshes,
+                               const BatchSettings& settings);
+
+    //! \brief Re-evaluate the changed collapses of simplify() lazily.
+    //! \details By default, each collapse immediately recomputes the best
+    //! collapse of every vertex around it and updates the queue. In lazy
+    //! mode, the vertices already in the queue are only marked as stale and
+    //! re-evaluated once they reach its front, so candidates that are never
+    //! popped are not evaluated again. Vertices not in the queue are still
+    //! evaluated immediately. A stale vertex keeps its old position in the
+    //! queue, so the greedy order is only approximated and the result
+    //! differs slightly. Used by subsequent calls of simplify().
+    void set_lazy_updates(bool lazy) { lazy_updates_ = lazy; }
+
+    //! \brief Report the progress of subsequent simplifications.
+    //! \details Polled every 256 collapse candidates, or once per round of
+    //! simplify_parallel(). A cancelled simplification keeps the collapses
+    //! performed so far. See ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
+
+    //! operation counts and phase times of a simplification
+    struct Statistics
+    {
+        unsigned int n_collapses = 0; //!< number of performed collapses
+
+        //! collapses checked by the fairness and error criteria
+        size_t n_legality_tests = 0;
+
+        //! collapses rejected by the fairness and error criteria
+        size_t n_rejected = 0;
+
+        //! collapses rejected by the topology check when performed
+        unsigned int n_invalid = 0;
+
+        //! insertions, updates, and removals of the priority queue
+        size_t n_queue_updates = 0;
+
+        //! stale vertices re-evaluated at the front of the queue, see
+        //! set_lazy_updates()
+        size_t n_stale = 0;
+
+        //! rounds of simplify_parallel()
+        unsigned int n_rounds = 0;
+
+        //! collapses of simplify_parallel() postponed to a later round
+        //! because their one-ring overlaps one of the current batch
+        size_t n_conflicts = 0;
+
+        //! time of initialize() in milliseconds
+        double initialize_time = 0;
+
+        //! time of finding the collapse targets and building the queue, or
+        //! of selecting the batches, in milliseconds
+        double queue_time = 0;
+
+        //! time of performing the collapses and updating the targets in
+        //! milliseconds
+        double collapse_time = 0;
+
+        //! peak memory of the simplification in addition to the memory in
+        //! use when it started, in bytes, see MemoryScope
+        size_t peak_memory = 0;
+    };
+
+    //! \brief Statistics of the last simplification.
+    //! \details Includes the latest initialize(). The counters are always
+    //! maintained, their cost is negligible compared to the checks they
+    //! count.
+    const Statistics& statistics() const { return statistics_; }
+
 private:
+    // scratch memory reused by consecutive simplifications, see
+    // simplify_batch()
+    class Workspace;
+
+    // construct with the scratch memory of workspace, if not nullptr
+    SurfaceSimplification(SurfaceMesh& mesh, Workspace* workspace);
+
     // Store data for an halfedge collapse
     struct CollapseData
     {
@@ -67,48 +213,74 @@ private:
         Vertex vl;     // Left vertex
         Vertex vr;     // Right vertex
         Halfedge v1vl, vlv0, v0vr, vrv1;
+        Point target;  // Position of v1 after the collapse
     };
 
-    // Heap interface
-    class HeapInterface
-    {
-    public:
-        HeapInterface(VertexProperty<float> prio, VertexProperty<int> pos)
-            : prio_(prio), pos_(pos)
-        {
-        }
-
-        bool less(Vertex v0, Vertex v1) { return prio_[v0] < prio_[v1]; }
-        bool greater(Vertex v0, Vertex v1) { return prio_[v0] > prio_[v1]; }
-        int get_heap_position(Vertex v) { return pos_[v]; }
-        void set_heap_position(Vertex v, int pos) { pos_[v] = pos; }
-
-    private:
-        VertexProperty<float> prio_;
-        VertexProperty<int> pos_;
-    };
+    // priority queue of vertices, sorted by the priority of their collapse
+    typedef DAryHeap<Vertex, float> PriorityQueue;
+
+    // reset the statistics, except for the time of initialize()
+    void reset_statistics();
+
+    // add the vertex property name to the mesh or to the workspace
+    template <class T>
+    VertexProperty<T> add_vertex_scratch(const std::string& name);
 
-    typedef Heap<Vertex, HeapInterface> PriorityQueue;
+    // get or add the face property name in the mesh or in the workspace
+    template <class T>
+    FaceProperty<T> face_scratch(const std::string& name);
 
-    typedef std::vector<Point> Points;
+    // remove a property added by the functions above from the mesh, the
+    // workspace keeps its properties for the next mesh
+    template <class T>
+    void remove_scratch(VertexProperty<T>& prop);
+    template <class T>
+    void remove_scratch(FaceProperty<T>& prop);
 
     // put the vertex v in the priority queue
     void enqueue_vertex(Vertex v);
 
+    // find the best out-going halfedge of v and its priority, does not
+    // modify the mesh and can be called concurrently
+    Halfedge find_target(Vertex v, float& prio) const;
+
+    // position of the remaining vertex after the collapse
+    Point placement(const CollapseData& cd) const;
+
+    // append the vertices whose target is changed by moving v: v itself, its
+    // one-ring, and the vertices collapsing into its one-ring
+    void moved_region(Vertex v, std::vector<Vertex>& vertices) const;
+
     // is collapsing the halfedge h allowed?
-    bool is_collapse_legal(const CollapseData& cd);
+    bool is_collapse_legal(const CollapseData& cd) const;
 
     // what is the priority of collapsing the halfedge h
-    float priority(const CollapseData& cd);
+    float priority(const CollapseData& cd) const;
+
+    // store the positions of the removed vertex and, if it is moved, of the
+    // remaining vertex for the Hausdorff error check, returns the index of
+    // their list in the point pool
+    IndexType store_points(const CollapseData& cd);
+
+    // postprocess halfedge collapse, points is the pool index returned by
+    // store_points()
+    void postprocess_collapse(const CollapseData& cd, IndexType points);
 
-    // postprocess halfedge collapse
-    void postprocess_collapse(const CollapseData& cd);
+    // get the corners of triangle f, with vertex v moved to *p unless p is
+    // null
+    void triangle(Face f, Vertex v, const Point* p, Point& p0, Point& p1,
+                  Point& p2) const;
 
-    // compute aspect ratio for face f
-    Scalar aspect_ratio(Face f) const;
+    // compute normal of triangle f, with vertex v moved to p
+    Normal face_normal(Face f, Vertex v, const Point& p) const;
 
-    // compute distance from point p to triangle f
-    Scalar distance(Face f, const Point& p) const;
+    // compute aspect ratio for face f, with vertex v moved to p
+    Scalar aspect_ratio(Face f, Vertex v, const Point& p) const;
+
+    // compute distance from point p to triangle f, with vertex v moved to
+    // *q unless q is null
+    Scalar distance(Face f, const Point& p, Vertex v = Vertex(),
+                    const Point* q = nullptr) const;
 
     SurfaceMesh& mesh_;
 
@@ -116,10 +288,14 @@ private:
 
     VertexProperty<float> vpriority_;
     VertexProperty<Halfedge> vtarget_;
-    VertexProperty<int> heap_pos_;
     VertexProperty<Quadric> vquadric_;
     FaceProperty<NormalCone> normal_cone_;
-    FaceProperty<Points> face_points_;
+
+    // positions of the removed vertices, in singly linked lists per face
+    // starting at face_points_ and continued by next_point_
+    FaceProperty<IndexType> face_points_;
+    std::vector<Point> points_;
+    std::vector<IndexType> next_point_;
 
     VertexProperty<Point> vpoint_;
     FaceProperty<Point> fnormal_;
@@ -129,6 +305,16 @@ private:
 
     PriorityQueue* queue_;
 
+    // shared scratch memory, nullptr if the properties are added to the mesh
+    Workspace* workspace_;
+
+    Statistics statistics_;
+    ProgressCallback progress_;
+
+    // counters updated by the concurrent calls of find_target()
+    mutable std::atomic<size_t> n_legality_tests_;
+    mutable std::atomic<size_t> n_rejected_;
+
     bool has_selection_;
     bool has_features_;
     Scalar normal_deviation_;
@@ -136,6 +322,8 @@ private:
     Scalar aspect_ratio_;
     Scalar edge_length_;
     unsigned int max_valence_;
+    bool optimal_placement_;
+    bool lazy_updates_;
 };
 
 } // namespace pmp
@@ -3,20 +3,39 @@
 
 #include "pmp/algorithms/SurfaceSmoothing.h"
 
+#include <algorithm>
+#include <utility>
+
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 
 #include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/GeometryCache.h"
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/LinearSolver.h"
+#include "pmp/CoordinateArrays.h"
+#include "pmp/EigenMaps.h"
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
 
 namespace pmp {
 
 using SparseMatrix = Eigen::SparseMatrix<double>;
-using Triplet = Eigen::Triplet<double>;
+
+// factorization of the matrix of implicit smoothing
+struct SurfaceSmoothing::Factorization
+{
+    SparseMatrix matrix;
+    LinearSolver solver;
+};
 
 SurfaceSmoothing::SurfaceSmoothing(SurfaceMesh& mesh) : mesh_(mesh)
 {
     how_many_edge_weights_ = 0;
     how_many_vertex_weights_ = 0;
+    laplace_uniform_ = false;
+    how_many_laplace_vertices_ = 0;
+    how_many_laplace_edges_ = 0;
 }
 
 SurfaceSmoothing::~SurfaceSmoothing()
@@ -41,8 +60,10 @@ void SurfaceSmoothing::compute_edge_weights(bool use_uniform_laplace)
     }
     else
     {
+        GeometryCache cache(mesh_);
+        cache.update();
         for (auto e : mesh_.edges())
-            eweight[e] = std::max(0.0, cotan_weight(mesh_, e));
+            eweight[e] = std::max(0.0, cache.cotan_weight(e));
     }
 
     how_many_edge_weights_ = mesh_.n_edges();
@@ -59,8 +80,10 @@ void SurfaceSmoothing::compute_vertex_weights(bool use_uniform_laplace)
     }
     else
     {
+        GeometryCache cache(mesh_);
+        cache.update();
         for (auto v : mesh_.vertices())
-            vweight[v] = 0.5 / voronoi_area(mesh_, v);
+            vweight[v] = 0.5 / cache.voronoi_area(v);
     }
 
     how_many_vertex_weights_ = mesh_.n_vertices();
@@ -69,6 +92,8 @@ void SurfaceSmoothing::compute_vertex_weights(bool use_uniform_laplace)
 void SurfaceSmoothing::explicit_smoothing(unsigned int iters,
                                           bool use_uniform_laplace)
 {
+    PMP_PROFILE_SCOPE("SurfaceSmoothing::explicit_smoothing");
+
     if (!mesh_.n_vertices())
         return;
 
@@ -77,61 +102,104 @@ void SurfaceSmoothing::explicit_smoothing(unsigned int iters,
         how_many_edge_weights_ != mesh_.n_edges())
         compute_edge_weights(use_uniform_laplace);
 
-    auto points = mesh_.get_vertex_property<Point>("v:point");
-    auto eweight = mesh_.get_edge_property<Scalar>("e:cotan");
-    auto laplace = mesh_.add_vertex_property<Point>("v:laplace");
+    const auto eweight = mesh_.get_edge_property<Scalar>("e:cotan");
 
-    // smoothing iterations
-    Vertex vv;
-    Edge e;
-    for (unsigned int i = 0; i < iters; ++i)
+    // move the interior vertices, only the selected ones if there are any
+    auto vselected = mesh_.get_vertex_property<bool>("v:selected");
+    bool no_selection = true;
+    if (vselected)
     {
-        // step 1: compute Laplace for each vertex
         for (auto v : mesh_.vertices())
         {
-            Point l(0, 0, 0);
-
-            if (!mesh_.is_boundary(v))
+            if (vselected[v])
             {
-                Scalar w(0);
+                no_selection = false;
+                break;
+            }
+        }
+    }
+    std::vector<IndexType> vertices;
+    for (auto v : mesh_.vertices())
+        if (!mesh_.is_boundary(v) && (no_selection || vselected[v]))
+            vertices.push_back(v.idx());
+
+    // flatten their weighted one-rings
+    const int n = int(vertices.size());
+    std::vector<size_t> offsets(n + 1, 0);
+    for (int i = 0; i < n; ++i)
+        offsets[i + 1] = offsets[i] + mesh_.valence(Vertex(vertices[i]));
+
+    std::vector<IndexType> neighbors(offsets[n]);
+    std::vector<Scalar> weights(offsets[n]);
+    parallel_for(0, n, [&](int i) {
+        size_t j = offsets[i];
+        for (auto h : mesh_.halfedges(Vertex(vertices[i])))
+        {
+            neighbors[j] = mesh_.to_vertex(h).idx();
+            weights[j] = eweight[mesh_.edge(h)];
+            ++j;
+        }
+    });
+
+    // iterate on two struct-of-arrays copies of the coordinates: each
+    // iteration reads the positions from one and writes the moved vertices
+    // to the other, the fixed vertices are the same in both
+    CoordinateArrays coords(mesh_);
+    CoordinateArrays moved(coords);
+    Scalar* p[3] = {coords.x(), coords.y(), coords.z()};
+    Scalar* q[3] = {moved.x(), moved.y(), moved.z()};
+
+    unsigned int iter = 0;
+    bool cancelled = false;
+    for (; iter < iters; ++iter)
+    {
+        if (progress_ && !progress_(float(iter) / float(iters)))
+        {
+            cancelled = true;
+            break;
+        }
 
-                for (auto h : mesh_.halfedges(v))
+        // move each vertex by its (damped) Laplacian
+        parallel_for(0, n, [&](int i) {
+            const IndexType v = vertices[i];
+            const size_t begin = offsets[i], end = offsets[i + 1];
+            for (int k = 0; k < 3; ++k)
+            {
+                const Scalar pk = p[k][v];
+                Scalar lk(0), w(0);
+                for (size_t j = begin; j < end; ++j)
                 {
-                    vv = mesh_.to_vertex(h);
-                    e = mesh_.edge(h);
-                    l += eweight[e] * (points[vv] - points[v]);
-                    w += eweight[e];
+                    lk += weights[j] * (p[k][neighbors[j]] - pk);
+                    w += weights[j];
                 }
-
-                l /= w;
+                lk /= w;
+                q[k][v] = pk + Scalar(0.5f) * lk;
             }
+        });
 
-            laplace[v] = l;
-        }
-
-        // step 2: move each vertex by its (damped) Laplacian
-        for (auto v : mesh_.vertices())
-        {
-            points[v] += 0.5f * laplace[v];
-        }
+        for (int k = 0; k < 3; ++k)
+            std::swap(p[k], q[k]);
     }
 
-    // clean-up custom properties
-    mesh_.remove_vertex_property(laplace);
+    // the last positions are in the buffer read next
+    if (iter % 2)
+        moved.scatter(mesh_);
+    else
+        coords.scatter(mesh_);
+
+    if (cancelled)
+        throw CancelledException("SurfaceSmoothing: Cancelled.");
 }
 
 void SurfaceSmoothing::implicit_smoothing(Scalar timestep,
                                           bool use_uniform_laplace,
                                           bool rescale)
 {
+    PMP_PROFILE_SCOPE("SurfaceSmoothing::implicit_smoothing");
+
     if (!mesh_.n_vertices())
         return;
 
-    // compute edge weights if they don't exist or if the mesh changed
-    if (!mesh_.has_edge_property("e:cotan") ||
-        how_many_edge_weights_ != mesh_.n_edges())
-        compute_edge_weights(use_uniform_laplace);
-
     // compute vertex weights
     compute_vertex_weights(use_uniform_laplace);
 
@@ -147,89 +215,84 @@ void SurfaceSmoothing::implicit_smoothing(Scalar timestep,
     // properties
     auto points = mesh_.get_vertex_property<Point>("v:point");
     auto vweight = mesh_.get_vertex_property<Scalar>("v:area");
-    auto eweight = mesh_.get_edge_property<Scalar>("e:cotan");
-    auto idx = mesh_.add_vertex_property<int>("v:idx", -1);
 
     // collect free (non-boundary) vertices in array free_vertices[]
-    // assign indices such that idx[ free_vertices[i] ] == i
-    unsigned i = 0;
     std::vector<Vertex> free_vertices;
     free_vertices.reserve(mesh_.n_vertices());
     for (auto v : mesh_.vertices())
     {
         if (!mesh_.is_boundary(v))
-        {
-            idx[v] = i++;
             free_vertices.push_back(v);
-        }
     }
     const unsigned int n = free_vertices.size();
 
-    // A*X = B
-    SparseMatrix A(n, n);
-    Eigen::MatrixXd B(n, 3);
-
-    // nonzero elements of A as triplets: (row, column, value)
-    std::vector<Triplet> triplets;
-
-    // setup matrix A and rhs B
-    dvec3 b;
-    double ww;
-    Vertex v, vv;
-    Edge e;
-    for (unsigned int i = 0; i < n; ++i)
+    // set up the Laplacian L, or refill the one of the previous call if the
+    // mesh did not change
+    const bool new_pattern = !laplace_ ||
+                             laplace_uniform_ != use_uniform_laplace ||
+                             how_many_laplace_vertices_ != mesh_.n_vertices() ||
+                             how_many_laplace_edges_ != mesh_.n_edges();
+    if (new_pattern)
     {
-        v = free_vertices[i];
-
-        // rhs row
-        b = static_cast<dvec3>(points[v]) / vweight[v];
+        laplace_.reset(new LaplaceOperator(mesh_, free_vertices, 1,
+                                           use_uniform_laplace));
+        laplace_uniform_ = use_uniform_laplace;
+        how_many_laplace_vertices_ = mesh_.n_vertices();
+        how_many_laplace_edges_ = mesh_.n_edges();
+    }
+    else
+    {
+        laplace_->update();
+    }
 
-        // lhs row
-        ww = 0.0;
-        for (auto h : mesh_.halfedges(v))
-        {
-            vv = mesh_.to_vertex(h);
-            e = mesh_.edge(h);
-            ww += eweight[e];
+    if (progress_ && !progress_(0.2f))
+        throw CancelledException("SurfaceSmoothing: Cancelled.");
 
-            // fixed boundary vertex -> right hand side
-            if (mesh_.is_boundary(vv))
-            {
-                b -= -timestep * eweight[e] * static_cast<dvec3>(points[vv]);
-            }
-            // free interior vertex -> matrix
-            else
-            {
-                triplets.emplace_back(i, idx[vv], -timestep * eweight[e]);
-            }
-
-            B.row(i) = (Eigen::Vector3d)b;
-        }
+    // A = D - timestep * L, with the inverse vertex weights in D
+    SparseMatrix A = -timestep * laplace_->matrix();
+    for (unsigned int i = 0; i < n; ++i)
+        A.coeffRef(i, i) += 1.0 / vweight[free_vertices[i]];
 
-        // center vertex -> matrix
-        triplets.emplace_back(i, i, 1.0 / vweight[v] + timestep * ww);
+    // A has the pattern of L, so keep the symbolic analysis until L is set
+    // up again, and the numeric factorization while A stays the same, e.g.,
+    // for uniform weights and a fixed timestep
+    if (new_pattern || !factorization_ ||
+        factorization_->solver.type() != LinearSolver::default_type())
+    {
+        factorization_.reset(new Factorization);
+        factorization_->solver.compute(A);
+        factorization_->matrix = std::move(A);
+    }
+    else if (!std::equal(A.valuePtr(), A.valuePtr() + A.nonZeros(),
+                         factorization_->matrix.valuePtr()))
+    {
+        factorization_->solver.factorize(A);
+        factorization_->matrix = std::move(A);
     }
 
-    // build sparse matrix from triplets
-    A.setFromTriplets(triplets.begin(), triplets.end());
+    if (progress_ && !progress_(0.8f))
+        throw CancelledException("SurfaceSmoothing: Cancelled.");
+
+    // B = D * X + timestep * L_c * X_c for the fixed boundary vertices X_c
+    Eigen::MatrixXd X = gather_rows(points, free_vertices);
+    Eigen::MatrixXd B(n, 3);
+    for (unsigned int i = 0; i < n; ++i)
+        B.row(i) = X.row(i) / double(vweight[free_vertices[i]]);
+    const Eigen::MatrixXd C =
+        gather_rows(points, laplace_->constraint_vertices());
+    B += timestep * (laplace_->constraint_matrix() * C);
 
-    // solve A*X = B
-    Eigen::SimplicialLDLT<SparseMatrix> solver(A);
-    Eigen::MatrixXd X = solver.solve(B);
-    if (solver.info() != Eigen::Success)
+    // solve A*X = B, starting from the current positions
+    if (!factorization_->solver.solve(B, X))
     {
-        // clean-up
-        mesh_.remove_vertex_property(idx);
+        factorization_.reset();
         auto what = "SurfaceSmoothing: Failed to solve linear system.";
         throw SolverException(what);
     }
     else
     {
         // copy solution
-        for (unsigned int i = 0; i < n; ++i)
-        {
-            points[free_vertices[i]] = X.row(i);
-        }
+        scatter_rows(X, free_vertices, points);
     }
 
     if (rescale)
@@ -246,9 +309,6 @@ void SurfaceSmoothing::implicit_smoothing(Scalar timestep,
         for (auto v : mesh_.vertices())
             mesh_.position(v) += trans;
     }
-
-    // clean-up
-    mesh_.remove_vertex_property(idx);
 }
 
 } // namespace pmp
@@ -3,10 +3,14 @@
 
 #pragma once
 
+#include <memory>
+
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
 
+class LaplaceOperator;
+
 //! \brief A class for Laplacian smoothing
 //! \details See also \cite desbrun_1999_implicit and \cite kazhdan_2012
 //! \ingroup algorithms
@@ -21,6 +25,9 @@ public:
 
     //! Perform \p iters iterations of explicit Laplacian smoothing.
     //! Decide whether to use uniform Laplacian or cotan Laplacian (default: cotan).
+    //! If vertices are selected by the \c "v:selected" property, only the
+    //! selected vertices are moved. Boundary vertices are never moved.
+    //! \throw CancelledException if cancelled, see set_progress()
     void explicit_smoothing(unsigned int iters = 10,
                             bool use_uniform_laplace = false);
 
@@ -29,10 +36,21 @@ public:
     //! \param use_uniform_laplace Decide whether to use uniform Laplacian or cotan Laplacian. Default: cotan.
     //! \param rescale Decide whether to re-center and re-scale model after smoothing. Default: true.
     //! \throw SolverException in case of a failure to solve the linear system.
+    //! \throw CancelledException if cancelled, see set_progress()
     void implicit_smoothing(Scalar timestep = 0.001,
                             bool use_uniform_laplace = false,
                             bool rescale = true);
 
+    //! \brief Report the progress of subsequent smoothing.
+    //! \details Explicit smoothing polls after each iteration and keeps the
+    //! iterations performed so far when cancelled. Implicit smoothing polls
+    //! after setting up and after factorizing the linear system and leaves
+    //! the mesh unchanged when cancelled. See ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
+
     //! Initialize edge and vertex weights.
     void initialize(bool use_uniform_laplace = false)
     {
@@ -55,6 +73,21 @@ private:
     // recompute if numbers change (i.e. mesh has changed)
     unsigned int how_many_edge_weights_;
     unsigned int how_many_vertex_weights_;
+
+    // Laplacian of implicit smoothing, refilled while the mesh size and the
+    // kind of weights stay the same
+    std::unique_ptr<LaplaceOperator> laplace_;
+    bool laplace_uniform_;
+    unsigned int how_many_laplace_vertices_;
+    unsigned int how_many_laplace_edges_;
+
+    // factorization of the last implicit smoothing matrix, its symbolic
+    // analysis is kept while the Laplacian is, its numeric factorization
+    // while the matrix stays the same
+    struct Factorization;
+    std::unique_ptr<Factorization> factorization_;
+
+    ProgressCallback progress_;
 };
 
 } // namespace pmp
@@ -3,237 +3,474 @@
 
 #include "pmp/algorithms/SurfaceSubdivision.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "pmp/Parallel.h"
+#include "pmp/Profiler.h"
+#include "pmp/algorithms/SurfaceCurvature.h"
+
 namespace pmp {
 
-SurfaceSubdivision::SurfaceSubdivision(SurfaceMesh& mesh) : mesh_(mesh)
+namespace {
+
+// connectivity of the mesh before a step, read while the mesh is rebuilt
+struct Connectivity
 {
-    points_ = mesh_.vertex_property<Point>("v:point");
-    vfeature_ = mesh_.get_vertex_property<bool>("v:feature");
-    efeature_ = mesh_.get_edge_property<bool>("e:feature");
-}
+    explicit Connectivity(const SurfaceMesh& mesh)
+    {
+        const int nv = int(mesh.vertices_size());
+        const int nh = int(mesh.halfedges_size());
+        const int nf = int(mesh.faces_size());
+
+        vertex_halfedge.resize(nv);
+        parallel_for(0, nv, [&](int i) {
+            vertex_halfedge[i] = mesh.halfedge(Vertex(i));
+        });
+
+        to_vertex.resize(nh);
+        next.resize(nh);
+        face.resize(nh);
+        parallel_for(0, nh, [&](int i) {
+            to_vertex[i] = mesh.to_vertex(Halfedge(i));
+            next[i] = mesh.next_halfedge(Halfedge(i));
+            face[i] = mesh.face(Halfedge(i));
+        });
+
+        // number the halfedges of the faces consecutively
+        face_halfedge.resize(nf);
+        face_offset.assign(nf + 1, 0);
+        parallel_for(0, nf, [&](int i) {
+            face_halfedge[i] = mesh.halfedge(Face(i));
+            face_offset[i + 1] = mesh.valence(Face(i));
+        });
+        for (int i = 0; i < nf; ++i)
+            face_offset[i + 1] += face_offset[i];
+    }
 
-void SurfaceSubdivision::catmull_clark()
+    std::vector<Halfedge> vertex_halfedge;
+    std::vector<Vertex> to_vertex;
+    std::vector<Halfedge> next;
+    std::vector<Face> face;
+    std::vector<Halfedge> face_halfedge;
+
+    // index of the first halfedge of each face among the halfedges of all
+    // faces, followed by their number
+    std::vector<IndexType> face_offset;
+};
+
+// Splitting edge e at its new vertex m keeps the index of e for the edge
+// towards its first vertex and appends the edge towards its second vertex.
+// The halfedge h of e is split into first_half(h) and second_half(h).
+class EdgeSplit
 {
-    // reserve memory
-    size_t nv = mesh_.n_vertices();
-    size_t ne = mesh_.n_edges();
-    size_t nf = mesh_.n_faces();
-    mesh_.reserve(nv + ne + nf, 2 * ne + 4 * nf, 4 * nf);
+public:
+    EdgeSplit(size_t nvertices, size_t nedges)
+        : nvertices_(IndexType(nvertices)), nedges_(IndexType(nedges))
+    {
+    }
 
-    // get properties
-    auto vpoint = mesh_.add_vertex_property<Point>("catmull:vpoint");
-    auto epoint = mesh_.add_edge_property<Point>("catmull:epoint");
-    auto fpoint = mesh_.add_face_property<Point>("catmull:fpoint");
+    // the vertex splitting the edge of h
+    Vertex vertex(Halfedge h) const { return Vertex(nvertices_ + h.idx() / 2); }
 
-    // compute face vertices
-    for (auto f : mesh_.faces())
+    // the half of h towards the vertex splitting its edge
+    Halfedge first_half(Halfedge h) const
     {
-        Point p(0, 0, 0);
-        Scalar c(0);
-        for (auto v : mesh_.vertices(f))
-        {
-            p += points_[v];
-            ++c;
-        }
-        p /= c;
-        fpoint[f] = p;
+        return h.idx() % 2 ? Halfedge(h.idx() + 2 * nedges_) : h;
     }
 
-    // compute edge vertices
-    for (auto e : mesh_.edges())
+    // the half of h away from the vertex splitting its edge
+    Halfedge second_half(Halfedge h) const
     {
-        // boundary or feature edge?
-        if (mesh_.is_boundary(e) || (efeature_ && efeature_[e]))
-        {
-            epoint[e] = 0.5f * (points_[mesh_.vertex(e, 0)] +
-                                points_[mesh_.vertex(e, 1)]);
-        }
+        return h.idx() % 2 ? h : Halfedge(h.idx() + 2 * nedges_);
+    }
 
-        // interior edge
-        else
-        {
-            Point p(0, 0, 0);
-            p += points_[mesh_.vertex(e, 0)];
-            p += points_[mesh_.vertex(e, 1)];
-            p += fpoint[mesh_.face(e, 0)];
-            p += fpoint[mesh_.face(e, 1)];
-            p *= 0.25f;
-            epoint[e] = p;
-        }
+    // Split all edges, connect the halves on the boundary, and update the
+    // outgoing halfedges of all vertices. These are chosen as splitting the
+    // edges one by one would do, such that the result does not depend on
+    // the implementation.
+    void apply(SurfaceMesh& mesh, const Connectivity& old) const
+    {
+        const int nh = int(2 * nedges_);
+        parallel_for(0, nh, [&](int i) {
+            const Halfedge h(i);
+            mesh.set_vertex(first_half(h), vertex(h));
+            mesh.set_vertex(second_half(h), old.to_vertex[i]);
+            if (!old.face[i].is_valid())
+            {
+                mesh.set_next_halfedge(first_half(h), second_half(h));
+                mesh.set_next_halfedge(second_half(h),
+                                       first_half(old.next[i]));
+                mesh.set_face(first_half(h), Face());
+                mesh.set_face(second_half(h), Face());
+            }
+        });
+
+        // vertices end up with the outgoing half of the last split edge
+        // pointing to them, or the next boundary halfedge clockwise
+        const int nv = int(nvertices_);
+        parallel_for(0, nv, [&](int i) {
+            const Halfedge h = old.vertex_halfedge[i];
+            if (!h.is_valid())
+                return;
+
+            Halfedge last = h;
+            IndexType max_edge = 0;
+            Halfedge o = h;
+            do
+            {
+                const Halfedge in(o.idx() ^ 1);
+                if (in.idx() % 2 == 0 && in.idx() / 2 >= max_edge)
+                {
+                    max_edge = in.idx() / 2;
+                    last = o;
+                }
+                o = old.next[in.idx()];
+            } while (o != h);
+
+            if (!old.face[h.idx()].is_valid())
+            {
+                o = last;
+                while (old.face[o.idx()].is_valid())
+                    o = old.next[o.idx() ^ 1];
+                last = o;
+            }
+            mesh.set_halfedge(Vertex(i), first_half(last));
+        });
+
+        const int ne = int(nedges_);
+        parallel_for(0, ne, [&](int i) {
+            const Halfedge h0(2 * i), h1(2 * i + 1);
+            mesh.set_halfedge(vertex(h0), old.face[h1.idx()].is_valid()
+                                              ? second_half(h0)
+                                              : second_half(h1));
+        });
     }
 
-    // compute new positions for old vertices
-    for (auto v : mesh_.vertices())
+    // The halfedge of the last split edge of face f, which the splits leave
+    // as the halfedge of f.
+    static Halfedge last_split(const Connectivity& old, Face f)
     {
-        // isolated vertex?
-        if (mesh_.is_isolated(v))
+        Halfedge last = old.face_halfedge[f.idx()];
+        Halfedge h = last;
+        do
         {
-            vpoint[v] = points_[v];
-        }
+            if (h.idx() > last.idx())
+                last = h;
+            h = old.next[h.idx()];
+        } while (h != old.face_halfedge[f.idx()]);
+        return last;
+    }
 
-        // boundary vertex?
-        else if (mesh_.is_boundary(v))
-        {
-            auto h1 = mesh_.halfedge(v);
-            auto h0 = mesh_.prev_halfedge(h1);
+private:
+    IndexType nvertices_;
+    IndexType nedges_;
+};
 
-            Point p = points_[v];
-            p *= 6.0;
-            p += points_[mesh_.to_vertex(h1)];
-            p += points_[mesh_.from_vertex(h0)];
-            p *= 0.125;
+// weights of the vertices of the mesh before a step
+class Stencil
+{
+public:
+    Stencil() = default;
 
-            vpoint[v] = p;
-        }
+    explicit Stencil(Vertex v) : terms_(1, std::make_pair(v.idx(), 1.0)) {}
 
-        // interior feature vertex?
-        else if (vfeature_ && vfeature_[v])
-        {
-            Point p = points_[v];
-            p *= 6.0;
-            int count(0);
+    Stencil& operator+=(const Stencil& s)
+    {
+        terms_.insert(terms_.end(), s.terms_.begin(), s.terms_.end());
+        return *this;
+    }
 
-            for (auto h : mesh_.halfedges(v))
+    Stencil& operator*=(double s)
+    {
+        for (auto& t : terms_)
+            t.second *= s;
+        return *this;
+    }
+
+    Stencil& operator/=(double s) { return *this *= 1.0 / s; }
+
+    const std::vector<std::pair<IndexType, double>>& terms() const
+    {
+        return terms_;
+    }
+
+private:
+    std::vector<std::pair<IndexType, double>> terms_;
+};
+
+Stencil operator+(Stencil a, const Stencil& b)
+{
+    return a += b;
+}
+
+Stencil operator*(Stencil a, double s)
+{
+    return a *= s;
+}
+
+Stencil operator*(double s, Stencil a)
+{
+    return a *= s;
+}
+
+void set_zero(Point& p)
+{
+    p = Point(0, 0, 0);
+}
+
+void set_zero(Stencil& s)
+{
+    s = Stencil();
+}
+
+// the unit stencil of each vertex
+struct UnitStencils
+{
+    Stencil operator[](Vertex v) const { return Stencil(v); }
+};
+
+// Multiply the stencils of the previous steps by the rows of the last step.
+void compose(const std::vector<Stencil>& rows,
+             SubdivisionStencils::Matrix& stencils)
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (size_t i = 0; i < rows.size(); ++i)
+        for (const auto& t : rows[i].terms())
+            triplets.emplace_back(i, t.first, t.second);
+    SubdivisionStencils::Matrix step(rows.size(), stencils.rows());
+    step.setFromTriplets(triplets.begin(), triplets.end());
+    stencils = step * stencils;
+}
+
+// The subdivision rules, evaluated for the positions of the vertices or for
+// their stencils. Each step stores the values of the old vertices followed
+// by those of the new ones.
+template <class Value, class Values>
+class Rules
+{
+public:
+    Rules(const SurfaceMesh& mesh, const Values& values,
+          const VertexProperty<bool>& vfeature,
+          const EdgeProperty<bool>& efeature)
+        : mesh_(mesh), values_(values), vfeature_(vfeature), efeature_(efeature)
+    {
+    }
+
+    void catmull_clark(std::vector<Value>& points) const
+    {
+        const int nv = int(mesh_.vertices_size());
+        const int ne = int(mesh_.edges_size());
+        const int nf = int(mesh_.faces_size());
+        points.resize(nv + ne + nf);
+        Value* fpoint = points.data() + nv + ne;
+
+        // compute face vertices
+        parallel_for(0, nf, [&](int i) {
+            Value p;
+            set_zero(p);
+            Scalar c(0);
+            for (auto v : mesh_.vertices(Face(i)))
             {
-                if (efeature_[mesh_.edge(h)])
-                {
-                    p += points_[mesh_.to_vertex(h)];
-                    ++count;
-                }
+                p += values_[v];
+                ++c;
             }
+            p /= c;
+            fpoint[i] = p;
+        });
 
-            if (count == 2) // vertex is on feature edge
+        // compute edge vertices
+        parallel_for(0, ne, [&](int i) {
+            const Edge e(i);
+
+            // boundary or feature edge?
+            if (mesh_.is_boundary(e) || (efeature_ && efeature_[e]))
             {
-                p *= 0.125;
-                vpoint[v] = p;
+                points[nv + i] = 0.5f * (values_[mesh_.vertex(e, 0)] +
+                                         values_[mesh_.vertex(e, 1)]);
             }
-            else // keep fixed
+
+            // interior edge
+            else
             {
-                vpoint[v] = points_[v];
+                Value p;
+                set_zero(p);
+                p += values_[mesh_.vertex(e, 0)];
+                p += values_[mesh_.vertex(e, 1)];
+                p += fpoint[mesh_.face(e, 0).idx()];
+                p += fpoint[mesh_.face(e, 1).idx()];
+                p *= 0.25f;
+                points[nv + i] = p;
             }
-        }
+        });
 
-        // interior vertex
-        else
-        {
-            // weights from SIGGRAPH paper "Subdivision Surfaces in Character Animation"
+        // compute new positions for old vertices
+        parallel_for(0, nv, [&](int i) {
+            const Vertex v(i);
+            if (feature_point(v, points[i]))
+                return;
+
+            // weights from SIGGRAPH paper "Subdivision Surfaces in Character
+            // Animation"
 
             const Scalar k = mesh_.valence(v);
-            Point p(0, 0, 0);
+            Value p;
+            set_zero(p);
 
             for (auto vv : mesh_.vertices(v))
-                p += points_[vv];
+                p += values_[vv];
 
             for (auto f : mesh_.faces(v))
-                p += fpoint[f];
+                p += fpoint[f.idx()];
 
             p /= (k * k);
 
-            p += ((k - 2.0f) / k) * points_[v];
+            p += ((k - 2.0f) / k) * values_[v];
 
-            vpoint[v] = p;
-        }
+            points[i] = p;
+        });
     }
 
-    // assign new positions to old vertices
-    for (auto v : mesh_.vertices())
+    void loop(std::vector<Value>& points) const
     {
-        points_[v] = vpoint[v];
-    }
+        const int nv = int(mesh_.vertices_size());
+        const int ne = int(mesh_.edges_size());
+        points.resize(nv + ne);
+
+        // compute vertex positions
+        parallel_for(0, nv, [&](int i) {
+            const Vertex v(i);
+            if (feature_point(v, points[i]))
+                return;
+
+            // interior vertex
+            Value p;
+            set_zero(p);
+            Scalar k(0);
 
-    // split edges
-    for (auto e : mesh_.edges())
-    {
-        // feature edge?
-        if (efeature_ && efeature_[e])
-        {
-            auto h = mesh_.insert_vertex(e, epoint[e]);
-            auto v = mesh_.to_vertex(h);
-            auto e0 = mesh_.edge(h);
-            auto e1 = mesh_.edge(mesh_.next_halfedge(h));
-
-            vfeature_[v] = true;
-            efeature_[e0] = true;
-            efeature_[e1] = true;
-        }
+            for (auto vv : mesh_.vertices(v))
+            {
+                p += values_[vv];
+                ++k;
+            }
+            p /= k;
 
-        // normal edge
-        else
-        {
-            mesh_.insert_vertex(e, epoint[e]);
-        }
+            Scalar beta =
+                (0.625 - pow(0.375 + 0.25 * cos(2.0 * M_PI / k), 2.0));
+
+            points[i] = values_[v] * (Scalar)(1.0 - beta) + beta * p;
+        });
+
+        // compute edge positions
+        parallel_for(0, ne, [&](int i) {
+            const Edge e(i);
+
+            // boundary or feature edge?
+            if (mesh_.is_boundary(e) || (efeature_ && efeature_[e]))
+            {
+                points[nv + i] = (values_[mesh_.vertex(e, 0)] +
+                                  values_[mesh_.vertex(e, 1)]) *
+                                 Scalar(0.5);
+            }
+
+            // interior edge
+            else
+            {
+                auto h0 = mesh_.halfedge(e, 0);
+                auto h1 = mesh_.halfedge(e, 1);
+                Value p = values_[mesh_.to_vertex(h0)];
+                p += values_[mesh_.to_vertex(h1)];
+                p *= 3.0;
+                p += values_[mesh_.to_vertex(mesh_.next_halfedge(h0))];
+                p += values_[mesh_.to_vertex(mesh_.next_halfedge(h1))];
+                p *= 0.125;
+                points[nv + i] = p;
+            }
+        });
     }
 
-    // split faces
-    for (auto f : mesh_.faces())
+    void sqrt3(std::vector<Value>& points) const
     {
-        auto h0 = mesh_.halfedge(f);
-        mesh_.insert_edge(h0, mesh_.next_halfedge(mesh_.next_halfedge(h0)));
+        const int nv = int(mesh_.vertices_size());
+        const int nf = int(mesh_.faces_size());
+        points.resize(nv + nf);
+
+        // compute new positions of old vertices
+        parallel_for(0, nv, [&](int i) {
+            const Vertex v(i);
+            if (!mesh_.is_boundary(v))
+            {
+                points[i] = sqrt3_point(v);
+            }
+            else
+            {
+                points[i] = values_[v];
+            }
+        });
 
-        auto h1 = mesh_.next_halfedge(h0);
-        mesh_.insert_vertex(mesh_.edge(h1), fpoint[f]);
+        // compute face vertices
+        parallel_for(0, nf, [&](int i) {
+            Value p;
+            set_zero(p);
+            Scalar c(0);
 
-        auto h =
-            mesh_.next_halfedge(mesh_.next_halfedge(mesh_.next_halfedge(h1)));
-        while (h != h0)
-        {
-            mesh_.insert_edge(h1, h);
-            h = mesh_.next_halfedge(
-                mesh_.next_halfedge(mesh_.next_halfedge(h1)));
-        }
-    }
+            for (auto fv : mesh_.vertices(Face(i)))
+            {
+                p += values_[fv];
+                ++c;
+            }
 
-    // clean-up properties
-    mesh_.remove_vertex_property(vpoint);
-    mesh_.remove_edge_property(epoint);
-    mesh_.remove_face_property(fpoint);
-}
+            p /= c;
+            points[nv + i] = p;
+        });
+    }
 
-void SurfaceSubdivision::loop()
-{
-    if (!mesh_.is_triangle_mesh())
+    // new value of an interior vertex
+    Value sqrt3_point(Vertex v) const
     {
-        auto what = "SurfaceSubdivision: Not a triangle mesh.";
-        throw InvalidInputException(what);
-    }
+        Scalar n = mesh_.valence(v);
+        Scalar alpha = (4.0 - 2.0 * cos(2.0 * M_PI / n)) / 9.0;
+        Value p;
+        set_zero(p);
 
-    // reserve memory
-    size_t nv = mesh_.n_vertices();
-    size_t ne = mesh_.n_edges();
-    size_t nf = mesh_.n_faces();
-    mesh_.reserve(nv + ne, 2 * ne + 3 * nf, 4 * nf);
+        for (auto vv : mesh_.vertices(v))
+            p += values_[vv];
 
-    // add properties
-    auto vpoint = mesh_.add_vertex_property<Point>("loop:vpoint");
-    auto epoint = mesh_.add_edge_property<Point>("loop:epoint");
+        p = (1.0f - alpha) * values_[v] + alpha / n * p;
+        return p;
+    }
 
-    // compute vertex positions
-    for (auto v : mesh_.vertices())
+private:
+    // value of a vertex on a boundary or feature, returns false for
+    // interior vertices
+    bool feature_point(Vertex v, Value& p) const
     {
         // isolated vertex?
         if (mesh_.is_isolated(v))
         {
-            vpoint[v] = points_[v];
+            p = values_[v];
+            return true;
         }
 
         // boundary vertex?
-        else if (mesh_.is_boundary(v))
+        if (mesh_.is_boundary(v))
         {
             auto h1 = mesh_.halfedge(v);
             auto h0 = mesh_.prev_halfedge(h1);
 
-            Point p = points_[v];
+            p = values_[v];
             p *= 6.0;
-            p += points_[mesh_.to_vertex(h1)];
-            p += points_[mesh_.from_vertex(h0)];
+            p += values_[mesh_.to_vertex(h1)];
+            p += values_[mesh_.from_vertex(h0)];
             p *= 0.125;
-            vpoint[v] = p;
+            return true;
         }
 
         // interior feature vertex?
-        else if (vfeature_ && vfeature_[v])
+        if (vfeature_ && vfeature_[v])
         {
-            Point p = points_[v];
+            p = values_[v];
             p *= 6.0;
             int count(0);
 
@@ -241,7 +478,7 @@ void SurfaceSubdivision::loop()
             {
                 if (efeature_[mesh_.edge(h)])
                 {
-                    p += points_[mesh_.to_vertex(h)];
+                    p += values_[mesh_.to_vertex(h)];
                     ++count;
                 }
             }
@@ -249,107 +486,214 @@ void SurfaceSubdivision::loop()
             if (count == 2) // vertex is on feature edge
             {
                 p *= 0.125;
-                vpoint[v] = p;
             }
             else // keep fixed
             {
-                vpoint[v] = points_[v];
+                p = values_[v];
             }
+            return true;
         }
 
-        // interior vertex
-        else
-        {
-            Point p(0, 0, 0);
-            Scalar k(0);
+        return false;
+    }
 
-            for (auto vv : mesh_.vertices(v))
-            {
-                p += points_[vv];
-                ++k;
-            }
-            p /= k;
+    const SurfaceMesh& mesh_;
+    const Values& values_;
+    const VertexProperty<bool>& vfeature_;
+    const EdgeProperty<bool>& efeature_;
+};
 
-            Scalar beta =
-                (0.625 - pow(0.375 + 0.25 * cos(2.0 * M_PI / k), 2.0));
+} // namespace
 
-            vpoint[v] = points_[v] * (Scalar)(1.0 - beta) + beta * p;
-        }
+void SubdivisionStencils::apply(const std::vector<Point>& control,
+                                std::vector<Point>& refined) const
+{
+    if (control.size() != n_control_vertices())
+    {
+        auto what = "SubdivisionStencils: Wrong number of control points.";
+        throw InvalidInputException(what);
+    }
+
+    const int n = int(n_vertices());
+    refined.resize(n);
+    parallel_for(0, n, [&](int i) {
+        dvec3 p(0, 0, 0);
+        for (Matrix::InnerIterator it(matrix_, i); it; ++it)
+            p += it.value() * dvec3(control[it.col()]);
+        refined[i] = Point(p);
+    });
+}
+
+void SubdivisionStencils::apply(const SurfaceMesh& control,
+                                SurfaceMesh& refined) const
+{
+    if (control.vertices_size() != n_control_vertices() ||
+        refined.vertices_size() != n_vertices())
+    {
+        auto what = "SubdivisionStencils: Wrong number of vertices.";
+        throw InvalidInputException(what);
     }
 
-    // compute edge positions
+    auto cpoints = control.get_vertex_property<Point>("v:point");
+    auto rpoints = refined.get_vertex_property<Point>("v:point");
+    const int n = int(n_vertices());
+    parallel_for(0, n, [&](int i) {
+        dvec3 p(0, 0, 0);
+        for (Matrix::InnerIterator it(matrix_, i); it; ++it)
+            p += it.value() * dvec3(cpoints[Vertex(IndexType(it.col()))]);
+        rpoints[Vertex(i)] = Point(p);
+    });
+}
+
+SurfaceSubdivision::SurfaceSubdivision(SurfaceMesh& mesh)
+    : mesh_(mesh), edge_index_(false), stencils_(nullptr)
+{
+    points_ = mesh_.vertex_property<Point>("v:point");
+    vfeature_ = mesh_.get_vertex_property<bool>("v:feature");
+    efeature_ = mesh_.get_edge_property<bool>("e:feature");
+}
+
+void SurfaceSubdivision::catmull_clark(unsigned int steps)
+{
+    catmull_clark(steps, nullptr);
+}
+
+void SurfaceSubdivision::catmull_clark(unsigned int steps,
+                                       SubdivisionStencils& stencils)
+{
+    catmull_clark(steps, &stencils);
+}
+
+void SurfaceSubdivision::catmull_clark(unsigned int steps,
+                                       SubdivisionStencils* stencils)
+{
+    // after the first step, all faces are quads
+    size_t nv = mesh_.n_vertices();
+    size_t ne = mesh_.n_edges();
+    size_t nf = mesh_.n_faces();
+    size_t nc = 2 * ne;
     for (auto e : mesh_.edges())
+        for (int i = 0; i < 2; ++i)
+            if (mesh_.is_boundary(mesh_.halfedge(e, i)))
+                --nc;
+    for (unsigned int i = 0; i < steps; ++i)
     {
-        // boundary or feature edge?
-        if (mesh_.is_boundary(e) || (efeature_ && efeature_[e]))
-        {
-            epoint[e] =
-                (points_[mesh_.vertex(e, 0)] + points_[mesh_.vertex(e, 1)]) *
-                Scalar(0.5);
-        }
+        nv += ne + nf;
+        ne = 2 * ne + nc;
+        nf = nc;
+        nc = 4 * nf;
+    }
 
-        // interior edge
-        else
-        {
-            auto h0 = mesh_.halfedge(e, 0);
-            auto h1 = mesh_.halfedge(e, 1);
-            Point p = points_[mesh_.to_vertex(h0)];
-            p += points_[mesh_.to_vertex(h1)];
-            p *= 3.0;
-            p += points_[mesh_.to_vertex(mesh_.next_halfedge(h0))];
-            p += points_[mesh_.to_vertex(mesh_.next_halfedge(h1))];
-            p *= 0.125;
-            epoint[e] = p;
-        }
+    begin_steps(nv, ne, nf, stencils);
+    run_steps(steps, &SurfaceSubdivision::catmull_clark_step);
+}
+
+void SurfaceSubdivision::loop(unsigned int steps)
+{
+    loop(steps, nullptr);
+}
+
+void SurfaceSubdivision::loop(unsigned int steps,
+                              SubdivisionStencils& stencils)
+{
+    loop(steps, &stencils);
+}
+
+void SurfaceSubdivision::loop(unsigned int steps,
+                              SubdivisionStencils* stencils)
+{
+    if (!mesh_.is_triangle_mesh())
+    {
+        auto what = "SurfaceSubdivision: Not a triangle mesh.";
+        throw InvalidInputException(what);
     }
 
-    // set new vertex positions
-    for (auto v : mesh_.vertices())
+    size_t nv = mesh_.n_vertices();
+    size_t ne = mesh_.n_edges();
+    size_t nf = mesh_.n_faces();
+    for (unsigned int i = 0; i < steps; ++i)
     {
-        points_[v] = vpoint[v];
+        nv += ne;
+        ne = 2 * ne + 3 * nf;
+        nf *= 4;
     }
 
-    // insert new vertices on edges
-    for (auto e : mesh_.edges())
+    begin_steps(nv, ne, nf, stencils);
+    run_steps(steps, &SurfaceSubdivision::loop_step);
+}
+
+void SurfaceSubdivision::sqrt3(unsigned int steps)
+{
+    sqrt3(steps, nullptr);
+}
+
+void SurfaceSubdivision::sqrt3(unsigned int steps,
+                               SubdivisionStencils& stencils)
+{
+    sqrt3(steps, &stencils);
+}
+
+void SurfaceSubdivision::sqrt3(unsigned int steps,
+                               SubdivisionStencils* stencils)
+{
+    if (!mesh_.is_triangle_mesh())
     {
-        // feature edge?
-        if (efeature_ && efeature_[e])
-        {
-            auto h = mesh_.insert_vertex(e, epoint[e]);
-            auto v = mesh_.to_vertex(h);
-            auto e0 = mesh_.edge(h);
-            auto e1 = mesh_.edge(mesh_.next_halfedge(h));
-
-            vfeature_[v] = true;
-            efeature_[e0] = true;
-            efeature_[e1] = true;
-        }
+        auto what = "SurfaceSubdivision: Not a triangle mesh.";
+        throw InvalidInputException(what);
+    }
 
-        // normal edge
-        else
-        {
-            mesh_.insert_vertex(e, epoint[e]);
-        }
+    size_t nv = mesh_.n_vertices();
+    size_t ne = mesh_.n_edges();
+    size_t nf = mesh_.n_faces();
+    for (unsigned int i = 0; i < steps; ++i)
+    {
+        nv += nf;
+        ne += 3 * nf;
+        nf *= 3;
     }
 
-    // split faces
-    Halfedge h;
-    for (auto f : mesh_.faces())
+    begin_steps(nv, ne, nf, stencils);
+    run_steps(steps, &SurfaceSubdivision::sqrt3_step);
+}
+
+void SurfaceSubdivision::adaptive_sqrt3(unsigned int steps)
+{
+    if (!mesh_.is_triangle_mesh())
     {
-        h = mesh_.halfedge(f);
-        mesh_.insert_edge(h, mesh_.next_halfedge(mesh_.next_halfedge(h)));
-        h = mesh_.next_halfedge(h);
-        mesh_.insert_edge(h, mesh_.next_halfedge(mesh_.next_halfedge(h)));
-        h = mesh_.next_halfedge(h);
-        mesh_.insert_edge(h, mesh_.next_halfedge(mesh_.next_halfedge(h)));
+        auto what = "SurfaceSubdivision: Not a triangle mesh.";
+        throw InvalidInputException(what);
     }
 
-    // clean-up properties
-    mesh_.remove_vertex_property(vpoint);
-    mesh_.remove_edge_property(epoint);
+    auto vselected = mesh_.get_vertex_property<bool>("v:selected");
+    if (!vselected)
+        return;
+
+    std::vector<Face> faces;
+    for (unsigned int i = 0; i < steps; ++i)
+    {
+        faces.clear();
+        for (auto f : mesh_.faces())
+        {
+            for (auto v : mesh_.vertices(f))
+            {
+                if (vselected[v])
+                {
+                    faces.push_back(f);
+                    break;
+                }
+            }
+        }
+
+        // the face vertices follow the old vertices
+        const size_t nv = mesh_.vertices_size();
+        adaptive_sqrt3_step(faces);
+        for (size_t j = nv; j < mesh_.vertices_size(); ++j)
+            vselected[Vertex(IndexType(j))] = true;
+    }
 }
 
-void SurfaceSubdivision::sqrt3()
+void SurfaceSubdivision::adaptive_sqrt3(unsigned int steps,
+                                        Scalar curvature_threshold)
 {
     if (!mesh_.is_triangle_mesh())
     {
@@ -357,38 +701,83 @@ void SurfaceSubdivision::sqrt3()
         throw InvalidInputException(what);
     }
 
-    // reserve memory
-    int nv = mesh_.n_vertices();
-    int ne = mesh_.n_edges();
-    int nf = mesh_.n_faces();
-    mesh_.reserve(nv + nf, ne + 3 * nf, 3 * nf);
+    std::vector<Face> faces;
+    for (unsigned int i = 0; i < steps; ++i)
+    {
+        std::vector<bool> curved(mesh_.vertices_size(), false);
+        {
+            SurfaceCurvature curvature(mesh_);
+            curvature.analyze();
+            for (auto v : mesh_.vertices())
+                curved[v.idx()] =
+                    curvature.max_abs_curvature(v) > curvature_threshold;
+        }
 
-    auto points = mesh_.vertex_property<Point>("v:point");
+        faces.clear();
+        for (auto f : mesh_.faces())
+        {
+            for (auto v : mesh_.vertices(f))
+            {
+                if (curved[v.idx()])
+                {
+                    faces.push_back(f);
+                    break;
+                }
+            }
+        }
+        if (faces.empty())
+            break;
 
-    // remember end of old vertices and edges
-    auto vend = mesh_.vertices_end();
-    auto eend = mesh_.edges_end();
+        adaptive_sqrt3_step(faces);
+    }
+}
 
-    // compute new positions of old vertices
-    auto new_pos = mesh_.add_vertex_property<Point>("v:np");
-    for (auto v : mesh_.vertices())
+void SurfaceSubdivision::adaptive_sqrt3_step(const std::vector<Face>& faces)
+{
+    std::vector<bool> refined(mesh_.faces_size(), false);
+    for (auto f : faces)
+        refined[f.idx()] = true;
+
+    // new positions of the interior vertices whose faces are all refined
+    const Rules<Point, VertexProperty<Point>> rules(mesh_, points_, vfeature_,
+                                                    efeature_);
+    std::vector<bool> visited(mesh_.vertices_size(), false);
+    std::vector<std::pair<Vertex, Point>> smoothed;
+    for (auto f : faces)
     {
-        if (!mesh_.is_boundary(v))
+        for (auto v : mesh_.vertices(f))
         {
-            Scalar n = mesh_.valence(v);
-            Scalar alpha = (4.0 - 2.0 * cos(2.0 * M_PI / n)) / 9.0;
-            Point p(0, 0, 0);
+            if (visited[v.idx()])
+                continue;
+            visited[v.idx()] = true;
 
-            for (auto vv : mesh_.vertices(v))
-                p += points_[vv];
+            if (mesh_.is_boundary(v))
+                continue;
 
-            p = (1.0f - alpha) * points_[v] + alpha / n * p;
-            new_pos[v] = p;
+            bool all_refined = true;
+            for (auto vf : mesh_.faces(v))
+                all_refined = all_refined && refined[vf.idx()];
+            if (!all_refined)
+                continue;
+
+            smoothed.emplace_back(v, rules.sqrt3_point(v));
+        }
+    }
+
+    // old edges between refined faces
+    std::vector<Edge> edges;
+    for (auto f : faces)
+    {
+        for (auto h : mesh_.halfedges(f))
+        {
+            const Face g = mesh_.face(mesh_.opposite_halfedge(h));
+            if (g.is_valid() && f.idx() < g.idx() && refined[g.idx()])
+                edges.push_back(mesh_.edge(h));
         }
     }
 
     // split faces
-    for (auto f : mesh_.faces())
+    for (auto f : faces)
     {
         Point p(0, 0, 0);
         Scalar c(0);
@@ -404,25 +793,401 @@ void SurfaceSubdivision::sqrt3()
         mesh_.split(f, p);
     }
 
-    // set new positions of old vertices
-    for (auto vit = mesh_.vertices_begin(); vit != vend; ++vit)
+    for (const auto& s : smoothed)
+        points_[s.first] = s.second;
+
+    // flip old edges
+    for (auto e : edges)
+    {
+        if (mesh_.is_flip_ok(e))
+        {
+            mesh_.flip(e);
+        }
+    }
+}
+
+void SurfaceSubdivision::begin_steps(size_t nvertices, size_t nedges,
+                                     size_t nfaces,
+                                     SubdivisionStencils* stencils)
+{
+    // the stencils start from the control vertices, including deleted ones
+    stencils_ = stencils;
+    if (stencils_)
     {
-        if (!mesh_.is_boundary(*vit))
+        const auto n = Eigen::Index(mesh_.vertices_size());
+        stencils_->matrix_.resize(n, n);
+        stencils_->matrix_.setIdentity();
+    }
+
+    // the steps index the elements consecutively
+    if (mesh_.n_vertices() < mesh_.vertices_size() ||
+        mesh_.n_edges() < mesh_.edges_size() ||
+        mesh_.n_faces() < mesh_.faces_size())
+    {
+        std::vector<Vertex> vmap;
+        std::vector<Halfedge> hmap;
+        std::vector<Edge> emap;
+        std::vector<Face> fmap;
+        mesh_.garbage_collection(vmap, hmap, emap, fmap);
+
+        if (stencils_)
         {
-            points[*vit] = new_pos[*vit];
+            std::vector<Eigen::Triplet<double>> triplets;
+            for (size_t i = 0; i < vmap.size(); ++i)
+                if (vmap[i].is_valid())
+                    triplets.emplace_back(vmap[i].idx(), i, 1.0);
+            stencils_->matrix_.resize(mesh_.vertices_size(), vmap.size());
+            stencils_->matrix_.setFromTriplets(triplets.begin(),
+                                               triplets.end());
         }
     }
 
-    mesh_.remove_vertex_property(new_pos);
+    mesh_.reserve(nvertices, nedges, nfaces);
 
-    // flip old edges
-    for (auto eit = mesh_.edges_begin(); eit != eend; ++eit)
+    // the connectivity is written in parallel, the edge index is rebuilt
+    // afterwards
+    edge_index_ = mesh_.has_edge_index();
+    if (edge_index_)
+        mesh_.set_edge_index(false);
+}
+
+void SurfaceSubdivision::run_steps(unsigned int steps,
+                                   void (SurfaceSubdivision::*step)())
+{
+    unsigned int i = 0;
+    for (; i < steps; ++i)
+    {
+        if (progress_ && !progress_(float(i) / float(steps)))
+            break;
+        (this->*step)();
+    }
+    end_steps();
+
+    if (i < steps)
+        throw CancelledException("SurfaceSubdivision: Cancelled.");
+}
+
+void SurfaceSubdivision::end_steps()
+{
+    if (edge_index_)
+        mesh_.set_edge_index(true);
+    stencils_ = nullptr;
+}
+
+void SurfaceSubdivision::split_features(size_t nvertices, size_t nedges)
+{
+    if (!efeature_)
+        return;
+
+    // serial, as bool properties are packed
+    for (size_t i = 0; i < nedges; ++i)
+    {
+        if (efeature_[Edge(IndexType(i))])
+        {
+            efeature_[Edge(IndexType(nedges + i))] = true;
+            if (vfeature_)
+                vfeature_[Vertex(IndexType(nvertices + i))] = true;
+        }
+    }
+}
+
+void SurfaceSubdivision::catmull_clark_step()
+{
+    PMP_PROFILE_SCOPE("catmull_clark_step");
+
+    const int nv = int(mesh_.vertices_size());
+    const int ne = int(mesh_.edges_size());
+    const int nf = int(mesh_.faces_size());
+
+    std::vector<Point> points;
+    Rules<Point, VertexProperty<Point>>(mesh_, points_, vfeature_, efeature_)
+        .catmull_clark(points);
+    if (stencils_)
+    {
+        std::vector<Stencil> rows;
+        Rules<Stencil, UnitStencils>(mesh_, UnitStencils(), vfeature_,
+                                     efeature_)
+            .catmull_clark(rows);
+        compose(rows, stencils_->matrix_);
+    }
+
+    // split each face into one quad per corner, the edges between the
+    // edge vertices and the face vertex are numbered by corner
+    const Connectivity old(mesh_);
+    const IndexType nc = old.face_offset[nf];
+    mesh_.new_vertices(ne + nf);
+    mesh_.new_edges(ne + nc);
+    mesh_.new_faces(nc - nf);
+
+    const EdgeSplit split(nv, ne);
+    split.apply(mesh_, old);
+
+    // the corners of a face start at the halfedge of its last split edge
+    std::vector<Halfedge> first(nf);
+    parallel_for(0, nf, [&](int i) {
+        first[i] = EdgeSplit::last_split(old, Face(i));
+    });
+
+    // the edge between the edge vertex of the k-th halfedge of face f and
+    // its face vertex
+    auto spoke = [&](int f, size_t k) {
+        return Edge(IndexType(2 * ne + old.face_offset[f] + k));
+    };
+
+    parallel_for_chunks(0, nf, [&](int begin, int end) {
+        std::vector<Halfedge> halfedges;
+        for (int i = begin; i < end; ++i)
+        {
+            const Vertex center(nv + ne + i);
+
+            halfedges.clear();
+            Halfedge h = first[i];
+            do
+            {
+                halfedges.push_back(h);
+                h = old.next[h.idx()];
+            } while (h != first[i]);
+
+            // halfedges from the edge vertex of the k-th halfedge to the
+            // center and back, the first spoke is oriented the other way
+            const size_t n = halfedges.size();
+            auto to_center = [&](size_t k) {
+                return mesh_.halfedge(spoke(i, k), k ? 1 : 0);
+            };
+            auto from_center = [&](size_t k) {
+                return mesh_.halfedge(spoke(i, k), k ? 0 : 1);
+            };
+
+            for (size_t k = 0; k < n; ++k)
+            {
+                mesh_.set_vertex(to_center(k), center);
+                mesh_.set_vertex(from_center(k), split.vertex(halfedges[k]));
+
+                // quad at the start of the k-th halfedge
+                const size_t j = (k + n - 1) % n;
+                const Face q =
+                    k ? Face(IndexType(nf + old.face_offset[i] - i + k - 1))
+                      : Face(i);
+                const Halfedge quad[4] = {split.second_half(halfedges[j]),
+                                          split.first_half(halfedges[k]),
+                                          to_center(k), from_center(j)};
+                for (int l = 0; l < 4; ++l)
+                {
+                    mesh_.set_next_halfedge(quad[l], quad[(l + 1) % 4]);
+                    mesh_.set_face(quad[l], q);
+                }
+                mesh_.set_halfedge(q, k == 0   ? to_center(0)
+                                      : k == 1 ? to_center(1)
+                                               : quad[1]);
+            }
+            mesh_.set_halfedge(center, from_center(1));
+        }
+    });
+
+    // interior edge vertices of the second halfedge of a face end up with
+    // the spoke of the last such face
+    parallel_for(0, ne, [&](int i) {
+        const Face f0 = old.face[2 * i], f1 = old.face[2 * i + 1];
+        if (!f0.is_valid() || !f1.is_valid())
+            return;
+
+        for (auto f : {std::max(f0, f1), std::min(f0, f1)})
+        {
+            const Halfedge h = old.next[first[f.idx()].idx()];
+            if (IndexType(h.idx() / 2) == IndexType(i))
+            {
+                mesh_.set_halfedge(Vertex(nv + i),
+                                   mesh_.halfedge(spoke(f.idx(), 1), 1));
+                break;
+            }
+        }
+    });
+
+    split_features(nv, ne);
+
+    const int n = int(points.size());
+    parallel_for(0, n, [&](int i) { points_[Vertex(i)] = points[i]; });
+}
+
+void SurfaceSubdivision::loop_step()
+{
+    PMP_PROFILE_SCOPE("loop_step");
+
+    const int nv = int(mesh_.vertices_size());
+    const int ne = int(mesh_.edges_size());
+    const int nf = int(mesh_.faces_size());
+
+    std::vector<Point> points;
+    Rules<Point, VertexProperty<Point>>(mesh_, points_, vfeature_, efeature_)
+        .loop(points);
+    if (stencils_)
     {
-        if (mesh_.is_flip_ok(*eit))
+        std::vector<Stencil> rows;
+        Rules<Stencil, UnitStencils>(mesh_, UnitStencils(), vfeature_,
+                                     efeature_)
+            .loop(rows);
+        compose(rows, stencils_->matrix_);
+    }
+
+    // split each triangle into three corner triangles, which are appended,
+    // and a center triangle, which keeps the index of the face
+    const Connectivity old(mesh_);
+    mesh_.new_vertices(ne);
+    mesh_.new_edges(ne + 3 * nf);
+    mesh_.new_faces(3 * nf);
+
+    const EdgeSplit split(nv, ne);
+    split.apply(mesh_, old);
+
+    parallel_for(0, nf, [&](int i) {
+        const Face f(i);
+        Halfedge h[3];
+        h[0] = EdgeSplit::last_split(old, f);
+        h[1] = old.next[h[0].idx()];
+        h[2] = old.next[h[1].idx()];
+
+        for (int k = 0; k < 3; ++k)
         {
-            mesh_.flip(*eit);
+            const Halfedge h0 = h[k], h1 = h[(k + 1) % 3];
+
+            // halfedges of the edge between the edge vertices of h0 and h1
+            const Halfedge inner(2 * (2 * ne + 3 * i + k));
+            const Halfedge outer(inner.idx() + 1);
+            const Halfedge next_inner(2 * (2 * ne + 3 * i + (k + 1) % 3));
+            mesh_.set_vertex(inner, split.vertex(h1));
+            mesh_.set_vertex(outer, split.vertex(h0));
+
+            // corner triangle at the vertex between h0 and h1
+            const Face c(nf + 3 * i + k);
+            const Halfedge corner[3] = {split.second_half(h0),
+                                        split.first_half(h1), outer};
+            for (int j = 0; j < 3; ++j)
+            {
+                mesh_.set_next_halfedge(corner[j], corner[(j + 1) % 3]);
+                mesh_.set_face(corner[j], c);
+            }
+            mesh_.set_halfedge(c, corner[1]);
+
+            // center triangle
+            mesh_.set_next_halfedge(inner, next_inner);
+            mesh_.set_face(inner, f);
         }
+        mesh_.set_halfedge(f, Halfedge(2 * (2 * ne + 3 * i + 1)));
+    });
+
+    split_features(nv, ne);
+
+    const int n = int(points.size());
+    parallel_for(0, n, [&](int i) { points_[Vertex(i)] = points[i]; });
+}
+
+void SurfaceSubdivision::sqrt3_step()
+{
+    const int nv = int(mesh_.vertices_size());
+    const int ne = int(mesh_.edges_size());
+    const int nf = int(mesh_.faces_size());
+
+    std::vector<Point> points;
+    Rules<Point, VertexProperty<Point>>(mesh_, points_, vfeature_, efeature_)
+        .sqrt3(points);
+    if (stencils_)
+    {
+        std::vector<Stencil> rows;
+        Rules<Stencil, UnitStencils>(mesh_, UnitStencils(), vfeature_,
+                                     efeature_)
+            .sqrt3(rows);
+        compose(rows, stencils_->matrix_);
     }
+
+    // Connect the face vertices to the corners and flip the old interior
+    // edges. Each halfedge of a face then bounds one triangle, the one of
+    // the halfedge of the face keeps the index of the face.
+    const Connectivity old(mesh_);
+    mesh_.new_vertices(nf);
+    mesh_.new_edges(3 * nf);
+    mesh_.new_faces(2 * nf);
+
+    // position of a halfedge in its face
+    auto position = [&](Halfedge h) {
+        const Halfedge h0 = old.face_halfedge[old.face[h.idx()].idx()];
+        return h == h0 ? 0 : h == old.next[h0.idx()] ? 1 : 2;
+    };
+
+    // halfedges from the start of h to the face vertex and back, the edges
+    // are numbered by the corners at their ends
+    auto to_center = [&](Halfedge h) {
+        const int f = old.face[h.idx()].idx();
+        return Halfedge(2 * (ne + 3 * f + (position(h) + 2) % 3));
+    };
+    auto from_center = [&](Halfedge h) {
+        return Halfedge(to_center(h).idx() + 1);
+    };
+
+    // Flip interior edges between different faces. Of several edges between
+    // the same two faces only the first one is flipped, the others would
+    // duplicate it.
+    auto flip = [&](Halfedge h) {
+        const Face f = old.face[h.idx()];
+        const Face g = old.face[h.idx() ^ 1];
+        if (!f.is_valid() || !g.is_valid() || f == g)
+            return false;
+        for (Halfedge hh = old.next[h.idx()]; hh != h;
+             hh = old.next[hh.idx()])
+            if (old.face[hh.idx() ^ 1] == g && hh.idx() / 2 < h.idx() / 2)
+                return false;
+        return true;
+    };
+
+    const int nh = 2 * ne;
+    parallel_for(0, nh, [&](int i) {
+        const Halfedge h(i), o(i ^ 1);
+        const Face f = old.face[i];
+        if (!f.is_valid())
+            return;
+
+        const Vertex center(nv + f.idx());
+        mesh_.set_vertex(from_center(h), old.to_vertex[o.idx()]);
+        mesh_.set_vertex(to_center(h), center);
+
+        const int k = position(h);
+        const Face t = k ? Face(nf + 2 * f.idx() + k - 1) : f;
+
+        Halfedge triangle[3];
+        if (flip(h))
+        {
+            // h now runs from the face vertex of g to the one of f
+            mesh_.set_vertex(h, center);
+            triangle[0] = h;
+            triangle[1] = from_center(h);
+            triangle[2] = to_center(old.next[o.idx()]);
+        }
+        else
+        {
+            triangle[0] = h;
+            triangle[1] = to_center(old.next[i]);
+            triangle[2] = from_center(h);
+        }
+        for (int j = 0; j < 3; ++j)
+        {
+            mesh_.set_next_halfedge(triangle[j], triangle[(j + 1) % 3]);
+            mesh_.set_face(triangle[j], t);
+        }
+        mesh_.set_halfedge(t, h);
+    });
+
+    // outgoing halfedges of vertices whose halfedge was flipped, and of the
+    // face vertices
+    parallel_for(0, nv, [&](int i) {
+        const Halfedge h = old.vertex_halfedge[i];
+        if (h.is_valid() && flip(h))
+            mesh_.set_halfedge(Vertex(i), to_center(old.next[h.idx() ^ 1]));
+    });
+    parallel_for(0, nf, [&](int i) {
+        mesh_.set_halfedge(Vertex(nv + i), from_center(old.face_halfedge[i]));
+    });
+
+    const int n = int(points.size());
+    parallel_for(0, n, [&](int i) { points_[Vertex(i)] = points[i]; });
 }
 
 } // namespace pmp
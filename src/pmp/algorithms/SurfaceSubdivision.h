@@ -3,11 +3,72 @@
 
 #pragma once
 
+#include <vector>
+
+#include <Eigen/Sparse>
+
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
 
+//! \brief Refined vertex positions as weighted sums of control vertices.
+//! \details Records the subdivision of a control mesh once, such that the
+//! refined positions for new positions of the control vertices, e.g., of an
+//! animated cage, take a sparse matrix-vector product instead of repeating
+//! the subdivision. Computed by the overloads of SurfaceSubdivision taking
+//! a SubdivisionStencils argument.
+//! \ingroup algorithms
+class SubdivisionStencils
+{
+public:
+    //! Sparse matrix with one row per refined vertex and one column per
+    //! control vertex, indexed by vertex index.
+    using Matrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+    //! The matrix mapping control positions to refined positions.
+    const Matrix& matrix() const { return matrix_; }
+
+    //! The number of vertices of the control mesh, including deleted ones.
+    size_t n_control_vertices() const { return matrix_.cols(); }
+
+    //! The number of vertices of the refined mesh.
+    size_t n_vertices() const { return matrix_.rows(); }
+
+    //! \brief Compute the refined positions from the control positions.
+    //! \pre \p control has n_control_vertices() elements.
+    //! \throw InvalidInputException if the precondition is violated.
+    void apply(const std::vector<Point>& control,
+               std::vector<Point>& refined) const;
+
+    //! \brief Set the positions of \p refined from those of \p control.
+    //! \pre \p refined was subdivided from a copy of \p control when
+    //! computing the stencils, and the connectivity and features of both
+    //! are unchanged since.
+    //! \throw InvalidInputException if the numbers of vertices do not match.
+    void apply(const SurfaceMesh& control, SurfaceMesh& refined) const;
+
+private:
+    friend class SurfaceSubdivision;
+
+    Matrix matrix_;
+};
+
 //! \brief A class providing surface subdivision algorithms.
+//! \details Each step evaluates the subdivision stencils of all new
+//! positions in parallel and builds the connectivity of the refined mesh
+//! directly from the element indices, allocating all elements at once.
+//! Memory for all steps is reserved up front.
+//!
+//! Deleted elements are removed by garbage collection first. The original
+//! vertices keep their indices and properties, the new vertices of edges
+//! and faces follow in the order of their edges and faces. Each original
+//! edge, halfedge, and face passes its index and properties on to one of
+//! the elements it is split into. The result is the same as splitting the
+//! elements one by one with the Euler operators of SurfaceMesh.
+//!
+//! For repeated subdivision of a control mesh with changing positions, the
+//! overloads taking SubdivisionStencils additionally record the refined
+//! positions as weights of the control vertices.
 //! \ingroup algorithms
 class SurfaceSubdivision
 {
@@ -15,27 +76,104 @@ public:
     //! Construct with mesh to be subdivided.
     SurfaceSubdivision(SurfaceMesh& mesh);
 
-    //! \brief Perform one step of Catmull-Clark subdivision.
+    //! \brief Perform \p steps steps of Catmull-Clark subdivision.
     //! \details See \cite catmull_1978_recursively for details.
-    void catmull_clark();
+    void catmull_clark(unsigned int steps = 1);
+
+    //! \brief Perform \p steps steps of Catmull-Clark subdivision and
+    //! compute the \p stencils of the refined vertices.
+    void catmull_clark(unsigned int steps, SubdivisionStencils& stencils);
 
-    //! \brief Perform one step of Loop subdivision.
+    //! \brief Perform \p steps steps of Loop subdivision.
     //! \details See \cite loop_1987_smooth for details.
     //! \pre Requires a pure triangle mesh as input.
     //! \throw InvalidInputException in case the input violates the precondition.
-    void loop();
+    void loop(unsigned int steps = 1);
+
+    //! \brief Perform \p steps steps of Loop subdivision and compute the
+    //! \p stencils of the refined vertices.
+    //! \pre Requires a pure triangle mesh as input.
+    //! \throw InvalidInputException in case the input violates the precondition.
+    void loop(unsigned int steps, SubdivisionStencils& stencils);
 
-    //! Perform one step of sqrt3 subdivision.
+    //! Perform \p steps steps of sqrt3 subdivision.
     //! See \cite kobbelt_2000_sqrt for details.
     //! \pre Requires a pure triangle mesh as input.
     //! \throw InvalidInputException in case the input violates the precondition.
-    void sqrt3();
+    void sqrt3(unsigned int steps = 1);
+
+    //! \brief Perform \p steps steps of sqrt3 subdivision and compute the
+    //! \p stencils of the refined vertices.
+    //! \pre Requires a pure triangle mesh as input.
+    //! \throw InvalidInputException in case the input violates the precondition.
+    void sqrt3(unsigned int steps, SubdivisionStencils& stencils);
+
+    //! \brief Perform \p steps steps of sqrt3 subdivision restricted to the
+    //! faces incident to selected vertices.
+    //! \details Vertices are selected by the `v:selected` property, the
+    //! vertices inserted into refined faces are selected as well. Only the
+    //! refined faces are split and only the edges between them are flipped,
+    //! which connects the refined region to the rest of the mesh without
+    //! T-junctions. Old vertices are smoothed only if all of their faces are
+    //! refined. Time and memory of a step grow with the refined region. See
+    //! \cite kobbelt_2000_sqrt for details.
+    //! \pre Requires a pure triangle mesh as input.
+    //! \throw InvalidInputException in case the input violates the precondition.
+    void adaptive_sqrt3(unsigned int steps = 1);
+
+    //! \brief Perform \p steps steps of sqrt3 subdivision restricted to the
+    //! faces incident to vertices of high curvature.
+    //! \details Refines the faces incident to vertices whose maximum
+    //! absolute curvature, evaluated by SurfaceCurvature before each step,
+    //! exceeds \p curvature_threshold. Otherwise as adaptive_sqrt3().
+    //! \pre Requires a pure triangle mesh as input.
+    //! \throw InvalidInputException in case the input violates the precondition.
+    void adaptive_sqrt3(unsigned int steps, Scalar curvature_threshold);
+
+    //! \brief Report the progress of subsequent Catmull-Clark, Loop, and
+    //! sqrt3 subdivision.
+    //! \details Polled before each step. A cancelled subdivision keeps the
+    //! steps performed so far, the stencils are those of these steps. See
+    //! ProgressCallback.
+    void set_progress(ProgressCallback progress)
+    {
+        progress_ = std::move(progress);
+    }
 
 private:
+    // perform the steps, record the stencils if given
+    void catmull_clark(unsigned int steps, SubdivisionStencils* stencils);
+    void loop(unsigned int steps, SubdivisionStencils* stencils);
+    void sqrt3(unsigned int steps, SubdivisionStencils* stencils);
+
+    // prepare the mesh for steps with the given final numbers of elements,
+    // start recording the stencils if given
+    void begin_steps(size_t nvertices, size_t nedges, size_t nfaces,
+                     SubdivisionStencils* stencils);
+
+    // perform the steps until cancelled, then call end_steps()
+    void run_steps(unsigned int steps, void (SurfaceSubdivision::*step)());
+
+    // restore the edge index disabled by begin_steps()
+    void end_steps();
+
+    void catmull_clark_step();
+    void loop_step();
+    void sqrt3_step();
+
+    // split the given faces and flip the edges between them
+    void adaptive_sqrt3_step(const std::vector<Face>& faces);
+
+    // mark the edges and new vertices split from feature edges
+    void split_features(size_t nvertices, size_t nedges);
+
     SurfaceMesh& mesh_;
     VertexProperty<Point> points_;
     VertexProperty<bool> vfeature_;
     EdgeProperty<bool> efeature_;
+    bool edge_index_;
+    SubdivisionStencils* stencils_;
+    ProgressCallback progress_;
 };
 
 } // namespace pmp
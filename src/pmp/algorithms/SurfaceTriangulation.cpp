@@ -3,8 +3,12 @@
 
 #include "pmp/algorithms/SurfaceTriangulation.h"
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 
+#include "pmp/Parallel.h"
+
 namespace pmp {
 
 SurfaceTriangulation::SurfaceTriangulation(SurfaceMesh& mesh) : mesh_(mesh)
@@ -16,8 +20,52 @@ SurfaceTriangulation::SurfaceTriangulation(SurfaceMesh& mesh) : mesh_(mesh)
 
 void SurfaceTriangulation::triangulate(Objective o)
 {
-    for (auto f : mesh_.faces())
-        triangulate(f, o);
+    // store objective
+    objective_ = o;
+
+    // compute the triangulations in parallel, each chunk of faces with its
+    // own scratch buffers
+    const int nf = int(mesh_.faces_size());
+    std::vector<std::vector<ivec2>> edges(nf);
+    std::vector<char> clipped(nf, false);
+    std::atomic<bool> manifold(true);
+    parallel_for_chunks(
+        0, nf,
+        [&](int first, int last) {
+            Polygon polygon;
+            for (int i = first; i < last; ++i)
+            {
+                const Face f(i);
+                if (mesh_.is_deleted(f))
+                    continue;
+                if (!collect(f, polygon))
+                {
+                    manifold = false;
+                    continue;
+                }
+                compute(polygon);
+                edges[i].swap(polygon.edges);
+                clipped[i] = polygon.clipped;
+            }
+        },
+        256);
+
+    if (!manifold)
+    {
+        auto what = "[SurfaceTriangulation] Non-manifold polygon";
+        throw InvalidInputException(what);
+    }
+
+    // insert the edges, which only splits the face they belong to
+    for (int i = 0; i < nf; ++i)
+    {
+        if (edges[i].empty())
+            continue;
+        collect(Face(i), polygon_);
+        polygon_.edges.swap(edges[i]);
+        polygon_.clipped = clipped[i];
+        insert_edges(polygon_);
+    }
 }
 
 void SurfaceTriangulation::triangulate(Face f, Objective o)
@@ -25,34 +73,182 @@ void SurfaceTriangulation::triangulate(Face f, Objective o)
     // store objective
     objective_ = o;
 
+    if (!collect(f, polygon_))
+    {
+        auto what = "[SurfaceTriangulation] Non-manifold polygon";
+        throw InvalidInputException(what);
+    }
+
+    compute(polygon_);
+    insert_edges(polygon_);
+}
+
+bool SurfaceTriangulation::collect(Face f, Polygon& polygon) const
+{
     // collect polygon halfedges
     Halfedge h0 = mesh_.halfedge(f);
-    halfedges_.clear();
-    vertices_.clear();
+    polygon.halfedges.clear();
+    polygon.vertices.clear();
+    polygon.edges.clear();
     Halfedge h = h0;
     do
     {
         if (!mesh_.is_manifold(mesh_.to_vertex(h)))
-        {
-            auto what = "[SurfaceTriangulation] Non-manifold polygon";
-            throw InvalidInputException(what);
-        }
+            return false;
 
-        halfedges_.push_back(h);
-        vertices_.push_back(mesh_.to_vertex(h));
+        polygon.halfedges.push_back(h);
+        polygon.vertices.push_back(mesh_.to_vertex(h));
     } while ((h = mesh_.next_halfedge(h)) != h0);
 
+    return true;
+}
+
+void SurfaceTriangulation::compute(Polygon& polygon) const
+{
+    polygon.edges.clear();
+    polygon.clipped = false;
+
     // do we have at least four vertices?
-    const int n = halfedges_.size();
-    if (n <= 3)
+    if (polygon.vertices.size() <= 3)
         return;
 
+    if (is_convex(polygon))
+    {
+        polygon.clipped = true;
+        clip_ears(polygon);
+    }
+    else
+    {
+        optimize(polygon);
+    }
+}
+
+bool SurfaceTriangulation::is_convex(Polygon& polygon) const
+{
+    const auto& vertices = polygon.vertices;
+    const int n = vertices.size();
+
+    // mean normal
+    Normal normal(0, 0, 0);
+    for (int i = 0; i < n; ++i)
+        normal += cross(points_[vertices[i]], points_[vertices[(i + 1) % n]]);
+
+    // all corners turn left
+    for (int i = 0; i < n; ++i)
+    {
+        const Point& p0 = points_[vertices[(i + n - 1) % n]];
+        const Point& p1 = points_[vertices[i]];
+        const Point& p2 = points_[vertices[(i + 1) % n]];
+        if (dot(cross(p1 - p0, p2 - p1), normal) <= 0)
+            return false;
+    }
+
+    // no vertex is visited twice and no diagonal exists as an edge, which
+    // the dynamic program handles by its weights
+    if (n == 4)
+        return !is_edge(vertices[0], vertices[2]) &&
+               !is_edge(vertices[1], vertices[3]) &&
+               vertices[0] != vertices[2] && vertices[1] != vertices[3];
+    auto& sorted = polygon.sorted;
+    sorted.clear();
+    for (auto v : vertices)
+        sorted.push_back(v.idx());
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        return false;
+    for (int i = 0; i < n; ++i)
+    {
+        const Vertex prev = vertices[(i + n - 1) % n];
+        const Vertex next = vertices[(i + 1) % n];
+        for (auto v : mesh_.vertices(vertices[i]))
+            if (v != prev && v != next &&
+                std::binary_search(sorted.begin(), sorted.end(), v.idx()))
+                return false;
+    }
+
+    return true;
+}
+
+void SurfaceTriangulation::clip_ears(Polygon& polygon) const
+{
+    const auto& vertices = polygon.vertices;
+    const int n = vertices.size();
+    auto& prev = polygon.prev;
+    auto& next = polygon.next;
+    auto& ear = polygon.ear;
+    prev.resize(n);
+    next.resize(n);
+    ear.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+
+    // the diagonals are new edges, only the triangles are weighted
+    auto weight = [&](int i, int j, int k) {
+        return triangle_weight(vertices[i], vertices[j], vertices[k]);
+    };
+
+    // start at the ear of least weight, quads start at 0 like the dynamic
+    // program
+    int first = 0;
+    if (n > 4)
+    {
+        for (int i = 0; i < n; ++i)
+            ear[i] = weight(prev[i], i, next[i]);
+        for (int i = 1; i < n; ++i)
+            if (ear[i] < ear[first])
+                first = i;
+    }
+
+    // grow a strip of triangles by clipping the cheaper of the two ears at
+    // the last diagonal (i,j), until a quad remains
+    int i = -1, j = -1;
+    for (int m = n; m > 4; --m)
+    {
+        const int k = (i == -1) ? first : (ear[i] <= ear[j] ? i : j);
+        i = prev[k];
+        j = next[k];
+        polygon.edges.push_back(ivec2(i, j));
+        next[i] = j;
+        prev[j] = i;
+        ear[i] = weight(prev[i], i, j);
+        ear[j] = weight(i, j, next[j]);
+        first = i;
+    }
+
+    // split the quad (a,b,c,d) optimally, as the dynamic program does
+    const int a = first;
+    const int b = next[a];
+    const int c = next[b];
+    const int d = next[c];
+    Scalar wbd, wac;
+    if (objective_ == MIN_AREA)
+    {
+        wbd = weight(a, b, d) + weight(b, c, d);
+        wac = weight(a, b, c) + weight(a, c, d);
+    }
+    else
+    {
+        wbd = std::max(weight(a, b, d), weight(b, c, d));
+        wac = std::max(weight(a, b, c), weight(a, c, d));
+    }
+    if (wbd <= wac)
+        polygon.edges.push_back(ivec2(b, d));
+    else
+        polygon.edges.push_back(ivec2(a, c));
+}
+
+void SurfaceTriangulation::optimize(Polygon& polygon) const
+{
+    const int n = polygon.vertices.size();
+
     // compute minimal triangulation by dynamic programming
-    weight_.clear();
-    weight_.resize(n,
-                   std::vector<Scalar>(n, std::numeric_limits<Scalar>::max()));
-    index_.clear();
-    index_.resize(n, std::vector<int>(n, 0));
+    auto& weight = polygon.weight;
+    auto& index = polygon.index;
+    weight.assign(n * n, std::numeric_limits<Scalar>::max());
+    index.assign(n * n, 0);
 
     int i, j, m, k, imin;
     Scalar w, wmin;
@@ -60,8 +256,8 @@ void SurfaceTriangulation::triangulate(Face f, Objective o)
     // initialize 2-gons
     for (i = 0; i < n - 1; ++i)
     {
-        weight_[i][i + 1] = 0.0;
-        index_[i][i + 1] = -1;
+        weight[i * n + i + 1] = 0.0;
+        index[i * n + i + 1] = -1;
     }
 
     // n-gons with n>2
@@ -80,13 +276,15 @@ void SurfaceTriangulation::triangulate(Face f, Objective o)
                 switch (objective_)
                 {
                     case MIN_AREA:
-                        w = weight_[i][m] + compute_weight(i, m, k) +
-                            weight_[m][k];
+                        w = weight[i * n + m] +
+                            compute_weight(polygon, i, m, k) +
+                            weight[m * n + k];
                         break;
                     case MAX_ANGLE:
                         w = std::max(
-                            weight_[i][m],
-                            std::max(compute_weight(i, m, k), weight_[m][k]));
+                            weight[i * n + m],
+                            std::max(compute_weight(polygon, i, m, k),
+                                     weight[m * n + k]));
                         break;
                     default:
                         // should never happen
@@ -101,12 +299,12 @@ void SurfaceTriangulation::triangulate(Face f, Objective o)
                 }
             }
 
-            weight_[i][k] = wmin;
-            index_[i][k] = imin;
+            weight[i * n + k] = wmin;
+            index[i * n + k] = imin;
         }
     }
 
-    // now add triangles to mesh
+    // now collect the edges of the triangles
     std::vector<ivec2> todo;
     todo.reserve(n);
     todo.push_back(ivec2(0, n - 1));
@@ -118,27 +316,40 @@ void SurfaceTriangulation::triangulate(Face f, Objective o)
         int end = tri[1];
         if (end - start < 2)
             continue;
-        int split = index_[start][end];
+        int split = index[start * n + end];
 
-        insert_edge(start, split);
-        insert_edge(split, end);
+        polygon.edges.push_back(ivec2(start, split));
+        polygon.edges.push_back(ivec2(split, end));
 
         todo.push_back(ivec2(start, split));
         todo.push_back(ivec2(split, end));
     }
+}
 
-    // clean up
-    weight_.clear();
-    index_.clear();
-    halfedges_.clear();
-    vertices_.clear();
+void SurfaceTriangulation::insert_edges(Polygon& polygon)
+{
+    if (polygon.clipped)
+    {
+        // the halfedge into each remaining vertex stays in the remaining
+        // polygon, the new edge replaces the one into the clipped ear
+        auto& halfedges = polygon.halfedges;
+        for (auto e : polygon.edges)
+            halfedges[e[1]] =
+                mesh_.insert_edge(halfedges[e[0]], halfedges[e[1]]);
+    }
+    else
+    {
+        for (auto e : polygon.edges)
+            insert_edge(polygon, e[0], e[1]);
+    }
 }
 
-Scalar SurfaceTriangulation::compute_weight(int i, int j, int k) const
+Scalar SurfaceTriangulation::compute_weight(const Polygon& polygon, int i,
+                                            int j, int k) const
 {
-    const Vertex a = vertices_[i];
-    const Vertex b = vertices_[j];
-    const Vertex c = vertices_[k];
+    const Vertex a = polygon.vertices[i];
+    const Vertex b = polygon.vertices[j];
+    const Vertex c = polygon.vertices[k];
 
     // if one of the potential edges already exists as NON-boundary edge
     // this would result in an invalid triangulation
@@ -151,6 +362,12 @@ Scalar SurfaceTriangulation::compute_weight(int i, int j, int k) const
     if (is_edge(a, b) && is_edge(b, c) && is_edge(c, a))
         return std::numeric_limits<Scalar>::max();
 
+    return triangle_weight(a, b, c);
+}
+
+Scalar SurfaceTriangulation::triangle_weight(Vertex a, Vertex b,
+                                             Vertex c) const
+{
     const Point& pa = points_[a];
     const Point& pb = points_[b];
     const Point& pc = points_[c];
@@ -191,12 +408,12 @@ bool SurfaceTriangulation::is_interior_edge(Vertex a, Vertex b) const
             !mesh_.is_boundary(mesh_.opposite_halfedge(h)));
 }
 
-bool SurfaceTriangulation::insert_edge(int i, int j)
+bool SurfaceTriangulation::insert_edge(const Polygon& polygon, int i, int j)
 {
-    Halfedge h0 = halfedges_[i];
-    Halfedge h1 = halfedges_[j];
-    Vertex v0 = vertices_[i];
-    Vertex v1 = vertices_[j];
+    Halfedge h0 = polygon.halfedges[i];
+    Halfedge h1 = polygon.halfedges[j];
+    Vertex v0 = polygon.vertices[i];
+    Vertex v1 = polygon.vertices[j];
 
     // does edge already exist?
     if (mesh_.find_halfedge(v0, v1).is_valid())
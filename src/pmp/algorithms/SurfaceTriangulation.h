@@ -13,6 +13,14 @@ namespace pmp {
 //! \details Tringulate n-gons into n-2 triangles. Find the triangulation that
 //! minimizes the sum of squared triangle areas.
 //! See \cite liepa_2003_filling for details.
+//!
+//! Polygons that are convex with respect to their mean normal and have no
+//! diagonal edges already in the mesh are triangulated in linear time by
+//! ear clipping: Starting at the ear of least weight, a strip of triangles
+//! is grown by clipping the cheaper of the two ears next to the last one.
+//! This is exact for quads and close to the optimum for larger convex
+//! polygons. All other polygons are triangulated optimally by dynamic
+//! programming in cubic time.
 //! \ingroup algorithms
 class SurfaceTriangulation
 {
@@ -29,7 +37,12 @@ public:
     //! construct with mesh
     SurfaceTriangulation(SurfaceMesh& mesh);
 
-    //! triangulate all faces
+    //! \brief Triangulate all faces.
+    //! \details The triangulations are computed in parallel and inserted
+    //! into the mesh afterwards.
+    //! \pre All faces are manifold
+    //! \throw InvalidInputException in case the input precondition is
+    //! violated. The mesh is not changed in this case.
     void triangulate(Objective o = MIN_AREA);
 
     //! triangulate a particular face f
@@ -38,8 +51,49 @@ public:
     void triangulate(Face f, Objective o = MIN_AREA);
 
 private:
+    // a polygon, the scratch buffers and the result of its triangulation
+    struct Polygon
+    {
+        std::vector<Halfedge> halfedges;
+        std::vector<Vertex> vertices;
+
+        // dynamic programming tables, n x n
+        std::vector<Scalar> weight;
+        std::vector<int> index;
+
+        // ear clipping: list of remaining vertices, ear weights
+        std::vector<int> prev, next;
+        std::vector<Scalar> ear;
+        std::vector<IndexType> sorted;
+
+        // edges (i,j) to insert, clipping ears (j,k) or splitting by index
+        std::vector<ivec2> edges;
+        bool clipped;
+    };
+
+    // collect halfedges and vertices of f, false if f is non-manifold
+    bool collect(Face f, Polygon& polygon) const;
+
+    // compute the edges of the triangulation of polygon
+    void compute(Polygon& polygon) const;
+
+    // is the polygon convex and are all its diagonals new edges?
+    bool is_convex(Polygon& polygon) const;
+
+    // ear clipping for convex polygons
+    void clip_ears(Polygon& polygon) const;
+
+    // optimal triangulation by dynamic programming
+    void optimize(Polygon& polygon) const;
+
+    // insert the edges of the triangulation into the mesh
+    void insert_edges(Polygon& polygon);
+
     // compute the weight of the triangle (i,j,k).
-    Scalar compute_weight(int i, int j, int k) const;
+    Scalar compute_weight(const Polygon& polygon, int i, int j, int k) const;
+
+    // compute the weight of the triangle (a,b,c) by the objective
+    Scalar triangle_weight(Vertex a, Vertex b, Vertex c) const;
 
     // does edge (a,b) exist?
     bool is_edge(Vertex a, Vertex b) const;
@@ -48,17 +102,14 @@ private:
     bool is_interior_edge(Vertex a, Vertex b) const;
 
     // add edges from vertex i to j
-    bool insert_edge(int i, int j);
+    bool insert_edge(const Polygon& polygon, int i, int j);
 
     // mesh and properties
     SurfaceMesh& mesh_;
     VertexProperty<Point> points_;
-    std::vector<Halfedge> halfedges_;
-    std::vector<Vertex> vertices_;
 
-    // data for computing optimal triangulation
-    std::vector<std::vector<Scalar>> weight_;
-    std::vector<std::vector<int>> index_;
+    // polygon for triangulating a single face
+    Polygon polygon_;
 };
 
 } // namespace pmp
@@ -0,0 +1,85 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/TextureMapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+Scalar quantile(std::vector<Scalar>& values, Scalar q)
+{
+    if (values.empty())
+        throw InvalidInputException("quantile: No values given.");
+
+    q = std::min(std::max(q, Scalar(0)), Scalar(1));
+    const auto nth = values.begin() + size_t(q * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+void values_to_texture_coordinates(SurfaceMesh& mesh,
+                                   VertexProperty<Scalar> values,
+                                   Scalar clamp)
+{
+    if (mesh.n_vertices() == 0)
+        return;
+
+    std::vector<Scalar> sorted;
+    sorted.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+        sorted.push_back(values[v]);
+
+    // the upper quantile is among the values above the lower one
+    const size_t n = sorted.size() - 1;
+    const size_t i = size_t(std::min(std::max(clamp, Scalar(0)), Scalar(0.5)) *
+                            Scalar(n));
+    std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+    Scalar lower = sorted[i];
+    std::nth_element(sorted.begin() + i, sorted.begin() + (n - i),
+                     sorted.end());
+    Scalar upper = sorted[n - i];
+
+    auto tex = mesh.vertex_property<TexCoord>("v:tex");
+    if (lower < 0.0) // signed
+    {
+        upper = std::max(std::fabs(lower), std::fabs(upper));
+        parallel_for(mesh.vertices(), [&](Vertex v) {
+            tex[v] = TexCoord((0.5f * values[v] / upper) + 0.5f, 0.0);
+        });
+    }
+    else // unsigned
+    {
+        parallel_for(mesh.vertices(), [&](Vertex v) {
+            tex[v] = TexCoord((values[v] - lower) / (upper - lower), 0.0);
+        });
+    }
+}
+
+void distances_to_texture_coordinates(SurfaceMesh& mesh,
+                                      VertexProperty<Scalar> distances)
+{
+    const Scalar unreached = std::numeric_limits<Scalar>::max();
+
+    // maximum distance of the reached vertices
+    const Scalar maxdist = parallel_reduce(
+        0, int(mesh.vertices_size()), Scalar(0),
+        [&](int i) {
+            const Vertex v(i);
+            const Scalar d = distances[v];
+            return mesh.is_deleted(v) || d == unreached ? Scalar(0) : d;
+        },
+        [](Scalar a, Scalar b) { return std::max(a, b); });
+
+    auto tex = mesh.vertex_property<TexCoord>("v:tex");
+    parallel_for(mesh.vertices(), [&](Vertex v) {
+        const Scalar d = distances[v];
+        tex[v] = TexCoord(d < unreached ? d / maxdist : 1.0, 0.0);
+    });
+}
+
+} // namespace pmp
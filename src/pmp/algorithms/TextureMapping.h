@@ -0,0 +1,43 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \addtogroup algorithms
+//! @{
+
+//! \brief Return the \p q quantile of \p values for \p q in `[0, 1]`.
+//! \details Selects the element at index `q * (n - 1)`, rounded down, of the
+//! \p n sorted values with `std::nth_element` in linear time instead of
+//! sorting them. Reorders \p values.
+//! \throw InvalidInputException if \p values is empty.
+Scalar quantile(std::vector<Scalar>& values, Scalar q);
+
+//! \brief Map the scalar field \p values to 1D texture coordinates in the
+//! vertex property \c "v:tex" for color coding.
+//! \details The lowest and the highest fraction \p clamp of the values are
+//! treated as outliers and mapped beyond `[0, 1]`, to be clamped by the
+//! texture. Fields with negative values are mapped symmetrically, such that
+//! zero maps to 0.5, otherwise the remaining range is mapped to `[0, 1]`.
+//! The quantiles are found by selection, the coordinates are written in
+//! parallel.
+void values_to_texture_coordinates(SurfaceMesh& mesh,
+                                   VertexProperty<Scalar> values,
+                                   Scalar clamp = 0.05);
+
+//! \brief Map the distance field \p distances to 1D texture coordinates in
+//! the vertex property \c "v:tex" for color coding.
+//! \details Divides the distances by their maximum, vertices with the
+//! maximum Scalar as distance, i.e., not reached, get 1. Runs in parallel.
+void distances_to_texture_coordinates(SurfaceMesh& mesh,
+                                      VertexProperty<Scalar> distances);
+
+//! @}
+
+} // namespace pmp
@@ -0,0 +1,673 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/algorithms/TriangleBVH.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "pmp/BoundingBox.h"
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/DistancePointTriangle.h"
+
+namespace pmp {
+
+namespace {
+
+// number of bins per axis for evaluating the surface area heuristic
+const int n_bins = 16;
+
+// deeper nodes become leaves, which bounds the traversal stack
+const unsigned int max_depth = 48;
+
+// number of rays traversed together by batched ray queries
+const int packet_size = 8;
+
+Scalar surface_area(const Point& min, const Point& max)
+{
+    const Point d = max - min;
+    return 2 * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+}
+
+Scalar surface_area(BoundingBox& bbox)
+{
+    return bbox.is_empty() ? 0 : surface_area(bbox.min(), bbox.max());
+}
+
+// inverse ray direction for slab tests, infinite for zero components
+Point inverse_direction(const Point& d)
+{
+    const Scalar inf = std::numeric_limits<Scalar>::infinity();
+    return Point(d[0] != 0 ? 1 / d[0] : inf, d[1] != 0 ? 1 / d[1] : inf,
+                 d[2] != 0 ? 1 / d[2] : inf);
+}
+
+// Intersect the ray origin + t * inv_dir^-1 with the box [min, max] for t in
+// [t_min, t_max], store the entry parameter in t_entry.
+bool intersect_box(const Point& min, const Point& max, const Point& origin,
+                   const Point& inv_dir, Scalar t_min, Scalar t_max,
+                   Scalar& t_entry)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        Scalar t0 = (min[i] - origin[i]) * inv_dir[i];
+        Scalar t1 = (max[i] - origin[i]) * inv_dir[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        // the comparisons ignore NaN from a ray in a slab's boundary plane
+        t_min = std::max(t_min, t0);
+        t_max = std::min(t_max, t1);
+    }
+    t_entry = t_min;
+    return t_min <= t_max;
+}
+
+// Intersect a ray with the triangle x using the algorithm of Moeller and
+// Trumbore, store the ray parameter in t.
+bool intersect_triangle(const Point& origin, const Point& dir, const Point* x,
+                        Scalar t_min, Scalar t_max, Scalar& t)
+{
+    const Point e1 = x[1] - x[0];
+    const Point e2 = x[2] - x[0];
+    const Point q = cross(dir, e2);
+    const Scalar det = dot(e1, q);
+    if (det == 0)
+        return false;
+
+    const Scalar inv_det = 1 / det;
+    const Point s = origin - x[0];
+    const Scalar u = dot(s, q) * inv_det;
+    if (u < 0 || u > 1)
+        return false;
+
+    const Point r = cross(s, e1);
+    const Scalar v = dot(dir, r) * inv_det;
+    if (v < 0 || u + v > 1)
+        return false;
+
+    t = dot(e2, r) * inv_det;
+    return t >= t_min && t <= t_max;
+}
+
+} // namespace
+
+TriangleBVH::TriangleBVH(const SurfaceMesh& mesh, unsigned int max_faces)
+    : max_faces_(std::max(max_faces, 1u))
+{
+    if (!mesh.is_triangle_mesh())
+        throw InvalidInputException("Input is not a pure triangle mesh!");
+
+    // collect triangles and their centers
+    std::vector<Point> centers;
+    triangles_.reserve(mesh.n_faces());
+    centers.reserve(mesh.n_faces());
+    for (auto f : mesh.faces())
+    {
+        Triangle t;
+        int i = 0;
+        for (auto v : mesh.vertices(f))
+            t.x[i++] = mesh.position(v);
+        t.f = f;
+        triangles_.push_back(t);
+        centers.push_back((t.x[0] + t.x[1] + t.x[2]) / Scalar(3));
+    }
+    if (triangles_.empty())
+        return;
+
+    std::vector<IndexType> order(triangles_.size());
+    std::iota(order.begin(), order.end(), 0);
+    nodes_.reserve(2 * triangles_.size() / max_faces_ + 1);
+    build_recurse(order, centers, 0, IndexType(triangles_.size()), max_faces_,
+                  0);
+
+    // store the triangles of each leaf contiguously
+    std::vector<Triangle> sorted(triangles_.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        sorted[i] = triangles_[order[i]];
+    triangles_.swap(sorted);
+    nodes_.shrink_to_fit();
+    relative_areas(build_areas_);
+}
+
+size_t TriangleBVH::refit(const SurfaceMesh& mesh, Scalar max_growth)
+{
+    if (!mesh.is_triangle_mesh() || mesh.n_faces() != triangles_.size())
+        throw InvalidInputException("Faces differ from the hierarchy!");
+
+    // update the corners, the faces keep their place in triangles_
+    const int n = int(triangles_.size());
+    parallel_for(0, n, [&](int i) {
+        Triangle& t = triangles_[i];
+        int k = 0;
+        for (auto v : mesh.vertices(t.f))
+            t.x[k++] = mesh.position(v);
+    });
+    if (nodes_.empty())
+        return 0;
+
+    // boxes of the leaves, then of the inner nodes bottom-up. Children follow
+    // their parent, so a reverse sweep visits them first.
+    const int n_nodes = int(nodes_.size());
+    parallel_for(0, n_nodes, [&](int i) {
+        Node& node = nodes_[i];
+        if (!node.n_triangles)
+            return;
+        BoundingBox bbox;
+        for (IndexType j = node.offset; j < node.offset + node.n_triangles;
+             ++j)
+            for (const Point& x : triangles_[j].x)
+                bbox += x;
+        node.min = bbox.min();
+        node.max = bbox.max();
+    });
+    for (int i = n_nodes - 1; i >= 0; --i)
+    {
+        Node& node = nodes_[i];
+        if (node.n_triangles)
+            continue;
+        const Node& left = nodes_[i + 1];
+        const Node& right = nodes_[node.offset];
+        node.min = min(left.min, right.min);
+        node.max = max(left.max, right.max);
+    }
+
+    // rebuild subtrees whose area relative to the root grew too much
+    std::vector<Scalar> areas;
+    relative_areas(areas);
+    bool degraded = false;
+    for (int i = 0; i < n_nodes && !degraded; ++i)
+        degraded = !nodes_[i].n_triangles &&
+                   areas[i] > max_growth * build_areas_[i];
+    if (!degraded)
+        return 0;
+
+    std::vector<Node> old_nodes;
+    std::vector<Scalar> old_build_areas;
+    old_nodes.swap(nodes_);
+    old_build_areas.swap(build_areas_);
+    nodes_.reserve(old_nodes.size());
+    build_areas_.reserve(old_nodes.size());
+
+    std::vector<IndexType> order(triangles_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<Point> centers(triangles_.size());
+    const size_t n_rebuilt =
+        rebuild_recurse(old_nodes, old_build_areas, areas, max_growth, 0, 0,
+                        order, centers);
+
+    std::vector<Triangle> sorted(triangles_.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        sorted[i] = triangles_[order[i]];
+    triangles_.swap(sorted);
+    return n_rebuilt;
+}
+
+size_t TriangleBVH::rebuild_recurse(const std::vector<Node>& old_nodes,
+                                    const std::vector<Scalar>& old_areas,
+                                    const std::vector<Scalar>& areas,
+                                    Scalar max_growth, IndexType i,
+                                    unsigned int depth,
+                                    std::vector<IndexType>& order,
+                                    std::vector<Point>& centers)
+{
+    const Node& node = old_nodes[i];
+
+    // leaf
+    if (node.n_triangles)
+    {
+        nodes_.push_back(node);
+        build_areas_.push_back(old_areas[i]);
+        return 0;
+    }
+
+    // inner node that is kept
+    if (areas[i] <= max_growth * old_areas[i])
+    {
+        const size_t index = nodes_.size();
+        nodes_.push_back(node);
+        build_areas_.push_back(old_areas[i]);
+        size_t n_rebuilt = rebuild_recurse(old_nodes, old_areas, areas,
+                                           max_growth, i + 1, depth + 1,
+                                           order, centers);
+        nodes_[index].offset = IndexType(nodes_.size());
+        n_rebuilt += rebuild_recurse(old_nodes, old_areas, areas, max_growth,
+                                     node.offset, depth + 1, order, centers);
+        return n_rebuilt;
+    }
+
+    // degraded subtree, its triangles are contiguous from the first
+    // triangle of its leftmost leaf to the last one of its rightmost leaf
+    IndexType first = i, last = i;
+    while (!old_nodes[first].n_triangles)
+        ++first;
+    while (!old_nodes[last].n_triangles)
+        last = old_nodes[last].offset;
+    const IndexType begin = old_nodes[first].offset;
+    const IndexType end = old_nodes[last].offset + old_nodes[last].n_triangles;
+
+    for (IndexType j = begin; j < end; ++j)
+    {
+        const Triangle& t = triangles_[j];
+        centers[j] = (t.x[0] + t.x[1] + t.x[2]) / Scalar(3);
+    }
+    const size_t n_before = nodes_.size();
+    build_recurse(order, centers, begin, end, max_faces_, depth);
+
+    // the box of the root is not changed by rebuilding subtrees
+    const Scalar root_area = surface_area(nodes_[0].min, nodes_[0].max);
+    for (size_t j = n_before; j < nodes_.size(); ++j)
+        build_areas_.push_back(relative_area(nodes_[j], root_area));
+    return 1;
+}
+
+Scalar TriangleBVH::relative_area(const Node& node, Scalar root_area)
+{
+    return root_area > 0 ? surface_area(node.min, node.max) / root_area
+                         : Scalar(0);
+}
+
+void TriangleBVH::relative_areas(std::vector<Scalar>& areas) const
+{
+    areas.resize(nodes_.size());
+    if (nodes_.empty())
+        return;
+    const Scalar root_area = surface_area(nodes_[0].min, nodes_[0].max);
+    for (size_t i = 0; i < nodes_.size(); ++i)
+        areas[i] = relative_area(nodes_[i], root_area);
+}
+
+void TriangleBVH::build_recurse(std::vector<IndexType>& order,
+                                const std::vector<Point>& centers,
+                                IndexType begin, IndexType end,
+                                unsigned int max_faces, unsigned int depth)
+{
+    const IndexType index = IndexType(nodes_.size());
+    nodes_.emplace_back();
+
+    // bounding boxes of the triangles and of their centers
+    BoundingBox bbox, cbox;
+    for (IndexType i = begin; i < end; ++i)
+    {
+        const Triangle& t = triangles_[order[i]];
+        bbox += t.x[0];
+        bbox += t.x[1];
+        bbox += t.x[2];
+        cbox += centers[order[i]];
+    }
+    nodes_[index].min = bbox.min();
+    nodes_[index].max = bbox.max();
+
+    // find the cheapest split by the surface area heuristic, binning the
+    // triangles by their centers along each axis
+    const IndexType n = end - begin;
+    int best_axis = -1;
+    int best_bin = 0;
+    Scalar best_cost = std::numeric_limits<Scalar>::max();
+
+    auto bin = [&](const Point& c, int axis) {
+        const Scalar lo = cbox.min()[axis];
+        const Scalar extent = cbox.max()[axis] - lo;
+        const int b = int(n_bins * ((c[axis] - lo) / extent));
+        return std::min(b, n_bins - 1);
+    };
+
+    if (n > max_faces && depth < max_depth)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (!(cbox.max()[axis] > cbox.min()[axis]))
+                continue;
+
+            BoundingBox boxes[n_bins];
+            IndexType counts[n_bins] = {};
+            for (IndexType i = begin; i < end; ++i)
+            {
+                const int b = bin(centers[order[i]], axis);
+                const Triangle& t = triangles_[order[i]];
+                boxes[b] += t.x[0];
+                boxes[b] += t.x[1];
+                boxes[b] += t.x[2];
+                ++counts[b];
+            }
+
+            // sweep from the right, then evaluate the splits from the left
+            Scalar right_area[n_bins];
+            IndexType right_count[n_bins];
+            BoundingBox box;
+            IndexType count = 0;
+            for (int b = n_bins - 1; b > 0; --b)
+            {
+                box += boxes[b];
+                count += counts[b];
+                right_area[b] = surface_area(box);
+                right_count[b] = count;
+            }
+
+            box = BoundingBox();
+            count = 0;
+            for (int b = 0; b < n_bins - 1; ++b)
+            {
+                box += boxes[b];
+                count += counts[b];
+                if (count == 0 || count == n)
+                    continue;
+
+                const Scalar cost = count * surface_area(box) +
+                                    right_count[b + 1] * right_area[b + 1];
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = b;
+                }
+            }
+        }
+    }
+
+    // leaf
+    if (best_axis == -1)
+    {
+        nodes_[index].offset = begin;
+        nodes_[index].n_triangles = n;
+        return;
+    }
+
+    // inner node, the first child directly follows
+    auto mid = std::partition(
+        order.begin() + begin, order.begin() + end,
+        [&](IndexType t) { return bin(centers[t], best_axis) <= best_bin; });
+    const IndexType split = IndexType(mid - order.begin());
+
+    build_recurse(order, centers, begin, split, max_faces, depth + 1);
+    nodes_[index].offset = IndexType(nodes_.size());
+    nodes_[index].n_triangles = 0;
+    build_recurse(order, centers, split, end, max_faces, depth + 1);
+}
+
+TriangleBVH::NearestNeighbor TriangleBVH::nearest(const Point& p) const
+{
+    NearestNeighbor data;
+    data.dist = std::numeric_limits<Scalar>::max();
+    data.tests = 0;
+    if (nodes_.empty())
+        return data;
+
+    Scalar sqr_dist = std::numeric_limits<Scalar>::max();
+    IndexType stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const IndexType i = stack[--top];
+        const Node& node = nodes_[i];
+        if (sqr_distance(node, p) > sqr_dist)
+            continue;
+
+        // leaf: test its triangles, equally near ones go to the lowest face
+        // index to make the result independent of the hierarchy
+        if (node.n_triangles)
+        {
+            Point n;
+            for (IndexType j = node.offset; j < node.offset + node.n_triangles;
+                 ++j)
+            {
+                const Triangle& t = triangles_[j];
+                const Scalar d =
+                    dist_point_triangle(p, t.x[0], t.x[1], t.x[2], n);
+                ++data.tests;
+                if (d < data.dist ||
+                    (d == data.dist && t.f.idx() < data.face.idx()))
+                {
+                    data.dist = d;
+                    data.face = t.f;
+                    data.nearest = n;
+                    sqr_dist = d * d;
+                }
+            }
+        }
+
+        // inner node: visit the nearer child first
+        else
+        {
+            IndexType near = i + 1, far = node.offset;
+            Scalar near_dist = sqr_distance(nodes_[near], p);
+            Scalar far_dist = sqr_distance(nodes_[far], p);
+            if (far_dist < near_dist)
+            {
+                std::swap(near, far);
+                std::swap(near_dist, far_dist);
+            }
+            if (far_dist <= sqr_dist)
+                stack[top++] = far;
+            if (near_dist <= sqr_dist)
+                stack[top++] = near;
+        }
+    }
+
+    return data;
+}
+
+void TriangleBVH::nearest(const std::vector<Point>& points,
+                          std::vector<NearestNeighbor>& result) const
+{
+    result.resize(points.size());
+    const int n = int(points.size());
+
+    parallel_for(
+        0, n,
+        [&](int i) { result[i] = nearest(points[i]); },
+        256);
+}
+
+template <class Visit>
+void TriangleBVH::traverse(const Ray& ray, Scalar& t_max, Visit visit) const
+{
+    if (nodes_.empty())
+        return;
+
+    const Point inv_dir = inverse_direction(ray.direction);
+    Scalar t_entry;
+    IndexType stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const IndexType i = stack[--top];
+        const Node& node = nodes_[i];
+        if (!intersect_box(node.min, node.max, ray.origin, inv_dir,
+                           ray.t_min, t_max, t_entry))
+            continue;
+
+        // leaf: test its triangles
+        if (node.n_triangles)
+        {
+            Scalar t;
+            for (IndexType j = node.offset; j < node.offset + node.n_triangles;
+                 ++j)
+                if (intersect_triangle(ray.origin, ray.direction,
+                                       triangles_[j].x, ray.t_min, t_max, t) &&
+                    visit(j, t))
+                    return;
+        }
+
+        // inner node: visit the child entered first first
+        else
+        {
+            const Scalar none = std::numeric_limits<Scalar>::max();
+            IndexType near = i + 1, far = node.offset;
+            Scalar t_near, t_far;
+            if (!intersect_box(nodes_[near].min, nodes_[near].max, ray.origin,
+                               inv_dir, ray.t_min, t_max, t_near))
+                t_near = none;
+            if (!intersect_box(nodes_[far].min, nodes_[far].max, ray.origin,
+                               inv_dir, ray.t_min, t_max, t_far))
+                t_far = none;
+            if (t_far < t_near)
+            {
+                std::swap(near, far);
+                std::swap(t_near, t_far);
+            }
+            if (t_far != none)
+                stack[top++] = far;
+            if (t_near != none)
+                stack[top++] = near;
+        }
+    }
+}
+
+TriangleBVH::RayHit TriangleBVH::intersect(const Ray& ray) const
+{
+    RayHit hit;
+    hit.t = std::numeric_limits<Scalar>::max();
+    Scalar t_max = ray.t_max;
+    traverse(ray, t_max, [&](IndexType j, Scalar t) {
+        hit.t = t_max = t;
+        hit.face = triangles_[j].f;
+        return false;
+    });
+    if (hit.face.is_valid())
+        hit.point = ray.origin + hit.t * ray.direction;
+    return hit;
+}
+
+void TriangleBVH::intersect(const std::vector<Ray>& rays,
+                            std::vector<RayHit>& hits) const
+{
+    hits.resize(rays.size());
+    const int n = int(rays.size());
+    const int n_packets = (n + packet_size - 1) / packet_size;
+
+    parallel_for(
+        0, n_packets,
+        [&](int i) {
+            const int first = i * packet_size;
+            intersect_packet(&rays[first], std::min(packet_size, n - first),
+                             &hits[first]);
+        },
+        16);
+}
+
+void TriangleBVH::intersect_packet(const Ray* rays, int n, RayHit* hits) const
+{
+    Point inv_dir[packet_size];
+    Scalar t_max[packet_size];
+    for (int k = 0; k < n; ++k)
+    {
+        inv_dir[k] = inverse_direction(rays[k].direction);
+        t_max[k] = rays[k].t_max;
+        hits[k].t = std::numeric_limits<Scalar>::max();
+        hits[k].face = Face();
+    }
+    if (nodes_.empty())
+        return;
+
+    IndexType stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const IndexType i = stack[--top];
+        const Node& node = nodes_[i];
+
+        // rays of the packet that hit the node, and the first entry
+        unsigned int active = 0;
+        int first = -1;
+        Scalar t_entry;
+        for (int k = 0; k < n; ++k)
+            if (intersect_box(node.min, node.max, rays[k].origin, inv_dir[k],
+                              rays[k].t_min, t_max[k], t_entry))
+            {
+                active |= 1u << k;
+                if (first == -1)
+                    first = k;
+            }
+        if (!active)
+            continue;
+
+        // leaf: test its triangles against the active rays
+        if (node.n_triangles)
+        {
+            Scalar t;
+            for (IndexType j = node.offset; j < node.offset + node.n_triangles;
+                 ++j)
+            {
+                const Triangle& triangle = triangles_[j];
+                for (int k = first; k < n; ++k)
+                    if ((active & (1u << k)) &&
+                        intersect_triangle(rays[k].origin, rays[k].direction,
+                                           triangle.x, rays[k].t_min,
+                                           t_max[k], t))
+                    {
+                        hits[k].t = t_max[k] = t;
+                        hits[k].face = triangle.f;
+                    }
+            }
+        }
+
+        // inner node: visit the child the first active ray enters first
+        else
+        {
+            IndexType near = i + 1, far = node.offset;
+            Scalar t_near, t_far;
+            const Ray& ray = rays[first];
+            if (!intersect_box(nodes_[near].min, nodes_[near].max, ray.origin,
+                               inv_dir[first], ray.t_min, t_max[first],
+                               t_near))
+                t_near = std::numeric_limits<Scalar>::max();
+            if (!intersect_box(nodes_[far].min, nodes_[far].max, ray.origin,
+                               inv_dir[first], ray.t_min, t_max[first], t_far))
+                t_far = std::numeric_limits<Scalar>::max();
+            if (t_far < t_near)
+                std::swap(near, far);
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+
+    for (int k = 0; k < n; ++k)
+        if (hits[k].face.is_valid())
+            hits[k].point = rays[k].origin + hits[k].t * rays[k].direction;
+}
+
+bool TriangleBVH::occluded(const Ray& ray) const
+{
+    bool hit = false;
+    Scalar t_max = ray.t_max;
+    traverse(ray, t_max, [&](IndexType, Scalar) { return (hit = true); });
+    return hit;
+}
+
+std::vector<TriangleBVH::RayHit> TriangleBVH::intersect_all(
+    const Ray& ray) const
+{
+    std::vector<RayHit> hits;
+    Scalar t_max = ray.t_max;
+    traverse(ray, t_max, [&](IndexType j, Scalar t) {
+        hits.push_back(
+            RayHit{t, triangles_[j].f, ray.origin + t * ray.direction});
+        return false;
+    });
+    std::sort(hits.begin(), hits.end(),
+              [](const RayHit& a, const RayHit& b) { return a.t < b.t; });
+    return hits;
+}
+
+Scalar TriangleBVH::sqr_distance(const Node& node, const Point& p)
+{
+    Scalar d(0);
+    for (int i = 0; i < 3; ++i)
+    {
+        const Scalar e =
+            std::max(std::max(node.min[i] - p[i], p[i] - node.max[i]),
+                     Scalar(0));
+        d += e * e;
+    }
+    return d;
+}
+
+} // namespace pmp
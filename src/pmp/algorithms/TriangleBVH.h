@@ -0,0 +1,163 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "pmp/SurfaceMesh.h"
+
+namespace pmp {
+
+//! \brief A bounding volume hierarchy for closest point queries on triangles.
+//! \details An alternative to TriangleKdTree that also answers ray queries.
+//! The hierarchy is built with the surface area heuristic and stored in one
+//! flat array in depth-first order, with the triangles of each leaf stored
+//! contiguously. Queries traverse it iteratively, nearer child first, and
+//! can be run for many points or rays in parallel. For meshes whose vertices
+//! move while the faces stay the same, the hierarchy can be refit instead of
+//! rebuilt.
+//! \ingroup algorithms
+class TriangleBVH
+{
+public:
+    //! \brief Construct from the faces of the triangle mesh \p mesh.
+    //! \details Nodes with at most \p max_faces triangles become leaves.
+    //! \throw InvalidInputException if \p mesh is not a triangle mesh.
+    TriangleBVH(const SurfaceMesh& mesh, unsigned int max_faces = 4);
+
+    //! nearest neighbor information
+    struct NearestNeighbor
+    {
+        Scalar dist;
+        Face face;
+        Point nearest;
+        int tests;
+    };
+
+    //! Return the nearest point on the triangles to \p p.
+    NearestNeighbor nearest(const Point& p) const;
+
+    //! \brief Find the nearest neighbors of all \p points in parallel.
+    //! \details The i-th entry of \p result is the nearest neighbor of the
+    //! i-th point.
+    void nearest(const std::vector<Point>& points,
+                 std::vector<NearestNeighbor>& result) const;
+
+    //! \brief A ray for intersection queries.
+    //! \details The ray covers the points origin + t * direction with
+    //! t_min <= t <= t_max. A segment from \c a to \c b is the ray with
+    //! origin \c a, direction \c b - \c a, and t_max 1. The direction does
+    //! not need to be normalized.
+    struct Ray
+    {
+        Ray(const Point& o, const Point& d, Scalar t0 = 0,
+            Scalar t1 = std::numeric_limits<Scalar>::max())
+            : origin(o), direction(d), t_min(t0), t_max(t1)
+        {
+        }
+
+        Point origin;
+        Point direction;
+        Scalar t_min;
+        Scalar t_max;
+    };
+
+    //! intersection of a ray with a triangle
+    struct RayHit
+    {
+        Scalar t;    //!< ray parameter of the intersection
+        Face face;   //!< hit face, invalid if there is no hit
+        Point point; //!< intersection point
+    };
+
+    //! Return the first intersection of \p ray with the triangles.
+    RayHit intersect(const Ray& ray) const;
+
+    //! \brief Find the first intersections of all \p rays in parallel.
+    //! \details Packets of consecutive rays are traversed together, visiting
+    //! a node once for all rays of a packet that hit its box. This is
+    //! efficient for coherent rays, e.g., the rays through neighboring
+    //! pixels. The i-th entry of \p hits belongs to the i-th ray.
+    void intersect(const std::vector<Ray>& rays,
+                   std::vector<RayHit>& hits) const;
+
+    //! Return whether \p ray hits any triangle, stopping at the first hit.
+    bool occluded(const Ray& ray) const;
+
+    //! Return all intersections of \p ray sorted by increasing t.
+    std::vector<RayHit> intersect_all(const Ray& ray) const;
+
+    //! \brief Update the hierarchy to the vertex positions of \p mesh.
+    //! \details \p mesh must have the faces the hierarchy was built from,
+    //! only its vertex positions may have changed. The bounding boxes are
+    //! refit bottom-up, which keeps the structure but degrades it for large
+    //! deformations. Subtrees whose surface area relative to the root grew
+    //! by more than the factor \p max_growth since they were built are
+    //! rebuilt. Pass infinity to only refit the boxes.
+    //! \return the number of rebuilt subtrees
+    //! \throw InvalidInputException if \p mesh is not a triangle mesh or its
+    //! number of faces differs.
+    size_t refit(const SurfaceMesh& mesh, Scalar max_growth = 2);
+
+    //! number of nodes of the hierarchy
+    size_t n_nodes() const { return nodes_.size(); }
+
+private:
+    // triangle stores corners and face handle
+    struct Triangle
+    {
+        Point x[3];
+        Face f;
+    };
+
+    // node of the hierarchy, its first child directly follows it
+    struct Node
+    {
+        Point min, max;        // bounding box
+        IndexType offset;      // first triangle of a leaf, or second child
+        IndexType n_triangles; // zero for inner nodes
+    };
+
+    // build the subtree of the triangles order[begin, end), partitioning
+    // order by their centers
+    void build_recurse(std::vector<IndexType>& order,
+                       const std::vector<Point>& centers, IndexType begin,
+                       IndexType end, unsigned int max_faces,
+                       unsigned int depth);
+
+    // copy the subtree of old node i to nodes_, rebuilding subtrees whose
+    // relative area grew by more than max_growth. Return their number.
+    size_t rebuild_recurse(const std::vector<Node>& old_nodes,
+                           const std::vector<Scalar>& old_areas,
+                           const std::vector<Scalar>& areas,
+                           Scalar max_growth, IndexType i, unsigned int depth,
+                           std::vector<IndexType>& order,
+                           std::vector<Point>& centers);
+
+    // surface area of a node relative to the one of the root
+    static Scalar relative_area(const Node& node, Scalar root_area);
+
+    // relative areas of all nodes
+    void relative_areas(std::vector<Scalar>& areas) const;
+
+    // squared distance from p to the bounding box of a node
+    static Scalar sqr_distance(const Node& node, const Point& p);
+
+    // call visit(j, t) for the triangles j hit by ray at t <= t_max, in
+    // roughly increasing order of t. visit may decrease t_max, and stops the
+    // traversal by returning true.
+    template <class Visit>
+    void traverse(const Ray& ray, Scalar& t_max, Visit visit) const;
+
+    // first intersections of the n rays of a packet
+    void intersect_packet(const Ray* rays, int n, RayHit* hits) const;
+
+    std::vector<Node> nodes_;
+    std::vector<Triangle> triangles_;
+    std::vector<Scalar> build_areas_; // relative node areas when built
+    unsigned int max_faces_;
+};
+
+} // namespace pmp
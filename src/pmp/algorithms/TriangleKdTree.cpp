@@ -3,61 +3,141 @@
 
 #include "pmp/algorithms/TriangleKdTree.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
+#include "pmp/Parallel.h"
 #include "pmp/algorithms/DistancePointTriangle.h"
-#include "pmp/BoundingBox.h"
 
 namespace pmp {
 
+namespace {
+
+// limit of the tree depth, which bounds the traversal stack
+const unsigned int depth_limit = 60;
+
+// subtrees with at most this many triangles are built by one thread, larger
+// nodes are split with parallel loops over chunks of triangles
+const size_t task_size = 4096;
+const size_t chunk_size = 1024;
+
+// consecutive points of batched queries handled by one task
+const int query_chunk_size = 256;
+
+// axis of the placeholder for a subtree that is built by a task
+const unsigned char placeholder = 4;
+
+// leaf triangles passed to dist_point_triangles() at once
+const size_t leaf_block_size = 16;
+
+} // namespace
+
 TriangleKdTree::TriangleKdTree(const SurfaceMesh& mesh, unsigned int max_faces,
                                unsigned int max_depth)
 {
-    // init
-    root_ = new Node();
-    root_->faces = new Triangles();
-    VertexProperty<Point> points = mesh.get_vertex_property<Point>("v:point");
+    // collect vertex positions, skipping deleted vertices
+    std::vector<IndexType> index(mesh.vertices_size(), PMP_MAX_INDEX);
+    points_.reserve(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        index[v.idx()] = IndexType(points_.size());
+        points_.push_back(mesh.position(v));
+    }
 
     // collect triangles
-    Triangle tri;
-    root_->faces->reserve(mesh.n_faces());
-    for (SurfaceMesh::FaceIterator fit = mesh.faces_begin();
-         fit != mesh.faces_end(); ++fit)
+    corners_.reserve(3 * mesh.n_faces());
+    faces_.reserve(mesh.n_faces());
+    for (auto f : mesh.faces())
     {
-        SurfaceMesh::VertexAroundFaceCirculator vfit = mesh.vertices(*fit);
-        tri.x[0] = points[*vfit];
+        SurfaceMesh::VertexAroundFaceCirculator vfit = mesh.vertices(f);
+        corners_.push_back(index[(*vfit).idx()]);
         ++vfit;
-        tri.x[1] = points[*vfit];
+        corners_.push_back(index[(*vfit).idx()]);
         ++vfit;
-        tri.x[2] = points[*vfit];
-        tri.f = *fit;
-        root_->faces->push_back(tri);
+        corners_.push_back(index[(*vfit).idx()]);
+        faces_.push_back(f);
     }
 
-    // call recursive helper
-    build_recurse(root_, max_faces, max_depth);
+    // the root contains all triangles
+    std::vector<IndexType> work(faces_.size());
+    for (size_t i = 0; i < work.size(); ++i)
+        work[i] = IndexType(i);
+
+    // split the large nodes, deferring small subtrees to tasks
+    Subtree top;
+    std::vector<Task> tasks;
+    build_recurse(work, 0, work.size(), max_faces,
+                  std::min(max_depth, depth_limit), top, &tasks);
+    std::vector<IndexType>().swap(work);
+
+    // build the subtrees in parallel
+    const int n_tasks = int(tasks.size());
+    parallel_for(
+        0, n_tasks,
+        [&](int i) {
+            Task& task = tasks[i];
+            build_recurse(task.work, 0, task.work.size(), max_faces, task.depth,
+                          task.tree, nullptr);
+            std::vector<IndexType>().swap(task.work);
+        },
+        1);
+
+    assemble(top, tasks);
+
+    // free memory
+    std::vector<Point>().swap(points_);
+    std::vector<IndexType>().swap(corners_);
+    std::vector<Face>().swap(faces_);
 }
 
-unsigned int TriangleKdTree::build_recurse(Node* node, unsigned int max_faces,
-                                           unsigned int depth)
+void TriangleKdTree::build_recurse(std::vector<IndexType>& work, size_t begin,
+                                   size_t end, unsigned int max_faces,
+                                   unsigned int depth, Subtree& tree,
+                                   std::vector<Task>* tasks) const
 {
-    // should we stop at this level ?
-    if ((depth == 0) || (node->faces->size() <= max_faces))
-        return depth;
+    const IndexType index = IndexType(tree.nodes.size());
+    tree.nodes.emplace_back();
 
-    std::vector<Triangle>::const_iterator fit, fend = node->faces->end();
-    unsigned int i;
-
-    // compute bounding box
-    BoundingBox bbox;
-    for (fit = node->faces->begin(); fit != fend; ++fit)
-    {
-        for (i = 0; i < 3; ++i)
+    auto make_leaf = [&]() {
+        Node& node = tree.nodes[index];
+        node.axis = 3;
+        node.index = IndexType(tree.leaf_faces.size());
+        node.n_faces = IndexType(end - begin);
+        for (size_t i = begin; i < end; ++i)
         {
-            bbox += fit->x[i];
+            const IndexType* c = &corners_[3 * work[i]];
+            for (int j = 0; j < 9; ++j)
+                tree.leaf_coords[j].push_back(points_[c[j / 3]][j % 3]);
+            tree.leaf_faces.push_back(faces_[work[i]]);
         }
+    };
+
+    // should we stop at this level ?
+    if ((depth == 0) || (end - begin <= max_faces))
+    {
+        make_leaf();
+        return;
     }
 
+    // leave small subtrees to a task
+    if (tasks && end - begin <= task_size)
+    {
+        Node& node = tree.nodes[index];
+        node.axis = placeholder;
+        node.index = IndexType(tasks->size());
+        node.n_faces = 0;
+
+        Task task;
+        task.work.assign(work.begin() + begin, work.begin() + end);
+        task.depth = depth;
+        tasks->push_back(std::move(task));
+        return;
+    }
+
+    // compute bounding box
+    BoundingBox bbox = bounding_box(work, begin, end);
+
     // split longest side of bounding box
     Point bb = bbox.max() - bbox.min();
     Scalar length = bb[0];
@@ -67,144 +147,427 @@ unsigned int TriangleKdTree::build_recurse(Node* node, unsigned int max_faces,
     if (bb[2] > length)
         length = bb[(axis = 2)];
 
-#if 1
     // split in the middle
     Scalar split = bbox.center()[axis];
-#else
-    // find split position as median
-    std::vector<Scalar> v;
-    v.reserve(node->faces->size() * 3);
-    for (fit = node->faces->begin(); fit != fend; ++fit)
-        for (i = 0; i < 3; ++i)
-            v.push_back(fit->x[i][axis]]);
-    std::sort(v.begin(), v.end());
-    split = v[v.size() / 2];
-#endif
-
-    // create children
-    auto* left = new Node();
-    left->faces = new Triangles();
-    left->faces->reserve(node->faces->size() / 2);
-    auto* right = new Node();
-    right->faces = new Triangles;
-    right->faces->reserve(node->faces->size() / 2);
-
-    // partition for left and right child
-    for (fit = node->faces->begin(); fit != fend; ++fit)
+
+    // partition for left and right child, appending their triangle lists
+    // to the work buffer
+    const size_t left_begin = work.size();
+    const size_t right_begin = partition(work, begin, end, axis, split);
+    const size_t right_end = work.size();
+
+    // stop here?
+    if (right_begin - left_begin == end - begin ||
+        right_end - right_begin == end - begin)
     {
-        bool l = false, r = false;
+        work.resize(left_begin);
+        make_leaf();
+        return;
+    }
 
-        const Triangle& t = *fit;
-        if (t.x[0][axis] <= split)
-            l = true;
-        else
-            r = true;
-        if (t.x[1][axis] <= split)
-            l = true;
-        else
-            r = true;
-        if (t.x[2][axis] <= split)
-            l = true;
-        else
-            r = true;
+    // store internal data
+    tree.nodes[index].axis = (unsigned char)axis;
+    tree.nodes[index].split = split;
+    tree.nodes[index].n_faces = 0;
+
+    // recurse to childen
+    build_recurse(work, left_begin, right_begin, max_faces, depth - 1, tree,
+                  tasks);
+    tree.nodes[index].index = IndexType(tree.nodes.size());
+    build_recurse(work, right_begin, right_end, max_faces, depth - 1, tree,
+                  tasks);
 
-        if (l)
+    work.resize(left_begin);
+}
+
+BoundingBox TriangleKdTree::bounding_box(const std::vector<IndexType>& work,
+                                         size_t begin, size_t end) const
+{
+    auto add = [&](BoundingBox& bbox, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
         {
-            left->faces->push_back(t);
+            const IndexType* c = &corners_[3 * work[i]];
+            bbox += points_[c[0]];
+            bbox += points_[c[1]];
+            bbox += points_[c[2]];
         }
+    };
+
+    BoundingBox bbox;
+    if (end - begin <= task_size)
+    {
+        add(bbox, begin, end);
+        return bbox;
+    }
+
+    // one box per chunk
+    const int n_chunks = int((end - begin + chunk_size - 1) / chunk_size);
+    std::vector<BoundingBox> boxes(n_chunks);
+    parallel_for(
+        0, n_chunks,
+        [&](int c) {
+            const size_t first = begin + c * chunk_size;
+            add(boxes[c], first, std::min(first + chunk_size, end));
+        },
+        1);
+
+    for (const auto& box : boxes)
+        bbox += box;
+    return bbox;
+}
+
+size_t TriangleKdTree::partition(std::vector<IndexType>& work, size_t begin,
+                                 size_t end, int axis, Scalar split) const
+{
+    // bit 1: triangle reaches the left side, bit 2: the right side
+    auto sides = [&](IndexType t) {
+        const IndexType* c = &corners_[3 * t];
+        int s = 0;
+        for (int i = 0; i < 3; ++i)
+            s |= (points_[c[i]][axis] <= split) ? 1 : 2;
+        return s;
+    };
 
-        if (r)
+    if (end - begin <= task_size)
+    {
+        for (size_t i = begin; i < end; ++i)
+            if (sides(work[i]) & 1)
+                work.push_back(work[i]);
+        const size_t right_begin = work.size();
+        for (size_t i = begin; i < end; ++i)
+            if (sides(work[i]) & 2)
+                work.push_back(work[i]);
+        return right_begin;
+    }
+
+    // count the triangles of each side per chunk
+    const int n_chunks = int((end - begin + chunk_size - 1) / chunk_size);
+    std::vector<size_t> n_left(n_chunks + 1, 0), n_right(n_chunks + 1, 0);
+    parallel_for(
+        0, n_chunks,
+        [&](int c) {
+            const size_t first = begin + c * chunk_size;
+            const size_t last = std::min(first + chunk_size, end);
+            for (size_t i = first; i < last; ++i)
+            {
+                const int s = sides(work[i]);
+                n_left[c + 1] += (s & 1);
+                n_right[c + 1] += (s >> 1);
+            }
+        },
+        1);
+
+    // prefix sums give the output position of each chunk
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        n_left[c + 1] += n_left[c];
+        n_right[c + 1] += n_right[c];
+    }
+    const size_t left_begin = work.size();
+    const size_t right_begin = left_begin + n_left[n_chunks];
+    work.resize(right_begin + n_right[n_chunks]);
+
+    // scatter, keeping the order of the triangles
+    parallel_for(
+        0, n_chunks,
+        [&](int c) {
+            const size_t first = begin + c * chunk_size;
+            const size_t last = std::min(first + chunk_size, end);
+            size_t l = left_begin + n_left[c];
+            size_t r = right_begin + n_right[c];
+            for (size_t i = first; i < last; ++i)
+            {
+                const int s = sides(work[i]);
+                if (s & 1)
+                    work[l++] = work[i];
+                if (s & 2)
+                    work[r++] = work[i];
+            }
+        },
+        1);
+
+    return right_begin;
+}
+
+void TriangleKdTree::assemble(const Subtree& top,
+                              const std::vector<Task>& tasks)
+{
+    // index of each node of top in the final tree
+    std::vector<IndexType> new_index(top.nodes.size());
+    size_t n_nodes = 0, n_leaf_faces = top.leaf_faces.size();
+    for (size_t i = 0; i < top.nodes.size(); ++i)
+    {
+        new_index[i] = IndexType(n_nodes);
+        if (top.nodes[i].axis == placeholder)
         {
-            right->faces->push_back(t);
+            const Subtree& tree = tasks[top.nodes[i].index].tree;
+            n_nodes += tree.nodes.size();
+            n_leaf_faces += tree.leaf_faces.size();
         }
+        else
+            ++n_nodes;
     }
 
-    // stop here?
-    if (left->faces->size() == node->faces->size() ||
-        right->faces->size() == node->faces->size())
+    nodes_.clear();
+    leaf_faces_.clear();
+    nodes_.reserve(n_nodes);
+    leaf_faces_.reserve(n_leaf_faces);
+    for (auto& coords : leaf_coords_)
+    {
+        coords.clear();
+        coords.reserve(n_leaf_faces);
+    }
+
+    for (Node node : top.nodes)
     {
-        // compact my memory
-        node->faces->shrink_to_fit();
+        // subtree of a task
+        if (node.axis == placeholder)
+        {
+            const Subtree& tree = tasks[node.index].tree;
+            const IndexType node_offset = IndexType(nodes_.size());
+            const IndexType leaf_offset = IndexType(leaf_faces_.size());
+            for (Node child : tree.nodes)
+            {
+                child.index += (child.axis == 3) ? leaf_offset : node_offset;
+                nodes_.push_back(child);
+            }
+            for (int j = 0; j < 9; ++j)
+                leaf_coords_[j].insert(leaf_coords_[j].end(),
+                                       tree.leaf_coords[j].begin(),
+                                       tree.leaf_coords[j].end());
+            leaf_faces_.insert(leaf_faces_.end(), tree.leaf_faces.begin(),
+                               tree.leaf_faces.end());
+        }
 
-        // delete new nodes
-        delete left;
-        delete right;
+        // leaf
+        else if (node.axis == 3)
+        {
+            const IndexType first = node.index;
+            node.index = IndexType(leaf_faces_.size());
+            nodes_.push_back(node);
+            for (int j = 0; j < 9; ++j)
+                leaf_coords_[j].insert(
+                    leaf_coords_[j].end(), top.leaf_coords[j].begin() + first,
+                    top.leaf_coords[j].begin() + first + node.n_faces);
+            leaf_faces_.insert(leaf_faces_.end(),
+                               top.leaf_faces.begin() + first,
+                               top.leaf_faces.begin() + first + node.n_faces);
+        }
 
-        // return tree depth
-        return depth;
+        // inner node
+        else
+        {
+            node.index = new_index[node.index];
+            nodes_.push_back(node);
+        }
     }
+}
 
-    // or recurse further?
-    else
+template <class Visit>
+void TriangleKdTree::traverse(const Point& p, Scalar& bound, Visit visit) const
+{
+    if (nodes_.empty())
+        return;
+
+    // nodes to visit and the distance to their splitting plane, the far
+    // children are only visited if they are closer than the bound
+    struct Entry
+    {
+        IndexType node;
+        Scalar dist;
+    };
+    Entry stack[depth_limit + 2];
+    int top = 0;
+    stack[top++] = Entry{0, 0};
+
+    while (top > 0)
     {
-        // free my memory
-        delete node->faces;
-        node->faces = nullptr;
+        const Entry entry = stack[--top];
+        if (std::fabs(entry.dist) >= bound)
+            continue;
 
-        // store internal data
-        node->axis = axis;
-        node->split = split;
-        node->left_child = left;
-        node->right_child = right;
+        const Node& node = nodes_[entry.node];
 
-        // recurse to childen
-        int depthLeft = build_recurse(node->left_child, max_faces, depth - 1);
-        int depthRight = build_recurse(node->right_child, max_faces, depth - 1);
+        // terminal node? test blocks of its triangles at once
+        if (node.axis == 3)
+        {
+            Scalar dist[leaf_block_size], b1[leaf_block_size],
+                b2[leaf_block_size];
+            const IndexType end = node.index + node.n_faces;
+            for (IndexType first = node.index; first < end;
+                 first += IndexType(leaf_block_size))
+            {
+                const size_t n =
+                    std::min(leaf_block_size, size_t(end - first));
+                const Scalar* x[9];
+                for (int j = 0; j < 9; ++j)
+                    x[j] = leaf_coords_[j].data() + first;
+                dist_point_triangles(p, x, n, dist, b1, b2);
+                for (size_t i = 0; i < n; ++i)
+                    visit(first + IndexType(i), dist[i], b1[i], b2[i]);
+            }
+        }
 
-        return std::min(depthLeft, depthRight);
+        // non-terminal node
+        else
+        {
+            const Scalar dist = p[node.axis] - node.split;
+            const IndexType left = entry.node + 1, right = node.index;
+            if (dist <= 0.0)
+            {
+                stack[top++] = Entry{right, dist};
+                stack[top++] = Entry{left, 0};
+            }
+            else
+            {
+                stack[top++] = Entry{left, dist};
+                stack[top++] = Entry{right, 0};
+            }
+        }
     }
 }
 
+Point TriangleKdTree::leaf_point(IndexType i, Scalar b1, Scalar b2) const
+{
+    Point x[3];
+    for (int j = 0; j < 9; ++j)
+        x[j / 3][j % 3] = leaf_coords_[j][i];
+    return x[0] + b1 * (x[1] - x[0]) + b2 * (x[2] - x[0]);
+}
+
+void TriangleKdTree::search(const Point& p, NearestNeighbor& data,
+                            IndexType& best) const
+{
+    traverse(p, data.dist, [&](IndexType i, Scalar d, Scalar b1, Scalar b2) {
+        ++data.tests;
+        if (d < data.dist)
+        {
+            data.dist = d;
+            data.face = leaf_faces_[i];
+            data.nearest = leaf_point(i, b1, b2);
+            best = i;
+        }
+    });
+}
+
 TriangleKdTree::NearestNeighbor TriangleKdTree::nearest(const Point& p) const
 {
     NearestNeighbor data;
     data.dist = std::numeric_limits<Scalar>::max();
     data.tests = 0;
-    nearest_recurse(root_, p, data);
+    IndexType best = PMP_MAX_INDEX;
+    search(p, data, best);
     return data;
 }
 
-void TriangleKdTree::nearest_recurse(Node* node, const Point& point,
-                                     NearestNeighbor& data) const
+void TriangleKdTree::nearest(const std::vector<Point>& points,
+                             std::vector<NearestNeighbor>& result) const
 {
-    // terminal node?
-    if (!node->left_child)
+    result.resize(points.size());
+    parallel_for_chunks(
+        0, int(points.size()),
+        [&](int first, int last) {
+            IndexType best = PMP_MAX_INDEX;
+            for (int i = first; i < last; ++i)
+            {
+                NearestNeighbor& data = result[i];
+                data.dist = std::numeric_limits<Scalar>::max();
+                data.face = Face();
+                data.tests = 0;
+
+                // the nearest triangle of the previous point bounds the search
+                if (best != PMP_MAX_INDEX)
+                {
+                    const Scalar* x[9];
+                    for (int j = 0; j < 9; ++j)
+                        x[j] = leaf_coords_[j].data() + best;
+                    Scalar b1, b2;
+                    dist_point_triangles(points[i], x, 1, &data.dist, &b1, &b2);
+                    data.nearest = leaf_point(best, b1, b2);
+                    data.face = leaf_faces_[best];
+                    data.tests = 1;
+                }
+
+                search(points[i], data, best);
+            }
+        },
+        query_chunk_size);
+}
+
+std::vector<TriangleKdTree::NearestNeighbor> TriangleKdTree::k_nearest(
+    const Point& p, unsigned int k) const
+{
+    // max-heap of the k nearest triangles found so far
+    std::vector<NearestNeighbor> result;
+    auto closer = [](const NearestNeighbor& a, const NearestNeighbor& b) {
+        return a.dist < b.dist;
+    };
+
+    Scalar bound = std::numeric_limits<Scalar>::max();
+    int tests = 0;
+    if (k > 0)
     {
-        Scalar d;
-        Point n;
+        traverse(p, bound, [&](IndexType i, Scalar d, Scalar b1, Scalar b2) {
+            ++tests;
+            if (d >= bound)
+                return;
 
-        auto fit = node->faces->begin(), fend = node->faces->end();
-        for (; fit != fend; ++fit)
-        {
-            d = dist_point_triangle(point, fit->x[0], fit->x[1], fit->x[2], n);
-            ++data.tests;
-            if (d < data.dist)
+            // triangles crossing a splitting plane are found several times
+            const Face f = leaf_faces_[i];
+            for (const auto& r : result)
+                if (r.face == f)
+                    return;
+
+            if (result.size() == k)
             {
-                data.dist = d;
-                data.face = fit->f;
-                data.nearest = n;
+                std::pop_heap(result.begin(), result.end(), closer);
+                result.pop_back();
             }
-        }
+            result.push_back(
+                NearestNeighbor{d, f, leaf_point(i, b1, b2), 0});
+            std::push_heap(result.begin(), result.end(), closer);
+            if (result.size() == k)
+                bound = result.front().dist;
+        });
     }
 
-    // non-terminal node
-    else
-    {
-        Scalar dist = point[node->axis] - node->split;
+    std::sort_heap(result.begin(), result.end(), closer);
+    for (auto& r : result)
+        r.tests = tests;
+    return result;
+}
 
-        if (dist <= 0.0)
-        {
-            nearest_recurse(node->left_child, point, data);
-            if (fabs(dist) < data.dist)
-                nearest_recurse(node->right_child, point, data);
-        }
-        else
-        {
-            nearest_recurse(node->right_child, point, data);
-            if (fabs(dist) < data.dist)
-                nearest_recurse(node->left_child, point, data);
-        }
-    }
+std::vector<TriangleKdTree::NearestNeighbor> TriangleKdTree::within_radius(
+    const Point& p, Scalar radius) const
+{
+    std::vector<NearestNeighbor> result;
+
+    // include triangles at distance radius
+    Scalar bound = std::nextafter(radius, std::numeric_limits<Scalar>::max());
+    int tests = 0;
+    traverse(p, bound, [&](IndexType i, Scalar d, Scalar b1, Scalar b2) {
+        ++tests;
+        if (d < bound)
+            result.push_back(NearestNeighbor{d, leaf_faces_[i],
+                                             leaf_point(i, b1, b2), 0});
+    });
+
+    // remove triangles found in several leaves, these have equal distances
+    std::sort(result.begin(), result.end(),
+              [](const NearestNeighbor& a, const NearestNeighbor& b) {
+                  return a.dist < b.dist ||
+                         (a.dist == b.dist && a.face.idx() < b.face.idx());
+              });
+    result.erase(std::unique(result.begin(), result.end(),
+                             [](const NearestNeighbor& a,
+                                const NearestNeighbor& b) {
+                                 return a.face == b.face;
+                             }),
+                 result.end());
+
+    for (auto& r : result)
+        r.tests = tests;
+    return result;
 }
 
 } // namespace pmp
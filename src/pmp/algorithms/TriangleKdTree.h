@@ -5,82 +5,134 @@
 
 #include <vector>
 
+#include "pmp/BoundingBox.h"
 #include "pmp/SurfaceMesh.h"
 
 namespace pmp {
 
 //! \brief A k-d tree for triangles
+//! \details The nodes are stored in one array in depth-first order. The
+//! corners of the triangles of each leaf are stored contiguously in
+//! structure-of-arrays layout, which a leaf references by a range, so that
+//! the triangles of a leaf are tested with dist_point_triangles(). Triangles
+//! crossing a splitting plane are stored in both children. Large meshes are
+//! split into subtrees that are built in parallel.
 //! \ingroup algorithms
 class TriangleKdTree
 {
 public:
-    //! Construct with mesh.
+    //! \brief Construct with mesh.
+    //! \details Nodes with at most \p max_faces triangles become leaves.
+    //! \p max_depth is limited to 60.
     TriangleKdTree(const SurfaceMesh& mesh, unsigned int max_faces = 10,
                    unsigned int max_depth = 30);
 
-    //! destructor
-    ~TriangleKdTree() { delete root_; }
-
     //! nearest neighbor information
     struct NearestNeighbor
     {
-        Scalar dist;
-        Face face;
-        Point nearest;
-        int tests;
+        Scalar dist;   //!< distance to the nearest triangle
+        Face face;     //!< face of the nearest triangle
+        Point nearest; //!< nearest point on the triangle
+        int tests;     //!< number of triangles tested by the query
     };
 
     //! Return handle of the nearest neighbor
     NearestNeighbor nearest(const Point& p) const;
 
+    //! \brief Find the nearest neighbors of all \p points in parallel.
+    //! \details The i-th entry of \p result is the nearest neighbor of the
+    //! i-th point. Consecutive points are handled by the same thread, and
+    //! the distance to the nearest triangle of the previous point is the
+    //! initial bound of each search. Among several triangles at the same
+    //! distance a different one than with nearest(const Point&) may be
+    //! returned.
+    void nearest(const std::vector<Point>& points,
+                 std::vector<NearestNeighbor>& result) const;
+
+    //! \brief Return the \p k triangles nearest to \p p.
+    //! \details The triangles are sorted by increasing distance. Fewer are
+    //! returned if the mesh has less than \p k faces. Intended for small \p k.
+    std::vector<NearestNeighbor> k_nearest(const Point& p,
+                                           unsigned int k) const;
+
+    //! \brief Return all triangles within distance \p radius of \p p.
+    //! \details The triangles are sorted by increasing distance.
+    std::vector<NearestNeighbor> within_radius(const Point& p,
+                                               Scalar radius) const;
+
+    //! number of nodes of the tree
+    size_t n_nodes() const { return nodes_.size(); }
+
 private:
-    // triangle stores corners and face handle
-    struct Triangle
+    // node of the tree, its left child directly follows it
+    struct Node
     {
-        Triangle() {}
-        Triangle(const Point& x0, const Point& x1, const Point& x2, Face ff)
-        {
-            x[0] = x0;
-            x[1] = x1;
-            x[2] = x2;
-            f = ff;
-        }
-
-        Point x[3];
-        Face f;
+        Scalar split;          // splitting plane of inner nodes
+        IndexType index;       // right child, or first triangle of a leaf
+        IndexType n_faces;     // number of triangles of a leaf
+        unsigned char axis;    // splitting axis, or 3 for leaves
     };
 
-    // vector of Triangle
-    typedef std::vector<Triangle> Triangles;
-
-    // Node of the tree: contains parent, children and splitting plane
-    struct Node
+    // nodes and leaf triangles of a subtree, with right children and leaf
+    // ranges relative to the subtree
+    struct Subtree
     {
-        Node() : faces(nullptr), left_child(nullptr), right_child(nullptr){};
-
-        ~Node()
-        {
-            delete faces;
-            delete left_child;
-            delete right_child;
-        }
-
-        unsigned char axis;
-        Scalar split;
-        Triangles* faces;
-        Node* left_child;
-        Node* right_child;
+        std::vector<Node> nodes;
+        std::vector<Scalar> leaf_coords[9];
+        std::vector<Face> leaf_faces;
     };
 
-    // Recursive part of build()
-    unsigned int build_recurse(Node* node, unsigned int max_handles,
-                               unsigned int depth);
-
-    // Recursive part of nearest()
-    void nearest_recurse(Node* node, const Point& point,
-                         NearestNeighbor& data) const;
+    // subtree built by one thread
+    struct Task
+    {
+        std::vector<IndexType> work; // triangle lists of its nodes
+        unsigned int depth;          // remaining depth
+        Subtree tree;
+    };
 
-    Node* root_;
+    // build the subtree of the triangles work[begin, end) into tree. If
+    // tasks is given, subtrees with few triangles are deferred to it and
+    // represented by a placeholder node.
+    void build_recurse(std::vector<IndexType>& work, size_t begin, size_t end,
+                       unsigned int max_faces, unsigned int depth,
+                       Subtree& tree, std::vector<Task>* tasks) const;
+
+    // bounding box of the triangles work[begin, end)
+    BoundingBox bounding_box(const std::vector<IndexType>& work, size_t begin,
+                             size_t end) const;
+
+    // append the triangles work[begin, end) on the left and then those on
+    // the right of the splitting plane to work, return where the right ones
+    // start
+    size_t partition(std::vector<IndexType>& work, size_t begin, size_t end,
+                     int axis, Scalar split) const;
+
+    // call visit(i, dist, b1, b2) for the leaf triangles i that may be
+    // closer to p than bound, which visit may decrease. b1 and b2 are the
+    // coordinates of the nearest point as in leaf_point().
+    template <class Visit>
+    void traverse(const Point& p, Scalar& bound, Visit visit) const;
+
+    // point v0 + b1 * (v1 - v0) + b2 * (v2 - v0) of leaf triangle i
+    Point leaf_point(IndexType i, Scalar b1, Scalar b2) const;
+
+    // update data if a triangle is closer than data.dist, storing the leaf
+    // triangle in best
+    void search(const Point& p, NearestNeighbor& data, IndexType& best) const;
+
+    // replace the placeholders of top by the subtrees of tasks, storing the
+    // tree in depth-first order
+    void assemble(const Subtree& top, const std::vector<Task>& tasks);
+
+    std::vector<Node> nodes_;
+    // corner coordinates of the leaf triangles, see dist_point_triangles()
+    std::vector<Scalar> leaf_coords_[9];
+    std::vector<Face> leaf_faces_; // face handle per leaf triangle
+
+    // only used during the build
+    std::vector<Point> points_;      // vertex positions
+    std::vector<IndexType> corners_; // three vertices per triangle
+    std::vector<Face> faces_;        // face handle per triangle
 };
 
 } // namespace pmp
@@ -16,14 +16,41 @@ static const char* matcap_vshader =
 R"glsl(
 layout (location=0) in vec4 v_position;
 layout (location=1) in vec3 v_normal;
+layout (location=4) in mat4 v_model;
 out vec3 v2f_normal;
+out vec3 v2f_view;
 uniform mat4 modelview_projection_matrix;
+uniform mat4 modelview_matrix;
 uniform mat3 normal_matrix;
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform bool use_octahedral_normals;
+
+// model transform per instance, see SurfaceMeshGL::set_instances()
+uniform bool use_instances;
+
+// decode a normal from the octahedral encoding in the xy-components
+vec3 octahedral_normal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
-    v2f_normal = normalize(normal_matrix * v_normal);
-    gl_Position = modelview_projection_matrix * v_position;
+    vec3 normal = use_octahedral_normals ? octahedral_normal(v_normal.xy) : v_normal;
+    vec4 vertex = vec4(position_offset + position_scale * v_position.xyz, 1.0);
+    if (use_instances)
+    {
+        vertex = v_model * vertex;
+        normal = mat3(v_model) * normal;
+    }
+    v2f_normal = normalize(normal_matrix * normal);
+    v2f_view = -(modelview_matrix * vertex).xyz;
+    gl_Position = modelview_projection_matrix * vertex;
 }
 )glsl";
 
@@ -38,8 +65,10 @@ R"glsl(
 precision mediump float;
 
 in vec3 v2f_normal;
+in vec3 v2f_view;
 uniform sampler2D matcap;
 uniform float  alpha;
+uniform bool   use_flat_shading;
 out vec4 f_color;
 
 vec2 uv;
@@ -47,15 +76,20 @@ vec4 rgba;
 
 void main()
 {
+    // the face normal from screen-space derivatives faces the viewer
+    vec3 N = use_flat_shading ? cross(dFdx(v2f_view), dFdy(v2f_view))
+                              : v2f_normal;
+
     if (gl_FrontFacing)
     {
-        uv = normalize(v2f_normal).xy * 0.49 + 0.5;
+        uv = normalize(N).xy * 0.49 + 0.5;
         rgba = texture(matcap, uv);
     }
     else
     {
         // invert normal, damp color
-        uv = normalize(-v2f_normal).xy * 0.49 + 0.5;
+        if (!use_flat_shading) N = -N;
+        uv = normalize(N).xy * 0.49 + 0.5;
         rgba = texture(matcap, uv);
         rgba.rgb *= 0.5;
     }
@@ -3,16 +3,37 @@
 
 #include "pmp/visualization/MeshViewer.h"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <sstream>
 
 #include <imgui.h>
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#endif
+
+#include "pmp/SurfaceMeshIO.h"
+
 namespace pmp {
 
 MeshViewer::MeshViewer(const char* title, int width, int height, bool showgui)
-    : TrackballViewer(title, width, height, showgui)
+    : TrackballViewer(title, width, height, showgui),
+      loaded_bytes_(0),
+      loading_size_(0),
+      cancel_loading_(false),
+      show_imgui_after_loading_(showgui),
+      view_only_(false),
+      stream_file_(nullptr),
+      stream_failed_(false),
+#ifdef __EMSCRIPTEN__
+      stream_fetch_(nullptr),
+#endif
+      bvh_generation_(0)
 {
     // setup draw modes
     clear_draw_modes();
@@ -20,10 +41,18 @@ MeshViewer::MeshViewer(const char* title, int width, int height, bool showgui)
     add_draw_mode("Hidden Line");
     add_draw_mode("Smooth Shading");
     add_draw_mode("Texture");
+#ifndef __EMSCRIPTEN__
+    add_draw_mode("Subdivision Surface");
+#endif
     set_draw_mode("Smooth Shading");
 
     crease_angle_ = 180.0;
 
+#ifdef __EMSCRIPTEN__
+    // save memory and bandwidth in the browser
+    mesh_.set_compress_attributes(true);
+#endif
+
     // add help items
     add_help_item("Backspace", "Reload mesh", 3);
 #ifndef __EMSCRIPTEN__
@@ -31,14 +60,33 @@ MeshViewer::MeshViewer(const char* title, int width, int height, bool showgui)
 #endif
 }
 
-MeshViewer::~MeshViewer() = default;
+MeshViewer::~MeshViewer()
+{
+    // the reading thread uses our members
+    cancel_loading_ = true;
+    if (loading_.valid())
+        loading_.wait();
+
+    if (stream_file_)
+        fclose(stream_file_);
+#ifdef __EMSCRIPTEN__
+    if (stream_fetch_)
+        emscripten_fetch_close(stream_fetch_);
+#endif
+}
 
 void MeshViewer::load_mesh(const char* filename)
 {
     // load mesh
+    IndexedFaces faces;
+    mesh_.set_deferred_faces(IndexedFaces());
     try
     {
-        mesh_.read(filename);
+        SurfaceMeshIO io(filename, IOFlags());
+        if (view_only_)
+            io.read(mesh_, faces);
+        else
+            io.read(mesh_);
     }
     catch (const IOException& e)
     {
@@ -46,22 +94,307 @@ void MeshViewer::load_mesh(const char* filename)
         return;
     }
 
+    mesh_.set_deferred_faces(std::move(faces));
+    mesh_loaded(filename);
+}
+
+void MeshViewer::load_mesh_async(const char* filename)
+{
+    // show streaming meshes while they are read
+    std::string ext = filename;
+    ext = ext.substr(ext.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+    if (ext == "sma" || ext == "smb")
+    {
+        load_mesh_streaming(filename);
+        return;
+    }
+
+#if defined(__EMSCRIPTEN__)
+    load_mesh(filename);
+#else
+    // cancel loading another mesh
+    if (loading_.valid())
+    {
+        cancel_loading_ = true;
+        loading_.wait();
+        loading_ = std::future<std::pair<SurfaceMesh, IndexedFaces>>();
+        show_imgui(show_imgui_after_loading_);
+    }
+
+    IOFlags flags;
+    flags.progress = [this](size_t bytes, size_t total) {
+        loaded_bytes_ = bytes;
+        loading_size_ = total;
+        return !cancel_loading_;
+    };
+    loaded_bytes_ = 0;
+    loading_size_ = 0;
+    cancel_loading_ = false;
+    loading_filename_ = filename;
+    const std::string name(filename);
+    const bool view_only = view_only_;
+    loading_ = std::async(std::launch::async, [name, flags, view_only]() {
+        std::pair<SurfaceMesh, IndexedFaces> result;
+        SurfaceMeshIO io(name, flags);
+        if (view_only)
+            io.read(result.first, result.second);
+        else
+            io.read(result.first);
+        return result;
+    });
+
+    // show the progress
+    show_imgui_after_loading_ = show_imgui();
+    show_imgui(true);
+#endif
+}
+
+void MeshViewer::load_mesh_streaming(const char* filename)
+{
+    // cancel loading another mesh
+    if (loading_.valid())
+    {
+        cancel_loading_ = true;
+        loading_.wait();
+        loading_ = std::future<std::pair<SurfaceMesh, IndexedFaces>>();
+        show_imgui(show_imgui_after_loading_);
+    }
+    if (stream_)
+        finish_stream();
+
+    stream_.reset(new StreamingMeshReader);
+    stream_failed_ = false;
+    loaded_bytes_ = 0;
+    loading_size_ = 0;
+    cancel_loading_ = false;
+    loading_filename_ = filename;
+
+#ifdef __EMSCRIPTEN__
+    // append the downloaded chunks as they arrive
+    emscripten_fetch_attr_t attr;
+    emscripten_fetch_attr_init(&attr);
+    strcpy(attr.requestMethod, "GET");
+    attr.attributes = EMSCRIPTEN_FETCH_STREAM_DATA;
+    attr.userData = this;
+    attr.onprogress = [](emscripten_fetch_t* fetch) {
+        auto viewer = static_cast<MeshViewer*>(fetch->userData);
+        viewer->stream_->append(fetch->data, size_t(fetch->numBytes));
+        viewer->loaded_bytes_ = size_t(fetch->dataOffset + fetch->numBytes);
+        viewer->loading_size_ = size_t(fetch->totalBytes);
+    };
+    attr.onsuccess = [](emscripten_fetch_t* fetch) {
+        auto viewer = static_cast<MeshViewer*>(fetch->userData);
+        viewer->stream_->close_input();
+        viewer->stream_fetch_ = nullptr;
+        emscripten_fetch_close(fetch);
+    };
+    attr.onerror = [](emscripten_fetch_t* fetch) {
+        auto viewer = static_cast<MeshViewer*>(fetch->userData);
+        std::cerr << "Error: Failed to download " << fetch->url << " ("
+                  << fetch->status << ")" << std::endl;
+        viewer->stream_failed_ = true;
+        viewer->stream_fetch_ = nullptr;
+        emscripten_fetch_close(fetch);
+    };
+    stream_fetch_ = emscripten_fetch(&attr, filename);
+#else
+    stream_file_ = fopen(filename, "rb");
+    if (!stream_file_)
+    {
+        std::cerr << "Error: Failed to open file: " << filename << std::endl;
+        stream_.reset();
+        return;
+    }
+    fseek(stream_file_, 0, SEEK_END);
+    loading_size_ = size_t(ftell(stream_file_));
+    fseek(stream_file_, 0, SEEK_SET);
+#endif
+
+    // start with an empty mesh, whose faces are appended as they arrive
+    static_cast<SurfaceMesh&>(mesh_) = SurfaceMesh();
+    mesh_.set_deferred_faces(IndexedFaces());
+    mesh_.set_crease_angle(crease_angle_);
+    stream_bounds_ = BoundingBox();
+    bvh_.reset();
+
+    // show the progress
+    show_imgui_after_loading_ = show_imgui();
+    show_imgui(true);
+}
+
+void MeshViewer::read_stream()
+{
+    using Event = StreamingMeshReader::Event;
+    using Clock = std::chrono::steady_clock;
+
+    // parse for a part of the frame time, reading the file as needed
+    const auto deadline = Clock::now() + std::chrono::milliseconds(10);
+    std::vector<char> chunk;
+    IndexedFaces faces;
+    bool done = cancel_loading_ || stream_failed_;
+    try
+    {
+        while (!done && Clock::now() < deadline)
+        {
+            const Event event = stream_->next();
+            if (event == Event::Vertex)
+            {
+                const Point& p = stream_->position(stream_->vertex());
+                mesh_.add_vertex(p);
+                stream_bounds_ += p;
+            }
+            else if (event == Event::Face)
+            {
+                const auto& face = stream_->face();
+                faces.indices.insert(faces.indices.end(), face.begin(),
+                                     face.end());
+                faces.face_sizes.push_back(IndexType(face.size()));
+            }
+            else if (event == Event::End)
+                done = true;
+            else if (event == Event::Pending)
+            {
+                // wait for the next chunk of the download
+                if (!stream_file_)
+                    break;
+
+                chunk.resize(1 << 20);
+                const size_t n = fread(chunk.data(), 1, chunk.size(),
+                                       stream_file_);
+                stream_->append(chunk.data(), n);
+                loaded_bytes_ += n;
+                if (n < chunk.size())
+                {
+                    if (ferror(stream_file_))
+                        throw IOException("Failed to read streaming mesh");
+                    fclose(stream_file_);
+                    stream_file_ = nullptr;
+                    stream_->close_input();
+                }
+            }
+        }
+    }
+    catch (const IOException& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        done = true;
+    }
+
+    // show the new faces, and the whole mesh once the first ones arrived
+    if (!faces.empty())
+    {
+        const auto& sizes = faces.face_sizes;
+        if (std::all_of(sizes.begin(), sizes.end(),
+                        [](IndexType n) { return n == 3; }))
+            faces.face_sizes.clear();
+
+        const bool first = !mesh_.has_deferred_faces();
+        mesh_.append_deferred_faces(faces);
+        if (first)
+            set_scene((vec3)stream_bounds_.center(),
+                      0.5 * stream_bounds_.size());
+        center_ = (vec3)stream_bounds_.center();
+        radius_ = 0.5f * stream_bounds_.size();
+    }
+
+    if (done)
+        finish_stream();
+    request_redraw();
+}
+
+void MeshViewer::finish_stream()
+{
+    if (stream_file_)
+    {
+        fclose(stream_file_);
+        stream_file_ = nullptr;
+    }
+#ifdef __EMSCRIPTEN__
+    if (stream_fetch_)
+    {
+        emscripten_fetch_close(stream_fetch_);
+        stream_fetch_ = nullptr;
+    }
+#endif
+    stream_.reset();
+    show_imgui(show_imgui_after_loading_);
+
+    // show also a mesh without faces
+    if (!mesh_.has_deferred_faces())
+    {
+        mesh_loaded(loading_filename_.c_str());
+        return;
+    }
+    if (!view_only_)
+        mesh_.build_connectivity();
+    finish_loading(loading_filename_.c_str());
+}
+
+void MeshViewer::do_processing()
+{
+    if (stream_)
+        read_stream();
+
+    if (!loading_.valid())
+        return;
+
+    // keep showing the progress until the mesh is loaded
+    request_redraw();
+    if (loading_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    show_imgui(show_imgui_after_loading_);
+    try
+    {
+        auto loaded = loading_.get();
+        static_cast<SurfaceMesh&>(mesh_) = std::move(loaded.first);
+        mesh_.set_deferred_faces(std::move(loaded.second));
+    }
+    catch (const CancelledException&)
+    {
+        return;
+    }
+    catch (const IOException& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return;
+    }
+    mesh_loaded(loading_filename_.c_str());
+}
+
+void MeshViewer::mesh_loaded(const char* filename)
+{
     // update scene center and bounds
-    BoundingBox bb = mesh_.bounds();
+    BoundingBox bb = scene_bounds();
     set_scene((vec3)bb.center(), 0.5 * bb.size());
 
+    finish_loading(filename);
+}
+
+void MeshViewer::finish_loading(const char* filename)
+{
+    // record modifications for partial buffer updates
+    mesh_.set_change_tracking(true);
+
+    // the picking hierarchy belongs to the previous mesh
+    bvh_.reset();
+
     // compute face & vertex normals, update face indices
     update_mesh();
 
     // set draw mode
-    if (mesh_.n_faces() == 0)
+    const size_t n_faces = mesh_.has_deferred_faces()
+                               ? mesh_.deferred_faces().size()
+                               : mesh_.n_faces();
+    if (n_faces == 0)
     {
         set_draw_mode("Points");
     }
 
     // print mesh statistic
     std::cout << "Loaded " << filename << ": " << mesh_.n_vertices()
-              << " vertices, " << mesh_.n_faces() << " faces\n";
+              << " vertices, " << n_faces << " faces\n";
 
     filename_ = filename;
     mesh_.set_crease_angle(crease_angle_);
@@ -104,25 +437,82 @@ void MeshViewer::load_texture(const char* filename, GLint format,
     mesh_.set_shininess(1.0);
 }
 
+SurfaceMeshGL& MeshViewer::add_instanced_mesh(const SurfaceMesh& mesh,
+                                              std::vector<mat4> transforms)
+{
+    std::unique_ptr<SurfaceMeshGL> instanced(new SurfaceMeshGL);
+    static_cast<SurfaceMesh&>(*instanced) = mesh;
+    instanced->set_crease_angle(crease_angle_);
+    instanced->set_instances(std::move(transforms));
+    instanced_meshes_.push_back(std::move(instanced));
+
+    BoundingBox bb = scene_bounds();
+    set_scene((vec3)bb.center(), 0.5 * bb.size());
+    return *instanced_meshes_.back();
+}
+
+BoundingBox MeshViewer::scene_bounds()
+{
+    BoundingBox bb = mesh_.bounds();
+
+    // transform the corners of the bounds of each instanced mesh
+    for (const auto& mesh : instanced_meshes_)
+    {
+        BoundingBox mesh_bb = mesh->bounds();
+        if (mesh_bb.is_empty())
+            continue;
+        const Point corners[2] = {mesh_bb.min(), mesh_bb.max()};
+        for (const auto& t : mesh->instances())
+            for (int i = 0; i < 8; ++i)
+                bb += affine_transform(
+                    t, Point(corners[i & 1][0], corners[(i >> 1) & 1][1],
+                             corners[i >> 2][2]));
+    }
+    return bb;
+}
+
 void MeshViewer::update_mesh()
 {
     // update scene center and radius, but don't update camera view
-    BoundingBox bb = mesh_.bounds();
+    BoundingBox bb = scene_bounds();
     center_ = (vec3)bb.center();
     radius_ = 0.5f * bb.size();
 
     // re-compute face and vertex normals
+    begin_timing("Buffer update");
     mesh_.update_opengl_buffers();
+    end_timing();
+
+    request_redraw();
 }
 
 void MeshViewer::process_imgui()
 {
+    if (is_loading())
+    {
+        ImGui::Text("Loading %s", loading_filename_.c_str());
+        const size_t size = loading_size_;
+        const float fraction = size ? float(loaded_bytes_) / size : 0.0f;
+        ImGui::ProgressBar(fraction, ImVec2(200, 0));
+        if (ImGui::Button("Cancel"))
+            cancel_loading_ = true;
+        ImGui::Spacing();
+    }
+
     if (ImGui::CollapsingHeader("Mesh Info", ImGuiTreeNodeFlags_DefaultOpen))
     {
         // output mesh statistics
         ImGui::BulletText("%d vertices", (int)mesh_.n_vertices());
-        ImGui::BulletText("%d edges", (int)mesh_.n_edges());
-        ImGui::BulletText("%d faces", (int)mesh_.n_faces());
+        if (mesh_.has_deferred_faces())
+        {
+            // edges are counted once the connectivity is built
+            ImGui::BulletText("%d faces", (int)mesh_.deferred_faces().size());
+        }
+        else
+        {
+            ImGui::BulletText("%d edges", (int)mesh_.n_edges());
+            ImGui::BulletText("%d faces", (int)mesh_.n_faces());
+        }
 
         // control crease angle
         ImGui::PushItemWidth(100);
@@ -132,6 +522,8 @@ void MeshViewer::process_imgui()
         if (crease_angle_ != mesh_.crease_angle())
         {
             mesh_.set_crease_angle(crease_angle_);
+            for (auto& mesh : instanced_meshes_)
+                mesh->set_crease_angle(crease_angle_);
         }
     }
 }
@@ -140,6 +532,21 @@ void MeshViewer::draw(const std::string& drawMode)
 {
     // draw mesh
     mesh_.draw(projection_matrix_, modelview_matrix_, drawMode);
+
+    size_t n_triangles = mesh_.n_faces();
+    size_t n_drawn = mesh_.n_drawn_triangles();
+    size_t uploaded = mesh_.uploaded_bytes();
+    for (auto& mesh : instanced_meshes_)
+    {
+        mesh->draw(projection_matrix_, modelview_matrix_, drawMode);
+        n_triangles += mesh->n_faces() * mesh->instances().size();
+        n_drawn += mesh->n_drawn_triangles();
+        uploaded += mesh->uploaded_bytes();
+    }
+
+    set_performance_counter("Triangles", n_triangles);
+    set_performance_counter("Drawn triangles", n_drawn);
+    set_performance_counter("Uploaded KB", uploaded / 1024);
 }
 
 void MeshViewer::keyboard(int key, int scancode, int action, int mods)
@@ -157,6 +564,7 @@ void MeshViewer::keyboard(int key, int scancode, int action, int mods)
 
         case GLFW_KEY_W: // write mesh
         {
+            mesh_.build_connectivity();
             mesh_.write("output.off");
             break;
         }
@@ -169,6 +577,73 @@ void MeshViewer::keyboard(int key, int scancode, int action, int mods)
     }
 }
 
+const TriangleBVH* MeshViewer::picking_bvh()
+{
+    // without change tracking, we could not tell when to update it
+    if (!mesh_.change_tracking())
+    {
+        bvh_.reset();
+        return nullptr;
+    }
+
+    // the marker detects a replaced mesh, since copies start with fresh
+    // stamps
+    const uint64_t g = bvh_generation_;
+    const ObjectProperty<uint64_t> marker =
+        mesh_.get_object_property<uint64_t>("viewer:bvh_generation");
+    const bool same_mesh = bvh_ && marker && marker.generation() &&
+                           marker[0] == g;
+
+    // refit after vertices moved, rebuild after the connectivity changed
+    const VertexProperty<Point> points =
+        mesh_.get_vertex_property<Point>("v:point");
+    if (same_mesh && mesh_.topology_generation() <= g)
+    {
+        if (points.generation() <= g)
+            return bvh_.get();
+        bvh_->refit(mesh_);
+    }
+    else if (mesh_.n_faces() && mesh_.is_triangle_mesh())
+    {
+        bvh_.reset(new TriangleBVH(mesh_));
+    }
+    else
+    {
+        bvh_.reset();
+        return nullptr;
+    }
+
+    bvh_generation_ = mesh_.new_generation();
+    auto new_marker = mesh_.object_property<uint64_t>("viewer:bvh_generation");
+    new_marker[0] = bvh_generation_;
+    return bvh_.get();
+}
+
+TriangleBVH::RayHit MeshViewer::pick_face(int x, int y)
+{
+    TriangleBVH::RayHit hit;
+    hit.t = std::numeric_limits<Scalar>::max();
+    if (auto bvh = picking_bvh())
+    {
+        vec3 origin, direction;
+        pick_ray(x, y, origin, direction);
+        hit = bvh->intersect(TriangleBVH::Ray(origin, direction, 0, 1));
+    }
+    return hit;
+}
+
+bool MeshViewer::pick(int x, int y, vec3& result)
+{
+    if (!picking_bvh())
+        return TrackballViewer::pick(x, y, result);
+
+    const auto hit = pick_face(x, y);
+    if (!hit.face.is_valid())
+        return false;
+    result = vec3(hit.point);
+    return true;
+}
+
 Vertex MeshViewer::pick_vertex(int x, int y)
 {
     Vertex vmin;
@@ -176,7 +651,24 @@ Vertex MeshViewer::pick_vertex(int x, int y)
     vec3 p;
     Scalar d, dmin(std::numeric_limits<Scalar>::max());
 
-    if (TrackballViewer::pick(x, y, p))
+    // only the vertices of the hit triangle are candidates
+    if (picking_bvh())
+    {
+        const auto hit = pick_face(x, y);
+        if (hit.face.is_valid())
+        {
+            for (auto v : mesh_.vertices(hit.face))
+            {
+                d = distance(mesh_.position(v), hit.point);
+                if (d < dmin)
+                {
+                    dmin = d;
+                    vmin = v;
+                }
+            }
+        }
+    }
+    else if (TrackballViewer::pick(x, y, p))
     {
         Point picked_position(p);
         for (auto v : mesh_.vertices())
@@ -3,8 +3,20 @@
 
 #pragma once
 
+#include <atomic>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "pmp/visualization/TrackballViewer.h"
 #include "pmp/visualization/SurfaceMeshGL.h"
+#include "pmp/algorithms/TriangleBVH.h"
+#include "pmp/StreamingMesh.h"
+
+#ifdef __EMSCRIPTEN__
+struct emscripten_fetch_t;
+#endif
 
 namespace pmp {
 
@@ -22,6 +34,32 @@ public:
     //! load a mesh from file \p filename
     virtual void load_mesh(const char* filename);
 
+    //! \brief Load a mesh from file \p filename in a background thread.
+    //! \details Shows the progress and replaces the current mesh when
+    //! reading is complete. Reads synchronously if threads are not
+    //! available, e.g., with Emscripten.
+    //!
+    //! Streaming meshes (.sma, .smb), see StreamingMeshReader, are instead
+    //! shown while they are read: each frame parses the records for a few
+    //! milliseconds and appends the new faces to the buffers, see
+    //! SurfaceMeshGL::append_deferred_faces(). With Emscripten, \p filename
+    //! is a URL that is downloaded with the Fetch API and parsed chunk by
+    //! chunk as it arrives, such that the first part of the mesh appears
+    //! long before the download completes. The halfedge connectivity is
+    //! built at the end unless set_view_only() is set.
+    void load_mesh_async(const char* filename);
+
+    //! whether a mesh is being loaded by load_mesh_async()
+    bool is_loading() const { return loading_.valid() || stream_; }
+
+    //! \brief Read meshes only for viewing.
+    //! \details Meshes are rendered from their indexed faces and the
+    //! halfedge connectivity is built only when needed, e.g., for writing.
+    //! Opens large files much faster, but derived viewers processing the
+    //! mesh have to call SurfaceMeshGL::build_connectivity() first. Applies
+    //! to meshes loaded afterwards. Default is \c false.
+    void set_view_only(bool view_only) { view_only_ = view_only; }
+
     //! load a matcap texture from file \p filename
     void load_matcap(const char* filename);
 
@@ -31,6 +69,19 @@ public:
                       GLint mag_filter = GL_LINEAR,
                       GLint wrap = GL_CLAMP_TO_EDGE);
 
+    //! \brief Add \p mesh to the scene, drawn at each of the model
+    //! \p transforms.
+    //! \details The mesh is stored and uploaded once and all its instances
+    //! are rendered with instanced draw calls after the main mesh, see
+    //! SurfaceMeshGL::set_instances(). Instanced meshes are neither picked
+    //! nor processed. Adjusts the scene to show all meshes.
+    //! \return the added mesh, e.g., for setting its material
+    SurfaceMeshGL& add_instanced_mesh(const SurfaceMesh& mesh,
+                                      std::vector<mat4> transforms);
+
+    //! remove the meshes added by add_instanced_mesh()
+    void clear_instanced_meshes() { instanced_meshes_.clear(); }
+
     //! update mesh normals and all buffers for OpenGL rendering.  call this
     //! function whenever you change either the vertex positions or the
     //! triangulation of the mesh
@@ -45,13 +96,80 @@ public:
     //! this function handles keyboard events
     virtual void keyboard(int key, int code, int action, int mod) override;
 
-    //! get vertex closest to 3D position Distributed under the mouse cursor
+    //! \brief Get the vertex closest to the 3D position under the mouse
+    //! cursor.
+    //! \details For triangle meshes, this is the vertex of the face hit by
+    //! the ray through the cursor that is closest to the hit point. The ray
+    //! is intersected with a bounding volume hierarchy, which is built on
+    //! the first pick and refit after the vertices moved. Other meshes use
+    //! the depth buffer and search all vertices.
     Vertex pick_vertex(int x, int y);
 
+    //! \brief Get 3D position of 2D position (x,y)
+    //! \details Intersects the ray through (x,y) with triangle meshes, which
+    //! also works with WebGL. Reads the depth buffer otherwise.
+    bool pick(int x, int y, vec3& result) override;
+    using TrackballViewer::pick;
+
 protected:
+    //! finish loading the mesh in the background
+    virtual void do_processing() override;
+
+    //! update the scene for the mesh just read from \p filename
+    void mesh_loaded(const char* filename);
+
     SurfaceMeshGL mesh_;   //!< the mesh
     std::string filename_; //!< the current file
     float crease_angle_;
+
+private:
+    // mesh being loaded in the background, and its deferred faces if
+    // view_only_
+    std::future<std::pair<SurfaceMesh, IndexedFaces>> loading_;
+    std::string loading_filename_;
+    std::atomic<size_t> loaded_bytes_;
+    std::atomic<size_t> loading_size_;
+    std::atomic<bool> cancel_loading_;
+    bool show_imgui_after_loading_;
+    bool view_only_;
+
+    // update the buffers for the mesh read from filename, keeping the view
+    void finish_loading(const char* filename);
+
+    // streaming mesh shown while it is read from a file, or downloaded
+    // with Emscripten, see load_mesh_async()
+    void load_mesh_streaming(const char* filename);
+
+    // parse the records read so far for a few milliseconds and append the
+    // new faces to the mesh
+    void read_stream();
+
+    // stop reading the stream and finish the mesh read so far
+    void finish_stream();
+
+    std::unique_ptr<StreamingMeshReader> stream_;
+    FILE* stream_file_;
+    bool stream_failed_;
+    BoundingBox stream_bounds_;
+#ifdef __EMSCRIPTEN__
+    emscripten_fetch_t* stream_fetch_;
+#endif
+
+    // return the hierarchy of the triangles of mesh_ for picking, built or
+    // refit if the mesh changed. null if mesh_ is not a triangle mesh.
+    const TriangleBVH* picking_bvh();
+
+    // intersect the ray through (x,y) with the triangles of mesh_
+    TriangleBVH::RayHit pick_face(int x, int y);
+
+    std::unique_ptr<TriangleBVH> bvh_;
+    uint64_t bvh_generation_;
+
+    // bounds of the main mesh and all instances
+    BoundingBox scene_bounds();
+
+    // meshes drawn with instancing in addition to mesh_
+    std::vector<std::unique_ptr<SurfaceMeshGL>> instanced_meshes_;
 };
 
 } // namespace pmp
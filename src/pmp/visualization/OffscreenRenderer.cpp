@@ -0,0 +1,277 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/visualization/OffscreenRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <GLFW/glfw3.h>
+#include <stb_image_write.h>
+
+#include "pmp/Parallel.h"
+
+namespace pmp {
+
+namespace {
+
+// readbacks in flight, such that the GPU is a few views ahead of the copies
+const size_t n_readbacks = 3;
+
+// number of images encoded together
+const size_t image_batch = 32;
+
+} // namespace
+
+OffscreenRenderer::OffscreenRenderer(int width, int height, int n_samples)
+    : window_(nullptr),
+      width_(width),
+      height_(height),
+      background_(1, 1, 1),
+      next_readback_(0),
+      n_written_(0)
+{
+    if (!glfwInit())
+        throw IOException("Cannot initialize GLFW.");
+
+    // hidden window with a core profile OpenGL 3.2 context
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    window_ = glfwCreateWindow(1, 1, "OffscreenRenderer", nullptr, nullptr);
+    glfwDefaultWindowHints();
+    if (!window_)
+        throw IOException("Cannot create OpenGL context.");
+
+    glfwMakeContextCurrent(window_);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK)
+    {
+        glfwDestroyWindow(window_);
+        throw IOException("Cannot initialize GLEW.");
+    }
+    glGetError();
+
+    // multisampled color and depth buffers
+    GLint max_samples;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    n_samples = std::max(0, std::min(n_samples, int(max_samples)));
+    glGenRenderbuffers(1, &color_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, n_samples, GL_RGBA8,
+                                     width_, height_);
+    glGenRenderbuffers(1, &depth_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, n_samples,
+                                     GL_DEPTH_COMPONENT24, width_, height_);
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, color_buffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depth_buffer_);
+    const bool complete =
+        glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // single sampled color buffer to read from
+    glGenRenderbuffers(1, &resolve_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolve_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+    glGenFramebuffers(1, &resolve_framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolve_framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, resolve_buffer_);
+    if (!complete ||
+        glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        glfwDestroyWindow(window_);
+        throw IOException("Cannot create framebuffer.");
+    }
+
+    // pixel buffer objects for the asynchronous readback
+    readbacks_.resize(n_readbacks);
+    for (auto& r : readbacks_)
+    {
+        glGenBuffers(1, &r.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, 4 * width_ * height_, nullptr,
+                     GL_STREAM_READ);
+        r.fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // same state as TrackballViewer
+    glEnable(GL_DEPTH_TEST);
+    glFrontFace(GL_CCW);
+    glEnable(GL_MULTISAMPLE);
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    try
+    {
+        finish();
+    }
+    catch (const IOException& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+
+    glfwMakeContextCurrent(window_);
+    for (auto& r : readbacks_)
+        glDeleteBuffers(1, &r.buffer);
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteFramebuffers(1, &resolve_framebuffer_);
+    glDeleteRenderbuffers(1, &color_buffer_);
+    glDeleteRenderbuffers(1, &depth_buffer_);
+    glDeleteRenderbuffers(1, &resolve_buffer_);
+
+    // the library is terminated by the last Window, or at exit
+    glfwDestroyWindow(window_);
+}
+
+std::vector<OffscreenRenderer::View> OffscreenRenderer::default_views()
+{
+    const vec3 y(0, 1, 0);
+    return {{vec3(0, 0, 1), y, "front"},   {vec3(0, 0, -1), y, "back"},
+            {vec3(-1, 0, 0), y, "left"},   {vec3(1, 0, 0), y, "right"},
+            {vec3(0, 1, 0), vec3(0, 0, -1), "top"},
+            {vec3(1, 1, 1), y, "oblique"}};
+}
+
+void OffscreenRenderer::render(SurfaceMeshGL& mesh,
+                               const std::vector<View>& views,
+                               const std::string& basename,
+                               const std::string& draw_mode)
+{
+    glfwMakeContextCurrent(window_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width_, height_);
+    glClearColor(background_[0], background_[1], background_[2], 1.0);
+
+    // frame the bounding sphere as TrackballViewer::view_all()
+    const BoundingBox bb = mesh.bounds();
+    vec3 center(0, 0, 0);
+    float radius = 1;
+    if (!bb.is_empty())
+    {
+        center = (vec3)bb.center();
+        radius = std::max(0.5f * float(bb.size()), 1e-6f);
+    }
+    const float distance = 2.5f * radius;
+    const mat4 projection =
+        perspective_matrix(45.0f, float(width_) / float(height_),
+                           distance - radius, distance + radius);
+
+    for (const auto& view : views)
+    {
+        const vec3 eye = center + distance * normalize(view.direction);
+        const mat4 modelview = look_at_matrix(eye, center, view.up);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mesh.draw(projection, modelview, draw_mode);
+
+        read_back(basename + "-" + view.name + ".png");
+    }
+}
+
+void OffscreenRenderer::read_back(const std::string& filename)
+{
+    // resolve the samples
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_framebuffer_);
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    // the buffer still holds an image from n_readbacks views ago
+    Readback& r = readbacks_[next_readback_];
+    next_readback_ = (next_readback_ + 1) % readbacks_.size();
+    if (r.fence)
+        collect(r);
+
+    // copy into the buffer without waiting for the GPU
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolve_framebuffer_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    r.filename = filename;
+
+    if (images_.size() >= image_batch)
+        write_images();
+}
+
+void OffscreenRenderer::collect(Readback& r)
+{
+    glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+    glDeleteSync(r.fence);
+    r.fence = nullptr;
+
+    Image image;
+    image.filename = r.filename;
+    image.pixels.resize(3 * width_ * height_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+    auto rgba = (const unsigned char*)glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, 4 * width_ * height_, GL_MAP_READ_BIT);
+    if (rgba)
+    {
+        // drop the alpha channel
+        const int n_pixels = width_ * height_;
+        for (int i = 0; i < n_pixels; ++i)
+            std::memcpy(&image.pixels[3 * i], &rgba[4 * i], 3);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    images_.push_back(std::move(image));
+}
+
+void OffscreenRenderer::write_images()
+{
+    // OpenGL rows start at the bottom
+    stbi_flip_vertically_on_write(true);
+
+    std::vector<char> written(images_.size());
+    parallel_for(
+        0, int(images_.size()),
+        [&](int i) {
+            const Image& image = images_[i];
+            written[i] = stbi_write_png(image.filename.c_str(), width_,
+                                        height_, 3, image.pixels.data(),
+                                        3 * width_) != 0;
+        },
+        1);
+
+    std::string failed;
+    for (size_t i = 0; i < images_.size(); ++i)
+    {
+        if (written[i])
+            ++n_written_;
+        else if (failed.empty())
+            failed = images_[i].filename;
+    }
+    images_.clear();
+
+    if (!failed.empty())
+        throw IOException("Failed to write image " + failed);
+}
+
+void OffscreenRenderer::finish()
+{
+    glfwMakeContextCurrent(window_);
+
+    // collect in the order of rendering
+    for (size_t i = 0; i < readbacks_.size(); ++i)
+    {
+        Readback& r = readbacks_[(next_readback_ + i) % readbacks_.size()];
+        if (r.fence)
+            collect(r);
+    }
+    write_images();
+}
+
+} // namespace pmp
@@ -0,0 +1,120 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/visualization/GL.h"
+#include "pmp/visualization/SurfaceMeshGL.h"
+
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace pmp {
+
+//! \brief Renders meshes into image files without a visible window.
+//! \details Draws into a multisampled framebuffer object of a hidden
+//! window's OpenGL context, such that the number and size of the images do
+//! not depend on creating windows. The pixels are read back asynchronously
+//! into pixel buffer objects while the next views are drawn, and the images
+//! are written as PNG files in parallel batches. The meshes are drawn by
+//! SurfaceMeshGL with its shaders and keep their buffers in the context of
+//! the renderer. On Linux without a display, run the program on a virtual
+//! one, e.g., with `xvfb-run`.
+//!
+//! Example:
+//! \code
+//! OffscreenRenderer renderer(256, 256);
+//! SurfaceMeshGL mesh;
+//! for (const auto& file : files)
+//! {
+//!     read(mesh, file);
+//!     mesh.update_opengl_buffers();
+//!     renderer.render(mesh, OffscreenRenderer::default_views(), file);
+//! }
+//! renderer.finish();
+//! \endcode
+//! \ingroup visualization
+class OffscreenRenderer
+{
+public:
+    //! a camera looking at the center of the mesh
+    struct View
+    {
+        vec3 direction;   //!< from the center towards the camera
+        vec3 up;          //!< up direction of the image
+        std::string name; //!< suffix of the image file name
+    };
+
+    //! \brief Create the context and the framebuffer of \p width x \p height
+    //! pixels with \p n_samples samples per pixel.
+    //! \throw IOException if no OpenGL 3.2 context can be created.
+    OffscreenRenderer(int width, int height, int n_samples = 4);
+
+    //! finish() and destroy the context
+    ~OffscreenRenderer();
+
+    OffscreenRenderer(const OffscreenRenderer&) = delete;
+    OffscreenRenderer& operator=(const OffscreenRenderer&) = delete;
+
+    //! the front, back, left, right, top, and an oblique view
+    static std::vector<View> default_views();
+
+    //! set the background color, white by default
+    void set_background(const vec3& color) { background_ = color; }
+
+    //! \brief Render \p mesh from each of the \p views in \p draw_mode, see
+    //! SurfaceMeshGL::draw(), into the images `basename-name.png`.
+    //! \details The mesh is framed as by TrackballViewer::view_all(). The
+    //! images are written at the latest by finish().
+    void render(SurfaceMeshGL& mesh, const std::vector<View>& views,
+                const std::string& basename,
+                const std::string& draw_mode = "Smooth Shading");
+
+    //! wait for the pending readbacks and write all remaining images
+    void finish();
+
+    //! number of images written so far
+    size_t n_written() const { return n_written_; }
+
+private:
+    // a pixel buffer object receiving the image of one view
+    struct Readback
+    {
+        GLuint buffer;
+        GLsync fence;
+        std::string filename;
+    };
+
+    // an image read back but not yet written
+    struct Image
+    {
+        std::string filename;
+        std::vector<unsigned char> pixels;
+    };
+
+    // start reading the current image into the next pixel buffer object
+    void read_back(const std::string& filename);
+
+    // wait for a readback and keep its image for writing
+    void collect(Readback& readback);
+
+    // write the collected images in parallel
+    void write_images();
+
+    GLFWwindow* window_;
+    int width_, height_;
+    vec3 background_;
+
+    // multisampled framebuffer, and the one it is resolved to for readback
+    GLuint framebuffer_, color_buffer_, depth_buffer_;
+    GLuint resolve_framebuffer_, resolve_buffer_;
+
+    std::vector<Readback> readbacks_;
+    size_t next_readback_;
+    std::vector<Image> images_;
+    size_t n_written_;
+};
+
+} // namespace pmp
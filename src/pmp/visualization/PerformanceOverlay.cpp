@@ -0,0 +1,193 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/visualization/PerformanceOverlay.h"
+
+#include <imgui.h>
+
+namespace pmp {
+
+namespace {
+
+// weight of a new sample in the running averages
+const double smoothing = 0.05;
+
+// sections not used for this many frames are hidden
+const unsigned long max_unused_frames = 60;
+
+double milliseconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void average(double& avg, double sample)
+{
+    avg = avg < 0 ? sample : avg + smoothing * (sample - avg);
+}
+
+} // namespace
+
+PerformanceOverlay::PerformanceOverlay()
+    : gpu_timing_(false), frame_(0), frame_ms_(-1)
+{
+}
+
+PerformanceOverlay::~PerformanceOverlay()
+{
+    clear();
+}
+
+void PerformanceOverlay::clear()
+{
+    for (auto& s : sections_)
+        if (s.queries[0][0])
+            glDeleteQueries(2 * n_query_frames, &s.queries[0][0]);
+    sections_.clear();
+    stack_.clear();
+    counters_.clear();
+}
+
+void PerformanceOverlay::begin_frame()
+{
+    const auto now = Clock::now();
+    if (frame_)
+        average(frame_ms_, milliseconds(now - frame_start_));
+    frame_start_ = now;
+    ++frame_;
+
+#ifndef __EMSCRIPTEN__ // WebGL has no timestamp queries
+    gpu_timing_ = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+#endif
+}
+
+void PerformanceOverlay::begin_section(const std::string& name)
+{
+    size_t i = 0;
+    while (i < sections_.size() && sections_[i].name != name)
+        ++i;
+    if (i == sections_.size())
+    {
+        Section s;
+        s.name = name;
+        s.cpu_ms = s.gpu_ms = -1;
+        for (int j = 0; j < n_query_frames; ++j)
+        {
+            s.queries[j][0] = s.queries[j][1] = 0;
+            s.pending[j] = false;
+        }
+        if (gpu_timing_)
+            glGenQueries(2 * n_query_frames, &s.queries[0][0]);
+        sections_.push_back(s);
+    }
+
+    Section& s = sections_[i];
+    s.depth = int(stack_.size());
+    s.frame = frame_;
+    s.timed = false;
+    stack_.push_back(i);
+
+    // skip the GPU timing if the results of this slot are still pending
+    if (gpu_timing_ && s.queries[0][0])
+    {
+        collect_queries(s);
+        const int slot = frame_ % n_query_frames;
+        if (!s.pending[slot])
+        {
+            glQueryCounter(s.queries[slot][0], GL_TIMESTAMP);
+            s.timed = true;
+        }
+    }
+
+    s.start = Clock::now();
+}
+
+void PerformanceOverlay::end_section()
+{
+    if (stack_.empty())
+        return;
+    Section& s = sections_[stack_.back()];
+    stack_.pop_back();
+
+    average(s.cpu_ms, milliseconds(Clock::now() - s.start));
+    if (s.timed)
+    {
+        const int slot = frame_ % n_query_frames;
+        glQueryCounter(s.queries[slot][1], GL_TIMESTAMP);
+        s.pending[slot] = true;
+    }
+}
+
+void PerformanceOverlay::collect_queries(Section& s)
+{
+    for (int j = 0; j < n_query_frames; ++j)
+    {
+        if (!s.pending[j])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(s.queries[j][1], GL_QUERY_RESULT_AVAILABLE,
+                           &available);
+        if (!available)
+            continue;
+
+        GLuint64 begin, end;
+        glGetQueryObjectui64v(s.queries[j][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(s.queries[j][1], GL_QUERY_RESULT, &end);
+        average(s.gpu_ms, 1e-6 * double(end - begin));
+        s.pending[j] = false;
+    }
+}
+
+void PerformanceOverlay::set_counter(const std::string& name, size_t value)
+{
+    for (auto& c : counters_)
+    {
+        if (c.first == name)
+        {
+            c.second = value;
+            return;
+        }
+    }
+    counters_.emplace_back(name, value);
+}
+
+void PerformanceOverlay::draw_imgui()
+{
+    const ImGuiIO& io = ImGui::GetIO();
+    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10, 10),
+                            ImGuiCond_Always, ImVec2(1, 0));
+    ImGui::Begin("Performance", nullptr,
+                 ImGuiWindowFlags_NoTitleBar |
+                     ImGuiWindowFlags_AlwaysAutoResize |
+                     ImGuiWindowFlags_NoFocusOnAppearing |
+                     ImGuiWindowFlags_NoInputs);
+
+    if (frame_ms_ > 0)
+        ImGui::Text("Frame: %.2f ms (%.0f fps)", frame_ms_, 1000 / frame_ms_);
+
+    ImGui::Columns(3, "sections", false);
+    for (const auto& s : sections_)
+    {
+        if (s.frame + max_unused_frames < frame_)
+            continue;
+        ImGui::Text("%*s%s", 2 * s.depth, "", s.name.c_str());
+        ImGui::NextColumn();
+        ImGui::Text("CPU %.2f ms", s.cpu_ms);
+        ImGui::NextColumn();
+        if (s.gpu_ms >= 0)
+            ImGui::Text("GPU %.2f ms", s.gpu_ms);
+        else
+            ImGui::TextDisabled("GPU n/a");
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    if (!counters_.empty())
+        ImGui::Separator();
+    for (const auto& c : counters_)
+        ImGui::Text("%s: %lu", c.first.c_str(), (unsigned long)c.second);
+
+    ImGui::End();
+}
+
+} // namespace pmp
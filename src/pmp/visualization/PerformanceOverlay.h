@@ -0,0 +1,83 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/visualization/GL.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pmp {
+
+//! \brief Frame time statistics shown by Window on top of the scene.
+//! \details Measures the CPU time between frames and the CPU and GPU time
+//! of named sections of a frame, and shows them along with counters such as
+//! uploaded bytes or drawn triangles. Times are averaged over recent frames.
+//! GPU times are measured with timestamp queries whose results are read a
+//! few frames later, so measuring does not stall the pipeline. They are not
+//! available with WebGL.
+//! \ingroup visualization
+class PerformanceOverlay
+{
+public:
+    //! constructor
+    PerformanceOverlay();
+
+    //! destructor
+    ~PerformanceOverlay();
+
+    //! delete the GPU queries, requires a current OpenGL context
+    void clear();
+
+    //! start a new frame
+    void begin_frame();
+
+    //! \brief Start the timed section \p name.
+    //! \details Sections may be nested and have to be closed by
+    //! end_section() within the same frame.
+    void begin_section(const std::string& name);
+
+    //! end the innermost timed section
+    void end_section();
+
+    //! set the counter \p name shown along with the timings
+    void set_counter(const std::string& name, size_t value);
+
+    //! draw the statistics in an ImGUI window
+    void draw_imgui();
+
+private:
+    // ring of timestamp queries, one pair per recent frame
+    static const int n_query_frames = 4;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Section
+    {
+        std::string name;
+        int depth;                  // nesting depth
+        Clock::time_point start;    // CPU time at the start
+        double cpu_ms;              // average CPU time
+        double gpu_ms;              // average GPU time, negative if unknown
+        GLuint queries[n_query_frames][2];
+        bool pending[n_query_frames];
+        bool timed;                 // timestamps issued for this frame
+        unsigned long frame;        // last frame the section was used in
+    };
+
+    // read the available query results of section s
+    void collect_queries(Section& s);
+
+    bool gpu_timing_; // timestamp queries are supported
+    unsigned long frame_;
+    Clock::time_point frame_start_;
+    double frame_ms_;
+    std::vector<Section> sections_;
+    std::vector<size_t> stack_; // indices of the open sections
+    std::vector<std::pair<std::string, size_t>> counters_;
+};
+
+} // namespace pmp
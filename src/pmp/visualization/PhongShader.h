@@ -14,6 +14,7 @@ layout (location=0) in vec4 v_position;
 layout (location=1) in vec3 v_normal;
 layout (location=2) in vec2 v_tex;
 layout (location=3) in vec3 v_color;
+layout (location=4) in mat4 v_model;
 
 out vec3 v2f_normal;
 out vec2 v2f_tex;
@@ -26,11 +27,36 @@ uniform mat3 normal_matrix;
 uniform float point_size;
 uniform bool show_texture_layout;
 
+// compressed attributes, see SurfaceMeshGL::set_compress_attributes()
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform bool use_octahedral_normals;
+
+// model transform per instance, see SurfaceMeshGL::set_instances()
+uniform bool use_instances;
+
+// decode a normal from the octahedral encoding in the xy-components
+vec3 octahedral_normal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    v2f_normal   = normal_matrix * v_normal;
+    vec3 normal  = use_octahedral_normals ? octahedral_normal(v_normal.xy) : v_normal;
+    vec4 vertex  = vec4(position_offset + position_scale * v_position.xyz, 1.0);
+    if (use_instances)
+    {
+        vertex = v_model * vertex;
+        normal = mat3(v_model) * normal;
+    }
+    v2f_normal   = normal_matrix * normal;
     v2f_tex      = v_tex;
-    vec4 pos     = show_texture_layout ? vec4(v_tex, 0.0, 1.0) : v_position;
+    vec4 pos     = show_texture_layout ? vec4(v_tex, 0.0, 1.0) : vertex;
     v2f_view     = -(modelview_matrix * pos).xyz;
     v2f_color    = v_color;
     gl_PointSize = point_size;
@@ -57,6 +83,7 @@ uniform bool   use_lighting;
 uniform bool   use_texture;
 uniform bool   use_srgb;
 uniform bool   use_vertex_color;
+uniform bool   use_flat_shading;
 uniform vec3   front_color;
 uniform vec3   back_color;
 uniform float  ambient;
@@ -82,7 +109,12 @@ void main()
         vec3 L1 = normalize(light1);
         vec3 L2 = normalize(light2);
         vec3 V  = normalize(v2f_view);
-        vec3 N  = gl_FrontFacing ? normalize(v2f_normal) : -normalize(v2f_normal);
+        vec3 N;
+        // the face normal from screen-space derivatives faces the viewer
+        if (use_flat_shading)
+            N = normalize(cross(dFdx(v2f_view), dFdy(v2f_view)));
+        else
+            N = gl_FrontFacing ? normalize(v2f_normal) : -normalize(v2f_normal);
         vec3 R;
         float NL, RV;
 
@@ -239,6 +239,15 @@ GLint Shader::load_and_compile(const char* filename, GLenum type)
     return compile(source.c_str(), type);
 }
 
+bool Shader::set_feedback_varyings(const std::vector<const char*>& varyings)
+{
+    if (!pid_)
+        return false;
+    glTransformFeedbackVaryings(pid_, GLsizei(varyings.size()),
+                                varyings.data(), GL_SEPARATE_ATTRIBS);
+    return link();
+}
+
 void Shader::use()
 {
     if (pid_)
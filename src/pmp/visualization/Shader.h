@@ -40,6 +40,11 @@ public:
     bool load(const char* vfile, const char* ffile, const char* gfile = nullptr,
               const char* tcfile = nullptr, const char* tefile = nullptr);
 
+    //! \brief Capture the outputs \p varyings of the vertex shader with
+    //! transform feedback, each into a separate buffer, and relink.
+    //! \details Call after source() or load().
+    bool set_feedback_varyings(const std::vector<const char*>& varyings);
+
     //! enable/bind this shader program
     void use();
 
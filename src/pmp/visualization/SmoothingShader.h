@@ -0,0 +1,105 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+// clang-format off
+
+// shaders of SurfaceSmoothingGL. the vertex shaders run once per vertex and
+// their outputs are captured with transform feedback. the one-rings are in
+// compressed-row buffers: the neighbors of vertex v are at the indices
+// [offsets[v], offsets[v+1]) in counter-clockwise order, and neighbor n is
+// stored as -n-1 if the face between it and the next one is a hole.
+
+// move each vertex by its damped weighted Laplacian, as
+// SurfaceSmoothing::explicit_smoothing(). fixed vertices have zero weights.
+static const char* smoothing_vshader =
+    "#version 330"
+R"glsl(
+uniform samplerBuffer positions;
+uniform isamplerBuffer offsets;
+uniform isamplerBuffer neighbors;
+uniform samplerBuffer weights;
+
+out vec4 position;
+
+void main()
+{
+    vec3 p = texelFetch(positions, gl_VertexID).xyz;
+    int begin = texelFetch(offsets, gl_VertexID).r;
+    int end = texelFetch(offsets, gl_VertexID + 1).r;
+
+    vec3 laplace = vec3(0.0);
+    float sum = 0.0;
+    for (int j = begin; j < end; ++j)
+    {
+        int n = texelFetch(neighbors, j).r;
+        float w = texelFetch(weights, j).r;
+        laplace += w * (texelFetch(positions, n < 0 ? -n - 1 : n).xyz - p);
+        sum += w;
+    }
+
+    position = vec4(sum > 0.0 ? p + 0.5 * laplace / sum : p, 1.0);
+}
+)glsl";
+
+
+// write the position and the angle-weighted vertex normal, as
+// SurfaceNormals::compute_vertex_normal(), of each buffer vertex of a
+// SurfaceMeshGL
+static const char* vertex_buffer_vshader =
+    "#version 330"
+R"glsl(
+uniform samplerBuffer positions;
+uniform isamplerBuffer offsets;
+uniform isamplerBuffer neighbors;
+uniform isamplerBuffer buffer_vertices;
+
+out vec3 position;
+out vec3 normal;
+
+int neighbor(int j)
+{
+    int n = texelFetch(neighbors, j).r;
+    return n < 0 ? -n - 1 : n;
+}
+
+void main()
+{
+    int v = texelFetch(buffer_vertices, gl_VertexID).r;
+    vec3 p0 = texelFetch(positions, v).xyz;
+    int begin = texelFetch(offsets, v).r;
+    int end = texelFetch(offsets, v + 1).r;
+
+    vec3 n = vec3(0.0);
+    for (int j = begin; j < end; ++j)
+    {
+        if (texelFetch(neighbors, j).r < 0)
+            continue;
+        int k = j + 1 < end ? j + 1 : begin;
+        vec3 p1 = texelFetch(positions, neighbor(j)).xyz - p0;
+        vec3 p2 = texelFetch(positions, neighbor(k)).xyz - p0;
+        float denom = sqrt(dot(p1, p1) * dot(p2, p2));
+        vec3 f = cross(p1, p2);
+        float l = length(f);
+        if (denom > 0.0 && l > 0.0)
+            n += acos(clamp(dot(p1, p2) / denom, -1.0, 1.0)) / l * f;
+    }
+
+    position = p0;
+    normal = length(n) > 0.0 ? normalize(n) : vec3(0.0);
+}
+)glsl";
+
+
+// nothing is rasterized
+static const char* feedback_fshader =
+    "#version 330"
+R"glsl(
+out vec4 f_color;
+
+void main()
+{
+    f_color = vec4(1.0);
+}
+)glsl";
+
+// clang-format on
@@ -0,0 +1,39 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+// clang-format off
+
+// shader of SubdivisionSurfaceGL. the vertex shader runs once per refined
+// vertex and its output is captured with transform feedback. the stencils
+// are a compressed-row matrix: the control vertices of refined vertex v and
+// their weights are at the indices [offsets[v], offsets[v+1]).
+
+// evaluate the limit position of each refined vertex as the weighted sum of
+// the control positions
+static const char* stencil_vshader =
+    "#version 330"
+R"glsl(
+uniform samplerBuffer control;
+uniform isamplerBuffer offsets;
+uniform isamplerBuffer columns;
+uniform samplerBuffer weights;
+
+out vec4 position;
+
+void main()
+{
+    int begin = texelFetch(offsets, gl_VertexID).r;
+    int end = texelFetch(offsets, gl_VertexID + 1).r;
+
+    vec3 p = vec3(0.0);
+    for (int j = begin; j < end; ++j)
+    {
+        int c = texelFetch(columns, j).r;
+        p += texelFetch(weights, j).r * texelFetch(control, c).xyz;
+    }
+
+    position = vec4(p, 1.0);
+}
+)glsl";
+
+// clang-format on
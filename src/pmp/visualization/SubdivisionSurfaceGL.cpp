@@ -0,0 +1,370 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/visualization/SubdivisionSurfaceGL.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "pmp/SurfaceAdjacency.h"
+#include "pmp/algorithms/SurfaceSubdivision.h"
+#include "pmp/visualization/SmoothingShader.h"
+#include "pmp/visualization/SubdivisionShader.h"
+
+namespace pmp {
+
+namespace {
+
+// texture units of the buffer textures, positions are the control
+// positions for the stencils and the limit positions for the normals
+const int positions_unit = 0;
+const int offsets_unit = 1;
+const int columns_unit = 2;
+const int neighbors_unit = 2;
+const int weights_unit = 3;
+const int buffer_vertices_unit = 3;
+
+// create a buffer of at least one texel and a buffer texture reading it
+void create_buffer_texture(GLuint& buffer, GLuint& texture, GLenum format,
+                           size_t bytes, const void* data, GLenum usage)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, size_t(16)),
+                 bytes ? data : nullptr, usage);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void bind_texture(int unit, GLuint texture)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
+
+void load_shader(Shader& shader, const char* vshader,
+                 const std::vector<const char*>& varyings)
+{
+    if (!shader.source(vshader, feedback_fshader) ||
+        !shader.set_feedback_varyings(varyings))
+        exit(1);
+}
+
+typedef Eigen::Triplet<double> Triplet;
+
+// the limit position of a vertex on a boundary or on a feature curve, which
+// subdivides as a cubic B-spline, returns false for interior vertices
+bool curve_limit(const SurfaceMesh& mesh, Vertex v,
+                 const VertexProperty<bool>& vfeature,
+                 const EdgeProperty<bool>& efeature,
+                 std::vector<Triplet>& triplets)
+{
+    const int row = int(v.idx());
+    Vertex neighbors[2];
+    int count = 0;
+
+    if (mesh.is_boundary(v))
+    {
+        const Halfedge h = mesh.halfedge(v);
+        neighbors[0] = mesh.to_vertex(h);
+        neighbors[1] = mesh.from_vertex(mesh.prev_halfedge(h));
+        count = 2;
+    }
+    else if (vfeature && efeature && vfeature[v])
+    {
+        for (auto h : mesh.halfedges(v))
+            if (efeature[mesh.edge(h)] && count++ < 2)
+                neighbors[count - 1] = mesh.to_vertex(h);
+    }
+    else
+    {
+        return false;
+    }
+
+    // feature corners stay fixed, as in SurfaceSubdivision
+    if (count != 2)
+    {
+        triplets.emplace_back(row, row, 1.0);
+        return true;
+    }
+
+    triplets.emplace_back(row, row, 4.0 / 6.0);
+    triplets.emplace_back(row, int(neighbors[0].idx()), 1.0 / 6.0);
+    triplets.emplace_back(row, int(neighbors[1].idx()), 1.0 / 6.0);
+    return true;
+}
+
+// the matrix mapping the refined positions to their limit positions, from
+// the limit masks of Loop or Catmull-Clark subdivision
+SubdivisionStencils::Matrix limit_matrix(const SurfaceMesh& mesh, bool loop)
+{
+    const auto vfeature = mesh.get_vertex_property<bool>("v:feature");
+    const auto efeature = mesh.get_edge_property<bool>("e:feature");
+
+    std::vector<Triplet> triplets;
+    triplets.reserve(mesh.n_vertices() * 9);
+    for (auto v : mesh.vertices())
+    {
+        const int row = int(v.idx());
+        if (mesh.is_isolated(v))
+        {
+            triplets.emplace_back(row, row, 1.0);
+            continue;
+        }
+        if (curve_limit(mesh, v, vfeature, efeature, triplets))
+            continue;
+
+        const double n = mesh.valence(v);
+        if (loop)
+        {
+            const double c = 3.0 / 8.0 + 0.25 * std::cos(2.0 * M_PI / n);
+            const double beta = (5.0 / 8.0 - c * c) / n;
+            const double chi = 1.0 / (n + 3.0 / (8.0 * beta));
+            triplets.emplace_back(row, row, 1.0 - n * chi);
+            for (auto w : mesh.vertices(v))
+                triplets.emplace_back(row, int(w.idx()), chi);
+        }
+        else
+        {
+            // edge neighbors and the opposite corners of the quads
+            const double s = 1.0 / (n * (n + 5.0));
+            triplets.emplace_back(row, row, n * n * s);
+            for (auto h : mesh.halfedges(v))
+            {
+                triplets.emplace_back(row, int(mesh.to_vertex(h).idx()),
+                                      4.0 * s);
+                const Vertex opposite = mesh.to_vertex(mesh.next_halfedge(h));
+                triplets.emplace_back(row, int(opposite.idx()), s);
+            }
+        }
+    }
+
+    SubdivisionStencils::Matrix limit(mesh.vertices_size(),
+                                      mesh.vertices_size());
+    limit.setFromTriplets(triplets.begin(), triplets.end());
+    return limit;
+}
+
+} // namespace
+
+SubdivisionSurfaceGL::SubdivisionSurfaceGL(const SurfaceMesh& control,
+                                           unsigned int levels)
+    : levels_(std::max(levels, 1u)),
+      n_control_vertices_(control.vertices_size()),
+      n_vertices_(0),
+      n_triangles_(0)
+{
+    if (!control.n_faces())
+        throw InvalidInputException("SubdivisionSurfaceGL: Mesh has no faces.");
+
+    setup(control);
+
+    load_shader(stencil_shader_, stencil_vshader, {"position"});
+    load_shader(normal_shader_, vertex_buffer_vshader, {"position", "normal"});
+}
+
+SubdivisionSurfaceGL::~SubdivisionSurfaceGL()
+{
+    const GLuint buffers[] = {control_buffer_,    offset_buffer_,
+                              column_buffer_,     weight_buffer_,
+                              limit_buffer_,      ring_offset_buffer_,
+                              neighbor_buffer_,   identity_buffer_,
+                              position_buffer_,   normal_buffer_,
+                              triangle_buffer_};
+    const GLuint textures[] = {control_texture_,  offset_texture_,
+                               column_texture_,   weight_texture_,
+                               limit_texture_,    ring_offset_texture_,
+                               neighbor_texture_, identity_texture_};
+    glDeleteBuffers(11, buffers);
+    glDeleteTextures(8, textures);
+    glDeleteVertexArrays(1, &vertex_array_object_);
+    glDeleteVertexArrays(1, &feedback_array_object_);
+}
+
+void SubdivisionSurfaceGL::setup(const SurfaceMesh& control)
+{
+    // refine a copy, the scheme follows SurfaceSubdivision's preconditions
+    SurfaceMesh refined = control;
+    SubdivisionStencils stencils;
+    const bool loop = control.is_triangle_mesh();
+    if (loop)
+        SurfaceSubdivision(refined).loop(levels_, stencils);
+    else
+        SurfaceSubdivision(refined).catmull_clark(levels_, stencils);
+    n_vertices_ = refined.vertices_size();
+
+    // limit positions as weighted sums of the control positions
+    SubdivisionStencils::Matrix limit =
+        limit_matrix(refined, loop) * stencils.matrix();
+    limit.makeCompressed();
+    const size_t n_weights = size_t(limit.nonZeros());
+    std::vector<int> offsets(limit.outerIndexPtr(),
+                             limit.outerIndexPtr() + n_vertices_ + 1);
+    std::vector<int> columns(limit.innerIndexPtr(),
+                             limit.innerIndexPtr() + n_weights);
+    std::vector<float> weights(limit.valuePtr(),
+                               limit.valuePtr() + n_weights);
+
+    // one-rings of the refined vertices, neighbors across holes are marked
+    const SurfaceAdjacency adjacency(refined);
+    std::vector<int> ring_offsets(n_vertices_ + 1, 0);
+    for (size_t i = 0; i < n_vertices_; ++i)
+        ring_offsets[i + 1] =
+            ring_offsets[i] + int(adjacency.valence(Vertex(IndexType(i))));
+    std::vector<int> neighbors(ring_offsets[n_vertices_]);
+    std::vector<int> identity(n_vertices_);
+    for (size_t i = 0; i < n_vertices_; ++i)
+    {
+        const auto v = Vertex(IndexType(i));
+        const auto vertices = adjacency.vertex_vertices(v);
+        const auto faces = adjacency.vertex_faces(v);
+        for (size_t j = 0; j < vertices.size(); ++j)
+        {
+            const int n = int(vertices[j].idx());
+            neighbors[ring_offsets[i] + j] = faces[j].is_valid() ? n : -n - 1;
+        }
+        identity[i] = int(i);
+    }
+
+    // triangle fans of the refined triangles or quads
+    std::vector<unsigned int> triangles;
+    triangles.reserve(6 * refined.n_faces());
+    std::vector<unsigned int> corners;
+    for (auto f : refined.faces())
+    {
+        corners.clear();
+        for (auto v : refined.vertices(f))
+            corners.push_back(v.idx());
+        for (size_t i = 2; i < corners.size(); ++i)
+        {
+            triangles.push_back(corners[0]);
+            triangles.push_back(corners[i - 1]);
+            triangles.push_back(corners[i]);
+        }
+    }
+    n_triangles_ = triangles.size() / 3;
+
+    create_buffer_texture(control_buffer_, control_texture_, GL_RGBA32F,
+                          n_control_vertices_ * sizeof(vec4), nullptr,
+                          GL_DYNAMIC_DRAW);
+    create_buffer_texture(offset_buffer_, offset_texture_, GL_R32I,
+                          offsets.size() * sizeof(int), offsets.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(column_buffer_, column_texture_, GL_R32I,
+                          columns.size() * sizeof(int), columns.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(weight_buffer_, weight_texture_, GL_R32F,
+                          weights.size() * sizeof(float), weights.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(limit_buffer_, limit_texture_, GL_RGBA32F,
+                          n_vertices_ * sizeof(vec4), nullptr,
+                          GL_DYNAMIC_COPY);
+    create_buffer_texture(ring_offset_buffer_, ring_offset_texture_, GL_R32I,
+                          ring_offsets.size() * sizeof(int),
+                          ring_offsets.data(), GL_STATIC_DRAW);
+    create_buffer_texture(neighbor_buffer_, neighbor_texture_, GL_R32I,
+                          neighbors.size() * sizeof(int), neighbors.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(identity_buffer_, identity_texture_, GL_R32I,
+                          identity.size() * sizeof(int), identity.data(),
+                          GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // the refined triangles, drawn from the captured positions and normals
+    glGenVertexArrays(1, &vertex_array_object_);
+    glBindVertexArray(vertex_array_object_);
+    glGenBuffers(1, &position_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, position_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, n_vertices_ * sizeof(vec3), nullptr,
+                 GL_DYNAMIC_COPY);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(0);
+    glGenBuffers(1, &normal_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, n_vertices_ * sizeof(vec3), nullptr,
+                 GL_DYNAMIC_COPY);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(1);
+    glGenBuffers(1, &triangle_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 triangles.size() * sizeof(unsigned int), triangles.data(),
+                 GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // drawing requires a vertex array, even without attributes
+    glGenVertexArrays(1, &feedback_array_object_);
+}
+
+void SubdivisionSurfaceGL::evaluate(const SurfaceMesh& control)
+{
+    if (control.vertices_size() != n_control_vertices_)
+        throw InvalidInputException(
+            "SubdivisionSurfaceGL: Number of control vertices differs.");
+
+    const auto vpoint = control.get_vertex_property<Point>("v:point");
+    std::vector<vec4> positions(n_control_vertices_);
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = vec4((vec3)vpoint[Vertex(IndexType(i))], 1.0);
+    glBindBuffer(GL_TEXTURE_BUFFER, control_buffer_);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, positions.size() * sizeof(vec4),
+                    positions.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindVertexArray(feedback_array_object_);
+    glEnable(GL_RASTERIZER_DISCARD);
+    const GLsizei nv = GLsizei(n_vertices_);
+
+    // limit positions from the stencils
+    stencil_shader_.use();
+    stencil_shader_.set_uniform("control", positions_unit);
+    stencil_shader_.set_uniform("offsets", offsets_unit);
+    stencil_shader_.set_uniform("columns", columns_unit);
+    stencil_shader_.set_uniform("weights", weights_unit);
+    bind_texture(positions_unit, control_texture_);
+    bind_texture(offsets_unit, offset_texture_);
+    bind_texture(columns_unit, column_texture_);
+    bind_texture(weights_unit, weight_texture_);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, limit_buffer_);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, nv);
+    glEndTransformFeedback();
+
+    // positions and normals of the vertex buffers
+    normal_shader_.use();
+    normal_shader_.set_uniform("positions", positions_unit);
+    normal_shader_.set_uniform("offsets", offsets_unit);
+    normal_shader_.set_uniform("neighbors", neighbors_unit);
+    normal_shader_.set_uniform("buffer_vertices", buffer_vertices_unit);
+    bind_texture(positions_unit, limit_texture_);
+    bind_texture(offsets_unit, ring_offset_texture_);
+    bind_texture(neighbors_unit, neighbor_texture_);
+    bind_texture(buffer_vertices_unit, identity_texture_);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, position_buffer_);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, normal_buffer_);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, nv);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, 0);
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    for (int unit = 3; unit >= 0; --unit)
+        bind_texture(unit, 0);
+    glBindVertexArray(0);
+    normal_shader_.disable();
+}
+
+void SubdivisionSurfaceGL::draw()
+{
+    glBindVertexArray(vertex_array_object_);
+    glDrawElements(GL_TRIANGLES, GLsizei(3 * n_triangles_), GL_UNSIGNED_INT,
+                   nullptr);
+    glBindVertexArray(0);
+}
+
+} // namespace pmp
@@ -0,0 +1,98 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include "pmp/SurfaceMesh.h"
+#include "pmp/visualization/GL.h"
+#include "pmp/visualization/Shader.h"
+
+namespace pmp {
+
+//! \brief Limit surface of a subdivided control mesh, evaluated on the GPU.
+//! \details Subdivides a copy of the control mesh once on the CPU, with
+//! Loop subdivision for triangle meshes and Catmull-Clark subdivision
+//! otherwise, and records the limit positions of the refined vertices as
+//! weighted sums of the control vertices, see SubdivisionStencils. The
+//! limit masks of the refined vertices are composed with the subdivision
+//! stencils, such that the displayed vertices lie on the limit surface.
+//! These weights and the refined triangles are uploaded once. Evaluating the
+//! surface for new control positions uploads just the control positions and
+//! computes the refined positions and normals in vertex shaders captured
+//! with transform feedback, as SurfaceSmoothingGL, since the tessellation
+//! and compute shaders of OpenGL 4 are not available in the core profile
+//! 3.2 of the viewers.
+//!
+//! Used by SurfaceMeshGL for the draw mode \c "Subdivision Surface". The
+//! connectivity of the control mesh must not change while the object is in
+//! use. Not available in WebGL, which has no buffer textures.
+//! \ingroup visualization
+class SubdivisionSurfaceGL
+{
+public:
+    //! \brief Subdivide \p control \p levels times and upload the stencils.
+    //! \details Requires an OpenGL context. Zero levels are treated as one.
+    //! \throw InvalidInputException if \p control has no faces.
+    SubdivisionSurfaceGL(const SurfaceMesh& control, unsigned int levels);
+
+    //! free the GPU buffers
+    ~SubdivisionSurfaceGL();
+
+    SubdivisionSurfaceGL(const SubdivisionSurfaceGL&) = delete;
+    SubdivisionSurfaceGL& operator=(const SubdivisionSurfaceGL&) = delete;
+
+    //! the number of subdivision levels
+    unsigned int levels() const { return levels_; }
+
+    //! the number of refined vertices
+    size_t n_vertices() const { return n_vertices_; }
+
+    //! the number of triangles drawn by draw()
+    size_t n_triangles() const { return n_triangles_; }
+
+    //! \brief Upload the positions of \p control and evaluate the limit
+    //! positions and normals.
+    //! \pre \p control has the connectivity of the mesh given to the
+    //! constructor.
+    //! \throw InvalidInputException if the number of vertices differs.
+    void evaluate(const SurfaceMesh& control);
+
+    //! \brief Draw the triangles of the limit surface.
+    //! \details Positions and normals are bound to the attribute locations 0
+    //! and 1. The caller sets up the shader.
+    void draw();
+
+private:
+    // compute the stencils of the limit positions and the refined
+    // connectivity, and upload them
+    void setup(const SurfaceMesh& control);
+
+    unsigned int levels_;
+    size_t n_control_vertices_;
+    size_t n_vertices_;
+    size_t n_triangles_;
+
+    // control positions and stencils, see SubdivisionShader.h
+    GLuint control_buffer_, offset_buffer_, column_buffer_, weight_buffer_;
+    GLuint control_texture_, offset_texture_, column_texture_,
+        weight_texture_;
+
+    // limit positions, and the one-rings of the refined vertices for their
+    // normals, see SmoothingShader.h
+    GLuint limit_buffer_, ring_offset_buffer_, neighbor_buffer_,
+        identity_buffer_;
+    GLuint limit_texture_, ring_offset_texture_, neighbor_texture_,
+        identity_texture_;
+
+    // buffers for drawing the refined triangles
+    GLuint vertex_array_object_;
+    GLuint position_buffer_, normal_buffer_, triangle_buffer_;
+
+    // vertex array without attributes for transform feedback
+    GLuint feedback_array_object_;
+
+    Shader stencil_shader_;
+    Shader normal_shader_;
+};
+
+} // namespace pmp
@@ -3,15 +3,236 @@
 
 #include "pmp/visualization/SurfaceMeshGL.h"
 
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <utility>
+
 #include <stb_image.h>
 
 #include "pmp/visualization/PhongShader.h"
 #include "pmp/visualization/MatCapShader.h"
 #include "pmp/visualization/ColdWarmTexture.h"
+#include "pmp/visualization/SubdivisionSurfaceGL.h"
+#include "pmp/Parallel.h"
 #include "pmp/algorithms/SurfaceNormals.h"
 
 namespace pmp {
 
+namespace {
+
+// object property holding the generation of the latest buffer update
+const char* const buffer_generation_name = "gl:buffer_generation";
+
+// number of triangles per meshlet
+const unsigned int meshlet_triangles = 512;
+
+// Spread the lower 21 bits of x such that two zero bits separate each bit.
+inline uint64_t spread_bits(uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+// the planes of the view frustum of the modelview-projection matrix mvp in
+// model coordinates, pointing inwards and normalized
+void frustum_planes(const mat4& mvp, vec4 planes[6])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            planes[2 * i][j] = mvp(3, j) + mvp(i, j);
+            planes[2 * i + 1][j] = mvp(3, j) - mvp(i, j);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        const float l = norm(vec3(planes[i][0], planes[i][1], planes[i][2]));
+        if (l > 0)
+            planes[i] /= l;
+    }
+}
+
+// upload the elements at the sorted indices, merging nearby indices into
+// contiguous ranges to reduce the number of calls. elements(first, count)
+// returns the data of a range. returns the number of uploaded bytes.
+template <class Elements>
+size_t upload_ranges(GLenum target, GLuint buffer, size_t element_size,
+                   const std::vector<size_t>& indices, Elements elements)
+{
+    const size_t max_gap = 64;
+    size_t bytes = 0;
+    glBindBuffer(target, buffer);
+    for (size_t i = 0; i < indices.size();)
+    {
+        size_t j = i + 1;
+        while (j < indices.size() && indices[j] - indices[j - 1] <= max_gap)
+            ++j;
+        const size_t first = indices[i];
+        const size_t count = indices[j - 1] - first + 1;
+        glBufferSubData(target, first * element_size, count * element_size,
+                        elements(first, count));
+        bytes += count * element_size;
+        i = j;
+    }
+    return bytes;
+}
+
+// compressed vertex attributes, padded to multiples of four bytes
+typedef std::array<uint16_t, 4> PackedPosition;
+typedef std::array<int16_t, 2> PackedNormal;
+typedef std::array<uint8_t, 4> PackedColor;
+typedef std::array<uint16_t, 2> PackedTexCoord;
+
+// quantize p to 16 bits relative to the box decoded as offset + scale * q
+PackedPosition pack_position(const vec3& p, const vec3& offset,
+                             const vec3& scale)
+{
+    PackedPosition q = {{0, 0, 0, 0}};
+    for (int i = 0; i < 3; ++i)
+    {
+        if (scale[i] > 0)
+        {
+            const float x = std::round((p[i] - offset[i]) / scale[i]);
+            q[i] = uint16_t(std::min(std::max(x, 0.0f), 65535.0f));
+        }
+    }
+    return q;
+}
+
+// octahedral encoding of the unit vector n, mapping the upper hemisphere
+// to the inner diamond of [-1,1]^2 and unfolding the lower one
+PackedNormal pack_normal(const vec3& n)
+{
+    PackedNormal q = {{0, 0}};
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    if (l1 == 0)
+        return q;
+    float x = n[0] / l1;
+    float y = n[1] / l1;
+    if (n[2] < 0)
+    {
+        const float u = (1 - std::abs(y)) * (x < 0 ? -1 : 1);
+        const float v = (1 - std::abs(x)) * (y < 0 ? -1 : 1);
+        x = u;
+        y = v;
+    }
+    q[0] = int16_t(std::round(std::min(std::max(x, -1.0f), 1.0f) * 32767));
+    q[1] = int16_t(std::round(std::min(std::max(y, -1.0f), 1.0f) * 32767));
+    return q;
+}
+
+PackedColor pack_color(const vec3& c)
+{
+    PackedColor q = {{0, 0, 0, 255}};
+    for (int i = 0; i < 3; ++i)
+        q[i] = uint8_t(std::round(std::min(std::max(c[i], 0.0f), 1.0f) * 255));
+    return q;
+}
+
+// convert to IEEE half precision, rounding to nearest
+uint16_t half_float(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const uint16_t sign = (x >> 16) & 0x8000;
+    const int exponent = int((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = x & 0x7fffff;
+
+    // infinity and NaN, or overflow
+    if (((x >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 31)
+        return sign | 0x7c00;
+
+    // subnormal or zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t h = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            ++h;
+        return uint16_t(sign | h);
+    }
+
+    // a carry of the rounding correctly increments the exponent
+    uint32_t h = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        ++h;
+    return uint16_t(h);
+}
+
+PackedTexCoord pack_texcoord(const vec2& t)
+{
+    PackedTexCoord q = {{half_float(t[0]), half_float(t[1])}};
+    return q;
+}
+
+// upload the values converted by pack to an array buffer
+template <class Value, class Pack>
+void upload_packed(GLuint buffer, const std::vector<Value>& values, Pack pack)
+{
+    typedef decltype(pack(values[0])) Packed;
+    std::vector<Packed> packed(values.size());
+    const int n = int(values.size());
+
+    parallel_for(0, n, [&](int i) { packed[i] = pack(values[i]); });
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(Packed),
+                 packed.data(), GL_STATIC_DRAW);
+}
+
+// replace buffer by one of capacity bytes, copying its first used bytes
+// on the GPU
+void grow_buffer(GLuint& buffer, size_t used, size_t capacity)
+{
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    if (used)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                            used);
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
+
+// the values of a vertex property for all vertices that are not deleted,
+// by a counted loop if the mesh has no garbage
+template <class T>
+void vertex_values(const SurfaceMesh& mesh, const VertexProperty<T>& prop,
+                   std::vector<vec3>& values)
+{
+    values.resize(mesh.n_vertices());
+    if (!mesh.has_garbage())
+    {
+        for (auto v : mesh.dense_vertices())
+            values[v.idx()] = (vec3)prop[v];
+        return;
+    }
+    size_t i = 0;
+    for (auto v : mesh.vertices())
+        values[i++] = (vec3)prop[v];
+}
+
+} // namespace
+
 SurfaceMeshGL::SurfaceMeshGL()
 {
     // initialize GL buffers to zero
@@ -20,8 +241,10 @@ SurfaceMeshGL::SurfaceMeshGL()
     color_buffer_ = 0;
     normal_buffer_ = 0;
     tex_coord_buffer_ = 0;
+    triangle_buffer_ = 0;
     edge_buffer_ = 0;
     feature_buffer_ = 0;
+    instance_buffer_ = 0;
 
     // initialize buffer sizes
     n_vertices_ = 0;
@@ -30,6 +253,20 @@ SurfaceMeshGL::SurfaceMeshGL()
     n_features_ = 0;
     has_texcoords_ = false;
     has_vertex_colors_ = false;
+    has_triangle_indices_ = false;
+    appended_vertex_capacity_ = 0;
+    appended_edge_capacity_ = 0;
+    cull_backfacing_ = false;
+    compress_attributes_ = false;
+    compressed_attributes_ = false;
+    uploaded_bytes_ = 0;
+    drawn_triangles_ = 0;
+    buffer_sources_ = 0;
+    buffer_generation_ = 0;
+    upload_instances_ = false;
+    subdivision_ = nullptr;
+    subdivision_levels_ = 3;
+    subdivision_outdated_ = false;
 
     // material parameters
     front_color_ = vec3(0.6, 0.6, 0.6);
@@ -50,13 +287,17 @@ SurfaceMeshGL::SurfaceMeshGL()
 
 SurfaceMeshGL::~SurfaceMeshGL()
 {
+    clear_subdivision();
+
     // delete OpenGL buffers
     glDeleteBuffers(1, &vertex_buffer_);
     glDeleteBuffers(1, &color_buffer_);
     glDeleteBuffers(1, &normal_buffer_);
     glDeleteBuffers(1, &tex_coord_buffer_);
+    glDeleteBuffers(1, &triangle_buffer_);
     glDeleteBuffers(1, &edge_buffer_);
     glDeleteBuffers(1, &feature_buffer_);
+    glDeleteBuffers(1, &instance_buffer_);
     glDeleteVertexArrays(1, &vertex_array_object_);
     glDeleteTextures(1, &texture_);
 }
@@ -229,183 +470,401 @@ void SurfaceMeshGL::set_crease_angle(Scalar ca)
     if (ca != crease_angle_)
     {
         crease_angle_ = std::max(Scalar(0), std::min(Scalar(180), ca));
+
+        // vertices are split differently, force a full update
+        corner_buffer_vertices_.clear();
         update_opengl_buffers();
     }
 }
 
 void SurfaceMeshGL::update_opengl_buffers()
 {
-    // are buffers already initialized?
-    if (!vertex_array_object_)
+    // only vertices moved since the last update?
+    if (update_moved_vertices())
     {
-        glGenVertexArrays(1, &vertex_array_object_);
-        glBindVertexArray(vertex_array_object_);
-        glGenBuffers(1, &vertex_buffer_);
-        glGenBuffers(1, &color_buffer_);
-        glGenBuffers(1, &normal_buffer_);
-        glGenBuffers(1, &tex_coord_buffer_);
-        glGenBuffers(1, &edge_buffer_);
-        glGenBuffers(1, &feature_buffer_);
+        subdivision_outdated_ = true;
+        return;
     }
 
-    // activate VAO
-    glBindVertexArray(vertex_array_object_);
-
-    // get properties
-    auto vpos = get_vertex_property<Point>("v:point");
-    auto vcolor = get_vertex_property<Color>("v:color");
-    auto vtex = get_vertex_property<TexCoord>("v:tex");
-    auto htex = get_halfedge_property<TexCoord>("h:tex");
-    auto fcolor = get_face_property<Color>("f:color");
+    // the connectivity may have changed
+    clear_subdivision();
 
-    // index array for remapping vertex indices during duplication
-    auto vertex_indices = add_vertex_property<size_t>("v:index");
+    // activate VAO, the buffers are allocated to fit
+    create_buffers();
+    glBindVertexArray(vertex_array_object_);
+    appended_vertex_capacity_ = 0;
+    appended_edge_capacity_ = 0;
+
+    // get properties, using interned keys to avoid name lookups. the
+    // handles are const such that reading them in parallel neither copies
+    // shared elements nor records modifications.
+    static const PropertyKey vpos_key("v:point");
+    static const PropertyKey vcolor_key("v:color");
+    static const PropertyKey vtex_key("v:tex");
+    static const PropertyKey htex_key("h:tex");
+    static const PropertyKey fcolor_key("f:color");
+    static const PropertyKey efeature_key("e:feature");
+    const auto vpos = get_vertex_property<Point>(vpos_key);
+    const auto vcolor = get_vertex_property<Color>(vcolor_key);
+    const auto vtex = get_vertex_property<TexCoord>(vtex_key);
+    const auto htex = get_halfedge_property<TexCoord>(htex_key);
+    const auto fcolor = get_face_property<Color>(fcolor_key);
+    const auto efeature = get_edge_property<bool>(efeature_key);
 
     // produce arrays of points, normals, and texcoords
-    // (duplicate vertices to allow for flat shading)
+    // (split vertices only where their attributes differ)
     std::vector<vec3> position_array;
     std::vector<vec3> color_array;
     std::vector<vec3> normal_array;
     std::vector<vec2> tex_array;
-    std::vector<ivec3> triangles;
+    std::vector<unsigned int> triangle_array;
+    std::vector<unsigned int> edgeArray;
+    std::vector<unsigned int> features;
+
+    // first buffer vertex of each vertex
+    std::vector<unsigned int> vertex_offsets;
+
+    // polygons with cached tessellations, see reusable_tessellations()
+    std::vector<char> reuse;
 
-    // we have a mesh: fill arrays by looping over faces
+    // index arrays prepared while the vertex arrays are uploaded
+    std::future<void> indices;
+
+    // we have a mesh: fill arrays in parallel, writing to offsets from
+    // prefix sums of the buffer vertices per vertex and triangles per face
     if (n_faces())
     {
-        // reserve memory
-        position_array.reserve(3 * n_faces());
-        normal_array.reserve(3 * n_faces());
-        if (htex || vtex)
-            tex_array.reserve(3 * n_faces());
-
-        if ((vcolor || fcolor) && use_colors_)
-            color_array.reserve(3 * n_faces());
+        const bool use_texcoords = htex || vtex;
+        const bool use_colors = (vcolor || fcolor) && use_colors_;
 
-        // precompute normals for easy cases
-        FaceProperty<Normal> fnormals;
+        // precompute normals for easy cases. flat shading computes the face
+        // normals in the shader, such that vertices need not be split.
         VertexProperty<Normal> vnormals;
-        if (crease_angle_ < 1)
-        {
-            fnormals = add_face_property<Normal>("gl:fnormal");
-            for (auto f : faces())
-                fnormals[f] = SurfaceNormals::compute_face_normal(*this, f);
-        }
-        else if (crease_angle_ > 170)
+        if (crease_angle_ < 1 || crease_angle_ > 170)
         {
             vnormals = add_vertex_property<Normal>("gl:vnormal");
-            for (auto v : vertices())
+            parallel_for(vertices(), [&](Vertex v) {
                 vnormals[v] = SurfaceNormals::compute_vertex_normal(*this, v);
+            });
         }
-
-        // data per face (for all corners)
-        std::vector<Halfedge> corner_halfedges;
-        std::vector<Vertex> corner_vertices;
-        std::vector<vec3> corner_positions;
-        std::vector<vec3> corner_colors;
-        std::vector<vec3> corner_normals;
-        std::vector<vec2> corner_texcoords;
+        const auto& cvnormals = vnormals;
 
         // convert from degrees to radians
         const Scalar crease_angle_radians = crease_angle_ / 180.0 * M_PI;
 
-        size_t vidx(0);
-
-        // loop over all faces
-        for (auto f : faces())
+        // attributes of the corner at the end of halfedge h, optionally
+        // skipping the computation of corner normals
+        struct Corner
         {
-            // collect corner positions and normals
-            corner_halfedges.clear();
-            corner_vertices.clear();
-            corner_positions.clear();
-            corner_colors.clear();
-            corner_normals.clear();
-            corner_texcoords.clear();
-            Vertex v;
-            Normal n;
-
-            for (auto h : halfedges(f))
-            {
-                v = to_vertex(h);
-                corner_halfedges.push_back(h);
-                corner_vertices.push_back(v);
-                corner_positions.push_back((vec3)vpos[v]);
-
-                if (crease_angle_ < 1)
-                {
-                    n = fnormals[f];
-                }
-                else if (crease_angle_ > 170)
+            vec3 normal;
+            vec2 texcoord;
+            vec3 color;
+        };
+        auto corner = [&](Halfedge h, bool corner_normal) {
+            Corner c;
+            const Vertex v = to_vertex(h);
+            if (cvnormals)
+                c.normal = (vec3)cvnormals[v];
+            else if (corner_normal)
+                c.normal = (vec3)SurfaceNormals::compute_corner_normal(
+                    *this, h, crease_angle_radians);
+            if (htex)
+                c.texcoord = (vec2)htex[h];
+            else if (vtex)
+                c.texcoord = (vec2)vtex[v];
+            if (vcolor && use_colors_)
+                c.color = (vec3)vcolor[v];
+            else if (fcolor && use_colors_)
+                c.color = (vec3)fcolor[face(h)];
+            return c;
+        };
+        auto same = [&](const Corner& a, const Corner& b) {
+            return a.normal == b.normal &&
+                   (!use_texcoords || a.texcoord == b.texcoord) &&
+                   (!use_colors || a.color == b.color);
+        };
+
+        // number the distinct corners of each vertex, which become its
+        // buffer vertices. this splits vertices only at creases, texture
+        // seams, and color borders. the expensive corner normals of the
+        // first corner of each split are kept for filling the buffers.
+        const int nv = int(vertices_size());
+        corner_buffer_vertices_.assign(halfedges_size(), UINT_MAX);
+        std::vector<vec3> split_normals(vnormals ? 0 : halfedges_size());
+        vertex_offsets.assign(nv + 1, 0);
+        parallel_for_chunks(
+            0, nv,
+            [&](int first, int last) {
+                std::vector<Corner> splits;
+                for (int i = first; i < last; ++i)
                 {
-                    n = vnormals[v];
+                    const Vertex v(i);
+                    if (is_deleted(v) || is_isolated(v))
+                        continue;
+
+                    splits.clear();
+                    for (auto h : halfedges(v))
+                    {
+                        const Halfedge c = opposite_halfedge(h);
+                        if (is_boundary(c))
+                            continue;
+                        const Corner attributes = corner(c, true);
+                        size_t k = 0;
+                        while (k < splits.size() &&
+                               !same(splits[k], attributes))
+                            ++k;
+                        if (k == splits.size())
+                        {
+                            splits.push_back(attributes);
+                            if (!vnormals)
+                                split_normals[c.idx()] = attributes.normal;
+                        }
+                        corner_buffer_vertices_[c.idx()] = (unsigned int)k;
+                    }
+                    vertex_offsets[i + 1] = (unsigned int)splits.size();
                 }
-                else
+            },
+            1024);
+        for (int i = 0; i < nv; ++i)
+            vertex_offsets[i + 1] += vertex_offsets[i];
+
+        // fill the buffer vertices from the first corner of each split
+        const size_t n_buffer_vertices = vertex_offsets[nv];
+        position_array.resize(n_buffer_vertices);
+        normal_array.resize(n_buffer_vertices);
+        if (use_texcoords)
+            tex_array.resize(n_buffer_vertices);
+        if (use_colors)
+            color_array.resize(n_buffer_vertices);
+        parallel_for(vertices(), [&](Vertex v) {
+            if (is_isolated(v))
+                return;
+            const unsigned int offset = vertex_offsets[v.idx()];
+            unsigned int n_splits = 0;
+            for (auto h : halfedges(v))
+            {
+                const Halfedge c = opposite_halfedge(h);
+                if (is_boundary(c))
+                    continue;
+                unsigned int& idx = corner_buffer_vertices_[c.idx()];
+                if (idx == n_splits)
                 {
-                    n = SurfaceNormals::compute_corner_normal(
-                        *this, h, crease_angle_radians);
+                    const Corner attributes = corner(c, false);
+                    position_array[offset + idx] = (vec3)vpos[v];
+                    normal_array[offset + idx] =
+                        vnormals ? attributes.normal : split_normals[c.idx()];
+                    if (use_texcoords)
+                        tex_array[offset + idx] = attributes.texcoord;
+                    if (use_colors)
+                        color_array[offset + idx] = attributes.color;
+                    ++n_splits;
                 }
-                corner_normals.push_back((vec3)n);
+                idx += offset;
+            }
+        });
+
+        // clean up
+        if (vnormals)
+            remove_vertex_property(vnormals);
 
-                if (htex)
+        // polygons whose tessellation need not be recomputed
+        reuse = reusable_tessellations();
+
+        // tessellate the faces into triangles, edges and feature edges
+        // connect the first buffer vertices of their vertices
+        auto prepare_indices = [&]() {
+            const int nf = int(faces_size());
+            face_triangles_.assign(nf, 0);
+            parallel_for(faces(), [&](Face f) {
+                face_triangles_[f.idx()] = (unsigned int)valence(f) - 2;
+            });
+
+            // the cached tessellations keep their offsets while the
+            // connectivity is unchanged
+            if (reuse.empty())
+            {
+                polygon_offsets_.assign(nf + 1, 0);
+                for (int i = 0; i < nf; ++i)
                 {
-                    corner_texcoords.push_back((vec2)htex[h]);
+                    const unsigned int n = face_triangles_[i];
+                    polygon_offsets_[i + 1] =
+                        polygon_offsets_[i] + (n > 1 ? n : 0);
                 }
-                else if (vtex)
+                if (polygon_offsets_[nf])
+                    polygon_triangles_.resize(polygon_offsets_[nf]);
+                else
+                    polygon_offsets_.clear();
+            }
+
+            // order the faces along a Morton curve of their centroids,
+            // sorting by grid cells of about eight faces each on a surface,
+            // such that consecutive triangles form compact meshlets
+            int levels = 0;
+            while (levels < 7 && (1 << 2 * (levels + 1)) <= nf / 8)
+                ++levels;
+            BoundingBox bb = bounds();
+            const Point extent = bb.max() - bb.min();
+            Scalar scale = std::max(extent[0], std::max(extent[1], extent[2]));
+            scale = scale > 0 ? Scalar((1 << levels) - 1) / scale : 0;
+            std::vector<unsigned int> codes(nf, 0);
+            parallel_for(faces(), [&](Face f) {
+                Point c(0, 0, 0);
+                for (auto v : vertices(f))
+                    c += vpos[v];
+                const Point q =
+                    (c / Scalar(face_triangles_[f.idx()] + 2) - bb.min()) *
+                    scale;
+                codes[f.idx()] =
+                    (unsigned int)(spread_bits(uint64_t(q[0])) |
+                                   spread_bits(uint64_t(q[1])) << 1 |
+                                   spread_bits(uint64_t(q[2])) << 2);
+            });
+            std::vector<unsigned int> cells((size_t(1) << 3 * levels) + 1, 0);
+            for (int i = 0; i < nf; ++i)
+                ++cells[codes[i] + 1];
+            for (size_t i = 1; i < cells.size(); ++i)
+                cells[i] += cells[i - 1];
+            std::vector<unsigned int> order(nf);
+            for (int i = 0; i < nf; ++i)
+                order[cells[codes[i]]++] = i;
+
+            unsigned int n_triangles = 0;
+            for (auto i : order)
+            {
+                const unsigned int n = face_triangles_[i];
+                face_triangles_[i] = n_triangles;
+                n_triangles += n;
+            }
+            triangle_array.resize(3 * size_t(n_triangles));
+
+            // reuse the cached tessellation of a polygon or compute and
+            // cache it. returns false if it needs the triangulation table
+            // but is tessellated in parallel.
+            auto tesselate_face = [&](Face f, bool parallel,
+                                      std::vector<vec3>& positions,
+                                      std::vector<unsigned int>& corners,
+                                      std::vector<ivec3>& triangles) {
+                corners.clear();
+                for (auto h : halfedges(f))
+                    corners.push_back(corner_buffer_vertices_[h.idx()]);
+                size_t t = 3 * size_t(face_triangles_[f.idx()]);
+                if (corners.size() == 3)
                 {
-                    corner_texcoords.push_back((vec2)vtex[v]);
+                    std::copy(corners.begin(), corners.end(),
+                              triangle_array.begin() + t);
+                    return true;
                 }
 
-                if (vcolor && use_colors_)
+                ivec3* cached =
+                    &polygon_triangles_[polygon_offsets_[f.idx()]];
+                if (reuse.empty() || !reuse[f.idx()])
                 {
-                    corner_colors.push_back((vec3)vcolor[v]);
+                    positions.clear();
+                    for (auto v : vertices(f))
+                        positions.push_back((vec3)vpos[v]);
+                    if (!parallel)
+                        tesselate(positions, triangles);
+                    else if (!tesselate_convex(positions, triangles))
+                        return false;
+                    std::copy(triangles.begin(), triangles.end(), cached);
                 }
-                else if (fcolor && use_colors_)
+                for (size_t i = 0; i + 2 < corners.size(); ++i)
+                    for (int k = 0; k < 3; ++k)
+                        triangle_array[t++] = corners[cached[i][k]];
+                return true;
+            };
+
+            // non-convex polygons with more than four corners share the
+            // triangulation table and are tessellated sequentially
+            const int chunk_size = 1024;
+            std::vector<std::vector<Face>> polygons((nf + chunk_size - 1) /
+                                                    chunk_size);
+            parallel_for_chunks(
+                0, nf,
+                [&](int first, int last) {
+                    std::vector<vec3> positions;
+                    std::vector<unsigned int> corners;
+                    std::vector<ivec3> triangles;
+                    std::vector<Face>& non_convex =
+                        polygons[first / chunk_size];
+                    for (int i = first; i < last; ++i)
+                    {
+                        const Face f(i);
+                        if (!is_deleted(f) &&
+                            !tesselate_face(f, true, positions, corners,
+                                            triangles))
+                            non_convex.push_back(f);
+                    }
+                },
+                chunk_size);
+            {
+                std::vector<vec3> positions;
+                std::vector<unsigned int> corners;
+                std::vector<ivec3> triangles;
+                for (const auto& non_convex : polygons)
+                    for (auto f : non_convex)
+                        tesselate_face(f, false, positions, corners,
+                                       triangles);
+            }
+
+            build_meshlets(position_array, triangle_array);
+
+            // backfacing meshlets are hidden if the mesh is closed
+            cull_backfacing_ = true;
+            for (auto v : vertices())
+            {
+                if (is_boundary(v))
                 {
-                    corner_colors.push_back((vec3)fcolor[f]);
+                    cull_backfacing_ = false;
+                    break;
                 }
             }
-            assert(corner_vertices.size() >= 3);
 
-            // tessellate face into triangles
-            tesselate(corner_positions, triangles);
-            for (auto& t : triangles)
+            // edges are compact unless some are deleted
+            if (edges_size() == n_edges())
             {
-                int i0 = t[0];
-                int i1 = t[1];
-                int i2 = t[2];
-
-                position_array.push_back(corner_positions[i0]);
-                position_array.push_back(corner_positions[i1]);
-                position_array.push_back(corner_positions[i2]);
-
-                normal_array.push_back(corner_normals[i0]);
-                normal_array.push_back(corner_normals[i1]);
-                normal_array.push_back(corner_normals[i2]);
-
-                if (htex || vtex)
+                edgeArray.resize(2 * n_edges());
+                parallel_for(edges(), [&](Edge e) {
+                    edgeArray[2 * e.idx()] = vertex_offsets[vertex(e, 0).idx()];
+                    edgeArray[2 * e.idx() + 1] =
+                        vertex_offsets[vertex(e, 1).idx()];
+                });
+            }
+            else
+            {
+                edgeArray.reserve(2 * n_edges());
+                for (auto e : edges())
                 {
-                    tex_array.push_back(corner_texcoords[i0]);
-                    tex_array.push_back(corner_texcoords[i1]);
-                    tex_array.push_back(corner_texcoords[i2]);
+                    edgeArray.push_back(vertex_offsets[vertex(e, 0).idx()]);
+                    edgeArray.push_back(vertex_offsets[vertex(e, 1).idx()]);
                 }
+            }
 
-                if ((vcolor || fcolor) && use_colors_)
+            if (efeature)
+            {
+                for (auto e : edges())
                 {
-                    color_array.push_back(corner_colors[i0]);
-                    color_array.push_back(corner_colors[i1]);
-                    color_array.push_back(corner_colors[i2]);
+                    if (efeature[e])
+                    {
+                        features.push_back(vertex_offsets[vertex(e, 0).idx()]);
+                        features.push_back(vertex_offsets[vertex(e, 1).idx()]);
+                    }
                 }
-
-                vertex_indices[corner_vertices[i0]] = vidx++;
-                vertex_indices[corner_vertices[i1]] = vidx++;
-                vertex_indices[corner_vertices[i2]] = vidx++;
             }
-        }
+        };
+#ifdef __EMSCRIPTEN__
+        indices = std::async(std::launch::deferred, prepare_indices);
+#else
+        indices = std::async(std::launch::async, prepare_indices);
+#endif
+    }
 
-        // clean up
-        if (vnormals)
-            remove_vertex_property(vnormals);
-        if (fnormals)
-            remove_face_property(fnormals);
+    // we have deferred faces: fill arrays from their indices
+    else if (has_deferred_faces())
+    {
+        deferred_arrays(deferred_faces_, 0, IndexType(vertices_size()),
+                        position_array, normal_array, color_array, tex_array,
+                        edgeArray);
     }
 
     // we have a point cloud
@@ -413,35 +872,55 @@ void SurfaceMeshGL::update_opengl_buffers()
     {
         auto position = vertex_property<Point>("v:point");
         if (position)
-        {
-            position_array.reserve(n_vertices());
-            for (auto v : vertices())
-                position_array.push_back((vec3)position[v]);
-        }
+            vertex_values(*this, position, position_array);
 
         auto normals = get_vertex_property<Point>("v:normal");
         if (normals)
-        {
-            normal_array.reserve(n_vertices());
-            for (auto v : vertices())
-                normal_array.push_back((vec3)normals[v]);
-        }
+            vertex_values(*this, normals, normal_array);
 
         if (vcolor && use_colors_)
+            vertex_values(*this, vcolor, color_array);
+    }
+
+    // compress the attributes?
+    compressed_attributes_ = compress_attributes_;
+    position_offset_ = vec3(0, 0, 0);
+    position_scale_ = vec3(1, 1, 1);
+    if (compressed_attributes_)
+    {
+        vec3 bbmin = position_array.empty() ? vec3(0, 0, 0) : position_array[0];
+        vec3 bbmax = bbmin;
+        for (const auto& p : position_array)
         {
-            color_array.reserve(n_vertices());
-            for (auto v : vertices())
-                color_array.push_back((vec3)vcolor[v]);
+            bbmin = min(bbmin, p);
+            bbmax = max(bbmax, p);
         }
+        position_offset_ = bbmin;
+        position_scale_ = (bbmax - bbmin) / 65535.0f;
     }
+    const vec3 offset = position_offset_;
+    const vec3 scale = position_scale_;
 
     // upload vertices
     if (!position_array.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, position_array.size() * 3 * sizeof(float),
-                     position_array.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        if (compressed_attributes_)
+        {
+            upload_packed(vertex_buffer_, position_array,
+                          [&](const vec3& p) {
+                              return pack_position(p, offset, scale);
+                          });
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE,
+                                  sizeof(PackedPosition), nullptr);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+            glBufferData(GL_ARRAY_BUFFER,
+                         position_array.size() * 3 * sizeof(float),
+                         position_array.data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        }
         glEnableVertexAttribArray(0);
         n_vertices_ = position_array.size();
     }
@@ -451,20 +930,37 @@ void SurfaceMeshGL::update_opengl_buffers()
     // upload normals
     if (!normal_array.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, normal_array.size() * 3 * sizeof(float),
-                     normal_array.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        if (compressed_attributes_)
+        {
+            upload_packed(normal_buffer_, normal_array, pack_normal);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, 0, nullptr);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
+            glBufferData(GL_ARRAY_BUFFER,
+                         normal_array.size() * 3 * sizeof(float),
+                         normal_array.data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        }
         glEnableVertexAttribArray(1);
     }
 
     // upload texture coordinates
     if (!tex_array.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, tex_coord_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, tex_array.size() * 2 * sizeof(float),
-                     tex_array.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        if (compressed_attributes_)
+        {
+            upload_packed(tex_coord_buffer_, tex_array, pack_texcoord);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, 0, nullptr);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, tex_coord_buffer_);
+            glBufferData(GL_ARRAY_BUFFER, tex_array.size() * 2 * sizeof(float),
+                         tex_array.data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        }
         glEnableVertexAttribArray(2);
         has_texcoords_ = true;
     }
@@ -474,26 +970,51 @@ void SurfaceMeshGL::update_opengl_buffers()
     // upload colors of vertices
     if (!color_array.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, color_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, color_array.size() * 3 * sizeof(float),
-                     color_array.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        if (compressed_attributes_)
+        {
+            upload_packed(color_buffer_, color_array, pack_color);
+            glVertexAttribPointer(3, 3, GL_UNSIGNED_BYTE, GL_TRUE,
+                                  sizeof(PackedColor), nullptr);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, color_buffer_);
+            glBufferData(GL_ARRAY_BUFFER,
+                         color_array.size() * 3 * sizeof(float),
+                         color_array.data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        }
         glEnableVertexAttribArray(3);
         has_vertex_colors_ = true;
     }
     else
         has_vertex_colors_ = false;
 
-    // edge indices
-    if (n_edges())
+    // wait for the index arrays
+    if (indices.valid())
+        indices.get();
+
+    // upload triangle indices, or the arrays hold triangles unless we have
+    // a point cloud
+    if (!triangle_array.empty())
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     triangle_array.size() * sizeof(unsigned int),
+                     triangle_array.data(), GL_STATIC_DRAW);
+        n_triangles_ = triangle_array.size() / 3;
+        has_triangle_indices_ = true;
+    }
+    else
+    {
+        n_triangles_ = has_deferred_faces() ? n_vertices_ / 3 : 0;
+        has_triangle_indices_ = false;
+        meshlets_.clear();
+    }
+
+    // upload edge indices
+    if (!edgeArray.empty())
     {
-        std::vector<unsigned int> edgeArray;
-        edgeArray.reserve(n_edges());
-        for (auto e : edges())
-        {
-            edgeArray.push_back(vertex_indices[vertex(e, 0)]);
-            edgeArray.push_back(vertex_indices[vertex(e, 1)]);
-        }
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_buffer_);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,
                      edgeArray.size() * sizeof(unsigned int), edgeArray.data(),
@@ -503,21 +1024,9 @@ void SurfaceMeshGL::update_opengl_buffers()
     else
         n_edges_ = 0;
 
-    // feature edges
-    auto efeature = get_edge_property<bool>("e:feature");
-    if (efeature)
+    // upload feature edges
+    if (!features.empty())
     {
-        std::vector<unsigned int> features;
-
-        for (auto e : edges())
-        {
-            if (efeature[e])
-            {
-                features.push_back(vertex_indices[vertex(e, 0)]);
-                features.push_back(vertex_indices[vertex(e, 1)]);
-            }
-        }
-
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, feature_buffer_);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,
                      features.size() * sizeof(unsigned int), features.data(),
@@ -527,17 +1036,660 @@ void SurfaceMeshGL::update_opengl_buffers()
     else
         n_features_ = 0;
 
+    // record the size of the upload
+    uploaded_bytes_ = (triangle_array.size() + edgeArray.size() +
+                       features.size()) *
+                      sizeof(unsigned int);
+    if (compressed_attributes_)
+        uploaded_bytes_ += position_array.size() * sizeof(PackedPosition) +
+                           normal_array.size() * sizeof(PackedNormal) +
+                           tex_array.size() * sizeof(PackedTexCoord) +
+                           color_array.size() * sizeof(PackedColor);
+    else
+        uploaded_bytes_ += (position_array.size() + normal_array.size() +
+                            color_array.size()) *
+                               sizeof(vec3) +
+                           tex_array.size() * sizeof(vec2);
+
     // unbind vertex arry
     glBindVertexArray(0);
 
-    // remove vertex index property again
-    remove_vertex_property(vertex_indices);
+    // keep the arrays for partial updates
+    if (change_tracking() && has_triangle_indices_)
+    {
+        buffer_positions_ = std::move(position_array);
+        buffer_normals_ = std::move(normal_array);
+        buffer_triangles_ = std::move(triangle_array);
+        buffer_sources_ = buffer_sources();
+        record_buffer_generation();
+    }
+    else
+    {
+        std::vector<vec3>().swap(buffer_positions_);
+        std::vector<vec3>().swap(buffer_normals_);
+        std::vector<unsigned int>().swap(buffer_triangles_);
+        std::vector<unsigned int>().swap(corner_buffer_vertices_);
+        std::vector<unsigned int>().swap(face_triangles_);
+        std::vector<unsigned int>().swap(polygon_offsets_);
+        std::vector<ivec3>().swap(polygon_triangles_);
+    }
+}
+
+void SurfaceMeshGL::create_buffers()
+{
+    if (vertex_array_object_)
+        return;
+    glGenVertexArrays(1, &vertex_array_object_);
+    glBindVertexArray(vertex_array_object_);
+    glGenBuffers(1, &vertex_buffer_);
+    glGenBuffers(1, &color_buffer_);
+    glGenBuffers(1, &normal_buffer_);
+    glGenBuffers(1, &tex_coord_buffer_);
+    glGenBuffers(1, &triangle_buffer_);
+    glGenBuffers(1, &edge_buffer_);
+    glGenBuffers(1, &feature_buffer_);
+}
+
+unsigned int SurfaceMeshGL::buffer_sources() const
+{
+    unsigned int sources = 0;
+    if (get_halfedge_property<TexCoord>("h:tex"))
+        sources |= 1;
+    if (get_vertex_property<TexCoord>("v:tex"))
+        sources |= 2;
+    if (get_vertex_property<Color>("v:color") && use_colors_)
+        sources |= 4;
+    if (get_face_property<Color>("f:color") && use_colors_)
+        sources |= 8;
+    if (get_edge_property<bool>("e:feature"))
+        sources |= 16;
+    return sources;
+}
+
+void SurfaceMeshGL::record_buffer_generation()
+{
+    // the marker detects a replaced mesh, e.g., after assignment, since
+    // copies start with fresh stamps
+    buffer_generation_ = new_generation();
+    auto marker = object_property<uint64_t>(buffer_generation_name);
+    marker[0] = buffer_generation_;
+}
+
+bool SurfaceMeshGL::same_buffer_topology() const
+{
+    if (!change_tracking())
+        return false;
+
+    // the marker detects a replaced mesh
+    const uint64_t g = buffer_generation_;
+    const ObjectProperty<uint64_t> marker =
+        get_object_property<uint64_t>(buffer_generation_name);
+    return marker && marker.generation() != 0 && marker[0] == g &&
+           topology_generation() <= g;
+}
+
+std::vector<char> SurfaceMeshGL::reusable_tessellations() const
+{
+    std::vector<char> reuse;
+    if (polygon_offsets_.size() != faces_size() + 1 ||
+        !same_buffer_topology())
+        return reuse;
+
+    // polygons incident to moved vertices are tessellated again
+    reuse.assign(faces_size(), 1);
+    const VertexProperty<Point> vpos = get_vertex_property<Point>("v:point");
+    for (auto i : vpos.changed_since(buffer_generation_))
+    {
+        const Vertex v(static_cast<IndexType>(i));
+        if (is_deleted(v) || is_isolated(v))
+            continue;
+        for (auto f : faces(v))
+            reuse[f.idx()] = 0;
+    }
+    return reuse;
+}
+
+bool SurfaceMeshGL::update_moved_vertices()
+{
+    // partial updates need the layout of the previous full update
+    if (!vertex_array_object_ ||
+        compressed_attributes_ != compress_attributes_ ||
+        corner_buffer_vertices_.empty() ||
+        corner_buffer_vertices_.size() != halfedges_size() ||
+        face_triangles_.size() != faces_size())
+        return false;
+
+    // is it still the same mesh, with the same connectivity?
+    if (!same_buffer_topology())
+        return false;
+
+    // all attributes but the positions are unchanged?
+    const uint64_t g = buffer_generation_;
+    const VertexProperty<Point> vpos = get_vertex_property<Point>("v:point");
+    const auto vcolor = get_vertex_property<Color>("v:color");
+    const auto vtex = get_vertex_property<TexCoord>("v:tex");
+    const auto htex = get_halfedge_property<TexCoord>("h:tex");
+    const auto fcolor = get_face_property<Color>("f:color");
+    const auto efeature = get_edge_property<bool>("e:feature");
+    if (buffer_sources() != buffer_sources_ ||
+        (vcolor && vcolor.generation() > g) ||
+        (vtex && vtex.generation() > g) || (htex && htex.generation() > g) ||
+        (fcolor && fcolor.generation() > g) ||
+        (efeature && efeature.generation() > g))
+        return false;
+
+    // faces incident to moved vertices, and their vertices, whose normals
+    // change as well
+    std::vector<char> face_marks(faces_size(), 0);
+    std::vector<Face> moved_faces;
+    for (auto i : vpos.changed_since(g))
+    {
+        const Vertex v(static_cast<IndexType>(i));
+        if (is_deleted(v) || is_isolated(v))
+            continue;
+        for (auto f : faces(v))
+        {
+            if (!face_marks[f.idx()])
+            {
+                face_marks[f.idx()] = 1;
+                moved_faces.push_back(f);
+            }
+        }
+    }
+
+    std::vector<char> vertex_marks(vertices_size(), 0);
+    std::vector<Vertex> moved_vertices;
+    for (auto f : moved_faces)
+    {
+        for (auto v : vertices(f))
+        {
+            if (!vertex_marks[v.idx()])
+            {
+                vertex_marks[v.idx()] = 1;
+                moved_vertices.push_back(v);
+            }
+        }
+    }
+
+    // update positions and normals of the buffer vertices of all corners
+    const bool vertex_normals = crease_angle_ < 1 || crease_angle_ > 170;
+    const Scalar crease_angle_radians = crease_angle_ / 180.0 * M_PI;
+    std::vector<char> buffer_marks(buffer_positions_.size(), 0);
+    std::vector<size_t> moved_buffer_vertices;
+    for (auto v : moved_vertices)
+    {
+        const vec3 p = (vec3)vpos[v];
+
+        // compressed positions have to stay within the quantization box
+        if (compressed_attributes_)
+        {
+            const vec3 q = p - position_offset_;
+            for (int i = 0; i < 3; ++i)
+                if (q[i] < 0 || q[i] > 65535 * position_scale_[i])
+                    return false;
+        }
+        vec3 n;
+        if (vertex_normals)
+            n = (vec3)SurfaceNormals::compute_vertex_normal(*this, v);
+
+        for (auto h : halfedges(v))
+        {
+            const Halfedge c = opposite_halfedge(h);
+            if (is_boundary(c))
+                continue;
+            if (!vertex_normals)
+                n = (vec3)SurfaceNormals::compute_corner_normal(
+                    *this, c, crease_angle_radians);
+
+            const unsigned int idx = corner_buffer_vertices_[c.idx()];
+            if (buffer_marks[idx])
+            {
+                // corners sharing a vertex got different normals, the
+                // vertex has to be split
+                if (buffer_normals_[idx] != n)
+                    return false;
+                continue;
+            }
+            buffer_marks[idx] = 1;
+            buffer_positions_[idx] = p;
+            buffer_normals_[idx] = n;
+            moved_buffer_vertices.push_back(idx);
+        }
+    }
+    std::sort(moved_buffer_vertices.begin(), moved_buffer_vertices.end());
+
+    // re-tessellate moved polygons, keeping their number of triangles
+    std::vector<vec3> corner_positions;
+    std::vector<unsigned int> corner_indices;
+    std::vector<ivec3> triangles;
+    std::vector<size_t> moved_triangles;
+    for (auto f : moved_faces)
+    {
+        if (valence(f) == 3)
+            continue;
+
+        corner_positions.clear();
+        corner_indices.clear();
+        for (auto h : halfedges(f))
+        {
+            corner_positions.push_back((vec3)vpos[to_vertex(h)]);
+            corner_indices.push_back(corner_buffer_vertices_[h.idx()]);
+        }
+
+        tesselate(corner_positions, triangles);
+        if (!polygon_offsets_.empty())
+            std::copy(triangles.begin(), triangles.end(),
+                      polygon_triangles_.begin() + polygon_offsets_[f.idx()]);
+        size_t t = face_triangles_[f.idx()];
+        for (auto& triangle : triangles)
+        {
+            for (int k = 0; k < 3; ++k)
+                buffer_triangles_[3 * t + k] = corner_indices[triangle[k]];
+            moved_triangles.push_back(t++);
+        }
+    }
+    std::sort(moved_triangles.begin(), moved_triangles.end());
+
+    // update the bounds of meshlets with moved faces
+    std::vector<size_t> moved_meshlets;
+    for (auto f : moved_faces)
+    {
+        const size_t first = face_triangles_[f.idx()];
+        const size_t last = first + valence(f) - 3;
+        for (size_t m = first / meshlet_triangles;
+             m <= last / meshlet_triangles; ++m)
+            moved_meshlets.push_back(m);
+    }
+    std::sort(moved_meshlets.begin(), moved_meshlets.end());
+    moved_meshlets.erase(
+        std::unique(moved_meshlets.begin(), moved_meshlets.end()),
+        moved_meshlets.end());
+    for (auto m : moved_meshlets)
+        update_meshlet(meshlets_[m], buffer_positions_, buffer_triangles_);
+
+    // upload the changed ranges
+    glBindVertexArray(vertex_array_object_);
+    uploaded_bytes_ = 0;
+    if (compressed_attributes_)
+    {
+        const vec3 offset = position_offset_;
+        const vec3 scale = position_scale_;
+        std::vector<PackedPosition> positions;
+        std::vector<PackedNormal> normals;
+        uploaded_bytes_ += upload_ranges(GL_ARRAY_BUFFER, vertex_buffer_, sizeof(PackedPosition),
+                      moved_buffer_vertices, [&](size_t first, size_t count) {
+                          positions.resize(count);
+                          for (size_t i = 0; i < count; ++i)
+                              positions[i] =
+                                  pack_position(buffer_positions_[first + i],
+                                                offset, scale);
+                          return positions.data();
+                      });
+        uploaded_bytes_ += upload_ranges(GL_ARRAY_BUFFER, normal_buffer_, sizeof(PackedNormal),
+                      moved_buffer_vertices, [&](size_t first, size_t count) {
+                          normals.resize(count);
+                          for (size_t i = 0; i < count; ++i)
+                              normals[i] =
+                                  pack_normal(buffer_normals_[first + i]);
+                          return normals.data();
+                      });
+    }
+    else
+    {
+        uploaded_bytes_ += upload_ranges(GL_ARRAY_BUFFER, vertex_buffer_, sizeof(vec3),
+                      moved_buffer_vertices, [&](size_t first, size_t) {
+                          return &buffer_positions_[first];
+                      });
+        uploaded_bytes_ += upload_ranges(GL_ARRAY_BUFFER, normal_buffer_, sizeof(vec3),
+                      moved_buffer_vertices, [&](size_t first, size_t) {
+                          return &buffer_normals_[first];
+                      });
+    }
+    uploaded_bytes_ += upload_ranges(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_,
+                  3 * sizeof(unsigned int), moved_triangles,
+                  [&](size_t first, size_t) {
+                      return &buffer_triangles_[3 * first];
+                  });
+    glBindVertexArray(0);
+
+    record_buffer_generation();
+    return true;
+}
+
+void SurfaceMeshGL::set_deferred_faces(IndexedFaces faces)
+{
+    for (auto idx : faces.indices)
+        if (idx >= vertices_size())
+            throw InvalidInputException(
+                "SurfaceMeshGL: Deferred face index out of range.");
+    deferred_faces_ = std::move(faces);
+
+    // appending starts over with these faces
+    appended_vertex_capacity_ = 0;
+    appended_edge_capacity_ = 0;
+}
+
+void SurfaceMeshGL::build_connectivity()
+{
+    if (!has_deferred_faces())
+        return;
+    SurfaceMeshIO::add_faces(*this, deferred_faces_);
+    deferred_faces_ = IndexedFaces();
+}
+
+void SurfaceMeshGL::append_deferred_faces(const IndexedFaces& faces)
+{
+    if (n_faces())
+        throw InvalidInputException(
+            "SurfaceMeshGL: Cannot append faces to a mesh with connectivity.");
+    if (faces.empty())
+        return;
+
+    // the range of referenced vertices, which is narrow for streaming meshes
+    IndexType first = PMP_MAX_INDEX;
+    IndexType end = 0;
+    for (auto idx : faces.indices)
+    {
+        first = std::min(first, idx);
+        end = std::max(end, idx + 1);
+    }
+    if (end > vertices_size())
+        throw InvalidInputException(
+            "SurfaceMeshGL: Deferred face index out of range.");
+
+    // after a full update, upload the previous deferred faces as well
+    std::vector<vec3> positions, normals, colors;
+    std::vector<vec2> texcoords;
+    std::vector<unsigned int> edges;
+    const bool start = appended_vertex_capacity_ == 0;
+    if (start)
+    {
+        clear_subdivision();
+        n_vertices_ = 0;
+        n_edges_ = 0;
+        if (has_deferred_faces())
+        {
+            first = 0;
+            end = IndexType(vertices_size());
+        }
+    }
+
+    // append the faces, listing sizes if either has polygons
+    const size_t n_previous = deferred_faces_.size();
+    auto& sizes = deferred_faces_.face_sizes;
+    if (sizes.empty() && !faces.face_sizes.empty())
+        sizes.assign(n_previous, 3);
+    if (!sizes.empty() && faces.face_sizes.empty())
+        sizes.insert(sizes.end(), faces.size(), 3);
+    else
+        sizes.insert(sizes.end(), faces.face_sizes.begin(),
+                     faces.face_sizes.end());
+    deferred_faces_.indices.insert(deferred_faces_.indices.end(),
+                                   faces.indices.begin(), faces.indices.end());
+
+    deferred_arrays(start ? deferred_faces_ : faces, first, end, positions,
+                    normals, colors, texcoords, edges);
+    for (auto& e : edges)
+        e += n_vertices_;
+
+    create_buffers();
+    glBindVertexArray(vertex_array_object_);
+
+    // grow the vertex buffers together and point the attributes to them
+    const size_t n_used = n_vertices_;
+    const size_t n_vertices = n_used + positions.size();
+    if (n_vertices > appended_vertex_capacity_)
+    {
+        const size_t capacity =
+            std::max(n_vertices, 2 * appended_vertex_capacity_);
+        grow_buffer(vertex_buffer_, n_used * sizeof(vec3),
+                    capacity * sizeof(vec3));
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glEnableVertexAttribArray(0);
+
+        grow_buffer(normal_buffer_, n_used * sizeof(vec3),
+                    capacity * sizeof(vec3));
+        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glEnableVertexAttribArray(1);
+
+        if (!texcoords.empty())
+        {
+            grow_buffer(tex_coord_buffer_, n_used * sizeof(vec2),
+                        capacity * sizeof(vec2));
+            glBindBuffer(GL_ARRAY_BUFFER, tex_coord_buffer_);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+            glEnableVertexAttribArray(2);
+        }
+        if (!colors.empty())
+        {
+            grow_buffer(color_buffer_, n_used * sizeof(vec3),
+                        capacity * sizeof(vec3));
+            glBindBuffer(GL_ARRAY_BUFFER, color_buffer_);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            glEnableVertexAttribArray(3);
+        }
+        appended_vertex_capacity_ = capacity;
+    }
+
+    // upload the new elements behind the used ones
+    uploaded_bytes_ = 0;
+    auto append = [&](GLenum target, GLuint buffer, size_t offset,
+                      size_t bytes, const void* data) {
+        glBindBuffer(target, buffer);
+        glBufferSubData(target, offset, bytes, data);
+        uploaded_bytes_ += bytes;
+    };
+    append(GL_ARRAY_BUFFER, vertex_buffer_, n_used * sizeof(vec3),
+           positions.size() * sizeof(vec3), positions.data());
+    append(GL_ARRAY_BUFFER, normal_buffer_, n_used * sizeof(vec3),
+           normals.size() * sizeof(vec3), normals.data());
+    if (!texcoords.empty())
+        append(GL_ARRAY_BUFFER, tex_coord_buffer_, n_used * sizeof(vec2),
+               texcoords.size() * sizeof(vec2), texcoords.data());
+    if (!colors.empty())
+        append(GL_ARRAY_BUFFER, color_buffer_, n_used * sizeof(vec3),
+               colors.size() * sizeof(vec3), colors.data());
+
+    const size_t n_edges = n_edges_ + edges.size();
+    if (n_edges > appended_edge_capacity_)
+    {
+        const size_t capacity = std::max(n_edges, 2 * appended_edge_capacity_);
+        grow_buffer(edge_buffer_, n_edges_ * sizeof(unsigned int),
+                    capacity * sizeof(unsigned int));
+        appended_edge_capacity_ = capacity;
+    }
+    append(GL_ELEMENT_ARRAY_BUFFER, edge_buffer_,
+           n_edges_ * sizeof(unsigned int), edges.size() * sizeof(unsigned int),
+           edges.data());
+    glBindVertexArray(0);
+
+    // the arrays hold triangles, see update_opengl_buffers()
+    n_vertices_ = GLsizei(n_vertices);
+    n_triangles_ = n_vertices_ / 3;
+    n_edges_ = GLsizei(n_edges);
+    n_features_ = 0;
+    has_texcoords_ = !texcoords.empty();
+    has_vertex_colors_ = !colors.empty();
+    has_triangle_indices_ = false;
+    meshlets_.clear();
+    compressed_attributes_ = false;
+    position_offset_ = vec3(0, 0, 0);
+    position_scale_ = vec3(1, 1, 1);
+    if (start)
+    {
+        std::vector<vec3>().swap(buffer_positions_);
+        std::vector<vec3>().swap(buffer_normals_);
+        std::vector<unsigned int>().swap(buffer_triangles_);
+        std::vector<unsigned int>().swap(corner_buffer_vertices_);
+        std::vector<unsigned int>().swap(face_triangles_);
+        std::vector<unsigned int>().swap(polygon_offsets_);
+        std::vector<ivec3>().swap(polygon_triangles_);
+    }
+}
+
+void SurfaceMeshGL::deferred_arrays(const IndexedFaces& faces,
+                                    IndexType first_vertex,
+                                    IndexType end_vertex,
+                                    std::vector<vec3>& positions,
+                                    std::vector<vec3>& normals,
+                                    std::vector<vec3>& colors,
+                                    std::vector<vec2>& texcoords,
+                                    std::vector<unsigned int>& edges)
+{
+    const auto& indices = faces.indices;
+    const auto& sizes = faces.face_sizes;
+    const size_t nf = faces.size();
+    const size_t nc = indices.size();
+    const size_t nv = end_vertex - first_vertex;
+
+    auto vpos = get_vertex_property<Point>("v:point");
+    auto vcolor = get_vertex_property<Color>("v:color");
+    auto vtex = get_vertex_property<TexCoord>("v:tex");
+
+    // first corner of each face and face of each corner
+    std::vector<size_t> offsets(nf + 1, 0);
+    for (size_t f = 0; f < nf; ++f)
+        offsets[f + 1] = offsets[f] + (sizes.empty() ? 3 : sizes[f]);
+    std::vector<size_t> corner_face(nc);
+    for (size_t f = 0; f < nf; ++f)
+        std::fill(corner_face.begin() + offsets[f],
+                  corner_face.begin() + offsets[f + 1], f);
+
+    // face normals and corner angles
+    std::vector<Normal> face_normals(nf);
+    std::vector<Scalar> angles(nc);
+    parallel_for(0, int(nf), [&](int f) {
+        const size_t begin = offsets[f];
+        const size_t n = offsets[f + 1] - begin;
+        const Point& p0 = vpos[Vertex(indices[begin])];
+        Normal sum(0, 0, 0);
+        for (size_t j = 0; j < n; ++j)
+        {
+            const Point& p = vpos[Vertex(indices[begin + j])];
+            const Point& q = vpos[Vertex(indices[begin + (j + 1) % n])];
+            const Point& r = vpos[Vertex(indices[begin + (j + n - 1) % n])];
+            sum += cross(p - p0, q - p0);
+            const Point d0 = q - p;
+            const Point d1 = r - p;
+            angles[begin + j] = std::atan2(norm(cross(d0, d1)), dot(d0, d1));
+        }
+        const Scalar l = norm(sum);
+        face_normals[f] = l > std::numeric_limits<Scalar>::min()
+                              ? Normal(sum / l)
+                              : Normal(0, 0, 0);
+    });
+
+    // corners of each vertex
+    std::vector<size_t> vertex_offsets(nv + 1, 0);
+    for (auto idx : indices)
+        ++vertex_offsets[idx - first_vertex + 1];
+    for (size_t v = 0; v < nv; ++v)
+        vertex_offsets[v + 1] += vertex_offsets[v];
+    std::vector<size_t> vertex_corners(nc);
+    {
+        std::vector<size_t> next(vertex_offsets.begin(),
+                                 vertex_offsets.end() - 1);
+        for (size_t c = 0; c < nc; ++c)
+            vertex_corners[next[indices[c] - first_vertex]++] = c;
+    }
+
+    // corner normals, averaging the angle-weighted normals of the faces
+    // around the vertex within the crease angle
+    std::vector<vec3> corner_normals(nc);
+    const Scalar cos_crease = std::cos(crease_angle_ / 180.0 * M_PI);
+    parallel_for(0, int(nc), [&](int c) {
+        const Normal& fn = face_normals[corner_face[c]];
+        Normal n = fn;
+        if (crease_angle_ >= 1)
+        {
+            Normal sum(0, 0, 0);
+            const IndexType v = indices[c] - first_vertex;
+            for (size_t k = vertex_offsets[v]; k < vertex_offsets[v + 1]; ++k)
+            {
+                const size_t d = vertex_corners[k];
+                const Normal& ng = face_normals[corner_face[d]];
+                if (crease_angle_ > 170 || dot(fn, ng) >= cos_crease)
+                    sum += angles[d] * ng;
+            }
+            const Scalar l = norm(sum);
+            if (l > std::numeric_limits<Scalar>::min())
+                n = sum / l;
+        }
+        corner_normals[c] = (vec3)n;
+    });
+
+    // triangulate the faces, duplicating vertices for flat shading
+    const size_t n_triangles = nc - 2 * nf;
+    positions.reserve(3 * n_triangles);
+    normals.reserve(3 * n_triangles);
+    if (vtex)
+        texcoords.reserve(3 * n_triangles);
+    if (vcolor && use_colors_)
+        colors.reserve(3 * n_triangles);
+
+    std::vector<unsigned int> vertex_index(nv, 0);
+    std::vector<vec3> corner_positions;
+    std::vector<ivec3> triangles;
+    for (size_t f = 0; f < nf; ++f)
+    {
+        const size_t begin = offsets[f];
+        corner_positions.clear();
+        for (size_t c = begin; c < offsets[f + 1]; ++c)
+            corner_positions.push_back((vec3)vpos[Vertex(indices[c])]);
+
+        tesselate(corner_positions, triangles);
+        for (auto& t : triangles)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const size_t c = begin + t[k];
+                const Vertex v(indices[c]);
+                vertex_index[v.idx() - first_vertex] =
+                    (unsigned int)positions.size();
+                positions.push_back(corner_positions[t[k]]);
+                normals.push_back(corner_normals[c]);
+                if (vtex)
+                    texcoords.push_back((vec2)vtex[v]);
+                if (vcolor && use_colors_)
+                    colors.push_back((vec3)vcolor[v]);
+            }
+        }
+    }
+
+    // unique edges of the faces
+    std::vector<std::pair<IndexType, IndexType>> face_edges;
+    face_edges.reserve(nc);
+    for (size_t f = 0; f < nf; ++f)
+    {
+        const size_t begin = offsets[f];
+        const size_t n = offsets[f + 1] - begin;
+        for (size_t j = 0; j < n; ++j)
+        {
+            const IndexType a = indices[begin + j];
+            const IndexType b = indices[begin + (j + 1) % n];
+            face_edges.emplace_back(std::min(a, b), std::max(a, b));
+        }
+    }
+    std::sort(face_edges.begin(), face_edges.end());
+    face_edges.erase(std::unique(face_edges.begin(), face_edges.end()),
+                     face_edges.end());
+
+    edges.reserve(2 * face_edges.size());
+    for (const auto& e : face_edges)
+    {
+        edges.push_back(vertex_index[e.first - first_vertex]);
+        edges.push_back(vertex_index[e.second - first_vertex]);
+    }
 }
 
 void SurfaceMeshGL::draw(const mat4& projection_matrix,
                          const mat4& modelview_matrix,
                          const std::string draw_mode)
 {
+    drawn_triangles_ = 0;
+
     // did we generate buffers already?
     if (!vertex_array_object_)
     {
@@ -571,11 +1723,29 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
     // allow for transparent objects
     glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
 
+    // evaluate the limit surface before the shader is set up
+    if (draw_mode == "Subdivision Surface")
+        update_subdivision();
+
     // setup matrices
     mat4 mv_matrix = modelview_matrix;
     mat4 mvp_matrix = projection_matrix * modelview_matrix;
     mat3 n_matrix = inverse(transpose(linear_part(mv_matrix)));
 
+    // indexed triangles share the vertices of faces, compute their normals
+    // in the shader for flat shading
+    const bool flat_shading = has_triangle_indices_ && crease_angle_ < 1;
+
+    // skip invisible meshlets, the eye is the origin of the view
+    // coordinates. instances are culled as a whole.
+    if (has_triangle_indices_ && instances_.empty())
+    {
+        const mat4 inv_mv_matrix = inverse(mv_matrix);
+        cull_meshlets(mvp_matrix, vec3(inv_mv_matrix(0, 3),
+                                       inv_mv_matrix(1, 3),
+                                       inv_mv_matrix(2, 3)));
+    }
+
     // setup shader
     phong_shader_.use();
     phong_shader_.set_uniform("modelview_projection_matrix", mvp_matrix);
@@ -596,24 +1766,31 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
     phong_shader_.set_uniform("use_srgb", false);
     phong_shader_.set_uniform("show_texture_layout", false);
     phong_shader_.set_uniform("use_vertex_color", has_vertex_colors_);
+    phong_shader_.set_uniform("use_flat_shading", flat_shading);
+    phong_shader_.set_uniform("position_offset", position_offset_);
+    phong_shader_.set_uniform("position_scale", position_scale_);
+    phong_shader_.set_uniform("use_octahedral_normals",
+                              compressed_attributes_);
+    phong_shader_.set_uniform("use_instances", !instances_.empty());
 
     glBindVertexArray(vertex_array_object_);
+    update_instances(mvp_matrix);
 
     if (draw_mode == "Points")
     {
 #ifndef __EMSCRIPTEN__
         glEnable(GL_PROGRAM_POINT_SIZE);
 #endif
-        glDrawArrays(GL_POINTS, 0, n_vertices_);
+        draw_arrays(GL_POINTS, n_vertices_);
     }
 
     else if (draw_mode == "Hidden Line")
     {
-        if (n_faces())
+        if (n_triangles_)
         {
             // draw faces
             glDepthRange(0.01, 1.0);
-            glDrawArrays(GL_TRIANGLES, 0, n_vertices_);
+            draw_triangles();
             glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
 
             // overlay edges
@@ -624,32 +1801,70 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
             phong_shader_.set_uniform("use_lighting", false);
             phong_shader_.set_uniform("use_vertex_color", false);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_buffer_);
-            glDrawElements(GL_LINES, n_edges_, GL_UNSIGNED_INT, nullptr);
+            draw_elements(GL_LINES, n_edges_);
             glDepthFunc(GL_LESS);
         }
     }
 
     else if (draw_mode == "Smooth Shading")
     {
-        if (n_faces())
+        if (n_triangles_)
         {
-            glDrawArrays(GL_TRIANGLES, 0, n_vertices_);
+            draw_triangles();
         }
     }
 
+    else if (draw_mode == "Subdivision Surface")
+    {
+#ifndef __EMSCRIPTEN__
+        if (subdivision_)
+        {
+            // the limit surface has plain positions and smooth normals
+            phong_shader_.set_uniform("use_vertex_color", false);
+            phong_shader_.set_uniform("use_flat_shading", false);
+            phong_shader_.set_uniform("position_offset", vec3(0, 0, 0));
+            phong_shader_.set_uniform("position_scale", vec3(1, 1, 1));
+            phong_shader_.set_uniform("use_octahedral_normals", false);
+            phong_shader_.set_uniform("use_instances", false);
+            subdivision_->draw();
+            drawn_triangles_ += subdivision_->n_triangles();
+
+            // restore the state for the feature edges
+            glBindVertexArray(vertex_array_object_);
+            phong_shader_.set_uniform("position_offset", position_offset_);
+            phong_shader_.set_uniform("position_scale", position_scale_);
+            phong_shader_.set_uniform("use_instances", !instances_.empty());
+        }
+#else
+        if (n_triangles_)
+        {
+            draw_triangles();
+        }
+#endif
+    }
+
     else if (draw_mode == "Texture")
     {
-        if (n_faces())
+        if (n_triangles_)
         {
             if (texture_mode_ == MatCapTexture)
             {
                 matcap_shader_.use();
                 matcap_shader_.set_uniform("modelview_projection_matrix",
                                            mvp_matrix);
+                matcap_shader_.set_uniform("modelview_matrix", mv_matrix);
                 matcap_shader_.set_uniform("normal_matrix", n_matrix);
+                matcap_shader_.set_uniform("use_flat_shading", flat_shading);
+                matcap_shader_.set_uniform("position_offset",
+                                           position_offset_);
+                matcap_shader_.set_uniform("position_scale", position_scale_);
+                matcap_shader_.set_uniform("use_octahedral_normals",
+                                           compressed_attributes_);
+                matcap_shader_.set_uniform("use_instances",
+                                           !instances_.empty());
                 matcap_shader_.set_uniform("alpha", alpha_);
                 glBindTexture(GL_TEXTURE_2D, texture_);
-                glDrawArrays(GL_TRIANGLES, 0, n_vertices_);
+                draw_triangles();
             }
             else
             {
@@ -659,14 +1874,14 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
                 phong_shader_.set_uniform("use_vertex_color", false);
                 phong_shader_.set_uniform("use_srgb", srgb_);
                 glBindTexture(GL_TEXTURE_2D, texture_);
-                glDrawArrays(GL_TRIANGLES, 0, n_vertices_);
+                draw_triangles();
             }
         }
     }
 
     else if (draw_mode == "Texture Layout")
     {
-        if (n_faces() && has_texcoords_)
+        if (n_triangles_ && has_texcoords_)
         {
             phong_shader_.set_uniform("show_texture_layout", true);
             phong_shader_.set_uniform("use_vertex_color", false);
@@ -676,7 +1891,7 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
             phong_shader_.set_uniform("front_color", vec3(0.8, 0.8, 0.8));
             phong_shader_.set_uniform("back_color", vec3(0.9, 0.0, 0.0));
             glDepthRange(0.01, 1.0);
-            glDrawArrays(GL_TRIANGLES, 0, n_vertices_);
+            draw_triangles(false);
 
             // overlay edges
             glDepthRange(0.0, 1.0);
@@ -684,7 +1899,7 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
             phong_shader_.set_uniform("front_color", vec3(0.1, 0.1, 0.1));
             phong_shader_.set_uniform("back_color", vec3(0.1, 0.1, 0.1));
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_buffer_);
-            glDrawElements(GL_LINES, n_edges_, GL_UNSIGNED_INT, nullptr);
+            draw_elements(GL_LINES, n_edges_);
             glDepthFunc(GL_LESS);
         }
     }
@@ -699,7 +1914,7 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
         glDepthRange(0.0, 1.0);
         glDepthFunc(GL_LEQUAL);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, feature_buffer_);
-        glDrawElements(GL_LINES, n_features_, GL_UNSIGNED_INT, nullptr);
+        draw_elements(GL_LINES, n_features_);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         glDepthFunc(GL_LESS);
     }
@@ -711,42 +1926,325 @@ void SurfaceMeshGL::draw(const mat4& projection_matrix,
     glCheckError();
 }
 
-void SurfaceMeshGL::tesselate(const std::vector<vec3>& points,
-                              std::vector<ivec3>& triangles)
+void SurfaceMeshGL::set_subdivision_levels(unsigned int levels)
 {
-    const int n = points.size();
+    if (levels != subdivision_levels_)
+    {
+        subdivision_levels_ = levels;
+        clear_subdivision();
+    }
+}
 
-    triangles.clear();
-    triangles.reserve(n - 2);
+void SurfaceMeshGL::update_subdivision()
+{
+#ifndef __EMSCRIPTEN__
+    if (!n_faces() || has_deferred_faces())
+        return;
 
-    // triangle? nothing to do
-    if (n == 3)
+    if (!subdivision_)
     {
-        triangles.push_back(ivec3(0, 1, 2));
+        subdivision_ = new SubdivisionSurfaceGL(*this, subdivision_levels_);
+        subdivision_outdated_ = true;
+    }
+    if (subdivision_outdated_)
+    {
+        subdivision_->evaluate(*this);
+        subdivision_outdated_ = false;
+    }
+#endif
+}
+
+void SurfaceMeshGL::clear_subdivision()
+{
+#ifndef __EMSCRIPTEN__
+    delete subdivision_;
+#endif
+    subdivision_ = nullptr;
+}
+
+void SurfaceMeshGL::set_instances(std::vector<mat4> transforms)
+{
+    instances_ = std::move(transforms);
+    visible_instances_.clear();
+    upload_instances_ = true;
+}
+
+void SurfaceMeshGL::update_instances(const mat4& mvp)
+{
+    // the instance transforms are a matrix attribute taking four locations
+    // with one column each, advancing once per instance
+    if (instances_.empty())
+    {
+        if (instance_buffer_)
+        {
+            for (GLuint i = 0; i < 4; ++i)
+                glDisableVertexAttribArray(4 + i);
+            glDeleteBuffers(1, &instance_buffer_);
+            instance_buffer_ = 0;
+        }
         return;
     }
+    if (!instance_buffer_)
+    {
+        glGenBuffers(1, &instance_buffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+        for (GLuint i = 0; i < 4; ++i)
+        {
+            glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                                  (const void*)(i * sizeof(vec4)));
+            glEnableVertexAttribArray(4 + i);
+            glVertexAttribDivisor(4 + i, 1);
+        }
+        upload_instances_ = true;
+    }
 
-    // quad? simply compare to two options
-    else if (n == 4)
+    // bounding sphere of the mesh from the spheres of its meshlets, all
+    // instances are drawn without meshlets
+    vec3 center(0, 0, 0);
+    float radius = -1;
+    if (!meshlets_.empty())
     {
-        if (area(points[0], points[1], points[2]) +
-                area(points[0], points[2], points[3]) <
-            area(points[0], points[1], points[3]) +
-                area(points[1], points[2], points[3]))
+        vec3 bb_min = meshlets_[0].center;
+        vec3 bb_max = bb_min;
+        for (const auto& m : meshlets_)
         {
-            triangles.push_back(ivec3(0, 1, 2));
-            triangles.push_back(ivec3(0, 2, 3));
+            const vec3 r(m.radius, m.radius, m.radius);
+            bb_min = min(bb_min, m.center - r);
+            bb_max = max(bb_max, m.center + r);
         }
-        else
+        center = 0.5f * (bb_min + bb_max);
+        radius = 0;
+        for (const auto& m : meshlets_)
+            radius = std::max(radius, distance(m.center, center) + m.radius);
+    }
+
+    // instances with the transformed sphere inside the frustum are visible
+    vec4 planes[6];
+    frustum_planes(mvp, planes);
+    std::vector<unsigned int> visible;
+    visible.reserve(instances_.size());
+    for (size_t i = 0; i < instances_.size(); ++i)
+    {
+        const mat4& t = instances_[i];
+        bool is_visible = true;
+        if (radius >= 0)
         {
-            triangles.push_back(ivec3(0, 1, 3));
-            triangles.push_back(ivec3(1, 2, 3));
+            const vec3 c = affine_transform(t, center);
+            float scale = 0;
+            for (int j = 0; j < 3; ++j)
+                scale = std::max(scale, norm(vec3(t(0, j), t(1, j), t(2, j))));
+            for (const auto& p : planes)
+            {
+                if (p[0] * c[0] + p[1] * c[1] + p[2] * c[2] + p[3] <
+                    -scale * radius)
+                {
+                    is_visible = false;
+                    break;
+                }
+            }
         }
+        if (is_visible)
+            visible.push_back((unsigned int)i);
+    }
+
+    // upload only if the visible instances changed
+    if (!upload_instances_ && visible == visible_instances_)
         return;
+    visible_instances_.swap(visible);
+    upload_instances_ = false;
+    std::vector<mat4> transforms;
+    transforms.reserve(visible_instances_.size());
+    for (auto i : visible_instances_)
+        transforms.push_back(instances_[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(mat4),
+                 transforms.data(), GL_DYNAMIC_DRAW);
+}
+
+void SurfaceMeshGL::draw_elements(GLenum mode, GLsizei count,
+                                  const void* offset)
+{
+    if (instances_.empty())
+        glDrawElements(mode, count, GL_UNSIGNED_INT, offset);
+    else if (!visible_instances_.empty())
+        glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, offset,
+                                GLsizei(visible_instances_.size()));
+}
+
+void SurfaceMeshGL::draw_arrays(GLenum mode, GLsizei count)
+{
+    if (instances_.empty())
+        glDrawArrays(mode, 0, count);
+    else if (!visible_instances_.empty())
+        glDrawArraysInstanced(mode, 0, count,
+                              GLsizei(visible_instances_.size()));
+}
+
+void SurfaceMeshGL::draw_triangles(bool cull)
+{
+    // meshlets are culled for single meshes only
+    const size_t n_instances =
+        instances_.empty() ? 1 : visible_instances_.size();
+
+    if (has_triangle_indices_ && cull && !meshlets_.empty() &&
+        instances_.empty())
+    {
+        for (auto count : draw_counts_)
+            drawn_triangles_ += count / 3;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+#ifdef __EMSCRIPTEN__
+        for (size_t i = 0; i < draw_counts_.size(); ++i)
+            glDrawElements(GL_TRIANGLES, draw_counts_[i], GL_UNSIGNED_INT,
+                           draw_offsets_[i]);
+#else
+        glMultiDrawElements(GL_TRIANGLES, draw_counts_.data(),
+                            GL_UNSIGNED_INT, draw_offsets_.data(),
+                            GLsizei(draw_counts_.size()));
+#endif
+    }
+    else if (has_triangle_indices_)
+    {
+        drawn_triangles_ += n_instances * n_triangles_;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+        draw_elements(GL_TRIANGLES, 3 * n_triangles_);
+    }
+    else
+    {
+        drawn_triangles_ += n_instances * (n_vertices_ / 3);
+        draw_arrays(GL_TRIANGLES, n_vertices_);
+    }
+}
+
+void SurfaceMeshGL::build_meshlets(const std::vector<vec3>& positions,
+                                   const std::vector<unsigned int>& triangles)
+{
+    const size_t n_indices = 3 * size_t(meshlet_triangles);
+    const int n = int((triangles.size() + n_indices - 1) / n_indices);
+    meshlets_.resize(n);
+
+    parallel_for(
+        0, n,
+        [&](int i) {
+            Meshlet& m = meshlets_[i];
+            m.first = (unsigned int)(i * n_indices);
+            m.count =
+                (unsigned int)std::min(n_indices, triangles.size() - m.first);
+            update_meshlet(m, positions, triangles);
+        },
+        16);
+}
+
+void SurfaceMeshGL::update_meshlet(
+    Meshlet& m, const std::vector<vec3>& positions,
+    const std::vector<unsigned int>& triangles) const
+{
+    const unsigned int* indices = triangles.data() + m.first;
+
+    // bounding sphere around the center of the bounding box
+    vec3 bmin(std::numeric_limits<float>::max());
+    vec3 bmax(-std::numeric_limits<float>::max());
+    for (unsigned int i = 0; i < m.count; ++i)
+    {
+        bmin = min(bmin, positions[indices[i]]);
+        bmax = max(bmax, positions[indices[i]]);
+    }
+    m.center = 0.5f * (bmin + bmax);
+    float r2 = 0;
+    for (unsigned int i = 0; i < m.count; ++i)
+        r2 = std::max(r2, sqrnorm(positions[indices[i]] - m.center));
+    m.radius = std::sqrt(r2);
+
+    // cone around the average triangle normal
+    std::vector<vec3> normals;
+    normals.reserve(m.count / 3);
+    vec3 axis(0, 0, 0);
+    for (unsigned int i = 0; i + 2 < m.count; i += 3)
+    {
+        const vec3& p0 = positions[indices[i]];
+        const vec3 n = cross(positions[indices[i + 1]] - p0,
+                             positions[indices[i + 2]] - p0);
+        const float l = norm(n);
+        if (l > std::numeric_limits<float>::min())
+        {
+            normals.push_back(n / l);
+            axis += normals.back();
+        }
+    }
+    const float l = norm(axis);
+    float min_dot = l > std::numeric_limits<float>::min() ? 1.0f : -1.0f;
+    m.cone_axis = min_dot > 0 ? vec3(axis / l) : vec3(0, 0, 1);
+    for (const auto& n : normals)
+        min_dot = std::min(min_dot, dot(n, m.cone_axis));
+
+    // normals spread too much for culling
+    m.cone_cutoff = min_dot > 0.1f ? std::sqrt(1.0f - min_dot * min_dot) : 2.0f;
+}
+
+void SurfaceMeshGL::cull_meshlets(const mat4& mvp, const vec3& eye)
+{
+    vec4 planes[6];
+    frustum_planes(mvp, planes);
+
+    // backfacing meshlets are only hidden by closed opaque meshes
+    const bool cull_backfacing = cull_backfacing_ && alpha_ >= 1;
+
+    draw_counts_.clear();
+    draw_offsets_.clear();
+    unsigned int next_first = 0;
+    for (const auto& m : meshlets_)
+    {
+        bool visible = true;
+        for (const auto& p : planes)
+        {
+            if (p[0] * m.center[0] + p[1] * m.center[1] + p[2] * m.center[2] +
+                    p[3] <
+                -m.radius)
+            {
+                visible = false;
+                break;
+            }
+        }
+
+        if (visible && cull_backfacing && m.cone_cutoff <= 1)
+        {
+            const vec3 d = m.center - eye;
+            if (dot(d, m.cone_axis) >= m.cone_cutoff * norm(d) + m.radius)
+                visible = false;
+        }
+
+        if (!visible)
+            continue;
+
+        // merge with the previous range if adjacent
+        if (!draw_counts_.empty() && m.first == next_first)
+        {
+            draw_counts_.back() += m.count;
+        }
+        else
+        {
+            draw_counts_.push_back(m.count);
+            draw_offsets_.push_back(reinterpret_cast<const void*>(
+                sizeof(unsigned int) * size_t(m.first)));
+        }
+        next_first = m.first + m.count;
     }
+}
+
+void SurfaceMeshGL::tesselate(const std::vector<vec3>& points,
+                              std::vector<ivec3>& triangles)
+{
+    // triangles, quads, and convex polygons are easy
+    if (tesselate_convex(points, triangles))
+        return;
 
-    // n-gon with n>4? compute triangulation by dynamic programming
+    const int n = points.size();
+    triangles.clear();
+    triangles.reserve(n - 2);
+
+    // non-convex n-gon with n>4? compute triangulation by dynamic
+    // programming
     init_triangulation(n);
+
     int i, j, m, k, imin;
     Scalar w, wmin;
 
@@ -806,4 +2304,60 @@ void SurfaceMeshGL::tesselate(const std::vector<vec3>& points,
     }
 }
 
+bool SurfaceMeshGL::tesselate_convex(const std::vector<vec3>& points,
+                                     std::vector<ivec3>& triangles) const
+{
+    const int n = points.size();
+
+    triangles.clear();
+    triangles.reserve(n - 2);
+
+    // triangle? nothing to do
+    if (n == 3)
+    {
+        triangles.push_back(ivec3(0, 1, 2));
+        return true;
+    }
+
+    // quad? simply compare to two options
+    else if (n == 4)
+    {
+        if (area(points[0], points[1], points[2]) +
+                area(points[0], points[2], points[3]) <
+            area(points[0], points[1], points[3]) +
+                area(points[1], points[2], points[3]))
+        {
+            triangles.push_back(ivec3(0, 1, 2));
+            triangles.push_back(ivec3(0, 2, 3));
+        }
+        else
+        {
+            triangles.push_back(ivec3(0, 1, 3));
+            triangles.push_back(ivec3(1, 2, 3));
+        }
+        return true;
+    }
+
+    // convex n-gon with n>4? all corners and all triangles of the fan
+    // around the first corner turn the same way around the polygon normal,
+    // such that the fan does not fold over
+    vec3 normal(0, 0, 0);
+    for (int i = 0; i < n; ++i)
+        normal += cross(points[i], points[(i + 1) % n]);
+    for (int i = 0; i < n; ++i)
+    {
+        const vec3& p0 = points[(i + n - 1) % n];
+        const vec3& p1 = points[i];
+        const vec3& p2 = points[(i + 1) % n];
+        if (dot(cross(p1 - p0, p2 - p1), normal) <= 0)
+            return false;
+        if (i > 0 && i + 1 < n &&
+            dot(cross(p1 - points[0], p2 - points[0]), normal) <= 0)
+            return false;
+    }
+    for (int i = 1; i + 1 < n; ++i)
+        triangles.push_back(ivec3(0, i, i + 1));
+    return true;
+}
+
 } // namespace pmp
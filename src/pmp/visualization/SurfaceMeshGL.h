@@ -6,12 +6,15 @@
 #include <limits>
 
 #include "pmp/SurfaceMesh.h"
+#include "pmp/SurfaceMeshIO.h"
 #include "pmp/visualization/GL.h"
 #include "pmp/visualization/Shader.h"
 #include "pmp/MatVec.h"
 
 namespace pmp {
 
+class SubdivisionSurfaceGL;
+
 //! Class for rendering surface meshes using OpenGL
 //! \ingroup visualization
 class SurfaceMeshGL : public SurfaceMesh
@@ -72,13 +75,114 @@ public:
     //! \note Vertex colors take precedence over face colors.
     void set_use_colors(bool use_colors) { use_colors_ = use_colors; }
 
-    //! draw the mesh
+    //! get whether vertex attributes are uploaded in compressed formats
+    bool compress_attributes() const { return compress_attributes_; }
+
+    //! \brief Control compression of the vertex attributes on the GPU
+    //! \details Positions are quantized to 16 bits relative to the bounding
+    //! box, normals are octahedral encoded with 2x16 bits, colors use 8 bits
+    //! per channel, and texture coordinates half floats. This halves the
+    //! memory and bandwidth of the vertex buffers, and is precise enough for
+    //! display. Takes effect on the next update_opengl_buffers(). Default is
+    //! \c false.
+    void set_compress_attributes(bool compress)
+    {
+        compress_attributes_ = compress;
+    }
+
+    //! \brief Number of bytes uploaded by the latest
+    //! update_opengl_buffers().
+    //! \details Partial updates of moved vertices only count the uploaded
+    //! ranges.
+    size_t uploaded_bytes() const { return uploaded_bytes_; }
+
+    //! \brief Number of triangles rendered by the latest draw().
+    //! \details Counts triangles drawn repeatedly, e.g., for hidden line
+    //! rendering, once per pass. Does not count culled triangles.
+    size_t n_drawn_triangles() const { return drawn_triangles_; }
+
+    //! \brief Draw the mesh.
+    //! \details The triangles are grouped into spatially clustered meshlets.
+    //! Meshlets outside the view frustum are skipped, and for closed opaque
+    //! meshes also meshlets whose triangles all face away from the viewer.
     void draw(const mat4& projection_matrix, const mat4& modelview_matrix,
               const std::string draw_mode);
 
-    //! update all opengl buffers for efficient core profile rendering
+    //! \brief Draw the mesh once for each of the model \p transforms.
+    //! \details The transforms map the mesh into the coordinates of the
+    //! modelview matrix passed to draw(). All instances share the buffers of
+    //! the mesh and each pass of draw() is a single instanced draw call.
+    //! Instances whose bounding sphere is outside the view frustum are
+    //! skipped, the meshlets are not culled. Normals are transformed by the
+    //! linear part of the transforms, which should therefore be rotations
+    //! with uniform scaling. Empty \p transforms draw the mesh once without
+    //! a transform, which is the default.
+    void set_instances(std::vector<mat4> transforms);
+
+    //! the model transforms of the instances, see set_instances()
+    const std::vector<mat4>& instances() const { return instances_; }
+
+    //! \brief Set the number of subdivision levels of the draw mode
+    //! \c "Subdivision Surface".
+    //! \details The mode draws the limit surface of Loop subdivision for
+    //! triangle meshes and of Catmull-Clark subdivision otherwise, evaluated
+    //! on the GPU from the control mesh by SubdivisionSurfaceGL. Each level
+    //! multiplies the number of drawn faces by four, but only the positions
+    //! of the control mesh are uploaded when they change. Instances are not
+    //! drawn in this mode. WebGL has no buffer textures, there the mode
+    //! draws the control mesh. Default is 3.
+    void set_subdivision_levels(unsigned int levels);
+
+    //! the number of subdivision levels, see set_subdivision_levels()
+    unsigned int subdivision_levels() const { return subdivision_levels_; }
+
+    //! \brief Update all opengl buffers for efficient core profile rendering.
+    //! \details The faces are uploaded as indexed triangles. Vertices are
+    //! shared by their faces and only split where normals (due to the crease
+    //! angle), texture coordinates, or colors differ. For flat shading,
+    //! the face normals are computed in the shader. The arrays are prepared
+    //! in parallel, and the index arrays are computed while the vertex
+    //! arrays are uploaded.
+    //!
+    //! If change tracking is enabled, see SurfaceMesh::set_change_tracking(),
+    //! and only vertex positions were modified since the previous update,
+    //! just the positions and normals of the moved vertices and their
+    //! neighbors are recomputed and the changed ranges of the buffers are
+    //! uploaded. Any other change causes a full update.
     void update_opengl_buffers();
 
+    //! \brief Render the vertices of the mesh with \p faces without building
+    //! the halfedge connectivity.
+    //! \details The buffers are filled from the indexed faces directly, which
+    //! is much faster for large meshes that are only viewed. Call
+    //! build_connectivity() before processing the mesh. Empty \p faces
+    //! discard the deferred faces.
+    //! \sa SurfaceMeshIO::read(SurfaceMesh&, IndexedFaces&)
+    void set_deferred_faces(IndexedFaces faces);
+
+    //! \brief Append \p faces to the deferred faces and upload just their
+    //! triangles.
+    //! \details For meshes arriving in pieces, e.g., a streaming mesh being
+    //! downloaded, which can be shown before they are complete. The buffers
+    //! grow geometrically and only the new triangles are computed and
+    //! uploaded. Normals are smoothed only across the faces appended
+    //! together and the attributes are not compressed until the next
+    //! update_opengl_buffers(). The vertices of \p faces have to be added
+    //! to the mesh before.
+    //! \throw InvalidInputException if the mesh has faces or an index of
+    //! \p faces is out of range.
+    void append_deferred_faces(const IndexedFaces& faces);
+
+    //! the faces not yet added to the mesh
+    const IndexedFaces& deferred_faces() const { return deferred_faces_; }
+
+    //! whether there are faces not yet added to the mesh
+    bool has_deferred_faces() const { return !deferred_faces_.empty(); }
+
+    //! \brief Add the deferred faces to the mesh.
+    //! \details Does nothing if there are none.
+    void build_connectivity();
+
     //! use color map to visualize scalar fields
     void use_cold_warm_texture();
 
@@ -142,11 +246,95 @@ private: // helpers for computing triangulation of a polygon
         return sqrnorm(cross(p1 - p0, p2 - p0));
     }
 
+    // fill the buffer arrays from faces, whose vertices are in the range
+    // [first_vertex, end_vertex)
+    void deferred_arrays(const IndexedFaces& faces, IndexType first_vertex,
+                         IndexType end_vertex, std::vector<vec3>& positions,
+                         std::vector<vec3>& normals, std::vector<vec3>& colors,
+                         std::vector<vec2>& texcoords,
+                         std::vector<unsigned int>& edges);
+
+    // create the vertex array object and the buffers if necessary
+    void create_buffers();
+
+    // draw the triangles, indexed unless filled from deferred faces.
+    // only the visible meshlets are drawn if cull is true.
+    void draw_triangles(bool cull = true);
+
+    // a range of the triangle indices with bounding volumes for culling
+    struct Meshlet
+    {
+        unsigned int first; // first index
+        unsigned int count; // number of indices
+        vec3 center;        // bounding sphere
+        float radius;
+        vec3 cone_axis;    // normals are within the cone around the axis
+        float cone_cutoff; // sine of the cone angle, > 1 if unbounded
+    };
+
+    // split the triangles into meshlets and compute their bounds
+    void build_meshlets(const std::vector<vec3>& positions,
+                        const std::vector<unsigned int>& triangles);
+
+    // compute the bounds of meshlet m
+    void update_meshlet(Meshlet& m, const std::vector<vec3>& positions,
+                        const std::vector<unsigned int>& triangles) const;
+
+    // collect the index ranges of the meshlets visible with the
+    // modelview-projection matrix mvp from the position eye
+    void cull_meshlets(const mat4& mvp, const vec3& eye);
+
+    // set up or remove the instance buffer, and upload the transforms of
+    // the instances whose bounding sphere is visible with the
+    // modelview-projection matrix mvp. expects the vertex array to be bound.
+    void update_instances(const mat4& mvp);
+
+    // draw count indices starting at offset, or count vertices, once for
+    // each visible instance if there are instances
+    void draw_elements(GLenum mode, GLsizei count,
+                       const void* offset = nullptr);
+    void draw_arrays(GLenum mode, GLsizei count);
+
+    // update the buffers of moved vertices only. returns false if a full
+    // update is required.
+    bool update_moved_vertices();
+
+    // is it still the mesh of the last buffer update, with the same
+    // connectivity? requires change tracking.
+    bool same_buffer_topology() const;
+
+    // faces whose cached tessellation can be reused since none of their
+    // vertices moved after the last buffer update. empty if the cache is
+    // invalid.
+    std::vector<char> reusable_tessellations() const;
+
+    // which attributes the buffers are filled from
+    unsigned int buffer_sources() const;
+
+    // writes positions and normals into the vertex buffers on the GPU
+    friend class SurfaceSmoothingGL;
+
+    // create the limit surface of the draw mode "Subdivision Surface" if
+    // necessary and evaluate it for new positions
+    void update_subdivision();
+
+    // delete the limit surface, e.g., after the connectivity changed
+    void clear_subdivision();
+
+    // start a new generation of changes after updating the buffers
+    void record_buffer_generation();
+
     // triangulate a polygon such that the sum of squared triangle areas is minimized.
     // this prevents overlapping/folding triangles for non-convex polygons.
     void tesselate(const std::vector<vec3>& points,
                    std::vector<ivec3>& triangles);
 
+    // triangulate triangles, quads, and convex polygons without the
+    // triangulation table, such that it can be called in parallel. returns
+    // false for non-convex polygons with more than four corners.
+    bool tesselate_convex(const std::vector<vec3>& points,
+                          std::vector<ivec3>& triangles) const;
+
 private:
     //! OpenGL buffers
     GLuint vertex_array_object_;
@@ -154,8 +342,10 @@ private:
     GLuint color_buffer_;
     GLuint normal_buffer_;
     GLuint tex_coord_buffer_;
+    GLuint triangle_buffer_;
     GLuint edge_buffer_;
     GLuint feature_buffer_;
+    GLuint instance_buffer_;
 
     //! buffer sizes
     GLsizei n_vertices_;
@@ -164,6 +354,56 @@ private:
     GLsizei n_features_;
     bool has_texcoords_;
     bool has_vertex_colors_;
+    bool has_triangle_indices_;
+
+    //! allocated vertices and edge indices of the buffers filled by
+    //! append_deferred_faces(), zero after full updates
+    size_t appended_vertex_capacity_;
+    size_t appended_edge_capacity_;
+
+    //! buffer layout for partial updates, see update_opengl_buffers()
+    std::vector<vec3> buffer_positions_;
+    std::vector<vec3> buffer_normals_;
+    std::vector<unsigned int> buffer_triangles_;
+    std::vector<unsigned int> corner_buffer_vertices_;
+    std::vector<unsigned int> face_triangles_;
+
+    //! tessellation of the polygons in corner indices, reused while their
+    //! connectivity and positions are unchanged. the triangles of face f
+    //! start at polygon_offsets_[f], triangles have none.
+    std::vector<unsigned int> polygon_offsets_;
+    std::vector<ivec3> polygon_triangles_;
+    unsigned int buffer_sources_;
+    uint64_t buffer_generation_;
+
+    //! compression of the vertex attributes, requested and uploaded, and
+    //! the decoding of quantized positions
+    bool compress_attributes_;
+    bool compressed_attributes_;
+    vec3 position_offset_;
+    vec3 position_scale_;
+
+    //! statistics of the latest update and draw
+    size_t uploaded_bytes_;
+    size_t drawn_triangles_;
+
+    //! meshlets for culling, and the visible index ranges
+    std::vector<Meshlet> meshlets_;
+    bool cull_backfacing_;
+    std::vector<GLsizei> draw_counts_;
+    std::vector<const void*> draw_offsets_;
+
+    //! model transforms of the instances, and the indices of the visible
+    //! ones in the instance buffer
+    std::vector<mat4> instances_;
+    std::vector<unsigned int> visible_instances_;
+    bool upload_instances_;
+
+    //! limit surface of the control mesh, created when first drawn, and
+    //! whether the positions changed since it was evaluated
+    SubdivisionSurfaceGL* subdivision_;
+    unsigned int subdivision_levels_;
+    bool subdivision_outdated_;
 
     //! shaders
     Shader phong_shader_;
@@ -176,6 +416,9 @@ private:
     bool use_colors_;
     float crease_angle_;
 
+    //! faces rendered without connectivity
+    IndexedFaces deferred_faces_;
+
     //! 1D texture for scalar field rendering
     GLuint texture_;
     enum TextureMode
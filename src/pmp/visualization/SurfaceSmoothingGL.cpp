@@ -0,0 +1,315 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "pmp/visualization/SurfaceSmoothingGL.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "pmp/SurfaceAdjacency.h"
+#include "pmp/algorithms/GeometryCache.h"
+#include "pmp/visualization/SmoothingShader.h"
+
+namespace pmp {
+
+namespace {
+
+// texture units of the buffer textures
+const int positions_unit = 0;
+const int offsets_unit = 1;
+const int neighbors_unit = 2;
+const int weights_unit = 3;
+const int buffer_vertices_unit = 3;
+
+// create a buffer of at least one texel and a buffer texture reading it
+void create_buffer_texture(GLuint& buffer, GLuint& texture, GLenum format,
+                           size_t bytes, const void* data, GLenum usage)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, size_t(16)),
+                 bytes ? data : nullptr, usage);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void bind_texture(int unit, GLuint texture)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
+
+void load_shader(Shader& shader, const char* vshader,
+                 const std::vector<const char*>& varyings)
+{
+    if (!shader.source(vshader, feedback_fshader) ||
+        !shader.set_feedback_varyings(varyings))
+        exit(1);
+}
+
+} // namespace
+
+SurfaceSmoothingGL::SurfaceSmoothingGL(SurfaceMeshGL& mesh)
+    : mesh_(mesh),
+      current_(0),
+      position_generation_(std::numeric_limits<uint64_t>::max())
+{
+    if (!mesh_.vertex_array_object_)
+        mesh_.update_opengl_buffers();
+
+    // the buffer vertices of each corner are needed, and the normals of all
+    // buffer vertices of a vertex have to be the same
+    const bool vertex_normals =
+        mesh_.crease_angle_ < 1 || mesh_.crease_angle_ > 170;
+    if (mesh_.corner_buffer_vertices_.size() != mesh_.halfedges_size() ||
+        mesh_.compressed_attributes_ || !vertex_normals)
+        throw InvalidInputException(
+            "SurfaceSmoothingGL: Requires change tracking, uncompressed "
+            "attributes, and no crease angle.");
+
+    // one-rings, neighbors across holes are marked
+    const SurfaceAdjacency adjacency(mesh_);
+    const size_t nv = mesh_.vertices_size();
+    std::vector<int> offsets(nv + 1, 0);
+    for (size_t i = 0; i < nv; ++i)
+        offsets[i + 1] = offsets[i] + int(adjacency.valence(Vertex(i)));
+    neighbors_.resize(offsets[nv]);
+    for (size_t i = 0; i < nv; ++i)
+    {
+        const auto vertices = adjacency.vertex_vertices(Vertex(i));
+        const auto faces = adjacency.vertex_faces(Vertex(i));
+        for (size_t j = 0; j < vertices.size(); ++j)
+        {
+            const int n = int(vertices[j].idx());
+            neighbors_[offsets[i] + j] = faces[j].is_valid() ? n : -n - 1;
+        }
+    }
+
+    // the vertex of each buffer vertex, from the corners
+    std::vector<int> buffer_vertices(mesh_.buffer_positions_.size(), 0);
+    for (auto h : mesh_.halfedges())
+        if (!mesh_.is_boundary(h))
+            buffer_vertices[mesh_.corner_buffer_vertices_[h.idx()]] =
+                int(mesh_.to_vertex(h).idx());
+
+    create_buffer_texture(offset_buffer_, offset_texture_, GL_R32I,
+                          offsets.size() * sizeof(int), offsets.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(neighbor_buffer_, neighbor_texture_, GL_R32I,
+                          neighbors_.size() * sizeof(int), neighbors_.data(),
+                          GL_STATIC_DRAW);
+    create_buffer_texture(weight_buffer_, weight_texture_, GL_R32F,
+                          neighbors_.size() * sizeof(float), nullptr,
+                          GL_DYNAMIC_DRAW);
+    create_buffer_texture(buffer_vertex_buffer_, buffer_vertex_texture_,
+                          GL_R32I, buffer_vertices.size() * sizeof(int),
+                          buffer_vertices.data(), GL_STATIC_DRAW);
+    for (int i = 0; i < 2; ++i)
+        create_buffer_texture(position_buffers_[i], position_textures_[i],
+                              GL_RGBA32F, nv * sizeof(vec4), nullptr,
+                              GL_DYNAMIC_COPY);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // drawing requires a vertex array, even without attributes
+    glGenVertexArrays(1, &vertex_array_object_);
+
+    load_shader(smoothing_shader_, smoothing_vshader, {"position"});
+    load_shader(vertex_buffer_shader_, vertex_buffer_vshader,
+                {"position", "normal"});
+
+    upload_positions();
+}
+
+SurfaceSmoothingGL::~SurfaceSmoothingGL()
+{
+    const GLuint buffers[] = {offset_buffer_,       neighbor_buffer_,
+                              weight_buffer_,       buffer_vertex_buffer_,
+                              position_buffers_[0], position_buffers_[1]};
+    const GLuint textures[] = {offset_texture_,       neighbor_texture_,
+                               weight_texture_,       buffer_vertex_texture_,
+                               position_textures_[0], position_textures_[1]};
+    glDeleteBuffers(6, buffers);
+    glDeleteTextures(6, textures);
+    glDeleteVertexArrays(1, &vertex_array_object_);
+}
+
+void SurfaceSmoothingGL::upload_positions()
+{
+    // the generation is the maximum before the first upload
+    const SurfaceMesh& mesh = mesh_;
+    const auto vpoint = mesh.get_vertex_property<Point>("v:point");
+    if (position_generation_ != std::numeric_limits<uint64_t>::max() &&
+        vpoint.generation() <= position_generation_)
+        return;
+
+    std::vector<vec4> positions(mesh.vertices_size());
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = vec4((vec3)vpoint[Vertex(i)], 1.0);
+    glBindBuffer(GL_TEXTURE_BUFFER, position_buffers_[current_]);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, positions.size() * sizeof(vec4),
+                    positions.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    position_generation_ = vpoint.generation();
+}
+
+void SurfaceSmoothingGL::upload_weights(bool use_uniform_laplace)
+{
+    if (!use_uniform_laplace && cotan_weights_.empty())
+    {
+        GeometryCache cache(mesh_);
+        cache.update();
+        cotan_weights_.reserve(neighbors_.size());
+        for (auto v : mesh_.vertices())
+            for (auto h : mesh_.halfedges(v))
+                cotan_weights_.push_back(
+                    float(std::max(0.0, cache.cotan_weight(mesh_.edge(h)))));
+    }
+
+    // move the selected interior vertices, or all if none is selected
+    const SurfaceMesh& mesh = mesh_;
+    const auto vselected = mesh.get_vertex_property<bool>("v:selected");
+    bool no_selection = true;
+    if (vselected)
+        for (auto v : mesh.vertices())
+            if (vselected[v])
+            {
+                no_selection = false;
+                break;
+            }
+
+    // fixed vertices get zero weights
+    std::vector<float> weights(neighbors_.size());
+    size_t j = 0;
+    for (auto v : mesh.vertices())
+    {
+        const bool moves =
+            !mesh.is_boundary(v) && (no_selection || vselected[v]);
+        for (size_t k = 0, n = mesh.valence(v); k < n; ++k, ++j)
+            weights[j] =
+                moves ? (use_uniform_laplace ? 1.0f : cotan_weights_[j]) : 0;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, weight_buffer_);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, weights.size() * sizeof(float),
+                    weights.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void SurfaceSmoothingGL::bind_rings(Shader& shader)
+{
+    shader.use();
+    shader.set_uniform("positions", positions_unit);
+    shader.set_uniform("offsets", offsets_unit);
+    shader.set_uniform("neighbors", neighbors_unit);
+    bind_texture(positions_unit, position_textures_[current_]);
+    bind_texture(offsets_unit, offset_texture_);
+    bind_texture(neighbors_unit, neighbor_texture_);
+}
+
+void SurfaceSmoothingGL::explicit_smoothing(unsigned int iters,
+                                            bool use_uniform_laplace)
+{
+    if (!mesh_.n_vertices())
+        return;
+
+    upload_positions();
+    upload_weights(use_uniform_laplace);
+
+    glBindVertexArray(vertex_array_object_);
+    glEnable(GL_RASTERIZER_DISCARD);
+    bind_rings(smoothing_shader_);
+    smoothing_shader_.set_uniform("weights", weights_unit);
+    bind_texture(weights_unit, weight_texture_);
+
+    // read the positions of one iteration, write those of the next
+    const GLsizei nv = GLsizei(mesh_.vertices_size());
+    for (unsigned int iter = 0; iter < iters; ++iter)
+    {
+        bind_texture(positions_unit, position_textures_[current_]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0,
+                         position_buffers_[1 - current_]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, nv);
+        glEndTransformFeedback();
+        current_ = 1 - current_;
+    }
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+    update_vertex_buffers();
+}
+
+void SurfaceSmoothingGL::update_vertex_buffers()
+{
+    glBindVertexArray(vertex_array_object_);
+    glEnable(GL_RASTERIZER_DISCARD);
+    bind_rings(vertex_buffer_shader_);
+    vertex_buffer_shader_.set_uniform("buffer_vertices",
+                                      buffer_vertices_unit);
+    bind_texture(buffer_vertices_unit, buffer_vertex_texture_);
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mesh_.vertex_buffer_);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, mesh_.normal_buffer_);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, GLsizei(mesh_.buffer_positions_.size()));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, 0);
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    bind_texture(0, 0);
+    glBindVertexArray(0);
+    vertex_buffer_shader_.disable();
+
+    // the meshlet bounds are outdated, draw all meshlets until download()
+    for (auto& m : mesh_.meshlets_)
+    {
+        m.radius = std::numeric_limits<float>::max();
+        m.cone_cutoff = 2;
+    }
+}
+
+void SurfaceSmoothingGL::download()
+{
+    if (!mesh_.n_vertices())
+        return;
+
+    std::vector<vec4> positions(mesh_.vertices_size());
+    glBindBuffer(GL_TEXTURE_BUFFER, position_buffers_[current_]);
+    glGetBufferSubData(GL_TEXTURE_BUFFER, 0, positions.size() * sizeof(vec4),
+                       positions.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    // only write moved vertices, which are tracked as changed
+    const SurfaceMesh& mesh = mesh_;
+    for (auto v : mesh.vertices())
+    {
+        const vec4& q = positions[v.idx()];
+        const Point p(q[0], q[1], q[2]);
+        if (mesh.position(v) != p)
+            mesh_.position(v) = p;
+    }
+
+    // update the copies of the vertex buffers and the meshlet bounds, such
+    // that the next buffer update only handles later changes
+    auto& buffer_positions = mesh_.buffer_positions_;
+    auto& buffer_normals = mesh_.buffer_normals_;
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_.vertex_buffer_);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0,
+                       buffer_positions.size() * sizeof(vec3),
+                       buffer_positions.data());
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_.normal_buffer_);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0,
+                       buffer_normals.size() * sizeof(vec3),
+                       buffer_normals.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    for (auto& m : mesh_.meshlets_)
+        mesh_.update_meshlet(m, buffer_positions, mesh_.buffer_triangles_);
+    mesh_.record_buffer_generation();
+
+    position_generation_ = mesh.get_vertex_property<Point>("v:point")
+                               .generation();
+}
+
+} // namespace pmp
@@ -0,0 +1,108 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#pragma once
+
+#include <vector>
+
+#include "pmp/visualization/GL.h"
+#include "pmp/visualization/Shader.h"
+#include "pmp/visualization/SurfaceMeshGL.h"
+
+namespace pmp {
+
+//! \brief Explicit Laplacian smoothing and vertex normals of a SurfaceMeshGL
+//! on the GPU.
+//! \details The one-rings and the positions are uploaded once into buffers
+//! in GPU memory. Each smoothing iteration and the update of the normals run
+//! in vertex shaders whose outputs are captured with transform feedback, the
+//! compute shaders of OpenGL 4.3 are not available in the core profile 3.2
+//! of the viewers. The positions and normals are written directly into the
+//! vertex buffers of the mesh, such that interactive smoothing, e.g., with a
+//! brush, does not copy the mesh between CPU and GPU.
+//!
+//! The mesh keeps its old positions until download(). Positions changed on
+//! the CPU before are uploaded again by the next smoothing. The connectivity
+//! of the mesh must not change while the object is in use.
+//!
+//! Example:
+//! \code
+//! SurfaceSmoothingGL smoother(mesh);
+//! smoother.explicit_smoothing(10);
+//! // ... draw the mesh, smooth further ...
+//! smoother.download();
+//! \endcode
+//! \ingroup visualization
+class SurfaceSmoothingGL
+{
+public:
+    //! \brief Upload the one-rings and positions of \p mesh.
+    //! \details Requires an OpenGL context and the buffers of the mesh,
+    //! which are created if necessary.
+    //! \throw InvalidInputException if the vertex buffers have no partial
+    //! update layout, i.e., if change tracking is disabled, the mesh has
+    //! deferred faces or compressed attributes, or normals are split at
+    //! creases.
+    explicit SurfaceSmoothingGL(SurfaceMeshGL& mesh);
+
+    //! free the GPU buffers
+    ~SurfaceSmoothingGL();
+
+    SurfaceSmoothingGL(const SurfaceSmoothingGL&) = delete;
+    SurfaceSmoothingGL& operator=(const SurfaceSmoothingGL&) = delete;
+
+    //! \brief Perform \p iters iterations of explicit Laplacian smoothing on
+    //! the GPU and update the vertex buffers of the mesh.
+    //! \details Moves the same vertices with the same weights as
+    //! SurfaceSmoothing::explicit_smoothing(), i.e., the selected interior
+    //! vertices, all interior ones if none is selected.
+    void explicit_smoothing(unsigned int iters = 10,
+                            bool use_uniform_laplace = false);
+
+    //! \brief Copy the positions back into the mesh.
+    //! \details Also updates the copies of the buffers that SurfaceMeshGL
+    //! keeps for partial updates and culling.
+    void download();
+
+private:
+    // upload the positions of the mesh if they changed on the CPU
+    void upload_positions();
+
+    // compute and upload the weights of the one-rings
+    void upload_weights(bool use_uniform_laplace);
+
+    // write positions and normals into the vertex buffers of the mesh
+    void update_vertex_buffers();
+
+    // bind the buffer textures of the one-rings to the units of the
+    // samplers offsets and neighbors
+    void bind_rings(Shader& shader);
+
+    SurfaceMeshGL& mesh_;
+
+    // one-rings, see SmoothingShader.h, and the vertex of each buffer
+    // vertex of the mesh
+    std::vector<int> neighbors_;
+    GLuint offset_buffer_, neighbor_buffer_, weight_buffer_;
+    GLuint buffer_vertex_buffer_;
+    GLuint offset_texture_, neighbor_texture_, weight_texture_;
+    GLuint buffer_vertex_texture_;
+
+    // positions of the last two iterations, and the current one
+    GLuint position_buffers_[2];
+    GLuint position_textures_[2];
+    int current_;
+
+    // generation of the positions on the GPU, see
+    // SurfaceMesh::set_change_tracking()
+    uint64_t position_generation_;
+
+    // cotan weights of the one-rings, computed when first needed
+    std::vector<float> cotan_weights_;
+
+    GLuint vertex_array_object_;
+    Shader smoothing_shader_;
+    Shader vertex_buffer_shader_;
+};
+
+} // namespace pmp
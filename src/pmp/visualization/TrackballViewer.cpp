@@ -125,7 +125,11 @@ void TrackballViewer::display()
 
     // draw the scene in current draw mode
     if (draw_mode_ < draw_mode_names_.size())
+    {
+        begin_timing(draw_mode_names_[draw_mode_]);
         draw(draw_mode_names_[draw_mode_]);
+        end_timing();
+    }
     else
         draw("");
 }
@@ -271,6 +275,36 @@ bool TrackballViewer::pick(int x, int y, vec3& result)
     return false;
 }
 
+void TrackballViewer::pick_ray(int x, int y, vec3& origin, vec3& direction)
+{
+    // get viewport data
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // take into accout highDPI scaling
+    x *= high_dpi_scaling();
+    y *= high_dpi_scaling();
+
+    // in OpenGL y=0 is at the 'bottom'
+    y = viewport[3] - y;
+
+    // unproject the pixel on the near and far plane
+    float xf =
+        ((float)x - (float)viewport[0]) / ((float)viewport[2]) * 2.0f - 1.0f;
+    float yf =
+        ((float)y - (float)viewport[1]) / ((float)viewport[3]) * 2.0f - 1.0f;
+
+    mat4 mvp = projection_matrix_ * modelview_matrix_;
+    mat4 inv = inverse(mvp);
+    vec4 p0 = inv * vec4(xf, yf, -1.0f, 1.0f);
+    vec4 p1 = inv * vec4(xf, yf, 1.0f, 1.0f);
+    p0 /= p0[3];
+    p1 /= p1[3];
+
+    origin = vec3(p0[0], p0[1], p0[2]);
+    direction = vec3(p1[0], p1[1], p1[2]) - origin;
+}
+
 void TrackballViewer::fly_to(int x, int y)
 {
     vec3 p;
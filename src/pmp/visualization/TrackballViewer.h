@@ -80,8 +80,15 @@ protected:
     //! get 3D position under the mouse cursor
     bool pick(vec3& result);
 
-    //! get 3D position of 2D position (x,y)
-    bool pick(int x, int y, vec3& result);
+    //! \brief Get 3D position of 2D position (x,y)
+    //! \details Reads the depth buffer, which is not possible with WebGL.
+    //! Derived viewers may intersect pick_ray() with their scene instead.
+    virtual bool pick(int x, int y, vec3& result);
+
+    //! \brief Get the ray through the 2D position (x,y) in scene coordinates.
+    //! \details The ray starts at the near plane and reaches the far plane
+    //! at origin + direction.
+    void pick_ray(int x, int y, vec3& origin, vec3& direction);
 
     //! fly toward the position Distributed under the mouse cursor and set rotation center to it
     void fly_to(int x, int y);
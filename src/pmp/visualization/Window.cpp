@@ -28,7 +28,10 @@ Window::Window(const char* title, int width, int height, bool showgui)
       show_imgui_(showgui),
       imgui_scale_(1.0),
       show_help_(false),
-      screenshot_number_(0)
+      show_performance_(false),
+      screenshot_number_(0),
+      render_on_demand_(false),
+      redraw_frames_(0)
 {
     // initialize glfw window
     if (!glfwInit())
@@ -143,6 +146,7 @@ Window::Window(const char* title, int width, int height, bool showgui)
     glfwSetMouseButtonCallback(window_, glfw_mouse);
     glfwSetScrollCallback(window_, glfw_scroll);
     glfwSetFramebufferSizeCallback(window_, glfw_resize);
+    glfwSetWindowRefreshCallback(window_, glfw_refresh);
 
     // setup imgui
     init_imgui();
@@ -151,6 +155,7 @@ Window::Window(const char* title, int width, int height, bool showgui)
     add_help_item("F", "Toggle fullscreen mode");
     add_help_item("G", "Toggle GUI dialog");
     add_help_item("PageUp/Down", "Scale GUI dialogs");
+    add_help_item("P", "Toggle performance overlay");
 #ifndef __EMSCRIPTEN__
     add_help_item("PrtScr", "Save screenshot");
     add_help_item("Esc/Q", "Quit application");
@@ -164,6 +169,7 @@ Window::Window(const char* title, int width, int height, bool showgui)
 
 Window::~Window()
 {
+    performance_.clear();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -369,6 +375,17 @@ int Window::run()
     return EXIT_SUCCESS;
 }
 
+void Window::set_render_on_demand(bool b)
+{
+    render_on_demand_ = b;
+    request_redraw();
+}
+
+void Window::request_redraw()
+{
+    redraw_frames_ = 3;
+}
+
 void Window::render_frame()
 {
     glfwMakeContextCurrent(instance_->window_);
@@ -390,42 +407,76 @@ void Window::render_frame()
     }
 #endif
 
+    // nothing changed: sleep until the next event. the browser calls this
+    // function for each animation frame, so just skip it there.
+    if (instance_->render_on_demand_)
+    {
+        if (instance_->redraw_frames_ == 0)
+        {
+#ifndef __EMSCRIPTEN__
+            glfwWaitEvents();
+#endif
+            return;
+        }
+        --instance_->redraw_frames_;
+    }
+
+    auto& performance = instance_->performance_;
+    performance.begin_frame();
+
     // do some computations
+    performance.begin_section("Processing");
     instance_->do_processing();
+    performance.end_section();
 
     // preapre and process ImGUI elements
-    if (instance_->show_imgui())
+    const bool show_imgui = instance_->show_imgui();
+    const bool show_performance = instance_->show_performance_;
+    if (show_imgui || show_performance)
     {
+        performance.begin_section("GUI");
+
         // start imgui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        // prepare, process, and finish applications ImGUI dialog
-        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Once);
-        ImGui::Begin(
-            "Mesh Info", nullptr,
-            ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize);
-        ImGui::Text("Press '?' for help");
-        ImGui::Spacing();
-        ImGui::Separator();
-        ImGui::Spacing();
-        instance_->process_imgui();
-        ImGui::End();
+        if (show_imgui)
+        {
+            // prepare, process, and finish applications ImGUI dialog
+            ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Once);
+            ImGui::Begin("Mesh Info", nullptr,
+                         ImGuiWindowFlags_NoTitleBar |
+                             ImGuiWindowFlags_AlwaysAutoResize);
+            ImGui::Text("Press '?' for help");
+            ImGui::Spacing();
+            ImGui::Separator();
+            ImGui::Spacing();
+            instance_->process_imgui();
+            ImGui::End();
+
+            // show imgui help
+            instance_->show_help();
+        }
 
-        // show imgui help
-        instance_->show_help();
+        if (show_performance)
+            performance.draw_imgui();
 
         ImGui::Render();
+        performance.end_section();
     }
 
     // draw scene
+    performance.begin_section("Display");
     instance_->display();
+    performance.end_section();
 
     // draw GUI
-    if (instance_->show_imgui())
+    if (show_imgui || show_performance)
     {
+        performance.begin_section("GUI Drawing");
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        performance.end_section();
     }
 
 #if __EMSCRIPTEN__
@@ -456,6 +507,7 @@ void Window::glfw_error(int error, const char* description)
 
 void Window::glfw_character(GLFWwindow* window, unsigned int c)
 {
+    instance_->request_redraw();
     ImGui_ImplGlfw_CharCallback(window, c);
     if (!ImGui::GetIO().WantCaptureKeyboard)
     {
@@ -466,6 +518,7 @@ void Window::glfw_character(GLFWwindow* window, unsigned int c)
 void Window::glfw_keyboard(GLFWwindow* window, int key, int scancode,
                            int action, int mods)
 {
+    instance_->request_redraw();
     ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods);
     if (!ImGui::GetIO().WantCaptureKeyboard)
     {
@@ -538,6 +591,12 @@ void Window::keyboard(int key, int /*code*/, int action, int /*mods*/)
             break;
         }
 
+        case GLFW_KEY_P:
+        {
+            show_performance(!show_performance());
+            break;
+        }
+
         case GLFW_KEY_PAGE_UP:
         {
             scale_imgui(1.25);
@@ -621,12 +680,15 @@ void Window::exit_fullscreen()
 
 void Window::glfw_motion(GLFWwindow* /*window*/, double xpos, double ypos)
 {
+    instance_->request_redraw();
+
     // correct for highDPI scaling
     instance_->motion(instance_->scaling_ * xpos, instance_->scaling_ * ypos);
 }
 
 void Window::glfw_mouse(GLFWwindow* window, int button, int action, int mods)
 {
+    instance_->request_redraw();
     ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods);
     if (!ImGui::GetIO().WantCaptureMouse)
     {
@@ -637,6 +699,8 @@ void Window::glfw_mouse(GLFWwindow* window, int button, int action, int mods)
 
 void Window::glfw_scroll(GLFWwindow* window, double xoffset, double yoffset)
 {
+    instance_->request_redraw();
+
 #ifdef __EMSCRIPTEN__
     yoffset = -yoffset;
 
@@ -660,6 +724,12 @@ void Window::glfw_resize(GLFWwindow* /*window*/, int width, int height)
     instance_->width_ = width;
     instance_->height_ = height;
     instance_->resize(width, height);
+    instance_->request_redraw();
+}
+
+void Window::glfw_refresh(GLFWwindow* /*window*/)
+{
+    instance_->request_redraw();
 }
 
 void Window::cursor_pos(double& x, double& y) const
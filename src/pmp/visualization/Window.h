@@ -4,6 +4,7 @@
 #pragma once
 
 #include "pmp/visualization/GL.h"
+#include "pmp/visualization/PerformanceOverlay.h"
 
 #include <vector>
 #include <utility>
@@ -26,6 +27,17 @@ public:
     //! main window loop
     int run();
 
+    //! \brief Only redraw the window on demand instead of continuously.
+    //! \details In this mode the main loop sleeps until an event arrives and
+    //! redraws the window only after input, resizing, or a call to
+    //! request_redraw(). Animations and background tasks have to call
+    //! request_redraw() in each frame to keep the window updating. The
+    //! performance overlay then shows the timings of the last redraw.
+    void set_render_on_demand(bool b);
+
+    //! are redraws limited to those on demand?
+    bool render_on_demand() const { return render_on_demand_; }
+
 private:
     static void glfw_error(int error, const char* description);
     static void glfw_keyboard(GLFWwindow* window, int key, int scancode,
@@ -36,6 +48,7 @@ private:
     static void glfw_motion(GLFWwindow* window, double xpos, double ypos);
     static void glfw_scroll(GLFWwindow* window, double xoffset, double yoffset);
     static void glfw_resize(GLFWwindow* window, int width, int height);
+    static void glfw_refresh(GLFWwindow* window);
 
     static void render_frame();
 
@@ -94,6 +107,38 @@ protected:
     //! show ImGUI help dialog
     void show_help();
 
+    //! is the performance overlay visible or hidden?
+    bool show_performance() const { return show_performance_; }
+
+    //! show or hide the performance overlay
+    void show_performance(bool b) { show_performance_ = b; }
+
+    //! \brief Start the timed section \p name of the current frame.
+    //! \details Its CPU and GPU time are shown in the performance overlay.
+    //! Sections may be nested and have to be closed by end_timing(). The
+    //! frame is split into the sections "Processing", "GUI", "Display", and
+    //! "GUI Drawing", and TrackballViewer times drawing in the current draw
+    //! mode.
+    void begin_timing(const std::string& name)
+    {
+        performance_.begin_section(name);
+    }
+
+    //! end the innermost timed section
+    void end_timing() { performance_.end_section(); }
+
+    //! set the counter \p name shown in the performance overlay
+    void set_performance_counter(const std::string& name, size_t value)
+    {
+        performance_.set_counter(name, value);
+    }
+
+    //! \brief Redraw the window in the next frames.
+    //! \details Needed after changes of the scene that are not caused by
+    //! input if render_on_demand() is set. Has to be called from the thread
+    //! running the main loop.
+    void request_redraw();
+
     //! take a screenshot, save it to `title-n.png` using the window title
     //! and an incremented number `n`.
     void screenshot();
@@ -155,6 +200,9 @@ private:
     float imgui_scale_;
     // show ImGUI help dialog
     bool show_help_;
+    // whether to show the performance overlay, and its statistics
+    bool show_performance_;
+    PerformanceOverlay performance_;
     // items for ImGUI help dialog
     std::vector<std::pair<std::string, std::string>> help_items_;
 
@@ -169,6 +217,11 @@ private:
 
     // screenshot number
     unsigned int screenshot_number_;
+
+    // whether to redraw on demand only, and the number of frames still to
+    // draw. ImGUI needs a few frames to settle after each event.
+    bool render_on_demand_;
+    int redraw_frames_;
 };
 
 } // namespace pmp
@@ -0,0 +1,118 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/BitVector.h"
+
+#include <thread>
+#include <vector>
+
+using namespace pmp;
+
+TEST(BitVectorTest, resize)
+{
+    BitVector bits(70, true);
+    EXPECT_EQ(bits.size(), 70u);
+    EXPECT_EQ(bits.count(), 70u);
+    EXPECT_EQ(bits.n_words(), 2u);
+
+    // bits after the size stay zero
+    EXPECT_EQ(bits.word(1), (BitVector::Word(1) << 6) - 1);
+    bits.resize(3);
+    EXPECT_EQ(bits.count(), 3u);
+    bits.resize(200, false);
+    EXPECT_EQ(bits.count(), 3u);
+    bits.resize(210, true);
+    EXPECT_EQ(bits.count(), 13u);
+    EXPECT_TRUE(bits[205]);
+    EXPECT_FALSE(bits[199]);
+
+    bits.clear();
+    bits.resize(100);
+    EXPECT_TRUE(bits.none());
+    bits.push_back(true);
+    EXPECT_EQ(bits.size(), 101u);
+    EXPECT_TRUE(bits[100]);
+}
+
+TEST(BitVectorTest, access)
+{
+    BitVector bits(130);
+    bits[0] = true;
+    bits[64] = true;
+    bits[129] = bits[64];
+    EXPECT_TRUE(bits[129]);
+    bits[64].flip();
+    EXPECT_FALSE(bits[64]);
+    EXPECT_EQ(bits.count(), 2u);
+
+    const BitVector copy = bits;
+    EXPECT_EQ(copy, bits);
+    bits[0] = false;
+    EXPECT_NE(copy, bits);
+    EXPECT_TRUE(copy[0]);
+}
+
+TEST(BitVectorTest, word_operations)
+{
+    const size_t n = 1000;
+    BitVector a(n), b(n);
+    for (size_t i = 0; i < n; i += 3)
+        a[i] = true;
+    for (size_t i = 0; i < n; i += 5)
+        b[i] = true;
+
+    BitVector both = a;
+    both &= b;
+    EXPECT_EQ(both.count(), (n + 14) / 15);
+    BitVector either = a;
+    either |= b;
+    EXPECT_EQ(either.count(), a.count() + b.count() - both.count());
+    BitVector one = a;
+    one ^= b;
+    EXPECT_EQ(one.count(), either.count() - both.count());
+    BitVector only_a = a;
+    only_a.and_not(b);
+    EXPECT_EQ(only_a.count(), a.count() - both.count());
+
+    a.flip();
+    EXPECT_EQ(a.count(), n - (n + 2) / 3);
+    a.fill(true);
+    EXPECT_EQ(a.count(), n);
+    a.fill(false);
+    EXPECT_TRUE(a.none());
+}
+
+TEST(BitVectorTest, find)
+{
+    BitVector bits(300);
+    EXPECT_EQ(bits.find_first(), size_t(BitVector::npos));
+
+    std::vector<size_t> set = {3, 63, 64, 200, 299};
+    for (auto i : set)
+        bits[i] = true;
+
+    std::vector<size_t> found;
+    for (size_t i = bits.find_first(); i != BitVector::npos;
+         i = bits.find_next(i))
+        found.push_back(i);
+    EXPECT_EQ(found, set);
+}
+
+TEST(BitVectorTest, parallel_writes)
+{
+    // the threads write interleaved bits, such that all of them write to
+    // the same words at the same time
+    const int n = 100000, n_threads = 4;
+    BitVector bits(n);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+        threads.emplace_back([&bits, t] {
+            for (int i = t; i < n; i += n_threads)
+                bits[i] = i % 2 == 0;
+        });
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(bits.count(), size_t(n / 2));
+}
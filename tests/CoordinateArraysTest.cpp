@@ -0,0 +1,71 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/CoordinateArrays.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <cstdint>
+
+#include "Helpers.h"
+
+using namespace pmp;
+
+TEST(CoordinateArraysTest, gather_scatter)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    CoordinateArrays coords(mesh);
+    EXPECT_EQ(coords.size(), mesh.vertices_size());
+    EXPECT_GE(coords.padded_size(), coords.size());
+    EXPECT_EQ(coords.padded_size() * sizeof(Scalar) %
+                  CoordinateArrays::alignment,
+              0u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(coords.y()) %
+                  CoordinateArrays::alignment,
+              0u);
+
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(coords.position(v), mesh.position(v));
+
+    // padding is zero
+    for (size_t i = coords.size(); i < coords.padded_size(); ++i)
+        EXPECT_EQ(coords.z()[i], 0);
+
+    for (size_t i = 0; i < coords.size(); ++i)
+        coords.x()[i] += 1;
+    coords.scatter(mesh);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(coords.position(v), mesh.position(v));
+
+    mesh.add_vertex(Point(0, 0, 0));
+    EXPECT_THROW(coords.scatter(mesh), InvalidInputException);
+}
+
+TEST(CoordinateArraysTest, copy)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    CoordinateArrays coords(mesh);
+    CoordinateArrays copy(coords);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(copy.x()) %
+                  CoordinateArrays::alignment,
+              0u);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(copy.position(v), mesh.position(v));
+}
+
+TEST(CoordinateArraysTest, bounds)
+{
+    auto mesh = vertex_onering();
+    auto v = mesh.add_vertex(Point(10, 10, 10));
+    mesh.delete_vertex(v);
+
+    auto bb = CoordinateArrays(mesh).bounds();
+    BoundingBox ref;
+    for (auto vv : mesh.vertices())
+        ref += mesh.position(vv);
+    EXPECT_EQ(bb.min(), ref.min());
+    EXPECT_EQ(bb.max(), ref.max());
+
+    EXPECT_TRUE(CoordinateArrays(SurfaceMesh()).bounds().is_empty());
+}
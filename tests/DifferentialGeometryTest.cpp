@@ -98,3 +98,90 @@ TEST_F(DifferentialGeometryTest, centroid)
     auto center = centroid(sphere);
     EXPECT_LT(norm(center), 1e-5);
 }
+
+TEST_F(DifferentialGeometryTest, coordinate_arrays)
+{
+    SurfaceAdjacency adjacency(sphere);
+    CoordinateArrays coords(sphere);
+    EXPECT_NEAR(surface_area(adjacency, coords), surface_area(sphere), 1e-4);
+    EXPECT_NEAR(volume(adjacency, coords), volume(sphere), 1e-4);
+    EXPECT_LT(norm(centroid(adjacency, coords) - centroid(sphere)), 1e-5);
+
+    auto quad = SurfaceFactory::hexahedron();
+    EXPECT_THROW(surface_area(SurfaceAdjacency(quad), CoordinateArrays(quad)),
+                 InvalidInputException);
+}
+
+TEST_F(DifferentialGeometryTest, index_buffer)
+{
+    std::vector<IndexType> triangles;
+    for (auto f : sphere.faces())
+        for (auto v : sphere.vertices(f))
+            triangles.push_back(v.idx());
+    CoordinateArrays coords(sphere);
+
+    // the sums do not depend on how the triangles are traversed
+    EXPECT_EQ(surface_area(triangles, coords), surface_area(sphere));
+    EXPECT_EQ(volume(triangles, coords), volume(sphere));
+    EXPECT_EQ(centroid(triangles, coords), centroid(sphere));
+    EXPECT_EQ(surface_area(triangles, coords),
+              surface_area(SurfaceAdjacency(sphere), coords));
+
+    // deleted faces are skipped
+    auto mesh = sphere;
+    mesh.delete_face(Face(0));
+    const auto area = surface_area(sphere) - triangle_area(sphere, Face(0));
+    EXPECT_NEAR(surface_area(mesh), area, 1e-4);
+    EXPECT_NEAR(surface_area(SurfaceAdjacency(mesh), CoordinateArrays(mesh)),
+                area, 1e-4);
+
+    EXPECT_EQ(surface_area(std::vector<IndexType>(), coords), 0);
+}
+
+TEST_F(DifferentialGeometryTest, dual)
+{
+    // build the dual face by face for reference
+    SurfaceMesh expected;
+    auto fvertex = sphere.add_face_property<Vertex>("f:vertex");
+    for (auto f : sphere.faces())
+        fvertex[f] = expected.add_vertex(centroid(sphere, f));
+    for (auto v : sphere.vertices())
+    {
+        std::vector<Vertex> vertices;
+        for (auto f : sphere.faces(v))
+            vertices.push_back(fvertex[f]);
+        expected.add_face(vertices);
+    }
+    sphere.remove_face_property(fvertex);
+
+    mesh = sphere;
+    dual(mesh);
+    ASSERT_EQ(mesh.n_vertices(), expected.n_vertices());
+    ASSERT_EQ(mesh.n_faces(), expected.n_faces());
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), expected.position(v));
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.halfedge(v), expected.halfedge(v));
+    for (auto f : mesh.faces())
+    {
+        // the faces start at the same vertices
+        std::vector<Vertex> vertices, expected_vertices;
+        for (auto v : mesh.vertices(f))
+            vertices.push_back(v);
+        for (auto v : expected.vertices(f))
+            expected_vertices.push_back(v);
+        EXPECT_EQ(vertices, expected_vertices);
+    }
+
+    // the dual of the dual has the topology of the original mesh
+    dual(mesh);
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+
+    // boundary vertices of a single triangle have only one face
+    mesh.clear();
+    add_triangle();
+    EXPECT_THROW(dual(mesh), InvalidInputException);
+    EXPECT_EQ(mesh.n_faces(), 1u);
+}
@@ -5,6 +5,7 @@
 
 #include <pmp/SurfaceMesh.h>
 #include <pmp/algorithms/DistancePointTriangle.h>
+#include <cstdlib>
 #include <vector>
 
 using namespace pmp;
@@ -35,3 +36,52 @@ TEST_F(DistancePointTriangleTest, distance_point_degenerate_triangle)
     EXPECT_FLOAT_EQ(dist, 1.0);
     EXPECT_EQ(nearest, Point(0, 0, 0));
 }
+
+TEST_F(DistancePointTriangleTest, batched_distances)
+{
+    // random triangles and points, and degenerate triangles
+    std::vector<Point> corners;
+    srand(42);
+    auto random_point = []() {
+        return Point(Scalar(rand()) / RAND_MAX, Scalar(rand()) / RAND_MAX,
+                     Scalar(rand()) / RAND_MAX);
+    };
+    for (int i = 0; i < 3 * 37; ++i)
+        corners.push_back(random_point());
+    for (const Point& a : {Point(0, 0, 0), Point(1, 0, 0)})
+    {
+        corners.push_back(Point(0, 0, 0));
+        corners.push_back(a);
+        corners.push_back(Point(0, 0, 0));
+    }
+    corners.push_back(Point(0, 0, 0));
+    corners.push_back(Point(1, 0, 0));
+    corners.push_back(Point(2, 0, 0));
+    const size_t n = corners.size() / 3;
+
+    std::vector<Scalar> coords[9];
+    for (size_t i = 0; i < 3 * n; ++i)
+        for (int j = 0; j < 3; ++j)
+            coords[3 * (i % 3) + j].push_back(corners[i][j]);
+    const Scalar* x[9];
+    for (int j = 0; j < 9; ++j)
+        x[j] = coords[j].data();
+
+    std::vector<Scalar> dist(n), b1(n), b2(n);
+    for (int k = 0; k < 20; ++k)
+    {
+        const Point p = Scalar(3) * random_point() - Point(1, 1, 1);
+        dist_point_triangles(p, x, n, dist.data(), b1.data(), b2.data());
+        for (size_t i = 0; i < n; ++i)
+        {
+            const Point* v = &corners[3 * i];
+            Point nearest;
+            const Scalar d = dist_point_triangle(p, v[0], v[1], v[2], nearest);
+            EXPECT_NEAR(dist[i], d, 1e-5);
+            const Point q =
+                v[0] + b1[i] * (v[1] - v[0]) + b2[i] * (v[2] - v[0]);
+            EXPECT_NEAR(distance(q, p), d, 1e-5);
+            EXPECT_NEAR(distance(q, nearest), 0, 1e-4);
+        }
+    }
+}
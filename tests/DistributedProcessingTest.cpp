@@ -0,0 +1,109 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/DistributedProcessing.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+
+using namespace pmp;
+
+namespace {
+
+// a transport that processes the encoded patches like remote workers
+DistributedProcessing::Transport workers(
+    const DistributedProcessing::PatchFunction& process, size_t& n_sent)
+{
+    return [&process, &n_sent](std::vector<std::vector<char>>& patches) {
+        for (auto& data : patches)
+            data = DistributedProcessing::process_patch(data, process);
+        n_sent += patches.size();
+    };
+}
+
+void expect_closed(const SurfaceMesh& mesh)
+{
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto e : mesh.edges())
+        ASSERT_FALSE(mesh.is_boundary(e));
+}
+
+} // namespace
+
+TEST(DistributedProcessingTest, smoothing)
+{
+    // a noisy sphere
+    auto mesh = SurfaceFactory::icosphere(3);
+    for (auto v : mesh.vertices())
+        mesh.position(v) *= Scalar(1) + Scalar(0.05) * Scalar(v.idx() % 3);
+    auto local = mesh;
+
+    const auto smoothing = DistributedProcessing::smoothing(5);
+    DistributedProcessing(local).run(smoothing, 4);
+
+    size_t n_sent = 0;
+    DistributedProcessing processing(mesh);
+    processing.set_transport(workers(smoothing, n_sent));
+    processing.run(smoothing, 4);
+    EXPECT_EQ(n_sent, 4u + 5u);
+
+    // the connectivity is unchanged and the result independent of where the
+    // patches are processed
+    ASSERT_EQ(mesh.n_vertices(), local.n_vertices());
+    expect_closed(mesh);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), local.position(v));
+
+    // the vertices frozen in the first round are smoothed in the second,
+    // except where the interfaces of both rounds cross
+    auto once = SurfaceFactory::icosphere(3);
+    for (auto v : once.vertices())
+        once.position(v) *= Scalar(1) + Scalar(0.05) * Scalar(v.idx() % 3);
+    const auto noisy = once;
+    DistributedProcessing(once).run(smoothing, 4, 1);
+    size_t n_once = 0, n_twice = 0;
+    for (auto v : mesh.vertices())
+    {
+        n_once += once.position(v) != noisy.position(v);
+        n_twice += mesh.position(v) != noisy.position(v);
+    }
+    EXPECT_GT(n_twice, n_once);
+    EXPECT_GT(n_twice, mesh.n_vertices() * 9 / 10);
+}
+
+TEST(DistributedProcessingTest, remeshing)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const auto n_faces = mesh.n_faces();
+    size_t n_sent = 0;
+    const auto remeshing = DistributedProcessing::remeshing(0.05, 3);
+
+    DistributedProcessing processing(mesh);
+    processing.set_transport(workers(remeshing, n_sent));
+    processing.set_halo_rings(2);
+    processing.run(remeshing, 3);
+    EXPECT_GT(mesh.n_faces(), n_faces);
+    expect_closed(mesh);
+}
+
+TEST(DistributedProcessingTest, simplification)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+    const auto n_vertices = mesh.n_vertices();
+    DistributedProcessing(mesh).run(
+        DistributedProcessing::simplification(0.5), 4, 1);
+    EXPECT_LT(mesh.n_vertices(), n_vertices * 3 / 4);
+    expect_closed(mesh);
+}
+
+TEST(DistributedProcessingTest, errors)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    DistributedProcessing processing(mesh);
+    const auto smoothing = DistributedProcessing::smoothing(1);
+    EXPECT_THROW(processing.run(smoothing, 0), InvalidInputException);
+
+    processing.set_transport(
+        [](std::vector<std::vector<char>>& patches) { patches.pop_back(); });
+    EXPECT_THROW(processing.run(smoothing, 2), InvalidInputException);
+}
@@ -0,0 +1,113 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/EigenMaps.h>
+#include <pmp/SurfaceMesh.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace pmp;
+
+TEST(EigenMapsTest, vector_property)
+{
+    auto mesh = SurfaceFactory::tetrahedron();
+    auto points = mesh.vertex_property<Point>("v:point");
+
+    auto map = eigen_map(points);
+    ASSERT_EQ(map.rows(), Eigen::Index(mesh.n_vertices()));
+    ASSERT_EQ(map.cols(), 3);
+    for (auto v : mesh.vertices())
+        for (int j = 0; j < 3; ++j)
+            EXPECT_EQ(map(v.idx(), j), points[v][j]);
+
+    // writes go to the property
+    map.col(2).setZero();
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(points[v][2], 0);
+
+    const auto cmap = const_eigen_map(points);
+    EXPECT_EQ(cmap.data(), map.data());
+}
+
+TEST(EigenMapsTest, scalar_property)
+{
+    auto mesh = SurfaceFactory::tetrahedron();
+    auto weight = mesh.vertex_property<double>("v:weight", 1.0);
+
+    auto map = eigen_map(weight);
+    ASSERT_EQ(map.size(), Eigen::Index(mesh.n_vertices()));
+    EXPECT_EQ(map.sum(), 4.0);
+    map *= 2.0;
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(weight[v], 2.0);
+    EXPECT_EQ(const_eigen_map(weight).sum(), 8.0);
+}
+
+TEST(EigenMapsTest, copy_on_write)
+{
+    auto mesh = SurfaceFactory::tetrahedron();
+    auto copy = mesh;
+
+    // a copy shares the positions until they are modified through the map
+    eigen_map(mesh.vertex_property<Point>("v:point")).setZero();
+    for (auto v : copy.vertices())
+        EXPECT_GT(norm(copy.position(v)), 0);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(norm(mesh.position(v)), 0);
+}
+
+TEST(EigenMapsTest, external_memory)
+{
+    // positions interleaved with normals in an external buffer
+    auto mesh = SurfaceFactory::tetrahedron();
+    std::vector<Point> buffer;
+    for (auto v : mesh.vertices())
+    {
+        buffer.push_back(mesh.position(v));
+        buffer.push_back(Point(0, 0, 1));
+    }
+    auto points = mesh.vertex_property<Point>("v:point");
+    points.wrap(buffer.data(), 2 * sizeof(Point));
+
+    auto map = eigen_map(points);
+    EXPECT_TRUE(points.is_external());
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(map.row(v.idx()),
+                  Eigen::RowVector3f(Eigen::Vector3f(points[v])));
+    map.col(0).setConstant(5);
+    for (size_t i = 0; i < buffer.size(); i += 2)
+    {
+        EXPECT_EQ(buffer[i][0], 5);
+        EXPECT_EQ(buffer[i + 1], Point(0, 0, 1));
+    }
+}
+
+TEST(EigenMapsTest, gather_scatter)
+{
+    auto mesh = SurfaceFactory::icosahedron();
+    auto points = mesh.vertex_property<Point>("v:point");
+    const std::vector<Vertex> vertices{Vertex(3), Vertex(0), Vertex(7)};
+
+    Eigen::MatrixXd X = gather_rows(points, vertices);
+    ASSERT_EQ(X.rows(), 3);
+    ASSERT_EQ(X.cols(), 3);
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            EXPECT_EQ(X(i, j), double(points[vertices[i]][j]));
+
+    X *= 2.0;
+    const auto before = mesh.positions();
+    scatter_rows(X, vertices, points);
+    for (auto v : mesh.vertices())
+    {
+        const bool scattered =
+            std::find(vertices.begin(), vertices.end(), v) != vertices.end();
+        const Point expected = scattered ? 2 * before[v.idx()]
+                                         : before[v.idx()];
+        EXPECT_EQ(points[v], expected);
+    }
+}
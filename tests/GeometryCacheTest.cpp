@@ -0,0 +1,71 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/GeometryCache.h"
+#include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+
+using namespace pmp;
+
+TEST(GeometryCacheTest, values)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    GeometryCache cache(mesh);
+    EXPECT_TRUE(cache.update());
+
+    for (auto e : mesh.edges())
+        EXPECT_DOUBLE_EQ(cache.cotan_weight(e), cotan_weight(mesh, e));
+    for (auto v : mesh.vertices())
+        EXPECT_DOUBLE_EQ(cache.voronoi_area(v), voronoi_area(mesh, v));
+}
+
+TEST(GeometryCacheTest, invalidation)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    mesh.set_change_tracking(true);
+    GeometryCache cache(mesh);
+    EXPECT_FALSE(cache.is_valid());
+    EXPECT_TRUE(cache.update());
+    EXPECT_TRUE(cache.is_valid());
+    EXPECT_FALSE(cache.update());
+
+    // a second cache shares the values
+    {
+        GeometryCache shared(mesh);
+        EXPECT_TRUE(shared.is_valid());
+        EXPECT_FALSE(shared.update());
+    }
+    EXPECT_TRUE(mesh.has_edge_property("geometry:cotan"));
+
+    // moving a vertex invalidates the values
+    const Vertex v(0);
+    mesh.position(v) *= Scalar(1.1);
+    EXPECT_FALSE(cache.is_valid());
+    EXPECT_TRUE(cache.update());
+    EXPECT_DOUBLE_EQ(cache.voronoi_area(v), voronoi_area(mesh, v));
+
+    // so does changing the connectivity
+    mesh.flip(*mesh.edges().begin());
+    EXPECT_FALSE(cache.is_valid());
+}
+
+TEST(GeometryCacheTest, no_change_tracking)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    GeometryCache cache(mesh);
+    EXPECT_TRUE(cache.update());
+    EXPECT_TRUE(cache.update());
+}
+
+TEST(GeometryCacheTest, remove_properties)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    {
+        GeometryCache cache(mesh);
+        cache.update();
+    }
+    EXPECT_FALSE(mesh.has_edge_property("geometry:cotan"));
+    EXPECT_FALSE(mesh.has_vertex_property("geometry:area"));
+}
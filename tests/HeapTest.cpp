@@ -0,0 +1,123 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/SurfaceMesh.h>
+#include <pmp/algorithms/Heap.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+// heap of indices into shared key and position arrays
+class IndexHeapInterface
+{
+public:
+    IndexHeapInterface(std::vector<float>& keys, std::vector<int>& pos)
+        : keys_(&keys), pos_(&pos)
+    {
+    }
+
+    bool less(int a, int b) { return (*keys_)[a] < (*keys_)[b]; }
+    bool greater(int a, int b) { return (*keys_)[a] > (*keys_)[b]; }
+    int get_heap_position(int i) { return (*pos_)[i]; }
+    void set_heap_position(int i, int pos) { (*pos_)[i] = pos; }
+
+private:
+    std::vector<float>* keys_;
+    std::vector<int>* pos_;
+};
+
+} // namespace
+
+TEST(HeapTest, build)
+{
+    const int n = 1000;
+    std::vector<float> keys(n);
+    std::vector<int> pos(n, -1);
+    std::srand(42);
+    for (auto& k : keys)
+        k = float(std::rand() % 100);
+
+    // every other index goes on the heap
+    std::vector<int> entries;
+    for (int i = 0; i < n; i += 2)
+        entries.push_back(i);
+
+    Heap<int, IndexHeapInterface> heap(IndexHeapInterface(keys, pos));
+    heap.build(entries);
+    EXPECT_EQ(heap.size(), unsigned(n / 2));
+    EXPECT_TRUE(heap.check());
+    for (int i = 0; i < n; ++i)
+        EXPECT_EQ(heap.is_stored(i), i % 2 == 0);
+
+    // updates and removals keep working on the built heap
+    keys[10] = -1;
+    heap.update(10);
+    heap.remove(20);
+    EXPECT_TRUE(heap.check());
+    EXPECT_EQ(heap.front(), 10);
+
+    float last = -2;
+    while (!heap.empty())
+    {
+        EXPECT_LE(last, keys[heap.front()]);
+        last = keys[heap.front()];
+        heap.pop_front();
+    }
+    EXPECT_FALSE(heap.is_stored(0));
+}
+
+TEST(HeapTest, d_ary_heap)
+{
+    const int n = 1000;
+    std::vector<float> keys(n);
+    std::srand(42);
+    for (auto& k : keys)
+        k = float(std::rand() % 100);
+
+    DAryHeap<Vertex, float> heap;
+    std::vector<std::pair<Vertex, float>> entries;
+    for (int i = 0; i < n; i += 2)
+        entries.emplace_back(Vertex(i), keys[i]);
+    heap.build(entries);
+    for (int i = 1; i < n; i += 2)
+        heap.insert(Vertex(i), keys[i]);
+    EXPECT_EQ(heap.size(), size_t(n));
+    EXPECT_TRUE(heap.check());
+
+    // updates, removals, and lazy removals
+    keys[10] = -1;
+    heap.update(Vertex(10), keys[10]);
+    heap.remove(Vertex(20));
+    for (int i = 100; i < 200; ++i)
+        heap.lazy_remove(Vertex(i));
+    EXPECT_TRUE(heap.check());
+    EXPECT_EQ(heap.size(), size_t(n - 101));
+    EXPECT_FALSE(heap.is_stored(Vertex(150)));
+    EXPECT_EQ(heap.front(), Vertex(10));
+    EXPECT_EQ(heap.priority(Vertex(11)), keys[11]);
+
+    // equal priorities come in order of the handle index
+    float last_key = -2;
+    Vertex last;
+    size_t n_popped = 0;
+    while (!heap.empty())
+    {
+        const Vertex v = heap.front();
+        EXPECT_EQ(heap.front_priority(), keys[v.idx()]);
+        EXPECT_TRUE(last_key < keys[v.idx()] ||
+                    (last_key == keys[v.idx()] && last < v));
+        EXPECT_FALSE(v.idx() >= 100 && v.idx() < 200);
+        last_key = keys[v.idx()];
+        last = v;
+        heap.pop_front();
+        ++n_popped;
+    }
+    EXPECT_EQ(n_popped, size_t(n - 101));
+    EXPECT_TRUE(heap.check());
+}
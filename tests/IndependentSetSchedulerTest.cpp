@@ -0,0 +1,190 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/IndependentSetScheduler.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceTriangulation.h>
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace pmp;
+
+namespace {
+
+// flip e if this reduces the deviation from valence six
+bool improve_valence(SurfaceMesh& mesh, Edge e)
+{
+    if (mesh.is_deleted(e) || mesh.is_boundary(e) || !mesh.is_flip_ok(e))
+        return false;
+
+    auto h0 = mesh.halfedge(e, 0);
+    auto h1 = mesh.halfedge(e, 1);
+    auto v0 = mesh.to_vertex(h0);
+    auto v1 = mesh.to_vertex(h1);
+    auto v2 = mesh.to_vertex(mesh.next_halfedge(h0));
+    auto v3 = mesh.to_vertex(mesh.next_halfedge(h1));
+
+    int d0 = int(mesh.valence(v0)) - 6;
+    int d1 = int(mesh.valence(v1)) - 6;
+    int d2 = int(mesh.valence(v2)) - 6;
+    int d3 = int(mesh.valence(v3)) - 6;
+    int before = std::abs(d0) + std::abs(d1) + std::abs(d2) + std::abs(d3);
+    int after = std::abs(d0 - 1) + std::abs(d1 - 1) + std::abs(d2 + 1) +
+                std::abs(d3 + 1);
+    if (after >= before)
+        return false;
+
+    mesh.flip(e);
+    return true;
+}
+
+SurfaceMesh triangulated_uv_sphere()
+{
+    auto mesh = SurfaceFactory::uv_sphere(Point(0, 0, 0), 1, 20, 20);
+    SurfaceTriangulation(mesh).triangulate();
+    return mesh;
+}
+
+void flip_all(SurfaceMesh& mesh, bool parallel, size_t& n_flips,
+              unsigned int& n_rounds)
+{
+    std::vector<Edge> edges;
+    for (auto e : mesh.edges())
+        edges.push_back(e);
+    IndependentSetScheduler scheduler(mesh);
+    n_flips = scheduler.run(
+        edges,
+        [&](Edge e, std::vector<Vertex>& region) {
+            IndependentSetScheduler::edge_region(mesh, e, region);
+        },
+        [&](Edge e) { return improve_valence(mesh, e); }, parallel);
+    n_rounds = scheduler.n_rounds();
+}
+
+} // namespace
+
+TEST(IndependentSetSchedulerTest, parallel_flips)
+{
+    auto serial = triangulated_uv_sphere();
+    auto parallel = triangulated_uv_sphere();
+
+    size_t n_serial, n_parallel;
+    unsigned int rounds_serial, rounds_parallel;
+    flip_all(serial, false, n_serial, rounds_serial);
+    flip_all(parallel, true, n_parallel, rounds_parallel);
+
+    EXPECT_GT(n_serial, 0u);
+    EXPECT_GT(rounds_serial, 1u);
+    EXPECT_EQ(n_serial, n_parallel);
+    EXPECT_EQ(rounds_serial, rounds_parallel);
+    EXPECT_TRUE(parallel.validate().empty());
+
+    // independent batches give the same result for any number of threads
+    for (auto f : serial.faces())
+    {
+        auto fv = serial.vertices(f);
+        auto fvp = parallel.vertices(Face(f.idx()));
+        for (auto v : fv)
+        {
+            EXPECT_EQ(v, *fvp);
+            ++fvp;
+        }
+    }
+}
+
+TEST(IndependentSetSchedulerTest, conflict_free_batches)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    std::vector<Edge> edges;
+    for (auto e : mesh.edges())
+        edges.push_back(e);
+
+    IndependentSetScheduler scheduler(mesh);
+    std::vector<unsigned int> touched(mesh.n_vertices(), 0);
+    unsigned int batch = 0;
+    bool scheduling = false;
+    size_t n_conflicts = 0, n_visited = 0;
+
+    // all regions of a round are computed before its batch is applied
+    scheduler.run(
+        edges,
+        [&](Edge e, std::vector<Vertex>& region) {
+            scheduling = true;
+            IndependentSetScheduler::edge_region(mesh, e, region);
+        },
+        [&](Edge e) {
+            if (scheduling)
+                ++batch;
+            scheduling = false;
+            ++n_visited;
+            std::vector<Vertex> region;
+            IndependentSetScheduler::edge_region(mesh, e, region);
+            for (auto v : region)
+            {
+                if (touched[v.idx()] == batch)
+                    ++n_conflicts;
+                touched[v.idx()] = batch;
+            }
+            return false;
+        },
+        false);
+
+    EXPECT_EQ(n_visited, mesh.n_edges());
+    EXPECT_EQ(n_conflicts, 0u);
+    EXPECT_GT(scheduler.n_rounds(), 1u);
+}
+
+TEST(IndependentSetSchedulerTest, collapse_batches)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const auto n_vertices = mesh.n_vertices();
+
+    std::vector<Halfedge> halfedges;
+    for (auto e : mesh.edges())
+        if (e.idx() % 7 == 0)
+            halfedges.push_back(mesh.halfedge(e, 0));
+
+    IndependentSetScheduler scheduler(mesh);
+    auto n_collapses = scheduler.run(
+        halfedges,
+        [&](Halfedge h, std::vector<Vertex>& region) {
+            if (mesh.is_deleted(h))
+                return;
+            IndependentSetScheduler::vertex_region(mesh, mesh.from_vertex(h),
+                                                   region);
+            IndependentSetScheduler::vertex_region(mesh, mesh.to_vertex(h),
+                                                   region);
+        },
+        [&](Halfedge h) {
+            if (mesh.is_deleted(h) || !mesh.is_collapse_ok(h))
+                return false;
+            mesh.collapse(h);
+            return true;
+        },
+        false);
+
+    EXPECT_GT(n_collapses, 0u);
+    EXPECT_EQ(mesh.n_vertices(), n_vertices - n_collapses);
+    EXPECT_TRUE(mesh.validate().empty());
+}
+
+TEST(IndependentSetSchedulerTest, exception)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    std::vector<Vertex> vertices;
+    for (auto v : mesh.vertices())
+        vertices.push_back(v);
+    IndependentSetScheduler scheduler(mesh);
+    auto region = [&](Vertex v, std::vector<Vertex>& r) {
+        IndependentSetScheduler::vertex_region(mesh, v, r);
+    };
+    auto fail = [](Vertex v) {
+        if (v.idx() == 5)
+            throw std::runtime_error("failure");
+        return true;
+    };
+    EXPECT_THROW(scheduler.run(vertices, region, fail), std::runtime_error);
+}
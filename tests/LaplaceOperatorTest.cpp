@@ -0,0 +1,138 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/DifferentialGeometry.h"
+#include "Helpers.h"
+
+using namespace pmp;
+
+using SparseMatrix = Eigen::SparseMatrix<double>;
+
+// Laplacian of all vertices assembled from triplets
+static SparseMatrix reference_laplace(const SurfaceMesh& mesh)
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (auto v : mesh.vertices())
+    {
+        double sum = 0.0;
+        for (auto h : mesh.halfedges(v))
+        {
+            const double w = std::max(0.0, cotan_weight(mesh, mesh.edge(h)));
+            triplets.emplace_back(v.idx(), mesh.to_vertex(h).idx(), w);
+            sum += w;
+        }
+        triplets.emplace_back(v.idx(), v.idx(), -sum);
+    }
+    SparseMatrix L(mesh.n_vertices(), mesh.n_vertices());
+    L.setFromTriplets(triplets.begin(), triplets.end());
+    return L;
+}
+
+// the interior vertices of the mesh
+static std::vector<Vertex> interior_vertices(const SurfaceMesh& mesh)
+{
+    std::vector<Vertex> vertices;
+    for (auto v : mesh.vertices())
+        if (!mesh.is_boundary(v))
+            vertices.push_back(v);
+    return vertices;
+}
+
+// expect op to be the restriction of the operator full of all vertices
+static void expect_restriction(const LaplaceOperator& op,
+                               const std::vector<Vertex>& free_vertices,
+                               const Eigen::MatrixXd& full)
+{
+    const auto& constraints = op.constraint_vertices();
+    const Eigen::MatrixXd A = op.matrix();
+    const Eigen::MatrixXd C = op.constraint_matrix();
+    for (size_t i = 0; i < free_vertices.size(); ++i)
+    {
+        const auto r = free_vertices[i].idx();
+        for (size_t j = 0; j < free_vertices.size(); ++j)
+            EXPECT_NEAR(A(i, j), full(r, free_vertices[j].idx()), 1e-8);
+        for (size_t j = 0; j < constraints.size(); ++j)
+            EXPECT_NEAR(C(i, j), full(r, constraints[j].idx()), 1e-8);
+    }
+}
+
+TEST(LaplaceOperatorTest, laplace)
+{
+    auto mesh = hemisphere();
+    auto free_vertices = interior_vertices(mesh);
+    std::reverse(free_vertices.begin(), free_vertices.end());
+
+    LaplaceOperator op(mesh, free_vertices);
+    ASSERT_EQ(op.matrix().rows(), Eigen::Index(free_vertices.size()));
+    EXPECT_FALSE(op.constraint_vertices().empty());
+    for (auto v : op.constraint_vertices())
+        EXPECT_TRUE(mesh.is_boundary(v));
+    for (size_t i = 0; i < free_vertices.size(); ++i)
+        EXPECT_DOUBLE_EQ(op.mass()[i], voronoi_area(mesh, free_vertices[i]));
+
+    expect_restriction(op, free_vertices, reference_laplace(mesh));
+}
+
+TEST(LaplaceOperatorTest, bi_laplace)
+{
+    auto mesh = hemisphere();
+
+    // fair the upper part
+    std::vector<Vertex> free_vertices;
+    Eigen::VectorXd inverse_mass(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+    {
+        if (mesh.position(v)[1] > 0.5)
+            free_vertices.push_back(v);
+        inverse_mass[v.idx()] = 1.0 / voronoi_area(mesh, v);
+    }
+
+    const SparseMatrix L = reference_laplace(mesh);
+    const SparseMatrix LL = L * inverse_mass.asDiagonal() * L;
+    expect_restriction(LaplaceOperator(mesh, free_vertices, 2), free_vertices,
+                       LL);
+}
+
+TEST(LaplaceOperatorTest, uniform)
+{
+    auto mesh = hemisphere();
+    const auto free_vertices = interior_vertices(mesh);
+    LaplaceOperator op(mesh, free_vertices, 1, true);
+
+    const Eigen::MatrixXd A = op.matrix();
+    for (size_t i = 0; i < free_vertices.size(); ++i)
+    {
+        EXPECT_EQ(A(i, i), -double(mesh.valence(free_vertices[i])));
+        EXPECT_EQ(op.mass()[i], 1.0);
+    }
+}
+
+TEST(LaplaceOperatorTest, update)
+{
+    auto mesh = hemisphere();
+    const auto free_vertices = interior_vertices(mesh);
+    LaplaceOperator op(mesh, free_vertices, 2);
+    const double* values = op.matrix().valuePtr();
+
+    for (auto v : mesh.vertices())
+        mesh.position(v)[1] *= Scalar(0.5);
+    op.update();
+
+    // the values are refilled in place
+    EXPECT_EQ(op.matrix().valuePtr(), values);
+    const Eigen::MatrixXd A = op.matrix();
+    const Eigen::MatrixXd B = LaplaceOperator(mesh, free_vertices, 2).matrix();
+    EXPECT_NEAR((A - B).norm(), 0.0, 1e-10);
+}
+
+TEST(LaplaceOperatorTest, degree)
+{
+    auto mesh = hemisphere();
+    EXPECT_THROW(LaplaceOperator(mesh, interior_vertices(mesh), 0),
+                 InvalidInputException);
+}
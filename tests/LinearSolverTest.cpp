@@ -0,0 +1,106 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/LinearSolver.h"
+#include "pmp/algorithms/LaplaceOperator.h"
+#include "pmp/algorithms/SurfaceFairing.h"
+#include "Helpers.h"
+
+using namespace pmp;
+
+using Type = LinearSolver::Type;
+
+static const Type types[] = {Type::LDLT, Type::CholmodLLT, Type::PardisoLDLT,
+                             Type::ConjugateGradient, Type::Multigrid};
+
+// positive definite system of the Laplacian of the interior vertices
+class LinearSolverTest : public ::testing::Test
+{
+public:
+    LinearSolverTest() : mesh(subdivided_icosahedron())
+    {
+        std::vector<Vertex> free_vertices;
+        for (auto v : mesh.vertices())
+            if (mesh.position(v)[2] > -0.8)
+                free_vertices.push_back(v);
+
+        LaplaceOperator laplace(mesh, free_vertices);
+        A = -laplace.matrix();
+        B = Eigen::MatrixXd::Random(A.rows(), 3);
+    }
+
+    SurfaceMesh mesh;
+    LinearSolver::SparseMatrix A;
+    Eigen::MatrixXd B;
+};
+
+TEST_F(LinearSolverTest, backends)
+{
+    for (auto type : types)
+    {
+        if (!LinearSolver::is_available(type))
+        {
+            EXPECT_THROW(LinearSolver solver(type), InvalidInputException);
+            continue;
+        }
+
+        LinearSolver solver(type);
+        EXPECT_EQ(solver.type(), type);
+        solver.compute(A);
+        Eigen::MatrixXd X;
+        ASSERT_TRUE(solver.solve(B, X));
+        EXPECT_LT((A * X - B).norm(), 1e-6 * B.norm());
+    }
+}
+
+TEST_F(LinearSolverTest, refactorize)
+{
+    for (auto type : types)
+    {
+        if (!LinearSolver::is_available(type))
+            continue;
+
+        // same pattern, other values
+        LinearSolver solver(type);
+        solver.compute(A);
+        const LinearSolver::SparseMatrix A2 = 2.0 * A;
+        solver.factorize(A2);
+        Eigen::MatrixXd X;
+        ASSERT_TRUE(solver.solve(B, X));
+        EXPECT_LT((A2 * X - B).norm(), 1e-6 * B.norm());
+    }
+}
+
+TEST_F(LinearSolverTest, warm_start)
+{
+    LinearSolver direct;
+    direct.compute(A);
+    Eigen::MatrixXd X;
+    ASSERT_TRUE(direct.solve(B, X));
+
+    // starting from the solution, conjugate gradients stay there
+    LinearSolver solver(Type::ConjugateGradient);
+    solver.set_max_iterations(1);
+    solver.compute(A);
+    Eigen::MatrixXd Y = X;
+    ASSERT_TRUE(solver.solve(B, Y));
+    EXPECT_LT((X - Y).norm(), 1e-6 * X.norm());
+}
+
+TEST(LinearSolverDefaultTest, fairing)
+{
+    // fairing results do not depend on the backend
+    auto reference = hemisphere();
+    SurfaceFairing(reference).fair(2);
+
+    EXPECT_EQ(LinearSolver::default_type(), Type::LDLT);
+    LinearSolver::set_default_type(Type::Multigrid);
+    auto mesh = hemisphere();
+    SurfaceFairing(mesh).fair(2);
+    LinearSolver::set_default_type(Type::LDLT);
+
+    for (auto v : mesh.vertices())
+        EXPECT_LT(distance(mesh.position(v), reference.position(v)), 1e-4);
+}
@@ -0,0 +1,79 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/MatVec.h>
+
+using namespace pmp;
+
+namespace {
+
+// a matrix with distinct integer entries, whose products are exact
+template <int M, int N>
+Matrix<double, M, N> test_matrix(int offset)
+{
+    Matrix<double, M, N> m;
+    for (int i = 0; i < m.size(); ++i)
+        m[i] = offset + i - (i * i) % 7;
+    return m;
+}
+
+// the product computed by Eigen
+template <int M, int K, int N>
+Matrix<double, M, N> eigen_product(const Matrix<double, M, K>& m1,
+                                   const Matrix<double, K, N>& m2)
+{
+    const Eigen::Matrix<double, M, K> e1 = m1;
+    const Eigen::Matrix<double, K, N> e2 = m2;
+    const Eigen::Matrix<double, M, N> e = e1 * e2;
+    return e;
+}
+
+} // namespace
+
+TEST(MatVecTest, matrix_products)
+{
+    const auto a3 = test_matrix<3, 3>(1), b3 = test_matrix<3, 3>(-2);
+    const auto a4 = test_matrix<4, 4>(1), b4 = test_matrix<4, 4>(-2);
+    const auto v3 = test_matrix<3, 1>(3);
+    const auto v4 = test_matrix<4, 1>(3);
+
+    EXPECT_EQ(a3 * b3, eigen_product(a3, b3));
+    EXPECT_EQ(a4 * b4, eigen_product(a4, b4));
+    EXPECT_EQ(a3 * v3, eigen_product(a3, v3));
+    EXPECT_EQ(a4 * v4, eigen_product(a4, v4));
+
+    // non-square products use the generic implementation
+    const auto a34 = test_matrix<3, 4>(1);
+    EXPECT_EQ(a34 * v4, eigen_product(a34, v4));
+    EXPECT_EQ(a34 * b4, eigen_product(a34, b4));
+
+    EXPECT_EQ(dmat4::identity() * a4, a4);
+    EXPECT_EQ(a3 * dmat3::identity(), a3);
+}
+
+TEST(MatVecTest, vector_products)
+{
+    const vec2 a2(1, 2), b2(-3, 4);
+    const vec3 a3(1, 2, 3), b3(-4, 5, 6);
+    const vec4 a4(1, 2, 3, 4), b4(-5, 6, 7, 8);
+
+    EXPECT_EQ(dot(a2, b2), 5);
+    EXPECT_EQ(dot(a3, b3), 24);
+    EXPECT_EQ(dot(a4, b4), 60);
+    EXPECT_EQ(dot(vec8(1), vec8(2)), 16);
+
+    EXPECT_EQ(sqrnorm(a2), 5);
+    EXPECT_EQ(sqrnorm(a3), 14);
+    EXPECT_EQ(sqrnorm(a4), 30);
+    EXPECT_FLOAT_EQ(norm(a3), std::sqrt(14.0f));
+
+    EXPECT_FLOAT_EQ(distance(a2, b2), std::sqrt(20.0f));
+    EXPECT_FLOAT_EQ(distance(a3, b3), std::sqrt(43.0f));
+    EXPECT_FLOAT_EQ(distance(a4, b4), std::sqrt(84.0f));
+
+    EXPECT_FLOAT_EQ(norm(normalize(b3)), 1);
+    EXPECT_EQ(dot(cross(a3, b3), a3), 0);
+    EXPECT_EQ(dot(cross(a3, b3), b3), 0);
+}
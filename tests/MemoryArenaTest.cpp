@@ -0,0 +1,98 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/MemoryArena.h>
+#include <pmp/SurfaceMesh.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace pmp;
+
+TEST(MemoryArenaTest, allocate)
+{
+    MemoryArena arena(1024);
+    auto a = arena.allocate(3, 1);
+    auto b = arena.allocate(8, 64);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 64, 0u);
+    EXPECT_EQ(arena.bytes_used(), 11u);
+
+    // larger than a block
+    auto c = arena.allocate<double>(1000);
+    c[999] = 1.0;
+    EXPECT_GE(arena.bytes_reserved(), 1000 * sizeof(double));
+}
+
+TEST(MemoryArenaTest, reset)
+{
+    MemoryArena arena(256);
+    auto first = arena.allocate<int>(10);
+    for (int i = 0; i < 100; ++i)
+        arena.allocate<int>(10);
+    const auto reserved = arena.bytes_reserved();
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_EQ(arena.allocate<int>(10), first);
+    for (int i = 0; i < 100; ++i)
+        arena.allocate<int>(10);
+    EXPECT_EQ(arena.bytes_reserved(), reserved);
+
+    arena.release();
+    EXPECT_EQ(arena.bytes_reserved(), 0u);
+}
+
+TEST(MemoryArenaTest, allocator)
+{
+    MemoryArena arena;
+    std::vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 1000; ++i)
+        values.push_back(i);
+    EXPECT_EQ(values[999], 999);
+    EXPECT_GE(arena.bytes_used(), 1000 * sizeof(int));
+}
+
+TEST(MemoryArenaTest, mesh)
+{
+    auto ico = SurfaceFactory::icosphere(1);
+    MemoryArena arena;
+    {
+        SurfaceMesh mesh;
+        mesh.reserve(ico.n_vertices(), ico.n_edges(), ico.n_faces(), arena);
+        EXPECT_TRUE(mesh.get_vertex_property<Point>("v:point").is_external());
+        EXPECT_GT(arena.bytes_used(), 0u);
+        const auto used = arena.bytes_used();
+
+        for (auto v : ico.vertices())
+            mesh.add_vertex(ico.position(v));
+        for (auto f : ico.faces())
+        {
+            std::vector<Vertex> vertices;
+            for (auto v : ico.vertices(f))
+                vertices.push_back(v);
+            mesh.add_face(vertices);
+        }
+
+        // the whole mesh fits into the reserved arena memory
+        EXPECT_EQ(arena.bytes_used(), used);
+        EXPECT_TRUE(mesh.get_vertex_property<Point>("v:point").is_external());
+        EXPECT_EQ(mesh.n_faces(), ico.n_faces());
+        EXPECT_TRUE(mesh.validate().empty());
+
+        // copies use internal storage
+        SurfaceMesh copy(mesh);
+        EXPECT_FALSE(copy.get_vertex_property<Point>("v:point").is_external());
+
+        // growing beyond the reserved size leaves the arena
+        auto v = mesh.split(Face(0), Point(0, 0, 0));
+        EXPECT_FALSE(mesh.get_vertex_property<Point>("v:point").is_external());
+        EXPECT_EQ(mesh.position(v), Point(0, 0, 0));
+        EXPECT_EQ(mesh.position(Vertex(3)), ico.position(Vertex(3)));
+        EXPECT_TRUE(mesh.validate().empty());
+    }
+    arena.reset();
+}
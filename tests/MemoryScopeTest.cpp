@@ -0,0 +1,60 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/MemoryScope.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+// touch n bytes so that they become resident, then free them
+void allocate_and_free(size_t n)
+{
+    std::vector<char> buffer(n);
+    std::memset(buffer.data(), 1, n);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+} // namespace
+
+#ifdef __linux__
+TEST(MemoryScopeTest, peak_after_free)
+{
+    const size_t n = 64 << 20;
+    MemoryScope outer;
+    {
+        MemoryScope inner;
+        allocate_and_free(n);
+        EXPECT_GE(inner.peak_extra(), n / 2);
+    }
+
+    // the peak is kept after the memory was returned
+    EXPECT_GE(outer.peak_extra(), n / 2);
+
+    // a scope opened afterwards starts from the current memory
+    MemoryScope later;
+    EXPECT_LT(later.peak_extra(), n / 2);
+}
+#endif
+
+#ifdef __linux__
+TEST(MemoryScopeTest, without_sampling)
+{
+    // peak_extra() still samples the current memory
+    const size_t n = 64 << 20;
+    MemoryScope::set_sampling_interval(0);
+    {
+        MemoryScope scope;
+        std::vector<char> buffer(n, 1);
+        EXPECT_GE(scope.peak_extra(), n / 2);
+    }
+    MemoryScope::set_sampling_interval(5);
+}
+#endif
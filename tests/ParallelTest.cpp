@@ -0,0 +1,183 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/Parallel.h>
+#include <pmp/algorithms/DifferentialGeometry.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceSimplification.h>
+#include <pmp/algorithms/SurfaceSmoothing.h>
+
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace pmp;
+
+TEST(ParallelTest, vertices)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    auto vidx = mesh.add_vertex_property<int>("v:idx", -1);
+    parallel_for(
+        mesh.vertices(), [&](Vertex v) { vidx[v] = v.idx(); }, 16);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(vidx[v], int(v.idx()));
+}
+
+TEST(ParallelTest, skip_deleted)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    mesh.delete_face(Face(0));
+    mesh.delete_face(Face(mesh.faces_size() - 1));
+
+    auto visited = mesh.add_face_property<int>("f:visited", 0);
+    parallel_for(
+        mesh.faces(), [&](Face f) { visited[f]++; }, 7);
+
+    for (auto f : mesh.faces())
+        EXPECT_EQ(visited[f], 1);
+    EXPECT_EQ(visited[Face(0)], 0);
+    EXPECT_EQ(visited[Face(mesh.faces_size() - 1)], 0);
+}
+
+TEST(ParallelTest, dense_range)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    auto visited = mesh.add_face_property<int>("f:visited", 0);
+    parallel_for(
+        mesh.dense_faces(), [&](Face f) { visited[f]++; }, 7);
+    for (auto f : mesh.faces())
+        EXPECT_EQ(visited[f], 1);
+}
+
+TEST(ParallelTest, halfedges_and_edges)
+{
+    auto mesh = SurfaceFactory::tetrahedron();
+    auto hcount = mesh.add_halfedge_property<int>("h:count", 0);
+    auto ecount = mesh.add_edge_property<int>("e:count", 0);
+    parallel_for(mesh.halfedges(), [&](Halfedge h) { hcount[h]++; });
+    parallel_for(mesh.edges(), [&](Edge e) { ecount[e]++; });
+    for (auto h : mesh.halfedges())
+        EXPECT_EQ(hcount[h], 1);
+    for (auto e : mesh.edges())
+        EXPECT_EQ(ecount[e], 1);
+}
+
+TEST(ParallelTest, exception)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    auto fn = [](Vertex v) {
+        if (v.idx() == 5)
+            throw std::runtime_error("failure");
+    };
+    EXPECT_THROW(parallel_for(mesh.vertices(), fn, 4), std::runtime_error);
+}
+
+TEST(ParallelTest, indices)
+{
+    std::vector<int> visited(1000, 0);
+    parallel_for(
+        10, 990, [&](int i) { visited[i]++; }, 16);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(visited[i], i >= 10 && i < 990 ? 1 : 0);
+}
+
+TEST(ParallelTest, reduce)
+{
+    auto sum = [](int n) {
+        return parallel_reduce(
+            0, n, 0.0, [](int i) { return 1.0 / (i + 1); },
+            [](double a, double b) { return a + b; }, 64);
+    };
+    EXPECT_NEAR(sum(100000), 12.0901, 1e-4);
+    EXPECT_EQ(sum(0), 0.0);
+
+    // the same rounding for any number of threads
+    Parallel::set_deterministic(true);
+    Parallel::set_n_threads(1);
+    const double one = sum(100000);
+    Parallel::set_n_threads(3);
+#ifdef _OPENMP
+    EXPECT_EQ(Parallel::n_threads(), 3);
+#endif
+    EXPECT_EQ(sum(100000), one);
+    Parallel::set_n_threads(0);
+    Parallel::set_deterministic(false);
+}
+
+TEST(ParallelTest, executor)
+{
+    // run the tasks on two threads of their own
+    std::atomic<int> n_calls(0);
+    Parallel::set_executor(
+        [&](int n_tasks, const std::function<void(int)>& task) {
+            ++n_calls;
+            std::atomic<int> next(0);
+            auto worker = [&]() {
+                for (int i; (i = next++) < n_tasks;)
+                    task(i);
+            };
+            std::thread thread(worker);
+            worker();
+            thread.join();
+        });
+    EXPECT_TRUE(Parallel::has_executor());
+
+    auto mesh = SurfaceFactory::icosphere(3);
+    auto vidx = mesh.add_vertex_property<int>("v:idx", -1);
+    auto nested = mesh.add_vertex_property<int>("v:nested", 0);
+    parallel_for(
+        mesh.vertices(),
+        [&](Vertex v) {
+            vidx[v] = v.idx();
+            // runs sequentially instead of waiting for the executor
+            parallel_for(
+                0, 4, [&](int) { nested[v]++; }, 1);
+        },
+        16);
+    EXPECT_EQ(n_calls, 1);
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(vidx[v], int(v.idx()));
+        EXPECT_EQ(nested[v], 4);
+    }
+
+    auto fn = [](Vertex v) {
+        if (v.idx() == 5)
+            throw std::runtime_error("failure");
+    };
+    EXPECT_THROW(parallel_for(mesh.vertices(), fn, 4), std::runtime_error);
+
+    Parallel::set_executor(nullptr);
+    EXPECT_FALSE(Parallel::has_executor());
+}
+
+TEST(ParallelTest, reproducible)
+{
+    // smooth and simplify a noisy sphere, report area and positions
+    auto run = [](int n_threads, std::vector<Point>& points) {
+        Parallel::set_n_threads(n_threads);
+        auto mesh = SurfaceFactory::icosphere(4);
+        for (auto v : mesh.vertices())
+            mesh.position(v) *= 1 + 0.01 * std::sin(13.0 * v.idx());
+        SurfaceSmoothing(mesh).explicit_smoothing(3);
+        SurfaceSimplification simplification(mesh);
+        simplification.initialize(5);
+        simplification.simplify_parallel(mesh.n_vertices() / 4);
+        points = mesh.positions();
+        return surface_area(mesh);
+    };
+
+    Parallel::set_deterministic(true);
+    std::vector<Point> one, three;
+    const Scalar area = run(1, one);
+    EXPECT_EQ(run(3, three), area);
+    ASSERT_EQ(one.size(), three.size());
+    for (size_t i = 0; i < one.size(); ++i)
+        EXPECT_EQ(one[i], three[i]);
+    Parallel::set_n_threads(0);
+    Parallel::set_deterministic(false);
+}
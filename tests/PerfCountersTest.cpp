@@ -0,0 +1,84 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/PerfCounters.h>
+
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+// a loop of roughly n instructions
+double work(size_t n)
+{
+    std::vector<double> values(1024, 1.0);
+    double sum = 0;
+    for (size_t i = 0; i < n / 4; ++i)
+        sum += values[i % values.size()];
+    return sum;
+}
+
+class PerfCountersTest : public ::testing::Test
+{
+public:
+    PerfCountersTest() : enabled_(PerfCounters::is_enabled()) {}
+    ~PerfCountersTest() override { PerfCounters::set_enabled(enabled_); }
+
+private:
+    bool enabled_;
+};
+
+} // namespace
+
+TEST_F(PerfCountersTest, counts)
+{
+    PerfCounts a;
+    a.cycles = 10;
+    a.instructions = 20;
+    PerfCounts b = a;
+    b += a;
+    EXPECT_EQ(b.instructions, 40u);
+    EXPECT_EQ((b - a).cycles, 10u);
+    EXPECT_EQ((a - b).cycles, 0u);
+    EXPECT_DOUBLE_EQ(a.ipc(), 2.0);
+    EXPECT_TRUE(a.is_valid());
+    EXPECT_FALSE(PerfCounts().is_valid());
+    EXPECT_EQ(PerfCounts().ipc(), 0.0);
+}
+
+TEST_F(PerfCountersTest, disabled)
+{
+    PerfCounters::set_enabled(false);
+    PerfCounterScope scope;
+    volatile double sum = work(1000000);
+    (void)sum;
+    EXPECT_FALSE(scope.counts().is_valid());
+    EXPECT_FALSE(PerfCounters::thread_counts().is_valid());
+}
+
+TEST_F(PerfCountersTest, scope)
+{
+    PerfCounters::set_enabled(true);
+    if (!PerfCounters::is_available())
+    {
+        // e.g., in a virtual machine or a container without permission
+        EXPECT_FALSE(PerfCounters::thread_counts().is_valid());
+        return;
+    }
+
+    PerfCounterScope scope;
+    volatile double sum = work(10000000);
+    (void)sum;
+    const PerfCounts counts = scope.counts();
+    EXPECT_TRUE(counts.is_valid());
+    EXPECT_GT(counts.instructions, 5000000u);
+    EXPECT_GT(counts.ipc(), 0.0);
+
+    // the team includes the calling thread
+    const PerfCounts thread = PerfCounters::thread_counts();
+    const PerfCounts team = PerfCounters::team_counts();
+    EXPECT_GE(team.instructions, thread.instructions);
+}
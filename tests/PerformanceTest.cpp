@@ -0,0 +1,308 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/MemoryScope.h>
+#include <pmp/algorithms/SurfaceCurvature.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceParameterization.h>
+#include <pmp/algorithms/SurfaceRemeshing.h>
+#include <pmp/algorithms/SurfaceSimplification.h>
+#include <pmp/algorithms/SurfaceSmoothing.h>
+#include <pmp/algorithms/SurfaceSubdivision.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace pmp;
+
+// Performance regression tests. They compare the running time and the peak
+// extra memory of key algorithms on generated meshes with the baselines in
+// the file named by the environment variable PMP_PERFORMANCE_BASELINES and
+// do nothing if it is not set. The times are stored relative to a fixed
+// workload independent of the library, such that the baselines carry over
+// between similar machines. With PMP_UPDATE_BASELINES=1 the measurements
+// replace the baselines instead.
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Baseline
+{
+    double time;   // relative to calibration_time()
+    double memory; // peak extra memory in MB
+};
+
+const char* environment(const char* name)
+{
+    const char* value = std::getenv(name);
+    return value && *value ? value : nullptr;
+}
+
+double tolerance(const char* name, double fallback)
+{
+    const char* value = environment(name);
+    return value ? std::atof(value) : fallback;
+}
+
+double milliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+// minimum time of sorting and summing pseudo-random numbers
+double calibration_time()
+{
+    static double time = 0;
+    if (time > 0)
+        return time;
+
+    std::vector<uint32_t> values(1 << 20);
+    volatile double sink = 0;
+    time = 1e30;
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto start = Clock::now();
+        uint32_t state = 12345;
+        for (auto& v : values)
+            v = state = state * 1664525u + 1013904223u;
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (auto v : values)
+            sum += std::sqrt(double(v));
+        sink = sink + sum;
+        time = std::min(time, milliseconds(start));
+    }
+    return time;
+}
+
+std::map<std::string, Baseline> read_baselines(const std::string& filename)
+{
+    std::map<std::string, Baseline> baselines;
+    std::ifstream ifs(filename);
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        std::string name;
+        Baseline b;
+        if (iss >> name && name[0] != '#' && iss >> b.time >> b.memory)
+            baselines[name] = b;
+    }
+    return baselines;
+}
+
+void write_baselines(const std::string& filename,
+                     const std::map<std::string, Baseline>& baselines)
+{
+    std::ofstream ofs(filename);
+    ofs << "# performance baselines, see tests/PerformanceTest.cpp\n"
+        << "# name time[calibration units] peak_extra_memory[MB]\n";
+    for (const auto& b : baselines)
+        ofs << b.first << " " << b.second.time << " " << b.second.memory
+            << "\n";
+}
+
+class PerformanceTest : public ::testing::Test
+{
+public:
+    PerformanceTest()
+    {
+        const char* filename = environment("PMP_PERFORMANCE_BASELINES");
+        if (filename)
+            filename_ = filename;
+    }
+
+    // Run \p setup and \p algorithm three times and check the fastest time
+    // and the highest peak extra memory of \p algorithm against the
+    // baseline of \p name.
+    void check(const std::string& name, const std::function<void()>& setup,
+               const std::function<void()>& algorithm)
+    {
+        if (filename_.empty())
+            return;
+
+        Baseline measured{1e30, 0};
+        for (int run = 0; run < 3; ++run)
+        {
+            setup();
+            MemoryScope memory;
+            const auto start = Clock::now();
+            algorithm();
+            measured.time = std::min(measured.time, milliseconds(start));
+            measured.memory = std::max(
+                measured.memory, memory.peak_extra() / 1048576.0);
+        }
+        measured.time /= calibration_time();
+
+        auto baselines = read_baselines(filename_);
+        if (environment("PMP_UPDATE_BASELINES"))
+        {
+            baselines[name] = measured;
+            write_baselines(filename_, baselines);
+            return;
+        }
+
+        auto it = baselines.find(name);
+        ASSERT_NE(it, baselines.end())
+            << "No baseline for " << name << " in " << filename_
+            << ", record one with PMP_UPDATE_BASELINES=1";
+
+        // memory is measured in pages and reused by the allocator, so
+        // small amounts are not compared
+        const double time_tolerance = tolerance("PMP_TIME_TOLERANCE", 1.5);
+        const double memory_tolerance =
+            tolerance("PMP_MEMORY_TOLERANCE", 1.25);
+        const Baseline& baseline = it->second;
+        EXPECT_LE(measured.time, baseline.time * time_tolerance)
+            << name << " is " << measured.time / baseline.time
+            << " times slower than its baseline";
+        EXPECT_LE(measured.memory, baseline.memory * memory_tolerance + 2.0)
+            << name << " needs " << measured.memory << " MB instead of "
+            << baseline.memory << " MB";
+    }
+
+private:
+    std::string filename_;
+};
+
+// a sphere with fixed noise
+SurfaceMesh noisy_sphere(size_t n_subdivisions)
+{
+    auto mesh = SurfaceFactory::icosphere(n_subdivisions);
+    for (auto v : mesh.vertices())
+        mesh.position(v) *= 1 + 0.01 * std::sin(13.0 * v.idx());
+    return mesh;
+}
+
+} // namespace
+
+TEST_F(PerformanceTest, simplification)
+{
+    const auto input = noisy_sphere(5);
+    SurfaceMesh mesh;
+    check(
+        "simplification", [&]() { mesh = input; },
+        [&]() {
+            SurfaceSimplification simplification(mesh);
+            simplification.initialize(5);
+            simplification.simplify(input.n_vertices() / 10);
+        });
+}
+
+TEST_F(PerformanceTest, remeshing)
+{
+    const auto input = noisy_sphere(5);
+    SurfaceMesh mesh;
+    check(
+        "remeshing", [&]() { mesh = input; },
+        [&]() { SurfaceRemeshing(mesh).uniform_remeshing(0.03, 5); });
+}
+
+TEST_F(PerformanceTest, implicit_smoothing)
+{
+    const auto input = noisy_sphere(6);
+    SurfaceMesh mesh;
+    check(
+        "implicit_smoothing", [&]() { mesh = input; },
+        [&]() { SurfaceSmoothing(mesh).implicit_smoothing(0.001); });
+}
+
+TEST_F(PerformanceTest, curvature)
+{
+    auto mesh = noisy_sphere(6);
+    check(
+        "curvature", []() {},
+        [&]() { SurfaceCurvature(mesh).analyze_tensor(1); });
+}
+
+TEST_F(PerformanceTest, subdivision)
+{
+    const auto input = noisy_sphere(5);
+    SurfaceMesh mesh;
+    check(
+        "subdivision", [&]() { mesh = input; },
+        [&]() { SurfaceSubdivision(mesh).loop(2); });
+}
+
+TEST_F(PerformanceTest, property_access)
+{
+    // explicit Laplacian smoothing through non-const property access. the
+    // same loop on plain vectors gives the baseline it should match.
+    const auto input = noisy_sphere(6);
+    const std::vector<Point> input_points =
+        input.get_vertex_property<Point>("v:point").vector();
+    SurfaceMesh mesh;
+
+    check(
+        "property_access", [&]() { mesh = input; },
+        [&]() {
+            auto points = mesh.vertex_property<Point>("v:point");
+            auto laplace = mesh.add_vertex_property<Point>("v:laplace");
+            for (int iter = 0; iter < 10; ++iter)
+            {
+                for (auto v : mesh.vertices())
+                {
+                    Point sum(0);
+                    Scalar n = 0;
+                    for (auto vv : mesh.vertices(v))
+                    {
+                        sum += points[vv];
+                        ++n;
+                    }
+                    laplace[v] = sum / n - points[v];
+                }
+                for (auto v : mesh.vertices())
+                    points[v] += Scalar(0.5) * laplace[v];
+            }
+            mesh.remove_vertex_property(laplace);
+        });
+
+    std::vector<Point> points, laplace;
+    check(
+        "property_access_vector",
+        [&]() {
+            mesh = input;
+            points = input_points;
+        },
+        [&]() {
+            laplace.resize(points.size());
+            for (int iter = 0; iter < 10; ++iter)
+            {
+                for (auto v : mesh.vertices())
+                {
+                    Point sum(0);
+                    Scalar n = 0;
+                    for (auto vv : mesh.vertices(v))
+                    {
+                        sum += points[vv.idx()];
+                        ++n;
+                    }
+                    laplace[v.idx()] = sum / n - points[v.idx()];
+                }
+                for (auto v : mesh.vertices())
+                    points[v.idx()] += Scalar(0.5) * laplace[v.idx()];
+            }
+        });
+}
+
+TEST_F(PerformanceTest, parameterization)
+{
+    const auto input = SurfaceFactory::terrain(300, 300, 0.5, 1);
+    SurfaceMesh mesh;
+    check(
+        "parameterization", [&]() { mesh = input; },
+        [&]() { SurfaceParameterization(mesh).harmonic(); });
+}
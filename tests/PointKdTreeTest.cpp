@@ -0,0 +1,131 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <pmp/algorithms/PointKdTree.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+using namespace pmp;
+
+namespace {
+
+// query points inside and outside of the unit sphere
+std::vector<Point> queries()
+{
+    std::vector<Point> points;
+    for (int i = 0; i < 100; ++i)
+    {
+        const Scalar t = Scalar(i) / 100;
+        const Scalar r = Scalar(0.2) + Scalar(1.6) * t;
+        points.emplace_back(r * std::cos(37 * t) * std::sin(11 * t),
+                            r * std::sin(37 * t) * std::sin(11 * t),
+                            r * std::cos(11 * t));
+    }
+    return points;
+}
+
+// sorted distances from p to all vertices of mesh
+std::vector<Scalar> distances(const SurfaceMesh& mesh, const Point& p)
+{
+    std::vector<Scalar> dist;
+    for (auto v : mesh.vertices())
+        dist.push_back(distance(mesh.position(v), p));
+    std::sort(dist.begin(), dist.end());
+    return dist;
+}
+
+} // namespace
+
+TEST(PointKdTreeTest, nearest)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+
+    // leave some garbage
+    mesh.delete_vertex(*mesh.vertices_begin());
+
+    for (unsigned int max_points : {1u, 16u})
+    {
+        PointKdTree tree(mesh, max_points);
+        EXPECT_GT(tree.n_nodes(), 1u);
+
+        for (const auto& p : queries())
+        {
+            const auto nn = tree.nearest(p);
+            ASSERT_TRUE(nn.vertex.is_valid());
+            EXPECT_FALSE(mesh.is_deleted(nn.vertex));
+            EXPECT_FLOAT_EQ(nn.dist, distances(mesh, p)[0]);
+            EXPECT_FLOAT_EQ(nn.dist, distance(mesh.position(nn.vertex), p));
+        }
+    }
+
+    EXPECT_FALSE(PointKdTree(std::vector<Point>()).nearest(Point(0, 0, 0))
+                     .vertex.is_valid());
+}
+
+TEST(PointKdTreeTest, k_nearest)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    PointKdTree tree(mesh);
+    const auto points = queries();
+
+    std::vector<std::vector<PointKdTree::Neighbor>> batch;
+    tree.k_nearest(points, 8, batch);
+    ASSERT_EQ(batch.size(), points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto dist = distances(mesh, points[i]);
+        const auto knn = tree.k_nearest(points[i], 8);
+        ASSERT_EQ(knn.size(), 8u);
+        ASSERT_EQ(batch[i].size(), 8u);
+        for (size_t j = 0; j < knn.size(); ++j)
+        {
+            EXPECT_FLOAT_EQ(knn[j].dist, dist[j]);
+            EXPECT_EQ(batch[i][j].vertex, knn[j].vertex);
+        }
+    }
+
+    // fewer points than requested
+    EXPECT_EQ(tree.k_nearest(Point(0, 0, 0), 10000).size(),
+              mesh.n_vertices());
+    EXPECT_TRUE(tree.k_nearest(Point(0, 0, 0), 0).empty());
+}
+
+TEST(PointKdTreeTest, within_radius)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    PointKdTree tree(mesh);
+    const auto points = queries();
+    const Scalar radius = 0.4;
+
+    std::vector<std::vector<PointKdTree::Neighbor>> batch;
+    tree.within_radius(points, radius, batch);
+    ASSERT_EQ(batch.size(), points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto dist = distances(mesh, points[i]);
+        const size_t n = std::upper_bound(dist.begin(), dist.end(), radius) -
+                         dist.begin();
+        const auto found = tree.within_radius(points[i], radius);
+        ASSERT_EQ(found.size(), n);
+        EXPECT_EQ(batch[i].size(), n);
+        for (size_t j = 1; j < found.size(); ++j)
+            EXPECT_LE(found[j - 1].dist, found[j].dist);
+    }
+}
+
+// coincident points are kept in one leaf
+TEST(PointKdTreeTest, duplicates)
+{
+    std::vector<Point> points(100, Point(1, 2, 3));
+    points.emplace_back(0, 0, 0);
+    PointKdTree tree(points, 1);
+    EXPECT_EQ(tree.nearest(Point(0, 0, 0.1)).vertex, Vertex(100));
+    EXPECT_EQ(tree.k_nearest(Point(1, 2, 3), 50).size(), 50u);
+    EXPECT_EQ(tree.within_radius(Point(1, 2, 3), 0).size(), 100u);
+}
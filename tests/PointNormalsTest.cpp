@@ -0,0 +1,54 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/PointNormals.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+using namespace pmp;
+
+namespace {
+
+// the vertices of an icosphere without its faces
+SurfaceMesh sphere_cloud()
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    SurfaceMesh cloud;
+    for (auto v : sphere.vertices())
+        cloud.add_vertex(sphere.position(v));
+    return cloud;
+}
+
+} // namespace
+
+// the normals of a sphere are parallel to the positions
+TEST(PointNormalsTest, compute_normals)
+{
+    auto cloud = sphere_cloud();
+    PointNormals::compute_normals(cloud, 10, false);
+    auto normals = cloud.get_vertex_property<Normal>("v:normal");
+    ASSERT_TRUE(normals);
+    for (auto v : cloud.vertices())
+        EXPECT_GT(std::fabs(dot(normals[v], cloud.position(v))), 0.99);
+}
+
+// consistently oriented normals of a sphere point outwards
+TEST(PointNormalsTest, orient_normals)
+{
+    auto cloud = sphere_cloud();
+    EXPECT_THROW(PointNormals::orient_normals(cloud), InvalidInputException);
+
+    PointNormals::compute_normals(cloud);
+    auto normals = cloud.get_vertex_property<Normal>("v:normal");
+    for (auto v : cloud.vertices())
+        EXPECT_GT(dot(normals[v], cloud.position(v)), 0.99);
+
+    // flip every other normal
+    for (auto v : cloud.vertices())
+        if (v.idx() % 2)
+            normals[v] = -normals[v];
+    PointNormals::orient_normals(cloud);
+    for (auto v : cloud.vertices())
+        EXPECT_GT(dot(normals[v], cloud.position(v)), 0.99);
+}
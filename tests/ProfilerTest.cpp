@@ -0,0 +1,121 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/Profiler.h>
+#include <pmp/Types.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace pmp;
+
+class ProfilerTest : public ::testing::Test
+{
+public:
+    ProfilerTest() { Profiler::clear(); }
+    ~ProfilerTest() override { Profiler::clear(); }
+
+    std::string report()
+    {
+        std::ostringstream os;
+        Profiler::report(os);
+        return os.str();
+    }
+};
+
+TEST_F(ProfilerTest, nested_zones)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        ProfileZone outer("outer");
+        ProfileZone inner("inner");
+    }
+    ProfileZone("inner");
+
+    std::istringstream is(report());
+    std::string line;
+    ASSERT_TRUE(std::getline(is, line));
+    EXPECT_EQ(line.find("outer"), 0u);
+    EXPECT_NE(line.find("3 calls"), std::string::npos);
+    EXPECT_NE(line.find(" MB"), std::string::npos);
+    ASSERT_TRUE(std::getline(is, line));
+    EXPECT_EQ(line.find("  inner"), 0u);
+    EXPECT_NE(line.find("3 calls"), std::string::npos);
+    EXPECT_NE(line.find('%'), std::string::npos);
+
+    // the same name at the top level is a different zone
+    ASSERT_TRUE(std::getline(is, line));
+    EXPECT_EQ(line.find("inner"), 0u);
+    EXPECT_NE(line.find("1 calls"), std::string::npos);
+    EXPECT_FALSE(std::getline(is, line));
+}
+
+TEST_F(ProfilerTest, threads)
+{
+    {
+        ProfileZone zone("main");
+    }
+    std::thread worker([]() { ProfileZone zone("worker"); });
+    worker.join();
+
+    const std::string text = report();
+    EXPECT_NE(text.find("thread 0:\nmain"), std::string::npos);
+    EXPECT_NE(text.find("thread 1:\nworker"), std::string::npos);
+}
+
+TEST_F(ProfilerTest, chrome_trace)
+{
+    {
+        ProfileZone outer("outer");
+        ProfileZone inner("in\"ner");
+    }
+    const std::string filename = "profile.json";
+    Profiler::write_chrome_trace(filename);
+
+    std::ifstream ifs(filename);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    const std::string json = ss.str();
+    EXPECT_EQ(json.find("{\"traceEvents\":["), 0u);
+    EXPECT_NE(json.find("\"name\":\"outer\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"in\\\"ner\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"peak_extra_bytes\":"), std::string::npos);
+    ifs.close();
+    std::remove(filename.c_str());
+
+    EXPECT_THROW(Profiler::write_chrome_trace("/nonexistent/profile.json"),
+                 IOException);
+}
+
+TEST_F(ProfilerTest, clear)
+{
+    {
+        ProfileZone zone("zone");
+    }
+    Profiler::clear();
+    EXPECT_TRUE(report().empty());
+}
+
+TEST_F(ProfilerTest, perf_counters)
+{
+    const bool enabled = PerfCounters::is_enabled();
+    PerfCounters::set_enabled(true);
+    {
+        ProfileZone zone("counted");
+        volatile double sum = 0;
+        for (int i = 0; i < 1000000; ++i)
+            sum = sum + 1;
+    }
+    const bool available = PerfCounters::is_available();
+    PerfCounters::set_enabled(enabled);
+
+    // the events are only reported if they were counted
+    const std::string text = report();
+    EXPECT_EQ(text.find("IPC") != std::string::npos, available);
+}
@@ -0,0 +1,55 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/QuadricClustering.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+using namespace pmp;
+
+TEST(QuadricClusteringTest, sphere)
+{
+    auto input = SurfaceFactory::icosphere(5);
+    QuadricClustering clustering(0.2);
+    clustering.add_faces(input);
+    auto mesh = clustering.mesh();
+
+    EXPECT_GT(mesh.n_faces(), 100u);
+    EXPECT_LT(mesh.n_faces(), input.n_faces() / 10);
+    EXPECT_EQ(mesh.n_vertices(), clustering.n_cells());
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+
+    // the quadric minimizers stay close to the surface
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(norm(mesh.position(v)), 1.0, 0.05);
+}
+
+TEST(QuadricClusteringTest, streaming)
+{
+    auto input = SurfaceFactory::icosphere(4);
+    input.write("test.smb");
+
+    QuadricClustering from_mesh(0.25), from_stream(0.25);
+    from_mesh.add_faces(input);
+    StreamingMeshReader reader("test.smb");
+    from_stream.add_faces(reader);
+    EXPECT_EQ(from_stream.n_cells(), from_mesh.n_cells());
+    EXPECT_EQ(from_stream.n_triangles(), from_mesh.n_triangles());
+
+    EXPECT_THROW(QuadricClustering(0), InvalidInputException);
+}
+
+TEST(QuadricClusteringTest, planar_corner)
+{
+    // a flat square keeps its corner at the minimizer of the plane quadric
+    QuadricClustering clustering(1);
+    clustering.add_triangle(Point(0.1, 0.1, 0), Point(2.9, 0.1, 0),
+                            Point(2.9, 2.9, 0));
+    clustering.add_triangle(Point(0.1, 0.1, 0), Point(2.9, 2.9, 0),
+                            Point(0.1, 2.9, 0));
+    auto mesh = clustering.mesh();
+    EXPECT_EQ(mesh.n_faces(), 2u);
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(mesh.position(v)[2], 0.0, 1e-6);
+}
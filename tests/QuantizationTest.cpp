@@ -0,0 +1,77 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/Quantization.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceNormals.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace pmp;
+
+TEST(QuantizationTest, half)
+{
+    // exactly representable values
+    for (float f : {0.0f, 1.0f, -2.0f, 0.5f, 1024.0f, 65504.0f, -0.0009765625f})
+        EXPECT_EQ(float(Half(f)), f);
+    EXPECT_EQ(Half(1.0f).bits(), 0x3c00);
+    EXPECT_EQ(Half(-2.0f).bits(), 0xc000);
+
+    // smallest subnormal
+    EXPECT_EQ(Half(std::ldexp(1.0f, -24)).bits(), 0x0001);
+    EXPECT_EQ(float(Half(std::ldexp(1.0f, -24))), std::ldexp(1.0f, -24));
+
+    // rounding and special values
+    EXPECT_NEAR(float(Half(3.14159f)), 3.14159f, 2e-3);
+    EXPECT_TRUE(std::isinf(float(Half(1e6f))));
+    EXPECT_TRUE(std::isinf(float(Half(std::numeric_limits<float>::infinity()))));
+    EXPECT_TRUE(std::isnan(float(Half(std::numeric_limits<float>::quiet_NaN()))));
+
+    // round to nearest even: 2049 lies between 2048 and 2050
+    EXPECT_EQ(float(Half(2049.0f)), 2048.0f);
+    EXPECT_EQ(float(Half(2051.0f)), 2052.0f);
+}
+
+TEST(QuantizationTest, oct_normal)
+{
+    for (auto n : {Normal(0, 0, 1), Normal(0, 0, -1), Normal(1, 0, 0),
+                   Normal(-1, -1, -1), Normal(0.3, -0.2, -0.9)})
+    {
+        Normal d = OctNormal(n);
+        EXPECT_NEAR(norm(d), 1.0, 1e-5);
+        EXPECT_GT(dot(d, normalize(n)), std::cos(0.01 * M_PI / 180.0));
+    }
+    EXPECT_EQ(sizeof(OctNormal), 4u);
+}
+
+TEST(QuantizationTest, color)
+{
+    Color c = Color8(Color(0.0, 0.5, 2.0));
+    EXPECT_EQ(c[0], 0);
+    EXPECT_NEAR(c[1], 0.5, 1.0 / 255);
+    EXPECT_EQ(c[2], 1);
+}
+
+TEST(QuantizationTest, convert_property)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    SurfaceNormals::compute_vertex_normals(mesh);
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto reference = normals.vector();
+
+    auto compact = convert_property<OctNormal>(mesh, normals, "v:onormal");
+    EXPECT_THROW(convert_property<OctNormal>(mesh, normals, "v:onormal"),
+                 InvalidInputException);
+    mesh.remove_vertex_property(normals);
+
+    auto restored = convert_property<Normal>(mesh, compact, "v:normal");
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(norm(restored[v] - reference[v.idx()]), 0, 1e-4);
+
+    auto tex = mesh.add_halfedge_property<TexCoord>("h:tex", TexCoord(0.25, 1));
+    auto htex = convert_property<HalfTexCoord>(mesh, tex, "h:htex");
+    EXPECT_EQ(TexCoord(htex[Halfedge(0)]), TexCoord(0.25, 1));
+}
@@ -0,0 +1,229 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/StreamingMesh.h>
+#include <pmp/SurfaceMeshIO.h>
+#include <pmp/algorithms/StreamingProcessing.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace pmp;
+
+namespace {
+
+void read_all(StreamingMeshReader& reader)
+{
+    while (reader.next() != StreamingMeshReader::Event::End)
+        ;
+}
+
+} // namespace
+
+TEST(StreamingMeshTest, read_ascii)
+{
+    FILE* file = fopen("test.sma", "w");
+    fprintf(file, "# two triangles\n"
+                  "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                  "f 1 2 -3\n"
+                  "v 1 1 0\n"
+                  "f -2 4 1\n"
+                  "x 4\n");
+    fclose(file);
+
+    StreamingMeshReader reader("test.sma");
+    using Event = StreamingMeshReader::Event;
+    EXPECT_EQ(reader.next(), Event::Vertex);
+    EXPECT_EQ(reader.vertex(), 0u);
+    EXPECT_EQ(reader.position(0), Point(0, 0, 0));
+    EXPECT_EQ(reader.next(), Event::Vertex);
+    EXPECT_EQ(reader.next(), Event::Vertex);
+    EXPECT_EQ(reader.next(), Event::Face);
+    EXPECT_EQ(reader.face(), std::vector<IndexType>({0, 1, 2}));
+    EXPECT_EQ(reader.next(), Event::Finalize);
+    EXPECT_EQ(reader.vertex(), 2u);
+    EXPECT_EQ(reader.position(2), Point(0, 1, 0));
+    EXPECT_EQ(reader.next(), Event::Vertex);
+    EXPECT_EQ(reader.vertex(), 3u);
+    EXPECT_THROW(reader.position(2), InvalidInputException);
+    EXPECT_EQ(reader.next(), Event::Face);
+    EXPECT_EQ(reader.face(), std::vector<IndexType>({1, 3, 0}));
+    EXPECT_EQ(reader.next(), Event::Finalize);
+    EXPECT_EQ(reader.vertex(), 1u);
+    EXPECT_EQ(reader.next(), Event::Finalize);
+    EXPECT_EQ(reader.vertex(), 3u);
+
+    // vertex 0 is finalized at the end
+    EXPECT_EQ(reader.next(), Event::Finalize);
+    EXPECT_EQ(reader.vertex(), 0u);
+    EXPECT_EQ(reader.next(), Event::End);
+    EXPECT_EQ(reader.n_vertices(), 4u);
+    EXPECT_EQ(reader.n_faces(), 2u);
+    EXPECT_EQ(reader.n_active_vertices(), 0u);
+    EXPECT_EQ(reader.max_active_vertices(), 3u);
+}
+
+TEST(StreamingMeshTest, read_finalized_vertex)
+{
+    FILE* file = fopen("test.sma", "w");
+    fprintf(file, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 -3\nf 1 2 3\n");
+    fclose(file);
+
+    StreamingMeshReader reader("test.sma");
+    EXPECT_THROW(read_all(reader), IOException);
+}
+
+TEST(StreamingMeshTest, write_read_binary)
+{
+    {
+        StreamingMeshWriter writer("test.smb", true);
+        auto a = writer.add_vertex(Point(0, 0, 0));
+        auto b = writer.add_vertex(Point(1, 0, 0));
+        auto c = writer.add_vertex(Point(0, 1, 0));
+        writer.add_face({a, b, c});
+        writer.finalize(a);
+        writer.finalize(b);
+        auto d = writer.add_vertex(Point(1, 1, 0));
+        EXPECT_THROW(writer.add_face({c, d, 7}), InvalidInputException);
+        writer.add_face({c, b, d});
+        writer.close();
+    }
+
+    // b is referenced after its finalization
+    StreamingMeshReader reader("test.smb");
+    EXPECT_THROW(read_all(reader), IOException);
+}
+
+TEST(StreamingMeshTest, append_in_pieces)
+{
+    SurfaceFactory::icosphere(2).write("test.smb");
+    using Event = StreamingMeshReader::Event;
+
+    for (const char* filename : {"test.smb", "test.sma"})
+    {
+        if (std::string(filename) == "test.sma")
+        {
+            StreamingMeshReader in("test.smb");
+            StreamingMeshWriter out("test.sma");
+            StreamingProcessing::copy(in, out);
+        }
+
+        std::vector<char> data;
+        FILE* file = fopen(filename, "rb");
+        for (int c = getc(file); c != EOF; c = getc(file))
+            data.push_back(char(c));
+        fclose(file);
+
+        // append a few bytes whenever the reader runs out of records, and
+        // compare with reading the file
+        StreamingMeshReader expected(filename);
+        StreamingMeshReader reader;
+        size_t appended = 0;
+        for (auto event = expected.next(); event != Event::End;
+             event = expected.next())
+        {
+            auto e = reader.next();
+            while (e == Event::Pending)
+            {
+                ASSERT_LT(appended, data.size());
+                const size_t n = std::min<size_t>(7, data.size() - appended);
+                reader.append(data.data() + appended, n);
+                appended += n;
+                if (appended == data.size())
+                    reader.close_input();
+                e = reader.next();
+            }
+            ASSERT_EQ(e, event);
+            EXPECT_EQ(reader.vertex(), expected.vertex());
+            if (event == Event::Face)
+            {
+                EXPECT_EQ(reader.face(), expected.face());
+            }
+            if (event == Event::Vertex)
+            {
+                EXPECT_EQ(reader.position(reader.vertex()),
+                          expected.position(expected.vertex()));
+            }
+        }
+        if (appended < data.size())
+            reader.append(data.data() + appended, data.size() - appended);
+        reader.close_input();
+        EXPECT_EQ(reader.next(), Event::End);
+        EXPECT_THROW(reader.append(data.data(), 1), InvalidInputException);
+    }
+
+    // a truncated record is an error once the input is closed
+    StreamingMeshReader reader;
+    reader.append("v 0 0 0\nf 1", 11);
+    EXPECT_EQ(reader.next(), Event::Vertex);
+    EXPECT_EQ(reader.next(), Event::Pending);
+    reader.close_input();
+    EXPECT_THROW(reader.next(), IOException);
+}
+
+TEST(StreamingMeshTest, mesh_io)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    mesh.write("test.smb");
+
+    auto info = SurfaceMeshIO::probe("test.smb");
+    EXPECT_EQ(info.n_vertices, mesh.n_vertices());
+    EXPECT_EQ(info.n_faces, mesh.n_faces());
+
+    // faces are sorted along an axis, the stream is narrower than the mesh
+    StreamingMeshReader reader("test.smb");
+    read_all(reader);
+    EXPECT_LT(reader.max_active_vertices(), mesh.n_vertices() / 2);
+
+    // binary to ASCII and back into a mesh
+    {
+        StreamingMeshReader in("test.smb");
+        StreamingMeshWriter out("test.sma");
+        StreamingProcessing::copy(in, out);
+    }
+    SurfaceMesh result;
+    result.read("test.sma");
+    EXPECT_EQ(result.n_vertices(), mesh.n_vertices());
+    EXPECT_EQ(result.n_faces(), mesh.n_faces());
+    EXPECT_TRUE(result.is_triangle_mesh());
+    EXPECT_EQ(result.n_edges(), mesh.n_edges());
+}
+
+TEST(StreamingMeshTest, vertex_normals)
+{
+    SurfaceFactory::icosphere(2).write("test.smb");
+
+    StreamingMeshReader reader("test.smb");
+    size_t n_vertices = 0;
+    StreamingProcessing::compute_vertex_normals(
+        reader, [&](IndexType, const Point& p, const Normal& n) {
+            // the normals of a sphere point outwards
+            EXPECT_GT(dot(n, normalize(p)), 0.99);
+            ++n_vertices;
+        });
+    EXPECT_EQ(n_vertices, reader.n_vertices());
+}
+
+TEST(StreamingMeshTest, cluster_vertices)
+{
+    SurfaceFactory::icosphere(4).write("test.smb");
+    {
+        StreamingMeshReader in("test.smb");
+        StreamingMeshWriter out("test_clustered.smb", true);
+        EXPECT_THROW(StreamingProcessing::cluster_vertices(in, out, 0),
+                     InvalidInputException);
+        StreamingProcessing::cluster_vertices(in, out, 0.25);
+    }
+
+    SurfaceMesh mesh;
+    mesh.read("test_clustered.smb");
+    EXPECT_GT(mesh.n_faces(), 20u);
+    EXPECT_LT(mesh.n_faces(), 5120u / 4);
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(norm(mesh.position(v)), 1.0, 0.1);
+}
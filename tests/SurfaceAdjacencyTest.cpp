@@ -0,0 +1,76 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/SurfaceAdjacency.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceNormals.h>
+
+#include "Helpers.h"
+
+using namespace pmp;
+
+void check_adjacency(const SurfaceMesh& mesh)
+{
+    SurfaceAdjacency adjacency(mesh);
+    EXPECT_EQ(adjacency.vertices_size(), mesh.vertices_size());
+    EXPECT_EQ(adjacency.faces_size(), mesh.faces_size());
+
+    for (auto v : mesh.vertices())
+    {
+        auto halfedges = adjacency.vertex_halfedges(v);
+        auto vertices = adjacency.vertex_vertices(v);
+        auto faces = adjacency.vertex_faces(v);
+        ASSERT_EQ(halfedges.size(), mesh.valence(v));
+        ASSERT_EQ(vertices.size(), mesh.valence(v));
+        ASSERT_EQ(faces.size(), mesh.valence(v));
+
+        size_t i = 0;
+        for (auto h : mesh.halfedges(v))
+        {
+            EXPECT_EQ(halfedges[i], h);
+            EXPECT_EQ(vertices[i], mesh.to_vertex(h));
+            EXPECT_EQ(faces[i], mesh.face(h));
+            ++i;
+        }
+    }
+
+    for (auto f : mesh.faces())
+    {
+        auto vertices = adjacency.face_vertices(f);
+        ASSERT_EQ(vertices.size(), mesh.valence(f));
+        size_t i = 0;
+        for (auto v : mesh.vertices(f))
+            EXPECT_EQ(vertices[i++], v);
+    }
+}
+
+TEST(SurfaceAdjacencyTest, triangles_with_boundary)
+{
+    check_adjacency(hemisphere());
+}
+
+TEST(SurfaceAdjacencyTest, quads)
+{
+    check_adjacency(SurfaceFactory::quad_sphere(1));
+}
+
+TEST(SurfaceAdjacencyTest, deleted_elements)
+{
+    auto mesh = vertex_onering();
+    mesh.delete_face(Face(0));
+
+    SurfaceAdjacency adjacency(mesh);
+    EXPECT_TRUE(adjacency.face_vertices(Face(0)).empty());
+    check_adjacency(mesh);
+}
+
+TEST(SurfaceAdjacencyTest, vertex_normals)
+{
+    auto mesh = hemisphere();
+    SurfaceNormals::compute_vertex_normals(mesh, SurfaceAdjacency(mesh));
+    auto vnormal = mesh.get_vertex_property<Normal>("v:normal");
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(vnormal[v], SurfaceNormals::compute_vertex_normal(mesh, v));
+}
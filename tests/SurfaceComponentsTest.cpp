@@ -0,0 +1,148 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/DifferentialGeometry.h"
+#include "pmp/algorithms/SurfaceComponents.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+
+using namespace pmp;
+
+namespace {
+
+// add a copy of part, moved by offset, to mesh
+void append(SurfaceMesh& mesh, const SurfaceMesh& part, const Point& offset)
+{
+    std::vector<Vertex> vertices;
+    for (auto v : part.vertices())
+        vertices.push_back(mesh.add_vertex(part.position(v) + offset));
+    for (auto f : part.faces())
+    {
+        std::vector<Vertex> face;
+        for (auto v : part.vertices(f))
+            face.push_back(vertices[v.idx()]);
+        mesh.add_face(face);
+    }
+}
+
+// a sphere, followed by many small tetrahedra and an isolated vertex
+SurfaceMesh fragments(size_t n_tetrahedra)
+{
+    SurfaceMesh mesh;
+    append(mesh, SurfaceFactory::icosphere(2), Point(0, 0, 0));
+    for (size_t i = 0; i < n_tetrahedra; ++i)
+        append(mesh, SurfaceFactory::tetrahedron(),
+               Point(3 + Scalar(i), 0, 0));
+    mesh.add_vertex(Point(0, 5, 0));
+    return mesh;
+}
+
+} // namespace
+
+TEST(SurfaceComponentsTest, label)
+{
+    auto mesh = fragments(100);
+    const auto sphere = SurfaceFactory::icosphere(2);
+    const auto tetrahedron = SurfaceFactory::tetrahedron();
+
+    auto components = SurfaceComponents::label(mesh);
+    ASSERT_EQ(components.size(), 102u);
+    EXPECT_EQ(components[0].n_vertices, sphere.n_vertices());
+    EXPECT_EQ(components[0].n_faces, sphere.n_faces());
+    EXPECT_NEAR(components[0].area, surface_area(sphere), 1e-4);
+    for (size_t c = 1; c <= 100; ++c)
+    {
+        EXPECT_EQ(components[c].n_vertices, 4u);
+        EXPECT_EQ(components[c].n_faces, 4u);
+        EXPECT_NEAR(components[c].area, surface_area(tetrahedron), 1e-5);
+    }
+    EXPECT_EQ(components[101].n_vertices, 1u);
+    EXPECT_EQ(components[101].n_faces, 0u);
+
+    // each face is in the component of its vertices
+    auto vcomponent = mesh.get_vertex_property<int>("v:component");
+    auto fcomponent = mesh.get_face_property<int>("f:component");
+    ASSERT_TRUE(vcomponent && fcomponent);
+    for (auto f : mesh.faces())
+        for (auto v : mesh.vertices(f))
+            EXPECT_EQ(vcomponent[v], fcomponent[f]);
+    EXPECT_EQ(vcomponent[Vertex(0)], 0);
+    EXPECT_EQ(vcomponent[Vertex(IndexType(mesh.vertices_size() - 1))], 101);
+
+    // deleting the faces around a vertex does not split the sphere, but
+    // deleted elements are not labeled
+    mesh.delete_vertex(Vertex(0));
+    components = SurfaceComponents::label(mesh);
+    ASSERT_EQ(components.size(), 102u);
+    EXPECT_EQ(components[0].n_vertices, sphere.n_vertices() - 1);
+    EXPECT_EQ(vcomponent[Vertex(0)], -1);
+}
+
+TEST(SurfaceComponentsTest, split)
+{
+    auto mesh = fragments(50);
+    auto quality = mesh.face_property<Scalar>("f:quality");
+    for (auto f : mesh.faces())
+        quality[f] = Scalar(f.idx());
+    mesh.delete_face(Face(0));
+
+    const auto parts = SurfaceComponents::split(mesh);
+    ASSERT_EQ(parts.size(), 52u);
+    EXPECT_EQ(parts[0].n_faces(), SurfaceFactory::icosphere(2).n_faces() - 1);
+    EXPECT_EQ(parts[0].faces_size(), parts[0].n_faces());
+    EXPECT_EQ(parts[51].n_vertices(), 1u);
+    EXPECT_EQ(parts[51].n_faces(), 0u);
+
+    // the tetrahedra keep their positions and face properties
+    size_t first_face = parts[0].n_faces() + 1;
+    for (size_t c = 1; c <= 50; ++c)
+    {
+        const auto& part = parts[c];
+        ASSERT_EQ(part.n_vertices(), 4u);
+        ASSERT_EQ(part.n_edges(), 6u);
+        ASSERT_EQ(part.n_faces(), 4u);
+        EXPECT_FALSE(part.is_boundary(Vertex(0)));
+        EXPECT_EQ(part.position(Vertex(0))[0],
+                  SurfaceFactory::tetrahedron().position(Vertex(0))[0] + 2 +
+                      Scalar(c));
+
+        auto part_quality = part.get_face_property<Scalar>("f:quality");
+        ASSERT_TRUE(part_quality);
+        for (auto f : part.faces())
+            EXPECT_EQ(part_quality[f], Scalar(first_face + f.idx()));
+        first_face += 4;
+
+        // the connectivity is consistent
+        for (auto h : part.halfedges())
+        {
+            EXPECT_EQ(part.prev_halfedge(part.next_halfedge(h)), h);
+            EXPECT_EQ(part.to_vertex(h),
+                      part.from_vertex(part.next_halfedge(h)));
+        }
+    }
+
+    // the source is unchanged
+    EXPECT_EQ(mesh.n_vertices(), 162u + 50 * 4 + 1);
+    EXPECT_EQ(mesh.faces_size(), mesh.n_faces() + 1);
+}
+
+TEST(SurfaceComponentsTest, remove_small)
+{
+    auto mesh = fragments(200);
+    const auto sphere = SurfaceFactory::icosphere(2);
+
+    EXPECT_EQ(SurfaceComponents::remove_small(mesh, 1), 1u);
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices() + 200 * 4);
+    EXPECT_EQ(mesh.vertices_size(), mesh.n_vertices());
+
+    EXPECT_EQ(SurfaceComponents::remove_small(mesh, 5), 200u);
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_edges(), sphere.n_edges());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+    EXPECT_EQ(mesh.vertices_size(), sphere.n_vertices());
+
+    // the sphere is too small by area
+    EXPECT_EQ(SurfaceComponents::remove_small(mesh, 1, Scalar(100)), 1u);
+    EXPECT_TRUE(mesh.is_empty());
+}
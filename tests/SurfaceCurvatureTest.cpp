@@ -71,3 +71,31 @@ TEST_F(SurfaceCurvatureTest, gauss_curvature_to_texture_coordinates)
     auto tex = mesh.vertex_property<TexCoord>("v:tex");
     EXPECT_TRUE(tex);
 }
+
+TEST_F(SurfaceCurvatureTest, curvature_tensor)
+{
+    for (bool two_ring : {false, true})
+    {
+        curvature->analyze_tensor(1, two_ring);
+        for (auto v : mesh.vertices())
+        {
+            EXPECT_NEAR(curvature->min_curvature(v), 1.0, 0.04);
+            EXPECT_NEAR(curvature->max_curvature(v), 1.0, 0.04);
+        }
+    }
+}
+
+TEST(SurfaceCurvatureBoundaryTest, boundary_interpolation)
+{
+    // upper half of a sphere
+    auto mesh = SurfaceFactory::icosphere(4);
+    for (auto v : mesh.vertices())
+        if (mesh.position(v)[2] < -0.1)
+            mesh.delete_vertex(v);
+    mesh.garbage_collection();
+
+    SurfaceCurvature curvature(mesh);
+    curvature.analyze();
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(curvature.mean_curvature(v), 1.0, 0.05);
+}
@@ -0,0 +1,83 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+#include "pmp/algorithms/SurfaceDistance.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+
+using namespace pmp;
+
+namespace {
+
+SurfaceMesh transformed(SurfaceMesh mesh, Scalar scale, const Point& offset)
+{
+    for (auto v : mesh.vertices())
+        mesh.position(v) = scale * mesh.position(v) + offset;
+    return mesh;
+}
+
+} // namespace
+
+TEST(SurfaceDistanceTest, identical)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    auto d = SurfaceDistance::symmetric(mesh, mesh, 10000);
+    EXPECT_NEAR(d.max_distance, 0, 1e-5);
+    EXPECT_NEAR(d.rms_distance, 0, 1e-5);
+    EXPECT_EQ(d.n_samples, 20000u);
+}
+
+// parallel planes have constant distance
+TEST(SurfaceDistanceTest, offset)
+{
+    auto grid = SurfaceFactory::grid(10, 10, true);
+    auto shifted = transformed(grid, 1, Point(0, 0, 0.1));
+    auto d = SurfaceDistance::one_sided(shifted, grid, 1000);
+    EXPECT_NEAR(d.max_distance, 0.1, 1e-5);
+    EXPECT_NEAR(d.mean_distance, 0.1, 1e-5);
+    EXPECT_NEAR(d.rms_distance, 0.1, 1e-5);
+    EXPECT_EQ(d.n_samples, 1000u);
+
+    // quads are sampled by triangle fans
+    auto quads = transformed(SurfaceFactory::grid(5, 5), 1, Point(0, 0, -1));
+    d = SurfaceDistance::one_sided(quads, grid, 1000);
+    EXPECT_NEAR(d.max_distance, 1, 1e-5);
+    EXPECT_THROW(SurfaceDistance::one_sided(grid, quads),
+                 InvalidInputException);
+}
+
+// a smaller square inside a larger one
+TEST(SurfaceDistanceTest, asymmetric)
+{
+    auto large = SurfaceFactory::grid(10, 10, true);
+    auto small = transformed(large, 0.5, Point(0, 0, 0));
+
+    auto d = SurfaceDistance::one_sided(small, large);
+    EXPECT_NEAR(d.max_distance, 0, 1e-5);
+
+    d = SurfaceDistance::one_sided(large, small);
+    EXPECT_NEAR(d.max_distance, std::sqrt(0.5), 1e-5);
+    EXPECT_GT(d.mean_distance, 0.1);
+    EXPECT_LT(d.mean_distance, d.rms_distance);
+
+    auto ds = SurfaceDistance::symmetric(small, large, 50000);
+    EXPECT_NEAR(ds.max_distance, std::sqrt(0.5), 1e-5);
+    EXPECT_LT(ds.rms_distance, d.rms_distance);
+}
+
+TEST(SurfaceDistanceTest, vertex_distances)
+{
+    auto sphere = SurfaceFactory::icosphere(2);
+    auto larger = transformed(sphere, 1.5, Point(0, 0, 0));
+    auto d = SurfaceDistance::vertex_distances(larger, sphere);
+    auto distance = larger.get_vertex_property<Scalar>("v:distance");
+    ASSERT_TRUE(distance);
+    for (auto v : larger.vertices())
+        EXPECT_NEAR(distance[v], 0.5, 1e-5);
+    EXPECT_NEAR(d.max_distance, 0.5, 1e-5);
+    EXPECT_NEAR(d.mean_distance, 0.5, 1e-5);
+    EXPECT_EQ(d.n_samples, 0u);
+}
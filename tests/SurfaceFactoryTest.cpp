@@ -3,7 +3,11 @@
 
 #include "gtest/gtest.h"
 
+#include <pmp/algorithms/DifferentialGeometry.h>
 #include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceNormals.h>
+
+#include <vector>
 
 using namespace pmp;
 
@@ -101,3 +105,105 @@ TEST(SurfaceFactoryTest, uv_sphere)
     EXPECT_FALSE(mesh.is_quad_mesh());
     EXPECT_TRUE(vertices_on_sphere(mesh));
 }
+
+// number of boundary loops
+size_t n_boundaries(const SurfaceMesh& mesh)
+{
+    size_t n = 0;
+    std::vector<bool> visited(mesh.halfedges_size(), false);
+    for (auto h : mesh.halfedges())
+    {
+        if (!mesh.is_boundary(h) || visited[h.idx()])
+            continue;
+        ++n;
+        for (auto hh = h; !visited[hh.idx()]; hh = mesh.next_halfedge(hh))
+            visited[hh.idx()] = true;
+    }
+    return n;
+}
+
+TEST(SurfaceFactoryTest, grid)
+{
+    auto mesh = SurfaceFactory::grid(20, 10);
+    EXPECT_EQ(mesh.n_vertices(), 21u * 11u);
+    EXPECT_EQ(mesh.n_faces(), 200u);
+    EXPECT_TRUE(mesh.is_quad_mesh());
+    EXPECT_EQ(n_boundaries(mesh), 1u);
+    EXPECT_FLOAT_EQ(mesh.bounds().max()[0], 1.0);
+    EXPECT_FLOAT_EQ(mesh.bounds().max()[1], 0.5);
+
+    mesh = SurfaceFactory::grid(20, 10, true);
+    EXPECT_EQ(mesh.n_vertices(), 21u * 11u);
+    EXPECT_EQ(mesh.n_faces(), 400u);
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    for (auto f : mesh.faces())
+        EXPECT_GT(SurfaceNormals::compute_face_normal(mesh, f)[2], 0);
+}
+
+TEST(SurfaceFactoryTest, terrain)
+{
+    auto mesh = SurfaceFactory::terrain(64, 64);
+    EXPECT_EQ(mesh.n_vertices(), 65u * 65u);
+    EXPECT_EQ(mesh.n_faces(), 2u * 64u * 64u);
+    EXPECT_GT(mesh.bounds().max()[2] - mesh.bounds().min()[2], 0.05);
+
+    // the same for the same seed, different otherwise
+    auto same = SurfaceFactory::terrain(64, 64);
+    auto other = SurfaceFactory::terrain(64, 64, 0.5, 1);
+    size_t n_different = 0;
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(mesh.position(v), same.position(v));
+        if (mesh.position(v) != other.position(v))
+            ++n_different;
+    }
+    EXPECT_GT(n_different, mesh.n_vertices() / 2);
+}
+
+TEST(SurfaceFactoryTest, perforated_plate)
+{
+    for (size_t genus : {0, 1, 5})
+    {
+        auto mesh = SurfaceFactory::perforated_plate(genus, 6);
+        EXPECT_TRUE(mesh.is_quad_mesh());
+        EXPECT_EQ(n_boundaries(mesh), 0u);
+        const long euler = long(mesh.n_vertices()) - long(mesh.n_edges()) +
+                           long(mesh.n_faces());
+        EXPECT_EQ(euler, 2 - 2 * long(genus));
+        for (auto v : mesh.vertices())
+            EXPECT_TRUE(mesh.is_manifold(v));
+    }
+}
+
+TEST(SurfaceFactoryTest, defective_grid)
+{
+    SurfaceFactory::Defects defects;
+    defects.n_holes = 3;
+    defects.n_non_manifold_vertices = 2;
+    defects.n_slivers = 4;
+    auto mesh = SurfaceFactory::defective_grid(50, 50, defects);
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+
+    // the outer boundary, the holes, and two gaps per non-manifold vertex
+    EXPECT_EQ(n_boundaries(mesh), 1u + 3u + 2u * 2u);
+
+    size_t n_non_manifold = 0, n_slivers = 0;
+    for (auto v : mesh.vertices())
+        if (!mesh.is_manifold(v))
+            ++n_non_manifold;
+    const Scalar h = 1.0 / 50;
+    for (auto f : mesh.faces())
+    {
+        const Scalar area = triangle_area(mesh, f);
+        EXPECT_GT(area, 0);
+        if (area < 0.01 * h * h)
+            ++n_slivers;
+    }
+    EXPECT_EQ(n_non_manifold, 2u);
+    EXPECT_EQ(n_slivers, 4u);
+    EXPECT_EQ(mesh.n_faces(), 2u * 50u * 50u - 3u * 2u * 9u - 2u * 2u);
+
+    defects.n_holes = 1000;
+    EXPECT_THROW(SurfaceFactory::defective_grid(50, 50, defects),
+                 InvalidInputException);
+}
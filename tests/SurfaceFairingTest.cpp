@@ -34,3 +34,45 @@ TEST(SurfaceFairingTest, fairing_selected)
     auto bb2 = mesh.bounds();
     EXPECT_LT(bb2.size(), bb.size());
 }
+
+TEST(SurfaceFairingTest, fairing_degree_three)
+{
+    SurfaceMesh mesh = hemisphere();
+    auto before = mesh;
+
+    // the two-ring of the boundary is locked
+    std::vector<bool> locked(mesh.vertices_size(), false);
+    for (auto v : mesh.vertices())
+        if (mesh.is_boundary(v))
+            for (auto vv : mesh.vertices(v))
+                for (auto vvv : mesh.vertices(vv))
+                    locked[vvv.idx()] = true;
+
+    SurfaceFairing sf(mesh);
+    sf.fair(3);
+    for (auto v : mesh.vertices())
+    {
+        if (locked[v.idx()])
+        {
+            EXPECT_EQ(mesh.position(v), before.position(v));
+        }
+        EXPECT_TRUE(std::isfinite(norm(mesh.position(v))));
+    }
+    EXPECT_LT(mesh.bounds().size(), before.bounds().size());
+}
+
+TEST(SurfaceFairingTest, cancel)
+{
+    auto mesh = hemisphere();
+    auto reference = mesh;
+    SurfaceFairing sf(mesh);
+    std::vector<float> fractions;
+    sf.set_progress([&](float fraction) {
+        fractions.push_back(fraction);
+        return fractions.size() < 2;
+    });
+    EXPECT_THROW(sf.fair(), CancelledException);
+    EXPECT_EQ(fractions.size(), 2u);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), reference.position(v));
+}
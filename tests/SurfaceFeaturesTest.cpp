@@ -55,3 +55,38 @@ TEST(SurfaceFeaturesTest, detect_boundary)
         }
     EXPECT_TRUE(found);
 }
+
+// compact list of feature edges
+TEST(SurfaceFeaturesTest, feature_edge_list)
+{
+    auto mesh = subdivided_icosahedron();
+    SurfaceFeatures sf(mesh);
+    std::vector<Edge> edges;
+    EXPECT_EQ(sf.detect_angle(25, edges), 240u);
+    ASSERT_EQ(edges.size(), 240u);
+
+    // the list holds exactly the marked edges, in the order of their indices
+    auto efeature = mesh.get_edge_property<bool>("e:feature");
+    auto vfeature = mesh.get_vertex_property<bool>("v:feature");
+    size_t i = 0;
+    for (auto e : mesh.edges())
+    {
+        if (efeature[e])
+        {
+            ASSERT_LT(i, edges.size());
+            EXPECT_EQ(edges[i++], e);
+            EXPECT_TRUE(vfeature[mesh.vertex(e, 0)]);
+            EXPECT_TRUE(vfeature[mesh.vertex(e, 1)]);
+        }
+    }
+    EXPECT_EQ(i, edges.size());
+
+    // boundary edges are appended
+    auto onering = vertex_onering();
+    SurfaceFeatures bf(onering);
+    edges.clear();
+    EXPECT_EQ(bf.detect_boundary(edges), 6u);
+    ASSERT_EQ(edges.size(), 6u);
+    for (auto e : edges)
+        EXPECT_TRUE(onering.is_boundary(e));
+}
@@ -6,6 +6,8 @@
 #include <pmp/algorithms/SurfaceGeodesic.h>
 #include <pmp/algorithms/SurfaceFactory.h>
 
+#include <limits>
+
 using namespace pmp;
 
 TEST(SurfaceGeodesicTest, geodesic)
@@ -85,3 +87,121 @@ TEST(SurfaceGeodesicTest, geodesic_maxnum)
         EXPECT_TRUE(geodist(neighbors[i]) <= geodist(neighbors[i + 1]));
     }
 }
+
+TEST(SurfaceGeodesicTest, geodesic_reuse)
+{
+    // flat ellipsoid with obtuse triangles, i.e., with virtual edges
+    SurfaceMesh mesh = SurfaceFactory::icosphere(3);
+    for (auto v : mesh.vertices())
+        mesh.position(v)[2] *= 0.1;
+
+    std::vector<Scalar> first;
+    {
+        SurfaceGeodesic geodist(mesh);
+        geodist.compute(std::vector<Vertex>{Vertex(0)});
+        for (auto v : mesh.vertices())
+            first.push_back(geodist(v));
+    }
+
+    // later queries reuse the virtual edges and do not affect each other
+    SurfaceGeodesic geodist(mesh);
+    geodist.compute(std::vector<Vertex>{Vertex(1), Vertex(2)});
+    geodist.compute(std::vector<Vertex>{Vertex(0)});
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(geodist(v), first[v.idx()]);
+}
+
+TEST(SurfaceGeodesicTest, geodesic_visited)
+{
+    SurfaceMesh mesh = SurfaceFactory::icosphere(4);
+    SurfaceGeodesic geodist(mesh);
+    const Scalar max = std::numeric_limits<Scalar>::max();
+
+    // farthest point sampling sets the distances of all vertices
+    geodist.farthest_point_sampling(3);
+
+    // local queries only reach a neighborhood, all other vertices are reset
+    for (auto seed : {Vertex(0), Vertex(100), Vertex(0)})
+    {
+        geodist.compute(std::vector<Vertex>{seed}, max, 20);
+        const auto& visited = geodist.visited();
+        EXPECT_GE(visited.size(), 21u);
+        EXPECT_LT(visited.size(), 100u);
+        EXPECT_EQ(visited.front(), seed);
+
+        size_t n_reached = 0;
+        for (auto v : mesh.vertices())
+            if (geodist(v) < max)
+                ++n_reached;
+        EXPECT_EQ(n_reached, visited.size());
+        for (auto v : visited)
+            EXPECT_LT(geodist(v), max);
+    }
+}
+
+TEST(SurfaceGeodesicTest, geodesic_distances)
+{
+    SurfaceMesh mesh = SurfaceFactory::icosphere(3);
+    SurfaceGeodesic geodist(mesh);
+
+    const std::vector<std::vector<Vertex>> seeds{
+        {Vertex(0)}, {Vertex(5), Vertex(50)}, {Vertex(100)}, {}};
+    const Eigen::MatrixXd D = geodist.distances(seeds);
+    ASSERT_EQ(D.rows(), Eigen::Index(mesh.n_vertices()));
+    ASSERT_EQ(D.cols(), Eigen::Index(seeds.size()));
+
+    // each column equals a single query
+    for (size_t j = 0; j < seeds.size(); ++j)
+    {
+        geodist.compute(seeds[j]);
+        for (auto v : mesh.vertices())
+            EXPECT_EQ(D(v.idx(), j), geodist(v));
+    }
+}
+
+TEST(SurfaceGeodesicTest, farthest_point_sampling)
+{
+    SurfaceMesh mesh = SurfaceFactory::icosphere(3);
+    SurfaceGeodesic geodist(mesh);
+
+    std::vector<unsigned int> regions;
+    const auto samples =
+        geodist.farthest_point_sampling(10, Vertex(0), &regions);
+    ASSERT_EQ(samples.size(), 10u);
+    EXPECT_EQ(samples[0], Vertex(0));
+
+    // full distance fields of all samples
+    std::vector<std::vector<Vertex>> seeds;
+    for (auto s : samples)
+        seeds.push_back({s});
+    const Eigen::MatrixXd D = geodist.distances(seeds);
+
+    for (size_t i = 1; i < samples.size(); ++i)
+    {
+        // each sample is farthest from the previous ones
+        double d = std::numeric_limits<double>::max();
+        for (size_t j = 0; j < i; ++j)
+            d = std::min(d, D(samples[i].idx(), j));
+        double farthest = 0.0;
+        for (auto v : mesh.vertices())
+        {
+            double dv = std::numeric_limits<double>::max();
+            for (size_t j = 0; j < i; ++j)
+                dv = std::min(dv, D(v.idx(), j));
+            farthest = std::max(farthest, dv);
+        }
+        EXPECT_NEAR(d, farthest, 1e-2 * farthest);
+    }
+
+    // distances and regions of the closest sample
+    for (auto v : mesh.vertices())
+    {
+        Eigen::Index closest;
+        const double d = D.row(v.idx()).minCoeff(&closest);
+        EXPECT_NEAR(geodist(v), d, 1e-2 * d + 1e-5);
+        EXPECT_NEAR(D(v.idx(), regions[v.idx()]), d, 1e-2 * d + 1e-5);
+    }
+
+    // no more samples than vertices
+    EXPECT_EQ(geodist.farthest_point_sampling(1000).size(), mesh.n_vertices());
+}
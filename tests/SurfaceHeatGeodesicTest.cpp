@@ -0,0 +1,146 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/SurfaceHeatGeodesic.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace pmp;
+
+// great circle distance of two vertices of a unit sphere
+static double sphere_distance(const SurfaceMesh& mesh, Vertex v0, Vertex v1)
+{
+    const dvec3 p0 = normalize(dvec3(mesh.position(v0)));
+    const dvec3 p1 = normalize(dvec3(mesh.position(v1)));
+    return std::acos(std::min(1.0, std::max(-1.0, dot(p0, p1))));
+}
+
+TEST(SurfaceHeatGeodesicTest, sphere)
+{
+    auto mesh = SurfaceFactory::icosphere(5);
+    SurfaceHeatGeodesic geodist(mesh);
+    geodist.compute(std::vector<Vertex>{Vertex(0)});
+
+    EXPECT_EQ(geodist(Vertex(0)), 0);
+    double error = 0.0;
+    for (auto v : mesh.vertices())
+        error += std::fabs(geodist(v) - sphere_distance(mesh, Vertex(0), v));
+    EXPECT_LT(error / mesh.n_vertices(), 0.01);
+
+    geodist.distance_to_texture_coordinates();
+    EXPECT_TRUE(mesh.has_vertex_property("v:tex"));
+}
+
+TEST(SurfaceHeatGeodesicTest, batch)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfaceHeatGeodesic geodist(mesh);
+
+    const std::vector<std::vector<Vertex>> seeds{
+        {Vertex(0)}, {Vertex(10), Vertex(100)}, {}, {Vertex(42)}};
+    const Eigen::MatrixXd D = geodist.distances(seeds);
+    ASSERT_EQ(D.rows(), Eigen::Index(mesh.n_vertices()));
+    ASSERT_EQ(D.cols(), Eigen::Index(seeds.size()));
+
+    // each column equals a single query
+    for (size_t j = 0; j < seeds.size(); ++j)
+    {
+        geodist.compute(seeds[j]);
+        for (auto v : mesh.vertices())
+            EXPECT_NEAR(D(v.idx(), j), geodist(v), 1e-5);
+    }
+
+    // no seeds, no distances
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(D(v.idx(), 2), std::numeric_limits<Scalar>::max());
+
+    // two seeds approximate the minimum distance to each of them
+    geodist.compute({Vertex(10)});
+    std::vector<Scalar> d10(mesh.n_vertices());
+    for (auto v : mesh.vertices())
+        d10[v.idx()] = geodist(v);
+    geodist.compute({Vertex(100)});
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(D(v.idx(), 1), std::min(d10[v.idx()], geodist(v)), 0.1);
+}
+
+TEST(SurfaceHeatGeodesicTest, components)
+{
+    // two spheres, and an isolated vertex
+    auto mesh = SurfaceFactory::icosphere(2);
+    const auto n = mesh.n_vertices();
+    auto other = SurfaceFactory::icosphere(2);
+    std::vector<Vertex> vertices;
+    for (auto v : other.vertices())
+        vertices.push_back(mesh.add_vertex(other.position(v) + Point(3, 0, 0)));
+    for (auto f : other.faces())
+    {
+        std::vector<Vertex> face;
+        for (auto v : other.vertices(f))
+            face.push_back(vertices[v.idx()]);
+        mesh.add_face(face);
+    }
+    const auto isolated = mesh.add_vertex(Point(0, 5, 0));
+
+    SurfaceHeatGeodesic geodist(mesh);
+    const Eigen::MatrixXd D =
+        geodist.distances({{Vertex(0)}, {Vertex(n)}, {isolated}});
+
+    for (auto v : mesh.vertices())
+    {
+        const bool first = v.idx() < n;
+        const bool second = !first && v != isolated;
+        EXPECT_EQ(D(v.idx(), 0) < 3.5, first);
+        EXPECT_EQ(D(v.idx(), 1) < 3.5, second);
+        EXPECT_EQ(D(v.idx(), 2) == 0, v == isolated);
+    }
+    for (auto v : other.vertices())
+        EXPECT_NEAR(D(v.idx() + n, 1),
+                    sphere_distance(other, Vertex(0), v), 0.1);
+}
+
+TEST(SurfaceHeatGeodesicTest, garbage)
+{
+    // deleted elements are skipped, distances match the compacted mesh
+    auto mesh = SurfaceFactory::icosphere(3);
+    mesh.delete_vertex(Vertex(5));
+    mesh.delete_face(Face(100));
+    ASSERT_TRUE(mesh.has_garbage());
+    auto compact = mesh;
+    std::vector<Vertex> vmap;
+    std::vector<Halfedge> hmap;
+    std::vector<Edge> emap;
+    std::vector<Face> fmap;
+    compact.garbage_collection(vmap, hmap, emap, fmap);
+
+    SurfaceHeatGeodesic geodist(mesh);
+    const Eigen::MatrixXd D = geodist.distances({{Vertex(0)}});
+    SurfaceHeatGeodesic compact_geodist(compact);
+    const Eigen::MatrixXd C = compact_geodist.distances({{vmap[0]}});
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(D(v.idx(), 0), C(vmap[v.idx()].idx(), 0), 1e-6);
+    EXPECT_EQ(D(5, 0), std::numeric_limits<Scalar>::max());
+}
+
+TEST(SurfaceHeatGeodesicTest, invalid_seed)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    mesh.delete_vertex(Vertex(5));
+    SurfaceHeatGeodesic geodist(mesh);
+    EXPECT_THROW(geodist.compute({Vertex(5)}), InvalidInputException);
+    EXPECT_THROW(geodist.distances({{Vertex(0)}, {Vertex(0), Vertex()}}),
+                 InvalidInputException);
+    const auto out = Vertex(IndexType(mesh.vertices_size()));
+    EXPECT_THROW(geodist.distances({{out}}), InvalidInputException);
+}
+
+TEST(SurfaceHeatGeodesicTest, non_triangle)
+{
+    auto mesh = SurfaceFactory::hexahedron();
+    EXPECT_THROW(SurfaceHeatGeodesic{mesh}, InvalidInputException);
+}
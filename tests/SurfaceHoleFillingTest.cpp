@@ -4,6 +4,7 @@
 #include "gtest/gtest.h"
 
 #include "pmp/algorithms/SurfaceHoleFilling.h"
+#include "pmp/algorithms/SurfaceFactory.h"
 #include "Helpers.h"
 
 using namespace pmp;
@@ -33,3 +34,101 @@ TEST(SurfaceHoleFillingTest, hemisphere)
     h = find_boundary(mesh);
     EXPECT_FALSE(h.is_valid());
 }
+
+TEST(SurfaceHoleFillingTest, large_hole)
+{
+    // a sphere without its upper half
+    auto mesh = SurfaceFactory::icosphere(4);
+    for (auto f : mesh.faces())
+        for (auto v : mesh.vertices(f))
+            if (mesh.position(v)[2] > 0.1)
+            {
+                mesh.delete_face(f);
+                break;
+            }
+    mesh.garbage_collection();
+
+    Halfedge h = find_boundary(mesh);
+    size_t n = 0;
+    for (auto hh = h; n == 0 || hh != h; hh = mesh.next_halfedge(hh))
+        ++n;
+    ASSERT_GT(n, size_t(40));
+
+    // triangulate in parts of at most 10 vertices
+    SurfaceHoleFilling hf(mesh);
+    hf.fill_hole(h, 10);
+    EXPECT_FALSE(find_boundary(mesh).is_valid());
+    EXPECT_TRUE(mesh.validate().empty());
+}
+
+TEST(SurfaceHoleFillingTest, fill_all_holes)
+{
+    // a sphere with many small holes and a large one
+    auto mesh = SurfaceFactory::icosphere(4);
+    auto blocked = mesh.add_vertex_property<bool>("v:blocked", false);
+    for (IndexType i = 0; i < 200; i += 20)
+    {
+        // keep the holes apart from each other
+        const Vertex v(i);
+        if (blocked[v] || mesh.position(v)[2] > 0.7)
+            continue;
+        for (auto vv : mesh.vertices(v))
+            for (auto vvv : mesh.vertices(vv))
+                for (auto w : mesh.vertices(vvv))
+                    blocked[w] = true;
+        mesh.delete_vertex(v);
+    }
+    for (auto v : mesh.vertices())
+        if (mesh.position(v)[2] > 0.8)
+            mesh.delete_vertex(v);
+    mesh.garbage_collection();
+
+    // count the holes and the small ones
+    size_t n_holes = 0, n_small = 0;
+    std::vector<bool> visited(mesh.halfedges_size(), false);
+    for (auto h : mesh.halfedges())
+    {
+        if (visited[h.idx()] || !mesh.is_boundary(h))
+            continue;
+        size_t size = 0;
+        for (auto hh = h; !visited[hh.idx()]; hh = mesh.next_halfedge(hh))
+        {
+            visited[hh.idx()] = true;
+            ++size;
+        }
+        ++n_holes;
+        if (size <= 10)
+            ++n_small;
+    }
+    ASSERT_GT(n_small, size_t(5));
+    ASSERT_EQ(n_holes, n_small + 1);
+
+    // fill the small holes only
+    SurfaceHoleFilling hf(mesh);
+    EXPECT_EQ(hf.fill_all_holes(10), n_small);
+    EXPECT_TRUE(mesh.validate().empty());
+    size_t n_boundary = 0;
+    for (auto h : mesh.halfedges())
+        if (mesh.is_boundary(h))
+            ++n_boundary;
+    EXPECT_GT(n_boundary, size_t(10));
+
+    // fill the rest
+    EXPECT_EQ(hf.fill_all_holes(), size_t(1));
+    EXPECT_FALSE(find_boundary(mesh).is_valid());
+    EXPECT_TRUE(mesh.validate().empty());
+}
+
+// a cancelled hole is triangulated, but not refined
+TEST(SurfaceHoleFillingTest, cancel)
+{
+    auto mesh = hemisphere();
+    const size_t n_vertices = mesh.n_vertices();
+    SurfaceHoleFilling hf(mesh);
+    hf.set_progress([](float) { return false; });
+    EXPECT_THROW(hf.fill_hole(find_boundary(mesh)), CancelledException);
+    EXPECT_FALSE(find_boundary(mesh).is_valid());
+    EXPECT_EQ(mesh.n_vertices(), n_vertices);
+    EXPECT_TRUE(mesh.validate().empty());
+    EXPECT_FALSE(mesh.has_vertex_property("SurfaceHoleFilling:vlocked"));
+}
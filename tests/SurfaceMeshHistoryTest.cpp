@@ -0,0 +1,254 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/SurfaceMeshHistory.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceSubdivision.h>
+
+using namespace pmp;
+
+// compare all elements, including the deleted ones
+void expect_equal(const SurfaceMesh& a, const SurfaceMesh& b)
+{
+    ASSERT_EQ(a.vertices_size(), b.vertices_size());
+    ASSERT_EQ(a.halfedges_size(), b.halfedges_size());
+    ASSERT_EQ(a.faces_size(), b.faces_size());
+    EXPECT_EQ(a.n_vertices(), b.n_vertices());
+    EXPECT_EQ(a.n_edges(), b.n_edges());
+    EXPECT_EQ(a.n_faces(), b.n_faces());
+
+    for (IndexType i = 0; i < a.vertices_size(); ++i)
+    {
+        const Vertex v(i);
+        EXPECT_EQ(a.is_deleted(v), b.is_deleted(v));
+        EXPECT_EQ(a.position(v), b.position(v));
+        EXPECT_EQ(a.halfedge(v), b.halfedge(v));
+    }
+    for (IndexType i = 0; i < a.halfedges_size(); ++i)
+    {
+        const Halfedge h(i);
+        EXPECT_EQ(a.is_deleted(h), b.is_deleted(h));
+        EXPECT_EQ(a.to_vertex(h), b.to_vertex(h));
+        EXPECT_EQ(a.next_halfedge(h), b.next_halfedge(h));
+        EXPECT_EQ(a.prev_halfedge(h), b.prev_halfedge(h));
+        EXPECT_EQ(a.face(h), b.face(h));
+    }
+    for (IndexType i = 0; i < a.faces_size(); ++i)
+    {
+        const Face f(i);
+        EXPECT_EQ(a.is_deleted(f), b.is_deleted(f));
+        EXPECT_EQ(a.halfedge(f), b.halfedge(f));
+    }
+}
+
+TEST(SurfaceMeshHistoryTest, topology)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    const Edge e0(10);
+    ASSERT_TRUE(mesh.is_flip_ok(e0));
+    mesh.flip(e0);
+    const Halfedge h(100);
+    ASSERT_TRUE(mesh.is_collapse_ok(h));
+    mesh.collapse(h);
+    mesh.split(Edge(200), Point(0, 0, 0));
+    history.commit("edits");
+    const SurfaceMesh edited = mesh;
+
+    ASSERT_TRUE(history.can_undo());
+    EXPECT_EQ(history.undo_name(), "edits");
+    history.undo();
+    expect_equal(mesh, original);
+    EXPECT_FALSE(history.can_undo());
+    ASSERT_TRUE(history.can_redo());
+
+    history.redo();
+    expect_equal(mesh, edited);
+    history.undo();
+    expect_equal(mesh, original);
+}
+
+TEST(SurfaceMeshHistoryTest, memory_scales_with_edit)
+{
+    auto mesh = SurfaceFactory::icosphere(5);
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    mesh.position(Vertex(0)) += Point(1, 0, 0);
+    mesh.flip(Edge(10));
+    history.commit("move and flip");
+    EXPECT_LT(history.memory_usage(), 2000u);
+
+    // all positions are saved, but not the connectivity
+    history.begin();
+    for (auto& p : mesh.positions())
+        p *= 2;
+    history.commit("scale");
+    EXPECT_LT(history.memory_usage(),
+              mesh.n_vertices() * sizeof(Point) + 4000);
+
+    history.undo();
+    history.undo();
+    expect_equal(mesh, original);
+}
+
+TEST(SurfaceMeshHistoryTest, garbage_collection)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    mesh.delete_vertex(Vertex(5));
+    mesh.delete_face(Face(40));
+    mesh.garbage_collection();
+    history.commit("delete");
+    const SurfaceMesh edited = mesh;
+    EXPECT_LT(mesh.n_faces(), original.n_faces());
+
+    history.undo();
+    expect_equal(mesh, original);
+    history.redo();
+    expect_equal(mesh, edited);
+}
+
+TEST(SurfaceMeshHistoryTest, properties)
+{
+    auto mesh = SurfaceFactory::icosahedron();
+    auto weights = mesh.add_vertex_property<float>("v:weight", 1.0f);
+    weights[Vertex(3)] = 3.0f;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    mesh.remove_vertex_property(weights);
+    auto colors = mesh.add_face_property<Color>("f:color");
+    colors[Face(0)] = Color(1, 0, 0);
+    auto temporary = mesh.add_edge_property<int>("e:temporary");
+    mesh.remove_edge_property(temporary);
+    history.commit("properties");
+
+    // a property added without recording is replaced when undoing
+    mesh.add_vertex_property<int>("v:weight");
+    history.undo();
+    EXPECT_FALSE(mesh.has_face_property("f:color"));
+    EXPECT_FALSE(mesh.has_edge_property("e:temporary"));
+    weights = mesh.get_vertex_property<float>("v:weight");
+    ASSERT_TRUE(weights);
+    EXPECT_EQ(weights[Vertex(3)], 3.0f);
+    EXPECT_EQ(weights[Vertex(4)], 1.0f);
+
+    // redo restores the property replaced by undo
+    history.redo();
+    EXPECT_FALSE(mesh.get_vertex_property<float>("v:weight"));
+    EXPECT_TRUE(mesh.get_vertex_property<int>("v:weight"));
+    colors = mesh.get_face_property<Color>("f:color");
+    ASSERT_TRUE(colors);
+    EXPECT_EQ(colors[Face(0)], Color(1, 0, 0));
+}
+
+TEST(SurfaceMeshHistoryTest, rollback)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    mesh.split(Face(3), Point(0, 0, 0));
+    mesh.position(Vertex(7)) = Point(1, 2, 3);
+    history.rollback();
+    expect_equal(mesh, original);
+    EXPECT_FALSE(history.is_recording());
+    EXPECT_FALSE(history.can_undo());
+}
+
+TEST(SurfaceMeshHistoryTest, clear_and_copy)
+{
+    auto mesh = SurfaceFactory::hexahedron();
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    history.begin();
+    mesh.clear();
+    history.commit("clear");
+    EXPECT_EQ(mesh.n_vertices(), 0u);
+
+    history.begin();
+    mesh = SurfaceFactory::icosahedron();
+    history.commit("copy");
+
+    history.undo();
+    EXPECT_EQ(mesh.n_vertices(), 0u);
+    history.undo();
+    expect_equal(mesh, original);
+    history.redo();
+    history.redo();
+    expect_equal(mesh, SurfaceFactory::icosahedron());
+}
+
+TEST(SurfaceMeshHistoryTest, assign)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+    const SurfaceMesh original = mesh;
+    SurfaceMeshHistory history(mesh);
+
+    // a copy with a single moved vertex is stored as a single position
+    SurfaceMesh moved = mesh;
+    moved.position(Vertex(42)) = Point(2, 0, 0);
+    history.assign(moved, "move");
+    expect_equal(mesh, moved);
+    EXPECT_LT(history.memory_usage(), 1000u);
+
+    SurfaceMesh subdivided = mesh;
+    SurfaceSubdivision(subdivided).loop();
+    history.assign(subdivided, "subdivide");
+    expect_equal(mesh, subdivided);
+
+    history.undo();
+    history.undo();
+    expect_equal(mesh, original);
+    history.redo();
+    history.redo();
+    expect_equal(mesh, subdivided);
+}
+
+TEST(SurfaceMeshHistoryTest, redo_and_memory_limit)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfaceMeshHistory history(mesh);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        history.begin();
+        for (auto v : mesh.vertices())
+            mesh.position(v) *= 2;
+        history.commit("scale");
+    }
+    EXPECT_EQ(history.n_undo(), 3u);
+
+    // a new edit discards the undone ones, an empty one is dropped
+    history.undo();
+    EXPECT_EQ(history.n_redo(), 1u);
+    history.begin();
+    mesh.position(Vertex(0)) = Point(0, 0, 0);
+    history.commit("move");
+    EXPECT_EQ(history.n_redo(), 0u);
+    history.begin();
+    history.commit("nothing");
+    EXPECT_EQ(history.n_undo(), 3u);
+    EXPECT_EQ(history.undo_name(), "move");
+
+    history.set_memory_limit(history.memory_usage() / 2);
+    EXPECT_LT(history.n_undo(), 3u);
+    EXPECT_GE(history.n_undo(), 1u);
+
+    EXPECT_THROW(history.commit("none"), InvalidInputException);
+    history.begin();
+    EXPECT_THROW(history.undo(), InvalidInputException);
+    history.rollback();
+}
@@ -3,9 +3,28 @@
 
 #include "SurfaceMeshTest.h"
 
+#include <pmp/Compression.h>
+#include <pmp/SurfaceMeshIO.h>
+#include <pmp/algorithms/SurfaceFactory.h>
 #include <pmp/algorithms/SurfaceNormals.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 using namespace pmp;
 
 class SurfaceMeshIOTest : public SurfaceMeshTest
@@ -26,6 +45,117 @@ TEST_F(SurfaceMeshIOTest, poly_io)
     EXPECT_THROW(mesh.write("testpolyly"), IOException);
 }
 
+TEST_F(SurfaceMeshIOTest, pmp_properties)
+{
+    auto sphere = SurfaceFactory::icosphere(2);
+    auto vint = sphere.add_vertex_property<int>("v:int");
+    sphere.add_halfedge_property<vec3>("h:vec3", vec3(1, 2, 3));
+    auto ebool = sphere.add_edge_property<bool>("e:bool");
+    auto fvertex = sphere.add_face_property<Vertex>("f:vertex");
+    auto oname = sphere.add_object_property<double>("g:double");
+    sphere.add_vertex_property<std::vector<int>>("v:unsupported");
+    for (auto v : sphere.vertices())
+        vint[v] = 3 * int(v.idx());
+    for (auto e : sphere.edges())
+        ebool[e] = e.idx() % 3 == 0;
+    for (auto f : sphere.faces())
+        fvertex[f] = sphere.to_vertex(sphere.halfedge(f));
+    oname[0] = 0.125;
+
+    // deleted elements are removed before writing
+    sphere.delete_face(Face(0));
+    sphere.write("properties.pmp");
+    sphere.garbage_collection();
+
+    for (int mapped = 0; mapped < 2; ++mapped)
+    {
+        IOFlags flags;
+        flags.use_memory_mapping = mapped != 0;
+        mesh.read("properties.pmp", flags);
+        EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+        EXPECT_EQ(mesh.n_edges(), sphere.n_edges());
+        EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+        EXPECT_TRUE(mesh.validate().empty());
+        EXPECT_FALSE(mesh.has_vertex_property("v:unsupported"));
+
+        auto points = mesh.get_vertex_property<Point>("v:point");
+        EXPECT_EQ(points.is_external(), mapped != 0);
+
+        auto rvint = mesh.get_vertex_property<int>("v:int");
+        auto rhvec = mesh.get_halfedge_property<vec3>("h:vec3");
+        auto rebool = mesh.get_edge_property<bool>("e:bool");
+        auto rfvertex = mesh.get_face_property<Vertex>("f:vertex");
+        auto roname = mesh.get_object_property<double>("g:double");
+        ASSERT_TRUE(rvint && rhvec && rebool && rfvertex && roname);
+        for (auto v : mesh.vertices())
+        {
+            EXPECT_EQ(mesh.position(v), sphere.position(v));
+            EXPECT_EQ(rvint[v], vint[v]);
+        }
+        for (auto h : mesh.halfedges())
+            EXPECT_EQ(rhvec[h], vec3(1, 2, 3));
+        for (auto e : mesh.edges())
+            EXPECT_EQ(rebool[e], ebool[e]);
+        for (auto f : mesh.faces())
+            EXPECT_EQ(rfvertex[f], fvertex[f]);
+        EXPECT_EQ(roname[0], 0.125);
+
+        // modifications do not change the file
+        mesh.position(Vertex(0)) = Point(1, 2, 3);
+        mesh.delete_vertex(Vertex(1));
+        mesh.garbage_collection();
+        EXPECT_TRUE(mesh.validate().empty());
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, pmp_version_1)
+{
+    add_triangle();
+
+    // write the header-less format of version 1
+    {
+        FILE* out = fopen("version_1.pmp", "wb");
+        unsigned int n[3] = {3, 3, 1};
+        bool has_htex = false;
+        fwrite(n, sizeof(n), 1, out);
+        fwrite(&has_htex, sizeof(has_htex), 1, out);
+        for (auto v : mesh.vertices())
+        {
+            Halfedge h = mesh.halfedge(v);
+            fwrite(&h, sizeof(h), 1, out);
+        }
+        for (auto h : mesh.halfedges())
+        {
+            Face f = mesh.face(h);
+            Vertex v = mesh.to_vertex(h);
+            Halfedge next = mesh.next_halfedge(h);
+            Halfedge prev = mesh.prev_halfedge(h);
+            fwrite(&f, sizeof(f), 1, out);
+            fwrite(&v, sizeof(v), 1, out);
+            fwrite(&next, sizeof(next), 1, out);
+            fwrite(&prev, sizeof(prev), 1, out);
+        }
+        for (auto f : mesh.faces())
+        {
+            Halfedge h = mesh.halfedge(f);
+            fwrite(&h, sizeof(h), 1, out);
+        }
+        for (auto v : mesh.vertices())
+        {
+            Point p = mesh.position(v);
+            fwrite(&p, sizeof(p), 1, out);
+        }
+        fclose(out);
+    }
+
+    SurfaceMesh copy;
+    copy.read("version_1.pmp");
+    EXPECT_EQ(copy.n_vertices(), size_t(3));
+    EXPECT_EQ(copy.n_faces(), size_t(1));
+    EXPECT_EQ(copy.position(Vertex(2)), mesh.position(Vertex(2)));
+    EXPECT_TRUE(copy.validate().empty());
+}
+
 TEST_F(SurfaceMeshIOTest, obj_io)
 {
     add_triangle();
@@ -39,6 +169,106 @@ TEST_F(SurfaceMeshIOTest, obj_io)
     EXPECT_EQ(mesh.n_faces(), size_t(1));
 }
 
+TEST_F(SurfaceMeshIOTest, read_triangulate)
+{
+    // reading and triangulating gives the same triangles as triangulating
+    // the mesh that was written
+    SurfaceMesh reference = SurfaceFactory::quad_sphere(1);
+    for (auto name : {"triangulate.obj", "triangulate.off"})
+    {
+        reference.write(name);
+        mesh.read(name);
+        SurfaceMesh expected = reference;
+        expected.triangulate();
+        mesh.triangulate();
+
+        ASSERT_EQ(mesh.n_faces(), expected.n_faces());
+        for (auto f : expected.faces())
+        {
+            std::vector<Vertex> fv, fw;
+            for (auto v : expected.vertices(f))
+                fv.push_back(v);
+            for (auto v : mesh.vertices(f))
+                fw.push_back(v);
+            EXPECT_EQ(fv, fw);
+        }
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, obj_syntax)
+{
+    std::ofstream("syntax.obj", std::ios::binary)
+        << "# comment\r\n"
+        << "v 0 0 0\r\n"
+        << "v 1 0 .5\r\n"
+        << "  v -1.25E-1 1 3\r\n"
+        << "v 1e1 1e+1 -2.5e-01\n"
+        << "vt 0.25 0.75\n"
+        << "vt 1 0\n"
+        << "vn 0 0 1\n"
+        << "f 1/1/1 2/2/1 3/1/1\n"
+        << "f -3//1 -1//1 -2//1\n"
+        << "f 4" << std::string(300, ' ') << "2 1\n"
+        << "f 1 2\n";
+
+    mesh.read("syntax.obj");
+    EXPECT_EQ(mesh.n_vertices(), size_t(4));
+    EXPECT_EQ(mesh.n_faces(), size_t(3));
+    EXPECT_EQ(mesh.position(Vertex(1)), Point(1, 0, 0.5));
+    EXPECT_EQ(mesh.position(Vertex(2)), Point(-0.125, 1, 3));
+    EXPECT_EQ(mesh.position(Vertex(3)), Point(10, 10, -0.25));
+
+    auto tex = mesh.get_halfedge_property<TexCoord>("h:tex");
+    ASSERT_TRUE(tex);
+    for (auto h : mesh.halfedges(Face(0)))
+    {
+        auto expected = mesh.to_vertex(h) == Vertex(1) ? TexCoord(1, 0)
+                                                       : TexCoord(0.25, 0.75);
+        EXPECT_EQ(tex[h], expected);
+    }
+
+    std::ofstream("invalid.obj") << "v 0 0 0\nv 1 0 0\nf 1 2 3\n";
+    EXPECT_THROW(mesh.read("invalid.obj"), IOException);
+}
+
+TEST_F(SurfaceMeshIOTest, obj_large)
+{
+    // large enough to be parsed in multiple chunks
+    auto sphere = SurfaceFactory::icosphere(6);
+    sphere.write("large.obj");
+    mesh.read("large.obj");
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+    for (auto v : sphere.vertices())
+        EXPECT_LT(norm(mesh.position(v) - sphere.position(v)), 1e-6);
+
+    // same faces, possibly starting at different vertices
+    for (auto f : sphere.faces())
+    {
+        auto v0 = *sphere.vertices(f);
+        auto h = mesh.halfedge(f);
+        while (mesh.to_vertex(h) != v0)
+            h = mesh.next_halfedge(h);
+        for (auto v : sphere.vertices(f))
+        {
+            EXPECT_EQ(mesh.to_vertex(h), v);
+            h = mesh.next_halfedge(h);
+        }
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, obj_non_manifold)
+{
+    std::ofstream("non_manifold.obj")
+        << "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 -1 0\nv 0 0 1\n"
+        << "f 1 2 3\nf 2 1 4\nf 1 2 5\n";
+    mesh.read("non_manifold.obj");
+
+    // the endpoints of the edge are split for the third face
+    EXPECT_EQ(mesh.n_vertices(), size_t(7));
+    EXPECT_EQ(mesh.n_faces(), size_t(3));
+}
+
 TEST_F(SurfaceMeshIOTest, off_io)
 {
     add_triangle();
@@ -75,6 +305,37 @@ TEST_F(SurfaceMeshIOTest, off_io_binary)
     EXPECT_EQ(mesh.n_faces(), size_t(1));
 }
 
+TEST_F(SurfaceMeshIOTest, off_io_binary_blocks)
+{
+    // polygons and deleted vertices
+    auto cube = SurfaceFactory::hexahedron();
+    cube.delete_vertex(Vertex(0));
+    auto sphere = SurfaceFactory::icosphere(3);
+
+    IOFlags flags;
+    flags.use_binary = true;
+    for (const auto* input : {&cube, &sphere})
+    {
+        input->write("binary.off", flags);
+        mesh.read("binary.off");
+        EXPECT_EQ(mesh.n_vertices(), input->n_vertices());
+        EXPECT_EQ(mesh.n_faces(), input->n_faces());
+        EXPECT_EQ(mesh.n_edges(), input->n_edges());
+        auto v = mesh.vertices().begin();
+        for (auto w : input->vertices())
+            EXPECT_EQ(mesh.position(*v++), input->position(w));
+    }
+
+    // truncated face block
+    std::ifstream in("binary.off", std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream("binary.off", std::ios::binary)
+        .write(data.data(), data.size() - sizeof(IndexType));
+    EXPECT_THROW(mesh.read("binary.off"), IOException);
+}
+
 TEST_F(SurfaceMeshIOTest, stl_io)
 {
     mesh.read("pmp-data/stl/icosahedron_ascii.stl");
@@ -87,10 +348,8 @@ TEST_F(SurfaceMeshIOTest, stl_io)
     EXPECT_EQ(mesh.n_faces(), size_t(20));
     EXPECT_EQ(mesh.n_edges(), size_t(30));
 
-    // try to write without normals being present
-    ASSERT_THROW(mesh.write("test.stl"), InvalidInputException);
-
-    // the same with normals computed
+    // face normals are computed if not present
+    EXPECT_NO_THROW(mesh.write("test.stl"));
     SurfaceNormals::compute_face_normals(mesh);
     EXPECT_NO_THROW(mesh.write("test.stl"));
 
@@ -100,6 +359,84 @@ TEST_F(SurfaceMeshIOTest, stl_io)
     ASSERT_THROW(mesh.write("test.stl"), InvalidInputException);
 }
 
+TEST_F(SurfaceMeshIOTest, stl_io_binary)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    sphere.delete_face(Face(0));
+    IOFlags flags;
+    flags.use_binary = true;
+    sphere.write("binary.stl", flags);
+
+    // header, face count, and 50 bytes per face
+    auto info = SurfaceMeshIO::probe("binary.stl");
+    EXPECT_TRUE(info.is_binary);
+    EXPECT_EQ(info.n_faces, sphere.n_faces());
+    FILE* in = fopen("binary.stl", "rb");
+    ASSERT_NE(in, nullptr);
+    fseek(in, 0, SEEK_END);
+    EXPECT_EQ(size_t(ftell(in)), 84 + 50 * sphere.n_faces());
+    fclose(in);
+
+    mesh.read("binary.stl");
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+
+    // the same mesh as the ASCII file
+    SurfaceMesh ascii;
+    sphere.write("ascii.stl");
+    ascii.read("ascii.stl");
+    EXPECT_EQ(ascii.n_vertices(), mesh.n_vertices());
+    EXPECT_EQ(ascii.n_faces(), mesh.n_faces());
+    for (auto v : mesh.vertices())
+        EXPECT_LT(norm(mesh.position(v) - ascii.position(v)), 1e-6);
+}
+
+TEST_F(SurfaceMeshIOTest, stl_welding)
+{
+    // ASCII round trip
+    auto ico = SurfaceFactory::icosahedron();
+    SurfaceNormals::compute_face_normals(ico);
+    ico.write("welding.stl");
+    mesh.read("welding.stl");
+    EXPECT_EQ(mesh.n_vertices(), size_t(12));
+    EXPECT_EQ(mesh.n_faces(), size_t(20));
+
+    // binary file with slightly displaced corners and a header starting
+    // with "solid"
+    {
+        std::ofstream ofs("welding_binary.stl", std::ios::binary);
+        char header[80] = "solid but binary";
+        ofs.write(header, 80);
+        uint32_t n_triangles = uint32_t(ico.n_faces());
+        ofs.write(reinterpret_cast<const char*>(&n_triangles), 4);
+        int i = 0;
+        for (auto f : ico.faces())
+        {
+            float data[12] = {0};
+            int j = 3;
+            for (auto v : ico.vertices(f))
+            {
+                ++i;
+                for (int k = 0; k < 3; ++k)
+                    data[j++] = float(ico.position(v)[k]) + 1e-6f * float(i);
+            }
+            ofs.write(reinterpret_cast<const char*>(data), sizeof(data));
+            ofs.write("\0\0", 2);
+        }
+    }
+
+    mesh.read("welding_binary.stl");
+    EXPECT_EQ(mesh.n_vertices(), size_t(60));
+    EXPECT_EQ(mesh.n_faces(), size_t(20));
+
+    IOFlags flags;
+    flags.weld_tolerance = Scalar(1e-4);
+    mesh.read("welding_binary.stl", flags);
+    EXPECT_EQ(mesh.n_vertices(), size_t(12));
+    EXPECT_EQ(mesh.n_faces(), size_t(20));
+    EXPECT_EQ(mesh.n_edges(), size_t(30));
+}
+
 TEST_F(SurfaceMeshIOTest, ply_io)
 {
     add_triangle();
@@ -126,6 +463,680 @@ TEST_F(SurfaceMeshIOTest, ply_io_binary)
     EXPECT_EQ(mesh.n_faces(), size_t(1));
 }
 
+TEST_F(SurfaceMeshIOTest, ply_binary_attributes)
+{
+    auto sphere = SurfaceFactory::icosphere(2);
+    SurfaceNormals::compute_vertex_normals(sphere);
+    auto colors = sphere.vertex_property<Color>("v:color");
+    for (auto v : sphere.vertices())
+        colors[v] = Color(0, 1, v.idx() % 2);
+
+    // deleted vertices are skipped
+    sphere.delete_vertex(Vertex(0));
+
+    IOFlags flags;
+    flags.use_binary = true;
+    flags.use_vertex_normals = true;
+    flags.use_vertex_colors = true;
+    sphere.write("attributes.ply", flags);
+
+    mesh.read("attributes.ply");
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto read_colors = mesh.get_vertex_property<Color>("v:color");
+    ASSERT_TRUE(normals);
+    ASSERT_TRUE(read_colors);
+    auto sphere_normals = sphere.get_vertex_property<Normal>("v:normal");
+    IndexType i = 0;
+    for (auto v : sphere.vertices())
+    {
+        Vertex w(i++);
+        EXPECT_LT(norm(mesh.position(w) - sphere.position(v)), 1e-6);
+        EXPECT_LT(norm(normals[w] - sphere_normals[v]), 1e-6);
+        EXPECT_EQ(read_colors[w], colors[v]);
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, ply_binary_fallback)
+{
+    // an extra face property is read through rply
+    const float points[9] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    const unsigned char n = 3, flag = 7;
+    const int32_t indices[3] = {0, 1, 2};
+    {
+        std::ofstream ofs("fallback.ply", std::ios::binary);
+        ofs << "ply\nformat binary_little_endian 1.0\nelement vertex 3\n"
+            << "property float x\nproperty float y\nproperty float z\n"
+            << "element face 1\nproperty list uchar int vertex_indices\n"
+            << "property uchar flags\nend_header\n";
+        ofs.write(reinterpret_cast<const char*>(points), sizeof(points));
+        ofs.write(reinterpret_cast<const char*>(&n), 1);
+        ofs.write(reinterpret_cast<const char*>(indices), sizeof(indices));
+        ofs.write(reinterpret_cast<const char*>(&flag), 1);
+    }
+    mesh.read("fallback.ply");
+    EXPECT_EQ(mesh.n_vertices(), size_t(3));
+    EXPECT_EQ(mesh.n_faces(), size_t(1));
+    EXPECT_EQ(mesh.position(Vertex(1)), Point(1, 0, 0));
+}
+
+TEST_F(SurfaceMeshIOTest, off_ascii_format)
+{
+    // many blocks, and values that need careful rounding
+    auto sphere = SurfaceFactory::icosphere(5);
+    sphere.position(Vertex(0)) = Point(-0.0, 1e9, 5e-11);
+    sphere.position(Vertex(1)) = Point(0.99999999995, -123.456, 1e-12);
+    sphere.write("format.off");
+
+    std::string expected = "OFF\n" + std::to_string(sphere.n_vertices()) +
+                           " " + std::to_string(sphere.n_faces()) + " 0\n";
+    char line[256];
+    for (auto v : sphere.vertices())
+    {
+        const auto& p = sphere.position(v);
+        snprintf(line, sizeof(line), "%.10f %.10f %.10f\n", p[0], p[1], p[2]);
+        expected += line;
+    }
+    for (auto f : sphere.faces())
+    {
+        expected += std::to_string(sphere.valence(f));
+        for (auto v : sphere.vertices(f))
+            expected += " " + std::to_string(v.idx());
+        expected += "\n";
+    }
+
+    std::ifstream ifs("format.off", std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(ifs)),
+                        std::istreambuf_iterator<char>());
+    EXPECT_EQ(written, expected);
+
+    mesh.read("format.off");
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+}
+
+TEST_F(SurfaceMeshIOTest, compressed_io)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    SurfaceNormals::compute_face_normals(sphere);
+
+    std::vector<Compression> compressions;
+    for (auto c : {Compression::Gzip, Compression::Zstd})
+        if (is_compression_supported(c))
+            compressions.push_back(c);
+
+    for (auto compression : compressions)
+    {
+        const std::string suffix =
+            compression == Compression::Gzip ? ".gz" : ".zst";
+        for (std::string format : {"obj", "off", "ply", "pmp", "stl"})
+        {
+            for (bool binary : {false, true})
+            {
+                IOFlags flags;
+                flags.use_binary = binary;
+                const std::string filename = "compressed." + format + suffix;
+                sphere.write(filename, flags);
+
+                // the file is compressed
+                FILE* in = fopen(filename.c_str(), "rb");
+                ASSERT_NE(in, nullptr);
+                char magic[4];
+                size_t n = fread(magic, 1, sizeof(magic), in);
+                fclose(in);
+                EXPECT_EQ(detect_compression(magic, n), compression);
+
+                mesh.read(filename);
+                EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices()) << filename;
+                EXPECT_EQ(mesh.n_faces(), sphere.n_faces()) << filename;
+            }
+        }
+    }
+
+    // compression chosen by flags, detected when reading
+    if (!compressions.empty())
+    {
+        IOFlags flags;
+        flags.compression = compressions[0];
+        sphere.write("compressed.off", flags);
+        mesh.read("compressed.off");
+        EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, corrupt_compressed_file)
+{
+    if (!is_compression_supported(Compression::Gzip))
+        return;
+
+    auto sphere = SurfaceFactory::icosphere(3);
+    sphere.write("corrupt.obj.gz");
+
+    // truncate the file
+    std::vector<char> data;
+    {
+        std::ifstream ifs("corrupt.obj.gz", std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(ifs),
+                    std::istreambuf_iterator<char>());
+    }
+    std::ofstream ofs("corrupt.obj.gz", std::ios::binary);
+    ofs.write(data.data(), data.size() / 2);
+    ofs.close();
+
+    EXPECT_THROW(mesh.read("corrupt.obj.gz"), IOException);
+}
+
+namespace {
+
+// check that b equals a up to vertex order, face order, and quantization
+void expect_equivalent(const SurfaceMesh& a, const SurfaceMesh& b,
+                       Scalar tolerance)
+{
+    ASSERT_EQ(a.n_vertices(), b.n_vertices());
+    ASSERT_EQ(a.n_faces(), b.n_faces());
+
+    // match vertices by position
+    std::vector<IndexType> to_a(b.vertices_size());
+    for (auto vb : b.vertices())
+    {
+        Scalar min_dist = std::numeric_limits<Scalar>::max();
+        for (auto va : a.vertices())
+        {
+            const Scalar d = distance(a.position(va), b.position(vb));
+            if (d < min_dist)
+            {
+                min_dist = d;
+                to_a[vb.idx()] = va.idx();
+            }
+        }
+        EXPECT_LE(min_dist, tolerance);
+    }
+
+    // compare faces with the same orientation
+    auto face_key = [](std::vector<IndexType> face) {
+        std::rotate(face.begin(), std::min_element(face.begin(), face.end()),
+                    face.end());
+        return face;
+    };
+    std::set<std::vector<IndexType>> faces;
+    for (auto f : a.faces())
+    {
+        std::vector<IndexType> face;
+        for (auto v : a.vertices(f))
+            face.push_back(v.idx());
+        faces.insert(face_key(face));
+    }
+    for (auto f : b.faces())
+    {
+        std::vector<IndexType> face;
+        for (auto v : b.vertices(f))
+            face.push_back(to_a[v.idx()]);
+        EXPECT_EQ(faces.count(face_key(face)), 1u);
+    }
+}
+
+SurfaceMesh pmc_round_trip(const SurfaceMesh& mesh,
+                           const IOFlags& flags = IOFlags())
+{
+    auto data = SurfaceMeshIO::encode(mesh, flags);
+    SurfaceMesh result;
+    SurfaceMeshIO::decode(data.data(), data.size(), result);
+    return result;
+}
+
+} // namespace
+
+TEST_F(SurfaceMeshIOTest, pmc_io)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    SurfaceNormals::compute_vertex_normals(sphere);
+    auto tex = sphere.add_vertex_property<TexCoord>("v:tex");
+    for (auto v : sphere.vertices())
+        tex[v] = TexCoord(sphere.position(v)[0], sphere.position(v)[1]);
+
+    IOFlags flags;
+    flags.use_vertex_normals = true;
+    flags.use_vertex_texcoords = true;
+    sphere.write("test.pmc", flags);
+    mesh.read("test.pmc");
+    expect_equivalent(sphere, mesh, 1e-3);
+
+    // attributes are stored at their vertices
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    auto texcoords = mesh.get_vertex_property<TexCoord>("v:tex");
+    ASSERT_TRUE(normals && texcoords);
+    for (auto v : mesh.vertices())
+    {
+        const Point& p = mesh.position(v);
+        EXPECT_GT(dot(normals[v], normalize(p)), 0.999);
+        EXPECT_NEAR(texcoords[v][0], p[0], 1e-3);
+        EXPECT_NEAR(texcoords[v][1], p[1], 1e-3);
+    }
+
+    // attributes are only written if requested
+    sphere.write("test.pmc");
+    mesh.read("test.pmc");
+    EXPECT_FALSE(mesh.has_vertex_property("v:normal"));
+    EXPECT_FALSE(mesh.has_vertex_property("v:tex"));
+
+    flags.quantization_bits = 0;
+    EXPECT_THROW(SurfaceMeshIO::encode(sphere, flags), InvalidInputException);
+}
+
+TEST_F(SurfaceMeshIOTest, pmc_compression_ratio)
+{
+    auto sphere = SurfaceFactory::icosphere(5);
+    IOFlags flags;
+    flags.use_binary = true;
+    sphere.write("test.ply", flags);
+    std::ifstream ply("test.ply", std::ios::binary | std::ios::ate);
+    const auto ply_size = size_t(ply.tellg());
+
+    const auto pmc_size = SurfaceMeshIO::encode(sphere).size();
+    EXPECT_GE(ply_size, 10 * pmc_size);
+}
+
+TEST_F(SurfaceMeshIOTest, pmc_topology)
+{
+    // torus
+    const int n = 24, m = 12;
+    SurfaceMesh torus;
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < m; ++j)
+        {
+            const Scalar u = 2 * M_PI * i / n, v = 2 * M_PI * j / m;
+            torus.add_vertex(Point((2 + std::cos(v)) * std::cos(u),
+                                   (2 + std::cos(v)) * std::sin(u),
+                                   std::sin(v)));
+        }
+    auto vertex = [&](int i, int j) {
+        return Vertex(static_cast<IndexType>((i % n) * m + j % m));
+    };
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < m; ++j)
+        {
+            torus.add_triangle(vertex(i, j), vertex(i + 1, j),
+                               vertex(i + 1, j + 1));
+            torus.add_triangle(vertex(i, j), vertex(i + 1, j + 1),
+                               vertex(i, j + 1));
+        }
+    expect_equivalent(torus, pmc_round_trip(torus), 1e-3);
+
+    // boundaries
+    auto sphere = SurfaceFactory::icosphere(3);
+    for (IndexType i = 0; i < 40; i += 3)
+        sphere.delete_face(Face(i));
+    sphere.garbage_collection();
+    expect_equivalent(sphere, pmc_round_trip(sphere), 1e-3);
+
+    // several components and an isolated vertex
+    auto components = SurfaceFactory::icosahedron();
+    const auto offset = IndexType(components.n_vertices());
+    auto tetrahedron = SurfaceFactory::tetrahedron();
+    for (auto v : tetrahedron.vertices())
+        components.add_vertex(tetrahedron.position(v) + Point(3, 0, 0));
+    for (auto f : tetrahedron.faces())
+    {
+        std::vector<Vertex> vertices;
+        for (auto v : tetrahedron.vertices(f))
+            vertices.emplace_back(v.idx() + offset);
+        components.add_face(vertices);
+    }
+    components.add_vertex(Point(0, 5, 0));
+    expect_equivalent(components, pmc_round_trip(components), 1e-3);
+
+    // polygons
+    auto quads = SurfaceFactory::quad_sphere(3);
+    expect_equivalent(quads, pmc_round_trip(quads), 1e-3);
+    auto dodecahedron = SurfaceFactory::dodecahedron();
+    expect_equivalent(dodecahedron, pmc_round_trip(dodecahedron), 1e-3);
+
+    // empty mesh
+    EXPECT_TRUE(pmc_round_trip(SurfaceMesh()).is_empty());
+}
+
+TEST_F(SurfaceMeshIOTest, pmc_corrupt_data)
+{
+    auto data = SurfaceMeshIO::encode(SurfaceFactory::icosphere(3));
+
+    // truncated data
+    EXPECT_THROW(SurfaceMeshIO::decode(data.data(), data.size() / 2, mesh),
+                 IOException);
+    EXPECT_THROW(SurfaceMeshIO::decode(data.data(), 10, mesh), IOException);
+
+    // random data must not crash the decoder
+    std::mt19937 rng(42);
+    for (int i = 0; i < 100; ++i)
+    {
+        auto corrupt = data;
+        corrupt[60 + rng() % (corrupt.size() - 60)] ^= char(1 + rng() % 255);
+        try
+        {
+            SurfaceMeshIO::decode(corrupt.data(), corrupt.size(), mesh);
+        }
+        catch (const IOException&)
+        {
+        }
+    }
+}
+
+namespace {
+
+// JSON and binary chunk of a GLB file
+struct GlbFile
+{
+    std::string json;
+    std::vector<char> bin;
+};
+
+GlbFile read_glb(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+    GlbFile glb;
+    uint32_t header[5];
+    EXPECT_GE(data.size(), sizeof(header));
+    if (data.size() < sizeof(header))
+        return glb;
+    memcpy(header, data.data(), sizeof(header));
+    EXPECT_EQ(header[0], 0x46546C67u);
+    EXPECT_EQ(header[1], 2u);
+    EXPECT_EQ(header[2], data.size());
+    EXPECT_EQ(header[4], 0x4E4F534Au);
+    EXPECT_EQ(header[3] % 4, 0u);
+    glb.json.assign(data.data() + 20, header[3]);
+
+    uint32_t chunk[2];
+    memcpy(chunk, data.data() + 20 + header[3], sizeof(chunk));
+    EXPECT_EQ(chunk[1], 0x004E4942u);
+    EXPECT_EQ(20 + header[3] + 8 + chunk[0], data.size());
+    glb.bin.assign(data.begin() + 28 + header[3], data.end());
+    return glb;
+}
+
+// the number following the n-th occurrence of key at or after start
+double json_value(const std::string& json, const std::string& key,
+                  const std::string& start = "", int n = 0)
+{
+    auto pos = json.find(start);
+    for (int i = 0; i <= n && pos != std::string::npos; ++i)
+        pos = json.find("\"" + key + "\":", i ? pos + 1 : pos);
+    EXPECT_NE(pos, std::string::npos) << key;
+    if (pos == std::string::npos)
+        return 0;
+    pos += key.size() + 3;
+    if (json[pos] == '[')
+        ++pos;
+    return std::stod(json.substr(pos));
+}
+
+// rebuild a mesh from the triangles of a file written by write_glb()
+SurfaceMesh decode_glb(const GlbFile& glb, std::vector<IndexType>& indices)
+{
+    const auto n_vertices = size_t(json_value(glb.json, "count", "accessors"));
+    const auto stride = size_t(json_value(glb.json, "byteStride"));
+    const auto position_type = int(json_value(glb.json, "componentType"));
+    const auto index_offset =
+        size_t(json_value(glb.json, "byteOffset", "bufferViews", 1));
+    const auto index_type = int(json_value(glb.json, "componentType",
+                                           "\"bufferView\":1"));
+    const auto n_indices = size_t(json_value(glb.json, "count",
+                                             "\"bufferView\":1"));
+
+    // quantized positions are transformed by the node
+    double scale = 1, translation[3] = {0, 0, 0};
+    if (position_type == 5123)
+    {
+        scale = json_value(glb.json, "scale");
+        auto pos = glb.json.find("\"translation\":[") + 15;
+        for (double& t : translation)
+        {
+            t = std::stod(glb.json.substr(pos));
+            pos = glb.json.find_first_of(",]", pos) + 1;
+        }
+    }
+
+    SurfaceMesh mesh;
+    for (size_t i = 0; i < n_vertices; ++i)
+    {
+        const char* record = glb.bin.data() + i * stride;
+        Point p;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (position_type == 5126)
+            {
+                float x;
+                memcpy(&x, record + 4 * k, 4);
+                p[k] = x;
+            }
+            else
+            {
+                uint16_t x;
+                memcpy(&x, record + 2 * k, 2);
+                p[k] = Scalar(translation[k] + scale * x);
+            }
+        }
+        mesh.add_vertex(p);
+    }
+
+    indices.resize(n_indices);
+    for (size_t i = 0; i < n_indices; ++i)
+    {
+        const char* p = glb.bin.data() + index_offset;
+        if (index_type == 5123)
+        {
+            uint16_t x;
+            memcpy(&x, p + 2 * i, 2);
+            indices[i] = x;
+        }
+        else
+        {
+            memcpy(&indices[i], p + 4 * i, 4);
+        }
+    }
+    for (size_t i = 0; i + 2 < n_indices; i += 3)
+        mesh.add_triangle(Vertex(indices[i]), Vertex(indices[i + 1]),
+                          Vertex(indices[i + 2]));
+    return mesh;
+}
+
+// average cache miss ratio of a FIFO vertex cache
+double acmr(const std::vector<IndexType>& indices, size_t cache_size)
+{
+    std::vector<IndexType> cache;
+    size_t misses = 0;
+    for (auto i : indices)
+    {
+        if (std::find(cache.begin(), cache.end(), i) != cache.end())
+            continue;
+        ++misses;
+        cache.push_back(i);
+        if (cache.size() > cache_size)
+            cache.erase(cache.begin());
+    }
+    return double(misses) / (indices.size() / 3);
+}
+
+} // namespace
+
+TEST_F(SurfaceMeshIOTest, glb_io)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    SurfaceNormals::compute_vertex_normals(sphere);
+    auto tex = sphere.add_vertex_property<TexCoord>("v:tex");
+    for (auto v : sphere.vertices())
+        tex[v] = TexCoord(0.5 * (sphere.position(v)[0] + 1),
+                          0.5 * (sphere.position(v)[1] + 1));
+
+    IOFlags flags;
+    flags.use_vertex_normals = true;
+    flags.use_vertex_texcoords = true;
+    sphere.write("sphere.glb", flags);
+    auto glb = read_glb("sphere.glb");
+    EXPECT_NE(glb.json.find("\"NORMAL\""), std::string::npos);
+    EXPECT_NE(glb.json.find("\"TEXCOORD_0\""), std::string::npos);
+    EXPECT_EQ(json_value(glb.json, "byteStride"), 32);
+    std::vector<IndexType> indices;
+    auto result = decode_glb(glb, indices);
+    expect_equivalent(sphere, result, 1e-6);
+
+    // quantized attributes need half the space
+    flags.use_quantization = true;
+    sphere.write("sphere_quantized.glb", flags);
+    auto quantized = read_glb("sphere_quantized.glb");
+    EXPECT_NE(quantized.json.find("\"extensionsRequired\":"
+                                  "[\"KHR_mesh_quantization\"]"),
+              std::string::npos);
+    EXPECT_EQ(json_value(quantized.json, "byteStride"), 16);
+    EXPECT_LT(quantized.bin.size(), glb.bin.size() * 2 / 3);
+    result = decode_glb(quantized, indices);
+    expect_equivalent(sphere, result, 2.0 / 65535);
+
+    // reordering improves the vertex cache hit rate
+    flags.use_quantization = false;
+    flags.optimize_vertex_cache = true;
+    const double unoptimized = acmr(indices, 16);
+    sphere.write("sphere_optimized.glb", flags);
+    result = decode_glb(read_glb("sphere_optimized.glb"), indices);
+    expect_equivalent(sphere, result, 1e-6);
+    EXPECT_LT(acmr(indices, 16), 0.8);
+    EXPECT_LT(acmr(indices, 16), unoptimized);
+
+    // vertices indexed by first use
+    IndexType next = 0;
+    for (auto i : indices)
+    {
+        EXPECT_LE(i, next);
+        next = std::max(next, i + 1);
+    }
+}
+
+TEST_F(SurfaceMeshIOTest, glb_polygons)
+{
+    // quads are triangulated
+    auto cube = SurfaceFactory::hexahedron();
+    cube.write("cube.glb");
+    auto glb = read_glb("cube.glb");
+    EXPECT_EQ(glb.json.find("NORMAL"), std::string::npos);
+    std::vector<IndexType> indices;
+    auto result = decode_glb(glb, indices);
+    EXPECT_EQ(result.n_vertices(), 8u);
+    EXPECT_EQ(result.n_faces(), 12u);
+
+    // texture seams split vertices
+    auto tex = cube.add_halfedge_property<TexCoord>("h:tex");
+    for (auto f : cube.faces())
+    {
+        int i = 0;
+        for (auto h : cube.halfedges(f))
+        {
+            const Scalar u = (2 * f.idx() + (i == 1 || i == 2)) / Scalar(12);
+            tex[h] = TexCoord(u, i / 2);
+            ++i;
+        }
+    }
+    IOFlags flags;
+    flags.use_halfedge_texcoords = true;
+    cube.write("cube.glb", flags);
+    result = decode_glb(read_glb("cube.glb"), indices);
+    EXPECT_EQ(result.n_vertices(), 24u);
+    EXPECT_EQ(result.n_faces(), 12u);
+    EXPECT_EQ(indices.size(), 36u);
+
+    SurfaceMesh points;
+    points.add_vertex(Point(0, 0, 0));
+    EXPECT_THROW(points.write("points.glb"), IOException);
+}
+
+TEST_F(SurfaceMeshIOTest, probe)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    SurfaceNormals::compute_vertex_normals(sphere);
+    const size_t nv = sphere.n_vertices(), nf = sphere.n_faces();
+
+    IOFlags flags;
+    flags.use_vertex_normals = true;
+    std::vector<std::string> files = {"probe.off", "probe.obj", "probe.ply",
+                                      "probe.pmp", "probe.pmc"};
+    if (is_compression_supported(Compression::Gzip))
+        files.push_back("probe.obj.gz");
+    for (const auto& file : files)
+    {
+        sphere.write(file, flags);
+        auto info = SurfaceMeshIO::probe(file);
+        EXPECT_EQ(info.n_vertices, nv) << file;
+        EXPECT_EQ(info.n_faces, nf) << file;
+        EXPECT_TRUE(info.exact_vertex_count);
+    }
+    EXPECT_TRUE(SurfaceMeshIO::probe("probe.off").has_vertex_normals);
+    EXPECT_TRUE(SurfaceMeshIO::probe("probe.pmp").has_vertex_normals);
+    EXPECT_TRUE(SurfaceMeshIO::probe("probe.pmc").has_vertex_normals);
+    EXPECT_FALSE(SurfaceMeshIO::probe("probe.ply").is_binary);
+
+    flags.use_binary = true;
+    for (const auto& file : {"probe.off", "probe.ply"})
+    {
+        sphere.write(file, flags);
+        auto info = SurfaceMeshIO::probe(file);
+        EXPECT_EQ(info.n_vertices, nv) << file;
+        EXPECT_EQ(info.n_faces, nf) << file;
+        EXPECT_TRUE(info.is_binary);
+    }
+
+    // STL stores the corners of each face
+    SurfaceNormals::compute_face_normals(sphere);
+    sphere.write("probe.stl");
+    auto info = SurfaceMeshIO::probe("probe.stl");
+    EXPECT_EQ(info.n_faces, nf);
+    EXPECT_EQ(info.n_vertices, 3 * nf);
+    EXPECT_FALSE(info.exact_vertex_count);
+
+    sphere.write("probe.xyz", flags);
+    info = SurfaceMeshIO::probe("probe.xyz");
+    EXPECT_EQ(info.n_vertices, nv);
+    EXPECT_EQ(info.n_faces, 0u);
+    EXPECT_TRUE(info.has_vertex_normals);
+
+    EXPECT_THROW(SurfaceMeshIO::probe("missing.off"), IOException);
+}
+
+TEST_F(SurfaceMeshIOTest, read_progress)
+{
+    auto sphere = SurfaceFactory::icosphere(5);
+    for (const auto& file : {"progress.off", "progress.obj", "progress.pmp"})
+    {
+        sphere.write(file);
+
+        // progress is monotonic and complete
+        std::vector<size_t> reported;
+        size_t file_size = 0;
+        IOFlags flags;
+        flags.progress = [&](size_t bytes, size_t total) {
+            reported.push_back(bytes);
+            file_size = total;
+            return true;
+        };
+        auto future = SurfaceMeshIO::read_async(file, flags);
+        mesh = future.get();
+        EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+        ASSERT_GE(reported.size(), 2u) << file;
+        EXPECT_TRUE(std::is_sorted(reported.begin(), reported.end()));
+        EXPECT_EQ(reported.back(), file_size);
+        EXPECT_GT(file_size, 0u);
+
+        // cancel after the first report
+        flags.progress = [](size_t bytes, size_t) { return bytes == 0; };
+        EXPECT_THROW(SurfaceMeshIO::read_async(file, flags).get(),
+                     CancelledException);
+        EXPECT_THROW(mesh.read(file, flags), CancelledException);
+        EXPECT_TRUE(mesh.is_empty());
+    }
+
+    EXPECT_THROW(SurfaceMeshIO::read_async("missing.off").get(), IOException);
+}
+
 TEST_F(SurfaceMeshIOTest, xyz_io)
 {
     add_triangle();
@@ -136,18 +1147,356 @@ TEST_F(SurfaceMeshIOTest, xyz_io)
     EXPECT_EQ(mesh.n_vertices(), size_t(3));
 }
 
+#ifdef __linux__
+TEST_F(SurfaceMeshIOTest, write_failure)
+{
+    // /dev/full accepts opening but fails every write
+    mesh = SurfaceFactory::icosphere(5);
+    SurfaceNormals::compute_vertex_normals(mesh);
+    for (auto name : {"full.obj", "full.off", "full.xyz", "full.stl"})
+    {
+        std::remove(name);
+        ASSERT_EQ(symlink("/dev/full", name), 0);
+        EXPECT_THROW(mesh.write(name), IOException) << name;
+        std::remove(name);
+    }
+}
+#endif
+
+TEST_F(SurfaceMeshIOTest, point_cloud_io)
+{
+    // normals, skipping comments and incomplete lines
+    std::ofstream("test.xyz") << "# points\n"
+                                 "0 0 0 0 0 1\n"
+                                 "1 2\n"
+                                 "1.5 -2e1 3 1 0 0\n";
+    mesh.read("test.xyz");
+    ASSERT_EQ(mesh.n_vertices(), size_t(2));
+    EXPECT_EQ(mesh.position(Vertex(1)), Point(1.5, -20, 3));
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    ASSERT_TRUE(normals);
+    EXPECT_EQ(normals[Vertex(1)], Normal(1, 0, 0));
+
+    std::ofstream("test.agi") << "1 2 3 255 0 0 0 1 0\n"
+                                 "4 5 6 0 255 0 0 0 1\n";
+    mesh.read("test.agi");
+    ASSERT_EQ(mesh.n_vertices(), size_t(2));
+    EXPECT_EQ(mesh.get_vertex_property<Color>("v:color")[Vertex(0)],
+              Color(1, 0, 0));
+    EXPECT_EQ(mesh.get_vertex_property<Normal>("v:normal")[Vertex(1)],
+              Normal(0, 0, 1));
+
+    // number of points, then x y z intensity r g b
+    std::ofstream("test.pts") << "2\n"
+                                 "1 2 3 -100 0 0 255\n"
+                                 "4 5 6 20 255 255 255\n";
+    auto info = SurfaceMeshIO::probe("test.pts");
+    EXPECT_EQ(info.n_vertices, size_t(2));
+    EXPECT_TRUE(info.has_vertex_colors);
+    mesh.read("test.pts");
+    ASSERT_EQ(mesh.n_vertices(), size_t(2));
+    EXPECT_EQ(mesh.position(Vertex(1)), Point(4, 5, 6));
+    EXPECT_EQ(mesh.get_vertex_property<Color>("v:color")[Vertex(0)],
+              Color(0, 0, 1));
+    EXPECT_FALSE(mesh.get_vertex_property<Normal>("v:normal"));
+
+    // binary point clouds are written as PLY
+    IOFlags flags;
+    flags.use_binary = true;
+    flags.use_vertex_colors = true;
+    mesh.write("points.ply", flags);
+    SurfaceMesh points;
+    points.read("points.ply");
+    EXPECT_EQ(points.n_vertices(), size_t(2));
+    EXPECT_EQ(points.position(Vertex(1)), Point(4, 5, 6));
+    EXPECT_TRUE(points.get_vertex_property<Color>("v:color"));
+}
+
+// the shared vertices are split per cube
 TEST_F(SurfaceMeshIOTest, complex_edge)
 {
     mesh.read("pmp-data/obj/cubes_complex_edge.obj");
-    EXPECT_EQ(mesh.n_vertices(), size_t(30));
+    EXPECT_EQ(mesh.n_vertices(), size_t(16));
     EXPECT_EQ(mesh.n_faces(), size_t(12));
-    EXPECT_EQ(mesh.n_edges(), size_t(35));
+    EXPECT_EQ(mesh.n_edges(), size_t(24));
 }
 
 TEST_F(SurfaceMeshIOTest, complex_vertex)
 {
     mesh.read("pmp-data/obj/cubes_complex_vertex.obj");
-    EXPECT_EQ(mesh.n_vertices(), size_t(27));
+    EXPECT_EQ(mesh.n_vertices(), size_t(16));
     EXPECT_EQ(mesh.n_faces(), size_t(12));
-    EXPECT_EQ(mesh.n_edges(), size_t(33));
+    EXPECT_EQ(mesh.n_edges(), size_t(24));
+}
+
+TEST_F(SurfaceMeshIOTest, non_manifold_off)
+{
+    // write two unit cubes offset by d as OFF, sharing coincident vertices
+    auto write_cubes = [](const Point& d) {
+        std::vector<Point> points;
+        std::vector<int> indices;
+        const int quads[6][4] = {{3, 2, 1, 0}, {2, 6, 5, 1}, {5, 6, 7, 4},
+                                 {0, 4, 7, 3}, {3, 7, 6, 2}, {1, 5, 4, 0}};
+        for (int cube = 0; cube < 2; ++cube)
+        {
+            int corner[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                Point p((i == 1 || i == 2 || i == 5 || i == 6) ? 1 : 0,
+                        (i == 2 || i == 3 || i == 6 || i == 7) ? 1 : 0,
+                        i >= 4 ? 1 : 0);
+                if (cube)
+                    p += d;
+                auto it = std::find(points.begin(), points.end(), p);
+                corner[i] = int(it - points.begin());
+                if (it == points.end())
+                    points.push_back(p);
+            }
+            for (const auto& q : quads)
+                for (int j : q)
+                    indices.push_back(corner[j]);
+        }
+
+        std::ofstream out("cubes.off");
+        out << "OFF\n" << points.size() << " 12 0\n";
+        for (const auto& p : points)
+            out << p[0] << ' ' << p[1] << ' ' << p[2] << '\n';
+        for (size_t f = 0; f < 12; ++f)
+            out << "4 " << indices[4 * f] << ' ' << indices[4 * f + 1] << ' '
+                << indices[4 * f + 2] << ' ' << indices[4 * f + 3] << '\n';
+    };
+
+    for (const auto& d : {Point(1, 1, 0), Point(1, 1, 1)})
+    {
+        write_cubes(d);
+        mesh.read("cubes.off");
+        EXPECT_EQ(mesh.n_vertices(), size_t(16));
+        EXPECT_EQ(mesh.n_faces(), size_t(12));
+        EXPECT_EQ(mesh.n_edges(), size_t(24));
+        EXPECT_TRUE(mesh.is_quad_mesh());
+    }
+
+    // three triangles on an edge, the third one is split off. a fourth
+    // triangle visits a vertex twice and gets its own vertices.
+    std::ofstream("fin.off") << "OFF\n5 4 0\n"
+                                "0 0 0\n1 0 0\n0 1 0\n0 -1 0\n0 0 1\n"
+                                "3 0 1 2\n3 1 0 3\n3 0 1 4\n3 2 4 2\n";
+    mesh.read("fin.off");
+    EXPECT_EQ(mesh.n_vertices(), size_t(10));
+    EXPECT_EQ(mesh.n_faces(), size_t(4));
+    EXPECT_EQ(mesh.n_edges(), size_t(11));
+}
+
+TEST_F(SurfaceMeshIOTest, deferred_faces)
+{
+    auto sphere = SurfaceFactory::icosphere(2);
+    SurfaceNormals::compute_vertex_normals(sphere);
+    IOFlags flags;
+    flags.use_vertex_normals = true;
+    sphere.write("deferred.off", flags);
+
+    // only the vertices are added
+    IndexedFaces faces;
+    SurfaceMeshIO("deferred.off", IOFlags()).read(mesh, faces);
+    EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), 0u);
+    EXPECT_EQ(faces.size(), sphere.n_faces());
+    EXPECT_TRUE(mesh.has_vertex_property("v:normal"));
+
+    SurfaceMeshIO::add_faces(mesh, faces);
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+    EXPECT_EQ(mesh.n_edges(), sphere.n_edges());
+    auto normals = mesh.get_vertex_property<Normal>("v:normal");
+    ASSERT_TRUE(normals);
+    for (auto v : mesh.vertices())
+        EXPECT_GT(dot(normals[v], normalize(mesh.position(v))), 0.99);
+
+    // non-manifold faces are split when building the connectivity
+    std::ofstream("fin.off") << "OFF\n5 4 0\n"
+                                "0 0 0\n1 0 0\n0 1 0\n0 -1 0\n0 0 1\n"
+                                "3 0 1 2\n3 1 0 3\n3 0 1 4\n3 2 4 2\n";
+    SurfaceMeshIO("fin.off", IOFlags()).read(mesh, faces);
+    EXPECT_EQ(mesh.n_vertices(), 5u);
+    EXPECT_EQ(faces.size(), 4u);
+    SurfaceMeshIO::add_faces(mesh, faces);
+    EXPECT_EQ(mesh.n_vertices(), size_t(10));
+    EXPECT_EQ(mesh.n_faces(), size_t(4));
+
+    // other formats are read completely
+    sphere.write("deferred.pmp");
+    SurfaceMeshIO("deferred.pmp", IOFlags()).read(mesh, faces);
+    EXPECT_TRUE(faces.empty());
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+}
+
+TEST_F(SurfaceMeshIOTest, memory_io)
+{
+    auto sphere = SurfaceFactory::icosphere(2);
+    IOFlags binary;
+    binary.use_binary = true;
+
+    for (auto format :
+         {"off", "obj", "stl", "ply", "pmp", "pmc", "sma", "smb"})
+    {
+        for (const auto& flags : {IOFlags(), binary})
+        {
+            const auto data = SurfaceMeshIO::write(sphere, format, flags);
+            ASSERT_FALSE(data.empty()) << format;
+            SurfaceMeshIO::read(data.data(), data.size(), format, mesh);
+            EXPECT_EQ(mesh.n_vertices(), sphere.n_vertices()) << format;
+            EXPECT_EQ(mesh.n_faces(), sphere.n_faces()) << format;
+
+            // same data as written to a file
+            sphere.write(std::string("memory.") + format, flags);
+            std::ifstream file(std::string("memory.") + format,
+                               std::ios::binary);
+            EXPECT_TRUE(std::equal(data.begin(), data.end(),
+                                   std::istreambuf_iterator<char>(file)))
+                << format;
+        }
+    }
+
+    // streams
+    std::stringstream stream;
+    SurfaceMeshIO::write(sphere, stream, "ply", binary);
+    SurfaceMeshIO::read(stream, "ply", mesh);
+    EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+
+    // point clouds
+    const std::string xyz = "0 0 0\n1 0 0\n0 1 0\n";
+    SurfaceMeshIO::read(xyz.data(), xyz.size(), "xyz", mesh);
+    EXPECT_EQ(mesh.n_vertices(), 3u);
+
+    // compressed data is detected when reading
+    if (is_compression_supported(Compression::Gzip))
+    {
+        const auto data = SurfaceMeshIO::write(sphere, "obj.gz");
+        EXPECT_EQ(detect_compression(data.data(), data.size()),
+                  Compression::Gzip);
+        SurfaceMeshIO::read(data.data(), data.size(), "obj", mesh);
+        EXPECT_EQ(mesh.n_faces(), sphere.n_faces());
+    }
+
+    EXPECT_THROW(SurfaceMeshIO::write(sphere, "unknown"), IOException);
+    EXPECT_THROW(SurfaceMeshIO::read(xyz.data(), xyz.size(), "off", mesh),
+                 IOException);
+    EXPECT_THROW(SurfaceMeshIO::read(nullptr, 0, "off", mesh), IOException);
+}
+
+namespace {
+
+// the faces of mesh with their own vertices
+SurfaceMesh triangle_soup(const SurfaceMesh& mesh)
+{
+    SurfaceMesh soup;
+    for (auto f : mesh.faces())
+    {
+        std::vector<Vertex> vertices;
+        for (auto v : mesh.vertices(f))
+            vertices.push_back(soup.add_vertex(mesh.position(v)));
+        soup.add_face(vertices);
+    }
+    return soup;
+}
+
+} // namespace
+
+TEST_F(SurfaceMeshIOTest, weld_vertices)
+{
+    auto sphere = SurfaceFactory::icosphere(3);
+    auto soup = triangle_soup(sphere);
+
+    // properties of the faces and of their halfedges are kept
+    auto fid = soup.add_face_property<int>("f:id");
+    auto hto = soup.add_halfedge_property<Point>("h:to");
+    for (auto f : soup.faces())
+        fid[f] = int(f.idx());
+    for (auto h : soup.halfedges())
+        hto[h] = soup.position(soup.to_vertex(h));
+    soup.delete_face(Face(0));
+
+    const size_t n_duplicates = soup.n_vertices() - sphere.n_vertices();
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(soup), n_duplicates);
+    EXPECT_EQ(soup.n_vertices(), sphere.n_vertices());
+    EXPECT_EQ(soup.n_faces(), sphere.n_faces() - 1);
+    EXPECT_EQ(soup.n_edges(), sphere.n_edges());
+    EXPECT_TRUE(soup.validate().empty());
+
+    fid = soup.get_face_property<int>("f:id");
+    hto = soup.get_halfedge_property<Point>("h:to");
+    for (auto f : soup.faces())
+    {
+        Point center(0, 0, 0), sphere_center(0, 0, 0);
+        for (auto v : soup.vertices(f))
+            center += soup.position(v);
+        for (auto v : sphere.vertices(Face(fid[f])))
+            sphere_center += sphere.position(v);
+        EXPECT_LT(distance(center, sphere_center), 1e-5);
+        for (auto h : soup.halfedges(f))
+            EXPECT_EQ(hto[h], soup.position(soup.to_vertex(h)));
+    }
+    for (auto h : soup.halfedges())
+        if (soup.is_boundary(h))
+        {
+            EXPECT_EQ(hto[h], soup.position(soup.to_vertex(h)));
+        }
+
+    // nothing left to weld
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(soup), 0u);
+}
+
+TEST_F(SurfaceMeshIOTest, weld_vertices_tolerance)
+{
+    SurfaceMesh mesh;
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(0, 1, 0));
+    auto v3 = mesh.add_vertex(Point(1.0001, 0, 0));
+    auto v4 = mesh.add_vertex(Point(0, 1.0002, 0));
+    auto v5 = mesh.add_vertex(Point(1, 1, 0));
+    mesh.add_triangle(v0, v1, v2);
+    mesh.add_triangle(v3, v5, v4);
+    auto color = mesh.add_vertex_property<Color>("v:color", Color(0, 0, 0));
+    color[v3] = Color(1, 1, 1);
+
+    auto copy = mesh;
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(copy), 0u);
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(copy, 0.001), 2u);
+    EXPECT_EQ(copy.n_edges(), 5u);
+    EXPECT_EQ(copy.position(Vertex(1)), Point(1, 0, 0));
+    EXPECT_EQ(copy.get_vertex_property<Color>("v:color")[Vertex(1)],
+              Color(0, 0, 0));
+
+    SurfaceMeshIO::weld_vertices(mesh, 0.001, WeldPolicy::Average);
+    EXPECT_EQ(mesh.n_vertices(), 4u);
+    EXPECT_NEAR(mesh.position(Vertex(1))[0], 1.00005, 1e-6);
+    EXPECT_NEAR(mesh.position(Vertex(2))[1], 1.0001, 1e-6);
+    EXPECT_EQ(mesh.get_vertex_property<Color>("v:color")[Vertex(1)],
+              Color(0.5, 0.5, 0.5));
+
+    // faces collapsing to an edge are removed
+    SurfaceMesh sliver;
+    sliver.add_triangle(sliver.add_vertex(Point(0, 0, 0)),
+                        sliver.add_vertex(Point(1, 0, 0)),
+                        sliver.add_vertex(Point(0, 0.0001, 0)));
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(sliver, 0.001), 1u);
+    EXPECT_EQ(sliver.n_faces(), 0u);
+    EXPECT_EQ(sliver.n_vertices(), 2u);
+}
+
+// vertices that become non-manifold are split again
+TEST_F(SurfaceMeshIOTest, weld_vertices_non_manifold)
+{
+    SurfaceMesh mesh;
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(0, 1, 0));
+    auto v3 = mesh.add_vertex(Point(0, 0, 0));
+    auto v4 = mesh.add_vertex(Point(-1, 0, 0));
+    auto v5 = mesh.add_vertex(Point(0, -1, 0));
+    mesh.add_triangle(v0, v1, v2);
+    mesh.add_triangle(v3, v4, v5);
+    EXPECT_EQ(SurfaceMeshIO::weld_vertices(mesh), 0u);
+    EXPECT_EQ(mesh.n_faces(), 2u);
+    EXPECT_TRUE(mesh.validate().empty());
 }
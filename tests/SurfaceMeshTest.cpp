@@ -4,7 +4,10 @@
 #include "SurfaceMeshTest.h"
 #include "Helpers.h"
 
+#include <pmp/Parallel.h>
+#include <pmp/algorithms/SurfaceFactory.h>
 #include <pmp/algorithms/SurfaceNormals.h>
+#include <algorithm>
 #include <vector>
 
 using namespace pmp;
@@ -105,6 +108,316 @@ TEST_F(SurfaceMeshTest, delete_center_edge)
     EXPECT_EQ(mesh.n_faces(), size_t(8));
 }
 
+TEST_F(SurfaceMeshTest, garbage_collection_maps)
+{
+    mesh = vertex_onering();
+    auto vidx = mesh.add_vertex_property<int>("v:idx");
+    for (auto v : mesh.vertices())
+        vidx[v] = v.idx();
+
+    mesh.delete_face(Face(0));
+    EXPECT_EQ(mesh.n_faces(), size_t(5));
+
+    std::vector<Vertex> vmap;
+    std::vector<Halfedge> hmap;
+    std::vector<Edge> emap;
+    std::vector<Face> fmap;
+    mesh.garbage_collection(vmap, hmap, emap, fmap);
+
+    EXPECT_EQ(vmap.size(), size_t(7));
+    EXPECT_EQ(fmap.size(), size_t(6));
+    EXPECT_EQ(hmap.size(), 2 * emap.size());
+    EXPECT_FALSE(fmap[0].is_valid());
+    EXPECT_EQ(mesh.faces_size(), size_t(5));
+    EXPECT_EQ(mesh.vertices_size(), mesh.n_vertices());
+
+    // custom properties are relocated along with the elements
+    for (size_t i = 0; i < vmap.size(); ++i)
+        if (vmap[i].is_valid())
+        {
+            EXPECT_EQ(vidx[vmap[i]], int(i));
+        }
+
+    // connectivity is consistent
+    for (auto h : mesh.halfedges())
+        EXPECT_EQ(mesh.prev_halfedge(mesh.next_halfedge(h)), h);
+    for (auto f : mesh.faces())
+        EXPECT_EQ(mesh.valence(f), size_t(3));
+}
+
+TEST_F(SurfaceMeshTest, reorder)
+{
+    mesh = hemisphere();
+    auto n_vertices = mesh.n_vertices();
+    auto n_edges = mesh.n_edges();
+    auto n_faces = mesh.n_faces();
+    auto n_boundary = 0;
+    for (auto v : mesh.vertices())
+        if (mesh.is_boundary(v))
+            ++n_boundary;
+
+    // custom properties follow their elements
+    auto vpos = mesh.add_vertex_property<Point>("v:pos");
+    for (auto v : mesh.vertices())
+        vpos[v] = mesh.position(v);
+
+    mesh.reorder();
+
+    EXPECT_EQ(mesh.n_vertices(), n_vertices);
+    EXPECT_EQ(mesh.n_edges(), n_edges);
+    EXPECT_EQ(mesh.n_faces(), n_faces);
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(vpos[v], mesh.position(v));
+        if (mesh.is_boundary(v))
+            --n_boundary;
+    }
+    EXPECT_EQ(n_boundary, 0);
+
+    // connectivity is consistent
+    for (auto h : mesh.halfedges())
+    {
+        EXPECT_EQ(mesh.prev_halfedge(mesh.next_halfedge(h)), h);
+        EXPECT_EQ(mesh.to_vertex(mesh.opposite_halfedge(h)),
+                  mesh.from_vertex(h));
+    }
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.from_vertex(mesh.halfedge(v)), v);
+    for (auto f : mesh.faces())
+        EXPECT_EQ(mesh.face(mesh.halfedge(f)), f);
+
+    // faces are emitted vertex by vertex
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    bool first_face_found = false;
+    for (auto f : mesh.faces(Vertex(0)))
+        if (f.idx() == 0)
+            first_face_found = true;
+    EXPECT_TRUE(first_face_found);
+}
+
+TEST_F(SurfaceMeshTest, external_vertex_positions)
+{
+    mesh = vertex_onering();
+    auto n = mesh.n_vertices();
+
+    // interleaved caller-owned buffer
+    struct Vertex3
+    {
+        Point position;
+        Scalar weight;
+    };
+    std::vector<Vertex3> buffer(n);
+    for (auto v : mesh.vertices())
+        buffer[v.idx()].position = 2 * mesh.position(v);
+
+    auto points = mesh.vertex_property<Point>("v:point");
+    points.wrap(&buffer[0].position, sizeof(Vertex3));
+    EXPECT_TRUE(points.is_external());
+
+    // mesh reads and writes the external memory
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), buffer[v.idx()].position);
+    mesh.position(Vertex(0)) = Point(1, 2, 3);
+    EXPECT_EQ(buffer[0].position, Point(1, 2, 3));
+
+    // copies own their storage
+    SurfaceMesh copy = mesh;
+    EXPECT_FALSE(copy.vertex_property<Point>("v:point").is_external());
+    EXPECT_EQ(copy.position(Vertex(0)), Point(1, 2, 3));
+
+    // growing falls back to internal storage and keeps the elements
+    auto v = mesh.add_vertex(Point(4, 5, 6));
+    EXPECT_FALSE(points.is_external());
+    EXPECT_EQ(mesh.position(Vertex(0)), Point(1, 2, 3));
+    EXPECT_EQ(mesh.position(v), Point(4, 5, 6));
+    EXPECT_EQ(mesh.n_vertices(), n + 1);
+}
+
+TEST_F(SurfaceMeshTest, move)
+{
+    mesh = vertex_onering();
+    auto vidx = mesh.add_vertex_property<int>("v:idx");
+    for (auto v : mesh.vertices())
+        vidx[v] = v.idx();
+    auto p0 = mesh.position(Vertex(0));
+
+    // handles stay valid and refer to the new mesh
+    SurfaceMesh m2(std::move(mesh));
+    EXPECT_EQ(m2.n_vertices(), size_t(7));
+    EXPECT_EQ(m2.n_faces(), size_t(6));
+    EXPECT_EQ(m2.position(Vertex(0)), p0);
+    for (auto v : m2.vertices())
+        EXPECT_EQ(vidx[v], int(v.idx()));
+
+    // moved-from mesh is empty but usable
+    EXPECT_TRUE(mesh.is_empty());
+    EXPECT_FALSE(mesh.has_vertex_property("v:idx"));
+    mesh.add_vertex(Point(0, 0, 0));
+    EXPECT_EQ(mesh.n_vertices(), size_t(1));
+
+    SurfaceMesh m3;
+    m3 = std::move(m2);
+    EXPECT_EQ(m3.n_faces(), size_t(6));
+    EXPECT_EQ(m3.vertex_property<int>("v:idx")[Vertex(3)], 3);
+    EXPECT_TRUE(m2.is_empty());
+}
+
+TEST_F(SurfaceMeshTest, copy_on_write)
+{
+    mesh = vertex_onering();
+    auto p0 = mesh.position(Vertex(0));
+
+    // copies share their elements until modified
+    SurfaceMesh m2 = mesh;
+    auto points = mesh.vertex_property<Point>("v:point");
+    auto points2 = m2.vertex_property<Point>("v:point");
+    EXPECT_TRUE(points.is_shared());
+    EXPECT_TRUE(points2.is_shared());
+
+    // reading through a const mesh does not copy
+    const SurfaceMesh& cm2 = m2;
+    EXPECT_EQ(cm2.position(Vertex(0)), p0);
+    EXPECT_TRUE(cm2.get_vertex_property<Point>("v:point").is_shared());
+
+    m2.position(Vertex(0)) = Point(1, 2, 3);
+    EXPECT_FALSE(points.is_shared());
+    EXPECT_FALSE(points2.is_shared());
+    EXPECT_EQ(mesh.position(Vertex(0)), p0);
+    EXPECT_EQ(m2.position(Vertex(0)), Point(1, 2, 3));
+
+    // writing the original after copying leaves the copy unchanged, too
+    SurfaceMesh m4 = mesh;
+    auto p1 = mesh.position(Vertex(1));
+    mesh.position(Vertex(1)) = Point(4, 5, 6);
+    EXPECT_EQ(m4.position(Vertex(1)), p1);
+
+    // topological changes only affect the modified copy
+    SurfaceMesh m3;
+    m3.assign(mesh);
+    m3.delete_vertex(Vertex(0));
+    m3.garbage_collection();
+    EXPECT_EQ(mesh.n_faces(), size_t(6));
+    EXPECT_LT(m3.n_faces(), mesh.n_faces());
+    for (auto h : mesh.halfedges())
+        EXPECT_EQ(mesh.prev_halfedge(mesh.next_halfedge(h)), h);
+}
+
+TEST_F(SurfaceMeshTest, copy_after_raw_access)
+{
+    mesh = vertex_onering();
+    auto p0 = mesh.position(Vertex(0));
+
+    // writing through the vector does not change later copies
+    auto& points = mesh.positions();
+    SurfaceMesh m2 = mesh;
+    points[0] = Point(1, 2, 3);
+    EXPECT_EQ(m2.position(Vertex(0)), p0);
+    EXPECT_EQ(mesh.position(Vertex(0)), Point(1, 2, 3));
+    EXPECT_TRUE(mesh.vertex_property<Point>("v:point").is_pinned());
+    EXPECT_FALSE(m2.vertex_property<Point>("v:point").is_pinned());
+
+    // same for the pointer to the elements
+    auto weight = mesh.add_vertex_property<Scalar>("v:weight", 1);
+    Scalar* data = weight.mutable_data();
+    SurfaceMesh m3 = mesh;
+    data[0] = 2;
+    EXPECT_EQ(m3.get_vertex_property<Scalar>("v:weight")[Vertex(0)], 1);
+    EXPECT_EQ(weight[Vertex(0)], 2);
+
+    // unpinned elements are shared again until modified
+    weight.unpin();
+    EXPECT_FALSE(weight.is_pinned());
+    SurfaceMesh m4 = mesh;
+    EXPECT_TRUE(weight.is_shared());
+    weight[Vertex(0)] = 3;
+    EXPECT_EQ(m4.get_vertex_property<Scalar>("v:weight")[Vertex(0)], 2);
+    EXPECT_EQ(weight[Vertex(0)], 3);
+}
+
+TEST_F(SurfaceMeshTest, concurrent_copies)
+{
+    mesh = SurfaceFactory::icosphere(3);
+    auto weight = mesh.add_vertex_property<Scalar>("v:weight", 1);
+    std::vector<SurfaceMesh> copies(16);
+    parallel_for(0, int(copies.size()), [&](int i) { copies[i] = mesh; }, 1);
+
+    // all copies share the elements, writing one of them unshares it
+    weight[Vertex(0)] = 2;
+    for (auto& copy : copies)
+    {
+        EXPECT_EQ(copy.n_vertices(), mesh.n_vertices());
+        EXPECT_EQ(copy.get_vertex_property<Scalar>("v:weight")[Vertex(0)], 1);
+    }
+}
+
+TEST_F(SurfaceMeshTest, reuse_deleted)
+{
+    mesh = vertex_onering();
+    mesh.set_reuse_deleted(true);
+    auto fidx = mesh.add_face_property<int>("f:idx", -1);
+    for (auto f : mesh.faces())
+        fidx[f] = f.idx();
+
+    auto n_vertices = mesh.vertices_size();
+    auto n_edges = mesh.edges_size();
+    auto n_faces = mesh.faces_size();
+
+    // delete a boundary face and add it again
+    mesh.delete_face(Face(0));
+    EXPECT_TRUE(mesh.is_deleted(Face(0)));
+    EXPECT_EQ(mesh.n_edges(), n_edges - 1);
+    mesh.add_triangle(Vertex(3), Vertex(0), Vertex(1));
+
+    // storage did not grow and no element is deleted
+    EXPECT_EQ(mesh.vertices_size(), n_vertices);
+    EXPECT_EQ(mesh.edges_size(), n_edges);
+    EXPECT_EQ(mesh.faces_size(), n_faces);
+    EXPECT_EQ(mesh.n_faces(), n_faces);
+    EXPECT_EQ(mesh.n_edges(), n_edges);
+
+    // reused elements have default property values
+    EXPECT_EQ(fidx[Face(0)], -1);
+    EXPECT_EQ(fidx[Face(1)], 1);
+
+    for (auto h : mesh.halfedges())
+        EXPECT_EQ(mesh.prev_halfedge(mesh.next_halfedge(h)), h);
+}
+
+TEST_F(SurfaceMeshTest, property_keys)
+{
+    mesh = vertex_onering();
+    PropertyKey key("v:weight");
+    EXPECT_EQ(PropertyKey("v:weight").id(), key.id());
+    EXPECT_NE(PropertyKey("v:other").id(), key.id());
+    EXPECT_FALSE(mesh.has_vertex_property(key));
+
+    auto w = mesh.add_vertex_property<Scalar>("v:weight", 1);
+    EXPECT_TRUE(mesh.has_vertex_property(key));
+    auto w2 = mesh.get_vertex_property<Scalar>(key);
+    ASSERT_TRUE(w2);
+    w2[Vertex(2)] = 2;
+    EXPECT_EQ(w[Vertex(2)], 2);
+
+    // type mismatch
+    EXPECT_FALSE(mesh.get_vertex_property<int>(key));
+
+    // keys are updated when removing properties
+    mesh.add_vertex_property<int>("v:extra");
+    mesh.remove_vertex_property(w);
+    EXPECT_FALSE(mesh.has_vertex_property(key));
+    EXPECT_TRUE(mesh.get_vertex_property<int>(PropertyKey("v:extra")));
+    EXPECT_TRUE(mesh.get_vertex_property<Point>(PropertyKey("v:point")));
+
+    // get or add
+    auto w3 = mesh.vertex_property<Scalar>(key, 3);
+    EXPECT_TRUE(mesh.has_vertex_property("v:weight"));
+    EXPECT_EQ(w3[Vertex(0)], 3);
+
+    // copies keep the key table
+    SurfaceMesh m2 = mesh;
+    EXPECT_TRUE(m2.get_vertex_property<Scalar>(key));
+}
+
 TEST_F(SurfaceMeshTest, copy)
 {
     auto v0 = mesh.add_vertex(Point(0, 0, 0));
@@ -132,6 +445,195 @@ TEST_F(SurfaceMeshTest, assignment)
     EXPECT_EQ(m2.n_faces(), size_t(1));
 }
 
+TEST_F(SurfaceMeshTest, from_indexed_faces)
+{
+    // 2x2 quad grid
+    std::vector<Point> points;
+    for (int j = 0; j < 3; ++j)
+        for (int i = 0; i < 3; ++i)
+            points.emplace_back(i, j, 0);
+    std::vector<IndexType> indices = {0, 1, 4, 3, 1, 2, 5, 4,
+                                      3, 4, 7, 6, 4, 5, 8, 7};
+    std::vector<IndexType> sizes = {4, 4, 4, 4};
+
+    mesh.from_indexed_faces(points, indices, sizes);
+    EXPECT_EQ(mesh.n_vertices(), size_t(9));
+    EXPECT_EQ(mesh.n_edges(), size_t(12));
+    EXPECT_EQ(mesh.n_faces(), size_t(4));
+    EXPECT_TRUE(mesh.is_quad_mesh());
+
+    size_t n_boundary(0);
+    for (auto e : mesh.edges())
+        if (mesh.is_boundary(e))
+            ++n_boundary;
+    EXPECT_EQ(n_boundary, size_t(8));
+    EXPECT_EQ(mesh.valence(Vertex(4)), size_t(4));
+    EXPECT_FALSE(mesh.is_boundary(Vertex(4)));
+    for (auto v : mesh.vertices())
+        EXPECT_TRUE(mesh.is_manifold(v));
+
+    // same result as incremental construction
+    SurfaceMesh m2 = vertex_onering();
+    std::vector<Point> m2_points;
+    for (auto v : m2.vertices())
+        m2_points.push_back(m2.position(v));
+    std::vector<IndexType> m2_indices;
+    for (auto f : m2.faces())
+        for (auto v : m2.vertices(f))
+            m2_indices.push_back(v.idx());
+    mesh.from_indexed_faces(m2_points, m2_indices);
+    EXPECT_EQ(mesh.n_edges(), m2.n_edges());
+    for (auto v : m2.vertices())
+    {
+        EXPECT_EQ(mesh.valence(v), m2.valence(v));
+        EXPECT_EQ(mesh.is_boundary(v), m2.is_boundary(v));
+    }
+}
+
+TEST_F(SurfaceMeshTest, from_indexed_faces_connectivity)
+{
+    // a polygon mesh with boundary, faces added in shuffled order
+    SurfaceMesh input = SurfaceFactory::quad_sphere(2);
+    input.delete_face(Face(0));
+    input.delete_face(Face(7));
+    input.garbage_collection();
+
+    std::vector<Point> points;
+    for (auto v : input.vertices())
+        points.push_back(input.position(v));
+    std::vector<Face> order;
+    for (auto f : input.faces())
+        order.push_back(f);
+    std::reverse(order.begin() + order.size() / 3, order.end());
+
+    std::vector<IndexType> indices, sizes;
+    SurfaceMesh reference;
+    for (auto v : input.vertices())
+        reference.add_vertex(input.position(v));
+    for (auto f : order)
+    {
+        std::vector<Vertex> vertices;
+        for (auto v : input.vertices(f))
+        {
+            indices.push_back(v.idx());
+            vertices.push_back(v);
+        }
+        sizes.push_back(IndexType(vertices.size()));
+        reference.add_face(vertices);
+    }
+
+    // same halfedges and numbering as add_face()
+    mesh.from_indexed_faces(points, indices, sizes);
+    ASSERT_EQ(mesh.halfedges_size(), reference.halfedges_size());
+    ASSERT_EQ(mesh.faces_size(), reference.faces_size());
+    for (auto v : reference.vertices())
+        EXPECT_EQ(mesh.halfedge(v), reference.halfedge(v));
+    for (auto f : reference.faces())
+        EXPECT_EQ(mesh.halfedge(f), reference.halfedge(f));
+    for (auto h : reference.halfedges())
+    {
+        EXPECT_EQ(mesh.to_vertex(h), reference.to_vertex(h));
+        EXPECT_EQ(mesh.next_halfedge(h), reference.next_halfedge(h));
+        EXPECT_EQ(mesh.face(h), reference.face(h));
+    }
+}
+
+TEST_F(SurfaceMeshTest, from_indexed_faces_complex_edge)
+{
+    std::vector<Point> points = {Point(0, 0, 0), Point(1, 0, 0),
+                                 Point(0, 1, 0), Point(0, -1, 0),
+                                 Point(0, 0, 1)};
+    std::vector<IndexType> indices = {0, 1, 2, 1, 0, 3, 0, 1, 4};
+    EXPECT_THROW(mesh.from_indexed_faces(points, indices), TopologyException);
+    EXPECT_TRUE(mesh.is_empty());
+
+    indices = {0, 1};
+    EXPECT_THROW(mesh.from_indexed_faces(points, indices),
+                 InvalidInputException);
+}
+
+TEST_F(SurfaceMeshTest, append)
+{
+    add_triangle();
+    auto quality = mesh.add_face_property<Scalar>("f:quality", -1);
+    quality[f0] = 1;
+    mesh.set_edge_index(true);
+
+    SurfaceMesh other = vertex_onering();
+    auto other_quality = other.add_face_property<Scalar>("f:quality");
+    auto other_tag = other.add_vertex_property<int>("v:tag", 3);
+    for (auto f : other.faces())
+        other_quality[f] = 2;
+    other.delete_face(Face(0));
+    const size_t n_faces = other.n_faces();
+
+    mesh.append(other);
+    EXPECT_EQ(mesh.n_vertices(), 3 + other.n_vertices());
+    EXPECT_EQ(mesh.n_edges(), 3 + other.n_edges());
+    EXPECT_EQ(mesh.n_faces(), 1 + n_faces);
+    EXPECT_TRUE(mesh.is_deleted(Face(1)));
+    EXPECT_TRUE(mesh.validate().empty());
+
+    // matching properties are copied, missing ones are not added
+    EXPECT_EQ(quality[f0], 1);
+    for (auto f : mesh.faces())
+        if (f != f0)
+        {
+            EXPECT_EQ(quality[f], 2);
+        }
+    EXPECT_FALSE(mesh.has_vertex_property("v:tag"));
+    EXPECT_EQ(other_tag[Vertex(0)], 3);
+
+    // the elements of other are shifted by the existing elements
+    for (auto v : other.vertices())
+        EXPECT_EQ(mesh.position(Vertex(v.idx() + 3)), other.position(v));
+    for (auto h : other.halfedges())
+    {
+        const Halfedge hh(h.idx() + 6);
+        const Vertex from = mesh.from_vertex(hh), to = mesh.to_vertex(hh);
+        EXPECT_EQ(to.idx(), other.to_vertex(h).idx() + 3);
+        EXPECT_EQ(mesh.find_halfedge(from, to), hh);
+    }
+
+    // the parts are not connected, appending itself doubles the mesh
+    mesh.garbage_collection();
+    mesh.append(mesh);
+    EXPECT_EQ(mesh.n_faces(), 2 * (1 + n_faces));
+    EXPECT_TRUE(mesh.validate().empty());
+}
+
+TEST_F(SurfaceMeshTest, append_many)
+{
+    std::vector<SurfaceMesh> parts(100, vertex_onering());
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        auto tag = parts[i].add_vertex_property<int>("v:tag");
+        for (auto v : parts[i].vertices())
+            tag[v] = int(i);
+    }
+    auto tag = mesh.add_vertex_property<int>("v:tag", -1);
+
+    mesh.append(parts);
+    const auto& part = parts.front();
+    EXPECT_EQ(mesh.n_vertices(), parts.size() * part.n_vertices());
+    EXPECT_EQ(mesh.n_halfedges(), parts.size() * part.n_halfedges());
+    EXPECT_EQ(mesh.n_faces(), parts.size() * part.n_faces());
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(tag[v], int(v.idx() / part.n_vertices()));
+
+    // same as appending one after the other
+    SurfaceMesh sequential;
+    for (const auto& p : parts)
+        sequential.append(p);
+    for (auto h : mesh.halfedges())
+    {
+        EXPECT_EQ(mesh.to_vertex(h), sequential.to_vertex(h));
+        EXPECT_EQ(mesh.next_halfedge(h), sequential.next_halfedge(h));
+        EXPECT_EQ(mesh.face(h), sequential.face(h));
+    }
+}
+
 TEST_F(SurfaceMeshTest, object_properties)
 {
     // explicit add
@@ -221,6 +723,83 @@ TEST_F(SurfaceMeshTest, face_properties)
     EXPECT_EQ(mesh.face_properties().size(), size_t(2));
 }
 
+TEST_F(SurfaceMeshTest, sparse_properties)
+{
+    mesh = subdivided_icosahedron();
+    auto locked = mesh.add_vertex_property<int>("v:locked", -1);
+    locked[Vertex(3)] = 7;
+    locked.make_sparse();
+    EXPECT_TRUE(locked.is_sparse());
+    EXPECT_EQ(locked.size(), mesh.vertices_size());
+
+    // reading does not allocate pages
+    const auto& clocked = locked;
+    size_t n_set = 0;
+    for (auto v : mesh.vertices())
+        if (clocked[v] != -1)
+            ++n_set;
+    EXPECT_EQ(n_set, 1u);
+    locked[Vertex(100)] = 8;
+
+    size_t bytes = 0;
+    for (const auto& m : mesh.memory_usage())
+        if (m.name == "v:locked")
+        {
+            EXPECT_TRUE(m.sparse);
+            bytes = m.bytes;
+        }
+    EXPECT_EQ(bytes, 2 * 64 * sizeof(int));
+
+    // sparse arrays follow changes of the elements
+    SurfaceMesh copy = mesh;
+    mesh.delete_vertex(Vertex(0));
+    mesh.garbage_collection();
+    EXPECT_EQ(clocked[Vertex(0)], -1);
+    EXPECT_EQ(clocked[Vertex(3)], 7);
+    EXPECT_EQ(clocked[Vertex(100)], 8);
+    auto added = mesh.add_vertex(Point(0, 0, 0));
+    EXPECT_EQ(clocked[added], -1);
+
+    auto copied = copy.get_vertex_property<int>("v:locked");
+    EXPECT_TRUE(copied.is_sparse());
+    EXPECT_EQ(copied[Vertex(3)], 7);
+
+    // writing through the vector converts to dense storage
+    auto& values = locked.vector();
+    EXPECT_FALSE(locked.is_sparse());
+    EXPECT_EQ(values[3], 7);
+    EXPECT_EQ(values[100], 8);
+    EXPECT_EQ(values[0], -1);
+}
+
+TEST_F(SurfaceMeshTest, bool_properties)
+{
+    mesh = subdivided_icosahedron();
+    auto selected = mesh.add_vertex_property<bool>("v:selected");
+    auto marked = mesh.add_vertex_property<bool>("v:marked");
+    for (auto v : mesh.vertices())
+    {
+        selected[v] = v.idx() % 2 == 0;
+        marked[v] = v.idx() % 3 == 0;
+    }
+
+    // word-parallel operations on the packed bits
+    const auto& bits = selected.vector();
+    EXPECT_EQ(bits.count(), (mesh.n_vertices() + 1) / 2);
+    selected.vector() &= marked.vector();
+    EXPECT_EQ(bits.count(), (mesh.n_vertices() + 5) / 6);
+    EXPECT_EQ(bits.find_next(bits.find_first()), 6u);
+
+    // bool properties stay packed
+    selected.make_sparse();
+    EXPECT_FALSE(selected.is_sparse());
+    for (const auto& m : mesh.memory_usage())
+        if (m.name == "v:selected")
+        {
+            EXPECT_EQ(m.bytes, (mesh.n_vertices() + 7) / 8);
+        }
+}
+
 TEST_F(SurfaceMeshTest, vertex_iterators)
 {
     add_triangle();
@@ -265,6 +844,33 @@ TEST_F(SurfaceMeshTest, face_iterators)
     EXPECT_EQ(sumIdx, size_t(0));
 }
 
+TEST_F(SurfaceMeshTest, dense_iterators)
+{
+    add_quad();
+    EXPECT_FALSE(mesh.has_garbage());
+
+    std::vector<IndexType> vidx, hidx, eidx, fidx;
+    for (auto v : mesh.dense_vertices())
+        vidx.push_back(v.idx());
+    for (auto h : mesh.dense_halfedges())
+        hidx.push_back(h.idx());
+    for (auto e : mesh.dense_edges())
+        eidx.push_back(e.idx());
+    for (auto f : mesh.dense_faces())
+        fidx.push_back(f.idx());
+    EXPECT_EQ(vidx, std::vector<IndexType>({0, 1, 2, 3}));
+    EXPECT_EQ(hidx.size(), mesh.n_halfedges());
+    EXPECT_EQ(eidx.size(), mesh.n_edges());
+    EXPECT_EQ(fidx, std::vector<IndexType>({0}));
+    EXPECT_EQ(mesh.dense_halfedges().size(), mesh.halfedges_size());
+
+    mesh.delete_face(Face(0));
+    EXPECT_TRUE(mesh.has_garbage());
+    mesh.garbage_collection();
+    EXPECT_FALSE(mesh.has_garbage());
+    EXPECT_EQ(mesh.dense_vertices().size(), 0u);
+}
+
 TEST_F(SurfaceMeshTest, is_triangle_mesh)
 {
     add_triangle();
@@ -284,6 +890,45 @@ TEST_F(SurfaceMeshTest, is_quad_mesh)
     EXPECT_TRUE(mesh.is_triangle_mesh());
 }
 
+TEST_F(SurfaceMeshTest, triangulate_polygons)
+{
+    // pentagons and quads, with a deleted face
+    mesh = SurfaceFactory::dodecahedron();
+    mesh.append(SurfaceFactory::quad_sphere(2));
+    mesh.delete_face(Face(5));
+    auto quality = mesh.add_face_property<Scalar>("f:quality", -1);
+    for (auto f : mesh.faces())
+        quality[f] = Scalar(f.idx());
+
+    SurfaceMesh expected = mesh;
+    for (auto f : expected.faces())
+        expected.triangulate(f);
+
+    mesh.set_edge_index(true);
+    mesh.triangulate();
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    EXPECT_TRUE(mesh.validate().empty());
+    ASSERT_EQ(mesh.faces_size(), expected.faces_size());
+    ASSERT_EQ(mesh.edges_size(), expected.edges_size());
+    EXPECT_EQ(mesh.n_faces(), expected.n_faces());
+
+    // the same triangles with the same start halfedges, the original faces
+    // keep their properties
+    for (auto f : expected.faces())
+        EXPECT_EQ(mesh.halfedge(f), expected.halfedge(f));
+    for (auto h : expected.halfedges())
+    {
+        EXPECT_EQ(mesh.to_vertex(h), expected.to_vertex(h));
+        EXPECT_EQ(mesh.next_halfedge(h), expected.next_halfedge(h));
+        EXPECT_EQ(mesh.face(h), expected.face(h));
+    }
+    EXPECT_EQ(quality[Face(3)], Scalar(3));
+
+    // new edges are in the edge index
+    for (auto e : mesh.edges())
+        EXPECT_EQ(mesh.find_edge(mesh.vertex(e, 0), mesh.vertex(e, 1)), e);
+}
+
 TEST_F(SurfaceMeshTest, poly_mesh)
 {
     std::vector<Vertex> vertices(5);
@@ -366,6 +1011,183 @@ TEST_F(SurfaceMeshTest, is_manifold)
         EXPECT_TRUE(mesh.is_manifold(v));
 }
 
+// compare indexed find_halfedge() against the linear search of a copy
+void check_edge_index(const SurfaceMesh& mesh)
+{
+    SurfaceMesh linear = mesh;
+    linear.set_edge_index(false);
+    for (auto v : mesh.vertices())
+        for (auto w : mesh.vertices())
+            ASSERT_EQ(mesh.find_halfedge(v, w), linear.find_halfedge(v, w));
+}
+
+TEST_F(SurfaceMeshTest, edge_index)
+{
+    mesh.set_edge_index(true);
+    EXPECT_TRUE(mesh.has_edge_index());
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(1, 1, 0));
+    auto v3 = mesh.add_vertex(Point(0, 1, 0));
+    mesh.add_triangle(v0, v1, v2);
+    mesh.add_triangle(v0, v2, v3);
+    check_edge_index(mesh);
+
+    mesh.flip(mesh.find_edge(v0, v2));
+    EXPECT_FALSE(mesh.find_halfedge(v0, v2).is_valid());
+    EXPECT_TRUE(mesh.find_halfedge(v1, v3).is_valid());
+    check_edge_index(mesh);
+
+    mesh.split(mesh.find_edge(v1, v3), Point(0.5, 0.5, 0));
+    check_edge_index(mesh);
+
+    mesh.split(Face(0), Point(0.6, 0.3, 0));
+    check_edge_index(mesh);
+
+    for (auto h : mesh.halfedges())
+        if (mesh.is_collapse_ok(h))
+        {
+            mesh.collapse(h);
+            break;
+        }
+    EXPECT_LT(mesh.n_vertices(), mesh.vertices_size());
+    check_edge_index(mesh);
+
+    mesh.delete_face(Face(0));
+    check_edge_index(mesh);
+    mesh.garbage_collection();
+    check_edge_index(mesh);
+
+    mesh = vertex_onering();
+    mesh.set_edge_index(true);
+    mesh.set_reuse_deleted(true);
+    mesh.delete_vertex(Vertex(3));
+    check_edge_index(mesh);
+    mesh.reorder();
+    check_edge_index(mesh);
+
+    // copies keep the index
+    SurfaceMesh copy = mesh;
+    EXPECT_TRUE(copy.has_edge_index());
+    check_edge_index(copy);
+}
+
+TEST_F(SurfaceMeshTest, change_tracking)
+{
+    mesh = vertex_onering();
+    EXPECT_EQ(mesh.new_generation(), 0u);
+    mesh.set_change_tracking(true);
+    EXPECT_TRUE(mesh.change_tracking());
+
+    auto points = mesh.get_vertex_property<Point>("v:point");
+    auto g0 = mesh.new_generation();
+    EXPECT_TRUE(points.changed_since(g0).empty());
+    EXPECT_LE(mesh.topology_generation(), g0);
+
+    // property writes
+    points[Vertex(2)] = Point(1, 2, 3);
+    auto changed = points.changed_since(g0);
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0], 2u);
+    EXPECT_GT(points.generation(), g0);
+    EXPECT_LE(mesh.topology_generation(), g0);
+
+    // reads through a const mesh are not recorded
+    const SurfaceMesh& cmesh = mesh;
+    for (auto v : cmesh.vertices())
+        EXPECT_TRUE(cmesh.halfedge(v).is_valid());
+    EXPECT_LE(mesh.topology_generation(), g0);
+
+    // properties added later are tracked, too
+    auto vquality = mesh.add_vertex_property<Scalar>("v:quality");
+    auto g1 = mesh.new_generation();
+    vquality[Vertex(0)] = 1;
+    EXPECT_EQ(vquality.changed_since(g1).size(), 1u);
+    EXPECT_TRUE(points.changed_since(g1).empty());
+
+    // topological operations
+    auto g2 = mesh.new_generation();
+    Edge e = mesh.find_edge(Vertex(3), Vertex(0));
+    ASSERT_TRUE(mesh.is_flip_ok(e));
+    mesh.flip(e);
+    EXPECT_GT(mesh.topology_generation(), g2);
+    EXPECT_TRUE(points.changed_since(g2).empty());
+
+    auto g3 = mesh.new_generation();
+    mesh.split(Face(0), Point(0, 0, 0));
+    EXPECT_GT(mesh.topology_generation(), g3);
+    EXPECT_EQ(points.changed_since(g3).back(), mesh.vertices_size() - 1);
+
+    // copies start fresh, disabling stops tracking
+    SurfaceMesh copy = mesh;
+    EXPECT_TRUE(copy.change_tracking());
+    EXPECT_EQ(copy.topology_generation(), 0u);
+    mesh.set_change_tracking(false);
+    points[Vertex(0)] = Point(0, 0, 0);
+    EXPECT_TRUE(points.changed_since(0).empty());
+}
+
+TEST_F(SurfaceMeshTest, topology_changed_vertices)
+{
+    mesh = vertex_onering();
+    EXPECT_TRUE(mesh.topology_changed_vertices(0).empty());
+    mesh.set_change_tracking(true);
+
+    // moving a vertex does not change the connectivity
+    auto g0 = mesh.new_generation();
+    mesh.position(Vertex(0)) = Point(0, 0, 1);
+    EXPECT_TRUE(mesh.topology_changed_vertices(g0).empty());
+
+    // a flip changes the one-rings of the vertices of both triangles
+    auto g1 = mesh.new_generation();
+    Edge e = mesh.find_edge(Vertex(3), Vertex(0));
+    mesh.flip(e);
+    const auto changed = mesh.topology_changed_vertices(g1);
+    EXPECT_TRUE(std::is_sorted(changed.begin(), changed.end()));
+    for (int i : {0, 1, 2, 3})
+        EXPECT_TRUE(std::binary_search(changed.begin(), changed.end(),
+                                       Vertex(i)));
+}
+
+TEST_F(SurfaceMeshTest, validate)
+{
+    mesh = vertex_onering();
+    EXPECT_TRUE(mesh.validate().empty());
+
+    // deleted elements are skipped
+    mesh.delete_face(Face(0));
+    EXPECT_TRUE(mesh.validate().empty());
+    mesh.garbage_collection();
+    EXPECT_TRUE(mesh.validate().empty());
+
+    // outgoing halfedge of a boundary vertex must be a boundary halfedge
+    Vertex v(1);
+    ASSERT_TRUE(mesh.is_boundary(v));
+    Halfedge h = mesh.halfedge(v);
+    mesh.set_halfedge(v, mesh.cw_rotated_halfedge(h));
+    auto defects = mesh.validate();
+    ASSERT_EQ(defects.size(), size_t(1));
+    EXPECT_EQ(defects[0].type, MeshDefect::OutgoingBoundary);
+    EXPECT_EQ(defects[0].idx, v.idx());
+    mesh.set_halfedge(v, h);
+
+    // inconsistent face loop
+    Halfedge hf = mesh.halfedge(Face(0));
+    mesh.set_face(hf, Face(1));
+    defects = mesh.validate();
+    ASSERT_FALSE(defects.empty());
+    EXPECT_EQ(defects[0].type, MeshDefect::FaceLoop);
+    mesh.set_face(hf, Face(0));
+
+    // broken next/prev cycle
+    Halfedge hn = mesh.next_halfedge(hf);
+    mesh.set_next_halfedge(hf, mesh.next_halfedge(hn));
+    defects = mesh.validate();
+    EXPECT_TRUE(std::any_of(
+        defects.begin(), defects.end(),
+        [](const MeshDefect& d) { return d.type == MeshDefect::NextPrev; }));
+}
+
 TEST_F(SurfaceMeshTest, edge_length)
 {
     add_quad();
@@ -382,3 +1204,39 @@ TEST_F(SurfaceMeshTest, property_stats)
 {
     mesh.property_stats();
 }
+
+TEST_F(SurfaceMeshTest, memory_usage)
+{
+    mesh = vertex_onering();
+    auto vlists = mesh.add_vertex_property<std::vector<int>>("v:lists");
+    vlists[Vertex(0)].resize(100);
+
+    auto usage = mesh.memory_usage();
+    size_t total = 0;
+    bool found_points = false, found_lists = false;
+    for (const auto& m : usage)
+    {
+        total += m.total_bytes();
+        EXPECT_LE(m.bytes, m.capacity_bytes);
+        if (m.container == "vertex" && m.name == "v:point")
+        {
+            found_points = true;
+            EXPECT_EQ(m.size, size_t(7));
+            EXPECT_EQ(m.bytes, 7 * sizeof(Point));
+            EXPECT_EQ(m.heap_bytes, size_t(0));
+        }
+        if (m.name == "v:lists")
+        {
+            found_lists = true;
+            EXPECT_GE(m.heap_bytes, 100 * sizeof(int));
+        }
+    }
+    EXPECT_TRUE(found_points);
+    EXPECT_TRUE(found_lists);
+    EXPECT_EQ(total, mesh.memory_bytes());
+
+    // copies share memory until modified
+    SurfaceMesh m2 = mesh;
+    for (const auto& m : m2.memory_usage())
+        EXPECT_TRUE(m.shared || m.size == 0 || m.container == "object");
+}
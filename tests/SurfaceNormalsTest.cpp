@@ -48,3 +48,65 @@ TEST(SurfaceNormalsTest, polygonal_face_normal)
     auto n0 = SurfaceNormals::compute_face_normal(mesh, f0);
     EXPECT_GT(norm(n0), 0);
 }
+
+TEST(SurfaceNormalsTest, parallel_normals)
+{
+    // triangles and quads, a boundary, and deleted elements
+    auto mesh = SurfaceFactory::uv_sphere(Point(0, 0, 0), 1, 10, 10);
+    mesh.delete_face(Face(7));
+    mesh.delete_vertex(Vertex(23));
+
+    SurfaceNormals::compute_vertex_normals(mesh);
+    SurfaceNormals::compute_face_normals(mesh);
+    auto vnormals = mesh.get_vertex_property<Normal>("v:normal");
+    auto fnormals = mesh.get_face_property<Normal>("f:normal");
+
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(vnormals[v], SurfaceNormals::compute_vertex_normal(mesh, v));
+    }
+    for (auto f : mesh.faces())
+        EXPECT_EQ(fnormals[f], SurfaceNormals::compute_face_normal(mesh, f));
+}
+
+TEST(SurfaceNormalsTest, update_normals)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    mesh.set_change_tracking(true);
+    SurfaceNormals::compute_vertex_normals(mesh);
+    SurfaceNormals::compute_face_normals(mesh);
+
+    // the same normals as computed from scratch
+    auto check = [&]() {
+        SurfaceMesh copy = mesh;
+        SurfaceNormals::compute_vertex_normals(copy);
+        SurfaceNormals::compute_face_normals(copy);
+        auto vnormals = mesh.get_vertex_property<Normal>("v:normal");
+        auto fnormals = mesh.get_face_property<Normal>("f:normal");
+        auto vexpected = copy.get_vertex_property<Normal>("v:normal");
+        auto fexpected = copy.get_face_property<Normal>("f:normal");
+        for (auto v : mesh.vertices())
+            EXPECT_EQ(vnormals[v], vexpected[v]);
+        for (auto f : mesh.faces())
+            EXPECT_EQ(fnormals[f], fexpected[f]);
+    };
+
+    // explicit list of moved vertices
+    mesh.position(Vertex(5)) *= Scalar(1.2);
+    mesh.position(Vertex(17)) *= Scalar(0.8);
+    SurfaceNormals::update_normals(mesh, {Vertex(5), Vertex(17)});
+    check();
+
+    // changes found by tracking
+    auto g = mesh.new_generation();
+    mesh.position(Vertex(3)) *= Scalar(1.1);
+    Edge e = mesh.edge(mesh.halfedge(Vertex(20)));
+    if (mesh.is_flip_ok(e))
+        mesh.flip(e);
+    mesh.split(Face(30), Point(0, 0, 0));
+    Halfedge h = mesh.halfedge(Vertex(40));
+    if (mesh.is_collapse_ok(h))
+        mesh.collapse(h);
+    SurfaceNormals::update_normals(mesh, g);
+    check();
+}
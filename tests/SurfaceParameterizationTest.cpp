@@ -4,8 +4,11 @@
 #include "gtest/gtest.h"
 
 #include "pmp/algorithms/SurfaceParameterization.h"
+#include "pmp/algorithms/SurfaceFactory.h"
 #include "Helpers.h"
 
+#include <cmath>
+
 using namespace pmp;
 
 TEST(SurfaceParameterizationTest, parameterization)
@@ -26,3 +29,115 @@ TEST(SurfaceParameterizationTest, lscm)
     auto tex = mesh.vertex_property<TexCoord>("v:tex");
     EXPECT_TRUE(tex);
 }
+
+TEST(SurfaceParameterizationTest, no_boundary)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    SurfaceParameterization param(mesh);
+    EXPECT_THROW(param.lscm(), InvalidInputException);
+    EXPECT_THROW(param.harmonic(), InvalidInputException);
+}
+
+TEST(SurfaceParameterizationTest, lscm_charts)
+{
+    // a closed mesh, cut into charts
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfaceParameterization param(mesh);
+    const size_t n_charts = param.lscm_charts(8);
+    EXPECT_GE(n_charts, 8u);
+    EXPECT_FALSE(mesh.has_face_property("f:patch"));
+
+    auto chart = mesh.get_face_property<int>("f:chart");
+    auto tex = mesh.get_halfedge_property<TexCoord>("h:tex");
+    ASSERT_TRUE(chart);
+    ASSERT_TRUE(tex);
+
+    // the charts lie in disjoint cells of the unit square and are not flipped
+    const auto columns = Scalar(std::ceil(std::sqrt(Scalar(n_charts))));
+    for (auto f : mesh.faces())
+    {
+        ASSERT_GE(chart[f], 0);
+        ASSERT_LT(size_t(chart[f]), n_charts);
+        const TexCoord cell(chart[f] % int(columns), chart[f] / int(columns));
+        std::vector<TexCoord> t;
+        for (auto h : mesh.halfedges(f))
+        {
+            t.push_back(tex[h]);
+            const TexCoord local = tex[h] * columns - cell;
+            EXPECT_GE(local[0], -1e-5);
+            EXPECT_GE(local[1], -1e-5);
+            EXPECT_LE(local[0], 1 + 1e-5);
+            EXPECT_LE(local[1], 1 + 1e-5);
+        }
+        const TexCoord a = t[1] - t[0], b = t[2] - t[0];
+        EXPECT_GT(a[0] * b[1] - a[1] * b[0], 0);
+    }
+
+    // an existing partition is kept
+    auto patch = mesh.face_property<int>("f:patch", 42);
+    param.lscm_charts(2);
+    for (auto f : mesh.faces())
+        EXPECT_EQ(patch[f], 42);
+    EXPECT_FALSE(patch.is_pinned());
+}
+
+TEST(SurfaceParameterizationTest, distortion)
+{
+    // a planar fan, mapped by its own coordinates
+    auto mesh = vertex_onering();
+    auto tex = mesh.vertex_property<TexCoord>("v:tex");
+    for (auto v : mesh.vertices())
+        tex[v] = TexCoord(mesh.position(v)[0], mesh.position(v)[1]);
+    SurfaceParameterization param(mesh);
+    auto stats = param.distortion();
+    EXPECT_NEAR(stats.mean_conformal, 1, 1e-5);
+    EXPECT_NEAR(stats.max_conformal, 1, 1e-5);
+    EXPECT_NEAR(stats.mean_area, 1, 1e-5);
+    EXPECT_NEAR(stats.max_area, 1, 1e-5);
+    EXPECT_EQ(stats.n_flipped, 0u);
+    EXPECT_EQ(stats.n_degenerate, 0u);
+
+    // stretching is not conformal, but preserves relative areas
+    for (auto v : mesh.vertices())
+        tex[v][0] *= 2;
+    stats = param.distortion();
+    EXPECT_NEAR(stats.max_conformal, 2, 1e-5);
+    EXPECT_NEAR(stats.max_area, 1, 1e-5);
+    auto conformal = mesh.get_face_property<Scalar>("f:conformal_distortion");
+    ASSERT_TRUE(conformal);
+    for (auto f : mesh.faces())
+        EXPECT_NEAR(conformal[f], 2, 1e-5);
+
+    // moving the center out of the fan flips faces
+    tex[Vertex(3)] = TexCoord(10, 0);
+    stats = param.distortion();
+    EXPECT_GT(stats.n_flipped, 0u);
+    auto flipped = mesh.get_face_property<bool>("f:flipped");
+    ASSERT_TRUE(flipped);
+    unsigned int n_flipped = 0;
+    for (auto f : mesh.faces())
+        n_flipped += flipped[f];
+    EXPECT_EQ(n_flipped, stats.n_flipped);
+
+    // collapsing the fan in texture space makes all faces degenerate
+    for (auto v : mesh.vertices())
+        tex[v] = TexCoord(0, 0);
+    stats = param.distortion();
+    EXPECT_EQ(stats.n_degenerate, mesh.n_faces());
+    EXPECT_EQ(stats.mean_conformal, 0);
+}
+
+TEST(SurfaceParameterizationTest, lscm_distortion)
+{
+    auto mesh = hemisphere();
+    SurfaceParameterization param(mesh);
+    EXPECT_THROW(param.distortion(), InvalidInputException);
+    param.lscm();
+    const auto stats = param.distortion();
+    EXPECT_EQ(stats.n_flipped, 0u);
+    EXPECT_EQ(stats.n_degenerate, 0u);
+    EXPECT_GE(stats.mean_conformal, 1);
+    EXPECT_LT(stats.mean_conformal, 1.1);
+    EXPECT_GE(stats.max_conformal, stats.mean_conformal);
+    EXPECT_GE(stats.max_area, stats.mean_area);
+}
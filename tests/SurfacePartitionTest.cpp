@@ -0,0 +1,123 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/SurfacePartition.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+#include "pmp/algorithms/SurfaceRemeshing.h"
+#include "Helpers.h"
+
+using namespace pmp;
+
+TEST(SurfacePartitionTest, partition)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfacePartition partition(mesh);
+    partition.partition(5);
+    EXPECT_EQ(partition.n_patches(), 5u);
+
+    auto fpatch = mesh.get_face_property<int>("f:patch");
+    std::vector<size_t> sizes(5, 0);
+    for (auto f : mesh.faces())
+    {
+        ASSERT_GE(fpatch[f], 0);
+        ASSERT_LT(fpatch[f], 5);
+        ++sizes[fpatch[f]];
+    }
+    for (auto s : sizes)
+    {
+        EXPECT_GE(s, mesh.n_faces() / 5);
+        EXPECT_LE(s, mesh.n_faces() / 5 + 1);
+    }
+
+    EXPECT_THROW(partition.partition(0), InvalidInputException);
+    EXPECT_THROW(partition.extract(5), InvalidInputException);
+}
+
+TEST(SurfacePartitionTest, extract)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfacePartition partition(mesh);
+    partition.partition(4);
+
+    size_t n_interior = 0;
+    for (size_t i = 0; i < partition.n_patches(); ++i)
+    {
+        auto patch = partition.extract(i, 2);
+        EXPECT_EQ(patch.index, i);
+        EXPECT_TRUE(patch.mesh.validate().empty());
+
+        auto vorigin = patch.mesh.get_vertex_property<Vertex>("v:origin");
+        auto fhalo = patch.mesh.get_face_property<bool>("f:halo");
+        auto vhalo = patch.mesh.get_vertex_property<bool>("v:halo");
+        for (auto v : patch.mesh.vertices())
+        {
+            EXPECT_EQ(patch.mesh.position(v), mesh.position(vorigin[v]));
+            if (patch.mesh.is_boundary(v))
+            {
+                EXPECT_TRUE(vhalo[v]);
+            }
+        }
+        for (auto f : patch.mesh.faces())
+            if (!fhalo[f])
+                ++n_interior;
+    }
+    EXPECT_EQ(n_interior, mesh.n_faces());
+}
+
+TEST(SurfacePartitionTest, stitch_geometry)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const auto n_faces = mesh.n_faces();
+    SurfacePartition partition(mesh);
+    partition.partition(4);
+
+    std::vector<SurfacePatch> patches;
+    for (size_t i = 0; i < partition.n_patches(); ++i)
+    {
+        patches.push_back(partition.extract(i));
+        auto& pmesh = patches.back().mesh;
+        for (auto v : pmesh.vertices())
+            pmesh.position(v) *= 2;
+    }
+
+    auto vprop = mesh.add_vertex_property<int>("v:prop");
+    partition.stitch(patches);
+
+    // connectivity and properties are kept
+    EXPECT_EQ(mesh.n_faces(), n_faces);
+    EXPECT_TRUE(mesh.has_vertex_property("v:prop"));
+
+    // interface vertices are kept fixed
+    size_t n_moved = 0;
+    for (auto v : mesh.vertices())
+        if (norm(mesh.position(v)) > 1.5)
+            ++n_moved;
+    EXPECT_GT(n_moved, 0u);
+    EXPECT_LT(n_moved, mesh.n_vertices());
+    EXPECT_TRUE(vprop);
+}
+
+TEST(SurfacePartitionTest, stitch_remeshed)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    SurfacePartition partition(mesh);
+    partition.partition(3);
+
+    std::vector<SurfacePatch> patches;
+    for (size_t i = 0; i < partition.n_patches(); ++i)
+    {
+        patches.push_back(partition.extract(i));
+        SurfaceRemeshing(patches.back().mesh).uniform_remeshing(0.05, 3);
+    }
+    const auto n_faces = mesh.n_faces();
+    partition.stitch(patches);
+
+    EXPECT_NE(mesh.n_faces(), n_faces);
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto e : mesh.edges())
+        ASSERT_FALSE(mesh.is_boundary(e));
+    EXPECT_EQ(partition.n_patches(), 3u);
+    EXPECT_TRUE(mesh.has_face_property("f:patch"));
+}
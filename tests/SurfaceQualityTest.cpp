@@ -0,0 +1,123 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <numeric>
+
+#include "pmp/Parallel.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+#include "pmp/algorithms/SurfaceQuality.h"
+
+using namespace pmp;
+
+namespace {
+
+size_t sum(const std::vector<size_t>& counts)
+{
+    return std::accumulate(counts.begin(), counts.end(), size_t(0));
+}
+
+} // namespace
+
+TEST(SurfaceQualityTest, aspect_ratio)
+{
+    const Point a(0, 0, 0), b(1, 0, 0);
+    EXPECT_NEAR(
+        SurfaceQuality::aspect_ratio(a, b, Point(0.5, std::sqrt(0.75), 0)),
+        1.0, 1e-5);
+    EXPECT_NEAR(SurfaceQuality::aspect_ratio(a, b, Point(0, 1, 0)),
+                std::sqrt(3.0), 1e-5);
+    EXPECT_TRUE(std::isinf(SurfaceQuality::aspect_ratio(a, b, Point(2, 0, 0))));
+}
+
+TEST(SurfaceQualityTest, tetrahedron)
+{
+    auto mesh = SurfaceFactory::tetrahedron();
+    auto report = SurfaceQuality::analyze(mesh);
+
+    EXPECT_EQ(report.n_vertices, 4u);
+    EXPECT_EQ(report.n_edges, 6u);
+    EXPECT_EQ(report.n_boundary_edges, 0u);
+    EXPECT_EQ(report.n_faces, 4u);
+    EXPECT_EQ(report.n_triangles, 4u);
+    EXPECT_EQ(report.n_slivers, 0u);
+    EXPECT_EQ(report.n_degenerate, 0u);
+    EXPECT_NEAR(report.aspect_ratio.min, 1.0, 1e-5);
+    EXPECT_NEAR(report.aspect_ratio.max, 1.0, 1e-5);
+    EXPECT_NEAR(report.angle.min, 60.0, 1e-3);
+    EXPECT_NEAR(report.angle.max, 60.0, 1e-3);
+    EXPECT_NEAR(report.edge_length.min, report.edge_length.max, 1e-5);
+    EXPECT_EQ(report.valences, std::vector<size_t>({0, 0, 0, 4}));
+
+    // all angles are in the bin of 60 degrees
+    ASSERT_EQ(report.angles.counts.size(), 18u);
+    EXPECT_EQ(report.angles.counts[6], 12u);
+    EXPECT_EQ(report.angles.bounds.front(), 0);
+    EXPECT_EQ(report.angles.bounds.back(), 180);
+    EXPECT_EQ(report.edge_lengths.counts, std::vector<size_t>({6}));
+    EXPECT_LE(report.edge_lengths.bounds[0], report.edge_length.min);
+    EXPECT_GT(report.edge_lengths.bounds[1], report.edge_length.max);
+}
+
+TEST(SurfaceQualityTest, slivers)
+{
+    SurfaceMesh mesh;
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(0.5, 0.01, 0));
+    auto v3 = mesh.add_vertex(Point(2, 0, 0));
+    auto v4 = mesh.add_vertex(Point(0, 1, 0));
+    mesh.add_triangle(v0, v1, v2);
+    mesh.add_triangle(v1, v3, v2);
+    mesh.add_triangle(v0, v2, v4);
+    mesh.add_vertex(Point(5, 5, 5));
+
+    SurfaceQuality::Settings settings;
+    settings.sliver_angle = 5;
+    auto report = SurfaceQuality::analyze(mesh, settings);
+    EXPECT_EQ(report.n_slivers, 2u);
+    EXPECT_EQ(report.n_degenerate, 0u);
+    EXPECT_EQ(report.n_edges, mesh.n_edges());
+    EXPECT_EQ(report.n_boundary_edges, 5u);
+    EXPECT_EQ(report.valences[0], 1u);
+    EXPECT_GT(report.angle.max, 170);
+
+    // a collinear triangle is degenerate
+    mesh.position(v2) = Point(0.5, 0, 0);
+    report = SurfaceQuality::analyze(mesh, settings);
+    EXPECT_EQ(report.n_degenerate, 2u);
+    EXPECT_EQ(report.n_slivers, 2u);
+}
+
+TEST(SurfaceQualityTest, parallel)
+{
+    auto mesh = SurfaceFactory::icosphere(6);
+    mesh.delete_face(Face(7));
+    mesh.garbage_collection();
+    mesh.add_triangle(mesh.add_vertex(Point(0, 0, 0)),
+                      mesh.add_vertex(Point(1, 0, 0)),
+                      mesh.add_vertex(Point(0, 0.1, 0)));
+
+    auto report = SurfaceQuality::analyze(mesh);
+    EXPECT_EQ(report.n_vertices, mesh.n_vertices());
+    EXPECT_EQ(report.n_edges, mesh.n_edges());
+    EXPECT_EQ(report.n_faces, mesh.n_faces());
+    EXPECT_EQ(sum(report.valences), mesh.n_vertices());
+    EXPECT_EQ(sum(report.angles.counts), 3 * mesh.n_faces());
+    EXPECT_EQ(sum(report.aspect_ratios.counts), mesh.n_faces());
+    EXPECT_EQ(sum(report.edge_lengths.counts), mesh.n_edges());
+    EXPECT_EQ(report.n_slivers, 1u);
+    EXPECT_GT(report.aspect_ratio.max, 5);
+
+    // independent of the number of threads
+    Parallel::set_n_threads(1);
+    auto serial = SurfaceQuality::analyze(mesh);
+    Parallel::set_n_threads(0);
+    EXPECT_EQ(serial.aspect_ratio.mean, report.aspect_ratio.mean);
+    EXPECT_EQ(serial.edge_length.mean, report.edge_length.mean);
+    EXPECT_EQ(serial.angles.counts, report.angles.counts);
+    EXPECT_EQ(serial.edge_lengths.counts, report.edge_lengths.counts);
+    EXPECT_EQ(serial.valences, report.valences);
+}
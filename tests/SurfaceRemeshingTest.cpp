@@ -36,7 +36,7 @@ TEST(SurfaceRemeshingTest, adaptive_remeshing_with_boundary)
     SurfaceRemeshing(mesh).adaptive_remeshing(0.001 * bb,  // min length
                                               1.0 * bb,    // max length
                                               0.001 * bb); // approx. error
-    EXPECT_EQ(mesh.n_vertices(), size_t(740));
+    EXPECT_EQ(mesh.n_vertices(), size_t(804));
 }
 
 TEST(SurfaceRemeshingTest, adaptive_remeshing_with_selection)
@@ -54,7 +54,7 @@ TEST(SurfaceRemeshingTest, adaptive_remeshing_with_selection)
     SurfaceRemeshing(mesh).adaptive_remeshing(0.001 * bb,  // min length
                                               1.0 * bb,    // max length
                                               0.001 * bb); // approx. error
-    EXPECT_EQ(mesh.n_vertices(), size_t(826));
+    EXPECT_EQ(mesh.n_vertices(), size_t(855));
 }
 
 TEST(SurfaceRemeshingTest, uniform_remeshing)
@@ -72,3 +72,212 @@ TEST(SurfaceRemeshingTest, uniform_remeshing)
     SurfaceRemeshing(mesh).uniform_remeshing(l);
     EXPECT_EQ(mesh.n_vertices(), size_t(940));
 }
+
+// smoothing updates are computed from the previous positions only
+TEST(SurfaceRemeshingTest, deterministic)
+{
+    auto input = hemisphere();
+    auto mesh0 = input, mesh1 = input;
+    SurfaceRemeshing(mesh0).uniform_remeshing(0.1, 3);
+    SurfaceRemeshing(mesh1).uniform_remeshing(0.1, 3);
+
+    ASSERT_EQ(mesh0.n_vertices(), mesh1.n_vertices());
+    for (auto v : mesh0.vertices())
+        EXPECT_EQ(mesh0.position(v), mesh1.position(v));
+}
+
+TEST(SurfaceRemeshingTest, stop_criteria)
+{
+    auto input = hemisphere();
+
+    // refine to half the mean edge length
+    Scalar l(0);
+    for (auto e : input.edges())
+        l += input.edge_length(e);
+    l /= (Scalar)input.n_edges() * 2;
+
+    // statistics of all iterations without stop criteria
+    auto mesh = input;
+    SurfaceRemeshing remeshing(mesh);
+    remeshing.uniform_remeshing(l, 10);
+    const auto all = remeshing.statistics();
+    ASSERT_EQ(all.size(), 10u);
+    EXPECT_GT(all[0].n_splits + all[0].n_collapses, 0u);
+    EXPECT_LT(all.back().outside_band, 0.1);
+    for (size_t i = 1; i < all.size(); ++i)
+        EXPECT_GE(all[i].elapsed, all[i - 1].elapsed);
+    for (const auto& s : all)
+        EXPECT_LE(s.split_time + s.collapse_time + s.flip_time + s.smooth_time,
+                  s.elapsed + 1e-6);
+    EXPECT_GT(all[0].n_rejected_collapses, 0u);
+
+    // stop once few operations are performed
+    mesh = input;
+    SurfaceRemeshing converged(mesh);
+    SurfaceRemeshing::StopCriteria criteria;
+    criteria.min_operations = 50;
+    converged.set_stop_criteria(criteria);
+    converged.uniform_remeshing(l, 10);
+    const auto& stats = converged.statistics();
+    ASSERT_FALSE(stats.empty());
+    EXPECT_LT(stats.size(), 10u);
+    const auto& last = stats.back();
+    EXPECT_LT(last.n_splits + last.n_collapses + last.n_flips, 50u);
+
+    // stop once edges are within the band
+    mesh = input;
+    SurfaceRemeshing banded(mesh);
+    criteria = SurfaceRemeshing::StopCriteria();
+    criteria.max_outside_band = 0.1;
+    banded.set_stop_criteria(criteria);
+    banded.uniform_remeshing(l, 10);
+    EXPECT_EQ(banded.statistics().size(), 1u);
+
+    // a tiny time budget allows a single iteration
+    mesh = input;
+    SurfaceRemeshing budgeted(mesh);
+    criteria = SurfaceRemeshing::StopCriteria();
+    criteria.time_budget = 1e-3;
+    budgeted.set_stop_criteria(criteria);
+    budgeted.uniform_remeshing(l, 10);
+    EXPECT_EQ(budgeted.statistics().size(), 1u);
+}
+
+// restricting the reference to the selection and a halo keeps the result
+// of uniform remeshing and approximates the sizing of adaptive remeshing
+TEST(SurfaceRemeshingTest, localized)
+{
+    auto input = hemisphere();
+    auto selected = input.add_vertex_property<bool>("v:selected");
+    for (auto v : input.vertices())
+        if (input.position(v)[0] > 0.5)
+            selected[v] = true;
+
+    auto bb = input.bounds().size();
+    for (bool uniform : {false, true})
+    {
+        auto global = input, local = input;
+        SurfaceRemeshing global_remeshing(global), local_remeshing(local);
+        local_remeshing.set_localized(true);
+        if (uniform)
+        {
+            global_remeshing.uniform_remeshing(0.02 * bb);
+            local_remeshing.uniform_remeshing(0.02 * bb);
+        }
+        else
+        {
+            global_remeshing.adaptive_remeshing(0.001 * bb, 1.0 * bb,
+                                                0.001 * bb);
+            local_remeshing.adaptive_remeshing(0.001 * bb, 1.0 * bb,
+                                               0.001 * bb);
+        }
+        EXPECT_NE(global.n_vertices(), input.n_vertices());
+
+        if (uniform)
+        {
+            ASSERT_EQ(local.n_vertices(), global.n_vertices());
+            for (auto v : local.vertices())
+                EXPECT_LT(distance(local.position(v), global.position(v)),
+                          1e-5);
+        }
+        else
+        {
+            EXPECT_NEAR(local.n_vertices(), global.n_vertices(),
+                        0.05 * global.n_vertices());
+        }
+    }
+}
+
+// a cancelled remeshing keeps a valid mesh and reports its phases
+TEST(SurfaceRemeshingTest, cancel)
+{
+    auto mesh = hemisphere();
+    SurfaceRemeshing remeshing(mesh);
+    std::vector<float> fractions;
+    remeshing.set_progress([&](float fraction) {
+        fractions.push_back(fraction);
+        return fractions.size() < 6;
+    });
+    Scalar l = 0;
+    for (auto e : mesh.edges())
+        l += mesh.edge_length(e);
+    l /= mesh.n_edges();
+    EXPECT_THROW(remeshing.uniform_remeshing(l, 4), CancelledException);
+
+    // polled after each of the four phases of an iteration
+    ASSERT_EQ(fractions.size(), 6u);
+    EXPECT_FLOAT_EQ(fractions[0], 1.0f / 16);
+    EXPECT_FLOAT_EQ(fractions[5], 6.0f / 16);
+    EXPECT_EQ(remeshing.statistics().size(), 2u);
+    EXPECT_TRUE(mesh.validate().empty());
+    EXPECT_FALSE(mesh.has_vertex_property("v:locked"));
+}
+
+// worklists and batches of flips reach about the same mesh as sweeps
+TEST(SurfaceRemeshingTest, worklist)
+{
+    auto input = hemisphere();
+    Scalar l = 0;
+    for (auto e : input.edges())
+        l += input.edge_length(e);
+    l /= input.n_edges() * 2;
+
+    auto swept = input;
+    SurfaceRemeshing(swept).uniform_remeshing(l, 5);
+
+    auto mesh = input;
+    SurfaceRemeshing remeshing(mesh);
+    remeshing.set_use_worklist(true);
+    remeshing.uniform_remeshing(l, 5);
+
+    EXPECT_TRUE(mesh.validate().empty());
+    EXPECT_NEAR(mesh.n_vertices(), swept.n_vertices(),
+                0.05 * swept.n_vertices());
+    EXPECT_LT(remeshing.statistics().back().outside_band, 0.1);
+    EXPECT_GT(remeshing.statistics()[0].n_splits, 0u);
+    EXPECT_GT(remeshing.statistics()[0].n_flips, 0u);
+    EXPECT_FALSE(mesh.has_vertex_property("v:valence"));
+}
+
+// the curvature computed in advance gives the same sizing
+TEST(SurfaceRemeshingTest, sizing_curvature)
+{
+    auto input = hemisphere();
+    auto bb = input.bounds().size();
+
+    auto mesh = input;
+    SurfaceRemeshing(mesh).adaptive_remeshing(0.001 * bb, 1.0 * bb,
+                                              0.001 * bb);
+
+    SurfaceRemeshing::compute_sizing_curvature(input);
+    auto cached = input;
+    SurfaceRemeshing(cached).adaptive_remeshing(0.001 * bb, 1.0 * bb,
+                                                0.001 * bb);
+    EXPECT_EQ(cached.n_vertices(), mesh.n_vertices());
+    EXPECT_FALSE(cached.has_vertex_property("v:sizing_curvature"));
+    EXPECT_TRUE(input.has_vertex_property("v:sizing_curvature"));
+}
+
+TEST(SurfaceRemeshingTest, sizing_field)
+{
+    auto mesh = hemisphere();
+
+    // finer on one side
+    auto sizing = mesh.add_vertex_property<Scalar>("v:target_length");
+    for (auto v : mesh.vertices())
+        sizing[v] = mesh.position(v)[0] > 0 ? 0.05 : 0.1;
+    SurfaceRemeshing(mesh).adaptive_remeshing(sizing, 5);
+
+    Scalar l[2] = {0, 0};
+    int n[2] = {0, 0};
+    for (auto e : mesh.edges())
+    {
+        const Scalar x = mesh.position(mesh.vertex(e, 0))[0];
+        if (std::abs(x) < 0.2)
+            continue;
+        l[x > 0] += mesh.edge_length(e);
+        ++n[x > 0];
+    }
+    ASSERT_TRUE(n[0] > 0 && n[1] > 0);
+    EXPECT_LT(l[1] / n[1], 0.75 * l[0] / n[0]);
+}
@@ -0,0 +1,77 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include "pmp/algorithms/SurfaceFactory.h"
+#include "pmp/algorithms/SurfaceSampling.h"
+
+using namespace pmp;
+
+TEST(SurfaceSamplingTest, uniform)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    mesh.delete_face(Face(0));
+
+    auto samples = SurfaceSampling::uniform(mesh, 10000);
+    ASSERT_EQ(samples.size(), 10000u);
+    auto positions = mesh.get_vertex_property<Point>("v:point");
+    for (const auto& s : samples)
+    {
+        ASSERT_TRUE(s.face.is_valid());
+        EXPECT_FALSE(mesh.is_deleted(s.face));
+        for (int i = 0; i < 3; ++i)
+            EXPECT_GE(s.barycentric[i], 0);
+        EXPECT_NEAR(s.barycentric[0] + s.barycentric[1] + s.barycentric[2],
+                    1, 1e-5);
+        EXPECT_LT(distance(SurfaceSampling::interpolate(mesh, positions, s),
+                           s.point),
+                  1e-5);
+    }
+
+    // the same seed gives the same samples
+    auto again = SurfaceSampling::uniform(mesh, 10000);
+    auto other = SurfaceSampling::uniform(mesh, 10000, 1);
+    EXPECT_EQ(again.back().point, samples.back().point);
+    EXPECT_NE(other.back().point, samples.back().point);
+
+    EXPECT_TRUE(SurfaceSampling::uniform(mesh, 0).empty());
+    EXPECT_THROW(SurfaceSampling::uniform(SurfaceFactory::hexahedron(), 10),
+                 InvalidInputException);
+}
+
+// samples are distributed proportionally to the areas
+TEST(SurfaceSamplingTest, area_weighted)
+{
+    SurfaceMesh mesh;
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(0, 1, 0));
+    auto v3 = mesh.add_vertex(Point(-3, 0, 0));
+    auto small = mesh.add_triangle(v0, v1, v2);
+    mesh.add_triangle(v0, v2, v3);
+
+    size_t n_small = 0;
+    for (const auto& s : SurfaceSampling::uniform(mesh, 1000))
+        if (s.face == small)
+            ++n_small;
+    EXPECT_NEAR(n_small, 250, 1);
+}
+
+TEST(SurfaceSamplingTest, poisson_disk)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const Scalar radius = 0.1;
+    auto samples = SurfaceSampling::poisson_disk(mesh, radius);
+
+    // a dense packing has about 0.3 to 1.2 samples per radius squared
+    EXPECT_GT(samples.size(), size_t(0.3 * 4 * M_PI / (radius * radius)));
+    EXPECT_LT(samples.size(), size_t(1.2 * 4 * M_PI / (radius * radius)));
+
+    for (size_t i = 0; i < samples.size(); ++i)
+        for (size_t j = i + 1; j < samples.size(); ++j)
+            ASSERT_GE(distance(samples[i].point, samples[j].point), radius);
+
+    EXPECT_THROW(SurfaceSampling::poisson_disk(mesh, 0),
+                 InvalidInputException);
+}
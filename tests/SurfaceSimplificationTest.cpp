@@ -5,6 +5,8 @@
 
 #include "pmp/algorithms/SurfaceSimplification.h"
 #include "pmp/algorithms/SurfaceFeatures.h"
+#include "pmp/algorithms/SurfaceFactory.h"
+#include "pmp/algorithms/TriangleKdTree.h"
 #include "Helpers.h"
 
 using namespace pmp;
@@ -37,3 +39,241 @@ TEST(SurfaceSimplificationTest, simplification_with_features)
     ss.simplify(mesh.n_vertices() * 0.1);
     EXPECT_EQ(mesh.n_vertices(), size_t(64));
 }
+
+// stop at a face count
+TEST(SurfaceSimplificationTest, face_target)
+{
+    auto mesh = subdivided_icosahedron();
+    SurfaceSimplification ss(mesh);
+    ss.initialize();
+    ss.simplify(0, 200, 0);
+    EXPECT_EQ(mesh.n_faces(), size_t(200));
+}
+
+// stop before the quadric error exceeds the budget
+TEST(SurfaceSimplificationTest, error_target)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    auto coarse = mesh;
+    SurfaceSimplification(mesh).simplify(0, 0, 1e-3);
+    SurfaceSimplification(coarse).simplify(0, 0, 1e-2);
+    EXPECT_LT(mesh.n_vertices(), size_t(642));
+    EXPECT_LT(coarse.n_vertices(), mesh.n_vertices());
+    EXPECT_GT(coarse.n_vertices(), size_t(12));
+}
+
+// record the collapses and extract levels of detail
+TEST(SurfaceSimplificationTest, progressive_mesh)
+{
+    auto mesh = hemisphere();
+    auto input = mesh;
+    ProgressiveMesh pm;
+    SurfaceSimplification ss(mesh);
+    ss.simplify(mesh.n_vertices() / 10, 0, 0, &pm);
+    EXPECT_EQ(pm.n_vertices(), input.n_vertices());
+    EXPECT_EQ(pm.n_collapses(), input.n_vertices() - mesh.n_vertices());
+
+    auto full = pm.lod(0);
+    EXPECT_EQ(full.n_vertices(), input.n_vertices());
+    EXPECT_EQ(full.n_faces(), input.n_faces());
+
+    auto coarse = pm.lod(pm.n_collapses());
+    EXPECT_EQ(coarse.n_vertices(), mesh.n_vertices());
+    EXPECT_EQ(coarse.n_faces(), mesh.n_faces());
+
+    // each level uses a prefix of the shared vertex buffer
+    std::vector<size_t> levels{0, pm.n_collapses() / 2, pm.n_collapses()};
+    std::vector<Point> positions;
+    std::vector<std::vector<IndexType>> indices;
+    pm.lod_buffers(levels, positions, indices);
+    EXPECT_EQ(positions.size(), input.n_vertices());
+    ASSERT_EQ(indices.size(), levels.size());
+    EXPECT_EQ(indices[2].size(), 3 * mesh.n_faces());
+    for (size_t i = 0; i < levels.size(); ++i)
+        for (auto idx : indices[i])
+            EXPECT_LT(idx, input.n_vertices() - levels[i]);
+
+    EXPECT_THROW(pm.lod(pm.n_collapses() + 1), InvalidInputException);
+}
+
+// parallel batches of independent collapses
+TEST(SurfaceSimplificationTest, simplify_parallel)
+{
+    auto mesh = hemisphere();
+    SurfaceSimplification ss(mesh);
+    ss.initialize(5, 0.5, 10, 10, 0.1);
+    ss.simplify_parallel(mesh.n_vertices() * 0.1);
+    EXPECT_NEAR(mesh.n_vertices(), 178, 10);
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+
+    auto sphere = SurfaceFactory::icosphere(4);
+    SurfaceSimplification(sphere).simplify_parallel(0, 1000);
+    EXPECT_EQ(sphere.n_faces(), size_t(1000));
+    for (auto v : sphere.vertices())
+        EXPECT_NEAR(norm(sphere.position(v)), 1.0, 1e-5);
+}
+
+// all removed vertices stay within the Hausdorff error
+TEST(SurfaceSimplificationTest, hausdorff_error)
+{
+    auto input = SurfaceFactory::icosphere(3);
+    for (int mode = 0; mode < 4; ++mode)
+    {
+        const bool parallel = mode & 1;
+        const bool optimal = mode & 2;
+
+        auto mesh = input;
+        SurfaceSimplification ss(mesh);
+        ss.initialize(0, 0, 0, 0, 0.01, optimal);
+        if (parallel)
+            ss.simplify_parallel(0);
+        else
+            ss.simplify(0);
+        EXPECT_LT(mesh.n_vertices(), input.n_vertices());
+
+        TriangleKdTree tree(mesh);
+        for (auto v : input.vertices())
+            EXPECT_LT(tree.nearest(input.position(v)).dist, 0.01);
+    }
+}
+
+// moving the remaining vertex reduces the approximation error
+TEST(SurfaceSimplificationTest, optimal_placement)
+{
+    auto input = SurfaceFactory::icosphere(4);
+    auto mean_distance = [&](bool optimal, bool parallel) {
+        auto mesh = input;
+        SurfaceSimplification ss(mesh);
+        ss.initialize(0, 0, 0, 0, 0, optimal);
+        if (parallel)
+            ss.simplify_parallel(200);
+        else
+            ss.simplify(200);
+        EXPECT_EQ(mesh.n_vertices(), size_t(200));
+        EXPECT_TRUE(mesh.is_triangle_mesh());
+
+        TriangleKdTree tree(mesh);
+        Scalar sum(0);
+        for (auto v : input.vertices())
+            sum += tree.nearest(input.position(v)).dist;
+        return sum / input.n_vertices();
+    };
+
+    EXPECT_LT(mean_distance(true, false), mean_distance(false, false));
+    EXPECT_LT(mean_distance(true, true), mean_distance(false, true));
+}
+
+// the statistics count the collapses of the last simplification
+TEST(SurfaceSimplificationTest, statistics)
+{
+    auto mesh = hemisphere();
+    const size_t nv = mesh.n_vertices();
+    SurfaceSimplification ss(mesh);
+    ss.initialize(5, 0.5, 10, 10, 0.1);
+    ss.simplify(nv * 0.1);
+
+    const auto& stats = ss.statistics();
+    EXPECT_EQ(stats.n_collapses, nv - mesh.n_vertices());
+    EXPECT_GT(stats.n_legality_tests, size_t(stats.n_collapses));
+    EXPECT_GT(stats.n_rejected, 0u);
+    EXPECT_LT(stats.n_rejected, stats.n_legality_tests);
+    EXPECT_GT(stats.n_queue_updates, size_t(stats.n_collapses));
+    EXPECT_EQ(stats.n_rounds, 0u);
+    EXPECT_GE(stats.initialize_time, 0);
+    EXPECT_GT(stats.queue_time + stats.collapse_time, 0);
+
+    auto sphere = SurfaceFactory::icosphere(4);
+    SurfaceSimplification parallel(sphere);
+    parallel.simplify_parallel(0, 1000);
+    const auto& pstats = parallel.statistics();
+    EXPECT_EQ(pstats.n_collapses, 2562 - sphere.n_vertices());
+    EXPECT_GT(pstats.n_rounds, 1u);
+    EXPECT_GT(pstats.n_conflicts, 0u);
+}
+
+// lazy updates evaluate fewer collapses and reach the same target
+TEST(SurfaceSimplificationTest, lazy_updates)
+{
+    auto input = SurfaceFactory::icosphere(4);
+    auto eager = input;
+    SurfaceSimplification ss(eager);
+    ss.simplify(200);
+
+    auto mesh = input;
+    SurfaceSimplification lazy(mesh);
+    lazy.set_lazy_updates(true);
+    lazy.simplify(200);
+    EXPECT_EQ(mesh.n_vertices(), size_t(200));
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto v : mesh.vertices())
+        EXPECT_NEAR(norm(mesh.position(v)), 1.0, 1e-5);
+
+    EXPECT_GT(lazy.statistics().n_stale, 0u);
+    EXPECT_EQ(ss.statistics().n_stale, 0u);
+    EXPECT_LT(lazy.statistics().n_legality_tests,
+              ss.statistics().n_legality_tests);
+}
+
+// a cancelled simplification keeps a valid mesh with the collapses so far
+TEST(SurfaceSimplificationTest, cancel)
+{
+    for (bool parallel : {false, true})
+    {
+        auto mesh = SurfaceFactory::icosphere(4);
+        SurfaceSimplification ss(mesh);
+        float last = -1;
+        ss.set_progress([&](float fraction) {
+            EXPECT_GE(fraction, last);
+            last = fraction;
+            return fraction < 0.5f;
+        });
+        if (parallel)
+            EXPECT_THROW(ss.simplify_parallel(100), CancelledException);
+        else
+            EXPECT_THROW(ss.simplify(100), CancelledException);
+        EXPECT_GE(last, 0.5f);
+        EXPECT_LT(mesh.n_vertices(), size_t(2562));
+        EXPECT_GT(mesh.n_vertices(), size_t(100));
+        EXPECT_EQ(mesh.n_vertices(), mesh.vertices_size());
+        EXPECT_TRUE(mesh.validate().empty());
+        EXPECT_FALSE(mesh.has_vertex_property("v:prio"));
+    }
+}
+
+// concurrent simplification of many meshes with shared scratch memory
+TEST(SurfaceSimplificationTest, simplify_batch)
+{
+    std::vector<SurfaceMesh> meshes;
+    for (int i = 0; i < 40; ++i)
+    {
+        // alternate between sizes, such that the scratch memory shrinks
+        meshes.push_back(i % 3 ? SurfaceFactory::icosphere(2 + i % 2)
+                               : hemisphere());
+        for (auto v : meshes.back().vertices())
+            meshes.back().position(v) *= Scalar(1 + i);
+    }
+    auto expected = meshes;
+
+    SurfaceSimplification::BatchSettings settings;
+    settings.ratio = 0.2;
+    settings.aspect_ratio = 5;
+    settings.normal_deviation = 10;
+    settings.hausdorff_error = 0.1;
+    SurfaceSimplification::simplify_batch(meshes, settings);
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        SurfaceSimplification ss(expected[i]);
+        ss.initialize(5, 0, 0, 10, 0.1);
+        ss.simplify(expected[i].n_vertices() * 0.2);
+        ASSERT_EQ(meshes[i].n_vertices(), expected[i].n_vertices());
+        EXPECT_EQ(meshes[i].positions(), expected[i].positions());
+        EXPECT_FALSE(meshes[i].has_vertex_property("v:quadric"));
+    }
+
+    meshes.push_back(SurfaceFactory::hexahedron());
+    const auto n_vertices = meshes.front().n_vertices();
+    EXPECT_THROW(SurfaceSimplification::simplify_batch(meshes, settings),
+                 InvalidInputException);
+    EXPECT_EQ(meshes.front().n_vertices(), n_vertices);
+}
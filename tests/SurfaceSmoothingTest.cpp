@@ -29,3 +29,87 @@ TEST(SurfaceSmoothingTest, explicit_smoothing)
     auto area_after = surface_area(mesh);
     EXPECT_LT(area_after, area_before);
 }
+
+TEST(SurfaceSmoothingTest, repeated_implicit_smoothing)
+{
+    // reusing the factorization gives the results of fresh ones
+    for (bool uniform : {true, false})
+    {
+        auto mesh = hemisphere();
+        auto reference = mesh;
+        SurfaceSmoothing ss(mesh);
+        for (int i = 0; i < 3; ++i)
+        {
+            ss.implicit_smoothing(0.01, uniform, false);
+            SurfaceSmoothing(reference).implicit_smoothing(0.01, uniform,
+                                                           false);
+        }
+        for (auto v : mesh.vertices())
+            EXPECT_LT(distance(mesh.position(v), reference.position(v)),
+                      1e-5);
+    }
+}
+
+TEST(SurfaceSmoothingTest, repeated_explicit_smoothing)
+{
+    // iterations continue from the positions of the previous call
+    auto mesh = hemisphere();
+    auto reference = mesh;
+    SurfaceSmoothing(mesh).explicit_smoothing(5, false);
+    SurfaceSmoothing ss(reference);
+    for (int i = 0; i < 5; ++i)
+        ss.explicit_smoothing(1, false);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), reference.position(v));
+}
+
+TEST(SurfaceSmoothingTest, explicit_smoothing_selection)
+{
+    auto mesh = hemisphere();
+    auto before = mesh;
+    auto selected = mesh.vertex_property<bool>("v:selected", false);
+    for (auto v : mesh.vertices())
+        selected[v] = mesh.position(v)[2] > 0.5;
+
+    SurfaceSmoothing(mesh).explicit_smoothing(10, true);
+
+    size_t n_moved = 0;
+    for (auto v : mesh.vertices())
+    {
+        if (mesh.position(v) != before.position(v))
+        {
+            EXPECT_TRUE(selected[v]);
+            ++n_moved;
+        }
+    }
+    EXPECT_GT(n_moved, 0u);
+}
+
+// cancelled smoothing keeps the iterations so far, or the mesh unchanged
+TEST(SurfaceSmoothingTest, cancel)
+{
+    auto mesh = hemisphere();
+    auto reference = mesh;
+    SurfaceSmoothing(reference).explicit_smoothing(3);
+
+    SurfaceSmoothing ss(mesh);
+    ss.set_progress([](float fraction) { return fraction < 0.3f; });
+    EXPECT_THROW(ss.explicit_smoothing(10), CancelledException);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), reference.position(v));
+
+    reference = mesh;
+    ss.set_progress([](float) { return false; });
+    EXPECT_THROW(ss.implicit_smoothing(0.01), CancelledException);
+    for (auto v : mesh.vertices())
+        EXPECT_EQ(mesh.position(v), reference.position(v));
+
+    // completes without cancelling
+    ss.set_progress(nullptr);
+    ss.implicit_smoothing(0.01);
+    size_t n_moved = 0;
+    for (auto v : mesh.vertices())
+        if (mesh.position(v) != reference.position(v))
+            ++n_moved;
+    EXPECT_GT(n_moved, 0u);
+}
@@ -5,6 +5,7 @@
 
 #include "pmp/algorithms/SurfaceSubdivision.h"
 #include "pmp/algorithms/SurfaceFeatures.h"
+#include "pmp/algorithms/SurfaceFactory.h"
 #include "Helpers.h"
 
 using namespace pmp;
@@ -68,3 +69,166 @@ TEST(SurfaceSubdivisionTest, sqrt3Subdivision)
     SurfaceSubdivision(mesh).sqrt3();
     EXPECT_EQ(mesh.n_vertices(), size_t(1922));
 }
+
+// several steps at once are the same as single steps
+static void expect_same_steps(SurfaceMesh mesh,
+                              void (SurfaceSubdivision::*step)(unsigned int))
+{
+    auto once = mesh;
+    (SurfaceSubdivision(once).*step)(2);
+    (SurfaceSubdivision(mesh).*step)(1);
+    (SurfaceSubdivision(mesh).*step)(1);
+
+    ASSERT_EQ(once.n_vertices(), mesh.n_vertices());
+    ASSERT_EQ(once.n_edges(), mesh.n_edges());
+    ASSERT_EQ(once.n_faces(), mesh.n_faces());
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(once.position(v), mesh.position(v));
+        EXPECT_EQ(once.halfedge(v), mesh.halfedge(v));
+    }
+    for (auto h : mesh.halfedges())
+    {
+        EXPECT_EQ(once.to_vertex(h), mesh.to_vertex(h));
+        EXPECT_EQ(once.next_halfedge(h), mesh.next_halfedge(h));
+        EXPECT_EQ(once.face(h), mesh.face(h));
+    }
+}
+
+TEST(SurfaceSubdivisionTest, loop_steps)
+{
+    auto mesh = hemisphere();
+    expect_same_steps(mesh, &SurfaceSubdivision::loop);
+
+    const auto n_faces = mesh.n_faces();
+    SurfaceSubdivision(mesh).loop(2);
+    EXPECT_EQ(mesh.n_faces(), 16 * n_faces);
+}
+
+TEST(SurfaceSubdivisionTest, catmull_clark_steps)
+{
+    auto mesh = SurfaceFactory::dodecahedron();
+    mesh.delete_face(Face(0));
+    expect_same_steps(mesh, &SurfaceSubdivision::catmull_clark);
+
+    // garbage is collected first, pentagons become five quads
+    SurfaceSubdivision(mesh).catmull_clark(3);
+    EXPECT_EQ(mesh.n_faces(), size_t(11 * 5 * 16));
+    EXPECT_EQ(mesh.n_vertices(), mesh.vertices_size());
+}
+
+TEST(SurfaceSubdivisionTest, sqrt3_steps)
+{
+    auto mesh = hemisphere();
+    expect_same_steps(mesh, &SurfaceSubdivision::sqrt3);
+
+    mesh = subdivided_icosahedron();
+    SurfaceSubdivision(mesh).sqrt3(2);
+    EXPECT_EQ(mesh.n_vertices(), size_t(642 + 1280 + 3 * 1280));
+}
+
+// stencils reproduce the subdivision of a deformed control mesh
+static void expect_stencils(SurfaceMesh control,
+                            void (SurfaceSubdivision::*steps)(
+                                unsigned int, SubdivisionStencils&))
+{
+    auto refined = control;
+    SubdivisionStencils stencils;
+    (SurfaceSubdivision(refined).*steps)(2, stencils);
+    EXPECT_EQ(stencils.n_control_vertices(), control.vertices_size());
+    EXPECT_EQ(stencils.n_vertices(), refined.vertices_size());
+
+    std::vector<Point> result;
+    stencils.apply(control.positions(), result);
+    for (auto v : refined.vertices())
+        EXPECT_LT(distance(result[v.idx()], refined.position(v)), 1e-5);
+
+    // deform, subdivide from scratch, and compare
+    for (auto v : control.vertices())
+        control.position(v) *= Scalar(1.0) + control.position(v)[0];
+    auto expected = control;
+    (SurfaceSubdivision(expected).*steps)(2, stencils);
+    stencils.apply(control, refined);
+    for (auto v : refined.vertices())
+        EXPECT_LT(distance(expected.position(v), refined.position(v)), 1e-5);
+}
+
+TEST(SurfaceSubdivisionTest, loop_stencils)
+{
+    auto mesh = hemisphere();
+    expect_stencils(mesh, &SurfaceSubdivision::loop);
+
+    mesh = subdivided_icosahedron();
+    SurfaceFeatures(mesh).detect_angle(25);
+    expect_stencils(mesh, &SurfaceSubdivision::loop);
+}
+
+TEST(SurfaceSubdivisionTest, catmull_clark_stencils)
+{
+    auto mesh = SurfaceFactory::dodecahedron();
+    mesh.delete_vertex(Vertex(0));
+    expect_stencils(mesh, &SurfaceSubdivision::catmull_clark);
+}
+
+TEST(SurfaceSubdivisionTest, sqrt3_stencils)
+{
+    expect_stencils(hemisphere(), &SurfaceSubdivision::sqrt3);
+}
+
+TEST(SurfaceSubdivisionTest, adaptive_sqrt3)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    const auto far = mesh.position(Vertex(0)) * -1;
+    auto vselected = mesh.vertex_property<bool>("v:selected", false);
+    vselected[Vertex(0)] = true;
+
+    SurfaceSubdivision(mesh).adaptive_sqrt3(3);
+    EXPECT_TRUE(mesh.validate().empty());
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+
+    // refined around the selected vertex only
+    EXPECT_GT(mesh.n_faces(), size_t(1280));
+    EXPECT_LT(mesh.n_faces(), size_t(2 * 1280));
+    for (auto v : mesh.vertices())
+        if (distance(mesh.position(v), far) < 1.0)
+        {
+            EXPECT_LT(v.idx(), 642u);
+        }
+}
+
+TEST(SurfaceSubdivisionTest, adaptive_sqrt3_everywhere)
+{
+    auto mesh = subdivided_icosahedron();
+    auto uniform = mesh;
+    mesh.vertex_property<bool>("v:selected", true);
+
+    SurfaceSubdivision(mesh).adaptive_sqrt3(2);
+    SurfaceSubdivision(uniform).sqrt3(2);
+    EXPECT_EQ(mesh.n_vertices(), uniform.n_vertices());
+    EXPECT_EQ(mesh.n_faces(), uniform.n_faces());
+    for (auto v : mesh.vertices())
+        EXPECT_LT(distance(mesh.position(v), uniform.position(v)), 1e-5);
+}
+
+TEST(SurfaceSubdivisionTest, adaptive_sqrt3_curvature)
+{
+    // a unit sphere with a spike
+    auto mesh = SurfaceFactory::icosphere(3);
+    mesh.position(Vertex(0)) *= 1.5;
+
+    SurfaceSubdivision(mesh).adaptive_sqrt3(2, 3);
+    EXPECT_TRUE(mesh.validate().empty());
+    EXPECT_GT(mesh.n_faces(), size_t(1280));
+    EXPECT_LT(mesh.n_faces(), size_t(2 * 1280));
+}
+
+// a cancelled subdivision keeps the steps so far
+TEST(SurfaceSubdivisionTest, cancel)
+{
+    auto mesh = SurfaceFactory::icosahedron();
+    SurfaceSubdivision subdivision(mesh);
+    subdivision.set_progress([](float fraction) { return fraction < 0.5f; });
+    EXPECT_THROW(subdivision.loop(4), CancelledException);
+    EXPECT_EQ(mesh.n_faces(), size_t(20 * 16));
+    EXPECT_TRUE(mesh.validate().empty());
+}
@@ -0,0 +1,128 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/SurfaceTriangulation.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/SurfaceNormals.h>
+
+#include <cmath>
+
+using namespace pmp;
+
+namespace {
+
+// a planar polygon in the xy-plane, a star if inner < outer
+SurfaceMesh polygon(int n, Scalar inner = 1, Scalar outer = 1)
+{
+    SurfaceMesh mesh;
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < n; ++i)
+    {
+        const Scalar r = i % 2 ? inner : outer;
+        const Scalar a = 2 * M_PI * i / n;
+        vertices.push_back(
+            mesh.add_vertex(Point(r * std::cos(a), r * std::sin(a), 0)));
+    }
+    mesh.add_face(vertices);
+    return mesh;
+}
+
+// all triangles of a planar polygon are oriented like the polygon
+void expect_planar_triangulation(const SurfaceMesh& mesh, size_t n)
+{
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    EXPECT_EQ(mesh.n_faces(), n - 2);
+    EXPECT_TRUE(mesh.validate().empty());
+    for (auto f : mesh.faces())
+        EXPECT_GT(SurfaceNormals::compute_face_normal(mesh, f)[2], 0.99);
+}
+
+std::vector<std::vector<Vertex>> faces(const SurfaceMesh& mesh)
+{
+    std::vector<std::vector<Vertex>> result;
+    for (auto f : mesh.faces())
+    {
+        result.emplace_back();
+        for (auto v : mesh.vertices(f))
+            result.back().push_back(v);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(SurfaceTriangulationTest, quads)
+{
+    auto mesh = SurfaceFactory::quad_sphere(3);
+    const auto n_faces = mesh.n_faces();
+    SurfaceTriangulation(mesh).triangulate();
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    EXPECT_EQ(mesh.n_faces(), 2 * n_faces);
+    EXPECT_TRUE(mesh.validate().empty());
+}
+
+TEST(SurfaceTriangulationTest, convex_polygon)
+{
+    for (auto objective :
+         {SurfaceTriangulation::MIN_AREA, SurfaceTriangulation::MAX_ANGLE})
+    {
+        auto mesh = polygon(50);
+        SurfaceTriangulation(mesh).triangulate(objective);
+        expect_planar_triangulation(mesh, 50);
+    }
+}
+
+TEST(SurfaceTriangulationTest, star_polygon)
+{
+    for (auto objective :
+         {SurfaceTriangulation::MIN_AREA, SurfaceTriangulation::MAX_ANGLE})
+    {
+        auto mesh = polygon(30, 0.5);
+        SurfaceTriangulation(mesh).triangulate(objective);
+        EXPECT_TRUE(mesh.is_triangle_mesh());
+        EXPECT_EQ(mesh.n_faces(), 28u);
+        EXPECT_TRUE(mesh.validate().empty());
+    }
+}
+
+TEST(SurfaceTriangulationTest, all_faces)
+{
+    // convex and non-convex polygons
+    SurfaceMesh mesh = SurfaceFactory::dodecahedron();
+    auto star = polygon(12, 0.5);
+    std::vector<Vertex> vertices;
+    for (auto v : star.vertices())
+        vertices.push_back(mesh.add_vertex(star.position(v) + Point(3, 0, 0)));
+    mesh.add_face(vertices);
+
+    // triangulating all faces at once equals triangulating each face
+    auto each = mesh;
+    SurfaceTriangulation(mesh).triangulate();
+    SurfaceTriangulation triangulation(each);
+    const auto n_faces = each.faces_size();
+    for (size_t i = 0; i < n_faces; ++i)
+        triangulation.triangulate(Face(i));
+    EXPECT_TRUE(mesh.is_triangle_mesh());
+    EXPECT_EQ(faces(mesh), faces(each));
+}
+
+TEST(SurfaceTriangulationTest, non_manifold)
+{
+    // two quads sharing a single vertex
+    SurfaceMesh mesh;
+    auto v0 = mesh.add_vertex(Point(0, 0, 0));
+    auto v1 = mesh.add_vertex(Point(1, 0, 0));
+    auto v2 = mesh.add_vertex(Point(1, 1, 0));
+    auto v3 = mesh.add_vertex(Point(0, 1, 0));
+    auto v4 = mesh.add_vertex(Point(-1, 0, 0));
+    auto v5 = mesh.add_vertex(Point(-1, -1, 0));
+    auto v6 = mesh.add_vertex(Point(0, -1, 0));
+    mesh.add_quad(v0, v1, v2, v3);
+    mesh.add_quad(v0, v4, v5, v6);
+
+    EXPECT_THROW(SurfaceTriangulation(mesh).triangulate(),
+                 InvalidInputException);
+    EXPECT_EQ(mesh.n_faces(), 2u);
+}
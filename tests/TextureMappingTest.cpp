@@ -0,0 +1,80 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/TextureMapping.h>
+
+#include <limits>
+#include <vector>
+
+using namespace pmp;
+
+TEST(TextureMappingTest, quantile)
+{
+    std::vector<Scalar> values;
+    for (int i = 100; i >= 0; --i)
+        values.push_back(Scalar(i));
+    EXPECT_EQ(quantile(values, 0.0), 0.0);
+    EXPECT_EQ(quantile(values, 0.05), 5.0);
+    EXPECT_EQ(quantile(values, 0.5), 50.0);
+    EXPECT_EQ(quantile(values, 1.0), 100.0);
+
+    std::vector<Scalar> empty;
+    EXPECT_THROW(quantile(empty, 0.5), InvalidInputException);
+}
+
+TEST(TextureMappingTest, unsigned_values)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    auto values = mesh.add_vertex_property<Scalar>("v:values");
+    for (auto v : mesh.vertices())
+        values[v] = Scalar(v.idx());
+
+    // the lowest and highest 5% are clamped
+    values_to_texture_coordinates(mesh, values);
+    auto tex = mesh.get_vertex_property<TexCoord>("v:tex");
+    ASSERT_TRUE(tex);
+    const size_t n = mesh.n_vertices() - 1;
+    const size_t i = n / 20;
+    EXPECT_FLOAT_EQ(tex[Vertex(i)][0], 0.0);
+    EXPECT_FLOAT_EQ(tex[Vertex(n - i)][0], 1.0);
+    EXPECT_LT(tex[Vertex(0)][0], 0.0);
+    EXPECT_GT(tex[Vertex(n)][0], 1.0);
+}
+
+TEST(TextureMappingTest, signed_values)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    auto values = mesh.add_vertex_property<Scalar>("v:values");
+    for (auto v : mesh.vertices())
+        values[v] = mesh.position(v)[2];
+
+    // zero maps to the center
+    values_to_texture_coordinates(mesh, values, 0.0);
+    auto tex = mesh.get_vertex_property<TexCoord>("v:tex");
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_GE(tex[v][0], 0.0);
+        EXPECT_LE(tex[v][0], 1.0);
+        EXPECT_EQ(tex[v][0] > 0.5, values[v] > 0);
+    }
+}
+
+TEST(TextureMappingTest, distances)
+{
+    auto mesh = SurfaceFactory::icosphere(1);
+    auto distances = mesh.add_vertex_property<Scalar>(
+        "v:distances", std::numeric_limits<Scalar>::max());
+    distances[Vertex(0)] = 0;
+    distances[Vertex(1)] = 2;
+    distances[Vertex(2)] = 4;
+
+    distances_to_texture_coordinates(mesh, distances);
+    auto tex = mesh.get_vertex_property<TexCoord>("v:tex");
+    EXPECT_EQ(tex[Vertex(0)][0], 0.0);
+    EXPECT_EQ(tex[Vertex(1)][0], 0.5);
+    EXPECT_EQ(tex[Vertex(2)][0], 1.0);
+    EXPECT_EQ(tex[Vertex(3)][0], 1.0);
+}
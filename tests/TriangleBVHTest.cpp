@@ -0,0 +1,192 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <limits>
+
+#include <pmp/algorithms/DistancePointTriangle.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/TriangleBVH.h>
+#include <pmp/algorithms/TriangleKdTree.h>
+
+using namespace pmp;
+
+// query points around and inside the unit sphere
+static std::vector<Point> query_points()
+{
+    std::vector<Point> points;
+    for (int i = 0; i < 200; ++i)
+    {
+        const Scalar t = Scalar(i) / 200;
+        const Scalar r = Scalar(0.2) + Scalar(1.6) * t;
+        points.emplace_back(r * std::cos(37 * t) * std::sin(11 * t),
+                            r * std::sin(37 * t) * std::sin(11 * t),
+                            r * std::cos(11 * t));
+    }
+    return points;
+}
+
+TEST(TriangleBVHTest, nearest)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    TriangleBVH bvh(mesh);
+    EXPECT_GT(bvh.n_nodes(), 1u);
+
+    for (const auto& p : query_points())
+    {
+        // brute force
+        Scalar dist = std::numeric_limits<Scalar>::max();
+        for (auto f : mesh.faces())
+        {
+            auto v = mesh.vertices(f);
+            const Point& p0 = mesh.position(*v);
+            const Point& p1 = mesh.position(*(++v));
+            const Point& p2 = mesh.position(*(++v));
+            Point n;
+            dist = std::min(dist, dist_point_triangle(p, p0, p1, p2, n));
+        }
+
+        auto nn = bvh.nearest(p);
+        EXPECT_FLOAT_EQ(nn.dist, dist);
+        EXPECT_NEAR(distance(nn.nearest, p), dist, 1e-5);
+        EXPECT_LT(nn.tests, int(mesh.n_faces()));
+    }
+}
+
+TEST(TriangleBVHTest, batch)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+    TriangleBVH bvh(mesh, 1);
+    TriangleKdTree kd_tree(mesh);
+
+    const auto points = query_points();
+    std::vector<TriangleBVH::NearestNeighbor> result;
+    bvh.nearest(points, result);
+    ASSERT_EQ(result.size(), points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        EXPECT_NEAR(result[i].dist, kd_tree.nearest(points[i]).dist, 1e-6);
+}
+
+TEST(TriangleBVHTest, intersect)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    TriangleBVH bvh(mesh);
+
+    for (const auto& p : query_points())
+    {
+        // rays from outside through the center enter and leave the sphere
+        const Point d = normalize(p);
+        const TriangleBVH::Ray ray(Scalar(2) * d, -d);
+        const auto hit = bvh.intersect(ray);
+        ASSERT_TRUE(hit.face.is_valid());
+        EXPECT_GT(hit.t, Scalar(0.99));
+        EXPECT_LE(hit.t, Scalar(1.01));
+        EXPECT_NEAR(distance(hit.point, ray.origin + hit.t * ray.direction), 0,
+                    1e-5);
+
+        const auto hits = bvh.intersect_all(ray);
+        ASSERT_GE(hits.size(), 2u);
+        EXPECT_FLOAT_EQ(hits.front().t, hit.t);
+        EXPECT_GT(hits.back().t, Scalar(2.98));
+        for (size_t i = 1; i < hits.size(); ++i)
+            EXPECT_LE(hits[i - 1].t, hits[i].t);
+
+        // segments inside the sphere hit nothing
+        EXPECT_TRUE(bvh.occluded(ray));
+        const Point center(0, 0, 0);
+        EXPECT_FALSE(
+            bvh.occluded(TriangleBVH::Ray(center, Scalar(0.9) * d, 0, 1)));
+        EXPECT_FALSE(bvh.intersect(TriangleBVH::Ray(center, d, 0, Scalar(0.9)))
+                         .face.is_valid());
+    }
+
+    // ray pointing away
+    EXPECT_FALSE(bvh.intersect(TriangleBVH::Ray(Point(2, 0, 0), Point(1, 0, 0)))
+                     .face.is_valid());
+}
+
+TEST(TriangleBVHTest, intersect_packets)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+    TriangleBVH bvh(mesh);
+
+    // a bundle of parallel rays, some of them missing the sphere
+    std::vector<TriangleBVH::Ray> rays;
+    for (int i = 0; i < 30; ++i)
+        for (int j = 0; j < 30; ++j)
+            rays.emplace_back(Point(Scalar(0.08) * (i - 15),
+                                    Scalar(0.08) * (j - 15), 3),
+                              Point(0, 0, -1));
+
+    std::vector<TriangleBVH::RayHit> hits;
+    bvh.intersect(rays, hits);
+    ASSERT_EQ(hits.size(), rays.size());
+
+    int n_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        const auto hit = bvh.intersect(rays[i]);
+        ASSERT_EQ(hits[i].face.is_valid(), hit.face.is_valid());
+        if (hit.face.is_valid())
+        {
+            EXPECT_FLOAT_EQ(hits[i].t, hit.t);
+            ++n_hits;
+        }
+    }
+    EXPECT_GT(n_hits, 0);
+    EXPECT_LT(n_hits, int(rays.size()));
+}
+
+TEST(TriangleBVHTest, refit)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    TriangleBVH bvh(mesh);
+
+    // check nearest neighbors and rays against a new hierarchy
+    auto check = [&]() {
+        TriangleBVH reference(mesh);
+        for (const auto& p : query_points())
+        {
+            EXPECT_FLOAT_EQ(bvh.nearest(p).dist, reference.nearest(p).dist);
+            const TriangleBVH::Ray ray(p, Point(0, 0, 1));
+            EXPECT_EQ(bvh.intersect(ray).face, reference.intersect(ray).face);
+        }
+    };
+
+    // a smooth deformation only refits the boxes
+    for (auto v : mesh.vertices())
+    {
+        Point& p = mesh.position(v);
+        p = Point(p[0] + Scalar(0.1) * p[2], p[1], Scalar(1.2) * p[2]);
+    }
+    EXPECT_EQ(bvh.refit(mesh, std::numeric_limits<Scalar>::infinity()), 0u);
+    check();
+
+    // stretching one half degrades its subtrees, which are rebuilt
+    for (auto v : mesh.vertices())
+    {
+        Point& p = mesh.position(v);
+        if (p[0] > 0)
+            p = Point(Scalar(5) * p[0], p[1] * p[0], p[2]);
+    }
+    EXPECT_GT(bvh.refit(mesh), 0u);
+    check();
+    EXPECT_EQ(bvh.refit(mesh), 0u);
+
+    EXPECT_THROW(bvh.refit(SurfaceFactory::icosphere(2)),
+                 InvalidInputException);
+}
+
+TEST(TriangleBVHTest, empty)
+{
+    SurfaceMesh mesh;
+    TriangleBVH bvh(mesh);
+    EXPECT_EQ(bvh.n_nodes(), 0u);
+    EXPECT_FALSE(bvh.nearest(Point(0, 0, 0)).face.is_valid());
+    EXPECT_FALSE(bvh.intersect(TriangleBVH::Ray(Point(0, 0, 0), Point(1, 0, 0)))
+                     .face.is_valid());
+
+    EXPECT_THROW(TriangleBVH(SurfaceFactory::hexahedron()),
+                 InvalidInputException);
+}
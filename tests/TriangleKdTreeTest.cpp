@@ -0,0 +1,153 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <pmp/algorithms/DistancePointTriangle.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+#include <pmp/algorithms/TriangleKdTree.h>
+
+using namespace pmp;
+
+TEST(TriangleKdTreeTest, nearest)
+{
+    // large enough to be built by several tasks
+    auto mesh = SurfaceFactory::icosphere(4);
+
+    // leave some garbage
+    auto v = *mesh.vertices_begin();
+    mesh.delete_vertex(v);
+
+    for (unsigned int max_faces : {0u, 1u, 10u})
+    {
+        TriangleKdTree tree(mesh, max_faces);
+        EXPECT_GT(tree.n_nodes(), 1u);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            const Scalar t = Scalar(i) / 100;
+            const Scalar r = Scalar(0.2) + Scalar(1.6) * t;
+            const Point p(r * std::cos(37 * t) * std::sin(11 * t),
+                          r * std::sin(37 * t) * std::sin(11 * t),
+                          r * std::cos(11 * t));
+
+            // brute force
+            Scalar dist = std::numeric_limits<Scalar>::max();
+            for (auto f : mesh.faces())
+            {
+                auto fv = mesh.vertices(f);
+                const Point& p0 = mesh.position(*fv);
+                const Point& p1 = mesh.position(*(++fv));
+                const Point& p2 = mesh.position(*(++fv));
+                Point n;
+                dist = std::min(dist, dist_point_triangle(p, p0, p1, p2, n));
+            }
+
+            auto nn = tree.nearest(p);
+            EXPECT_NEAR(nn.dist, dist, 1e-6);
+            EXPECT_NEAR(distance(nn.nearest, p), dist, 1e-5);
+            EXPECT_FALSE(mesh.is_deleted(nn.face));
+        }
+    }
+}
+
+TEST(TriangleKdTreeTest, depth)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    EXPECT_EQ(TriangleKdTree(mesh, 0, 0).n_nodes(), 1u);
+    EXPECT_LT(TriangleKdTree(mesh, 0, 3).n_nodes(), 16u);
+
+    SurfaceMesh empty;
+    TriangleKdTree tree(empty);
+    EXPECT_FALSE(tree.nearest(Point(0, 0, 0)).face.is_valid());
+}
+
+// distances from p to all faces of mesh in increasing order
+static std::vector<Scalar> sorted_distances(const SurfaceMesh& mesh,
+                                            const Point& p)
+{
+    std::vector<Scalar> dists;
+    for (auto f : mesh.faces())
+    {
+        auto fv = mesh.vertices(f);
+        const Point& p0 = mesh.position(*fv);
+        const Point& p1 = mesh.position(*(++fv));
+        const Point& p2 = mesh.position(*(++fv));
+        Point n;
+        dists.push_back(dist_point_triangle(p, p0, p1, p2, n));
+    }
+    std::sort(dists.begin(), dists.end());
+    return dists;
+}
+
+TEST(TriangleKdTreeTest, batch)
+{
+    auto mesh = SurfaceFactory::icosphere(4);
+    TriangleKdTree tree(mesh);
+
+    // coherent query points along a spiral
+    std::vector<Point> points;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const Scalar t = Scalar(i) / 1000;
+        const Scalar r = Scalar(0.9) + Scalar(0.2) * t;
+        points.emplace_back(r * std::cos(37 * t) * std::sin(11 * t),
+                            r * std::sin(37 * t) * std::sin(11 * t),
+                            r * std::cos(11 * t));
+    }
+
+    std::vector<TriangleKdTree::NearestNeighbor> result;
+    tree.nearest(points, result);
+    ASSERT_EQ(result.size(), points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(result[i].dist, tree.nearest(points[i]).dist);
+        EXPECT_TRUE(result[i].face.is_valid());
+    }
+}
+
+TEST(TriangleKdTreeTest, k_nearest)
+{
+    auto mesh = SurfaceFactory::icosphere(2);
+    TriangleKdTree tree(mesh, 1);
+
+    for (const Point& p : {Point(0.1, 0.2, 0.3), Point(0, 0, 1.2)})
+    {
+        const auto dists = sorted_distances(mesh, p);
+        const auto result = tree.k_nearest(p, 7);
+        ASSERT_EQ(result.size(), 7u);
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            EXPECT_NEAR(result[i].dist, dists[i], 1e-6);
+            for (size_t j = 0; j < i; ++j)
+                EXPECT_NE(result[i].face, result[j].face);
+        }
+    }
+
+    EXPECT_EQ(tree.k_nearest(Point(0, 0, 0), 1000).size(), mesh.n_faces());
+    EXPECT_TRUE(tree.k_nearest(Point(0, 0, 0), 0).empty());
+}
+
+TEST(TriangleKdTreeTest, within_radius)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    TriangleKdTree tree(mesh, 1);
+
+    const Point p(0.3, 0.5, 0.8);
+    const Scalar radius = 0.2;
+    const auto dists = sorted_distances(mesh, p);
+    const auto n = size_t(std::upper_bound(dists.begin(), dists.end(), radius) -
+                          dists.begin());
+
+    const auto result = tree.within_radius(p, radius);
+    ASSERT_EQ(result.size(), n);
+    EXPECT_GT(n, 1u);
+    for (size_t i = 0; i < n; ++i)
+        EXPECT_NEAR(result[i].dist, dists[i], 1e-6);
+
+    EXPECT_TRUE(tree.within_radius(Point(5, 0, 0), 1).empty());
+}
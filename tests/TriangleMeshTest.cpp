@@ -0,0 +1,108 @@
+// Copyright 2021 the Polygon Mesh Processing Library developers.
+// Distributed under a MIT-style license, see LICENSE.txt for details.
+
+#include "gtest/gtest.h"
+
+#include <pmp/TriangleMesh.h>
+#include <pmp/algorithms/SurfaceFactory.h>
+
+#include <algorithm>
+
+#include "Helpers.h"
+
+using namespace pmp;
+
+void check_triangle_mesh(const SurfaceMesh& mesh)
+{
+    TriangleMesh tmesh(mesh);
+    EXPECT_EQ(tmesh.n_vertices(), mesh.n_vertices());
+    EXPECT_EQ(tmesh.n_edges(), mesh.n_edges());
+    EXPECT_EQ(tmesh.n_faces(), mesh.n_faces());
+    EXPECT_EQ(tmesh.n_halfedges(), 3 * mesh.n_faces());
+
+    // same one-rings, vertex indices are unchanged without garbage
+    for (auto v : mesh.vertices())
+    {
+        EXPECT_EQ(tmesh.position(v), mesh.position(v));
+        EXPECT_EQ(tmesh.is_boundary(v), mesh.is_boundary(v));
+        EXPECT_EQ(tmesh.valence(v), mesh.valence(v));
+
+        std::vector<IndexType> ring, tring;
+        for (auto vv : mesh.vertices(v))
+            ring.push_back(vv.idx());
+        for (auto vv : tmesh.vertices(v))
+            tring.push_back(vv.idx());
+        std::sort(ring.begin(), ring.end());
+        std::sort(tring.begin(), tring.end());
+        EXPECT_EQ(ring, tring);
+
+        size_t n_faces = 0;
+        for (auto f : tmesh.faces(v))
+        {
+            bool found = false;
+            for (auto fv : tmesh.vertices(f))
+                if (fv == v)
+                    found = true;
+            EXPECT_TRUE(found);
+            ++n_faces;
+        }
+        EXPECT_EQ(n_faces, tmesh.valence(v) - (tmesh.is_boundary(v) ? 1 : 0));
+    }
+
+    // halfedge consistency
+    for (auto h : tmesh.halfedges())
+    {
+        EXPECT_EQ(tmesh.next_halfedge(tmesh.prev_halfedge(h)), h);
+        EXPECT_EQ(tmesh.face(tmesh.next_halfedge(h)), tmesh.face(h));
+        if (!tmesh.is_boundary(h))
+        {
+            auto o = tmesh.opposite_halfedge(h);
+            EXPECT_EQ(tmesh.opposite_halfedge(o), h);
+            EXPECT_EQ(tmesh.from_vertex(o), tmesh.to_vertex(h));
+        }
+    }
+
+    // round trip
+    auto mesh2 = tmesh.to_surface_mesh();
+    EXPECT_EQ(mesh2.n_vertices(), mesh.n_vertices());
+    EXPECT_EQ(mesh2.n_edges(), mesh.n_edges());
+    EXPECT_EQ(mesh2.n_faces(), mesh.n_faces());
+}
+
+TEST(TriangleMeshTest, closed)
+{
+    check_triangle_mesh(SurfaceFactory::icosphere(2));
+}
+
+TEST(TriangleMeshTest, boundary)
+{
+    check_triangle_mesh(hemisphere());
+    check_triangle_mesh(vertex_onering());
+}
+
+TEST(TriangleMeshTest, memory)
+{
+    auto mesh = SurfaceFactory::icosphere(3);
+    TriangleMesh tmesh(mesh);
+    EXPECT_LT(tmesh.memory_bytes(), mesh.memory_bytes());
+}
+
+TEST(TriangleMeshTest, properties_and_copy)
+{
+    TriangleMesh tmesh(vertex_onering());
+    auto fidx = tmesh.add_face_property<int>("f:idx");
+    for (auto f : tmesh.faces())
+        fidx[f] = f.idx();
+
+    TriangleMesh copy = tmesh;
+    copy.position(Vertex(0)) = Point(1, 2, 3);
+    EXPECT_NE(tmesh.position(Vertex(0)), Point(1, 2, 3));
+    EXPECT_EQ(copy.get_face_property<int>("f:idx")[Face(4)], 4);
+    EXPECT_EQ(copy.n_edges(), tmesh.n_edges());
+}
+
+TEST(TriangleMeshTest, reject_polygons)
+{
+    EXPECT_THROW(TriangleMesh(SurfaceFactory::hexahedron()),
+                 InvalidInputException);
+}